@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+"""Decode MY_DEBUG_TRACE records into the regular MySensors debug log.
+
+The firmware sends each debug point as a binary record:
+
+    0xFE <len> <id> <timestamp:16> <arguments...>
+
+The id is the address of the debug format string. The event table (id to
+format string) is built from the ELF file of the running firmware, so no
+table has to be maintained by hand. Bytes outside of records (e.g. plain
+Serial.print() output of the sketch) are passed through unchanged.
+
+Usage:
+    decode_trace.py firmware.elf /dev/ttyUSB0 [--baud 115200]
+    decode_trace.py firmware.elf capture.bin
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SYNC = 0xFE
+EM_AVR = 83
+
+SPEC = re.compile(rb'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|z)?([diouxXcspeEfgG%])')
+
+
+class Firmware:
+    """Format strings of a firmware image and the type sizes of its target."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as elf:
+            self.image = elf.read()
+        if self.image[:4] != b'\x7fELF' or self.image[4] != 1 or self.image[5] != 1:
+            raise ValueError('%s is not a little endian ELF32 file' % path)
+        machine = struct.unpack_from('<H', self.image, 18)[0]
+        if machine == EM_AVR:
+            self.int_size, self.ptr_size, self.double_size = 2, 2, 4
+        else:
+            self.int_size, self.ptr_size, self.double_size = 4, 4, 8
+        shoff, = struct.unpack_from('<I', self.image, 32)
+        shentsize, shnum = struct.unpack_from('<HH', self.image, 46)
+        self.sections = []
+        for index in range(shnum):
+            (_, sh_type, sh_flags, sh_addr, sh_offset,
+             sh_size) = struct.unpack_from('<IIIIII', self.image, shoff + index * shentsize)
+            # allocated sections with content (SHT_PROGBITS, SHF_ALLOC)
+            if sh_type == 1 and sh_flags & 0x2 and sh_size:
+                self.sections.append((sh_addr, sh_size, sh_offset))
+        self.cache = {}
+
+    def format(self, address):
+        """Format string stored at the given address or None."""
+        if address not in self.cache:
+            self.cache[address] = None
+            for sh_addr, sh_size, sh_offset in self.sections:
+                if sh_addr <= address < sh_addr + sh_size:
+                    start = sh_offset + address - sh_addr
+                    end = self.image.find(b'\0', start, sh_offset + sh_size)
+                    if end > start:
+                        self.cache[address] = self.image[start:end]
+                    break
+        return self.cache[address]
+
+
+class Record:
+    """Sequential reader of the argument bytes of one record."""
+
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def take(self, size, signed=False):
+        if self.pos + size > len(self.data):
+            raise IndexError
+        value = int.from_bytes(self.data[self.pos:self.pos + size], 'little', signed=signed)
+        self.pos += size
+        return value
+
+    def take_double(self, size):
+        if self.pos + size > len(self.data):
+            raise IndexError
+        value, = struct.unpack_from('<f' if size == 4 else '<d', self.data, self.pos)
+        self.pos += size
+        return value
+
+    def take_string(self):
+        end = self.data.find(b'\0', self.pos)
+        if end < 0:
+            raise IndexError
+        value = self.data[self.pos:end].decode('latin-1')
+        self.pos = end + 1
+        return value
+
+
+def render(firmware, fmt, record):
+    """printf() the format string with the recorded arguments."""
+    out = []
+    last = 0
+    for match in SPEC.finditer(fmt):
+        out.append(fmt[last:match.start()].decode('latin-1'))
+        last = match.end()
+        flags, width, precision, length, conv = [
+            group.decode() if group else '' for group in match.groups()]
+        if conv == '%':
+            out.append('%')
+            continue
+        try:
+            if width == '*':
+                width = str(record.take(firmware.int_size, True))
+            if precision == '*':
+                precision = str(record.take(firmware.int_size, True))
+            if length == 'll':
+                size = 8
+            elif length == 'l':
+                size = 4
+            elif length == 'z':
+                size = firmware.ptr_size
+            else:
+                size = firmware.int_size
+            spec = '%' + flags + width + ('.' + precision if precision else '')
+            if conv in 'di':
+                out.append((spec + 'd') % record.take(size, True))
+            elif conv in 'ouxX':
+                out.append((spec + conv) % record.take(size))
+            elif conv == 'c':
+                out.append((spec + 'c') % chr(record.take(size) & 0xFF))
+            elif conv == 's':
+                out.append((spec + 's') % record.take_string())
+            elif conv == 'p':
+                out.append('0x%x' % record.take(firmware.ptr_size))
+            else:
+                out.append((spec + conv) % record.take_double(firmware.double_size))
+        except IndexError:
+            # argument truncated by the firmware
+            out.append('?')
+    out.append(fmt[last:].decode('latin-1'))
+    return ''.join(out)
+
+
+def decode(firmware, stream, output):
+    """Translate the byte stream into text lines."""
+    millis = None
+    while True:
+        byte = stream.read(1)
+        if not byte:
+            return
+        if byte[0] != SYNC:
+            output.write(byte.decode('latin-1'))
+            continue
+        length = stream.read(1)
+        if not length:
+            return
+        data = stream.read(length[0])
+        header = firmware.ptr_size + 2
+        if len(data) < header:
+            return
+        address = int.from_bytes(data[:firmware.ptr_size], 'little')
+        stamp = int.from_bytes(data[firmware.ptr_size:header], 'little')
+        # unwrap the 16 bit timestamps
+        if millis is None:
+            millis = stamp
+        else:
+            millis += (stamp - millis) & 0xFFFF
+        record = Record(data[header:])
+        if address == 0:
+            line = '!TRACE:DROP=%d\n' % record.take(2)
+        else:
+            fmt = firmware.format(address)
+            if fmt is None:
+                line = '!TRACE:ID=0x%x,DATA=%s\n' % (address, data[header:].hex())
+            else:
+                line = render(firmware, fmt, record)
+        output.write('%d %s' % (millis, line))
+        output.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('elf', help='ELF file of the traced firmware')
+    parser.add_argument('input', nargs='?', default='-',
+                        help='serial device or capture file, - for stdin (default)')
+    parser.add_argument('--baud', type=int, help='open input as serial port (needs pyserial)')
+    args = parser.parse_args()
+
+    firmware = Firmware(args.elf)
+    if args.baud:
+        import serial
+        stream = serial.Serial(args.input, args.baud)
+    elif args.input == '-':
+        stream = sys.stdin.buffer
+    else:
+        stream = open(args.input, 'rb')
+    try:
+        decode(firmware, stream, sys.stdout)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
@@ -99,6 +99,38 @@
 #define MY_DEBUG_OTA_DISABLE_ECHO
 #endif
 
+/**
+ * @def MY_DEBUG_TRACE
+ * @brief Define MY_DEBUG_TRACE to emit binary trace records instead of formatted debug prints.
+ *
+ * Each debug point stores the address of its format string (the event id), a 16 bit timestamp
+ * and the raw argument bytes in a ring buffer instead of formatting the line at the call site.
+ * The buffer is drained to MY_DEBUGDEVICE from the main loop and before sleeping. Records are
+ * decoded on the host with .mystools/trace/decode_trace.py which builds the event table from the
+ * firmware ELF file. Once the buffer is half full it is drained blocking, records that still do
+ * not fit are dropped and counted.
+ *
+ * Not available on serial gateways, the binary records would corrupt the controller stream.
+ * Not available together with MY_DEBUG_OTA and on Linux.
+ */
+//#define MY_DEBUG_TRACE
+
+/**
+ * @def MY_DEBUG_TRACE_BUFFER_SIZE
+ * @brief Size of the MY_DEBUG_TRACE ring buffer in bytes.
+ */
+#ifndef MY_DEBUG_TRACE_BUFFER_SIZE
+#define MY_DEBUG_TRACE_BUFFER_SIZE (256u)
+#endif
+
+/**
+ * @def MY_DEBUG_TRACE_STRING_SIZE
+ * @brief Maximum number of characters recorded per string argument in MY_DEBUG_TRACE mode.
+ */
+#ifndef MY_DEBUG_TRACE_STRING_SIZE
+#define MY_DEBUG_TRACE_STRING_SIZE (24u)
+#endif
+
 /**
  * @def MY_OTA_LOG_RECEIVER_FEATURE
  * @brief Define this to enable printing of OTA logs.
@@ -185,9 +217,21 @@
  * of a SPI flash. Used EEPROM needs to be large enough, an 24(L)C256 will do as minimum.
  * HW I2C assumed. This will exclude the SPI flash code.
  * Note that you also need an updated DualOptiboot supporting I2C EEPROM!
+ * Fm+ EEPROMs (e.g. 24FC256) can run at 1MHz with
+ * \code #define I2CEEPROM_TWI_CLK twiClock1000kHz \endcode
  */
 //#define MY_OTA_USE_I2C_EEPROM
 
+/**
+ * @def MY_OTA_I2C_EEPROM_PAGE_BUFFER
+ * @brief Collect firmware blocks in a RAM buffer of one EEPROM page (I2CEEPROM_PAGE_SIZE bytes)
+ * and write whole pages.
+ *
+ * An EEPROM write cycle takes up to 5ms regardless of the number of bytes. Note that the
+ * Wire buffer limits the bytes per cycle, 30 bytes on AVR.
+ */
+//#define MY_OTA_I2C_EEPROM_PAGE_BUFFER
+
 #ifdef MY_OTA_USE_I2C_EEPROM
 // I2C address of EEPROM. Wire will shift this left, i.e. 0x50->0xA0
 #ifndef MY_OTA_I2C_ADDR
@@ -241,6 +285,46 @@
 #define MY_RS485_SOH_COUNT (1)
 #endif
 
+/**
+ * @def MY_RS485_CRC16
+ * @brief Define this to protect RS485 frames with a CRC16 (MODBUS) instead of an 8 bit sum.
+ *
+ * All nodes on the bus must use the same setting.
+ */
+//#define MY_RS485_CRC16
+
+/**
+ * @def MY_RS485_TDMA
+ * @brief Define this to arbitrate the RS485 bus in time slots instead of carrier sense.
+ *
+ * The GW broadcasts a beacon that starts a cycle of @ref MY_RS485_TDMA_SLOTS slots, each long
+ * enough for a frame of @ref MY_RS485_MAX_MESSAGE_LENGTH bytes plus @ref MY_RS485_TDMA_GUARD_US.
+ * Slot 0 belongs to the GW, a node sends in slot 1 + (node id - 1) % (slots - 1) and waits for
+ * it in transportSend(), processing received frames meanwhile. Nodes that have not heard a
+ * beacon for two cycles fall back to carrier sense. All nodes on the bus and the GW must use
+ * the same settings. Nodes should poll the transport more often than the guard time, the
+ * beacon is timed when it is processed.
+ */
+//#define MY_RS485_TDMA
+
+/**
+ * @def MY_RS485_TDMA_SLOTS
+ * @brief Number of slots per cycle with @ref MY_RS485_TDMA, including the slot of the GW.
+ */
+#ifndef MY_RS485_TDMA_SLOTS
+#define MY_RS485_TDMA_SLOTS (16u)
+#endif
+
+/**
+ * @def MY_RS485_TDMA_GUARD_US
+ * @brief Idle time (in us) at the end of each slot with @ref MY_RS485_TDMA.
+ *
+ * Covers the latency of the beacon processing and the driver enable turnaround.
+ */
+#ifndef MY_RS485_TDMA_GUARD_US
+#define MY_RS485_TDMA_GUARD_US (2000ul)
+#endif
+
 
 /**
  * @def MY_RS485_DE_PIN
@@ -248,6 +332,17 @@
  */
 //#define MY_RS485_DE_PIN (2)
 
+/**
+ * @def MY_RS485_KERNEL_DE
+ * @brief Define this on Linux to let the kernel drive the driver enable of the transceiver.
+ *
+ * The serial port is switched to RS485 mode (TIOCSRS485), RTS is asserted while a frame is sent
+ * and released by the UART driver right after the last stop bit. No GPIO is toggled and the
+ * write does not wait for the transmission. DE must be wired to RTS and the UART driver must
+ * support RS485 mode. Cannot be combined with @ref MY_RS485_DE_PIN.
+ */
+//#define MY_RS485_KERNEL_DE
+
 /**
  * @def MY_RS485_HWSERIAL
  * @brief Define this if RS485 is connected to a hardware serial port.
@@ -255,8 +350,160 @@
  * Example: @code #define MY_RS485_HWSERIAL Serial1 @endcode
  */
 //#define MY_RS485_HWSERIAL (Serial1)
+
+/**
+ * @def MY_ALTSOFTSERIAL_RX_BUFFER_SIZE
+ * @brief Size of the AltSoftSerial receive buffer in bytes, up to 255.
+ *
+ * Bytes arriving while the buffer is full are dropped and counted, see
+ * AltSoftSerial::rxOverruns() and AltSoftSerial::rxHighWater().
+ */
+#ifndef MY_ALTSOFTSERIAL_RX_BUFFER_SIZE
+#define MY_ALTSOFTSERIAL_RX_BUFFER_SIZE (80u)
+#endif
 /** @}*/ // End of RS485SettingGrpPub group
 
+/**
+ * @defgroup SimulatedSettingGrpPub Simulated radio
+ * @ingroup TransportSettingGrpPub
+ * @brief These options are specific to the simulated radio of Linux builds.
+ *
+ * The simulated radio connects node processes on one Linux host, e.g. hundreds of nodes and
+ * a mysgw, to load test routing, signing or OTA without hardware. All processes join a UDP
+ * multicast group on the loopback interface. Loss, time on air and the topology (which nodes
+ * hear each other, with loss and RSSI per link) are set by the sim_* options of the
+ * configuration file. Build with the --my-transport=simulated option of configure.
+ * @{
+ */
+
+/**
+ * @def MY_RADIO_SIMULATED
+ * @brief Define this to use the simulated radio for sensor network communication (Linux only).
+ */
+//#define MY_RADIO_SIMULATED
+
+/**
+ * @def MY_RADIO_SIMULATED_GROUP
+ * @brief Multicast group of the simulated network, overridden by sim_group.
+ */
+#ifndef MY_RADIO_SIMULATED_GROUP
+#define MY_RADIO_SIMULATED_GROUP "239.255.77.77"
+#endif
+
+/**
+ * @def MY_RADIO_SIMULATED_PORT
+ * @brief UDP port of the simulated network, overridden by sim_port.
+ */
+#ifndef MY_RADIO_SIMULATED_PORT
+#define MY_RADIO_SIMULATED_PORT (17777u)
+#endif
+
+/**
+ * @def MY_RADIO_SIMULATED_ACK_TIMEOUT_MS
+ * @brief Time in ms a sender waits for the ACK of a frame before it is resent.
+ */
+#ifndef MY_RADIO_SIMULATED_ACK_TIMEOUT_MS
+#define MY_RADIO_SIMULATED_ACK_TIMEOUT_MS (5u)
+#endif
+
+/**
+ * @def MY_RADIO_SIMULATED_RETRIES
+ * @brief Times an unacknowledged frame is resent.
+ */
+#ifndef MY_RADIO_SIMULATED_RETRIES
+#define MY_RADIO_SIMULATED_RETRIES (3u)
+#endif
+
+/**
+ * @def MY_RADIO_SIMULATED_RX_QUEUE_SIZE
+ * @brief Received frames buffered by the simulated radio, further frames are not acknowledged.
+ */
+#ifndef MY_RADIO_SIMULATED_RX_QUEUE_SIZE
+#define MY_RADIO_SIMULATED_RX_QUEUE_SIZE (16u)
+#endif
+/** @}*/ // End of SimulatedSettingGrpPub group
+
+/**
+ * @defgroup RemoteSettingGrpPub Remote radio
+ * @ingroup TransportSettingGrpPub
+ * @brief These options are specific to the radio of a coprocessor attached to a Linux gateway.
+ *
+ * Hosts without SPI, e.g. x86 servers and VMs, use the radio of a microcontroller attached to
+ * a (USB) serial port. The coprocessor runs the radio driver only: it sends with ACK and retries
+ * on its own, and forwards the received frames in batches with the time they were received.
+ * The gateway runs the transport. Build the gateway with the --my-transport=remote option of
+ * configure, and the coprocessor from the RemoteRadioCoprocessor example with the radio options
+ * of the network. See RemoteRadio.h for the serial link.
+ * @{
+ */
+
+/**
+ * @def MY_RADIO_REMOTE
+ * @brief Define this on a Linux gateway to use the radio of a coprocessor.
+ */
+//#define MY_RADIO_REMOTE
+
+/**
+ * @def MY_RADIO_REMOTE_COPROCESSOR
+ * @brief Define this with @ref MY_CORE_ONLY and a radio to build the coprocessor.
+ *
+ * Call remoteRadioBegin() in setup() and remoteRadioProcess() in loop().
+ */
+//#define MY_RADIO_REMOTE_COPROCESSOR
+
+/**
+ * @def MY_RADIO_REMOTE_SERIAL
+ * @brief Serial port of the link, the device on the gateway and the serial object on the coprocessor.
+ */
+#ifndef MY_RADIO_REMOTE_SERIAL
+#if defined(__linux__)
+#define MY_RADIO_REMOTE_SERIAL "/dev/ttyACM0"
+#else
+#define MY_RADIO_REMOTE_SERIAL Serial
+#endif
+#endif
+
+/**
+ * @def MY_RADIO_REMOTE_BAUD_RATE
+ * @brief Baud rate of the link, not used by native USB ports.
+ */
+#ifndef MY_RADIO_REMOTE_BAUD_RATE
+#define MY_RADIO_REMOTE_BAUD_RATE (115200ul)
+#endif
+
+/**
+ * @def MY_RADIO_REMOTE_TIMEOUT_MS
+ * @brief Time in ms the gateway waits for an answer of the coprocessor, must cover the retries of a frame.
+ */
+#ifndef MY_RADIO_REMOTE_TIMEOUT_MS
+#define MY_RADIO_REMOTE_TIMEOUT_MS (250u)
+#endif
+
+/**
+ * @def MY_RADIO_REMOTE_INIT_TIMEOUT_MS
+ * @brief Time in ms the gateway waits for the coprocessor to start, opening the port may reset it.
+ */
+#ifndef MY_RADIO_REMOTE_INIT_TIMEOUT_MS
+#define MY_RADIO_REMOTE_INIT_TIMEOUT_MS (5000u)
+#endif
+
+/**
+ * @def MY_RADIO_REMOTE_RX_QUEUE_SIZE
+ * @brief Received frames buffered by the gateway, further frames are dropped.
+ */
+#ifndef MY_RADIO_REMOTE_RX_QUEUE_SIZE
+#define MY_RADIO_REMOTE_RX_QUEUE_SIZE (32u)
+#endif
+
+/**
+ * @def MY_RADIO_REMOTE_RX_BATCH
+ * @brief Received frames the coprocessor sends in one message, at most 6.
+ */
+#ifndef MY_RADIO_REMOTE_RX_BATCH
+#define MY_RADIO_REMOTE_RX_BATCH (4u)
+#endif
+/** @}*/ // End of RemoteSettingGrpPub group
+
 /**
  * @defgroup RF24SettingGrpPub RF24
  * @ingroup TransportSettingGrpPub
@@ -303,7 +550,8 @@
  * key.
  * @see @ref personalization
  *
- * @warning This driver always sets the initialization vector to 0 so encryption is weak.
+ * @warning This driver always sets the initialization vector to 0 so encryption is weak, unless
+ * @ref MY_ENCRYPTION_CTR is used.
  */
 //#define MY_RF24_ENABLE_ENCRYPTION
 
@@ -323,6 +571,18 @@
 #define MY_RF24_SPI_SPEED (2*1000000ul)
 #endif
 
+/**
+ * @def MY_RF24_SPI_CSN_DELAY_US
+ * @brief Delay in us after selecting and after deselecting the RF24 module for an SPI transaction.
+ *
+ * The nRF24L01+ requires 2ns CSN to SCK setup and 50ns CSN high time between transactions, which
+ * the pin writes already take, so no delay is added by default. Define e.g. 10 for modules that
+ * need more, like clones behind slow level shifters. Not used on Linux, where spidev drives CSN.
+ */
+#ifndef MY_RF24_SPI_CSN_DELAY_US
+#define MY_RF24_SPI_CSN_DELAY_US (0u)
+#endif
+
 /**
  * @def MY_RF24_CE_PIN
  * @brief Define this to change the chip enable pin from the default.
@@ -355,8 +615,11 @@
  * @def MY_RX_MESSAGE_BUFFER_FEATURE
  * @brief This enables the receiving buffer feature.
  *
- * This feature is currently not supported for anything but RF24.
- * Require @ref MY_RF24_IRQ_PIN to be set.
+ * Supported for RF24, RFM69, RFM95 and RS485. RF24 requires @ref MY_RF24_IRQ_PIN to be set and
+ * reads frames from its interrupt, which also signals the end of a transmission instead of
+ * polling the radio status via SPI. For the other transports the HAL takes every frame out
+ * of the radio as soon as it is flagged, also around sending, into a queue of
+ * @ref MY_RX_MESSAGE_BUFFER_SIZE frames, see transportHALGetRxQueueStats().
  *
  * Note: Not supported on ESP8266. See below issue for details
  * https://github.com/mysensors/MySensors/issues/1128
@@ -367,11 +630,12 @@
  * @def MY_RX_MESSAGE_BUFFER_SIZE
  * @brief Define this to change the incoming message buffer size from the default.
  *
- * Require @ref MY_RX_MESSAGE_BUFFER_FEATURE to be set.
+ * Require @ref MY_RX_MESSAGE_BUFFER_FEATURE to be set. The RF24 queue is lock-free and rounds
+ * the size up to a power of two (max. 128).
  */
 #ifdef MY_RX_MESSAGE_BUFFER_FEATURE
 #ifndef MY_RX_MESSAGE_BUFFER_SIZE
-#define MY_RX_MESSAGE_BUFFER_SIZE (20)
+#define MY_RX_MESSAGE_BUFFER_SIZE (16)
 #endif
 #endif
 
@@ -383,11 +647,23 @@
  * - RF24_PA_LOW = -12dBm
  * - RF24_PA_HIGH = -6dBm
  * - RF24_PA_MAX = 0dBm
+ *
+ * With @ref MY_RF24_ATC_MODE this is the maximum level.
  */
 #ifndef MY_RF24_PA_LEVEL
 #define MY_RF24_PA_LEVEL (RF24_PA_HIGH)
 #endif
 
+/**
+ * @def MY_RF24_ATC_MODE
+ * @brief Define to enable automatic TX power control (ATC) of the RF24 driver in nodes.
+ *
+ * The nRF24 provides no RSSI, the retransmit count of acknowledged frames is used instead:
+ * frames needing retransmits or failing raise the PA level, a run of frames without retransmit
+ * lowers it. The level is kept between RF24_PA_MIN and @ref MY_RF24_PA_LEVEL.
+ */
+//#define MY_RF24_ATC_MODE
+
 /**
  * @def MY_RF24_CHANNEL
  * @brief RF channel for the sensor net, 0-125.
@@ -407,6 +683,9 @@
  * In some countries there might be limitations, in Germany for example only the range
  * 2400,0 - 2483,5 Mhz is allowed.
  * @see http://www.bundesnetzagentur.de/SharedDocs/Downloads/DE/Sachgebiete/Telekommunikation/Unternehmen_Institutionen/Frequenzen/Allgemeinzuteilungen/2013_10_WLAN_2,4GHz_pdf.pdf
+ *
+ * Linux gateways take the channel from rf24_channel in the config file if set, so several
+ * gateways can serve separate networks on separate channels.
  */
 #ifndef MY_RF24_CHANNEL
 #define MY_RF24_CHANNEL (76)
@@ -427,6 +706,37 @@
 #define MY_RF24_DATARATE (RF24_250KBPS)
 #endif
 
+/**
+ * @def MY_RF24_LINK_DATARATE
+ * @brief Define this to a faster data rate used on the links that carry it, e.g. RF24_2MBPS.
+ *
+ * A frame is sent at this data rate first, if it gets no ACK the link falls back to
+ * @ref MY_RF24_DATARATE and is tried again every @ref MY_RF24_LINK_DATARATE_PROBE messages to
+ * slow links. A radio receives at one data rate only, gateway and repeaters therefore listen at
+ * both in turns of @ref MY_RF24_LINK_DATARATE_DWELL_MS, the auto retransmits of a sender bridge
+ * the other turn. Other nodes listen at @ref MY_RF24_DATARATE, broadcasts go out at both data
+ * rates. All nodes of the network need this option.
+ */
+//#define MY_RF24_LINK_DATARATE (RF24_2MBPS)
+
+/**
+ * @def MY_RF24_LINK_DATARATE_DWELL_MS
+ * @brief Time gateway and repeaters listen at one data rate, see @ref MY_RF24_LINK_DATARATE.
+ *
+ * Two turns must be shorter than the 15 auto retransmits of a frame (~22ms).
+ */
+#ifndef MY_RF24_LINK_DATARATE_DWELL_MS
+#define MY_RF24_LINK_DATARATE_DWELL_MS (5u)
+#endif
+
+/**
+ * @def MY_RF24_LINK_DATARATE_PROBE
+ * @brief Every how many messages to slow links one is tried at @ref MY_RF24_LINK_DATARATE.
+ */
+#ifndef MY_RF24_LINK_DATARATE_PROBE
+#define MY_RF24_LINK_DATARATE_PROBE (32u)
+#endif
+
 /**
  * @def MY_RF24_BASE_RADIO_ID
  * @brief RF24 radio network identifier.
@@ -445,6 +755,29 @@
 #ifndef MY_RF24_ADDR_WIDTH
 #define MY_RF24_ADDR_WIDTH (5)
 #endif
+
+/**
+ * @def MY_RF24_ACK_PAYLOAD
+ * @brief Define this to send messages in the ACK of a received frame (nRF24L01+ only).
+ *
+ * The radio attaches the payload to the ACK of the next frame on the pipe, whoever sent it. A
+ * payload set for a node is therefore loaded once a frame of the node was received and leaves
+ * with the ACK of its following frame. A gateway with @ref MY_GATEWAY_MAILBOX arms the oldest
+ * buffered message of a sleeping direct child this way: a node sending a reading and its
+ * pre-sleep notification has the message before it gets to listen. If another node transmits
+ * in between it drops the payload, which is loaded again. The message then stays in the
+ * mailbox, and it may reach the node twice. All nodes of the network need this option, a radio
+ * without it cannot take an ACK with payload. Not available with encryption or signing.
+ */
+//#define MY_RF24_ACK_PAYLOAD
+
+/**
+ * @def MY_RF24_ACK_PAYLOAD_SLOTS
+ * @brief Number of nodes with a pending ACK payload, see @ref MY_RF24_ACK_PAYLOAD.
+ */
+#ifndef MY_RF24_ACK_PAYLOAD_SLOTS
+#define MY_RF24_ACK_PAYLOAD_SLOTS (4u)
+#endif
 /** @}*/ // End of RF24SettingGrpPub group
 
 /**
@@ -478,7 +811,8 @@
  * key.
  * @see @ref personalization
  *
- * @warning This driver always sets the initialization vector to 0 so encryption is weak.
+ * @warning This driver always sets the initialization vector to 0 so encryption is weak, unless
+ * @ref MY_ENCRYPTION_CTR is used.
  */
 //#define MY_NRF5_ESB_ENABLE_ENCRYPTION
 
@@ -496,11 +830,31 @@
  * - NRF5_PA_LOW = -16dBm
  * - NRF5_PA_HIGH = 0dBm
  * - NRF5_PA_MAX = 4dBm
+ *
+ * With @ref MY_NRF5_ESB_ATC_MODE this is the maximum level.
  */
 #ifndef MY_NRF5_ESB_PA_LEVEL
 #define MY_NRF5_ESB_PA_LEVEL (NRF5_PA_MAX)
 #endif
 
+/**
+ * @def MY_NRF5_ESB_ATC_MODE
+ * @brief Define to enable automatic TX power control (ATC) of the nRF5 driver in nodes.
+ *
+ * The TX level is adjusted between NRF5_PA_LOW and @ref MY_NRF5_ESB_PA_LEVEL to reach
+ * @ref MY_NRF5_ESB_ATC_TARGET_RSSI, as reported in the ACK by the receiver.
+ */
+//#define MY_NRF5_ESB_ATC_MODE
+#define MY_NRF5_ESB_ACK_PAYLOAD
+
+/**
+ * @def MY_NRF5_ESB_ATC_TARGET_RSSI
+ * @brief Target RSSI level (in dBm) for nRF5 ATC mode.
+ */
+#ifndef MY_NRF5_ESB_ATC_TARGET_RSSI
+#define MY_NRF5_ESB_ATC_TARGET_RSSI (-80)
+#endif
+
 /**
  * @def MY_NRF5_ESB_CHANNEL
  * @brief RF channel for the sensor net, 0-125.
@@ -560,9 +914,13 @@
 /**
  * @def MY_NRF5_ESB_RX_BUFFER_SIZE
  * @brief Declare the amount of incoming messages that can be buffered at driver level.
+ *
+ * The radio receives directly into a pool of this many buffers plus two, the one being
+ * received and the one armed for the next packet. The queues are lock-free and round the
+ * pool size up to a power of two (max. 126 buffered messages).
  */
 #ifndef MY_NRF5_ESB_RX_BUFFER_SIZE
-#define MY_NRF5_ESB_RX_BUFFER_SIZE (20)
+#define MY_NRF5_ESB_RX_BUFFER_SIZE (16)
 #endif
 
 /**
@@ -576,6 +934,25 @@
  * @brief Switch to SI24R1 or faked nRF24L01+ compatible ACK mode. ACK bit is reversed on RX side.
  */
 //#define MY_NRF5_ESB_REVERSE_ACK_RX
+
+/**
+ * @def MY_NRF5_ESB_ACK_PAYLOAD
+ * @brief Define this to send messages in the ACK of a received packet.
+ *
+ * A payload set for a node leaves with the ACK of its next packet, at most once and without
+ * retries. A gateway with @ref MY_GATEWAY_MAILBOX arms the oldest buffered message of a
+ * sleeping direct child this way, the node has it before it gets to listen. Messages that
+ * are not confirmed sent stay in the mailbox. Not available with encryption or signing.
+ */
+//#define MY_NRF5_ESB_ACK_PAYLOAD
+
+/**
+ * @def MY_NRF5_ESB_ACK_PAYLOAD_SLOTS
+ * @brief Number of nodes with a pending ACK payload, see @ref MY_NRF5_ESB_ACK_PAYLOAD.
+ */
+#ifndef MY_NRF5_ESB_ACK_PAYLOAD_SLOTS
+#define MY_NRF5_ESB_ACK_PAYLOAD_SLOTS (4u)
+#endif
 /** @}*/ // End of NRF5SettingGrpPub group
 
 /**
@@ -796,6 +1173,39 @@
  */
 //#define MY_RFM69_MODEM_CONFIGURATION (RFM69_FSK_BR55_5_FD50)
 
+/**
+ * @def MY_RFM69_ENABLE_LISTENMODE
+ * @brief Define this on a sleeping node to keep the %RFM69 receiving in Listen Mode, requires
+ * @ref MY_RFM69_NEW_DRIVER.
+ *
+ * While the MCU sleeps the radio wakes itself every @ref MY_RFM69_DEFAULT_LISTEN_IDLE_US for
+ * @ref MY_RFM69_DEFAULT_LISTEN_RX_US. A frame wakes the MCU on the radio interrupt, it is
+ * processed and sleep() continues for the remaining time. sleep() needs a free interrupt for
+ * the radio, with two interrupts in use the radio does not wake the MCU.
+ *
+ * On entering sleep() the node broadcasts an I_WAKE_ON_RADIO with its listen cycle. The parent
+ * needs @ref MY_TRANSPORT_WAKE_ON_RADIO, it resends an unacknowledged frame with a preamble
+ * spanning the cycle. The radio stays in RX for at most 4080 bit times after detecting a
+ * preamble, this limits the cycle to about 60 ms at 55.5 kbps and 400 ms at 9.6 kbps.
+ */
+//#define MY_RFM69_ENABLE_LISTENMODE
+
+/**
+ * @def MY_RFM69_DEFAULT_LISTEN_IDLE_US
+ * @brief Time in us the radio idles per listen cycle, see @ref MY_RFM69_ENABLE_LISTENMODE.
+ */
+#ifndef MY_RFM69_DEFAULT_LISTEN_IDLE_US
+#define MY_RFM69_DEFAULT_LISTEN_IDLE_US (50000ul)
+#endif
+
+/**
+ * @def MY_RFM69_DEFAULT_LISTEN_RX_US
+ * @brief Time in us the radio receives per listen cycle, see @ref MY_RFM69_ENABLE_LISTENMODE.
+ */
+#ifndef MY_RFM69_DEFAULT_LISTEN_RX_US
+#define MY_RFM69_DEFAULT_LISTEN_RX_US (1000ul)
+#endif
+
 
 /** @}*/ // End of RFM69SettingGrpPub group
 
@@ -815,6 +1225,28 @@
  */
 //#define MY_RADIO_RFM95
 
+/**
+ * @def MY_GATEWAY_SECONDARY_RFM95
+ * @brief Define this to run an RFM95 on the GW as second radio next to the RF24, RS485 or
+ * simulated radio.
+ *
+ * Both radios use the GW address and share one node ID space and routing table. The GW
+ * remembers on which radio it heard each neighbour and sends to it there. A neighbour it has not
+ * heard yet is tried on the other radio when the frame is not acknowledged, broadcasts go out on
+ * both radios. Received frames are queued per radio and handed out in turns. The RFM95 is
+ * configured with the MY_RFM95_xxx settings below, make sure its CS and IRQ pins differ from the
+ * ones of the first radio.
+ */
+//#define MY_GATEWAY_SECONDARY_RFM95
+
+/**
+ * @def MY_GATEWAY_SECONDARY_RX_QUEUE_SIZE
+ * @brief Number of frames queued from the secondary radio, see @ref MY_GATEWAY_SECONDARY_RFM95.
+ */
+#ifndef MY_GATEWAY_SECONDARY_RX_QUEUE_SIZE
+#define MY_GATEWAY_SECONDARY_RX_QUEUE_SIZE (4u)
+#endif
+
 /**
  * @def MY_DEBUG_VERBOSE_RFM95
  * @brief Define this for verbose debug prints related to the RFM95 driver.
@@ -829,7 +1261,8 @@
  * key.
  * @see @ref personalization
  *
- * @warning This driver always sets the initialization vector to 0 so encryption is weak.
+ * @warning This driver always sets the initialization vector to 0 so encryption is weak, unless
+ * @ref MY_ENCRYPTION_CTR is used.
  */
 //#define MY_RFM95_ENABLE_ENCRYPTION
 
@@ -959,6 +1392,36 @@
  * This allows for better stability using SF 9 to 12.
  */
 //#define MY_RFM95_TCXO
+
+/**
+ * @def MY_RFM95_IMPLICIT_ACK
+ * @brief Define this to send ACKs without LoRa header.
+ *
+ * The length of an ACK is known, the sender of a frame listens for it in implicit header
+ * mode. This saves the header symbols of every ACK. Frames of other lengths cannot be received
+ * while waiting for the ACK. All nodes of the network need this option.
+ */
+//#define MY_RFM95_IMPLICIT_ACK
+
+/**
+ * @def MY_RFM95_SHORT_PREAMBLE_LENGTH
+ * @brief Define this to a preamble length of at least 6 symbols for links with good SNR.
+ *
+ * Receivers keep listening for the default preamble of 8 symbols and detect a shorter one as
+ * well. Frames and ACKs to a node use the short preamble while the SNR of the link is
+ * @ref MY_RFM95_SHORT_PREAMBLE_MARGIN_DB above the demodulation limit of the spreading factor.
+ * The SNR is taken from received frames and from the report in the ACKs, a missing ACK restores
+ * the full preamble for the retry.
+ */
+//#define MY_RFM95_SHORT_PREAMBLE_LENGTH (6u)
+
+/**
+ * @def MY_RFM95_SHORT_PREAMBLE_MARGIN_DB
+ * @brief SNR margin for @ref MY_RFM95_SHORT_PREAMBLE_LENGTH in dB.
+ */
+#ifndef MY_RFM95_SHORT_PREAMBLE_MARGIN_DB
+#define MY_RFM95_SHORT_PREAMBLE_MARGIN_DB (10)
+#endif
 /** @}*/ // End of RFM95SettingGrpPub group
 
 /**
@@ -1003,6 +1466,29 @@
 #ifndef MY_SOFT_SPI_MOSI_PIN
 #define MY_SOFT_SPI_MOSI_PIN (15)
 #endif
+
+/**
+ * @def MY_SPI_DMA
+ * @brief Define this to move radio FIFO blocks of hardware SPI by DMA on SAMD (DMAC), STM32F1,
+ * nRF52 (SPIM EasyDMA) and Raspberry Pi gateways with the BCM SPI driver.
+ *
+ * The bytes follow back-to-back at the SPI clock instead of one transfer() call each. The
+ * radio drivers keep chip select low over the block, the transfer is completed before
+ * returning. On SAMD channels 0 and 1 of the DMAC are taken, it cannot be shared with other
+ * DMA libraries. On the Raspberry Pi DMA channels 8 and 9 are taken (override with
+ * BCM2835_SPI_DMA_TX_CHANNEL and BCM2835_SPI_DMA_RX_CHANNEL), the gateway yields the CPU while
+ * a block is moved and falls back to polled transfers if /dev/vcio is not available.
+ * Configure the gateway with --spi-dma.
+ */
+//#define MY_SPI_DMA
+
+/**
+ * @def MY_SPI_DMA_MIN_LENGTH
+ * @brief Shorter blocks are transferred byte by byte, see @ref MY_SPI_DMA.
+ */
+#ifndef MY_SPI_DMA_MIN_LENGTH
+#define MY_SPI_DMA_MIN_LENGTH (8u)
+#endif
 /** @}*/ // End of SoftSpiSettingGrpPub group
 
 /** @}*/ // End of TransportSettingGrpPub group
@@ -1033,12 +1519,78 @@
 
 /**
  * @def MY_ROUTING_TABLE_SAVE_INTERVAL_MS
- * @brief Interval to dump content of routing table to EEPROM
+ * @brief Interval to save changed routes of the RAM routing table to EEPROM
+ *
+ * Routing itself only uses the RAM table, this limits the EEPROM (or flash) writes to one per
+ * interval, and none while no routes change.
  */
 #ifndef MY_ROUTING_TABLE_SAVE_INTERVAL_MS
 #define MY_ROUTING_TABLE_SAVE_INTERVAL_MS (30*60*1000ul)
 #endif
 
+/**
+ * @def MY_ROUTING_TABLE_BACKUP_ROUTES
+ * @brief Define this to keep link metrics and a backup route per node in the RAM routing table.
+ *
+ * The RSSI of messages received via the route and when the last one arrived are tracked. A message
+ * from a node arriving via another hop makes that hop the backup route. It only becomes the route
+ * if it is received stronger by @ref MY_ROUTING_TABLE_HYSTERESIS_RSSI or the route was silent for
+ * @ref MY_ROUTING_TABLE_ROUTE_TIMEOUT_MS, so a flaky hop does not flip the route back and forth.
+ * If sending via the route fails, the message is sent via the backup route, which replaces it.
+ * Backup routes and metrics are not saved. Requires @ref MY_RAM_ROUTING_TABLE_FEATURE, costs
+ * 5 bytes of RAM per node (1280 bytes).
+ */
+//#define MY_ROUTING_TABLE_BACKUP_ROUTES
+
+/**
+ * @def MY_ROUTING_TABLE_HYSTERESIS_RSSI
+ * @brief RSSI margin in dB a backup route needs to replace the route, see @ref MY_ROUTING_TABLE_BACKUP_ROUTES.
+ */
+#ifndef MY_ROUTING_TABLE_HYSTERESIS_RSSI
+#define MY_ROUTING_TABLE_HYSTERESIS_RSSI (6)
+#endif
+
+/**
+ * @def MY_ROUTING_TABLE_ROUTE_TIMEOUT_MS
+ * @brief Time without messages via a route after which another hop replaces it right away.
+ */
+#ifndef MY_ROUTING_TABLE_ROUTE_TIMEOUT_MS
+#define MY_ROUTING_TABLE_ROUTE_TIMEOUT_MS (10*60*1000ul)
+#endif
+
+/**
+ * @def MY_NODE_ID_16BIT
+ * @brief Define this to use 16 bit node ids, for networks of more than 254 nodes.
+ *
+ * Messages carry an extended header (protocol version 3) with 16 bit last, sender and
+ * destination, which leaves 22 bytes of payload. 0xFFFF is #AUTO and #BROADCAST_ADDRESS. All
+ * nodes of the network need this setting, version 2 messages are dropped.
+ *
+ * The routing table holds @ref MY_ROUTING_TABLE_SIZE routes, hashed by node id, instead of
+ * one per node. The node and parent ids take 2 bytes each in EEPROM, the EEPROM layout of the
+ * user data changes.
+ *
+ * The gateway passes the ids to the controller as they are. 255 stays the broadcast of the
+ * controller protocol and is not used as node id, raise @ref MY_GATEWAY_ID_ALLOCATOR_LAST to
+ * lease higher ids. Supported by the RF24 transport, which takes the two lowest address bytes
+ * for the node id, and the simulated radio. Signing and @ref MY_TRANSPORT_WAKE_ON_RADIO keep
+ * per-node tables of 256 entries and are not available.
+ */
+//#define MY_NODE_ID_16BIT
+
+/**
+ * @def MY_ROUTING_TABLE_SIZE
+ * @brief Routes kept by the routing table with @ref MY_NODE_ID_16BIT.
+ *
+ * Each route takes 4 bytes of EEPROM, the default keeps the 256 bytes of the 8 bit routing table.
+ * Nodes without a route are handled as after clearing the table, repeaters pass their messages
+ * to the parent and the gateway addresses them directly. Repeaters and gateways of larger
+ * networks need a larger table, 8..4096 routes.
+ */
+#ifndef MY_ROUTING_TABLE_SIZE
+#define MY_ROUTING_TABLE_SIZE (64u)
+#endif
+
 /**
  * @def MY_REPEATER_FEATURE
  * @brief Enables repeater functionality (relays messages from other nodes)
@@ -1081,208 +1633,1435 @@
 //#define MY_PARENT_NODE_IS_STATIC
 
 /**
- * @def MY_TRANSPORT_SANITY_CHECK
- * @brief If defined, will cause node to check transport in regular intervals to detect HW issues
- *        and re-initialize in case of failure.
- * @note This feature is enabled for all repeater nodes (incl. GW)
+ * @def MY_TRANSPORT_PARENT_CACHE
+ * @brief Define this to remember parent candidates and probe them first when finding a parent.
+ *
+ * The nodes that answered the find parent request are ranked by distance to the GW and RSSI, the
+ * best four are kept in EEPROM. When looking for a parent again, e.g. after a reboot or when
+ * the parent was lost, the node sends the request to the candidates one by one and takes the
+ * first one answering within @ref MY_TRANSPORT_PARENT_PROBE_MS. Candidates not answering are
+ * removed, the request is broadcast as before once no candidate is left.
  */
-//#define MY_TRANSPORT_SANITY_CHECK
+//#define MY_TRANSPORT_PARENT_CACHE
 
 /**
- * @def MY_TRANSPORT_SANITY_CHECK_INTERVAL_MS
- * @brief Interval (in ms) for transport sanity checks
+ * @def MY_TRANSPORT_PARENT_PROBE_MS
+ * @brief Time in ms a parent candidate has to answer, see @ref MY_TRANSPORT_PARENT_CACHE.
  */
-#ifndef MY_TRANSPORT_SANITY_CHECK_INTERVAL_MS
-#define MY_TRANSPORT_SANITY_CHECK_INTERVAL_MS (15*60*1000ul)
+#ifndef MY_TRANSPORT_PARENT_PROBE_MS
+#define MY_TRANSPORT_PARENT_PROBE_MS (500ul)
 #endif
+
 /**
- * @def MY_TRANSPORT_DISCOVERY_INTERVAL_MS
- * @brief This is a gateway-only feature: Interval (in ms) to issue network discovery checks
+ * @def MY_TRANSPORT_PARENT_LOAD
+ * @brief Define this to balance the nodes between the parents by their load.
+ *
+ * Parents add their load to the find parent response: the larger of the TX queue fill and the
+ * time on air, relative to the duty cycle budget with @ref MY_TRANSPORT_DUTY_CYCLE_FEATURE and
+ * to 10% of the time otherwise. Nodes choose the parent by a cost, a hop counts 100, a fully
+ * loaded parent @ref MY_TRANSPORT_PARENT_LOAD_WEIGHT and a weak link up to another hop, instead
+ * of by distance only. Parents with older firmware are taken as idle.
+ *
+ * Every @ref MY_TRANSPORT_PARENT_LOAD_INTERVAL_MS the nodes broadcast the find parent request
+ * again while staying connected and move to a parent cheaper by
+ * @ref MY_TRANSPORT_PARENT_LOAD_HYSTERESIS, never to one further from the GW. The reviews are
+ * spread over the interval by node ID, the nodes of a loaded parent move one at a time and see
+ * the load change in between.
  */
-#ifndef MY_TRANSPORT_DISCOVERY_INTERVAL_MS
-#define MY_TRANSPORT_DISCOVERY_INTERVAL_MS (20*60*1000ul)
-#endif
+//#define MY_TRANSPORT_PARENT_LOAD
 
 /**
- *@def MY_TRANSPORT_UPLINK_CHECK_DISABLED
- *@brief If defined, disables uplink check to GW during transport initialisation
+ * @def MY_TRANSPORT_PARENT_LOAD_WEIGHT
+ * @brief Cost of a fully loaded parent, a hop costs 100, see @ref MY_TRANSPORT_PARENT_LOAD.
  */
-//#define MY_TRANSPORT_UPLINK_CHECK_DISABLED
+#ifndef MY_TRANSPORT_PARENT_LOAD_WEIGHT
+#define MY_TRANSPORT_PARENT_LOAD_WEIGHT (100u)
+#endif
 
 /**
- *@def MY_TRANSPORT_MAX_TX_FAILURES
- *@brief Define to override max. consecutive TX failures until SNP is initiated
+ * @def MY_TRANSPORT_PARENT_LOAD_HYSTERESIS
+ * @brief Cost by which another parent has to be cheaper to move to it, see @ref MY_TRANSPORT_PARENT_LOAD.
  */
-//#define MY_TRANSPORT_MAX_TX_FAILURES (10u)
+#ifndef MY_TRANSPORT_PARENT_LOAD_HYSTERESIS
+#define MY_TRANSPORT_PARENT_LOAD_HYSTERESIS (25u)
+#endif
 
 /**
- * @def MY_TRANSPORT_WAIT_READY_MS
- * @brief Timeout in ms until transport is ready during startup, set to 0 for no timeout
+ * @def MY_TRANSPORT_PARENT_LOAD_INTERVAL_MS
+ * @brief Interval in ms of the parent review, see @ref MY_TRANSPORT_PARENT_LOAD.
  */
-#ifndef MY_TRANSPORT_WAIT_READY_MS
-#define MY_TRANSPORT_WAIT_READY_MS (0)
+#ifndef MY_TRANSPORT_PARENT_LOAD_INTERVAL_MS
+#define MY_TRANSPORT_PARENT_LOAD_INTERVAL_MS (60*60*1000ul)
 #endif
 
 /**
-* @def MY_SIGNAL_REPORT_ENABLED
+ * @def MY_TRANSPORT_SANITY_CHECK
+ * @brief If defined, will cause node to check transport in regular intervals to detect HW issues
+ *        and re-initialize in case of failure.
+ * @note This feature is enabled for all repeater nodes (incl. GW)
+ */
+//#define MY_TRANSPORT_SANITY_CHECK
+
+/**
+ * @def MY_TRANSPORT_SANITY_CHECK_INTERVAL_MS
+ * @brief Interval (in ms) for transport sanity checks
+ */
+#ifndef MY_TRANSPORT_SANITY_CHECK_INTERVAL_MS
+#define MY_TRANSPORT_SANITY_CHECK_INTERVAL_MS (15*60*1000ul)
+#endif
+
+/**
+ * @def MY_TRANSPORT_FAST_RECOVERY
+ * @brief Define this to recover from radio faults without the fixed dwell of the failure state.
+ *
+ * A failed sanity check re-initializes the radio in place first: the registers are written
+ * again, the transport stays ready and keeps its routing table, queues and signing state. Only if
+ * this fails, or the radio cannot be initialized, the transport enters the failure state. It
+ * re-initializes after @ref MY_TRANSPORT_RECOVERY_BACKOFF_MS, doubled per consecutive fault up to
+ * @ref MY_TRANSPORT_TIMEOUT_FAILURE_STATE_MS (@ref MY_TRANSPORT_TIMEOUT_EXT_FAILURE_STATE_MS after
+ * repeated failures). Failures of the network, e.g. no parent found, keep the fixed dwell.
+ */
+//#define MY_TRANSPORT_FAST_RECOVERY
+
+/**
+ * @def MY_TRANSPORT_RECOVERY_BACKOFF_MS
+ * @brief Dwell in the failure state after the first radio fault, see @ref MY_TRANSPORT_FAST_RECOVERY.
+ */
+#ifndef MY_TRANSPORT_RECOVERY_BACKOFF_MS
+#define MY_TRANSPORT_RECOVERY_BACKOFF_MS (10ul)
+#endif
+
+/**
+ * @def MY_TRANSPORT_SEQUENCE
+ * @brief Define this to number the frames a node sends to the gateway, all nodes of the network must have this enabled.
+ *
+ * Frames shorter than MAX_MESSAGE_LENGTH carry a one byte sequence number of their sender behind
+ * the message (and its signature), repeaters relay it unchanged. Each frame sent to the gateway,
+ * resends included, takes the next number; it wraps from 255 to 1, 0 is sent once after booting.
+ * Full length frames carry none and are not counted.
+ *
+ * With @ref MY_STATS_FEATURE the gateway tracks the received, lost, duplicated and reordered
+ * frames, restarts and the inter-arrival jitter per node, see statsLinkGet(). Linux gateways
+ * serve them with the counters. A node not heard from anymore lost its link (or its power), one
+ * sending without losses sleeps.
+ */
+//#define MY_TRANSPORT_SEQUENCE
+/**
+ * @def MY_TRANSPORT_DISCOVERY_INTERVAL_MS
+ * @brief This is a gateway-only feature: Interval (in ms) to issue network discovery checks
+ */
+#ifndef MY_TRANSPORT_DISCOVERY_INTERVAL_MS
+#define MY_TRANSPORT_DISCOVERY_INTERVAL_MS (20*60*1000ul)
+#endif
+
+/**
+ *@def MY_TRANSPORT_UPLINK_CHECK_DISABLED
+ *@brief If defined, disables uplink check to GW during transport initialisation
+ */
+//#define MY_TRANSPORT_UPLINK_CHECK_DISABLED
+
+/**
+ *@def MY_TRANSPORT_UPLINK_CHECK_PASSIVE
+ *@brief If defined, repeaters do not block in transportCheckUplink() before answering a find
+ * parent request.
+ *
+ * Any message from the GW received through the parent counts as a working uplink for
+ * MY_TRANSPORT_CHKUPL_INTERVAL_MS. After that, the GW is pinged in the background. Until its PONG
+ * arrives, find parent requests are not answered. If no PONG arrives within
+ * MY_TRANSPORT_STATE_TIMEOUT_MS, the GW is pinged again on the next check. The requesting node
+ * retries and is answered once the PONG is in.
+ */
+//#define MY_TRANSPORT_UPLINK_CHECK_PASSIVE
+
+/**
+ *@def MY_TRANSPORT_MAX_TX_FAILURES
+ *@brief Define to override max. consecutive TX failures until SNP is initiated
+ */
+//#define MY_TRANSPORT_MAX_TX_FAILURES (10u)
+
+/**
+ * @def MY_TRANSPORT_WAIT_READY_MS
+ * @brief Timeout in ms until transport is ready during startup, set to 0 for no timeout
+ */
+#ifndef MY_TRANSPORT_WAIT_READY_MS
+#define MY_TRANSPORT_WAIT_READY_MS (0)
+#endif
+
+/**
+ * @def MY_TRANSPORT_PROCESS_BUDGET_US
+ * @brief Time in us the transport may spend on received radio messages per loop iteration.
+ *
+ * Radio messages are processed as long as there are more and the budget is not used up, at
+ * least one is processed per iteration. The rest of the iteration goes to the controller and
+ * the sketch.
+ */
+#ifndef MY_TRANSPORT_PROCESS_BUDGET_US
+#define MY_TRANSPORT_PROCESS_BUDGET_US (20000ul)
+#endif
+
+/**
+ * @def MY_TRANSPORT_REPLY_JITTER_MS
+ * @brief Longest random delay in ms of replies to broadcast requests.
+ *
+ * Repeaters answer I_FIND_PARENT_REQUEST and nodes answer I_DISCOVER_REQUEST after a random
+ * delay, so the replies of all nodes in range do not collide. The replies are scheduled, the
+ * transport keeps receiving and relaying meanwhile. Must be at least 1.
+ */
+#ifndef MY_TRANSPORT_REPLY_JITTER_MS
+#define MY_TRANSPORT_REPLY_JITTER_MS (1024ul)
+#endif
+
+/**
+ * @def MY_TRANSPORT_DEFERRED_REPLIES
+ * @brief Number of scheduled replies to broadcast requests, see @ref MY_TRANSPORT_REPLY_JITTER_MS.
+ *
+ * Requests arriving while all are pending are not answered, the requesting node retries.
+ */
+#ifndef MY_TRANSPORT_DEFERRED_REPLIES
+#define MY_TRANSPORT_DEFERRED_REPLIES (4u)
+#endif
+
+/**
+ * @def MY_TRANSPORT_BROADCAST_FLOODING
+ * @brief Define this to flood broadcasts through the mesh, relayed about once per repeater.
+ *
+ * Without it, a repeater relays the broadcasts received from its parent. With it, the first
+ * copy of a broadcast is processed and its relay is scheduled after a random delay of up to
+ * @ref MY_TRANSPORT_BROADCAST_JITTER_MS, whichever neighbour it came from. Broadcasts of
+ * nodes reach the whole network this way. The copies received meanwhile are counted and
+ * dropped, the relay is suppressed once @ref MY_TRANSPORT_BROADCAST_THRESHOLD copies were
+ * heard. The header has no sequence number, a broadcast is recognized by a hash of its sender,
+ * header and payload for @ref MY_TRANSPORT_BROADCAST_WINDOW_MS, so an identical broadcast sent
+ * again within the window is dropped. Find parent and wake-on-radio broadcasts are not flooded.
+ * All nodes of the network should use it.
+ */
+//#define MY_TRANSPORT_BROADCAST_FLOODING
+
+/**
+ * @def MY_TRANSPORT_BROADCAST_JITTER_MS
+ * @brief Longest random delay in ms of a broadcast relay, see @ref MY_TRANSPORT_BROADCAST_FLOODING.
+ *
+ * Must be at least 1.
+ */
+#ifndef MY_TRANSPORT_BROADCAST_JITTER_MS
+#define MY_TRANSPORT_BROADCAST_JITTER_MS (256ul)
+#endif
+
+/**
+ * @def MY_TRANSPORT_BROADCAST_THRESHOLD
+ * @brief Copies of a broadcast heard before its relay that suppress the relay, see @ref MY_TRANSPORT_BROADCAST_FLOODING.
+ */
+#ifndef MY_TRANSPORT_BROADCAST_THRESHOLD
+#define MY_TRANSPORT_BROADCAST_THRESHOLD (3u)
+#endif
+
+/**
+ * @def MY_TRANSPORT_BROADCAST_WINDOW_MS
+ * @brief Time in ms a received broadcast is remembered, see @ref MY_TRANSPORT_BROADCAST_FLOODING.
+ */
+#ifndef MY_TRANSPORT_BROADCAST_WINDOW_MS
+#define MY_TRANSPORT_BROADCAST_WINDOW_MS (2000ul)
+#endif
+
+/**
+ * @def MY_TRANSPORT_BROADCAST_CACHE_SIZE
+ * @brief Number of received broadcasts remembered, see @ref MY_TRANSPORT_BROADCAST_FLOODING.
+ */
+#ifndef MY_TRANSPORT_BROADCAST_CACHE_SIZE
+#define MY_TRANSPORT_BROADCAST_CACHE_SIZE (4u)
+#endif
+
+/**
+ * @def MY_TRANSPORT_TX_QUEUE_FEATURE
+ * @brief Define this to queue relayed messages and messages from the controller for sending.
+ *
+ * Instead of sending a message to be relayed right away, the transport queues it and sends
+ * the queued messages one at a time, processing received messages in between. A message that
+ * fails is retried behind the others, so a repeater or gateway keeps receiving and serves other
+ * nodes while a far node does not answer. Messages sent by the sketch are not queued, send()
+ * still returns the result, unless @ref MY_TRANSPORT_PACING holds them back. See transportRegisterTxCallback() and transportTxQueuePending().
+ */
+//#define MY_TRANSPORT_TX_QUEUE_FEATURE
+
+/**
+ * @def MY_TRANSPORT_TX_QUEUE_SIZE
+ * @brief Number of messages the TX queue holds, see @ref MY_TRANSPORT_TX_QUEUE_FEATURE.
+ */
+#ifndef MY_TRANSPORT_TX_QUEUE_SIZE
+#define MY_TRANSPORT_TX_QUEUE_SIZE (4u)
+#endif
+
+/**
+ * @def MY_TRANSPORT_TX_QUEUE_RETRIES
+ * @brief Number of times a queued message is retried after it failed.
+ */
+#ifndef MY_TRANSPORT_TX_QUEUE_RETRIES
+#define MY_TRANSPORT_TX_QUEUE_RETRIES (2u)
+#endif
+
+/**
+ * @def MY_TRANSPORT_TX_QUEUE_PRIORITY
+ * @brief Define this to queue messages by priority, see @ref MY_TRANSPORT_TX_QUEUE_FEATURE.
+ *
+ * Commands from the controller (C_SET, C_REQ) go first, then sensor data and internal messages,
+ * presentations and stream messages (OTA) last. Each class has its own queue of
+ * @ref MY_TRANSPORT_TX_QUEUE_SIZE messages and keeps its order, so an actuator command does not
+ * wait behind a burst of OTA blocks.
+ */
+//#define MY_TRANSPORT_TX_QUEUE_PRIORITY
+
+/**
+ * @def MY_TRANSPORT_PACING
+ * @brief Define this on a node to pace its messages to the GW while the uplink is congested.
+ *
+ * Every failed transmission to the parent doubles the gap kept between the messages to the GW,
+ * starting at @ref MY_TRANSPORT_PACING_MIN_MS and up to @ref MY_TRANSPORT_PACING_MAX_MS, every
+ * successful one shortens it by @ref MY_TRANSPORT_PACING_STEP_MS (AIMD). While there is a gap,
+ * messages to the GW sent by the sketch, except internal ones, go to the TX queue and send()
+ * returns true once queued, a sketch repeating send() until it succeeds no longer adds to the
+ * collisions. If the queue is full, send() returns false without sending. Requires
+ * @ref MY_TRANSPORT_TX_QUEUE_FEATURE, queued messages are counted by STATS_TX_PACED.
+ */
+//#define MY_TRANSPORT_PACING
+
+/**
+ * @def MY_TRANSPORT_PACING_MIN_MS
+ * @brief Gap in ms after the first failed transmission, see @ref MY_TRANSPORT_PACING.
+ */
+#ifndef MY_TRANSPORT_PACING_MIN_MS
+#define MY_TRANSPORT_PACING_MIN_MS (100ul)
+#endif
+
+/**
+ * @def MY_TRANSPORT_PACING_MAX_MS
+ * @brief Longest gap in ms, see @ref MY_TRANSPORT_PACING.
+ */
+#ifndef MY_TRANSPORT_PACING_MAX_MS
+#define MY_TRANSPORT_PACING_MAX_MS (10*1000ul)
+#endif
+
+/**
+ * @def MY_TRANSPORT_PACING_STEP_MS
+ * @brief Gap in ms removed by each successful transmission, see @ref MY_TRANSPORT_PACING.
+ */
+#ifndef MY_TRANSPORT_PACING_STEP_MS
+#define MY_TRANSPORT_PACING_STEP_MS (50ul)
+#endif
+
+/**
+ * @def MY_TRANSPORT_AGGREGATION
+ * @brief Define this on a repeater to relay C_SET messages to the GW in one I_AGGREGATE message.
+ *
+ * Readings of several nodes that arrive within @ref MY_TRANSPORT_AGGREGATION_MS share one frame
+ * on the way to the GW, each one costs the 5 bytes of its header instead of a frame of its own.
+ * Signed messages and echo requests are relayed as received. The GW unpacks the frames, verifies
+ * them one by one and updates its routes, so it must run a library that knows I_AGGREGATE.
+ */
+//#define MY_TRANSPORT_AGGREGATION
+
+/**
+ * @def MY_TRANSPORT_AGGREGATION_MS
+ * @brief Longest time a relayed message waits for others, see @ref MY_TRANSPORT_AGGREGATION.
+ */
+#ifndef MY_TRANSPORT_AGGREGATION_MS
+#define MY_TRANSPORT_AGGREGATION_MS (20ul)
+#endif
+
+/**
+ * @def MY_TRANSPORT_CUT_THROUGH
+ * @brief Define this on a repeater or GW to relay messages for other nodes right after reception.
+ *
+ * The header of a received frame decides: a message that is neither addressed to this node nor
+ * a broadcast, and not internal, only updates the routing table and goes to the TX queue, ahead
+ * of the messages of the sketch. It is not formatted for the debug log and skips the signing
+ * checks, which only concern messages addressed to this node. Internal messages take the full
+ * path, the hop count of I_PING/I_PONG is updated there.
+ */
+//#define MY_TRANSPORT_CUT_THROUGH
+
+/**
+ * @def MY_TRANSPORT_FRAGMENTATION
+ * @brief Define this to send and receive data blocks larger than MAX_PAYLOAD, see sendFragmented().
+ *
+ * A block is split into I_FRAGMENT messages of FRAGMENT_DATA_SIZE bytes that are routed like any
+ * other message. The receiver collects them in a pool of @ref MY_TRANSPORT_FRAGMENT_SLOTS blocks
+ * and calls receiveFragmented() once a block is complete. Lost fragments are not requested again,
+ * the block is dropped after @ref MY_TRANSPORT_FRAGMENT_TIMEOUT_MS.
+ */
+//#define MY_TRANSPORT_FRAGMENTATION
+
+/**
+ * @def MY_TRANSPORT_FRAGMENT_MAX_LENGTH
+ * @brief Largest block sent or reassembled, see @ref MY_TRANSPORT_FRAGMENTATION.
+ *
+ * Each slot of the reassembly pool takes this many bytes of RAM.
+ */
+#ifndef MY_TRANSPORT_FRAGMENT_MAX_LENGTH
+#define MY_TRANSPORT_FRAGMENT_MAX_LENGTH (128u)
+#endif
+
+/**
+ * @def MY_TRANSPORT_FRAGMENT_SLOTS
+ * @brief Number of blocks reassembled at the same time, see @ref MY_TRANSPORT_FRAGMENTATION.
+ */
+#ifndef MY_TRANSPORT_FRAGMENT_SLOTS
+#define MY_TRANSPORT_FRAGMENT_SLOTS (2u)
+#endif
+
+/**
+ * @def MY_TRANSPORT_FRAGMENT_TIMEOUT_MS
+ * @brief Time to receive all fragments of a block, see @ref MY_TRANSPORT_FRAGMENTATION.
+ */
+#ifndef MY_TRANSPORT_FRAGMENT_TIMEOUT_MS
+#define MY_TRANSPORT_FRAGMENT_TIMEOUT_MS (1000ul)
+#endif
+
+/**
+ * @def MY_REPEATER_WAKE_ON_RADIO
+ * @brief Define this to let a battery powered repeater sleep with a duty-cycled receiver.
+ *
+ * Instead of refusing, sleep() powers the radio down for @ref MY_WAKE_ON_RADIO_PERIOD_MS and
+ * listens for @ref MY_WAKE_ON_RADIO_LISTEN_MS, the window is extended as long as frames arrive.
+ * On entering sleep() the repeater broadcasts an I_WAKE_ON_RADIO with the length of its cycle.
+ * Neighbours with @ref MY_TRANSPORT_WAKE_ON_RADIO then repeat an unacknowledged frame to it for
+ * one cycle, a message reaches the repeater within one period. Interrupts end the sleep as usual,
+ * smartSleep() is not supported. The repeater does not answer find parent requests while the
+ * radio is off, nodes find it once it is awake. Not possible on a GW.
+ */
+//#define MY_REPEATER_WAKE_ON_RADIO
+
+/**
+ * @def MY_TRANSPORT_WAKE_ON_RADIO
+ * @brief Define this on nodes sending to a @ref MY_REPEATER_WAKE_ON_RADIO repeater or a
+ * @ref MY_RFM69_ENABLE_LISTENMODE node.
+ *
+ * Unicasts to a neighbour that announced a listen cycle are repeated until they are acknowledged
+ * or the longest announced cycle has passed. Set automatically with @ref MY_REPEATER_WAKE_ON_RADIO.
+ */
+//#define MY_TRANSPORT_WAKE_ON_RADIO
+
+/**
+ * @def MY_WAKE_ON_RADIO_PERIOD_MS
+ * @brief Time in ms the radio sleeps per cycle, see @ref MY_REPEATER_WAKE_ON_RADIO.
+ */
+#ifndef MY_WAKE_ON_RADIO_PERIOD_MS
+#define MY_WAKE_ON_RADIO_PERIOD_MS (1000ul)
+#endif
+
+/**
+ * @def MY_WAKE_ON_RADIO_LISTEN_MS
+ * @brief Time in ms the radio listens per cycle, see @ref MY_REPEATER_WAKE_ON_RADIO.
+ *
+ * Must be longer than one transmission attempt of the sender including its retries.
+ */
+#ifndef MY_WAKE_ON_RADIO_LISTEN_MS
+#define MY_WAKE_ON_RADIO_LISTEN_MS (20ul)
+#endif
+
+/**
+ * @def MY_TRANSPORT_DIRECT_CACHE
+ * @brief Define this on a node without repeater feature to remember which peers it reaches directly.
+ *
+ * Node-to-node messages are sent to the destination directly and, if that fails after all radio
+ * retries, to the parent. With this, the outcome is kept for @ref MY_TRANSPORT_DIRECT_CACHE_MS
+ * for the last @ref MY_TRANSPORT_DIRECT_CACHE_SIZE destinations, messages to a peer out of range
+ * go to the parent right away. The direct way is tried again once the entry has aged.
+ */
+//#define MY_TRANSPORT_DIRECT_CACHE
+
+/**
+ * @def MY_TRANSPORT_DIRECT_CACHE_SIZE
+ * @brief Number of destinations remembered, see @ref MY_TRANSPORT_DIRECT_CACHE.
+ */
+#ifndef MY_TRANSPORT_DIRECT_CACHE_SIZE
+#define MY_TRANSPORT_DIRECT_CACHE_SIZE (4u)
+#endif
+
+/**
+ * @def MY_TRANSPORT_DIRECT_CACHE_MS
+ * @brief Time in ms the way to a destination is remembered, see @ref MY_TRANSPORT_DIRECT_CACHE.
+ */
+#ifndef MY_TRANSPORT_DIRECT_CACHE_MS
+#define MY_TRANSPORT_DIRECT_CACHE_MS (10*60*1000ul)
+#endif
+
+/**
+ * @def MY_TRANSPORT_DUPLICATE_FILTER
+ * @brief Define this to drop messages received twice within @ref MY_TRANSPORT_DUPLICATE_WINDOW_MS.
+ *
+ * If the radio ACK of a message gets lost, the sender sends it again and it is received twice,
+ * repeaters would relay it and gateways hand it to the controller twice. With this, a hash of
+ * the received messages (without the last hop) is kept by sender in a cache of
+ * @ref MY_TRANSPORT_DUPLICATE_CACHE_SIZE entries, a message matching an entry of the window is
+ * dropped before verification and routing. See transportGetDuplicateCount(). The internal
+ * handshakes (ID, find parent, nonce, ping, registration, discovery and receipts) are never
+ * dropped, so back to back signed messages get their nonces.
+ *
+ * With @ref MY_TRANSPORT_SEQUENCE, frames sent to the GW are compared by their sequence number
+ * instead: a resend of the radio is dropped, the same message sent again is not. Signed messages
+ * differ by their signature. Otherwise, identical messages deliberately sent within the window
+ * (e.g. the same command twice) are dropped as well.
+ */
+//#define MY_TRANSPORT_DUPLICATE_FILTER
+
+/**
+ * @def MY_TRANSPORT_DUPLICATE_WINDOW_MS
+ * @brief Time in ms a received message is remembered, see @ref MY_TRANSPORT_DUPLICATE_FILTER.
+ */
+#ifndef MY_TRANSPORT_DUPLICATE_WINDOW_MS
+#define MY_TRANSPORT_DUPLICATE_WINDOW_MS (500u)
+#endif
+
+/**
+ * @def MY_TRANSPORT_DUPLICATE_CACHE_SIZE
+ * @brief Number of received messages remembered, see @ref MY_TRANSPORT_DUPLICATE_FILTER.
+ */
+#ifndef MY_TRANSPORT_DUPLICATE_CACHE_SIZE
+#define MY_TRANSPORT_DUPLICATE_CACHE_SIZE (8u)
+#endif
+
+/**
+ * @def MY_TRANSPORT_RECEIPTS
+ * @brief Define this to confirm echo requests with a short receipt instead of the whole message.
+ *
+ * The destination of a message sent with echo (see send()) answers with an I_RECEIPT carrying the
+ * command, the type and a hash of the payload, 4 bytes instead of the message. The sender keeps
+ * its last @ref MY_TRANSPORT_RECEIPT_SLOTS messages requesting an echo and turns the matching
+ * receipt back into the echo, so receive() and the controller get the echo as before. All nodes
+ * sending or receiving echo requests and the GW have to be built with it.
+ */
+//#define MY_TRANSPORT_RECEIPTS
+
+/**
+ * @def MY_TRANSPORT_RECEIPT_SLOTS
+ * @brief Number of sent messages waiting for a receipt, see @ref MY_TRANSPORT_RECEIPTS.
+ */
+#ifndef MY_TRANSPORT_RECEIPT_SLOTS
+#define MY_TRANSPORT_RECEIPT_SLOTS (4u)
+#endif
+
+/**
+ * @def MY_TRANSPORT_DUTY_CYCLE_FEATURE
+ * @brief Define this to limit the time on air of the radio to a duty cycle, e.g. for EU868.
+ *
+ * The radio driver computes the time on air of every frame it sends from the length and the
+ * modem settings (see transportHALGetAirtime()). The transport sums it up over the last
+ * @ref MY_TRANSPORT_DUTY_CYCLE_WINDOW_MS in 12 slots, i.e. a frame counts until at most 1/12 of
+ * the window after it expired. Once @ref MY_TRANSPORT_DUTY_CYCLE_THROTTLE percent of the budget
+ * are used, presentations and stream (OTA) messages are deferred, once the budget is used up
+ * no message is sent until the oldest slot expires. send() returns false, queued messages (see
+ * @ref MY_TRANSPORT_TX_QUEUE_FEATURE) stay queued. See transportGetDutyCycle().
+ *
+ * The accounting uses hwMillis(), which does not advance during sleep on some architectures,
+ * sleeping nodes are accounted conservatively.
+ */
+//#define MY_TRANSPORT_DUTY_CYCLE_FEATURE
+
+/**
+ * @def MY_TRANSPORT_DUTY_CYCLE_LIMIT
+ * @brief Share of the window the radio may be on air in per mille, see @ref MY_TRANSPORT_DUTY_CYCLE_FEATURE.
+ *
+ * Use 10 for 1% (EU868 g/g1 sub-bands), 1 for 0.1% or 100 for 10% (g3).
+ */
+#ifndef MY_TRANSPORT_DUTY_CYCLE_LIMIT
+#define MY_TRANSPORT_DUTY_CYCLE_LIMIT (10u)
+#endif
+
+/**
+ * @def MY_TRANSPORT_DUTY_CYCLE_WINDOW_MS
+ * @brief Window of the duty cycle in ms, see @ref MY_TRANSPORT_DUTY_CYCLE_FEATURE.
+ */
+#ifndef MY_TRANSPORT_DUTY_CYCLE_WINDOW_MS
+#define MY_TRANSPORT_DUTY_CYCLE_WINDOW_MS (3600000ul)
+#endif
+
+/**
+ * @def MY_TRANSPORT_DUTY_CYCLE_THROTTLE
+ * @brief Percent of the duty cycle budget from which low priority messages are deferred, see
+ * @ref MY_TRANSPORT_DUTY_CYCLE_FEATURE.
+ */
+#ifndef MY_TRANSPORT_DUTY_CYCLE_THROTTLE
+#define MY_TRANSPORT_DUTY_CYCLE_THROTTLE (80u)
+#endif
+
+/**
+* @def MY_SIGNAL_REPORT_ENABLED
 * @brief Enables signal report functionality.
 * @note This feature adds ~1kB code to the sketch.
 */
 //#define MY_SIGNAL_REPORT_ENABLED
 
-/** @}*/ // End of RoutingNodeSettingGrpPub group
+/** @}*/ // End of RoutingNodeSettingGrpPub group
+
+/**
+ * @defgroup RegistrationSettingGrpPub Node registration
+ * @ingroup MyConfigGrp
+ * @brief These options control node registration configurations.
+ * @{
+ */
+/**
+ * @def MY_REGISTRATION_FEATURE
+ * @brief If enabled, node has to register to GW/controller before being allowed to send sensor
+ *        data.
+ * @note Enabled by default.
+ */
+#define MY_REGISTRATION_FEATURE
+
+/**
+ * @def MY_REGISTRATION_RETRIES
+ * @brief Number of registration retries if no reply received from GW/controller.
+ */
+
+#ifndef MY_REGISTRATION_RETRIES
+#define MY_REGISTRATION_RETRIES (3u)
+#endif
+
+/**
+* @def MY_REGISTRATION_DEFAULT
+* @brief Node registration default - this applies if no registration response is received from
+ *       controller.
+*/
+#define MY_REGISTRATION_DEFAULT (true)
+
+/**
+ * @def MY_REGISTRATION_CONTROLLER
+ * @brief If defined, node registration request has to be handled by controller
+ */
+//#define MY_REGISTRATION_CONTROLLER
+
+/**
+ * @def MY_REGISTRATION_CACHE
+ * @brief Skip the blocking boot handshake when its result is stored in EEPROM.
+ *
+ * A node waits up to 2s for the I_CONFIG reply on every boot and up to
+ * (@ref MY_REGISTRATION_RETRIES + 1) * 2s for the registration response. With this the
+ * registration result is stored together with @ref MY_REGISTRATION_CACHE_EPOCH. Once stored the
+ * node sends both requests without waiting and takes the stored result, the replies update it
+ * whenever they arrive. A full handshake is done again after an EEPROM clear or when the epoch
+ * is changed, e.g. after the controller config was changed.
+ */
+//#define MY_REGISTRATION_CACHE
+
+/**
+ * @def MY_REGISTRATION_CACHE_EPOCH
+ * @brief Version of the stored handshake result, 0..254. Another value invalidates it.
+ */
+#ifndef MY_REGISTRATION_CACHE_EPOCH
+#define MY_REGISTRATION_CACHE_EPOCH (1u)
+#endif
+/** @}*/ // End of RegistrationSettingGrpPub group
+
+/**
+ * @defgroup CoreSettingGrpPub Core
+ * @ingroup MyConfigGrp
+ * @brief These options control the library core configurations.
+ * @{
+ */
+/**
+ * @def MY_CORE_ONLY
+ * @brief Define this if you want to use core functions without loading the framework.
+ */
+//#define MY_CORE_ONLY
+
+/**
+ * @def MY_CORE_COMPATIBILITY_CHECK
+ * @brief If defined, library compatibility is checked during node registration.
+ *        Incompatible libraries are unable to send sensor data.
+ */
+#define MY_CORE_COMPATIBILITY_CHECK
+
+/**
+ * @def MY_CORE_PROCESS_STATS
+ * @brief Define this to account the time spent on radio and controller messages.
+ *
+ * See coreGetProcessStats().
+ */
+//#define MY_CORE_PROCESS_STATS
+
+/**
+ * @def MY_STATS_FEATURE
+ * @brief Define this to count transport, signing and gateway events.
+ *
+ * Counts frames sent/received, NACKs, TX queue retries and drops, uplink failures, duplicates,
+ * RX buffer overflows, signing and verification failures, messages from/to the controller,
+ * controller parse errors and the bytes of each Ethernet controller connection.
+ *
+ * The controller reads a counter with an I_STATS request to the counter index as sensor id,
+ * 255 requests all counters. Each counter is answered by an I_STATS message with the counter
+ * index as sensor id, the counter value is the payload. A payload of "R" resets the counters
+ * after they have been reported. See statsCounter_t for the indices.
+ *
+ * Linux gateways also serve the counters in Prometheus text format over HTTP if stats_port is
+ * set in the configuration file. Enable it with the --my-stats option of configure.
+ */
+//#define MY_STATS_FEATURE
+
+/**
+ * @def MY_STATS_LATENCY
+ * @brief Define this to record latency histograms of the gateway paths, requires @ref MY_STATS_FEATURE.
+ *
+ * Timestamps are taken at each stage of a message through the gateway: radio IRQ (with the RX
+ * message buffer), transport dequeue, signature verification, protocol formatting and write to
+ * the controller for the uplink, read from the controller, core dequeue and radio send for the
+ * downlink. The time since the start of the path is recorded per stage in histograms with log2
+ * buckets from 16us to 256ms, see statsLatency_t.
+ *
+ * Linux gateways serve the histograms with the counters, including p50, p99 and max estimates.
+ * Enable it with the --my-stats-latency option of configure. Each message costs a few hwMicros()
+ * calls, the histograms take about 0.5kB of RAM.
+ */
+//#define MY_STATS_LATENCY
+
+/**
+ * @def MY_STATS_LINK_SLOTS
+ * @brief Nodes whose links are tracked by the gateway, see @ref MY_TRANSPORT_SEQUENCE.
+ *
+ * The node heard least recently makes room for a new one. Each slot takes about 36 bytes of RAM.
+ */
+#ifndef MY_STATS_LINK_SLOTS
+#define MY_STATS_LINK_SLOTS (32u)
+#endif
+
+/**
+ * @def MY_PROFILING
+ * @brief Define this to profile the hot functions of the library, see MyProfiling.h.
+ *
+ * Calls, total and longest run time are accumulated for transportProcessFIFO(),
+ * transportSendWrite(), signerSignMsg(), signerVerifyMsg(), the radio send and receive,
+ * ledsProcess() and MyMessage::getString(). Times are in CPU cycles where the architecture has a
+ * cycle counter (DWT CYCCNT on Cortex-M3/M4, the cycle count register on ESP8266/ESP32, Timer1
+ * on AVR), in microseconds otherwise.
+ *
+ * The controller reads the probes with an I_PROFILING request, profilingDump() prints them to
+ * the debug output. On AVR, Timer1 is used by the profiler and not available to the sketch.
+ */
+//#define MY_PROFILING
+
+/**
+ * @def MY_ENERGY_ACCOUNTING
+ * @brief Define this on battery nodes to account the time awake per sleep cycle, see MyEnergy.h.
+ *
+ * The time between waking up and going back to sleep is split up into the radio sending,
+ * wait() listening, the smartSleep() window and nonce waits, the remainder is the sketch working.
+ * Frames not acknowledged are counted, each costs the full retry sequence of the radio. The
+ * charge drawn is estimated from @ref MY_ENERGY_CURRENT_AWAKE_UA, @ref MY_ENERGY_CURRENT_TX_UA
+ * and @ref MY_ENERGY_CURRENT_RX_UA.
+ *
+ * Every @ref MY_ENERGY_REPORT_CYCLES cycles the node reports to the controller in one I_ENERGY
+ * message, the controller can also request it. energyDump() prints it to the debug output.
+ */
+//#define MY_ENERGY_ACCOUNTING
+
+/**
+ * @def MY_ENERGY_REPORT_CYCLES
+ * @brief Sleep cycles accounted per I_ENERGY report, see @ref MY_ENERGY_ACCOUNTING.
+ */
+#ifndef MY_ENERGY_REPORT_CYCLES
+#define MY_ENERGY_REPORT_CYCLES (24u)
+#endif
+
+/**
+ * @def MY_ENERGY_CURRENT_AWAKE_UA
+ * @brief Current of the awake node without the radio in uA, default ATmega328P at 8MHz and 3.3V.
+ */
+#ifndef MY_ENERGY_CURRENT_AWAKE_UA
+#define MY_ENERGY_CURRENT_AWAKE_UA (4000ul)
+#endif
+
+/**
+ * @def MY_ENERGY_CURRENT_TX_UA
+ * @brief Current of the radio sending in uA, default nRF24L01+ at 0dBm.
+ */
+#ifndef MY_ENERGY_CURRENT_TX_UA
+#define MY_ENERGY_CURRENT_TX_UA (11300ul)
+#endif
+
+/**
+ * @def MY_ENERGY_CURRENT_RX_UA
+ * @brief Current of the radio receiving in uA, default nRF24L01+ at 2Mbps.
+ */
+#ifndef MY_ENERGY_CURRENT_RX_UA
+#define MY_ENERGY_CURRENT_RX_UA (13500ul)
+#endif
+
+/**
+ * @def MY_SHARED_BUFFERS
+ * @brief Define this to overlay the scratch buffers of the core in one arena, see
+ * MySharedBuffers.h.
+ *
+ * The transport debug string, the debug hex dump, the SHA256 input of the software signing and
+ * the gateway's protocol buffers are never used at the same time. Overlaid they take the RAM of
+ * the largest one instead of the sum, e.g. 96 instead of 212 bytes on a debug node with
+ * MY_SIGNING_SOFT. Outside AVR the soft signing buffer moves from the stack into the arena. The sizes are printed at boot (MCO:BGN:SHB). Meant for AVR, cannot be combined with a
+ * gateway controller thread (MY_LINUX_THREADED_GATEWAY, MY_ESP32_DUAL_CORE_GATEWAY).
+ */
+//#define MY_SHARED_BUFFERS
+
+/**
+ * @def MY_SEND_DEADBAND
+ * @brief Define this to enable sendOnChange(), reporting a reading only when it changed.
+ *
+ * The last value sent is kept per child sensor and type. A reading within the deadband of it is
+ * not sent, unless @ref MY_SEND_DEADBAND_MAX_SILENCE_MS passed since the last report. Slowly
+ * changing sensors then report a fraction of their readings, each saved report saves a frame,
+ * its ACK and with signing a nonce exchange. Time spent in sleep() counts towards the silence.
+ */
+//#define MY_SEND_DEADBAND
+
+/**
+ * @def MY_SEND_DEADBAND_SLOTS
+ * @brief Number of child sensor and type pairs sendOnChange() keeps the last value of.
+ *
+ * Each slot takes 10 bytes of RAM on AVR. Readings of further pairs are always sent.
+ */
+#ifndef MY_SEND_DEADBAND_SLOTS
+#define MY_SEND_DEADBAND_SLOTS (4u)
+#endif
+
+/**
+ * @def MY_SEND_DEADBAND_MAX_SILENCE_MS
+ * @brief Longest time sendOnChange() suppresses the readings of a child sensor.
+ *
+ * The next reading after it is sent even if unchanged, the controller sees the sensor is alive.
+ */
+#ifndef MY_SEND_DEADBAND_MAX_SILENCE_MS
+#define MY_SEND_DEADBAND_MAX_SILENCE_MS (60*60*1000ul)
+#endif
+
+/**
+ * @def MY_PRESENTATION_DIGEST
+ * @brief Define this on nodes to skip the presentation at boot if the GW already has it.
+ *
+ * The node runs presentation() without sending anything and sends a digest of the presentations
+ * and sketch info instead. A GW with @ref MY_GATEWAY_PRESENTATION_CACHE compares it with the cached
+ * ones of the node and answers, only if they differ the node presents itself in full. The signing
+ * requirements of both sides, as stored in their requirement tables, are part of the digest: the
+ * signing presentation and its EEPROM updates are skipped as well while they match. Without an
+ * answer within @ref MY_PRESENTATION_DIGEST_TIMEOUT_MS, e.g. from an older GW, it presents itself
+ * as well. A presentation requested by the controller is always sent in full. Values sent from
+ * presentation() are not sent on a skipped presentation.
+ */
+//#define MY_PRESENTATION_DIGEST
+
+/**
+ * @def MY_PRESENTATION_DIGEST_TIMEOUT_MS
+ * @brief Time in ms a node waits for the answer to its presentation digest.
+ */
+#ifndef MY_PRESENTATION_DIGEST_TIMEOUT_MS
+#define MY_PRESENTATION_DIGEST_TIMEOUT_MS (2000ul)
+#endif
+/** @}*/ // End of CoreSettingGrpPub group
+
+/**
+ * @defgroup SleepSettingGrpPub Sleep
+ * @ingroup MyConfigGrp
+ * @brief These options control sleep configurations.
+ * @{
+ */
+/**
+ * @def MY_SLEEP_TRANSPORT_RECONNECT_TIMEOUT_MS
+ * @brief Timeout (in ms) to re-establish link if node is send to sleep and transport is not ready.
+ */
+#ifndef MY_SLEEP_TRANSPORT_RECONNECT_TIMEOUT_MS
+#define MY_SLEEP_TRANSPORT_RECONNECT_TIMEOUT_MS (10*1000ul)
+#endif
+
+/**
+ * @def MY_SMART_SLEEP_WAIT_DURATION_MS
+ * @brief The wait period (in ms) before going to sleep when using smartSleep-functions.
+ *
+ * This period has to be long enough for controller to be able to send out
+ * potential buffered messages.
+ */
+#ifndef MY_SMART_SLEEP_WAIT_DURATION_MS
+#define MY_SMART_SLEEP_WAIT_DURATION_MS (500ul)
+#endif
+
+/**
+ * @def MY_WAIT_IDLE
+ * @brief Define this to idle the CPU in wait() and while waiting for replies.
+ *
+ * Between two passes of the message processing the CPU sleeps until the next interrupt, in the
+ * lightest sleep mode that keeps timers, the radio IRQ and the serial port running (AVR idle,
+ * WFI on ARM). This covers the smartSleep() listen window, nonce and ping waits. A frame is
+ * processed at the latest one timer tick after it arrived, 1 ms on most architectures. No effect
+ * on ESP8266, ESP32 and Linux.
+ */
+//#define MY_WAIT_IDLE
+
+/**
+ * @def MY_SMART_SLEEP_GATEWAY_RELEASE
+ * @brief Define this on the GW if the controller does not buffer messages for sleeping nodes.
+ *
+ * A smartSleep() node listens for up to @ref MY_SMART_SLEEP_WAIT_DURATION_MS after its
+ * I_PRE_SLEEP_NOTIFICATION, or until it receives an I_PRE_SLEEP_NOTIFICATION back. Controllers
+ * send that reply after the buffered messages, with this option the GW sends it right away
+ * and the node goes back to sleep after one round trip instead of the full listen window.
+ * The controller still receives the notification. With @ref MY_GATEWAY_MAILBOX the release
+ * follows the messages buffered on the GW instead.
+ */
+//#define MY_SMART_SLEEP_GATEWAY_RELEASE
+/** @}*/ // End of SleepSettingGrpPub group
+
+/**
+ * @defgroup OTASettingGrpPub Over The Air firmware
+ * @ingroup MyConfigGrp
+ * @brief These options control OTA firmware configurations.
+ * @{
+ */
+
+/**
+ * @def MY_OTA_FIRMWARE_FEATURE
+ * @brief Define this in sketch to allow safe over-the-air firmware updates.
+ *
+ * This feature requires external flash and the DualOptiBoot boot-loader.
+ * @note You can still have OTA FW updates without external flash but it
+ *       requires the MYSBootloader and you must not define this flag.
+ */
+//#define MY_OTA_FIRMWARE_FEATURE
+
+/**
+ * @def MY_OTA_FLASH_SS
+ * @brief Slave select pin for external flash used for OTA.
+ */
+#ifndef MY_OTA_FLASH_SS
+#define MY_OTA_FLASH_SS (8)
+#endif
+
+/**
+ * @def MY_OTA_FLASH_JDECID
+ * @brief Flash JDECID used for OTA. Use (0x00) if unknown.
+ */
+#ifndef MY_OTA_FLASH_JDECID
+#define MY_OTA_FLASH_JDECID (0x1F65)
+#endif
+
+/**
+ * @def MY_OTA_WINDOW_SIZE
+ * @brief Define this (2-32) to request that many FW blocks at once (ST_FIRMWARE_REQUEST_WINDOW).
+ *
+ * Blocks of the window are accepted in any order, only missing blocks are requested again. The
+ * controller answers with one ST_FIRMWARE_RESPONSE per block. If it does not answer the first
+ * window request, the node falls back to requesting one block at a time.
+ */
+//#define MY_OTA_WINDOW_SIZE (8u)
+
+/**
+ * @def MY_OTA_LZ_BLOCKS
+ * @brief Define this (1-8) to accept LZ compressed FW blocks (ST_FIRMWARE_RESPONSE_LZ).
+ *
+ * The value is the max number of blocks decoded from one response and is announced in the
+ * window request, so it requires @ref MY_OTA_WINDOW_SIZE. Costs FIRMWARE_BLOCK_SIZE bytes of
+ * stack per block while a response is decoded. Controllers without support keep sending
+ * uncompressed blocks.
+ */
+//#define MY_OTA_LZ_BLOCKS (4u)
+
+/**
+ * @def MY_OTA_DELTA
+ * @brief Define this to let ST_FIRMWARE_RESPONSE_LZ copy from the current FW, i.e. delta updates.
+ *
+ * When an update starts, the current FW is checked against the CRC stored in EEPROM and, if it
+ * matches, announced as delta base in the window request. Small changes then transfer only the
+ * changed bytes. Requires @ref MY_OTA_LZ_BLOCKS, supported on AVR and with mcuboot.
+ */
+//#define MY_OTA_DELTA
+
+/**
+ * @def MY_OTA_MULTICAST
+ * @brief Define this to store FW blocks broadcast by the controller for this node's FW type.
+ *
+ * A broadcast ST_FIRMWARE_CONFIG_RESPONSE starts the update on all nodes of its type that run
+ * another FW. Broadcast blocks are stored in any order, while they arrive no blocks are
+ * requested. Afterwards each node requests its missing blocks with window requests, so this
+ * requires @ref MY_OTA_WINDOW_SIZE. Blocks ahead of the window are tracked in a bitmap of
+ * MY_OTA_MULTICAST_BLOCKS bits (default 2048, i.e. 256 bytes of RAM for 32 KB images).
+ */
+//#define MY_OTA_MULTICAST
+
+/**
+ * @def MY_OTA_VERIFY_FLASH
+ * @brief Define this to verify the CRC of the received FW by reading it back from flash.
+ *
+ * The CRC is always calculated from the blocks as they are received. Reading back the whole
+ * image additionally detects flash write errors, but blocks the node for a while on SPI flash.
+ */
+//#define MY_OTA_VERIFY_FLASH
+
+/**
+ * @def MY_OTA_RESUME
+ * @brief Define this to resume an interrupted FW update after a reset or power loss.
+ *
+ * The progress is saved in EEPROM every @ref MY_OTA_RESUME_INTERVAL blocks. If the controller
+ * offers the same FW again after a reset, the flash is not erased and only the blocks below the
+ * saved one are requested. Uses 8 bytes of the unused controller config area in EEPROM.
+ */
+//#define MY_OTA_RESUME
+
+/**
+ * @def MY_OTA_RESUME_INTERVAL
+ * @brief FW blocks between saving the progress, see @ref MY_OTA_RESUME.
+ *
+ * Each save writes 8 bytes of EEPROM and waits for the flash to finish the pending blocks.
+ */
+#ifndef MY_OTA_RESUME_INTERVAL
+#define MY_OTA_RESUME_INTERVAL (64u)
+#endif
+
+/**
+ * @def MY_DISABLE_REMOTE_RESET
+ * @brief Disables over-the-air reset of node
+ */
+//#define MY_DISABLE_REMOTE_RESET
+/** @}*/ // End of OTASettingGrpPub group
+
+/**
+ * @defgroup GatewaySettingGrpPub Gateway
+ * @ingroup MyConfigGrp
+ * @brief These options control gateway specific configurations.
+ * @{
+ */
+/**
+ * @def MY_GATEWAY_MAX_RECEIVE_LENGTH
+ * @brief Max buffersize needed for messages coming from controller.
+ */
+#ifndef MY_GATEWAY_MAX_RECEIVE_LENGTH
+#define MY_GATEWAY_MAX_RECEIVE_LENGTH (100u)
+#endif
+
+/**
+ * @def MY_GATEWAY_MAX_SEND_LENGTH
+ * @brief Max buffer size when sending messages.
+ */
+#ifndef MY_GATEWAY_MAX_SEND_LENGTH
+#define MY_GATEWAY_MAX_SEND_LENGTH (120u)
+#endif
+
+/**
+ * @def MY_GATEWAY_BINARY_FRAMING
+ * @brief Accept binary frames from the controller next to the ASCII protocol.
+ *
+ * A binary frame is a sync byte (0xA5), the length of the raw message, the raw message header
+ * and payload and a CRC-16, see protocolParse(). Stream payloads such as OTA firmware blocks
+ * are sent as they are instead of hex encoded.
+ *
+ * Links start in ASCII framing. A serial or Ethernet controller that sends a valid binary frame
+ * gets its replies in binary framing until it sends an ASCII line again, or reconnects. For
+ * MQTT gateways an incoming payload that holds a binary frame carries the whole message,
+ * publishes stay ASCII as there may be any number of subscribers.
+ */
+//#define MY_GATEWAY_BINARY_FRAMING
+
+/**
+ * @def MY_GATEWAY_SERIAL_BUFFERED
+ * @brief Collect the output of the serial GW per loop and read the input in blocks.
+ *
+ * On MCUs with native USB (SAMD21, nRF52840, STM32) every write to the CDC serial device can
+ * become a USB packet of its own, and reading a byte at a time costs a call into the USB stack
+ * per byte. With this option the messages to the controller are collected and written once per
+ * pass of the core loop, or when @ref MY_GATEWAY_SERIAL_BUFFER_SIZE is full, so the USB stack
+ * sends full packets. The input is read in blocks of up to the same size. Debug prints are still
+ * written right away, they may overtake the messages of the same pass.
+ */
+//#define MY_GATEWAY_SERIAL_BUFFERED
+
+/**
+ * @def MY_GATEWAY_SERIAL_BUFFER_SIZE
+ * @brief Size of each of the output and input buffers of @ref MY_GATEWAY_SERIAL_BUFFERED.
+ *
+ * A multiple of the 64 byte USB full speed packet.
+ */
+#ifndef MY_GATEWAY_SERIAL_BUFFER_SIZE
+#define MY_GATEWAY_SERIAL_BUFFER_SIZE (256u)
+#endif
+
+/**
+ * @def MY_GATEWAY_MAX_CLIENTS
+ * @brief Max number of parallel clients (sever mode).
+ *
+ * On Linux the connections are served by epoll events, idle clients cost nothing per loop
+ * iteration and hundreds of them, e.g. read-only monitors, are fine.
+ */
+#ifndef MY_GATEWAY_MAX_CLIENTS
+#define MY_GATEWAY_MAX_CLIENTS (1u)
+#endif
+
+/**
+ * @def MY_GATEWAY_CLIENT_FILTER
+ * @brief Let each client of a multi-client Ethernet gateway (ESP8266, ESP32, Linux in server
+ * mode) choose the messages it is sent.
+ *
+ * A client registers its filter with an I_GATEWAY_FILTER message to the GW, which is consumed
+ * and not passed on, e.g. @code 0;255;3;0;38;1,20,3,255 @endcode
+ * The payload is the first and last sender node id, a bit mask of the commands (bit n for
+ * command n, e.g. 3 for C_PRESENTATION and C_SET) and a type (255 for all types). An empty
+ * payload forwards everything again, as does a reconnect. Messages of the GW itself are sent to
+ * every client.
+ *
+ * Clients are written one by one instead of by a single write to all.
+ */
+//#define MY_GATEWAY_CLIENT_FILTER
+
+/**
+ * @def MY_GATEWAY_SECONDARY_TCP_PORT
+ * @brief Define this to a TCP port to serve a second controller link next to the MQTT or serial
+ * gateway (Linux).
+ *
+ * Controllers connecting to the port speak the serial protocol, like with the Ethernet gateway.
+ * Every message for the controller is sent on both links, messages from both links are merged,
+ * the first link is read first. The serial gateway formats each message once for both links.
+ * Example: @code #define MY_GATEWAY_SECONDARY_TCP_PORT 5003 @endcode
+ */
+//#define MY_GATEWAY_SECONDARY_TCP_PORT 5003
 
 /**
- * @defgroup RegistrationSettingGrpPub Node registration
- * @ingroup MyConfigGrp
- * @brief These options control node registration configurations.
- * @{
+ * @def MY_GATEWAY_SECONDARY_MAX_CLIENTS
+ * @brief Max number of parallel clients of the second controller link.
  */
+#ifndef MY_GATEWAY_SECONDARY_MAX_CLIENTS
+#define MY_GATEWAY_SECONDARY_MAX_CLIENTS (2u)
+#endif
+
 /**
- * @def MY_REGISTRATION_FEATURE
- * @brief If enabled, node has to register to GW/controller before being allowed to send sensor
- *        data.
- * @note Enabled by default.
+ * @def MY_GATEWAY_RX_BATCH_SIZE
+ * @brief Max number of controller messages routed per loop iteration.
+ *
+ * Every complete message the gateway transport has buffered, across all clients, is routed
+ * in one go up to this limit, the radio is serviced again before the rest is picked up.
  */
-#define MY_REGISTRATION_FEATURE
+#ifndef MY_GATEWAY_RX_BATCH_SIZE
+#define MY_GATEWAY_RX_BATCH_SIZE (16u)
+#endif
 
 /**
- * @def MY_REGISTRATION_RETRIES
- * @brief Number of registration retries if no reply received from GW/controller.
+ * @def MY_GATEWAY_RX_BUDGET_US
+ * @brief Time in us the gateway may spend on controller messages per loop iteration.
+ *
+ * Together with @ref MY_GATEWAY_RX_BATCH_SIZE this bounds a loop iteration, at least one
+ * message is routed per iteration.
  */
+#ifndef MY_GATEWAY_RX_BUDGET_US
+#define MY_GATEWAY_RX_BUDGET_US (20000ul)
+#endif
 
-#ifndef MY_REGISTRATION_RETRIES
-#define MY_REGISTRATION_RETRIES (3u)
+/**
+ * @def MY_GATEWAY_RECONNECT_MIN_DELAY_MS
+ * @brief Delay before retrying a failed connection to the controller or MQTT broker (client mode).
+ *
+ * The delay doubles after every failed attempt up to @ref MY_GATEWAY_RECONNECT_MAX_DELAY_MS,
+ * the radio keeps being serviced in the meantime.
+ */
+#ifndef MY_GATEWAY_RECONNECT_MIN_DELAY_MS
+#define MY_GATEWAY_RECONNECT_MIN_DELAY_MS (1000ul)
 #endif
 
 /**
-* @def MY_REGISTRATION_DEFAULT
-* @brief Node registration default - this applies if no registration response is received from
- *       controller.
-*/
-#define MY_REGISTRATION_DEFAULT (true)
+ * @def MY_GATEWAY_RECONNECT_MAX_DELAY_MS
+ * @brief Maximum delay between connection attempts to the controller or MQTT broker (client mode).
+ */
+#ifndef MY_GATEWAY_RECONNECT_MAX_DELAY_MS
+#define MY_GATEWAY_RECONNECT_MAX_DELAY_MS (30*1000ul)
+#endif
 
 /**
- * @def MY_REGISTRATION_CONTROLLER
- * @brief If defined, node registration request has to be handled by controller
+ * @def MY_GATEWAY_TIME_BEACON
+ * @brief Define this to broadcast the controller time to all nodes.
+ *
+ * The GW requests the time from the controller every @ref MY_GATEWAY_TIME_BEACON_INTERVAL_MS and
+ * broadcasts the answer, nodes hand it to receiveTime(). I_TIME requests of nodes are answered
+ * from the cached time instead of the controller. Broadcasts cannot be signed, nodes only accept
+ * the beacon from their parent.
  */
-//#define MY_REGISTRATION_CONTROLLER
-/** @}*/ // End of RegistrationSettingGrpPub group
+//#define MY_GATEWAY_TIME_BEACON
 
 /**
- * @defgroup CoreSettingGrpPub Core
- * @ingroup MyConfigGrp
- * @brief These options control the library core configurations.
- * @{
+ * @def MY_GATEWAY_TIME_BEACON_INTERVAL_MS
+ * @brief Interval of the time beacon, see @ref MY_GATEWAY_TIME_BEACON.
+ *
+ * The cached time answers requests for up to two intervals.
  */
+#ifndef MY_GATEWAY_TIME_BEACON_INTERVAL_MS
+#define MY_GATEWAY_TIME_BEACON_INTERVAL_MS (60*60*1000ul)
+#endif
+
 /**
- * @def MY_CORE_ONLY
- * @brief Define this if you want to use core functions without loading the framework.
+ * @def MY_GATEWAY_TIME_BEACON_RETRY_MS
+ * @brief Delay of the next time request if the controller could not be reached.
  */
-//#define MY_CORE_ONLY
+#ifndef MY_GATEWAY_TIME_BEACON_RETRY_MS
+#define MY_GATEWAY_TIME_BEACON_RETRY_MS (10*1000ul)
+#endif
 
 /**
- * @def MY_CORE_COMPATIBILITY_CHECK
- * @brief If defined, library compatibility is checked during node registration.
- *        Incompatible libraries are unable to send sensor data.
+ * @def MY_GATEWAY_FLOW_CONTROL
+ * @brief Define this to report the TX queue to the controller, so it can pace its commands.
+ *
+ * The GW sends I_FLOW_CONTROL messages with the payload "<queued>,<credit>": the messages waiting
+ * in the TX queue, and the commands (C_SET, C_REQ) the controller may send before their queue is
+ * full. The GW reports right away when the command queue fills up to
+ * @ref MY_GATEWAY_FLOW_CONTROL_HIGH percent and when it drains to @ref MY_GATEWAY_FLOW_CONTROL_LOW
+ * percent, other changes at most every @ref MY_GATEWAY_FLOW_CONTROL_INTERVAL_MS. An I_FLOW_CONTROL
+ * request of the controller is answered with the current values. Commands beyond the credit are
+ * still accepted, they are sent without queueing and hold up the GW until the radio is done.
+ * Requires @ref MY_TRANSPORT_TX_QUEUE_FEATURE.
  */
-#define MY_CORE_COMPATIBILITY_CHECK
-/** @}*/ // End of CoreSettingGrpPub group
+//#define MY_GATEWAY_FLOW_CONTROL
 
 /**
- * @defgroup SleepSettingGrpPub Sleep
- * @ingroup MyConfigGrp
- * @brief These options control sleep configurations.
- * @{
+ * @def MY_GATEWAY_FLOW_CONTROL_INTERVAL_MS
+ * @brief Shortest interval of the reports of changed values, see @ref MY_GATEWAY_FLOW_CONTROL.
  */
+#ifndef MY_GATEWAY_FLOW_CONTROL_INTERVAL_MS
+#define MY_GATEWAY_FLOW_CONTROL_INTERVAL_MS (1000ul)
+#endif
+
 /**
- * @def MY_SLEEP_TRANSPORT_RECONNECT_TIMEOUT_MS
- * @brief Timeout (in ms) to re-establish link if node is send to sleep and transport is not ready.
+ * @def MY_GATEWAY_FLOW_CONTROL_HIGH
+ * @brief Fill level in percent of the command queue reported right away, see @ref MY_GATEWAY_FLOW_CONTROL.
  */
-#ifndef MY_SLEEP_TRANSPORT_RECONNECT_TIMEOUT_MS
-#define MY_SLEEP_TRANSPORT_RECONNECT_TIMEOUT_MS (10*1000ul)
+#ifndef MY_GATEWAY_FLOW_CONTROL_HIGH
+#define MY_GATEWAY_FLOW_CONTROL_HIGH (75u)
 #endif
 
 /**
- * @def MY_SMART_SLEEP_WAIT_DURATION_MS
- * @brief The wait period (in ms) before going to sleep when using smartSleep-functions.
+ * @def MY_GATEWAY_FLOW_CONTROL_LOW
+ * @brief Fill level in percent the command queue is reported at again after it went up to
+ * @ref MY_GATEWAY_FLOW_CONTROL_HIGH.
+ */
+#ifndef MY_GATEWAY_FLOW_CONTROL_LOW
+#define MY_GATEWAY_FLOW_CONTROL_LOW (25u)
+#endif
+
+/**
+ * @def MY_GATEWAY_MAILBOX
+ * @brief Define this to buffer controller messages for sleeping nodes on the GW.
  *
- * This period has to be long enough for controller to be able to send out
- * potential buffered messages.
+ * A node is considered asleep after its I_PRE_SLEEP_NOTIFICATION. Controller messages for it
+ * are kept in a mailbox and delivered in one burst as soon as the node sends its next frame,
+ * e.g. the I_POST_SLEEP_NOTIFICATION, a reading or the next I_PRE_SLEEP_NOTIFICATION. A burst
+ * triggered by the pre-sleep notification is followed by an I_PRE_SLEEP_NOTIFICATION to the
+ * node, so the smartSleep() listen window only lasts as long as the delivery. A newer message
+ * for the same child sensor, command and type replaces the buffered one.
  */
-#ifndef MY_SMART_SLEEP_WAIT_DURATION_MS
-#define MY_SMART_SLEEP_WAIT_DURATION_MS (500ul)
+//#define MY_GATEWAY_MAILBOX
+
+/**
+ * @def MY_GATEWAY_MAILBOX_SIZE
+ * @brief Number of messages the mailbox holds for all sleeping nodes together.
+ *
+ * When the mailbox is full the oldest message is dropped.
+ */
+#ifndef MY_GATEWAY_MAILBOX_SIZE
+#if defined(__linux__)
+#define MY_GATEWAY_MAILBOX_SIZE (64u)
+#else
+#define MY_GATEWAY_MAILBOX_SIZE (8u)
+#endif
 #endif
-/** @}*/ // End of SleepSettingGrpPub group
 
 /**
- * @defgroup OTASettingGrpPub Over The Air firmware
- * @ingroup MyConfigGrp
- * @brief These options control OTA firmware configurations.
- * @{
+ * @def MY_GATEWAY_MAILBOX_NODE_SIZE
+ * @brief Number of messages the mailbox holds for a single node.
+ *
+ * When a node reaches the limit its oldest message is dropped.
  */
+#ifndef MY_GATEWAY_MAILBOX_NODE_SIZE
+#define MY_GATEWAY_MAILBOX_NODE_SIZE (4u)
+#endif
 
 /**
- * @def MY_OTA_FIRMWARE_FEATURE
- * @brief Define this in sketch to allow safe over-the-air firmware updates.
+ * @def MY_GATEWAY_PRESENTATION_CACHE
+ * @brief Define this to replay remote nodes' presentations to a newly connected controller.
  *
- * This feature requires external flash and the DualOptiBoot boot-loader.
- * @note You can still have OTA FW updates without external flash but it
- *       requires the MYSBootloader and you must not define this flag.
+ * The GW keeps the latest presentation, sketch name and version and value (C_SET) per node and
+ * child it handed to the controller. Whenever it presents itself, i.e. when a controller connects
+ * or sends I_PRESENTATION, the cache follows in one burst, so the controller does not have to
+ * wake up the network to ask each node to present itself again. On Linux the cache is kept in
+ * the presentation_cache_file of the config file across restarts. The GW also answers the
+ * presentation digest of nodes with @ref MY_PRESENTATION_DIGEST from the cache.
  */
-//#define MY_OTA_FIRMWARE_FEATURE
+//#define MY_GATEWAY_PRESENTATION_CACHE
 
 /**
- * @def MY_OTA_FLASH_SS
- * @brief Slave select pin for external flash used for OTA.
+ * @def MY_GATEWAY_PRESENTATION_CACHE_SIZE
+ * @brief Number of messages the presentation cache holds.
+ *
+ * When the cache is full the least recently updated value is dropped, or the least recently
+ * updated presentation if there is no value left.
  */
-#ifndef MY_OTA_FLASH_SS
-#define MY_OTA_FLASH_SS (8)
+#ifndef MY_GATEWAY_PRESENTATION_CACHE_SIZE
+#if defined(__linux__)
+#define MY_GATEWAY_PRESENTATION_CACHE_SIZE (1024u)
+#else
+#define MY_GATEWAY_PRESENTATION_CACHE_SIZE (16u)
+#endif
 #endif
 
 /**
- * @def MY_OTA_FLASH_JDECID
- * @brief Flash JDECID used for OTA. Use (0x00) if unknown.
+ * @def MY_GATEWAY_PRESENTATION_CACHE_SAVE_MS
+ * @brief Time in ms changes of the presentation cache are collected before the file is written (Linux).
  */
-#ifndef MY_OTA_FLASH_JDECID
-#define MY_OTA_FLASH_JDECID (0x1F65)
+#ifndef MY_GATEWAY_PRESENTATION_CACHE_SAVE_MS
+#define MY_GATEWAY_PRESENTATION_CACHE_SAVE_MS (30000ul)
 #endif
 
 /**
- * @def MY_DISABLE_REMOTE_RESET
- * @brief Disables over-the-air reset of node
+ * @def MY_GATEWAY_OUTBOX
+ * @brief Define this to keep controller messages for nodes until the radio delivered them (Linux).
+ *
+ * Messages from the controller to a node are stored in an outbox and sent from there. A message
+ * that is not acknowledged by the next hop is retried with a backoff from
+ * @ref MY_GATEWAY_OUTBOX_RETRY_MIN_MS to @ref MY_GATEWAY_OUTBOX_RETRY_MAX_MS until it expires after
+ * @ref MY_GATEWAY_OUTBOX_TTL_S, messages for the same node keep their order. A newer message for
+ * the same child sensor, command and type replaces the stored one. With the outbox_file of the
+ * config file the outbox is a memory mapped file, messages still pending when the gateway stops
+ * are sent after it started again. Broadcasts are sent once and not stored.
  */
-//#define MY_DISABLE_REMOTE_RESET
-/** @}*/ // End of OTASettingGrpPub group
+//#define MY_GATEWAY_OUTBOX
 
 /**
- * @defgroup GatewaySettingGrpPub Gateway
- * @ingroup MyConfigGrp
- * @brief These options control gateway specific configurations.
- * @{
+ * @def MY_GATEWAY_OUTBOX_SIZE
+ * @brief Number of messages the outbox holds (max 255).
+ *
+ * When the outbox is full the oldest message is dropped.
  */
+#ifndef MY_GATEWAY_OUTBOX_SIZE
+#define MY_GATEWAY_OUTBOX_SIZE (64u)
+#endif
+
 /**
- * @def MY_GATEWAY_MAX_RECEIVE_LENGTH
- * @brief Max buffersize needed for messages coming from controller.
+ * @def MY_GATEWAY_OUTBOX_TTL_S
+ * @brief Time in seconds a message is kept in the outbox, including the time the gateway was stopped.
  */
-#ifndef MY_GATEWAY_MAX_RECEIVE_LENGTH
-#define MY_GATEWAY_MAX_RECEIVE_LENGTH (100u)
+#ifndef MY_GATEWAY_OUTBOX_TTL_S
+#define MY_GATEWAY_OUTBOX_TTL_S (3600ul)
 #endif
 
 /**
- * @def MY_GATEWAY_MAX_SEND_LENGTH
- * @brief Max buffer size when sending messages.
+ * @def MY_GATEWAY_OUTBOX_RETRY_MIN_MS
+ * @brief Delay before a message of the outbox is sent again after its first failed attempt.
+ *
+ * The delay doubles after every further failed attempt up to @ref MY_GATEWAY_OUTBOX_RETRY_MAX_MS.
  */
-#ifndef MY_GATEWAY_MAX_SEND_LENGTH
-#define MY_GATEWAY_MAX_SEND_LENGTH (120u)
+#ifndef MY_GATEWAY_OUTBOX_RETRY_MIN_MS
+#define MY_GATEWAY_OUTBOX_RETRY_MIN_MS (2000ul)
 #endif
 
 /**
- * @def MY_GATEWAY_MAX_CLIENTS
- * @brief Max number of parallel clients (sever mode).
+ * @def MY_GATEWAY_OUTBOX_RETRY_MAX_MS
+ * @brief Maximum delay between two attempts to send a message of the outbox.
  */
-#ifndef MY_GATEWAY_MAX_CLIENTS
-#define MY_GATEWAY_MAX_CLIENTS (1u)
+#ifndef MY_GATEWAY_OUTBOX_RETRY_MAX_MS
+#define MY_GATEWAY_OUTBOX_RETRY_MAX_MS (300000ul)
+#endif
+
+/**
+ * @def MY_GATEWAY_STANDBY
+ * @brief Define this to run two GWs as a hot-standby pair on one radio address (Linux).
+ *
+ * The active GW accepts the standby on the standby_port of the config file. It sends heartbeats
+ * every @ref MY_GATEWAY_STANDBY_HEARTBEAT_MS, the routes set, the verification nonces handed out
+ * with @ref MY_SIGNING_FEATURE and the entries of the @ref MY_GATEWAY_OUTBOX. A standby that
+ * connects first gets the complete routing table and outbox.
+ *
+ * A GW with standby_peer in its config file starts as the standby. It mirrors this state and
+ * leaves its radio off until nothing was heard from the peer for @ref MY_GATEWAY_STANDBY_TIMEOUT_MS.
+ * Then it starts like a GW that was restarted, with the mirrored state, and the nodes keep their
+ * parent. With standby_port set as well it serves the next standby itself, e.g. the repaired
+ * GW started with standby_peer pointing to it.
+ *
+ * Both GWs need the same radio settings and keys. The controller must reach the one that is active,
+ * e.g. through a MQTT broker or a floating IP address.
+ *
+ * The standby cannot tell a dead GW from a broken link. If the link between the two fails, both
+ * are active on the same radio address until it is back: the nodes get duplicate ACKs and answers
+ * and the controller sees two GWs. Use a reliable link between the two. As a guard, a GW that took
+ * over keeps connecting to standby_peer, which only answers while it is active itself. If it does,
+ * the GW that took over exits with a failure, unless the peer took over as well and did so later.
+ * Run mysgw under a service manager that restarts it on failure, e.g. Restart=on-failure of systemd,
+ * so it starts as the standby again. Messages handled by it alone in the meantime are lost.
+ */
+//#define MY_GATEWAY_STANDBY
+
+/**
+ * @def MY_GATEWAY_STANDBY_HEARTBEAT_MS
+ * @brief Interval of the heartbeats of the active GW, see @ref MY_GATEWAY_STANDBY.
+ */
+#ifndef MY_GATEWAY_STANDBY_HEARTBEAT_MS
+#define MY_GATEWAY_STANDBY_HEARTBEAT_MS (100ul)
+#endif
+
+/**
+ * @def MY_GATEWAY_STANDBY_TIMEOUT_MS
+ * @brief Time without anything heard from the active GW after which the standby takes over.
+ *
+ * A few heartbeats long, so a delayed one does not start a second active GW.
+ */
+#ifndef MY_GATEWAY_STANDBY_TIMEOUT_MS
+#define MY_GATEWAY_STANDBY_TIMEOUT_MS (500ul)
+#endif
+
+/**
+ * @def MY_GATEWAY_FIRMWARE_SERVER
+ * @brief Define this to answer OTA firmware requests of the nodes on the GW (Linux).
+ *
+ * The binary images in the firmware_dir of the config file, named <type>-<version>.bin, are
+ * memory mapped. A node asking for the firmware config is offered the highest version of its
+ * type, its block requests are answered from the image at radio speed. The controller only gets
+ * I_LOG_MESSAGEs of the progress on behalf of the node. Requests for types without an image go to
+ * the controller as before. New images are picked up when they are moved into the directory or
+ * on SIGHUP.
+ */
+//#define MY_GATEWAY_FIRMWARE_SERVER
+
+/**
+ * @def MY_GATEWAY_ID_ALLOCATOR
+ * @brief Define this to answer I_ID_REQUEST on the GW instead of forwarding it to the controller.
+ *
+ * The GW leases the lowest ID from @ref MY_GATEWAY_ID_ALLOCATOR_FIRST to
+ * @ref MY_GATEWAY_ID_ALLOCATOR_LAST without a route in its routing table, i.e. that never sent a
+ * message through the GW. The lease is stored as route in the routing table, clearing the
+ * routing table releases all IDs.
+ *
+ * The last @ref MY_GATEWAY_ID_ALLOCATOR_LEASES IDs answered are remembered with the token and the
+ * last hop of the request until the node sends with its ID. A repeated request, e.g. because the
+ * response got lost, gets the same ID. An ID not used within @ref MY_GATEWAY_ID_ALLOCATOR_LEASE_MS
+ * is free again, e.g. if the node restarted and asked with another token. The I_ID_RESPONSE sent to the node is also handed to the
+ * controller, after the node has been answered. Nodes with static IDs must use IDs outside the
+ * range unless they have been seen by the GW before the first lease.
+ */
+//#define MY_GATEWAY_ID_ALLOCATOR
+
+/**
+ * @def MY_GATEWAY_ID_ALLOCATOR_FIRST
+ * @brief Lowest ID leased, see @ref MY_GATEWAY_ID_ALLOCATOR.
+ */
+#ifndef MY_GATEWAY_ID_ALLOCATOR_FIRST
+#define MY_GATEWAY_ID_ALLOCATOR_FIRST (1u)
+#endif
+
+/**
+ * @def MY_GATEWAY_ID_ALLOCATOR_LAST
+ * @brief Highest ID leased, see @ref MY_GATEWAY_ID_ALLOCATOR.
+ */
+#ifndef MY_GATEWAY_ID_ALLOCATOR_LAST
+#define MY_GATEWAY_ID_ALLOCATOR_LAST (254u)
+#endif
+
+/**
+ * @def MY_GATEWAY_ID_ALLOCATOR_LEASES
+ * @brief IDs remembered until the node uses them, see @ref MY_GATEWAY_ID_ALLOCATOR.
+ */
+#ifndef MY_GATEWAY_ID_ALLOCATOR_LEASES
+#define MY_GATEWAY_ID_ALLOCATOR_LEASES (4u)
+#endif
+
+/**
+ * @def MY_GATEWAY_ID_ALLOCATOR_LEASE_MS
+ * @brief Time in ms a node has to use its ID before it is leased again, see @ref MY_GATEWAY_ID_ALLOCATOR.
+ */
+#ifndef MY_GATEWAY_ID_ALLOCATOR_LEASE_MS
+#define MY_GATEWAY_ID_ALLOCATOR_LEASE_MS (60000ul)
 #endif
 
 /**
@@ -1429,57 +3208,212 @@
 #endif
 
 /**
- * @def MY_MQTT_CLIENT_PUBLISH_RETAIN
- * @brief Enables MQTT client to set the retain flag when publishing specific messages.
+ * @def MY_MQTT_CLIENT_PUBLISH_RETAIN
+ * @brief Enables MQTT client to set the retain flag when publishing specific messages.
+ */
+//#define MY_MQTT_CLIENT_PUBLISH_RETAIN
+
+/**
+ * @def MY_MQTT_CLIENT_PUBLISH_QOS1
+ * @brief Publish with QoS1 from an outbound queue instead of publishing synchronously with QoS0.
+ *
+ * Messages for the broker are queued in a ring of @ref MY_MQTT_CLIENT_QUEUE_SIZE entries and
+ * up to @ref MY_MQTT_CLIENT_INFLIGHT_WINDOW of them are published before their PUBACK arrives.
+ * Unacknowledged publishes are sent again after a reconnect, so a broker hiccup does not lose
+ * messages as long as the queue does not overflow.
+ */
+//#define MY_MQTT_CLIENT_PUBLISH_QOS1
+
+/**
+ * @def MY_MQTT_CLIENT_QUEUE_SIZE
+ * @brief Number of messages the MQTT outbound queue holds, see @ref MY_MQTT_CLIENT_PUBLISH_QOS1.
+ */
+#ifndef MY_MQTT_CLIENT_QUEUE_SIZE
+#define MY_MQTT_CLIENT_QUEUE_SIZE (16u)
+#endif
+
+/**
+ * @def MY_MQTT_CLIENT_INFLIGHT_WINDOW
+ * @brief Number of QoS1 publishes that may await their PUBACK at the same time.
+ *
+ * Limited to MQTT_MAX_INFLIGHT of the MQTT client, see @ref MY_MQTT_CLIENT_PUBLISH_QOS1.
+ */
+#ifndef MY_MQTT_CLIENT_INFLIGHT_WINDOW
+#define MY_MQTT_CLIENT_INFLIGHT_WINDOW (4u)
+#endif
+
+/**
+ * @def MY_MQTT_CLIENT_RX_QUEUE_SIZE
+ * @brief Number of messages from the broker queued for the radio.
+ *
+ * One poll of the MQTT client can deliver several publishes, e.g. a scene fired by the
+ * controller. They are parsed into this queue and routed in batches, messages arriving on a full
+ * queue are counted by STATS_GW_RX_OVERFLOWS.
+ * @note Each entry is a MyMessage, 32 bytes of RAM. Defaults to 8 (256 bytes), 2 on AVR.
+ */
+#ifndef MY_MQTT_CLIENT_RX_QUEUE_SIZE
+#if defined(__AVR__)
+#define MY_MQTT_CLIENT_RX_QUEUE_SIZE (2u)
+#else
+#define MY_MQTT_CLIENT_RX_QUEUE_SIZE (8u)
+#endif
+#endif
+
+/**
+ * @def MY_MQTT_PASSWORD
+ * @brief Used for authenticated MQTT connections.
+ *
+ * Set if your MQTT broker requires username/password.
+ * Example: @code #define MY_MQTT_PASSWORD "secretpassword" @endcode
+ * @see MY_MQTT_USER
+ */
+//#define MY_MQTT_PASSWORD "secretpassword"
+
+/**
+ * @def MY_MQTT_USER
+ * @brief Used for authenticated MQTT connections.
+ *
+ * Set if your MQTT broker requires username/password.
+ * Example: @code #define MY_MQTT_USER "username" @endcode
+ * @see MY_MQTT_PASSWORD
+ */
+//#define MY_MQTT_USER "username"
+
+/**
+ * @def MY_MQTT_CLIENT_ID
+ * @brief Set client ID for MQTT connections
+ *
+ * This define is mandatory for all MQTT client gateways.
+ * Example: @code #define MY_MQTT_CLIENT_ID "mysensors-1" @endcode
+ */
+//#define MY_MQTT_CLIENT_ID "mysensors-1"
+
+/**
+ * @def MY_MQTT_PUBLISH_TOPIC_PREFIX
+ * @brief Set prefix for MQTT topic to publish to.
+ *
+ * This define is mandatory for all MQTT client gateways.
+ * Example: @code #define MY_MQTT_PUBLISH_TOPIC_PREFIX "mygateway1-out" @endcode
+ */
+//#define MY_MQTT_PUBLISH_TOPIC_PREFIX "mygateway1-out"
+
+/**
+ * @def MY_MQTT_SUBSCRIBE_TOPIC_PREFIX
+ * @brief Set prefix for MQTT topic to subscribe to.
+ *
+ * This define is mandatory for all MQTT client gateways.
+ * Example: @code #define MY_MQTT_SUBSCRIBE_TOPIC_PREFIX "mygateway1-in" @endcode
+ */
+//#define MY_MQTT_SUBSCRIBE_TOPIC_PREFIX "mygateway1-in"
+
+/**
+ * @def MY_MQTT_CLIENT_BUFFER_SIZE
+ * @brief Size of the MQTT client packet buffer in bytes.
+ *
+ * Incoming packets that do not fit are dropped. Outgoing publishes are streamed and
+ * not limited by this buffer.
+ */
+#ifndef MY_MQTT_CLIENT_BUFFER_SIZE
+#define MY_MQTT_CLIENT_BUFFER_SIZE (MQTT_MAX_PACKET_SIZE)
+#endif
+
+/**
+ * @def MY_MQTT_CLIENT_KEEPALIVE_S
+ * @brief Keepalive in seconds the MQTT gateway announces to the broker.
+ *
+ * A broker that stays silent for this long is pinged, the connection is dropped and
+ * re-established if it does not answer within another period. Shorter values notice a
+ * restarted broker or a WiFi blip sooner at the cost of a ping packet per period.
+ */
+#ifndef MY_MQTT_CLIENT_KEEPALIVE_S
+#define MY_MQTT_CLIENT_KEEPALIVE_S (MQTT_KEEPALIVE)
+#endif
+
+/**
+ * @def MY_MQTT_CLIENT_SOCKET_TIMEOUT_S
+ * @brief Time in seconds the MQTT gateway waits for the broker to accept a connect.
+ *
+ * The gateway blocks meanwhile, so a broker that accepts the TCP connection but does not
+ * answer holds the radio for this long per attempt.
+ */
+#ifndef MY_MQTT_CLIENT_SOCKET_TIMEOUT_S
+#define MY_MQTT_CLIENT_SOCKET_TIMEOUT_S (MQTT_SOCKET_TIMEOUT)
+#endif
+
+/**
+ * @def MY_MQTT_CLIENT_TLS
+ * @brief Define this to connect to the broker by TLS, ESP8266 and ESP32 only.
+ *
+ * Set @ref MY_PORT to the TLS port of the broker, usually 8883. On the ESP8266 the session
+ * of the first handshake is kept and resumed on reconnects, which skips the key exchange
+ * that takes seconds there. The ESP32 does a full handshake on every connect.
+ * The broker is trusted as set by @ref MY_MQTT_CLIENT_TLS_CA_CERT or
+ * @ref MY_MQTT_CLIENT_TLS_FINGERPRINT, without either one its certificate is not checked.
  */
-//#define MY_MQTT_CLIENT_PUBLISH_RETAIN
+//#define MY_MQTT_CLIENT_TLS
 
 /**
- * @def MY_MQTT_PASSWORD
- * @brief Used for authenticated MQTT connections.
+ * @def MY_MQTT_CLIENT_TLS_CA_CERT
+ * @brief PEM certificate of the CA that signed the certificate of the broker.
  *
- * Set if your MQTT broker requires username/password.
- * Example: @code #define MY_MQTT_PASSWORD "secretpassword" @endcode
- * @see MY_MQTT_USER
+ * Example: @code #define MY_MQTT_CLIENT_TLS_CA_CERT "-----BEGIN CERTIFICATE-----\n..." @endcode
  */
-//#define MY_MQTT_PASSWORD "secretpassword"
+//#define MY_MQTT_CLIENT_TLS_CA_CERT "-----BEGIN CERTIFICATE-----\n..."
 
 /**
- * @def MY_MQTT_USER
- * @brief Used for authenticated MQTT connections.
+ * @def MY_MQTT_CLIENT_TLS_FINGERPRINT
+ * @brief SHA1 fingerprint of the certificate of the broker, ESP8266 only.
  *
- * Set if your MQTT broker requires username/password.
- * Example: @code #define MY_MQTT_USER "username" @endcode
- * @see MY_MQTT_PASSWORD
+ * Example: @code #define MY_MQTT_CLIENT_TLS_FINGERPRINT "AB:CD:..." @endcode
  */
-//#define MY_MQTT_USER "username"
+//#define MY_MQTT_CLIENT_TLS_FINGERPRINT "AB:CD:..."
 
 /**
- * @def MY_MQTT_CLIENT_ID
- * @brief Set client ID for MQTT connections
+ * @def MY_MQTT_CLIENT_TOPIC_CACHE_SIZE
+ * @brief Number of formatted publish topics the MQTT gateway keeps, 0 to format every topic.
  *
- * This define is mandatory for all MQTT client gateways.
- * Example: @code #define MY_MQTT_CLIENT_ID "mysensors-1" @endcode
+ * Each entry takes about 28 bytes, the cache is enabled on Linux only by default.
  */
-//#define MY_MQTT_CLIENT_ID "mysensors-1"
+#ifndef MY_MQTT_CLIENT_TOPIC_CACHE_SIZE
+#if defined(MY_GATEWAY_LINUX)
+#define MY_MQTT_CLIENT_TOPIC_CACHE_SIZE (256u)
+#else
+#define MY_MQTT_CLIENT_TOPIC_CACHE_SIZE (0u)
+#endif
+#endif
 
 /**
- * @def MY_MQTT_PUBLISH_TOPIC_PREFIX
- * @brief Set prefix for MQTT topic to publish to.
+ * @def MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS
+ * @brief Define this to a time in ms to skip retained publishes that repeat the last payload
+ * of their topic within it.
  *
- * This define is mandatory for all MQTT client gateways.
- * Example: @code #define MY_MQTT_PUBLISH_TOPIC_PREFIX "mygateway1-out" @endcode
+ * Nodes re-sending unchanged values (periodic state, heartbeats of a sensor) then do not load
+ * the broker and wake its subscribers, the retained value is already there. The last payload is
+ * kept as a hash in the topic cache, each entry grows by 8 bytes. A topic whose entry was
+ * replaced is published again, as is everything after a reconnect to the broker. Skipped
+ * publishes are counted by STATS_GW_TX_SUPPRESSED.
+ * Requires @ref MY_MQTT_CLIENT_PUBLISH_RETAIN and @ref MY_MQTT_CLIENT_TOPIC_CACHE_SIZE > 0.
+ * Example: @code #define MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS (15*60*1000ul) @endcode
  */
-//#define MY_MQTT_PUBLISH_TOPIC_PREFIX "mygateway1-out"
+//#define MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS (15*60*1000ul)
 
 /**
- * @def MY_MQTT_SUBSCRIBE_TOPIC_PREFIX
- * @brief Set prefix for MQTT topic to subscribe to.
+ * @def MY_GSM_ASYNC_SLICE_MS
+ * @brief Time in ms the modem gets per gatewayTransportAvailable() call, see @ref MY_GSM_ASYNC.
+ */
+#ifndef MY_GSM_ASYNC_SLICE_MS
+#define MY_GSM_ASYNC_SLICE_MS (2u)
+#endif
+
+/**
+ * @def MY_UART_DMA_RX_BUFFER_SIZE
+ * @brief Size of the DMA receive buffer of the modem UART in bytes, see @ref MY_GSM_UART_DMA.
  *
- * This define is mandatory for all MQTT client gateways.
- * Example: @code #define MY_MQTT_SUBSCRIBE_TOPIC_PREFIX "mygateway1-in" @endcode
+ * At 115200 baud, 512 bytes last 44ms without reading.
  */
-//#define MY_MQTT_SUBSCRIBE_TOPIC_PREFIX "mygateway1-in"
+#ifndef MY_UART_DMA_RX_BUFFER_SIZE
+#define MY_UART_DMA_RX_BUFFER_SIZE (512u)
+#endif
 
 /**
  * @def MY_IP_ADDRESS
@@ -1508,10 +3442,36 @@
 /**
  * @def MY_USE_UDP
  * @brief Enables UDP mode for Ethernet gateway.
- * @note This is not supported on ENC28J60 and Linux based GWs.
+ *
+ * On Linux the pending datagrams are received with one recvmmsg() and the queued ones are sent
+ * with one sendmmsg() per loop iteration.
+ * @note This is not supported on ENC28J60 based GWs.
  */
 //#define MY_USE_UDP
 
+/**
+ * @def MY_GATEWAY_UDP_DATAGRAM_SIZE
+ * @brief Size up to which messages for the controller are packed into one datagram in UDP mode.
+ *
+ * The default fills an Ethernet frame, lower it if the path to the controller has a smaller MTU.
+ * Set it to @ref MY_GATEWAY_MAX_SEND_LENGTH or less to send every message on its own.
+ * @see MY_GATEWAY_UDP_FLUSH_MS
+ */
+#ifndef MY_GATEWAY_UDP_DATAGRAM_SIZE
+#define MY_GATEWAY_UDP_DATAGRAM_SIZE (1472u)
+#endif
+
+/**
+ * @def MY_GATEWAY_UDP_FLUSH_MS
+ * @brief Longest time in milliseconds a message waits for more to share its datagram in UDP mode.
+ *
+ * With 0 the messages sent during one loop pass, e.g. a presentation, share a datagram which is
+ * sent on the next pass.
+ */
+#ifndef MY_GATEWAY_UDP_FLUSH_MS
+#define MY_GATEWAY_UDP_FLUSH_MS (0u)
+#endif
+
 /**
  * @def MY_IP_RENEWAL_INTERVAL_MS
  * @brief DHCP, default renewal setting in milliseconds.
@@ -1599,6 +3559,17 @@
  */
 //#define MY_WITH_LEDS_BLINKING_INVERSE
 
+/**
+ * @def MY_WITH_LEDS_BLINKING_TIMER
+ * @brief Define this to blink the LEDs from a timer interrupt instead of polling them in doYield().
+ *
+ * Nodes go to sleep without waiting for the blinking to finish. The LEDs are dark while sleeping
+ * and the timer continues their patterns after wake-up. It stops while all LEDs are off.
+ * AVR uses the compare B interrupt of Timer0, which also counts millis(). Other architectures
+ * keep polling the LEDs.
+ */
+//#define MY_WITH_LEDS_BLINKING_TIMER
+
 /**
  * @def MY_INDICATION_HANDLER
  * @brief Define to use own indication handler.
@@ -1627,12 +3598,15 @@
  * | @ref MY_ENCRYPTION_SIMPLE_PASSWD | Enables encryption without the need for @ref personalization | "#define" in the top of your sketch | @verbatim --my-security-password=<PASSWORD> @endverbatim and encryption enabled on the chosen transport
  * | @ref MY_DEBUG_VERBOSE_SIGNING | Enables verbose signing debugging | "#define" in the top of your sketch | @verbatim --my-signing-debug @endverbatim
  * | @ref MY_SIGNING_ATSHA204 | Enables support to sign messages backed by ATSHA204A hardware | "#define" in the top of your sketch | Not supported
+ * | @ref MY_SIGNING_ATECC | Enables support to sign messages backed by ATECC508A/ATECC608A hardware | "#define" in the top of your sketch | Not supported
  * | @ref MY_SIGNING_SOFT | Enables support to sign messages backed by software | "#define" in the top of your sketch | @verbatim --my-signing=software @endverbatim
  * | @ref MY_SIGNING_REQUEST_SIGNATURES | Enables node/gw to require signed messages | "#define" in the top of your sketch | @verbatim --my-signing-request-signatures @endverbatim
  * | @ref MY_SIGNING_WEAK_SECURITY | Weakens signing security, useful for testing before deploying signing "globally" | "#define" in the top of your sketch | @verbatim --my-signing-weak_security @endverbatim
  * | @ref MY_VERIFICATION_TIMEOUT_MS | Change default signing timeout | "#define" in the top of your sketch | @verbatim --my-signing-verification-timeout-ms=<TIMEOUT> @endverbatim
  * | @ref MY_SIGNING_NODE_WHITELISTING | Defines a whitelist of trusted nodes | "#define" in the top of your sketch | @verbatim --my-signing-whitelist="<WHITELIST>" @endverbatim
  * | @ref MY_SIGNING_ATSHA204_PIN | Change default ATSHA204A communication pin | "#define" in the top of your sketch | Not supported
+ * | @ref MY_SIGNING_ATSHA204_SERIAL | Talk to the ATSHA204A through a hardware serial port | "#define" in the top of your sketch | Not supported
+ * | @ref MY_SIGNING_ATSHA204_SESSION | Keep the ATSHA204A awake between signing operations | "#define" in the top of your sketch | Not supported
  * | @ref MY_SIGNING_SOFT_RANDOMSEED_PIN | Change default software RNG seed pin | "#define" in the top of your sketch | Not supported
  * | @ref MY_RF24_ENABLE_ENCRYPTION | Enables encryption on RF24 radios | "#define" in the top of your sketch | @verbatim --my-rf24-encryption-enabled @endverbatim
  * | @ref MY_RFM69_ENABLE_ENCRYPTION | Enables encryption on %RFM69 radios | "#define" in the top of your sketch | @verbatim --my-rfm69-encryption-enabled @endverbatim
@@ -1715,6 +3689,38 @@
  */
 //#define MY_SIGNING_ATSHA204
 
+/**
+ * @def MY_SIGNING_ATECC
+ * @brief Enables HW backed signing with an ATECC508A or ATECC608A on I2C.
+ *
+ * The signatures are the same as with @ref MY_SIGNING_ATSHA204, nodes of both backends and
+ * @ref MY_SIGNING_SOFT can be mixed. Only the HMAC with the key runs on the chip, in three
+ * commands per 32 bytes of message without EEPROM writes, the ATSHA204A needs four including
+ * one write. The digests around it are calculated in software.
+ *
+ * The HMAC key has to be in slot @ref MY_SIGNING_ATECC_KEY_SLOT and the configuration zone
+ * has to be locked. The SHA command sends 72 bytes at once, on AVR the buffers of the Wire
+ * library (BUFFER_LENGTH, TWI_BUFFER_LENGTH) have to be raised accordingly. The bus runs at
+ * 100kHz to generate the wake token.
+ */
+//#define MY_SIGNING_ATECC
+
+/**
+ * @def MY_SIGNING_ATECC_I2C_ADDRESS
+ * @brief 7 bit I2C address of the ATECC, see @ref MY_SIGNING_ATECC.
+ */
+#ifndef MY_SIGNING_ATECC_I2C_ADDRESS
+#define MY_SIGNING_ATECC_I2C_ADDRESS (0x60)
+#endif
+
+/**
+ * @def MY_SIGNING_ATECC_KEY_SLOT
+ * @brief Slot of the ATECC holding the HMAC key, see @ref MY_SIGNING_ATECC.
+ */
+#ifndef MY_SIGNING_ATECC_KEY_SLOT
+#define MY_SIGNING_ATECC_KEY_SLOT (0)
+#endif
+
 /**
  * @def MY_SIGNING_SOFT
  * @brief Enables SW backed signing functionality in library.
@@ -1764,6 +3770,114 @@
 #define MY_VERIFICATION_TIMEOUT_MS (5*1000ul)
 #endif
 
+/**
+ * @def MY_SIGNING_NONCE_TABLE_SIZE
+ * @brief Number of verification sessions that can be ongoing at the same time
+ *
+ * Every nonce handed out for verification is kept until the signed message from that peer
+ * arrives or until @ref MY_VERIFICATION_TIMEOUT_MS has passed. When the table is full, the
+ * oldest session is dropped. Each entry costs 38 bytes of RAM, so nodes default to a single
+ * session while Linux gateways, that verify traffic from many nodes, keep 16.
+ */
+#ifndef MY_SIGNING_NONCE_TABLE_SIZE
+#if defined(__linux__)
+#define MY_SIGNING_NONCE_TABLE_SIZE (16u)
+#else
+#define MY_SIGNING_NONCE_TABLE_SIZE (1u)
+#endif
+#endif
+
+/**
+ * @def MY_SIGNING_NONCE_PREFETCH
+ * @brief Define to fetch the next nonce for a destination in the background
+ *
+ * Normally every signed message waits for a nonce request/response round trip before it can
+ * be sent. With this option, a new nonce is requested right after a signed message to a
+ * destination has been sent, so the next signed message to that destination within
+ * @ref MY_VERIFICATION_TIMEOUT_MS / 2 is signed without waiting. Each nonce is still used
+ * only once. Costs one extra nonce request per burst of signed messages.
+ *
+ * The receiver must be able to keep a session per peer (see @ref MY_SIGNING_NONCE_TABLE_SIZE).
+ */
+//#define MY_SIGNING_NONCE_PREFETCH
+
+/**
+ * @def MY_SIGNING_NONCE_PREFETCH_SIZE
+ * @brief Number of destinations for which a nonce is prefetched
+ *
+ * When the table is full, the destination signed for least recently is replaced.
+ */
+#ifndef MY_SIGNING_NONCE_PREFETCH_SIZE
+#define MY_SIGNING_NONCE_PREFETCH_SIZE (2u)
+#endif
+
+/**
+ * @def MY_SIGNING_NONCE_POOL
+ * @brief Define to answer nonce requests from a pool of nonces generated ahead of time
+ *
+ * Without it every I_NONCE_REQUEST gathers entropy and hashes it before the nonce is sent, on
+ * the path of every signed message to this node. With it, e.g. on a gateway, the pool is refilled
+ * one nonce per loop iteration and a request takes the oldest nonce from it. Each nonce is
+ * handed out once and dropped after @ref MY_SIGNING_NONCE_POOL_MAX_AGE_MS unused. Requests
+ * served from the pool and generated on the spot are counted by @ref MY_STATS_FEATURE.
+ * Soft signing backend only, the ATSHA204 and ATECC generate their nonces themselves.
+ */
+//#define MY_SIGNING_NONCE_POOL
+
+/**
+ * @def MY_SIGNING_NONCE_POOL_SIZE
+ * @brief Number of nonces kept ready, 32 bytes each
+ */
+#ifndef MY_SIGNING_NONCE_POOL_SIZE
+#define MY_SIGNING_NONCE_POOL_SIZE (4u)
+#endif
+
+/**
+ * @def MY_SIGNING_NONCE_POOL_MAX_AGE_MS
+ * @brief Time in ms after which an unused nonce of the pool is replaced
+ */
+#ifndef MY_SIGNING_NONCE_POOL_MAX_AGE_MS
+#define MY_SIGNING_NONCE_POOL_MAX_AGE_MS (60000ul)
+#endif
+
+/**
+ * @def MY_SIGNING_TAG_SIZE
+ * @brief Truncate signatures to this many bytes (2..32), including the signing identifier.
+ *
+ * Without it, the signature fills the payload and every signed message is sent with the
+ * maximum length. With it, a signed message is its payload plus this many bytes, less if the
+ * payload leaves less space. The identifier carries the length, relaying nodes need no
+ * configuration but have to run a library version that knows the identifier.
+ *
+ * Shorter signatures than configured are rejected, signatures filling the payload are still
+ * accepted from senders without this option. Signatures of 9 bytes (64 bit HMAC) are
+ * considered adequate for messages protected by a one-time nonce.
+ */
+//#define MY_SIGNING_TAG_SIZE (9u)
+
+/**
+ * @def MY_SIGNING_ASYNC
+ * @brief Define to sign messages once their nonce arrives instead of waiting for it
+ *
+ * Normally writing a signed message blocks until the nonce from the destination has arrived,
+ * processing other messages in a nested _process() call meanwhile. With this option, the
+ * message is queued, and signed and written to the transport when the nonce arrives. Several
+ * destinations can have a signed message in flight at the same time, which suits gateways
+ * sending to many nodes. Messages are dropped if their nonce does not arrive within
+ * @ref MY_VERIFICATION_TIMEOUT_MS. When the queue is full, signing blocks as before.
+ *
+ * A message is reported as sent once it has been queued.
+ */
+//#define MY_SIGNING_ASYNC
+
+/**
+ * @def MY_SIGNING_ASYNC_QUEUE_SIZE
+ * @brief Number of messages that can wait for their nonce with @ref MY_SIGNING_ASYNC
+ */
+#ifndef MY_SIGNING_ASYNC_QUEUE_SIZE
+#define MY_SIGNING_ASYNC_QUEUE_SIZE (4u)
+#endif
+
 /**
  * @def MY_SIGNING_NODE_WHITELISTING
  * @brief Define to turn on whitelisting
@@ -1778,6 +3892,9 @@
  *
  * It is legal to only have one node with a whitelist for this reason but it is not required.
  *
+ * List the entries in ascending order of nodeId to have them looked up with a binary search
+ * instead of a linear one.
+ *
  * Example: @code #define MY_SIGNING_NODE_WHITELISTING {{.nodeId = GATEWAY_ADDRESS,.serial = {0x09,0x08,0x07,0x06,0x05,0x04,0x03,0x02,0x01}}} @endcode
  */
 //#define MY_SIGNING_NODE_WHITELISTING {{.nodeId = GATEWAY_ADDRESS,.serial = {0x09,0x08,0x07,0x06,0x05,0x04,0x03,0x02,0x01}}}
@@ -1790,6 +3907,43 @@
 #define MY_SIGNING_ATSHA204_PIN (17)
 #endif
 
+/**
+ * @def MY_SIGNING_ATSHA204_SERIAL
+ * @brief Talk to the Atsha204a through this hardware serial port instead of bit-banging the pin.
+ *
+ * Connect both RX and TX of the UART to SDA of the device, TX through a schottky diode
+ * (cathode towards TX). The UART times the single-wire bits, so interrupts stay enabled and
+ * the radio does not lose frames while messages are signed or verified. Bit-banging has to
+ * disable interrupts for every byte sent and for the whole response.
+ * @ref MY_SIGNING_ATSHA204_PIN is not used then.
+ *
+ * Example: @code #define MY_SIGNING_ATSHA204_SERIAL Serial1 @endcode
+ */
+//#define MY_SIGNING_ATSHA204_SERIAL Serial1
+
+/**
+ * @def MY_SIGNING_ATSHA204_SESSION
+ * @brief Keep the Atsha204a awake between signing operations.
+ *
+ * Every nonce, signature and verification wakes the device and puts it back to idle or sleep,
+ * the wake-up alone takes 3ms. In a session the device stays awake while signing activity
+ * continues, back-to-back operations on a busy GW or repeater skip the wake-up. The session ends
+ * @ref MY_SIGNING_ATSHA204_SESSION_MS after the last operation, and before the watchdog of the
+ * device would end it, which puts the device to sleep 0.7s after the wake-up at the earliest.
+ * The awake device draws about 1mA more than a sleeping one while the session lasts.
+ */
+//#define MY_SIGNING_ATSHA204_SESSION
+
+/**
+ * @def MY_SIGNING_ATSHA204_SESSION_MS
+ * @brief Time without signing activity after which the session of the Atsha204a ends.
+ *
+ * See @ref MY_SIGNING_ATSHA204_SESSION.
+ */
+#ifndef MY_SIGNING_ATSHA204_SESSION_MS
+#define MY_SIGNING_ATSHA204_SESSION_MS (200ul)
+#endif
+
 /**
  * @def MY_SIGNING_SOFT_RANDOMSEED_PIN
  * @brief Pin used for random seed generation in soft signing
@@ -1822,7 +3976,7 @@
  * @ingroup internals
  * @brief Helper flag to indicate that some signing feature is enabled, set automatically
  */
-#if defined(MY_SIGNING_ATSHA204) || defined(MY_SIGNING_SOFT)
+#if defined(MY_SIGNING_ATSHA204) || defined(MY_SIGNING_ATECC) || defined(MY_SIGNING_SOFT)
 #define MY_SIGNING_FEATURE
 #endif
 /** @}*/ // End of SigningSettingGrpPub group
@@ -1871,6 +4025,22 @@
 #endif
 #endif
 
+/**
+ * @def MY_ENCRYPTION_CTR
+ * @brief Define this to use %AES-CTR instead of %AES-CBC on the software encrypted transports.
+ *
+ * Only the actual frame is encrypted, so frames are no longer padded to 16 or 32 bytes. Each frame
+ * is prefixed by a 4 byte counter in clear text which is used as nonce. A 9 byte message is sent
+ * as 13 bytes instead of 16 bytes, which saves airtime and power. Frames that would exceed
+ * @ref MAX_MESSAGE_LENGTH with the counter are still sent as 32 byte %AES-CBC frames.
+ *
+ * This changes the frame format, so it has to be identical on ALL nodes in the network. %RFM69
+ * radios encrypt in hardware and are not affected.
+ *
+ * @warning Like %AES-CBC, %AES-CTR does not authenticate the frame, use @ref signing for that.
+ */
+//#define MY_ENCRYPTION_CTR
+
 /**
  * @def MY_ENCRYPTION_FEATURE
  * @ingroup internals
@@ -1953,6 +4123,52 @@
  * @brief These options control platform specific configurations.
  * @{
  */
+/**
+ * @defgroup AVRSettingGrpPub AVR
+ * @ingroup PlatformSettingGrpPub
+ * @brief These options control AVR specific configurations.
+ * @{
+ */
+/**
+ * @def MY_AVR_SLEEP_TIMER2
+ * @brief Time sleep() with Timer2 clocked asynchronously from a 32.768kHz crystal.
+ *
+ * Without it the AVR sleeps on the watchdog, which only knows multiples of 16ms and is off by
+ * up to 10%. With it the node sleeps in power-save mode until a Timer2 compare match, with a
+ * resolution of about 1ms and the accuracy of the crystal, and @ref hwGetSleepRemaining() is
+ * exact after an interrupt wake-up.
+ *
+ * The crystal has to be connected to TOSC1/TOSC2. On the ATmega328P these are the XTAL pins, so
+ * the MCU has to run from its internal RC oscillator. Timer2 is no longer available to the
+ * sketch, e.g. for tone(). The crystal takes about a second to start up, a sleep() right after
+ * power-up may last longer than requested.
+ */
+//#define MY_AVR_SLEEP_TIMER2
+
+/**
+ * @def MY_AVR_TWI_MASTER
+ * @brief Provide TwiMaster, an interrupt driven hardware I2C master for sensors and EEPROMs.
+ *
+ * Transactions are queued with TwiMaster::queue() and run by the TWI interrupt, the callback
+ * is called from the interrupt once done. Meanwhile the node keeps processing messages, e.g.
+ * an EEPROM write cycle or a sensor read overlaps with the radio. The Wire library cannot be
+ * used in the same sketch, SoftI2cMaster can for other pins.
+ */
+//#define MY_AVR_TWI_MASTER
+
+/**
+ * @def MY_AVR_CPU_VOLTAGE_ASYNC
+ * @brief Let the 1.1V Vref of hwCPUVoltage() settle while the node does other work.
+ *
+ * The Vref needs about 70ms to settle once selected, hwCPUVoltage() otherwise spends them in
+ * delay() every time. With this the Vref is selected on every wake-up and by
+ * hwCPUVoltageStart(), hwCPUVoltage() only waits for the part of the 70ms not yet passed and
+ * converts in ADC noise reduction mode, which also lowers the noise of the reading. An
+ * analogRead() in between selects another input, the settling starts again then.
+ */
+//#define MY_AVR_CPU_VOLTAGE_ASYNC
+/** @}*/ // End of AVRSettingGrpPub group
+
 /**
  * @defgroup ESP8266SettingGrpPub ESP8266
  * @ingroup PlatformSettingGrpPub
@@ -1970,6 +4186,19 @@
 #ifndef MY_ESP8266_SERIAL_MODE
 #define MY_ESP8266_SERIAL_MODE SERIAL_FULL
 #endif
+
+/**
+ * @def MY_ESP8266_EEPROM_COMMIT_MS
+ * @brief Time in ms EEPROM writes are collected before EEPROM.commit() writes them to flash.
+ *
+ * With 0 every config write is committed immediately, which erases and writes a flash sector
+ * and stalls the CPU for tens of ms. Otherwise the EEPROM is marked dirty and committed when
+ * the interval expired, before sleeping or rebooting, and when hwFlushConfig() is called.
+ * Up to this many ms of changes are lost on a power loss.
+ */
+#ifndef MY_ESP8266_EEPROM_COMMIT_MS
+#define MY_ESP8266_EEPROM_COMMIT_MS (0u)
+#endif
 /** @}*/ // End of ESP8266SettingGrpPub group
 
 /**
@@ -1978,13 +4207,78 @@
 * @brief These options control ESP32 specific configurations.
 * @{
 */
+/**
+ * @def MY_ESP32_EEPROM_COMMIT_MS
+ * @brief Time in ms EEPROM writes are collected before EEPROM.commit() writes them to flash.
+ *
+ * See @ref MY_ESP8266_EEPROM_COMMIT_MS.
+ */
+#ifndef MY_ESP32_EEPROM_COMMIT_MS
+#define MY_ESP32_EEPROM_COMMIT_MS (0u)
+#endif
+
+/**
+ * @def MY_ESP32_DUAL_CORE_GATEWAY
+ * @brief Run the gateway transport driver (WiFi, Ethernet or MQTT) on its own task on the other core.
+ *
+ * The Arduino loop task keeps the radio, the transport layer and the sketch callbacks on
+ * its core, the controller task is pinned to @ref MY_ESP32_CONTROLLER_CORE next to the WiFi
+ * stack. Messages are passed between the tasks through FreeRTOS queues of
+ * @ref MY_ESP32_DUAL_CORE_GATEWAY_QUEUE_SIZE entries, messages to the controller are dropped
+ * when its queue is full. See @ref MY_LINUX_THREADED_GATEWAY.
+ */
+//#define MY_ESP32_DUAL_CORE_GATEWAY
+
+/**
+ * @def MY_ESP32_DUAL_CORE_GATEWAY_QUEUE_SIZE
+ * @brief Number of slots per direction between the controller task and the core.
+ */
+#ifndef MY_ESP32_DUAL_CORE_GATEWAY_QUEUE_SIZE
+#define MY_ESP32_DUAL_CORE_GATEWAY_QUEUE_SIZE (32u)
+#endif
+
+/**
+ * @def MY_ESP32_CONTROLLER_CORE
+ * @brief Core the controller task of @ref MY_ESP32_DUAL_CORE_GATEWAY is pinned to.
+ *
+ * Defaults to the protocol core, the Arduino loop task runs on the application core.
+ */
+#ifndef MY_ESP32_CONTROLLER_CORE
+#define MY_ESP32_CONTROLLER_CORE (0)
+#endif
 
-//
-// no ESP32 settings
-//
+/**
+ * @def MY_ESP32_CONTROLLER_STACK_SIZE
+ * @brief Stack size in bytes of the controller task of @ref MY_ESP32_DUAL_CORE_GATEWAY.
+ */
+#ifndef MY_ESP32_CONTROLLER_STACK_SIZE
+#define MY_ESP32_CONTROLLER_STACK_SIZE (8192u)
+#endif
 
 /** @}*/ // End of ESP32SettingGrpPub group
 
+/**
+ * @defgroup STM32F1SettingGrpPub STM32F1
+ * @ingroup PlatformSettingGrpPub
+ * @brief These options control STM32F1 specific configurations.
+ * @{
+ */
+
+/**
+ * @def MY_STM32F1_NVRAM
+ * @brief Define this to keep the config in the wear levelled NVRAM store used on nRF5.
+ *
+ * NVRAM (drivers/NVM) appends every changed byte to a log in a virtual page and compacts the
+ * current values into the next page once the log is full, so a write programs a single flash
+ * word and page erases rotate over all virtual pages. This replaces the EEPROM emulation of the
+ * core, which formats itself once more addresses are in use than it can hold.
+ *
+ * The store occupies the top 16k of the flash (see NVM_VIRTUAL_PAGE_COUNT), the sketch must
+ * fit below. The config stored by the EEPROM emulation is not migrated.
+ */
+//#define MY_STM32F1_NVRAM
+/** @}*/ // End of STM32F1SettingGrpPub group
+
 /**
  * @defgroup LinuxSettingGrpPub Linux
  * @ingroup PlatformSettingGrpPub
@@ -2040,6 +4334,154 @@
 #ifndef MY_LINUX_CONFIG_FILE
 #define MY_LINUX_CONFIG_FILE "/etc/mysensors.conf"
 #endif
+
+/**
+ * @def MY_LINUX_EVENT_LOOP_TICK_MS
+ * @brief Interval in ms at which the main loop runs when no sockets, serial or radio interrupts are pending.
+ *
+ * Between ticks the gateway sleeps in epoll until a watched fd becomes readable or an interrupt fires.
+ * A polled radio (RF24 without @ref MY_RF24_IRQ_PIN, RS485) needs a short tick, otherwise
+ * the tick only drives the transport state machine and GW timers. LEDs, inclusion mode, the
+ * sanity check and OTA requests wake the loop at their deadline, see schedulerGetNextMS().
+ */
+#ifndef MY_LINUX_EVENT_LOOP_TICK_MS
+#if (defined(MY_RADIO_RF24) && !defined(MY_RF24_IRQ_PIN)) || defined(MY_RS485)
+#define MY_LINUX_EVENT_LOOP_TICK_MS (10u)
+#else
+#define MY_LINUX_EVENT_LOOP_TICK_MS (50u)
+#endif
+#endif
+
+/**
+ * @def MY_LINUX_EEPROM_FLUSH_MS
+ * @brief Time in ms eeprom writes are collected before they are committed to the eeprom file.
+ *
+ * With 0 every changed block is written to the file immediately. Otherwise the file is memory-mapped,
+ * changes are collected into one dirty range and committed through a write-ahead journal
+ * (<eeprom_file>.journal) when the interval expired and at shutdown. This saves SD cards from
+ * hundreds of small writes when many nodes register at once, and a power loss never leaves a
+ * torn routing table behind. Up to this many ms of changes are lost on a power loss.
+ */
+#ifndef MY_LINUX_EEPROM_FLUSH_MS
+#define MY_LINUX_EEPROM_FLUSH_MS (0u)
+#endif
+
+/**
+ * @def MY_LINUX_ENTROPY_POOL_SIZE
+ * @brief Size in bytes of the pool hwGetentropy() hands out random data from.
+ *
+ * The pool is refilled from the kernel (getrandom(), or /dev/urandom on old kernels) in one call
+ * when it runs empty, so generating signing nonces for many nodes does not cost a syscall each.
+ * Handed out bytes are wiped from the pool.
+ */
+#ifndef MY_LINUX_ENTROPY_POOL_SIZE
+#define MY_LINUX_ENTROPY_POOL_SIZE (256u)
+#endif
+
+/**
+ * @def MY_LINUX_ETHERNET_TX_FLUSH_MS
+ * @brief Maximum time in ms the Ethernet gateway (server mode) holds back data for its clients.
+ *
+ * Messages to each client are coalesced into one send() per flush instead of one TCP segment per
+ * message. With 0 the data is sent on the next main loop iteration, so messages queued in the same
+ * iteration (e.g. a presentation) still go out together.
+ */
+#ifndef MY_LINUX_ETHERNET_TX_FLUSH_MS
+#define MY_LINUX_ETHERNET_TX_FLUSH_MS (0u)
+#endif
+
+/**
+ * @def MY_LINUX_ETHERNET_TX_FLUSH_SIZE
+ * @brief Number of pending bytes per client that triggers a flush before @ref MY_LINUX_ETHERNET_TX_FLUSH_MS expired.
+ */
+#ifndef MY_LINUX_ETHERNET_TX_FLUSH_SIZE
+#define MY_LINUX_ETHERNET_TX_FLUSH_SIZE (1024u)
+#endif
+
+/**
+ * @def MY_LINUX_ETHERNET_UNIX_SOCKET
+ * @brief Also serve controllers on this Unix domain socket (Ethernet gateway in server mode).
+ *
+ * A controller on the same host connects to the socket file instead of the TCP port and speaks
+ * the same protocol, without the TCP/IP stack in between. It takes one of the
+ * @ref MY_GATEWAY_MAX_CLIENTS slots. Access is controlled by the permissions of the file.
+ *
+ * Example: @code #define MY_LINUX_ETHERNET_UNIX_SOCKET "/run/mysensors/mysgw.sock" @endcode
+ */
+//#define MY_LINUX_ETHERNET_UNIX_SOCKET "/run/mysensors/mysgw.sock"
+
+/**
+ * @def MY_LINUX_ETHERNET_SHM_RING
+ * @brief Hand a shared-memory ring to a controller connecting to this Unix domain socket.
+ *
+ * The controller receives a memfd with one ring per direction and two eventfds for the wakeups,
+ * see shmring.h for the layout. The records are raw MyMessage structs, nothing is formatted or
+ * parsed and no syscall is made per message while the other side is busy. One controller is
+ * served at a time, next to the clients of the Ethernet gateway in server mode. Messages to it
+ * are dropped while its ring is full.
+ *
+ * Example: @code #define MY_LINUX_ETHERNET_SHM_RING "/run/mysensors/mysgw.ring" @endcode
+ */
+//#define MY_LINUX_ETHERNET_SHM_RING "/run/mysensors/mysgw.ring"
+
+/**
+ * @def MY_LINUX_ETHERNET_SHM_RING_SLOTS
+ * @brief Messages per direction of @ref MY_LINUX_ETHERNET_SHM_RING, rounded up to a power of two.
+ */
+#ifndef MY_LINUX_ETHERNET_SHM_RING_SLOTS
+#define MY_LINUX_ETHERNET_SHM_RING_SLOTS (256u)
+#endif
+
+/**
+ * @def MY_LINUX_THREADED_GATEWAY
+ * @brief Run the gateway transport driver (Ethernet or MQTT) on its own controller thread.
+ *
+ * The main thread keeps the radio, the transport layer and the sketch callbacks, so a slow
+ * controller or an MQTT reconnect no longer stalls radio reception. Messages are passed between
+ * the threads through bounded queues of @ref MY_LINUX_THREADED_GATEWAY_QUEUE_SIZE entries,
+ * messages to the controller are dropped when its queue is full.
+ */
+//#define MY_LINUX_THREADED_GATEWAY
+
+/**
+ * @def MY_LINUX_THREADED_GATEWAY_QUEUE_SIZE
+ * @brief Number of slots per direction between the controller thread and the core.
+ */
+#ifndef MY_LINUX_THREADED_GATEWAY_QUEUE_SIZE
+#define MY_LINUX_THREADED_GATEWAY_QUEUE_SIZE (32u)
+#endif
+
+/**
+ * @def MY_LINUX_DISABLE_CRYPTO_EXTENSIONS
+ * @brief Always use the software SHA256 and AES128 for signing and encryption.
+ *
+ * On x86_64 and aarch64 the SHA-NI/AES-NI or ARMv8 crypto instructions are used when the CPU
+ * reports them at startup, the binary still runs on CPUs without them.
+ */
+//#define MY_LINUX_DISABLE_CRYPTO_EXTENSIONS
+
+/**
+ * @def MY_LINUX_SIGNING_VERIFY_THREADS
+ * @brief Number of threads verifying the signatures of received messages, 0 or 1 to verify them
+ * on the main thread.
+ *
+ * Requires @ref MY_SIGNING_SOFT and @ref MY_SIGNING_REQUEST_SIGNATURES on a gateway. Up to
+ * @ref MY_LINUX_SIGNING_VERIFY_BATCH received messages are read at once. Their nonces are taken
+ * in order, then the signatures are calculated in parallel, messages of one sender always on the
+ * same thread. The messages are routed in the order received afterwards. With
+ * @ref MY_DEBUG_VERBOSE_SIGNING the output of the threads may interleave.
+ */
+#ifndef MY_LINUX_SIGNING_VERIFY_THREADS
+#define MY_LINUX_SIGNING_VERIFY_THREADS (0u)
+#endif
+
+/**
+ * @def MY_LINUX_SIGNING_VERIFY_BATCH
+ * @brief Maximum number of received messages verified together by @ref MY_LINUX_SIGNING_VERIFY_THREADS.
+ */
+#ifndef MY_LINUX_SIGNING_VERIFY_BATCH
+#define MY_LINUX_SIGNING_VERIFY_BATCH (16u)
+#endif
 /** @}*/ // End of LinuxSettingGrpPub group
 /** @}*/ // End of PlatformSettingGrpPub group
 
@@ -2057,6 +4499,15 @@
 #define MY_GATEWAY_FEATURE
 #define MY_IS_GATEWAY (true)
 #define MY_NODE_TYPE "GW"
+#if defined(MY_LINUX_THREADED_GATEWAY) || defined(MY_ESP32_DUAL_CORE_GATEWAY)
+// the gateway transport driver runs on a controller thread or task of its own
+#define MY_GATEWAY_CONTROLLER_THREAD
+#endif
+#if defined(__linux__) && defined(MY_SIGNING_SOFT) && defined(MY_SIGNING_REQUEST_SIGNATURES) && \
+	MY_LINUX_SIGNING_VERIFY_THREADS > 1
+// received signatures are verified by a pool of threads
+#define MY_SIGNING_PARALLEL_VERIFY
+#endif
 #elif defined(MY_REPEATER_FEATURE)
 #define MY_IS_GATEWAY (false)
 #define MY_NODE_TYPE "REPEATER"
@@ -2071,6 +4522,7 @@
 // DEBUG
 #if defined(MY_DISABLED_SERIAL) && !defined(MY_DEBUG_OTA)
 #undef MY_DEBUG
+#undef MY_DEBUG_TRACE
 #endif
 #if defined(MY_DEBUG)
 // standard debug output
@@ -2082,7 +4534,9 @@
 
 #if defined(MY_DEBUG) || defined(MY_DEBUG_VERBOSE_CORE) || defined(MY_DEBUG_VERBOSE_TRANSPORT) || defined(MY_DEBUG_VERBOSE_GATEWAY) || defined(MY_DEBUG_VERBOSE_SIGNING) || defined(MY_DEBUG_VERBOSE_OTA_UPDATE) || defined(MY_DEBUG_VERBOSE_RF24) || defined(MY_DEBUG_VERBOSE_NRF5_ESB) || defined(MY_DEBUG_VERBOSE_RFM69) || defined(MY_DEBUG_VERBOSE_RFM95) || defined(MY_DEBUG_VERBOSE_TRANSPORT_HAL)
 #define DEBUG_OUTPUT_ENABLED	//!< DEBUG_OUTPUT_ENABLED
-#ifndef MY_DEBUG_OTA
+#if defined(MY_DEBUG_TRACE) && !defined(MY_DEBUG_OTA)
+#define DEBUG_OUTPUT(x,...)		hwDebugTrace(x, ##__VA_ARGS__)	//!< debug
+#elif !defined(MY_DEBUG_OTA)
 #define DEBUG_OUTPUT(x,...)		hwDebugPrint(x, ##__VA_ARGS__)	//!< debug
 #else
 #ifndef MY_OTA_LOG_SENDER_FEATURE
@@ -2102,6 +4556,8 @@
 #endif
 #else
 #define DEBUG_OUTPUT(x,...)								//!< debug NULL
+// nothing to trace
+#undef MY_DEBUG_TRACE
 #endif
 
 // temp. workaround for nRF5 verifier: redirect RF24 to NRF_ESB
@@ -2111,7 +4567,7 @@
 #endif
 
 // Enable sensor network "feature" if one of the transport types was enabled
-#if defined(MY_RADIO_RF24) || defined(MY_RADIO_NRF5_ESB) || defined(MY_RADIO_RFM69) || defined(MY_RADIO_RFM95) || defined(MY_RS485)
+#if defined(MY_RADIO_RF24) || defined(MY_RADIO_NRF5_ESB) || defined(MY_RADIO_RFM69) || defined(MY_RADIO_RFM95) || defined(MY_RS485) || defined(MY_RADIO_SIMULATED) || defined(MY_RADIO_REMOTE)
 #define MY_SENSOR_NETWORK
 #endif
 
@@ -2180,6 +4636,7 @@
 #define MY_DEBUGDEVICE
 #define MY_DEBUG_OTA
 #define MY_DEBUG_OTA_DISABLE_ECHO
+#define MY_DEBUG_TRACE
 #define MY_SPECIAL_DEBUG
 #define MY_DISABLED_SERIAL
 #define MY_SPLASH_SCREEN_DISABLED
@@ -2189,6 +4646,30 @@
 #define MY_LINUX_SERIAL_GROUPNAME
 #define MY_LINUX_SERIAL_PTY
 #define MY_LINUX_IS_SERIAL_PTY
+#define MY_LINUX_EVENT_LOOP_TICK_MS
+#define MY_LINUX_EEPROM_FLUSH_MS
+#define MY_LINUX_ENTROPY_POOL_SIZE
+#define MY_LINUX_ETHERNET_TX_FLUSH_MS
+#define MY_LINUX_ETHERNET_TX_FLUSH_SIZE
+#define MY_LINUX_ETHERNET_UNIX_SOCKET
+#define MY_LINUX_ETHERNET_SHM_RING
+#define MY_LINUX_ETHERNET_SHM_RING_SLOTS
+#define MY_LINUX_THREADED_GATEWAY
+#define MY_LINUX_THREADED_GATEWAY_QUEUE_SIZE
+#define MY_LINUX_DISABLE_CRYPTO_EXTENSIONS
+#define MY_LINUX_SIGNING_VERIFY_THREADS
+#define MY_LINUX_SIGNING_VERIFY_BATCH
+// avr
+#define MY_AVR_SLEEP_TIMER2
+#define MY_AVR_TWI_MASTER
+#define MY_AVR_CPU_VOLTAGE_ASYNC
+// esp32
+#define MY_ESP32_DUAL_CORE_GATEWAY
+#define MY_ESP32_DUAL_CORE_GATEWAY_QUEUE_SIZE
+#define MY_ESP32_CONTROLLER_CORE
+#define MY_ESP32_CONTROLLER_STACK_SIZE
+// stm32f1
+#define MY_STM32F1_NVRAM
 // inclusion mode
 #define MY_INCLUSION_MODE_FEATURE
 #define MY_INCLUSION_BUTTON_FEATURE
@@ -2197,11 +4678,28 @@
 #define MY_OTA_LOG_SENDER_FEATURE
 // transport
 #define MY_PARENT_NODE_IS_STATIC
+#define MY_TRANSPORT_PARENT_CACHE
+#define MY_TRANSPORT_PARENT_LOAD
 #define MY_REGISTRATION_CONTROLLER
+#define MY_REGISTRATION_CACHE
+#define MY_REGISTRATION_CACHE_EPOCH
 #define MY_TRANSPORT_UPLINK_CHECK_DISABLED
+#define MY_TRANSPORT_UPLINK_CHECK_PASSIVE
 #define MY_TRANSPORT_SANITY_CHECK
+#define MY_TRANSPORT_FAST_RECOVERY
+#define MY_TRANSPORT_RECOVERY_BACKOFF_MS
+#define MY_TRANSPORT_SEQUENCE
+#define MY_TRANSPORT_TX_QUEUE_FEATURE
+#define MY_TRANSPORT_TX_QUEUE_PRIORITY
+#define MY_TRANSPORT_PACING
+#define MY_TRANSPORT_AGGREGATION
+#define MY_TRANSPORT_BROADCAST_FLOODING
+#define MY_TRANSPORT_CUT_THROUGH
+#define MY_TRANSPORT_FRAGMENTATION
+#define MY_TRANSPORT_WAKE_ON_RADIO
 #define MY_NODE_LOCK_FEATURE
 #define MY_REPEATER_FEATURE
+#define MY_REPEATER_WAKE_ON_RADIO
 #define MY_PASSIVE_NODE
 #define MY_MQTT_CLIENT_PUBLISH_RETAIN
 #define MY_MQTT_PASSWORD
@@ -2209,15 +4707,43 @@
 #define MY_MQTT_CLIENT_ID
 #define MY_MQTT_PUBLISH_TOPIC_PREFIX
 #define MY_MQTT_SUBSCRIBE_TOPIC_PREFIX
+#define MY_MQTT_CLIENT_BUFFER_SIZE
+#define MY_MQTT_CLIENT_KEEPALIVE_S
+#define MY_MQTT_CLIENT_SOCKET_TIMEOUT_S
+#define MY_MQTT_CLIENT_TLS
+#define MY_MQTT_CLIENT_TLS_CA_CERT
+#define MY_MQTT_CLIENT_TLS_FINGERPRINT
+#define MY_MQTT_CLIENT_TOPIC_CACHE_SIZE
+#define MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS
+#define MY_MQTT_CLIENT_PUBLISH_QOS1
+#define MY_MQTT_CLIENT_QUEUE_SIZE
+#define MY_MQTT_CLIENT_INFLIGHT_WINDOW
+#define MY_MQTT_CLIENT_RX_QUEUE_SIZE
 #define MY_SIGNAL_REPORT_ENABLED
 // general
 #define MY_WITH_LEDS_BLINKING_INVERSE
+#define MY_WITH_LEDS_BLINKING_TIMER
 #define MY_INDICATION_HANDLER
 #define MY_DISABLE_REMOTE_RESET
 #define MY_DISABLE_RAM_ROUTING_TABLE_FEATURE
 #define MY_LOCK_DEVICE
 // core
 #define MY_CORE_ONLY
+#define MY_CORE_PROCESS_STATS
+#define MY_STATS_FEATURE
+#define MY_STATS_LATENCY
+#define MY_STATS_LINK_SLOTS
+#define MY_PROFILING
+#define MY_ENERGY_ACCOUNTING
+#define MY_ENERGY_REPORT_CYCLES
+#define MY_ENERGY_CURRENT_AWAKE_UA
+#define MY_ENERGY_CURRENT_TX_UA
+#define MY_ENERGY_CURRENT_RX_UA
+#define MY_SHARED_BUFFERS
+#define MY_SEND_DEADBAND
+#define MY_PRESENTATION_DIGEST
+#define MY_SMART_SLEEP_GATEWAY_RELEASE
+#define MY_WAIT_IDLE
 // GW
 #define MY_DEBUG_VERBOSE_GATEWAY
 #define MY_INCLUSION_BUTTON_EXTERNAL_PULLUP
@@ -2234,18 +4760,40 @@
 #define MY_GATEWAY_TINYGSM
 #define MY_GATEWAY_MQTT_CLIENT
 #define MY_GATEWAY_SERIAL
+#define MY_GATEWAY_BINARY_FRAMING
+#define MY_GATEWAY_SERIAL_BUFFERED
+#define MY_GATEWAY_CLIENT_FILTER
 #define MY_IP_ADDRESS
 #define MY_IP_GATEWAY_ADDRESS
 #define MY_IP_SUBNET_ADDRESS
 #define MY_USE_UDP
 #define MY_CONTROLLER_IP_ADDRESS
 #define MY_CONTROLLER_URL_ADDRESS
+#define MY_GATEWAY_MAILBOX
+#define MY_GATEWAY_PRESENTATION_CACHE
+#define MY_GATEWAY_OUTBOX
+#define MY_GATEWAY_FIRMWARE_SERVER
+#define MY_GATEWAY_STANDBY
+#define MY_GATEWAY_ID_ALLOCATOR
+#define MY_GATEWAY_TIME_BEACON
+#define MY_GATEWAY_FLOW_CONTROL
 // TinyGSM
 /**
  * @def MY_GSM_APN
  * @brief APN from your cell carrier / mobile provider. Example: 4g.tele2.se
  */
 #define MY_GSM_APN
+/**
+ * @def MY_GSM_ASYNC
+ * @brief Drive a SIM800, SIM900, SIM808 or SIM868 without blocking the radio.
+ *
+ * The AT commands are queued and their responses matched in time slices of
+ * @ref MY_GSM_ASYNC_SLICE_MS from gatewayTransportAvailable(): registration, GPRS, the
+ * broker connection and the socket data go on in the background instead of waiting up to
+ * several seconds per command. The MQTT CONNECT handshake itself still waits for the
+ * broker. Requires @ref MY_GSM_BAUDRATE to skip the blocking baud rate detection.
+ */
+#define MY_GSM_ASYNC
 /**
  * @def MY_GSM_BAUDRATE
  * @brief Baudrate for your GSM modem. If left undefined, TinyGSM will try to auto detect the correct rate
@@ -2276,6 +4824,15 @@
  * @brief If defined, uses softSerial using defined pins (must also define MY_GSM_RX)
  */
 #define MY_GSM_TX
+/**
+ * @def MY_GSM_UART_DMA
+ * @brief Receive from the modem by DMA into a buffer of @ref MY_UART_DMA_RX_BUFFER_SIZE bytes.
+ *
+ * STM32F1 only, SerialAT has to be Serial1, Serial2 or Serial3. Nothing is lost while the
+ * gateway is busy with signing or the radio for less than the buffer lasts, so the modem can
+ * run at 115200 baud and above. Overruns are logged as !GWT:TSA:UART OVR.
+ */
+#define MY_GSM_UART_DMA
 /**
  * @def MY_GSM_USR
  * @brief Supplied by your cell carrier / mobile operator. If not required, leave undefined.
@@ -2290,10 +4847,20 @@
 #define MY_SECURITY_SIMPLE_PASSWD
 #define MY_SIGNING_SIMPLE_PASSWD
 #define MY_ENCRYPTION_SIMPLE_PASSWD
+#define MY_ENCRYPTION_CTR
 #define MY_SIGNING_ATSHA204
+#define MY_SIGNING_ATSHA204_SERIAL
+#define MY_SIGNING_ATSHA204_SESSION
+#define MY_SIGNING_ATECC
 #define MY_SIGNING_SOFT
 #define MY_SIGNING_REQUEST_SIGNATURES
 #define MY_SIGNING_WEAK_SECURITY
+#define MY_SIGNING_NONCE_PREFETCH
+#define MY_SIGNING_NONCE_POOL
+#define MY_SIGNING_NONCE_POOL_SIZE
+#define MY_SIGNING_NONCE_POOL_MAX_AGE_MS
+#define MY_SIGNING_TAG_SIZE
+#define MY_SIGNING_ASYNC
 #define MY_SIGNING_NODE_WHITELISTING
 #define MY_DEBUG_VERBOSE_SIGNING
 #define MY_SIGNING_FEATURE
@@ -2301,9 +4868,33 @@
 // FOTA update
 #define MY_DEBUG_VERBOSE_OTA_UPDATE
 #define MY_OTA_USE_I2C_EEPROM
+#define MY_OTA_WINDOW_SIZE
+#define MY_OTA_LZ_BLOCKS
+#define MY_OTA_DELTA
+#define MY_OTA_MULTICAST
+#define MY_OTA_VERIFY_FLASH
+#define MY_OTA_RESUME
 // RS485
 #define MY_RS485
 #define MY_RS485_HWSERIAL
+#define MY_RS485_KERNEL_DE
+#define MY_RS485_TDMA
+#define MY_RS485_CRC16
+// Simulated radio
+#define MY_RADIO_SIMULATED
+#define MY_RADIO_SIMULATED_GROUP
+#define MY_RADIO_SIMULATED_PORT
+#define MY_RADIO_SIMULATED_ACK_TIMEOUT_MS
+#define MY_RADIO_SIMULATED_RETRIES
+#define MY_RADIO_SIMULATED_RX_QUEUE_SIZE
+#define MY_RADIO_REMOTE
+#define MY_RADIO_REMOTE_COPROCESSOR
+#define MY_RADIO_REMOTE_SERIAL
+#define MY_RADIO_REMOTE_BAUD_RATE
+#define MY_RADIO_REMOTE_TIMEOUT_MS
+#define MY_RADIO_REMOTE_INIT_TIMEOUT_MS
+#define MY_RADIO_REMOTE_RX_QUEUE_SIZE
+#define MY_RADIO_REMOTE_RX_BATCH
 // RF24
 #define MY_RADIO_RF24
 #define MY_RADIO_NRF24 //deprecated
@@ -2311,14 +4902,27 @@
 #define MY_RF24_POWER_PIN
 #define MY_RF24_IRQ_PIN
 #define MY_RF24_ENABLE_ENCRYPTION
+#define MY_RF24_ATC_MODE
+#define MY_RF24_ACK_PAYLOAD
+#define MY_RF24_ACK_PAYLOAD_SLOTS
+#define MY_RF24_LINK_DATARATE
+#define MY_RF24_LINK_DATARATE_DWELL_MS
+#define MY_RF24_LINK_DATARATE_PROBE
 #define MY_RX_MESSAGE_BUFFER_FEATURE
 #define MY_RX_MESSAGE_BUFFER_SIZE
+#define MY_ROUTING_TABLE_BACKUP_ROUTES
+#define MY_NODE_ID_16BIT
+#define MY_TRANSPORT_DIRECT_CACHE
+#define MY_TRANSPORT_DUPLICATE_FILTER
+#define MY_TRANSPORT_RECEIPTS
+#define MY_TRANSPORT_DUTY_CYCLE_FEATURE
 // NRF5_ESB
 #define MY_RADIO_NRF5_ESB
 #define MY_NRF5_ESB_ENABLE_ENCRYPTION
 #define MY_DEBUG_VERBOSE_NRF5_ESB
 #define MY_NRF5_ESB_REVERSE_ACK_RX
 #define MY_NRF5_ESB_REVERSE_ACK_TX
+#define MY_NRF5_ESB_ATC_MODE
 // RFM69
 #define MY_RADIO_RFM69
 #define MY_IS_RFM69HW
@@ -2329,6 +4933,7 @@
 #define MY_RFM69_ATC_MODE_DISABLED
 #define MY_RFM69_MAX_POWER_LEVEL_DBM
 #define MY_RFM69_RST_PIN
+#define MY_RFM69_ENABLE_LISTENMODE
 #define MY_DEBUG_VERBOSE_RFM69
 #define MY_DEBUG_VERBOSE_RFM69_REGISTERS
 // RFM95
@@ -2341,7 +4946,10 @@
 #define MY_RFM95_POWER_PIN
 #define MY_RFM95_TCXO
 #define MY_RFM95_MAX_POWER_LEVEL_DBM
+#define MY_RFM95_IMPLICIT_ACK
+#define MY_RFM95_SHORT_PREAMBLE_LENGTH
 // SOFT-SPI
 #define MY_SOFTSPI
+#define MY_SPI_DMA
 #endif
 /** @}*/ // End of MyConfig group
@@ -46,11 +46,44 @@
 #include "core/MySplashScreen.h"
 #include "core/MySensorsCore.h"
 
+// STATISTICS, counted from the HAL on
+#if defined(MY_STATS_LATENCY) && !defined(MY_STATS_FEATURE)
+#error MY_STATS_LATENCY requires MY_STATS_FEATURE
+#endif
+#include "core/MyStats.h"
+
+// PROFILING, probes from the HAL on
+#include "core/MyProfiling.h"
+
+// ENERGY, accounted from the HAL on
+#include "core/MyEnergy.h"
+
+// SCHEDULER, deadlines of the periodic core work
+#include "core/MyScheduler.h"
+
+// SHARED BUFFERS, overlaid from the HAL on
+#if defined(MY_SHARED_BUFFERS) && defined(MY_GATEWAY_CONTROLLER_THREAD)
+#error MY_SHARED_BUFFERS cannot be used with a gateway controller thread
+#endif
+#include "core/MySharedBuffers.h"
+
 // OTA Debug, has to be defined before HAL
 #if defined(MY_OTA_LOG_SENDER_FEATURE) || defined(MY_OTA_LOG_RECEIVER_FEATURE)
 #include "core/MyOTALogging.h"
 #endif
 
+#if defined(MY_DEBUG_TRACE)
+#if defined(MY_GATEWAY_SERIAL)
+#error MY_DEBUG_TRACE is not supported on serial gateways
+#endif
+#if defined(MY_DEBUG_OTA)
+#error MY_DEBUG_TRACE and MY_DEBUG_OTA cannot be used together
+#endif
+#if defined(__linux__)
+#error MY_DEBUG_TRACE is not supported on Linux, use the log file instead
+#endif
+#endif
+
 // HARDWARE
 #include "hal/architecture/MyHwHAL.h"
 #include "hal/crypto/MyCryptoHAL.h"
@@ -62,6 +95,9 @@
 #include "hal/crypto/ESP32/MyCryptoESP32.cpp"
 #elif defined(ARDUINO_ARCH_AVR)
 #include "hal/architecture/AVR/MyHwAVR.cpp"
+#if defined(MY_AVR_TWI_MASTER)
+#include "hal/architecture/AVR/drivers/DigitalIO/TwiMaster.cpp"
+#endif
 #include "hal/crypto/AVR/MyCryptoAVR.cpp"
 #elif defined(ARDUINO_ARCH_SAMD)
 #include "drivers/extEEPROM/extEEPROM.cpp"
@@ -72,7 +108,7 @@
 #include "hal/crypto/generic/MyCryptoGeneric.cpp"
 #elif defined(ARDUINO_ARCH_NRF5) || defined(ARDUINO_ARCH_NRF52)
 #include "hal/architecture/NRF5/MyHwNRF5.cpp"
-#include "hal/crypto/generic/MyCryptoGeneric.cpp"
+#include "hal/crypto/NRF5/MyCryptoNRF5.cpp"
 #elif defined(__arm__) && defined(TEENSYDUINO)
 #include "hal/architecture/Teensy3/MyHwTeensy3.cpp"
 #include "hal/crypto/generic/MyCryptoGeneric.cpp"
@@ -86,6 +122,13 @@
 #include "hal/architecture/MyHwHAL.cpp"
 
 // commonly used macros, sometimes missing in arch definitions
+#if !defined(MY_HW_HAS_FLUSH_CONFIG)
+#define hwFlushConfig()		//!< config writes are not deferred
+#define hwFlushConfigIfDue()	//!< config writes are not deferred
+#endif
+#if !defined(MY_HW_HAS_IDLE)
+#define hwIdle(__ms)	//!< no idle sleep, waits keep polling
+#endif
 #if !defined(_BV)
 #define _BV(x) (1<<(x))	//!< _BV
 #endif
@@ -106,6 +149,24 @@
 #define MAX max //!< MAX
 #endif
 
+// STATISTICS second part, latencies depend on HAL
+#if defined(MY_STATS_FEATURE)
+#include "core/MyStats.cpp"
+#endif
+
+// PROFILING second part, depends on HAL
+#if defined(MY_PROFILING)
+#include "core/MyProfiling.cpp"
+#endif
+
+// ENERGY second part, depends on HAL
+#if defined(MY_ENERGY_ACCOUNTING)
+#include "core/MyEnergy.cpp"
+#endif
+
+// SCHEDULER second part, depends on HAL
+#include "core/MyScheduler.cpp"
+
 // OTA Debug second part, depends on HAL
 #if defined(MY_OTA_LOG_SENDER_FEATURE) || defined(MY_OTA_LOG_RECEIVER_FEATURE)
 #include "core/MyOTALogging.cpp"
@@ -142,13 +203,37 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #if defined(MY_SIGNING_ATSHA204) && defined(__linux__)
 #error No support for ATSHA204 on this platform
 #endif
+#if defined(MY_SIGNING_ATECC) && (defined(MY_SIGNING_ATSHA204) || defined(MY_SIGNING_SOFT))
+#error Only one signing engine can be activated
+#endif
+#if defined(MY_SIGNING_ATECC) && defined(__linux__)
+#error No support for ATECC on this platform
+#endif
+#if defined(MY_SIGNING_NONCE_POOL) && !defined(MY_SIGNING_SOFT)
+#error MY_SIGNING_NONCE_POOL is only supported by the soft signing backend
+#endif
+#if defined(MY_SIGNING_NONCE_POOL) && (MY_SIGNING_NONCE_POOL_SIZE < 1 || MY_SIGNING_NONCE_POOL_SIZE > 255)
+#error MY_SIGNING_NONCE_POOL_SIZE must be 1..255
+#endif
 
 #if defined(MY_SIGNING_ATSHA204)
 #include "core/MySigningAtsha204.cpp"
 #include "drivers/ATSHA204/ATSHA204.cpp"
+#elif defined(MY_SIGNING_ATECC)
+#include "core/MySigningAtecc.cpp"
+#include "drivers/ATECC/ATECC.cpp"
 #elif defined(MY_SIGNING_SOFT)
 #include "core/MySigningAtsha204Soft.cpp"
 #endif
+#if defined(MY_SIGNING_PARALLEL_VERIFY)
+#if defined(MY_SHARED_BUFFERS)
+#error MY_SHARED_BUFFERS cannot be used with MY_LINUX_SIGNING_VERIFY_THREADS
+#endif
+#if MY_LINUX_SIGNING_VERIFY_BATCH < 1 || MY_LINUX_SIGNING_VERIFY_BATCH > 255
+#error MY_LINUX_SIGNING_VERIFY_BATCH must be 1..255
+#endif
+#include "core/MySigningVerifyThreads.cpp"
+#endif
 #endif
 
 // FLASH
@@ -172,6 +257,11 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #error You must specify MY_CONTROLLER_IP_ADDRESS or MY_CONTROLLER_URL_ADDRESS for UDP
 #endif
 
+#if defined(MY_GATEWAY_CLIENT_FILTER) && (defined(MY_GATEWAY_CLIENT_MODE) || \
+        !(defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32) || defined(MY_GATEWAY_LINUX)))
+#error MY_GATEWAY_CLIENT_FILTER requires the ESP8266, ESP32 or Linux Ethernet gateway in server mode
+#endif
+
 
 
 // Set MQTT defaults if not set
@@ -208,7 +298,29 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #include "core/MyGatewayTransport.cpp"
 #include "core/MyProtocol.cpp"
 
-#if defined(MY_GATEWAY_TINYGSM)
+#if defined(MY_GSM_UART_DMA)
+#if !defined(MY_GATEWAY_TINYGSM) || !defined(ARDUINO_ARCH_STM32F1) || defined(MY_GSM_RX)
+#error MY_GSM_UART_DMA needs MY_GATEWAY_TINYGSM on a STM32F1 with a hardware SerialAT
+#endif
+#if MY_UART_DMA_RX_BUFFER_SIZE > 65535
+#error MY_UART_DMA_RX_BUFFER_SIZE must not exceed 65535
+#endif
+#include "hal/architecture/STM32F1/drivers/UartRxDMA.cpp"
+#endif
+
+#if defined(MY_GSM_ASYNC) && !defined(MY_GATEWAY_TINYGSM)
+#error MY_GSM_ASYNC only works with MY_GATEWAY_TINYGSM
+#endif
+
+#if defined(MY_GSM_ASYNC)
+#if !defined(TINY_GSM_MODEM_SIM800) && !defined(TINY_GSM_MODEM_SIM900) && !defined(TINY_GSM_MODEM_SIM808) && !defined(TINY_GSM_MODEM_SIM868)
+#error MY_GSM_ASYNC is only supported on SIM800, SIM900, SIM808 and SIM868 modems
+#endif
+#if !defined(MY_GSM_BAUDRATE)
+#error MY_GSM_ASYNC needs MY_GSM_BAUDRATE, the baud rate detection blocks
+#endif
+#include "drivers/TinyGSM/TinyGsmClientSIM800Async.h"
+#elif defined(MY_GATEWAY_TINYGSM)
 #include "drivers/TinyGSM/TinyGsmClient.h"
 #endif
 
@@ -217,6 +329,15 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #include "hal/architecture/Linux/drivers/core/EthernetServer.h"
 #include "hal/architecture/Linux/drivers/core/IPAddress.h"
 #endif
+
+#if defined(MY_MQTT_CLIENT_TLS)
+#if !defined(MY_GATEWAY_ESP8266) && !defined(MY_GATEWAY_ESP32)
+#error MY_MQTT_CLIENT_TLS is only supported on ESP8266 and ESP32 gateways
+#endif
+#if defined(MY_GATEWAY_ESP32)
+#include <WiFiClientSecure.h>
+#endif
+#endif
 #include "drivers/PubSubClient/PubSubClient.cpp"
 #include "core/MyGatewayTransportMQTTClient.cpp"
 #elif defined(MY_GATEWAY_FEATURE)
@@ -236,11 +357,14 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #elif defined(MY_GATEWAY_LINUX)
 // GATEWAY - Generic Linux
 #if defined(MY_USE_UDP)
-#error UDP mode is not available for Linux
+#include "hal/architecture/Linux/drivers/core/EthernetUDP.h"
 #endif
 #include "hal/architecture/Linux/drivers/core/EthernetClient.h"
 #include "hal/architecture/Linux/drivers/core/EthernetServer.h"
 #include "hal/architecture/Linux/drivers/core/IPAddress.h"
+#if defined(MY_LINUX_ETHERNET_SHM_RING)
+#include "hal/architecture/Linux/drivers/core/shmring.h"
+#endif
 #include "core/MyGatewayTransportEthernet.cpp"
 #elif defined(MY_GATEWAY_W5100)
 // GATEWAY - W5100
@@ -257,6 +381,80 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #endif
 #endif
 
+#if defined(MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS)
+#if !defined(MY_GATEWAY_MQTT_CLIENT) || !defined(MY_MQTT_CLIENT_PUBLISH_RETAIN)
+#error MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS requires MY_GATEWAY_MQTT_CLIENT and MY_MQTT_CLIENT_PUBLISH_RETAIN
+#endif
+#if MY_MQTT_CLIENT_TOPIC_CACHE_SIZE == 0
+#error MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS requires MY_MQTT_CLIENT_TOPIC_CACHE_SIZE > 0
+#endif
+#endif
+
+#if defined(MY_GATEWAY_FIRMWARE_SERVER) && !defined(__linux__)
+#error MY_GATEWAY_FIRMWARE_SERVER is only supported on Linux
+#endif
+
+#if defined(MY_GATEWAY_OUTBOX)
+#if !defined(__linux__)
+#error MY_GATEWAY_OUTBOX is only supported on Linux
+#endif
+#if MY_GATEWAY_OUTBOX_SIZE > 255 || MY_GATEWAY_OUTBOX_SIZE < 1
+#error MY_GATEWAY_OUTBOX_SIZE must be between 1 and 255
+#endif
+#endif
+
+#if defined(MY_GATEWAY_STANDBY)
+#if !defined(MY_GATEWAY_LINUX)
+#error MY_GATEWAY_STANDBY is only supported on the Linux gateway
+#endif
+#if !defined(MY_SENSOR_NETWORK)
+#error MY_GATEWAY_STANDBY requires a radio
+#endif
+#if MY_GATEWAY_STANDBY_TIMEOUT_MS <= MY_GATEWAY_STANDBY_HEARTBEAT_MS
+#error MY_GATEWAY_STANDBY_TIMEOUT_MS must be longer than MY_GATEWAY_STANDBY_HEARTBEAT_MS
+#endif
+#endif
+
+#if defined(MY_LINUX_ETHERNET_UNIX_SOCKET) || defined(MY_LINUX_ETHERNET_SHM_RING)
+#if !defined(MY_GATEWAY_LINUX) || defined(MY_GATEWAY_MQTT_CLIENT) || defined(MY_GATEWAY_CLIENT_MODE)
+#error MY_LINUX_ETHERNET_UNIX_SOCKET and MY_LINUX_ETHERNET_SHM_RING require the Linux Ethernet gateway in server mode
+#endif
+#endif
+
+#if defined(MY_GATEWAY_SECONDARY_TCP_PORT)
+#if !defined(__linux__)
+#error MY_GATEWAY_SECONDARY_TCP_PORT is only supported on Linux
+#endif
+#if !defined(MY_GATEWAY_MQTT_CLIENT) && !defined(MY_GATEWAY_SERIAL)
+#error MY_GATEWAY_SECONDARY_TCP_PORT requires the MQTT or serial gateway
+#endif
+#if defined(MY_GATEWAY_SERIAL) && !defined(MY_GATEWAY_MQTT_CLIENT)
+#include "hal/architecture/Linux/drivers/core/EthernetClient.h"
+#include "hal/architecture/Linux/drivers/core/EthernetServer.h"
+#endif
+#include "core/MyGatewayTransportSecondary.cpp"
+#endif
+
+#if defined(MY_LINUX_THREADED_GATEWAY)
+#if !defined(MY_GATEWAY_LINUX)
+#error MY_LINUX_THREADED_GATEWAY requires MY_GATEWAY_LINUX (Ethernet or MQTT gateway)
+#endif
+#include "core/MyGatewayTransportThread.cpp"
+#endif
+
+#if defined(MY_ESP32_DUAL_CORE_GATEWAY)
+#if !defined(ARDUINO_ARCH_ESP32)
+#error MY_ESP32_DUAL_CORE_GATEWAY is only supported on ESP32
+#endif
+#if defined(CONFIG_FREERTOS_UNICORE)
+#error MY_ESP32_DUAL_CORE_GATEWAY requires a dual core ESP32
+#endif
+#if !defined(MY_GATEWAY_ESP32) && !defined(MY_GATEWAY_MQTT_CLIENT)
+#error MY_ESP32_DUAL_CORE_GATEWAY requires MY_GATEWAY_ESP32 or MY_GATEWAY_MQTT_CLIENT
+#endif
+#include "core/MyGatewayTransportTaskESP32.cpp"
+#endif
+
 // TRANSPORT
 #ifndef DOXYGEN
 // count enabled transports
@@ -286,7 +484,19 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #define __RS485CNT 0	//!< __RS485CNT
 #endif
 
-#if (__RF24CNT + __NRF5ESBCNT + __RFM69CNT + __RFM95CNT + __RS485CNT > 1)
+#if defined(MY_RADIO_SIMULATED)
+#define __SIMULATEDCNT 1	//!< __SIMULATEDCNT
+#else
+#define __SIMULATEDCNT 0	//!< __SIMULATEDCNT
+#endif
+
+#if defined(MY_RADIO_REMOTE)
+#define __REMOTECNT 1	//!< __REMOTECNT
+#else
+#define __REMOTECNT 0	//!< __REMOTECNT
+#endif
+
+#if (__RF24CNT + __NRF5ESBCNT + __RFM69CNT + __RFM95CNT + __RS485CNT + __SIMULATEDCNT + __REMOTECNT > 1)
 #error Only one forward link driver can be activated
 #endif
 #endif //DOXYGEN
@@ -296,8 +506,27 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #define MY_TRANSPORT_SANITY_CHECK		//!< enable regular transport sanity checks
 #endif
 
+// WAKE-ON-RADIO
+#if defined(MY_REPEATER_WAKE_ON_RADIO)
+#if defined(MY_GATEWAY_FEATURE)
+#error MY_REPEATER_WAKE_ON_RADIO cannot be set on a GW
+#endif
+#define MY_TRANSPORT_WAKE_ON_RADIO		//!< repeaters relay to other duty-cycled repeaters
+#endif
+#if defined(MY_RFM69_ENABLE_LISTENMODE)
+#if !defined(MY_RADIO_RFM69) || !defined(MY_RFM69_NEW_DRIVER)
+#error MY_RFM69_ENABLE_LISTENMODE requires MY_RADIO_RFM69 and MY_RFM69_NEW_DRIVER
+#endif
+#if defined(MY_GATEWAY_FEATURE) || defined(MY_REPEATER_FEATURE)
+#error MY_RFM69_ENABLE_LISTENMODE is for sleeping nodes, not a GW or repeater
+#endif
+#if defined(MY_RFM69_POWER_PIN)
+#error MY_RFM69_ENABLE_LISTENMODE keeps the radio powered, MY_RFM69_POWER_PIN cannot be set
+#endif
+#endif
+
 // TRANSPORT INCLUDES
-#if defined(MY_RADIO_RF24) || defined(MY_RADIO_NRF5_ESB) || defined(MY_RADIO_RFM69) || defined(MY_RADIO_RFM95) || defined(MY_RS485)
+#if defined(MY_RADIO_RF24) || defined(MY_RADIO_NRF5_ESB) || defined(MY_RADIO_RFM69) || defined(MY_RADIO_RFM95) || defined(MY_RS485) || defined(MY_RADIO_SIMULATED) || defined(MY_RADIO_REMOTE)
 #include "hal/transport/MyTransportHAL.h"
 #include "core/MyTransport.h"
 
@@ -306,6 +535,23 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #error Parent is static but no parent ID defined, set MY_PARENT_NODE_ID.
 #endif
 
+#if defined(MY_TRANSPORT_PARENT_LOAD) && (MY_TRANSPORT_PARENT_LOAD_WEIGHT > 1000)
+#error MY_TRANSPORT_PARENT_LOAD_WEIGHT must not exceed 1000, ten hops
+#endif
+
+#if defined(MY_GATEWAY_SERIAL_BUFFERED) && !defined(MY_GATEWAY_SERIAL)
+#error MY_GATEWAY_SERIAL_BUFFERED requires MY_GATEWAY_SERIAL
+#endif
+#if defined(MY_GATEWAY_FLOW_CONTROL) && !defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+#error MY_GATEWAY_FLOW_CONTROL requires MY_TRANSPORT_TX_QUEUE_FEATURE
+#endif
+#if defined(MY_TRANSPORT_PACING) && !defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+#error MY_TRANSPORT_PACING requires MY_TRANSPORT_TX_QUEUE_FEATURE
+#endif
+#if defined(MY_TRANSPORT_PACING) && defined(MY_GATEWAY_FEATURE)
+#error MY_TRANSPORT_PACING paces the uplink of a node, it cannot be set on a GW
+#endif
+
 #if defined(MY_TRANSPORT_DONT_CARE_MODE)
 #error MY_TRANSPORT_DONT_CARE_MODE is deprecated, set MY_TRANSPORT_WAIT_READY_MS instead!
 #endif
@@ -325,6 +571,29 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #endif // __avr_atmega1280__, __avr_atmega1284__, __avr_atmega2560__
 #endif // ARDUINO_ARCH_AVR
 #endif
+#if defined(MY_ROUTING_TABLE_BACKUP_ROUTES) && defined(MY_REPEATER_FEATURE) && !defined(MY_RAM_ROUTING_TABLE_ENABLED)
+#error MY_ROUTING_TABLE_BACKUP_ROUTES requires the RAM routing table
+#endif
+#if defined(MY_ROUTING_TABLE_BACKUP_ROUTES) && !defined(MY_REPEATER_FEATURE)
+#undef MY_ROUTING_TABLE_BACKUP_ROUTES
+#endif
+#if defined(MY_TRANSPORT_CUT_THROUGH) && !defined(MY_REPEATER_FEATURE)
+#undef MY_TRANSPORT_CUT_THROUGH
+#endif
+#if defined(MY_NODE_ID_16BIT)
+#if defined(MY_RADIO_NRF5_ESB) || defined(MY_RADIO_RFM69) || defined(MY_RADIO_RFM95) || defined(MY_RS485) || defined(MY_GATEWAY_SECONDARY_RFM95)
+#error MY_NODE_ID_16BIT is only supported by the RF24 and simulated radios
+#endif
+#if defined(MY_SIGNING_FEATURE)
+#error MY_NODE_ID_16BIT cannot be combined with signing, its requirement tables are per 8 bit node id
+#endif
+#if defined(MY_TRANSPORT_WAKE_ON_RADIO)
+#error MY_NODE_ID_16BIT cannot be combined with MY_TRANSPORT_WAKE_ON_RADIO
+#endif
+#if MY_ROUTING_TABLE_SIZE < 8 || MY_ROUTING_TABLE_SIZE > 4096
+#error MY_ROUTING_TABLE_SIZE must be 8..4096
+#endif
+#endif
 #ifdef DOXYGEN
 /**
  * @def MY_RAM_ROUTING_TABLE_ENABLED
@@ -371,6 +640,12 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #endif
 #include "drivers/AltSoftSerial/AltSoftSerial.cpp"
 #endif
+#if defined(MY_RS485_KERNEL_DE) && (!defined(__linux__) || defined(MY_RS485_DE_PIN))
+#error MY_RS485_KERNEL_DE needs Linux and replaces MY_RS485_DE_PIN
+#endif
+#if defined(MY_RS485_TDMA) && MY_RS485_TDMA_SLOTS < 2
+#error MY_RS485_TDMA needs at least 2 slots, one for the GW and one for the nodes
+#endif
 #include "hal/transport/RS485/MyTransportRS485.cpp"
 #elif defined(MY_RADIO_RFM69)
 #if defined(MY_RFM69_NEW_DRIVER)
@@ -382,14 +657,78 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #elif defined(MY_RADIO_RFM95)
 #include "hal/transport/RFM95/driver/RFM95.cpp"
 #include "hal/transport/RFM95/MyTransportRFM95.cpp"
+#elif defined(MY_RADIO_SIMULATED)
+#if !defined(__linux__)
+#error The simulated radio is only supported on Linux
+#endif
+#include "hal/transport/Simulated/MyTransportSimulated.cpp"
+#elif defined(MY_RADIO_REMOTE)
+#if !defined(__linux__)
+#error The remote radio is only supported on Linux, the coprocessor uses MY_RADIO_REMOTE_COPROCESSOR
+#endif
+#include "hal/transport/Remote/driver/RemoteRadio.cpp"
+#include "hal/transport/Remote/MyTransportRemote.cpp"
+#endif
+
+#if defined(MY_RADIO_REMOTE_COPROCESSOR)
+#if !defined(MY_CORE_ONLY)
+#error MY_RADIO_REMOTE_COPROCESSOR requires MY_CORE_ONLY, the host runs the transport
+#endif
+#if !defined(MY_SENSOR_NETWORK) || defined(MY_RADIO_REMOTE)
+#error MY_RADIO_REMOTE_COPROCESSOR requires the radio of the coprocessor
+#endif
+#include "hal/transport/Remote/driver/RemoteRadio.cpp"
+#if (REMOTE_RADIO_RX_HEADER + MY_RADIO_REMOTE_RX_BATCH * (REMOTE_RADIO_RX_FRAME + MAX_MESSAGE_LENGTH) > REMOTE_RADIO_MAX_PAYLOAD)
+#error MY_RADIO_REMOTE_RX_BATCH exceeds a frame of the serial link
+#endif
+#include "hal/transport/Remote/MyRemoteRadioCoprocessor.cpp"
+#endif
+
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+#if !defined(MY_GATEWAY_FEATURE)
+#error MY_GATEWAY_SECONDARY_RFM95 is only supported on gateways
+#endif
+#if !defined(MY_RADIO_RF24) && !defined(MY_RS485) && !defined(MY_RADIO_SIMULATED)
+#error MY_GATEWAY_SECONDARY_RFM95 requires the RF24, RS485 or simulated radio as first radio
+#endif
+#include "hal/transport/RFM95/driver/RFM95.cpp"
+#include "hal/transport/RFM95/MyTransportRFM95Secondary.cpp"
 #endif
 
 #if (defined(MY_RF24_ENABLE_ENCRYPTION) && defined(MY_RADIO_RF24)) || (defined(MY_NRF5_ESB_ENABLE_ENCRYPTION) && defined(MY_RADIO_NRF5_ESB)) || (defined(MY_RFM69_ENABLE_ENCRYPTION) && defined(MY_RADIO_RFM69)) || (defined(MY_RFM95_ENABLE_ENCRYPTION) && defined(MY_RADIO_RFM95))
 #define MY_TRANSPORT_ENCRYPTION //!< ïnternal flag
 #endif
 
+#if defined(MY_NRF5_ESB_ACK_PAYLOAD) && defined(MY_RADIO_NRF5_ESB)
+#if defined(MY_TRANSPORT_ENCRYPTION) || defined(MY_SIGNING_FEATURE)
+#error MY_NRF5_ESB_ACK_PAYLOAD cannot be combined with encryption or signing
+#endif
+#endif
+
+#if defined(MY_RF24_ACK_PAYLOAD) && defined(MY_RADIO_RF24)
+#if defined(MY_TRANSPORT_ENCRYPTION) || defined(MY_SIGNING_FEATURE)
+#error MY_RF24_ACK_PAYLOAD cannot be combined with encryption or signing
+#endif
+#endif
+
+#if defined(MY_RF24_LINK_DATARATE) && defined(MY_RADIO_RF24)
+#if MY_RF24_LINK_DATARATE == MY_RF24_DATARATE
+#error MY_RF24_LINK_DATARATE must differ from MY_RF24_DATARATE
+#endif
+#endif
+
 #include "hal/transport/MyTransportHAL.cpp"
 
+#if defined(MY_PRESENTATION_DIGEST) && (defined(MY_GATEWAY_FEATURE) || defined(MY_PASSIVE_NODE))
+#error MY_PRESENTATION_DIGEST is for nodes that get an answer, a GW answers it with MY_GATEWAY_PRESENTATION_CACHE
+#endif
+#if defined(MY_REGISTRATION_CACHE) && (defined(MY_GATEWAY_FEATURE) || defined(MY_PASSIVE_NODE))
+#error MY_REGISTRATION_CACHE is for nodes that get a registration response
+#endif
+#if defined(MY_REGISTRATION_CACHE) && (MY_REGISTRATION_CACHE_EPOCH > 254)
+#error MY_REGISTRATION_CACHE_EPOCH must be 0..254, 255 is erased EEPROM
+#endif
+
 // PASSIVE MODE
 #if defined(MY_PASSIVE_NODE) && !defined(DOXYGEN)
 #define MY_TRANSPORT_UPLINK_CHECK_DISABLED
@@ -83,7 +83,8 @@
  * @def MY_CAP_RADIO
  * @brief Indicate the type of transport selected.
  *
- * @see MY_RADIO_RF24, MY_RADIO_NRF5_ESB, MY_RADIO_RFM69, MY_RFM69_NEW_DRIVER, MY_RADIO_RFM95, MY_RS485
+ * @see MY_RADIO_RF24, MY_RADIO_NRF5_ESB, MY_RADIO_RFM69, MY_RFM69_NEW_DRIVER, MY_RADIO_RFM95, MY_RS485,
+ * MY_RADIO_SIMULATED, MY_RADIO_REMOTE
  *
  * | Radio        | Indicator
  * |--------------|----------
@@ -92,6 +93,8 @@
  * | %RFM69 (new) | P
  * | RFM95        | L
  * | RS485        | S
+ * | Simulated    | V
+ * | Remote       | C
  * | None         | -
  */
 #if defined(MY_RADIO_RF24) || defined(MY_RADIO_NRF5_ESB)
@@ -108,6 +111,10 @@
 #define MY_CAP_RADIO "L"
 #elif defined(MY_RS485)
 #define MY_CAP_RADIO "S"
+#elif defined(MY_RADIO_SIMULATED)
+#define MY_CAP_RADIO "V"
+#elif defined(MY_RADIO_REMOTE)
+#define MY_CAP_RADIO "C"
 #else
 #define MY_CAP_RADIO "-"
 #endif
@@ -179,16 +186,19 @@
  * @def MY_CAP_SIGN
  * @brief Indicate the signing backend used.
  *
- * @see MY_SIGNING_ATSHA204, MY_SIGNING_SOFT
+ * @see MY_SIGNING_ATSHA204, MY_SIGNING_ATECC, MY_SIGNING_SOFT
  *
  * | Signing backend | Indicator
  * |-----------------|----------
  * | ATSHA204        | A
+ * | ATECC508A/608A  | E
  * | Software        | S
  * | No signing      | -
  */
 #if defined(MY_SIGNING_ATSHA204)
 #define MY_CAP_SIGN "A"
+#elif defined(MY_SIGNING_ATECC)
+#define MY_CAP_SIGN "E"
 #elif defined(MY_SIGNING_SOFT)
 #define MY_CAP_SIGN "S"
 #else
@@ -32,10 +32,17 @@
 #define MyEepromAddresses_h
 
 // EEPROM variable sizes, in bytes
+#if defined(MY_NODE_ID_16BIT)
+#define SIZE_NODE_ID						(2u)		//!< Size node ID
+#define SIZE_PARENT_NODE_ID					(2u)		//!< Size parent node ID
+#define SIZE_DISTANCE						(1u)		//!< Size GW distance
+#define SIZE_ROUTES							(MY_ROUTING_TABLE_SIZE * 4u)	//!< Size routing table, node and route per entry
+#else
 #define SIZE_NODE_ID						(1u)		//!< Size node ID
 #define SIZE_PARENT_NODE_ID					(1u)		//!< Size parent node ID
 #define SIZE_DISTANCE						(1u)		//!< Size GW distance
 #define SIZE_ROUTES							(256u)	//!< Size routing table
+#endif
 #define SIZE_CONTROLLER_CONFIG				(23u)	//!< Size controller config
 #define SIZE_PERSONALIZATION_CHECKSUM	(1u)  //!< Size personalization checksum
 #define SIZE_FIRMWARE_TYPE					(2u)		//!< Size firmware type
@@ -48,6 +55,9 @@
 #define SIZE_SIGNING_SOFT_SERIAL			(9u)		//!< Size soft signing serial
 #define SIZE_RF_ENCRYPTION_AES_KEY			(16u)	//!< Size RF AES encryption key
 #define SIZE_NODE_LOCK_COUNTER				(1u)		//!< Size node lock counter
+#define SIZE_PARENT_CANDIDATES				(12u)	//!< Size parent candidates, part of the controller config
+#define SIZE_FIRMWARE_RESUME				(8u)		//!< Size OTA resume record, part of the controller config
+#define SIZE_REGISTRATION_CACHE				(2u)		//!< Size stored boot handshake, part of the controller config
 
 
 /** @brief EEPROM start address */
@@ -62,6 +72,12 @@
 #define EEPROM_ROUTES_ADDRESS (EEPROM_DISTANCE_ADDRESS + SIZE_DISTANCE)
 /** @brief Address configuration bytes sent by controller */
 #define EEPROM_CONTROLLER_CONFIG_ADDRESS (EEPROM_ROUTES_ADDRESS + SIZE_ROUTES)
+/** @brief Address parent candidates, the unused end of the controller config, see @ref MY_TRANSPORT_PARENT_CACHE */
+#define EEPROM_PARENT_CANDIDATES_ADDRESS (EEPROM_CONTROLLER_CONFIG_ADDRESS + SIZE_CONTROLLER_CONFIG - SIZE_PARENT_CANDIDATES)
+/** @brief Address OTA resume record, the unused controller config below the parent candidates, see @ref MY_OTA_RESUME */
+#define EEPROM_FIRMWARE_RESUME_ADDRESS (EEPROM_PARENT_CANDIDATES_ADDRESS - SIZE_FIRMWARE_RESUME)
+/** @brief Address stored boot handshake, the unused controller config below the OTA resume record, see @ref MY_REGISTRATION_CACHE */
+#define EEPROM_REGISTRATION_CACHE_ADDRESS (EEPROM_FIRMWARE_RESUME_ADDRESS - SIZE_REGISTRATION_CACHE)
 /** @brief Personalization checksum (set by SecurityPersonalizer.ino) */
 #define EEPROM_PERSONALIZATION_CHECKSUM_ADDRESS (EEPROM_CONTROLLER_CONFIG_ADDRESS + SIZE_CONTROLLER_CONFIG)
 /** @brief Address firmware type */
@@ -0,0 +1,100 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyEnergy.h"
+
+static energyReport_t _energyReport;
+static uint32_t _energyWakeUpMS = 0;	// hwMillis() when the running cycle started
+static bool _energyWindow = false;
+
+// the fields are packed, no references to them
+static uint16_t _energyAdd16(const uint16_t field, const uint32_t value)
+{
+	const uint32_t sum = (uint32_t)field + value;
+	return sum > 0xFFFFu ? 0xFFFFu : (uint16_t)sum;
+}
+
+void energyAccountSend(const uint32_t startUS, const bool acknowledged)
+{
+	_energyReport.txUS += hwMicros() - startUS;
+	if (!acknowledged) {
+		_energyReport.nack = _energyAdd16(_energyReport.nack, 1u);
+	}
+}
+
+void energyAccountWait(const uint32_t enteringMS)
+{
+	const uint32_t elapsedMS = hwMillis() - enteringMS;
+	if (_energyWindow) {
+		_energyReport.windowMS = _energyAdd16(_energyReport.windowMS, elapsedMS);
+	} else {
+		_energyReport.listenMS += elapsedMS;
+	}
+}
+
+void energyAccountNonce(const uint32_t enteringMS)
+{
+	_energyReport.nonceMS = _energyAdd16(_energyReport.nonceMS, hwMillis() - enteringMS);
+}
+
+void energyWindow(const bool active)
+{
+	_energyWindow = active;
+}
+
+void energySleep(void)
+{
+	_energyReport.awakeMS += hwMillis() - _energyWakeUpMS;
+	_energyReport.cycles = _energyAdd16(_energyReport.cycles, 1u);
+}
+
+bool energyWakeUp(void)
+{
+	// hwMillis() may have stopped while sleeping, the cycle is timed from here
+	_energyWakeUpMS = hwMillis();
+	return _energyReport.cycles >= MY_ENERGY_REPORT_CYCLES;
+}
+
+energyReport_t energyGet(void)
+{
+	energyReport_t report = _energyReport;
+	report.awakeMS += hwMillis() - _energyWakeUpMS;
+	// uA * ms is nC, the sum of a long report period exceeds 32 bits
+	const uint64_t txMS = report.txUS / 1000u;
+	const uint64_t rxMS = report.awakeMS > txMS ? report.awakeMS - txMS : 0u;
+	const uint64_t chargeNC = (uint64_t)report.awakeMS * MY_ENERGY_CURRENT_AWAKE_UA +
+	                          txMS * MY_ENERGY_CURRENT_TX_UA + rxMS * MY_ENERGY_CURRENT_RX_UA;
+	report.chargeUC = (uint32_t)(chargeNC / 1000u);
+	return report;
+}
+
+void energyReset(void)
+{
+	(void)memset((void *)&_energyReport, 0, sizeof(_energyReport));
+	_energyWakeUpMS = hwMillis();
+}
+
+void energyDump(void)
+{
+	const energyReport_t report = energyGet();
+	DEBUG_OUTPUT(PSTR("NRG:C=%" PRIu16 ",AWK=%" PRIu32 ",TX=%" PRIu32 ",LSN=%" PRIu32 ",WIN=%" PRIu16
+	                  ",NCE=%" PRIu16 ",NACK=%" PRIu16 ",UC=%" PRIu32 "\n"), report.cycles, report.awakeMS,
+	             report.txUS / 1000u, report.listenMS, report.windowMS, report.nonceMS, report.nack,
+	             report.chargeUC);
+}
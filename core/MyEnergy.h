@@ -0,0 +1,123 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+ * @file MyEnergy.h
+ *
+ * @brief Awake time and charge accounting of battery nodes, see @ref MY_ENERGY_ACCOUNTING
+ *
+ * A cycle is the time a node is awake between two sleeps. Its length is split up by the reason
+ * the node stays awake: the radio sending (including the ACK waits and retries of the driver),
+ * wait() listening for messages, the smartSleep() window and nonce waits of the signing. The
+ * remainder is the sketch and the core working, e.g. ADC settling and sensor readouts.
+ *
+ * The charge of the cycles is estimated from @ref MY_ENERGY_CURRENT_AWAKE_UA,
+ * @ref MY_ENERGY_CURRENT_TX_UA and @ref MY_ENERGY_CURRENT_RX_UA: the radio receives whenever the
+ * node is awake and not sending. The charge drawn while sleeping is not included.
+ *
+ * Every @ref MY_ENERGY_REPORT_CYCLES cycles the node sends the accounting of these cycles in an
+ * I_ENERGY message with a custom payload of energyReport_t (little endian) to the controller and
+ * starts over. An I_ENERGY request is answered the same way, including the running cycle, a
+ * payload of "R" starts over after the reply.
+ */
+
+#ifndef MyEnergy_h
+#define MyEnergy_h
+
+#include <stdint.h>
+
+/**
+ * @brief Accounting of the cycles since the last report, also the payload of I_ENERGY messages
+ *
+ * The 16 bit fields saturate.
+ */
+typedef struct {
+	uint16_t cycles;		//!< Cycles completed, i.e. sleeps entered
+	uint32_t awakeMS;		//!< Time awake
+	uint32_t txUS;			//!< Time sending, see transportHALSend()
+	uint32_t listenMS;		//!< Time in wait() outside the smartSleep() window
+	uint16_t windowMS;		//!< Time in the smartSleep() window
+	uint16_t nonceMS;		//!< Time waiting for nonces, see @ref MY_SIGNING_FEATURE
+	uint16_t nack;			//!< Frames not acknowledged, each costs the retries of the driver
+	uint32_t chargeUC;		//!< Estimated charge in uC (uAs) drawn while awake
+} __attribute__((packed)) energyReport_t;
+
+#if defined(MY_ENERGY_ACCOUNTING)
+/**
+ * @brief Account a frame sent
+ * @param startUS hwMicros() before the frame was handed to the radio
+ * @param acknowledged true if the frame was acknowledged or broadcast
+ */
+void energyAccountSend(const uint32_t startUS, const bool acknowledged);
+
+/**
+ * @brief Account time spent in wait()
+ * @param enteringMS hwMillis() when wait() was entered
+ */
+void energyAccountWait(const uint32_t enteringMS);
+
+/**
+ * @brief Account time spent waiting for a nonce
+ * @param enteringMS hwMillis() when the wait started
+ */
+void energyAccountNonce(const uint32_t enteringMS);
+
+/**
+ * @brief Mark the smartSleep() window, wait() is accounted to it meanwhile
+ * @param active true when the window opens, false when it closes
+ */
+void energyWindow(const bool active);
+
+/**
+ * @brief End the running cycle, call right before the MCU sleeps
+ */
+void energySleep(void);
+
+/**
+ * @brief Start a cycle, call right after the MCU woke up
+ * @return true if @ref MY_ENERGY_REPORT_CYCLES cycles are to be reported
+ */
+bool energyWakeUp(void);
+
+/**
+ * @brief Read the accounting including the running cycle
+ * @return Copy of the accounting with the estimated charge
+ */
+energyReport_t energyGet(void);
+
+/**
+ * @brief Start over, the running cycle is accounted from now on
+ */
+void energyReset(void);
+
+/**
+ * @brief Print the accounting to the debug output
+ */
+void energyDump(void);
+
+#define ENERGY_SEND(startUS, acknowledged)	energyAccountSend((startUS), (acknowledged))	//!< Account a frame
+#define ENERGY_WAIT(enteringMS)				energyAccountWait(enteringMS)	//!< Account a wait()
+#define ENERGY_NONCE(enteringMS)			energyAccountNonce(enteringMS)	//!< Account a nonce wait
+#else
+#define ENERGY_SEND(startUS, acknowledged)	//!< Energy accounting disabled
+#define ENERGY_WAIT(enteringMS)				//!< Energy accounting disabled
+#define ENERGY_NONCE(enteringMS)			//!< Energy accounting disabled
+#endif
+
+#endif
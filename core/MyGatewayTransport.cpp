@@ -18,53 +18,1283 @@
  */
 
 #include "MyGatewayTransport.h"
+#include "MyTransport.h"
 
+extern bool transportQueueRoute(MyMessage &message);
 extern bool transportSendRoute(MyMessage &message);
+extern bool isTransportReady(void);
 
 // global variables
 extern MyMessage _msg;
 extern MyMessage _msgTmp;
 
-inline void gatewayTransportProcess(void)
+static uint32_t _gatewayReconnectAt = 0;
+static uint32_t _gatewayReconnectDelay = 0;
+
+#if defined(MY_GATEWAY_STANDBY)
+#include "standby.h"
+
+// records replicated to the standby, STANDBY_HEARTBEAT (0) is taken by the link
+#define GATEWAY_STANDBY_SYNC (1u)			//!< complete state follows, forget the replicated one
+#define GATEWAY_STANDBY_ROUTE (2u)			//!< node and route, route BROADCAST_ADDRESS if cleared
+#define GATEWAY_STANDBY_ROUTES_CLEARED (3u)	//!< routing table cleared
+#define GATEWAY_STANDBY_NONCE (4u)			//!< node and nonce, only the node if the nonce was taken
+#define GATEWAY_STANDBY_OUTBOX (5u)			//!< index and outbox entry
+#endif
+
+#if defined(MY_GATEWAY_TIME_BEACON) && defined(MY_SENSOR_NETWORK)
+// last controller time and hwMillis() when it arrived
+static uint32_t _gatewayTime = 0;
+static uint32_t _gatewayTimeAt = 0;
+static bool _gatewayTimeValid = false;
+// next time request to the controller
+static uint32_t _gatewayTimeDue = 0;
+#endif
+
+#if defined(MY_GATEWAY_FLOW_CONTROL) && defined(MY_SENSOR_NETWORK)
+// last values reported to the controller
+static uint8_t _gatewayFlowQueued = 0;
+static uint8_t _gatewayFlowCredit = MY_TRANSPORT_TX_QUEUE_SIZE;
+static bool _gatewayFlowCongested = false;
+static uint32_t _gatewayFlowSentAt = 0;
+#endif
+
+#if defined(MY_GATEWAY_MAILBOX) && defined(MY_SENSOR_NETWORK)
+// messages for sleeping nodes, in order of arrival
+static MyMessage _gatewayMailbox[MY_GATEWAY_MAILBOX_SIZE];
+static uint8_t _gatewayMailboxCount = 0;
+// one bit per node id: asleep, burst due, release due after the burst
+static uint8_t _gatewayMailboxAsleep[32];
+static uint8_t _gatewayMailboxDeliver[32];
+static uint8_t _gatewayMailboxRelease[32];
+static bool _gatewayMailboxDue = false;
+#if (defined(MY_RADIO_NRF5_ESB) && defined(MY_NRF5_ESB_ACK_PAYLOAD)) || (defined(MY_RADIO_RF24) && defined(MY_RF24_ACK_PAYLOAD))
+#define GATEWAY_MAILBOX_ACK_PAYLOAD
+extern bool transportArmAckPayload(MyMessage &message);
+extern bool transportDisarmAckPayload(const nodeId_t node);
+// oldest message of the node is waiting in the radio for the ACK of its next frame
+static uint8_t _gatewayMailboxArmed[32];
+#endif
+
+// 16 bit node ids above 255 are never treated as asleep, their messages are sent right away
+static bool _gatewayMailboxGetBit(const uint8_t *bitmap, const nodeId_t nodeId)
 {
-	if (gatewayTransportAvailable()) {
-		_msg = gatewayTransportReceive();
-		if (_msg.destination == GATEWAY_ADDRESS) {
-
-			// Check if sender requests an echo
-			if (mGetRequestEcho(_msg)) {
-				// Copy message
-				_msgTmp = _msg;
-				// Reply without echo flag, otherwise we would end up in an eternal loop
-				mSetRequestEcho(_msgTmp,
-				                false);
-				mSetEcho(_msgTmp, true);
-				_msgTmp.sender = getNodeId();
-				_msgTmp.destination = _msg.sender;
-				gatewayTransportSend(_msgTmp);
+	return nodeId < 256u && (bitmap[nodeId >> 3] & (1u << (nodeId & 7)));
+}
+
+static void _gatewayMailboxSetBit(uint8_t *bitmap, const nodeId_t nodeId, const bool value)
+{
+	if (nodeId >= 256u) {
+		return;
+	}
+	if (value) {
+		bitmap[nodeId >> 3] |= (1u << (nodeId & 7));
+	} else {
+		bitmap[nodeId >> 3] &= ~(1u << (nodeId & 7));
+	}
+}
+
+static void _gatewayMailboxRemove(const uint8_t index)
+{
+	_gatewayMailboxCount--;
+	for (uint8_t i = index; i < _gatewayMailboxCount; i++) {
+		_gatewayMailbox[i] = _gatewayMailbox[i + 1];
+	}
+}
+
+#if defined(GATEWAY_MAILBOX_ACK_PAYLOAD)
+// Hand the oldest message of the node to the radio, the node gets it in the ACK of its next
+// frame, before it goes back to sleep. The mailbox keeps it until the frame is seen.
+static void _gatewayMailboxArm(const nodeId_t nodeId)
+{
+	for (uint8_t i = 0; i < _gatewayMailboxCount; i++) {
+		if (_gatewayMailbox[i].destination == nodeId) {
+			MyMessage message = _gatewayMailbox[i];
+			_gatewayMailboxSetBit(_gatewayMailboxArmed, nodeId, transportArmAckPayload(message));
+			return;
+		}
+	}
+	(void)transportDisarmAckPayload(nodeId);
+	_gatewayMailboxSetBit(_gatewayMailboxArmed, nodeId, false);
+}
+#endif
+
+static bool _gatewayMailboxStore(MyMessage &message)
+{
+	const nodeId_t nodeId = message.destination;
+	if (!_gatewayMailboxGetBit(_gatewayMailboxAsleep, nodeId)) {
+		return false;
+	}
+	uint8_t count = 0;
+	uint8_t oldest = 0;
+	for (uint8_t i = 0; i < _gatewayMailboxCount; ) {
+		MyMessage &stored = _gatewayMailbox[i];
+		if (stored.destination == nodeId) {
+			if (stored.sensor == message.sensor && stored.type == message.type &&
+			        mGetCommand(stored) == mGetCommand(message)) {
+				// the newer message supersedes the buffered one
+				_gatewayMailboxRemove(i);
+				continue;
+			}
+			if (count == 0) {
+				oldest = i;
+			}
+			count++;
+		}
+		i++;
+	}
+	if (count >= MY_GATEWAY_MAILBOX_NODE_SIZE || _gatewayMailboxCount >= MY_GATEWAY_MAILBOX_SIZE) {
+		if (count < MY_GATEWAY_MAILBOX_NODE_SIZE) {
+			oldest = 0;
+		}
+		const nodeId_t dropped = _gatewayMailbox[oldest].destination;
+		GATEWAY_DEBUG(PSTR("!GWT:MBX:DROP,N=%" PRIuNodeId "\n"), dropped);
+		if (dropped == nodeId) {
+			count--;
+		}
+		_gatewayMailboxRemove(oldest);
+#if defined(GATEWAY_MAILBOX_ACK_PAYLOAD)
+		if (dropped != nodeId) {
+			_gatewayMailboxArm(dropped);
+		}
+#endif
+	}
+	_gatewayMailbox[_gatewayMailboxCount++] = message;
+	GATEWAY_DEBUG(PSTR("GWT:MBX:STORE,N=%" PRIuNodeId ",C=%" PRIu8 "\n"), nodeId, count + 1);
+#if defined(GATEWAY_MAILBOX_ACK_PAYLOAD)
+	_gatewayMailboxArm(nodeId);
+#endif
+	return true;
+}
+
+static void _gatewayMailboxProcess(void)
+{
+	if (!_gatewayMailboxDue) {
+		return;
+	}
+	_gatewayMailboxDue = false;
+	// messages leave in order of arrival
+	uint8_t delivered[32] = { 0 };
+	for (uint8_t i = 0; i < _gatewayMailboxCount; ) {
+		const nodeId_t nodeId = _gatewayMailbox[i].destination;
+		if (!_gatewayMailboxGetBit(_gatewayMailboxDeliver, nodeId)) {
+			i++;
+			continue;
+		}
+		MyMessage message = _gatewayMailbox[i];
+		_gatewayMailboxRemove(i);
+#if defined(GATEWAY_MAILBOX_ACK_PAYLOAD)
+		if (_gatewayMailboxGetBit(_gatewayMailboxArmed, nodeId)) {
+			_gatewayMailboxSetBit(_gatewayMailboxArmed, nodeId, false);
+			if (!transportDisarmAckPayload(nodeId)) {
+				// left with the ACK of the frame that woke the node up
+				GATEWAY_DEBUG(PSTR("GWT:MBX:ACK PL,N=%" PRIuNodeId "\n"), nodeId);
+				_gatewayMailboxSetBit(delivered, nodeId, true);
+				continue;
+			}
+		}
+#endif
+		(void)transportQueueRoute(message);
+		_gatewayMailboxSetBit(delivered, nodeId, true);
+	}
+	for (uint16_t nodeId = 0; nodeId < sizeof(delivered) * 8; nodeId++) {
+		if (!_gatewayMailboxGetBit(_gatewayMailboxDeliver, (uint8_t)nodeId)) {
+			continue;
+		}
+		_gatewayMailboxSetBit(_gatewayMailboxDeliver, (uint8_t)nodeId, false);
+		if (_gatewayMailboxGetBit(delivered, (uint8_t)nodeId)) {
+			GATEWAY_DEBUG(PSTR("GWT:MBX:DELIVER,N=%" PRIu16 "\n"), nodeId);
+		}
+		if (_gatewayMailboxGetBit(_gatewayMailboxRelease, (uint8_t)nodeId)) {
+			_gatewayMailboxSetBit(_gatewayMailboxRelease, (uint8_t)nodeId, false);
+			// the burst is over, nothing else for the node until it wakes up again
+			MyMessage release;
+			(void)transportQueueRoute(build(release, (uint8_t)nodeId, NODE_SENSOR_ID, C_INTERNAL,
+			                                I_PRE_SLEEP_NOTIFICATION).set((uint8_t)0));
+			_gatewayMailboxSetBit(_gatewayMailboxAsleep, (uint8_t)nodeId, true);
+			GATEWAY_DEBUG(PSTR("GWT:MBX:REL,N=%" PRIu16 "\n"), nodeId);
+		}
+	}
+}
+
+void gatewayTransportMailboxWake(const nodeId_t nodeId, const bool preSleep)
+{
+	_gatewayMailboxSetBit(_gatewayMailboxAsleep, nodeId, false);
+	_gatewayMailboxSetBit(_gatewayMailboxDeliver, nodeId, true);
+	if (preSleep) {
+		_gatewayMailboxSetBit(_gatewayMailboxRelease, nodeId, true);
+	}
+	// deliver from gatewayTransportProcess(), not while the frame is being processed
+	_gatewayMailboxDue = true;
+#if defined(MY_GATEWAY_LINUX)
+	eventLoopWakeup();
+#endif
+}
+#endif
+
+#if defined(MY_GATEWAY_PRESENTATION_CACHE) && defined(MY_SENSOR_NETWORK)
+// latest presentation, sketch info and value per node and child, least recently updated first
+static MyMessage _gatewayCache[MY_GATEWAY_PRESENTATION_CACHE_SIZE];
+static uint16_t _gatewayCacheCount = 0;
+#if defined(__linux__)
+#define GATEWAY_CACHE_FILE_MAGIC "MYSC\x01"		//!< Cache file header, the last byte is the format version
+static char *_gatewayCacheFile = NULL;
+static bool _gatewayCacheDirty = false;
+static uint32_t _gatewayCacheChangedAt = 0;
+#endif
+
+static bool _gatewayCacheMatch(const MyMessage &stored, const MyMessage &message)
+{
+	if (stored.sender != message.sender || stored.sensor != message.sensor ||
+	        mGetCommand(stored) != mGetCommand(message)) {
+		return false;
+	}
+	// a child is presented with one sensor type only
+	return mGetCommand(message) == C_PRESENTATION || stored.type == message.type;
+}
+
+static void _gatewayCacheRemove(const uint16_t index)
+{
+	_gatewayCacheCount--;
+	for (uint16_t i = index; i < _gatewayCacheCount; i++) {
+		_gatewayCache[i] = _gatewayCache[i + 1];
+	}
+}
+
+void gatewayTransportCacheStore(const MyMessage &message)
+{
+	const uint8_t command = mGetCommand(message);
+	if (message.sender == GATEWAY_ADDRESS || !(command == C_PRESENTATION || command == C_SET ||
+	        (command == C_INTERNAL && (message.type == I_SKETCH_NAME ||
+	                                   message.type == I_SKETCH_VERSION)))) {
+		return;
+	}
+	for (uint16_t i = 0; i < _gatewayCacheCount; i++) {
+		if (_gatewayCacheMatch(_gatewayCache[i], message)) {
+			_gatewayCacheRemove(i);
+			break;
+		}
+	}
+	if (_gatewayCacheCount >= MY_GATEWAY_PRESENTATION_CACHE_SIZE) {
+		// values are cheaper to lose than presentations, the node sends them again anyway
+		uint16_t oldest = 0;
+		for (uint16_t i = 0; i < _gatewayCacheCount; i++) {
+			if (mGetCommand(_gatewayCache[i]) == C_SET) {
+				oldest = i;
+				break;
+			}
+		}
+		GATEWAY_DEBUG(PSTR("!GWT:PCH:DROP,N=%" PRIuNodeId ",C=%" PRIu8 "\n"), _gatewayCache[oldest].sender,
+		              _gatewayCache[oldest].sensor);
+		_gatewayCacheRemove(oldest);
+	}
+	MyMessage &stored = _gatewayCache[_gatewayCacheCount++];
+	stored = message;
+	mSetRequestEcho(stored, false);
+	mSetEcho(stored, false);
+#if defined(__linux__)
+	if (!_gatewayCacheDirty) {
+		_gatewayCacheDirty = true;
+		_gatewayCacheChangedAt = hwMillis();
+	}
+#endif
+}
+
+void gatewayTransportCacheReplay(void)
+{
+	if (_gatewayCacheCount == 0) {
+		return;
+	}
+	GATEWAY_DEBUG(PSTR("GWT:PCH:REPLAY,C=%" PRIu16 "\n"), _gatewayCacheCount);
+	// same order as a node presenting itself: presentations and sketch info before values
+	for (uint8_t pass = 0; pass < 2; pass++) {
+		for (uint16_t i = 0; i < _gatewayCacheCount; i++) {
+			if ((mGetCommand(_gatewayCache[i]) == C_SET) == (pass == 1)) {
+				_msgTmp = _gatewayCache[i];
+				(void)gatewayTransportSend(_msgTmp);
+			}
+		}
+	}
+}
+
+void gatewayTransportCacheDigestReply(const MyMessage &request)
+{
+	uint32_t digest = 0;
+	for (uint16_t i = 0; i < _gatewayCacheCount; i++) {
+		if (_gatewayCache[i].sender == request.sender) {
+			digest = presentationDigestAdd(digest, _gatewayCache[i]);
+		}
+	}
+	// nothing cached, e.g. dropped when the cache was full: the node presents in full
+	uint8_t known = PRESENTATION_DIGEST_UNKNOWN;
+	if (digest != 0) {
+		// the signing requirements are part of the digest, the tables need no update if they match
+		const uint32_t signing = presentationDigestAdd(digest, build(_msgTmp, request.sender,
+		                         NODE_SENSOR_ID, C_INTERNAL, I_SIGNING_PRESENTATION).set(
+		                             signerPresentationState(request.sender)));
+		if (signing == request.getULong()) {
+			known = PRESENTATION_DIGEST_KNOWN;
+		} else if (digest == request.getULong()) {
+			// a node of an older version, it always sends its signing presentation
+			known = PRESENTATION_DIGEST_KNOWN_LEGACY;
+		}
+	}
+	GATEWAY_DEBUG(PSTR("GWT:PCH:DIGEST,N=%" PRIuNodeId ",KNOWN=%" PRIu8 "\n"), request.sender, known);
+	(void)transportQueueRoute(build(_msgTmp, request.sender, NODE_SENSOR_ID, C_INTERNAL,
+	                                I_PRESENTATION_DIGEST).set(known));
+}
+
+#if defined(__linux__)
+void gatewayTransportCacheLoad(const char *fileName)
+{
+	free(_gatewayCacheFile);
+	_gatewayCacheFile = fileName ? strdup(fileName) : NULL;
+	_gatewayCacheCount = 0;
+	if (!_gatewayCacheFile) {
+		return;
+	}
+	FILE *file = fopen(_gatewayCacheFile, "rb");
+	if (!file) {
+		// no cache yet
+		return;
+	}
+	char magic[sizeof(GATEWAY_CACHE_FILE_MAGIC) - 1];
+	if (fread(magic, sizeof(magic), 1, file) != 1 ||
+	        memcmp(magic, GATEWAY_CACHE_FILE_MAGIC, sizeof(magic)) != 0) {
+		logWarning("Ignoring presentation cache %s, unknown format.\n", _gatewayCacheFile);
+		fclose(file);
+		return;
+	}
+	while (_gatewayCacheCount < MY_GATEWAY_PRESENTATION_CACHE_SIZE &&
+	        fread(&_gatewayCache[_gatewayCacheCount], sizeof(MyMessage), 1, file) == 1) {
+		_gatewayCacheCount++;
+	}
+	fclose(file);
+	logInfo("Loaded %u cached messages from %s.\n", (unsigned int)_gatewayCacheCount, _gatewayCacheFile);
+}
+
+void gatewayTransportCacheSave(void)
+{
+	if (!_gatewayCacheFile || !_gatewayCacheDirty) {
+		return;
+	}
+	_gatewayCacheDirty = false;
+	// replace the file in one step, a power loss leaves the old or the new cache behind
+	char tempName[PATH_MAX];
+	(void)snprintf(tempName, sizeof(tempName), "%s.tmp", _gatewayCacheFile);
+	FILE *file = fopen(tempName, "wb");
+	if (!file) {
+		logError("Unable to write presentation cache %s.\n", tempName);
+		return;
+	}
+	bool success = fwrite(GATEWAY_CACHE_FILE_MAGIC, sizeof(GATEWAY_CACHE_FILE_MAGIC) - 1, 1,
+	                      file) == 1;
+	if (success && _gatewayCacheCount > 0) {
+		success = fwrite(_gatewayCache, sizeof(MyMessage), _gatewayCacheCount,
+		                 file) == _gatewayCacheCount;
+	}
+	success = (fclose(file) == 0) && success;
+	if (!success || rename(tempName, _gatewayCacheFile) != 0) {
+		logError("Unable to write presentation cache %s.\n", _gatewayCacheFile);
+		(void)unlink(tempName);
+	}
+}
+#endif
+#endif
+
+#if defined(MY_GATEWAY_OUTBOX) && defined(MY_SENSOR_NETWORK)
+#define GATEWAY_OUTBOX_FILE_MAGIC "MYSO\x01"		//!< Outbox file header, the last byte is the format version
+
+typedef struct {
+	MyMessage message;
+	uint32_t sequence;	// order of arrival, 0 if the slot is free
+	uint32_t expiresAt;	// wall clock in s, stays valid across restarts
+	uint32_t retryAt;	// hwMillis() of the next attempt, due right away after a restart
+	uint8_t attempts;
+} gatewayOutboxEntry_t;
+
+// layout of the outbox file
+typedef struct {
+	char magic[sizeof(GATEWAY_OUTBOX_FILE_MAGIC) - 1];
+	uint8_t size;
+	uint32_t sequence;	// last sequence number handed out
+	gatewayOutboxEntry_t entries[MY_GATEWAY_OUTBOX_SIZE];
+} gatewayOutbox_t;
+
+static gatewayOutbox_t _gatewayOutboxMemory;
+static gatewayOutbox_t *_gatewayOutbox = &_gatewayOutboxMemory;
+static bool _gatewayOutboxMapped = false;
+static uint8_t _gatewayOutboxCount = 0;
+
+static void _gatewayOutboxChanged(void)
+{
+	if (_gatewayOutboxMapped) {
+		// written back by the kernel, also if the gateway is killed
+		(void)msync(_gatewayOutbox, sizeof(gatewayOutbox_t), MS_ASYNC);
+	}
+}
+
+#if defined(MY_GATEWAY_STANDBY)
+static void _gatewayOutboxReplicate(const gatewayOutboxEntry_t &entry)
+{
+	uint8_t record[1 + sizeof(gatewayOutboxEntry_t)];
+	record[0] = (uint8_t)(&entry - _gatewayOutbox->entries);
+	(void)memcpy(&record[1], (const void *)&entry, sizeof(gatewayOutboxEntry_t));
+	standbySend(GATEWAY_STANDBY_OUTBOX, record, sizeof(record));
+}
+#endif
+
+static void _gatewayOutboxRemove(gatewayOutboxEntry_t &entry)
+{
+	entry.sequence = 0;
+	_gatewayOutboxCount--;
+#if defined(MY_GATEWAY_STANDBY)
+	_gatewayOutboxReplicate(entry);
+#endif
+}
+
+static bool _gatewayOutboxStore(MyMessage &message)
+{
+	if (message.destination == BROADCAST_ADDRESS) {
+		// nothing acknowledges a broadcast (BROADCAST_ADDRESS)
+		return false;
+	}
+	gatewayOutboxEntry_t *slot = NULL;
+	gatewayOutboxEntry_t *oldest = NULL;
+	for (uint8_t i = 0; i < MY_GATEWAY_OUTBOX_SIZE; i++) {
+		gatewayOutboxEntry_t &entry = _gatewayOutbox->entries[i];
+		if (entry.sequence != 0 && entry.message.destination == message.destination &&
+		        entry.message.sensor == message.sensor && entry.message.type == message.type &&
+		        mGetCommand(entry.message) == mGetCommand(message)) {
+			// the newer message supersedes the stored one
+			_gatewayOutboxRemove(entry);
+		}
+		if (entry.sequence == 0) {
+			if (slot == NULL) {
+				slot = &entry;
+			}
+		} else if (oldest == NULL || entry.sequence < oldest->sequence) {
+			oldest = &entry;
+		}
+	}
+	if (slot == NULL) {
+		GATEWAY_DEBUG(PSTR("!GWT:OBX:DROP,N=%" PRIuNodeId "\n"), oldest->message.destination);
+		_gatewayOutboxRemove(*oldest);
+		slot = oldest;
+	}
+	slot->message = message;
+	slot->expiresAt = (uint32_t)time(NULL) + MY_GATEWAY_OUTBOX_TTL_S;
+	slot->retryAt = hwMillis();
+	slot->attempts = 0;
+	slot->sequence = ++_gatewayOutbox->sequence;
+	_gatewayOutboxCount++;
+	_gatewayOutboxChanged();
+#if defined(MY_GATEWAY_STANDBY)
+	_gatewayOutboxReplicate(*slot);
+#endif
+	GATEWAY_DEBUG(PSTR("GWT:OBX:STORE,N=%" PRIuNodeId ",C=%" PRIu8 "\n"), message.destination,
+	              _gatewayOutboxCount);
+	// sent from gatewayTransportProcess(), the next controller message does not wait for the radio
+	eventLoopWakeup();
+	return true;
+}
+
+static bool _gatewayOutboxFirstForNode(const gatewayOutboxEntry_t &entry)
+{
+	for (uint8_t i = 0; i < MY_GATEWAY_OUTBOX_SIZE; i++) {
+		const gatewayOutboxEntry_t &other = _gatewayOutbox->entries[i];
+		if (other.sequence != 0 && other.sequence < entry.sequence &&
+		        other.message.destination == entry.message.destination) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void _gatewayOutboxProcess(void)
+{
+	if (_gatewayOutboxCount == 0 || !isTransportReady()) {
+		return;
+	}
+	const uint32_t now = (uint32_t)time(NULL);
+	const uint32_t nowMs = hwMillis();
+	gatewayOutboxEntry_t *due = NULL;
+	int32_t wait = -1;
+	for (uint8_t i = 0; i < MY_GATEWAY_OUTBOX_SIZE; i++) {
+		gatewayOutboxEntry_t &entry = _gatewayOutbox->entries[i];
+		if (entry.sequence == 0) {
+			continue;
+		}
+		if ((int32_t)(now - entry.expiresAt) >= 0) {
+			GATEWAY_DEBUG(PSTR("!GWT:OBX:EXPIRE,N=%" PRIuNodeId ",A=%" PRIu8 "\n"),
+			              entry.message.destination, entry.attempts);
+			_gatewayOutboxRemove(entry);
+			_gatewayOutboxChanged();
+			continue;
+		}
+		// messages for a node leave in order of arrival
+		if (!_gatewayOutboxFirstForNode(entry)) {
+			continue;
+		}
+		const int32_t remaining = (int32_t)(entry.retryAt - nowMs);
+		if (remaining <= 0) {
+			if (due == NULL || entry.sequence < due->sequence) {
+				due = &entry;
+			}
+		} else if (wait < 0 || remaining < wait) {
+			wait = remaining;
+		}
+	}
+	if (due == NULL) {
+		if (wait > 0) {
+			// come back when the next attempt is due
+			eventLoopWakeupIn((uint32_t)wait);
+		}
+		return;
+	}
+	// one message per call, controller and radio input are served in between
+	MyMessage message = due->message;
+	if (transportSendRoute(message)) {
+		GATEWAY_DEBUG(PSTR("GWT:OBX:DELIVER,N=%" PRIuNodeId ",A=%" PRIu8 "\n"), due->message.destination,
+		              due->attempts);
+		_gatewayOutboxRemove(*due);
+	} else {
+		uint32_t delay = MY_GATEWAY_OUTBOX_RETRY_MIN_MS;
+		for (uint8_t i = 0; i < due->attempts && delay < MY_GATEWAY_OUTBOX_RETRY_MAX_MS; i++) {
+			delay *= 2;
+		}
+		if (delay > MY_GATEWAY_OUTBOX_RETRY_MAX_MS) {
+			delay = MY_GATEWAY_OUTBOX_RETRY_MAX_MS;
+		}
+		due->attempts++;
+		due->retryAt = hwMillis() + delay;
+#if defined(MY_GATEWAY_STANDBY)
+		_gatewayOutboxReplicate(*due);
+#endif
+		GATEWAY_DEBUG(PSTR("!GWT:OBX:RETRY,N=%" PRIuNodeId ",A=%" PRIu8 "\n"), due->message.destination,
+		              due->attempts);
+	}
+	_gatewayOutboxChanged();
+	// other messages may be due as well
+	eventLoopWakeup();
+}
+
+void gatewayTransportOutboxOpen(const char *fileName)
+{
+	const int fd = open(fileName, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		logError("Unable to open outbox %s: %s\n", fileName, strerror(errno));
+		return;
+	}
+	struct stat fileInfo;
+	if (fstat(fd, &fileInfo) != 0 || (fileInfo.st_size != sizeof(gatewayOutbox_t) &&
+	                                   ftruncate(fd, sizeof(gatewayOutbox_t)) != 0)) {
+		logError("Unable to size outbox %s: %s\n", fileName, strerror(errno));
+		close(fd);
+		return;
+	}
+	void *map = mmap(NULL, sizeof(gatewayOutbox_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		logError("Unable to map outbox %s: %s\n", fileName, strerror(errno));
+		return;
+	}
+	gatewayOutbox_t *outbox = (gatewayOutbox_t *)map;
+	if (memcmp(outbox->magic, GATEWAY_OUTBOX_FILE_MAGIC, sizeof(outbox->magic)) != 0 ||
+	        outbox->size != MY_GATEWAY_OUTBOX_SIZE) {
+		if (fileInfo.st_size != 0) {
+			logWarning("Resetting outbox %s, unknown format.\n", fileName);
+		}
+		(void)memset((void *)outbox, 0, sizeof(gatewayOutbox_t));
+		memcpy(outbox->magic, GATEWAY_OUTBOX_FILE_MAGIC, sizeof(outbox->magic));
+		outbox->size = MY_GATEWAY_OUTBOX_SIZE;
+	}
+	_gatewayOutbox = outbox;
+	_gatewayOutboxMapped = true;
+	_gatewayOutboxCount = 0;
+	const uint32_t now = hwMillis();
+	for (uint8_t i = 0; i < MY_GATEWAY_OUTBOX_SIZE; i++) {
+		gatewayOutboxEntry_t &entry = _gatewayOutbox->entries[i];
+		if (entry.sequence != 0) {
+			// the old hwMillis() times mean nothing after a restart
+			entry.retryAt = now;
+			_gatewayOutboxCount++;
+		}
+	}
+	_gatewayOutboxChanged();
+	logInfo("Loaded %u pending messages from %s.\n", (unsigned int)_gatewayOutboxCount, fileName);
+}
+
+void gatewayTransportOutboxClose(void)
+{
+	if (!_gatewayOutboxMapped) {
+		return;
+	}
+	(void)msync(_gatewayOutbox, sizeof(gatewayOutbox_t), MS_SYNC);
+	(void)munmap(_gatewayOutbox, sizeof(gatewayOutbox_t));
+	_gatewayOutboxMapped = false;
+	_gatewayOutbox = &_gatewayOutboxMemory;
+	_gatewayOutboxCount = 0;
+}
+
+#if defined(MY_GATEWAY_STANDBY)
+// replace the outbox by the one of the gateway taken over from
+static void _gatewayOutboxRestore(const gatewayOutboxEntry_t *entries)
+{
+	const uint32_t now = hwMillis();
+	_gatewayOutboxCount = 0;
+	for (uint8_t i = 0; i < MY_GATEWAY_OUTBOX_SIZE; i++) {
+		gatewayOutboxEntry_t &entry = _gatewayOutbox->entries[i];
+		entry = entries[i];
+		if (entry.sequence != 0) {
+			// its hwMillis() times mean nothing here
+			entry.retryAt = now;
+			_gatewayOutboxCount++;
+			if ((int32_t)(entry.sequence - _gatewayOutbox->sequence) > 0) {
+				_gatewayOutbox->sequence = entry.sequence;
 			}
-			if (mGetCommand(_msg) == C_INTERNAL) {
-				if (_msg.type == I_VERSION) {
-					// Request for version. Create the response
-					gatewayTransportSend(buildGw(_msgTmp, I_VERSION).set(MYSENSORS_LIBRARY_VERSION));
+		}
+	}
+	_gatewayOutboxChanged();
+}
+#endif
+#endif
+
+#if defined(MY_GATEWAY_STANDBY)
+// state mirrored from the active gateway, applied when taking over
+typedef struct {
+	nodeId_t node;
+	nodeId_t route;
+} gatewayStandbyRoute_t;
+
+static gatewayStandbyRoute_t _gatewayStandbyRoutes[TRANSPORT_ROUTE_SLOTS];
+static uint16_t _gatewayStandbyRouteCount = 0;
+static bool _gatewayStandbySynced = false;	// the complete state was received, replaces the own one
+#if defined(MY_SIGNING_FEATURE)
+typedef struct {
+	uint32_t receivedAt;	// hwMillis(), the nonces only live MY_VERIFICATION_TIMEOUT_MS
+	bool used;
+	uint8_t nodeId;
+	uint8_t nonce[32];
+} gatewayStandbyNonce_t;
+
+static gatewayStandbyNonce_t _gatewayStandbyNonces[MY_SIGNING_NONCE_TABLE_SIZE];
+#endif
+#if defined(MY_GATEWAY_OUTBOX)
+static gatewayOutboxEntry_t _gatewayStandbyOutbox[MY_GATEWAY_OUTBOX_SIZE];
+#endif
+
+static void _gatewayStandbyMirrorRoute(const nodeId_t node, const nodeId_t route)
+{
+	for (uint16_t i = 0; i < _gatewayStandbyRouteCount; i++) {
+		if (_gatewayStandbyRoutes[i].node == node) {
+			_gatewayStandbyRoutes[i].route = route;
+			return;
+		}
+	}
+	if (_gatewayStandbyRouteCount < TRANSPORT_ROUTE_SLOTS) {
+		_gatewayStandbyRoutes[_gatewayStandbyRouteCount].node = node;
+		_gatewayStandbyRoutes[_gatewayStandbyRouteCount].route = route;
+		_gatewayStandbyRouteCount++;
+	}
+}
+
+#if defined(MY_SIGNING_FEATURE)
+static void _gatewayStandbyMirrorNonce(const uint8_t nodeId, const uint8_t *nonce)
+{
+	gatewayStandbyNonce_t *slot = NULL;
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_TABLE_SIZE; i++) {
+		gatewayStandbyNonce_t *entry = &_gatewayStandbyNonces[i];
+		if (entry->used && entry->nodeId == nodeId) {
+			slot = entry;
+			break;
+		}
+		if (slot == NULL || (slot->used &&
+		                     (!entry->used || (int32_t)(entry->receivedAt - slot->receivedAt) < 0))) {
+			slot = entry;
+		}
+	}
+	if (nonce == NULL) {
+		if (slot->used && slot->nodeId == nodeId) {
+			(void)memset((void *)slot->nonce, 0xAA, sizeof(slot->nonce));
+			slot->used = false;
+		}
+		return;
+	}
+	(void)memcpy((void *)slot->nonce, (const void *)nonce, sizeof(slot->nonce));
+	slot->used = true;
+	slot->nodeId = nodeId;
+	slot->receivedAt = hwMillis();
+}
+#endif
+
+static void _gatewayStandbyApply(uint8_t type, const uint8_t *data, uint16_t length)
+{
+	if (type == GATEWAY_STANDBY_SYNC || type == GATEWAY_STANDBY_ROUTES_CLEARED) {
+		_gatewayStandbyRouteCount = 0;
+	}
+	if (type == GATEWAY_STANDBY_SYNC) {
+		_gatewayStandbySynced = true;
+#if defined(MY_SIGNING_FEATURE)
+		(void)memset((void *)_gatewayStandbyNonces, 0, sizeof(_gatewayStandbyNonces));
+#endif
+#if defined(MY_GATEWAY_OUTBOX)
+		(void)memset((void *)_gatewayStandbyOutbox, 0, sizeof(_gatewayStandbyOutbox));
+#endif
+	} else if (type == GATEWAY_STANDBY_ROUTE && length == 2 * sizeof(nodeId_t)) {
+		nodeId_t route[2];
+		(void)memcpy((void *)route, (const void *)data, sizeof(route));
+		_gatewayStandbyMirrorRoute(route[0], route[1]);
+#if defined(MY_SIGNING_FEATURE)
+	} else if (type == GATEWAY_STANDBY_NONCE && (length == 1 || length == 33)) {
+		_gatewayStandbyMirrorNonce(data[0], length == 1 ? NULL : &data[1]);
+#endif
+#if defined(MY_GATEWAY_OUTBOX)
+	} else if (type == GATEWAY_STANDBY_OUTBOX && length == 1 + sizeof(gatewayOutboxEntry_t) &&
+	           data[0] < MY_GATEWAY_OUTBOX_SIZE) {
+		(void)memcpy((void *)&_gatewayStandbyOutbox[data[0]], (const void *)&data[1],
+		             sizeof(gatewayOutboxEntry_t));
+#endif
+	}
+}
+
+static void _gatewayStandbySendRoute(const nodeId_t node, const nodeId_t route)
+{
+	const nodeId_t record[2] = { node, route };
+	standbySend(GATEWAY_STANDBY_ROUTE, record, sizeof(record));
+}
+
+// a standby connected, it gets the complete state. Nonces are only replicated as they are
+// generated, they expire within MY_VERIFICATION_TIMEOUT_MS anyway.
+static void _gatewayStandbyProcess(void)
+{
+	if (!standbySyncPending()) {
+		return;
+	}
+	standbySend(GATEWAY_STANDBY_SYNC, NULL, 0);
+	transportVisitRoutes(_gatewayStandbySendRoute);
+#if defined(MY_GATEWAY_OUTBOX)
+	for (uint8_t i = 0; i < MY_GATEWAY_OUTBOX_SIZE; i++) {
+		if (_gatewayOutbox->entries[i].sequence != 0) {
+			_gatewayOutboxReplicate(_gatewayOutbox->entries[i]);
+		}
+	}
+#endif
+}
+
+void gatewayTransportStandbyFollow(const char *peer, const uint16_t port)
+{
+	standbyFollow(peer, port, MY_GATEWAY_STANDBY_TIMEOUT_MS, _gatewayStandbyApply);
+}
+
+void gatewayTransportStandbyTakeOver(void)
+{
+	if (!_gatewayStandbySynced) {
+		// the active gateway was never reached, carry on with the own state
+		return;
+	}
+	transportClearRoutingTable();
+	for (uint16_t i = 0; i < _gatewayStandbyRouteCount; i++) {
+		if (_gatewayStandbyRoutes[i].route != BROADCAST_ADDRESS) {
+			transportSetRoute(_gatewayStandbyRoutes[i].node, _gatewayStandbyRoutes[i].route);
+		}
+	}
+	transportSaveRoutingTable();
+	uint8_t nonces = 0;
+#if defined(MY_SIGNING_FEATURE)
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_TABLE_SIZE; i++) {
+		const gatewayStandbyNonce_t &entry = _gatewayStandbyNonces[i];
+		if (entry.used && hwMillis() - entry.receivedAt <= MY_VERIFICATION_TIMEOUT_MS) {
+			signerNonceStore(entry.nodeId, entry.nonce);
+			nonces++;
+		}
+	}
+	(void)memset((void *)_gatewayStandbyNonces, 0, sizeof(_gatewayStandbyNonces));
+#endif
+#if defined(MY_GATEWAY_OUTBOX)
+	_gatewayOutboxRestore(_gatewayStandbyOutbox);
+	const uint8_t messages = _gatewayOutboxCount;
+#else
+	const uint8_t messages = 0;
+#endif
+	logNotice("Took over %u routes, %u nonces and %u outbox messages.\n",
+	          (unsigned int)_gatewayStandbyRouteCount, (unsigned int)nonces, (unsigned int)messages);
+}
+
+void gatewayTransportStandbyRoute(const nodeId_t node, const nodeId_t route)
+{
+	_gatewayStandbySendRoute(node, route);
+}
+
+void gatewayTransportStandbyRoutesCleared(void)
+{
+	standbySend(GATEWAY_STANDBY_ROUTES_CLEARED, NULL, 0);
+}
+
+void gatewayTransportStandbyNonce(const uint8_t nodeId, const uint8_t *nonce)
+{
+	uint8_t record[33];
+	record[0] = nodeId;
+	if (nonce != NULL) {
+		(void)memcpy((void *)&record[1], (const void *)nonce, 32);
+	}
+	standbySend(GATEWAY_STANDBY_NONCE, record, nonce != NULL ? sizeof(record) : 1);
+}
+#endif
+
+#if defined(MY_GATEWAY_FIRMWARE_SERVER) && defined(MY_SENSOR_NETWORK)
+#include <dirent.h>
+#include "MyOTAFirmwareUpdate.h"
+
+#define GATEWAY_FIRMWARE_PROGRESS_BLOCKS (128u)	//!< Blocks between the progress reports to the controller
+
+typedef struct {
+	uint16_t type;
+	uint16_t version;
+	uint16_t blocks;
+	uint16_t crc;
+	const uint8_t *image;	// mapped image file
+	size_t size;
+} gatewayFirmware_t;
+
+static char *_gatewayFirmwareDir = NULL;
+static struct timespec _gatewayFirmwareDirChanged;
+static gatewayFirmware_t *_gatewayFirmware = NULL;
+static uint16_t _gatewayFirmwareCount = 0;
+
+static void _gatewayFirmwareBlock(const gatewayFirmware_t &firmware, const uint16_t block,
+                                  uint8_t *data)
+{
+	// the last block is padded with 0xFF
+	const size_t offset = (size_t)block * FIRMWARE_BLOCK_SIZE;
+	const size_t length = firmware.size - offset < FIRMWARE_BLOCK_SIZE ? firmware.size - offset :
+	                      FIRMWARE_BLOCK_SIZE;
+	(void)memset(data, 0xFF, FIRMWARE_BLOCK_SIZE);
+	(void)memcpy(data, &firmware.image[offset], length);
+}
+
+static void _gatewayFirmwareUnmap(void)
+{
+	for (uint16_t i = 0; i < _gatewayFirmwareCount; i++) {
+		(void)munmap((void *)_gatewayFirmware[i].image, _gatewayFirmware[i].size);
+	}
+	free(_gatewayFirmware);
+	_gatewayFirmware = NULL;
+	_gatewayFirmwareCount = 0;
+}
+
+static void _gatewayFirmwareMap(const char *fileName, const uint16_t type, const uint16_t version)
+{
+	char path[PATH_MAX];
+	(void)snprintf(path, sizeof(path), "%s/%s", _gatewayFirmwareDir, fileName);
+	const int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		logError("Unable to open firmware %s: %s\n", path, strerror(errno));
+		return;
+	}
+	struct stat fileInfo;
+	if (fstat(fd, &fileInfo) != 0 || fileInfo.st_size == 0 ||
+	        (uint64_t)fileInfo.st_size > (uint64_t)UINT16_MAX * FIRMWARE_BLOCK_SIZE) {
+		logWarning("Ignoring firmware %s, empty or too large.\n", path);
+		close(fd);
+		return;
+	}
+	const size_t size = (size_t)fileInfo.st_size;
+	void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		logError("Unable to map firmware %s: %s\n", path, strerror(errno));
+		return;
+	}
+	gatewayFirmware_t *grown = (gatewayFirmware_t *)realloc(_gatewayFirmware,
+	                           (_gatewayFirmwareCount + 1) * sizeof(gatewayFirmware_t));
+	if (!grown) {
+		(void)munmap(map, size);
+		return;
+	}
+	_gatewayFirmware = grown;
+	gatewayFirmware_t &firmware = _gatewayFirmware[_gatewayFirmwareCount++];
+	firmware.type = type;
+	firmware.version = version;
+	firmware.blocks = (uint16_t)((size + FIRMWARE_BLOCK_SIZE - 1) / FIRMWARE_BLOCK_SIZE);
+	firmware.image = (const uint8_t *)map;
+	firmware.size = size;
+	// same CRC as the node calculates over the received blocks
+	uint16_t crc = ~0;
+	uint8_t data[FIRMWARE_BLOCK_SIZE];
+	for (uint16_t block = 0; block < firmware.blocks; block++) {
+		_gatewayFirmwareBlock(firmware, block, data);
+		crc = crc16Buffer(crc, data, FIRMWARE_BLOCK_SIZE);
+	}
+	firmware.crc = crc;
+}
+
+static void _gatewayFirmwareScan(void)
+{
+	_gatewayFirmwareUnmap();
+	struct stat dirInfo;
+	DIR *dir = opendir(_gatewayFirmwareDir);
+	if (!dir || fstat(dirfd(dir), &dirInfo) != 0) {
+		logError("Unable to read firmware directory %s: %s\n", _gatewayFirmwareDir, strerror(errno));
+		if (dir) {
+			closedir(dir);
+		}
+		return;
+	}
+	_gatewayFirmwareDirChanged = dirInfo.st_mtim;
+	const struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		// <type>-<version>.bin, decimal
+		unsigned int type, version;
+		int consumed = 0;
+		if (sscanf(entry->d_name, "%u-%u.bin%n", &type, &version, &consumed) == 2 && consumed > 0 &&
+		        entry->d_name[consumed] == '\0' && type <= UINT16_MAX && version <= UINT16_MAX) {
+			_gatewayFirmwareMap(entry->d_name, (uint16_t)type, (uint16_t)version);
+		}
+	}
+	closedir(dir);
+	logInfo("Serving %u firmware images from %s.\n", (unsigned int)_gatewayFirmwareCount,
+	        _gatewayFirmwareDir);
+}
+
+static const gatewayFirmware_t *_gatewayFirmwareFind(const uint16_t type, const uint16_t version,
+        const bool newest)
+{
+	const gatewayFirmware_t *found = NULL;
+	for (uint16_t i = 0; i < _gatewayFirmwareCount; i++) {
+		const gatewayFirmware_t &firmware = _gatewayFirmware[i];
+		if (firmware.type == type && (newest ? (!found || firmware.version > found->version) :
+		                              firmware.version == version)) {
+			found = &firmware;
+		}
+	}
+	return found;
+}
+
+// the controller is told about the progress with log messages on behalf of the node
+static void _gatewayFirmwareReport(const nodeId_t nodeId, const char *text)
+{
+	build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_LOG_MESSAGE).set(text);
+	_msgTmp.sender = nodeId;
+	(void)gatewayTransportSend(_msgTmp);
+}
+
+static void _gatewayFirmwareSend(const nodeId_t nodeId, const gatewayFirmware_t &firmware,
+                                 const uint16_t block)
+{
+	replyFirmwareBlock_t reply;
+	reply.type = firmware.type;
+	reply.version = firmware.version;
+	reply.block = block;
+	_gatewayFirmwareBlock(firmware, block, reply.data);
+	(void)transportQueueRoute(build(_msgTmp, nodeId, NODE_SENSOR_ID, C_STREAM,
+	                                ST_FIRMWARE_RESPONSE).set(&reply, sizeof(replyFirmwareBlock_t)));
+	if (block == 0) {
+		GATEWAY_DEBUG(PSTR("GWT:FWS:DONE,N=%" PRIuNodeId "\n"), nodeId);
+		_gatewayFirmwareReport(nodeId, "OTA:DONE");
+	} else if (block % GATEWAY_FIRMWARE_PROGRESS_BLOCKS == 0) {
+		char text[MAX_PAYLOAD + 1];
+		(void)snprintf(text, sizeof(text), "OTA:B=%04X", (unsigned int)block);
+		_gatewayFirmwareReport(nodeId, text);
+	}
+}
+
+void gatewayTransportFirmwareOpen(const char *directory)
+{
+	free(_gatewayFirmwareDir);
+	_gatewayFirmwareDir = directory ? strdup(directory) : NULL;
+	if (_gatewayFirmwareDir) {
+		_gatewayFirmwareScan();
+	} else {
+		_gatewayFirmwareUnmap();
+	}
+}
+
+bool gatewayTransportFirmwareReply(const MyMessage &request)
+{
+	if (!_gatewayFirmwareDir) {
+		return false;
+	}
+	if (request.type == ST_FIRMWARE_CONFIG_REQUEST) {
+		// images are added by moving them into the directory, which changes its time stamp
+		struct stat dirInfo;
+		if (stat(_gatewayFirmwareDir, &dirInfo) == 0 &&
+		        (dirInfo.st_mtim.tv_sec != _gatewayFirmwareDirChanged.tv_sec ||
+		         dirInfo.st_mtim.tv_nsec != _gatewayFirmwareDirChanged.tv_nsec)) {
+			_gatewayFirmwareScan();
+		}
+		const requestFirmwareConfig_t *current = (const requestFirmwareConfig_t *)request.data;
+		const gatewayFirmware_t *firmware = _gatewayFirmwareFind(current->type, 0, true);
+		if (!firmware) {
+			return false;
+		}
+		nodeFirmwareConfig_t config;
+		config.type = firmware->type;
+		config.version = firmware->version;
+		config.blocks = firmware->blocks;
+		config.crc = firmware->crc;
+		GATEWAY_DEBUG(PSTR("GWT:FWS:CONFIG,N=%" PRIuNodeId ",T=%" PRIu16 ",V=%" PRIu16 "\n"), request.sender,
+		              config.type, config.version);
+		const bool sent = transportQueueRoute(build(_msgTmp, request.sender, NODE_SENSOR_ID, C_STREAM,
+		                                      ST_FIRMWARE_CONFIG_RESPONSE).set(&config, sizeof(nodeFirmwareConfig_t)));
+		if (sent && memcmp(current, &config, sizeof(nodeFirmwareConfig_t)) != 0) {
+			char text[MAX_PAYLOAD + 1];
+			(void)snprintf(text, sizeof(text), "OTA:T=%04X,V=%04X,B=%04X", (unsigned int)config.type,
+			               (unsigned int)config.version, (unsigned int)config.blocks);
+			_gatewayFirmwareReport(request.sender, text);
+		}
+		return sent;
+	}
+	if (request.type == ST_FIRMWARE_REQUEST) {
+		const requestFirmwareBlock_t *blockRequest = (const requestFirmwareBlock_t *)request.data;
+		const gatewayFirmware_t *firmware = _gatewayFirmwareFind(blockRequest->type,
+		                                    blockRequest->version, false);
+		if (!firmware || blockRequest->block >= firmware->blocks) {
+			return false;
+		}
+		_gatewayFirmwareSend(request.sender, *firmware, blockRequest->block);
+		return true;
+	}
+	if (request.type == ST_FIRMWARE_REQUEST_WINDOW) {
+		// answered block by block, LZ and delta responses are left to the controller
+		const requestFirmwareWindow_t *window = (const requestFirmwareWindow_t *)request.data;
+		const gatewayFirmware_t *firmware = _gatewayFirmwareFind(window->type, window->version, false);
+		if (!firmware || window->block >= firmware->blocks) {
+			return false;
+		}
+		for (uint8_t n = 0; n < 32 && n <= window->block; n++) {
+			if (window->missing & ((uint32_t)1 << n)) {
+				_gatewayFirmwareSend(request.sender, *firmware, window->block - n);
+			}
+		}
+		return true;
+	}
+	return false;
+}
+#endif
+
+#if defined(MY_GATEWAY_TIME_BEACON) && defined(MY_SENSOR_NETWORK)
+static uint32_t _gatewayTimeNow(void)
+{
+	return _gatewayTime + (hwMillis() - _gatewayTimeAt) / 1000ul;
+}
+
+static void _gatewayTimeStore(const MyMessage &message)
+{
+	_gatewayTime = message.getULong();
+	_gatewayTimeAt = hwMillis();
+	_gatewayTimeValid = true;
+}
+
+static void _gatewayTimeProcess(void)
+{
+	if ((int32_t)(hwMillis() - _gatewayTimeDue) < 0) {
+		return;
+	}
+	// the answer is broadcast as beacon, a failed request is repeated soon
+	const bool sent = gatewayTransportSend(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+	                                       I_TIME).set(""));
+	_gatewayTimeDue = hwMillis() + (sent ? MY_GATEWAY_TIME_BEACON_INTERVAL_MS :
+	                                MY_GATEWAY_TIME_BEACON_RETRY_MS);
+}
+
+bool gatewayTransportTimeReply(const MyMessage &request)
+{
+	if (!_gatewayTimeValid ||
+	        (uint32_t)(hwMillis() - _gatewayTimeAt) > 2 * MY_GATEWAY_TIME_BEACON_INTERVAL_MS) {
+		// ask the controller
+		return false;
+	}
+	return transportQueueRoute(build(_msgTmp, request.sender, NODE_SENSOR_ID, C_INTERNAL,
+	                                 I_TIME).set(_gatewayTimeNow()));
+}
+#endif
+
+#if defined(MY_GATEWAY_FLOW_CONTROL) && defined(MY_SENSOR_NETWORK)
+static void _gatewayFlowReport(const uint8_t queued, const uint8_t credit)
+{
+	char payload[8];
+	(void)snprintf_P(payload, sizeof(payload), PSTR("%" PRIu8 ",%" PRIu8), queued, credit);
+	if (gatewayTransportSend(buildGw(_msgTmp, I_FLOW_CONTROL).set(payload))) {
+		_gatewayFlowQueued = queued;
+		_gatewayFlowCredit = credit;
+	}
+	_gatewayFlowSentAt = hwMillis();
+}
+
+static void _gatewayFlowProcess(void)
+{
+	const uint8_t queued = transportTxQueuePending();
+	// commands have a queue of their own with MY_TRANSPORT_TX_QUEUE_PRIORITY
+	const uint8_t credit = transportTxQueueFree(TRANSPORT_TX_PRIORITY_CONTROL);
+	if (queued == _gatewayFlowQueued && credit == _gatewayFlowCredit) {
+		return;
+	}
+	const uint8_t fill = (uint8_t)((MY_TRANSPORT_TX_QUEUE_SIZE - credit) * 100u /
+	                               MY_TRANSPORT_TX_QUEUE_SIZE);
+	// crossing a threshold is reported right away, the hysteresis keeps it from flapping
+	bool urgent = false;
+	if (!_gatewayFlowCongested && fill >= MY_GATEWAY_FLOW_CONTROL_HIGH) {
+		_gatewayFlowCongested = true;
+		urgent = true;
+	} else if (_gatewayFlowCongested && fill <= MY_GATEWAY_FLOW_CONTROL_LOW) {
+		_gatewayFlowCongested = false;
+		urgent = true;
+	}
+	if (urgent || (uint32_t)(hwMillis() - _gatewayFlowSentAt) >= MY_GATEWAY_FLOW_CONTROL_INTERVAL_MS) {
+		GATEWAY_DEBUG(PSTR("GWT:FLW:Q=%" PRIu8 ",C=%" PRIu8 ",F=%" PRIu8 "\n"), queued, credit, fill);
+		_gatewayFlowReport(queued, credit);
+	}
+}
+#endif
+
+static void _gatewayTransportRoute(void)
+{
+	if (_msg.destination == GATEWAY_ADDRESS) {
+
+		// Check if sender requests an echo
+		if (mGetRequestEcho(_msg)) {
+			// Copy message
+			_msgTmp = _msg;
+			// Reply without echo flag, otherwise we would end up in an eternal loop
+			mSetRequestEcho(_msgTmp,
+			                false);
+			mSetEcho(_msgTmp, true);
+			_msgTmp.sender = getNodeId();
+			_msgTmp.destination = _msg.sender;
+			gatewayTransportSend(_msgTmp);
+		}
+		if (mGetCommand(_msg) == C_INTERNAL) {
+			if (_msg.type == I_VERSION) {
+				// Request for version. Create the response
+				gatewayTransportSend(buildGw(_msgTmp, I_VERSION).set(MYSENSORS_LIBRARY_VERSION));
 #ifdef MY_INCLUSION_MODE_FEATURE
-				} else if (_msg.type == I_INCLUSION_MODE) {
-					// Request to change inclusion mode
-					inclusionModeSet(atoi(_msg.data) == 1);
+			} else if (_msg.type == I_INCLUSION_MODE) {
+				// Request to change inclusion mode
+				inclusionModeSet(atoi(_msg.data) == 1);
+#endif
+#if defined(MY_GATEWAY_TIME_BEACON) && defined(MY_SENSOR_NETWORK)
+			} else if (_msg.type == I_TIME) {
+				// one broadcast serves all nodes
+				_gatewayTimeStore(_msg);
+				(void)transportQueueRoute(build(_msgTmp, BROADCAST_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+				                                I_TIME).set(_gatewayTime));
+				(void)_processInternalCoreMessage();
+#endif
+#if defined(MY_GATEWAY_FLOW_CONTROL) && defined(MY_SENSOR_NETWORK)
+			} else if (_msg.type == I_FLOW_CONTROL) {
+				_gatewayFlowReport(transportTxQueuePending(),
+				                   transportTxQueueFree(TRANSPORT_TX_PRIORITY_CONTROL));
 #endif
-				} else {
-					(void)_processInternalCoreMessage();
-				}
 			} else {
-				// Call incoming message callback if available
-				if (receive) {
-					receive(_msg);
-				}
+				(void)_processInternalCoreMessage();
 			}
 		} else {
+			// Call incoming message callback if available
+			if (receive) {
+				receive(_msg);
+			}
+		}
+	} else {
 #if defined(MY_SENSOR_NETWORK)
-			transportSendRoute(_msg);
+#if defined(MY_GATEWAY_TIME_BEACON)
+		if (mGetCommand(_msg) == C_INTERNAL && _msg.type == I_TIME) {
+			_gatewayTimeStore(_msg);
+		}
+#endif
+#if defined(MY_GATEWAY_MAILBOX)
+		if (_gatewayMailboxStore(_msg)) {
+			return;
+		}
 #endif
+#if defined(MY_GATEWAY_OUTBOX)
+		if (_gatewayOutboxStore(_msg)) {
+			return;
 		}
+#endif
+		// the next controller message does not have to wait for the radio
+		(void)transportQueueRoute(_msg);
+#endif
+	}
+}
+
+inline void gatewayTransportProcess(void)
+{
+	// route every message that is complete, bounded to keep the sensor network serviced
+#if defined(MY_GATEWAY_MAILBOX) && defined(MY_SENSOR_NETWORK)
+	_gatewayMailboxProcess();
+#endif
+#if defined(MY_GATEWAY_OUTBOX) && defined(MY_SENSOR_NETWORK)
+	_gatewayOutboxProcess();
+#endif
+#if defined(MY_GATEWAY_STANDBY)
+	_gatewayStandbyProcess();
+#endif
+#if defined(MY_GATEWAY_TIME_BEACON) && defined(MY_SENSOR_NETWORK)
+	_gatewayTimeProcess();
+#endif
+#if defined(MY_GATEWAY_FLOW_CONTROL) && defined(MY_SENSOR_NETWORK)
+	_gatewayFlowProcess();
+#endif
+#if defined(MY_GATEWAY_PRESENTATION_CACHE) && defined(MY_SENSOR_NETWORK) && defined(__linux__)
+	if (_gatewayCacheDirty &&
+	        (uint32_t)(hwMillis() - _gatewayCacheChangedAt) >= MY_GATEWAY_PRESENTATION_CACHE_SAVE_MS) {
+		gatewayTransportCacheSave();
+	}
+#endif
+	const uint32_t started = hwMicros();
+	for (uint8_t count = 0; count < MY_GATEWAY_RX_BATCH_SIZE &&
+	        (count == 0 || (uint32_t)(hwMicros() - started) < MY_GATEWAY_RX_BUDGET_US); count++) {
+#if defined(MY_GATEWAY_CONTROLLER_THREAD)
+		// the controller thread reads from the driver
+		if (!gatewayThreadReceive(_msg)) {
+			return;
+		}
+#else
+#if defined(MY_GATEWAY_SECONDARY_TCP_PORT)
+		// the first link is served first, the second one when the first has nothing
+		if (gatewayTransportAvailable()) {
+			_msg = gatewayTransportReceive();
+		} else if (gatewaySecondaryAvailable()) {
+			_msg = gatewaySecondaryReceive();
+		} else {
+			return;
+		}
+#else
+		if (!gatewayTransportAvailable()) {
+			return;
+		}
+		_msg = gatewayTransportReceive();
+#endif
+		STATS_DOWNLINK_BEGIN(statsLatencyStamp());
+#endif
+		STATS_INC(STATS_GW_RX_MESSAGES);
+		STATS_DOWNLINK(STATS_LATENCY_DOWNLINK_DEQUEUE);
+		_gatewayTransportRoute();
+		STATS_DOWNLINK_END();
+	}
+#if defined(MY_GATEWAY_LINUX)
+	// input may be left in the driver buffers, come back without sleeping
+	eventLoopWakeup();
+#endif
+}
+
+bool gatewayTransportReconnectDue(void)
+{
+	return _gatewayReconnectDelay == 0 || (int32_t)(hwMillis() - _gatewayReconnectAt) >= 0;
+}
+
+void gatewayTransportReconnectResult(const bool success)
+{
+	if (success) {
+		_gatewayReconnectDelay = 0;
+		return;
+	}
+	// double the delay after every failed attempt
+	_gatewayReconnectDelay = _gatewayReconnectDelay == 0 ? MY_GATEWAY_RECONNECT_MIN_DELAY_MS :
+	                         _gatewayReconnectDelay * 2;
+	if (_gatewayReconnectDelay > MY_GATEWAY_RECONNECT_MAX_DELAY_MS) {
+		_gatewayReconnectDelay = MY_GATEWAY_RECONNECT_MAX_DELAY_MS;
 	}
+	_gatewayReconnectAt = hwMillis() + _gatewayReconnectDelay;
 }
@@ -35,8 +35,12 @@
 *  - GWT:<b>RMQ</b>		from reconnectMQTT()
 *  - GWT:<b>TPC</b>		from gatewayTransportConnect()
 *  - GWT:<b>RFC</b>		from _readFromClient()
+*  - GWT:<b>CTC</b>		from _connectToController()
 *  - GWT:<b>TSA</b>		from @ref gatewayTransportAvailable()
 *  - GWT:<b>TRC</b>		from @ref gatewayTransportReceive()
+*  - GWT:<b>THR</b>		from the controller thread (@ref MY_LINUX_THREADED_GATEWAY, @ref MY_ESP32_DUAL_CORE_GATEWAY)
+*  - GWT:<b>MBX</b>		from the mailbox for sleeping nodes (@ref MY_GATEWAY_MAILBOX)
+*  - GWT:<b>OBX</b>		from the outbox of controller messages (@ref MY_GATEWAY_OUTBOX)
 *
 * Gateway transport debug log messages :
 *
@@ -47,9 +51,11 @@
 * |!| GWT | TIN   | DHCP FAIL                 | DHCP request failed
 * | | GWT | TIN   | ETH OK                    | Connected to network
 * |!| GWT | TIN   | ETH FAIL                  | Connection failed
+* | | GWT | TIN   | GSM ASYNC                 | Modem is brought up in the background (MY_GSM_ASYNC)
+* |!| GWT | TIN   | MQTT BUFFER SIZE          | MQTT packet buffer could not be resized
 * | | GWT | TPS   | TOPIC=%%s,MSG SENT        | MQTT message sent on topic [%%s]
-* | | GWT | TPS   | ETH OK                    | Connected to network
-* |!| GWT | TPS   | ETH FAIL                  | Connection failed
+* |!| GWT | TPS   | QUEUE FULL                | MQTT outbound queue full, message dropped
+* | | GWT | TPS   | N=%%d,S=%%d,T=%%d,UNCHANGED   | Retained MQTT publish of node [%%d], sensor [%%d], type [%%d] skipped, same payload as the last one
 * | | GWT | IMQ   | TOPIC=%%s,MSG RECEIVE     | MQTT message received on topic [%%s]
 * | | GWT | RMQ   | CONNECTING...             | Connecting to MQTT broker
 * | | GWT | RMQ   | OK                        | Connected to MQTT broker
@@ -59,13 +65,35 @@
 * |!| GWT | TPC   | DHCP FAIL                 | DHCP request failed
 * | | GWT | RFC   | C=%%d,MSG=%%s             | Received message [%%s] from client [%%d]
 * |!| GWT | RFC   | C=%%d,MSG TOO LONG        | Received message from client [%%d] too long
+* | | GWT | RFC   | C=%%d,FLT=%%d-%%d,%%d,%%d     | Client [%%d] wants senders [%%d] to [%%d], commands mask [%%d], type [%%d]
+* | | GWT | CTC   | ETH OK                    | Connected to controller
+* |!| GWT | CTC   | ETH FAIL                  | Connection to controller failed, retried after a backoff
 * | | GWT | TSA   | UDP MSG=%%s               | Received UDP message [%%s]
 * | | GWT | TSA   | ETH OK                    | Connected to network
 * |!| GWT | TSA   | ETH FAIL                  | Connection failed
 * | | GWT | TSA   | C=%d,DISCONNECTED         | Client [%%d] disconnected
 * | | GWT | TSA   | C=%d,CONNECTED            | Client [%%d] connected
 * |!| GWT | TSA   | NO FREE SLOT              | No free slot for client
+* |!| GWT | TSA   | UART OVR,N=%d,HW=%d       | Modem UART buffer overrun, [%%d] in total, high-water mark [%%d] bytes
 * |!| GWT | TRC   | IP RENEW FAIL             | IP renewal failed
+* | | GWT | PCH   | DIGEST,N=%%d,KNOWN=%%d      | Presentation digest of node [%%d] answered, matches the cache [%%d]: 0 no, 1 yes, 2 without signing requirements (@ref MY_PRESENTATION_DIGEST)
+* | | GWT | THR   | START                     | Controller thread started
+* |!| GWT | THR   | START FAIL                | Controller thread could not be started
+* |!| GWT | THR   | QUEUE FAIL                | Queues of the controller task could not be allocated
+* |!| GWT | THR   | TX DROP,N=%%d             | Queue to controller full, message dropped, [%%d] drops in total
+* |!| GWT | THR   | RX BP,N=%%d               | Queue from controller full, reading paused, [%%d] times in total
+* | | GWT | MBX   | STORE,N=%%d,C=%%d         | Message for sleeping node [%%d] stored, [%%d] messages buffered for it
+* |!| GWT | MBX   | DROP,N=%%d                | Mailbox full, oldest message for node [%%d] dropped
+* | | GWT | MBX   | DELIVER,N=%%d             | Node [%%d] awake, buffered messages sent
+* | | GWT | MBX   | ACK PL,N=%%d              | Oldest message for node [%%d] sent in the ACK of its frame
+* | | GWT | MBX   | REL,N=%%d                 | Node [%%d] released after the burst
+* | | GWT | OBX   | STORE,N=%%d,C=%%d         | Message for node [%%d] stored in the outbox, [%%d] messages pending
+* |!| GWT | OBX   | DROP,N=%%d                | Outbox full, oldest message for node [%%d] dropped
+* | | GWT | OBX   | DELIVER,N=%%d,A=%%d       | Message delivered to node [%%d] after [%%d] retries
+* |!| GWT | OBX   | RETRY,N=%%d,A=%%d         | Message to node [%%d] not acknowledged, retried later, [%%d] failed attempts
+* |!| GWT | OBX   | EXPIRE,N=%%d,A=%%d        | Message to node [%%d] expired after [%%d] failed attempts
+* | | GWT | FWS   | CONFIG,N=%%d,T=%%d,V=%%d    | Node [%%d] offered firmware type [%%d] version [%%d] from the image files
+* | | GWT | FWS   | DONE,N=%%d                | Last firmware block sent to node [%%d]
 *
 * @brief API declaration for MyGatewayTransport
 *
@@ -105,6 +133,9 @@ bool gatewayTransportSend(MyMessage &message);
 
 /**
  * @brief Check if a new message is available from controller
+ *
+ * Called repeatedly until it returns false, each call makes the next complete message
+ * available. Transports with several clients take turns between them.
  * @return true if message available
  */
 bool gatewayTransportAvailable(void);
@@ -115,6 +146,258 @@ bool gatewayTransportAvailable(void);
  */
 MyMessage& gatewayTransportReceive(void);
 
+#if defined(MY_GATEWAY_SERIAL_BUFFERED)
+/**
+ * @brief Write the messages buffered since the last call to the serial device
+ */
+void gatewayTransportFlush(void);
+#endif
+
+/**
+ * @brief Check if the reconnect backoff allows a new connection attempt to the controller
+ * @return true if a connection attempt may be started
+ */
+bool gatewayTransportReconnectDue(void);
+
+/**
+ * @brief Update the reconnect backoff after a connection attempt to the controller
+ *
+ * Failed attempts double the delay from @ref MY_GATEWAY_RECONNECT_MIN_DELAY_MS up to
+ * @ref MY_GATEWAY_RECONNECT_MAX_DELAY_MS, a successful attempt resets it.
+ * @param success true if the attempt succeeded
+ */
+void gatewayTransportReconnectResult(const bool success);
+
+#if defined(MY_GATEWAY_MAILBOX)
+/**
+ * @brief Notify the mailbox about a frame received from a node
+ *
+ * Buffered messages for the node are sent with the next call of gatewayTransportProcess().
+ * @param nodeId sender of the frame
+ * @param preSleep true if the frame is an I_PRE_SLEEP_NOTIFICATION, the node is released
+ * after the burst and considered asleep until its next frame
+ */
+void gatewayTransportMailboxWake(const nodeId_t nodeId, const bool preSleep);
+#endif
+
+#if defined(MY_GATEWAY_TIME_BEACON)
+/**
+ * @brief Answer an I_TIME request of a node with the controller time cached on the GW
+ * @param request I_TIME request
+ * @return false if no recent controller time is cached, the request goes to the controller then
+ */
+bool gatewayTransportTimeReply(const MyMessage &request);
+#endif
+
+#if defined(MY_GATEWAY_PRESENTATION_CACHE)
+/**
+ * @brief Remember a message handed to the controller if it is a presentation, sketch info or value
+ *
+ * A newer message replaces the cached one of the same node, child, command and type.
+ * @param message received from a node
+ */
+void gatewayTransportCacheStore(const MyMessage &message);
+
+/**
+ * @brief Send all cached messages to the controller, presentations and sketch info first
+ */
+void gatewayTransportCacheReplay(void);
+
+/**
+ * @brief Answer the presentation digest of a booting node
+ *
+ * The reply is PRESENTATION_DIGEST_KNOWN if the digest matches the presentation and sketch info
+ * cached for the node and the signing requirements in the tables, the node does not present
+ * itself then. Nodes of older versions leave out the signing requirements and get
+ * PRESENTATION_DIGEST_KNOWN_LEGACY.
+ * @param request I_PRESENTATION_DIGEST of the node
+ */
+void gatewayTransportCacheDigestReply(const MyMessage &request);
+
+#if defined(__linux__)
+/**
+ * @brief Fill the cache from a file, later changes are saved to the same file
+ * @param fileName cache file, NULL keeps the cache in memory only
+ */
+void gatewayTransportCacheLoad(const char *fileName);
+
+/**
+ * @brief Write the cache file now if the cache changed since it was saved
+ */
+void gatewayTransportCacheSave(void);
+#endif
+#endif
+
+#if defined(MY_GATEWAY_OUTBOX)
+/**
+ * @brief Keep the outbox in a memory mapped file, pending messages of the file are sent again
+ * @param fileName outbox file, created if it does not exist
+ */
+void gatewayTransportOutboxOpen(const char *fileName);
+
+/**
+ * @brief Write the outbox file and unmap it, the outbox is empty and in memory afterwards
+ */
+void gatewayTransportOutboxClose(void);
+#endif
+
+#if defined(MY_GATEWAY_FIRMWARE_SERVER)
+/**
+ * @brief Serve OTA firmware from the image files of a directory, see @ref MY_GATEWAY_FIRMWARE_SERVER
+ *
+ * Maps all images again, e.g. after new ones were added.
+ * @param directory directory of the images, NULL stops serving
+ */
+void gatewayTransportFirmwareOpen(const char *directory);
+
+/**
+ * @brief Answer a firmware config or block request of a node from the image files
+ * @param request C_STREAM message of the node
+ * @return false if no image matches, the request goes to the controller then
+ */
+bool gatewayTransportFirmwareReply(const MyMessage &request);
+#endif
+
+#if defined(MY_GATEWAY_STANDBY)
+/**
+ * @brief Mirror the active gateway at peer until its heartbeat stops, see @ref MY_GATEWAY_STANDBY
+ *
+ * Called before _begin(), the radio stays off meanwhile. Call gatewayTransportStandbyTakeOver()
+ * after _begin() to apply what was mirrored.
+ * @param peer host of the active gateway
+ * @param port its standby_port
+ */
+void gatewayTransportStandbyFollow(const char *peer, const uint16_t port);
+
+/**
+ * @brief Take over the routes, nonces and outbox mirrored by gatewayTransportStandbyFollow()
+ */
+void gatewayTransportStandbyTakeOver(void);
+
+/**
+ * @brief Replicate a route to the standby, called by transportSetRoute()
+ * @param node
+ * @param route BROADCAST_ADDRESS if the route was cleared
+ */
+void gatewayTransportStandbyRoute(const nodeId_t node, const nodeId_t route);
+
+/**
+ * @brief Replicate the clearing of the routing table to the standby
+ */
+void gatewayTransportStandbyRoutesCleared(void);
+
+/**
+ * @brief Replicate a verification nonce to the standby
+ * @param nodeId peer the nonce was generated for
+ * @param nonce the nonce, NULL if it was taken
+ */
+void gatewayTransportStandbyNonce(const uint8_t nodeId, const uint8_t *nonce);
+#endif
+
+#if defined(MY_GATEWAY_SECONDARY_TCP_PORT)
+/**
+ * @brief Start the TCP server of the second controller link, see @ref MY_GATEWAY_SECONDARY_TCP_PORT
+ * @return true if started
+ */
+bool gatewaySecondaryInit(void);
+
+/**
+ * @brief Send a message to the clients of the second controller link
+ * @param message to send
+ * @param line message already formatted by protocolMyMessage2Serial(), NULL to format it here
+ * @param length length of line
+ */
+void gatewaySecondarySend(MyMessage &message, const char *line, size_t length);
+
+/**
+ * @brief Accept and serve clients of the second controller link
+ * @return true if a message was received, see gatewaySecondaryReceive()
+ */
+bool gatewaySecondaryAvailable(void);
+
+/**
+ * @brief Pick up the message received from the second controller link
+ * @return message
+ */
+MyMessage &gatewaySecondaryReceive(void);
+#endif
+
+#if defined(MY_GATEWAY_MQTT_CLIENT) && defined(MY_MQTT_CLIENT_PUBLISH_QOS1)
+/**
+ * @brief Counters of the MQTT outbound queue
+ */
+typedef struct {
+	uint32_t published;	//!< QoS1 publishes sent, including resends
+	uint32_t acknowledged;	//!< Publishes acknowledged by the broker
+	uint32_t resent;	//!< Publishes sent again after a reconnect
+	uint32_t dropped;	//!< Messages dropped because the queue was full
+	uint8_t highWater;	//!< Largest number of messages queued at the same time
+	uint8_t queued;		//!< Messages currently queued, including the ones in flight
+	uint8_t inflight;	//!< Publishes currently awaiting their PUBACK
+} gatewayMQTTStats_t;
+
+/**
+ * @brief Get the MQTT outbound queue counters
+ * @return snapshot of the counters
+ */
+gatewayMQTTStats_t gatewayMQTTGetStats(void);
+#endif
+
+#if defined(MY_GATEWAY_CONTROLLER_THREAD)
+/**
+ * @brief Message counters of the controller thread queues
+ */
+typedef struct {
+	uint32_t txQueued;		//!< Messages queued for the controller
+	uint32_t txDropped;		//!< Messages dropped because the queue to the controller was full
+	uint32_t rxQueued;		//!< Messages queued for the core
+	uint32_t rxBackpressure;	//!< Times reading from the controller paused because the queue to the core was full
+} gatewayThreadStats_t;
+
+/**
+ * @brief Start the controller thread, it initializes and then owns the gateway transport driver
+ * @return true if @ref gatewayTransportInit() succeeded on the controller thread
+ */
+bool gatewayThreadInit(void);
+
+/**
+ * @brief Check if the caller runs on the controller thread
+ * @return true if called from the controller thread
+ */
+bool gatewayThreadIsController(void);
+
+/**
+ * @brief Check if the caller must hand messages over to the controller thread
+ * @return true if the controller thread is running and the caller is not it
+ */
+bool gatewayThreadIsCore(void);
+
+/**
+ * @brief Queue a message for the controller, must be called from the core thread
+ * @param message to send
+ * @return true if message queued, false if dropped
+ */
+bool gatewayThreadSend(MyMessage &message);
+
+/**
+ * @brief Pick up the next message received from the controller, must be called from the core thread
+ * @param message receives the message
+ * @return true if a message was available
+ */
+bool gatewayThreadReceive(MyMessage &message);
+
+/**
+ * @brief Ask the core thread to present the node, called from the controller thread
+ */
+void gatewayThreadPresentNode(void);
+
+/**
+ * @brief Get the queue counters
+ * @return snapshot of the counters
+ */
+gatewayThreadStats_t gatewayThreadGetStats(void);
+#endif
+
 #endif /* MyGatewayTransportEthernet_h */
 
 /** @}*/
@@ -20,7 +20,13 @@
 #include "MyGatewayTransport.h"
 
 // global variables
+#if defined(MY_GATEWAY_CONTROLLER_THREAD)
+// used on the controller thread, _msgTmp belongs to the core thread
+static MyMessage _ethernetMsgTmp;
+#else
 extern MyMessage _msgTmp;
+static MyMessage &_ethernetMsgTmp = _msgTmp;
+#endif
 
 // housekeeping, remove for 3.0.0
 #ifdef MY_ESP8266_SSID
@@ -76,6 +82,7 @@ extern MyMessage _msgTmp;
 uint8_t _ethernetGatewayMAC[] = { MY_MAC_ADDRESS };
 uint16_t _ethernetGatewayPort = MY_PORT;
 MyMessage _ethernetMsg;
+static MyMessage *_ethernetRxMsg = &_ethernetMsg;	// last parsed message
 
 #define ARRAY_SIZE(x)  (sizeof(x)/sizeof(x[0]))
 
@@ -83,9 +90,19 @@ typedef struct {
 	// Suppress the warning about unused members in this struct because it is used through a complex
 	// set of preprocessor directives
 	// cppcheck-suppress unusedStructMember
-	char string[MY_GATEWAY_MAX_RECEIVE_LENGTH];
+	protocolParser_t parser;
+	// cppcheck-suppress unusedStructMember
+	MyMessage message;	// parsed in place, bytes of several clients may interleave
+#if defined(MY_GATEWAY_CLIENT_FILTER)
+	// cppcheck-suppress unusedStructMember
+	uint8_t filterFirst;	// lowest sender sent to the client
+	// cppcheck-suppress unusedStructMember
+	uint8_t filterLast;	// highest sender sent to the client
+	// cppcheck-suppress unusedStructMember
+	uint8_t filterCommands;	// bit per command sent to the client
 	// cppcheck-suppress unusedStructMember
-	uint8_t idx;
+	uint8_t filterType;	// type sent to the client, 0xFF for all
+#endif
 } inputBuffer;
 
 #if defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32)
@@ -106,21 +123,99 @@ EthernetServer _ethernetServer(_ethernetGatewayPort);
 #endif /* End of MY_GATEWAY_CLIENT_MODE */
 
 #if defined(MY_GATEWAY_CLIENT_MODE)
-static inputBuffer inputString;
 #if defined(MY_USE_UDP)
-// Nothing to do here
+// messages are parsed straight from the datagram, one per gatewayTransportAvailable() call
+static protocolParser_t _ethernetParser;
+// outbound datagram being filled, it is buffered by the network module until endPacket()
+static uint16_t _ethernetUdpTxLength = 0;
+static uint32_t _ethernetUdpTxSince = 0;
 #else
+static protocolParser_t _ethernetParser;
 static EthernetClient client = EthernetClient();
 #endif /* End of MY_USE_UDP */
 #elif defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32) || defined(MY_GATEWAY_LINUX)
 static EthernetClient clients[MY_GATEWAY_MAX_CLIENTS];
 static bool clientsConnected[MY_GATEWAY_MAX_CLIENTS];
 static inputBuffer inputString[MY_GATEWAY_MAX_CLIENTS];
+// the scan for complete lines resumes after the client that delivered the last one
+static uint8_t _ethernetRxClient = 0;
+
+#if defined(MY_LINUX_ETHERNET_SHM_RING)
+static MyMessage _ethernetShmMsg;	// taken from the shared-memory ring
+#endif /* End of MY_LINUX_ETHERNET_SHM_RING */
+
+#if defined(MY_GATEWAY_LINUX)
+// slot of a client socket reported by the server, MY_GATEWAY_MAX_CLIENTS if none
+static uint8_t _ethernetClientSlot(const int sock)
+{
+	for (uint8_t i = 0; i < ARRAY_SIZE(clients); i++) {
+		if (clientsConnected[i] && clients[i].getSocketNumber() == sock) {
+			return i;
+		}
+	}
+	return ARRAY_SIZE(clients);
+}
+#endif /* End of MY_GATEWAY_LINUX */
+
+#if defined(MY_GATEWAY_CLIENT_FILTER)
+// set the filter of a client from an I_GATEWAY_FILTER payload, an empty one forwards everything
+static void _clientFilterSet(inputBuffer &input, const char *payload)
+{
+	input.filterFirst = 0;
+	input.filterLast = 0xFF;
+	input.filterCommands = 0xFF;
+	input.filterType = 0xFF;
+	if (payload == NULL || !*payload) {
+		return;
+	}
+	char *end;
+	input.filterFirst = (uint8_t)strtoul(payload, &end, 10);
+	if (*end == ',') {
+		input.filterLast = (uint8_t)strtoul(end + 1, &end, 10);
+	}
+	if (*end == ',') {
+		input.filterCommands = (uint8_t)strtoul(end + 1, &end, 10);
+	}
+	if (*end == ',') {
+		input.filterType = (uint8_t)strtoul(end + 1, &end, 10);
+	}
+}
+
+static bool _clientFilterPass(const inputBuffer &input, const MyMessage &message)
+{
+	if (message.sender == GATEWAY_ADDRESS) {
+		// ready, log and replies of the GW, every client needs them
+		return true;
+	}
+	return message.sender >= input.filterFirst && message.sender <= input.filterLast &&
+	       (input.filterCommands & (1u << mGetCommand(message))) &&
+	       (input.filterType == 0xFF || input.filterType == message.type);
+}
+#endif /* End of MY_GATEWAY_CLIENT_FILTER */
 #else /* Else part of MY_GATEWAY_CLIENT_MODE */
 static EthernetClient client = EthernetClient();
-static inputBuffer inputString;
+static protocolParser_t _ethernetParser;
 #endif /* End of MY_GATEWAY_CLIENT_MODE */
 
+#if defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32)
+static bool _ethernetWiFiConnected = false;
+
+// The station associates in the background, nothing is exchanged before it has an address
+static bool _ethernetWiFiReady(void)
+{
+	const bool connected = WiFi.status() == WL_CONNECTED;
+	if (connected != _ethernetWiFiConnected) {
+		_ethernetWiFiConnected = connected;
+		if (connected) {
+			GATEWAY_DEBUG(PSTR("GWT:TSA:IP=%s\n"), WiFi.localIP().toString().c_str());
+		} else {
+			GATEWAY_DEBUG(PSTR("!GWT:TSA:WIFI DISCONNECTED\n"));
+		}
+	}
+	return connected;
+}
+#endif /* End of MY_GATEWAY_ESP8266 || MY_GATEWAY_ESP32 */
+
 // On W5100 boards with SPI_EN exposed we can use the real SPI bus together with radio
 // (if we enable it during usage)
 void _w5100_spi_en(const bool enable)
@@ -140,6 +235,50 @@ void _w5100_spi_en(const bool enable)
 #endif
 }
 
+#if defined(MY_GATEWAY_CLIENT_MODE) && !defined(MY_USE_UDP)
+// Connect to the controller if not connected, failed attempts are retried with a backoff
+bool _connectToController(void)
+{
+	if (client.connected()) {
+		return true;
+	}
+#if defined(MY_GATEWAY_LINUX)
+	// a pending non-blocking connect is checked on every call
+	if (!client.connecting())
+#endif /* End of MY_GATEWAY_LINUX */
+	{
+		if (!gatewayTransportReconnectDue()) {
+			return false;
+		}
+		client.stop();
+	}
+#if defined(MY_CONTROLLER_URL_ADDRESS)
+	const int result = client.connect(MY_CONTROLLER_URL_ADDRESS, MY_PORT);
+#else
+	const int result = client.connect(_ethernetControllerIP, MY_PORT);
+#endif /* End of MY_CONTROLLER_URL_ADDRESS */
+	if (result == 1) {
+		gatewayTransportReconnectResult(true);
+		GATEWAY_DEBUG(PSTR("GWT:CTC:ETH OK\n"));
+		_w5100_spi_en(false);
+		gatewayTransportSend(buildGw(_ethernetMsgTmp, I_GATEWAY_READY).set(F(MSG_GW_STARTUP_COMPLETE)));
+		_w5100_spi_en(true);
+		// Send presentation of locally attached sensors (and node if applicable)
+		presentNode();
+		return true;
+	}
+#if defined(MY_GATEWAY_LINUX)
+	if (client.connecting()) {
+		return false;
+	}
+#endif /* End of MY_GATEWAY_LINUX */
+	client.stop();
+	gatewayTransportReconnectResult(false);
+	GATEWAY_DEBUG(PSTR("!GWT:CTC:ETH FAIL\n"));
+	return false;
+}
+#endif /* End of MY_GATEWAY_CLIENT_MODE && !MY_USE_UDP */
+
 #if !defined(MY_IP_ADDRESS) && defined(MY_GATEWAY_W5100)
 void gatewayTransportRenewIP(void)
 {
@@ -182,11 +321,8 @@ bool gatewayTransportInit(void)
 	WiFi.config(_ethernetGatewayIP, _gatewayIp, _subnetIp);
 #endif
 	(void)WiFi.begin(MY_WIFI_SSID, MY_WIFI_PASSWORD, 0, MY_WIFI_BSSID);
-	while (WiFi.status() != WL_CONNECTED) {
-		delay(1000);
-		GATEWAY_DEBUG(PSTR("GWT:TIN:CONNECTING...\n"));
-	}
-	GATEWAY_DEBUG(PSTR("GWT:TIN:IP: %s\n"), WiFi.localIP().toString().c_str());
+	// don't wait for the association, gatewayTransportAvailable() holds off until it is up
+	GATEWAY_DEBUG(PSTR("GWT:TIN:CONNECTING...\n"));
 #elif defined(MY_GATEWAY_LINUX)
 	// Nothing to do here
 #else
@@ -206,8 +342,7 @@ bool gatewayTransportInit(void)
 	GATEWAY_DEBUG(PSTR("GWT:TIN:IP=%" PRIu8 ".%" PRIu8 ".%" PRIu8 ".%" PRIu8 "\n"),
 	              Ethernet.localIP()[0],
 	              Ethernet.localIP()[1], Ethernet.localIP()[2], Ethernet.localIP()[3]);
-	// give the Ethernet interface a second to initialize
-	delay(1000);
+	// no settle delay, a first controller connection that fails is retried with the backoff
 #endif /* MY_GATEWAY_ESP8266 / MY_GATEWAY_ESP32 */
 
 #if defined(MY_GATEWAY_CLIENT_MODE)
@@ -217,20 +352,7 @@ bool gatewayTransportInit(void)
 #if defined(MY_GATEWAY_LINUX) && defined(MY_IP_ADDRESS)
 	client.bind(_ethernetGatewayIP);
 #endif /* End of MY_GATEWAY_LINUX && MY_IP_ADDRESS */
-#if defined(MY_CONTROLLER_URL_ADDRESS)
-	if (client.connect(MY_CONTROLLER_URL_ADDRESS, MY_PORT)) {
-#else
-	if (client.connect(_ethernetControllerIP, MY_PORT)) {
-#endif /* End of MY_CONTROLLER_URL_ADDRESS */
-		GATEWAY_DEBUG(PSTR("GWT:TIN:ETH OK\n"));
-		_w5100_spi_en(false);
-		gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set(F(MSG_GW_STARTUP_COMPLETE)));
-		_w5100_spi_en(true);
-		presentNode();
-	} else {
-		client.stop();
-		GATEWAY_DEBUG(PSTR("!GWT:TIN:ETH FAIL\n"));
-	}
+	(void)_connectToController();
 #endif /* End of MY_USE_UDP */
 #else /* Else part of MY_GATEWAY_CLIENT_MODE */
 #if defined(MY_GATEWAY_LINUX) && defined(MY_IP_ADDRESS)
@@ -239,65 +361,168 @@ bool gatewayTransportInit(void)
 	// we have to use pointers due to the constructor of EthernetServer
 	_ethernetServer.begin();
 #endif /* End of MY_GATEWAY_LINUX && MY_IP_ADDRESS */
+#if defined(MY_GATEWAY_LINUX)
+	_ethernetServer.setTxCoalescing(MY_LINUX_ETHERNET_TX_FLUSH_MS, MY_LINUX_ETHERNET_TX_FLUSH_SIZE);
+#if defined(MY_LINUX_ETHERNET_UNIX_SOCKET)
+	_ethernetServer.beginUnix(MY_LINUX_ETHERNET_UNIX_SOCKET);
+#endif /* End of MY_LINUX_ETHERNET_UNIX_SOCKET */
+#if defined(MY_LINUX_ETHERNET_SHM_RING)
+	(void)shmRingServe(MY_LINUX_ETHERNET_SHM_RING, MY_LINUX_ETHERNET_SHM_RING_SLOTS, sizeof(MyMessage));
+#endif /* End of MY_LINUX_ETHERNET_SHM_RING */
+#endif /* End of MY_GATEWAY_LINUX */
 #endif /* End of MY_GATEWAY_CLIENT_MODE */
 
 	_w5100_spi_en(false);
 	return true;
 }
 
+#if defined(MY_USE_UDP)
+// send the pending datagram, returns 1 if it was sent successfully or nothing was pending
+static int _ethernetUdpFlush(void)
+{
+	if (!_ethernetUdpTxLength) {
+		return 1;
+	}
+	_ethernetUdpTxLength = 0;
+	return _ethernetServer.endPacket();
+}
+#endif /* End of MY_USE_UDP */
+
 bool gatewayTransportSend(MyMessage &message)
 {
+#if defined(MY_GATEWAY_CONTROLLER_THREAD)
+	if (gatewayThreadIsCore()) {
+		return gatewayThreadSend(message);
+	}
+#endif
 	int nbytes = 0;
-	char *_ethernetMsg = protocolMyMessage2Serial(message);
+	size_t length;
+#if defined(MY_GATEWAY_BINARY_FRAMING) && \
+	(defined(MY_GATEWAY_CLIENT_MODE) || !(defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32) || defined(MY_GATEWAY_LINUX)))
+	// a single controller link, reply in the framing it used last
+	char *_ethernetMsg = protocolMyMessage2Frame(message, _ethernetParser, length);
+#else
+	char *_ethernetMsg = protocolMyMessage2Serial(message, length);
+#endif
+#if defined(MY_GATEWAY_BINARY_FRAMING) && !defined(MY_GATEWAY_CLIENT_MODE) && \
+	(defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32) || defined(MY_GATEWAY_LINUX))
+	// binary frame for the clients that negotiated it, built once when the first one is served
+	uint8_t frame[PROTOCOL_BINARY_MAX_LENGTH];
+	size_t frameLength = 0;
+#endif
+	STATS_UPLINK(STATS_LATENCY_UPLINK_FORMAT);
 
 	setIndication(INDICATION_GW_TX);
 
 	_w5100_spi_en(true);
 #if defined(MY_GATEWAY_CLIENT_MODE)
 #if defined(MY_USE_UDP)
+	// pack the message into the pending datagram, it is sent once full or due
+	nbytes = 1;
+	if (_ethernetUdpTxLength + length > MY_GATEWAY_UDP_DATAGRAM_SIZE) {
+		nbytes = _ethernetUdpFlush();
+	}
+	if (!_ethernetUdpTxLength) {
 #if defined(MY_CONTROLLER_URL_ADDRESS)
-	_ethernetServer.beginPacket(MY_CONTROLLER_URL_ADDRESS, MY_PORT);
+		_ethernetServer.beginPacket(MY_CONTROLLER_URL_ADDRESS, MY_PORT);
 #else
-	_ethernetServer.beginPacket(_ethernetControllerIP, MY_PORT);
+		_ethernetServer.beginPacket(_ethernetControllerIP, MY_PORT);
 #endif /* End of MY_CONTROLLER_URL_ADDRESS */
-	_ethernetServer.write((uint8_t *)_ethernetMsg, strlen(_ethernetMsg));
-	// returns 1 if the packet was sent successfully
-	nbytes = _ethernetServer.endPacket();
+		_ethernetUdpTxSince = hwMillis();
+#if defined(MY_GATEWAY_LINUX)
+		eventLoopWakeupIn(MY_GATEWAY_UDP_FLUSH_MS);
+#endif /* End of MY_GATEWAY_LINUX */
+	}
+	_ethernetServer.write((uint8_t *)_ethernetMsg, length);
+	_ethernetUdpTxLength += length;
+	if (_ethernetUdpTxLength >= MY_GATEWAY_UDP_DATAGRAM_SIZE) {
+		nbytes = _ethernetUdpFlush();
+	}
 #else /* Else part of MY_USE_UDP */
-	if (!client.connected()) {
-		client.stop();
-#if defined(MY_CONTROLLER_URL_ADDRESS)
-		if (client.connect(MY_CONTROLLER_URL_ADDRESS, MY_PORT)) {
-#else
-		if (client.connect(_ethernetControllerIP, MY_PORT)) {
-#endif /* End of MY_CONTROLLER_URL_ADDRESS */
-			GATEWAY_DEBUG(PSTR("GWT:TPS:ETH OK\n"));
-			_w5100_spi_en(false);
-			gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set(MSG_GW_STARTUP_COMPLETE));
-			_w5100_spi_en(true);
-			presentNode();
-		} else {
-			// connecting to the server failed!
-			GATEWAY_DEBUG(PSTR("!GWT:TPS:ETH FAIL\n"));
-			_w5100_spi_en(false);
-			return false;
-		}
+	if (!_connectToController()) {
+		_w5100_spi_en(false);
+		return false;
 	}
-	nbytes = client.write((const uint8_t*)_ethernetMsg, strlen(_ethernetMsg));
+	nbytes = client.write((const uint8_t*)_ethernetMsg, length);
 #endif /* End of MY_USE_UDP */
 #else /* Else part of MY_GATEWAY_CLIENT_MODE */
 	// Send message to connected clients
 #if defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32)
 	for (uint8_t i = 0; i < ARRAY_SIZE(clients); i++) {
 		if (clients[i] && clients[i].connected()) {
-			nbytes += clients[i].write((uint8_t *)_ethernetMsg, strlen(_ethernetMsg));
+#if defined(MY_GATEWAY_CLIENT_FILTER)
+			if (!_clientFilterPass(inputString[i], message)) {
+				continue;
+			}
+#endif /* End of MY_GATEWAY_CLIENT_FILTER */
+#if defined(MY_GATEWAY_BINARY_FRAMING)
+			if (inputString[i].parser.mode == PROTOCOL_MODE_BINARY) {
+				if (!frameLength) {
+					frameLength = protocolMyMessage2Binary(message, frame);
+				}
+				const size_t sent = clients[i].write(frame, frameLength);
+				STATS_CLIENT_TX(i, sent);
+				nbytes += sent;
+				continue;
+			}
+#endif /* End of MY_GATEWAY_BINARY_FRAMING */
+			const size_t sent = clients[i].write((uint8_t *)_ethernetMsg, length);
+			STATS_CLIENT_TX(i, sent);
+			nbytes += sent;
+		}
+	}
+#elif defined(MY_GATEWAY_BINARY_FRAMING) /* Elif part of MY_GATEWAY_ESPxx */
+	for (uint8_t i = 0; i < ARRAY_SIZE(clients); i++) {
+		if (!clientsConnected[i]) {
+			continue;
+		}
+#if defined(MY_GATEWAY_CLIENT_FILTER)
+		if (!_clientFilterPass(inputString[i], message)) {
+			continue;
+		}
+#endif /* End of MY_GATEWAY_CLIENT_FILTER */
+		const int sock = clients[i].getSocketNumber();
+		size_t sent;
+		if (inputString[i].parser.mode == PROTOCOL_MODE_BINARY) {
+			if (!frameLength) {
+				frameLength = protocolMyMessage2Binary(message, frame);
+			}
+			sent = _ethernetServer.write(sock, frame, frameLength);
+		} else {
+			sent = _ethernetServer.write(sock, (const uint8_t *)_ethernetMsg, length);
+		}
+		STATS_CLIENT_TX(i, sent);
+		nbytes += sent;
+	}
+#elif defined(MY_GATEWAY_LINUX) && (defined(MY_STATS_FEATURE) || defined(MY_GATEWAY_CLIENT_FILTER)) /* Elif part of MY_GATEWAY_ESPxx */
+	// write per connection to account the bytes of each client and skip filtered ones
+	for (uint8_t i = 0; i < ARRAY_SIZE(clients); i++) {
+#if defined(MY_GATEWAY_CLIENT_FILTER)
+		if (!_clientFilterPass(inputString[i], message)) {
+			continue;
+		}
+#endif /* End of MY_GATEWAY_CLIENT_FILTER */
+		if (clientsConnected[i]) {
+			const size_t sent = _ethernetServer.write(clients[i].getSocketNumber(),
+			                    (const uint8_t *)_ethernetMsg, length);
+			STATS_CLIENT_TX(i, sent);
+			nbytes += sent;
 		}
 	}
 #else /* Else part of MY_GATEWAY_ESPxx*/
-	nbytes = _ethernetServer.write(_ethernetMsg);
+	nbytes = _ethernetServer.write(_ethernetMsg, length);
 #endif /* End of MY_GATEWAY_ESPxx */
+#if defined(MY_LINUX_ETHERNET_SHM_RING)
+	if (shmRingWrite(&message)) {
+		nbytes += sizeof(MyMessage);
+	}
+#endif /* End of MY_LINUX_ETHERNET_SHM_RING */
 #endif /* End of MY_GATEWAY_CLIENT_MODE */
 	_w5100_spi_en(false);
+	STATS_INC(nbytes > 0 ? STATS_GW_TX_MESSAGES : STATS_GW_TX_FAILURES);
+	if (nbytes > 0) {
+		STATS_UPLINK(STATS_LATENCY_UPLINK_WRITE);
+	}
 	return (nbytes > 0);
 }
 
@@ -309,26 +534,31 @@ bool _readFromClient(uint8_t i)
 {
 	while (clients[i].connected() && clients[i].available()) {
 		const char inChar = clients[i].read();
-		if (inputString[i].idx < MY_GATEWAY_MAX_RECEIVE_LENGTH - 1) {
-			// if newline then command is complete
-			if (inChar == '\n' || inChar == '\r') {
-				// Add string terminator and prepare for the next message
-				inputString[i].string[inputString[i].idx] = 0;
-				GATEWAY_DEBUG(PSTR("GWT:RFC:C=%" PRIu8 ",MSG=%s\n"), i, inputString[i].string);
-				inputString[i].idx = 0;
-				if (protocolSerial2MyMessage(_ethernetMsg, inputString[i].string)) {
-					return true;
-				}
-			} else {
-				// add it to the inputString:
-				inputString[i].string[inputString[i].idx++] = inChar;
+		STATS_CLIENT_RX(i, 1);
+		const protocolParseResult_t result = protocolParse(inputString[i].parser, inputString[i].message,
+		                                     inChar);
+		if (result == PROTOCOL_PARSE_OK) {
+			GATEWAY_DEBUG(PSTR("GWT:RFC:C=%" PRIu8 ",MSG=%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8
+			                   ";%s\n"), i, inputString[i].message.destination, inputString[i].message.sensor,
+			              mGetCommand(inputString[i].message), mGetRequestEcho(inputString[i].message),
+			              inputString[i].message.type, inputString[i].message.getString(_convBuffer));
+#if defined(MY_GATEWAY_CLIENT_FILTER)
+			if (inputString[i].message.destination == GATEWAY_ADDRESS &&
+			        mGetCommand(inputString[i].message) == C_INTERNAL &&
+			        inputString[i].message.type == I_GATEWAY_FILTER) {
+				// meant for this link, the core never sees it
+				_clientFilterSet(inputString[i], inputString[i].message.getString());
+				GATEWAY_DEBUG(PSTR("GWT:RFC:C=%" PRIu8 ",FLT=%" PRIu8 "-%" PRIu8 ",%" PRIu8 ",%" PRIu8 "\n"), i,
+				              inputString[i].filterFirst, inputString[i].filterLast,
+				              inputString[i].filterCommands, inputString[i].filterType);
+				continue;
 			}
-		} else {
+#endif /* End of MY_GATEWAY_CLIENT_FILTER */
+			_ethernetRxMsg = &inputString[i].message;
+			return true;
+		} else if (result == PROTOCOL_PARSE_TOO_LONG) {
 			// Incoming message too long. Throw away
 			GATEWAY_DEBUG(PSTR("!GWT:RFC:C=%" PRIu8 ",MSG TOO LONG\n"), i);
-			inputString[i].idx = 0;
-			// Finished with this client's message. Next loop() we'll see if there's more to read.
-			break;
 		}
 	}
 	return false;
@@ -338,27 +568,15 @@ bool _readFromClient(void)
 {
 	while (client.connected() && client.available()) {
 		const char inChar = client.read();
-		if (inputString.idx < MY_GATEWAY_MAX_RECEIVE_LENGTH - 1) {
-			// if newline then command is complete
-			if (inChar == '\n' || inChar == '\r') {
-				// Add string terminator and prepare for the next message
-				inputString.string[inputString.idx] = 0;
-				GATEWAY_DEBUG(PSTR("GWT:RFC:MSG=%s\n"), inputString.string);
-				inputString.idx = 0;
-				if (protocolSerial2MyMessage(_ethernetMsg, inputString.string)) {
-					return true;
-				}
-
-			} else {
-				// add it to the inputString:
-				inputString.string[inputString.idx++] = inChar;
-			}
-		} else {
+		const protocolParseResult_t result = protocolParse(_ethernetParser, _ethernetMsg, inChar);
+		if (result == PROTOCOL_PARSE_OK) {
+			GATEWAY_DEBUG(PSTR("GWT:RFC:MSG=%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%s\n"),
+			              _ethernetMsg.destination, _ethernetMsg.sensor, mGetCommand(_ethernetMsg),
+			              mGetRequestEcho(_ethernetMsg), _ethernetMsg.type, _ethernetMsg.getString(_convBuffer));
+			return true;
+		} else if (result == PROTOCOL_PARSE_TOO_LONG) {
 			// Incoming message too long. Throw away
 			GATEWAY_DEBUG(PSTR("!GWT:RFC:MSG TOO LONG\n"));
-			inputString.idx = 0;
-			// Finished with this client's message. Next loop() we'll see if there's more to read.
-			break;
 		}
 	}
 	return false;
@@ -368,6 +586,11 @@ bool _readFromClient(void)
 
 bool gatewayTransportAvailable(void)
 {
+#if defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32)
+	if (!_ethernetWiFiReady()) {
+		return false;
+	}
+#endif /* End of MY_GATEWAY_ESP8266 || MY_GATEWAY_ESP32 */
 	_w5100_spi_en(true);
 #if !defined(MY_IP_ADDRESS) && defined(MY_GATEWAY_W5100)
 	// renew IP address using DHCP
@@ -376,38 +599,47 @@ bool gatewayTransportAvailable(void)
 
 #if defined(MY_GATEWAY_CLIENT_MODE)
 #if defined(MY_USE_UDP)
-	int packet_size = _ethernetServer.parsePacket();
-
-	if (packet_size) {
-		_ethernetServer.read(inputString.string, MY_GATEWAY_MAX_RECEIVE_LENGTH);
-		inputString.string[packet_size] = 0;
-		GATEWAY_DEBUG(PSTR("GWT:TSA:UDP MSG=%s\n"), inputString.string);
-		_w5100_spi_en(false);
-		const bool ok = protocolSerial2MyMessage(_ethernetMsg, inputString.string);
-		if (ok) {
-			setIndication(INDICATION_GW_RX);
-		}
-		return ok;
+	// send the pending datagram once due
+#if MY_GATEWAY_UDP_FLUSH_MS > 0
+	if ((uint32_t)(hwMillis() - _ethernetUdpTxSince) >= MY_GATEWAY_UDP_FLUSH_MS)
+#endif
+	{
+		(void)_ethernetUdpFlush();
 	}
-#else /* Else part of MY_USE_UDP */
-	if (!client.connected()) {
-		client.stop();
-#if defined(MY_CONTROLLER_URL_ADDRESS)
-		if (client.connect(MY_CONTROLLER_URL_ADDRESS, MY_PORT)) {
-#else
-		if (client.connect(_ethernetControllerIP, MY_PORT)) {
-#endif /* End of MY_CONTROLLER_URL_ADDRESS */
-			GATEWAY_DEBUG(PSTR("GWT:TSA:ETH OK\n"));
-			_w5100_spi_en(false);
-			gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set(F(MSG_GW_STARTUP_COMPLETE)));
-			_w5100_spi_en(true);
-			presentNode();
-		} else {
-			GATEWAY_DEBUG(PSTR("!GWT:TSA:ETH FAIL\n"));
+#if defined(MY_GATEWAY_LINUX)
+	// everything finished since the last pass leaves with one syscall
+	(void)_ethernetServer.sendQueued();
+#endif /* End of MY_GATEWAY_LINUX */
+	if (!_ethernetServer.available()) {
+		// the parser is at the start of a line here, the previous datagram terminated its last one
+		if (!_ethernetServer.parsePacket()) {
 			_w5100_spi_en(false);
 			return false;
 		}
 	}
+	bool ok = false;
+	while (!ok && _ethernetServer.available()) {
+		const int inChar = _ethernetServer.read();
+		ok = inChar >= 0 &&
+		     protocolParse(_ethernetParser, _ethernetMsg, (char)inChar) == PROTOCOL_PARSE_OK;
+	}
+	if (!ok && !_ethernetServer.available()) {
+		// the end of the datagram terminates its last line
+		ok = protocolParse(_ethernetParser, _ethernetMsg, '\n') == PROTOCOL_PARSE_OK;
+	}
+	_w5100_spi_en(false);
+	if (ok) {
+		GATEWAY_DEBUG(PSTR("GWT:TSA:UDP MSG=%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%s\n"),
+		              _ethernetMsg.destination, _ethernetMsg.sensor, mGetCommand(_ethernetMsg),
+		              mGetRequestEcho(_ethernetMsg), _ethernetMsg.type, _ethernetMsg.getString(_convBuffer));
+		setIndication(INDICATION_GW_RX);
+	}
+	return ok;
+#else /* Else part of MY_USE_UDP */
+	if (!_connectToController()) {
+		_w5100_spi_en(false);
+		return false;
+	}
 	if (_readFromClient()) {
 		setIndication(INDICATION_GW_RX);
 		_w5100_spi_en(false);
@@ -415,7 +647,83 @@ bool gatewayTransportAvailable(void)
 	}
 #endif /* End of MY_USE_UDP */
 #else /* Else part of MY_GATEWAY_CLIENT_MODE */
-#if defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32) || defined(MY_GATEWAY_LINUX)
+#if defined(MY_GATEWAY_LINUX)
+	// send what was coalesced since the last loop iteration
+	_ethernetServer.flushIfDue();
+	// connections are served by the events of the server, idle clients cost nothing
+	const bool newClients = _ethernetServer.hasClient();
+	int sock;
+	while ((sock = _ethernetServer.closedClient()) != -1) {
+		const uint8_t i = _ethernetClientSlot(sock);
+		if (i < ARRAY_SIZE(clients)) {
+			GATEWAY_DEBUG(PSTR("GWT:TSA:C=%" PRIu8 ",DISCONNECTED\n"), i);
+			clients[i].stop();
+			clientsConnected[i] = false;
+		}
+	}
+	if (newClients) {
+		for (uint8_t i = 0; i < ARRAY_SIZE(clients); i++) {
+			if (clientsConnected[i]) {
+				continue;
+			}
+			clients[i] = _ethernetServer.available();
+			if (!clients[i]) {
+				break;
+			}
+			clientsConnected[i] = true;
+			protocolParserReset(inputString[i].parser);
+#if defined(MY_GATEWAY_CLIENT_FILTER)
+			_clientFilterSet(inputString[i], NULL);
+#endif /* End of MY_GATEWAY_CLIENT_FILTER */
+			GATEWAY_DEBUG(PSTR("GWT:TSA:C=%" PRIu8 ",CONNECTED\n"), i);
+			gatewayTransportSend(buildGw(_ethernetMsgTmp, I_GATEWAY_READY).set(MSG_GW_STARTUP_COMPLETE));
+			// Send presentation of locally attached sensors (and node if applicable)
+			presentNode();
+		}
+		EthernetClient c = _ethernetServer.available();
+		while (c) {
+			//no free/disconnected spot so reject
+			GATEWAY_DEBUG(PSTR("!GWT:TSA:NO FREE SLOT\n"));
+			c.stop();
+			c = _ethernetServer.available();
+		}
+	}
+#if defined(MY_LINUX_ETHERNET_SHM_RING)
+	if (shmRingAccept()) {
+		GATEWAY_DEBUG(PSTR("GWT:TSA:SHM,CONNECTED\n"));
+		gatewayTransportSend(buildGw(_ethernetMsgTmp, I_GATEWAY_READY).set(MSG_GW_STARTUP_COMPLETE));
+		presentNode();
+	}
+	while (shmRingRead(&_ethernetShmMsg)) {
+		// raw structs from another process, only the header is trusted after this check
+		if (mGetVersion(_ethernetShmMsg) != PROTOCOL_VERSION || mGetLength(_ethernetShmMsg) > MAX_PAYLOAD) {
+			GATEWAY_DEBUG(PSTR("!GWT:TSA:SHM,MSG INVALID\n"));
+			continue;
+		}
+		GATEWAY_DEBUG(PSTR("GWT:RFC:SHM,MSG=%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 "\n"),
+		              _ethernetShmMsg.destination, _ethernetShmMsg.sensor, mGetCommand(_ethernetShmMsg),
+		              mGetRequestEcho(_ethernetShmMsg), _ethernetShmMsg.type);
+		_ethernetRxMsg = &_ethernetShmMsg;
+		setIndication(INDICATION_GW_RX);
+		_w5100_spi_en(false);
+		return true;
+	}
+#endif /* End of MY_LINUX_ETHERNET_SHM_RING */
+	// clients are read in the order their input arrived, one message per call
+	while ((sock = _ethernetServer.readableClient()) != -1) {
+		const uint8_t i = _ethernetClientSlot(sock);
+		if (i < ARRAY_SIZE(clients) && _readFromClient(i)) {
+			if (clients[i].available()) {
+				// the rest of the input is buffered by the client, the kernel does not report it
+				_ethernetServer.setReadable(sock);
+			}
+			_ethernetRxClient = i;
+			setIndication(INDICATION_GW_RX);
+			_w5100_spi_en(false);
+			return true;
+		}
+	}
+#elif defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32)
 	// ESP8266/ESP32: Go over list of clients and stop any that are no longer connected.
 	// If the server has a new client connection it will be assigned to a free slot.
 	bool allSlotsOccupied = true;
@@ -428,9 +736,12 @@ bool gatewayTransportAvailable(void)
 			//check if there are any new clients
 			if (_ethernetServer.hasClient()) {
 				clients[i] = _ethernetServer.available();
-				inputString[i].idx = 0;
+				protocolParserReset(inputString[i].parser);
+#if defined(MY_GATEWAY_CLIENT_FILTER)
+				_clientFilterSet(inputString[i], NULL);
+#endif /* End of MY_GATEWAY_CLIENT_FILTER */
 				GATEWAY_DEBUG(PSTR("GWT:TSA:C=%" PRIu8 ",CONNECTED\n"), i);
-				gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set(MSG_GW_STARTUP_COMPLETE));
+				gatewayTransportSend(buildGw(_ethernetMsgTmp, I_GATEWAY_READY).set(MSG_GW_STARTUP_COMPLETE));
 				// Send presentation of locally attached sensors (and node if applicable)
 				presentNode();
 			}
@@ -445,15 +756,18 @@ bool gatewayTransportAvailable(void)
 		EthernetClient c = _ethernetServer.available();
 		c.stop();
 	}
-	// Loop over clients connect and read available data
-	for (uint8_t i = 0; i < ARRAY_SIZE(clients); i++) {
+	// Loop over clients connect and read available data, each call continues with the next
+	// client so that a burst from one client does not hold back the others
+	for (uint8_t n = 0; n < ARRAY_SIZE(clients); n++) {
+		const uint8_t i = (_ethernetRxClient + n + 1u) % ARRAY_SIZE(clients);
 		if (_readFromClient(i)) {
+			_ethernetRxClient = i;
 			setIndication(INDICATION_GW_RX);
 			_w5100_spi_en(false);
 			return true;
 		}
 	}
-#else /* Else part of MY_GATEWAY_ESP8266 || MY_GATEWAY_LINUX */
+#else /* Else part of MY_GATEWAY_LINUX / MY_GATEWAY_ESPxx */
 	// W5100/ENC module does not have hasClient-method. We can only serve one client at the time.
 	EthernetClient newclient = _ethernetServer.available();
 	// if a new client connects make sure to dispose any previous existing sockets
@@ -463,7 +777,7 @@ bool gatewayTransportAvailable(void)
 			client = newclient;
 			GATEWAY_DEBUG(PSTR("GWT:TSA:ETH OK\n"));
 			_w5100_spi_en(false);
-			gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set(MSG_GW_STARTUP_COMPLETE));
+			gatewayTransportSend(buildGw(_ethernetMsgTmp, I_GATEWAY_READY).set(MSG_GW_STARTUP_COMPLETE));
 			_w5100_spi_en(true);
 			presentNode();
 		}
@@ -489,7 +803,7 @@ bool gatewayTransportAvailable(void)
 MyMessage& gatewayTransportReceive(void)
 {
 	// Return the last parsed message
-	return _ethernetMsg;
+	return *_ethernetRxMsg;
 }
 
 
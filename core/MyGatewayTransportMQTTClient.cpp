@@ -21,6 +21,7 @@
 // Topic structure: MY_MQTT_PUBLISH_TOPIC_PREFIX/NODE-ID/SENSOR-ID/CMD-TYPE/ACK-FLAG/SUB-TYPE
 
 #include "MyGatewayTransport.h"
+#include "drivers/CircularBuffer/CircularBuffer.h"
 
 // housekeeping, remove for 3.0.0
 #ifdef MY_ESP8266_SSID
@@ -94,27 +95,56 @@ uint8_t _MQTT_clientMAC[] = { MY_MAC_ADDRESS };
 #if defined(MY_GSM_RX) && defined(MY_GSM_TX)
 SoftwareSerial SerialAT(MY_GSM_RX, MY_GSM_TX);
 #endif
-static TinyGsm modem(SerialAT);
+#if defined(MY_GSM_UART_DMA)
+// the DMA keeps receiving while the gateway is busy elsewhere
+static UartRxDMA _MQTT_gsmSerial(SerialAT);
+static uint32_t _MQTT_gsmOverruns = 0;
+#else
+#define _MQTT_gsmSerial SerialAT
+#endif /* End of MY_GSM_UART_DMA */
+#if defined(MY_GSM_ASYNC)
+static TinyGsmSim800Async modem(_MQTT_gsmSerial);
+static TinyGsmSim800Async::GsmClient _MQTT_ethClient(modem);
+#else
+static TinyGsm modem(_MQTT_gsmSerial);
 static TinyGsmClient _MQTT_ethClient(modem);
+#endif /* End of MY_GSM_ASYNC */
 #if defined(MY_GSM_BAUDRATE)
 uint32_t rate = MY_GSM_BAUDRATE;
 #else /* Else part of MY_GSM_BAUDRATE */
 uint32_t rate = 0;
 #endif /* End of MY_GSM_BAUDRATE */
+#elif defined(MY_MQTT_CLIENT_TLS) && defined(MY_GATEWAY_ESP8266)
+static BearSSL::WiFiClientSecure _MQTT_ethClient;
+// filled by the first handshake, reconnects resume it instead of a full handshake
+static BearSSL::Session _MQTT_tlsSession;
+#if defined(MY_MQTT_CLIENT_TLS_CA_CERT)
+static BearSSL::X509List _MQTT_tlsTrust(MY_MQTT_CLIENT_TLS_CA_CERT);
+#endif /* End of MY_MQTT_CLIENT_TLS_CA_CERT */
+#elif defined(MY_MQTT_CLIENT_TLS)
+static WiFiClientSecure _MQTT_ethClient;
 #else /* Else part of MY_GATEWAY_TINYGSM */
 static EthernetClient _MQTT_ethClient;
 #endif /* End of MY_GATEWAY_TINYGSM */
 
 static PubSubClient _MQTT_client(_MQTT_ethClient);
 static bool _MQTT_connecting = true;
-static bool _MQTT_available = false;
+#if defined(MY_GATEWAY_ESP32)
+static uint32_t _MQTT_wifiBeginAt = 0;
+#endif /* End of MY_GATEWAY_ESP32 */
 static MyMessage _MQTT_msg;
 
-bool gatewayTransportSend(MyMessage &message)
+#if MY_MQTT_CLIENT_RX_QUEUE_SIZE > 255 || MY_MQTT_CLIENT_RX_QUEUE_SIZE < 1
+#error MY_MQTT_CLIENT_RX_QUEUE_SIZE must be between 1 and 255
+#endif
+// Messages parsed from the publishes of one _MQTT_client.loop(), handed out in order
+static MyMessage _MQTT_rxQueueStorage[MY_MQTT_CLIENT_RX_QUEUE_SIZE];
+static CircularBuffer<MyMessage> _MQTT_rxQueue(_MQTT_rxQueueStorage,
+        MY_MQTT_CLIENT_RX_QUEUE_SIZE);
+
+static bool _MQTT_publish(MyMessage &message, const uint8_t qos, uint16_t *packetId,
+                          const bool dup = false)
 {
-	if (!_MQTT_client.connected()) {
-		return false;
-	}
 	setIndication(INDICATION_GW_TX);
 	char *topic = protocolMyMessage2MQTT(MY_MQTT_PUBLISH_TOPIC_PREFIX, message);
 	GATEWAY_DEBUG(PSTR("GWT:TPS:TOPIC=%s,MSG SENT\n"), topic);
@@ -124,22 +154,216 @@ bool gatewayTransportSend(MyMessage &message)
 #else
 	const bool retain = false;
 #endif /* End of MY_MQTT_CLIENT_PUBLISH_RETAIN */
-	return _MQTT_client.publish(topic, message.getString(_convBuffer), retain);
+	const char *payload = message.getString(_convBuffer);
+#if defined(MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS)
+	if (!_MQTT_client.publish(topic, (const uint8_t *)payload, strlen(payload), retain, qos,
+	                          packetId, dup)) {
+		return false;
+	}
+	if (retain) {
+		protocolMQTTPayloadPublished(message, payload);
+	}
+	return true;
+#else
+	return _MQTT_client.publish(topic, (const uint8_t *)payload, strlen(payload), retain, qos,
+	                            packetId, dup);
+#endif /* End of MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS */
+}
+
+#if defined(MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS)
+// the broker retains the payload already, unless the topic was not published recently
+static bool _MQTT_unchanged(MyMessage &message)
+{
+	if (mGetCommand(message) != C_SET &&
+	        (mGetCommand(message) != C_INTERNAL || message.type != I_BATTERY_LEVEL)) {
+		// not retained
+		return false;
+	}
+	if (!protocolMQTTPayloadUnchanged(message, message.getString(_convBuffer))) {
+		return false;
+	}
+	STATS_INC(STATS_GW_TX_SUPPRESSED);
+	GATEWAY_DEBUG(PSTR("GWT:TPS:N=%" PRIu8 ",S=%" PRIu8 ",T=%" PRIu8 ",UNCHANGED\n"), message.sender,
+	              message.sensor, message.type);
+	return true;
+}
+#endif /* End of MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS */
+
+#if defined(MY_MQTT_CLIENT_PUBLISH_QOS1)
+#if MY_MQTT_CLIENT_QUEUE_SIZE > 255 || MY_MQTT_CLIENT_QUEUE_SIZE < 1
+#error MY_MQTT_CLIENT_QUEUE_SIZE must be between 1 and 255
+#endif
+#define _MQTT_WINDOW ((MY_MQTT_CLIENT_INFLIGHT_WINDOW) < (MQTT_MAX_INFLIGHT) ? \
+                      (MY_MQTT_CLIENT_INFLIGHT_WINDOW) : (MQTT_MAX_INFLIGHT))
+
+// Ring of outbound messages: the first _MQTT_queueInflight entries from _MQTT_queueTail
+// are published and await their PUBACK, the rest are pending
+static MyMessage _MQTT_queue[MY_MQTT_CLIENT_QUEUE_SIZE];
+static uint16_t _MQTT_queueId[MY_MQTT_CLIENT_QUEUE_SIZE];	// packet id, 0 once acknowledged
+static bool _MQTT_queueDup[MY_MQTT_CLIENT_QUEUE_SIZE];	// published before, sent again with DUP
+static uint8_t _MQTT_queueTail = 0;
+static uint8_t _MQTT_queueCount = 0;
+static uint8_t _MQTT_queueInflight = 0;
+static gatewayMQTTStats_t _MQTT_stats;
+
+static void _MQTT_queuePump(void)
+{
+	while (_MQTT_queueInflight < _MQTT_queueCount && _MQTT_queueInflight < _MQTT_WINDOW &&
+	        _MQTT_client.connected()) {
+		const uint8_t index = (_MQTT_queueTail + _MQTT_queueInflight) % MY_MQTT_CLIENT_QUEUE_SIZE;
+		uint16_t packetId = 0;
+		if (!_MQTT_publish(_MQTT_queue[index], 1, &packetId, _MQTT_queueDup[index])) {
+			return;
+		}
+		_MQTT_queueId[index] = packetId;
+		_MQTT_queueInflight++;
+		_MQTT_stats.published++;
+	}
+}
+
+static void _MQTT_queueAck(uint16_t packetId)
+{
+	for (uint8_t i = 0; i < _MQTT_queueInflight; i++) {
+		const uint8_t index = (_MQTT_queueTail + i) % MY_MQTT_CLIENT_QUEUE_SIZE;
+		if (_MQTT_queueId[index] == packetId) {
+			_MQTT_queueId[index] = 0;
+			_MQTT_stats.acknowledged++;
+			break;
+		}
+	}
+	// release the acknowledged entries at the front, later ones wait for the front to catch up
+	while (_MQTT_queueInflight > 0 && _MQTT_queueId[_MQTT_queueTail] == 0) {
+		_MQTT_queueTail = (_MQTT_queueTail + 1) % MY_MQTT_CLIENT_QUEUE_SIZE;
+		_MQTT_queueCount--;
+		_MQTT_queueInflight--;
+	}
+}
+
+static void _MQTT_queueRestart(void)
+{
+	// the broker session is new, unacknowledged publishes are sent again with DUP set.
+	// Acknowledged entries waiting behind them are dropped and the ring is compacted
+	uint8_t kept = 0;
+	for (uint8_t i = 0; i < _MQTT_queueCount; i++) {
+		const uint8_t from = (_MQTT_queueTail + i) % MY_MQTT_CLIENT_QUEUE_SIZE;
+		const bool inflight = i < _MQTT_queueInflight;
+		if (inflight && _MQTT_queueId[from] == 0) {
+			continue;
+		}
+		const uint8_t to = (_MQTT_queueTail + kept) % MY_MQTT_CLIENT_QUEUE_SIZE;
+		if (to != from) {
+			_MQTT_queue[to] = _MQTT_queue[from];
+		}
+		_MQTT_queueId[to] = 0;
+		_MQTT_queueDup[to] = inflight || _MQTT_queueDup[from];
+		if (inflight) {
+			_MQTT_stats.resent++;
+		}
+		kept++;
+	}
+	_MQTT_queueCount = kept;
+	_MQTT_queueInflight = 0;
+}
+
+gatewayMQTTStats_t gatewayMQTTGetStats(void)
+{
+	gatewayMQTTStats_t stats = _MQTT_stats;
+	stats.queued = _MQTT_queueCount;
+	stats.inflight = _MQTT_queueInflight;
+	return stats;
+}
+#endif /* End of MY_MQTT_CLIENT_PUBLISH_QOS1 */
+
+bool gatewayTransportSend(MyMessage &message)
+{
+#if defined(MY_GATEWAY_CONTROLLER_THREAD)
+	if (gatewayThreadIsCore()) {
+		return gatewayThreadSend(message);
+	}
+#endif
+#if defined(MY_GATEWAY_SECONDARY_TCP_PORT)
+	gatewaySecondarySend(message, NULL, 0);
+#endif /* End of MY_GATEWAY_SECONDARY_TCP_PORT */
+#if defined(MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS)
+	if (_MQTT_unchanged(message)) {
+		return true;
+	}
+#endif /* End of MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS */
+#if defined(MY_MQTT_CLIENT_PUBLISH_QOS1)
+	if (_MQTT_queueCount == MY_MQTT_CLIENT_QUEUE_SIZE) {
+		_MQTT_stats.dropped++;
+		STATS_INC(STATS_GW_TX_FAILURES);
+		GATEWAY_DEBUG(PSTR("!GWT:TPS:QUEUE FULL\n"));
+		return false;
+	}
+	const uint8_t index = (_MQTT_queueTail + _MQTT_queueCount) % MY_MQTT_CLIENT_QUEUE_SIZE;
+	_MQTT_queue[index] = message;
+	_MQTT_queueDup[index] = false;
+	_MQTT_queueCount++;
+	if (_MQTT_queueCount > _MQTT_stats.highWater) {
+		_MQTT_stats.highWater = _MQTT_queueCount;
+	}
+	_MQTT_queuePump();
+	STATS_INC(STATS_GW_TX_MESSAGES);
+	return true;
+#else
+	const bool result = _MQTT_client.connected() && _MQTT_publish(message, 0, NULL);
+	STATS_INC(result ? STATS_GW_TX_MESSAGES : STATS_GW_TX_FAILURES);
+	if (result) {
+		// formatted and published in one go
+		STATS_UPLINK(STATS_LATENCY_UPLINK_WRITE);
+	}
+	return result;
+#endif /* End of MY_MQTT_CLIENT_PUBLISH_QOS1 */
 }
 
 void incomingMQTT(char *topic, uint8_t *payload, unsigned int length)
 {
 	GATEWAY_DEBUG(PSTR("GWT:IMQ:TOPIC=%s, MSG RECEIVED\n"), topic);
-	_MQTT_available = protocolMQTT2MyMessage(_MQTT_msg, topic, payload, length);
 	setIndication(INDICATION_GW_RX);
+	// parsed in place, the slot is only pushed if the publish holds a valid message
+	MyMessage *message = _MQTT_rxQueue.getFront();
+	if (message == NULL) {
+		STATS_INC(STATS_GW_RX_OVERFLOWS);
+		GATEWAY_DEBUG(PSTR("!GWT:IMQ:QUEUE FULL\n"));
+		return;
+	}
+#if defined(MY_GATEWAY_BINARY_FRAMING)
+	// a payload holding a binary frame carries the whole message, e.g. raw OTA blocks
+	if (length && payload[0] == PROTOCOL_BINARY_SYNC &&
+	        protocolBinary2MyMessage(*message, payload, length)) {
+		(void)_MQTT_rxQueue.pushFront(message);
+		return;
+	}
+#endif /* End of MY_GATEWAY_BINARY_FRAMING */
+	if (protocolMQTT2MyMessage(*message, topic, payload, length)) {
+		(void)_MQTT_rxQueue.pushFront(message);
+	} else {
+		STATS_INC(STATS_GW_PARSE_ERRORS);
+	}
 }
 
 bool reconnectMQTT(void)
 {
-	GATEWAY_DEBUG(PSTR("GWT:RMQ:CONNECTING...\n"));
+#if defined(MY_GATEWAY_LINUX) || defined(MY_GSM_ASYNC)
+	// the TCP connection is established without blocking, don't log every check
+	if (!_MQTT_ethClient.connecting())
+#endif /* End of MY_GATEWAY_LINUX || MY_GSM_ASYNC */
+	{
+		GATEWAY_DEBUG(PSTR("GWT:RMQ:CONNECTING...\n"));
+	}
 	// Attempt to connect
 	if (_MQTT_client.connect(MY_MQTT_CLIENT_ID, MY_MQTT_USER, MY_MQTT_PASSWORD)) {
+		gatewayTransportReconnectResult(true);
 		GATEWAY_DEBUG(PSTR("GWT:RMQ:OK\n"));
+#if defined(MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS)
+		// the broker may have lost the retained payloads
+		protocolMQTTPayloadReset();
+#endif /* End of MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS */
+#if defined(MY_MQTT_CLIENT_PUBLISH_QOS1)
+		_MQTT_queueRestart();
+		_MQTT_queuePump();
+#endif /* End of MY_MQTT_CLIENT_PUBLISH_QOS1 */
 		// Send presentation of locally attached sensors (and node if applicable)
 		presentNode();
 		// Once connected, publish subscribe
@@ -155,7 +379,12 @@ bool reconnectMQTT(void)
 
 		return true;
 	}
-	delay(1000);
+#if defined(MY_GATEWAY_LINUX) || defined(MY_GSM_ASYNC)
+	if (_MQTT_ethClient.connecting()) {
+		return false;
+	}
+#endif /* End of MY_GATEWAY_LINUX || MY_GSM_ASYNC */
+	gatewayTransportReconnectResult(false);
 	GATEWAY_DEBUG(PSTR("!GWT:RMQ:FAIL\n"));
 	return false;
 }
@@ -164,8 +393,8 @@ bool gatewayTransportConnect(void)
 {
 #if defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32)
 	if (WiFi.status() != WL_CONNECTED) {
+		// still associating, gatewayTransportAvailable() comes back once it is up
 		GATEWAY_DEBUG(PSTR("GWT:TPC:CONNECTING...\n"));
-		delay(1000);
 		return false;
 	}
 	GATEWAY_DEBUG(PSTR("GWT:TPC:IP=%s\n"), WiFi.localIP().toString().c_str());
@@ -173,6 +402,12 @@ bool gatewayTransportConnect(void)
 #if defined(MY_IP_ADDRESS)
 	_MQTT_ethClient.bind(_MQTT_clientIp);
 #endif /* End of MY_IP_ADDRESS */
+#elif defined(MY_GSM_ASYNC)
+	if (!modem.isReady()) {
+		// registration and GPRS are still coming up
+		return false;
+	}
+	GATEWAY_DEBUG(PSTR("GWT:TPC:IP=%s\n"), modem.getLocalIP());
 #elif defined(MY_GATEWAY_TINYGSM)
 	GATEWAY_DEBUG(PSTR("GWT:TPC:IP=%s\n"), modem.getLocalIP().c_str());
 #else
@@ -189,8 +424,7 @@ bool gatewayTransportConnect(void)
 	GATEWAY_DEBUG(PSTR("GWT:TPC:IP=%" PRIu8 ".%" PRIu8 ".%" PRIu8 ".%" PRIu8 "\n"),
 	              Ethernet.localIP()[0],
 	              Ethernet.localIP()[1], Ethernet.localIP()[2], Ethernet.localIP()[3]);
-	// give the Ethernet interface a second to initialize
-	delay(1000);
+	// no settle delay, a broker connection that fails is retried with the backoff
 #endif
 	return true;
 }
@@ -205,9 +439,18 @@ bool gatewayTransportInit(void)
 	rate = TinyGsmAutoBaud(SerialAT);
 #endif /* End of MY_GSM_BAUDRATE */
 
-	SerialAT.begin(rate);
-	delay(3000);
+	_MQTT_gsmSerial.begin(rate);
 
+#if defined(MY_GSM_ASYNC)
+	// brought up from gatewayTransportAvailable(), the radio keeps running meanwhile
+#if defined(MY_GSM_PIN)
+	modem.begin(MY_GSM_APN, MY_GSM_USR, MY_GSM_PSW, MY_GSM_PIN);
+#else
+	modem.begin(MY_GSM_APN, MY_GSM_USR, MY_GSM_PSW);
+#endif /* End of MY_GSM_PIN */
+	GATEWAY_DEBUG(PSTR("GWT:TIN:GSM ASYNC\n"));
+#else /* Else part of MY_GSM_ASYNC */
+	// waits until the modem answers AT instead of a fixed power-up delay
 	modem.restart();
 
 #if defined(MY_GSM_PIN) && !defined(TINY_GSM_MODEM_ESP8266)
@@ -226,15 +469,14 @@ bool gatewayTransportInit(void)
 		while (true);
 	}
 	GATEWAY_DEBUG(PSTR("GWT:TIN:ETH OK\n"));
-	delay(1000);
 #else /* Else part of TINY_GSM_MODEM_ESP8266 */
 	if (!modem.networkConnect(MY_GSM_SSID, MY_GSM_PSW)) {
 		GATEWAY_DEBUG(PSTR("!GWT:TIN:ETH FAIL\n"));
 		while (true);
 	}
 	GATEWAY_DEBUG(PSTR("GWT:TIN:ETH OK\n"));
-	delay(1000);
 #endif /* End of TINY_GSM_MODEM_ESP8266 */
+#endif /* End of MY_GSM_ASYNC */
 
 #endif /* End of MY_GATEWAY_TINYGSM */
 
@@ -245,6 +487,33 @@ bool gatewayTransportInit(void)
 #endif /* End of MY_CONTROLLER_IP_ADDRESS */
 
 	_MQTT_client.setCallback(incomingMQTT);
+#if defined(MY_MQTT_CLIENT_PUBLISH_QOS1)
+	_MQTT_client.setAckCallback(_MQTT_queueAck);
+#endif /* End of MY_MQTT_CLIENT_PUBLISH_QOS1 */
+	if (!_MQTT_client.setBufferSize(MY_MQTT_CLIENT_BUFFER_SIZE)) {
+		GATEWAY_DEBUG(PSTR("!GWT:TIN:MQTT BUFFER SIZE\n"));
+	}
+	_MQTT_client.setKeepAlive(MY_MQTT_CLIENT_KEEPALIVE_S);
+	_MQTT_client.setSocketTimeout(MY_MQTT_CLIENT_SOCKET_TIMEOUT_S);
+
+#if defined(MY_MQTT_CLIENT_TLS)
+#if defined(MY_GATEWAY_ESP8266)
+	_MQTT_ethClient.setSession(&_MQTT_tlsSession);
+#if defined(MY_MQTT_CLIENT_TLS_CA_CERT)
+	_MQTT_ethClient.setTrustAnchors(&_MQTT_tlsTrust);
+#elif defined(MY_MQTT_CLIENT_TLS_FINGERPRINT)
+	_MQTT_ethClient.setFingerprint(MY_MQTT_CLIENT_TLS_FINGERPRINT);
+#else
+	_MQTT_ethClient.setInsecure();
+#endif /* End of MY_MQTT_CLIENT_TLS_CA_CERT */
+#else /* Else part of MY_GATEWAY_ESP8266 */
+#if defined(MY_MQTT_CLIENT_TLS_CA_CERT)
+	_MQTT_ethClient.setCACert(MY_MQTT_CLIENT_TLS_CA_CERT);
+#else
+	_MQTT_ethClient.setInsecure();
+#endif /* End of MY_MQTT_CLIENT_TLS_CA_CERT */
+#endif /* End of MY_GATEWAY_ESP8266 */
+#endif /* End of MY_MQTT_CLIENT_TLS */
 
 #if defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32)
 	// Turn off access point
@@ -258,9 +527,15 @@ bool gatewayTransportInit(void)
 	WiFi.config(_MQTT_clientIp, _gatewayIp, _subnetIp);
 #endif /* End of MY_IP_ADDRESS */
 	(void)WiFi.begin(MY_WIFI_SSID, MY_WIFI_PASSWORD, 0, MY_WIFI_BSSID);
+#if defined(MY_GATEWAY_ESP32)
+	_MQTT_wifiBeginAt = hwMillis();
+#endif /* End of MY_GATEWAY_ESP32 */
 #endif
 
 	gatewayTransportConnect();
+#if defined(MY_GATEWAY_SECONDARY_TCP_PORT)
+	(void)gatewaySecondaryInit();
+#endif /* End of MY_GATEWAY_SECONDARY_TCP_PORT */
 
 	_MQTT_connecting = false;
 	return true;
@@ -271,28 +546,57 @@ bool gatewayTransportAvailable(void)
 	if (_MQTT_connecting) {
 		return false;
 	}
+	if (!_MQTT_rxQueue.empty()) {
+		// drain what the last poll delivered before polling the broker again
+		return true;
+	}
+#if defined(MY_GSM_UART_DMA)
+	if (_MQTT_gsmSerial.overruns() != _MQTT_gsmOverruns) {
+		_MQTT_gsmOverruns = _MQTT_gsmSerial.overruns();
+		GATEWAY_DEBUG(PSTR("!GWT:TSA:UART OVR,N=%" PRIu32 ",HW=%" PRIu16 "\n"), _MQTT_gsmOverruns,
+		              _MQTT_gsmSerial.highWater());
+	}
+#endif /* End of MY_GSM_UART_DMA */
+#if defined(MY_GSM_ASYNC)
+	modem.loop(MY_GSM_ASYNC_SLICE_MS);
+#endif /* End of MY_GSM_ASYNC */
 #if defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32)
 	if (WiFi.status() != WL_CONNECTED) {
 #if defined(MY_GATEWAY_ESP32)
-		(void)gatewayTransportInit();
+		// restart the association if it did not come up, without a delay throttling the calls
+		if ((uint32_t)(hwMillis() - _MQTT_wifiBeginAt) >= MY_GATEWAY_RECONNECT_MAX_DELAY_MS) {
+			(void)gatewayTransportInit();
+		}
 #endif
 		return false;
 	}
 #endif
 	if (!_MQTT_client.connected()) {
-		//reinitialise client
-		if (gatewayTransportConnect()) {
+#if defined(MY_GATEWAY_LINUX) || defined(MY_GSM_ASYNC)
+		const bool pending = _MQTT_ethClient.connecting();
+#else
+		const bool pending = false;
+#endif /* End of MY_GATEWAY_LINUX || MY_GSM_ASYNC */
+		// reinitialise client, failed attempts are retried with a backoff
+		if ((pending || gatewayTransportReconnectDue()) && gatewayTransportConnect()) {
 			reconnectMQTT();
 		}
 		return false;
 	}
 	_MQTT_client.loop();
-	return _MQTT_available;
+#if defined(MY_MQTT_CLIENT_PUBLISH_QOS1)
+	_MQTT_queuePump();
+#endif /* End of MY_MQTT_CLIENT_PUBLISH_QOS1 */
+	return !_MQTT_rxQueue.empty();
 }
 
 MyMessage & gatewayTransportReceive(void)
 {
-	// Return the last parsed message
-	_MQTT_available = false;
+	// Return the oldest parsed message, copied out so the slot can be reused right away
+	const MyMessage *message = _MQTT_rxQueue.getBack();
+	if (message != NULL) {
+		_MQTT_msg = *message;
+		(void)_MQTT_rxQueue.popBack();
+	}
 	return _MQTT_msg;
 }
@@ -0,0 +1,157 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// Second controller link of the MQTT or serial gateway: a TCP server speaking the serial
+// protocol, see MY_GATEWAY_SECONDARY_TCP_PORT. It is driven by the thread owning the first link.
+
+#include "MyGatewayTransport.h"
+
+static EthernetServer _secondaryServer(MY_GATEWAY_SECONDARY_TCP_PORT,
+                                       MY_GATEWAY_SECONDARY_MAX_CLIENTS);
+static EthernetClient _secondaryClients[MY_GATEWAY_SECONDARY_MAX_CLIENTS];
+static bool _secondaryConnected[MY_GATEWAY_SECONDARY_MAX_CLIENTS];
+static protocolParser_t _secondaryParser[MY_GATEWAY_SECONDARY_MAX_CLIENTS];
+static MyMessage _secondaryMsg[MY_GATEWAY_SECONDARY_MAX_CLIENTS];	// parsed in place per client
+static uint8_t _secondaryRxClient = 0;
+static bool _secondaryStarted = false;
+
+bool gatewaySecondaryInit(void)
+{
+	if (!_secondaryStarted) {
+		_secondaryServer.begin();
+		_secondaryServer.setTxCoalescing(MY_LINUX_ETHERNET_TX_FLUSH_MS, MY_LINUX_ETHERNET_TX_FLUSH_SIZE);
+		_secondaryStarted = true;
+		GATEWAY_DEBUG(PSTR("GWT:SEC:PORT=%" PRIu16 "\n"), (uint16_t)MY_GATEWAY_SECONDARY_TCP_PORT);
+	}
+	return true;
+}
+
+void gatewaySecondarySend(MyMessage &message, const char *line, size_t length)
+{
+#if defined(MY_GATEWAY_BINARY_FRAMING)
+	uint8_t frame[PROTOCOL_BINARY_MAX_LENGTH];
+	size_t frameLength = 0;
+#endif
+	for (uint8_t i = 0; i < MY_GATEWAY_SECONDARY_MAX_CLIENTS; i++) {
+		if (!_secondaryConnected[i]) {
+			continue;
+		}
+		// each format is built once, when the first client needing it is served
+#if defined(MY_GATEWAY_BINARY_FRAMING)
+		if (_secondaryParser[i].mode == PROTOCOL_MODE_BINARY) {
+			if (!frameLength) {
+				frameLength = protocolMyMessage2Binary(message, frame);
+			}
+			(void)_secondaryServer.write(_secondaryClients[i].getSocketNumber(), frame, frameLength);
+			continue;
+		}
+#endif
+		if (!line) {
+			line = protocolMyMessage2Serial(message, length);
+		}
+		(void)_secondaryServer.write(_secondaryClients[i].getSocketNumber(), (const uint8_t *)line,
+		                             length);
+	}
+}
+
+// slot of a client socket reported by the server, MY_GATEWAY_SECONDARY_MAX_CLIENTS if none
+static uint8_t _secondarySlot(const int sock)
+{
+	for (uint8_t i = 0; i < MY_GATEWAY_SECONDARY_MAX_CLIENTS; i++) {
+		if (_secondaryConnected[i] && _secondaryClients[i].getSocketNumber() == sock) {
+			return i;
+		}
+	}
+	return MY_GATEWAY_SECONDARY_MAX_CLIENTS;
+}
+
+static bool _secondaryRead(const uint8_t i)
+{
+	while (_secondaryClients[i].connected() && _secondaryClients[i].available()) {
+		const char inChar = _secondaryClients[i].read();
+		const protocolParseResult_t result = protocolParse(_secondaryParser[i], _secondaryMsg[i], inChar);
+		if (result == PROTOCOL_PARSE_OK) {
+			return true;
+		} else if (result == PROTOCOL_PARSE_TOO_LONG) {
+			GATEWAY_DEBUG(PSTR("!GWT:SEC:C=%" PRIu8 ",MSG TOO LONG\n"), i);
+		}
+	}
+	return false;
+}
+
+bool gatewaySecondaryAvailable(void)
+{
+	MyMessage message;
+
+	// send what was coalesced since the last loop iteration
+	_secondaryServer.flushIfDue();
+	// connections are served by the events of the server, idle clients cost nothing
+	const bool newClients = _secondaryServer.hasClient();
+	int sock;
+	while ((sock = _secondaryServer.closedClient()) != -1) {
+		const uint8_t i = _secondarySlot(sock);
+		if (i < MY_GATEWAY_SECONDARY_MAX_CLIENTS) {
+			GATEWAY_DEBUG(PSTR("GWT:SEC:C=%" PRIu8 ",DISCONNECTED\n"), i);
+			_secondaryClients[i].stop();
+			_secondaryConnected[i] = false;
+		}
+	}
+	if (newClients) {
+		for (uint8_t i = 0; i < MY_GATEWAY_SECONDARY_MAX_CLIENTS; i++) {
+			if (_secondaryConnected[i]) {
+				continue;
+			}
+			_secondaryClients[i] = _secondaryServer.available();
+			if (!_secondaryClients[i]) {
+				break;
+			}
+			_secondaryConnected[i] = true;
+			protocolParserReset(_secondaryParser[i]);
+			GATEWAY_DEBUG(PSTR("GWT:SEC:C=%" PRIu8 ",CONNECTED\n"), i);
+			// greet the new client only, the first link has seen this already
+			gatewaySecondarySend(buildGw(message, I_GATEWAY_READY).set(MSG_GW_STARTUP_COMPLETE), NULL, 0);
+			presentNode();
+		}
+		EthernetClient c = _secondaryServer.available();
+		while (c) {
+			GATEWAY_DEBUG(PSTR("!GWT:SEC:NO FREE SLOT\n"));
+			c.stop();
+			c = _secondaryServer.available();
+		}
+	}
+	// clients are read in the order their input arrived, one message per call
+	while ((sock = _secondaryServer.readableClient()) != -1) {
+		const uint8_t i = _secondarySlot(sock);
+		if (i < MY_GATEWAY_SECONDARY_MAX_CLIENTS && _secondaryRead(i)) {
+			if (_secondaryClients[i].available()) {
+				// the rest of the input is buffered by the client, the kernel does not report it
+				_secondaryServer.setReadable(sock);
+			}
+			_secondaryRxClient = i;
+			setIndication(INDICATION_GW_RX);
+			return true;
+		}
+	}
+	return false;
+}
+
+MyMessage &gatewaySecondaryReceive(void)
+{
+	return _secondaryMsg[_secondaryRxClient];
+}
@@ -26,20 +26,76 @@
 // global variables
 extern MyMessage _msgTmp;
 
-char _serialInputString[MY_GATEWAY_MAX_RECEIVE_LENGTH];    // A buffer for incoming commands from serial interface
-uint8_t _serialInputPos;
+protocolParser_t _serialParser;	// State of the command being received from the serial interface
 MyMessage _serialMsg;
 
+#if defined(MY_GATEWAY_SERIAL_BUFFERED)
+// whole lines only, debug prints written straight to the device never split one
+static uint8_t _serialTxBuffer[MY_GATEWAY_SERIAL_BUFFER_SIZE];
+static size_t _serialTxLength = 0;
+// block read from the device, parsed up to _serialRxPosition
+static uint8_t _serialRxBuffer[MY_GATEWAY_SERIAL_BUFFER_SIZE];
+static size_t _serialRxLength = 0;
+static size_t _serialRxPosition = 0;
+
+static void gatewaySerialWrite(const char *line, const size_t length)
+{
+	if (_serialTxLength + length > sizeof(_serialTxBuffer)) {
+		gatewayTransportFlush();
+	}
+	if (length > sizeof(_serialTxBuffer)) {
+		MY_SERIALDEVICE.write((const uint8_t *)line, length);
+		return;
+	}
+	(void)memcpy((void *)&_serialTxBuffer[_serialTxLength], (const void *)line, length);
+	_serialTxLength += length;
+}
+
+void gatewayTransportFlush(void)
+{
+	if (_serialTxLength) {
+		// one write, the USB stack fills whole packets
+		MY_SERIALDEVICE.write(_serialTxBuffer, _serialTxLength);
+		_serialTxLength = 0;
+	}
+}
+#endif
+
 bool gatewayTransportSend(MyMessage &message)
 {
 	setIndication(INDICATION_GW_TX);
-	MY_SERIALDEVICE.print(protocolMyMessage2Serial(message));
+	size_t length;
+#if defined(MY_GATEWAY_BINARY_FRAMING)
+	// reply in the framing the controller used last
+	const char *line = protocolMyMessage2Frame(message, _serialParser, length);
+#else
+	const char *line = protocolMyMessage2Serial(message, length);
+#endif
+	STATS_UPLINK(STATS_LATENCY_UPLINK_FORMAT);
+#if defined(MY_GATEWAY_SERIAL_BUFFERED)
+	gatewaySerialWrite(line, length);
+#else
+	MY_SERIALDEVICE.write((const uint8_t *)line, length);
+#endif
+#if defined(MY_GATEWAY_SECONDARY_TCP_PORT)
+#if defined(MY_GATEWAY_BINARY_FRAMING)
+	gatewaySecondarySend(message, NULL, 0);
+#else
+	// the serial line is formatted once for both links
+	gatewaySecondarySend(message, line, length);
+#endif
+#endif
+	STATS_INC(STATS_GW_TX_MESSAGES);
+	STATS_UPLINK(STATS_LATENCY_UPLINK_WRITE);
 	// Serial print is always successful
 	return true;
 }
 
 bool gatewayTransportInit(void)
 {
+#if defined(MY_GATEWAY_SECONDARY_TCP_PORT)
+	(void)gatewaySecondaryInit();
+#endif
 	(void)gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set(MSG_GW_STARTUP_COMPLETE));
 	// Send presentation of locally attached sensors (and node if applicable)
 	presentNode();
@@ -48,31 +104,41 @@ bool gatewayTransportInit(void)
 
 bool gatewayTransportAvailable(void)
 {
+#if defined(MY_GATEWAY_SERIAL_BUFFERED)
+	for (;;) {
+		if (_serialRxPosition == _serialRxLength) {
+			const int available = MY_SERIALDEVICE.available();
+			if (available <= 0) {
+				return false;
+			}
+			const size_t length = (size_t)available < sizeof(_serialRxBuffer) ? (size_t)available :
+			                      sizeof(_serialRxBuffer);
+			// takes what the device has received in one call, USB CDC copies whole packets
+			_serialRxLength = MY_SERIALDEVICE.readBytes((char *)_serialRxBuffer, length);
+			_serialRxPosition = 0;
+			if (!_serialRxLength) {
+				return false;
+			}
+		}
+		while (_serialRxPosition < _serialRxLength) {
+			if (protocolParse(_serialParser, _serialMsg,
+			                  (char)_serialRxBuffer[_serialRxPosition++]) == PROTOCOL_PARSE_OK) {
+				setIndication(INDICATION_GW_RX);
+				return true;
+			}
+		}
+	}
+#else
 	while (MY_SERIALDEVICE.available()) {
-		// get the new byte:
+		// get the new byte and parse it straight into the message:
 		const char inChar = (char)MY_SERIALDEVICE.read();
-		// if the incoming character is a newline, set a flag
-		// so the main loop can do something about it:
-		if (_serialInputPos < MY_GATEWAY_MAX_RECEIVE_LENGTH - 1) {
-			if (inChar == '\n') {
-				_serialInputString[_serialInputPos] = 0;
-				const bool ok = protocolSerial2MyMessage(_serialMsg, _serialInputString);
-				if (ok) {
-					setIndication(INDICATION_GW_RX);
-				}
-				_serialInputPos = 0;
-				return ok;
-			} else {
-				// add it to the inputString:
-				_serialInputString[_serialInputPos] = inChar;
-				_serialInputPos++;
-			}
-		} else {
-			// Incoming message too long. Throw away
-			_serialInputPos = 0;
+		if (protocolParse(_serialParser, _serialMsg, inChar) == PROTOCOL_PARSE_OK) {
+			setIndication(INDICATION_GW_RX);
+			return true;
 		}
 	}
 	return false;
+#endif
 }
 
 MyMessage & gatewayTransportReceive(void)
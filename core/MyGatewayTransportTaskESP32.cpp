@@ -0,0 +1,175 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// The controller task owns the gateway transport driver (WiFi, Ethernet, MQTT client) and is
+// pinned to the other core than the Arduino loop task, which keeps the radio, the transport
+// layer and the sketch callbacks. Same interface as the Linux controller thread, the two
+// tasks talk through two FreeRTOS queues.
+
+#include "MyGatewayTransport.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+typedef struct {
+	MyMessage message;
+#if defined(MY_STATS_LATENCY)
+	uint32_t origin;	// start of the path of the message
+#endif
+} gatewayTaskEntry_t;
+
+static QueueHandle_t _gwTxQueue = NULL;	// core -> controller
+static QueueHandle_t _gwRxQueue = NULL;	// controller -> core
+static volatile uint32_t _gwTxQueued = 0;
+static volatile uint32_t _gwTxDropped = 0;
+static volatile uint32_t _gwRxQueued = 0;
+static volatile uint32_t _gwRxBackpressure = 0;
+
+static TaskHandle_t _gwTask = NULL;
+static TaskHandle_t _gwStarter = NULL;
+static volatile bool _gwTaskRunning = false;
+static volatile bool _gwInitOk = false;
+
+static void _gatewayTaskLoop(void *)
+{
+	gatewayTaskEntry_t entry;
+	bool paused = false;
+
+	const bool initOk = gatewayTransportInit();
+	_gwInitOk = initOk;
+	_gwTaskRunning = initOk;
+	xTaskNotifyGive(_gwStarter);
+	if (!initOk) {
+		vTaskDelete(NULL);
+		return;
+	}
+
+	for (;;) {
+		// controller -> core, input is left in the driver while the core is behind
+		while (uxQueueSpacesAvailable(_gwRxQueue) > 0 && gatewayTransportAvailable()) {
+#if defined(MY_STATS_LATENCY)
+			entry.origin = statsLatencyStamp();
+#endif
+			entry.message = gatewayTransportReceive();
+			(void)xQueueSendToBack(_gwRxQueue, &entry, 0);
+			_gwRxQueued++;
+		}
+		const bool full = uxQueueSpacesAvailable(_gwRxQueue) == 0;
+		if (full && !paused) {
+			_gwRxBackpressure++;
+			GATEWAY_DEBUG(PSTR("!GWT:THR:RX BP,N=%" PRIu32 "\n"), _gwRxBackpressure);
+		}
+		paused = full;
+		// core -> controller, waiting for it is also the idle time of this task. At least one
+		// tick, so the idle task of this core gets to run and feeds the task watchdog.
+		if (xQueueReceive(_gwTxQueue, &entry, 1) == pdTRUE) {
+			do {
+#if defined(MY_STATS_LATENCY)
+				_statsUplinkOrigin = entry.origin;
+#endif
+				(void)gatewayTransportSend(entry.message);
+				STATS_UPLINK_END();
+			} while (xQueueReceive(_gwTxQueue, &entry, 0) == pdTRUE);
+		}
+	}
+}
+
+bool gatewayThreadInit(void)
+{
+	_gwTxQueue = xQueueCreate(MY_ESP32_DUAL_CORE_GATEWAY_QUEUE_SIZE, sizeof(gatewayTaskEntry_t));
+	_gwRxQueue = xQueueCreate(MY_ESP32_DUAL_CORE_GATEWAY_QUEUE_SIZE, sizeof(gatewayTaskEntry_t));
+	if (_gwTxQueue == NULL || _gwRxQueue == NULL) {
+		GATEWAY_DEBUG(PSTR("!GWT:THR:QUEUE FAIL\n"));
+		return false;
+	}
+	_gwStarter = xTaskGetCurrentTaskHandle();
+	if (xTaskCreatePinnedToCore(_gatewayTaskLoop, "gatewayTask", MY_ESP32_CONTROLLER_STACK_SIZE,
+	                            NULL, uxTaskPriorityGet(NULL), &_gwTask, MY_ESP32_CONTROLLER_CORE) != pdPASS) {
+		GATEWAY_DEBUG(PSTR("!GWT:THR:START FAIL\n"));
+		return false;
+	}
+	(void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+	if (!_gwInitOk) {
+		return false;
+	}
+	GATEWAY_DEBUG(PSTR("GWT:THR:START\n"));
+	return true;
+}
+
+bool gatewayThreadIsController(void)
+{
+	return _gwTaskRunning && xTaskGetCurrentTaskHandle() == _gwTask;
+}
+
+bool gatewayThreadIsCore(void)
+{
+	return _gwTaskRunning && xTaskGetCurrentTaskHandle() != _gwTask;
+}
+
+bool gatewayThreadSend(MyMessage &message)
+{
+	gatewayTaskEntry_t entry;
+	entry.message = message;
+#if defined(MY_STATS_LATENCY)
+	entry.origin = _statsUplinkOrigin;
+#endif
+	if (xQueueSendToBack(_gwTxQueue, &entry, 0) != pdTRUE) {
+		_gwTxDropped++;
+		GATEWAY_DEBUG(PSTR("!GWT:THR:TX DROP,N=%" PRIu32 "\n"), _gwTxDropped);
+		return false;
+	}
+	_gwTxQueued++;
+	return true;
+}
+
+bool gatewayThreadReceive(MyMessage &message)
+{
+	gatewayTaskEntry_t entry;
+	if (xQueueReceive(_gwRxQueue, &entry, 0) != pdTRUE) {
+		return false;
+	}
+	message = entry.message;
+#if defined(MY_STATS_LATENCY)
+	_statsDownlinkOrigin = entry.origin;
+#endif
+	return true;
+}
+
+void gatewayThreadPresentNode(void)
+{
+	gatewayTaskEntry_t entry;
+	// handled by _processInternalCoreMessage() on the core task
+	(void)buildGw(entry.message, I_PRESENTATION).set("");
+#if defined(MY_STATS_LATENCY)
+	entry.origin = 0;
+#endif
+	if (xQueueSendToBack(_gwRxQueue, &entry, 0) == pdTRUE) {
+		_gwRxQueued++;
+	}
+}
+
+gatewayThreadStats_t gatewayThreadGetStats(void)
+{
+	gatewayThreadStats_t stats;
+	stats.txQueued = _gwTxQueued;
+	stats.txDropped = _gwTxDropped;
+	stats.rxQueued = _gwRxQueued;
+	stats.rxBackpressure = _gwRxBackpressure;
+	return stats;
+}
@@ -0,0 +1,226 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// The controller thread owns the gateway transport driver (sockets, MQTT client).
+// The core thread (radio, transport, sketch callbacks) talks to it through two SPSC queues.
+
+#include "MyGatewayTransport.h"
+#include <pthread.h>
+#include "hal/architecture/Linux/drivers/core/SPSCQueue.h"
+#include "hal/architecture/Linux/drivers/core/SlabPool.h"
+
+typedef struct {
+	MyMessage message;
+	uint32_t stamp;		// start of the path, see MY_STATS_LATENCY
+} gatewayThreadEntry_t;
+
+typedef SPSCQueue<gatewayThreadEntry_t *, MY_LINUX_THREADED_GATEWAY_QUEUE_SIZE> gatewayThreadQueue_t;
+
+// entries of both queues, a queue holds at most MY_LINUX_THREADED_GATEWAY_QUEUE_SIZE - 1
+static SlabPool<gatewayThreadEntry_t, 2 * MY_LINUX_THREADED_GATEWAY_QUEUE_SIZE> _gwPool("gw_thread");
+static gatewayThreadQueue_t _gwTxQueue;	// core -> controller
+static gatewayThreadQueue_t _gwRxQueue;	// controller -> core
+static volatile uint32_t _gwTxQueued = 0;
+static volatile uint32_t _gwTxDropped = 0;
+static volatile uint32_t _gwRxQueued = 0;
+static volatile uint32_t _gwRxBackpressure = 0;
+
+static pthread_t _gwThread;
+static volatile bool _gwThreadRunning = false;
+static pthread_mutex_t _gwInitMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _gwInitCond = PTHREAD_COND_INITIALIZER;
+static int _gwInitResult = -1;	// -1 pending, 0 failed, 1 ok
+
+// producer side
+static bool _gatewayThreadPush(gatewayThreadQueue_t &queue, const MyMessage &message,
+                               const uint32_t stamp)
+{
+	if (queue.full()) {
+		return false;
+	}
+	gatewayThreadEntry_t *entry = _gwPool.alloc();
+	if (!entry) {
+		return false;
+	}
+	entry->message = message;
+	entry->stamp = stamp;
+	return queue.push(entry);
+}
+
+// consumer side
+static bool _gatewayThreadPop(gatewayThreadQueue_t &queue, MyMessage &message, uint32_t &stamp)
+{
+	gatewayThreadEntry_t *entry;
+	if (!queue.pop(entry)) {
+		return false;
+	}
+	message = entry->message;
+	stamp = entry->stamp;
+	_gwPool.release(entry);
+	return true;
+}
+
+static void *_gatewayThreadLoop(void *)
+{
+	MyMessage message;
+	uint32_t stamp;
+	bool paused = false;
+
+	// sockets opened by the driver are watched by this thread's event loop
+	eventLoopSetTick(MY_LINUX_EVENT_LOOP_TICK_MS);
+	const bool initOk = gatewayTransportInit();
+	pthread_mutex_lock(&_gwInitMutex);
+	_gwThread = pthread_self();
+	_gwThreadRunning = initOk;
+	_gwInitResult = initOk ? 1 : 0;
+	pthread_cond_signal(&_gwInitCond);
+	pthread_mutex_unlock(&_gwInitMutex);
+	if (!initOk) {
+		eventLoopClose();
+		return NULL;
+	}
+
+	for (;;) {
+		// controller -> core, input is left in the sockets while the core is behind
+		while (!_gwRxQueue.full() && gatewayTransportAvailable()) {
+#if defined(MY_STATS_LATENCY)
+			stamp = statsLatencyStamp();
+#else
+			stamp = 0;
+#endif
+			(void)_gatewayThreadPush(_gwRxQueue, gatewayTransportReceive(), stamp);
+			_gwRxQueued++;
+			eventLoopWakeup();
+		}
+#if defined(MY_GATEWAY_SECONDARY_TCP_PORT)
+		while (!_gwRxQueue.full() && gatewaySecondaryAvailable()) {
+#if defined(MY_STATS_LATENCY)
+			stamp = statsLatencyStamp();
+#else
+			stamp = 0;
+#endif
+			(void)_gatewayThreadPush(_gwRxQueue, gatewaySecondaryReceive(), stamp);
+			_gwRxQueued++;
+			eventLoopWakeup();
+		}
+#endif
+		const bool full = _gwRxQueue.full();
+		if (full && !paused) {
+			_gwRxBackpressure++;
+			GATEWAY_DEBUG(PSTR("!GWT:THR:RX BP,N=%" PRIu32 "\n"), _gwRxBackpressure);
+		}
+		paused = full;
+		// core -> controller
+		while (_gatewayThreadPop(_gwTxQueue, message, stamp)) {
+#if defined(MY_STATS_LATENCY)
+			_statsUplinkOrigin = stamp;
+#endif
+			(void)gatewayTransportSend(message);
+			STATS_UPLINK_END();
+		}
+		if (paused) {
+			// give the core time to catch up
+			usleep(1000);
+		} else {
+			(void)eventLoopWait(-1);
+		}
+	}
+	return NULL;
+}
+
+bool gatewayThreadInit(void)
+{
+	pthread_t thread;
+
+	if (pthread_create(&thread, NULL, _gatewayThreadLoop, NULL) != 0) {
+		GATEWAY_DEBUG(PSTR("!GWT:THR:START FAIL\n"));
+		return false;
+	}
+	pthread_mutex_lock(&_gwInitMutex);
+	while (_gwInitResult == -1) {
+		pthread_cond_wait(&_gwInitCond, &_gwInitMutex);
+	}
+	pthread_mutex_unlock(&_gwInitMutex);
+	if (_gwInitResult != 1) {
+		(void)pthread_join(thread, NULL);
+		return false;
+	}
+	(void)pthread_detach(thread);
+	GATEWAY_DEBUG(PSTR("GWT:THR:START\n"));
+	return true;
+}
+
+bool gatewayThreadIsController(void)
+{
+	return _gwThreadRunning && pthread_equal(pthread_self(), _gwThread);
+}
+
+bool gatewayThreadIsCore(void)
+{
+	return _gwThreadRunning && !pthread_equal(pthread_self(), _gwThread);
+}
+
+bool gatewayThreadSend(MyMessage &message)
+{
+#if defined(MY_STATS_LATENCY)
+	const uint32_t stamp = _statsUplinkOrigin;
+#else
+	const uint32_t stamp = 0;
+#endif
+	if (!_gatewayThreadPush(_gwTxQueue, message, stamp)) {
+		_gwTxDropped++;
+		GATEWAY_DEBUG(PSTR("!GWT:THR:TX DROP,N=%" PRIu32 "\n"), _gwTxDropped);
+		return false;
+	}
+	_gwTxQueued++;
+	eventLoopWakeup();
+	return true;
+}
+
+bool gatewayThreadReceive(MyMessage &message)
+{
+	uint32_t stamp;
+	if (!_gatewayThreadPop(_gwRxQueue, message, stamp)) {
+		return false;
+	}
+#if defined(MY_STATS_LATENCY)
+	_statsDownlinkOrigin = stamp;
+#endif
+	return true;
+}
+
+void gatewayThreadPresentNode(void)
+{
+	MyMessage message;
+	// handled by _processInternalCoreMessage() on the core thread
+	if (_gatewayThreadPush(_gwRxQueue, buildGw(message, I_PRESENTATION).set(""), 0)) {
+		_gwRxQueued++;
+		eventLoopWakeup();
+	}
+}
+
+gatewayThreadStats_t gatewayThreadGetStats(void)
+{
+	gatewayThreadStats_t stats;
+	stats.txQueued = _gwTxQueued;
+	stats.txDropped = _gwTxDropped;
+	stats.rxQueued = _gwRxQueued;
+	stats.rxBackpressure = _gwRxBackpressure;
+	return stats;
+}
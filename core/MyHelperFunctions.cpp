@@ -39,3 +39,261 @@ static char convertI2H(const uint8_t i)
 		return 'A' + k - 10;
 	}
 }
+
+// SIMD hex codecs on the Linux gateway
+#if defined(__linux__) && defined(__SSE2__)
+#define MY_HEX_SSE2
+#include <emmintrin.h>
+#elif defined(__linux__) && defined(__ARM_NEON)
+#define MY_HEX_NEON
+#include <arm_neon.h>
+#endif
+
+static const char _hexDigits[16] PROGMEM = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+
+// '0'..'9', 'A'..'F' and 'a'..'f' to 0..15 without branches: letters have bit 6 set
+#define HEX_NIBBLE(c) (((uint8_t)(c) & 0x0F) + 9 * (((uint8_t)(c) >> 6) & 1))
+
+static void convertBuf2Hex(char *hex, const uint8_t *data, const size_t length)
+{
+	size_t i = 0;
+#if defined(MY_HEX_SSE2)
+	// 16 bytes at a time: nibble + '0', + 7 more for A..F
+	const __m128i mask = _mm_set1_epi8(0x0F);
+	const __m128i nine = _mm_set1_epi8(9);
+	const __m128i zero = _mm_set1_epi8('0');
+	const __m128i letters = _mm_set1_epi8('A' - '0' - 10);
+	for (; i + 16 <= length; i += 16) {
+		const __m128i bytes = _mm_loadu_si128((const __m128i *)&data[i]);
+		const __m128i hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+		const __m128i lo = _mm_and_si128(bytes, mask);
+		const __m128i hiHex = _mm_add_epi8(_mm_add_epi8(hi, zero), _mm_and_si128(_mm_cmpgt_epi8(hi,
+		                                   nine), letters));
+		const __m128i loHex = _mm_add_epi8(_mm_add_epi8(lo, zero), _mm_and_si128(_mm_cmpgt_epi8(lo,
+		                                   nine), letters));
+		_mm_storeu_si128((__m128i *)&hex[i * 2], _mm_unpacklo_epi8(hiHex, loHex));
+		_mm_storeu_si128((__m128i *)&hex[i * 2 + 16], _mm_unpackhi_epi8(hiHex, loHex));
+	}
+#elif defined(MY_HEX_NEON)
+	const uint8x16_t mask = vdupq_n_u8(0x0F);
+	const uint8x16_t nine = vdupq_n_u8(9);
+	const uint8x16_t zero = vdupq_n_u8('0');
+	const uint8x16_t letters = vdupq_n_u8('A' - '0' - 10);
+	for (; i + 16 <= length; i += 16) {
+		const uint8x16_t bytes = vld1q_u8(&data[i]);
+		const uint8x16_t hi = vshrq_n_u8(bytes, 4);
+		const uint8x16_t lo = vandq_u8(bytes, mask);
+		uint8x16x2_t pairs;
+		pairs.val[0] = vaddq_u8(vaddq_u8(hi, zero), vandq_u8(vcgtq_u8(hi, nine), letters));
+		pairs.val[1] = vaddq_u8(vaddq_u8(lo, zero), vandq_u8(vcgtq_u8(lo, nine), letters));
+		// interleaving store
+		vst2q_u8((uint8_t *)&hex[i * 2], pairs);
+	}
+#endif
+	for (; i < length; i++) {
+		hex[i * 2] = pgm_read_byte(&_hexDigits[data[i] >> 4]);
+		hex[i * 2 + 1] = pgm_read_byte(&_hexDigits[data[i] & 0x0F]);
+	}
+	hex[length * 2] = '\0';
+}
+
+static void convertHex2Buf(uint8_t *data, const char *hex, const size_t length)
+{
+	size_t i = 0;
+#if defined(MY_HEX_SSE2)
+	// 32 chars at a time, a 16 bit lane holds the high and the low nibble char of one byte
+	const __m128i mask = _mm_set1_epi8(0x0F);
+	const __m128i letter = _mm_set1_epi8(0x40);
+	const __m128i nine = _mm_set1_epi8(9);
+	const __m128i low = _mm_set1_epi16(0x00FF);
+	for (; i + 16 <= length; i += 16) {
+		__m128i lanes[2];
+		for (uint8_t j = 0; j < 2; j++) {
+			const __m128i chars = _mm_loadu_si128((const __m128i *)&hex[i * 2 + j * 16]);
+			const __m128i isLetter = _mm_cmpeq_epi8(_mm_and_si128(chars, letter), letter);
+			const __m128i nibbles = _mm_add_epi8(_mm_and_si128(chars, mask), _mm_and_si128(isLetter, nine));
+			lanes[j] = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(nibbles, low), 4),
+			                        _mm_srli_epi16(nibbles, 8));
+		}
+		_mm_storeu_si128((__m128i *)&data[i], _mm_packus_epi16(lanes[0], lanes[1]));
+	}
+#elif defined(MY_HEX_NEON)
+	const uint8x16_t mask = vdupq_n_u8(0x0F);
+	const uint8x16_t one = vdupq_n_u8(1);
+	const uint8x16_t nine = vdupq_n_u8(9);
+	for (; i + 16 <= length; i += 16) {
+		// deinterleaving load: high nibble chars, low nibble chars
+		const uint8x16x2_t chars = vld2q_u8((const uint8_t *)&hex[i * 2]);
+		const uint8x16_t hi = vmlaq_u8(vandq_u8(chars.val[0], mask),
+		                               vandq_u8(vshrq_n_u8(chars.val[0], 6), one), nine);
+		const uint8x16_t lo = vmlaq_u8(vandq_u8(chars.val[1], mask),
+		                               vandq_u8(vshrq_n_u8(chars.val[1], 6), one), nine);
+		vst1q_u8(&data[i], vorrq_u8(vshlq_n_u8(hi, 4), lo));
+	}
+#endif
+	for (; i < length; i++) {
+		data[i] = (HEX_NIBBLE(hex[i * 2]) << 4) | HEX_NIBBLE(hex[i * 2 + 1]);
+	}
+}
+
+static const char _decimalPairs[201] PROGMEM =
+    "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+    "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+static uint8_t convertU2D(char *buffer, uint32_t value)
+{
+	char digits[10];
+	uint8_t pos = sizeof(digits);
+	// write two digits per division, from the end
+	while (value >= 100) {
+		const uint8_t pair = (value % 100) * 2;
+		value /= 100;
+		digits[--pos] = pgm_read_byte(&_decimalPairs[pair + 1]);
+		digits[--pos] = pgm_read_byte(&_decimalPairs[pair]);
+	}
+	if (value >= 10) {
+		digits[--pos] = pgm_read_byte(&_decimalPairs[value * 2 + 1]);
+		digits[--pos] = pgm_read_byte(&_decimalPairs[value * 2]);
+	} else {
+		digits[--pos] = '0' + value;
+	}
+	const uint8_t length = sizeof(digits) - pos;
+	(void)memcpy(buffer, &digits[pos], length);
+	buffer[length] = 0;
+	return length;
+}
+
+static uint8_t convertI2D(char *buffer, const int32_t value)
+{
+	if (value < 0) {
+		buffer[0] = '-';
+		return 1 + convertU2D(&buffer[1], (uint32_t)0 - (uint32_t)value);
+	}
+	return convertU2D(buffer, (uint32_t)value);
+}
+
+static const uint32_t _powersOf10[9] = {1ul, 10ul, 100ul, 1000ul, 10000ul, 100000ul, 1000000ul,
+                                        10000000ul, 100000000ul
+                                       };
+
+// value scaled by 10^decimals to decimal, integer only
+static uint8_t convertScaled2D(char *buffer, const bool negative, const uint32_t scaled,
+                               const uint8_t decimals)
+{
+	uint8_t pos = 0;
+	if (negative) {
+		buffer[pos++] = '-';
+	}
+	pos += convertU2D(&buffer[pos], scaled / _powersOf10[decimals]);
+	if (decimals) {
+		char fraction[10];
+		// zero padded to decimals digits
+		const uint8_t length = convertU2D(fraction, (scaled % _powersOf10[decimals]) + _powersOf10[decimals]);
+		buffer[pos++] = '.';
+		(void)memcpy(&buffer[pos], &fraction[1], length - 1);
+		pos += length - 1;
+	} else if (pos < 2) {
+		// minimum field width of 2, as dtostrf pads
+		buffer[1] = buffer[0];
+		buffer[0] = ' ';
+		pos = 2;
+	}
+	buffer[pos] = 0;
+	return pos;
+}
+
+static uint8_t convertF2D(char *buffer, const float value, const uint8_t decimals)
+{
+	const uint8_t prec = decimals > 8 ? 8 : decimals;
+	uint32_t bits;
+	(void)memcpy(&bits, &value, sizeof(bits));
+	const bool negative = bits >> 31;
+	const uint8_t exponent = (uint8_t)(bits >> 23);
+	// value = mantissa * 2^shift, integer only: on AVR double is float and
+	// value * 10^decimals would round before we do
+	const uint32_t mantissa = exponent ? (bits & 0x7FFFFFul) | 0x800000ul : bits & 0x7FFFFFul;
+	const int16_t shift = (int16_t)(exponent ? exponent : 1) - 150;
+	// exact, 24 bit mantissa * 10^8 < 2^51
+	uint64_t scaled = (uint64_t)mantissa * _powersOf10[prec];
+	uint64_t remainder = 0;
+	uint64_t half = 1;
+	if (exponent == 0xFF || shift > 8) {
+		// NaN, infinity and values of 2^32 and above
+		scaled = UINT64_MAX;
+	} else if (shift >= 0) {
+		scaled <<= shift;
+	} else if (shift > -52) {
+		half <<= -shift - 1;
+		remainder = scaled & ((half << 1) - 1);
+		scaled >>= -shift;
+	} else {
+		// below 10^-8
+		scaled = 0;
+	}
+	if (scaled >= 0xFFFFFFFFul) {
+		(void)dtostrf(value, 2, prec, buffer);
+		return strlen(buffer);
+	}
+	uint32_t rounded = (uint32_t)scaled;
+	// round half to even, as printf does
+	if (remainder > half || (remainder == half && (rounded & 1u))) {
+		rounded++;
+	}
+	return convertScaled2D(buffer, negative, rounded, prec);
+}
+
+static uint8_t convertX2D(char *buffer, const int32_t value, const uint8_t decimals)
+{
+	return convertScaled2D(buffer, value < 0,
+	                       value < 0 ? (uint32_t)0 - (uint32_t)value : (uint32_t)value,
+	                       decimals > 8 ? 8 : decimals);
+}
+
+#if defined(__AVR__)
+#include <util/crc16.h>
+
+static uint16_t crc16Update(uint16_t crc, const uint8_t data)
+{
+	// avr-libc, branch free assembler, no table in flash
+	return _crc16_update(crc, data);
+}
+#else
+// one byte of the reflected CRC, bit by bit, to build the table at compile time
+static constexpr uint16_t _crc16Bits(const uint16_t crc, const uint8_t bits)
+{
+	return bits ? _crc16Bits((crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1), bits - 1) : crc;
+}
+#define _CRC16_T4(n) _crc16Bits((n), 8), _crc16Bits((n) + 1, 8), _crc16Bits((n) + 2, 8), \
+	_crc16Bits((n) + 3, 8)
+#define _CRC16_T16(n) _CRC16_T4(n), _CRC16_T4((n) + 4), _CRC16_T4((n) + 8), _CRC16_T4((n) + 12)
+#define _CRC16_T64(n) _CRC16_T16(n), _CRC16_T16((n) + 16), _CRC16_T16((n) + 32), \
+	_CRC16_T16((n) + 48)
+
+static const uint16_t _crc16Table[256] = {
+	_CRC16_T64(0), _CRC16_T64(64), _CRC16_T64(128), _CRC16_T64(192)
+};
+
+static uint16_t crc16Update(uint16_t crc, const uint8_t data)
+{
+	return (crc >> 8) ^ _crc16Table[(crc ^ data) & 0xFF];
+}
+#endif
+
+static uint16_t crc16Buffer(uint16_t crc, const uint8_t *data, const size_t length)
+{
+	for (size_t i = 0; i < length; i++) {
+		crc = crc16Update(crc, data[i]);
+	}
+	return crc;
+}
+
+static uint16_t crc16Atsha204(const uint8_t *data, const uint8_t length)
+{
+	// same CRC reflected: 0xA001 is 0x8005 bit reversed, so only the result needs reversing
+	const uint16_t reflected = crc16Buffer(0, data, length);
+	uint16_t crc = 0;
+	for (uint8_t i = 0; i < 16; i++) {
+		crc = (crc << 1) | ((reflected >> i) & 1);
+	}
+	return crc;
+}
@@ -34,5 +34,86 @@ static uint8_t convertH2I(const char c) __attribute__((unused));
 */
 static char convertI2H(const uint8_t i) __attribute__((unused));
 
+/**
+* Bytes to upper case hex conversion
+* @param hex destination, at least 2*length+1 chars, null terminated
+* @param data bytes
+* @param length number of bytes
+*/
+static void convertBuf2Hex(char *hex, const uint8_t *data, const size_t length) __attribute__((unused));
+
+/**
+* Hex to bytes conversion, upper or lower case
+* @param data destination
+* @param hex 2*length hex chars
+* @param length number of bytes to decode
+*/
+static void convertHex2Buf(uint8_t *data, const char *hex, const size_t length) __attribute__((unused));
+
+/**
+* Unsigned integer to decimal conversion
+* @param buffer destination, at least 11 bytes, null terminated
+* @param value integer
+* @return number of characters written, excluding the terminating null
+*/
+static uint8_t convertU2D(char *buffer, uint32_t value) __attribute__((unused));
+
+/**
+* Signed integer to decimal conversion
+* @param buffer destination, at least 12 bytes, null terminated
+* @param value integer
+* @return number of characters written, excluding the terminating null
+*/
+static uint8_t convertI2D(char *buffer, const int32_t value) __attribute__((unused));
+
+/**
+* Float to decimal conversion, as dtostrf(value, 2, decimals, buffer)
+*
+* Scales the exact binary value in integer math and rounds half to even, as printf does, e.g.
+* 0.125 with 2 decimals gives 0.12. avr-libc dtostrf() may differ in the last digit on ties.
+* Values that do not fit 32 bits once scaled by 10^decimals are handed to dtostrf().
+* @param buffer destination, at least 2*MAX_PAYLOAD+1 bytes, null terminated
+* @param value float
+* @param decimals number of decimals, max 8
+* @return number of characters written, excluding the terminating null
+*/
+static uint8_t convertF2D(char *buffer, const float value, const uint8_t decimals) __attribute__((unused));
+
+/**
+* Fixed-point to decimal conversion, integer only, same output as convertF2D()
+* @param buffer destination, at least 13 bytes, null terminated
+* @param value number scaled by 10^decimals
+* @param decimals number of decimals, max 8
+* @return number of characters written, excluding the terminating null
+*/
+static uint8_t convertX2D(char *buffer, const int32_t value, const uint8_t decimals) __attribute__((unused));
+
+/**
+* CRC-16 with the reflected polynomial 0xA001 (MODBUS, ARC), one byte
+*
+* Used by OTA, the binary gateway framing and RS485. Start with 0xFFFF.
+* @param crc CRC so far
+* @param data byte
+* @return updated CRC
+*/
+static uint16_t crc16Update(uint16_t crc, const uint8_t data) __attribute__((unused));
+
+/**
+* CRC-16 with the reflected polynomial 0xA001, buffer
+* @param crc CRC so far
+* @param data bytes
+* @param length number of bytes
+* @return updated CRC
+*/
+static uint16_t crc16Buffer(uint16_t crc, const uint8_t *data, const size_t length) __attribute__((unused));
+
+/**
+* CRC-16 of the ATSHA204A and ATECC508A/608A: polynomial 0x8005 and initial 0, data bits LSB first
+* @param data bytes
+* @param length number of bytes
+* @return CRC, low byte first on the wire
+*/
+static uint16_t crc16Atsha204(const uint8_t *data, const uint8_t length) __attribute__((unused));
+
 
 #endif
@@ -22,12 +22,19 @@
 // global variables
 extern MyMessage _msgTmp;
 
-unsigned long _inclusionStartTime;
+static schedulerTask_t _inclusionTask;
 bool _inclusionMode;
 
+static void inclusionTimeout()
+{
+	// MY_INCLUSION_MODE_DURATION has passed, stop inclusion mode
+	inclusionModeSet(false);
+}
+
 inline void inclusionInit()
 {
 	_inclusionMode = false;
+	schedulerAdd(&_inclusionTask, inclusionTimeout);
 #if defined(MY_INCLUSION_BUTTON_FEATURE)
 	// Setup digital in that triggers inclusion mode
 	hwPinMode(MY_INCLUSION_MODE_BUTTON_PIN, INPUT_PULLUP);
@@ -48,7 +55,9 @@ void inclusionModeSet(bool newMode)
 		// Send back mode change to controller
 		gatewayTransportSend(buildGw(_msgTmp, I_INCLUSION_MODE).set((uint8_t)(_inclusionMode?1:0)));
 		if (_inclusionMode) {
-			_inclusionStartTime = hwMillis();
+			schedulerSet(&_inclusionTask, MY_INCLUSION_MODE_DURATION * 1000ul);
+		} else {
+			schedulerCancel(&_inclusionTask);
 		}
 	}
 #if defined (MY_INCLUSION_LED_PIN)
@@ -64,9 +73,4 @@ inline void inclusionProcess()
 		inclusionModeSet(true);
 	}
 #endif
-
-	if (_inclusionMode && hwMillis()-_inclusionStartTime>MY_INCLUSION_MODE_DURATION*1000L) {
-		// inclusionTimeInMinutes minute(s) has passed.. stop inclusion mode
-		inclusionModeSet(false);
-	}
 }
@@ -22,11 +22,23 @@
 #define LED_ON_OFF_RATIO        (4)       // Power of 2 please
 #define LED_PROCESS_INTERVAL_MS (MY_DEFAULT_LED_BLINK_PERIOD/LED_ON_OFF_RATIO)
 
+#if defined(LEDS_TIMER)
+// also counted down by the timer interrupt
+static volatile uint8_t countRx;
+static volatile uint8_t countTx;
+static volatile uint8_t countErr;
+static volatile bool ledsTimerRunning = false;
+#define ledsIdle() (!ledsTimerRunning)
+#else
 // these variables don't need to be volatile, since we are not using interrupts
 static uint8_t countRx;
 static uint8_t countTx;
 static uint8_t countErr;
-static unsigned long prevTime;
+static schedulerTask_t ledsTask;
+#define ledsIdle() (!schedulerPending(&ledsTask))
+#endif
+
+static void ledsUpdate();
 
 inline void ledsInit()
 {
@@ -45,19 +57,38 @@ inline void ledsInit()
 #if defined(MY_DEFAULT_ERR_LED_PIN)
 	hwPinMode(MY_DEFAULT_ERR_LED_PIN, OUTPUT);
 #endif
-	prevTime = hwMillis() -
-	           LED_PROCESS_INTERVAL_MS;     // Subtract some, to make sure leds gets updated on first run.
-	ledsProcess();
+#if !defined(LEDS_TIMER)
+	schedulerAdd(&ledsTask, ledsUpdate);
+#endif
+	ledsUpdate();
 }
 
+#if defined(LEDS_TIMER)
+void ledsSleep()
+{
+	// the next update after wake-up restores the pattern
+#if defined(MY_DEFAULT_RX_LED_PIN)
+	hwDigitalWrite(MY_DEFAULT_RX_LED_PIN, LED_OFF);
+#endif
+#if defined(MY_DEFAULT_TX_LED_PIN)
+	hwDigitalWrite(MY_DEFAULT_TX_LED_PIN, LED_OFF);
+#endif
+#if defined(MY_DEFAULT_ERR_LED_PIN)
+	hwDigitalWrite(MY_DEFAULT_ERR_LED_PIN, LED_OFF);
+#endif
+}
+#else
 void ledsProcess()
 {
-	// Just return if it is not the time...
-	if ((hwMillis() - prevTime) < LED_PROCESS_INTERVAL_MS) {
-		return;
-	}
-	prevTime = hwMillis();
+	PROFILING_SCOPE(PROFILING_LEDS_PROCESS);
+	// also called from nested waits, which do not run the scheduler
+	(void)schedulerRun(&ledsTask);
+}
+#endif
 
+// from the timer interrupt with LEDS_TIMER, or from the main loop while the timer is stopped
+static void ledsUpdate()
+{
 #if defined(MY_DEFAULT_RX_LED_PIN) || defined(MY_DEFAULT_TX_LED_PIN) || defined(MY_DEFAULT_ERR_LED_PIN)
 	uint8_t state;
 #endif
@@ -86,6 +117,22 @@ void ledsProcess()
 	}
 	state = (countErr & (LED_ON_OFF_RATIO-1)) ? LED_ON : LED_OFF;
 	hwDigitalWrite(MY_DEFAULT_ERR_LED_PIN, state);
+#endif
+	// idle once all LEDs are off
+#if defined(LEDS_TIMER)
+	const bool blinking = ledsBlinking();
+	if (blinking != ledsTimerRunning) {
+		ledsTimerRunning = blinking;
+		if (blinking) {
+			hwLedTimerStart(ledsUpdate, LED_PROCESS_INTERVAL_MS);
+		} else {
+			hwLedTimerStop();
+		}
+	}
+#else
+	if (ledsBlinking()) {
+		schedulerSet(&ledsTask, LED_PROCESS_INTERVAL_MS);
+	}
 #endif
 }
 
@@ -94,7 +141,9 @@ void ledsBlinkRx(uint8_t cnt)
 	if (!countRx) {
 		countRx = cnt*LED_ON_OFF_RATIO;
 	}
-	ledsProcess();
+	if (ledsIdle()) {
+		ledsUpdate();
+	}
 }
 
 void ledsBlinkTx(uint8_t cnt)
@@ -102,7 +151,9 @@ void ledsBlinkTx(uint8_t cnt)
 	if(!countTx) {
 		countTx = cnt*LED_ON_OFF_RATIO;
 	}
-	ledsProcess();
+	if (ledsIdle()) {
+		ledsUpdate();
+	}
 }
 
 void ledsBlinkErr(uint8_t cnt)
@@ -110,7 +161,9 @@ void ledsBlinkErr(uint8_t cnt)
 	if(!countErr) {
 		countErr = cnt*LED_ON_OFF_RATIO;
 	}
-	ledsProcess();
+	if (ledsIdle()) {
+		ledsUpdate();
+	}
 }
 
 bool ledsBlinking()
@@ -29,6 +29,10 @@
 #define LED_OFF 0x1
 #endif
 
+#if defined(MY_WITH_LEDS_BLINKING_TIMER) && defined(MY_HW_HAS_LED_TIMER)
+#define LEDS_TIMER	//!< the LEDs blink from a timer interrupt, not from doYield()
+#endif
+
 #if defined(MY_DEFAULT_TX_LED_PIN) || defined(MY_DEFAULT_RX_LED_PIN) || defined(MY_DEFAULT_ERR_LED_PIN)
 #define ledBlinkTx(x,...) ledsBlinkTx(x)
 #define ledBlinkRx(x,...) ledsBlinkRx(x)
@@ -42,7 +46,15 @@ void ledsInit();
 void ledsBlinkRx(uint8_t cnt);
 void ledsBlinkTx(uint8_t cnt);
 void ledsBlinkErr(uint8_t cnt);
+#if defined(LEDS_TIMER)
+#define ledsProcess()
+/**
+ * Switch the LEDs off before sleeping, the timer continues their patterns after wake-up.
+ */
+void ledsSleep();
+#else
 void ledsProcess(); // do the actual blinking
+#endif
 /**
  * Test if any LED is currently blinking.
  * @return true when one or more LEDs are blinking, false otherwise.
@@ -20,6 +20,7 @@
 
 #include "MyMessage.h"
 #include "MyHelperFunctions.h"
+#include "MyProfiling.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -85,11 +86,7 @@ const char* MyMessage::getString(void) const
 
 char* MyMessage::getCustomString(char *buffer) const
 {
-	for (uint8_t i = 0; i < miGetLength(); i++) {
-		buffer[i * 2] = convertI2H(data[i] >> 4);
-		buffer[(i * 2) + 1] = convertI2H(data[i]);
-	}
-	buffer[miGetLength() * 2] = '\0';
+	convertBuf2Hex(buffer, (const uint8_t *)data, miGetLength());
 	return buffer;
 }
 
@@ -105,23 +102,28 @@ char* MyMessage::getStream(char *buffer) const
 
 char* MyMessage::getString(char *buffer) const
 {
+	PROFILING_SCOPE(PROFILING_MESSAGE_GET_STRING);
 	uint8_t payloadType = miGetPayloadType();
 	if (buffer != NULL) {
 		if (payloadType == P_STRING) {
 			(void)strncpy(buffer, data, miGetLength());
 			buffer[miGetLength()] = 0;
 		} else if (payloadType == P_BYTE) {
-			(void)itoa(bValue, buffer, 10);
+			(void)convertU2D(buffer, bValue);
 		} else if (payloadType == P_INT16) {
-			(void)itoa(iValue, buffer, 10);
+			(void)convertI2D(buffer, iValue);
 		} else if (payloadType == P_UINT16) {
-			(void)utoa(uiValue, buffer, 10);
+			(void)convertU2D(buffer, uiValue);
 		} else if (payloadType == P_LONG32) {
-			(void)ltoa(lValue, buffer, 10);
+			(void)convertI2D(buffer, lValue);
 		} else if (payloadType == P_ULONG32) {
-			(void)ultoa(ulValue, buffer, 10);
+			(void)convertU2D(buffer, ulValue);
 		} else if (payloadType == P_FLOAT32) {
-			(void)dtostrf(fValue, 2, min(fPrecision, (uint8_t)8), buffer);
+			if (fPrecision & P_FLOAT32_FIXED_POINT) {
+				(void)convertX2D(buffer, lValue, fPrecision & ~P_FLOAT32_FIXED_POINT);
+			} else {
+				(void)convertF2D(buffer, fValue, min(fPrecision, (uint8_t)8));
+			}
 		} else if (payloadType == P_CUSTOM) {
 			return getCustomString(buffer);
 		}
@@ -151,6 +153,14 @@ uint8_t MyMessage::getByte(void) const
 float MyMessage::getFloat(void) const
 {
 	if (miGetPayloadType() == P_FLOAT32) {
+		if (fPrecision & P_FLOAT32_FIXED_POINT) {
+			uint32_t divisor = 1;
+			for (uint8_t i = min((uint8_t)(fPrecision & ~P_FLOAT32_FIXED_POINT), (uint8_t)8); i > 0;
+			        i--) {
+				divisor *= 10;
+			}
+			return (float)lValue / divisor;
+		}
 		return fValue;
 	} else if (miGetPayloadType() == P_STRING) {
 		return atof(data);
@@ -215,7 +225,7 @@ MyMessage& MyMessage::setSensor(const uint8_t _sensor)
 	return *this;
 }
 
-MyMessage& MyMessage::setDestination(const uint8_t _destination)
+MyMessage& MyMessage::setDestination(const nodeId_t _destination)
 {
 	destination = _destination;
 	return *this;
@@ -286,6 +296,15 @@ MyMessage& MyMessage::set(const float value, const uint8_t decimals)
 	return *this;
 }
 
+MyMessage& MyMessage::setFixed(const int32_t value, const uint8_t decimals)
+{
+	miSetLength(5); // 32 bit integer + precision
+	miSetPayloadType(P_FLOAT32);
+	lValue = value;
+	fPrecision = min(decimals, (uint8_t)8) | P_FLOAT32_FIXED_POINT;
+	return *this;
+}
+
 MyMessage& MyMessage::set(const uint32_t value)
 {
 	miSetPayloadType(P_ULONG32);
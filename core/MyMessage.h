@@ -36,10 +36,26 @@
 #include <stdint.h>
 #endif
 
+#if defined(MY_NODE_ID_16BIT)
+typedef uint16_t nodeId_t;	//!< Node id, 16 bit with #MY_NODE_ID_16BIT
+#define PRIuNodeId PRIu16	//!< printf format of a node id
+#define PROTOCOL_VERSION	(3u)	//!< The version of the protocol, 3 is the extended header with 16 bit node ids
+#define HEADER_SIZE			(10u)	//!< The size of the header
+#define AGGREGATE_RECORD_HEADER_SIZE	(6u)	//!< Sender, version/length, command/payload type, type and sensor of a frame in an I_AGGREGATE payload
+#else
+typedef uint8_t nodeId_t;	//!< Node id
+#define PRIuNodeId PRIu8	//!< printf format of a node id
 #define PROTOCOL_VERSION	(2u)	//!< The version of the protocol
-#define MAX_MESSAGE_LENGTH	(32u)	//!< The maximum size of a message (including header)
 #define HEADER_SIZE			(7u)	//!< The size of the header
+#define AGGREGATE_RECORD_HEADER_SIZE	(5u)	//!< Sender, version/length, command/payload type, type and sensor of a frame in an I_AGGREGATE payload
+#endif
+#define MAX_MESSAGE_LENGTH	(32u)	//!< The maximum size of a message (including header)
 #define MAX_PAYLOAD (MAX_MESSAGE_LENGTH - HEADER_SIZE) //!< The maximum size of a payload depends on #MAX_MESSAGE_LENGTH and #HEADER_SIZE
+#define BATCH_RECORD_HEADER_SIZE	(3u)	//!< Sensor, type and payload type/length of a reading in an I_BATCH payload
+#define FRAGMENT_HEADER_SIZE	(3u)	//!< Message id, index/last flag and type of the data in an I_FRAGMENT payload
+#define FRAGMENT_DATA_SIZE	(MAX_PAYLOAD - FRAGMENT_HEADER_SIZE)	//!< Data carried by each but the last I_FRAGMENT message
+#define FRAGMENT_LAST		(0x80u)	//!< Index flag of the last I_FRAGMENT message
+#define FRAGMENT_MAX_COUNT	(32u)	//!< Most I_FRAGMENT messages of one data block
 
 /// @brief The command field (message-type) defines the overall properties of a message
 typedef enum {
@@ -197,7 +213,18 @@ typedef enum {
 	I_SIGNAL_REPORT_REVERSE		= 30,	//!< Internal
 	I_SIGNAL_REPORT_RESPONSE	= 31,	//!< Device signal strength response (RSSI)
 	I_PRE_SLEEP_NOTIFICATION	= 32,	//!< Message sent before node is going to sleep
-	I_POST_SLEEP_NOTIFICATION	= 33	//!< Message sent after node woke up (if enabled)
+	I_POST_SLEEP_NOTIFICATION	= 33,	//!< Message sent after node woke up (if enabled)
+	I_BATCH						= 34,	//!< Several sensor readings in one message, unpacked by the GW, see sendBatch()
+	I_AGGREGATE					= 35,	//!< Frames of several nodes relayed in one message by a repeater, unpacked by the GW
+	I_FRAGMENT					= 36,	//!< Part of a data block larger than MAX_PAYLOAD, see sendFragmented()
+	I_WAKE_ON_RADIO				= 37,	//!< Listen period of a duty-cycled repeater, see MY_REPEATER_WAKE_ON_RADIO
+	I_GATEWAY_FILTER			= 38,	//!< Messages a controller client wants, consumed by the GW, see MY_GATEWAY_CLIENT_FILTER
+	I_PRESENTATION_DIGEST		= 39,	//!< Digest of a node's presentation at boot, the reply tells if it is known, see MY_PRESENTATION_DIGEST
+	I_STATS						= 40,	//!< Statistics request/response, see @ref MY_STATS_FEATURE
+	I_PROFILING					= 41,	//!< Profiling request/response, see @ref MY_PROFILING
+	I_RECEIPT					= 42,	//!< Short confirmation of a message sent with echo, see MY_TRANSPORT_RECEIPTS
+	I_FLOW_CONTROL				= 43,	//!< Fill level of the GW's TX queue and credit of the controller, see MY_GATEWAY_FLOW_CONTROL
+	I_ENERGY					= 44	//!< Awake time and charge of the last cycles, see MY_ENERGY_ACCOUNTING
 } mysensors_internal_t;
 
 
@@ -211,6 +238,8 @@ typedef enum {
 	ST_IMAGE					= 5,	//!< Image
 	ST_FIRMWARE_CONFIRM	= 6, //!< Mark running firmware as valid (MyOTAFirmwareUpdateNVM + mcuboot)
 	ST_FIRMWARE_RESPONSE_RLE = 7,	//!< Response FW block with run length encoded data
+	ST_FIRMWARE_REQUEST_WINDOW = 8,	//!< Request several FW blocks, answered with one ST_FIRMWARE_RESPONSE per block
+	ST_FIRMWARE_RESPONSE_LZ = 9,	//!< Response with consecutive FW blocks, LZ compressed
 } mysensors_stream_t;
 
 /// @brief Type of payload
@@ -225,6 +254,13 @@ typedef enum {
 	P_FLOAT32				= 7		//!< Payload type is float32
 } mysensors_payload_t;
 
+/**
+ * @brief Precision flag of a P_FLOAT32 payload, the value is an int32 scaled by 10^decimals
+ *
+ * Set by MyMessage::setFixed(), the payload is formatted without float code.
+ */
+#define P_FLOAT32_FIXED_POINT	(0x80u)
+
 
 
 #ifndef BIT
@@ -280,6 +316,47 @@ typedef enum {
 
 
 #if defined(__cplusplus) || defined(DOXYGEN)
+/**
+ * @brief C type and payload length of a binary payload type, see MyMessage::setTyped()
+ */
+template <uint8_t payloadType> struct MyMessagePayload;
+
+/** @brief Payload type P_BYTE */
+template <> struct MyMessagePayload<P_BYTE> {
+	typedef uint8_t type;					//!< C type of the payload
+	static const uint8_t length = 1u;	//!< Payload length
+};
+
+/** @brief Payload type P_INT16 */
+template <> struct MyMessagePayload<P_INT16> {
+	typedef int16_t type;					//!< C type of the payload
+	static const uint8_t length = 2u;	//!< Payload length
+};
+
+/** @brief Payload type P_UINT16 */
+template <> struct MyMessagePayload<P_UINT16> {
+	typedef uint16_t type;				//!< C type of the payload
+	static const uint8_t length = 2u;	//!< Payload length
+};
+
+/** @brief Payload type P_LONG32 */
+template <> struct MyMessagePayload<P_LONG32> {
+	typedef int32_t type;					//!< C type of the payload
+	static const uint8_t length = 4u;	//!< Payload length
+};
+
+/** @brief Payload type P_ULONG32 */
+template <> struct MyMessagePayload<P_ULONG32> {
+	typedef uint32_t type;				//!< C type of the payload
+	static const uint8_t length = 4u;	//!< Payload length
+};
+
+/** @brief Payload type P_FLOAT32 */
+template <> struct MyMessagePayload<P_FLOAT32> {
+	typedef float type;						//!< C type of the payload
+	static const uint8_t length = 5u;	//!< Payload length, 32 bit float + precision
+};
+
 /**
  * @brief MyMessage is used to create, manipulate, send and read MySensors messages
  */
@@ -408,7 +485,7 @@ public:
 	 * @brief Set final destination node id for this message
 	 * @param destination
 	 */
-	MyMessage& setDestination(const uint8_t destination);
+	MyMessage& setDestination(const nodeId_t destination);
 
 	/**
 	 * @brief Set entire payload
@@ -473,15 +550,69 @@ public:
 	 */
 	MyMessage& set(const int16_t value);
 
+	/**
+	 * @brief Set payload to decimal number given in fixed-point
+	 *
+	 * Sent as P_FLOAT32, e.g. setFixed(2150, 2) is shown as 21.50 by the controller. Neither
+	 * the node nor the GW need float code for such a payload, receivers have to be on a release
+	 * that knows @ref P_FLOAT32_FIXED_POINT.
+	 * @param value number multiplied by 10^decimals
+	 * @param decimals number of decimals, max 8
+	 */
+	MyMessage& setFixed(const int32_t value, const uint8_t decimals);
+
+	/**
+	 * @brief Set a binary payload, the payload type is fixed at compile time
+	 *
+	 * Compiles to a plain store of the value and the header fields, e.g.
+	 * msg.setTyped<P_UINT16>(value).
+	 * @tparam payloadType P_BYTE, P_INT16, P_UINT16, P_LONG32, P_ULONG32 or P_FLOAT32
+	 * @param value payload value
+	 * @param decimals number of decimals to include, P_FLOAT32 only
+	 */
+	template <uint8_t payloadType>
+	MyMessage& setTyped(const typename MyMessagePayload<payloadType>::type value,
+	                    const uint8_t decimals = 0)
+	{
+		miSetPayloadType(payloadType);
+		miSetLength(MyMessagePayload<payloadType>::length);
+		(void)memcpy(data, &value, sizeof(value));
+		if (payloadType == P_FLOAT32) {
+			fPrecision = decimals;
+		}
+		return *this;
+	}
+
+	/**
+	 * @brief Get a binary payload, the payload type is fixed at compile time
+	 *
+	 * Unlike getUInt() and friends, string payloads are not converted, the conversion
+	 * routines are only linked in if the sketch uses them elsewhere.
+	 * @tparam payloadType P_BYTE, P_INT16, P_UINT16, P_LONG32, P_ULONG32 or P_FLOAT32
+	 * @return the value of the payload, 0 if the message carries another payload type
+	 */
+	template <uint8_t payloadType>
+	typename MyMessagePayload<payloadType>::type getTyped(void) const
+	{
+		typename MyMessagePayload<payloadType>::type value = 0;
+		if (payloadType == P_FLOAT32 && miGetPayloadType() == P_FLOAT32 &&
+		        (fPrecision & P_FLOAT32_FIXED_POINT)) {
+			value = getFloat();
+		} else if (miGetPayloadType() == payloadType) {
+			(void)memcpy(&value, data, sizeof(value));
+		}
+		return value;
+	}
+
 #else
 
 typedef union {
 	struct {
 
 #endif
-	uint8_t last;							//!< 8 bit - Id of last node this message passed
-	uint8_t sender;						//!< 8 bit - Id of sender node (origin)
-	uint8_t destination;			//!< 8 bit - Id of destination node
+	nodeId_t last;						//!< 8 bit (16 bit with #MY_NODE_ID_16BIT) - Id of last node this message passed
+	nodeId_t sender;					//!< 8 bit (16 bit with #MY_NODE_ID_16BIT) - Id of sender node (origin)
+	nodeId_t destination;			//!< 8 bit (16 bit with #MY_NODE_ID_16BIT) - Id of destination node
 
 	/**
 	 * 2 bit - Protocol version<br>
@@ -18,6 +18,7 @@
  */
 
 #include "MyOTAFirmwareUpdate.h"
+#include "MyTransport.h"
 
 // global variables
 extern MyMessage _msg;
@@ -44,32 +45,343 @@ SPIFlash _flash(MY_OTA_FLASH_SS, MY_OTA_FLASH_JDECID);
 #define _flash_busy() false
 #endif
 
+// Map reading the current firmware, base of delta updates
+#if defined(MY_OTA_DELTA)
+#if defined(MCUBOOT_PRESENT)
+#define _firmware_readCurrentByte(addr)	(*((uint8_t *)(FLASH_AREA_IMAGE_0_OFFSET_0 + (addr))))
+#elif defined(ARDUINO_ARCH_AVR) && (FLASHEND > 0xFFFF)
+#define _firmware_readCurrentByte(addr)	pgm_read_byte_far(addr)
+#elif defined(ARDUINO_ARCH_AVR)
+#define _firmware_readCurrentByte(addr)	pgm_read_byte(addr)
+#else
+#error MY_OTA_DELTA is not supported on this architecture
+#endif
+#endif
+
 LOCAL nodeFirmwareConfig_t _nodeFirmwareConfig;
 LOCAL bool _firmwareUpdateOngoing = false;
-LOCAL uint32_t _firmwareLastRequest;
+LOCAL schedulerTask_t _firmwareRequestTask;	//!< next block request
 LOCAL uint16_t _firmwareBlock;
 LOCAL uint8_t _firmwareRetry;
+#if defined(MY_OTA_WINDOW_SIZE)
+LOCAL bool _firmwareWindowed;
+// bit n set: block (_firmwareBlock - 1 - n) is stored
+LOCAL uint32_t _firmwareWindowReceived;
+// _firmwareBlock when the update started or resumed
+LOCAL uint16_t _firmwareWindowStart;
+#endif
+#if defined(MY_OTA_MULTICAST)
+// bit set: block stored ahead of the window, from a broadcast
+LOCAL uint8_t _firmwareMulticastReceived[(MY_OTA_MULTICAST_BLOCKS + 7) / 8];
+#endif
+#if defined(MY_OTA_DELTA)
+// blocks of the current firmware available to copy from
+LOCAL uint16_t _firmwareDeltaBlocks;
+#endif
+// CRC of the image, assembled from the blocks as they are accepted
+LOCAL uint16_t _firmwareCRC;
+#if defined(MY_OTA_RESUME)
+// _firmwareBlock when the progress was saved last
+LOCAL uint16_t _firmwareResumeBlock;
+#endif
 LOCAL bool _firmwareResponse(uint16_t block, uint8_t *data);
 
+LOCAL uint16_t _firmwareCRCUpdate(uint16_t crc, const uint8_t data)
+{
+	return crc16Update(crc, data);
+}
+
+// The CRC is linear: passing zero bytes maps the CRC through a 16x16 bit matrix, column n is the image of bit n
+LOCAL uint16_t _firmwareCRCMatrixApply(const uint16_t *matrix, uint16_t crc)
+{
+	uint16_t result = 0;
+	for (uint8_t n = 0; crc; n++, crc >>= 1) {
+		if (crc & 1) {
+			result ^= matrix[n];
+		}
+	}
+	return result;
+}
+
+// CRC after passing (blocks * FIRMWARE_BLOCK_SIZE) zero bytes
+LOCAL uint16_t _firmwareCRCShift(uint16_t crc, uint16_t blocks)
+{
+	uint16_t power[16];
+	uint16_t square[16];
+	// one block of zero bytes
+	for (uint8_t n = 0; n < 16; n++) {
+		power[n] = (uint16_t)(1u << n);
+		for (uint8_t i = 0; i < FIRMWARE_BLOCK_SIZE; i++) {
+			power[n] = _firmwareCRCUpdate(power[n], 0);
+		}
+	}
+	while (blocks) {
+		if (blocks & 1) {
+			crc = _firmwareCRCMatrixApply(power, crc);
+		}
+		blocks >>= 1;
+		if (blocks) {
+			for (uint8_t n = 0; n < 16; n++) {
+				square[n] = _firmwareCRCMatrixApply(power, power[n]);
+			}
+			(void)memcpy(power, square, sizeof(power));
+		}
+	}
+	return crc;
+}
+
+#if defined(MY_OTA_WINDOW_SIZE)
+LOCAL uint8_t _firmwareWindowLength(void)
+{
+	return (_firmwareBlock < MY_OTA_WINDOW_SIZE) ? (uint8_t)_firmwareBlock : (uint8_t)MY_OTA_WINDOW_SIZE;
+}
+
+LOCAL uint32_t _firmwareWindowMask(void)
+{
+	const uint8_t length = _firmwareWindowLength();
+	return (length >= 32) ? 0xFFFFFFFFul : (((uint32_t)1 << length) - 1);
+}
+#endif
+
+#if defined(MY_OTA_MULTICAST)
+LOCAL bool _firmwareMulticastStored(const uint16_t block)
+{
+	return (block < MY_OTA_MULTICAST_BLOCKS) &&
+	       (_firmwareMulticastReceived[block >> 3] & (1u << (block & 7)));
+}
+
+// blocks of the window already stored from broadcasts
+LOCAL uint32_t _firmwareMulticastWindow(void)
+{
+	uint32_t stored = 0;
+	for (uint8_t n = 0; n < _firmwareWindowLength(); n++) {
+		if (_firmwareMulticastStored(_firmwareBlock - 1 - n)) {
+			stored |= ((uint32_t)1 << n);
+		}
+	}
+	return stored;
+}
+#endif
+
+#if defined(MY_OTA_LZ_BLOCKS)
+LOCAL bool _firmwareBlockStored(const uint16_t block)
+{
+	if (block >= _nodeFirmwareConfig.blocks) {
+		return false;
+	}
+	if (block >= _firmwareBlock) {
+		return true;
+	}
+	const uint16_t offset = (uint16_t)(_firmwareBlock - 1 - block);
+#if defined(MY_OTA_MULTICAST)
+	if (_firmwareMulticastStored(block)) {
+		return true;
+	}
+#endif
+	return _firmwareWindowed && (offset < _firmwareWindowLength()) &&
+	       (_firmwareWindowReceived & ((uint32_t)1 << offset));
+}
+
+#if defined(MY_OTA_DELTA)
+// blocks of the current firmware if it matches the CRC in _nodeFirmwareConfig, 0 otherwise
+LOCAL uint16_t _firmwareCurrentBlocks(void)
+{
+	uint16_t crc = ~0;
+	for (uint32_t i = 0; i < (uint32_t)_nodeFirmwareConfig.blocks * FIRMWARE_BLOCK_SIZE; ++i) {
+		crc = _firmwareCRCUpdate(crc, _firmware_readCurrentByte(i));
+	}
+	return (_nodeFirmwareConfig.blocks && crc == _nodeFirmwareConfig.crc) ? _nodeFirmwareConfig.blocks :
+	       0;
+}
+#endif
+
+// decode a ST_FIRMWARE_RESPONSE_LZ, see replyFirmwareBlockLZ_t for the format
+LOCAL bool _firmwareResponseLZ(void)
+{
+	replyFirmwareBlockLZ_t *firmwareResponse = (replyFirmwareBlockLZ_t *)_msg.data;
+	const uint8_t *in = firmwareResponse->data;
+	const uint8_t *inEnd = (const uint8_t *)_msg.data + mGetLength(_msg);
+	const uint8_t blocks = firmwareResponse->number_of_blocks;
+	const uint16_t outSize = blocks * FIRMWARE_BLOCK_SIZE;
+	// image bytes from the end of block downwards
+	uint8_t out[MY_OTA_LZ_BLOCKS * FIRMWARE_BLOCK_SIZE];
+	const uint32_t end = (uint32_t)(firmwareResponse->block + 1) * FIRMWARE_BLOCK_SIZE;
+	uint16_t pos = 0;
+	bool valid = (blocks > 0) && (blocks <= MY_OTA_LZ_BLOCKS) &&
+	             (blocks <= firmwareResponse->block + 1) && (in <= inEnd);
+	while (valid && pos < outSize && in < inEnd) {
+		const uint8_t token = *in++;
+		if (token < 0x40) {
+			uint8_t count = token + 1;
+			valid = (count <= inEnd - in) && (count <= outSize - pos);
+			while (valid && count--) {
+				out[pos++] = *in++;
+			}
+		} else if (token < 0x80) {
+			uint8_t count = (token & 0x3F) + 3;
+			valid = (inEnd - in >= 2) && (count <= outSize - pos);
+#if defined(MY_OTA_DELTA)
+			if (valid) {
+				const int16_t offset = (int16_t)(in[0] | ((uint16_t)in[1] << 8));
+				in += 2;
+				while (valid && count--) {
+					// from the current firmware, at the same address plus offset
+					const int32_t addr = (int32_t)(end - 1 - pos) + offset;
+					valid = (addr >= 0) && (addr < (int32_t)_firmwareDeltaBlocks * FIRMWARE_BLOCK_SIZE);
+					if (valid) {
+						out[pos++] = _firmware_readCurrentByte(addr);
+					}
+				}
+			}
+#else
+			valid = false;
+#endif
+		} else {
+			uint8_t count = (token & 0x3F) + 3;
+			uint16_t distance = 1;
+			if (token & 0x40) {
+				valid = (inEnd - in >= 2);
+				if (valid) {
+					distance += in[0] | ((uint16_t)in[1] << 8);
+					in += 2;
+				}
+			} else {
+				valid = (inEnd - in >= 1);
+				if (valid) {
+					distance += *in++;
+				}
+			}
+			valid = valid && (count <= outSize - pos);
+			while (valid && count--) {
+				if (distance <= pos) {
+					out[pos] = out[pos - distance];
+				} else {
+					// from a stored block above this response
+					const uint32_t addr = end - 1 - pos + distance;
+					valid = _firmwareBlockStored((uint16_t)(addr / FIRMWARE_BLOCK_SIZE));
+					if (valid) {
+						out[pos] = _flash_readByte(addr + FIRMWARE_START_OFFSET);
+					}
+				}
+				pos++;
+			}
+		}
+	}
+	if (!valid || pos != outSize || in != inEnd) {
+		OTA_DEBUG(PSTR("!OTA:FWP:LZ ERR\n"));
+		setIndication(INDICATION_FW_UPDATE_RX_ERR);
+		return true;
+	}
+	for (uint8_t n = 0; n < blocks; n++) {
+		uint8_t data[FIRMWARE_BLOCK_SIZE];
+		for (uint8_t i = 0; i < FIRMWARE_BLOCK_SIZE; i++) {
+			data[i] = out[(n + 1) * FIRMWARE_BLOCK_SIZE - 1 - i];
+		}
+		(void)_firmwareResponse(firmwareResponse->block - n, data);
+	}
+	return true;
+}
+#endif
+
 LOCAL void readFirmwareSettings(void)
 {
 	hwReadConfigBlock((void*)&_nodeFirmwareConfig, (void*)EEPROM_FIRMWARE_TYPE_ADDRESS,
 	                  sizeof(nodeFirmwareConfig_t));
 }
 
+#if defined(MY_OTA_RESUME)
+LOCAL uint16_t _firmwareResumeConfig(void)
+{
+	return crc16Buffer(~0, (const uint8_t *)&_nodeFirmwareConfig, sizeof(nodeFirmwareConfig_t));
+}
+
+LOCAL void _firmwareResumeSave(const uint16_t block)
+{
+	nodeFirmwareResume_t resume;
+	resume.config = _firmwareResumeConfig();
+	resume.block = block;
+	resume.crc = _firmwareCRC;
+	resume.check = crc16Buffer(~0, (const uint8_t *)&resume, offsetof(nodeFirmwareResume_t, check));
+	// the saved blocks must be in flash before the record claims them, block 0 is never resumed
+	while (_flash_busy()) {}
+	hwWriteConfigBlock((void *)&resume, (void *)EEPROM_FIRMWARE_RESUME_ADDRESS,
+	                   sizeof(nodeFirmwareResume_t));
+	_firmwareResumeBlock = block;
+}
+
+// restores _firmwareBlock and _firmwareCRC of an interrupted update of _nodeFirmwareConfig
+LOCAL bool _firmwareResumeLoad(void)
+{
+	nodeFirmwareResume_t resume;
+	hwReadConfigBlock((void *)&resume, (void *)EEPROM_FIRMWARE_RESUME_ADDRESS,
+	                  sizeof(nodeFirmwareResume_t));
+	if (resume.check != crc16Buffer(~0, (const uint8_t *)&resume, offsetof(nodeFirmwareResume_t,
+	                                check)) ||
+	        resume.config != _firmwareResumeConfig() || !resume.block ||
+	        resume.block >= _nodeFirmwareConfig.blocks) {
+		return false;
+	}
+	_firmwareBlock = resume.block;
+	_firmwareCRC = resume.crc;
+	_firmwareResumeBlock = resume.block;
+	return true;
+}
+#endif
+
+LOCAL void _firmwareScheduleRequest(const uint32_t delayMS)
+{
+	schedulerAdd(&_firmwareRequestTask, firmwareOTAUpdateRequest);
+	schedulerSet(&_firmwareRequestTask, delayMS);
+}
+
 LOCAL void firmwareOTAUpdateRequest(void)
 {
-	const uint32_t enterMS = hwMillis();
-	if (_firmwareUpdateOngoing && (enterMS - _firmwareLastRequest > MY_OTA_RETRY_DELAY)) {
+	if (_firmwareUpdateOngoing) {
+		// the next request, unless a response arrives before
+		schedulerSet(&_firmwareRequestTask, MY_OTA_RETRY_DELAY);
+	}
+	if (_firmwareUpdateOngoing && isTransportReady()) {
 		if (!_firmwareRetry) {
 			setIndication(INDICATION_ERR_FW_TIMEOUT);
 			OTA_DEBUG(PSTR("!OTA:FRQ:FW UPD FAIL\n"));	// fw update failed
 			// Give up. We have requested MY_OTA_RETRY times without any packet in return.
 			_firmwareUpdateOngoing = false;
+			schedulerCancel(&_firmwareRequestTask);
 			return;
 		}
 		_firmwareRetry--;
-		_firmwareLastRequest = enterMS;
+#if defined(MY_OTA_WINDOW_SIZE)
+		if (_firmwareWindowed && _firmwareRetry < MY_OTA_RETRY &&
+		        _firmwareBlock == _firmwareWindowStart && !_firmwareWindowReceived) {
+			// first window request not answered, controller does not support windows
+			OTA_DEBUG(PSTR("!OTA:FRQ:NO WINDOW\n"));
+			_firmwareWindowed = false;
+		}
+		if (_firmwareWindowed) {
+			// Time to (re-)request the missing blocks of the window from controller
+			requestFirmwareWindow_t firmwareRequest;
+			firmwareRequest.type = _nodeFirmwareConfig.type;
+			firmwareRequest.version = _nodeFirmwareConfig.version;
+			firmwareRequest.block = (_firmwareBlock - 1);
+			firmwareRequest.missing = _firmwareWindowMask() & ~_firmwareWindowReceived;
+#if defined(MY_OTA_LZ_BLOCKS)
+			firmwareRequest.lzBlocks = MY_OTA_LZ_BLOCKS;
+#else
+			firmwareRequest.lzBlocks = 0;
+#endif
+#if defined(MY_OTA_DELTA)
+			firmwareRequest.deltaBlocks = _firmwareDeltaBlocks;
+#else
+			firmwareRequest.deltaBlocks = 0;
+#endif
+			OTA_DEBUG(PSTR("OTA:FRQ:FW REQ,T=%04" PRIX16 ",V=%04" PRIX16 ",B=%04" PRIX16 ",M=%08" PRIX32 "\n"),
+			          _nodeFirmwareConfig.type, _nodeFirmwareConfig.version, _firmwareBlock - 1,
+			          firmwareRequest.missing); // request FW update window
+			(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_STREAM,
+			                       ST_FIRMWARE_REQUEST_WINDOW, false).set(&firmwareRequest, sizeof(requestFirmwareWindow_t)));
+			return;
+		}
+#endif
 		// Time to (re-)request firmware block from controller
 		requestFirmwareBlock_t firmwareRequest;
 		firmwareRequest.type = _nodeFirmwareConfig.type;
@@ -85,6 +397,18 @@ LOCAL void firmwareOTAUpdateRequest(void)
 
 LOCAL bool firmwareOTAUpdateProcess(void)
 {
+#if defined(MY_OTA_MULTICAST)
+	if (_msg.destination == BROADCAST_ADDRESS) {
+		if (_msg.type == ST_FIRMWARE_CONFIG_RESPONSE) {
+			if (((nodeFirmwareConfig_t *)_msg.data)->type != _nodeFirmwareConfig.type) {
+				return true;	// broadcast FW for other nodes
+			}
+		} else if (_msg.type != ST_FIRMWARE_RESPONSE && _msg.type != ST_FIRMWARE_RESPONSE_RLE &&
+		           _msg.type != ST_FIRMWARE_RESPONSE_LZ) {
+			return false;
+		}
+	}
+#endif
 	if (_msg.type == ST_FIRMWARE_CONFIG_RESPONSE) {
 		if(_firmwareUpdateOngoing) {
 			OTA_DEBUG(PSTR("!OTA:FWP:UPDO\n"));	// FW config response received, FW update already ongoing
@@ -95,6 +419,11 @@ LOCAL bool firmwareOTAUpdateProcess(void)
 		if (memcmp(&_nodeFirmwareConfig, firmwareConfigResponse, sizeof(nodeFirmwareConfig_t))) {
 			setIndication(INDICATION_FW_UPDATE_START);
 			OTA_DEBUG(PSTR("OTA:FWP:UPDATE\n"));	// FW update initiated
+#if defined(MY_OTA_DELTA)
+			// the current FW is described by the config read from EEPROM until it is replaced
+			_firmwareDeltaBlocks = _firmwareCurrentBlocks();
+			OTA_DEBUG(PSTR("OTA:FWP:DELTA B=%04" PRIX16 "\n"), _firmwareDeltaBlocks);
+#endif
 			// copy new FW config
 			(void)memcpy(&_nodeFirmwareConfig, firmwareConfigResponse, sizeof(nodeFirmwareConfig_t));
 			// Init flash
@@ -103,15 +432,40 @@ LOCAL bool firmwareOTAUpdateProcess(void)
 				OTA_DEBUG(PSTR("!OTA:FWP:FLASH INIT FAIL\n"));	// failed to initialise flash
 				_firmwareUpdateOngoing = false;
 			} else {
-				// erase lower 32K -> max flash size for ATMEGA328
-				_flash_blockErase32K(0);
-				// wait until flash erased
-				while ( _flash_busy() ) {}
-				_firmwareBlock = _nodeFirmwareConfig.blocks;
+#if defined(MY_OTA_RESUME)
+				if (_firmwareResumeLoad()) {
+					// the blocks above are still in flash
+					OTA_DEBUG(PSTR("OTA:FWP:RESUME B=%04" PRIX16 "\n"), _firmwareBlock);
+				} else
+#endif
+				{
+					// erase lower 32K -> max flash size for ATMEGA328
+					_flash_blockErase32K(0);
+					// wait until flash erased
+					while ( _flash_busy() ) {}
+					_firmwareBlock = _nodeFirmwareConfig.blocks;
+					// contribution of the CRC init value, the blocks are added as they arrive
+					_firmwareCRC = _firmwareCRCShift(~0, _nodeFirmwareConfig.blocks);
+#if defined(MY_OTA_RESUME)
+					_firmwareResumeBlock = _firmwareBlock;
+#endif
+				}
 				_firmwareUpdateOngoing = true;
+#if defined(MY_OTA_WINDOW_SIZE)
+				_firmwareWindowed = true;
+				_firmwareWindowReceived = 0;
+				_firmwareWindowStart = _firmwareBlock;
+#endif
 				// reset flags
 				_firmwareRetry = MY_OTA_RETRY + 1;
-				_firmwareLastRequest = 0;
+				_firmwareScheduleRequest(0);
+#if defined(MY_OTA_MULTICAST)
+				(void)memset(_firmwareMulticastReceived, 0, sizeof(_firmwareMulticastReceived));
+				if (_msg.destination == BROADCAST_ADDRESS) {
+					// listen to the broadcast blocks before requesting any
+					_firmwareScheduleRequest(MY_OTA_RETRY_DELAY);
+				}
+#endif
 			}
 			return true;
 		}
@@ -121,6 +475,10 @@ LOCAL bool firmwareOTAUpdateProcess(void)
 		replyFirmwareBlock_t *firmwareResponse = (replyFirmwareBlock_t *)_msg.data;
 		// Proceed firmware data
 		return _firmwareResponse(firmwareResponse->block, firmwareResponse->data);
+#if defined(MY_OTA_LZ_BLOCKS)
+	} else if (_msg.type == ST_FIRMWARE_RESPONSE_LZ) {
+		return _firmwareResponseLZ();
+#endif
 #ifdef FIRMWARE_PROTOCOL_31
 	} else if (_msg.type == ST_FIRMWARE_RESPONSE_RLE) {
 		// RLE encoded block
@@ -192,21 +550,21 @@ LOCAL bool isFirmwareUpdateOngoing(void)
 {
 	return _firmwareUpdateOngoing;
 }
-// do a crc16 on the whole received firmware
+// check the crc16 of the whole received firmware
 LOCAL bool transportIsValidFirmware(void)
 {
-	// init crc
+#if defined(MY_OTA_VERIFY_FLASH)
+	// read back the image from flash
 	uint16_t crc = ~0;
 	for (uint32_t i = 0; i < _nodeFirmwareConfig.blocks * FIRMWARE_BLOCK_SIZE; ++i) {
-		crc ^= _flash_readByte(i + FIRMWARE_START_OFFSET);
-		for (int8_t j = 0; j < 8; ++j) {
-			if (crc & 1) {
-				crc = (crc >> 1) ^ 0xA001;
-			} else {
-				crc = (crc >> 1);
-			}
-		}
+		crc = _firmwareCRCUpdate(crc, _flash_readByte(i + FIRMWARE_START_OFFSET));
+	}
+	if (crc != _firmwareCRC) {
+		OTA_DEBUG(PSTR("!OTA:CRC:FLASH=%04" PRIX16 ",RECV=%04" PRIX16 "\n"), crc, _firmwareCRC);
 	}
+#else
+	const uint16_t crc = _firmwareCRC;
+#endif
 	OTA_DEBUG(PSTR("OTA:CRC:B=%04" PRIX16 ",C=%04" PRIX16 ",F=%04" PRIX16 "\n"),
 	          _nodeFirmwareConfig.blocks,crc,
 	          _nodeFirmwareConfig.crc);
@@ -217,7 +575,28 @@ LOCAL bool _firmwareResponse(uint16_t block, uint8_t *data)
 {
 	if (_firmwareUpdateOngoing) {
 		OTA_DEBUG(PSTR("OTA:FWP:RECV B=%04" PRIX16 "\n"), block);	// received FW block
-		if (block != _firmwareBlock - 1) {
+		bool expected = (block == _firmwareBlock - 1);
+#if defined(MY_OTA_WINDOW_SIZE)
+		const uint16_t offset = (uint16_t)(_firmwareBlock - 1 - block);
+		if (_firmwareWindowed) {
+			// any block of the window not stored yet, in any order
+			expected = (block < _firmwareBlock) && (offset < _firmwareWindowLength()) &&
+			           !(_firmwareWindowReceived & ((uint32_t)1 << offset));
+#if defined(MY_OTA_MULTICAST)
+			// or a broadcast block ahead of the window
+			expected = expected || ((block < _firmwareBlock) && (offset >= _firmwareWindowLength()) &&
+			                        (block < MY_OTA_MULTICAST_BLOCKS) && !_firmwareMulticastStored(block));
+#endif
+		}
+#endif
+#if defined(MY_OTA_MULTICAST)
+		if (_msg.destination == BROADCAST_ADDRESS) {
+			// more broadcast blocks are on the way, do not request any meanwhile
+			_firmwareRetry = MY_OTA_RETRY + 1;
+			_firmwareScheduleRequest(MY_OTA_RETRY_DELAY);
+		}
+#endif
+		if (!expected) {
 			OTA_DEBUG(PSTR("!OTA:FWP:WRONG FWB\n"));	// received FW block
 			// wrong firmware block received
 			setIndication(INDICATION_FW_UPDATE_RX_ERR);
@@ -225,23 +604,26 @@ LOCAL bool _firmwareResponse(uint16_t block, uint8_t *data)
 			return true;
 		}
 		setIndication(INDICATION_FW_UPDATE_RX);
+		// add block to the image CRC, at its position from the end of the image
+		const uint16_t blockCRC = crc16Buffer(0, data, FIRMWARE_BLOCK_SIZE);
+		_firmwareCRC ^= _firmwareCRCShift(blockCRC, _nodeFirmwareConfig.blocks - 1 - block);
 		// Save block to flash
 #ifdef MCUBOOT_PRESENT
-		uint32_t addr = ((size_t)(((_firmwareBlock - 1) * FIRMWARE_BLOCK_SIZE)) + (size_t)(
+		uint32_t addr = ((size_t)((block * FIRMWARE_BLOCK_SIZE)) + (size_t)(
 		                     FIRMWARE_START_OFFSET));
 		if (addr<FLASH_AREA_IMAGE_SCRATCH_OFFSET_0) {
 			Flash.write_block( (uint32_t *)addr, (uint32_t *)data, FIRMWARE_BLOCK_SIZE>>2);
 		}
 #else
-		_flash_writeBytes( ((_firmwareBlock - 1) * FIRMWARE_BLOCK_SIZE) + FIRMWARE_START_OFFSET,
+		_flash_writeBytes( (block * FIRMWARE_BLOCK_SIZE) + FIRMWARE_START_OFFSET,
 		                   data, FIRMWARE_BLOCK_SIZE);
 #endif
-		// wait until flash written
-		while (_flash_busy()) {}
+		// no busy wait: the flash drivers wait for a pending program cycle before their next
+		// command, meanwhile the next block is received
 #ifdef OTA_EXTRA_FLASH_DEBUG
 		{
 			char prbuf[8];
-			uint32_t addr = ((_firmwareBlock - 1) * FIRMWARE_BLOCK_SIZE) + FIRMWARE_START_OFFSET;
+			uint32_t addr = (block * FIRMWARE_BLOCK_SIZE) + FIRMWARE_START_OFFSET;
 			OTA_DEBUG(PSTR("OTA:FWP:FL DUMP "));
 			sprintf_P(prbuf,PSTR("%04" PRIX16 ":"), (uint16_t)addr);
 			MY_SERIALDEVICE.print(prbuf);
@@ -252,12 +634,52 @@ LOCAL bool _firmwareResponse(uint16_t block, uint8_t *data)
 			}
 			OTA_DEBUG(PSTR("\n"));
 		}
+#endif
+#if defined(MY_OTA_WINDOW_SIZE)
+		if (_firmwareWindowed) {
+#if defined(MY_OTA_MULTICAST)
+			if (offset >= _firmwareWindowLength()) {
+				_firmwareMulticastReceived[block >> 3] |= (1u << (block & 7));
+				return true;
+			}
+#endif
+			_firmwareWindowReceived |= ((uint32_t)1 << offset);
+			if (_firmwareWindowReceived != _firmwareWindowMask()) {
+				// wait for the rest of the window
+				_firmwareRetry = MY_OTA_RETRY + 1;
+				_firmwareScheduleRequest(MY_OTA_RETRY_DELAY);
+				return true;
+			}
+			// window complete, the last block is counted below
+			_firmwareBlock -= (_firmwareWindowLength() - 1);
+			_firmwareWindowReceived = 0;
+		}
 #endif
 		_firmwareBlock--;
+#if defined(MY_OTA_MULTICAST)
+		// skip windows completed by broadcasts
+		while (_firmwareWindowed && _firmwareBlock) {
+			_firmwareWindowReceived = _firmwareMulticastWindow();
+			if (_firmwareWindowReceived != _firmwareWindowMask()) {
+				break;
+			}
+			_firmwareBlock -= _firmwareWindowLength();
+			_firmwareWindowReceived = 0;
+		}
+#endif
+#if defined(MY_OTA_RESUME)
+		if (_firmwareBlock && _firmwareResumeBlock - _firmwareBlock >= MY_OTA_RESUME_INTERVAL) {
+			_firmwareResumeSave(_firmwareBlock);
+		}
+#endif
 		if (!_firmwareBlock) {
 			// We're done! Do a checksum and reboot.
 			OTA_DEBUG(PSTR("OTA:FWP:FW END\n"));	// received FW block
 			_firmwareUpdateOngoing = false;
+#if defined(MY_OTA_RESUME)
+			// complete or corrupt, nothing to resume either way
+			_firmwareResumeSave(0);
+#endif
 			if (transportIsValidFirmware()) {
 				OTA_DEBUG(PSTR("OTA:FWP:CRC OK\n"));	// FW checksum ok
 				// Write the new firmware config to eeprom
@@ -279,7 +701,11 @@ LOCAL bool _firmwareResponse(uint16_t block, uint8_t *data)
 		}
 		// reset flags
 		_firmwareRetry = MY_OTA_RETRY + 1;
-		_firmwareLastRequest = 0;
+#if defined(MY_OTA_MULTICAST)
+		_firmwareScheduleRequest((_msg.destination == BROADCAST_ADDRESS) ? MY_OTA_RETRY_DELAY : 0);
+#else
+		_firmwareScheduleRequest(0);
+#endif
 	} else {
 		OTA_DEBUG(PSTR("!OTA:FWP:NO UPDATE\n"));
 	}
@@ -39,15 +39,21 @@
 * | | OTA | FWP | UPDATE                      | FW update initiated
 * |!| OTA | FWP | UPDO                        | FW config response received, FW update already ongoing
 * |!| OTA | FWP | FLASH INIT FAIL             | Failed to initialise flash
+* | | OTA | FWP | DELTA B=%04X                | Current FW usable as delta base, blocks (B), 0 if its CRC does not match
+* | | OTA | FWP | RESUME B=%04X               | Interrupted update of the same FW resumed, next block (B)
 * | | OTA | FWP | UPDATE SKIPPED              | FW update skipped, no newer version available
 * | | OTA | FWP | RECV B=%04X                 | Received FW block (B)
+* |!| OTA | FWP | LZ ERR                      | Compressed FW blocks could not be decoded
 * |!| OTA | FWP | WRONG FWB                   | Wrong FW block received
 * | | OTA | FWP | FW END                      | FW received, proceed to CRC verification
 * | | OTA | FWP | CRC OK                      | FW CRC verification OK
 * |!| OTA | FWP | CRC FAIL                    | FW CRC verification failed
 * | | OTA | FRQ | FW REQ,T=%04X,V=%04X,B=%04X | Request FW update, FW type (T), version (V), block (B)
+* | | OTA | FRQ | FW REQ,T=%04X,V=%04X,B=%04X,M=%08X | Request FW window, FW type (T), version (V), highest block (B), missing blocks (M)
+* |!| OTA | FRQ | NO WINDOW                   | No response to window request, fall back to single block requests
 * |!| OTA | FRQ | FW UPD FAIL                 | FW update failed
 * | | OTA | CRC | B=%04X,C=%04X,F=%04X        | FW CRC verification. FW blocks (B), calculated CRC (C), FW CRC (F)
+* |!| OTA | CRC | FLASH=%04X,RECV=%04X        | Flash read-back CRC (FLASH) differs from CRC of received blocks (RECV)
 *
 *
 * @brief API declaration for MyOTAFirmwareUpdate
@@ -79,6 +85,24 @@
 #ifndef MY_OTA_RETRY_DELAY
 #define MY_OTA_RETRY_DELAY		(500u)				//!< Number of milliseconds before re-requesting a FW block
 #endif
+#if defined(MY_OTA_WINDOW_SIZE) && (MY_OTA_WINDOW_SIZE < 2 || MY_OTA_WINDOW_SIZE > 32)
+#error MY_OTA_WINDOW_SIZE must be between 2 and 32
+#endif
+#if defined(MY_OTA_LZ_BLOCKS) && (!defined(MY_OTA_WINDOW_SIZE) || MY_OTA_LZ_BLOCKS < 1 || MY_OTA_LZ_BLOCKS > 8)
+#error MY_OTA_LZ_BLOCKS must be between 1 and 8 and requires MY_OTA_WINDOW_SIZE
+#endif
+#if defined(MY_OTA_DELTA) && !defined(MY_OTA_LZ_BLOCKS)
+#error MY_OTA_DELTA requires MY_OTA_LZ_BLOCKS
+#endif
+#if defined(MY_OTA_MULTICAST) && !defined(MY_OTA_WINDOW_SIZE)
+#error MY_OTA_MULTICAST requires MY_OTA_WINDOW_SIZE
+#endif
+#if defined(MY_OTA_RESUME) && (MY_OTA_RESUME_INTERVAL < 1 || MY_OTA_RESUME_INTERVAL > 0xFFFF)
+#error MY_OTA_RESUME_INTERVAL must be between 1 and 65535
+#endif
+#if defined(MY_OTA_MULTICAST) && !defined(MY_OTA_MULTICAST_BLOCKS)
+#define MY_OTA_MULTICAST_BLOCKS	(2048u)				//!< Max number of blocks stored ahead of the window, 1 bit of RAM each
+#endif
 #ifndef MCUBOOT_PRESENT
 #define FIRMWARE_START_OFFSET	(10u)				//!< Start offset for firmware in flash (DualOptiboot wants to keeps a signature first)
 #else
@@ -121,6 +145,16 @@ typedef struct {
 	uint16_t crc;								//!< CRC of block data
 } __attribute__((packed)) nodeFirmwareConfig_t;
 
+/**
+* @brief Progress of an interrupted FW update, stored in eeprom, see @ref MY_OTA_RESUME
+*/
+typedef struct {
+	uint16_t config;							//!< CRC of the nodeFirmwareConfig_t being received
+	uint16_t block;								//!< Blocks from this one upwards are stored in flash
+	uint16_t crc;								//!< Image CRC assembled so far
+	uint16_t check;								//!< CRC of the fields above, guards against torn writes
+} __attribute__((packed)) nodeFirmwareResume_t;
+
 /**
 * @brief FW config request structure
 */
@@ -147,6 +181,18 @@ typedef struct {
 	uint16_t block;								//!< Block index
 } __attribute__((packed)) requestFirmwareBlock_t;
 
+/**
+* @brief FW block window request structure
+*/
+typedef struct {
+	uint16_t type;								//!< Type of config
+	uint16_t version;							//!< Version of config
+	uint16_t block;								//!< Highest block index of the window
+	uint32_t missing;							//!< Blocks to send, bit n requests block (block - n)
+	uint8_t lzBlocks;							//!< Max blocks per ST_FIRMWARE_RESPONSE_LZ, 0: not supported
+	uint16_t deltaBlocks;						//!< Blocks of the current FW to copy from, 0: none
+} __attribute__((packed)) requestFirmwareWindow_t;
+
 /**
 * @brief  FW block reply structure
 */
@@ -168,6 +214,32 @@ typedef struct {
 	uint8_t data;								//!< Block data
 } __attribute__((packed)) replyFirmwareBlockRLE_t;
 
+/**
+* @brief  FW block reply structure (LZ)
+*
+* The image is compressed back to front, i.e. as the byte stream from its last byte down to the
+* first, which is the order the blocks are requested in. The data decodes to number_of_blocks
+* blocks, from block downwards. Each token is a control byte c:
+* - 0x00-0x3F: c+1 literal bytes follow
+* - 0x40-0x7F: copy (c & 0x3F) + 3 bytes from the current FW (@ref MY_OTA_DELTA), at the same
+*   address plus the signed offset in the next two bytes (LSB first)
+* - 0x80-0xBF: copy (c & 0x3F) + 3 bytes, from a distance of 1 + the next byte
+* - 0xC0-0xFF: copy (c & 0x3F) + 3 bytes, from a distance of 1 + the next two bytes (LSB first)
+*
+* The distance counts back in the stream: copies come from this response or from blocks above
+* it that are already stored, no dictionary is kept in RAM. Copies from the current FW are only
+* valid within the deltaBlocks announced in the window request.
+*/
+typedef struct {
+	uint16_t type;								//!< Type of config
+	uint16_t version;							//!< Version of config
+	uint16_t block;								//!< Highest block index
+	uint8_t number_of_blocks;					//!< Number of blocks encoded
+	uint8_t data[MAX_PAYLOAD - 7];				//!< Compressed data
+} __attribute__((packed)) replyFirmwareBlockLZ_t;
+
+// the structures above are shared with the firmware server of the GW
+#if defined(MY_OTA_FIRMWARE_FEATURE) || defined(DOXYGEN)
 /**
  * @brief Read firmware settings from EEPROM
  *
@@ -187,13 +259,15 @@ LOCAL bool firmwareOTAUpdateProcess(void);
 /**
  * @brief Validate uploaded FW CRC
  *
- * This function verifies if uploaded FW CRC is valid
+ * This function verifies if uploaded FW CRC is valid. The CRC is calculated while the blocks are
+ * received, with @ref MY_OTA_VERIFY_FLASH the image is also read back from flash.
  */
 LOCAL bool transportIsValidFirmware(void);
 /**
  * @brief Present bootloader/FW information upon startup
  */
 LOCAL void presentBootloaderInformation(void);
+#endif
 
 #endif
 
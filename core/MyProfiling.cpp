@@ -0,0 +1,83 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyProfiling.h"
+
+static profilingProbe_t _profilingProbes[PROFILING_PROBES];
+
+void profilingInit(void)
+{
+#if defined(MY_HW_HAS_CYCLE_COUNTER)
+	hwCycleCounterInit();
+#endif
+}
+
+uint32_t profilingStamp(void)
+{
+#if defined(MY_HW_HAS_CYCLE_COUNTER)
+	return hwCycles();
+#else
+	return hwMicros();
+#endif
+}
+
+void profilingRecord(const uint8_t probe, const uint32_t start)
+{
+	const uint32_t elapsed = profilingStamp() - start;
+	if (probe >= PROFILING_PROBES) {
+		return;
+	}
+	profilingProbe_t *entry = &_profilingProbes[probe];
+	entry->count++;
+	entry->total += elapsed;
+	if (elapsed > entry->max) {
+		entry->max = elapsed;
+	}
+}
+
+profilingProbe_t profilingGet(const uint8_t probe)
+{
+	profilingProbe_t entry;
+	if (probe < PROFILING_PROBES) {
+		entry = _profilingProbes[probe];
+	} else {
+		(void)memset((void *)&entry, 0, sizeof(entry));
+	}
+	return entry;
+}
+
+void profilingReset(void)
+{
+	(void)memset((void *)_profilingProbes, 0, sizeof(_profilingProbes));
+}
+
+void profilingDump(void)
+{
+#if defined(MY_HW_HAS_CYCLE_COUNTER)
+	DEBUG_OUTPUT(PSTR("PRF:UNIT=CYCLES\n"));
+#else
+	DEBUG_OUTPUT(PSTR("PRF:UNIT=US\n"));
+#endif
+	for (uint8_t i = 0; i < PROFILING_PROBES; i++) {
+		const profilingProbe_t entry = profilingGet(i);
+		// the average instead of the 64 bit total, not all printf implementations support it
+		DEBUG_OUTPUT(PSTR("PRF:P=%" PRIu8 ",N=%" PRIu32 ",AVG=%" PRIu32 ",MAX=%" PRIu32 "\n"), i,
+		             entry.count, entry.count ? (uint32_t)(entry.total / entry.count) : 0u, entry.max);
+	}
+}
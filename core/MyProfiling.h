@@ -0,0 +1,132 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+ * @file MyProfiling.h
+ *
+ * @brief Per function profiling, see @ref MY_PROFILING
+ *
+ * Each probe brackets a hot function and accumulates the number of calls, the total and the
+ * longest run time. Times are CPU cycles where the architecture has a cycle counter
+ * (@ref MY_HW_HAS_CYCLE_COUNTER), microseconds otherwise. Probes are inclusive: the time of
+ * transportSendWrite() contains the signing and the radio send it calls.
+ *
+ * The controller reads a probe with an I_PROFILING request to the probe index as sensor id,
+ * 255 requests all probes. Each probe is answered by an I_PROFILING message with the probe
+ * index as sensor id and a custom payload of profilingProbe_t (little endian). A payload of "R"
+ * resets the probes after they have been reported. profilingDump() prints all probes to the
+ * debug output, e.g. on a serial command handled by the sketch.
+ */
+
+#ifndef MyProfiling_h
+#define MyProfiling_h
+
+#include <stdint.h>
+
+/**
+ * @brief Profiling probes
+ *
+ * The order defines the index used by I_PROFILING messages, new probes are added at the end.
+ */
+typedef enum {
+	PROFILING_TRANSPORT_PROCESS_FIFO = 0,	//!< transportProcessFIFO()
+	PROFILING_TRANSPORT_SEND_WRITE,			//!< transportSendWrite()
+	PROFILING_SIGNER_SIGN,					//!< signerSignMsg()
+	PROFILING_SIGNER_VERIFY,				//!< signerVerifyMsg()
+	PROFILING_RADIO_SEND,					//!< transportHALSend(), the radio driver send
+	PROFILING_RADIO_RECEIVE,				//!< transportHALReceive(), the radio driver receive
+	PROFILING_LEDS_PROCESS,					//!< ledsProcess()
+	PROFILING_MESSAGE_GET_STRING,			//!< MyMessage::getString(), payload formatting
+	PROFILING_PROBES						//!< Number of probes
+} profilingProbeId_t;
+
+/**
+ * @brief Accumulated probe data, also the payload of I_PROFILING responses
+ */
+typedef struct {
+	uint32_t count;		//!< Calls
+	uint32_t max;		//!< Longest call
+	uint64_t total;		//!< Sum of all calls
+} __attribute__((packed)) profilingProbe_t;
+
+#if defined(MY_PROFILING)
+/**
+ * @brief Start the cycle counter
+ */
+void profilingInit(void);
+
+/**
+ * @brief Timestamp starting a probe
+ * @return cycle counter, or hwMicros() without cycle counter
+ */
+uint32_t profilingStamp(void);
+
+/**
+ * @brief Account a call
+ * @param probe Probe index, see profilingProbeId_t
+ * @param start Timestamp returned by profilingStamp() when the call started
+ */
+void profilingRecord(const uint8_t probe, const uint32_t start);
+
+/**
+ * @brief Read a probe
+ * @param probe Probe index, see profilingProbeId_t
+ * @return Copy of the probe data, empty for an unknown index
+ */
+profilingProbe_t profilingGet(const uint8_t probe);
+
+/**
+ * @brief Reset all probes
+ */
+void profilingReset(void);
+
+/**
+ * @brief Print all probes to the debug output
+ */
+void profilingDump(void);
+
+/**
+ * @brief Records the lifetime of the object in a probe, i.e. all exit paths of a function
+ */
+class ProfilingScope
+{
+public:
+	/**
+	 * @brief Start the probe
+	 * @param probe Probe index, see profilingProbeId_t
+	 */
+	explicit ProfilingScope(const uint8_t probe) : _probe(probe), _start(profilingStamp()) {}
+	/**
+	 * @brief Account the call
+	 */
+	~ProfilingScope()
+	{
+		profilingRecord(_probe, _start);
+	}
+private:
+	const uint8_t _probe;
+	const uint32_t _start;
+};
+
+#define PROFILING_SCOPE(probe)	const ProfilingScope _profilingScope(probe)	//!< Profile the enclosing block
+#else
+#define PROFILING_SCOPE(probe)	//!< Profiling disabled
+#endif
+
+#endif
@@ -23,143 +23,519 @@
 #include "MyHelperFunctions.h"
 #include <string.h>
 
+#if defined(MY_NODE_ID_16BIT)
+// node ids have up to 5 digits, 255 stays the broadcast of the controller
+#define PROTOCOL_NODE_ID_MAX (0xFFFFu)
+#define PROTOCOL_HEADER_LENGTH (22u)
+#else
+#define PROTOCOL_NODE_ID_MAX (0xFFu)
+#define PROTOCOL_HEADER_LENGTH (20u)
+#endif
+
+#if MY_GATEWAY_MAX_SEND_LENGTH < PROTOCOL_HEADER_LENGTH
+#error MY_GATEWAY_MAX_SEND_LENGTH must hold at least the message header
+#endif
+
+#if defined(MY_GATEWAY_BINARY_FRAMING) && MY_GATEWAY_MAX_SEND_LENGTH < PROTOCOL_BINARY_MAX_LENGTH
+#error MY_GATEWAY_MAX_SEND_LENGTH must hold a binary frame
+#endif
+
+#if defined(MY_SHARED_BUFFERS)
+static char (&_fmtBuffer)[MY_GATEWAY_MAX_SEND_LENGTH] = _coreSharedBuffers.protocol.fmt;
+static char (&_convBuffer)[MAX_PAYLOAD * 2 + 1] = _coreSharedBuffers.protocol.conv;
+#else
 char _fmtBuffer[MY_GATEWAY_MAX_SEND_LENGTH];
 char _convBuffer[MAX_PAYLOAD * 2 + 1];
+#endif
 
-bool protocolSerial2MyMessage(MyMessage &message, char *inputString)
+// prepare for the next line or frame, the framing of the link is kept
+static void _protocolParserNext(protocolParser_t &parser)
 {
-	char *str, *p;
-	uint8_t index = 0;
-	uint8_t command = 0;
-	message.sender = GATEWAY_ADDRESS;
-	message.last = GATEWAY_ADDRESS;
-	mSetEcho(message, false);
+	parser.field = 0;
+	parser.command = 0;
+	parser.digits = 0;
+	parser.value = 0;
+	parser.length = 0;
+}
 
-	// Extract command data coming on serial line
-	for (str = strtok_r(inputString, ";", &p); // split using semicolon
-	        str && index < 6; // loop while str is not null an max 5 times
-	        str = strtok_r(NULL, ";", &p) // get subsequent tokens
-	    ) {
-		switch (index) {
-		case 0: // Radio id (destination)
-			message.destination = atoi(str);
-			break;
-		case 1: // Child id
-			message.sensor = atoi(str);
-			break;
-		case 2: // Message type
-			command = atoi(str);
-			mSetCommand(message, command);
-			break;
-		case 3: // Should we request echo from destination?
-			mSetRequestEcho(message, atoi(str) ? 1 : 0);
-			break;
-		case 4: // Data type
-			message.type = atoi(str);
-			break;
-		case 5: {// Variable value
-			if (command == C_STREAM) {
-				uint8_t bvalue[MAX_PAYLOAD];
-				uint8_t blen = 0;
-				while (*str) {
-					uint8_t val;
-					val = convertH2I(*str++) << 4;
-					val += convertH2I(*str++);
-					bvalue[blen] = val;
-					blen++;
-				}
-				message.set(bvalue, blen);
-			} else {
-				char *value = str;
-				// Remove trailing carriage return and newline character (if it exists)
-				const uint8_t lastCharacter = strlen(value) - 1;
-				if (value[lastCharacter] == '\r' || value[lastCharacter] == '\n') {
-					value[lastCharacter] = '\0';
-				}
-				message.set(value);
+void protocolParserReset(protocolParser_t &parser)
+{
+	_protocolParserNext(parser);
+	parser.mode = PROTOCOL_MODE_ASCII;
+}
+
+#if defined(MY_GATEWAY_BINARY_FRAMING)
+static uint16_t _protocolCRC16(uint16_t crc, const uint8_t data)
+{
+	// same CRC as the OTA firmware check
+	return crc16Update(crc, data);
+}
+
+static protocolParseResult_t _protocolParseBinary(protocolParser_t &parser, MyMessage &message,
+        const uint8_t inByte)
+{
+	parser.length++;
+	if (parser.length == 1) {
+		// frame length, a complete header and at most MAX_PAYLOAD bytes
+		if (inByte < HEADER_SIZE || inByte > HEADER_SIZE + MAX_PAYLOAD) {
+			_protocolParserNext(parser);
+			STATS_INC(STATS_GW_PARSE_ERRORS);
+			return PROTOCOL_PARSE_INVALID;
+		}
+		parser.command = inByte;
+		parser.value = _protocolCRC16(0xFFFF, inByte);
+	} else if (parser.length <= (uint16_t)parser.command + 1) {
+		((uint8_t *)&message)[parser.length - 2] = inByte;
+		parser.value = _protocolCRC16(parser.value, inByte);
+	} else if (parser.length == (uint16_t)parser.command + 2) {
+		parser.digits = inByte;
+	} else {
+		const uint16_t crc = (uint16_t)parser.digits << 8 | inByte;
+		const uint8_t payloadLength = parser.command - HEADER_SIZE;
+		if (crc != parser.value || mGetLength(message) != payloadLength) {
+			// start over, the next byte may begin a frame or an ASCII line
+			_protocolParserNext(parser);
+			STATS_INC(STATS_GW_PARSE_ERRORS);
+			return PROTOCOL_PARSE_INVALID;
+		}
+		// messages from the controller are sent by the gateway, like in ASCII framing
+		message.sender = GATEWAY_ADDRESS;
+		message.last = GATEWAY_ADDRESS;
+		mSetEcho(message, false);
+		message.data[payloadLength] = 0;
+		_protocolParserNext(parser);
+		parser.mode = PROTOCOL_MODE_BINARY;
+		return PROTOCOL_PARSE_OK;
+	}
+	return PROTOCOL_PARSE_PENDING;
+}
+#endif
+
+static protocolParseResult_t _protocolParseEnd(protocolParser_t &parser, MyMessage &message)
+{
+	protocolParseResult_t result = PROTOCOL_PARSE_INVALID;
+	if (parser.length == 0 || parser.length >= MY_GATEWAY_MAX_RECEIVE_LENGTH) {
+		// empty line (e.g. \n of a \r\n line ending) or end of a line already reported too long
+		result = PROTOCOL_PARSE_PENDING;
+	} else if (parser.field == PROTOCOL_PARSER_FIELD_PAYLOAD ||
+	           parser.field == PROTOCOL_PARSER_FIELD_SKIP) {
+		if (parser.command == C_STREAM) {
+			if (!(parser.value & 1u)) {
+				mSetLength(message, parser.value / 2);
+				mSetPayloadType(message, P_CUSTOM);
+				result = PROTOCOL_PARSE_OK;
 			}
-			break;
+		} else {
+			// strings longer than the payload are truncated like MyMessage::set() does
+			const uint8_t payloadLength = min(parser.value, (uint16_t)MAX_PAYLOAD);
+			message.data[payloadLength] = 0;
+			mSetLength(message, payloadLength);
+			mSetPayloadType(message, P_STRING);
+			result = PROTOCOL_PARSE_OK;
 		}
+	}
+	_protocolParserNext(parser);
+	if (result == PROTOCOL_PARSE_OK) {
+		parser.mode = PROTOCOL_MODE_ASCII;
+	} else if (result == PROTOCOL_PARSE_INVALID) {
+		STATS_INC(STATS_GW_PARSE_ERRORS);
+	}
+	return result;
+}
+
+protocolParseResult_t protocolParse(protocolParser_t &parser, MyMessage &message,
+                                    const char inChar)
+{
+#if defined(MY_GATEWAY_BINARY_FRAMING)
+	if (parser.field == PROTOCOL_PARSER_FIELD_BINARY) {
+		return _protocolParseBinary(parser, message, (uint8_t)inChar);
+	}
+	if ((parser.length == 0 || parser.field == PROTOCOL_PARSER_FIELD_DISCARD) &&
+	        (uint8_t)inChar == PROTOCOL_BINARY_SYNC) {
+		// a frame starts a line, or ends a garbled one
+		_protocolParserNext(parser);
+		parser.field = PROTOCOL_PARSER_FIELD_BINARY;
+		return PROTOCOL_PARSE_PENDING;
+	}
+#endif
+	if (inChar == '\n' || inChar == '\r') {
+		return _protocolParseEnd(parser, message);
+	}
+	if (parser.field == PROTOCOL_PARSER_FIELD_DISCARD) {
+		return PROTOCOL_PARSE_PENDING;
+	}
+	if (++parser.length >= MY_GATEWAY_MAX_RECEIVE_LENGTH) {
+		// Incoming message too long. Throw away the rest of the line
+		parser.field = PROTOCOL_PARSER_FIELD_DISCARD;
+		STATS_INC(STATS_GW_PARSE_ERRORS);
+		return PROTOCOL_PARSE_TOO_LONG;
+	}
+
+	if (parser.field < PROTOCOL_PARSER_FIELD_PAYLOAD) {
+		if (inChar >= '0' && inChar <= '9') {
+			const uint32_t value = (uint32_t)parser.value * 10 + (inChar - '0');
+			parser.digits++;
+			if (value <= (parser.field ? 0xFFu : PROTOCOL_NODE_ID_MAX)) {
+				parser.value = (uint16_t)value;
+				return PROTOCOL_PARSE_PENDING;
+			}
+		} else if (inChar == ';' && parser.digits) {
+			const uint8_t value = (uint8_t)parser.value;
+			switch (parser.field) {
+			case 0: // Radio id (destination)
+				message.sender = GATEWAY_ADDRESS;
+				message.last = GATEWAY_ADDRESS;
+				mSetEcho(message, false);
+				message.destination = parser.value == 0xFFu ? BROADCAST_ADDRESS : (nodeId_t)parser.value;
+				break;
+			case 1: // Child id
+				message.sensor = value;
+				break;
+			case 2: // Message type
+				parser.command = value;
+				mSetCommand(message, value);
+				break;
+			case 3: // Should we request echo from destination?
+				mSetRequestEcho(message, value ? 1 : 0);
+				break;
+			case 4: // Data type
+				message.type = value;
+				break;
+			}
+			parser.field++;
+			parser.digits = 0;
+			parser.value = 0;
+			return PROTOCOL_PARSE_PENDING;
+		}
+		// not a number, out of range or a field without digits
+		parser.field = PROTOCOL_PARSER_FIELD_DISCARD;
+		return PROTOCOL_PARSE_PENDING;
+	}
+
+	if (parser.field == PROTOCOL_PARSER_FIELD_PAYLOAD) {
+		// Variable value
+		if (inChar == ';') {
+			parser.field = PROTOCOL_PARSER_FIELD_SKIP;
+		} else if (parser.command == C_STREAM) {
+			uint8_t nibble;
+			if (inChar >= '0' && inChar <= '9') {
+				nibble = inChar - '0';
+			} else if (inChar >= 'a' && inChar <= 'f') {
+				nibble = inChar - 'a' + 10;
+			} else if (inChar >= 'A' && inChar <= 'F') {
+				nibble = inChar - 'A' + 10;
+			} else {
+				parser.field = PROTOCOL_PARSER_FIELD_DISCARD;
+				return PROTOCOL_PARSE_PENDING;
+			}
+			if (parser.value >= MAX_PAYLOAD * 2) {
+				parser.field = PROTOCOL_PARSER_FIELD_DISCARD;
+				return PROTOCOL_PARSE_PENDING;
+			}
+			uint8_t *byte = (uint8_t *)&message.data[parser.value / 2];
+			*byte = (parser.value & 1u) ? (*byte | nibble) : (nibble << 4);
+			parser.value++;
+		} else {
+			if (parser.value < MAX_PAYLOAD) {
+				message.data[parser.value] = inChar;
+			}
+			parser.value++;
 		}
-		index++;
+	}
+	return PROTOCOL_PARSE_PENDING;
+}
+
+bool protocolSerial2MyMessage(MyMessage &message, char *inputString)
+{
+	protocolParser_t parser;
+	protocolParserReset(parser);
+	while (*inputString) {
+		(void)protocolParse(parser, message, *inputString++);
 	}
 	// Return true if input valid
-	return (index == 6);
+	return protocolParse(parser, message, '\n') == PROTOCOL_PARSE_OK;
+}
+
+#if defined(MY_GATEWAY_BINARY_FRAMING)
+size_t protocolMyMessage2Binary(MyMessage &message, uint8_t *frame)
+{
+	const uint8_t frameLength = HEADER_SIZE + min(mGetLength(message), (uint8_t)MAX_PAYLOAD);
+	frame[0] = PROTOCOL_BINARY_SYNC;
+	frame[1] = frameLength;
+	(void)memcpy(&frame[2], &message, frameLength);
+	uint16_t crc = 0xFFFF;
+	for (uint8_t i = 1; i < frameLength + 2; i++) {
+		crc = _protocolCRC16(crc, frame[i]);
+	}
+	frame[frameLength + 2] = crc >> 8;
+	frame[frameLength + 3] = crc & 0xFF;
+	return frameLength + PROTOCOL_BINARY_OVERHEAD;
 }
 
+char *protocolMyMessage2Frame(MyMessage &message, const protocolParser_t &parser, size_t &length)
+{
+	if (parser.mode == PROTOCOL_MODE_BINARY) {
+		length = protocolMyMessage2Binary(message, (uint8_t *)_fmtBuffer);
+		return _fmtBuffer;
+	}
+	return protocolMyMessage2Serial(message, length);
+}
+
+bool protocolBinary2MyMessage(MyMessage &message, const uint8_t *buffer, const size_t length)
+{
+	protocolParser_t parser;
+	protocolParserReset(parser);
+	if (length < 1 || buffer[0] != PROTOCOL_BINARY_SYNC) {
+		return false;
+	}
+	for (size_t i = 0; i < length; i++) {
+		if (protocolParse(parser, message, (char)buffer[i]) == PROTOCOL_PARSE_OK) {
+			// the frame has to fill the buffer exactly
+			return i == length - 1;
+		}
+		if (parser.field != PROTOCOL_PARSER_FIELD_BINARY) {
+			// invalid frame
+			return false;
+		}
+	}
+	return false;
+}
+#endif
+
 char *protocolMyMessage2Serial(MyMessage &message)
 {
-	(void)snprintf_P(_fmtBuffer, MY_GATEWAY_MAX_SEND_LENGTH,
-	                 PSTR("%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%s\n"), message.sender,
-	                 message.sensor, mGetCommand(message), mGetEcho(message), message.type,
-	                 message.getString(_convBuffer));
+	size_t length;
+	return protocolMyMessage2Serial(message, length);
+}
+
+char *protocolMyMessage2Serial(MyMessage &message, size_t &length)
+{
+	// header: at most 5 fields of 3 digits (5 for a 16 bit node id) and their separators
+	size_t pos = convertU2D(_fmtBuffer, message.sender);
+	_fmtBuffer[pos++] = ';';
+	pos += convertU2D(&_fmtBuffer[pos], message.sensor);
+	_fmtBuffer[pos++] = ';';
+	pos += convertU2D(&_fmtBuffer[pos], mGetCommand(message));
+	_fmtBuffer[pos++] = ';';
+	pos += convertU2D(&_fmtBuffer[pos], mGetEcho(message));
+	_fmtBuffer[pos++] = ';';
+	pos += convertU2D(&_fmtBuffer[pos], message.type);
+	_fmtBuffer[pos++] = ';';
+
+	if (MY_GATEWAY_MAX_SEND_LENGTH - pos >= sizeof(_convBuffer) + 1) {
+		// payload fits, format it in place
+		pos += strlen(message.getString(&_fmtBuffer[pos]));
+	} else {
+		// truncate like snprintf, keeping room for the newline
+		const size_t payloadLength = min(strlen(message.getString(_convBuffer)),
+		                                 MY_GATEWAY_MAX_SEND_LENGTH - pos - 2);
+		(void)memcpy(&_fmtBuffer[pos], _convBuffer, payloadLength);
+		pos += payloadLength;
+	}
+	_fmtBuffer[pos++] = '\n';
+	_fmtBuffer[pos] = 0;
+	length = pos;
 	return _fmtBuffer;
 }
 
+// "/node/child/command/echo/type", at most 5 fields of 3 digits and their separators
+#define PROTOCOL_MQTT_SUFFIX_LENGTH PROTOCOL_HEADER_LENGTH
+
+static uint8_t _protocolMQTTSuffix(char *buffer, MyMessage &message)
+{
+	uint8_t pos = 0;
+	buffer[pos++] = '/';
+	pos += convertU2D(&buffer[pos], message.sender);
+	buffer[pos++] = '/';
+	pos += convertU2D(&buffer[pos], message.sensor);
+	buffer[pos++] = '/';
+	pos += convertU2D(&buffer[pos], mGetCommand(message));
+	buffer[pos++] = '/';
+	pos += convertU2D(&buffer[pos], mGetEcho(message));
+	buffer[pos++] = '/';
+	pos += convertU2D(&buffer[pos], message.type);
+	return pos;
+}
+
+#if MY_MQTT_CLIENT_TOPIC_CACHE_SIZE > 0
+#if defined(MY_NODE_ID_16BIT)
+typedef uint64_t protocolMQTTKey_t;
+#else
+typedef uint32_t protocolMQTTKey_t;
+#endif
+
+// Direct mapped cache of formatted topic suffixes, the topic space of a network is small
+typedef struct {
+	protocolMQTTKey_t key;		// header fields + 1, 0 marks an empty slot
+	uint8_t length;
+	char suffix[PROTOCOL_MQTT_SUFFIX_LENGTH];
+#if defined(MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS)
+	uint32_t payloadHash;	// FNV-1a of the last payload published, 0 if none
+	uint32_t publishedMS;
+#endif
+} protocolMQTTTopic_t;
+
+static protocolMQTTTopic_t _protocolMQTTTopics[MY_MQTT_CLIENT_TOPIC_CACHE_SIZE];
+
+static protocolMQTTKey_t _protocolMQTTKey(const MyMessage &message)
+{
+	return ((protocolMQTTKey_t)message.sender << 20 | (uint32_t)message.sensor << 12 |
+	        (uint32_t)mGetCommand(message) << 9 | (uint32_t)mGetEcho(message) << 8 |
+	        message.type) + 1;
+}
+
+static protocolMQTTTopic_t &_protocolMQTTEntry(const protocolMQTTKey_t key)
+{
+	return _protocolMQTTTopics[(uint32_t)(key * 2654435761u >> 16) % MY_MQTT_CLIENT_TOPIC_CACHE_SIZE];
+}
+#endif
+
+#if defined(MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS)
+static uint32_t _protocolMQTTHash(const char *payload)
+{
+	uint32_t hash = 2166136261u;
+	while (*payload) {
+		hash = (hash ^ (uint8_t)*payload++) * 16777619u;
+	}
+	// 0 is reserved for no payload
+	return hash ? hash : 1u;
+}
+
+bool protocolMQTTPayloadUnchanged(const MyMessage &message, const char *payload)
+{
+	const protocolMQTTKey_t key = _protocolMQTTKey(message);
+	const protocolMQTTTopic_t &entry = _protocolMQTTEntry(key);
+	return entry.key == key && entry.payloadHash == _protocolMQTTHash(payload) &&
+	       (uint32_t)(hwMillis() - entry.publishedMS) < (uint32_t)MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS;
+}
+
+void protocolMQTTPayloadPublished(const MyMessage &message, const char *payload)
+{
+	const protocolMQTTKey_t key = _protocolMQTTKey(message);
+	protocolMQTTTopic_t &entry = _protocolMQTTEntry(key);
+	if (entry.key == key) {
+		entry.payloadHash = _protocolMQTTHash(payload);
+		entry.publishedMS = hwMillis();
+	}
+}
+
+void protocolMQTTPayloadReset(void)
+{
+	for (size_t i = 0; i < MY_MQTT_CLIENT_TOPIC_CACHE_SIZE; i++) {
+		_protocolMQTTTopics[i].payloadHash = 0;
+	}
+}
+#endif
+
 char *protocolMyMessage2MQTT(const char *prefix, MyMessage &message)
 {
-	(void)snprintf_P(_fmtBuffer, MY_GATEWAY_MAX_SEND_LENGTH,
-	                 PSTR("%s/%" PRIu8 "/%" PRIu8 "/%" PRIu8 "/%" PRIu8 "/%" PRIu8 ""), prefix,
-	                 message.sender, message.sensor, mGetCommand(message), mGetEcho(message), message.type);
+	size_t pos = min(strlen(prefix), (size_t)(MY_GATEWAY_MAX_SEND_LENGTH - 1));
+	(void)memcpy(_fmtBuffer, prefix, pos);
+	// the suffix is written to a scratch area first, the prefix may be long enough to truncate it
+	char suffix[PROTOCOL_MQTT_SUFFIX_LENGTH];
+	const char *formatted = suffix;
+	uint8_t length;
+#if MY_MQTT_CLIENT_TOPIC_CACHE_SIZE > 0
+	const protocolMQTTKey_t key = _protocolMQTTKey(message);
+	protocolMQTTTopic_t &entry = _protocolMQTTEntry(key);
+	if (entry.key != key) {
+		entry.length = _protocolMQTTSuffix(entry.suffix, message);
+		entry.key = key;
+#if defined(MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS)
+		entry.payloadHash = 0;
+#endif
+	}
+	formatted = entry.suffix;
+	length = entry.length;
+#else
+	length = _protocolMQTTSuffix(suffix, message);
+#endif
+	length = min((size_t)length, MY_GATEWAY_MAX_SEND_LENGTH - 1 - pos);
+	(void)memcpy(&_fmtBuffer[pos], formatted, length);
+	pos += length;
+	_fmtBuffer[pos] = 0;
 	return _fmtBuffer;
 }
 
 bool protocolMQTT2MyMessage(MyMessage &message, char *topic, uint8_t *payload,
                             const unsigned int length)
 {
-	char *str, *p;
+	// Only the part behind the subscribed prefix is looked at, it is parsed in a single pass
+	const char *str = topic + strlen(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX) + 1;
+	uint16_t fields[5];
 	uint8_t index = 0;
-	message.sender = GATEWAY_ADDRESS;
-	message.last = GATEWAY_ADDRESS;
-	mSetEcho(message, false);
-	for (str = strtok_r(topic + strlen(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX) + 1, "/", &p);
-	        str && index < 5;
-	        str = strtok_r(NULL, "/", &p)
-	    ) {
-		switch (index) {
-		case 0:
-			// Node id
-			message.destination = atoi(str);
-			break;
-		case 1:
-			// Sensor id
-			message.sensor = atoi(str);
-			break;
-		case 2: {
-			// Command type
-			const uint8_t command = atoi(str);
-			mSetCommand(message, command);
-			// Add payload
-			if (command == C_STREAM) {
-				uint8_t bvalue[MAX_PAYLOAD];
-				uint8_t blen = 0;
-				while (*payload) {
-					uint8_t val;
-					val = convertH2I(*payload++) << 4;
-					val += convertH2I(*payload++);
-					bvalue[blen] = val;
-					blen++;
-				}
-				message.set(bvalue, blen);
-			} else {
-				// terminate string
-				char *value = (char *)payload;
-				value[length] = '\0';
-				message.set((const char*)payload);
+	uint32_t value = 0;
+	uint8_t digits = 0;
+	for (;; str++) {
+		if (*str >= '0' && *str <= '9') {
+			value = value * 10 + (*str - '0');
+			if (value > (index ? 0xFFu : PROTOCOL_NODE_ID_MAX)) {
+				return false;
 			}
-			break;
-		}
-		case 3:
-			// Echo flag
-			mSetRequestEcho(message, atoi(str) ? 1 : 0);
-			break;
-		case 4:
-			// Sub type
-			message.type = atoi(str);
-			break;
+			digits++;
+		} else if ((*str == '/' || *str == 0) && digits && index < 5) {
+			fields[index++] = (uint16_t)value;
+			value = 0;
+			digits = 0;
+			if (*str == 0) {
+				break;
+			}
+		} else {
+			return false;
 		}
-		index++;
 	}
 	// Return true if input valid
-	return (index == 5);
+	if (index != 5) {
+		return false;
+	}
+	message.sender = GATEWAY_ADDRESS;
+	message.last = GATEWAY_ADDRESS;
+	mSetEcho(message, false);
+	message.destination = fields[0] == 0xFFu ? BROADCAST_ADDRESS : (nodeId_t)fields[0];
+	message.sensor = fields[1];
+	mSetCommand(message, fields[2]);
+	mSetRequestEcho(message, fields[3] ? 1 : 0);
+	message.type = fields[4];
+	// Add payload
+	if (fields[2] == C_STREAM) {
+		uint8_t bvalue[MAX_PAYLOAD];
+		const uint8_t blen = min(length / 2, (unsigned int)MAX_PAYLOAD);
+		convertHex2Buf(bvalue, (const char *)payload, blen);
+		message.set(bvalue, blen);
+	} else {
+		// strings longer than the payload are truncated like MyMessage::set() does
+		const uint8_t payloadLength = min(length, (unsigned int)MAX_PAYLOAD);
+		(void)memcpy(message.data, payload, payloadLength);
+		message.data[payloadLength] = 0;
+		mSetLength(message, payloadLength);
+		mSetPayloadType(message, P_STRING);
+	}
+	return true;
+}
+
+bool protocolBatch2MyMessage(MyMessage &message, const MyMessage &batch, uint8_t &position)
+{
+	const uint8_t batchLength = mGetLength(batch);
+	if (position + BATCH_RECORD_HEADER_SIZE > batchLength) {
+		return false;
+	}
+	const uint8_t *record = (const uint8_t *)&batch.data[position];
+	const uint8_t length = record[2] & 0x1F;
+	if (position + BATCH_RECORD_HEADER_SIZE + length > batchLength) {
+		return false;
+	}
+	message.last = batch.last;
+	message.sender = batch.sender;
+	message.destination = batch.destination;
+	message.version_length = 0;
+	mSetVersion(message, PROTOCOL_VERSION);
+	message.command_echo_payload = 0;
+	mSetCommand(message, C_SET);
+	message.sensor = record[0];
+	message.type = record[1];
+	(void)message.set(&record[BATCH_RECORD_HEADER_SIZE], length);
+	message.data[length] = 0;	// terminate string payloads
+	mSetPayloadType(message, record[2] >> 5);
+	position += BATCH_RECORD_HEADER_SIZE + length;
+	return true;
 }
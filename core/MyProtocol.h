@@ -22,6 +22,53 @@
 
 #include "MySensorsCore.h"
 
+#define PROTOCOL_PARSER_FIELD_PAYLOAD	(5u)		//!< Index of the payload field
+#define PROTOCOL_PARSER_FIELD_SKIP	(6u)		//!< Ignore the rest of the line, message is complete
+#define PROTOCOL_PARSER_FIELD_BINARY	(7u)		//!< Inside a binary frame
+#define PROTOCOL_PARSER_FIELD_DISCARD	(0xFFu)	//!< Ignore the rest of the line, message is invalid
+
+#define PROTOCOL_BINARY_SYNC		(0xA5u)		//!< First byte of a binary frame
+#define PROTOCOL_BINARY_OVERHEAD	(4u)		//!< Sync, length and CRC bytes around the raw message
+#define PROTOCOL_BINARY_MAX_LENGTH	(PROTOCOL_BINARY_OVERHEAD + HEADER_SIZE + MAX_PAYLOAD) //!< Largest binary frame
+
+// Framing of a controller link
+typedef enum {
+	PROTOCOL_MODE_ASCII,		// node;child;cmd;ack;type;payload lines, the default
+	PROTOCOL_MODE_BINARY		// length prefixed raw messages with a CRC
+} protocolMode_t;
+
+// State of the incremental serial protocol parser, one per input stream
+typedef struct {
+	uint8_t field;		// field currently parsed
+	uint8_t command;	// command of the message being parsed, binary frames: frame length
+	uint8_t digits;		// digits in the current numeric field, binary frames: first CRC byte
+	uint16_t value;		// numeric field value or payload characters received, binary frames: CRC
+	uint16_t length;	// characters received on the current line or frame
+	uint8_t mode;		// framing of the last complete message, replies should use the same
+} protocolParser_t;
+
+// Result of feeding one character to the parser
+typedef enum {
+	PROTOCOL_PARSE_PENDING,		// line not complete yet
+	PROTOCOL_PARSE_OK,			// a complete message was stored in message
+	PROTOCOL_PARSE_INVALID,		// malformed line dropped
+	PROTOCOL_PARSE_TOO_LONG		// line exceeds MY_GATEWAY_MAX_RECEIVE_LENGTH, rest of it is dropped
+} protocolParseResult_t;
+
+// reset the parser, e.g. when a new client connects, the link falls back to ASCII framing
+void protocolParserReset(protocolParser_t &parser);
+
+// parse(parser, message, inChar)
+// feed one character of the serial protocol, the message is filled in place
+// returns PROTOCOL_PARSE_OK when a newline completed a valid message
+// with MY_GATEWAY_BINARY_FRAMING a line may also be a binary frame:
+//   PROTOCOL_BINARY_SYNC, length, raw message header and payload (length bytes),
+//   CRC-16 (0xA001 polynomial, initial 0xFFFF, high byte first) of length and raw message
+// PROTOCOL_PARSE_OK is then returned on the last CRC byte and parser.mode becomes
+// PROTOCOL_MODE_BINARY until the next ASCII line
+protocolParseResult_t protocolParse(protocolParser_t &parser, MyMessage &message,
+                                    const char inChar);
+
 // parse(message, inputString)
 // parse a string into a message element
 // returns true if successfully parsed the input string
@@ -30,4 +77,36 @@ bool protocolSerial2MyMessage(MyMessage &message, char *inputString);
 // Format MyMessage to the protocol representation
 char *protocolMyMessage2Serial(MyMessage &message);
 
+// Format MyMessage to the protocol representation, length receives the number of characters
+char *protocolMyMessage2Serial(MyMessage &message, size_t &length);
+
+// Unpack the reading at position of an I_BATCH message into a C_SET message from the same sender
+// position is advanced to the next reading, start with 0
+// returns false when all readings are unpacked or the batch is malformed
+bool protocolBatch2MyMessage(MyMessage &message, const MyMessage &batch, uint8_t &position);
+
+#if defined(MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS)
+// returns true if payload was published to the topic of message within
+// MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS, as recorded by protocolMQTTPayloadPublished()
+bool protocolMQTTPayloadUnchanged(const MyMessage &message, const char *payload);
+
+// record payload as published to the topic of message, call after protocolMyMessage2MQTT()
+void protocolMQTTPayloadPublished(const MyMessage &message, const char *payload);
+
+// forget all recorded payloads, e.g. when the broker session is new
+void protocolMQTTPayloadReset(void);
+#endif
+
+#if defined(MY_GATEWAY_BINARY_FRAMING)
+// Format MyMessage to a binary frame of at most PROTOCOL_BINARY_MAX_LENGTH bytes
+// returns the number of bytes written to frame
+size_t protocolMyMessage2Binary(MyMessage &message, uint8_t *frame);
+
+// Format MyMessage in the framing the parser of the link last received
+char *protocolMyMessage2Frame(MyMessage &message, const protocolParser_t &parser, size_t &length);
+
+// parse a buffer holding exactly one binary frame, returns true if the frame is valid
+bool protocolBinary2MyMessage(MyMessage &message, const uint8_t *buffer, const size_t length);
+#endif
+
 #endif
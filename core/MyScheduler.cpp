@@ -0,0 +1,85 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyScheduler.h"
+
+static schedulerTask_t *_schedulerTasks = NULL;	//!< registered tasks
+
+void schedulerAdd(schedulerTask_t *task, const schedulerCallback_t callback)
+{
+	for (schedulerTask_t *entry = _schedulerTasks; entry != NULL; entry = entry->next) {
+		if (entry == task) {
+			return;
+		}
+	}
+	task->callback = callback;
+	task->armed = false;
+	task->next = _schedulerTasks;
+	_schedulerTasks = task;
+}
+
+void schedulerSet(schedulerTask_t *task, const uint32_t delayMS)
+{
+	task->due = hwMillis() + delayMS;
+	task->armed = true;
+}
+
+void schedulerCancel(schedulerTask_t *task)
+{
+	task->armed = false;
+}
+
+bool schedulerPending(const schedulerTask_t *task)
+{
+	return task->armed;
+}
+
+bool schedulerRun(schedulerTask_t *task)
+{
+	if (!task->armed || (int32_t)(hwMillis() - task->due) < 0) {
+		return false;
+	}
+	// disarm first, the callback may arm it again
+	task->armed = false;
+	task->callback();
+	return true;
+}
+
+void schedulerProcess(void)
+{
+	for (schedulerTask_t *task = _schedulerTasks; task != NULL; task = task->next) {
+		(void)schedulerRun(task);
+	}
+}
+
+uint32_t schedulerGetNextMS(void)
+{
+	const uint32_t now = hwMillis();
+	uint32_t next = SCHEDULER_IDLE;
+	for (const schedulerTask_t *task = _schedulerTasks; task != NULL; task = task->next) {
+		if (task->armed) {
+			const int32_t left = (int32_t)(task->due - now);
+			if (left <= 0) {
+				return 0;
+			}
+			next = min(next, (uint32_t)left);
+		}
+	}
+	return next;
+}
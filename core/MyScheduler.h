@@ -0,0 +1,98 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+ * @file MyScheduler.h
+ *
+ * @brief Deadlines of the periodic core work
+ *
+ * LEDs, inclusion mode, the transport sanity check and OTA retries register a task and arm it
+ * with a delay instead of comparing hwMillis() against their own timestamps. _process() runs
+ * the tasks that are due and knows when the next one is, the Linux GW sleeps in its event loop
+ * until then. Tasks are owned by the subsystems, the scheduler links them in a list.
+ */
+
+#ifndef MyScheduler_h
+#define MyScheduler_h
+
+#include <stdint.h>
+
+#define SCHEDULER_IDLE	(UINT32_MAX)	//!< schedulerGetNextMS(): no task armed
+
+/**
+ * @brief Function run when a task is due
+ */
+typedef void (*schedulerCallback_t)(void);
+
+/**
+ * @brief Task, owned by the subsystem and valid as long as the program runs
+ */
+typedef struct schedulerTask {
+	struct schedulerTask *next;		//!< next registered task
+	schedulerCallback_t callback;	//!< run when due
+	uint32_t due;					//!< hwMillis() deadline
+	bool armed;						//!< deadline set
+} schedulerTask_t;
+
+/**
+ * @brief Register a task, unarmed. Registering a task again has no effect.
+ * @param task Task
+ * @param callback Function run when the task is due
+ */
+void schedulerAdd(schedulerTask_t *task, const schedulerCallback_t callback);
+
+/**
+ * @brief Arm a task, replaces a pending deadline. The task runs once, callbacks re-arm periodic tasks.
+ * @param task Task
+ * @param delayMS Time in ms from now
+ */
+void schedulerSet(schedulerTask_t *task, const uint32_t delayMS);
+
+/**
+ * @brief Disarm a task
+ * @param task Task
+ */
+void schedulerCancel(schedulerTask_t *task);
+
+/**
+ * @brief Check if a task is armed
+ * @param task Task
+ * @return true if the task waits for its deadline
+ */
+bool schedulerPending(const schedulerTask_t *task);
+
+/**
+ * @brief Run a single task if it is due, for tasks that also advance in nested waits
+ * @param task Task
+ * @return true if the task was run
+ */
+bool schedulerRun(schedulerTask_t *task);
+
+/**
+ * @brief Run all tasks that are due, called by _process()
+ */
+void schedulerProcess(void);
+
+/**
+ * @brief Time until the next task is due, e.g. to limit a sleep
+ * @return Time in ms, 0 if a task is due, @ref SCHEDULER_IDLE if no task is armed
+ */
+uint32_t schedulerGetNextMS(void);
+
+#endif
@@ -33,19 +33,95 @@ MyMessage _msgTmp;		// Buffer for temporary messages (acks and nonces among othe
 // core configuration
 static coreConfig_t _coreConfig;
 
+#if defined(MY_CORE_PROCESS_STATS)
+static coreProcessStats_t _coreProcessStats;
+#endif
+
 #if defined(MY_DEBUG_VERBOSE_CORE)
 static uint8_t waitLock = 0;
 #endif
 
-#if defined(DEBUG_OUTPUT_ENABLED)
+#if defined(MY_SHARED_BUFFERS)
+coreSharedBuffers_t _coreSharedBuffers;
+#endif
+
+#if defined(DEBUG_OUTPUT_ENABLED) && !defined(MY_SHARED_BUFFERS)
 char _convBuf[MAX_PAYLOAD * 2 + 1];
 #endif
 
+#if defined(MY_PRESENTATION_DIGEST)
+// set while the presentation is run without sending it, see _presentationDigestKnown()
+static bool _presentationDigesting = false;
+static uint32_t _presentationDigest = 0;
+
+// Ask the GW if it already has the presentation of this node
+static bool _presentationDigestKnown(void)
+{
+	// dry run: _sendRoute() adds every message to the digest instead of sending it
+	_presentationDigest = 0;
+	_presentationDigesting = true;
+#if defined(MY_REPEATER_FEATURE)
+	(void)present(NODE_SENSOR_ID, S_ARDUINO_REPEATER_NODE);
+#else
+	(void)present(NODE_SENSOR_ID, S_ARDUINO_NODE);
+#endif
+	if (presentation) {
+		presentation();
+	}
+	_presentationDigesting = false;
+	// the signing requirements of both sides, unchanged ones need no signing presentation
+	_presentationDigest = presentationDigestAdd(_presentationDigest, build(_msgTmp, GATEWAY_ADDRESS,
+	                      NODE_SENSOR_ID, C_INTERNAL, I_SIGNING_PRESENTATION).set(
+	                          signerPresentationState(GATEWAY_ADDRESS)));
+	(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+	                       I_PRESENTATION_DIGEST).set(_presentationDigest));
+	// no reply from a GW or controller that does not know digests, present in full
+	const bool known = wait(MY_PRESENTATION_DIGEST_TIMEOUT_MS, C_INTERNAL, I_PRESENTATION_DIGEST) &&
+	                   _msg.getByte() == PRESENTATION_DIGEST_KNOWN;
+	CORE_DEBUG(PSTR("MCO:PRD:D=%08" PRIX32 ",KNOWN=%" PRIu8 "\n"), _presentationDigest, known);
+	return known;
+}
+#endif
+
+#if defined(MY_REGISTRATION_CACHE) && !defined(MY_GATEWAY_FEATURE)
+#define REGISTRATION_CACHE_REGISTERED	(0xA5u)
+#define REGISTRATION_CACHE_DENIED		(0x5Au)
+// a complete handshake with MY_REGISTRATION_CACHE_EPOCH is stored
+static bool _registrationCached = false;
+
+static void _registrationCacheLoad(void)
+{
+	uint8_t cache[SIZE_REGISTRATION_CACHE];
+	hwReadConfigBlock((void *)cache, (void *)EEPROM_REGISTRATION_CACHE_ADDRESS, sizeof(cache));
+	// erased EEPROM matches neither
+	_registrationCached = cache[0] == MY_REGISTRATION_CACHE_EPOCH &&
+	                      (cache[1] == REGISTRATION_CACHE_REGISTERED || cache[1] == REGISTRATION_CACHE_DENIED);
+	if (_registrationCached) {
+		_coreConfig.nodeRegistered = cache[1] == REGISTRATION_CACHE_REGISTERED;
+	}
+	CORE_DEBUG(PSTR("MCO:REG:CACHE=%" PRIu8 "\n"), _registrationCached);
+}
+
+static void _registrationCacheStore(void)
+{
+	const uint8_t cache[SIZE_REGISTRATION_CACHE] = {
+		MY_REGISTRATION_CACHE_EPOCH,
+		(uint8_t)(_coreConfig.nodeRegistered ? REGISTRATION_CACHE_REGISTERED : REGISTRATION_CACHE_DENIED)
+	};
+	hwWriteConfigBlock((void *)cache, (void *)EEPROM_REGISTRATION_CACHE_ADDRESS, sizeof(cache));
+	_registrationCached = true;
+}
+#endif
+
 // Callback for transport=ok transition
 void _callbackTransportReady(void)
 {
 	if (!_coreConfig.presentationSent) {
-#if !defined(MY_GATEWAY_FEATURE)	// GW calls presentNode() when client connected
+#if defined(MY_PRESENTATION_DIGEST)
+		if (!_presentationDigestKnown()) {
+			presentNode();
+		}
+#elif !defined(MY_GATEWAY_FEATURE)	// GW calls presentNode() when client connected
 		presentNode();
 #endif
 		_registerNode();
@@ -57,21 +133,67 @@ void _process(void)
 {
 	doYield();
 
+	// LEDs, inclusion mode, transport sanity check, OTA requests
+	schedulerProcess();
+
+	// commit deferred config writes
+	hwFlushConfigIfDue();
+
+#if defined(MY_DEBUG_TRACE)
+	hwDebugTraceFlush(false);
+#endif
+
 #if defined(MY_INCLUSION_MODE_FEATURE)
 	inclusionProcess();
 #endif
 
+#if defined(MY_CORE_PROCESS_STATS)
+	_coreProcessStats.iterations++;
+	uint32_t started = hwMicros();
+	uint32_t elapsed;
+#endif
+
 #if defined(MY_GATEWAY_FEATURE)
 	gatewayTransportProcess();
+#if defined(MY_CORE_PROCESS_STATS)
+	elapsed = hwMicros() - started;
+	_coreProcessStats.controllerUs += elapsed;
+	if (elapsed > _coreProcessStats.controllerMaxUs) {
+		_coreProcessStats.controllerMaxUs = elapsed;
+	}
+	started += elapsed;
+#endif
 #endif
 
 #if defined(MY_SENSOR_NETWORK)
 	transportProcess();
+#if defined(MY_CORE_PROCESS_STATS)
+	elapsed = hwMicros() - started;
+	_coreProcessStats.radioUs += elapsed;
+	if (elapsed > _coreProcessStats.radioMaxUs) {
+		_coreProcessStats.radioMaxUs = elapsed;
+	}
+#endif
+#endif
+
+#if defined(MY_GATEWAY_SERIAL_BUFFERED)
+	// what this pass sent to the controller leaves in one write
+	gatewayTransportFlush();
 #endif
 
 #if defined(__linux__)
-	// To avoid high cpu usage
-	usleep(10000); // 10ms
+	// To avoid high cpu usage, sleep until there is something to do
+#if defined(MY_SENSOR_NETWORK)
+	if (!transportHALDataAvailable())
+#endif
+	{
+		hwWaitForEvents(schedulerGetNextMS());
+	}
+#if defined(MY_SENSOR_NETWORK)
+	else {
+		hwFlushConfig();
+	}
+#endif
 #endif
 }
 
@@ -104,6 +226,12 @@ void _begin(void)
 	}
 
 	const bool hwInitResult = hwInit();
+#if defined(MY_PROFILING)
+	profilingInit();
+#endif
+#if defined(MY_ENERGY_ACCOUNTING)
+	energyReset();
+#endif
 
 #if !defined(MY_SPLASH_SCREEN_DISABLED) && !defined(MY_GATEWAY_FEATURE)
 	displaySplashScreen();
@@ -118,6 +246,11 @@ void _begin(void)
 	CORE_DEBUG(PSTR("MCO:BGN:INIT " MY_NODE_TYPE ",CP=" MY_CAPABILITIES ",FQ=NA,REL=%"
 	                PRIu8 ",VER="
 	                MYSENSORS_LIBRARY_VERSION "\n"), MYSENSORS_LIBRARY_VERSION_PRERELEASE_NUMBER);
+#endif
+#if defined(MY_SHARED_BUFFERS)
+	CORE_DEBUG(PSTR("MCO:BGN:SHB=%" PRIu16 ",DBG=%" PRIu16 ",SGN=%" PRIu16 ",GWP=%" PRIu16 "\n"),
+	           (uint16_t)sizeof(coreSharedBuffers_t), (uint16_t)SHARED_BUFFERS_DEBUG_SIZE,
+	           (uint16_t)SHARED_BUFFERS_SIGNING_SIZE, (uint16_t)SHARED_BUFFERS_PROTOCOL_SIZE);
 #endif
 	if (!hwInitResult) {
 		CORE_DEBUG(PSTR("!MCO:BGN:HW ERR\n"));
@@ -144,6 +277,9 @@ void _begin(void)
 	// Note: _coreConfig.isMetric is bool, hence empty EEPROM (=0xFF) evaluates to true (default)
 	hwReadConfigBlock((void *)&_coreConfig.controllerConfig, (void *)EEPROM_CONTROLLER_CONFIG_ADDRESS,
 	                  sizeof(controllerConfig_t));
+#if defined(MY_REGISTRATION_CACHE) && !defined(MY_GATEWAY_FEATURE)
+	_registrationCacheLoad();
+#endif
 
 #if defined(MY_OTA_FIRMWARE_FEATURE)
 	// Read firmware config from EEPROM, i.e. type, version, CRC, blocks
@@ -152,7 +288,9 @@ void _begin(void)
 
 #if defined(MY_SENSOR_NETWORK)
 	// Save static parent ID in eeprom (used by bootloader)
-	hwWriteConfig(EEPROM_PARENT_NODE_ID_ADDRESS, MY_PARENT_NODE_ID);
+	nodeId_t parentNodeId = MY_PARENT_NODE_ID;
+	hwWriteConfigBlock((void *)&parentNodeId, (void *)EEPROM_PARENT_NODE_ID_ADDRESS,
+	                   SIZE_PARENT_NODE_ID);
 	// Initialise transport layer
 	transportInitialise();
 	// Register transport=ready callback
@@ -169,7 +307,11 @@ void _begin(void)
 #endif
 
 	// initialise the transport driver
+#if defined(MY_GATEWAY_CONTROLLER_THREAD)
+	if (!gatewayThreadInit()) {
+#else
 	if (!gatewayTransportInit()) {
+#endif
 		setIndication(INDICATION_ERR_INIT_GWTRANSPORT);
 		CORE_DEBUG(PSTR("!MCO:BGN:TSP FAIL\n"));
 		// Nothing more we can do
@@ -200,6 +342,14 @@ void _registerNode(void)
 #if defined (MY_REGISTRATION_FEATURE) && !defined(MY_GATEWAY_FEATURE)
 	CORE_DEBUG(PSTR("MCO:REG:REQ\n"));	// registration request
 	setIndication(INDICATION_REQ_REGISTRATION);
+#if defined(MY_REGISTRATION_CACHE)
+	if (_registrationCached) {
+		// keep the stored result, the response updates it in the background
+		(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+		                       I_REGISTRATION_REQUEST).set(MY_CORE_VERSION));
+		return;
+	}
+#endif
 	_coreConfig.nodeRegistered = MY_REGISTRATION_DEFAULT;
 	uint8_t counter = MY_REGISTRATION_RETRIES;
 	// only proceed if register response received or retries exceeded
@@ -215,6 +365,13 @@ void _registerNode(void)
 
 void presentNode(void)
 {
+#if defined(MY_GATEWAY_CONTROLLER_THREAD)
+	if (gatewayThreadIsController()) {
+		// presentation() and the radio belong to the core thread
+		gatewayThreadPresentNode();
+		return;
+	}
+#endif
 	setIndication(INDICATION_PRESENT);
 	// Present node and request config
 #if defined(MY_GATEWAY_FEATURE)
@@ -245,20 +402,53 @@ void presentNode(void)
 	(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
 	                       I_CONFIG).set(getParentNodeId()));
 
-	// Wait configuration reply.
+	// Wait configuration reply, a stored handshake picks it up whenever it arrives
+#if defined(MY_REGISTRATION_CACHE)
+	if (!_registrationCached) {
+		(void)wait(2000, C_INTERNAL, I_CONFIG);
+	}
+#else
 	(void)wait(2000, C_INTERNAL, I_CONFIG);
+#endif
 
 #endif
 
 	if (presentation) {
 		presentation();
 	}
+#if defined(MY_GATEWAY_PRESENTATION_CACHE) && defined(MY_SENSOR_NETWORK)
+	// the remote nodes follow from the cache, no need to wake them up
+	gatewayTransportCacheReplay();
+#endif
 }
 
 
-uint8_t getNodeId(void)
+#if defined(MY_PRESENTATION_DIGEST) || defined(MY_GATEWAY_PRESENTATION_CACHE)
+uint32_t presentationDigestAdd(const uint32_t digest, const MyMessage &message)
 {
-	uint8_t result;
+	const uint8_t command = mGetCommand(message);
+	if (command != C_PRESENTATION && !(command == C_INTERNAL && (message.type == I_SKETCH_NAME ||
+	                                   message.type == I_SKETCH_VERSION || message.type == I_SIGNING_PRESENTATION))) {
+		return digest;
+	}
+	// FNV-1a per message, summed up so the GW can add its cached messages in any order
+	const uint8_t length = mGetLength(message);
+	const uint8_t header[4] = { command, message.sensor, message.type, length };
+	uint32_t hash = 2166136261u;
+	for (uint8_t i = 0; i < sizeof(header); i++) {
+		hash = (hash ^ header[i]) * 16777619u;
+	}
+	const uint8_t *payload = (const uint8_t *)message.data;
+	for (uint8_t i = 0; i < length; i++) {
+		hash = (hash ^ payload[i]) * 16777619u;
+	}
+	return digest + hash;
+}
+#endif
+
+nodeId_t getNodeId(void)
+{
+	nodeId_t result;
 #if defined(MY_GATEWAY_FEATURE)
 	result = GATEWAY_ADDRESS;
 #elif defined(MY_SENSOR_NETWORK)
@@ -269,9 +459,9 @@ uint8_t getNodeId(void)
 	return result;
 }
 
-uint8_t getParentNodeId(void)
+nodeId_t getParentNodeId(void)
 {
-	uint8_t result;
+	nodeId_t result;
 #if defined(MY_GATEWAY_FEATURE)
 	result = VALUE_NOT_DEFINED;	// GW doesn't have a parent
 #elif defined(MY_SENSOR_NETWORK)
@@ -306,6 +496,12 @@ bool _sendRoute(MyMessage &message)
 #if defined(MY_CORE_ONLY)
 	(void)message;
 #endif
+#if defined(MY_PRESENTATION_DIGEST)
+	if (_presentationDigesting) {
+		_presentationDigest = presentationDigestAdd(_presentationDigest, message);
+		return true;
+	}
+#endif
 #if defined(MY_GATEWAY_FEATURE)
 	if (message.destination == getNodeId()) {
 		// This is a message sent from a sensor attached on the gateway node.
@@ -338,6 +534,173 @@ bool send(MyMessage &message, const bool echo)
 #endif
 }
 
+#if !defined(MY_GATEWAY_FEATURE)
+// transmit the readings of msgs[first] to msgs[last - 1] collected in batch
+static bool _sendBatchRecords(MyMessage &batch, uint8_t length, MyMessage *msgs,
+                             const uint8_t first, const uint8_t last)
+{
+	if (first == last) {
+		return true;
+	}
+	if (last - first == 1) {
+		// no gain from batching a single reading
+		return send(msgs[first]);
+	}
+	(void)build(batch, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_BATCH);
+	mSetLength(batch, length);
+	mSetPayloadType(batch, P_CUSTOM);
+#if defined(MY_REGISTRATION_FEATURE) && !defined(MY_GATEWAY_FEATURE)
+	if (!_coreConfig.nodeRegistered) {
+		CORE_DEBUG(PSTR("!MCO:SND:NODE NOT REG\n"));	// node not registered
+		return false;
+	}
+#endif
+	return _sendRoute(batch);
+}
+#endif
+
+bool sendBatch(MyMessage *msgs, const uint8_t count)
+{
+#if defined(MY_GATEWAY_FEATURE)
+	// readings of the gateway node go straight to the controller
+	bool result = true;
+	for (uint8_t i = 0; i < count; i++) {
+		result &= send(msgs[i]);
+	}
+	return result;
+#else
+	MyMessage batch;
+	bool result = true;
+	uint8_t length = 0;
+	uint8_t first = 0;
+	for (uint8_t i = 0; i < count; i++) {
+		MyMessage &msg = msgs[i];
+		const uint8_t recordLength = mGetLength(msg);
+		if (msg.destination != GATEWAY_ADDRESS ||
+		        recordLength + BATCH_RECORD_HEADER_SIZE > MAX_PAYLOAD) {
+			// cannot be batched, send the pending readings first to keep the order
+			result &= _sendBatchRecords(batch, length, msgs, first, i);
+			result &= send(msg);
+			length = 0;
+			first = i + 1;
+			continue;
+		}
+		if (length + BATCH_RECORD_HEADER_SIZE + recordLength > MAX_PAYLOAD) {
+			// batch is full
+			result &= _sendBatchRecords(batch, length, msgs, first, i);
+			length = 0;
+			first = i;
+		}
+		batch.data[length++] = msg.sensor;
+		batch.data[length++] = msg.type;
+		batch.data[length++] = (mGetPayloadType(msg) << 5) | recordLength;
+		(void)memcpy(&batch.data[length], msg.data, recordLength);
+		length += recordLength;
+	}
+	result &= _sendBatchRecords(batch, length, msgs, first, count);
+	return result;
+#endif
+}
+
+#if defined(MY_SEND_DEADBAND)
+typedef struct {
+	uint8_t sensor;
+	uint8_t type;
+	float value;		// last value sent
+	uint32_t sentMS;	// _sendDeadbandNow() when it was sent
+} sendDeadband_t;
+
+static sendDeadband_t _sendDeadband[MY_SEND_DEADBAND_SLOTS];
+static uint8_t _sendDeadbandCount = 0;
+static uint32_t _sendDeadbandSleptMS = 0;	// hwMillis() stands still while sleeping
+
+static uint32_t _sendDeadbandNow(void)
+{
+	return hwMillis() + _sendDeadbandSleptMS;
+}
+
+static bool _sendOnChange(MyMessage &msg, const float value, const float deadband,
+                          const bool relative)
+{
+	const uint32_t now = _sendDeadbandNow();
+	sendDeadband_t *entry = NULL;
+	for (uint8_t i = 0; i < _sendDeadbandCount; i++) {
+		if (_sendDeadband[i].sensor == msg.sensor && _sendDeadband[i].type == msg.type) {
+			entry = &_sendDeadband[i];
+			break;
+		}
+	}
+	if (entry != NULL) {
+		const float band = relative ? deadband * fabs(entry->value) : deadband;
+		if (fabs(value - entry->value) <= band &&
+		        (uint32_t)(now - entry->sentMS) < MY_SEND_DEADBAND_MAX_SILENCE_MS) {
+			return true;
+		}
+	}
+	if (!send(msg)) {
+		// keep the last value that arrived, the next reading is compared to it
+		return false;
+	}
+	if (entry == NULL) {
+		if (_sendDeadbandCount >= MY_SEND_DEADBAND_SLOTS) {
+			CORE_DEBUG(PSTR("!MCO:SOC:FULL,S=%" PRIu8 ",T=%" PRIu8 "\n"), msg.sensor, msg.type);
+			return true;
+		}
+		entry = &_sendDeadband[_sendDeadbandCount++];
+		entry->sensor = msg.sensor;
+		entry->type = msg.type;
+	}
+	entry->value = value;
+	entry->sentMS = now;
+	return true;
+}
+
+bool sendOnChange(MyMessage &msg, const float value, const uint8_t decimals, const float deadband,
+                  const bool relative)
+{
+	return _sendOnChange(msg.set(value, decimals), value, deadband, relative);
+}
+
+bool sendOnChange(MyMessage &msg, const int32_t value, const int32_t deadband)
+{
+	return _sendOnChange(msg.set(value), (float)value, (float)deadband, false);
+}
+#endif
+
+#if defined(MY_TRANSPORT_FRAGMENTATION)
+bool sendFragmented(const nodeId_t destination, const uint8_t sensor, const uint8_t type,
+                    const void *data, const uint16_t length)
+{
+	static uint8_t id = 0;
+	if (length > MY_TRANSPORT_FRAGMENT_MAX_LENGTH) {
+		return false;
+	}
+	const uint8_t *block = (const uint8_t *)data;
+	id++;
+	uint16_t offset = 0;
+	uint8_t index = 0;
+	do {
+		const uint8_t dataLength = (uint8_t)min((uint16_t)(length - offset), (uint16_t)FRAGMENT_DATA_SIZE);
+		uint8_t *payload = (uint8_t *)_msgTmp.data;
+		(void)build(_msgTmp, destination, sensor, C_INTERNAL, I_FRAGMENT);
+		mSetSigned(_msgTmp, false);
+		payload[0] = id;
+		payload[1] = index | (offset + dataLength == length ? FRAGMENT_LAST : 0);
+		payload[2] = type;
+		(void)memcpy((void *)&payload[FRAGMENT_HEADER_SIZE], (const void *)&block[offset], dataLength);
+		mSetLength(_msgTmp, FRAGMENT_HEADER_SIZE + dataLength);
+		mSetPayloadType(_msgTmp, P_CUSTOM);
+		if (!_sendRoute(_msgTmp)) {
+			// the receiver drops the incomplete block after MY_TRANSPORT_FRAGMENT_TIMEOUT_MS
+			return false;
+		}
+		offset += dataLength;
+		index++;
+	} while (offset < length);
+	return true;
+}
+#endif
+
 bool sendBatteryLevel(const uint8_t value, const bool echo)
 {
 	return _sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_BATTERY_LEVEL,
@@ -411,7 +774,7 @@ bool sendSketchInfo(const __FlashStringHelper *name, const __FlashStringHelper *
 }
 #endif
 
-bool request(const uint8_t childSensorId, const uint8_t variableType, const uint8_t destination)
+bool request(const uint8_t childSensorId, const uint8_t variableType, const nodeId_t destination)
 {
 	return _sendRoute(build(_msgTmp, destination, childSensorId, C_REQ, variableType).set(""));
 }
@@ -422,6 +785,15 @@ bool requestTime(const bool echo)
 	                        echo).set(""));
 }
 
+#if defined(MY_ENERGY_ACCOUNTING)
+static bool _sendEnergyReport(void)
+{
+	const energyReport_t report = energyGet();
+	return _sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+	                        I_ENERGY).set(&report, sizeof(report)));
+}
+#endif
+
 // Message delivered through _msg
 bool _processInternalCoreMessage(void)
 {
@@ -438,6 +810,9 @@ bool _processInternalCoreMessage(void)
 			_coreConfig.nodeRegistered = _msg.getBool();
 			setIndication(INDICATION_GOT_REGISTRATION);
 			CORE_DEBUG(PSTR("MCO:PIM:NODE REG=%" PRIu8 "\n"), _coreConfig.nodeRegistered);	// node registration
+#if defined(MY_REGISTRATION_CACHE)
+			_registrationCacheStore();
+#endif
 #endif
 		} else if (type == I_CONFIG) {
 			// Pick up configuration from controller (currently only metric/imperial) and store it in eeprom if changed
@@ -448,6 +823,8 @@ bool _processInternalCoreMessage(void)
 		} else if (type == I_PRESENTATION) {
 			// Re-send node presentation to controller
 			presentNode();
+		} else if (type == I_PRESENTATION_DIGEST) {
+			// reply to the digest, picked up by _presentationDigestKnown()
 		} else if (type == I_HEARTBEAT_REQUEST) {
 			(void)sendHeartbeat();
 		} else if (_msg.type == I_VERSION) {
@@ -469,6 +846,43 @@ bool _processInternalCoreMessage(void)
 				(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_CHILDREN).set("OK"));
 #endif
 			}
+		} else if (type == I_STATS) {
+#if defined(MY_STATS_FEATURE)
+			// one reply per counter with the counter index as sensor id, 255 requests all counters
+			const bool all = _msg.sensor >= STATS_COUNTERS;
+			const bool reset = _msg.data[0] == 'R';
+			const uint8_t first = all ? 0u : _msg.sensor;
+			const uint8_t end = all ? (uint8_t)STATS_COUNTERS : (uint8_t)(first + 1u);
+			for (uint8_t i = first; i < end; i++) {
+				(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, i, C_INTERNAL, I_STATS).set(statsGet(i)));
+			}
+			if (reset) {
+				statsReset();
+			}
+#endif
+		} else if (type == I_PROFILING) {
+#if defined(MY_PROFILING)
+			// one reply per probe with the probe index as sensor id, 255 requests all probes
+			const bool all = _msg.sensor >= PROFILING_PROBES;
+			const bool reset = _msg.data[0] == 'R';
+			const uint8_t first = all ? 0u : _msg.sensor;
+			const uint8_t end = all ? (uint8_t)PROFILING_PROBES : (uint8_t)(first + 1u);
+			for (uint8_t i = first; i < end; i++) {
+				const profilingProbe_t probe = profilingGet(i);
+				(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, i, C_INTERNAL, I_PROFILING).set(&probe,
+				                 sizeof(probe)));
+			}
+			if (reset) {
+				profilingReset();
+			}
+#endif
+		} else if (type == I_ENERGY) {
+#if defined(MY_ENERGY_ACCOUNTING)
+			const bool reset = _msg.data[0] == 'R';
+			if (_sendEnergyReport() && reset) {
+				energyReset();
+			}
+#endif
 		} else if (type == I_DEBUG) {
 #if defined(MY_SPECIAL_DEBUG)
 			const char debug_msg = _msg.data[0];
@@ -522,6 +936,13 @@ bool _processInternalCoreMessage(void)
 			return false;	// processing of this request via controller
 #endif
 #endif
+		} else if (type == I_PRE_SLEEP_NOTIFICATION) {
+#if defined(MY_GATEWAY_FEATURE) && defined(MY_SMART_SLEEP_GATEWAY_RELEASE) && !defined(MY_GATEWAY_MAILBOX)
+			// nothing is buffered for sleeping nodes, release the node right away
+			(void)_sendRoute(build(_msgTmp, _msg.sender, NODE_SENSOR_ID, C_INTERNAL,
+			                       I_PRE_SLEEP_NOTIFICATION).set((uint8_t)0));
+#endif
+			return false;	// notify controller
 		} else {
 			return false; // further processing required
 		}
@@ -551,7 +972,9 @@ void wait(const uint32_t waitingMS)
 	const uint32_t enteringMS = hwMillis();
 	while (hwMillis() - enteringMS < waitingMS) {
 		_process();
+		_waitIdle(enteringMS, waitingMS);
 	}
+	ENERGY_WAIT(enteringMS);
 #if defined(MY_DEBUG_VERBOSE_CORE)
 	waitLock--;
 #endif
@@ -572,7 +995,11 @@ bool wait(const uint32_t waitingMS, const uint8_t cmd)
 	while ((hwMillis() - enteringMS < waitingMS) && !expectedResponse) {
 		_process();
 		expectedResponse = (mGetCommand(_msg) == cmd);
+		if (!expectedResponse) {
+			_waitIdle(enteringMS, waitingMS);
+		}
 	}
+	ENERGY_WAIT(enteringMS);
 #if defined(MY_DEBUG_VERBOSE_CORE)
 	waitLock--;
 #endif
@@ -594,13 +1021,37 @@ bool wait(const uint32_t waitingMS, const uint8_t cmd, const uint8_t msgType)
 	while ( (hwMillis() - enteringMS < waitingMS) && !expectedResponse ) {
 		_process();
 		expectedResponse = (mGetCommand(_msg) == cmd && _msg.type == msgType);
+		if (!expectedResponse) {
+			_waitIdle(enteringMS, waitingMS);
+		}
 	}
+	ENERGY_WAIT(enteringMS);
 #if defined(MY_DEBUG_VERBOSE_CORE)
 	waitLock--;
 #endif
 	return expectedResponse;
 }
 
+void _waitIdle(const uint32_t enteringMS, const uint32_t waitingMS)
+{
+#if defined(MY_WAIT_IDLE)
+	const uint32_t elapsedMS = hwMillis() - enteringMS;
+	if (elapsedMS >= waitingMS) {
+		return;
+	}
+#if defined(MY_SENSOR_NETWORK)
+	if (transportHALDataAvailable()) {
+		// frames to process
+		return;
+	}
+#endif
+	hwIdle(waitingMS - elapsedMS);
+#else
+	(void)enteringMS;
+	(void)waitingMS;
+#endif
+}
+
 void doYield(void)
 {
 	hwWatchdogReset();
@@ -610,6 +1061,54 @@ void doYield(void)
 #endif
 }
 
+#if defined(TRANSPORT_HAL_LISTEN_INTERRUPT)
+static int8_t _sleepListen(const uint32_t sleepingMS, const uint8_t interrupt1,
+                           const uint8_t mode1)
+{
+	uint32_t remainingMS = sleepingMS;
+	int8_t result;
+	while (true) {
+		if (interrupt1 != INTERRUPT_NOT_DEFINED) {
+			result = hwSleep(interrupt1, mode1, TRANSPORT_HAL_LISTEN_INTERRUPT, RISING, remainingMS);
+		} else {
+			result = hwSleep(TRANSPORT_HAL_LISTEN_INTERRUPT, RISING, remainingMS);
+		}
+		if (result != (int8_t)TRANSPORT_HAL_LISTEN_INTERRUPT) {
+			// woken by the timer, the other interrupt or sleeping not possible
+			return result;
+		}
+		if (sleepingMS) {
+			remainingMS = hwGetSleepRemaining();
+			if (!remainingMS) {
+				return MY_WAKE_UP_BY_TIMER;
+			}
+		}
+		CORE_DEBUG(PSTR("MCO:SLP:LSN,MS=%" PRIu32 "\n"), remainingMS);
+#if defined(MY_ENERGY_ACCOUNTING)
+		(void)energyWakeUp();
+#endif
+		// the radio holds the frame, process it and what follows
+		transportReInitialise();
+		const uint32_t listenStartMS = hwMillis();
+		do {
+			resetMessageReceived();
+			wait(MY_WAKE_ON_RADIO_LISTEN_MS);
+		} while (isMessageReceived());
+		if (sleepingMS) {
+			const uint32_t listenedMS = hwMillis() - listenStartMS;
+			if (remainingMS <= listenedMS) {
+				return MY_WAKE_UP_BY_TIMER;
+			}
+			remainingMS -= listenedMS;
+		}
+		transportDisable();
+#if defined(MY_ENERGY_ACCOUNTING)
+		energySleep();
+#endif
+	}
+}
+#endif
+
 int8_t _sleep(const uint32_t sleepingMS, const bool smartSleep, const uint8_t interrupt1,
               const uint8_t mode1, const uint8_t interrupt2, const uint8_t mode2)
 {
@@ -619,6 +1118,9 @@ int8_t _sleep(const uint32_t sleepingMS, const bool smartSleep, const uint8_t in
 	// repeater feature: sleeping not possible
 #if defined(MY_REPEATER_FEATURE)
 	(void)smartSleep;
+#if defined(MY_REPEATER_WAKE_ON_RADIO)
+	return _sleepWakeOnRadio(sleepingMS, interrupt1, mode1, interrupt2, mode2);
+#else
 	(void)interrupt1;
 	(void)mode1;
 	(void)interrupt2;
@@ -627,6 +1129,7 @@ int8_t _sleep(const uint32_t sleepingMS, const bool smartSleep, const uint8_t in
 	CORE_DEBUG(PSTR("!MCO:SLP:REP\n"));	// sleeping not possible, repeater feature enabled
 	wait(sleepingMS);
 	return MY_SLEEP_NOT_POSSIBLE;
+#endif
 #else
 	uint32_t sleepingTimeMS = sleepingMS;
 #if defined(MY_SENSOR_NETWORK)
@@ -667,7 +1170,17 @@ int8_t _sleep(const uint32_t sleepingMS, const bool smartSleep, const uint8_t in
 		// notify controller about going to sleep, payload indicates smartsleep waiting time in MS
 		(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
 		                       I_PRE_SLEEP_NOTIFICATION).set((uint32_t)MY_SMART_SLEEP_WAIT_DURATION_MS));
-		wait(MY_SMART_SLEEP_WAIT_DURATION_MS);		// listen for incoming messages
+		// listen for incoming messages, the controller ends the window early with an
+		// I_PRE_SLEEP_NOTIFICATION once all messages buffered for this node are sent
+#if defined(MY_ENERGY_ACCOUNTING)
+		energyWindow(true);
+#endif
+		if (wait(MY_SMART_SLEEP_WAIT_DURATION_MS, C_INTERNAL, I_PRE_SLEEP_NOTIFICATION)) {
+			CORE_DEBUG(PSTR("MCO:SLP:REL\n"));	// released by controller
+		}
+#if defined(MY_ENERGY_ACCOUNTING)
+		energyWindow(false);
+#endif
 #if defined(MY_OTA_FIRMWARE_FEATURE)
 		// check if during smart sleep waiting period a FOTA request was received
 		if (isFirmwareUpdateOngoing()) {
@@ -680,19 +1193,47 @@ int8_t _sleep(const uint32_t sleepingMS, const bool smartSleep, const uint8_t in
 	(void)smartSleep;
 #endif // MY_SENSOR_NETWORK
 
+#if defined(TRANSPORT_HAL_LISTEN_INTERRUPT)
+	// the parent resends unacknowledged frames with a preamble spanning the listen cycle
+	(void)_sendRoute(build(_msgTmp, BROADCAST_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+	                       I_WAKE_ON_RADIO).set((uint32_t)TRANSPORT_HAL_LISTEN_CYCLE_MS));
+#endif
 #if defined(MY_SENSOR_NETWORK)
 	transportDisable();
 #endif
 	setIndication(INDICATION_SLEEP);
+	// commit deferred config writes before power is reduced
+	hwFlushConfig();
+#if defined(MY_DEBUG_TRACE)
+	// the serial device stops while sleeping
+	hwDebugTraceFlush(true);
+#endif
 
 #if defined (MY_DEFAULT_TX_LED_PIN) || defined(MY_DEFAULT_RX_LED_PIN) || defined(MY_DEFAULT_ERR_LED_PIN)
+#if defined(LEDS_TIMER)
+	// no need to stay awake for the blinking, the timer finishes it after wake-up
+	ledsSleep();
+#else
 	// Wait until leds finish their blinking pattern
 	while (ledsBlinking()) {
 		doYield();
 	}
 #endif
+#endif
 
+#if defined(MY_ENERGY_ACCOUNTING)
+	energySleep();
+#endif
 	int8_t result = MY_SLEEP_NOT_POSSIBLE;	// default
+#if defined(TRANSPORT_HAL_LISTEN_INTERRUPT)
+	if (interrupt2 == INTERRUPT_NOT_DEFINED) {
+		// the radio IRQ takes the free interrupt
+		result = _sleepListen(sleepingTimeMS, interrupt1, mode1);
+	} else {
+		CORE_DEBUG(PSTR("!MCO:SLP:LSN\n"));	// no free interrupt for the radio
+		result = hwSleep(interrupt1, mode1, interrupt2, mode2, sleepingTimeMS);
+	}
+#else
 	if (interrupt1 != INTERRUPT_NOT_DEFINED && interrupt2 != INTERRUPT_NOT_DEFINED) {
 		// both IRQs
 		result = hwSleep(interrupt1, mode1, interrupt2, mode2, sleepingTimeMS);
@@ -703,10 +1244,26 @@ int8_t _sleep(const uint32_t sleepingMS, const bool smartSleep, const uint8_t in
 		// no IRQ
 		result = hwSleep(sleepingTimeMS);
 	}
+#endif
+#if defined(MY_ENERGY_ACCOUNTING)
+	const bool energyDue = energyWakeUp();
+#endif
+#if defined(MY_SEND_DEADBAND) && !defined(__linux__)
+	if (result != MY_SLEEP_NOT_POSSIBLE) {
+		// Linux sleeps by waiting, the other architectures stop hwMillis()
+		const uint32_t remainingMS = hwGetSleepRemaining();
+		_sendDeadbandSleptMS += sleepingTimeMS > remainingMS ? sleepingTimeMS - remainingMS : 0;
+	}
+#endif
 	setIndication(INDICATION_WAKEUP);
 	CORE_DEBUG(PSTR("MCO:SLP:WUP=%" PRIi8 "\n"), result);	// sleep wake-up
 #if defined(MY_SENSOR_NETWORK)
 	transportReInitialise();
+#endif
+#if defined(MY_ENERGY_ACCOUNTING)
+	if (energyDue && _sendEnergyReport()) {
+		energyReset();
+	}
 #endif
 	if (smartSleep) {
 		// notify controller about waking up, payload indicates sleeping time in MS
@@ -717,6 +1274,70 @@ int8_t _sleep(const uint32_t sleepingMS, const bool smartSleep, const uint8_t in
 #endif
 }
 
+#if defined(MY_REPEATER_WAKE_ON_RADIO)
+int8_t _sleepWakeOnRadio(const uint32_t sleepingMS, const uint8_t interrupt1, const uint8_t mode1,
+                         const uint8_t interrupt2, const uint8_t mode2)
+{
+	CORE_DEBUG(PSTR("MCO:SLP:WOR,MS=%" PRIu32 "\n"), sleepingMS);
+	if (isTransportReady()) {
+		// neighbours repeat unacknowledged frames for one cycle
+		(void)_sendRoute(build(_msgTmp, BROADCAST_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+		                       I_WAKE_ON_RADIO).set((uint32_t)(MY_WAKE_ON_RADIO_PERIOD_MS +
+		                               MY_WAKE_ON_RADIO_LISTEN_MS)));
+	}
+	hwFlushConfig();
+	uint32_t remainingMS = sleepingMS;
+	int8_t result = MY_WAKE_UP_BY_TIMER;
+	do {
+		uint32_t periodMS = MY_WAKE_ON_RADIO_PERIOD_MS;
+		if (sleepingMS && remainingMS < periodMS) {
+			periodMS = remainingMS;
+		}
+		transportDisable();
+		setIndication(INDICATION_SLEEP);
+#if defined(MY_ENERGY_ACCOUNTING)
+		energySleep();
+#endif
+		if (interrupt1 != INTERRUPT_NOT_DEFINED && interrupt2 != INTERRUPT_NOT_DEFINED) {
+			result = hwSleep(interrupt1, mode1, interrupt2, mode2, periodMS);
+		} else if (interrupt1 != INTERRUPT_NOT_DEFINED) {
+			result = hwSleep(interrupt1, mode1, periodMS);
+		} else {
+			result = hwSleep(periodMS);
+		}
+#if defined(MY_ENERGY_ACCOUNTING)
+		const bool energyDue = energyWakeUp();
+#endif
+		setIndication(INDICATION_WAKEUP);
+		transportReInitialise();
+#if defined(MY_ENERGY_ACCOUNTING)
+		if (energyDue && _sendEnergyReport()) {
+			energyReset();
+		}
+#endif
+		if (result != MY_WAKE_UP_BY_TIMER) {
+			// woken by an interrupt or sleeping not possible
+			break;
+		}
+		if (sleepingMS) {
+			remainingMS -= periodMS;
+		}
+		// listen window, extended as long as frames arrive
+		const uint32_t listenStartMS = hwMillis();
+		do {
+			resetMessageReceived();
+			wait(MY_WAKE_ON_RADIO_LISTEN_MS);
+		} while (isMessageReceived());
+		if (sleepingMS) {
+			const uint32_t listenedMS = hwMillis() - listenStartMS;
+			remainingMS = remainingMS > listenedMS ? remainingMS - listenedMS : 0;
+		}
+	} while (!sleepingMS || remainingMS);
+	CORE_DEBUG(PSTR("MCO:SLP:WUP=%" PRIi8 "\n"), result);	// sleep wake-up
+	return result;
+}
+#endif
+
 // sleep functions
 int8_t sleep(const uint32_t sleepingMS, const bool smartSleep)
 {
@@ -760,6 +1381,13 @@ uint32_t getSleepRemaining(void)
 	return hwGetSleepRemaining();
 }
 
+#if defined(MY_CORE_PROCESS_STATS)
+coreProcessStats_t coreGetProcessStats(void)
+{
+	return _coreProcessStats;
+}
+#endif
+
 
 void _nodeLock(const char *str)
 {
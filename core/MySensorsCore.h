@@ -32,6 +32,8 @@
 *  - MCO:<b>BGN</b>	from @ref _begin()
 *  - MCO:<b>REG</b>	from @ref _registerNode()
 *  - MCO:<b>SND</b>	from @ref send()
+*  - MCO:<b>SOC</b>	from @ref sendOnChange()
+*  - MCO:<b>PRD</b>	from the presentation digest at boot (@ref MY_PRESENTATION_DIGEST)
 *  - MCO:<b>PIM</b>	from @ref _processInternalCoreMessage()
 *  - MCO:<b>NLK</b>	from @ref _nodeLock()
 *
@@ -41,6 +43,7 @@
 * |-|-----|-----|---------------------------------------------|-----------------------------------------------------------------------------------------------------------------
 * |!| MCO | BGN | HW ERR																			| Error HW initialization (e.g. ext. EEPROM)
 * | | MCO | BGN | INIT %%s,CP=%%s,FQ=%%d,REL=%%d,VER=%%s			| Core initialization, capabilities (CP), CPU frequency [Mhz] (FQ), release number (REL), library version (VER)
+* | | MCO | BGN | SHB=%%d,DBG=%%d,SGN=%%d,GWP=%%d									| Shared buffers (@ref MY_SHARED_BUFFERS): arena size (SHB), buffers it replaces for debug (DBG), soft signing (SGN) and the GW protocol (GWP) [bytes]
 * | | MCO | BGN | BFR																					| Callback before()
 * | | MCO | BGN | STP																					| Callback setup()
 * | | MCO | BGN | INIT OK,TSP=%%d															| Core initialised, transport status (TSP): 0=not initialised, 1=initialised, NA=not available
@@ -49,13 +52,19 @@
 * | | MCO | REG | REQ																					| Registration request
 * | | MCO | REG | NOT NEEDED																	| No registration needed (i.e. GW)
 * |!| MCO | SND | NODE NOT REG																| Node is not registered, cannot send message
+* |!| MCO | SOC | FULL,S=%%d,T=%%d															| No free slot to keep the last value of child sensor (S) type (T), its readings are always sent (@ref MY_SEND_DEADBAND_SLOTS)
+* | | MCO | PRD | D=%%08X,KNOWN=%%d														| Presentation digest (D) sent, known to the GW (KNOWN), the presentation is skipped if so (@ref MY_PRESENTATION_DIGEST)
 * | | MCO | PIM | NODE REG=%%d																| Registration response received, registration status (REG)
 * |!| MCO | WAI | RC=%%d																			| Recursive call detected in wait(), level (RC)
 * | | MCO | SLP | MS=%%lu,SMS=%%d,I1=%%d,M1=%%d,I2=%%d,M2=%%d	| Sleep node, time (MS), smartSleep (SMS), Int1 (I1), Mode1 (M1), Int2 (I2), Mode2 (M2)
 * | | MCO | SLP | WUP=%%d																			| Node woke-up, reason/IRQ (WUP)
 * |!| MCO | SLP | NTL																					| Sleeping not possible, no time left
+* | | MCO | SLP | REL																					| Smart sleep listen window ended early, no more messages buffered for this node
 * |!| MCO | SLP | FWUPD																				| Sleeping not possible, FW update ongoing
 * |!| MCO | SLP | REP																					| Sleeping not possible, repeater feature enabled
+* | | MCO | SLP | WOR,MS=%%lu																		| Repeater sleeps with duty-cycled receiver (@ref MY_REPEATER_WAKE_ON_RADIO), time left (MS)
+* | | MCO | SLP | LSN,MS=%%lu																		| Frame received in listen mode (@ref MY_RFM69_ENABLE_LISTENMODE), sleeping on, time left (MS)
+* |!| MCO | SLP | LSN																					| No free interrupt, the radio listens without waking the node (@ref MY_RFM69_ENABLE_LISTENMODE)
 * |!| MCO | SLP | TNR																					| Transport not ready, attempt to reconnect until timeout (@ref MY_SLEEP_TRANSPORT_RECONNECT_TIMEOUT_MS)
 * | | MCO | NLK | NODE LOCKED. UNLOCK: GND PIN %%d AND RESET	| Node locked during booting, see signing chapter for additional information
 * | | MCO | NLK | TSL																					| Set transport to sleep
@@ -106,24 +115,56 @@ typedef struct {
 	uint8_t reserved : 6;					//!< reserved
 } coreConfig_t;
 
+#if defined(MY_CORE_PROCESS_STATS)
+/**
+* @brief Time accounting of the main process, see coreGetProcessStats()
+*
+* Times are in us and wrap around after about 71 minutes, use the difference between two reads.
+*/
+typedef struct {
+	uint32_t iterations;					//!< Number of loop iterations
+	uint32_t radioUs;						//!< Time spent on received radio messages
+	uint32_t radioMaxUs;					//!< Longest time spent on radio messages in one iteration
+	uint32_t controllerUs;					//!< Time spent on messages from the controller
+	uint32_t controllerMaxUs;				//!< Longest time spent on controller messages in one iteration
+} coreProcessStats_t;
+#endif
+
 
 // **** public functions ********
 
 /**
  * Return this nodes id.
  */
-uint8_t getNodeId(void);
+nodeId_t getNodeId(void);
 
 /**
  * Return the parent node id.
  */
-uint8_t getParentNodeId(void);
+nodeId_t getParentNodeId(void);
 
 /**
 * Sends node information to the gateway.
 */
 void presentNode(void);
 
+#if defined(MY_PRESENTATION_DIGEST) || defined(MY_GATEWAY_PRESENTATION_CACHE)
+#define PRESENTATION_DIGEST_UNKNOWN		(0u)	//!< Digest reply: the node presents itself in full
+#define PRESENTATION_DIGEST_KNOWN		(1u)	//!< Digest reply: presentation and signing requirements unchanged
+#define PRESENTATION_DIGEST_KNOWN_LEGACY	(2u)	//!< Digest reply: presentation unchanged, digest without signing requirements
+
+/**
+ * @brief Add a message to the digest of a presentation
+ *
+ * Only presentations, sketch info and signing presentations count, other messages leave the
+ * digest as it is. The result does not depend on the order the messages are added in.
+ * @param digest Digest so far, 0 for none
+ * @param message Message sent or received
+ * @return New digest
+ */
+uint32_t presentationDigestAdd(const uint32_t digest, const MyMessage &message);
+#endif
+
 /**
  * Each node must present all attached sensors before any values can be handled correctly by the controller.
  * It is usually good to present all attached sensors after power-up in setup().
@@ -172,6 +213,67 @@ bool sendSketchInfo(const __FlashStringHelper *name, const __FlashStringHelper *
  */
 bool send(MyMessage &msg, const bool echo = false);
 
+/**
+ * Sends several readings to the gateway, packed into as few messages as possible
+ *
+ * The readings are sent as C_SET messages like send() does. Up to MAX_PAYLOAD bytes of readings
+ * share one I_BATCH message, each reading takes BATCH_RECORD_HEADER_SIZE bytes plus its payload
+ * (e.g. four 16 bit values or three floats). The gateway unpacks them into individual C_SET
+ * messages to the controller. Readings to another destination than the gateway, and a
+ * batch holding a single reading, are sent with send().
+ * @param msgs Array of messages to send
+ * @param count Number of messages in msgs
+ * @return true Returns true if all messages reached the first stop on their way to destination.
+ */
+bool sendBatch(MyMessage *msgs, const uint8_t count);
+
+#if defined(MY_TRANSPORT_FRAGMENTATION) || defined(DOXYGEN)
+/**
+ * Sends a block of data larger than MAX_PAYLOAD, split into I_FRAGMENT messages
+ *
+ * Each message carries FRAGMENT_DATA_SIZE bytes of the block. The destination reassembles them
+ * and hands the block to receiveFragmented(), it needs @ref MY_TRANSPORT_FRAGMENTATION as well.
+ * A gateway does not forward the block to the controller.
+ * @param destination Node to send the block to
+ * @param sensor Child sensor id
+ * @param type Type of the data, passed on to receiveFragmented()
+ * @param data The block
+ * @param length Length of the block, at most @ref MY_TRANSPORT_FRAGMENT_MAX_LENGTH
+ * @return true Returns true if all messages reached the first stop on their way to destination.
+ */
+bool sendFragmented(const nodeId_t destination, const uint8_t sensor, const uint8_t type,
+                    const void *data, const uint16_t length);
+#endif
+
+#if defined(MY_SEND_DEADBAND) || defined(DOXYGEN)
+/**
+ * Sends a reading only if it left the deadband around the last value sent, see @ref MY_SEND_DEADBAND
+ *
+ * The last value is kept per child sensor and type of msg. The first reading, a reading that
+ * differs by more than the deadband and the first reading after
+ * @ref MY_SEND_DEADBAND_MAX_SILENCE_MS are sent with send(). A failed send is retried by the
+ * next call.
+ * @param msg Message to send, its payload is set to value
+ * @param value Reading
+ * @param decimals Number of decimals sent
+ * @param deadband Largest change not reported
+ * @param relative If true, deadband is a fraction of the last value sent (e.g. 0.05 for 5%)
+ * @return true Returns true if the reading was not due or reached the first stop on its way to destination.
+ */
+bool sendOnChange(MyMessage &msg, const float value, const uint8_t decimals, const float deadband,
+                  const bool relative = false);
+/**
+ * Sends an integer reading only if it left the deadband around the last value sent
+ *
+ * Like sendOnChange() for floats, with an absolute deadband.
+ * @param msg Message to send, its payload is set to value
+ * @param value Reading
+ * @param deadband Largest change not reported
+ * @return true Returns true if the reading was not due or reached the first stop on its way to destination.
+ */
+bool sendOnChange(MyMessage &msg, const int32_t value, const int32_t deadband);
+#endif
+
 /**
  * Send this nodes battery level to gateway.
  * @param level Level between 0-100(%)
@@ -226,10 +328,14 @@ bool sendTXPowerLevel(const uint8_t level, const bool echo = false);
 * @return true Returns true if message reached the first stop on its way to destination.
 */
 bool request(const uint8_t childSensorId, const uint8_t variableType,
-             const uint8_t destination = GATEWAY_ADDRESS);
+             const nodeId_t destination = GATEWAY_ADDRESS);
 
 /**
  * Requests time from controller. Answer will be delivered to receiveTime function in sketch.
+ *
+ * A gateway with @ref MY_GATEWAY_TIME_BEACON answers from its cached controller time and
+ * broadcasts the time regularly, the broadcast is delivered to receiveTime as well. Nodes that
+ * heard a beacon recently do not need to request the time.
  * @param echo Set this to true if you want destination node to echo the message back to this node.
  * Default is not to request echo. If set to true, the final destination will echo back the
  * contents of the message, triggering the receive() function on the original node with a copy of
@@ -388,6 +494,30 @@ int8_t _sleep(const uint32_t sleepingMS, const bool smartSleep = false,
               const uint8_t interrupt1 = INTERRUPT_NOT_DEFINED, const uint8_t mode1 = MODE_NOT_DEFINED,
               const uint8_t interrupt2 = INTERRUPT_NOT_DEFINED, const uint8_t mode2 = MODE_NOT_DEFINED);
 
+#if defined(MY_REPEATER_WAKE_ON_RADIO)
+/**
+* Sleep of a repeater, see @ref MY_REPEATER_WAKE_ON_RADIO. The radio is powered down for
+* @ref MY_WAKE_ON_RADIO_PERIOD_MS and listens in between, messages are relayed meanwhile.
+* @param sleepingMS Number of milliseconds to sleep or 0 to sleep forever
+* @param interrupt1 First interrupt that should trigger the wakeup
+* @param mode1 Mode for first interrupt (RISING, FALLING, CHANGE)
+* @param interrupt2 Second interrupt that should trigger the wakeup
+* @param mode2 Mode for second interrupt (RISING, FALLING, CHANGE)
+* @return Interrupt number if wake up was triggered by pin change, @ref MY_WAKE_UP_BY_TIMER if wake up was triggered by timer, @ref MY_SLEEP_NOT_POSSIBLE if sleep was not possible
+*/
+int8_t _sleepWakeOnRadio(const uint32_t sleepingMS, const uint8_t interrupt1, const uint8_t mode1,
+                         const uint8_t interrupt2, const uint8_t mode2);
+#endif
+
+#if defined(MY_CORE_PROCESS_STATS)
+/**
+ * Return the time spent on radio and controller messages, see @ref MY_CORE_PROCESS_STATS.
+ * Replies to the controller are sent from within the accounted sections and included there.
+ * @return Process time accounting
+ */
+coreProcessStats_t coreGetProcessStats(void);
+#endif
+
 /**
  * Return the sleep time remaining after waking up from sleep.
  * Depending on the CPU architecture, the remaining time can be seconds off (e.g. upto roughly 8 seconds on AVR).
@@ -430,6 +560,12 @@ void _begin(void);
 */
 void _process(void);
 /**
+* @brief Sleep the CPU until the next interrupt or the end of a wait, see @ref MY_WAIT_IDLE
+* @param enteringMS hwMillis() when the wait started
+* @param waitingMS duration of the wait
+*/
+void _waitIdle(const uint32_t enteringMS, const uint32_t waitingMS);
+/**
 * @brief Processes internal core message
 * @return True if no further processing required
 */
@@ -455,6 +591,11 @@ bool _sendRoute(MyMessage &message);
 */
 void receive(const MyMessage &message)  __attribute__((weak));
 /**
+* @brief Callback for data blocks reassembled from I_FRAGMENT messages, see sendFragmented()
+*/
+void receiveFragmented(const nodeId_t sender, const uint8_t sensor, const uint8_t type,
+                       const uint8_t *data, const uint16_t length) __attribute__((weak));
+/**
 * @brief Callback for incoming time messages
 */
 void receiveTime(uint32_t)  __attribute__((weak));
@@ -481,7 +622,7 @@ void loop(void) __attribute__((weak));
 
 
 // Inline function and macros
-static inline MyMessage& build(MyMessage &msg, const uint8_t destination, const uint8_t sensor,
+static inline MyMessage& build(MyMessage &msg, const nodeId_t destination, const uint8_t sensor,
                                const uint8_t command, const uint8_t type, const bool echo = false)
 {
 	msg.sender = getNodeId();
@@ -0,0 +1,84 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+ * @file MySharedBuffers.h
+ *
+ * @brief Scratch buffers of the core overlaid in one arena, see MY_SHARED_BUFFERS
+ *
+ * Each member is only live within a single call and never across a wait, a yield or a call into
+ * another member's user:
+ * - debugConv: payload to string for a transport debug line, from getString() to the print
+ * - debugHex: hex dump of hwDebugBuf2Str(), from the conversion to the signing/THA debug print
+ * - signing: SHA256 input of the software signing backend, within signerAtsha204AHmac()
+ * - protocol: the gateway's formatted line and payload, from formatting to the write to the
+ *   controller
+ *
+ * The users bind array references of their own size to the members, a member that does not
+ * match fails to compile.
+ */
+
+#ifndef MySharedBuffers_h
+#define MySharedBuffers_h
+
+#if defined(MY_SHARED_BUFFERS)
+
+#include <stdint.h>
+
+#if defined(DEBUG_OUTPUT_ENABLED)
+#define SHARED_BUFFERS_DEBUG_SIZE	(MAX_PAYLOAD * 2 + 1 + 65)	//!< debugConv, debugHex
+#else
+#define SHARED_BUFFERS_DEBUG_SIZE	(0)	//!< no debug output
+#endif
+#if defined(MY_SIGNING_SOFT)
+#define SHARED_BUFFERS_SIGNING_SIZE	(96)	//!< signing
+#else
+#define SHARED_BUFFERS_SIGNING_SIZE	(0)	//!< no software signing
+#endif
+#if defined(MY_GATEWAY_FEATURE)
+#define SHARED_BUFFERS_PROTOCOL_SIZE	(MY_GATEWAY_MAX_SEND_LENGTH + MAX_PAYLOAD * 2 + 1)	//!< protocol
+#else
+#define SHARED_BUFFERS_PROTOCOL_SIZE	(0)	//!< no gateway
+#endif
+
+/**
+ * @brief Arena of the buffers with disjoint lifetimes
+ */
+typedef union {
+#if defined(DEBUG_OUTPUT_ENABLED)
+	char debugConv[MAX_PAYLOAD * 2 + 1];		//!< _convBuf of the transport debug
+	char debugHex[65];							//!< hwDebugPrintStr
+#endif
+#if defined(MY_SIGNING_SOFT)
+	uint8_t signing[96];						//!< SHA256 input of the soft signing HMAC
+#endif
+#if defined(MY_GATEWAY_FEATURE)
+	struct {
+		char fmt[MY_GATEWAY_MAX_SEND_LENGTH];	//!< _fmtBuffer
+		char conv[MAX_PAYLOAD * 2 + 1];			//!< _convBuffer
+	} protocol;									//!< live together while a message is written
+#endif
+	uint8_t none;								//!< nothing to share in this configuration
+} coreSharedBuffers_t;
+
+extern coreSharedBuffers_t _coreSharedBuffers;	//!< defined in MySensorsCore.cpp
+
+#endif
+
+#endif
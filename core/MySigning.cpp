@@ -30,10 +30,13 @@
 #endif
 
 #if defined(MY_SIGNING_REQUEST_SIGNATURES) &&\
-    (!defined(MY_SIGNING_ATSHA204) && !defined(MY_SIGNING_SOFT))
-#error You have to pick either MY_SIGNING_ATSHA204 or MY_SIGNING_SOFT to reqire signatures!
+    (!defined(MY_SIGNING_ATSHA204) && !defined(MY_SIGNING_ATECC) && !defined(MY_SIGNING_SOFT))
+#error You have to pick either MY_SIGNING_ATSHA204, MY_SIGNING_ATECC or MY_SIGNING_SOFT to reqire signatures!
 #endif
-#if defined(MY_SIGNING_SOFT) && defined(MY_SIGNING_ATSHA204)
+#if defined(MY_SIGNING_TAG_SIZE) && (MY_SIGNING_TAG_SIZE < 2 || MY_SIGNING_TAG_SIZE > 32)
+#error MY_SIGNING_TAG_SIZE has to be between 2 and 32
+#endif
+#if (defined(MY_SIGNING_SOFT) + defined(MY_SIGNING_ATSHA204) + defined(MY_SIGNING_ATECC)) > 1
 #error You have to pick one and only one signing backend
 #endif
 #ifdef MY_SIGNING_FEATURE
@@ -51,6 +54,36 @@ static uint8_t nof_failed_verifications = 0;
 // Status when waiting for signing nonce in signerSignMsg
 enum { SIGN_WAITING_FOR_NONCE = 0, SIGN_OK = 1 };
 
+#if defined(MY_SIGNING_NONCE_PREFETCH)
+// State of a nonce fetched in the background
+enum { SIGN_PREFETCH_FREE = 0, SIGN_PREFETCH_DUE, SIGN_PREFETCH_REQUESTED, SIGN_PREFETCH_READY };
+
+typedef struct {
+	uint32_t timestamp;	// hwMillis() when the entry was scheduled or the nonce was requested
+	uint8_t state;		// SIGN_PREFETCH_*
+	uint8_t nodeId;		// Destination the nonce is for
+	uint8_t nonce[32];
+} signerPrefetchEntry_t;
+
+static signerPrefetchEntry_t _signingPrefetch[MY_SIGNING_NONCE_PREFETCH_SIZE];
+#endif
+
+#if defined(MY_SIGNING_ASYNC)
+// State of a message waiting for the nonce of its destination
+enum { SIGN_ASYNC_FREE = 0, SIGN_ASYNC_QUEUED, SIGN_ASYNC_REQUESTED, SIGN_ASYNC_SIGNED };
+
+typedef struct {
+	MyMessage msg;		// Message to sign, the signed message once state is SIGN_ASYNC_SIGNED
+	uint32_t timestamp;	// hwMillis() when the nonce was requested
+	uint8_t state;		// SIGN_ASYNC_*
+	uint8_t seq;		// Queue order, messages to the same destination are signed in this order
+	uint8_t to;			// Next hop the message is written to
+} signerAsyncEntry_t;
+
+static signerAsyncEntry_t _signingAsync[MY_SIGNING_ASYNC_QUEUE_SIZE];
+static uint8_t _signingAsyncSeq = 0;
+#endif
+
 // Macros for manipulating signing requirement tables
 #define DO_SIGN(node) (~_doSign[node>>3]&(1<<node%8))
 #define SET_SIGN(node) (_doSign[node>>3]&=~(1<<node%8))
@@ -69,6 +102,7 @@ extern bool signerAtsha204SoftCheckTimer(void);
 extern bool signerAtsha204SoftGetNonce(MyMessage &msg);
 extern void signerAtsha204SoftPutNonce(MyMessage &msg);
 extern bool signerAtsha204SoftVerifyMsg(MyMessage &msg);
+extern bool signerAtsha204SoftVerifyWithNonce(MyMessage &msg, const uint8_t *nonce);
 extern bool signerAtsha204SoftSignMsg(MyMessage &msg);
 #define signerBackendInit       signerAtsha204SoftInit
 #define signerBackendCheckTimer signerAtsha204SoftCheckTimer
@@ -89,8 +123,32 @@ extern bool signerAtsha204SignMsg(MyMessage &msg);
 #define signerBackendPutNonce   signerAtsha204PutNonce
 #define signerBackendVerifyMsg  signerAtsha204VerifyMsg
 #define signerBackendSignMsg    signerAtsha204SignMsg
+#elif defined(MY_SIGNING_ATECC)
+extern bool signerAteccInit(void);
+extern bool signerAteccCheckTimer(void);
+extern bool signerAteccGetNonce(MyMessage &msg);
+extern void signerAteccPutNonce(MyMessage &msg);
+extern bool signerAteccVerifyMsg(MyMessage &msg);
+extern bool signerAteccSignMsg(MyMessage &msg);
+#define signerBackendInit       signerAteccInit
+#define signerBackendCheckTimer signerAteccCheckTimer
+#define signerBackendGetNonce   signerAteccGetNonce
+#define signerBackendPutNonce   signerAteccPutNonce
+#define signerBackendVerifyMsg  signerAteccVerifyMsg
+#define signerBackendSignMsg    signerAteccSignMsg
 #endif
+static bool isSignException(const MyMessage &msg);
 static bool skipSign(MyMessage &msg);
+#if defined(MY_SIGNING_NONCE_PREFETCH)
+static signerPrefetchEntry_t *signerPrefetchFind(const uint8_t nodeId);
+static void signerPrefetchSchedule(const uint8_t nodeId);
+static void signerPrefetchProcess(void);
+#endif
+#if defined(MY_SIGNING_ASYNC)
+static signerAsyncEntry_t *signerAsyncFind(const uint8_t nodeId, const uint8_t state);
+static bool signerAsyncRequest(signerAsyncEntry_t &entry);
+static void signerAsyncProcess(void);
+#endif
 #else // not MY_SIGNING_FEATURE
 #define signerBackendCheckTimer() true
 #endif // MY_SIGNING_FEATURE
@@ -190,11 +248,96 @@ bool signerProcessInternal(MyMessage &msg)
 
 bool signerCheckTimer(void)
 {
+#if defined(MY_SIGNING_FEATURE) && defined(MY_SIGNING_NONCE_PREFETCH)
+	signerPrefetchProcess();
+#endif
+#if defined(MY_SIGNING_FEATURE) && defined(MY_SIGNING_ASYNC)
+	signerAsyncProcess();
+#endif
 	return signerBackendCheckTimer();
 }
 
+bool signerQueueMsg(const uint8_t to, MyMessage &msg)
+{
+#if defined(MY_SIGNING_FEATURE) && defined(MY_SIGNING_ASYNC)
+	// Only messages that have to wait for a nonce are queued, signerSignMsg() handles the rest
+	if (!DO_SIGN(msg.destination) || msg.sender != getNodeId() || !stateValid ||
+	        isSignException(msg)) {
+		return false;
+	}
+#if defined(MY_SIGNING_NONCE_PREFETCH)
+	signerPrefetchEntry_t *prefetch = signerPrefetchFind(msg.destination);
+	if (prefetch != NULL && prefetch->state == SIGN_PREFETCH_READY) {
+		// Can be signed right away
+		return false;
+	}
+#endif
+	signerAsyncEntry_t *slot = NULL;
+	for (uint8_t i = 0; i < MY_SIGNING_ASYNC_QUEUE_SIZE; i++) {
+		if (_signingAsync[i].state == SIGN_ASYNC_FREE) {
+			slot = &_signingAsync[i];
+			break;
+		}
+	}
+	if (slot == NULL) {
+		SIGN_DEBUG(PSTR("!SGN:SGN:QUEUE FULL\n")); // No room in queue, sign while waiting
+		return false;
+	}
+	slot->msg = msg;
+	slot->to = to;
+	slot->seq = _signingAsyncSeq++;
+	slot->state = SIGN_ASYNC_QUEUED;
+	if (signerAsyncFind(msg.destination, SIGN_ASYNC_QUEUED) == slot &&
+	        signerAsyncFind(msg.destination, SIGN_ASYNC_REQUESTED) == NULL &&
+	        signerAsyncFind(msg.destination, SIGN_ASYNC_SIGNED) == NULL) {
+#if defined(MY_SIGNING_NONCE_PREFETCH)
+		if (prefetch != NULL) {
+			// The nonce is already on its way, wait for it instead of requesting another one
+			slot->state = SIGN_ASYNC_REQUESTED;
+			slot->timestamp = prefetch->timestamp;
+			prefetch->state = SIGN_PREFETCH_FREE;
+		}
+#endif
+		if (slot->state == SIGN_ASYNC_QUEUED && !signerAsyncRequest(*slot)) {
+			return false;
+		}
+	}
+	SIGN_DEBUG(PSTR("SGN:SGN:QUEUED,TO=%" PRIu8 "\n"), msg.destination); // Signed once nonce arrives
+	return true;
+#else
+	(void)to;
+	(void)msg;
+	return false;
+#endif
+}
+
+MyMessage *signerGetSignedMsg(uint8_t *to)
+{
+#if defined(MY_SIGNING_FEATURE) && defined(MY_SIGNING_ASYNC)
+	// Signed messages leave the queue in the order they were queued in
+	signerAsyncEntry_t *oldest = NULL;
+	for (uint8_t i = 0; i < MY_SIGNING_ASYNC_QUEUE_SIZE; i++) {
+		signerAsyncEntry_t *entry = &_signingAsync[i];
+		if (entry->state == SIGN_ASYNC_SIGNED &&
+		        (oldest == NULL || (int8_t)(entry->seq - oldest->seq) < 0)) {
+			oldest = entry;
+		}
+	}
+	if (oldest == NULL) {
+		return NULL;
+	}
+	*to = oldest->to;
+	oldest->state = SIGN_ASYNC_FREE;
+	return &oldest->msg;
+#else
+	(void)to;
+	return NULL;
+#endif
+}
+
 bool signerSignMsg(MyMessage &msg)
 {
+	PROFILING_SCOPE(PROFILING_SIGNER_SIGN);
 	bool ret;
 #if defined(MY_SIGNING_FEATURE)
 	// If destination is known to require signed messages and we are the sender,
@@ -208,15 +351,42 @@ bool signerSignMsg(MyMessage &msg)
 				SIGN_DEBUG(PSTR("!SGN:SGN:STATE\n")); // Signing system is not in a valid state
 				ret = false;
 			} else {
-				// Send nonce-request
 				_signingNonceStatus=SIGN_WAITING_FOR_NONCE;
-				if (!_sendRoute(build(_msgSign, msg.destination, msg.sensor, C_INTERNAL,
-				                      I_NONCE_REQUEST).set(""))) {
-					SIGN_DEBUG(PSTR("!SGN:SGN:NCE REQ,TO=%" PRIu8 " FAIL\n"),
-					           msg.destination); // Failed to transmit nonce request!
-					ret = false;
-				} else {
-					SIGN_DEBUG(PSTR("SGN:SGN:NCE REQ,TO=%" PRIu8 "\n"), msg.destination); // Nonce requested
+				bool nonceRequested = false;
+				bool signedInPlace = false;
+#if defined(MY_SIGNING_NONCE_PREFETCH)
+				signerPrefetchEntry_t *prefetch = signerPrefetchFind(msg.destination);
+				if (prefetch != NULL) {
+					if (prefetch->state == SIGN_PREFETCH_READY) {
+						// Sign right away using the nonce fetched in the background
+						SIGN_DEBUG(PSTR("SGN:SGN:NCE PRE,TO=%" PRIu8 "\n"), msg.destination);
+						MyMessage nonce;
+						signerBackendPutNonce(nonce.set(prefetch->nonce, MIN((uint8_t)MAX_PAYLOAD, (uint8_t)32)));
+						// nothing runs in between, sign in place
+						if (signerBackendSignMsg(msg)) {
+							_signingNonceStatus = SIGN_OK;
+							signedInPlace = true;
+						}
+					} else {
+						// The nonce is already on its way, wait for it instead of requesting another one
+						nonceRequested = true;
+					}
+					// A nonce is only ever used once, a new one is fetched after this message is sent
+					prefetch->state = SIGN_PREFETCH_FREE;
+				}
+#endif
+				if (_signingNonceStatus == SIGN_WAITING_FOR_NONCE && !nonceRequested) {
+					// Send nonce-request
+					if (!_sendRoute(build(_msgSign, msg.destination, msg.sensor, C_INTERNAL,
+					                      I_NONCE_REQUEST).set(""))) {
+						SIGN_DEBUG(PSTR("!SGN:SGN:NCE REQ,TO=%" PRIu8 " FAIL\n"),
+						           msg.destination); // Failed to transmit nonce request!
+					} else {
+						SIGN_DEBUG(PSTR("SGN:SGN:NCE REQ,TO=%" PRIu8 "\n"), msg.destination); // Nonce requested
+						nonceRequested = true;
+					}
+				}
+				if (nonceRequested) {
 					// We have to wait for the nonce to arrive before we can sign our original message
 					// Other messages could come in-between. We trust _process() takes care of them
 					unsigned long enter = hwMillis();
@@ -225,23 +395,29 @@ bool signerSignMsg(MyMessage &msg)
 					        _signingNonceStatus==SIGN_WAITING_FOR_NONCE) {
 						_process();
 					}
+					ENERGY_NONCE(enter);
 					if (hwMillis() - enter > MY_VERIFICATION_TIMEOUT_MS) {
 						SIGN_DEBUG(PSTR("!SGN:SGN:NCE TMO\n")); // Timeout waiting for nonce!
-						ret = false;
-					} else {
-						if (_signingNonceStatus == SIGN_OK) {
-							// process() received a nonce and signerProcessInternal successfully signed the message
-							msg = _msgSign; // Write the signed message back
-							SIGN_DEBUG(PSTR("SGN:SGN:SGN\n")); // Message to send has been signed
-							ret = true;
-							// After this point, only the 'last' member of the message structure is allowed to be
-							// altered if the message has been signed, or signature will become invalid and the
-							// message rejected by the receiver
-						} else {
-							SIGN_DEBUG(PSTR("!SGN:SGN:SGN FAIL\n")); // Message to send could not be signed!
-							ret = false;
-						}
+						_signingNonceStatus = SIGN_WAITING_FOR_NONCE;
+					} else if (_signingNonceStatus != SIGN_OK) {
+						SIGN_DEBUG(PSTR("!SGN:SGN:SGN FAIL\n")); // Message to send could not be signed!
+					}
+				}
+				if (_signingNonceStatus == SIGN_OK) {
+					if (!signedInPlace) {
+						// process() received a nonce and signerProcessInternal successfully signed the message
+						msg = _msgSign; // Write the signed message back
 					}
+					SIGN_DEBUG(PSTR("SGN:SGN:SGN\n")); // Message to send has been signed
+					ret = true;
+					// After this point, only the 'last' member of the message structure is allowed to be
+					// altered if the message has been signed, or signature will become invalid and the
+					// message rejected by the receiver
+#if defined(MY_SIGNING_NONCE_PREFETCH)
+					signerPrefetchSchedule(msg.destination);
+#endif
+				} else {
+					ret = false;
 				}
 			}
 		}
@@ -255,6 +431,9 @@ bool signerSignMsg(MyMessage &msg)
 		           getNodeId()); // Will not sign message since it was from someone else
 		ret = true;
 	}
+	if (!ret) {
+		STATS_INC(STATS_SIGN_FAILURES);
+	}
 #else
 	(void)msg;
 	ret = true;
@@ -262,13 +441,15 @@ bool signerSignMsg(MyMessage &msg)
 	return ret;
 }
 
-bool signerVerifyMsg(MyMessage &msg)
-{
-	bool verificationResult = true;
-	// Before processing message, reject unsigned messages if signing is required and check signature
-	// (if it is signed and addressed to us)
-	// Note that we do not care at all about any signature found if we do not require signing
 #if defined(MY_SIGNING_FEATURE) && defined(MY_SIGNING_REQUEST_SIGNATURES)
+// Outcome of the checks before the backend, see signerVerifyCheck()
+#define SIGNER_VERIFY_OK		(0u)	//!< Nothing to verify
+#define SIGNER_VERIFY_UNSIGNED	(1u)	//!< Rejected, the message is not signed
+#define SIGNER_VERIFY_STATE		(2u)	//!< Rejected, the signing state is not valid
+#define SIGNER_VERIFY_BACKEND	(3u)	//!< Signature has to be verified by the backend
+
+static uint8_t signerVerifyCheck(MyMessage &msg)
+{
 	// If we are a node, or we are a gateway and the sender require signatures (or just a strict gw)
 	// and we are the destination...
 #if defined(MY_SIGNING_WEAK_SECURITY)
@@ -278,39 +459,73 @@ bool signerVerifyMsg(MyMessage &msg)
 #endif
 		// Internal messages of certain types are not verified
 		if (skipSign(msg)) {
-			verificationResult = true;
-		} else if (!mGetSigned(msg)) {
+			return SIGNER_VERIFY_OK;
+		}
+		if (!mGetSigned(msg)) {
 			// Got unsigned message that should have been signed
 			SIGN_DEBUG(PSTR("!SGN:VER:NSG\n")); // Message is not signed, but it should have been!
-			verificationResult = false;
-		} else {
-			// Before starting, validate that our state is good, or signing will fail
-			if (!stateValid) {
-				SIGN_DEBUG(PSTR("!SGN:VER:STATE\n")); // Signing system is not in a valid state
-				verificationResult = false;
-			} else {
-				if (!signerBackendVerifyMsg(msg)) {
-					SIGN_DEBUG(PSTR("!SGN:VER:FAIL\n")); // Signature verification failed!
-					verificationResult = false;
-				} else {
-					SIGN_DEBUG(PSTR("SGN:VER:OK\n"));
-				}
-			}
+			return SIGNER_VERIFY_UNSIGNED;
+		}
+		// Before starting, validate that our state is good, or signing will fail
+		if (!stateValid) {
+			SIGN_DEBUG(PSTR("!SGN:VER:STATE\n")); // Signing system is not in a valid state
+			return SIGNER_VERIFY_STATE;
+		}
+		return SIGNER_VERIFY_BACKEND;
+	}
+	return SIGNER_VERIFY_OK;
+}
+
+// Result of a signed message, verified by the backend or rejected for the signing state
+static bool signerVerifyDone(MyMessage &msg, const bool verificationResult)
+{
 #if defined(MY_NODE_LOCK_FEATURE)
-			if (verificationResult) {
-				// On successful verification, clear lock counters
-				nof_nonce_requests = 0;
-				nof_failed_verifications = 0;
-			} else {
-				nof_failed_verifications++;
-				SIGN_DEBUG(PSTR("SGN:VER:LEFT=%" PRIu8 "\n"), MY_NODE_LOCK_COUNTER_MAX-nof_failed_verifications);
-				if (nof_failed_verifications >= MY_NODE_LOCK_COUNTER_MAX) {
-					_nodeLock("TMFV"); // Too many failed verifications
-				}
-			}
+	if (verificationResult) {
+		// On successful verification, clear lock counters
+		nof_nonce_requests = 0;
+		nof_failed_verifications = 0;
+	} else {
+		nof_failed_verifications++;
+		SIGN_DEBUG(PSTR("SGN:VER:LEFT=%" PRIu8 "\n"), MY_NODE_LOCK_COUNTER_MAX-nof_failed_verifications);
+		if (nof_failed_verifications >= MY_NODE_LOCK_COUNTER_MAX) {
+			_nodeLock("TMFV"); // Too many failed verifications
+		}
+	}
+#endif
+	mSetSigned(msg,0); // Clear the sign-flag now as verification is completed
+	return verificationResult;
+}
+#endif
+
+bool signerVerifyMsg(MyMessage &msg)
+{
+	PROFILING_SCOPE(PROFILING_SIGNER_VERIFY);
+	bool verificationResult = true;
+	// Before processing message, reject unsigned messages if signing is required and check signature
+	// (if it is signed and addressed to us)
+	// Note that we do not care at all about any signature found if we do not require signing
+#if defined(MY_SIGNING_FEATURE) && defined(MY_SIGNING_REQUEST_SIGNATURES)
+	const uint8_t check = signerVerifyCheck(msg);
+	if (check == SIGNER_VERIFY_UNSIGNED) {
+		verificationResult = false;
+	} else if (check == SIGNER_VERIFY_STATE) {
+		verificationResult = signerVerifyDone(msg, false);
+	} else if (check == SIGNER_VERIFY_BACKEND) {
+#if defined(MY_DEBUG_VERBOSE_SIGNING)
+		const uint32_t verifyStart = hwMicros();
 #endif
-			mSetSigned(msg,0); // Clear the sign-flag now as verification is completed
+		const bool verified = signerBackendVerifyMsg(msg);
+		// Time spent in the backend, the nonce was generated when it was requested
+		SIGN_DEBUG(PSTR("SGN:VER:T=%" PRIu32 "\n"), (uint32_t)(hwMicros() - verifyStart));
+		if (!verified) {
+			SIGN_DEBUG(PSTR("!SGN:VER:FAIL\n")); // Signature verification failed!
+		} else {
+			SIGN_DEBUG(PSTR("SGN:VER:OK\n"));
 		}
+		verificationResult = signerVerifyDone(msg, verified);
+	}
+	if (!verificationResult) {
+		STATS_INC(STATS_VERIFY_FAILURES);
 	}
 #else
 	(void)msg;
@@ -320,37 +535,206 @@ bool signerVerifyMsg(MyMessage &msg)
 
 int signerMemcmp(const void* a, const void* b, size_t sz)
 {
-	int retVal;
-	size_t i;
-	int done = 0;
+	// Differences are accumulated without data dependent branches or an early exit
 	const uint8_t* ptrA = (const uint8_t*)a;
 	const uint8_t* ptrB = (const uint8_t*)b;
-	for (i=0; i < sz; i++) {
-		if (ptrA[i] == ptrB[i]) {
-			if (done > 0) {
-				done = 1;
-			} else {
-				done = 0;
+	size_t i = 0;
+	uint8_t diff = 0;
+#if !defined(ARDUINO_ARCH_AVR)
+	// 32-bit targets compare a word at a time, memcpy keeps unaligned buffers safe
+	uint32_t diffWords = 0;
+	for (; i + sizeof(uint32_t) <= sz; i += sizeof(uint32_t)) {
+		uint32_t wordA, wordB;
+		(void)memcpy((void *)&wordA, (const void *)&ptrA[i], sizeof(wordA));
+		(void)memcpy((void *)&wordB, (const void *)&ptrB[i], sizeof(wordB));
+		diffWords |= wordA ^ wordB;
+	}
+	diff = (uint8_t)(diffWords | (diffWords >> 8) | (diffWords >> 16) | (diffWords >> 24));
+#endif
+	for (; i < sz; i++) {
+		diff |= ptrA[i] ^ ptrB[i];
+	}
+	// 0 if no difference, else -1
+	return -(int)((uint8_t)(diff | (uint8_t)(0u - diff)) >> 7);
+}
+
+// Space for a signature after the payload, a signature is at most 32 bytes
+static uint8_t signerSignatureSpace(const MyMessage &msg)
+{
+	return MIN((uint8_t)(MAX_PAYLOAD - MIN(mGetLength(msg), (uint8_t)MAX_PAYLOAD)), (uint8_t)32);
+}
+
+uint8_t signerGetSignatureLength(const MyMessage &msg)
+{
+	// taken from the frame, a relaying node may have another configuration than the sender
+	const uint8_t identifier = msg.data[MIN(mGetLength(msg), (uint8_t)MAX_PAYLOAD)];
+	if (identifier & SIGNING_IDENTIFIER_TAG) {
+		return MIN((uint8_t)(identifier & ~SIGNING_IDENTIFIER_TAG), signerSignatureSpace(msg));
+	}
+	return signerSignatureSpace(msg);
+}
+
+#if defined(MY_SIGNING_FEATURE)
+void signerPutSignature(MyMessage &msg, uint8_t *hmac)
+{
+#if defined(MY_SIGNING_TAG_SIZE)
+	const uint8_t length = MIN(signerSignatureSpace(msg), (uint8_t)MY_SIGNING_TAG_SIZE);
+	// Overwrite the first byte in the signature with the tag length
+	hmac[0] = SIGNING_IDENTIFIER_TAG | length;
+#else
+	const uint8_t length = signerSignatureSpace(msg);
+	// Overwrite the first byte in the signature with the signing identifier
+	hmac[0] = SIGNING_IDENTIFIER;
+#endif
+	(void)memcpy((void *)&msg.data[mGetLength(msg)], (const void *)hmac, length);
+}
+
+uint8_t signerCheckSignatureLength(const MyMessage &msg)
+{
+	const uint8_t space = signerSignatureSpace(msg);
+	const uint8_t identifier = msg.data[mGetLength(msg)];
+	if (space < 2) {
+		return 0;
+	}
+	if (identifier == SIGNING_IDENTIFIER) {
+		// signature fills the payload
+		return space;
+	}
+#if defined(MY_SIGNING_TAG_SIZE)
+	const uint8_t length = identifier & ~SIGNING_IDENTIFIER_TAG;
+	// shorter tags than configured are refused, the sender could be downgraded otherwise
+	if ((identifier & SIGNING_IDENTIFIER_TAG) && length <= space &&
+	        length >= MIN(space, (uint8_t)MY_SIGNING_TAG_SIZE)) {
+		return length;
+	}
+#endif
+	return 0;
+}
+#endif
+
+#if defined(MY_SIGNING_FEATURE)
+#if defined(MY_GATEWAY_STANDBY)
+extern void gatewayTransportStandbyNonce(const uint8_t nodeId, const uint8_t *nonce);
+#endif
+
+// Nonces handed out for verification, one entry per peer so several sessions can be ongoing
+typedef struct {
+	uint32_t timestamp;	// hwMillis() when the nonce was generated
+	bool used;			// Entry holds a nonce that has not been consumed or purged yet
+	uint8_t nodeId;		// Peer the nonce was generated for
+	uint8_t nonce[32];
+} signerNonceEntry_t;
+
+static signerNonceEntry_t _signingNonceTable[MY_SIGNING_NONCE_TABLE_SIZE];
+
+static void signerNonceFree(signerNonceEntry_t &entry)
+{
+	(void)memset((void *)entry.nonce, 0xAA, sizeof(entry.nonce));
+	entry.used = false;
+}
+
+void signerNonceStore(const uint8_t nodeId, const uint8_t *nonce)
+{
+	signerNonceEntry_t *slot = NULL;
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_TABLE_SIZE; i++) {
+		signerNonceEntry_t *entry = &_signingNonceTable[i];
+		if (entry->used && entry->nodeId == nodeId) {
+			// A new nonce request from the same peer invalidates the previous nonce
+			slot = entry;
+			break;
+		}
+		if (slot == NULL || (slot->used &&
+		                     (!entry->used || (int32_t)(entry->timestamp - slot->timestamp) < 0))) {
+			// Prefer a free entry, else replace the oldest one
+			slot = entry;
+		}
+	}
+	(void)memcpy((void *)slot->nonce, (const void *)nonce, sizeof(slot->nonce));
+	slot->used = true;
+	slot->nodeId = nodeId;
+	slot->timestamp = hwMillis();
+#if defined(MY_GATEWAY_STANDBY)
+	gatewayTransportStandbyNonce(nodeId, nonce);
+#endif
+}
+
+bool signerNonceTake(const uint8_t nodeId, uint8_t *nonce)
+{
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_TABLE_SIZE; i++) {
+		signerNonceEntry_t &entry = _signingNonceTable[i];
+		if (entry.used && entry.nodeId == nodeId) {
+			const bool expired = hwMillis() - entry.timestamp > MY_VERIFICATION_TIMEOUT_MS;
+			if (!expired) {
+				(void)memcpy((void *)nonce, (const void *)entry.nonce, sizeof(entry.nonce));
 			}
-		}	else {
-			if (done > 0) {
-				done = 2;
-			} else {
-				done = 3;
+			signerNonceFree(entry); // A nonce is only ever used once
+#if defined(MY_GATEWAY_STANDBY)
+			gatewayTransportStandbyNonce(nodeId, NULL);
+#endif
+			if (expired) {
+				SIGN_DEBUG(PSTR("!SGN:BND:TMR\n")); //Verification timeout
 			}
+			return !expired;
 		}
 	}
-	if (done > 0) {
-		retVal = -1;
+	SIGN_DEBUG(PSTR("!SGN:BND:VER ONGOING\n"));
+	return false;
+}
+
+void signerNoncePurgeExpired(void)
+{
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_TABLE_SIZE; i++) {
+		signerNonceEntry_t &entry = _signingNonceTable[i];
+		if (entry.used && hwMillis() - entry.timestamp > MY_VERIFICATION_TIMEOUT_MS) {
+			SIGN_DEBUG(PSTR("!SGN:BND:TMR\n")); //Verification timeout
+			signerNonceFree(entry);
+		}
+	}
+}
+
+#if defined(MY_SIGNING_NODE_WHITELISTING)
+static constexpr whitelist_entry_t _signingWhitelist[] = MY_SIGNING_NODE_WHITELISTING;
+
+// Helper to check at compile time if the whitelist is in ascending order of node id
+static constexpr bool signerWhitelistSorted(const size_t i)
+{
+	return (i + 1 >= NUM_OF(_signingWhitelist)) ||
+	       (_signingWhitelist[i].nodeId < _signingWhitelist[i + 1].nodeId && signerWhitelistSorted(i + 1));
+}
+
+const whitelist_entry_t *signerWhitelistFind(const uint8_t nodeId)
+{
+	static constexpr bool sorted = signerWhitelistSorted(0);
+	if (sorted) {
+		// Binary search, list the whitelist in ascending order of node id to use it
+		size_t lo = 0;
+		size_t hi = NUM_OF(_signingWhitelist);
+		while (lo < hi) {
+			const size_t mid = (lo + hi) / 2;
+			if (_signingWhitelist[mid].nodeId < nodeId) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		if (lo < NUM_OF(_signingWhitelist) && _signingWhitelist[lo].nodeId == nodeId) {
+			return &_signingWhitelist[lo];
+		}
 	} else {
-		retVal = 0;
+		for (size_t i = 0; i < NUM_OF(_signingWhitelist); i++) {
+			if (_signingWhitelist[i].nodeId == nodeId) {
+				return &_signingWhitelist[i];
+			}
+		}
 	}
-	return retVal;
+	return NULL;
 }
+#endif
+#endif
 
 #if defined(MY_SIGNING_FEATURE)
 // Helper function to centralize signing/verification exceptions
-static bool skipSign(MyMessage &msg)
+static bool isSignException(const MyMessage &msg)
 {
 	bool ret = false;
 	if (mGetEcho(msg)) {
@@ -372,6 +756,13 @@ static bool skipSign(MyMessage &msg)
 	            msg.type == ST_FIRMWARE_REQUEST || msg.type == ST_FIRMWARE_RESPONSE )) {
 		ret = true;
 	}
+	return ret;
+}
+
+// Helper function to skip signing/verification of exceptions
+static bool skipSign(MyMessage &msg)
+{
+	const bool ret = isSignException(msg);
 	if (ret) {
 		SIGN_DEBUG(PSTR("SGN:SKP:%s CMD=%" PRIu8 ",TYPE=%" PRIu8 "\n"), mGetEcho(msg) ? "ECHO" : "MSG",
 		           mGetCommand(msg),
@@ -379,6 +770,130 @@ static bool skipSign(MyMessage &msg)
 	}
 	return ret;
 }
+
+#if defined(MY_SIGNING_NONCE_PREFETCH)
+// Helper to find the usable prefetch entry of a destination
+static signerPrefetchEntry_t *signerPrefetchFind(const uint8_t nodeId)
+{
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_PREFETCH_SIZE; i++) {
+		signerPrefetchEntry_t *entry = &_signingPrefetch[i];
+		const uint32_t age = hwMillis() - entry->timestamp;
+		if (entry->nodeId == nodeId &&
+		        ((entry->state == SIGN_PREFETCH_REQUESTED && age <= MY_VERIFICATION_TIMEOUT_MS) ||
+		         (entry->state == SIGN_PREFETCH_READY && age <= MY_VERIFICATION_TIMEOUT_MS / 2))) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+// Helper to fetch a new nonce for a destination once the current message has been sent
+static void signerPrefetchSchedule(const uint8_t nodeId)
+{
+	signerPrefetchEntry_t *slot = NULL;
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_PREFETCH_SIZE; i++) {
+		signerPrefetchEntry_t *entry = &_signingPrefetch[i];
+		if (entry->state != SIGN_PREFETCH_FREE && entry->nodeId == nodeId) {
+			slot = entry;
+			break;
+		}
+		if (slot == NULL || (slot->state != SIGN_PREFETCH_FREE &&
+		                     (entry->state == SIGN_PREFETCH_FREE ||
+		                      (int32_t)(entry->timestamp - slot->timestamp) < 0))) {
+			// Prefer a free entry, else replace the least recently used one
+			slot = entry;
+		}
+	}
+	slot->state = SIGN_PREFETCH_DUE;
+	slot->nodeId = nodeId;
+	slot->timestamp = hwMillis();
+}
+
+// Helper to send scheduled nonce requests and drop nonces the receiver will no longer accept
+static void signerPrefetchProcess(void)
+{
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_PREFETCH_SIZE; i++) {
+		signerPrefetchEntry_t &entry = _signingPrefetch[i];
+		const uint32_t age = hwMillis() - entry.timestamp;
+		if (entry.state == SIGN_PREFETCH_DUE) {
+			// _msgSign might hold a message waiting for its nonce, use a separate buffer
+			MyMessage request;
+			if (_sendRoute(build(request, entry.nodeId, NODE_SENSOR_ID, C_INTERNAL,
+			                     I_NONCE_REQUEST).set(""))) {
+				SIGN_DEBUG(PSTR("SGN:NCE:PRE REQ,TO=%" PRIu8 "\n"), entry.nodeId); // Nonce prefetch requested
+				entry.state = SIGN_PREFETCH_REQUESTED;
+				entry.timestamp = hwMillis();
+			} else {
+				SIGN_DEBUG(PSTR("!SGN:NCE:PRE REQ,TO=%" PRIu8 " FAIL\n"), entry.nodeId);
+				entry.state = SIGN_PREFETCH_FREE;
+			}
+		} else if ((entry.state == SIGN_PREFETCH_REQUESTED && age > MY_VERIFICATION_TIMEOUT_MS) ||
+		           (entry.state == SIGN_PREFETCH_READY && age > MY_VERIFICATION_TIMEOUT_MS / 2)) {
+			// The receiver times out the nonce after MY_VERIFICATION_TIMEOUT_MS, keep a safe margin
+			(void)memset((void *)entry.nonce, 0xAA, sizeof(entry.nonce));
+			entry.state = SIGN_PREFETCH_FREE;
+		}
+	}
+}
+#endif
+
+#if defined(MY_SIGNING_ASYNC)
+// Helper to find the first queued message in a given state for a destination
+static signerAsyncEntry_t *signerAsyncFind(const uint8_t nodeId, const uint8_t state)
+{
+	signerAsyncEntry_t *oldest = NULL;
+	for (uint8_t i = 0; i < MY_SIGNING_ASYNC_QUEUE_SIZE; i++) {
+		signerAsyncEntry_t *entry = &_signingAsync[i];
+		if (entry->state == state && entry->msg.destination == nodeId &&
+		        (oldest == NULL || (int8_t)(entry->seq - oldest->seq) < 0)) {
+			oldest = entry;
+		}
+	}
+	return oldest;
+}
+
+// Helper to request the nonce for a queued message
+static bool signerAsyncRequest(signerAsyncEntry_t &entry)
+{
+	// _msgSign might hold a message waiting for its nonce, use a separate buffer
+	MyMessage request;
+	if (!_sendRoute(build(request, entry.msg.destination, entry.msg.sensor, C_INTERNAL,
+	                      I_NONCE_REQUEST).set(""))) {
+		SIGN_DEBUG(PSTR("!SGN:SGN:NCE REQ,TO=%" PRIu8 " FAIL\n"),
+		           entry.msg.destination); // Failed to transmit nonce request!
+		entry.state = SIGN_ASYNC_FREE;
+		return false;
+	}
+	SIGN_DEBUG(PSTR("SGN:SGN:NCE REQ,TO=%" PRIu8 "\n"), entry.msg.destination); // Nonce requested
+	entry.state = SIGN_ASYNC_REQUESTED;
+	entry.timestamp = hwMillis();
+	return true;
+}
+
+// Helper to drop messages whose nonce did not arrive and to request nonces for the next ones
+static void signerAsyncProcess(void)
+{
+	for (uint8_t i = 0; i < MY_SIGNING_ASYNC_QUEUE_SIZE; i++) {
+		signerAsyncEntry_t &entry = _signingAsync[i];
+		if (entry.state == SIGN_ASYNC_REQUESTED &&
+		        hwMillis() - entry.timestamp > MY_VERIFICATION_TIMEOUT_MS) {
+			SIGN_DEBUG(PSTR("!SGN:SGN:NCE TMO\n")); // Timeout waiting for nonce!
+			STATS_INC(STATS_SIGN_FAILURES);
+			entry.state = SIGN_ASYNC_FREE;
+		}
+	}
+	for (uint8_t i = 0; i < MY_SIGNING_ASYNC_QUEUE_SIZE; i++) {
+		signerAsyncEntry_t &entry = _signingAsync[i];
+		// One nonce per destination at a time, a new request would replace the pending nonce
+		if (entry.state == SIGN_ASYNC_QUEUED &&
+		        signerAsyncFind(entry.msg.destination, SIGN_ASYNC_QUEUED) == &entry &&
+		        signerAsyncFind(entry.msg.destination, SIGN_ASYNC_REQUESTED) == NULL &&
+		        signerAsyncFind(entry.msg.destination, SIGN_ASYNC_SIGNED) == NULL) {
+			(void)signerAsyncRequest(entry);
+		}
+	}
+}
+#endif
 #endif
 
 // Helper to prepare a signing presentation message
@@ -392,6 +907,48 @@ static void prepareSigningPresentation(MyMessage &msg, uint8_t destination)
 	msg.data[1] = 0;
 }
 
+// Helper to get the requirements presented to a node, a gateway answering a node with weak
+// security only requires signatures if the node required them
+static uint8_t signerPresentationRequirements(const uint8_t nodeId, const bool answer)
+{
+	uint8_t requirements = 0;
+#if defined(MY_SIGNING_REQUEST_SIGNATURES)
+#if defined(MY_SIGNING_WEAK_SECURITY) && defined(MY_SIGNING_FEATURE)
+	if (!answer || DO_SIGN(nodeId)) {
+		requirements |= SIGNING_PRESENTATION_REQUIRE_SIGNATURES;
+	}
+#else
+	requirements |= SIGNING_PRESENTATION_REQUIRE_SIGNATURES;
+#endif
+#endif
+#if defined(MY_SIGNING_NODE_WHITELISTING)
+	requirements |= SIGNING_PRESENTATION_REQUIRE_WHITELISTING;
+#endif
+	(void)nodeId;
+	(void)answer;
+	return requirements;
+}
+
+uint8_t signerPresentationState(const uint8_t nodeId)
+{
+	uint8_t stored = 0;
+#if defined(MY_SIGNING_FEATURE)
+	if (DO_SIGN(nodeId)) {
+		stored |= SIGNING_PRESENTATION_REQUIRE_SIGNATURES;
+	}
+	if (DO_WHITELIST(nodeId)) {
+		stored |= SIGNING_PRESENTATION_REQUIRE_WHITELISTING;
+	}
+#endif
+#if defined(MY_GATEWAY_FEATURE)
+	// presented by the node, answered by us
+	return stored | signerPresentationRequirements(nodeId, true) << 2;
+#else
+	// presented by us, answered by the gateway
+	return signerPresentationRequirements(nodeId, false) | stored << 2;
+#endif
+}
+
 // Helper to process presentation messages
 static bool signerInternalProcessPresentation(MyMessage &msg)
 {
@@ -402,6 +959,8 @@ static bool signerInternalProcessPresentation(MyMessage &msg)
 		           msg.data[0]); // Unsupported signing presentation version
 		return true; // Just drop this presentation message
 	}
+	const uint8_t doSignPrev = _doSign[sender >> 3];
+	const uint8_t doWhitelistPrev = _doWhitelist[sender >> 3];
 	// We only handle version 1 here...
 	if (msg.data[1] & SIGNING_PRESENTATION_REQUIRE_SIGNATURES) {
 		// We received an indicator that the sender require us to sign all messages we send to it
@@ -437,28 +996,20 @@ static bool signerInternalProcessPresentation(MyMessage &msg)
 #endif
 	}
 
-	// Save updated tables
-	hwWriteConfigBlock((void*)_doSign, (void*)EEPROM_SIGNING_REQUIREMENT_TABLE_ADDRESS,
-	                   sizeof(_doSign));
-	hwWriteConfigBlock((void*)_doWhitelist, (void*)EEPROM_WHITELIST_REQUIREMENT_TABLE_ADDRESS,
-	                   sizeof(_doWhitelist));
+	// Save updated tables, the RAM copies are authoritative so only a changed byte is written
+	if (_doSign[sender >> 3] != doSignPrev) {
+		hwWriteConfig(EEPROM_SIGNING_REQUIREMENT_TABLE_ADDRESS + (sender >> 3), _doSign[sender >> 3]);
+	}
+	if (_doWhitelist[sender >> 3] != doWhitelistPrev) {
+		hwWriteConfig(EEPROM_WHITELIST_REQUIREMENT_TABLE_ADDRESS + (sender >> 3),
+		              _doWhitelist[sender >> 3]);
+	}
 
 	// Inform sender about our preference if we are a gateway, but only require signing if the sender
 	// required signing unless we explicitly configure it to
 #if defined(MY_GATEWAY_FEATURE)
 	prepareSigningPresentation(msg, sender);
-#if defined(MY_SIGNING_REQUEST_SIGNATURES)
-#if defined(MY_SIGNING_WEAK_SECURITY)
-	if (DO_SIGN(sender)) {
-		msg.data[1] |= SIGNING_PRESENTATION_REQUIRE_SIGNATURES;
-	}
-#else
-	msg.data[1] |= SIGNING_PRESENTATION_REQUIRE_SIGNATURES;
-#endif
-#endif // MY_SIGNING_REQUEST_SIGNATURES
-#if defined(MY_SIGNING_NODE_WHITELISTING)
-	msg.data[1] |= SIGNING_PRESENTATION_REQUIRE_WHITELISTING;
-#endif // MY_SIGNING_NODE_WHITELISTING
+	msg.data[1] = signerPresentationRequirements(sender, true);
 	if (msg.data[1] & SIGNING_PRESENTATION_REQUIRE_SIGNATURES) {
 		SIGN_DEBUG(PSTR("SGN:PRE:SGN REQ,TO=%" PRIu8 "\n"),
 		           sender); // Inform node that we require signatures
@@ -541,6 +1092,37 @@ static bool signerInternalProcessNonceResponse(MyMessage &msg)
 #if defined(MY_SIGNING_FEATURE)
 	// Proceed with signing if nonce has been received
 	SIGN_DEBUG(PSTR("SGN:NCE:FROM=%" PRIu8 "\n"), msg.sender);
+#if defined(MY_SIGNING_NONCE_PREFETCH)
+	if (_signingNonceStatus != SIGN_WAITING_FOR_NONCE || msg.sender != _msgSign.destination) {
+		// Keep the nonce if it answers a background request
+		signerPrefetchEntry_t *prefetch = signerPrefetchFind(msg.sender);
+		if (prefetch != NULL && prefetch->state == SIGN_PREFETCH_REQUESTED) {
+			(void)memcpy((void *)prefetch->nonce, (const void *)msg.getCustom(),
+			             MIN((uint8_t)MAX_PAYLOAD, (uint8_t)32));
+			prefetch->state = SIGN_PREFETCH_READY;
+			SIGN_DEBUG(PSTR("SGN:NCE:PRE\n")); // Nonce prefetched
+			return true;
+		}
+	}
+#endif
+#if defined(MY_SIGNING_ASYNC)
+	if (_signingNonceStatus != SIGN_WAITING_FOR_NONCE || msg.sender != _msgSign.destination) {
+		// Sign the queued message the nonce was requested for
+		signerAsyncEntry_t *pending = signerAsyncFind(msg.sender, SIGN_ASYNC_REQUESTED);
+		if (pending != NULL) {
+			signerBackendPutNonce(msg);
+			if (signerBackendSignMsg(pending->msg)) {
+				SIGN_DEBUG(PSTR("SGN:SGN:SGN\n")); // Message to send has been signed
+				pending->state = SIGN_ASYNC_SIGNED;
+			} else {
+				SIGN_DEBUG(PSTR("!SGN:SGN:SGN FAIL\n")); // Message to send could not be signed!
+				STATS_INC(STATS_SIGN_FAILURES);
+				pending->state = SIGN_ASYNC_FREE;
+			}
+			return true;
+		}
+	}
+#endif
 	if (msg.sender != _msgSign.destination) {
 		SIGN_DEBUG(PSTR("SGN:NCE:%" PRIu8 "!=%" PRIu8 " (DROPPED)\n"), _msgSign.destination, msg.sender);
 	} else {
@@ -46,7 +46,8 @@
  * choice in your sketch. Currently, two compatible backends are supported; @ref MY_SIGNING_ATSHA204
  * (hardware backed) and @ref MY_SIGNING_SOFT (software backed). There also exist a simplified
  * variant (@ref MY_SIGNING_SIMPLE_PASSWD) of the software backend which only require one setting
- * to activate.
+ * to activate. @ref MY_SIGNING_ATECC is a hardware backend for the ATECC508A/ATECC608A on I2C,
+ * compatible with the other two.
  *
  * If you use hardware backed signing, then connect the device as follows:
  * @image html MySigning/wiring.png
@@ -419,6 +420,9 @@
  * thing to consider is that the strength of the signature is inversely proportional to the payload
  * size.
  *
+ * With @ref MY_SIGNING_TAG_SIZE, the signature is truncated instead of filling the payload, so short
+ * messages are sent short. The signing identifier then holds the length of the signature.
+ *
  * As for the software backend, it turns out that the ATSHA does not do “vanilla” HMAC processing.
  * Fortunately, Atmel has documented exactly how the circuit processes the data and hashes thus
  * making it possible to generate signatures that are identical to signatures generated by the
@@ -601,6 +605,9 @@
 
 #include "MySensorsCore.h"
 #include "drivers/ATSHA204/ATSHA204.h"
+#if defined(MY_SIGNING_ATECC)
+#include "drivers/ATECC/ATECC.h"
+#endif
 
 #ifdef MY_SIGNING_NODE_WHITELISTING
 typedef struct {
@@ -638,6 +645,19 @@ void signerInit(void);
  */
 void signerPresentation(MyMessage &msg, uint8_t destination);
 
+/**
+ * @brief Get the signing requirements exchanged with a node by the last signing presentation.
+ *
+ * The lower two bits hold the requirements of the node, the next two bits those of the gateway,
+ * as stored in the requirement tables and as currently configured. A node calls this for the
+ * gateway, the gateway for the node, both get the same value if nothing changed since. It is part
+ * of the presentation digest, see @ref MY_PRESENTATION_DIGEST.
+ *
+ * @param nodeId Node ID of the other side.
+ * @returns The requirements of both sides.
+ */
+uint8_t signerPresentationState(const uint8_t nodeId);
+
 /**
  * @brief Manages internal signing message handshaking.
  *
@@ -654,10 +674,11 @@ bool signerProcessInternal(MyMessage &msg);
 /**
  * @brief Check timeout of verification session.
  *
- * Nonce will be purged if it takes too long for a signed message to be sent to the receiver.
+ * Nonces will be purged if it takes too long for a signed message to be sent to the receiver.
+ * Each peer has its own session, see @ref MY_SIGNING_NONCE_TABLE_SIZE.
  * \n@b Usage: This function should be called on regular intervals, typically within some process loop.
  *
- * @returns @c true if session is still valid.
+ * @returns @c true if the signing backend is operational.
  */
 bool signerCheckTimer(void);
 
@@ -694,6 +715,36 @@ bool signerPutNonce(MyMessage &msg);
 */
 bool signerSignMsg(MyMessage &msg);
 
+/**
+ * @brief Queues a message that has to wait for a nonce instead of blocking in @ref signerSignMsg().
+ *
+ * Only has an effect if @ref MY_SIGNING_ASYNC is defined. A nonce is requested from the
+ * destination of the message and the message is signed in @ref signerProcessInternal() when
+ * the nonce arrives. Signed messages are fetched using @ref signerGetSignedMsg(). Messages to
+ * the same destination are signed one after the other, messages to different destinations
+ * can wait for their nonces at the same time.
+ * \n@b Usage: This function is typically called before @ref signerSignMsg() when a message is
+ * written to the transport.
+ *
+ * @param to Next hop the message is to be written to.
+ * @param msg The message to sign.
+ * @returns @c true if the message has been queued, @c false if it has to be passed to
+ * @ref signerSignMsg().
+ */
+bool signerQueueMsg(const uint8_t to, MyMessage &msg);
+
+/**
+ * @brief Gets the oldest message queued by @ref signerQueueMsg() that has been signed.
+ *
+ * The message is not copied out of the queue. Its slot is released by this call and stays
+ * untouched until the next call of @ref signerQueueMsg(), i.e. the message has to be written
+ * to the transport right away.
+ *
+ * @param to Next hop the message is to be written to.
+ * @returns the signed message or NULL if none is waiting.
+ */
+MyMessage *signerGetSignedMsg(uint8_t *to);
+
 /**
  * @brief Verifies signature in provided message.
  *
@@ -711,6 +762,22 @@ bool signerSignMsg(MyMessage &msg);
  */
 bool signerVerifyMsg(MyMessage &msg);
 
+#if defined(MY_SIGNING_PARALLEL_VERIFY) || defined(DOXYGEN)
+/**
+ * @brief Verifies the signatures of several received messages in parallel.
+ *
+ * Same as calling @ref signerVerifyMsg() for each message in the order given. The nonces are taken
+ * in that order on the calling thread, the signatures are calculated by the
+ * @ref MY_LINUX_SIGNING_VERIFY_THREADS threads. Messages of one sender are verified by the same
+ * thread.
+ *
+ * @param msgs The messages to verify, at most @ref MY_LINUX_SIGNING_VERIFY_BATCH.
+ * @param results Receives the result of each message.
+ * @param count Number of messages.
+ */
+void signerVerifyBatch(MyMessage *msgs, bool *results, const uint8_t count);
+#endif
+
 /**
  * @brief Do a timing neutral memory comparison.
  *
@@ -725,6 +792,91 @@ bool signerVerifyMsg(MyMessage &msg);
  */
 int signerMemcmp(const void* a, const void* b, size_t sz);
 
+/** Signing identifier of HMAC-SHA256 signatures filling the payload */
+#define SIGNING_IDENTIFIER (1)
+/** Flag in the signing identifier of truncated HMAC-SHA256 signatures, the other bits are the length */
+#define SIGNING_IDENTIFIER_TAG (0x80)
+
+/**
+ * @brief Get the number of signature bytes of a signed message.
+ *
+ * The length is taken from the signing identifier in the message, it is independent of the own
+ * configuration so relaying nodes send signed messages as long as the sender did.
+ *
+ * @param msg The signed message.
+ * @returns Number of bytes after the payload, including the signing identifier.
+ */
+uint8_t signerGetSignatureLength(const MyMessage &msg);
+
+#if defined(MY_SIGNING_FEATURE) || defined(DOXYGEN)
+/**
+ * @brief Append a signature to a message.
+ *
+ * Used by the signing backends. The first byte of the HMAC is replaced by the signing identifier.
+ * With @ref MY_SIGNING_TAG_SIZE, the HMAC is truncated and the identifier holds its length.
+ *
+ * @param msg The message to sign, the payload has to leave at least 2 bytes.
+ * @param hmac The 32 byte HMAC of the message.
+ */
+void signerPutSignature(MyMessage &msg, uint8_t *hmac);
+
+/**
+ * @brief Check the signing identifier of a received message.
+ *
+ * Used by the signing backends. Truncated signatures are only accepted with
+ * @ref MY_SIGNING_TAG_SIZE and if they are at least as long as configured.
+ *
+ * @param msg The received message.
+ * @returns Number of signature bytes to compare, 0 if the identifier is not accepted.
+ */
+uint8_t signerCheckSignatureLength(const MyMessage &msg);
+#endif
+
+/**
+ * @brief Remember a nonce handed out to a peer for verification.
+ *
+ * Used by the signing backends. A previous nonce for the same peer is replaced. When all
+ * @ref MY_SIGNING_NONCE_TABLE_SIZE entries are taken, the oldest entry is replaced.
+ *
+ * @param nodeId The peer the nonce was sent to.
+ * @param nonce The 32 byte nonce.
+ */
+void signerNonceStore(const uint8_t nodeId, const uint8_t *nonce);
+
+/**
+ * @brief Fetch and forget the nonce handed out to a peer.
+ *
+ * @param nodeId The peer that sent the signed message.
+ * @param nonce Buffer of 32 bytes receiving the nonce.
+ * @returns @c false if no nonce is pending for the peer or if it has expired.
+ */
+bool signerNonceTake(const uint8_t nodeId, uint8_t *nonce);
+
+/**
+ * @brief Drop all nonces older than @ref MY_VERIFICATION_TIMEOUT_MS.
+ */
+void signerNoncePurgeExpired(void);
+
+#if defined(MY_SIGNING_NONCE_POOL)
+/**
+ * @brief Get the number of nonces ready in the pool, see @ref MY_SIGNING_NONCE_POOL.
+ */
+uint8_t signerNoncePoolDepth(void);
+#endif
+
+#ifdef MY_SIGNING_NODE_WHITELISTING
+/**
+ * @brief Look up a node in @ref MY_SIGNING_NODE_WHITELISTING.
+ *
+ * A whitelist listed in ascending order of node id is searched with a binary search,
+ * others are searched linearly.
+ *
+ * @param nodeId The node to look up.
+ * @returns The whitelist entry of the node, or NULL if the node is not whitelisted.
+ */
+const whitelist_entry_t *signerWhitelistFind(const uint8_t nodeId);
+#endif
+
 #endif
 /** @}*/
 
@@ -780,6 +932,9 @@ int signerMemcmp(const void* a, const void* b, size_t sz);
  * | | SGN | SGN | NCE REQ,TO='node'				| Nonce request transmitted to 'node'
  * |!| SGN | SGN | NCE REQ,TO='node' FAIL		| Nonce request not properly transmitted to 'node'
  * |!| SGN | SGN | NCE TMO									| Timeout waiting for nonce
+ * | | SGN | SGN | NCE PRE,TO='node'				| Signing with the nonce prefetched from 'node'
+ * | | SGN | SGN | QUEUED,TO='node'				| Message to 'node' is signed once the nonce arrives (@ref MY_SIGNING_ASYNC)
+ * |!| SGN | SGN | QUEUE FULL								| No room to queue message, waiting for nonce instead
  * | | SGN | SGN | SGN											| Message signed
  * |!| SGN | SGN | SGN FAIL									| Message failed to be signed
  * | | SGN | SGN | NREQ='node'							| 'node' does not require signed messages
@@ -788,6 +943,7 @@ int signerMemcmp(const void* a, const void* b, size_t sz);
  * |!| SGN | VER | NSG											| Message was not signed, but it should have been
  * |!| SGN | VER | FAIL											| Verification failed
  * | | SGN | VER | OK												| Verification succeeded
+ * | | SGN | VER | T='us'										| Backend verification took 'us' microseconds
  * | | SGN | VER | LEFT='number'						| 'number' of failed verifications left in a row before node is locked
  * |!| SGN | VER | STATE  									| Security system in a invalid state (personalization data tampered)
  * | | SGN | SKP | MSG CMD='cmd',TYPE='type'| Message with command 'cmd' and type 'type' does not need to be signed
@@ -798,6 +954,9 @@ int signerMemcmp(const void* a, const void* b, size_t sz);
  * |!| SGN | NCE | GEN											| Failed to generate nonce
  * | | SGN | NCE | NSUP (DROPPED)						| Ignored nonce/request for nonce (signing not supported)
  * | | SGN | NCE | FROM='node'							| Received nonce from 'node'
+ * | | SGN | NCE | PRE											| Nonce stored for the next signed message (@ref MY_SIGNING_NONCE_PREFETCH)
+ * | | SGN | NCE | PRE REQ,TO='node'				| Nonce prefetch request transmitted to 'node'
+ * |!| SGN | NCE | PRE REQ,TO='node' FAIL	| Nonce prefetch request not properly transmitted to 'node'
  * | | SGN | NCE | 'sender'!='dst' (DROPPED)| Ignoring nonce as it did not come from the designation of the message to sign
  * |!| SGN | BND | INIT FAIL								| Failed to initialize signing backend
  * |!| SGN | BND | PWD<8										| Signing password too short
@@ -807,7 +966,7 @@ int signerMemcmp(const void* a, const void* b, size_t sz);
  * |!| SGN | BND | SIG,SIZE,'message'>'max'	| Refusing to sign 'message' because it is bigger than 'max' allowed size
  * | | SGN | BND | SIG WHI,ID='id'					| Salting message with our 'id'
  * | | SGN | BND | SIG WHI,SERIAL='serial'	| Salting message with our 'serial'
- * |!| SGN | BND | VER ONGOING							| Verification failed, no ongoing session
+ * |!| SGN | BND | VER ONGOING							| Verification failed, no ongoing session with sender
  * |!| SGN | BND | VER,IDENT='identifier'		| Verification failed, 'identifier' is unknown
  * | | SGN | BND | VER WHI,ID='sender'			| 'sender' found in whitelist
  * | | SGN | BND | VER WHI,SERIAL='serial'	| Expecting 'serial' for this sender
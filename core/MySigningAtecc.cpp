@@ -0,0 +1,313 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ *******************************
+ *
+ * DESCRIPTION
+ * ATECC508A/ATECC608A signing backend. The chips offer true random number generation and
+ * HMAC-SHA256 with a readout-protected key over I2C. The signatures are the same as those of
+ * the ATSHA204A and software backends: the key is only needed for the final HMAC, which the
+ * chip calculates in three commands. The digests around it are not secret and are calculated
+ * in software.
+ *
+ */
+
+#include "MySigning.h"
+#include "MyHelperFunctions.h"
+
+#ifdef MY_SIGNING_ATECC
+
+#if defined(MY_DEBUG_VERBOSE_SIGNING)
+#define SIGN_DEBUG(x,...) DEBUG_OUTPUT(x, ##__VA_ARGS__)
+#else
+#define SIGN_DEBUG(x,...)
+#endif
+
+static uint8_t _signing_verifying_nonce[32+9+1];
+static uint8_t _signing_signing_nonce[32+9+1];
+static uint8_t _signing_buffer[96];
+static uint8_t _signing_rx_buffer[ATECC_RSP_SIZE_MAX];
+static uint8_t _signing_hmac[32];
+static uint8_t _signing_node_serial_info[9];
+static uint8_t _signing_hmac_end_mode = ATECC_SHA_HMAC_END;
+
+static bool init_ok = false;
+
+static void signerCalculateSignature(MyMessage &msg, bool signing);
+static bool signerAteccHmac(const uint8_t* nonce, const uint8_t* data);
+
+bool signerAteccInit(void)
+{
+	init_ok = true;
+	atecc_init(MY_SIGNING_ATECC_I2C_ADDRESS);
+
+	(void)atecc_wakeup(_signing_rx_buffer);
+	// Read the configuration lock flag to determine if device is personalized or not
+	if (atecc_read(_signing_rx_buffer, ATECC_ZONE_CONFIG, ATECC_ADDRESS_LOCK) != ATECC_SUCCESS) {
+		SIGN_DEBUG(PSTR("!SGN:BND:INIT FAIL\n")); //Could not read ATECC lock config
+		init_ok = false;
+	} else if (_signing_rx_buffer[ATECC_BUFFER_POS_DATA+3] != 0x00) {
+		SIGN_DEBUG(PSTR("!SGN:BND:PER\n")); //ATECC not personalized
+		init_ok = false;
+	}
+	if (init_ok) {
+		// Get and cache the serial of the ATECC
+		if (atecc_getSerialNumber(_signing_node_serial_info) != ATECC_SUCCESS) {
+			SIGN_DEBUG(PSTR("!SGN:BND:SER\n")); //Could not get ATECC serial
+			init_ok = false;
+		}
+	}
+	if (init_ok) {
+		// The ATECC608A moved the HMAC end mode of the SHA command
+		if (atecc_read(_signing_rx_buffer, ATECC_ZONE_CONFIG, ATECC_ADDRESS_REVNUM) != ATECC_SUCCESS) {
+			SIGN_DEBUG(PSTR("!SGN:BND:INIT FAIL\n")); //Could not read ATECC revision
+			init_ok = false;
+		} else if (_signing_rx_buffer[ATECC_BUFFER_POS_DATA+2] >= ATECC_REVNUM_608) {
+			_signing_hmac_end_mode = ATECC_SHA_608_HMAC_END;
+		}
+	}
+	atecc_sleep();
+	return init_ok;
+}
+
+bool signerAteccCheckTimer(void)
+{
+	if (!init_ok) {
+		return false;
+	}
+	// Purge nonces whose signed message did not arrive in time
+	signerNoncePurgeExpired();
+	return true;
+}
+
+bool signerAteccGetNonce(MyMessage &msg)
+{
+	if (!init_ok) {
+		return false;
+	}
+
+	// We used a basic whitening technique that XORs each byte in a 32byte random value with current
+	// hwMillis() counter. This 32-byte random value is then hashed (SHA256) to produce the resulting
+	// nonce
+	if (atecc_wakeup(_signing_rx_buffer) != ATECC_SUCCESS ||
+	        atecc_execute(ATECC_RANDOM, ATECC_RANDOM_SEED_UPDATE, 0, 0, NULL, ATECC_RSP_SIZE_MAX,
+	                      _signing_rx_buffer, ATECC_RANDOM_EXEC_MAX) != ATECC_SUCCESS) {
+		atecc_sleep();
+		return false;
+	}
+	// We just idle the chip now since we expect to use it soon when the signed message arrives
+	atecc_idle();
+	for (uint8_t i = 0; i < 32; i++) {
+		_signing_verifying_nonce[i] = _signing_rx_buffer[ATECC_BUFFER_POS_DATA+i] ^ (hwMillis()&0xFF);
+	}
+	SHA256(_signing_hmac, _signing_verifying_nonce, 32);
+	(void)memcpy((void *)_signing_verifying_nonce, (const void *)_signing_hmac, min(MAX_PAYLOAD, 32));
+
+	if (MAX_PAYLOAD < 32) {
+		// We set the part of the 32-byte nonce that does not fit into a message to 0xAA
+		(void)memset((void *)&_signing_verifying_nonce[MAX_PAYLOAD], 0xAA, 32-MAX_PAYLOAD);
+	}
+
+	// Transfer the first part of the nonce to the message
+	msg.set(_signing_verifying_nonce, min(MAX_PAYLOAD, 32));
+	// Keep the nonce for the requesting peer until its signed message arrives
+	signerNonceStore(msg.sender, _signing_verifying_nonce);
+	(void)memset((void *)_signing_verifying_nonce, 0xAA, 32);
+	return true;
+}
+
+void signerAteccPutNonce(MyMessage &msg)
+{
+	if (!init_ok) {
+		return;
+	}
+
+	(void)memcpy((void *)_signing_signing_nonce, (const void *)msg.getCustom(), min(MAX_PAYLOAD, 32));
+	if (MAX_PAYLOAD < 32) {
+		// We set the part of the 32-byte nonce that does not fit into a message to 0xAA
+		(void)memset((void *)&_signing_signing_nonce[MAX_PAYLOAD], 0xAA, 32-MAX_PAYLOAD);
+	}
+}
+
+bool signerAteccSignMsg(MyMessage &msg)
+{
+	// If we cannot fit any signature in the message, refuse to sign it
+	if (mGetLength(msg) > MAX_PAYLOAD-2) {
+		SIGN_DEBUG(PSTR("!SGN:BND:SIG,SIZE,%" PRIu8 ">%" PRIu8 "\n"), mGetLength(msg),
+		           MAX_PAYLOAD-2); //Message too large
+		return false;
+	}
+
+	// Calculate signature of message
+	mSetSigned(msg, 1); // make sure signing flag is set before signature is calculated
+	signerCalculateSignature(msg, true);
+
+	if (DO_WHITELIST(msg.destination)) {
+		// Salt the signature with the senders nodeId and the unique serial of the ATECC device
+		// We can reuse the nonce buffer now since it is no longer needed
+		(void)memcpy((void *)_signing_signing_nonce, (const void *)_signing_hmac, 32);
+		_signing_signing_nonce[32] = msg.sender;
+		(void)memcpy((void *)&_signing_signing_nonce[33], (const void *)_signing_node_serial_info, 9);
+		SHA256(_signing_hmac, _signing_signing_nonce, 32+1+9);
+		SIGN_DEBUG(PSTR("SGN:BND:SIG WHI,ID=%" PRIu8 "\n"), msg.sender);
+#ifdef MY_DEBUG_VERBOSE_SIGNING
+		hwDebugBuf2Str(_signing_node_serial_info, 9);
+		SIGN_DEBUG(PSTR("SGN:BND:SIG WHI,SERIAL=%s\n"), hwDebugPrintStr);
+#endif
+	}
+
+	// Append the signature with the signing identifier
+	signerPutSignature(msg, _signing_hmac);
+
+	return true;
+}
+
+bool signerAteccVerifyMsg(MyMessage &msg)
+{
+	// Fetch the nonce handed out to the sender, make sure it has not expired
+	if (!signerNonceTake(msg.sender, _signing_verifying_nonce)) {
+		return false;
+	} else {
+		const uint8_t signatureLength = signerCheckSignatureLength(msg);
+		if (!signatureLength) {
+			SIGN_DEBUG(PSTR("!SGN:BND:VER,IDENT=%" PRIu8 "\n"), msg.data[mGetLength(msg)]);
+			return false;
+		}
+
+		signerCalculateSignature(msg, false); // Get signature of message
+
+#ifdef MY_SIGNING_NODE_WHITELISTING
+		// Look up the senders nodeId in our whitelist and salt the signature with that data
+		const whitelist_entry_t *whitelisted = signerWhitelistFind(msg.sender);
+		if (whitelisted != NULL) {
+			// We can reuse the nonce buffer now since it is no longer needed
+			(void)memcpy((void *)_signing_verifying_nonce, (const void *)_signing_hmac, 32);
+			_signing_verifying_nonce[32] = msg.sender;
+			(void)memcpy((void *)&_signing_verifying_nonce[33], (const void *)whitelisted->serial, 9);
+			SHA256(_signing_hmac, _signing_verifying_nonce, 32+1+9);
+			SIGN_DEBUG(PSTR("SGN:BND:VER WHI,ID=%" PRIu8 "\n"), msg.sender);
+#ifdef MY_DEBUG_VERBOSE_SIGNING
+			hwDebugBuf2Str(whitelisted->serial, 9);
+			SIGN_DEBUG(PSTR("SGN:BND:VER WHI,SERIAL=%s\n"), hwDebugPrintStr);
+#endif
+		} else {
+			SIGN_DEBUG(PSTR("!SGN:BND:VER WHI,ID=%" PRIu8 " MISSING\n"), msg.sender);
+			return false;
+		}
+#endif
+
+		// Overwrite the first byte in the signature with the signing identifier
+		_signing_hmac[0] = msg.data[mGetLength(msg)];
+
+		// Compare the calculated signature with the provided signature
+		if (signerMemcmp(&msg.data[mGetLength(msg)], _signing_hmac, signatureLength)) {
+			return false;
+		} else {
+			return true;
+		}
+	}
+}
+
+// Helper to calculate signature of msg (returned in _signing_hmac)
+static void signerCalculateSignature(MyMessage &msg, bool signing)
+{
+	// Signature is calculated on everything expect the first byte in the header
+	uint16_t bytes_left = mGetLength(msg)+HEADER_SIZE-1;
+	int16_t current_pos = 1-(int16_t)HEADER_SIZE; // Start at the second byte in the header
+	uint8_t* nonce = signing ? _signing_signing_nonce : _signing_verifying_nonce;
+	uint8_t data[32];
+
+#ifdef MY_DEBUG_VERBOSE_SIGNING
+	hwDebugBuf2Str(nonce, 32);
+	SIGN_DEBUG(PSTR("SGN:BND:NONCE=%s\n"), hwDebugPrintStr);
+#endif
+
+	// One wake up for all passes, the chip calculates a pass in a few ms, well within its watchdog
+	if (atecc_wakeup(_signing_rx_buffer) != ATECC_SUCCESS) {
+		SIGN_DEBUG(PSTR("!SGN:BND:WAKE\n"));
+	}
+	while (bytes_left) {
+		uint16_t bytes_to_include = min(bytes_left, 32);
+
+		(void)memset((void *)data, 0, 32);
+		(void)memcpy((void *)data, (const void *)&msg.data[current_pos], bytes_to_include);
+
+		if (!signerAteccHmac(nonce, data)) {
+			// a failed HMAC never matches, the result is not a valid signature
+			(void)memset((void *)_signing_hmac, 0xAA, 32);
+		}
+		// Purge nonce when used
+		(void)memset((void *)nonce, 0xAA, 32);
+
+		bytes_left -= bytes_to_include;
+		current_pos += bytes_to_include;
+
+		if (bytes_left > 0) {
+			// We will do another pass, use current HMAC as nonce for the next HMAC
+			(void)memcpy((void *)nonce, (const void *)_signing_hmac, 32);
+		}
+	}
+	// Put device back to sleep
+	atecc_sleep();
+#ifdef MY_DEBUG_VERBOSE_SIGNING
+	hwDebugBuf2Str(_signing_hmac, 32);
+	SIGN_DEBUG(PSTR("SGN:BND:HMAC=%s\n"), hwDebugPrintStr);
+#endif
+}
+
+// Helper to calculate a ATSHA204A specific HMAC-SHA256 using provided 32 byte nonce and data
+// (zero padded to 32 bytes), see signerAtsha204AHmac() of the software backend for the layout.
+// The HMAC is stored in _signing_hmac.
+static bool signerAteccHmac(const uint8_t* nonce, const uint8_t* data)
+{
+	// Digest of the data and the nonce, what GenDig puts into TempKey on the ATSHA204A
+	(void)memset((void *)_signing_buffer, 0x00, sizeof(_signing_buffer));
+	(void)memcpy((void *)_signing_buffer, (const void *)data, 32);
+	_signing_buffer[0 + 32] = 0x15; // OPCODE
+	_signing_buffer[1 + 32] = 0x02; // param1
+	_signing_buffer[2 + 32] = 0x08; // param2(1)
+	_signing_buffer[4 + 32] = 0xEE; // SN[8]
+	_signing_buffer[5 + 32] = 0x01; // SN[0]
+	_signing_buffer[6 + 32] = 0x23; // SN[1]
+	(void)memcpy((void *)&_signing_buffer[64], (const void *)nonce, 32);
+	SHA256(_signing_hmac, _signing_buffer, 96);
+
+	// Message the ATSHA204A HMAC command authenticates
+	(void)memset((void *)_signing_buffer, 0x00, sizeof(_signing_buffer));
+	(void)memcpy((void *)&_signing_buffer[32], (const void *)_signing_hmac, 32);
+	_signing_buffer[0 + 64] = 0x11; // OPCODE
+	_signing_buffer[1 + 64] = 0x04; // Mode
+	_signing_buffer[15 + 64] = 0xEE; // SN[8]
+	_signing_buffer[20 + 64] = 0x01;
+	_signing_buffer[21 + 64] = 0x23;
+
+	// HMAC with the key in the slot: start, one 64 byte block, the remaining 24 bytes
+	if (atecc_execute(ATECC_SHA, ATECC_SHA_HMAC_START, MY_SIGNING_ATECC_KEY_SLOT, 0, NULL,
+	                  ATECC_RSP_SIZE_MIN, _signing_rx_buffer, ATECC_SHA_EXEC_MAX) != ATECC_SUCCESS ||
+	        atecc_execute(ATECC_SHA, ATECC_SHA_UPDATE, 0, ATECC_SHA_BLOCK_SIZE, _signing_buffer,
+	                      ATECC_RSP_SIZE_MIN, _signing_rx_buffer, ATECC_SHA_EXEC_MAX) != ATECC_SUCCESS ||
+	        atecc_execute(ATECC_SHA, _signing_hmac_end_mode, 88 - ATECC_SHA_BLOCK_SIZE,
+	                      88 - ATECC_SHA_BLOCK_SIZE, &_signing_buffer[ATECC_SHA_BLOCK_SIZE],
+	                      ATECC_RSP_SIZE_MAX, _signing_rx_buffer, ATECC_SHA_EXEC_MAX) != ATECC_SUCCESS) {
+		SIGN_DEBUG(PSTR("!SGN:BND:HMAC FAIL\n"));
+		return false;
+	}
+	(void)memcpy((void *)_signing_hmac, (const void *)&_signing_rx_buffer[ATECC_BUFFER_POS_DATA], 32);
+	return true;
+}
+#endif //MY_SIGNING_ATECC
@@ -29,7 +29,6 @@
 #include "MyHelperFunctions.h"
 
 #ifdef MY_SIGNING_ATSHA204
-#define SIGNING_IDENTIFIER (1) //HMAC-SHA256
 
 #if defined(MY_DEBUG_VERBOSE_SIGNING)
 #define SIGN_DEBUG(x,...) DEBUG_OUTPUT(x, ##__VA_ARGS__)
@@ -37,8 +36,6 @@
 #define SIGN_DEBUG(x,...)
 #endif
 
-static unsigned long _signing_timestamp;
-static bool _signing_verification_ongoing = false;
 static uint8_t _signing_verifying_nonce[32+9+1];
 static uint8_t _signing_signing_nonce[32+9+1];
 static uint8_t _signing_temp_message[SHA_MSG_SIZE];
@@ -46,12 +43,22 @@ static uint8_t _signing_rx_buffer[SHA204_RSP_SIZE_MAX];
 static uint8_t _signing_tx_buffer[SHA204_CMD_SIZE_MAX];
 static uint8_t* const _signing_hmac = &_signing_rx_buffer[SHA204_BUFFER_POS_DATA];
 static uint8_t _signing_node_serial_info[9];
-#ifdef MY_SIGNING_NODE_WHITELISTING
-static const whitelist_entry_t _signing_whitelist[] = MY_SIGNING_NODE_WHITELISTING;
-#endif
 
 static bool init_ok = false;
 
+#if defined(MY_SIGNING_ATSHA204_SESSION)
+// The chip's watchdog sends it to sleep 0.7s after wake-up at the earliest, an operation started
+// later than this could lose TempKey in the middle
+#define SIGNING_ATSHA204_WATCHDOG_MS (500u)
+
+static bool _signing_session = false;	// chip kept awake since _signing_session_woken
+static uint32_t _signing_session_woken = 0;
+static uint32_t _signing_session_used = 0;
+#endif
+
+static void signerAtsha204Wake(void);
+static void signerAtsha204Idle(void);
+static void signerAtsha204Sleep(void);
 static void signerCalculateSignature(MyMessage &msg, bool signing);
 static uint8_t* signerAtsha204AHmac(const uint8_t* nonce, const uint8_t* data);
 static uint8_t* signerSha256(const uint8_t* data, size_t sz);
@@ -61,7 +68,7 @@ bool signerAtsha204Init(void)
 	init_ok = true;
 	atsha204_init(MY_SIGNING_ATSHA204_PIN);
 
-	(void)atsha204_wakeup(_signing_temp_message);
+	signerAtsha204Wake();
 	// Read the configuration lock flag to determine if device is personalized or not
 	if (atsha204_read(_signing_tx_buffer, _signing_rx_buffer,
 	                  SHA204_ZONE_CONFIG, 0x15<<2) != SHA204_SUCCESS) {
@@ -86,24 +93,17 @@ bool signerAtsha204CheckTimer(void)
 	if (!init_ok) {
 		return false;
 	}
-	if (_signing_verification_ongoing) {
-		unsigned long time_now = hwMillis();
-		// If timestamp is taken so late a rollover can take place during the timeout,
-		// offset both timestamp and current time to make sure no rollover takes place during the
-		// timeout
-		if (_signing_timestamp + MY_VERIFICATION_TIMEOUT_MS < _signing_timestamp) {
-			_signing_timestamp += MY_VERIFICATION_TIMEOUT_MS;
-			time_now += MY_VERIFICATION_TIMEOUT_MS;
-		}
-		if (time_now > _signing_timestamp + MY_VERIFICATION_TIMEOUT_MS) {
-			SIGN_DEBUG(PSTR("!SGN:BND:TMR\n")); //Verification timeout
-			// Purge nonce
-			memset(_signing_signing_nonce, 0xAA, 32);
-			memset(_signing_verifying_nonce, 0xAA, 32);
-			_signing_verification_ongoing = false;
-			return false;
-		}
+	// Purge nonces whose signed message did not arrive in time
+	signerNoncePurgeExpired();
+#if defined(MY_SIGNING_ATSHA204_SESSION)
+	// End the session once signing activity stopped, or before the watchdog does
+	if (_signing_session &&
+	        ((uint32_t)(hwMillis() - _signing_session_used) >= MY_SIGNING_ATSHA204_SESSION_MS ||
+	         (uint32_t)(hwMillis() - _signing_session_woken) >= SIGNING_ATSHA204_WATCHDOG_MS)) {
+		atsha204_sleep();
+		_signing_session = false;
 	}
+#endif
 	return true;
 }
 
@@ -116,7 +116,7 @@ bool signerAtsha204GetNonce(MyMessage &msg)
 	// We used a basic whitening technique that XORs each byte in a 32byte random value with current
 	// hwMillis() counter. This 32-byte random value is then hashed (SHA256) to produce the resulting
 	// nonce
-	(void)atsha204_wakeup(_signing_temp_message);
+	signerAtsha204Wake();
 	if (atsha204_execute(SHA204_RANDOM, RANDOM_SEED_UPDATE, 0, 0, NULL,
 	                     RANDOM_COUNT, _signing_tx_buffer, RANDOM_RSP_SIZE, _signing_rx_buffer) !=
 	        SHA204_SUCCESS) {
@@ -129,7 +129,7 @@ bool signerAtsha204GetNonce(MyMessage &msg)
 	       min(MAX_PAYLOAD, 32));
 
 	// We just idle the chip now since we expect to use it soon when the signed message arrives
-	atsha204_idle();
+	signerAtsha204Idle();
 
 	if (MAX_PAYLOAD < 32) {
 		// We set the part of the 32-byte nonce that does not fit into a message to 0xAA
@@ -138,8 +138,9 @@ bool signerAtsha204GetNonce(MyMessage &msg)
 
 	// Transfer the first part of the nonce to the message
 	msg.set(_signing_verifying_nonce, min(MAX_PAYLOAD, 32));
-	_signing_verification_ongoing = true;
-	_signing_timestamp = hwMillis(); // Set timestamp to determine when to purge nonce
+	// Keep the nonce for the requesting peer until its signed message arrives
+	signerNonceStore(msg.sender, _signing_verifying_nonce);
+	memset(_signing_verifying_nonce, 0xAA, 32);
 	return true;
 }
 
@@ -185,31 +186,22 @@ bool signerAtsha204SignMsg(MyMessage &msg)
 	}
 
 	// Put device back to sleep
-	atsha204_sleep();
+	signerAtsha204Sleep();
 
-	// Overwrite the first byte in the signature with the signing identifier
-	_signing_hmac[0] = SIGNING_IDENTIFIER;
-
-	// Transfer as much signature data as the remaining space in the message permits
-	memcpy(&msg.data[mGetLength(msg)], _signing_hmac, min(MAX_PAYLOAD-mGetLength(msg), 32));
+	// Append the signature with the signing identifier
+	signerPutSignature(msg, _signing_hmac);
 
 	return true;
 }
 
 bool signerAtsha204VerifyMsg(MyMessage &msg)
 {
-	if (!_signing_verification_ongoing) {
-		SIGN_DEBUG(PSTR("!SGN:BND:VER ONGOING\n"));
+	// Fetch the nonce handed out to the sender, make sure it has not expired
+	if (!signerNonceTake(msg.sender, _signing_verifying_nonce)) {
 		return false;
 	} else {
-		// Make sure we have not expired
-		if (!signerCheckTimer()) {
-			return false;
-		}
-
-		_signing_verification_ongoing = false;
-
-		if (msg.data[mGetLength(msg)] != SIGNING_IDENTIFIER) {
+		const uint8_t signatureLength = signerCheckSignatureLength(msg);
+		if (!signatureLength) {
 			SIGN_DEBUG(PSTR("!SGN:BND:VER,IDENT=%" PRIu8 "\n"), msg.data[mGetLength(msg)]);
 			return false;
 		}
@@ -218,40 +210,35 @@ bool signerAtsha204VerifyMsg(MyMessage &msg)
 
 #ifdef MY_SIGNING_NODE_WHITELISTING
 		// Look up the senders nodeId in our whitelist and salt the signature with that data
-		size_t j;
-		for (j=0; j < NUM_OF(_signing_whitelist); j++) {
-			if (_signing_whitelist[j].nodeId == msg.sender) {
-				// We can reuse the nonce buffer now since it is no longer needed
-				memcpy(_signing_verifying_nonce, _signing_hmac, 32);
-				_signing_verifying_nonce[32] = msg.sender;
-				memcpy(&_signing_verifying_nonce[33], _signing_whitelist[j].serial, 9);
-				// We can 'void' sha256 because the hash is already put in the correct place
-				(void)signerSha256(_signing_verifying_nonce, 32+1+9);
-				SIGN_DEBUG(PSTR("SGN:BND:VER WHI,ID=%" PRIu8 "\n"), msg.sender);
+		const whitelist_entry_t *whitelisted = signerWhitelistFind(msg.sender);
+		if (whitelisted != NULL) {
+			// We can reuse the nonce buffer now since it is no longer needed
+			memcpy(_signing_verifying_nonce, _signing_hmac, 32);
+			_signing_verifying_nonce[32] = msg.sender;
+			memcpy(&_signing_verifying_nonce[33], whitelisted->serial, 9);
+			// We can 'void' sha256 because the hash is already put in the correct place
+			(void)signerSha256(_signing_verifying_nonce, 32+1+9);
+			SIGN_DEBUG(PSTR("SGN:BND:VER WHI,ID=%" PRIu8 "\n"), msg.sender);
 #ifdef MY_DEBUG_VERBOSE_SIGNING
-				hwDebugBuf2Str(_signing_whitelist[j].serial, 9);
-				SIGN_DEBUG(PSTR("SGN:BND:VER WHI,SERIAL=%s\n"), hwDebugPrintStr);
+			hwDebugBuf2Str(whitelisted->serial, 9);
+			SIGN_DEBUG(PSTR("SGN:BND:VER WHI,SERIAL=%s\n"), hwDebugPrintStr);
 #endif
-				break;
-			}
-		}
-		if (j == NUM_OF(_signing_whitelist)) {
+		} else {
 			SIGN_DEBUG(PSTR("!SGN:BND:VER WHI,ID=%" PRIu8 " MISSING\n"), msg.sender);
 			// Put device back to sleep
-			atsha204_sleep();
+			signerAtsha204Sleep();
 			return false;
 		}
 #endif
 
 		// Put device back to sleep
-		atsha204_sleep();
+		signerAtsha204Sleep();
 
 		// Overwrite the first byte in the signature with the signing identifier
-		_signing_hmac[0] = SIGNING_IDENTIFIER;
+		_signing_hmac[0] = msg.data[mGetLength(msg)];
 
 		// Compare the calculated signature with the provided signature
-		if (signerMemcmp(&msg.data[mGetLength(msg)], _signing_hmac,
-		                 min(MAX_PAYLOAD-mGetLength(msg), 32))) {
+		if (signerMemcmp(&msg.data[mGetLength(msg)], _signing_hmac, signatureLength)) {
 			return false;
 		} else {
 			return true;
@@ -259,6 +246,45 @@ bool signerAtsha204VerifyMsg(MyMessage &msg)
 	}
 }
 
+// Wake the chip for an operation. In a session the chip stays awake between operations, it is
+// only woken again when the watchdog could interrupt the next one.
+static void signerAtsha204Wake(void)
+{
+#if defined(MY_SIGNING_ATSHA204_SESSION)
+	if (_signing_session) {
+		if ((uint32_t)(hwMillis() - _signing_session_woken) < SIGNING_ATSHA204_WATCHDOG_MS) {
+			return;
+		}
+		// Idle keeps TempKey, the wakeup resets the watchdog
+		atsha204_idle();
+	}
+	_signing_session = true;
+	_signing_session_woken = hwMillis();
+	_signing_session_used = _signing_session_woken;
+#endif
+	(void)atsha204_wakeup(_signing_temp_message);
+}
+
+// End of an operation that expects the next one soon
+static void signerAtsha204Idle(void)
+{
+#if defined(MY_SIGNING_ATSHA204_SESSION)
+	_signing_session_used = hwMillis();
+#else
+	atsha204_idle();
+#endif
+}
+
+// End of an operation, signerAtsha204CheckTimer() ends the session
+static void signerAtsha204Sleep(void)
+{
+#if defined(MY_SIGNING_ATSHA204_SESSION)
+	_signing_session_used = hwMillis();
+#else
+	atsha204_sleep();
+#endif
+}
+
 // Helper to calculate signature of msg (returned in _signing_rx_buffer[SHA204_BUFFER_POS_DATA])
 // (=_signing_hmac)
 static void signerCalculateSignature(MyMessage &msg, bool signing)
@@ -276,7 +302,7 @@ static void signerCalculateSignature(MyMessage &msg, bool signing)
 	while (bytes_left) {
 		uint16_t bytes_to_include = min(bytes_left, 32);
 
-		(void)atsha204_wakeup(_signing_temp_message); // Issue wakeup to reset watchdog
+		signerAtsha204Wake(); // Issue wakeup to reset watchdog
 		memset(_signing_temp_message, 0, 32);
 		memcpy(_signing_temp_message, (uint8_t*)&msg.data[current_pos], bytes_to_include);
 
@@ -291,7 +317,7 @@ static void signerCalculateSignature(MyMessage &msg, bool signing)
 		if (bytes_left > 0) {
 			// We will do another pass, use current HMAC as nonce for the next HMAC
 			memcpy(nonce, _signing_hmac, 32);
-			atsha204_idle(); // Idle the chip to allow the wakeup call to reset the watchdog
+			signerAtsha204Idle(); // Idle the chip to allow the wakeup call to reset the watchdog
 		}
 	}
 #ifdef MY_DEBUG_VERBOSE_SIGNING
@@ -32,7 +32,6 @@
 #include "MyHelperFunctions.h"
 
 #ifdef MY_SIGNING_SOFT
-#define SIGNING_IDENTIFIER (1) //HMAC-SHA256
 
 #if defined(MY_DEBUG_VERBOSE_SIGNING)
 #define SIGN_DEBUG(x,...) DEBUG_OUTPUT(x, ##__VA_ARGS__)
@@ -40,47 +39,105 @@
 #define SIGN_DEBUG(x,...)
 #endif
 
-static unsigned long _signing_timestamp;
-static bool _signing_verification_ongoing = false;
 static bool _signing_init_ok = false;
-static uint8_t _signing_verifying_nonce[32+9+1];
+// the verification buffers are per thread when verifying in parallel
+static MY_CRYPTO_THREAD_LOCAL uint8_t _signing_verifying_nonce[32+9+1];
 static uint8_t _signing_nonce[32+9+1];
-static uint8_t _signing_hmac_key[SIZE_SIGNING_SOFT_HMAC_KEY];
-static uint8_t _signing_hmac[32];
+static MY_CRYPTO_THREAD_LOCAL uint8_t _signing_hmac[32];
 static uint8_t _signing_node_serial_info[SIZE_SIGNING_SOFT_SERIAL];
 
-#ifdef MY_SIGNING_NODE_WHITELISTING
-static const whitelist_entry_t _signing_whitelist[] = MY_SIGNING_NODE_WHITELISTING;
+#if defined(MY_SIGNING_NONCE_POOL)
+typedef struct {
+	uint32_t timestamp;	// hwMillis() when the nonce was generated
+	uint8_t nonce[32];
+} signerNoncePoolEntry_t;
+
+// ring buffer, the oldest nonce is handed out first
+static signerNoncePoolEntry_t _signingNoncePool[MY_SIGNING_NONCE_POOL_SIZE];
+static uint8_t _signingNoncePoolHead = 0;
+static uint8_t _signingNoncePoolCount = 0;
 #endif
 
+
 static void signerCalculateSignature(MyMessage &msg, const bool signing);
 static void signerAtsha204AHmac(uint8_t *dest, const uint8_t *nonce, const uint8_t *data);
 
+// Helper to generate a nonce
+static void signerAtsha204SoftGenerateNonce(uint8_t *nonce)
+{
+#ifdef MY_HW_HAS_GETENTROPY
+	// Try to get MAX_PAYLOAD random bytes
+	while (hwGetentropy(nonce, MAX_PAYLOAD) != MAX_PAYLOAD);
+#else
+	// We used a basic whitening technique that XORs a random byte with the current hwMillis() counter
+	// and then the byte is hashed (SHA256) to produce the resulting nonce
+	uint8_t randBuffer[32];
+	for (uint8_t i = 0; i < sizeof(randBuffer); i++) {
+		randBuffer[i] = random(256) ^ (hwMillis() & 0xFF);
+	}
+	SHA256(nonce, randBuffer, sizeof(randBuffer));
+#endif
+
+	if (MAX_PAYLOAD < 32) {
+		// We set the part of the 32-byte nonce that does not fit into a message to 0xAA
+		(void)memset((void *)&nonce[MAX_PAYLOAD], 0xAA, 32-MAX_PAYLOAD);
+	}
+}
+
+#if defined(MY_SIGNING_NONCE_POOL)
+// Helper to drop the expired nonces of the pool and generate one more, the cost is spread over the
+// loop iterations
+static void signerAtsha204SoftNoncePoolProcess(void)
+{
+	while (_signingNoncePoolCount &&
+	        hwMillis() - _signingNoncePool[_signingNoncePoolHead].timestamp > MY_SIGNING_NONCE_POOL_MAX_AGE_MS) {
+		(void)memset((void *)_signingNoncePool[_signingNoncePoolHead].nonce, 0xAA, 32);
+		_signingNoncePoolHead = (_signingNoncePoolHead + 1) % MY_SIGNING_NONCE_POOL_SIZE;
+		_signingNoncePoolCount--;
+	}
+	if (_signingNoncePoolCount < MY_SIGNING_NONCE_POOL_SIZE) {
+		signerNoncePoolEntry_t &entry = _signingNoncePool[(_signingNoncePoolHead + _signingNoncePoolCount) %
+		                                MY_SIGNING_NONCE_POOL_SIZE];
+		signerAtsha204SoftGenerateNonce(entry.nonce);
+		entry.timestamp = hwMillis();
+		_signingNoncePoolCount++;
+	}
+}
+
+uint8_t signerNoncePoolDepth(void)
+{
+	return _signingNoncePoolCount;
+}
+#endif
+
 bool signerAtsha204SoftInit(void)
 {
 	_signing_init_ok = true;
 	// initialize pseudo-RNG
 	hwRandomNumberInit();
-	// Set secrets
+	// Set secrets, the HMAC key is only kept as precomputed hash state
+	uint8_t hmacKey[SIZE_SIGNING_SOFT_HMAC_KEY];
 #ifdef MY_SIGNING_SIMPLE_PASSWD
 	if (strnlen(MY_SIGNING_SIMPLE_PASSWD, 32) < 8) {
 		SIGN_DEBUG(PSTR("!SGN:BND:PWD<8\n")); //Password is too short to be acceptable
 		_signing_init_ok = false;
 	} else {
-		(void)memset((void *)_signing_hmac_key, 0x00, sizeof(_signing_hmac_key));
-		(void)memcpy((void *)_signing_hmac_key, MY_SIGNING_SIMPLE_PASSWD, strnlen(MY_SIGNING_SIMPLE_PASSWD,
-		             32));
+		(void)memset((void *)hmacKey, 0x00, sizeof(hmacKey));
+		(void)memcpy((void *)hmacKey, MY_SIGNING_SIMPLE_PASSWD, strnlen(MY_SIGNING_SIMPLE_PASSWD, 32));
 		(void)memset((void *)_signing_node_serial_info, 0x00, sizeof(_signing_node_serial_info));
 		(void)memcpy((void *)_signing_node_serial_info, MY_SIGNING_SIMPLE_PASSWD,
 		             strnlen(MY_SIGNING_SIMPLE_PASSWD, 8));
 		_signing_node_serial_info[8] = getNodeId();
+		SHA256HMACSetKey(hmacKey, sizeof(hmacKey));
 	}
 #else
-	hwReadConfigBlock((void *)_signing_hmac_key, (void *)EEPROM_SIGNING_SOFT_HMAC_KEY_ADDRESS,
+	hwReadConfigBlock((void *)hmacKey, (void *)EEPROM_SIGNING_SOFT_HMAC_KEY_ADDRESS,
 	                  SIZE_SIGNING_SOFT_HMAC_KEY);
 	hwReadConfigBlock((void *)_signing_node_serial_info, (void *)EEPROM_SIGNING_SOFT_SERIAL_ADDRESS,
 	                  SIZE_SIGNING_SOFT_SERIAL);
+	SHA256HMACSetKey(hmacKey, sizeof(hmacKey));
 #endif
+	(void)memset((void *)hmacKey, 0x00, sizeof(hmacKey));
 
 	uint16_t chk = 0;
 	for (uint8_t i = 0; i < SIZE_SIGNING_SOFT_SERIAL; i++) {
@@ -103,24 +160,11 @@ bool signerAtsha204SoftCheckTimer(void)
 	if (!_signing_init_ok) {
 		return false;
 	}
-	if (_signing_verification_ongoing) {
-		unsigned long time_now = hwMillis();
-		// If timestamp is taken so late a rollover can take place during the timeout,
-		// offset both timestamp and current time to make sure no rollover takes place during the
-		// timeout
-		if (_signing_timestamp + MY_VERIFICATION_TIMEOUT_MS < _signing_timestamp) {
-			_signing_timestamp += MY_VERIFICATION_TIMEOUT_MS;
-			time_now += MY_VERIFICATION_TIMEOUT_MS;
-		}
-		if (time_now > _signing_timestamp + MY_VERIFICATION_TIMEOUT_MS) {
-			SIGN_DEBUG(PSTR("!SGN:BND:TMR\n")); //Verification timeout
-			// Purge nonce
-			(void)memset((void *)_signing_nonce, 0xAA, sizeof(_signing_nonce));
-			(void)memset((void *)_signing_verifying_nonce, 0xAA, sizeof(_signing_verifying_nonce));
-			_signing_verification_ongoing = false;
-			return false;
-		}
-	}
+	// Purge nonces whose signed message did not arrive in time
+	signerNoncePurgeExpired();
+#if defined(MY_SIGNING_NONCE_POOL)
+	signerAtsha204SoftNoncePoolProcess();
+#endif
 	return true;
 }
 
@@ -130,34 +174,27 @@ bool signerAtsha204SoftGetNonce(MyMessage &msg)
 		return false;
 	}
 
-#ifdef MY_HW_HAS_GETENTROPY
-	// Try to get MAX_PAYLOAD random bytes
-	while (hwGetentropy(&_signing_verifying_nonce, MAX_PAYLOAD) != MAX_PAYLOAD);
-#else
-	// We used a basic whitening technique that XORs a random byte with the current hwMillis() counter
-	// and then the byte is hashed (SHA256) to produce the resulting nonce
-	uint8_t randBuffer[32];
-	for (uint8_t i = 0; i < sizeof(randBuffer); i++) {
-		randBuffer[i] = random(256) ^ (hwMillis() & 0xFF);
+#if defined(MY_SIGNING_NONCE_POOL)
+	if (_signingNoncePoolCount) {
+		signerNoncePoolEntry_t &entry = _signingNoncePool[_signingNoncePoolHead];
+		(void)memcpy((void *)_signing_verifying_nonce, (const void *)entry.nonce, sizeof(entry.nonce));
+		(void)memset((void *)entry.nonce, 0xAA, sizeof(entry.nonce));
+		_signingNoncePoolHead = (_signingNoncePoolHead + 1) % MY_SIGNING_NONCE_POOL_SIZE;
+		_signingNoncePoolCount--;
+		STATS_INC(STATS_NONCE_POOL_HITS);
+	} else {
+		signerAtsha204SoftGenerateNonce(_signing_verifying_nonce);
+		STATS_INC(STATS_NONCE_POOL_MISSES);
 	}
-	SHA256(_signing_verifying_nonce, randBuffer, sizeof(randBuffer));
+#else
+	signerAtsha204SoftGenerateNonce(_signing_verifying_nonce);
 #endif
 
-	if (MAX_PAYLOAD < 32) {
-		// We set the part of the 32-byte nonce that does not fit into a message to 0xAA
-		(void)memset((void *)&_signing_verifying_nonce[MAX_PAYLOAD], 0xAA, 32-MAX_PAYLOAD);
-	}
-
 	// Transfer the first part of the nonce to the message
 	msg.set(_signing_verifying_nonce, MIN((uint8_t)MAX_PAYLOAD, (uint8_t)32));
-	_signing_verification_ongoing = true;
-	_signing_timestamp = hwMillis(); // Set timestamp to determine when to purge nonce
-	// Be a little fancy to handle turnover (prolong the time allowed to timeout after turnover)
-	// Note that if message is "too" quick, and arrives before turnover, it will be rejected
-	// but this is consider such a rare case that it is accepted and rejects are 'safe'
-	if (_signing_timestamp + MY_VERIFICATION_TIMEOUT_MS < hwMillis()) {
-		_signing_timestamp = 0;
-	}
+	// Keep the nonce for the requesting peer until its signed message arrives
+	signerNonceStore(msg.sender, _signing_verifying_nonce);
+	(void)memset((void *)_signing_verifying_nonce, 0xAA, sizeof(_signing_verifying_nonce));
 	return true;
 }
 
@@ -201,70 +238,63 @@ bool signerAtsha204SoftSignMsg(MyMessage &msg)
 #endif
 	}
 
-	// Overwrite the first byte in the signature with the signing identifier
-	_signing_hmac[0] = SIGNING_IDENTIFIER;
-
-	// Transfer as much signature data as the remaining space in the message permits
-	(void)memcpy((void *)&msg.data[mGetLength(msg)], (const void *)_signing_hmac,
-	             MIN((uint8_t)(MAX_PAYLOAD-mGetLength(msg)), (uint8_t)32));
+	// Append the signature with the signing identifier
+	signerPutSignature(msg, _signing_hmac);
 
 	return true;
 }
 
 bool signerAtsha204SoftVerifyMsg(MyMessage &msg)
 {
-	if (!_signing_verification_ongoing) {
-		SIGN_DEBUG(PSTR("!SGN:BND:VER ONGOING\n"));
+	// Fetch the nonce handed out to the sender, make sure it has not expired
+	if (!signerNonceTake(msg.sender, _signing_verifying_nonce)) {
 		return false;
 	} else {
-		// Make sure we have not expired
-		if (!signerCheckTimer()) {
-			return false;
-		}
-
-		_signing_verification_ongoing = false;
+		return signerAtsha204SoftVerifyWithNonce(msg, _signing_verifying_nonce);
+	}
+}
 
-		if (msg.data[mGetLength(msg)] != SIGNING_IDENTIFIER) {
-			SIGN_DEBUG(PSTR("!SGN:BND:VER,IDENT=%" PRIu8 "\n"), msg.data[mGetLength(msg)]);
-			return false;
-		}
+bool signerAtsha204SoftVerifyWithNonce(MyMessage &msg, const uint8_t *nonce)
+{
+	if (nonce != _signing_verifying_nonce) {
+		(void)memcpy((void *)_signing_verifying_nonce, (const void *)nonce, 32);
+	}
+	const uint8_t signatureLength = signerCheckSignatureLength(msg);
+	if (!signatureLength) {
+		SIGN_DEBUG(PSTR("!SGN:BND:VER,IDENT=%" PRIu8 "\n"), msg.data[mGetLength(msg)]);
+		return false;
+	}
 
-		signerCalculateSignature(msg, false); // Get signature of message
+	signerCalculateSignature(msg, false); // Get signature of message
 
 #ifdef MY_SIGNING_NODE_WHITELISTING
-		// Look up the senders nodeId in our whitelist and salt the signature with that data
-		size_t j;
-		for (j = 0; j < NUM_OF(_signing_whitelist); j++) {
-			if (_signing_whitelist[j].nodeId == msg.sender) {
-				// We can reuse the nonce buffer now since it is no longer needed
-				(void)memcpy((void *)_signing_verifying_nonce, (const void *)_signing_hmac, 32);
-				_signing_verifying_nonce[32] = msg.sender;
-				(void)memcpy((void *)&_signing_verifying_nonce[33], (const void *)_signing_whitelist[j].serial, 9);
-				SHA256(_signing_hmac, _signing_verifying_nonce, 32+1+9);
-				SIGN_DEBUG(PSTR("SGN:BND:VER WHI,ID=%" PRIu8 "\n"), msg.sender);
+	// Look up the senders nodeId in our whitelist and salt the signature with that data
+	const whitelist_entry_t *whitelisted = signerWhitelistFind(msg.sender);
+	if (whitelisted != NULL) {
+		// We can reuse the nonce buffer now since it is no longer needed
+		(void)memcpy((void *)_signing_verifying_nonce, (const void *)_signing_hmac, 32);
+		_signing_verifying_nonce[32] = msg.sender;
+		(void)memcpy((void *)&_signing_verifying_nonce[33], (const void *)whitelisted->serial, 9);
+		SHA256(_signing_hmac, _signing_verifying_nonce, 32+1+9);
+		SIGN_DEBUG(PSTR("SGN:BND:VER WHI,ID=%" PRIu8 "\n"), msg.sender);
 #ifdef MY_DEBUG_VERBOSE_SIGNING
-				hwDebugBuf2Str(_signing_whitelist[j].serial, 9);
-				SIGN_DEBUG(PSTR("SGN:BND:VER WHI,SERIAL=%s\n"), hwDebugPrintStr);
+		hwDebugBuf2Str(whitelisted->serial, 9);
+		SIGN_DEBUG(PSTR("SGN:BND:VER WHI,SERIAL=%s\n"), hwDebugPrintStr);
 #endif
-				break;
-			}
-		}
-		if (j == NUM_OF(_signing_whitelist)) {
-			SIGN_DEBUG(PSTR("!SGN:BND:VER WHI,ID=%" PRIu8 " MISSING\n"), msg.sender);
-			return false;
-		}
+	} else {
+		SIGN_DEBUG(PSTR("!SGN:BND:VER WHI,ID=%" PRIu8 " MISSING\n"), msg.sender);
+		return false;
+	}
 #endif
 
-		// Overwrite the first byte in the signature with the signing identifier
-		_signing_hmac[0] = SIGNING_IDENTIFIER;
+	// Overwrite the first byte in the signature with the signing identifier
+	_signing_hmac[0] = msg.data[mGetLength(msg)];
 
-		// Compare the calculated signature with the provided signature
-		if (signerMemcmp(&msg.data[mGetLength(msg)], _signing_hmac,
-		                 MIN((uint8_t)(MAX_PAYLOAD-mGetLength(msg)), (uint8_t)32))) {
-			return false;
-		} else {
-			return true;
-		}
+	// Compare the calculated signature with the provided signature
+	if (signerMemcmp(&msg.data[mGetLength(msg)], _signing_hmac, signatureLength)) {
+		return false;
+	} else {
+		return true;
 	}
 }
 
@@ -334,7 +364,9 @@ static void signerAtsha204AHmac(uint8_t *dest, const uint8_t *nonce, const uint8
 	// 25 bytes zeroes
 	// 32 bytes nonce
 
-#if defined(MY_CRYPTO_SHA256_ASM)
+#if defined(MY_SHARED_BUFFERS)
+	uint8_t (&_signing_buffer)[96] = _coreSharedBuffers.signing;
+#elif defined(MY_CRYPTO_SHA256_ASM)
 	static uint8_t _signing_buffer[96]; // static for AVR ASM SHA256
 #else
 	uint8_t _signing_buffer[96];
@@ -367,7 +399,7 @@ static void signerAtsha204AHmac(uint8_t *dest, const uint8_t *nonce, const uint8
 	_signing_buffer[21 + 64] = 0x23;
 	//_signing_buffer[22 + 64] = 0x00; // SN[0]
 	//_signing_buffer[23 + 64] = 0x00; // SN[1]
-	SHA256HMAC(dest, _signing_hmac_key, 32, _signing_buffer, 88);
+	SHA256HMACWithKey(dest, _signing_buffer, 88);
 }
 
 #endif //MY_SIGNING_SOFT
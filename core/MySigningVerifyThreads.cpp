@@ -0,0 +1,143 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// Signature verification of received batches on several threads. The core thread runs the checks
+// of signerVerifyMsg() and takes the nonces, the verifying threads only calculate and compare the
+// signatures with their own hash state. The core thread is one of them and waits for the others
+// before the results are applied in order.
+
+#include <pthread.h>
+
+typedef struct {
+	MyMessage *msg;		// message in the batch
+	uint8_t check;		// SIGNER_VERIFY_xxx outcome of signerVerifyCheck()
+	bool pending;		// backend verification to run, a nonce was taken
+	bool verified;		// result of the backend
+	uint8_t nonce[32];
+} signerVerifyJob_t;
+
+static signerVerifyJob_t _signerVerifyJobs[MY_LINUX_SIGNING_VERIFY_BATCH];
+static uint8_t _signerVerifyJobCount = 0;
+static uint8_t _signerVerifyShards = 0;		// verifying threads including the core, 0 not started
+static uint8_t _signerVerifyBusy = 0;		// threads still working on the current batch
+static uint32_t _signerVerifyGeneration = 0;	// counts the batches handed to the threads
+static pthread_mutex_t _signerVerifyMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _signerVerifyStartCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t _signerVerifyDoneCond = PTHREAD_COND_INITIALIZER;
+
+static void signerVerifyShard(const uint8_t shard, const uint8_t shards)
+{
+	for (uint8_t i = 0; i < _signerVerifyJobCount; i++) {
+		signerVerifyJob_t &job = _signerVerifyJobs[i];
+		if (job.pending && job.msg->sender % shards == shard) {
+			job.verified = signerAtsha204SoftVerifyWithNonce(*job.msg, job.nonce);
+			(void)memset((void *)job.nonce, 0xAA, sizeof(job.nonce));
+		}
+	}
+}
+
+static void *signerVerifyThread(void *arg)
+{
+	const uint8_t shard = (uint8_t)(intptr_t)arg;
+	uint32_t generation = 0;
+	pthread_mutex_lock(&_signerVerifyMutex);
+	for (;;) {
+		while (generation == _signerVerifyGeneration) {
+			pthread_cond_wait(&_signerVerifyStartCond, &_signerVerifyMutex);
+		}
+		generation = _signerVerifyGeneration;
+		pthread_mutex_unlock(&_signerVerifyMutex);
+		signerVerifyShard(shard, _signerVerifyShards);
+		pthread_mutex_lock(&_signerVerifyMutex);
+		if (--_signerVerifyBusy == 0) {
+			pthread_cond_signal(&_signerVerifyDoneCond);
+		}
+	}
+	return NULL;
+}
+
+static void signerVerifyThreadsStart(void)
+{
+	_signerVerifyShards = 1;
+	for (uint8_t shard = 1; shard < MY_LINUX_SIGNING_VERIFY_THREADS; shard++) {
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, signerVerifyThread, (void *)(intptr_t)shard) != 0) {
+			SIGN_DEBUG(PSTR("!SGN:VTH:START FAIL\n"));
+			break;
+		}
+		(void)pthread_detach(thread);
+		_signerVerifyShards++;
+	}
+	SIGN_DEBUG(PSTR("SGN:VTH:START,T=%" PRIu8 "\n"), _signerVerifyShards);
+}
+
+void signerVerifyBatch(MyMessage *msgs, bool *results, const uint8_t count)
+{
+	PROFILING_SCOPE(PROFILING_SIGNER_VERIFY);
+	if (!_signerVerifyShards) {
+		signerVerifyThreadsStart();
+	}
+	uint8_t pending = 0;
+	for (uint8_t i = 0; i < count; i++) {
+		signerVerifyJob_t &job = _signerVerifyJobs[i];
+		job.msg = &msgs[i];
+		job.check = signerVerifyCheck(msgs[i]);
+		// nonces are taken in the order received, as signerVerifyMsg() does
+		job.pending = job.check == SIGNER_VERIFY_BACKEND && signerNonceTake(msgs[i].sender, job.nonce);
+		job.verified = false;
+		pending += job.pending;
+	}
+	_signerVerifyJobCount = count;
+	if (pending > 1 && _signerVerifyShards > 1) {
+		pthread_mutex_lock(&_signerVerifyMutex);
+		_signerVerifyBusy = _signerVerifyShards - 1;
+		_signerVerifyGeneration++;
+		pthread_cond_broadcast(&_signerVerifyStartCond);
+		pthread_mutex_unlock(&_signerVerifyMutex);
+		signerVerifyShard(0, _signerVerifyShards);
+		pthread_mutex_lock(&_signerVerifyMutex);
+		while (_signerVerifyBusy) {
+			pthread_cond_wait(&_signerVerifyDoneCond, &_signerVerifyMutex);
+		}
+		pthread_mutex_unlock(&_signerVerifyMutex);
+	} else if (pending) {
+		signerVerifyShard(0, 1);
+	}
+	for (uint8_t i = 0; i < count; i++) {
+		signerVerifyJob_t &job = _signerVerifyJobs[i];
+		if (job.check == SIGNER_VERIFY_OK) {
+			results[i] = true;
+		} else if (job.check == SIGNER_VERIFY_UNSIGNED) {
+			results[i] = false;
+		} else if (job.check == SIGNER_VERIFY_STATE) {
+			results[i] = signerVerifyDone(msgs[i], false);
+		} else {
+			if (!job.verified) {
+				SIGN_DEBUG(PSTR("!SGN:VER:FAIL\n")); // Signature verification failed!
+			} else {
+				SIGN_DEBUG(PSTR("SGN:VER:OK\n"));
+			}
+			results[i] = signerVerifyDone(msgs[i], job.verified);
+		}
+		if (!results[i]) {
+			STATS_INC(STATS_VERIFY_FAILURES);
+		}
+	}
+	_signerVerifyJobCount = 0;
+}
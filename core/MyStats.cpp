@@ -0,0 +1,347 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyStats.h"
+#if defined(MY_SIGNING_NONCE_POOL)
+#include "MySigning.h"
+#endif
+
+uint32_t _statsCounters[STATS_COUNTERS];
+#if defined(MY_GATEWAY_FEATURE)
+uint32_t _statsClientRxBytes[MY_GATEWAY_MAX_CLIENTS];
+uint32_t _statsClientTxBytes[MY_GATEWAY_MAX_CLIENTS];
+#endif
+#if defined(MY_STATS_LATENCY)
+static statsHistogram_t _statsLatencies[STATS_LATENCIES];
+STATS_THREAD_LOCAL uint32_t _statsUplinkOrigin = 0;
+STATS_THREAD_LOCAL uint32_t _statsDownlinkOrigin = 0;
+#endif
+#if defined(STATS_LINKS)
+static statsLink_t _statsLinks[MY_STATS_LINK_SLOTS];
+#endif
+
+uint32_t statsGet(const uint8_t counter)
+{
+	return counter < STATS_COUNTERS ? _statsCounters[counter] : 0;
+}
+
+void statsReset(void)
+{
+	(void)memset((void *)_statsCounters, 0, sizeof(_statsCounters));
+#if defined(MY_GATEWAY_FEATURE)
+	(void)memset((void *)_statsClientRxBytes, 0, sizeof(_statsClientRxBytes));
+	(void)memset((void *)_statsClientTxBytes, 0, sizeof(_statsClientTxBytes));
+#endif
+#if defined(MY_STATS_LATENCY)
+	(void)memset((void *)_statsLatencies, 0, sizeof(_statsLatencies));
+#endif
+#if defined(STATS_LINKS)
+	(void)memset((void *)_statsLinks, 0, sizeof(_statsLinks));
+#endif
+}
+
+#if defined(STATS_LINKS)
+static statsLink_t *_statsLinkFind(const nodeId_t node)
+{
+	for (uint8_t i = 0; i < MY_STATS_LINK_SLOTS; i++) {
+		if (_statsLinks[i].node == node) {
+			return &_statsLinks[i];
+		}
+	}
+	return NULL;
+}
+
+void statsLinkRecord(const nodeId_t node, const uint8_t sequence)
+{
+	const uint32_t now = hwMillis();
+	statsLink_t *link = _statsLinkFind(node);
+	if (link == NULL) {
+		// an unused slot, else the node heard least recently
+		link = &_statsLinks[0];
+		for (uint8_t i = 0; i < MY_STATS_LINK_SLOTS && link->node != GATEWAY_ADDRESS; i++) {
+			if (_statsLinks[i].node == GATEWAY_ADDRESS || now - _statsLinks[i].lastMS > now - link->lastMS) {
+				link = &_statsLinks[i];
+			}
+		}
+		(void)memset((void *)link, 0, sizeof(statsLink_t));
+		link->node = node;
+		link->sequence = sequence;
+		link->received = 1u;
+		link->lastMS = now;
+		return;
+	}
+	uint8_t delta = sequence - link->sequence;
+	if (!sequence) {
+		// 0 is only sent once after booting
+		link->restarts++;
+		link->received++;
+		link->sequence = sequence;
+		link->lastMS = now;
+	} else if (!delta) {
+		link->duplicates++;
+	} else if (delta < 128u) {
+		if (sequence < link->sequence) {
+			// wrapped around, 0 is skipped
+			delta--;
+		}
+		link->received++;
+		link->lost += delta - 1u;
+		const int32_t interval = (int32_t)((now - link->lastMS) / delta);
+		if (!link->intervalMS) {
+			link->intervalMS = interval;
+		} else {
+			// smoothed like the RFC 3550 jitter, the interval itself adapts slower
+			const int32_t difference = interval - (int32_t)link->intervalMS;
+			const int32_t deviation = difference < 0 ? -difference : difference;
+			link->jitterMS += (deviation - (int32_t)link->jitterMS) / 16;
+			link->intervalMS += (interval - (int32_t)link->intervalMS) / 8;
+		}
+		link->sequence = sequence;
+		link->lastMS = now;
+	} else {
+		// older than the last one, it was counted as lost
+		link->reordered++;
+		link->received++;
+		if (link->lost) {
+			link->lost--;
+		}
+	}
+}
+
+statsLink_t statsLinkGet(const nodeId_t node)
+{
+	const statsLink_t *link = _statsLinkFind(node);
+	statsLink_t result;
+	if (link != NULL && node != GATEWAY_ADDRESS) {
+		result = *link;
+	} else {
+		(void)memset((void *)&result, 0, sizeof(result));
+	}
+	return result;
+}
+#endif
+
+#if defined(MY_STATS_LATENCY)
+uint32_t statsLatencyStamp(void)
+{
+	const uint32_t now = hwMicros();
+	return now ? now : 1u;
+}
+
+void statsLatencyRecord(const uint8_t histogram, const uint32_t origin)
+{
+	if (!origin || histogram >= STATS_LATENCIES) {
+		return;
+	}
+	const uint32_t latency = hwMicros() - origin;
+	statsHistogram_t *hist = &_statsLatencies[histogram];
+	uint8_t bucket = 0;
+	while (bucket < STATS_LATENCY_BUCKETS - 1 && latency >= STATS_LATENCY_BUCKET_US(bucket)) {
+		bucket++;
+	}
+	hist->buckets[bucket]++;
+	hist->count++;
+	hist->sum += latency;
+	if (latency > hist->max) {
+		hist->max = latency;
+	}
+}
+
+statsHistogram_t statsLatencyGet(const uint8_t histogram)
+{
+	statsHistogram_t hist;
+	if (histogram < STATS_LATENCIES) {
+		hist = _statsLatencies[histogram];
+	} else {
+		(void)memset((void *)&hist, 0, sizeof(hist));
+	}
+	return hist;
+}
+
+uint32_t statsLatencyPercentile(const uint8_t histogram, const uint8_t percent)
+{
+	const statsHistogram_t hist = statsLatencyGet(histogram);
+	if (!hist.count) {
+		return 0;
+	}
+	// rank of the percentile, rounded up
+	const uint32_t rank = (uint32_t)(((uint64_t)hist.count * percent + 99u) / 100u);
+	uint32_t seen = 0;
+	for (uint8_t i = 0; i < STATS_LATENCY_BUCKETS - 1; i++) {
+		seen += hist.buckets[i];
+		if (seen >= rank) {
+			return min((uint32_t)STATS_LATENCY_BUCKET_US(i), hist.max);
+		}
+	}
+	return hist.max;
+}
+#endif
+
+#if defined(__linux__)
+#include <inttypes.h>
+#include "hal/architecture/Linux/drivers/core/SlabPool.h"
+
+// metric names, in the order of statsCounter_t
+static const char *const _statsNames[STATS_COUNTERS] = {
+	"tx_frames",
+	"tx_nack",
+	"tx_retries",
+	"tx_dropped",
+	"tx_queue_full",
+	"uplink_failures",
+	"rx_frames",
+	"rx_duplicates",
+	"rx_overflows",
+	"sign_failures",
+	"verify_failures",
+	"gw_rx_messages",
+	"gw_tx_messages",
+	"gw_tx_failures",
+	"gw_parse_errors",
+	"tx_airtime_ms",
+	"tx_duty_cycle",
+	"gw_tx_suppressed",
+	"gw_rx_overflows",
+	"tx_paced",
+	"nonce_pool_hits",
+	"nonce_pool_misses",
+	"rx_cut_through",
+	"bc_suppressed"
+};
+
+#if defined(MY_STATS_LATENCY)
+// path and stage labels, in the order of statsLatency_t
+static const char *const _statsLatencyLabels[STATS_LATENCIES] = {
+	"path=\"uplink\",stage=\"dequeue\"",
+	"path=\"uplink\",stage=\"verify\"",
+	"path=\"uplink\",stage=\"format\"",
+	"path=\"uplink\",stage=\"write\"",
+	"path=\"downlink\",stage=\"dequeue\"",
+	"path=\"downlink\",stage=\"send\""
+};
+#endif
+
+size_t statsRender(char *buffer, const size_t size)
+{
+	size_t length = 0;
+	for (uint8_t i = 0; i < STATS_COUNTERS && length < size; i++) {
+		length += snprintf(&buffer[length], size - length,
+		                   "# TYPE mysensors_%s_total counter\nmysensors_%s_total %" PRIu32 "\n",
+		                   _statsNames[i], _statsNames[i], _statsCounters[i]);
+	}
+	// the message pools of the gateway
+	if (length < size) {
+		length += slabPoolRender(&buffer[length], size - length);
+	}
+#if defined(MY_SIGNING_NONCE_POOL)
+	if (length < size) {
+		length += snprintf(&buffer[length], size - length,
+		                   "# TYPE mysensors_nonce_pool_depth gauge\nmysensors_nonce_pool_depth %" PRIu8 "\n",
+		                   signerNoncePoolDepth());
+	}
+#endif
+#if defined(MY_GATEWAY_FEATURE)
+	// bytes per controller connection
+	for (uint8_t dir = 0; dir < 2; dir++) {
+		const char *name = dir ? "tx" : "rx";
+		const uint32_t *bytes = dir ? _statsClientTxBytes : _statsClientRxBytes;
+		if (length < size) {
+			length += snprintf(&buffer[length], size - length,
+			                   "# TYPE mysensors_gw_client_%s_bytes_total counter\n", name);
+		}
+		for (uint8_t i = 0; i < MY_GATEWAY_MAX_CLIENTS && length < size; i++) {
+			length += snprintf(&buffer[length], size - length,
+			                   "mysensors_gw_client_%s_bytes_total{client=\"%" PRIu8 "\"} %" PRIu32 "\n", name, i,
+			                   bytes[i]);
+		}
+	}
+#endif
+#if defined(MY_STATS_LATENCY)
+	// histograms in seconds, percentiles estimated from the buckets
+	if (length < size) {
+		length += snprintf(&buffer[length], size - length,
+		                   "# TYPE mysensors_latency_seconds histogram\n");
+	}
+	for (uint8_t h = 0; h < STATS_LATENCIES && length < size; h++) {
+		const statsHistogram_t hist = statsLatencyGet(h);
+		uint32_t cumulative = 0;
+		for (uint8_t i = 0; i < STATS_LATENCY_BUCKETS - 1 && length < size; i++) {
+			cumulative += hist.buckets[i];
+			length += snprintf(&buffer[length], size - length,
+			                   "mysensors_latency_seconds_bucket{%s,le=\"%.6f\"} %" PRIu32 "\n",
+			                   _statsLatencyLabels[h], STATS_LATENCY_BUCKET_US(i) / 1e6, cumulative);
+		}
+		if (length < size) {
+			length += snprintf(&buffer[length], size - length,
+			                   "mysensors_latency_seconds_bucket{%s,le=\"+Inf\"} %" PRIu32 "\n"
+			                   "mysensors_latency_seconds_sum{%s} %.6f\n"
+			                   "mysensors_latency_seconds_count{%s} %" PRIu32 "\n",
+			                   _statsLatencyLabels[h], hist.count, _statsLatencyLabels[h], hist.sum / 1e6,
+			                   _statsLatencyLabels[h], hist.count);
+		}
+	}
+	for (uint8_t q = 0; q < 3; q++) {
+		static const char *const names[3] = { "p50", "p99", "max" };
+		if (length < size) {
+			length += snprintf(&buffer[length], size - length,
+			                   "# TYPE mysensors_latency_%s_seconds gauge\n", names[q]);
+		}
+		for (uint8_t h = 0; h < STATS_LATENCIES && length < size; h++) {
+			const uint32_t us = q == 2 ? statsLatencyGet(h).max : statsLatencyPercentile(h, q ? 99 : 50);
+			length += snprintf(&buffer[length], size - length,
+			                   "mysensors_latency_%s_seconds{%s} %.6f\n", names[q], _statsLatencyLabels[h], us / 1e6);
+		}
+	}
+#endif
+#if defined(STATS_LINKS)
+	// per node sending to the gateway
+	const uint32_t now = hwMillis();
+	for (uint8_t m = 0; m < 8; m++) {
+		static const char *const names[8] = {
+			"rx_frames_total counter", "lost_total counter", "duplicates_total counter",
+			"reordered_total counter", "restarts_total counter", "interval_seconds gauge",
+			"jitter_seconds gauge", "last_seen_seconds gauge"
+		};
+		const size_t nameLength = strchr(names[m], ' ') - names[m];
+		if (length < size) {
+			length += snprintf(&buffer[length], size - length, "# TYPE mysensors_link_%s\n", names[m]);
+		}
+		for (uint8_t i = 0; i < MY_STATS_LINK_SLOTS && length < size; i++) {
+			const statsLink_t *link = &_statsLinks[i];
+			if (link->node == GATEWAY_ADDRESS) {
+				continue;
+			}
+			const uint32_t values[8] = { link->received, link->lost, link->duplicates, link->reordered,
+			                             link->restarts, link->intervalMS, link->jitterMS, now - link->lastMS
+			                           };
+			if (m < 5) {
+				length += snprintf(&buffer[length], size - length,
+				                   "mysensors_link_%.*s{node=\"%" PRIuNodeId "\"} %" PRIu32 "\n", (int)nameLength,
+				                   names[m], link->node, values[m]);
+			} else {
+				length += snprintf(&buffer[length], size - length,
+				                   "mysensors_link_%.*s{node=\"%" PRIuNodeId "\"} %.3f\n", (int)nameLength,
+				                   names[m], link->node, values[m] / 1e3);
+			}
+		}
+	}
+#endif
+	return length < size ? length : size - 1;
+}
+#endif
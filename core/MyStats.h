@@ -0,0 +1,244 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+ * @file MyStats.h
+ *
+ * @brief Transport and gateway statistics, see @ref MY_STATS_FEATURE
+ *
+ * The counters are incremented where the events happen and wrap around at 2^32. They can be
+ * read with statsGet(), by the controller with an I_STATS request (the node replies one
+ * I_STATS message per counter, with the counter index as sensor id) and on Linux gateways
+ * from the HTTP endpoint configured by stats_port in the configuration file.
+ *
+ * With @ref MY_STATS_LATENCY the time a message needs through the gateway is recorded in
+ * fixed log2 histograms, per path and stage. Each stage records the time since the start of
+ * the path, so the difference between two stages is the time spent between them:
+ *  - uplink (radio to controller): from the frame taken from the radio (by the RX message
+ *    buffer, or when it is read otherwise) to dequeued by the transport, signature verified,
+ *    formatted for the controller and written to the controller
+ *  - downlink (controller to radio): from the message read from the controller to processed
+ *    by the core and the first frame sent by the radio. Messages deferred by the TX queue are
+ *    only recorded up to the core.
+ *
+ * With @ref MY_TRANSPORT_SEQUENCE a gateway follows the sequence numbers of the nodes sending to
+ * it and counts per node the frames received, lost, duplicated and reordered, and the restarts.
+ * The interval between the frames of a node is smoothed, its variation is the jitter. The
+ * statistics are kept for the @ref MY_STATS_LINK_SLOTS nodes heard most recently.
+ */
+
+#ifndef MyStats_h
+#define MyStats_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Statistics counters
+ *
+ * The order defines the index used by I_STATS messages, new counters are added at the end.
+ */
+typedef enum {
+	STATS_TX_FRAMES = 0,		//!< Frames sent by the radio
+	STATS_TX_NACK,				//!< Frames not acknowledged by the receiver
+	STATS_TX_RETRIES,			//!< Messages resent by the TX queue
+	STATS_TX_DROPPED,			//!< Messages dropped by the TX queue after the last retry
+	STATS_TX_QUEUE_FULL,		//!< Messages sent right away because the TX queue was full
+	STATS_UPLINK_FAILURES,		//!< Failed transmissions to the parent
+	STATS_RX_FRAMES,			//!< Frames received
+	STATS_RX_DUPLICATES,		//!< Received frames dropped by the duplicate filter
+	STATS_RX_OVERFLOWS,			//!< Frames lost on a full RX message buffer
+	STATS_SIGN_FAILURES,		//!< Messages that could not be signed
+	STATS_VERIFY_FAILURES,		//!< Received messages that failed signature verification
+	STATS_GW_RX_MESSAGES,		//!< Messages received from the controller
+	STATS_GW_TX_MESSAGES,		//!< Messages sent to the controller
+	STATS_GW_TX_FAILURES,		//!< Messages that could not be sent to the controller
+	STATS_GW_PARSE_ERRORS,		//!< Invalid or too long lines and frames from the controller
+	STATS_TX_AIRTIME_MS,		//!< Time on air of the sent frames in ms, see transportHALGetAirtime()
+	STATS_TX_DUTY_CYCLE,		//!< Messages not sent because of the duty cycle, see @ref MY_TRANSPORT_DUTY_CYCLE_FEATURE
+	STATS_GW_TX_SUPPRESSED,		//!< Unchanged retained MQTT publishes skipped, see @ref MY_MQTT_CLIENT_SUPPRESS_UNCHANGED_MS
+	STATS_GW_RX_OVERFLOWS,		//!< Messages from the controller lost on a full MQTT inbound queue, see @ref MY_MQTT_CLIENT_RX_QUEUE_SIZE
+	STATS_TX_PACED,				//!< Messages of the sketch queued on a congested uplink, see @ref MY_TRANSPORT_PACING
+	STATS_NONCE_POOL_HITS,		//!< Nonce requests answered from the pool, see @ref MY_SIGNING_NONCE_POOL
+	STATS_NONCE_POOL_MISSES,	//!< Nonce requests answered with a nonce generated on the spot, the pool was empty
+	STATS_RX_CUT_THROUGH,		//!< Received frames relayed right away, see @ref MY_TRANSPORT_CUT_THROUGH
+	STATS_BC_SUPPRESSED,		//!< Broadcasts not relayed because enough copies were heard, see @ref MY_TRANSPORT_BROADCAST_FLOODING
+	STATS_COUNTERS				//!< Number of counters
+} statsCounter_t;
+
+/**
+ * @brief Latency histograms, in the order of the path stages
+ */
+typedef enum {
+	STATS_LATENCY_UPLINK_DEQUEUE = 0,	//!< Radio frame received -> processed by the transport
+	STATS_LATENCY_UPLINK_VERIFY,		//!< Radio frame received -> signature verified
+	STATS_LATENCY_UPLINK_FORMAT,		//!< Radio frame received -> formatted for the controller
+	STATS_LATENCY_UPLINK_WRITE,			//!< Radio frame received -> written to the controller
+	STATS_LATENCY_DOWNLINK_DEQUEUE,		//!< Controller message read -> processed by the core
+	STATS_LATENCY_DOWNLINK_SEND,		//!< Controller message read -> first frame sent by the radio
+	STATS_LATENCIES						//!< Number of histograms
+} statsLatency_t;
+
+#define STATS_LATENCY_BUCKETS		(16u)	//!< Buckets per histogram, the last one has no upper bound
+#define STATS_LATENCY_BUCKET_US(i)	(16ul << (i))	//!< Upper bound of bucket i in us: 16us, 32us ... 256ms
+
+/**
+ * @brief Latency histogram
+ */
+typedef struct {
+	uint32_t count;								//!< Recorded latencies
+	uint32_t max;								//!< Highest latency in us
+	uint64_t sum;								//!< Sum of the latencies in us
+	uint32_t buckets[STATS_LATENCY_BUCKETS];	//!< Latencies per bucket (not cumulative)
+} statsHistogram_t;
+
+#if defined(MY_STATS_FEATURE) && defined(MY_TRANSPORT_SEQUENCE) && defined(MY_GATEWAY_FEATURE)
+#define STATS_LINKS		//!< Statistics of the links to the gateway
+#endif
+
+/**
+ * @brief Statistics of the link from a node, see @ref MY_TRANSPORT_SEQUENCE
+ */
+typedef struct {
+	nodeId_t node;			//!< Sender, GATEWAY_ADDRESS for an unused slot
+	uint8_t sequence;		//!< Last sequence number in order
+	uint32_t received;		//!< Frames received, duplicates excluded
+	uint32_t lost;			//!< Frames missing in the sequence
+	uint32_t duplicates;	//!< Frames received again, e.g. after a lost ACK
+	uint32_t reordered;		//!< Frames received after a later one, not counted as lost anymore
+	uint32_t restarts;		//!< Sequences started over, i.e. the node rebooted
+	uint32_t lastMS;		//!< hwMillis() of the last frame
+	uint32_t intervalMS;	//!< Smoothed interval between two sequence numbers
+	uint32_t jitterMS;		//!< Smoothed deviation of the interval
+} statsLink_t;
+
+#if defined(MY_STATS_FEATURE)
+extern uint32_t _statsCounters[STATS_COUNTERS];
+#if defined(MY_GATEWAY_FEATURE)
+extern uint32_t _statsClientRxBytes[MY_GATEWAY_MAX_CLIENTS];
+extern uint32_t _statsClientTxBytes[MY_GATEWAY_MAX_CLIENTS];
+#endif
+
+#define STATS_INC(counter)	(_statsCounters[(counter)]++)	//!< Count an event
+#define STATS_ADD(counter, n)	(_statsCounters[(counter)] += (n))	//!< Count several events
+#define STATS_CLIENT_RX(client, n)	(_statsClientRxBytes[(client)] += (n))	//!< Bytes received from a controller connection
+#define STATS_CLIENT_TX(client, n)	(_statsClientTxBytes[(client)] += (n))	//!< Bytes sent to a controller connection
+
+/**
+ * @brief Read a counter
+ * @param counter Counter index, see statsCounter_t
+ * @return Counter value, 0 for an unknown index
+ */
+uint32_t statsGet(const uint8_t counter);
+
+/**
+ * @brief Reset all counters
+ */
+void statsReset(void);
+
+#if defined(__linux__)
+/**
+ * @brief Render all counters in Prometheus text exposition format
+ * @param buffer Output buffer
+ * @param size Size of the output buffer
+ * @return Length of the text, truncated to size - 1
+ */
+size_t statsRender(char *buffer, const size_t size);
+#endif
+
+#if defined(STATS_LINKS)
+/**
+ * @brief Record a frame addressed to the gateway
+ * @param node Sender
+ * @param sequence Sequence number carried by the frame
+ */
+void statsLinkRecord(const nodeId_t node, const uint8_t sequence);
+
+/**
+ * @brief Read the statistics of a link
+ * @param node Sender
+ * @return Copy of the statistics, node is GATEWAY_ADDRESS if the node is not tracked
+ */
+statsLink_t statsLinkGet(const nodeId_t node);
+#endif
+
+#if defined(MY_STATS_LATENCY)
+#if defined(MY_GATEWAY_CONTROLLER_THREAD)
+// the core and the controller thread each follow their own message
+#define STATS_THREAD_LOCAL	__thread	//!< Origin per thread
+#else
+#define STATS_THREAD_LOCAL				//!< Single threaded
+#endif
+extern STATS_THREAD_LOCAL uint32_t _statsUplinkOrigin;
+extern STATS_THREAD_LOCAL uint32_t _statsDownlinkOrigin;
+
+#define STATS_LATENCY(histogram, origin)	statsLatencyRecord((histogram), (origin))	//!< Record a stage
+#define STATS_UPLINK_BEGIN(stamp)	(_statsUplinkOrigin = (stamp))	//!< Start the uplink path
+#define STATS_UPLINK_END()			(_statsUplinkOrigin = 0)	//!< End the uplink path
+#define STATS_UPLINK(histogram)		STATS_LATENCY((histogram), _statsUplinkOrigin)	//!< Record an uplink stage
+#define STATS_DOWNLINK_BEGIN(stamp)	(_statsDownlinkOrigin = (stamp))	//!< Start the downlink path
+#define STATS_DOWNLINK_END()		(_statsDownlinkOrigin = 0)	//!< End the downlink path
+#define STATS_DOWNLINK(histogram)	STATS_LATENCY((histogram), _statsDownlinkOrigin)	//!< Record a downlink stage
+
+/**
+ * @brief Timestamp starting a path
+ * @return hwMicros(), never 0 (no path)
+ */
+uint32_t statsLatencyStamp(void);
+
+/**
+ * @brief Record the time since origin
+ * @param histogram Histogram index, see statsLatency_t
+ * @param origin Timestamp returned by statsLatencyStamp(), nothing is recorded for 0
+ */
+void statsLatencyRecord(const uint8_t histogram, const uint32_t origin);
+
+/**
+ * @brief Read a histogram
+ * @param histogram Histogram index, see statsLatency_t
+ * @return Copy of the histogram, empty for an unknown index
+ */
+statsHistogram_t statsLatencyGet(const uint8_t histogram);
+
+/**
+ * @brief Estimate a percentile from a histogram
+ * @param histogram Histogram index, see statsLatency_t
+ * @param percent Percentile, 1..100
+ * @return Upper bound in us of the bucket holding the percentile, capped at the highest latency
+ */
+uint32_t statsLatencyPercentile(const uint8_t histogram, const uint8_t percent);
+#endif
+#else
+#define STATS_INC(counter)					//!< Statistics disabled
+#define STATS_ADD(counter, n)				//!< Statistics disabled
+#define STATS_CLIENT_RX(client, n)			//!< Statistics disabled
+#define STATS_CLIENT_TX(client, n)			//!< Statistics disabled
+#endif
+
+#if !defined(MY_STATS_LATENCY)
+#define STATS_LATENCY(histogram, origin)	//!< Latency histograms disabled
+#define STATS_UPLINK_BEGIN(stamp)			//!< Latency histograms disabled
+#define STATS_UPLINK_END()					//!< Latency histograms disabled
+#define STATS_UPLINK(histogram)				//!< Latency histograms disabled
+#define STATS_DOWNLINK_BEGIN(stamp)			//!< Latency histograms disabled
+#define STATS_DOWNLINK_END()				//!< Latency histograms disabled
+#define STATS_DOWNLINK(histogram)			//!< Latency histograms disabled
+#endif
+
+#endif
@@ -22,7 +22,11 @@
 // debug
 #if defined(MY_DEBUG_VERBOSE_TRANSPORT)
 #define TRANSPORT_DEBUG(x,...) DEBUG_OUTPUT(x, ##__VA_ARGS__)	//!< debug
+#if defined(MY_SHARED_BUFFERS)
+static char (&_convBuf)[MAX_PAYLOAD * 2 + 1] = _coreSharedBuffers.debugConv;
+#else
 extern char _convBuf[MAX_PAYLOAD * 2 + 1];
+#endif
 #else
 #define TRANSPORT_DEBUG(x,...)	//!< debug NULL
 #endif
@@ -45,23 +49,142 @@ static transportConfig_t _transportConfig;
 // callback transportOk
 transportCallback_t _transportReady_cb = NULL;
 
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+#include "drivers/CircularBuffer/CircularBuffer.h"
+
+#if defined(MY_TRANSPORT_TX_QUEUE_PRIORITY)
+#define TRANSPORT_TX_QUEUES	(3u)	//!< one queue per priority class
+#else
+#define TRANSPORT_TX_QUEUES	(1u)	//!< one queue for all messages
+#endif
+static transportTxQueueEntry_t _transportTxQueueStorage[TRANSPORT_TX_QUEUES][MY_TRANSPORT_TX_QUEUE_SIZE];
+static CircularBuffer<transportTxQueueEntry_t> _transportTxQueue[TRANSPORT_TX_QUEUES] = {
+	CircularBuffer<transportTxQueueEntry_t>(_transportTxQueueStorage[0], MY_TRANSPORT_TX_QUEUE_SIZE),
+#if defined(MY_TRANSPORT_TX_QUEUE_PRIORITY)
+	CircularBuffer<transportTxQueueEntry_t>(_transportTxQueueStorage[1], MY_TRANSPORT_TX_QUEUE_SIZE),
+	CircularBuffer<transportTxQueueEntry_t>(_transportTxQueueStorage[2], MY_TRANSPORT_TX_QUEUE_SIZE),
+#endif
+};
+// callback for completed queued messages
+static transportTxCallback_t _transportTx_cb = NULL;
+#endif
+
 // enhanced ID assignment
 #if !defined(MY_GATEWAY_FEATURE) && (MY_NODE_ID == AUTO)
-static uint8_t _transportToken = AUTO;
+static uint8_t _transportToken = (uint8_t)AUTO;	// the token travels in the 8 bit sensor field
 #endif
 
 // global variables
 extern MyMessage _msg;		// incoming message
 extern MyMessage _msgTmp;	// outgoing message
 
+#if defined(MY_TRANSPORT_DIRECT_CACHE) && !defined(MY_REPEATER_FEATURE)
+static transportDirect_t _transportDirect[MY_TRANSPORT_DIRECT_CACHE_SIZE];	//!< ways to node-to-node destinations
+#endif
+
+#if defined(MY_TRANSPORT_DUPLICATE_FILTER)
+static transportDuplicate_t _transportDuplicates[MY_TRANSPORT_DUPLICATE_CACHE_SIZE];	//!< recently received messages
+static uint8_t _transportDuplicatesNext;			//!< cache entry to replace next
+static uint16_t _transportDuplicateCount;			//!< duplicates dropped
+#endif
+
+#if defined(MY_TRANSPORT_BROADCAST_FLOODING)
+static transportBroadcast_t _transportBroadcasts[MY_TRANSPORT_BROADCAST_CACHE_SIZE];	//!< recently received broadcasts
+#endif
+
+#if defined(MY_GATEWAY_FEATURE) && defined(MY_GATEWAY_ID_ALLOCATOR)
+static transportIdLease_t _transportIdLeases[MY_GATEWAY_ID_ALLOCATOR_LEASES];	//!< IDs answered but not used yet
+#endif
+
+static uint32_t _transportAirtime = 0;				//!< radio time on air at the last update
+#if defined(MY_STATS_FEATURE)
+static uint32_t _transportAirtimeUncounted = 0;	//!< us not yet added to STATS_TX_AIRTIME_MS
+#endif
+#if defined(MY_TRANSPORT_DUTY_CYCLE_FEATURE)
+#define TRANSPORT_DUTY_CYCLE_SLOTS		(12u)	//!< slots of the duty cycle window
+#define TRANSPORT_DUTY_CYCLE_SLOT_MS	(MY_TRANSPORT_DUTY_CYCLE_WINDOW_MS / TRANSPORT_DUTY_CYCLE_SLOTS)	//!< length of a slot
+#define TRANSPORT_DUTY_CYCLE_BUDGET_MS	((uint32_t)((uint64_t)MY_TRANSPORT_DUTY_CYCLE_WINDOW_MS * MY_TRANSPORT_DUTY_CYCLE_LIMIT / 1000u))	//!< time on air per window
+static uint32_t _transportDutyCycleSlots[TRANSPORT_DUTY_CYCLE_SLOTS];	//!< time on air in us per slot
+static uint8_t _transportDutyCycleSlot = 0;		//!< current slot
+static uint32_t _transportDutyCycleSlotStart = 0;	//!< start of the current slot
+#endif
+
+#if defined(MY_TRANSPORT_RECEIPTS)
+static MyMessage _transportReceipts[MY_TRANSPORT_RECEIPT_SLOTS];	//!< messages waiting for a receipt, free without echo request
+static uint8_t _transportReceiptsNext = 0;	//!< slot to replace next
+#endif
+
+#if defined(MY_TRANSPORT_PACING)
+static uint32_t _transportPacingGapMS = 0;		//!< gap kept between messages to the GW, 0 if the uplink is not congested
+static uint32_t _transportPacingLast = 0;		//!< last transmission to the parent
+#endif
+
+static transportDeferredReply_t _transportDeferredReplies[MY_TRANSPORT_DEFERRED_REPLIES];	//!< scheduled replies
+
+#if defined(MY_TRANSPORT_PARENT_CACHE)
+static transportParentCandidate_t _transportParentCandidates[TRANSPORT_PARENT_CANDIDATES];	//!< ranked parent candidates
+static bool _transportParentCandidatesLoaded = false;	//!< candidates read from EEPROM
+static nodeId_t _transportParentProbe = AUTO;			//!< candidate probed, AUTO while broadcasting
+#endif
+
+#if defined(MY_TRANSPORT_PARENT_LOAD)
+#if !defined(MY_TRANSPORT_DUTY_CYCLE_FEATURE)
+static uint32_t _transportLoadWindowStart = 0;	//!< start of the time on air window
+static uint32_t _transportLoadAirtimeUs = 0;		//!< time on air in the current window
+static uint8_t _transportLoadAirtime = 0;		//!< time on air share of the last window, 255 is fully loaded
+#endif
+#if !defined(MY_GATEWAY_FEATURE)
+static uint16_t _transportParentCost = UINT16_MAX;	//!< cost of the parent chosen while finding the parent
+#endif
+#endif
+#if defined(TRANSPORT_PARENT_REVIEW)
+static bool _transportParentReviewActive = false;	//!< find parent request broadcast, collecting responses
+static uint32_t _transportParentReviewTime = 0;		//!< start of the active review, due time of the next one otherwise
+static nodeId_t _transportParentReviewBest = AUTO;	//!< cheapest other parent answering
+static uint8_t _transportParentReviewDistance = 0;	//!< distance to the GW via the cheapest other parent
+static uint16_t _transportParentReviewBestCost = UINT16_MAX;	//!< cost of the cheapest other parent
+static uint16_t _transportParentReviewCost = UINT16_MAX;	//!< cost of the current parent, UINT16_MAX if it did not answer
+#endif
+
 #if defined(MY_RAM_ROUTING_TABLE_ENABLED)
 static routingTable_t _transportRoutingTable;		//!< routing table
 static uint32_t _lastRoutingTableSave;			//!< last routing table dump
 #endif
 
+#if defined(MY_TRANSPORT_FRAGMENTATION)
+#if MY_TRANSPORT_FRAGMENT_MAX_LENGTH > FRAGMENT_MAX_COUNT * FRAGMENT_DATA_SIZE
+#error MY_TRANSPORT_FRAGMENT_MAX_LENGTH exceeds FRAGMENT_MAX_COUNT fragments
+#endif
+static transportFragmentSlot_t _transportFragments[MY_TRANSPORT_FRAGMENT_SLOTS];	//!< reassembly pool
+#endif
+
+#if defined(MY_TRANSPORT_AGGREGATION) && defined(MY_REPEATER_FEATURE) && !defined(MY_GATEWAY_FEATURE)
+static MyMessage _transportAggregate;			//!< relayed frames collected for the GW
+static uint8_t _transportAggregateCount = 0;	//!< frames in _transportAggregate
+static uint32_t _transportAggregateStart;		//!< first frame collected
+#endif
+
+#if defined(MY_TRANSPORT_WAKE_ON_RADIO)
+static uint8_t _transportWakeOnRadio[32];			//!< neighbours with a duty-cycled receiver, bit per node
+static uint32_t _transportWakeOnRadioCycleMS = 0;	//!< longest announced cycle
+#endif
+
+#if defined(MY_TRANSPORT_SEQUENCE)
+static uint8_t _transportSequence = 0;		//!< next sequence number, 0 only for the first frame after boot
+#endif
+
+#if defined(MY_TRANSPORT_FAST_RECOVERY)
+static uint8_t _transportRecoveryAttempts = 0;	//!< consecutive radio faults, 0: none pending
+#endif
+
+#if defined(MY_DEBUG_VERBOSE_TRANSPORT)
+static uint32_t _transportWakeUpMicros;		//!< wake-up after sleeping, start of the wake to TX latency
+static bool _transportWakeUpPending = false;	//!< no frame sent since the wake-up
+#endif
+
 // regular sanity check, activated by default on GW and repeater nodes
 #if defined(MY_TRANSPORT_SANITY_CHECK)
-static uint32_t _lastSanityCheck;		//!< last sanity check
+static schedulerTask_t _transportSanityTask;	//!< next sanity check
 #endif
 
 // regular network discovery, sends I_DISCOVER_REQUESTS to update routing table
@@ -78,9 +201,13 @@ void stInitTransition(void)
 	_transportSM.pingActive = false;
 	_transportSM.transportActive = false;
 	_transportSM.lastUplinkCheck = 0;
+#if defined(MY_TRANSPORT_UPLINK_CHECK_PASSIVE)
+	_transportSM.uplinkPingActive = false;
+#endif
 
 #if defined(MY_TRANSPORT_SANITY_CHECK)
-	_lastSanityCheck = hwMillis();
+	schedulerAdd(&_transportSanityTask, transportSanityCheckTask);
+	schedulerSet(&_transportSanityTask, MY_TRANSPORT_SANITY_CHECK_INTERVAL_MS);
 #endif
 #if defined(MY_GATEWAY_FEATURE)
 	_lastNetworkDiscovery = 0;
@@ -100,10 +227,17 @@ void stInitUpdate(void)
 	if (!transportHALInit()) {
 		TRANSPORT_DEBUG(PSTR("!TSM:INIT:TSP FAIL\n"));
 		setIndication(INDICATION_ERR_INIT_TRANSPORT);
+#if defined(MY_TRANSPORT_FAST_RECOVERY)
+		transportRecoveryBackoff();
+#endif
 		transportSwitchSM(stFailure);
 	} else {
 		TRANSPORT_DEBUG(PSTR("TSM:INIT:TSP OK\n"));
 		_transportSM.transportActive = true;
+#if defined(MY_TRANSPORT_FAST_RECOVERY)
+		// the radio works again, failures of the network are timed as before
+		_transportRecoveryAttempts = 0;
+#endif
 #if defined (MY_PASSIVE_NODE)
 		_transportConfig.passiveMode = true;
 		TRANSPORT_DEBUG(PSTR("TSM:INIT:TSP PSM\n"));	// transport passive mode
@@ -121,11 +255,12 @@ void stInitUpdate(void)
 		transportSwitchSM(stReady);
 #else
 		if (MY_NODE_ID != AUTO) {
-			TRANSPORT_DEBUG(PSTR("TSM:INIT:STATID=%" PRIu8 "\n"),(uint8_t)MY_NODE_ID);
+			TRANSPORT_DEBUG(PSTR("TSM:INIT:STATID=%" PRIuNodeId "\n"),(nodeId_t)MY_NODE_ID);
 			// Set static ID
-			_transportConfig.nodeId = (uint8_t)MY_NODE_ID;
+			_transportConfig.nodeId = (nodeId_t)MY_NODE_ID;
 			// Save static ID to eeprom (for bootloader)
-			hwWriteConfig(EEPROM_NODE_ID_ADDRESS, (uint8_t)MY_NODE_ID);
+			hwWriteConfigBlock((void *)&_transportConfig.nodeId, (void *)EEPROM_NODE_ID_ADDRESS,
+			                   SIZE_NODE_ID);
 		}
 		// assign ID if set
 		if (_transportConfig.nodeId == AUTO || transportAssignNodeID(_transportConfig.nodeId)) {
@@ -147,16 +282,32 @@ void stParentTransition(void)
 	_transportSM.uplinkOk = false;
 	_transportSM.preferredParentFound = false;
 #if defined(MY_PARENT_NODE_IS_STATIC) || defined(MY_PASSIVE_NODE)
-	TRANSPORT_DEBUG(PSTR("TSM:FPAR:STATP=%" PRIu8 "\n"), (uint8_t)MY_PARENT_NODE_ID);	// static parent
+	TRANSPORT_DEBUG(PSTR("TSM:FPAR:STATP=%" PRIuNodeId "\n"), (nodeId_t)MY_PARENT_NODE_ID);	// static parent
 	_transportSM.findingParentNode = false;
 	_transportConfig.distanceGW = 1u;	// assumption, CHKUPL:GWDC will update this variable
-	_transportConfig.parentNodeId = (uint8_t)MY_PARENT_NODE_ID;
+	_transportConfig.parentNodeId = (nodeId_t)MY_PARENT_NODE_ID;
 	// save parent ID to eeprom (for bootloader)
-	hwWriteConfig(EEPROM_PARENT_NODE_ID_ADDRESS, (uint8_t)MY_PARENT_NODE_ID);
+	hwWriteConfigBlock((void *)&_transportConfig.parentNodeId, (void *)EEPROM_PARENT_NODE_ID_ADDRESS,
+	                   SIZE_PARENT_NODE_ID);
 #else
 	_transportSM.findingParentNode = true;
 	_transportConfig.distanceGW = DISTANCE_INVALID;	// Set distance to max and invalidate parent node ID
 	_transportConfig.parentNodeId = AUTO;
+#if defined(MY_TRANSPORT_PARENT_LOAD) && !defined(MY_GATEWAY_FEATURE)
+	_transportParentCost = UINT16_MAX;
+#endif
+#if defined(MY_TRANSPORT_PARENT_CACHE)
+	if (_transportSM.stateRetries == 0u) {
+		// first attempt, the known candidates are asked before all nodes in range
+		if (!_transportParentCandidatesLoaded) {
+			transportLoadParentCandidates();
+		}
+		_transportParentProbe = 0u;
+	}
+	if (transportProbeParent()) {
+		return;
+	}
+#endif
 	// Broadcast find parent request
 	(void)transportRouteMessage(build(_msgTmp, BROADCAST_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
 	                                  I_FIND_PARENT_REQUEST).set(""));
@@ -171,12 +322,33 @@ void stParentUpdate(void)
 	setIndication(INDICATION_GOT_PARENT);
 	transportSwitchSM(stID);
 #else
+#if defined(MY_TRANSPORT_PARENT_CACHE)
+	if (_transportParentProbe != AUTO && _transportConfig.parentNodeId == AUTO &&
+	        transportTimeInState() > MY_TRANSPORT_PARENT_PROBE_MS) {
+		// candidate did not answer, try the next one or all nodes in range
+		TRANSPORT_DEBUG(PSTR("!TSM:FPAR:PROBE FAIL,ID=%" PRIu8 "\n"),
+		                _transportParentCandidates[_transportParentProbe].nodeId);
+		_transportParentCandidates[_transportParentProbe].nodeId = AUTO;
+		_transportParentProbe++;
+		if (!transportProbeParent()) {
+			(void)transportRouteMessage(build(_msgTmp, BROADCAST_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+			                                  I_FIND_PARENT_REQUEST).set(""));
+		}
+		// the state timeout starts over without using up a retry
+		_transportSM.stateEnter = hwMillis();
+		return;
+	}
+#endif
 	if (transportTimeInState() > MY_TRANSPORT_STATE_TIMEOUT_MS || _transportSM.preferredParentFound) {
 		// timeout or preferred parent found
 		if (_transportConfig.parentNodeId != AUTO) {
 			// parent assigned
 			TRANSPORT_DEBUG(PSTR("TSM:FPAR:OK\n"));	// find parent ok
 			_transportSM.findingParentNode = false;
+#if defined(MY_TRANSPORT_PARENT_CACHE)
+			_transportParentProbe = AUTO;
+			transportSaveParentCandidates();
+#endif
 			setIndication(INDICATION_GOT_PARENT);
 			// go to next state
 			transportSwitchSM(stID);
@@ -206,9 +378,12 @@ void stIDTransition(void)
 		// send ID request
 		setIndication(INDICATION_REQ_NODEID);
 #if !defined(MY_GATEWAY_FEATURE) && (MY_NODE_ID == AUTO)
-		_transportToken = (uint8_t)(hwMillis() & 0xFF);
-		if (_transportToken == AUTO) {
-			_transportToken++;    // AUTO as token not allowed
+		if (_transportToken == (uint8_t)AUTO) {
+			// kept for the retries, a GW leasing IDs answers them with the same ID
+			_transportToken = (uint8_t)(hwMillis() & 0xFF);
+			if (_transportToken == (uint8_t)AUTO) {
+				_transportToken++;    // AUTO as token not allowed
+			}
 		}
 		const uint8_t sensorID = _transportToken;
 #else
@@ -295,6 +470,12 @@ void stReadyTransition(void)
 	_transportSM.uplinkOk = true;
 	_transportSM.failureCounter = 0u;			// reset failure counter
 	_transportSM.failedUplinkTransmissions = 0u;	// reset failed uplink TX counter
+#if defined(TRANSPORT_PARENT_REVIEW)
+	// spread over the interval by node ID, the children of a parent are not all reviewed at once
+	_transportParentReviewActive = false;
+	_transportParentReviewTime = hwMillis() + MY_TRANSPORT_PARENT_LOAD_INTERVAL_MS / 256u *
+	                             (1u + (_transportConfig.nodeId & 0xFFu));
+#endif
 	// callback
 	if (_transportReady_cb) {
 		_transportReady_cb();
@@ -324,6 +505,9 @@ void stReadyUpdate(void)
 		_transportSM.failedUplinkTransmissions = 0u;
 #endif
 	}
+#if defined(TRANSPORT_PARENT_REVIEW)
+	transportReviewParent();
+#endif
 #endif
 
 #if defined(MY_RAM_ROUTING_TABLE_ENABLED)
@@ -352,9 +536,17 @@ void stFailureTransition(void)
 
 void stFailureUpdate(void)
 {
-	if (transportTimeInState() > ( isTransportExtendedFailure()?
-	                               MY_TRANSPORT_TIMEOUT_EXT_FAILURE_STATE_MS:
-	                               MY_TRANSPORT_TIMEOUT_FAILURE_STATE_MS) ) {
+	uint32_t dwellMS = isTransportExtendedFailure() ? MY_TRANSPORT_TIMEOUT_EXT_FAILURE_STATE_MS :
+	                   MY_TRANSPORT_TIMEOUT_FAILURE_STATE_MS;
+#if defined(MY_TRANSPORT_FAST_RECOVERY)
+	if (_transportRecoveryAttempts) {
+		// radio fault: doubled per attempt up to the dwell of the failure state
+		const uint32_t backoffMS = (uint32_t)MY_TRANSPORT_RECOVERY_BACKOFF_MS <<
+		                           (_transportRecoveryAttempts - 1u);
+		dwellMS = min(dwellMS, backoffMS);
+	}
+#endif
+	if (transportTimeInState() > dwellMS) {
 		TRANSPORT_DEBUG(PSTR("TSM:FAIL:RE-INIT\n"));	// attempt to re-initialise transport
 		transportSwitchSM(stInit);
 	}
@@ -433,6 +625,10 @@ void transportDisable(void)
 
 void transportReInitialise(void)
 {
+#if defined(MY_DEBUG_VERBOSE_TRANSPORT)
+	_transportWakeUpMicros = hwMicros();
+	_transportWakeUpPending = true;
+#endif
 	if (RADIO_CAN_POWER_OFF == true) {
 		TRANSPORT_DEBUG(PSTR("TSF:TRI:TPU\n"));		// transport power up
 		transportHALPowerUp();
@@ -472,6 +668,26 @@ bool transportCheckUplink(const bool force)
 		TRANSPORT_DEBUG(PSTR("TSF:CKU:OK,FCTRL\n"));	// flood control
 		return true;
 	}
+#if defined(MY_TRANSPORT_UPLINK_CHECK_PASSIVE)
+	if (!force) {
+		// nothing heard from the GW recently: ping it without waiting, the uplink counts as working
+		// once the PONG is in. Until then, or if it does not arrive in time, the check fails
+		if (_transportSM.uplinkPingActive &&
+		        hwMillis() - _transportSM.uplinkPingSent > MY_TRANSPORT_STATE_TIMEOUT_MS) {
+			TRANSPORT_DEBUG(PSTR("!TSF:CKU:PONG TMO\n"));	// no PONG from the GW
+			_transportSM.uplinkPingActive = false;
+		}
+		if (!_transportSM.uplinkPingActive && !_transportSM.pingActive) {
+			TRANSPORT_DEBUG(PSTR("TSF:CKU:PING\n"));
+			_transportSM.uplinkPingActive = true;
+			_transportSM.uplinkPingSent = hwMillis();
+			(void)transportRouteMessage(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+			                                  I_PING).set((uint8_t)0x01));
+		}
+		TRANSPORT_DEBUG(PSTR("TSF:CKU:FAIL\n"));
+		return false;
+	}
+#endif
 	// ping GW
 	const uint8_t hopsCount = transportPingNode(GATEWAY_ADDRESS);
 	// verify hops
@@ -492,18 +708,18 @@ bool transportCheckUplink(const bool force)
 	}
 }
 
-bool transportAssignNodeID(const uint8_t newNodeId)
+bool transportAssignNodeID(const nodeId_t newNodeId)
 {
 	// verify if ID valid
 	if (newNodeId != GATEWAY_ADDRESS && newNodeId != AUTO) {
 		_transportConfig.nodeId = newNodeId;
 		transportHALSetAddress(newNodeId);
 		// Write ID to EEPROM
-		hwWriteConfig(EEPROM_NODE_ID_ADDRESS, newNodeId);
-		TRANSPORT_DEBUG(PSTR("TSF:SID:OK,ID=%" PRIu8 "\n"),newNodeId);	// Node ID assigned
+		hwWriteConfigBlock((void *)&_transportConfig.nodeId, (void *)EEPROM_NODE_ID_ADDRESS, SIZE_NODE_ID);
+		TRANSPORT_DEBUG(PSTR("TSF:SID:OK,ID=%" PRIuNodeId "\n"),newNodeId);	// Node ID assigned
 		return true;
 	} else {
-		TRANSPORT_DEBUG(PSTR("!TSF:SID:FAIL,ID=%" PRIu8 "\n"),newNodeId);	// ID is invalid, cannot assign ID
+		TRANSPORT_DEBUG(PSTR("!TSF:SID:FAIL,ID=%" PRIuNodeId "\n"),newNodeId);	// ID is invalid, cannot assign ID
 		setIndication(INDICATION_ERR_NET_FULL);
 		_transportConfig.nodeId = AUTO;
 		return false;
@@ -512,8 +728,24 @@ bool transportAssignNodeID(const uint8_t newNodeId)
 
 bool transportRouteMessage(MyMessage &message)
 {
-	const uint8_t destination = message.destination;
-	uint8_t route = _transportConfig.parentNodeId;	// by default, all traffic is routed via parent node
+	const nodeId_t destination = message.destination;
+	nodeId_t route = _transportConfig.parentNodeId;	// by default, all traffic is routed via parent node
+
+#if defined(MY_TRANSPORT_RECEIPTS)
+	if (mGetRequestEcho(message) && message.sender == _transportConfig.nodeId &&
+	        destination != BROADCAST_ADDRESS) {
+		transportReceiptExpect(message);
+	}
+#endif
+
+#if defined(MY_TRANSPORT_DUTY_CYCLE_FEATURE)
+	if (!transportDutyCycleAllows(message)) {
+		// not a TX failure, the uplink is not counted as failed
+		TRANSPORT_DEBUG(PSTR("!TSF:RTE:DC=%" PRIu8 "\n"), transportGetDutyCycle());
+		STATS_INC(STATS_TX_DUTY_CYCLE);
+		return false;
+	}
+#endif
 
 	if (_transportSM.findingParentNode && destination != BROADCAST_ADDRESS) {
 		TRANSPORT_DEBUG(PSTR("!TSF:RTE:FPAR ACTIVE\n")); // find parent active, message not sent
@@ -530,7 +762,7 @@ bool transportRouteMessage(MyMessage &message)
 		// destination not GW & not BC, get route
 		route = transportGetRoute(destination);
 		if (route == AUTO) {
-			TRANSPORT_DEBUG(PSTR("!TSF:RTE:%" PRIu8 " UNKNOWN\n"), destination);	// route unknown
+			TRANSPORT_DEBUG(PSTR("!TSF:RTE:%" PRIuNodeId " UNKNOWN\n"), destination);	// route unknown
 #if !defined(MY_GATEWAY_FEATURE)
 			if (message.last != _transportConfig.parentNodeId) {
 				// message not from parent, i.e. child node - route it to parent
@@ -544,10 +776,22 @@ bool transportRouteMessage(MyMessage &message)
 			route = destination;
 #endif
 		}
+#else
+#if defined(MY_TRANSPORT_DIRECT_CACHE)
+		const transportDirect_t *known = transportGetDirect(destination);
+		if (known != NULL && !known->direct) {
+			// out of range lately, the retries of a direct attempt are saved
+			TRANSPORT_DEBUG(PSTR("TSF:RTE:N2N PAR\n"));
+		} else if (destination > GATEWAY_ADDRESS && destination < BROADCAST_ADDRESS) {
 #else
 		if (destination > GATEWAY_ADDRESS && destination < BROADCAST_ADDRESS) {
+#endif
 			// node2node traffic: assume node is in vincinity. If transmission fails, hand over to parent
-			if (transportSendWrite(destination, message)) {
+			const bool direct = transportSendWrite(destination, message);
+#if defined(MY_TRANSPORT_DIRECT_CACHE)
+			transportSetDirect(destination, direct);
+#endif
+			if (direct) {
 				TRANSPORT_DEBUG(PSTR("TSF:RTE:N2N OK\n"));
 				return true;
 			}
@@ -557,16 +801,45 @@ bool transportRouteMessage(MyMessage &message)
 #endif
 	}
 	// send message
+#if defined(MY_ROUTING_TABLE_BACKUP_ROUTES)
+	bool result = transportSendWrite(route, message);
+	if (!result && destination != GATEWAY_ADDRESS && destination != BROADCAST_ADDRESS &&
+	        route == transportGetRoute(destination)) {
+		// fail over to the backup route right away
+		const nodeId_t backup = transportFailoverRoute(destination);
+		if (backup != AUTO) {
+			TRANSPORT_DEBUG(PSTR("!TSF:RTE:%" PRIuNodeId " FAIL,BKP=%" PRIuNodeId "\n"), destination, backup);
+			route = backup;
+			result = transportSendWrite(route, message);
+		}
+	}
+#else
 	const bool result = transportSendWrite(route, message);
+#endif
 #if !defined(MY_GATEWAY_FEATURE)
 	// update counter
 	if (route == _transportConfig.parentNodeId) {
 
+#if defined(MY_TRANSPORT_PACING)
+		_transportPacingLast = hwMillis();
+#endif
 		if (!result) {
 			setIndication(INDICATION_ERR_TX);
 			_transportSM.failedUplinkTransmissions++;
+			STATS_INC(STATS_UPLINK_FAILURES);
+#if defined(MY_TRANSPORT_PACING)
+			// multiplicative decrease of the rate
+			_transportPacingGapMS = min(max(_transportPacingGapMS * 2u, (uint32_t)MY_TRANSPORT_PACING_MIN_MS),
+			                            (uint32_t)MY_TRANSPORT_PACING_MAX_MS);
+			TRANSPORT_DEBUG(PSTR("!TSF:RTE:PACE,G=%" PRIu32 "\n"), _transportPacingGapMS);
+#endif
 		} else {
 			_transportSM.failedUplinkTransmissions = 0u;
+#if defined(MY_TRANSPORT_PACING)
+			// additive increase of the rate
+			_transportPacingGapMS = (_transportPacingGapMS > MY_TRANSPORT_PACING_STEP_MS) ?
+			                        _transportPacingGapMS - MY_TRANSPORT_PACING_STEP_MS : 0u;
+#endif
 #if defined(MY_SIGNAL_REPORT_ENABLED)
 			// update uplink quality monitor
 			const int16_t signalStrengthRSSI = transportGetSignalReport(SR_TX_RSSI);
@@ -585,10 +858,41 @@ bool transportRouteMessage(MyMessage &message)
 	return result;
 }
 
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+static bool transportQueueMessage(MyMessage &message)
+{
+	const uint8_t priority = (TRANSPORT_TX_QUEUES > 1u) ? (uint8_t)transportTxPriority(message) : 0u;
+	transportTxQueueEntry_t *entry = _transportTxQueue[priority].getFront();
+	if (entry == NULL) {
+		return false;
+	}
+	entry->message = message;
+	entry->attempts = 0u;
+	(void)_transportTxQueue[priority].pushFront(entry);
+	TRANSPORT_DEBUG(PSTR("TSF:TXQ:QUEUED,P=%" PRIu8 ",N=%" PRIu8 "\n"), priority,
+	                _transportTxQueue[priority].available());
+	return true;
+}
+#endif
+
 bool transportSendRoute(MyMessage &message)
 {
 	bool result = false;
 	if (isTransportReady()) {
+#if defined(MY_TRANSPORT_PACING)
+		if (message.destination == GATEWAY_ADDRESS && mGetCommand(message) != C_INTERNAL &&
+		        (_transportPacingGapMS || transportTxQueuePending())) {
+			// congested uplink, the queue sends it once the gap has passed
+			if (transportQueueMessage(message)) {
+				STATS_INC(STATS_TX_PACED);
+				TRANSPORT_DEBUG(PSTR("TSF:SND:PACED,G=%" PRIu32 "\n"), _transportPacingGapMS);
+				return true;
+			}
+			// the sketch tries again later instead of adding to the collisions
+			TRANSPORT_DEBUG(PSTR("!TSF:SND:PACED FULL\n"));
+			return false;
+		}
+#endif
 		result = transportRouteMessage(message);
 	} else {
 		// TNR: transport not ready
@@ -597,161 +901,1268 @@ bool transportSendRoute(MyMessage &message)
 	return result;
 }
 
-// only be used inside transport
-bool transportWait(const uint32_t waitingMS, const uint8_t cmd, const uint8_t msgType)
+bool transportQueueRoute(MyMessage &message)
 {
-	const uint32_t enterMS = hwMillis();
-	// invalidate msg type
-	_msg.type = !msgType;
-	bool expectedResponse = false;
-	while ((hwMillis() - enterMS < waitingMS) && !expectedResponse) {
-		// process incoming messages
-		transportProcessFIFO();
-		doYield();
-		expectedResponse = (mGetCommand(_msg) == cmd && _msg.type == msgType);
+	if (!isTransportReady()) {
+		// TNR: transport not ready
+		TRANSPORT_DEBUG(PSTR("!TSF:SND:TNR\n"));
+		return false;
 	}
-	return expectedResponse;
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+	if (transportQueueMessage(message)) {
+		return true;
+	}
+	STATS_INC(STATS_TX_QUEUE_FULL);
+	TRANSPORT_DEBUG(PSTR("!TSF:TXQ:FULL\n"));
+#endif
+	return transportRouteMessage(message);
 }
 
-uint8_t transportPingNode(const uint8_t targetId)
+#if defined(MY_TRANSPORT_PARENT_CACHE)
+void transportLoadParentCandidates(void)
 {
-	if(!_transportSM.pingActive) {
-		TRANSPORT_DEBUG(PSTR("TSF:PNG:SEND,TO=%" PRIu8 "\n"), targetId);
-		if(targetId == _transportConfig.nodeId) {
-			// pinging self
-			_transportSM.pingResponse = 0u;
-		} else {
-			_transportSM.pingActive = true;
-			_transportSM.pingResponse = INVALID_HOPS;
-			(void)transportRouteMessage(build(_msgTmp, targetId, NODE_SENSOR_ID, C_INTERNAL,
-			                                  I_PING).set((uint8_t)0x01));
-			// Wait for ping reply or timeout
-			(void)transportWait(2000, C_INTERNAL, I_PONG);
+	hwReadConfigBlock((void *)_transportParentCandidates, (void *)EEPROM_PARENT_CANDIDATES_ADDRESS,
+	                  sizeof(_transportParentCandidates));
+	for (uint8_t i = 0u; i < TRANSPORT_PARENT_CANDIDATES; i++) {
+		transportParentCandidate_t *candidate = &_transportParentCandidates[i];
+		// erased EEPROM reads as AUTO, entries written by older firmware are dropped
+		if (candidate->nodeId == _transportConfig.nodeId || !isValidDistance(candidate->distance) ||
+		        candidate->distance == 0u) {
+			candidate->nodeId = AUTO;
 		}
-		// make sure missing I_PONG msg does not block pinging function by leaving pingActive=true
-		_transportSM.pingActive = false;
-		return _transportSM.pingResponse;
-	} else {
-		TRANSPORT_DEBUG(PSTR("!TSF:PNG:ACTIVE\n"));	// ping active, cannot start new ping
-		return INVALID_HOPS;
 	}
+	_transportParentCandidatesLoaded = true;
 }
 
-uint32_t transportGetHeartbeat(void)
+void transportSaveParentCandidates(void)
 {
-	return transportTimeInState();
+	transportParentCandidate_t stored[TRANSPORT_PARENT_CANDIDATES];
+	hwReadConfigBlock((void *)stored, (void *)EEPROM_PARENT_CANDIDATES_ADDRESS, sizeof(stored));
+	if (memcmp((const void *)stored, (const void *)_transportParentCandidates, sizeof(stored))) {
+		hwWriteConfigBlock((void *)_transportParentCandidates, (void *)EEPROM_PARENT_CANDIDATES_ADDRESS,
+		                   sizeof(_transportParentCandidates));
+	}
 }
 
-void transportProcessMessage(void)
+void transportAddParentCandidate(const nodeId_t nodeId, const uint8_t distance, const int16_t rssi)
 {
-	// Manage signing timeout
-	(void)signerCheckTimer();
-	// receive message
-	setIndication(INDICATION_RX);
-	uint8_t payloadLength;
-	// last is the first byte of the payload buffer
-	if (!transportHALReceive(&_msg, &payloadLength)) {
+	const int8_t rssiCandidate = (rssi == INVALID_RSSI) ? INT8_MIN : (int8_t)constrain(rssi, -127, 127);
+	// remove the node, free entries move to the end
+	uint8_t count = 0u;
+	for (uint8_t i = 0u; i < TRANSPORT_PARENT_CANDIDATES; i++) {
+		if (_transportParentCandidates[i].nodeId != AUTO && _transportParentCandidates[i].nodeId != nodeId) {
+			_transportParentCandidates[count++] = _transportParentCandidates[i];
+		}
+	}
+	// rank by distance, then RSSI
+	uint8_t pos = count;
+	while (pos > 0u && (_transportParentCandidates[pos - 1u].distance > distance ||
+	                    (_transportParentCandidates[pos - 1u].distance == distance &&
+	                     _transportParentCandidates[pos - 1u].RSSI < rssiCandidate))) {
+		pos--;
+	}
+	if (pos >= TRANSPORT_PARENT_CANDIDATES) {
+		// worse than all candidates kept
 		return;
 	}
-	// get message length and limit size
-	const uint8_t msgLength = min(mGetLength(_msg), (uint8_t)MAX_PAYLOAD);
-	// calculate expected length
+	for (uint8_t i = (count < TRANSPORT_PARENT_CANDIDATES) ? count : TRANSPORT_PARENT_CANDIDATES - 1u;
+	        i > pos; i--) {
+		_transportParentCandidates[i] = _transportParentCandidates[i - 1u];
+	}
+	_transportParentCandidates[pos].nodeId = nodeId;
+	_transportParentCandidates[pos].distance = distance;
+	_transportParentCandidates[pos].RSSI = rssiCandidate;
+	if (count < TRANSPORT_PARENT_CANDIDATES) {
+		count++;
+	}
+	for (uint8_t i = count; i < TRANSPORT_PARENT_CANDIDATES; i++) {
+		_transportParentCandidates[i].nodeId = AUTO;
+	}
+}
 
-	const uint8_t command = mGetCommand(_msg);
-	const uint8_t type = _msg.type;
-	const uint8_t sender = _msg.sender;
-	const uint8_t last = _msg.last;
-	const uint8_t destination = _msg.destination;
-
-	TRANSPORT_DEBUG(PSTR("TSF:MSG:READ,%" PRIu8 "-%" PRIu8 "-%" PRIu8 ",s=%" PRIu8 ",c=%" PRIu8 ",t=%"
-	                     PRIu8 ",pt=%" PRIu8 ",l=%" PRIu8 ",sg=%" PRIu8 ":%s\n"),
-	                sender, last, destination, _msg.sensor, command, type, mGetPayloadType(_msg), msgLength,
-	                mGetSigned(_msg), ((command == C_INTERNAL &&
-	                                    type == I_NONCE_RESPONSE) ? "<NONCE>" : _msg.getString(_convBuf)));
-
-	// Reject messages that do not pass verification
-	if (!signerVerifyMsg(_msg)) {
-		setIndication(INDICATION_ERR_SIGN);
-		TRANSPORT_DEBUG(PSTR("!TSF:MSG:SIGN VERIFY FAIL\n"));
-		return;
+bool transportProbeParent(void)
+{
+	// the candidate has to know where to send the response
+	if (_transportConfig.nodeId == AUTO) {
+		_transportParentProbe = AUTO;
+	}
+	while (_transportParentProbe < TRANSPORT_PARENT_CANDIDATES) {
+		transportParentCandidate_t *candidate = &_transportParentCandidates[_transportParentProbe];
+		if (candidate->nodeId != AUTO) {
+			TRANSPORT_DEBUG(PSTR("TSM:FPAR:PROBE,ID=%" PRIuNodeId "\n"), candidate->nodeId);
+			// sent directly, routing is blocked while finding the parent
+			if (transportSendWrite(candidate->nodeId, build(_msgTmp, candidate->nodeId, NODE_SENSOR_ID,
+			                       C_INTERNAL, I_FIND_PARENT_REQUEST).set(""))) {
+				return true;
+			}
+			TRANSPORT_DEBUG(PSTR("!TSM:FPAR:PROBE FAIL,ID=%" PRIuNodeId "\n"), candidate->nodeId);
+			candidate->nodeId = AUTO;
+		}
+		_transportParentProbe++;
 	}
+	_transportParentProbe = AUTO;
+	return false;
+}
+#endif
 
-	// update routing table if msg not from parent
-#if defined(MY_REPEATER_FEATURE)
-#if !defined(MY_GATEWAY_FEATURE)
-	if (last != _transportConfig.parentNodeId) {
+#if defined(MY_TRANSPORT_PARENT_LOAD)
+uint8_t transportGetLoad(void)
+{
+#if defined(MY_TRANSPORT_DUTY_CYCLE_FEATURE)
+	uint8_t load = (uint8_t)min((uint16_t)(transportGetDutyCycle() * 255u / 100u), (uint16_t)255u);
 #else
-	// GW doesn't have parent
-	{
+	transportUpdateAirtime();
+	uint8_t load = _transportLoadAirtime;
 #endif
-		// Message is from one of the child nodes and not sent from this node. Add it to routing table.
-		if (sender != _transportConfig.nodeId)
-		{
-			transportSetRoute(sender, last);
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+	uint16_t queued = 0u;
+	for (uint8_t i = 0u; i < TRANSPORT_TX_QUEUES; i++) {
+		queued += _transportTxQueue[i].available();
+	}
+	const uint8_t fill = (uint8_t)(queued * 255u / (TRANSPORT_TX_QUEUES * MY_TRANSPORT_TX_QUEUE_SIZE));
+	load = max(load, fill);
+#endif
+	return load;
+}
+
+uint16_t transportParentCost(const uint8_t distance, const int16_t rssi, const uint8_t load)
+{
+	uint16_t cost = (uint16_t)distance * 100u + (uint16_t)((uint32_t)load *
+	                MY_TRANSPORT_PARENT_LOAD_WEIGHT / 255u);
+	if (rssi != INVALID_RSSI && rssi < TRANSPORT_PARENT_LOAD_RSSI_GOOD) {
+		// weak links lose frames and need retries
+		cost += (uint16_t)min((TRANSPORT_PARENT_LOAD_RSSI_GOOD - rssi) * 4, 100);
+	}
+	return cost;
+}
+#endif
+
+#if defined(TRANSPORT_PARENT_REVIEW)
+void transportReviewParent(void)
+{
+	if (!_transportParentReviewActive) {
+		if ((int32_t)(hwMillis() - _transportParentReviewTime) < 0) {
+			return;
 		}
+		TRANSPORT_DEBUG(PSTR("TSM:READY:PAR REVIEW\n"));
+		_transportParentReviewActive = true;
+		_transportParentReviewTime = hwMillis();
+		_transportParentReviewBest = AUTO;
+		_transportParentReviewBestCost = UINT16_MAX;
+		_transportParentReviewCost = UINT16_MAX;
+		// the current parent answers as well, the node stays connected meanwhile
+		(void)transportRouteMessage(build(_msgTmp, BROADCAST_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+		                                  I_FIND_PARENT_REQUEST).set(""));
+		return;
 	}
-#endif // MY_REPEATER_FEATURE
+	if (hwMillis() - _transportParentReviewTime < MY_TRANSPORT_STATE_TIMEOUT_MS) {
+		return;
+	}
+	_transportParentReviewActive = false;
+	_transportParentReviewTime = hwMillis() + MY_TRANSPORT_PARENT_LOAD_INTERVAL_MS;
+	// a silent parent is left to the uplink monitoring
+	if (_transportParentReviewBest == AUTO || _transportParentReviewCost == UINT16_MAX ||
+	        (uint32_t)_transportParentReviewBestCost + MY_TRANSPORT_PARENT_LOAD_HYSTERESIS >=
+	        _transportParentReviewCost) {
+		return;
+	}
+	TRANSPORT_DEBUG(PSTR("TSM:READY:PAR MOVE,O=%" PRIuNodeId ",N=%" PRIuNodeId "\n"),
+	                _transportConfig.parentNodeId, _transportParentReviewBest);
+	_transportConfig.parentNodeId = _transportParentReviewBest;
+	_transportConfig.distanceGW = _transportParentReviewDistance;
+	_transportParentCost = _transportParentReviewBestCost;
+	// the ping to the GW also updates the routes on the way
+	transportSwitchSM(stUplink);
+}
 
-	// set message received flag
-	_transportSM.msgReceived = true;
+void transportReviewParentResponse(const nodeId_t nodeId, const uint8_t distance,
+                                   const uint16_t cost)
+{
+	TRANSPORT_DEBUG(PSTR("TSF:MSG:FPAR REVIEW,ID=%" PRIuNodeId ",C=%" PRIu16 "\n"), nodeId, cost);
+	if (nodeId == _transportConfig.parentNodeId) {
+		_transportParentReviewCost = cost;
+	} else if (distance <= _transportConfig.distanceGW && cost < _transportParentReviewBestCost) {
+		// never further from the GW, nodes behind this one would answer otherwise
+		_transportParentReviewBest = nodeId;
+		_transportParentReviewDistance = distance;
+		_transportParentReviewBestCost = cost;
+	}
+}
+#endif
 
-	// Is message addressed to this node?
-	if (destination == _transportConfig.nodeId) {
-		// prevent buffer overflow by limiting max. possible message length (5 bits=31 bytes max) to MAX_PAYLOAD (25 bytes)
-		mSetLength(_msg, min(mGetLength(_msg), (uint8_t)MAX_PAYLOAD));
-		// null terminate data
-		_msg.data[msgLength] = 0u;
-		// Check if sender requests an echo.
-		if (mGetRequestEcho(_msg)) {
-			TRANSPORT_DEBUG(PSTR("TSF:MSG:ECHO REQ\n"));	// ECHO requested
-			_msgTmp = _msg;	// Copy message
-			// Reply without echo flag (otherwise we would end up in an eternal loop)
-			mSetRequestEcho(_msgTmp, false);
-			mSetEcho(_msgTmp, true); // set ECHO flag
-			_msgTmp.sender = _transportConfig.nodeId;
-			_msgTmp.destination = sender;
-			// send ECHO, use transportSendRoute since ECHO reply is not internal, i.e. if !transportOK do not reply
-			(void)transportSendRoute(_msgTmp);
+#if defined(MY_GATEWAY_FEATURE) && defined(MY_GATEWAY_ID_ALLOCATOR)
+bool transportAllocateNodeId(const MyMessage &request)
+{
+	const uint32_t now = hwMillis();
+	transportIdLease_t *lease = NULL;
+	bool released = false;
+	for (uint8_t i = 0u; i < MY_GATEWAY_ID_ALLOCATOR_LEASES; i++) {
+		transportIdLease_t *entry = &_transportIdLeases[i];
+		if (entry->leasedAt && now - entry->leasedAt >= MY_GATEWAY_ID_ALLOCATOR_LEASE_MS) {
+			// never used, e.g. the node restarted and asks with another token
+			TRANSPORT_DEBUG(PSTR("TSF:IDA:EXPIRED,N=%" PRIuNodeId "\n"), entry->nodeId);
+			transportSetRoute(entry->nodeId, BROADCAST_ADDRESS);
+			entry->leasedAt = 0u;
+			released = true;
+		}
+		if (entry->leasedAt && entry->token == request.sensor && entry->via == request.last) {
+			// a retry, the response got lost
+			lease = entry;
+		}
+	}
+	nodeId_t nodeId;
+	if (lease != NULL) {
+		nodeId = lease->nodeId;
+		if (released) {
+			transportSaveRoutingTable();
+		}
+	} else {
+		nodeId = MY_GATEWAY_ID_ALLOCATOR_FIRST;
+		// IDs without route never sent a message through the GW, 255 is the broadcast of the controller
+		while (transportGetRoute(nodeId) != BROADCAST_ADDRESS || nodeId == 255u) {
+			if (nodeId >= MY_GATEWAY_ID_ALLOCATOR_LAST) {
+				TRANSPORT_DEBUG(PSTR("!TSF:IDA:FULL\n"));
+				return false;
+			}
+			nodeId++;
+		}
+		// the lease is the route, via the repeater that relayed the request or direct
+		transportSetRoute(nodeId, request.last == AUTO ? nodeId : request.last);
+#if defined(MY_NODE_ID_16BIT)
+		if (transportGetRoute(nodeId) == BROADCAST_ADDRESS) {
+			// no free entry in the routing table
+			TRANSPORT_DEBUG(PSTR("!TSF:IDA:FULL\n"));
+			return false;
 		}
-		if(!mGetEcho(_msg)) {
-			// only process if not ECHO
-			if (command == C_INTERNAL) {
-				// Process signing related internal messages
-				if (signerProcessInternal(_msg)) {
-					return; // Signer processing indicated no further action needed
-				}
-#if !defined(MY_GATEWAY_FEATURE)
-				if (type == I_ID_RESPONSE) {
-#if (MY_NODE_ID == AUTO)
-					// only active if node ID dynamic
-					if ((_msg.sensor == _transportToken) || (_msg.sensor == AUTO)) {
-						(void)transportAssignNodeID(_msg.getByte());
-					} else {
-						TRANSPORT_DEBUG(PSTR("!TSF:MSG:ID TK INVALID\n"));
-					}
 #endif
-					return; // no further processing required
-				}
-				if (type == I_FIND_PARENT_RESPONSE) {
-#if !defined(MY_GATEWAY_FEATURE) && !defined(MY_PARENT_NODE_IS_STATIC)
-					if (_transportSM.findingParentNode) {	// only process if find parent active
-						// Reply to a I_FIND_PARENT_REQUEST message. Check if the distance is shorter than we already have.
-						uint8_t distance = _msg.getByte();
-						if (isValidDistance(distance)) {
-							distance++;	// Distance to gateway is one more for us w.r.t. parent
-							// update settings if distance shorter or preferred parent found
-							if (((isValidDistance(distance) && distance < _transportConfig.distanceGW) || (!_autoFindParent &&
-							        sender == (uint8_t)MY_PARENT_NODE_ID)) && !_transportSM.preferredParentFound) {
-								// Found a neighbor closer to GW than previously found
-								if (!_autoFindParent && sender == (uint8_t)MY_PARENT_NODE_ID) {
-									_transportSM.preferredParentFound = true;
-									TRANSPORT_DEBUG(PSTR("TSF:MSG:FPAR PREF\n"));	// find parent, preferred parent found
+		transportSaveRoutingTable();
+		// free entries are the oldest, if all are pending the oldest one is kept as route only
+		lease = &_transportIdLeases[0];
+		for (uint8_t i = 1u; i < MY_GATEWAY_ID_ALLOCATOR_LEASES; i++) {
+			transportIdLease_t *entry = &_transportIdLeases[i];
+			if (!entry->leasedAt || (lease->leasedAt && now - entry->leasedAt > now - lease->leasedAt)) {
+				lease = entry;
+			}
+		}
+		lease->nodeId = nodeId;
+		lease->via = request.last;
+		lease->token = request.sensor;
+	}
+	lease->leasedAt = now ? now : 1u;	// 0 marks unused entries
+	TRANSPORT_DEBUG(PSTR("TSF:IDA:LEASE,T=%" PRIu8 ",N=%" PRIuNodeId "\n"), request.sensor, nodeId);
+	// the node has no ID yet and takes the response addressed to its token
+	(void)transportRouteMessage(build(_msgTmp, BROADCAST_ADDRESS, request.sensor, C_INTERNAL,
+	                                  I_ID_RESPONSE).set(nodeId));
+	(void)gatewayTransportSend(_msgTmp);
+	return true;
+}
+
+void transportConfirmNodeId(const nodeId_t nodeId)
+{
+	for (uint8_t i = 0u; i < MY_GATEWAY_ID_ALLOCATOR_LEASES; i++) {
+		transportIdLease_t *entry = &_transportIdLeases[i];
+		if (entry->leasedAt && entry->nodeId == nodeId) {
+			// the node took the ID, its route keeps it from now on
+			TRANSPORT_DEBUG(PSTR("TSF:IDA:USED,N=%" PRIuNodeId "\n"), nodeId);
+			entry->leasedAt = 0u;
+		}
+	}
+}
+#endif
+
+void transportDeferReply(const nodeId_t destination, const uint8_t type)
+{
+	transportDeferredReply_t *entry = NULL;
+	for (uint8_t i = 0u; i < MY_TRANSPORT_DEFERRED_REPLIES; i++) {
+		transportDeferredReply_t *candidate = &_transportDeferredReplies[i];
+		if (candidate->type == type && candidate->destination == destination) {
+			// repeated request, answered by the pending reply
+			return;
+		}
+		if (candidate->type == 0u && entry == NULL) {
+			entry = candidate;
+		}
+	}
+	if (entry == NULL) {
+		TRANSPORT_DEBUG(PSTR("!TSF:RPL:FULL\n"));
+		return;
+	}
+	// the arrival time in us differs between nodes hearing the same request
+	const uint32_t jitter = hwMicros() % MY_TRANSPORT_REPLY_JITTER_MS;
+	entry->due = hwMillis() + jitter;
+	entry->destination = destination;
+	entry->type = type;
+	TRANSPORT_DEBUG(PSTR("TSF:RPL:DEFER,ID=%" PRIuNodeId ",T=%" PRIu8 ",D=%" PRIu32 "\n"), destination, type,
+	                jitter);
+}
+
+MyMessage &transportBuildParentResponse(const nodeId_t destination)
+{
+	(void)build(_msgTmp, destination, NODE_SENSOR_ID, C_INTERNAL,
+	            I_FIND_PARENT_RESPONSE).set(_transportConfig.distanceGW);
+#if defined(MY_TRANSPORT_PARENT_LOAD)
+	// older nodes only read the distance in the first byte
+	_msgTmp.data[1] = (char)transportGetLoad();
+	mSetLength(_msgTmp, 2u);
+#endif
+	return _msgTmp;
+}
+
+bool transportProcessDeferredReplies(void)
+{
+	for (uint8_t i = 0u; i < MY_TRANSPORT_DEFERRED_REPLIES; i++) {
+		transportDeferredReply_t *entry = &_transportDeferredReplies[i];
+		if (entry->type == 0u || (int32_t)(hwMillis() - entry->due) < 0) {
+			continue;
+		}
+		const uint8_t type = entry->type;
+		entry->type = 0u;
+		if (type == I_FIND_PARENT_RESPONSE) {
+			// the uplink may have failed since the request
+			if (isTransportReady()) {
+				(void)transportRouteMessage(transportBuildParentResponse(entry->destination));
+			}
+		} else {
+			(void)transportRouteMessage(build(_msgTmp, entry->destination, NODE_SENSOR_ID, C_INTERNAL,
+			                                  type).set(_transportConfig.parentNodeId));
+		}
+		// one reply at a time, received messages are processed in between
+		return true;
+	}
+	return false;
+}
+
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+transportTxPriority_t transportTxPriority(const MyMessage &message)
+{
+#if defined(MY_TRANSPORT_TX_QUEUE_PRIORITY)
+	const uint8_t command = mGetCommand(message);
+	if (command == C_STREAM || command == C_PRESENTATION) {
+		return TRANSPORT_TX_PRIORITY_BULK;
+	}
+	if ((command == C_SET || command == C_REQ) && message.sender == GATEWAY_ADDRESS) {
+		return TRANSPORT_TX_PRIORITY_CONTROL;
+	}
+#else
+	(void)message;
+#endif
+	return TRANSPORT_TX_PRIORITY_DATA;
+}
+
+bool transportProcessTxQueue(void)
+{
+	// signing waits for the nonce in _process(), which calls this again
+	static bool sending = false;
+	if (sending) {
+		return false;
+	}
+	// the highest priority class with messages pending
+	uint8_t priority = 0u;
+	while (priority < TRANSPORT_TX_QUEUES - 1u && _transportTxQueue[priority].empty()) {
+		priority++;
+	}
+	CircularBuffer<transportTxQueueEntry_t> &queue = _transportTxQueue[priority];
+	transportTxQueueEntry_t *entry = queue.getBack();
+	if (entry == NULL) {
+		return false;
+	}
+#if defined(MY_TRANSPORT_PACING)
+	if (entry->message.destination == GATEWAY_ADDRESS &&
+	        hwMillis() - _transportPacingLast < _transportPacingGapMS) {
+		return false;
+	}
+#endif
+#if defined(MY_TRANSPORT_DUTY_CYCLE_FEATURE)
+	if (!transportDutyCycleAllows(entry->message)) {
+		// deferred until the budget allows it, the other messages are tried first
+		if (queue.available() > 1u) {
+			transportTxQueueEntry_t deferred = *entry;
+			(void)queue.popBack();
+			(void)queue.pushFront(&deferred);
+		}
+		return false;
+	}
+#endif
+	// taken off the queue while it is sent, messages queued meanwhile may reuse its slot
+	transportTxQueueEntry_t current = *entry;
+	(void)queue.popBack();
+	// the radio may retry on its own, the queue round-robins between messages on top of that
+	sending = true;
+	const bool result = transportRouteMessage(current.message);
+	sending = false;
+	if (!result && current.attempts < MY_TRANSPORT_TX_QUEUE_RETRIES) {
+		current.attempts++;
+		STATS_INC(STATS_TX_RETRIES);
+		TRANSPORT_DEBUG(PSTR("!TSF:TXQ:RETRY,A=%" PRIu8 "\n"), current.attempts);
+		if (queue.pushFront(&current)) {
+			return true;
+		}
+	}
+	if (!result) {
+		STATS_INC(STATS_TX_DROPPED);
+		TRANSPORT_DEBUG(PSTR("!TSF:TXQ:DROP\n"));
+	}
+	if (_transportTx_cb) {
+		_transportTx_cb(current.message, result);
+	}
+	return true;
+}
+
+void transportRegisterTxCallback(transportTxCallback_t cb)
+{
+	_transportTx_cb = cb;
+}
+
+uint8_t transportTxQueuePending(void)
+{
+	uint8_t pending = 0u;
+	for (uint8_t priority = 0u; priority < TRANSPORT_TX_QUEUES; priority++) {
+		pending += _transportTxQueue[priority].available();
+	}
+	return pending;
+}
+
+uint8_t transportTxQueueFree(const transportTxPriority_t priority)
+{
+	const uint8_t index = (TRANSPORT_TX_QUEUES > 1u) ? (uint8_t)priority : 0u;
+	return (uint8_t)(MY_TRANSPORT_TX_QUEUE_SIZE - _transportTxQueue[index].available());
+}
+#endif
+
+#if defined(MY_TRANSPORT_FRAGMENTATION)
+transportFragmentSlot_t *transportReassemble(const MyMessage &fragment)
+{
+	const uint8_t length = mGetLength(fragment);
+	const uint8_t *payload = (const uint8_t *)fragment.data;
+	const uint8_t index = payload[1] & ~FRAGMENT_LAST;
+	const bool last = payload[1] & FRAGMENT_LAST;
+	const uint16_t offset = (uint16_t)index * FRAGMENT_DATA_SIZE;
+	const uint8_t dataLength = length - FRAGMENT_HEADER_SIZE;
+	// all but the last fragment are full, so the offset follows from the index
+	if (length < FRAGMENT_HEADER_SIZE || index >= FRAGMENT_MAX_COUNT ||
+	        (!last && dataLength != FRAGMENT_DATA_SIZE) ||
+	        offset + dataLength > MY_TRANSPORT_FRAGMENT_MAX_LENGTH) {
+		TRANSPORT_DEBUG(PSTR("!TSF:FRG:LEN,ID=%" PRIuNodeId "\n"), fragment.sender);
+		return NULL;
+	}
+	transportFragmentSlot_t *slot = NULL;
+	transportFragmentSlot_t *replace = &_transportFragments[0];
+	for (uint8_t i = 0; i < MY_TRANSPORT_FRAGMENT_SLOTS; i++) {
+		transportFragmentSlot_t &entry = _transportFragments[i];
+		if (entry.received && hwMillis() - entry.started > MY_TRANSPORT_FRAGMENT_TIMEOUT_MS) {
+			TRANSPORT_DEBUG(PSTR("!TSF:FRG:DROP,ID=%" PRIuNodeId "\n"), entry.sender);
+			entry.received = 0;
+		}
+		if (entry.received && entry.sender == fragment.sender && entry.id == payload[0]) {
+			slot = &entry;
+			break;
+		}
+		// a free slot, else the oldest one
+		if (replace->received && (!entry.received || entry.started - replace->started > 0x7FFFFFFFul)) {
+			replace = &entry;
+		}
+	}
+	if (slot == NULL) {
+		slot = replace;
+		if (slot->received) {
+			TRANSPORT_DEBUG(PSTR("!TSF:FRG:DROP,ID=%" PRIuNodeId "\n"), slot->sender);
+		}
+		slot->received = 0;
+		slot->started = hwMillis();
+		slot->sender = fragment.sender;
+		slot->id = payload[0];
+		slot->sensor = fragment.sensor;
+		slot->type = payload[2];
+		slot->last = FRAGMENT_MAX_COUNT;
+	}
+	(void)memcpy((void *)&slot->data[offset], (const void *)&payload[FRAGMENT_HEADER_SIZE], dataLength);
+	slot->received |= (uint32_t)1 << index;
+	if (last) {
+		slot->last = index;
+		slot->length = offset + dataLength;
+	}
+	// a missing fragment is not requested again, the block times out then
+	if (slot->last < FRAGMENT_MAX_COUNT && slot->received == ((uint32_t)2 << slot->last) - 1u) {
+		TRANSPORT_DEBUG(PSTR("TSF:FRG:OK,ID=%" PRIuNodeId ",L=%" PRIu16 "\n"), slot->sender, slot->length);
+		return slot;
+	}
+	return NULL;
+}
+#endif
+
+bool transportUnpackAggregate(MyMessage &message, const MyMessage &aggregate, uint8_t &position)
+{
+	const uint8_t aggregateLength = mGetLength(aggregate);
+	if (position + AGGREGATE_RECORD_HEADER_SIZE > aggregateLength) {
+		return false;
+	}
+	const uint8_t *record = (const uint8_t *)&aggregate.data[position];
+	message.last = aggregate.last;
+	(void)memcpy((void *)&message.sender, (const void *)record, sizeof(message.sender));
+	message.destination = aggregate.destination;
+	message.version_length = record[sizeof(message.sender)];
+	message.command_echo_payload = record[sizeof(message.sender) + 1];
+	message.type = record[sizeof(message.sender) + 2];
+	message.sensor = record[sizeof(message.sender) + 3];
+	const uint8_t length = mGetLength(message);
+	if (position + AGGREGATE_RECORD_HEADER_SIZE + length > aggregateLength) {
+		return false;
+	}
+	(void)memcpy((void *)message.data, (const void *)&record[AGGREGATE_RECORD_HEADER_SIZE], length);
+	message.data[length] = 0;	// terminate string payloads
+	position += AGGREGATE_RECORD_HEADER_SIZE + length;
+	return true;
+}
+
+#if defined(MY_TRANSPORT_AGGREGATION) && defined(MY_REPEATER_FEATURE) && !defined(MY_GATEWAY_FEATURE)
+bool transportAggregate(const MyMessage &message)
+{
+	const uint8_t length = mGetLength(message);
+	// signatures cover the frame as sent, echo requests expect the frame back
+	if (message.destination != GATEWAY_ADDRESS || mGetCommand(message) != C_SET ||
+	        mGetSigned(message) || mGetRequestEcho(message) ||
+	        AGGREGATE_RECORD_HEADER_SIZE + length > MAX_PAYLOAD) {
+		return false;
+	}
+	if (_transportAggregateCount &&
+	        mGetLength(_transportAggregate) + AGGREGATE_RECORD_HEADER_SIZE + length > MAX_PAYLOAD) {
+		transportFlushAggregate();
+	}
+	if (!_transportAggregateCount) {
+		(void)build(_transportAggregate, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_AGGREGATE);
+		mSetSigned(_transportAggregate, false);
+		mSetLength(_transportAggregate, 0);
+		mSetPayloadType(_transportAggregate, P_CUSTOM);
+		_transportAggregateStart = hwMillis();
+	}
+	const uint8_t position = mGetLength(_transportAggregate);
+	uint8_t *record = (uint8_t *)&_transportAggregate.data[position];
+	(void)memcpy((void *)record, (const void *)&message.sender, sizeof(message.sender));
+	record[sizeof(message.sender)] = message.version_length;
+	record[sizeof(message.sender) + 1] = message.command_echo_payload;
+	record[sizeof(message.sender) + 2] = message.type;
+	record[sizeof(message.sender) + 3] = message.sensor;
+	(void)memcpy((void *)&record[AGGREGATE_RECORD_HEADER_SIZE], (const void *)message.data, length);
+	mSetLength(_transportAggregate, position + AGGREGATE_RECORD_HEADER_SIZE + length);
+	_transportAggregateCount++;
+	TRANSPORT_DEBUG(PSTR("TSF:AGG:ADD,ID=%" PRIuNodeId ",N=%" PRIu8 "\n"), message.sender,
+	                _transportAggregateCount);
+	if (mGetLength(_transportAggregate) + AGGREGATE_RECORD_HEADER_SIZE > MAX_PAYLOAD) {
+		// not even an empty frame fits anymore
+		transportFlushAggregate();
+	}
+	return true;
+}
+
+void transportFlushAggregate(void)
+{
+	if (!_transportAggregateCount) {
+		return;
+	}
+	if (_transportAggregateCount == 1) {
+		// no gain from a single frame, relay it as received
+		uint8_t position = 0;
+		(void)transportUnpackAggregate(_msgTmp, _transportAggregate, position);
+		(void)transportQueueRoute(_msgTmp);
+	} else {
+		TRANSPORT_DEBUG(PSTR("TSF:AGG:SEND,N=%" PRIu8 ",L=%" PRIu8 "\n"), _transportAggregateCount,
+		                mGetLength(_transportAggregate));
+		(void)transportQueueRoute(_transportAggregate);
+	}
+	_transportAggregateCount = 0;
+}
+#endif
+
+// only be used inside transport
+bool transportWait(const uint32_t waitingMS, const uint8_t cmd, const uint8_t msgType)
+{
+	const uint32_t enterMS = hwMillis();
+	// invalidate msg type
+	_msg.type = !msgType;
+	bool expectedResponse = false;
+	while ((hwMillis() - enterMS < waitingMS) && !expectedResponse) {
+		// process incoming messages
+		transportProcessFIFO();
+		doYield();
+		expectedResponse = (mGetCommand(_msg) == cmd && _msg.type == msgType);
+		if (!expectedResponse) {
+			_waitIdle(enterMS, waitingMS);
+		}
+	}
+	return expectedResponse;
+}
+
+uint8_t transportPingNode(const nodeId_t targetId)
+{
+	if(!_transportSM.pingActive) {
+		TRANSPORT_DEBUG(PSTR("TSF:PNG:SEND,TO=%" PRIuNodeId "\n"), targetId);
+		if(targetId == _transportConfig.nodeId) {
+			// pinging self
+			_transportSM.pingResponse = 0u;
+		} else {
+			_transportSM.pingActive = true;
+			_transportSM.pingResponse = INVALID_HOPS;
+			(void)transportRouteMessage(build(_msgTmp, targetId, NODE_SENSOR_ID, C_INTERNAL,
+			                                  I_PING).set((uint8_t)0x01));
+			// Wait for ping reply or timeout
+			(void)transportWait(2000, C_INTERNAL, I_PONG);
+		}
+		// make sure missing I_PONG msg does not block pinging function by leaving pingActive=true
+		_transportSM.pingActive = false;
+		return _transportSM.pingResponse;
+	} else {
+		TRANSPORT_DEBUG(PSTR("!TSF:PNG:ACTIVE\n"));	// ping active, cannot start new ping
+		return INVALID_HOPS;
+	}
+}
+
+uint32_t transportGetHeartbeat(void)
+{
+	return transportTimeInState();
+}
+
+#if defined(MY_TRANSPORT_DIRECT_CACHE) && !defined(MY_REPEATER_FEATURE)
+transportDirect_t *transportGetDirect(const nodeId_t destination)
+{
+	for (uint8_t i = 0; i < MY_TRANSPORT_DIRECT_CACHE_SIZE; i++) {
+		transportDirect_t *entry = &_transportDirect[i];
+		if (entry->updated && entry->nodeId == destination) {
+			return (hwMillis() - entry->updated < MY_TRANSPORT_DIRECT_CACHE_MS) ? entry : NULL;
+		}
+	}
+	return NULL;
+}
+
+void transportSetDirect(const nodeId_t destination, const bool direct)
+{
+	const uint32_t now = hwMillis();
+	// the destination's entry, otherwise a free or the oldest one
+	transportDirect_t *entry = NULL;
+	uint32_t age = 0u;
+	for (uint8_t i = 0; i < MY_TRANSPORT_DIRECT_CACHE_SIZE; i++) {
+		transportDirect_t *candidate = &_transportDirect[i];
+		if (candidate->updated && candidate->nodeId == destination) {
+			entry = candidate;
+			break;
+		}
+		const uint32_t candidateAge = candidate->updated ? now - candidate->updated : UINT32_MAX;
+		if (entry == NULL || candidateAge > age) {
+			entry = candidate;
+			age = candidateAge;
+		}
+	}
+	entry->nodeId = destination;
+	entry->direct = direct;
+	entry->updated = now ? now : 1u;	// 0 marks free entries
+}
+#endif
+
+#if defined(MY_TRANSPORT_DUPLICATE_FILTER)
+uint16_t transportGetDuplicateCount(void)
+{
+	return _transportDuplicateCount;
+}
+#endif
+
+#if defined(MY_TRANSPORT_DUPLICATE_FILTER) || defined(MY_TRANSPORT_BROADCAST_FLOODING)
+uint16_t transportMessageHash(const MyMessage &message, const uint8_t length)
+{
+	// hash header and payload, the last hop changes if the message arrives via another repeater
+	const uint8_t *data = (const uint8_t *)&message.sender;
+	uint16_t hash = 5381u;
+	for (uint8_t i = 0; i < HEADER_SIZE - sizeof(message.last) + length; i++) {
+		hash = (uint16_t)((hash << 5) + hash + data[i]);
+	}
+	return hash;
+}
+#endif
+
+#if defined(MY_TRANSPORT_BROADCAST_FLOODING)
+bool transportBroadcastSeen(MyMessage &message, const bool relay)
+{
+	const uint16_t hash = transportMessageHash(message, min(mGetLength(message), (uint8_t)MAX_PAYLOAD));
+	const uint32_t now = hwMillis();
+	transportBroadcast_t *entry = NULL;
+	for (uint8_t i = 0; i < MY_TRANSPORT_BROADCAST_CACHE_SIZE; i++) {
+		transportBroadcast_t *candidate = &_transportBroadcasts[i];
+		const bool current = candidate->received &&
+		                      (candidate->pending || now - candidate->received < MY_TRANSPORT_BROADCAST_WINDOW_MS);
+		if (current && candidate->sender == message.sender && candidate->hash == hash) {
+			// another copy, each one makes the relay of this node less useful
+			if (candidate->heard < UINT8_MAX) {
+				candidate->heard++;
+			}
+			TRANSPORT_DEBUG(PSTR("TSF:BCF:SEEN,ID=%" PRIuNodeId ",N=%" PRIu8 "\n"), message.sender,
+			                candidate->heard);
+			return true;
+		}
+		// replace the oldest entry not waiting for its relay, free entries are the oldest
+		if (!candidate->pending && (entry == NULL || now - candidate->received > now - entry->received)) {
+			entry = candidate;
+		}
+	}
+	if (entry == NULL) {
+		// all entries wait for their relay, relay this one as received
+		TRANSPORT_DEBUG(PSTR("!TSF:BCF:FULL\n"));
+		if (relay) {
+			(void)transportQueueRoute(message);
+		}
+		return false;
+	}
+	entry->received = now ? now : 1u;	// 0 marks unused entries
+	entry->hash = hash;
+	entry->sender = message.sender;
+	entry->heard = 1u;
+	entry->pending = relay;
+	if (relay) {
+		// neighbours hearing the same broadcast pick different delays
+		const uint32_t jitter = hwMicros() % MY_TRANSPORT_BROADCAST_JITTER_MS;
+		entry->due = now + jitter;
+		entry->message = message;
+		TRANSPORT_DEBUG(PSTR("TSF:BCF:DEFER,ID=%" PRIuNodeId ",D=%" PRIu32 "\n"), message.sender, jitter);
+	}
+	return false;
+}
+
+bool transportProcessBroadcasts(void)
+{
+	for (uint8_t i = 0; i < MY_TRANSPORT_BROADCAST_CACHE_SIZE; i++) {
+		transportBroadcast_t *entry = &_transportBroadcasts[i];
+		if (!entry->pending || (int32_t)(hwMillis() - entry->due) < 0) {
+			continue;
+		}
+		entry->pending = false;
+		if (entry->heard >= MY_TRANSPORT_BROADCAST_THRESHOLD) {
+			// enough neighbours relayed it already
+			STATS_INC(STATS_BC_SUPPRESSED);
+			TRANSPORT_DEBUG(PSTR("TSF:BCF:SUPP,ID=%" PRIuNodeId ",N=%" PRIu8 "\n"), entry->sender, entry->heard);
+			continue;
+		}
+		if (!isTransportReady()) {
+			continue;
+		}
+		TRANSPORT_DEBUG(PSTR("TSF:MSG:FWD BC MSG\n")); // controlled broadcast msg forwarding
+		(void)transportQueueRoute(entry->message);
+		// one relay at a time, received messages are processed in between
+		return true;
+	}
+	return false;
+}
+#endif
+
+#if defined(MY_TRANSPORT_DUPLICATE_FILTER)
+bool transportIsDuplicate(const MyMessage &message, const uint8_t length)
+{
+	if (mGetCommand(message) == C_INTERNAL) {
+		switch (message.type) {
+		case I_ID_REQUEST:
+		case I_ID_RESPONSE:
+		case I_FIND_PARENT_REQUEST:
+		case I_FIND_PARENT_RESPONSE:
+		case I_SIGNING_PRESENTATION:
+		case I_NONCE_REQUEST:
+		case I_NONCE_RESPONSE:
+		case I_DISCOVER_REQUEST:
+		case I_DISCOVER_RESPONSE:
+		case I_PING:
+		case I_PONG:
+		case I_REGISTRATION_REQUEST:
+		case I_REGISTRATION_RESPONSE:
+		case I_RECEIPT:
+			// handshakes are repeated on purpose and most look the same every time
+			return false;
+		default:
+			break;
+		}
+	}
+	// a signature is made with a new nonce for each message sent, but kept in resends
+	const uint8_t signedLength = length + (mGetSigned(message) ? signerGetSignatureLength(message) : 0);
+	uint16_t key = 0u;
+	bool sequenced = false;
+#if defined(MY_TRANSPORT_SEQUENCE)
+	const uint8_t frameLength = HEADER_SIZE + signedLength;
+	if (message.destination == GATEWAY_ADDRESS && frameLength < MAX_MESSAGE_LENGTH) {
+		// a radio resend keeps the number, a message sent again takes the next one
+		key = ((const uint8_t *)&message.last)[frameLength];
+		sequenced = key != 0u;
+	}
+#endif
+	if (!sequenced) {
+		key = transportMessageHash(message, min(signedLength, (uint8_t)MAX_PAYLOAD));
+	}
+	const uint32_t now = hwMillis();
+	for (uint8_t i = 0; i < MY_TRANSPORT_DUPLICATE_CACHE_SIZE; i++) {
+		transportDuplicate_t *entry = &_transportDuplicates[i];
+		if (entry->sender == message.sender && entry->key == key && entry->sequenced == sequenced &&
+		        entry->received && now - entry->received < MY_TRANSPORT_DUPLICATE_WINDOW_MS) {
+			return true;
+		}
+	}
+	transportDuplicate_t *entry = &_transportDuplicates[_transportDuplicatesNext];
+	_transportDuplicatesNext = (_transportDuplicatesNext + 1) % MY_TRANSPORT_DUPLICATE_CACHE_SIZE;
+	entry->sender = message.sender;
+	entry->key = key;
+	entry->sequenced = sequenced;
+	entry->received = now ? now : 1u;	// 0 marks unused entries
+	return false;
+}
+#endif
+
+#if defined(MY_TRANSPORT_RECEIPTS)
+uint16_t transportReceiptHash(const MyMessage &message)
+{
+	const uint8_t *data = (const uint8_t *)message.data;
+	uint16_t hash = 5381u;
+	for (uint8_t i = 0; i < mGetLength(message); i++) {
+		hash = (uint16_t)((hash << 5) + hash + data[i]);
+	}
+	return hash;
+}
+
+static MyMessage *transportReceiptFind(const nodeId_t destination, const uint8_t sensor,
+                                       const uint8_t command, const uint8_t type, const uint16_t hash)
+{
+	for (uint8_t i = 0u; i < MY_TRANSPORT_RECEIPT_SLOTS; i++) {
+		MyMessage &slot = _transportReceipts[i];
+		if (mGetRequestEcho(slot) && slot.destination == destination && slot.sensor == sensor &&
+		        mGetCommand(slot) == command && slot.type == type && transportReceiptHash(slot) == hash) {
+			return &slot;
+		}
+	}
+	return NULL;
+}
+
+void transportReceiptExpect(const MyMessage &message)
+{
+	if (transportReceiptFind(message.destination, message.sensor, mGetCommand(message), message.type,
+	                         transportReceiptHash(message)) != NULL) {
+		// sent again, e.g. by the TX queue
+		return;
+	}
+	_transportReceipts[_transportReceiptsNext] = message;
+	_transportReceiptsNext = (_transportReceiptsNext + 1u) % MY_TRANSPORT_RECEIPT_SLOTS;
+}
+
+bool transportReceiptToEcho(MyMessage &receipt)
+{
+	if (mGetLength(receipt) < 4u) {
+		return false;
+	}
+	const uint8_t *data = (const uint8_t *)receipt.data;
+	MyMessage *expected = transportReceiptFind(receipt.sender, receipt.sensor, data[0], data[1],
+	                   data[2] | (uint16_t)data[3] << 8);
+	if (expected == NULL) {
+		return false;
+	}
+	// as the destination would have echoed it
+	const nodeId_t sender = receipt.sender;
+	const nodeId_t last = receipt.last;
+	receipt = *expected;
+	mSetRequestEcho((*expected), false);
+	mSetRequestEcho(receipt, false);
+	mSetEcho(receipt, true);
+	receipt.destination = receipt.sender;
+	receipt.sender = sender;
+	receipt.last = last;
+	return true;
+}
+#endif
+
+void transportUpdateAirtime(void)
+{
+	const uint32_t airtime = transportHALGetAirtime();
+	const uint32_t elapsed = airtime - _transportAirtime;
+	_transportAirtime = airtime;
+#if defined(MY_STATS_FEATURE)
+	_transportAirtimeUncounted += elapsed;
+	STATS_ADD(STATS_TX_AIRTIME_MS, _transportAirtimeUncounted / 1000u);
+	_transportAirtimeUncounted %= 1000u;
+#endif
+#if defined(MY_TRANSPORT_PARENT_LOAD) && !defined(MY_TRANSPORT_DUTY_CYCLE_FEATURE)
+	_transportLoadAirtimeUs += elapsed;
+	const uint32_t window = hwMillis() - _transportLoadWindowStart;
+	if (window >= TRANSPORT_PARENT_LOAD_WINDOW_MS) {
+		// share of the window, full scale at TRANSPORT_PARENT_LOAD_AIRTIME permille
+		const uint64_t share = (uint64_t)_transportLoadAirtimeUs * 255u / ((uint64_t)window *
+		                       TRANSPORT_PARENT_LOAD_AIRTIME);
+		_transportLoadAirtime = (uint8_t)min(share, (uint64_t)255u);
+		_transportLoadAirtimeUs = 0u;
+		_transportLoadWindowStart += window;
+	}
+#endif
+#if defined(MY_TRANSPORT_DUTY_CYCLE_FEATURE)
+	const uint32_t now = hwMillis();
+	if (now - _transportDutyCycleSlotStart >= MY_TRANSPORT_DUTY_CYCLE_WINDOW_MS) {
+		// nothing sent for a whole window
+		(void)memset((void *)_transportDutyCycleSlots, 0, sizeof(_transportDutyCycleSlots));
+		_transportDutyCycleSlotStart = now;
+	}
+	while (now - _transportDutyCycleSlotStart >= TRANSPORT_DUTY_CYCLE_SLOT_MS) {
+		_transportDutyCycleSlot = (_transportDutyCycleSlot + 1u) % TRANSPORT_DUTY_CYCLE_SLOTS;
+		_transportDutyCycleSlots[_transportDutyCycleSlot] = 0u;
+		_transportDutyCycleSlotStart += TRANSPORT_DUTY_CYCLE_SLOT_MS;
+	}
+	_transportDutyCycleSlots[_transportDutyCycleSlot] += elapsed;
+#else
+	(void)elapsed;
+#endif
+}
+
+#if defined(MY_TRANSPORT_DUTY_CYCLE_FEATURE)
+uint8_t transportGetDutyCycle(void)
+{
+	transportUpdateAirtime();
+	uint32_t airtimeMS = 0u;
+	for (uint8_t i = 0u; i < TRANSPORT_DUTY_CYCLE_SLOTS; i++) {
+		airtimeMS += _transportDutyCycleSlots[i] / 1000u;
+	}
+	const uint32_t percent = (uint32_t)((uint64_t)airtimeMS * 100u / TRANSPORT_DUTY_CYCLE_BUDGET_MS);
+	return (uint8_t)min(percent, (uint32_t)255u);
+}
+
+bool transportDutyCycleAllows(const MyMessage &message)
+{
+	const uint8_t used = transportGetDutyCycle();
+	if (used >= 100u) {
+		return false;
+	}
+	const uint8_t command = mGetCommand(message);
+	// presentations and OTA blocks leave the rest of the budget to sensor data and commands
+	return used < MY_TRANSPORT_DUTY_CYCLE_THROTTLE || (command != C_PRESENTATION &&
+	        command != C_STREAM);
+}
+#endif
+
+void transportProcessMessage(void)
+{
+	// Manage signing timeout
+	(void)signerCheckTimer();
+	// receive message
+	setIndication(INDICATION_RX);
+	if (transportReceiveMessage()) {
+		// Reject messages that do not pass verification
+		transportHandleMessage(signerVerifyMsg(_msg));
+	}
+}
+
+#if defined(MY_SIGNING_PARALLEL_VERIFY)
+void transportProcessBatch(void)
+{
+	static MyMessage batch[MY_LINUX_SIGNING_VERIFY_BATCH];
+	static bool verified[MY_LINUX_SIGNING_VERIFY_BATCH];
+	// Manage signing timeout
+	(void)signerCheckTimer();
+	setIndication(INDICATION_RX);
+	uint8_t count = 0;
+	while (count < MY_LINUX_SIGNING_VERIFY_BATCH && transportHALDataAvailable()) {
+		if (transportReceiveMessage()) {
+			batch[count++] = _msg;
+		}
+	}
+	// the signatures are checked in parallel, the messages are handled in the order received
+	signerVerifyBatch(batch, verified, count);
+	for (uint8_t i = 0; i < count; i++) {
+		_msg = batch[i];
+		transportHandleMessage(verified[i]);
+		STATS_UPLINK_END();
+	}
+}
+#endif
+
+bool transportReceiveMessage(void)
+{
+	uint8_t payloadLength;
+	// last is the first byte of the payload buffer
+	if (!transportHALReceive(&_msg, &payloadLength)) {
+		return false;
+	}
+	STATS_INC(STATS_RX_FRAMES);
+	STATS_UPLINK(STATS_LATENCY_UPLINK_DEQUEUE);
+#if defined(STATS_LINKS)
+	// the sequence number is read before the payload is terminated, duplicates included
+	const uint8_t frameLength = HEADER_SIZE + payloadLength + (mGetSigned(_msg) ?
+	                            signerGetSignatureLength(_msg) : 0);
+	if (frameLength < MAX_MESSAGE_LENGTH && _msg.destination == _transportConfig.nodeId &&
+	        _msg.sender != AUTO && _msg.sender != _transportConfig.nodeId) {
+		statsLinkRecord(_msg.sender, ((const uint8_t *)&_msg.last)[frameLength]);
+	}
+#endif
+
+#if defined(MY_TRANSPORT_CUT_THROUGH)
+	// decided on the header, relayed frames are not formatted
+	const bool cutThrough = transportIsCutThrough(_msg);
+	if (!cutThrough)
+#endif
+	{
+		TRANSPORT_DEBUG(PSTR("TSF:MSG:READ,%" PRIuNodeId "-%" PRIuNodeId "-%" PRIuNodeId ",s=%" PRIu8 ",c=%" PRIu8
+		                     ",t=%" PRIu8 ",pt=%" PRIu8 ",l=%" PRIu8 ",sg=%" PRIu8 ":%s\n"),
+		                _msg.sender, _msg.last, _msg.destination, _msg.sensor, mGetCommand(_msg), _msg.type,
+		                mGetPayloadType(_msg), min(mGetLength(_msg), (uint8_t)MAX_PAYLOAD), mGetSigned(_msg),
+		                ((mGetCommand(_msg) == C_INTERNAL &&
+		                  _msg.type == I_NONCE_RESPONSE) ? "<NONCE>" : _msg.getString(_convBuf)));
+	}
+
+#if defined(MY_TRANSPORT_DUPLICATE_FILTER)
+	// Drop messages resent because the radio ACK got lost, before verification and routing
+	if (_msg.sender != _transportConfig.nodeId &&
+#if defined(MY_TRANSPORT_BROADCAST_FLOODING)
+	        // the copies of a broadcast are counted by transportBroadcastSeen()
+	        _msg.destination != BROADCAST_ADDRESS &&
+#endif
+	        transportIsDuplicate(_msg, min(mGetLength(_msg), (uint8_t)MAX_PAYLOAD))) {
+		_transportDuplicateCount++;
+		STATS_INC(STATS_RX_DUPLICATES);
+		TRANSPORT_DEBUG(PSTR("!TSF:MSG:DUP,N=%" PRIu16 "\n"), _transportDuplicateCount);
+		return false;
+	}
+#endif
+#if defined(MY_TRANSPORT_CUT_THROUGH)
+	if (cutThrough) {
+		transportCutThrough();
+		return false;
+	}
+#endif
+	return true;
+}
+
+#if defined(MY_TRANSPORT_CUT_THROUGH)
+bool transportIsCutThrough(const MyMessage &message)
+{
+	// internal messages are left to transportHandleMessage(), PING/PONG count the hops and
+	// I_AGGREGATE carries the routes of other nodes
+	return message.destination != _transportConfig.nodeId &&
+	       message.destination != BROADCAST_ADDRESS && message.sender != _transportConfig.nodeId &&
+	       mGetCommand(message) != C_INTERNAL && isTransportReady();
+}
+
+void transportCutThrough(void)
+{
+	// signerVerifyMsg() only checks messages addressed to this node, there is nothing to verify
+	const nodeId_t last = _msg.last;
+#if !defined(MY_GATEWAY_FEATURE) && defined(MY_TRANSPORT_UPLINK_CHECK_PASSIVE)
+	if (_msg.sender == GATEWAY_ADDRESS && last == _transportConfig.parentNodeId) {
+		// the GW is reachable through the parent
+		_transportSM.lastUplinkCheck = hwMillis();
+	}
+#endif
+	// update routing table if msg not from parent
+#if !defined(MY_GATEWAY_FEATURE)
+	if (last != _transportConfig.parentNodeId)
+#endif
+	{
+#if defined(MY_ROUTING_TABLE_BACKUP_ROUTES)
+		transportUpdateRoute(_msg.sender, last, transportHALGetReceivingRSSI());
+#else
+		transportSetRoute(_msg.sender, last);
+#endif
+	}
+	_transportSM.msgReceived = true;
+	STATS_INC(STATS_RX_CUT_THROUGH);
+#if defined(MY_TRANSPORT_AGGREGATION) && !defined(MY_GATEWAY_FEATURE)
+	if (transportAggregate(_msg)) {
+		return;
+	}
+#endif
+	(void)transportQueueRoute(_msg);
+}
+#endif
+
+void transportHandleMessage(const bool verified)
+{
+	if (!verified) {
+		setIndication(INDICATION_ERR_SIGN);
+		TRANSPORT_DEBUG(PSTR("!TSF:MSG:SIGN VERIFY FAIL\n"));
+		return;
+	}
+	STATS_UPLINK(STATS_LATENCY_UPLINK_VERIFY);
+	// get message length and limit size
+	const uint8_t msgLength = min(mGetLength(_msg), (uint8_t)MAX_PAYLOAD);
+	const uint8_t command = mGetCommand(_msg);
+	const uint8_t type = _msg.type;
+	const nodeId_t sender = _msg.sender;
+	const nodeId_t last = _msg.last;
+	const nodeId_t destination = _msg.destination;
+
+#if !defined(MY_GATEWAY_FEATURE) && defined(MY_TRANSPORT_UPLINK_CHECK_PASSIVE)
+	if (sender == GATEWAY_ADDRESS && last == _transportConfig.parentNodeId) {
+		// the GW is reachable through the parent
+		_transportSM.lastUplinkCheck = hwMillis();
+	}
+#endif
+
+	// update routing table if msg not from parent
+#if defined(MY_REPEATER_FEATURE)
+#if !defined(MY_GATEWAY_FEATURE)
+	if (last != _transportConfig.parentNodeId) {
+#else
+	// GW doesn't have parent
+	{
+#endif
+		// Message is from one of the child nodes and not sent from this node. Add it to routing table.
+		if (sender != _transportConfig.nodeId)
+		{
+#if defined(MY_ROUTING_TABLE_BACKUP_ROUTES)
+			transportUpdateRoute(sender, last, transportHALGetReceivingRSSI());
+#else
+			transportSetRoute(sender, last);
+#endif
+		}
+		if (command == C_INTERNAL && type == I_AGGREGATE) {
+			// the frames collected by a repeater took the same way
+			uint8_t position = 0;
+			while (transportUnpackAggregate(_msgTmp, _msg, position)) {
+				if (_msgTmp.sender != _transportConfig.nodeId) {
+#if defined(MY_ROUTING_TABLE_BACKUP_ROUTES)
+					transportUpdateRoute(_msgTmp.sender, last, transportHALGetReceivingRSSI());
+#else
+					transportSetRoute(_msgTmp.sender, last);
+#endif
+				}
+			}
+		}
+	}
+#endif // MY_REPEATER_FEATURE
+
+#if defined(MY_GATEWAY_FEATURE) && defined(MY_GATEWAY_ID_ALLOCATOR)
+	transportConfirmNodeId(sender);
+#endif
+
+	// set message received flag
+	_transportSM.msgReceived = true;
+
+	// Is message addressed to this node?
+	if (destination == _transportConfig.nodeId) {
+		// prevent buffer overflow by limiting max. possible message length (5 bits=31 bytes max) to MAX_PAYLOAD (25 bytes)
+		mSetLength(_msg, min(mGetLength(_msg), (uint8_t)MAX_PAYLOAD));
+		// null terminate data
+		_msg.data[msgLength] = 0u;
+		// Check if sender requests an echo.
+		if (mGetRequestEcho(_msg)) {
+			TRANSPORT_DEBUG(PSTR("TSF:MSG:ECHO REQ\n"));	// ECHO requested
+#if defined(MY_TRANSPORT_RECEIPTS)
+			// the sender turns the receipt back into the echo
+			const uint16_t hash = transportReceiptHash(_msg);
+			const uint8_t receipt[4] = {command, type, (uint8_t)(hash & 0xFFu), (uint8_t)(hash >> 8)};
+			TRANSPORT_DEBUG(PSTR("TSF:MSG:RECEIPT\n"));
+			(void)transportSendRoute(build(_msgTmp, sender, _msg.sensor, C_INTERNAL, I_RECEIPT).set(receipt,
+			                         sizeof(receipt)));
+#else
+			_msgTmp = _msg;	// Copy message
+			// Reply without echo flag (otherwise we would end up in an eternal loop)
+			mSetRequestEcho(_msgTmp, false);
+			mSetEcho(_msgTmp, true); // set ECHO flag
+			_msgTmp.sender = _transportConfig.nodeId;
+			_msgTmp.destination = sender;
+			// send ECHO, use transportSendRoute since ECHO reply is not internal, i.e. if !transportOK do not reply
+			(void)transportSendRoute(_msgTmp);
+#endif
+		}
+#if defined(MY_TRANSPORT_RECEIPTS)
+		if (command == C_INTERNAL && type == I_RECEIPT && !mGetEcho(_msg) && !transportReceiptToEcho(_msg)) {
+			TRANSPORT_DEBUG(PSTR("!TSF:MSG:RECEIPT UNKNOWN,ID=%" PRIuNodeId "\n"), sender);
+			return; // no further processing required
+		}
+#endif
+#if defined(MY_GATEWAY_FEATURE) && defined(MY_GATEWAY_MAILBOX)
+		// the sender is listening now, hand over what the controller sent while it slept
+		gatewayTransportMailboxWake(sender, command == C_INTERNAL && type == I_PRE_SLEEP_NOTIFICATION);
+#endif
+		if(!mGetEcho(_msg)) {
+			// only process if not ECHO
+			if (command == C_INTERNAL) {
+				// Process signing related internal messages
+				if (signerProcessInternal(_msg)) {
+					return; // Signer processing indicated no further action needed
+				}
+#if defined(MY_GATEWAY_FEATURE) && defined(MY_GATEWAY_ID_ALLOCATOR)
+				if (type == I_ID_REQUEST && transportAllocateNodeId(_msg)) {
+					return; // answered on the GW, the controller gets the response
+				}
+#endif
+#if defined(MY_REPEATER_FEATURE)
+				if (type == I_FIND_PARENT_REQUEST) {
+					// probe of a node that has this node cached as parent candidate, answered right away
+					if (isTransportReady() && sender != _transportConfig.parentNodeId) {
+						TRANSPORT_DEBUG(PSTR("TSF:MSG:FPAR REQ,ID=%" PRIuNodeId "\n"), sender);
+						if (transportCheckUplink()) {
+#if !defined(MY_TRANSPORT_UPLINK_CHECK_PASSIVE)
+							_transportSM.lastUplinkCheck = hwMillis();
+#endif
+							(void)transportRouteMessage(transportBuildParentResponse(sender));
+						}
+					}
+					return; // no further processing required
+				}
+#endif
+#if !defined(MY_GATEWAY_FEATURE)
+				if (type == I_ID_RESPONSE) {
+#if (MY_NODE_ID == AUTO)
+					// only active if node ID dynamic
+					if ((_msg.sensor == _transportToken) || (_msg.sensor == (uint8_t)AUTO)) {
+#if defined(MY_NODE_ID_16BIT)
+						(void)transportAssignNodeID(_msg.getUInt());
+#else
+						(void)transportAssignNodeID(_msg.getByte());
+#endif
+					} else {
+						TRANSPORT_DEBUG(PSTR("!TSF:MSG:ID TK INVALID\n"));
+					}
+#endif
+					return; // no further processing required
+				}
+				if (type == I_FIND_PARENT_RESPONSE) {
+#if !defined(MY_GATEWAY_FEATURE) && !defined(MY_PARENT_NODE_IS_STATIC)
+#if defined(MY_TRANSPORT_PARENT_LOAD)
+					// parents with older firmware send the distance only
+					const uint8_t load = (mGetLength(_msg) > 1u) ? (uint8_t)_msg.data[1] : 0u;
+#endif
+#if defined(TRANSPORT_PARENT_REVIEW)
+					if (_transportParentReviewActive && !_transportSM.findingParentNode) {
+						const uint8_t distance = _msg.getByte();
+						if (isValidDistance(distance) && isValidDistance(distance + 1u)) {
+							transportReviewParentResponse(sender, distance + 1u, transportParentCost(distance + 1u,
+							                              transportHALGetReceivingRSSI(), load));
+						}
+						return; // no further processing required
+					}
+#endif
+					if (_transportSM.findingParentNode) {	// only process if find parent active
+						// Reply to a I_FIND_PARENT_REQUEST message. Check if the distance is shorter than we already have.
+						uint8_t distance = _msg.getByte();
+						if (isValidDistance(distance)) {
+							distance++;	// Distance to gateway is one more for us w.r.t. parent
+#if defined(MY_TRANSPORT_PARENT_CACHE)
+							transportAddParentCandidate(sender, distance, transportHALGetReceivingRSSI());
+#endif
+#if defined(MY_TRANSPORT_PARENT_LOAD)
+							// cheaper by distance, link and load
+							const uint16_t cost = transportParentCost(distance, transportHALGetReceivingRSSI(), load);
+							const bool better = cost < _transportParentCost;
+#else
+							const bool better = distance < _transportConfig.distanceGW;
+#endif
+							// update settings if parent better or preferred parent found
+							if (((isValidDistance(distance) && better) || (!_autoFindParent &&
+							        sender == (nodeId_t)MY_PARENT_NODE_ID)) && !_transportSM.preferredParentFound) {
+								// Found a neighbor closer to GW than previously found
+								if (!_autoFindParent && sender == (nodeId_t)MY_PARENT_NODE_ID) {
+									_transportSM.preferredParentFound = true;
+									TRANSPORT_DEBUG(PSTR("TSF:MSG:FPAR PREF\n"));	// find parent, preferred parent found
 								}
 								_transportConfig.distanceGW = distance;
 								_transportConfig.parentNodeId = sender;
-								TRANSPORT_DEBUG(PSTR("TSF:MSG:FPAR OK,ID=%" PRIu8 ",D=%" PRIu8 "\n"), _transportConfig.parentNodeId,
+#if defined(MY_TRANSPORT_PARENT_LOAD)
+								_transportParentCost = cost;
+#endif
+								TRANSPORT_DEBUG(PSTR("TSF:MSG:FPAR OK,ID=%" PRIuNodeId ",D=%" PRIu8 "\n"), _transportConfig.parentNodeId,
 								                _transportConfig.distanceGW);
 							}
+#if defined(MY_TRANSPORT_PARENT_CACHE)
+							if (_transportParentProbe != AUTO) {
+								// a candidate answered the probe, no need to wait for others
+								_transportSM.preferredParentFound = true;
+							}
+#endif
 						}
 					} else {
 						TRANSPORT_DEBUG(PSTR("!TSF:MSG:FPAR INACTIVE\n"));	// find parent response received, but inactive
@@ -762,7 +2173,7 @@ void transportProcessMessage(void)
 #endif // !defined(MY_GATEWAY_FEATURE)
 				// general
 				if (type == I_PING) {
-					TRANSPORT_DEBUG(PSTR("TSF:MSG:PINGED,ID=%" PRIu8 ",HP=%" PRIu8 "\n"), sender,
+					TRANSPORT_DEBUG(PSTR("TSF:MSG:PINGED,ID=%" PRIuNodeId ",HP=%" PRIu8 "\n"), sender,
 					                _msg.getByte()); // node pinged
 #if defined(MY_GATEWAY_FEATURE) && (F_CPU>16000000)
 					// delay for fast GW and slow nodes
@@ -773,6 +2184,20 @@ void transportProcessMessage(void)
 					return; // no further processing required
 				}
 				if (type == I_PONG) {
+#if !defined(MY_GATEWAY_FEATURE) && defined(MY_TRANSPORT_UPLINK_CHECK_PASSIVE)
+					if (sender == GATEWAY_ADDRESS && _transportSM.uplinkPingActive && !_transportSM.pingActive) {
+						// answer to the ping of transportCheckUplink()
+						_transportSM.uplinkPingActive = false;
+						TRANSPORT_DEBUG(PSTR("TSF:CKU:OK\n"));
+						const uint8_t hopsCount = _msg.getByte();
+						if (hopsCount != _transportConfig.distanceGW) {
+							TRANSPORT_DEBUG(PSTR("TSF:CKU:DGWC,O=%" PRIu8 ",N=%" PRIu8 "\n"), _transportConfig.distanceGW,
+							                hopsCount);	// distance to GW changed
+							_transportConfig.distanceGW = hopsCount;
+						}
+						return; // no further processing required
+					}
+#endif
 					if (_transportSM.pingActive) {
 						_transportSM.pingActive = false;
 						_transportSM.pingResponse = _msg.getByte();
@@ -805,10 +2230,73 @@ void transportProcessMessage(void)
 					                                  I_SIGNAL_REPORT_RESPONSE).set(value));
 					return; // no further processing required
 				}
+#if defined(MY_TRANSPORT_FRAGMENTATION)
+				if (type == I_FRAGMENT) {
+					transportFragmentSlot_t *slot = transportReassemble(_msg);
+					if (slot != NULL) {
+						if (receiveFragmented) {
+							receiveFragmented(slot->sender, slot->sensor, slot->type, slot->data, slot->length);
+						}
+						slot->received = 0;
+					}
+					return; // no further processing required
+				}
+#endif
+#if defined(MY_GATEWAY_FEATURE)
+#if defined(MY_GATEWAY_TIME_BEACON)
+				if (type == I_TIME && gatewayTransportTimeReply(_msg)) {
+					return; // answered from the cache
+				}
+#endif
+#if defined(MY_GATEWAY_PRESENTATION_CACHE)
+				if (type == I_PRESENTATION_DIGEST) {
+					gatewayTransportCacheDigestReply(_msg);
+					return; // answered from the cache
+				}
+#endif
+				if (type == I_BATCH) {
+					// hand over the readings to the controller one by one
+					uint8_t position = 0;
+					while (protocolBatch2MyMessage(_msgTmp, _msg, position)) {
+#if defined(MY_GATEWAY_PRESENTATION_CACHE)
+						gatewayTransportCacheStore(_msgTmp);
+#endif
+						(void)gatewayTransportSend(_msgTmp);
+						if (receive) {
+							receive(_msgTmp);
+						}
+					}
+					return; // no further processing required
+				}
+				if (type == I_AGGREGATE) {
+					// frames relayed by a repeater, each one is verified and handed over on its own
+					uint8_t position = 0;
+					while (transportUnpackAggregate(_msgTmp, _msg, position)) {
+						if (!signerVerifyMsg(_msgTmp)) {
+							setIndication(INDICATION_ERR_SIGN);
+							TRANSPORT_DEBUG(PSTR("!TSF:AGG:SIGN VERIFY FAIL,ID=%" PRIuNodeId "\n"), _msgTmp.sender);
+							continue;
+						}
+#if defined(MY_GATEWAY_PRESENTATION_CACHE)
+						gatewayTransportCacheStore(_msgTmp);
+#endif
+						(void)gatewayTransportSend(_msgTmp);
+						if (receive) {
+							receive(_msgTmp);
+						}
+					}
+					return; // no further processing required
+				}
+#endif
 				if (_processInternalCoreMessage()) {
 					return; // no further processing required
 				}
 			} else if (command == C_STREAM) {
+#if defined(MY_GATEWAY_FIRMWARE_SERVER)
+				if (gatewayTransportFirmwareReply(_msg)) {
+					return; // answered from the firmware images
+				}
+#endif
 #if defined(MY_OTA_FIRMWARE_FEATURE)
 				if(firmwareOTAUpdateProcess()) {
 					return; // OTA FW update processing indicated no further action needed
@@ -826,6 +2314,9 @@ void transportProcessMessage(void)
 		}
 #endif //defined(MY_OTA_LOG_RECEIVER_FEATURE)
 #if defined(MY_GATEWAY_FEATURE)
+#if defined(MY_GATEWAY_PRESENTATION_CACHE)
+		gatewayTransportCacheStore(_msg);
+#endif
 		// Hand over message to controller
 		(void)gatewayTransportSend(_msg);
 #endif
@@ -835,22 +2326,41 @@ void transportProcessMessage(void)
 		}
 	} else if (destination == BROADCAST_ADDRESS) {
 		TRANSPORT_DEBUG(PSTR("TSF:MSG:BC\n"));	// broadcast msg
+#if defined(MY_TRANSPORT_BROADCAST_FLOODING)
+		// find parent and wake-on-radio broadcasts concern neighbours only, the others are flooded
+		if (command != C_INTERNAL || (type != I_FIND_PARENT_REQUEST && type != I_FIND_PARENT_RESPONSE &&
+		                              type != I_WAKE_ON_RADIO)) {
+#if defined(MY_REPEATER_FEATURE)
+			const bool relay = isTransportReady();
+#else
+			const bool relay = false;
+#endif
+			if (sender == _transportConfig.nodeId || transportBroadcastSeen(_msg, relay)) {
+				return;	// own broadcast or copy already processed
+			}
+		}
+		// the first copy is processed, whoever relayed it
+		const bool viaParent = true;
+#else
+		const bool viaParent = (last == _transportConfig.parentNodeId);
+#endif
+		(void)viaParent;	// not used by every configuration
 		if (command == C_INTERNAL) {
 			if (isTransportReady()) {
 				// only reply if node is fully operational
 				if (type == I_FIND_PARENT_REQUEST) {
 #if defined(MY_REPEATER_FEATURE)
 					if (sender != _transportConfig.parentNodeId) {	// no circular reference
-						TRANSPORT_DEBUG(PSTR("TSF:MSG:FPAR REQ,ID=%" PRIu8 "\n"), sender);	// FPAR: find parent request
+						TRANSPORT_DEBUG(PSTR("TSF:MSG:FPAR REQ,ID=%" PRIuNodeId "\n"), sender);	// FPAR: find parent request
 						// check if uplink functional - node can only be parent node if link to GW functional
 						// this also prevents circular references in case GW ooo
 						if (transportCheckUplink()) {
+#if !defined(MY_TRANSPORT_UPLINK_CHECK_PASSIVE)
 							_transportSM.lastUplinkCheck = hwMillis();
+#endif
 							TRANSPORT_DEBUG(PSTR("TSF:MSG:GWL OK\n")); // GW uplink ok
 							// random delay minimizes collisions
-							delay(hwMillis() & 0x3ff);
-							(void)transportRouteMessage(build(_msgTmp, sender, NODE_SENSOR_ID, C_INTERNAL,
-							                                  I_FIND_PARENT_RESPONSE).set(_transportConfig.distanceGW));
+							transportDeferReply(sender, I_FIND_PARENT_RESPONSE);
 						} else {
 							TRANSPORT_DEBUG(PSTR("!TSF:MSG:GWL FAIL\n")); // GW uplink fail, do not respond to parent request
 						}
@@ -862,25 +2372,39 @@ void transportProcessMessage(void)
 			if (type == I_FIND_PARENT_RESPONSE) {
 				return;	// no further processing required, do not forward
 			}
+			if (type == I_WAKE_ON_RADIO) {
+#if defined(MY_TRANSPORT_WAKE_ON_RADIO)
+				if (last == sender) {
+					transportSetWakeOnRadio(sender, _msg.getULong());
+				}
+#endif
+				return;	// concerns neighbours only, do not forward
+			}
 #if !defined(MY_GATEWAY_FEATURE)
 			if (type == I_DISCOVER_REQUEST) {
-				if (last == _transportConfig.parentNodeId) {
+				if (viaParent) {
 					// random wait to minimize collisions
-					delay(hwMillis() & 0x3ff);
-					(void)transportRouteMessage(build(_msgTmp, sender, NODE_SENSOR_ID, C_INTERNAL,
-					                                  I_DISCOVER_RESPONSE).set(_transportConfig.parentNodeId));
+					transportDeferReply(sender, I_DISCOVER_RESPONSE);
 					// no return here (for fwd if repeater)
 				}
 			}
+			if (type == I_TIME && sender == GATEWAY_ADDRESS && viaParent) {
+				// time beacon, see MY_GATEWAY_TIME_BEACON
+				TRANSPORT_DEBUG(PSTR("TSF:MSG:TIME BC\n"));
+				if (receiveTime) {
+					receiveTime(_msg.getULong());
+				}
+				// no return here (for fwd if repeater)
+			}
 #endif
 		}
 		// controlled BC relay
-#if defined(MY_REPEATER_FEATURE)
+#if defined(MY_REPEATER_FEATURE) && !defined(MY_TRANSPORT_BROADCAST_FLOODING)
 		// controlled BC repeating: forward only if message received from parent and sender not self to prevent circular fwds
-		if(last == _transportConfig.parentNodeId && sender != _transportConfig.nodeId &&
+		if(viaParent && sender != _transportConfig.nodeId &&
 		        isTransportReady()) {
 			TRANSPORT_DEBUG(PSTR("TSF:MSG:FWD BC MSG\n")); // controlled broadcast msg forwarding
-			(void)transportRouteMessage(_msg);
+			(void)transportQueueRoute(_msg);
 		}
 #endif
 
@@ -888,9 +2412,14 @@ void transportProcessMessage(void)
 		if (command != C_INTERNAL) {
 #if !defined(MY_GATEWAY_FEATURE)
 			// only proceed if message received from parent
-			if (last != _transportConfig.parentNodeId) {
+			if (!viaParent) {
 				return;
 			}
+#if defined(MY_OTA_FIRMWARE_FEATURE) && defined(MY_OTA_MULTICAST)
+			if (command == C_STREAM && firmwareOTAUpdateProcess()) {
+				return; // OTA FW update processing indicated no further action needed
+			}
+#endif
 #endif
 #if defined(MY_GATEWAY_FEATURE)
 			// Hand over message to controller
@@ -916,9 +2445,14 @@ void transportProcessMessage(void)
 					}
 				}
 			}
+#if defined(MY_TRANSPORT_AGGREGATION) && !defined(MY_GATEWAY_FEATURE)
+			if (transportAggregate(_msg)) {
+				return;
+			}
+#endif
 			// Relay this message to another node
 			TRANSPORT_DEBUG(PSTR("TSF:MSG:REL MSG\n"));	// relay msg
-			(void)transportRouteMessage(_msg);
+			(void)transportQueueRoute(_msg);
 		}
 #else
 		TRANSPORT_DEBUG(PSTR("!TSF:MSG:REL MSG,NREP\n"));	// message relaying request, but not a repeater
@@ -927,67 +2461,219 @@ void transportProcessMessage(void)
 	(void)last;	//avoid cppcheck warning
 }
 
+#if defined(MY_TRANSPORT_FAST_RECOVERY)
+void transportRecoveryBackoff(void)
+{
+	// the backoff stops growing once it exceeds the extended failure state
+	if ((uint32_t)MY_TRANSPORT_RECOVERY_BACKOFF_MS << _transportRecoveryAttempts <
+	        MY_TRANSPORT_TIMEOUT_EXT_FAILURE_STATE_MS) {
+		_transportRecoveryAttempts++;
+	}
+	TRANSPORT_DEBUG(PSTR("TSF:REC:BO=%" PRIu32 "\n"),
+	                (uint32_t)MY_TRANSPORT_RECOVERY_BACKOFF_MS << (_transportRecoveryAttempts - 1u));
+}
+
+bool transportRecoverRadio(void)
+{
+	// rewrite the radio registers in place, the state machine, the routing table, the queues and
+	// the signing state are kept
+	if (!transportHALInit()) {
+		return false;
+	}
+	transportHALSetAddress(_transportConfig.nodeId);
+	// cppcheck-suppress knownConditionTrueFalse
+	return transportHALSanityCheck();
+}
+#endif
+
 void transportInvokeSanityCheck(void)
 {
 	// Suppress this because the function may return a variable value in some configurations
 	// cppcheck-suppress knownConditionTrueFalse
 	if (!transportHALSanityCheck()) {
 		TRANSPORT_DEBUG(PSTR("!TSF:SAN:FAIL\n"));	// sanity check fail
+#if defined(MY_TRANSPORT_FAST_RECOVERY)
+		if (transportRecoverRadio()) {
+			TRANSPORT_DEBUG(PSTR("TSF:REC:OK\n"));	// radio re-initialized in place
+			return;
+		}
+		TRANSPORT_DEBUG(PSTR("!TSF:REC:FAIL\n"));
+		transportRecoveryBackoff();
+#endif
 		transportSwitchSM(stFailure);
 	} else {
 		TRANSPORT_DEBUG(PSTR("TSF:SAN:OK\n"));		// sanity check ok
 	}
 }
 
+void transportSanityCheckTask(void)
+{
+#if defined(MY_TRANSPORT_SANITY_CHECK)
+	schedulerSet(&_transportSanityTask, MY_TRANSPORT_SANITY_CHECK_INTERVAL_MS);
+	if (_transportSM.transportActive) {
+		transportInvokeSanityCheck();
+	}
+#endif
+}
+
 void transportProcessFIFO(void)
 {
+	PROFILING_SCOPE(PROFILING_TRANSPORT_PROCESS_FIFO);
 	if (!_transportSM.transportActive) {
 		// transport not active, no further processing required
 		return;
 	}
 
-#if defined(MY_TRANSPORT_SANITY_CHECK)
-	if (hwMillis() - _lastSanityCheck > MY_TRANSPORT_SANITY_CHECK_INTERVAL_MS) {
-		_lastSanityCheck = hwMillis();
-		transportInvokeSanityCheck();
+	// process msgs in FIFO until it is empty or the time budget is used up, this also ends
+	// the loop if a HW issue keeps reporting data
+	const uint32_t started = hwMicros();
+	bool pending;
+	do {
+		pending = transportHALDataAvailable();
+		if (pending) {
+#if defined(MY_SIGNING_PARALLEL_VERIFY)
+			transportProcessBatch();
+#else
+			transportProcessMessage();
+			STATS_UPLINK_END();
+#endif
+		}
+		pending |= transportProcessDeferredReplies();
+#if defined(MY_TRANSPORT_BROADCAST_FLOODING)
+		pending |= transportProcessBroadcasts();
+#endif
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+		// one queued message at a time, received messages are processed in between
+		pending |= transportProcessTxQueue();
+#endif
+#if defined(MY_SIGNING_ASYNC)
+		// messages signed since their nonce arrived
+		pending |= transportProcessSignedMsg();
+#endif
+	} while (pending && (uint32_t)(hwMicros() - started) < MY_TRANSPORT_PROCESS_BUDGET_US);
+#if defined(MY_TRANSPORT_AGGREGATION) && defined(MY_REPEATER_FEATURE) && !defined(MY_GATEWAY_FEATURE)
+	if (_transportAggregateCount &&
+	        hwMillis() - _transportAggregateStart >= MY_TRANSPORT_AGGREGATION_MS) {
+		transportFlushAggregate();
 	}
 #endif
+#if defined(MY_SIGNING_ASYNC)
+	// time out queued messages and request nonces for the next ones, also without RX traffic
+	(void)signerCheckTimer();
+#endif
+}
 
-	uint8_t _processedMessages = MAX_SUBSEQ_MSGS;
-	// process all msgs in FIFO or counter exit
-	while (transportHALDataAvailable() && _processedMessages--) {
-		transportProcessMessage();
+#if defined(MY_TRANSPORT_WAKE_ON_RADIO)
+void transportSetWakeOnRadio(const uint8_t node, const uint32_t cycleMS)
+{
+	TRANSPORT_DEBUG(PSTR("TSF:WOR:ID=%" PRIu8 ",MS=%" PRIu32 "\n"), node, cycleMS);
+	if (cycleMS) {
+		_transportWakeOnRadio[node >> 3] |= (uint8_t)(1u << (node & 0x07u));
+		_transportWakeOnRadioCycleMS = max(_transportWakeOnRadioCycleMS, cycleMS);
+	} else {
+		_transportWakeOnRadio[node >> 3] &= (uint8_t)~(1u << (node & 0x07u));
 	}
-#if defined(MY_OTA_FIRMWARE_FEATURE)
-	if (isTransportReady()) {
-		// only process if transport ok
-		firmwareOTAUpdateRequest();
+}
+
+static bool transportSendTrain(const nodeId_t to, MyMessage &message, const uint8_t length)
+{
+	// the receiver listens once per cycle, repeat the frame until it is awake
+	const uint32_t startMS = hwMillis();
+	uint16_t count = 0;
+	bool result = false;
+#if defined(TRANSPORT_HAL_WAKE_UP_PREAMBLE)
+	// a receiver in listen mode detects the preamble in its next RX window
+	transportHALSetWakeUpPreamble(_transportWakeOnRadioCycleMS);
+#endif
+	while (!result && hwMillis() - startMS < _transportWakeOnRadioCycleMS) {
+		doYield();
+		result = transportHALSend(to, &message, length, false);
+		transportUpdateAirtime();
+		count++;
 	}
+#if defined(TRANSPORT_HAL_WAKE_UP_PREAMBLE)
+	transportHALSetWakeUpPreamble(0);
 #endif
+	TRANSPORT_DEBUG(PSTR("%sTSF:WOR:TRAIN,TO=%" PRIu8 ",N=%" PRIu16 ",ST=%s\n"), result ? "" : "!", to,
+	                count, result ? "OK" : "NACK");
+	return result;
 }
+#endif
 
-bool transportSendWrite(const uint8_t to, MyMessage &message)
+#if defined(MY_TRANSPORT_SEQUENCE)
+// append the sequence number to own frames, returns the length of the frame to send
+static uint8_t transportSequenceTrailer(MyMessage &message, const uint8_t frameLength)
 {
-	message.last = _transportConfig.nodeId; // Update last
-	// sign message if required
-	if (!signerSignMsg(message)) {
-		TRANSPORT_DEBUG(PSTR("!TSF:MSG:SIGN FAIL\n"));
-		setIndication(INDICATION_ERR_SIGN);
-		return false;
+	if (frameLength >= MAX_MESSAGE_LENGTH) {
+		// no room, full frames carry no sequence number
+		return frameLength;
+	}
+	if (message.sender == _transportConfig.nodeId) {
+		uint8_t sequence = _transportSequence;
+		if (message.destination == GATEWAY_ADDRESS) {
+			// counted per frame sent to the GW, resends included, 0 marks a restart
+			_transportSequence = _transportSequence == 255u ? 1u : _transportSequence + 1u;
+		} else {
+			// ignored by other receivers
+			sequence = 0;
+		}
+		((uint8_t *)&message.last)[frameLength] = sequence;
 	}
+	// relayed frames keep the sequence number of their sender
+	return frameLength + 1u;
+}
+#endif
 
-	// msg length changes if signed
-	const uint8_t totalMsgLength = HEADER_SIZE + ( mGetSigned(message) ? MAX_PAYLOAD : mGetLength(
-	                                   message) );
+static bool transportSendFrame(const nodeId_t to, MyMessage &message)
+{
+	// msg length changes if signed, by the length of the signature
+	const uint8_t totalMsgLength = HEADER_SIZE + mGetLength(message) + (mGetSigned(
+	                                   message) ? signerGetSignatureLength(message) : 0);
+#if defined(MY_TRANSPORT_SEQUENCE)
+	// the trailer takes the byte behind the message, the string terminator of unsigned messages
+	const uint8_t messageLength = min((uint8_t)MAX_MESSAGE_LENGTH, totalMsgLength);
+	const uint8_t terminator = ((uint8_t *)&message.last)[messageLength];
+	const uint8_t frameLength = transportSequenceTrailer(message, messageLength);
+#else
+	const uint8_t frameLength = min((uint8_t)MAX_MESSAGE_LENGTH, totalMsgLength);
+#endif
 
 	// send
 	setIndication(INDICATION_TX);
-	bool result = transportHALSend(to, &message, min((uint8_t)MAX_MESSAGE_LENGTH, totalMsgLength),
-	                               _transportConfig.passiveMode);
+#if defined(MY_ENERGY_ACCOUNTING)
+	const uint32_t sendStartUS = hwMicros();
+#endif
+	bool result = transportHALSend(to, &message, frameLength, _transportConfig.passiveMode);
+	transportUpdateAirtime();
+#if defined(MY_TRANSPORT_WAKE_ON_RADIO)
+	if (!result && to != BROADCAST_ADDRESS && !_transportConfig.passiveMode &&
+	        (_transportWakeOnRadio[to >> 3] & (1u << (to & 0x07u)))) {
+		result = transportSendTrain(to, message, frameLength);
+	}
+#endif
+#if defined(MY_TRANSPORT_SEQUENCE)
+	if (message.sender == _transportConfig.nodeId) {
+		((uint8_t *)&message.last)[messageLength] = terminator;
+	}
+#endif
 	// broadcasting (workaround counterfeits)
 	result |= (to == BROADCAST_ADDRESS);
+	ENERGY_SEND(sendStartUS, result);
+	STATS_INC(STATS_TX_FRAMES);
+	if (!result) {
+		STATS_INC(STATS_TX_NACK);
+	}
+	// first frame of a message from the controller
+	STATS_DOWNLINK(STATS_LATENCY_DOWNLINK_SEND);
+	STATS_DOWNLINK_END();
+#if defined(MY_DEBUG_VERBOSE_TRANSPORT)
+	if (_transportWakeUpPending) {
+		_transportWakeUpPending = false;
+		TRANSPORT_DEBUG(PSTR("TSF:TRI:WTX=%" PRIu32 "\n"), (uint32_t)(hwMicros() - _transportWakeUpMicros));
+	}
+#endif
 
-	TRANSPORT_DEBUG(PSTR("%sTSF:MSG:SEND,%" PRIu8 "-%" PRIu8 "-%" PRIu8 "-%" PRIu8 ",s=%" PRIu8 ",c=%"
+	TRANSPORT_DEBUG(PSTR("%sTSF:MSG:SEND,%" PRIuNodeId "-%" PRIuNodeId "-%" PRIuNodeId "-%" PRIuNodeId ",s=%" PRIu8 ",c=%"
 	                     PRIu8 ",t=%" PRIu8 ",pt=%" PRIu8 ",l=%" PRIu8 ",sg=%" PRIu8 ",ft=%" PRIu8 ",st=%s:%s\n"),
 	                (_transportConfig.passiveMode ? "?" : result ? "" : "!"), message.sender, message.last, to,
 	                message.destination,
@@ -1002,16 +2688,77 @@ bool transportSendWrite(const uint8_t to, MyMessage &message)
 	return result;
 }
 
+bool transportSendWrite(const nodeId_t to, MyMessage &message)
+{
+	PROFILING_SCOPE(PROFILING_TRANSPORT_SEND_WRITE);
+	message.last = _transportConfig.nodeId; // Update last
+#if defined(MY_SIGNING_ASYNC)
+	// message waiting for a nonce is written by transportProcessSignedMsg() once signed
+	if (signerQueueMsg(to, message)) {
+		return true;
+	}
+#endif
+	// sign message if required
+	if (!signerSignMsg(message)) {
+		TRANSPORT_DEBUG(PSTR("!TSF:MSG:SIGN FAIL\n"));
+		setIndication(INDICATION_ERR_SIGN);
+		return false;
+	}
+	return transportSendFrame(to, message);
+}
+
+#if defined(TRANSPORT_HAL_ACK_PAYLOAD)
+bool transportArmAckPayload(MyMessage &message)
+{
+	const nodeId_t to = message.destination;
+	// the ACK goes to the hop the frame came from
+	if (to == BROADCAST_ADDRESS || transportGetRoute(to) != to) {
+		return false;
+	}
+	message.last = _transportConfig.nodeId;
+	const uint8_t totalMsgLength = HEADER_SIZE + mGetLength(message);
+#if defined(MY_TRANSPORT_SEQUENCE)
+	const uint8_t messageLength = min((uint8_t)MAX_MESSAGE_LENGTH, totalMsgLength);
+	const uint8_t terminator = ((uint8_t *)&message.last)[messageLength];
+	const bool result = transportHALSetAckPayload(to, &message, transportSequenceTrailer(message,
+	                    messageLength));
+	((uint8_t *)&message.last)[messageLength] = terminator;
+	return result;
+#else
+	return transportHALSetAckPayload(to, &message, min((uint8_t)MAX_MESSAGE_LENGTH, totalMsgLength));
+#endif
+}
+
+bool transportDisarmAckPayload(const nodeId_t node)
+{
+	return transportHALWithdrawAckPayload(node);
+}
+#endif
+
+#if defined(MY_SIGNING_ASYNC)
+bool transportProcessSignedMsg(void)
+{
+	uint8_t to;
+	MyMessage *message = signerGetSignedMsg(&to);
+	if (message == NULL) {
+		return false;
+	}
+	// sent straight from the signing queue
+	(void)transportSendFrame(to, *message);
+	return true;
+}
+#endif
+
 void transportRegisterReadyCallback(transportCallback_t cb)
 {
 	_transportReady_cb = cb;
 }
 
-uint8_t transportGetNodeId(void)
+nodeId_t transportGetNodeId(void)
 {
 	return _transportConfig.nodeId;
 }
-uint8_t transportGetParentNodeId(void)
+nodeId_t transportGetParentNodeId(void)
 {
 	return _transportConfig.parentNodeId;
 }
@@ -1021,11 +2768,90 @@ uint8_t transportGetDistanceGW(void)
 }
 
 
+#if defined(MY_NODE_ID_16BIT)
+// routing table entry of a slot
+static transportRoute_t transportReadRouteSlot(const uint16_t slot)
+{
+#if defined(MY_RAM_ROUTING_TABLE_ENABLED)
+	return _transportRoutingTable.route[slot];
+#else
+	transportRoute_t entry;
+	hwReadConfigBlock((void *)&entry, (void *)(EEPROM_ROUTES_ADDRESS + slot * sizeof(transportRoute_t)),
+	                  sizeof(transportRoute_t));
+	return entry;
+#endif
+}
+
+// slot of the node, probed linearly from its hash. With insert, a free or cleared slot if the node
+// is not in the table. TRANSPORT_ROUTE_SLOTS if there is none.
+static uint16_t transportFindRouteSlot(const nodeId_t node, const bool insert)
+{
+	if (node == BROADCAST_ADDRESS) {
+		return TRANSPORT_ROUTE_SLOTS;
+	}
+	uint16_t slot = (uint16_t)(node * 40503u) % TRANSPORT_ROUTE_SLOTS;
+	uint16_t freeSlot = TRANSPORT_ROUTE_SLOTS;
+	for (uint16_t probe = 0; probe < TRANSPORT_ROUTE_SLOTS; probe++) {
+		const transportRoute_t entry = transportReadRouteSlot(slot);
+		if (entry.node == node) {
+			return slot;
+		}
+		if (entry.route == BROADCAST_ADDRESS && freeSlot == TRANSPORT_ROUTE_SLOTS) {
+			freeSlot = slot;
+		}
+		if (entry.node == BROADCAST_ADDRESS) {
+			// never used, slots are only freed by clearing the table
+			break;
+		}
+		slot = (slot + 1u) % TRANSPORT_ROUTE_SLOTS;
+	}
+	return insert ? freeSlot : TRANSPORT_ROUTE_SLOTS;
+}
+#define transportRouteSlot(__node, __insert) transportFindRouteSlot(__node, __insert)	//!< slot of the node
+#else
+#define transportRouteSlot(__node, __insert) ((uint16_t)(__node))	//!< one slot per node id
+#endif
+
+static void transportWriteRouteSlot(const uint16_t slot, const nodeId_t node, const nodeId_t route)
+{
+#if defined(MY_NODE_ID_16BIT)
+	transportRoute_t entry = { node, route };
+#else
+	(void)node;
+	transportRoute_t entry = route;
+#endif
+#if defined(MY_RAM_ROUTING_TABLE_ENABLED)
+	if (memcmp((const void *)&_transportRoutingTable.route[slot], (const void *)&entry, sizeof(entry))) {
+#if defined(MY_NODE_ID_16BIT) && defined(MY_ROUTING_TABLE_BACKUP_ROUTES)
+		if (_transportRoutingTable.route[slot].node != node) {
+			// slot taken over by another node
+			_transportRoutingTable.backup[slot] = AUTO;
+			_transportRoutingTable.rssi[slot] = INT8_MIN;
+			_transportRoutingTable.backupRssi[slot] = INT8_MIN;
+		}
+#endif
+		_transportRoutingTable.route[slot] = entry;
+		_transportRoutingTable.dirty[slot >> 3] |= (1u << (slot & 7));
+	}
+#elif defined(MY_NODE_ID_16BIT)
+	hwWriteConfigBlock((void *)&entry, (void *)(EEPROM_ROUTES_ADDRESS + slot * sizeof(transportRoute_t)),
+	                   sizeof(transportRoute_t));
+#else
+	hwWriteConfig(EEPROM_ROUTES_ADDRESS + slot, entry);
+#endif
+}
+
 void transportClearRoutingTable(void)
 {
-	for (uint16_t i = 0; i < SIZE_ROUTES; i++) {
-		transportSetRoute((uint8_t)i, BROADCAST_ADDRESS);
+	for (uint16_t i = 0; i < TRANSPORT_ROUTE_SLOTS; i++) {
+		transportWriteRouteSlot(i, BROADCAST_ADDRESS, BROADCAST_ADDRESS);
+#if defined(MY_ROUTING_TABLE_BACKUP_ROUTES)
+		_transportRoutingTable.backup[i] = AUTO;
+#endif
 	}
+#if defined(MY_GATEWAY_STANDBY)
+	gatewayTransportStandbyRoutesCleared();
+#endif
 	transportSaveRoutingTable();	// save cleared routing table to EEPROM (if feature enabled)
 	TRANSPORT_DEBUG(PSTR("TSF:CRT:OK\n"));	// clear routing table
 }
@@ -1034,6 +2860,13 @@ void transportLoadRoutingTable(void)
 {
 #if defined(MY_RAM_ROUTING_TABLE_ENABLED)
 	hwReadConfigBlock((void*)&_transportRoutingTable.route, (void*)EEPROM_ROUTES_ADDRESS, SIZE_ROUTES);
+	(void)memset(_transportRoutingTable.dirty, 0, sizeof(_transportRoutingTable.dirty));
+#if defined(MY_ROUTING_TABLE_BACKUP_ROUTES)
+	(void)memset(_transportRoutingTable.backup, AUTO, sizeof(_transportRoutingTable.backup));
+	(void)memset(_transportRoutingTable.rssi, INT8_MIN, sizeof(_transportRoutingTable.rssi));
+	(void)memset(_transportRoutingTable.backupRssi, INT8_MIN, sizeof(_transportRoutingTable.backupRssi));
+	(void)memset(_transportRoutingTable.lastSeen, 0, sizeof(_transportRoutingTable.lastSeen));
+#endif
 	TRANSPORT_DEBUG(PSTR("TSF:LRT:OK\n"));	//  load routing table
 #endif
 }
@@ -1041,44 +2874,152 @@ void transportLoadRoutingTable(void)
 void transportSaveRoutingTable(void)
 {
 #if defined(MY_RAM_ROUTING_TABLE_ENABLED)
-	hwWriteConfigBlock((void*)&_transportRoutingTable.route, (void*)EEPROM_ROUTES_ADDRESS, SIZE_ROUTES);
+	// range of changed routes, one block write keeps flash based EEPROM emulations at one commit
+	uint16_t first = TRANSPORT_ROUTE_SLOTS;
+	uint16_t last = 0;
+	for (uint16_t i = 0; i < TRANSPORT_ROUTE_SLOTS; i++) {
+		if (_transportRoutingTable.dirty[i >> 3] & (1u << (i & 7))) {
+			if (first == TRANSPORT_ROUTE_SLOTS) {
+				first = i;
+			}
+			last = i;
+		}
+	}
+	if (first == TRANSPORT_ROUTE_SLOTS) {
+		return;
+	}
+	hwWriteConfigBlock((void*)&_transportRoutingTable.route[first],
+	                   (void*)(EEPROM_ROUTES_ADDRESS + (uintptr_t)first * sizeof(transportRoute_t)),
+	                   (last - first + 1) * sizeof(transportRoute_t));
+	(void)memset(_transportRoutingTable.dirty, 0, sizeof(_transportRoutingTable.dirty));
 	TRANSPORT_DEBUG(PSTR("TSF:SRT:OK\n"));	//  save routing table
 #endif
 }
 
-void transportSetRoute(const uint8_t node, const uint8_t route)
+void transportSetRoute(const nodeId_t node, const nodeId_t route)
 {
-#if defined(MY_RAM_ROUTING_TABLE_ENABLED)
-	_transportRoutingTable.route[node] = route;
-#else
-	hwWriteConfig(EEPROM_ROUTES_ADDRESS + node, route);
+	const uint16_t slot = transportRouteSlot(node, route != BROADCAST_ADDRESS);
+	if (slot < TRANSPORT_ROUTE_SLOTS) {
+		transportWriteRouteSlot(slot, node, route);
+#if defined(MY_GATEWAY_STANDBY)
+		gatewayTransportStandbyRoute(node, route);
 #endif
+	} else if (route != BROADCAST_ADDRESS) {
+		TRANSPORT_DEBUG(PSTR("!TSF:RTE:FULL,N=%" PRIuNodeId "\n"), node);	// no free slot
+	}
 }
 
-uint8_t transportGetRoute(const uint8_t node)
+#if defined(MY_ROUTING_TABLE_BACKUP_ROUTES)
+void transportUpdateRoute(const nodeId_t node, const nodeId_t route, const int16_t rssi)
 {
-	uint8_t result;
-#if defined(MY_RAM_ROUTING_TABLE_ENABLED)
-	result = _transportRoutingTable.route[node];
+	const uint16_t slot = transportRouteSlot(node, true);
+	if (slot >= TRANSPORT_ROUTE_SLOTS) {
+		return;
+	}
+	const uint16_t now = (uint16_t)(hwMillis() >> 10);
+	const int8_t rssiRoute = (rssi == INVALID_RSSI) ? INT8_MIN : (int8_t)constrain(rssi, -127, 127);
+	const nodeId_t current = transportGetRoute(node);
+	if (route == current || current == AUTO) {
+		if (route != current) {
+			transportSetRoute(node, route);
+			_transportRoutingTable.rssi[slot] = rssiRoute;
+		} else if (rssiRoute != INT8_MIN && _transportRoutingTable.rssi[slot] != INT8_MIN) {
+			_transportRoutingTable.rssi[slot] = (int8_t)((3 * _transportRoutingTable.rssi[slot] + rssiRoute) /
+			                                    4);
+		} else {
+			_transportRoutingTable.rssi[slot] = rssiRoute;
+		}
+		_transportRoutingTable.lastSeen[slot] = now;
+		return;
+	}
+	// received via another node
+	if (route == _transportRoutingTable.backup[slot] && rssiRoute != INT8_MIN &&
+	        _transportRoutingTable.backupRssi[slot] != INT8_MIN) {
+		_transportRoutingTable.backupRssi[slot] = (int8_t)((3 * _transportRoutingTable.backupRssi[slot] +
+		        rssiRoute) / 4);
+	} else {
+		_transportRoutingTable.backup[slot] = route;
+		_transportRoutingTable.backupRssi[slot] = rssiRoute;
+	}
+	// switch if clearly stronger, the route went silent, or there are no metrics
+	if (_transportRoutingTable.backupRssi[slot] == INT8_MIN || _transportRoutingTable.rssi[slot] == INT8_MIN ||
+	        _transportRoutingTable.backupRssi[slot] > _transportRoutingTable.rssi[slot] +
+	        MY_ROUTING_TABLE_HYSTERESIS_RSSI ||
+	        (uint16_t)(now - _transportRoutingTable.lastSeen[slot]) > (MY_ROUTING_TABLE_ROUTE_TIMEOUT_MS >> 10)) {
+		(void)transportFailoverRoute(node);
+		_transportRoutingTable.lastSeen[slot] = now;
+	}
+}
+
+nodeId_t transportFailoverRoute(const nodeId_t node)
+{
+	const uint16_t slot = transportRouteSlot(node, false);
+	if (slot >= TRANSPORT_ROUTE_SLOTS) {
+		return AUTO;
+	}
+	const nodeId_t route = transportGetRoute(node);
+	const nodeId_t backup = _transportRoutingTable.backup[slot];
+	if (backup == AUTO || backup == route) {
+		return AUTO;
+	}
+	const int8_t backupRssi = _transportRoutingTable.backupRssi[slot];
+	_transportRoutingTable.backup[slot] = route;
+	_transportRoutingTable.backupRssi[slot] = _transportRoutingTable.rssi[slot];
+	transportSetRoute(node, backup);
+	_transportRoutingTable.rssi[slot] = backupRssi;
+	TRANSPORT_DEBUG(PSTR("TSF:RTE:N=%" PRIuNodeId ",R=%" PRIuNodeId ",B=%" PRIuNodeId "\n"), node, backup,
+	                _transportRoutingTable.backup[slot]);
+	return backup;
+}
+#endif
+
+nodeId_t transportGetRoute(const nodeId_t node)
+{
+	const uint16_t slot = transportRouteSlot(node, false);
+	if (slot >= TRANSPORT_ROUTE_SLOTS) {
+		return BROADCAST_ADDRESS;
+	}
+#if defined(MY_NODE_ID_16BIT)
+	return transportReadRouteSlot(slot).route;
+#elif defined(MY_RAM_ROUTING_TABLE_ENABLED)
+	return _transportRoutingTable.route[slot];
 #else
-	result = hwReadConfig(EEPROM_ROUTES_ADDRESS + node);
+	return hwReadConfig(EEPROM_ROUTES_ADDRESS + slot);
 #endif
-	return result;
 }
 
-void transportReportRoutingTable(void)
+void transportVisitRoutes(transportRouteVisitor_t visit)
 {
-#if defined(MY_REPEATER_FEATURE)
-	for (uint16_t cnt = 0; cnt < SIZE_ROUTES; cnt++) {
-		const uint8_t route = transportGetRoute(cnt);
+	for (uint16_t slot = 0; slot < TRANSPORT_ROUTE_SLOTS; slot++) {
+#if defined(MY_NODE_ID_16BIT)
+		const transportRoute_t entry = transportReadRouteSlot(slot);
+		const nodeId_t node = entry.node;
+		const nodeId_t route = entry.route;
+#else
+		const nodeId_t node = (nodeId_t)slot;
+		const nodeId_t route = transportGetRoute(node);
+#endif
 		if (route != BROADCAST_ADDRESS) {
-			TRANSPORT_DEBUG(PSTR("TSF:RRT:ROUTE N=%" PRIu8 ",R=%" PRIu8 "\n"), cnt, route);
-			uint8_t outBuf[2] = { (uint8_t)cnt,route };
-			(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_DEBUG).set(outBuf,
-			                 2));
-			wait(200);
+			visit(node, route);
 		}
 	}
+}
+
+#if defined(MY_REPEATER_FEATURE)
+static void transportReportRoute(const nodeId_t node, const nodeId_t route)
+{
+	TRANSPORT_DEBUG(PSTR("TSF:RRT:ROUTE N=%" PRIuNodeId ",R=%" PRIuNodeId "\n"), node, route);
+	const nodeId_t outBuf[2] = { node, route };
+	(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_DEBUG).set(outBuf,
+	                 sizeof(outBuf)));
+	wait(200);
+}
+#endif
+
+void transportReportRoutingTable(void)
+{
+#if defined(MY_REPEATER_FEATURE)
+	transportVisitRoutes(transportReportRoute);
 #endif
 }
 
@@ -47,8 +47,15 @@
 *   - TSF:<b>SRT</b>		from @ref transportSaveRoutingTable(), saves RAM routing table to EEPROM (only GW/repeaters)
 *   - TSF:<b>MSG</b>		from @ref transportProcessMessage(), processes incoming message
 *   - TSF:<b>SAN</b>		from @ref transportInvokeSanityCheck(), calls transport-specific sanity check
+*   - TSF:<b>REC</b>		from @ref transportRecoverRadio() and @ref transportRecoveryBackoff(), radio fault recovery
 *   - TSF:<b>RTE</b>		from @ref transportRouteMessage(), sends message
 *   - TSF:<b>SND</b>		from @ref transportSendRoute(), sends message if transport is ready (exposed)
+*   - TSF:<b>TXQ</b>		from @ref transportQueueRoute() and @ref transportProcessTxQueue(), queued sending
+*   - TSF:<b>RPL</b>		from @ref transportDeferReply(), replies to broadcast requests
+*   - TSF:<b>BCF</b>		from @ref transportBroadcastSeen() and @ref transportProcessBroadcasts(), broadcast flooding
+*   - TSF:<b>FRG</b>		from @ref transportReassemble(), reassembles data blocks sent with sendFragmented()
+*   - TSF:<b>AGG</b>		from @ref transportAggregate() and @ref transportFlushAggregate(), relayed frames sent together
+*   - TSF:<b>IDA</b>		from @ref transportAllocateNodeId(), assigns node IDs on the GW
 *   - TSF:<b>TDI</b>		from @ref transportDisable()
 *   - TSF:<b>TRI</b>		from @ref transportReInitialise()
 *   - TSF:<b>SIR</b>		from @ref transportSignalReport()
@@ -66,6 +73,8 @@
 * | | TSM | FPAR  |														| <b>Transition to stParent state</b>
 * | | TSM | FPAR  | STATP=%%d									| Static parent set, skip finding parent
 * | | TSM | FPAR  | OK												| Parent node identified
+* | | TSM | FPAR  | PROBE,ID=%%d								| Find parent request sent to cached parent candidate (ID)
+* |!| TSM | FPAR  | PROBE FAIL,ID=%%d						| Cached parent candidate (ID) did not answer, candidate removed
 * |!| TSM | FPAR  | NO REPLY									| No potential parents replied to find parent request
 * |!| TSM | FPAR  | FAIL											| Finding parent failed
 * | | TSM | ID    |														| <b>Transition to stID state</b>
@@ -76,6 +85,8 @@
 * | | TSM | UPL   | OK												| Uplink OK, GW returned ping
 * | | TSF | UPL   | DGWC,O=%%d,N=%%d					| Uplink check revealed changed network topology, old distance (O), new distance (N)
 * |!| TSM | UPL   | FAIL											| Uplink check failed, i.e. GW could not be pinged
+* | | TSM | READY | PAR REVIEW								| Find parent request broadcast to review the parent, see @ref MY_TRANSPORT_PARENT_LOAD
+* | | TSM | READY | PAR MOVE,O=%%d,N=%%d				| Parent changed from (O) to the less loaded (N), uplink checked next
 * | | TSM | READY | SRT												| Save routing table
 * | | TSM | READY | ID=%%d,PAR=%%d,DIS=%%d		| <b>Transition to stReady</b> Transport ready, node ID (ID), parent node ID (PAR), distance to GW (DIS)
 * |!| TSM | READY | UPL FAIL,SNP							| Too many failed uplink transmissions, search new parent
@@ -85,6 +96,8 @@
 * | | TSM | FAIL  | RE-INIT										| Attempt to re-initialize transport
 * | | TSF | CKU   | OK												| Uplink OK
 * | | TSF | CKU   | OK,FCTRL									| Uplink OK, flood control prevents pinging GW in too short intervals
+* | | TSF | CKU   | PING											| Nothing heard from the GW recently, ping GW without waiting, see @ref MY_TRANSPORT_UPLINK_CHECK_PASSIVE
+* |!| TSF | CKU   | PONG TMO									| GW did not answer the ping of @ref MY_TRANSPORT_UPLINK_CHECK_PASSIVE in time
 * | | TSF | CKU   | DGWC,O=%%d,N=%%d					| Uplink check revealed changed network topology, old distance (O), new distance (N)
 * | | TSF | CKU   | FAIL											| No reply received when checking uplink
 * | | TSF | SID   | OK,ID=%%d									| Node ID assigned
@@ -92,10 +105,13 @@
 * | | TSF | PNG   | SEND,TO=%%d								| Send ping to destination (TO)
 * | | TSF | WUR   | MS=%%lu										| Wait until transport ready, timeout (MS)
 * | | TSF | MSG   | ECHO REQ										| ECHO message requested
+* | | TSF | MSG   | RECEIPT										| Receipt sent instead of the ECHO message, see @ref MY_TRANSPORT_RECEIPTS
+* |!| TSF | MSG   | RECEIPT UNKNOWN,ID=%%d			| Receipt from node (ID) matches no message sent with echo request
 * | | TSF | MSG   | ECHO												| ECHO message, do not proceed but forward to callback
 * | | TSF | MSG   | FPAR RES,ID=%%d,D=%%d			| Response to find parent received from node (ID) with distance (D) to GW
 * | | TSF | MSG   | FPAR PREF FOUND						| Preferred parent found, i.e. parent defined via MY_PARENT_NODE_ID
 * | | TSF | MSG   | FPAR OK,ID=%%d,D=%%d			| Find parent response from node (ID) is valid, distance (D) to GW
+* | | TSF | MSG   | FPAR REVIEW,ID=%%d,C=%%d			| Find parent response from node (ID) during the parent review, cost (C)
 * | | TSF | MSG   | FPAR INACTIVE							| Find parent response received, but no find parent request active, skip response
 * | | TSF | MSG   | FPAR REQ,ID=%%d						| Find parent request from node (ID)
 * | | TSF | MSG   | PINGED,ID=%%d,HP=%%d			| Node pinged by node (ID) with (HP) hops
@@ -103,16 +119,21 @@
 * | | TSF | MSG   | BC												| Broadcast message received
 * | | TSF | MSG   | GWL OK										| Link to GW ok
 * | | TSF | MSG   | FWD BC MSG								| Controlled broadcast message forwarding
+* | | TSF | MSG   | TIME BC										| Time beacon of the GW received, handed over to receiveTime()
 * | | TSF | MSG   | RCV CB										| Hand over message to @ref receive() callback function
 * | | TSF | MSG   | REL MSG										| Relay message
 * | | TSF | MSG   | REL PxNG,HP=%%d						| Relay PING/PONG message, increment hop counter (HP)
 * |!| TSF | MSG   | SIGN VERIFY FAIL					| Signing verification failed
+* |!| TSF | MSG   | DUP,N=%%d								| Duplicate message dropped, dropped messages so far (N)
 * |!| TSF | MSG   | REL MSG,NORP							| Node received a message for relaying, but node is not a repeater, message skipped
 * |!| TSF | MSG   | SIGN FAIL									| Signing message failed
 * |!| TSF | MSG   | GWL FAIL									| GW uplink failed
 * |!| TSF | MSG   | ID TK INVALID							| Token for ID request invalid
 * | | TSF | SAN   | OK												| Sanity check passed
 * |!| TSF | SAN   | FAIL											| Sanity check failed, attempt to re-initialize radio
+* | | TSF | REC   | OK												| Radio re-initialized in place, see @ref MY_TRANSPORT_FAST_RECOVERY
+* |!| TSF | REC   | FAIL											| Radio could not be re-initialized in place, transition to stFailure
+* | | TSF | REC   | BO=%%d										| Radio fault, re-initialize after (BO) ms in stFailure
 * | | TSF | CRT   | OK												| Clearing routing table successful
 * | | TSF | LRT   | OK												| Loading routing table successful
 * | | TSF | SRT   | OK												| Saving routing table successful
@@ -120,12 +141,42 @@
 * |!| TSF | RTE   | DST %%d UNKNOWN						| Routing for destination (DST) unknown, send message to parent
 * | | TSF | RTE   | N2N OK										| Node-to-node communication succeeded
 * |!| TSF | RTE   | N2N FAIL									| Node-to-node communication failed, handing over to parent for re-routing
+* | | TSF | RTE   | N2N PAR										| Destination not reached directly lately, sent to parent, see @ref MY_TRANSPORT_DIRECT_CACHE
+* |!| TSF | RTE   | PACE,G=%%d								| Uplink transmission failed, gap between messages to the GW doubled to (G) ms
+* |!| TSF | RTE   | DC=%%d										| Duty cycle budget used to (DC) percent, message not sent
+* |!| TSF | RTE   | %%d FAIL,BKP=%%d							| Sending to destination failed, retry via backup route (BKP)
+* | | TSF | RTE   | N=%%d,R=%%d,B=%%d							| Route to node (N) changed to (R), previous route kept as backup (B)
 * | | TSF | RRT   | ROUTE N=%%d,R=%%d					| Routing table, messages to node (N) are routed via node (R)
 * |!| TSF | SND   | TNR												| Transport not ready, message cannot be sent
+* | | TSF | SND   | PACED,G=%%d								| Uplink congested, message queued, gap between messages to the GW (G) in ms
+* |!| TSF | SND   | PACED FULL								| Uplink congested and queue full, message not sent
+* | | TSF | TXQ   | QUEUED,P=%%d,N=%%d						| Message queued for sending with priority (P), N messages pending
+* |!| TSF | TXQ   | FULL											| Queue full, message sent right away
+* |!| TSF | TXQ   | RETRY,A=%%d								| Sending queued message failed, retried after the other ones (attempt A)
+* |!| TSF | TXQ   | DROP											| Sending queued message failed, no retries left
+* | | TSF | RPL   | DEFER,ID=%%d,T=%%d,D=%%d					| Reply of type (T) to node (ID) scheduled in (D) ms
+* |!| TSF | RPL   | FULL											| All scheduled replies pending, request not answered
+* | | TSF | BCF   | DEFER,ID=%%d,D=%%d						| Relay of a broadcast from node (ID) scheduled in (D) ms
+* | | TSF | BCF   | SEEN,ID=%%d,N=%%d							| Copy of a broadcast from node (ID) dropped, N copies received
+* | | TSF | BCF   | SUPP,ID=%%d,N=%%d							| Relay of a broadcast from node (ID) suppressed, N copies received
+* |!| TSF | BCF   | FULL											| All cached broadcasts wait for their relay, broadcast relayed right away
+* | | TSF | FRG   | OK,ID=%%d,L=%%d							| Data block of length (L) from node (ID) reassembled
+* |!| TSF | FRG   | LEN,ID=%%d								| Fragment from node (ID) does not fit MY_TRANSPORT_FRAGMENT_MAX_LENGTH, dropped
+* |!| TSF | FRG   | DROP,ID=%%d								| Incomplete block from node (ID) timed out or replaced by a newer one
+* | | TSF | WOR   | ID=%%d,MS=%%lu							| Node (ID) listens once per cycle of (MS) ms, 0 = always
+* | | TSF | WOR   | TRAIN,TO=%%d,N=%%d,ST=%%s					| Frame repeated (N) more times to a duty-cycled node (TO), status (ST)
+* | | TSF | AGG   | ADD,ID=%%d,N=%%d							| Frame of node (ID) collected for the GW, N frames collected
+* | | TSF | AGG   | SEND,N=%%d,L=%%d							| N collected frames sent in one message of length (L)
+* |!| TSF | AGG   | SIGN VERIFY FAIL,ID=%%d					| GW: signature of a collected frame from node (ID) not valid, frame dropped
+* | | TSF | IDA   | LEASE,T=%%d,N=%%d							| ID (N) leased to the node requesting with token (T), again if the request is repeated
+* | | TSF | IDA   | USED,N=%%d									| Node (N) sent with its leased ID, the lease ends
+* | | TSF | IDA   | EXPIRED,N=%%d								| ID (N) was not used within @ref MY_GATEWAY_ID_ALLOCATOR_LEASE_MS and is free again
+* |!| TSF | IDA   | FULL											| No free ID left, request forwarded to the controller
 * | | TSF | TDI   | TSL												| Set transport to sleep
 * | | TSF | TDI   | TPD												| Power down transport
 * | | TSF | TRI   | TRI												| Reinitialise transport
 * | | TSF | TRI   | TSB												| Set transport to standby
+* | | TSF | TRI   | WTX=%%d										| First frame after the wake-up sent, [%%d] us after the wake-up
 * | | TSF | SIR   | CMD=%d,VAL=%d							| Get signal report
 *
 *
@@ -230,12 +281,16 @@
 #define MY_TRANSPORT_STATE_RETRIES				(3u)			//!< retries before switching to FAILURE
 #endif
 
+#if defined(MY_NODE_ID_16BIT)
+#define AUTO									(0xFFFFu)		//!< ID 0xFFFF is reserved
+#define BROADCAST_ADDRESS			(0xFFFFu)		//!< broadcasts are addressed to ID 0xFFFF
+#else
 #define AUTO									(255u)			//!< ID 255 is reserved
 #define BROADCAST_ADDRESS			(255u)			//!< broadcasts are addressed to ID 255
+#endif
 #define DISTANCE_INVALID			(255u)			//!< invalid distance when searching for parent
 #define MAX_HOPS							(254u)			//!< maximal number of hops for ping/pong
 #define INVALID_HOPS					(255u)			//!< invalid hops
-#define MAX_SUBSEQ_MSGS				(5u)				//!< Maximum number of subsequently processed messages in FIFO (to prevent transport deadlock if HW issue)
 #define UPLINK_QUALITY_WEIGHT	(0.05f)			//!< UPLINK_QUALITY_WEIGHT
 
 
@@ -253,14 +308,40 @@
  */
 typedef void(*transportCallback_t)(void);
 
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+/**
+ * @brief Callback type for queued messages, see transportRegisterTxCallback()
+ * @param message Message as it was sent
+ * @param success true if the message was delivered
+ */
+typedef void(*transportTxCallback_t)(const MyMessage &message, const bool success);
+
+/**
+* @brief Entry of the TX queue
+*/
+typedef struct {
+	MyMessage message;		//!< message to route
+	uint8_t attempts;		//!< failed attempts so far
+} transportTxQueueEntry_t;
+
+/**
+* @brief Priority classes of the TX queue, see @ref MY_TRANSPORT_TX_QUEUE_PRIORITY
+*/
+typedef enum {
+	TRANSPORT_TX_PRIORITY_CONTROL = 0,	//!< Commands from the controller (C_SET, C_REQ)
+	TRANSPORT_TX_PRIORITY_DATA = 1,		//!< Sensor data and internal messages
+	TRANSPORT_TX_PRIORITY_BULK = 2		//!< Presentation and stream (OTA) messages
+} transportTxPriority_t;
+#endif
+
 /**
  * @brief Node configuration
  *
  * This structure stores node-related configurations
  */
 typedef struct {
-	uint8_t nodeId;								//!< Current node id
-	uint8_t parentNodeId;					//!< Where this node sends its messages
+	nodeId_t nodeId;							//!< Current node id
+	nodeId_t parentNodeId;					//!< Where this node sends its messages
 	uint8_t distanceGW;						//!< This nodes distance to sensor net gateway (number of hops)
 	uint8_t passiveMode : 1;			//!< Passive mode
 	uint8_t reserved : 7;					//!< Reserved
@@ -275,6 +356,101 @@ typedef struct {
 	void(*Transition)(void);					//!< state transition function
 	void(*Update)(void);							//!< state update function
 } transportState_t;
+/**
+* @brief Reply to a broadcast request, sent after a random delay
+*/
+typedef struct {
+	uint32_t due;			//!< hwMillis() when the reply is sent
+	nodeId_t destination;	//!< requesting node
+	uint8_t type;			//!< I_FIND_PARENT_RESPONSE or I_DISCOVER_RESPONSE, 0 if the entry is free
+} transportDeferredReply_t;
+
+#if defined(MY_TRANSPORT_PARENT_CACHE) || defined(DOXYGEN)
+#define TRANSPORT_PARENT_CANDIDATES	(SIZE_PARENT_CANDIDATES / sizeof(transportParentCandidate_t))	//!< parent candidates kept
+/**
+* @brief Parent candidate, see @ref MY_TRANSPORT_PARENT_CACHE
+*/
+typedef struct {
+	nodeId_t nodeId;	//!< candidate, AUTO if the entry is free
+	uint8_t distance;	//!< distance to the GW via the candidate
+	int8_t RSSI;		//!< RSSI of the candidate's find parent response, INT8_MIN if unknown
+} __attribute__((packed)) transportParentCandidate_t;
+#endif
+
+#if defined(MY_TRANSPORT_PARENT_LOAD) && !defined(MY_GATEWAY_FEATURE) && !defined(MY_PARENT_NODE_IS_STATIC) && !defined(MY_PASSIVE_NODE)
+#define TRANSPORT_PARENT_REVIEW	//!< the node reviews its parent regularly, see @ref MY_TRANSPORT_PARENT_LOAD
+#endif
+#define TRANSPORT_PARENT_LOAD_WINDOW_MS	(60*1000ul)	//!< window of the time on air share advertised as load
+#define TRANSPORT_PARENT_LOAD_AIRTIME	(100u)		//!< time on air in permille counted as fully loaded without duty cycle budget
+#define TRANSPORT_PARENT_LOAD_RSSI_GOOD	(-70)		//!< RSSI without link cost, each dB below costs 4 up to another hop
+
+#if defined(MY_TRANSPORT_FRAGMENTATION) || defined(DOXYGEN)
+/**
+* @brief Data block being reassembled from I_FRAGMENT messages, see @ref MY_TRANSPORT_FRAGMENTATION
+*/
+typedef struct {
+	uint32_t received;		//!< bit mask of the fragments received, 0 if the slot is free
+	uint32_t started;		//!< hwMillis() when the first fragment arrived
+	uint16_t length;		//!< length of the block, known once the last fragment arrived
+	nodeId_t sender;		//!< sender of the block
+	uint8_t id;				//!< message id of the block
+	uint8_t sensor;			//!< child sensor id
+	uint8_t type;			//!< type of the data
+	uint8_t last;			//!< index of the last fragment, FRAGMENT_MAX_COUNT until it arrived
+	uint8_t data[MY_TRANSPORT_FRAGMENT_MAX_LENGTH];	//!< the data
+} transportFragmentSlot_t;
+#endif
+
+#if defined(MY_TRANSPORT_DIRECT_CACHE) || defined(DOXYGEN)
+/**
+* @brief Way to a node-to-node destination, see @ref MY_TRANSPORT_DIRECT_CACHE
+*/
+typedef struct {
+	uint32_t updated;	//!< hwMillis() of the last direct attempt, 0 if the entry is free
+	nodeId_t nodeId;	//!< destination
+	bool direct;		//!< the destination received the message directly
+} transportDirect_t;
+#endif
+
+#if defined(MY_TRANSPORT_DUPLICATE_FILTER) || defined(DOXYGEN)
+/**
+* @brief Entry of the duplicate message cache
+*/
+typedef struct {
+	uint32_t received;	//!< hwMillis() when received
+	uint16_t key;		//!< hash of the message without the last hop, or its sequence number
+	nodeId_t sender;	//!< sender of the message
+	bool sequenced;		//!< key is the sequence number, see @ref MY_TRANSPORT_SEQUENCE
+} transportDuplicate_t;
+#endif
+
+#if (defined(MY_GATEWAY_FEATURE) && defined(MY_GATEWAY_ID_ALLOCATOR)) || defined(DOXYGEN)
+/**
+* @brief ID answered to an I_ID_REQUEST and not used by the node yet
+*/
+typedef struct {
+	uint32_t leasedAt;	//!< hwMillis() of the last response, 0 if the entry is unused
+	nodeId_t nodeId;	//!< leased ID
+	nodeId_t via;		//!< last hop of the request
+	uint8_t token;		//!< token of the request
+} transportIdLease_t;
+#endif
+
+#if defined(MY_TRANSPORT_BROADCAST_FLOODING) || defined(DOXYGEN)
+/**
+* @brief Entry of the broadcast cache, see @ref MY_TRANSPORT_BROADCAST_FLOODING
+*/
+typedef struct {
+	uint32_t received;	//!< hwMillis() when the first copy was received, 0 if the entry is free
+	uint32_t due;		//!< hwMillis() when the broadcast is relayed
+	uint16_t hash;		//!< hash of the message without the last hop
+	nodeId_t sender;	//!< sender of the broadcast
+	uint8_t heard;		//!< copies received
+	bool pending;		//!< relay scheduled
+	MyMessage message;	//!< broadcast to relay
+} transportBroadcast_t;
+#endif
+
 /**
 * @brief Datatype for internal RSSI storage
 */
@@ -308,13 +484,39 @@ typedef struct {
 	bool msgReceived : 1;										//!< flag message received
 	uint8_t pingResponse;										//!< stores I_PONG hops
 	transportRSSI_t uplinkQualityRSSI;			//!< Uplink quality, internal RSSI representation
+#if defined(MY_TRANSPORT_UPLINK_CHECK_PASSIVE)
+	uint32_t uplinkPingSent;								//!< I_PING of transportCheckUplink() sent
+	bool uplinkPingActive;									//!< I_PING of transportCheckUplink() awaits the I_PONG
+#endif
 } transportSM_t;
 
+#if defined(MY_NODE_ID_16BIT) || defined(DOXYGEN)
+#define TRANSPORT_ROUTE_SLOTS	(MY_ROUTING_TABLE_SIZE)	//!< entries of the routing table
+/**
+* @brief Routing table entry with @ref MY_NODE_ID_16BIT, stored at the slot the node id hashes to
+* or the next free one. Both BROADCAST_ADDRESS: free, route BROADCAST_ADDRESS: cleared.
+*/
+typedef struct {
+	nodeId_t node;		//!< node
+	nodeId_t route;		//!< route for node
+} transportRoute_t;
+#else
+#define TRANSPORT_ROUTE_SLOTS	(SIZE_ROUTES)	//!< entries of the routing table, one per node id
+typedef uint8_t transportRoute_t;	//!< route for the node id of the entry
+#endif
+
 /**
 * @brief RAM routing table
 */
 typedef struct {
-	uint8_t route[SIZE_ROUTES];	//!< route for node
+	transportRoute_t route[TRANSPORT_ROUTE_SLOTS];	//!< route for node
+	uint8_t dirty[(TRANSPORT_ROUTE_SLOTS + 7) / 8];	//!< bit set: route changed since last save
+#if defined(MY_ROUTING_TABLE_BACKUP_ROUTES)
+	nodeId_t backup[TRANSPORT_ROUTE_SLOTS];	//!< backup route for node, not saved
+	int8_t rssi[TRANSPORT_ROUTE_SLOTS];	//!< averaged RSSI of messages received via route, INT8_MIN: unknown
+	int8_t backupRssi[TRANSPORT_ROUTE_SLOTS];	//!< averaged RSSI of messages received via backup route
+	uint16_t lastSeen[TRANSPORT_ROUTE_SLOTS];	//!< hwMillis() / 1024 of the last message received via route
+#endif
 } routingTable_t;
 
 // PRIVATE functions
@@ -385,6 +587,21 @@ uint32_t transportTimeInState(void);
 * @brief Call transport driver sanity check
 */
 void transportInvokeSanityCheck(void);
+#if defined(MY_TRANSPORT_FAST_RECOVERY) || defined(DOXYGEN)
+/**
+* @brief Re-initialize the radio without leaving the current state, see @ref MY_TRANSPORT_FAST_RECOVERY
+* @return true if the radio passes the sanity check afterwards
+*/
+bool transportRecoverRadio(void);
+/**
+* @brief Double the dwell of the failure state for the next radio fault, see @ref MY_TRANSPORT_RECOVERY_BACKOFF_MS
+*/
+void transportRecoveryBackoff(void);
+#endif
+/**
+* @brief Periodic sanity check, scheduled every @ref MY_TRANSPORT_SANITY_CHECK_INTERVAL_MS
+*/
+void transportSanityCheckTask(void);
 /**
 * @brief Process all pending messages in RX FIFO
 */
@@ -394,11 +611,192 @@ void transportProcessFIFO(void);
 */
 void transportProcessMessage(void);
 /**
+* @brief Read the next message from the RX FIFO into _msg
+* @return false if there was none, it was dropped as a duplicate or relayed by @ref transportCutThrough()
+*/
+bool transportReceiveMessage(void);
+#if defined(MY_TRANSPORT_CUT_THROUGH) || defined(DOXYGEN)
+/**
+* @brief Check if a received message is relayed without further processing, see @ref MY_TRANSPORT_CUT_THROUGH
+* @param message received message, only the header is looked at
+* @return true if it is neither addressed to this node nor a broadcast, and not internal
+*/
+bool transportIsCutThrough(const MyMessage &message);
+/**
+* @brief Update the routing table with _msg and hand it over to the TX queue
+*/
+void transportCutThrough(void);
+#endif
+/**
+* @brief Process the message in _msg
+* @param verified Result of @ref signerVerifyMsg() for the message, it is dropped if false
+*/
+void transportHandleMessage(const bool verified);
+#if defined(MY_SIGNING_PARALLEL_VERIFY) || defined(DOXYGEN)
+/**
+* @brief Receive up to @ref MY_LINUX_SIGNING_VERIFY_BATCH messages, verify their signatures in
+* parallel and process them in the order received
+*/
+void transportProcessBatch(void);
+#endif
+#if defined(MY_TRANSPORT_PARENT_CACHE) || defined(DOXYGEN)
+/**
+* @brief Load the parent candidates from EEPROM, invalid entries are cleared
+*/
+void transportLoadParentCandidates(void);
+/**
+* @brief Save the parent candidates to EEPROM if they changed
+*/
+void transportSaveParentCandidates(void);
+/**
+* @brief Rank a node that answered the find parent request among the parent candidates
+* @param nodeId node
+* @param distance distance to the GW via the node
+* @param rssi RSSI of the response
+*/
+void transportAddParentCandidate(const nodeId_t nodeId, const uint8_t distance, const int16_t rssi);
+/**
+* @brief Send the find parent request to the next parent candidate acknowledging it
+* @return true if a candidate was probed, false if none is left
+*/
+bool transportProbeParent(void);
+#endif
+#if defined(MY_TRANSPORT_PARENT_LOAD) || defined(DOXYGEN)
+/**
+* @brief Load advertised in the find parent response, see @ref MY_TRANSPORT_PARENT_LOAD
+* @return larger of the TX queue fill and the share of time on air, 255 is fully loaded
+*/
+uint8_t transportGetLoad(void);
+/**
+* @brief Cost of a parent candidate, a hop counts 100
+* @param distance distance to the GW via the candidate
+* @param rssi RSSI of its find parent response, INVALID_RSSI if not available
+* @param load advertised load of the candidate
+* @return cost, the lowest is the best parent
+*/
+uint16_t transportParentCost(const uint8_t distance, const int16_t rssi, const uint8_t load);
+#endif
+#if defined(TRANSPORT_PARENT_REVIEW) || defined(DOXYGEN)
+/**
+* @brief Start the parent review when it is due, move to a cheaper parent when it ends
+*/
+void transportReviewParent(void);
+/**
+* @brief Rank a find parent response received during the parent review
+* @param nodeId node that answered
+* @param distance distance to the GW via the node
+* @param cost cost of the node as parent
+*/
+void transportReviewParentResponse(const nodeId_t nodeId, const uint8_t distance,
+                                   const uint16_t cost);
+#endif
+#if (defined(MY_GATEWAY_FEATURE) && defined(MY_GATEWAY_ID_ALLOCATOR)) || defined(DOXYGEN)
+/**
+* @brief Answer an I_ID_REQUEST with a free ID, see @ref MY_GATEWAY_ID_ALLOCATOR
+* @param request received I_ID_REQUEST
+* @return false if no ID is free, the request is forwarded to the controller then
+*/
+bool transportAllocateNodeId(const MyMessage &request);
+/**
+* @brief End the lease of an ID once the node sends with it, see @ref MY_GATEWAY_ID_ALLOCATOR
+* @param nodeId sender of a received message
+*/
+void transportConfirmNodeId(const nodeId_t nodeId);
+#endif
+/**
+* @brief Schedule a reply to a broadcast request after a random delay, see @ref MY_TRANSPORT_REPLY_JITTER_MS
+* @param destination requesting node
+* @param type I_FIND_PARENT_RESPONSE or I_DISCOVER_RESPONSE, the payload is set when it is sent
+*/
+void transportDeferReply(const nodeId_t destination, const uint8_t type);
+/**
+* @brief Build the find parent response in _msgTmp
+* @param destination requesting node
+* @return _msgTmp with the distance to the GW, followed by @ref transportGetLoad() with @ref MY_TRANSPORT_PARENT_LOAD
+*/
+MyMessage &transportBuildParentResponse(const nodeId_t destination);
+/**
+* @brief Send the scheduled replies that are due
+* @return true if a reply was sent
+*/
+bool transportProcessDeferredReplies(void);
+#if defined(MY_TRANSPORT_DUPLICATE_FILTER) || defined(MY_TRANSPORT_BROADCAST_FLOODING) || defined(DOXYGEN)
+/**
+* @brief Hash of a message without the last hop
+* @param message message to hash
+* @param length payload length
+* @return hash of the header and the payload
+*/
+uint16_t transportMessageHash(const MyMessage &message, const uint8_t length);
+#endif
+#if defined(MY_TRANSPORT_BROADCAST_FLOODING) || defined(DOXYGEN)
+/**
+* @brief Look up a received broadcast in the broadcast cache, see @ref MY_TRANSPORT_BROADCAST_FLOODING
+* @param message received broadcast
+* @param relay schedule the relay of a new broadcast
+* @return true if it is a copy of a cached broadcast, which is counted
+*/
+bool transportBroadcastSeen(MyMessage &message, const bool relay);
+/**
+* @brief Relay the cached broadcasts that are due, unless enough copies were heard
+* @return true if a broadcast was relayed
+*/
+bool transportProcessBroadcasts(void);
+#endif
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+/**
+* @brief Send the oldest queued message, a failed one is queued again behind the others
+* @return true if a message was processed
+*/
+bool transportProcessTxQueue(void);
+/**
+* @brief Priority class of a message for the TX queue
+* @param message
+* @return priority class, TRANSPORT_TX_PRIORITY_DATA without @ref MY_TRANSPORT_TX_QUEUE_PRIORITY
+*/
+transportTxPriority_t transportTxPriority(const MyMessage &message);
+#endif
+/**
+* @brief Unpack the frame at position of an I_AGGREGATE message, last and destination are taken from the aggregate
+* @param message receives the frame
+* @param aggregate I_AGGREGATE message
+* @param position offset of the frame, start with 0, advanced to the next frame
+* @return false when all frames are unpacked or the aggregate is malformed
+*/
+bool transportUnpackAggregate(MyMessage &message, const MyMessage &aggregate, uint8_t &position);
+#if (defined(MY_TRANSPORT_AGGREGATION) && defined(MY_REPEATER_FEATURE) && !defined(MY_GATEWAY_FEATURE)) || defined(DOXYGEN)
+/**
+* @brief Collect a relayed C_SET frame for the GW in an I_AGGREGATE message, see @ref MY_TRANSPORT_AGGREGATION
+* @param message frame to relay
+* @return false if the frame cannot be aggregated and has to be relayed as is
+*/
+bool transportAggregate(const MyMessage &message);
+/**
+* @brief Send the collected frames, a single frame is relayed unchanged
+*/
+void transportFlushAggregate(void);
+#endif
+#if defined(MY_TRANSPORT_FRAGMENTATION) || defined(DOXYGEN)
+/**
+* @brief Store an I_FRAGMENT message in the reassembly pool, see @ref MY_TRANSPORT_FRAGMENTATION
+* @param fragment received I_FRAGMENT message
+* @return the slot of the completed block, to be freed by the caller, or NULL
+*/
+transportFragmentSlot_t *transportReassemble(const MyMessage &fragment);
+#endif
+#if defined(MY_SIGNING_ASYNC)
+/**
+* @brief Send the oldest message that has been signed once its nonce arrived, see @ref MY_SIGNING_ASYNC
+* @return true if a message was sent
+*/
+bool transportProcessSignedMsg(void);
+#endif
+/**
 * @brief Assign node ID
 * @param newNodeId New node ID
 * @return true if node ID is valid and successfully assigned
 */
-bool transportAssignNodeID(const uint8_t newNodeId);
+bool transportAssignNodeID(const nodeId_t newNodeId);
 /**
 * @brief Wait and process messages for a defined amount of time until specified message received
 * @param waitingMS Time to wait and process incoming messages in ms
@@ -412,7 +810,7 @@ bool transportWait(const uint32_t waitingMS, const uint8_t cmd, const uint8_t ms
 * @param targetId Node to be pinged
 * @return hops from pinged node or 255 if no answer received within 2000ms
 */
-uint8_t transportPingNode(const uint8_t targetId);
+uint8_t transportPingNode(const nodeId_t targetId);
 /**
 * @brief Send and route message according to destination
 *
@@ -429,15 +827,41 @@ bool transportRouteMessage(MyMessage &message);
 */
 bool transportSendRoute(MyMessage &message);
 /**
+* @brief Queue message for routing with transport state check, see @ref MY_TRANSPORT_TX_QUEUE_FEATURE
+*
+* Without the feature, or with a full queue, the message is sent right away.
+* @param message
+* @return true if message queued or sent successfully, false if sending error or transport !OK
+*/
+bool transportQueueRoute(MyMessage &message);
+/**
 * @brief Send message to recipient
 * @param to Recipient of message
 * @param message
 * @return true if message sent successfully
 */
-bool transportSendWrite(const uint8_t to, MyMessage &message);
+bool transportSendWrite(const nodeId_t to, MyMessage &message);
+#if defined(TRANSPORT_HAL_ACK_PAYLOAD)
+/**
+* @brief Send message in the ACK of the next frame from its destination, see @ref MY_NRF5_ESB_ACK_PAYLOAD
+* @param message Unsigned message for a direct child
+* @return true if the payload is pending
+*/
+bool transportArmAckPayload(MyMessage &message);
+/**
+* @brief Drop the ACK payload pending for node
+* @param node
+* @return true if it was still pending, false if there was none or it has been sent
+*/
+bool transportDisarmAckPayload(const nodeId_t node);
+#endif
 /**
 * @brief Check uplink to GW, includes flooding control
-* @param force to override flood control timer
+*
+* With @ref MY_TRANSPORT_UPLINK_CHECK_PASSIVE, messages from the GW within
+* @ref MY_TRANSPORT_CHKUPL_INTERVAL_MS count as a working uplink. Without them, the GW is pinged
+* without waiting and the check fails until its PONG is in.
+* @param force to override flood control timer and wait for the PONG
 * @return true if uplink ok
 */
 bool transportCheckUplink(const bool force = false);
@@ -491,6 +915,82 @@ void transportClearRoutingTable(void);
 * @return MS in current state
 */
 uint32_t transportGetHeartbeat(void);
+#if defined(MY_TRANSPORT_DIRECT_CACHE) || defined(DOXYGEN)
+/**
+* @brief Way to a destination remembered from the last direct attempt
+* @param destination node-to-node destination
+* @return entry, NULL if unknown or aged
+*/
+transportDirect_t *transportGetDirect(const nodeId_t destination);
+/**
+* @brief Remember the outcome of a direct attempt
+* @param destination node-to-node destination
+* @param direct true if the destination received the message directly
+*/
+void transportSetDirect(const nodeId_t destination, const bool direct);
+#endif
+#if defined(MY_TRANSPORT_DUPLICATE_FILTER) || defined(DOXYGEN)
+/**
+* @brief Number of duplicate messages dropped, see @ref MY_TRANSPORT_DUPLICATE_FILTER
+* @return dropped messages since start, wraps at 65535
+*/
+uint16_t transportGetDuplicateCount(void);
+/**
+* @brief Check received message against recently received ones and remember it
+*
+* Handshake messages (ID, find parent, nonce, ping, registration, receipt...) are never
+* duplicates. With @ref MY_TRANSPORT_SEQUENCE, frames sent to the GW are compared by sequence
+* number, the other ones by their hash.
+* @param message received message
+* @param length payload length of the message
+* @return true if the message is a duplicate
+*/
+bool transportIsDuplicate(const MyMessage &message, const uint8_t length);
+#endif
+#if defined(MY_TRANSPORT_RECEIPTS) || defined(DOXYGEN)
+/**
+* @brief Hash of the payload confirmed by a receipt, see @ref MY_TRANSPORT_RECEIPTS
+* @param message
+* @return hash
+*/
+uint16_t transportReceiptHash(const MyMessage &message);
+/**
+* @brief Remember a message sent with an echo request to turn its receipt into the echo
+* @param message message sent by this node
+*/
+void transportReceiptExpect(const MyMessage &message);
+/**
+* @brief Turn a received I_RECEIPT into the echo of the message it confirms
+* @param receipt received I_RECEIPT, replaced by the echo
+* @return false if no message waits for the receipt
+*/
+bool transportReceiptToEcho(MyMessage &receipt);
+#endif
+/**
+* @brief Account the time on air of the frames sent since the last call
+*/
+void transportUpdateAirtime(void);
+#if defined(MY_TRANSPORT_WAKE_ON_RADIO) || defined(DOXYGEN)
+/**
+* @brief Set the listen cycle of a neighbour, see @ref MY_TRANSPORT_WAKE_ON_RADIO
+* @param node neighbour announcing the cycle
+* @param cycleMS sleeping and listening time of one cycle, 0 if the neighbour always listens
+*/
+void transportSetWakeOnRadio(const uint8_t node, const uint32_t cycleMS);
+#endif
+#if defined(MY_TRANSPORT_DUTY_CYCLE_FEATURE) || defined(DOXYGEN)
+/**
+* @brief Used duty cycle budget, see @ref MY_TRANSPORT_DUTY_CYCLE_FEATURE
+* @return time on air in the window in percent of the budget, capped at 255
+*/
+uint8_t transportGetDutyCycle(void);
+/**
+* @brief Check if a message may be sent with the used duty cycle budget
+* @param message message to send
+* @return true if the message may be sent
+*/
+bool transportDutyCycleAllows(const MyMessage &message);
+#endif
 /**
 * @brief Load routing table from EEPROM to RAM.
 * Only for GW devices with enough RAM, i.e. ESP8266, RPI Sensebender GW, etc.
@@ -498,7 +998,10 @@ uint32_t transportGetHeartbeat(void);
 */
 void transportLoadRoutingTable(void);
 /**
-* @brief Save routing table to EEPROM.
+* @brief Save changed routes of the RAM routing table to EEPROM.
+*
+* Routes are written as one block from the first to the last changed entry, nothing is written
+* if no route changed.
 */
 void transportSaveRoutingTable(void);
 /**
@@ -506,13 +1009,39 @@ void transportSaveRoutingTable(void);
 * @param node
 * @param route
 */
-void transportSetRoute(const uint8_t node, const uint8_t route);
+void transportSetRoute(const nodeId_t node, const nodeId_t route);
 /**
 * @brief Load route to node
 * @param node
 * @return route to node
 */
-uint8_t transportGetRoute(const uint8_t node);
+nodeId_t transportGetRoute(const nodeId_t node);
+#if defined(MY_ROUTING_TABLE_BACKUP_ROUTES) || defined(DOXYGEN)
+/**
+* @brief Update the route of a node from a received message, with metrics and a backup route
+* @param node sender of the message
+* @param route node the message was received from
+* @param rssi RSSI of the message, INVALID_RSSI if not available
+*/
+void transportUpdateRoute(const nodeId_t node, const nodeId_t route, const int16_t rssi);
+/**
+* @brief Replace the route to a node by its backup route
+* @param node
+* @return new route to node, AUTO if there is no backup route
+*/
+nodeId_t transportFailoverRoute(const nodeId_t node);
+#endif
+/**
+* @brief Callback for each route of the routing table
+* @param node
+* @param route
+*/
+typedef void(*transportRouteVisitor_t)(const nodeId_t node, const nodeId_t route);
+/**
+* @brief Call visit for every node with a route
+* @param visit
+*/
+void transportVisitRoutes(transportRouteVisitor_t visit);
 /**
 * @brief Reports content of routing table
 */
@@ -521,17 +1050,35 @@ void transportReportRoutingTable(void);
 * @brief Get node ID
 * @return node ID
 */
-uint8_t transportGetNodeId(void);
+nodeId_t transportGetNodeId(void);
 /**
 * @brief Get parent node ID
 * @return parent node ID
 */
-uint8_t transportGetParentNodeId(void);
+nodeId_t transportGetParentNodeId(void);
 /**
 * @brief Get distance to GW
 * @return distance (=hops) to GW
 */
 uint8_t transportGetDistanceGW(void);
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+/**
+* @brief Register a callback for the completion of queued messages
+* @param cb Called once per queued message, after it was delivered or dropped
+*/
+void transportRegisterTxCallback(transportTxCallback_t cb);
+/**
+* @brief Number of queued messages not sent yet
+* @return pending messages
+*/
+uint8_t transportTxQueuePending(void);
+/**
+* @brief Number of messages the queue of a priority class can still take
+* @param priority class, all messages share one queue without @ref MY_TRANSPORT_TX_QUEUE_PRIORITY
+* @return free entries
+*/
+uint8_t transportTxQueueFree(const transportTxPriority_t priority);
+#endif
 /**
 * @brief Toggle passive mode, i.e. transport does not wait for ACK
 * @param OnOff
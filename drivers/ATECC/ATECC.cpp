@@ -0,0 +1,186 @@
+#include "Arduino.h"
+#include "ATECC.h"
+
+/* Local data and function prototypes */
+
+static uint8_t device_address;
+static void atecc_calculate_crc(uint8_t length, const uint8_t *data, uint8_t *crc);
+static uint8_t atecc_check_crc(const uint8_t *response);
+static bool atecc_send(uint8_t word_address, const uint8_t *buffer, uint8_t count);
+static uint8_t atecc_receive(uint8_t size, uint8_t *response);
+
+/* I2C functions */
+
+static bool atecc_send(uint8_t word_address, const uint8_t *buffer, uint8_t count)
+{
+	Wire.beginTransmission(device_address);
+	(void)Wire.write(word_address);
+	if (count > 0) {
+		(void)Wire.write(buffer, count);
+	}
+	return Wire.endTransmission() == 0;
+}
+
+static uint8_t atecc_receive(uint8_t size, uint8_t *response)
+{
+	// The device does not acknowledge its address while it is busy. The response is read in
+	// chunks the Wire buffer can hold, the device keeps its read position in between.
+	uint8_t received = 0;
+	while (received < size) {
+		uint8_t chunk = size - received;
+		if (chunk > 32) {
+			chunk = 32;
+		}
+		if (Wire.requestFrom(device_address, chunk) != chunk) {
+			return received == 0 ? ATECC_RX_NO_RESPONSE : ATECC_INVALID_SIZE;
+		}
+		while (chunk-- > 0) {
+			response[received++] = (uint8_t)Wire.read();
+		}
+		if (received >= response[ATECC_BUFFER_POS_COUNT]) {
+			// the count byte tells that the response is complete
+			break;
+		}
+	}
+	const uint8_t count = response[ATECC_BUFFER_POS_COUNT];
+	if (count < ATECC_RSP_SIZE_MIN || count > size) {
+		return ATECC_INVALID_SIZE;
+	}
+	return atecc_check_crc(response);
+}
+
+/* CRC Calculator and Checker, same as for the ATSHA204 */
+
+static void atecc_calculate_crc(uint8_t length, const uint8_t *data, uint8_t *crc)
+{
+	const uint16_t crc_register = crc16Atsha204(data, length);
+	crc[0] = (uint8_t) (crc_register & 0x00FF);
+	crc[1] = (uint8_t) (crc_register >> 8);
+}
+
+static uint8_t atecc_check_crc(const uint8_t *response)
+{
+	uint8_t crc[ATECC_CRC_SIZE];
+	uint8_t count = response[ATECC_BUFFER_POS_COUNT];
+
+	count -= ATECC_CRC_SIZE;
+	atecc_calculate_crc(count, response, crc);
+
+	return (crc[0] == response[count] && crc[1] == response[count + 1])
+	       ? ATECC_SUCCESS : ATECC_BAD_CRC;
+}
+
+/* Public functions */
+
+void atecc_init(uint8_t address)
+{
+	device_address = address;
+	Wire.begin();
+	// the wake token needs the slow clock
+	Wire.setClock(ATECC_WAKE_CLOCK);
+}
+
+uint8_t atecc_wakeup(uint8_t *response)
+{
+	// Writing to address 0 holds SDA low for the address byte, the device does not acknowledge
+	Wire.beginTransmission(0x00);
+	(void)Wire.endTransmission();
+	delayMicroseconds(ATECC_WAKE_DELAY_US);
+
+	uint8_t ret_code = atecc_receive(ATECC_RSP_SIZE_MIN, response);
+	if (ret_code != ATECC_SUCCESS) {
+		return ret_code;
+	}
+	if (response[ATECC_BUFFER_POS_STATUS] != ATECC_STATUS_BYTE_WAKEUP) {
+		return ATECC_COMM_FAIL;
+	}
+	return ATECC_SUCCESS;
+}
+
+void atecc_idle(void)
+{
+	(void)atecc_send(ATECC_WORD_ADDRESS_IDLE, NULL, 0);
+}
+
+void atecc_sleep(void)
+{
+	(void)atecc_send(ATECC_WORD_ADDRESS_SLEEP, NULL, 0);
+}
+
+uint8_t atecc_execute(uint8_t op_code, uint8_t param1, uint16_t param2,
+                      uint8_t datalen, const uint8_t *data, uint8_t rx_size, uint8_t *rx_buffer,
+                      uint8_t execution_timeout)
+{
+	uint8_t tx_buffer[ATECC_CMD_SIZE_MAX];
+	const uint8_t len = datalen + ATECC_CMD_SIZE_MIN;
+	if (len > ATECC_CMD_SIZE_MAX || rx_size < ATECC_RSP_SIZE_MIN) {
+		return ATECC_INVALID_SIZE;
+	}
+
+	// Assemble command.
+	tx_buffer[0] = len;
+	tx_buffer[1] = op_code;
+	tx_buffer[2] = param1;
+	tx_buffer[3] = param2 & 0xFF;
+	tx_buffer[4] = param2 >> 8;
+	if (datalen > 0) {
+		(void)memcpy(&tx_buffer[5], data, datalen);
+	}
+	atecc_calculate_crc(len - ATECC_CRC_SIZE, tx_buffer, &tx_buffer[len - ATECC_CRC_SIZE]);
+
+	if (!atecc_send(ATECC_WORD_ADDRESS_CMD, tx_buffer, len)) {
+		return ATECC_COMM_FAIL;
+	}
+
+	// Poll until the device answers, interrupts stay enabled all the time
+	uint8_t ret_code;
+	const uint32_t started = millis();
+	do {
+		delay(ATECC_POLL_DELAY_MS);
+		ret_code = atecc_receive(rx_size, rx_buffer);
+	} while (ret_code == ATECC_RX_NO_RESPONSE &&
+	         (uint32_t)(millis() - started) <= execution_timeout);
+	if (ret_code != ATECC_SUCCESS) {
+		return ret_code;
+	}
+
+	if (rx_buffer[ATECC_BUFFER_POS_COUNT] == ATECC_RSP_SIZE_MIN) {
+		// Translate the device status into library return codes.
+		switch (rx_buffer[ATECC_BUFFER_POS_STATUS]) {
+		case ATECC_STATUS_BYTE_PARSE:
+			return ATECC_PARSE_ERROR;
+		case ATECC_STATUS_BYTE_EXEC:
+			return ATECC_CMD_FAIL;
+		case ATECC_STATUS_BYTE_COMM:
+			return ATECC_STATUS_CRC;
+		default:
+			break;
+		}
+	}
+	return ATECC_SUCCESS;
+}
+
+uint8_t atecc_read(uint8_t *rx_buffer, uint8_t zone, uint16_t address)
+{
+	return atecc_execute(ATECC_READ, zone, address >> 2, 0, NULL, ATECC_RSP_SIZE_VAL, rx_buffer,
+	                     ATECC_READ_EXEC_MAX);
+}
+
+uint8_t atecc_getSerialNumber(uint8_t *response)
+{
+	uint8_t readResponse[ATECC_RSP_SIZE_VAL];
+
+	uint8_t returnCode = atecc_read(readResponse, ATECC_ZONE_CONFIG, ATECC_ADDRESS_SN03);
+	if (returnCode == ATECC_SUCCESS) {
+		(void)memcpy(response, &readResponse[ATECC_BUFFER_POS_DATA], 4);
+		returnCode = atecc_read(readResponse, ATECC_ZONE_CONFIG, ATECC_ADDRESS_SN47);
+	}
+	if (returnCode == ATECC_SUCCESS) {
+		(void)memcpy(&response[4], &readResponse[ATECC_BUFFER_POS_DATA], 4);
+		returnCode = atecc_read(readResponse, ATECC_ZONE_CONFIG, ATECC_ADDRESS_SN8);
+	}
+	if (returnCode == ATECC_SUCCESS) {
+		response[8] = readResponse[ATECC_BUFFER_POS_DATA];
+	}
+	return returnCode;
+}
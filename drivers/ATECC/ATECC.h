@@ -0,0 +1,87 @@
+#ifndef ATECC_H
+#define ATECC_H
+#if !DOXYGEN
+#include <Arduino.h>
+#include <Wire.h>
+
+/* A minimal I2C driver for the ATECC508A and ATECC608A, tweaked to meet the specific needs of the MySensors library. */
+
+/* Library return codes, same values as the ATSHA204 library */
+#define ATECC_SUCCESS               ((uint8_t)  0x00) //!< Function succeeded.
+#define ATECC_PARSE_ERROR           ((uint8_t)  0xD2) //!< response status byte indicates parsing error
+#define ATECC_CMD_FAIL              ((uint8_t)  0xD3) //!< response status byte indicates command execution error
+#define ATECC_STATUS_CRC            ((uint8_t)  0xD4) //!< response status byte indicates CRC error
+#define ATECC_INVALID_SIZE          ((uint8_t)  0xE4) //!< Count value is out of range or greater than buffer size.
+#define ATECC_BAD_CRC               ((uint8_t)  0xE5) //!< incorrect CRC received
+#define ATECC_RX_NO_RESPONSE        ((uint8_t)  0xE7) //!< Device did not answer within the maximum execution time
+#define ATECC_COMM_FAIL             ((uint8_t)  0xF0) //!< Device did not acknowledge the command
+
+/* I2C word addresses */
+#define ATECC_WORD_ADDRESS_SLEEP    ((uint8_t) 0x01) //!< go into Sleep mode
+#define ATECC_WORD_ADDRESS_IDLE     ((uint8_t) 0x02) //!< go into Idle mode
+#define ATECC_WORD_ADDRESS_CMD      ((uint8_t) 0x03) //!< command follows
+
+/* Timing */
+#define ATECC_WAKE_CLOCK            (100000ul)        //!< I2C clock, the zero address byte is the wake token (> 60 us)
+#define ATECC_WAKE_DELAY_US         (1500)            //!< delay between wake token and communication
+#define ATECC_POLL_DELAY_MS         (1)               //!< delay between polls for a response
+
+/* Packet layout */
+#define ATECC_CMD_SIZE_MIN          ((uint8_t)  7)    //!< count, op-code, param1, param2 (2), CRC (2)
+#define ATECC_CMD_SIZE_MAX          ((uint8_t) 71)    //!< command with 64 bytes of data
+#define ATECC_RSP_SIZE_MIN          ((uint8_t)  4)    //!< count, status, CRC (2)
+#define ATECC_RSP_SIZE_VAL          ((uint8_t)  7)    //!< response with four bytes of data
+#define ATECC_RSP_SIZE_MAX          ((uint8_t) 35)    //!< response with 32 bytes of data
+#define ATECC_CRC_SIZE              ((uint8_t)  2)    //!< number of CRC bytes
+#define ATECC_BUFFER_POS_COUNT      (0)               //!< buffer index of count byte in command or response
+#define ATECC_BUFFER_POS_STATUS     (1)               //!< buffer index of status byte in status response
+#define ATECC_BUFFER_POS_DATA       (1)               //!< buffer index of first data byte in data response
+#define ATECC_STATUS_BYTE_WAKEUP    ((uint8_t) 0x11)  //!< device woke up
+#define ATECC_STATUS_BYTE_PARSE     ((uint8_t) 0x03)  //!< command parse error
+#define ATECC_STATUS_BYTE_EXEC      ((uint8_t) 0x0F)  //!< command execution error
+#define ATECC_STATUS_BYTE_COMM      ((uint8_t) 0xFF)  //!< communication error
+
+/* Commands */
+#define ATECC_READ                  ((uint8_t) 0x02)  //!< Read command op-code
+#define ATECC_RANDOM                ((uint8_t) 0x1B)  //!< Random command op-code
+#define ATECC_SHA                   ((uint8_t) 0x47)  //!< SHA command op-code
+
+#define ATECC_ZONE_CONFIG           ((uint8_t) 0x00)  //!< Configuration zone
+#define ATECC_RANDOM_SEED_UPDATE    ((uint8_t) 0x00)  //!< Random mode for automatic seed update
+#define ATECC_SHA_UPDATE            ((uint8_t) 0x01)  //!< SHA mode: add a 64 byte block
+#define ATECC_SHA_HMAC_START        ((uint8_t) 0x04)  //!< SHA mode: start HMAC with the key in slot param2
+#define ATECC_SHA_HMAC_END          ((uint8_t) 0x05)  //!< SHA mode: add the last 0..63 bytes, param2 bytes, and return the HMAC
+#define ATECC_SHA_608_HMAC_END      ((uint8_t) 0x02)  //!< SHA mode for HMAC end on the ATECC608A
+#define ATECC_SHA_BLOCK_SIZE        (64)              //!< data size of ATECC_SHA_UPDATE
+
+/* Maximum execution times (ms), the longer ones of both chips */
+#define ATECC_READ_EXEC_MAX         (2)
+#define ATECC_RANDOM_EXEC_MAX       (23)
+#define ATECC_SHA_EXEC_MAX          (42)
+
+/* Configuration zone */
+#define ATECC_ADDRESS_SN03          (0)               //!< SN[0:3] are bytes 0->3 of configuration zone
+#define ATECC_ADDRESS_REVNUM        (4)               //!< RevNum are bytes 4->7 of configuration zone
+#define ATECC_REVNUM_608            ((uint8_t) 0x60)  //!< RevNum byte 6 from the ATECC608A on
+#define ATECC_ADDRESS_SN47          (8)               //!< SN[4:7] are bytes 8->11 of configuration zone
+#define ATECC_ADDRESS_SN8           (12)              //!< SN[8] is byte 12 of configuration zone
+#define ATECC_ADDRESS_LOCK          (84)              //!< word with LockValue (byte 86) and LockConfig (byte 87)
+#define ATECC_SERIAL_SZ             (9)               //!< The number of bytes the serial number consists of
+
+/* The SHA update command does not fit the 32 byte buffer of the AVR Wire library */
+#if defined(BUFFER_LENGTH) && (BUFFER_LENGTH < 72)
+#error MY_SIGNING_ATECC needs a Wire buffer of 72 bytes, raise BUFFER_LENGTH and TWI_BUFFER_LENGTH of the Wire library
+#endif
+
+void atecc_init(uint8_t address);
+uint8_t atecc_wakeup(uint8_t *response);
+void atecc_idle(void);
+void atecc_sleep(void);
+uint8_t atecc_execute(uint8_t op_code, uint8_t param1, uint16_t param2,
+                      uint8_t datalen, const uint8_t *data, uint8_t rx_size, uint8_t *rx_buffer,
+                      uint8_t execution_timeout);
+uint8_t atecc_read(uint8_t *rx_buffer, uint8_t zone, uint16_t address);
+uint8_t atecc_getSerialNumber(uint8_t *response);
+
+#endif
+#endif
@@ -3,13 +3,16 @@
 
 /* Local data and function prototypes */
 
+#if !defined(MY_SIGNING_ATSHA204_SERIAL)
 static uint8_t device_pin;
 #ifdef ARDUINO_ARCH_AVR
 static volatile uint8_t *device_port_DDR, *device_port_OUT, *device_port_IN;
 #endif
+static void swi_set_signal_pin(uint8_t is_high);
+#endif
 static void sha204c_calculate_crc(uint8_t length, uint8_t *data, uint8_t *crc);
 static uint8_t sha204c_check_crc(uint8_t *response);
-static void swi_set_signal_pin(uint8_t is_high);
+static void swi_wakeup_pulse(void);
 static uint8_t swi_receive_bytes(uint8_t count, uint8_t *buffer);
 static uint8_t swi_send_bytes(uint8_t count, uint8_t *buffer);
 static uint8_t swi_send_byte(uint8_t value);
@@ -18,6 +21,95 @@ static uint8_t sha204c_resync(uint8_t size, uint8_t *response);
 static uint8_t sha204c_send_and_receive(uint8_t *tx_buffer, uint8_t rx_size, uint8_t *rx_buffer,
                                         uint8_t execution_delay, uint8_t execution_timeout);
 
+#if defined(MY_SIGNING_ATSHA204_SERIAL)
+/* SWI UART functions */
+
+// RX and TX of the UART are both connected to SDA. Every UART frame (7N1 at 230400 baud) is one
+// single-wire bit: the start bit is the start pulse, the data bits shape the rest of the bit.
+// The UART times the bits, so interrupts stay enabled.
+
+static void swi_uart_drain(void)
+{
+	// our own frames are echoed back, drop them before the device answers
+	MY_SIGNING_ATSHA204_SERIAL.flush();
+	delayMicroseconds(SWI_UART_FRAME_US);
+	while (MY_SIGNING_ATSHA204_SERIAL.available()) {
+		(void)MY_SIGNING_ATSHA204_SERIAL.read();
+	}
+}
+
+static void swi_wakeup_pulse(void)
+{
+	// a zero byte at the lower baud rate holds SDA low long enough for a wake token
+	MY_SIGNING_ATSHA204_SERIAL.begin(SWI_UART_WAKE_BAUD, SERIAL_8N1);
+	(void)MY_SIGNING_ATSHA204_SERIAL.write((uint8_t)0x00);
+	MY_SIGNING_ATSHA204_SERIAL.flush();
+	MY_SIGNING_ATSHA204_SERIAL.begin(SWI_UART_BAUD, SERIAL_7N1);
+}
+
+static uint8_t swi_send_bytes(uint8_t count, uint8_t *buffer)
+{
+	uint8_t i, bit_mask;
+
+	// Wait turn around time.
+	delayMicroseconds(RX_TX_DELAY);
+
+	for (i = 0; i < count; i++) {
+		for (bit_mask = 1; bit_mask > 0; bit_mask <<= 1) {
+			(void)MY_SIGNING_ATSHA204_SERIAL.write((bit_mask & buffer[i]) ? SWI_UART_BIT_ONE :
+			                                       SWI_UART_BIT_ZERO);
+		}
+	}
+	swi_uart_drain();
+	return SWI_FUNCTION_RETCODE_SUCCESS;
+}
+
+static uint8_t swi_send_byte(uint8_t value)
+{
+	return swi_send_bytes(1, &value);
+}
+
+static uint8_t swi_receive_bytes(uint8_t count, uint8_t *buffer)
+{
+	uint8_t status = SWI_FUNCTION_RETCODE_SUCCESS;
+	uint8_t i;
+	uint8_t bit_mask;
+	// the device answers within the turn around time, then sends the bits back to back
+	uint16_t timeout_us = SWI_RECEIVE_TIME_OUT;
+
+	for (i = 0; i < count; i++) {
+		for (bit_mask = 1; bit_mask > 0; bit_mask <<= 1) {
+			const uint32_t started = micros();
+			while (!MY_SIGNING_ATSHA204_SERIAL.available()) {
+				if ((uint32_t)(micros() - started) > timeout_us) {
+					status = SWI_FUNCTION_RETCODE_TIMEOUT;
+					break;
+				}
+			}
+			if (status != SWI_FUNCTION_RETCODE_SUCCESS) {
+				break;
+			}
+			// a one bit is a single start pulse, allow one bit time of jitter at the end of it
+			if ((uint8_t)(MY_SIGNING_ATSHA204_SERIAL.read() ^ SWI_UART_BIT_ONE) < 2) {
+				buffer[i] |= bit_mask;
+			}
+			timeout_us = SWI_UART_BIT_TIME_OUT;
+		}
+
+		if (status != SWI_FUNCTION_RETCODE_SUCCESS) {
+			break;
+		}
+	}
+
+	if (status == SWI_FUNCTION_RETCODE_TIMEOUT) {
+		if (i > 0) {
+			// Indicate that we timed out after having received at least one byte.
+			status = SWI_FUNCTION_RETCODE_RX_FAIL;
+		}
+	}
+	return status;
+}
+#else
 /* SWI bit bang functions */
 
 static void swi_set_signal_pin(uint8_t is_high)
@@ -31,13 +123,17 @@ static void swi_set_signal_pin(uint8_t is_high)
 	}
 }
 
+static void swi_wakeup_pulse(void)
+{
+	swi_set_signal_pin(0);
+	delayMicroseconds(10*SHA204_WAKEUP_PULSE_WIDTH);
+	swi_set_signal_pin(1);
+}
+
 static uint8_t swi_send_bytes(uint8_t count, uint8_t *buffer)
 {
 	uint8_t i, bit_mask;
 
-	// Disable interrupts while sending.
-	noInterrupts();  //swi_disable_interrupts();
-
 	// Set signal pin as output.
 	SHA204_POUT_HIGH();
 	SHA204_SET_OUTPUT();
@@ -47,6 +143,9 @@ static uint8_t swi_send_bytes(uint8_t count, uint8_t *buffer)
 	delayMicroseconds(RX_TX_DELAY);  //RX_TX_DELAY;
 
 	for (i = 0; i < count; i++) {
+		// Disable interrupts while sending a byte only, the device accepts gaps between bytes,
+		// so pending interrupts are served every SWI_US_PER_BYTE.
+		noInterrupts();  //swi_disable_interrupts();
 		for (bit_mask = 1; bit_mask > 0; bit_mask <<= 1) {
 			if (bit_mask & buffer[i]) {
 				SHA204_POUT_LOW(); //*device_port_OUT &= ~device_pin;
@@ -65,8 +164,8 @@ static uint8_t swi_send_bytes(uint8_t count, uint8_t *buffer)
 				delayMicroseconds(5*BIT_DELAY);  //BIT_DELAY_5;
 			}
 		}
+		interrupts();  //swi_enable_interrupts();
 	}
-	interrupts();  //swi_enable_interrupts();
 	return SWI_FUNCTION_RETCODE_SUCCESS;
 }
 
@@ -171,6 +270,7 @@ static uint8_t swi_receive_bytes(uint8_t count, uint8_t *buffer)
 	}
 	return status;
 }
+#endif
 
 /* Physical functions */
 
@@ -376,25 +476,7 @@ static uint8_t sha204c_send_and_receive(uint8_t *tx_buffer, uint8_t rx_size, uin
 
 static void sha204c_calculate_crc(uint8_t length, uint8_t *data, uint8_t *crc)
 {
-	uint8_t counter;
-	uint16_t crc_register = 0;
-	uint16_t polynom = 0x8005;
-	uint8_t shift_register;
-	uint8_t data_bit, crc_bit;
-
-	for (counter = 0; counter < length; counter++) {
-		for (shift_register = 0x01; shift_register > 0x00; shift_register <<= 1) {
-			data_bit = (data[counter] & shift_register) ? 1 : 0;
-			crc_bit = crc_register >> 15;
-
-			// Shift CRC to the left by 1.
-			crc_register <<= 1;
-
-			if ((data_bit ^ crc_bit) != 0) {
-				crc_register ^= polynom;
-			}
-		}
-	}
+	const uint16_t crc_register = crc16Atsha204(data, length);
 	crc[0] = (uint8_t) (crc_register & 0x00FF);
 	crc[1] = (uint8_t) (crc_register >> 8);
 }
@@ -415,7 +497,10 @@ static uint8_t sha204c_check_crc(uint8_t *response)
 
 void atsha204_init(uint8_t pin)
 {
-#if defined(ARDUINO_ARCH_AVR)
+#if defined(MY_SIGNING_ATSHA204_SERIAL)
+	(void)pin;
+	MY_SIGNING_ATSHA204_SERIAL.begin(SWI_UART_BAUD, SERIAL_7N1);
+#elif defined(ARDUINO_ARCH_AVR)
 	device_pin = digitalPinToBitMask(pin);  // Find the bit value of the pin
 	uint8_t port = digitalPinToPort(pin); // temoporarily used to get the next three registers
 
@@ -442,9 +527,7 @@ void atsha204_sleep(void)
 
 uint8_t atsha204_wakeup(uint8_t *response)
 {
-	swi_set_signal_pin(0);
-	delayMicroseconds(10*SHA204_WAKEUP_PULSE_WIDTH);
-	swi_set_signal_pin(1);
+	swi_wakeup_pulse();
 	delay(SHA204_WAKEUP_DELAY);
 
 	uint8_t ret_code = sha204p_receive_response(SHA204_RSP_SIZE_MIN, response);
@@ -33,6 +33,15 @@
 #define START_PULSE_TIME_OUT	(255)	//! This value is decremented while waiting for the falling edge of a start pulse.
 #define ZERO_PULSE_TIME_OUT		(26)	//! This value is decremented while waiting for the falling edge of a zero pulse.
 
+/* SWI over UART, see MY_SIGNING_ATSHA204_SERIAL */
+
+#define SWI_UART_BAUD			(230400ul)	//! one UART frame (7N1) is one single-wire bit
+#define SWI_UART_WAKE_BAUD		(115200ul)	//! a zero byte (8N1) is a 78 us wake token
+#define SWI_UART_BIT_ONE		((uint8_t) 0x7F)	//! UART frame of a one bit: start pulse only
+#define SWI_UART_BIT_ZERO		((uint8_t) 0x7D)	//! UART frame of a zero bit: start pulse and zero pulse
+#define SWI_UART_FRAME_US		(40)	//! time of one UART frame in us, rounded up
+#define SWI_UART_BIT_TIME_OUT	(200)	//! timeout for the next bit of a response in us
+
 /* swi_phys.h */
 
 #define SWI_FUNCTION_RETCODE_SUCCESS     ((uint8_t) 0x00) //!< Communication with device succeeded.
@@ -49,8 +49,13 @@ static uint16_t rx_target;
 static uint16_t rx_stop_ticks=0;
 static volatile uint8_t rx_buffer_head;
 static volatile uint8_t rx_buffer_tail;
-#define RX_BUFFER_SIZE 80
+#define RX_BUFFER_SIZE MY_ALTSOFTSERIAL_RX_BUFFER_SIZE
+#if RX_BUFFER_SIZE > 255
+#error MY_ALTSOFTSERIAL_RX_BUFFER_SIZE must not exceed 255
+#endif
 static volatile uint8_t rx_buffer[RX_BUFFER_SIZE];
+static volatile uint8_t rx_high_water;
+static volatile uint16_t rx_overruns;
 
 static volatile uint8_t tx_state=0;
 static uint8_t tx_byte;
@@ -225,6 +230,22 @@ void AltSoftSerial::flushOutput(void)
 /**            Reception               **/
 /****************************************/
 
+// Store rx_byte at head, called from the receive interrupts
+static inline void rx_store(uint8_t head)
+{
+	const uint8_t tail = rx_buffer_tail;
+	if (head == tail) {
+		rx_overruns++;
+		return;
+	}
+	rx_buffer[head] = rx_byte;
+	rx_buffer_head = head;
+	const uint8_t waiting = head >= tail ? head - tail : RX_BUFFER_SIZE + head - tail;
+	if (waiting > rx_high_water) {
+		rx_high_water = waiting;
+	}
+}
+
 ISR(CAPTURE_INTERRUPT)
 {
 	uint8_t state, bit;
@@ -265,10 +286,7 @@ ISR(CAPTURE_INTERRUPT)
 				if (head >= RX_BUFFER_SIZE) {
 					head = 0;
 				}
-				if (head != rx_buffer_tail) {
-					rx_buffer[head] = rx_byte;
-					rx_buffer_head = head;
-				}
+				rx_store(head);
 				CONFIG_CAPTURE_FALLING_EDGE();
 				rx_bit = 0;
 				rx_state = 0;
@@ -297,10 +315,7 @@ ISR(COMPARE_B_INTERRUPT)
 	if (head >= RX_BUFFER_SIZE) {
 		head = 0;
 	}
-	if (head != rx_buffer_tail) {
-		rx_buffer[head] = rx_byte;
-		rx_buffer_head = head;
-	}
+	rx_store(head);
 	rx_state = 0;
 	CONFIG_CAPTURE_FALLING_EDGE();
 	rx_bit = 0;
@@ -357,6 +372,21 @@ void AltSoftSerial::flushInput(void)
 	rx_buffer_head = rx_buffer_tail;
 }
 
+uint8_t AltSoftSerial::rxHighWater(void)
+{
+	return rx_high_water;
+}
+
+uint16_t AltSoftSerial::rxOverruns(void)
+{
+	uint16_t overruns;
+	const uint8_t sreg = SREG;
+	cli();
+	overruns = rx_overruns;
+	SREG = sreg;
+	return overruns;
+}
+
 
 #ifdef ALTSS_USE_FTM0
 void ftm0_isr(void)
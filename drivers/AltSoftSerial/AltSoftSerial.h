@@ -79,6 +79,8 @@ public:
 	using Print::write;
 	static void flushInput(); //!< flushInput
 	static void flushOutput(); //!< flushOutput
+	static uint8_t rxHighWater(); //!< most bytes waiting in the receive buffer so far
+	static uint16_t rxOverruns(); //!< bytes dropped because the receive buffer was full
 	// for drop-in compatibility with NewSoftSerial, rxPin & txPin ignored
 	AltSoftSerial(uint8_t rxPin, uint8_t txPin, bool inverse = false)
 	{
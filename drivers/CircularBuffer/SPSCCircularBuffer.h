@@ -0,0 +1,182 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file SPSCCircularBuffer.h
+*
+* Lock-free circular buffering for one producer (e.g. an interrupt handler) and one consumer.
+*/
+
+#ifndef SPSCCircularBuffer_h
+#define SPSCCircularBuffer_h
+
+/**
+ * @brief Smallest power of two not below n, for 1 <= n <= 128
+ */
+#define SPSC_CIRCULAR_BUFFER_SIZE(n) ((((n) - 1) | (((n) - 1) >> 1) | (((n) - 1) >> 2) | \
+                                       (((n) - 1) >> 3) | (((n) - 1) >> 4) | (((n) - 1) >> 5) | \
+                                       (((n) - 1) >> 6)) + 1)
+
+/**
+ * The single-producer/single-consumer circular buffer class.
+ *
+ * Pass the datatype and the number of records, a power of two up to 128, as template
+ * parameters. The interface matches CircularBuffer: the producer fills the record returned by
+ * getFront() and pushes it, the consumer reads the record returned by getBack() and pops it.
+ * Each side only writes its own index, so no critical sections are needed as long as there is
+ * one producer and one consumer.
+ */
+template <class T, uint8_t N> class SPSCCircularBuffer
+{
+	static_assert(N > 0 && N <= 128 && (N & (N - 1)) == 0,
+	              "SPSCCircularBuffer size must be a power of two up to 128");
+public:
+	/**
+	 * Constructor
+	 */
+	SPSCCircularBuffer(void) : m_front(0), m_back(0)
+	{
+	}
+
+	/**
+	 * Clear all entries, only if neither side is active.
+	 */
+	void clear(void)
+	{
+		__atomic_store_n(&m_back, __atomic_load_n(&m_front, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+	}
+
+	/**
+	 * Test if the circular buffer is empty.
+	 * @return True, when empty.
+	 */
+	inline bool empty(void) const
+	{
+		return available() == 0;
+	}
+
+	/**
+	 * Test if the circular buffer is full.
+	 * @return True, when full.
+	 */
+	inline bool full(void) const
+	{
+		return available() == N;
+	}
+
+	/**
+	 * Get number of records in the circular buffer.
+	 * @return Number of records in buffer.
+	 */
+	inline uint8_t available(void) const
+	{
+		return (uint8_t)(__atomic_load_n(&m_front, __ATOMIC_ACQUIRE) -
+		                 __atomic_load_n(&m_back, __ATOMIC_ACQUIRE));
+	}
+
+	/**
+	 * Aquire record on front of the buffer, for writing (producer).
+	 * After filling the record, it has to be pushed to actually
+	 * add it to the buffer.
+	 * @return Pointer to record, or NULL when buffer is full.
+	 */
+	T* getFront(void)
+	{
+		const uint8_t front = __atomic_load_n(&m_front, __ATOMIC_RELAXED);
+		if ((uint8_t)(front - __atomic_load_n(&m_back, __ATOMIC_ACQUIRE)) == N) {
+			return static_cast<T*>(NULL);
+		}
+		return &m_buff[front & (N - 1)];
+	}
+
+	/**
+	 * Push record to front of the buffer (producer).
+	 * @param record   Record to push. If record was aquired previously (using getFront) its
+	 *                 data will not be copied as it is already present in the buffer.
+	 * @return True, when record was pushed successfully.
+	 */
+	bool pushFront(T* record)
+	{
+		T* front = getFront();
+		if (front == NULL) {
+			return false;
+		}
+		if (record != front) {
+			*front = *record;
+		}
+		// publish the record after its data
+		__atomic_store_n(&m_front, (uint8_t)(__atomic_load_n(&m_front, __ATOMIC_RELAXED) + 1),
+		                 __ATOMIC_RELEASE);
+		return true;
+	}
+
+	/**
+	 * Aquire record on back of the buffer, for reading (consumer).
+	 * After reading the record, it has to be pop'ed to actually
+	 * remove it from the buffer.
+	 * @return Pointer to record, or NULL when buffer is empty.
+	 */
+	T* getBack(void)
+	{
+		const uint8_t back = __atomic_load_n(&m_back, __ATOMIC_RELAXED);
+		if (__atomic_load_n(&m_front, __ATOMIC_ACQUIRE) == back) {
+			return static_cast<T*>(NULL);
+		}
+		return &m_buff[back & (N - 1)];
+	}
+
+	/**
+	 * Remove record from back of the buffer (consumer).
+	 * @return True, when record was pop'ed successfully.
+	 */
+	bool popBack(void)
+	{
+		return popBack(NULL, 1) == 1;
+	}
+
+	/**
+	 * Copy out and remove several records from back of the buffer (consumer).
+	 * @param records  Destination for at least count records, NULL to drop them.
+	 * @param count    Max number of records to remove.
+	 * @return Number of records removed.
+	 */
+	uint8_t popBack(T* records, const uint8_t count)
+	{
+		const uint8_t back = __atomic_load_n(&m_back, __ATOMIC_RELAXED);
+		uint8_t n = (uint8_t)(__atomic_load_n(&m_front, __ATOMIC_ACQUIRE) - back);
+		if (n > count) {
+			n = count;
+		}
+		if (records != NULL) {
+			for (uint8_t i = 0; i < n; i++) {
+				records[i] = m_buff[(uint8_t)(back + i) & (N - 1)];
+			}
+		}
+		// release the records after they have been read
+		__atomic_store_n(&m_back, (uint8_t)(back + n), __ATOMIC_RELEASE);
+		return n;
+	}
+
+protected:
+	T                  m_buff[N];  //!< Records.
+	uint8_t            m_front;    //!< Free-running count of pushed records, written by the producer.
+	uint8_t            m_back;     //!< Free-running count of pop'ed records, written by the consumer.
+};
+
+#endif // SPSCCircularBuffer_h
@@ -30,9 +30,14 @@
 #include <Wire.h>
 #include "I2CEeprom.h"
 
-I2CEeprom::I2CEeprom(uint8_t addr) : extEEPROM(I2CEEPROM_CHIP_SIZE, 1, I2CEEPROM_PAGE_SIZE)
+I2CEeprom::I2CEeprom(uint8_t addr) : extEEPROM(I2CEEPROM_CHIP_SIZE, 1, I2CEEPROM_PAGE_SIZE, addr)
 {
 	m_addr = addr;    // we only need this for busy()
+#if defined(MY_OTA_I2C_EEPROM_PAGE_BUFFER)
+	m_pageAddr = 0;
+	m_pageUsed = false;
+	(void)memset(m_pageValid, 0, sizeof(m_pageValid));
+#endif
 }
 
 /// setup
@@ -52,12 +57,14 @@ uint8_t I2CEeprom::readByte(uint32_t addr)
 /// read multiple bytes
 void I2CEeprom::readBytes(uint32_t addr, void* buf, uint16_t len)
 {
+	flush();
 	extEEPROM::read((unsigned long)addr, (byte *)buf, (unsigned int) len);
 }
 
 /// check if the chip is busy
 bool I2CEeprom::busy()
 {
+	flush();
 	Wire.beginTransmission(m_addr);
 	Wire.write(0);
 	Wire.write(0);
@@ -74,8 +81,64 @@ void I2CEeprom::writeByte(uint32_t addr, uint8_t byt)
 	writeBytes(addr, &byt, 1);
 }
 
+/// write multiple bytes
+#if defined(MY_OTA_I2C_EEPROM_PAGE_BUFFER)
+/// write multiple bytes, merged in the page buffer
+void I2CEeprom::writeBytes(uint32_t addr, const void* buf, uint16_t len)
+{
+	const uint8_t *data = (const uint8_t *)buf;
+	while (len > 0) {
+		const uint32_t pageAddr = addr & ~(uint32_t)(I2CEEPROM_PAGE_SIZE - 1);
+		if (m_pageUsed && pageAddr != m_pageAddr) {
+			flush();
+		}
+		m_pageAddr = pageAddr;
+		m_pageUsed = true;
+		uint16_t offset = addr - pageAddr;
+		const uint16_t end = (offset + len < I2CEEPROM_PAGE_SIZE) ? offset + len : I2CEEPROM_PAGE_SIZE;
+		len -= end - offset;
+		addr += end - offset;
+		for (; offset < end; offset++) {
+			m_page[offset] = *data++;
+			m_pageValid[offset >> 3] |= (1u << (offset & 7));
+		}
+		bool full = true;
+		for (uint8_t i = 0; i < sizeof(m_pageValid); i++) {
+			full &= (m_pageValid[i] == 0xFF);
+		}
+		if (full) {
+			// a whole page takes one write cycle
+			flush();
+		}
+	}
+}
+
+/// write the runs of buffered bytes
+void I2CEeprom::flush()
+{
+	if (!m_pageUsed) {
+		return;
+	}
+	uint16_t start = 0;
+	while (start < I2CEEPROM_PAGE_SIZE) {
+		if (!(m_pageValid[start >> 3] & (1u << (start & 7)))) {
+			start++;
+			continue;
+		}
+		uint16_t end = start + 1;
+		while (end < I2CEEPROM_PAGE_SIZE && (m_pageValid[end >> 3] & (1u << (end & 7)))) {
+			end++;
+		}
+		extEEPROM::write((unsigned long)(m_pageAddr + start), &m_page[start], (unsigned int)(end - start));
+		start = end;
+	}
+	(void)memset(m_pageValid, 0, sizeof(m_pageValid));
+	m_pageUsed = false;
+}
+#else
 /// write multiple bytes
 void I2CEeprom::writeBytes(uint32_t addr, const void* buf, uint16_t len)
 {
 	extEEPROM::write((unsigned long) addr, (byte *)buf, (unsigned int) len);
 }
+#endif
@@ -49,7 +49,7 @@
 #include <extEEPROM.h>
 
 /// I2C speed
-// 400kHz clock as default. Use extEEPROM type
+// 400kHz clock as default. Use extEEPROM type, twiClock1000kHz for Fm+ chips (e.g. 24FC256)
 #ifndef I2CEEPROM_TWI_CLK
 #define I2CEEPROM_TWI_CLK twiClock400kHz
 #endif
@@ -80,7 +80,13 @@ public:
 	void writeByte(uint32_t addr, uint8_t byt); //!< Write 1 byte to flash memory
 	void writeBytes(uint32_t addr, const void* buf,
 	                uint16_t len); //!< write multiple bytes to flash memory (up to 64K), if define SPIFLASH_SST25TYPE is set AAI Word Programming will be used
-	bool busy(); //!< check if the chip is busy erasing/writing
+	bool busy(); //!< check if the chip is busy erasing/writing, writes the page buffer first
+#if defined(MY_OTA_I2C_EEPROM_PAGE_BUFFER)
+	void flush(); //!< write the page buffer to the EEPROM
+#else
+	/// nothing buffered
+	void flush() {};
+#endif
 
 	// the rest not needed for EEPROMs, but kept so SPI flash code compiles as is (functions are NOP)
 
@@ -111,6 +117,12 @@ public:
 protected:
 
 	uint8_t m_addr; ///< I2C address for busy()
+#if defined(MY_OTA_I2C_EEPROM_PAGE_BUFFER)
+	uint32_t m_pageAddr; ///< address of the buffered page
+	uint8_t m_page[I2CEEPROM_PAGE_SIZE]; ///< page buffer, consecutive writes are merged
+	uint8_t m_pageValid[I2CEEPROM_PAGE_SIZE / 8]; ///< bit per byte of m_page to write
+	bool m_pageUsed; ///< m_page holds data
+#endif
 };
 
 #endif
@@ -73,6 +73,12 @@
 #define FLASH_SUPPORTS_RANDOM_WRITE true
 #define FLASH_WRITES_PER_WORD 2
 #define FLASH_WRITES_PER_PAGE 403
+#elif defined(ARDUINO_ARCH_STM32F1)
+#define FLASH_ERASE_CYCLES 10000
+#define FLASH_PAGE_SIZE 1024
+#define FLASH_ERASE_PAGE_TIME 40
+#define FLASH_SUPPORTS_RANDOM_WRITE true
+#define FLASH_WRITES_PER_WORD 1
 #else
 #define FLASH_ERASE_CYCLES 10000
 #define FLASH_PAGE_SIZE 4096
@@ -171,6 +177,8 @@ extern FlashClass Flash;
 /** Load Hardwarespecific files */
 #ifdef NRF5
 #include "hal/architecture/NRF5/drivers/Flash.cpp"
+#elif defined(ARDUINO_ARCH_STM32F1)
+#include "hal/architecture/STM32F1/drivers/Flash.cpp"
 #else
 #error "Unsupported platform."
 #endif
@@ -34,6 +34,8 @@
 #define NVRAM_BITMAP_MASK 0x000fff00
 #define ADDR2BIT(index)                                                        \
 	((1 << (index >> NVRAM_BITMAP_ADDR_SHIFT)) << NVRAM_BITMAP_POS)
+// Number of bytes resolved by one log pass in write_block and switch_page
+#define NVRAM_CHUNK_LENGTH 64
 
 NVRAMClass NVRAM;
 
@@ -65,22 +67,14 @@ void NVRAMClass::read_block(uint8_t *dst, uint16_t idx, uint16_t n)
 	} else {
 		log_start = vpage[0] + 1;
 	}
-	/*
-	  Serial.print("\r\nread_block idx=");
-	  Serial.print(idx);
-	  Serial.print(" n=");
-	  Serial.print(n);
-	  Serial.print("("); */
-	while (n > 0) {
-		// Read cell
+	// a single byte is found faster by the backwards search
+	if (n == 1) {
 		*dst = get_byte_from_page(vpage, log_start, log_end, idx);
-		// Serial.print(*dst, HEX);
-		// calculate next address
-		n--;
-		dst++;
-		idx++;
+		return;
 	}
-	// Serial.println(")");
+
+	// one pass over the log for the whole block
+	get_block_from_page(vpage, log_start, log_end, dst, idx, n);
 }
 
 uint8_t NVRAMClass::read(const uint16_t idx)
@@ -113,9 +107,18 @@ bool NVRAMClass::write_block(uint8_t *src, uint16_t idx, uint16_t n)
 		bitmap = 0;
 	}
 
+	// Current values, read chunk by chunk with one log pass each
+	uint8_t old_values[NVRAM_CHUNK_LENGTH];
+	uint16_t chunk_pos = NVRAM_CHUNK_LENGTH;
+
 	while (n > 0) {
-		// Read cell
-		uint8_t old_value = get_byte_from_page(vpage, log_start, log_end, idx);
+		// Read next chunk of cells
+		if (chunk_pos >= NVRAM_CHUNK_LENGTH) {
+			get_block_from_page(vpage, log_start, log_end, old_values, idx,
+			                    (n < NVRAM_CHUNK_LENGTH) ? n : NVRAM_CHUNK_LENGTH);
+			chunk_pos = 0;
+		}
+		uint8_t old_value = old_values[chunk_pos++];
 		uint8_t new_value = *src;
 
 		// Have to write into log?
@@ -131,9 +134,10 @@ bool NVRAMClass::write_block(uint8_t *src, uint16_t idx, uint16_t n)
 				bitmap = 0;
 			}
 
-			// Add Entry into log
+			// Add Entry into log, the bitmap accumulates all ranges in the log
+			bitmap |= ADDR2BIT(idx);
 			Flash.write(&vpage[log_end], (idx << NVRAM_ADDR_POS) | bitmap |
-			            ADDR2BIT(idx) | (uint32_t)new_value);
+			            (uint32_t)new_value);
 			log_end++;
 		}
 
@@ -208,13 +212,17 @@ uint32_t *NVRAMClass::switch_page(uint32_t *old_vpage, uint16_t *log_start,
 
 	// Build map
 #ifdef FLASH_SUPPORTS_RANDOM_WRITE
-	// Copy current values
-	for (uint16_t i = 0; i < (NVRAM_LENGTH >> 2); i++) {
-		read_block((uint8_t *)&value, i << 2, 4);
-		if (value != (uint32_t)~0) {
-			// Value found
-			map_length = i + 1;
-			Flash.write(&new_vpage[i + 1], value);
+	// Copy current values, one log pass per chunk
+	uint32_t values[NVRAM_CHUNK_LENGTH >> 2];
+	for (uint16_t i = 0; i < (NVRAM_LENGTH >> 2); i += (NVRAM_CHUNK_LENGTH >> 2)) {
+		read_block((uint8_t *)values, i << 2, NVRAM_CHUNK_LENGTH);
+		for (uint16_t j = 0; j < (NVRAM_CHUNK_LENGTH >> 2); j++) {
+			value = values[j];
+			if (value != (uint32_t)~0) {
+				// Value found
+				map_length = i + j + 1;
+				Flash.write(&new_vpage[i + j + 1], value);
+			}
 		}
 	}
 	// Store map length
@@ -340,3 +348,38 @@ uint8_t NVRAMClass::get_byte_from_page(uint32_t *vpage, uint16_t log_start,
 	// empty cell
 	return 0xff;
 }
+
+void NVRAMClass::get_block_from_page(uint32_t *vpage, uint16_t log_start,
+                                     uint16_t log_end, uint8_t *dst,
+                                     uint16_t idx, uint16_t n)
+{
+	// Start with the values from the map at the beginning of the vpage
+	for (uint16_t i = 0; i < n; i++) {
+		uint16_t map_address = ((idx + i) >> 2) + 1;
+		if (map_address < log_start) {
+			dst[i] = (uint8_t)(vpage[map_address] >> (((idx + i) % 4) << 3));
+		} else {
+			dst[i] = 0xff;
+		}
+	}
+
+	// mask matching the bits of all address ranges in the block
+	uint32_t address_mask = 0;
+	for (uint16_t range = idx >> NVRAM_BITMAP_ADDR_SHIFT;
+	        range <= ((idx + n - 1) >> NVRAM_BITMAP_ADDR_SHIFT); range++) {
+		address_mask |= (1 << range) << NVRAM_BITMAP_POS;
+	}
+
+	// Replay the log forwards, newer entries overwrite older ones
+	for (uint16_t pos = log_start; pos < log_end; pos++) {
+		uint32_t value = vpage[pos];
+		// skip entries written before the first update of one of the ranges
+		if ((value & address_mask) == 0) {
+			continue;
+		}
+		uint16_t offset = (uint16_t)((value >> NVRAM_ADDR_POS) - idx);
+		if (offset < n) {
+			dst[offset] = (uint8_t)value;
+		}
+	}
+}
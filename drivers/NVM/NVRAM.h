@@ -102,6 +102,10 @@ private:
 	// Read a byte from page
 	uint8_t get_byte_from_page(uint32_t *vpage, uint16_t log_start,
 	                           uint16_t log_end, uint16_t idx);
+	// Read a block from page with a single pass over the log
+	void get_block_from_page(uint32_t *vpage, uint16_t log_start,
+	                         uint16_t log_end, uint8_t *dst, uint16_t idx,
+	                         uint16_t n);
 	// switch a page
 	uint32_t *switch_page(uint32_t *old_vpage, uint16_t *log_start,
 	                      uint16_t *log_end);
@@ -66,31 +66,35 @@ VirtualPageClass VirtualPage;
  * Offsets are defined in words!
  */
 #ifdef FLASH_SUPPORTS_RANDOM_WRITE
+#if FLASH_WRITES_PER_WORD > 2
 // use first 8 byte for magic, erase counter and status
 #define OFFSET_MAGIC 0
 #define OFFSET_ERASE_COUNTER 1
-#if FLASH_WRITES_PER_WORD > 2
-// use first 12 bytes for magic, erase counter and status
 #define MASK_ERASE_COUNTER 0x00FFFFFF
 #define OFFSET_STATUS_RELEASE_PREPARE 1
 #define OFFSET_STATUS_RELEASE_END 1
 #define METADATA_SIZE 8
 #define OFFSET_DATA 2
 #elif FLASH_WRITES_PER_WORD == 2
+// use first 12 bytes for magic, erase counter and status
+#define OFFSET_MAGIC 0
+#define OFFSET_ERASE_COUNTER 1
 #define MASK_ERASE_COUNTER 0x00FFFFFF
 #define OFFSET_STATUS_RELEASE_PREPARE 2
 #define OFFSET_STATUS_RELEASE_END 2
 #define METADATA_SIZE 12
 #define OFFSET_DATA 3
 #else
-// use first 12 bytes for erase counter, and magic
+// use first 8 byte for erase counter and magic and last 8 byte for page release
 #define OFFSET_MAGIC 1
-#define OFFSET_COUNTER 0
-#define MASK_ERASE_COUNTER 0x00FFFFFF
-#define OFFSET_STATUS_RELEASE_PREPARE NVM_VIRTUAL_PAGE_SIZE - 8
-#define OFFSET_STATUS_RELEASE_END NVM_VIRTUAL_PAGE_SIZE - 4
+#define OFFSET_ERASE_COUNTER 0
+#define MASK_ERASE_COUNTER 0xFFFFFFFF
+#define OFFSET_STATUS_RELEASE_PREPARE                                          \
+	((NVM_VIRTUAL_PAGE_SIZE - 8) / sizeof(uint32_t))
+#define OFFSET_STATUS_RELEASE_END                                              \
+	((NVM_VIRTUAL_PAGE_SIZE - 4) / sizeof(uint32_t))
 #define METADATA_SIZE 16
-#define OFFSET_DATA 4
+#define OFFSET_DATA 2
 #endif
 
 #define BIT_STATUS_RELEASE_PREPARE (1 << 30)
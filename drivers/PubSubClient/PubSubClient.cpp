@@ -6,6 +6,9 @@
 
 #include "PubSubClient.h"
 #include "Arduino.h"
+#if defined(__linux__)
+#include <sys/uio.h>
+#endif
 
 // Suppress uninitialized member variable in all constructors because some memory can be saved with
 // on-demand initialization of these members
@@ -13,6 +16,13 @@
 PubSubClient::PubSubClient()
 {
 	this->_state = MQTT_DISCONNECTED;
+	this->buffer = NULL;
+	this->bufferSize = 0;
+	setBufferSize(MQTT_MAX_PACKET_SIZE);
+	this->keepAlive = MQTT_KEEPALIVE;
+	this->socketTimeout = MQTT_SOCKET_TIMEOUT;
+	this->ackCallback = NULL;
+	this->inflightCount = 0;
 	this->_client = NULL;
 	this->stream = NULL;
 	setCallback(NULL);
@@ -21,6 +31,13 @@ PubSubClient::PubSubClient()
 PubSubClient::PubSubClient(Client& client)
 {
 	this->_state = MQTT_DISCONNECTED;
+	this->buffer = NULL;
+	this->bufferSize = 0;
+	setBufferSize(MQTT_MAX_PACKET_SIZE);
+	this->keepAlive = MQTT_KEEPALIVE;
+	this->socketTimeout = MQTT_SOCKET_TIMEOUT;
+	this->ackCallback = NULL;
+	this->inflightCount = 0;
 	setClient(client);
 	this->stream = NULL;
 }
@@ -28,6 +45,13 @@ PubSubClient::PubSubClient(Client& client)
 PubSubClient::PubSubClient(IPAddress addr, uint16_t port, Client& client)
 {
 	this->_state = MQTT_DISCONNECTED;
+	this->buffer = NULL;
+	this->bufferSize = 0;
+	setBufferSize(MQTT_MAX_PACKET_SIZE);
+	this->keepAlive = MQTT_KEEPALIVE;
+	this->socketTimeout = MQTT_SOCKET_TIMEOUT;
+	this->ackCallback = NULL;
+	this->inflightCount = 0;
 	setServer(addr, port);
 	setClient(client);
 	this->stream = NULL;
@@ -36,6 +60,13 @@ PubSubClient::PubSubClient(IPAddress addr, uint16_t port, Client& client)
 PubSubClient::PubSubClient(IPAddress addr, uint16_t port, Client& client, Stream& stream)
 {
 	this->_state = MQTT_DISCONNECTED;
+	this->buffer = NULL;
+	this->bufferSize = 0;
+	setBufferSize(MQTT_MAX_PACKET_SIZE);
+	this->keepAlive = MQTT_KEEPALIVE;
+	this->socketTimeout = MQTT_SOCKET_TIMEOUT;
+	this->ackCallback = NULL;
+	this->inflightCount = 0;
 	setServer(addr,port);
 	setClient(client);
 	setStream(stream);
@@ -45,6 +76,13 @@ PubSubClient::PubSubClient(IPAddress addr, uint16_t port, Client& client, Stream
 PubSubClient::PubSubClient(IPAddress addr, uint16_t port, MQTT_CALLBACK_SIGNATURE, Client& client)
 {
 	this->_state = MQTT_DISCONNECTED;
+	this->buffer = NULL;
+	this->bufferSize = 0;
+	setBufferSize(MQTT_MAX_PACKET_SIZE);
+	this->keepAlive = MQTT_KEEPALIVE;
+	this->socketTimeout = MQTT_SOCKET_TIMEOUT;
+	this->ackCallback = NULL;
+	this->inflightCount = 0;
 	setServer(addr, port);
 	setCallback(callback);
 	setClient(client);
@@ -56,6 +94,13 @@ PubSubClient::PubSubClient(IPAddress addr, uint16_t port, MQTT_CALLBACK_SIGNATUR
                            Stream& stream)
 {
 	this->_state = MQTT_DISCONNECTED;
+	this->buffer = NULL;
+	this->bufferSize = 0;
+	setBufferSize(MQTT_MAX_PACKET_SIZE);
+	this->keepAlive = MQTT_KEEPALIVE;
+	this->socketTimeout = MQTT_SOCKET_TIMEOUT;
+	this->ackCallback = NULL;
+	this->inflightCount = 0;
 	setServer(addr,port);
 	setCallback(callback);
 	setClient(client);
@@ -65,6 +110,13 @@ PubSubClient::PubSubClient(IPAddress addr, uint16_t port, MQTT_CALLBACK_SIGNATUR
 PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, Client& client)
 {
 	this->_state = MQTT_DISCONNECTED;
+	this->buffer = NULL;
+	this->bufferSize = 0;
+	setBufferSize(MQTT_MAX_PACKET_SIZE);
+	this->keepAlive = MQTT_KEEPALIVE;
+	this->socketTimeout = MQTT_SOCKET_TIMEOUT;
+	this->ackCallback = NULL;
+	this->inflightCount = 0;
 	setServer(ip, port);
 	setClient(client);
 	this->stream = NULL;
@@ -73,6 +125,13 @@ PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, Client& client)
 PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, Client& client, Stream& stream)
 {
 	this->_state = MQTT_DISCONNECTED;
+	this->buffer = NULL;
+	this->bufferSize = 0;
+	setBufferSize(MQTT_MAX_PACKET_SIZE);
+	this->keepAlive = MQTT_KEEPALIVE;
+	this->socketTimeout = MQTT_SOCKET_TIMEOUT;
+	this->ackCallback = NULL;
+	this->inflightCount = 0;
 	setServer(ip,port);
 	setClient(client);
 	setStream(stream);
@@ -82,6 +141,13 @@ PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, Client& client, Stream& s
 PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, MQTT_CALLBACK_SIGNATURE, Client& client)
 {
 	this->_state = MQTT_DISCONNECTED;
+	this->buffer = NULL;
+	this->bufferSize = 0;
+	setBufferSize(MQTT_MAX_PACKET_SIZE);
+	this->keepAlive = MQTT_KEEPALIVE;
+	this->socketTimeout = MQTT_SOCKET_TIMEOUT;
+	this->ackCallback = NULL;
+	this->inflightCount = 0;
 	setServer(ip, port);
 	setCallback(callback);
 	setClient(client);
@@ -93,6 +159,13 @@ PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, MQTT_CALLBACK_SIGNATURE,
                            Stream& stream)
 {
 	this->_state = MQTT_DISCONNECTED;
+	this->buffer = NULL;
+	this->bufferSize = 0;
+	setBufferSize(MQTT_MAX_PACKET_SIZE);
+	this->keepAlive = MQTT_KEEPALIVE;
+	this->socketTimeout = MQTT_SOCKET_TIMEOUT;
+	this->ackCallback = NULL;
+	this->inflightCount = 0;
 	setServer(ip,port);
 	setCallback(callback);
 	setClient(client);
@@ -102,6 +175,13 @@ PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, MQTT_CALLBACK_SIGNATURE,
 PubSubClient::PubSubClient(const char* domain, uint16_t port, Client& client)
 {
 	this->_state = MQTT_DISCONNECTED;
+	this->buffer = NULL;
+	this->bufferSize = 0;
+	setBufferSize(MQTT_MAX_PACKET_SIZE);
+	this->keepAlive = MQTT_KEEPALIVE;
+	this->socketTimeout = MQTT_SOCKET_TIMEOUT;
+	this->ackCallback = NULL;
+	this->inflightCount = 0;
 	setServer(domain,port);
 	setClient(client);
 	this->stream = NULL;
@@ -110,6 +190,13 @@ PubSubClient::PubSubClient(const char* domain, uint16_t port, Client& client)
 PubSubClient::PubSubClient(const char* domain, uint16_t port, Client& client, Stream& stream)
 {
 	this->_state = MQTT_DISCONNECTED;
+	this->buffer = NULL;
+	this->bufferSize = 0;
+	setBufferSize(MQTT_MAX_PACKET_SIZE);
+	this->keepAlive = MQTT_KEEPALIVE;
+	this->socketTimeout = MQTT_SOCKET_TIMEOUT;
+	this->ackCallback = NULL;
+	this->inflightCount = 0;
 	setServer(domain,port);
 	setClient(client);
 	setStream(stream);
@@ -120,6 +207,13 @@ PubSubClient::PubSubClient(const char* domain, uint16_t port, MQTT_CALLBACK_SIGN
                            Client& client)
 {
 	this->_state = MQTT_DISCONNECTED;
+	this->buffer = NULL;
+	this->bufferSize = 0;
+	setBufferSize(MQTT_MAX_PACKET_SIZE);
+	this->keepAlive = MQTT_KEEPALIVE;
+	this->socketTimeout = MQTT_SOCKET_TIMEOUT;
+	this->ackCallback = NULL;
+	this->inflightCount = 0;
 	setServer(domain,port);
 	setCallback(callback);
 	setClient(client);
@@ -131,12 +225,24 @@ PubSubClient::PubSubClient(const char* domain, uint16_t port, MQTT_CALLBACK_SIGN
                            Client& client, Stream& stream)
 {
 	this->_state = MQTT_DISCONNECTED;
+	this->buffer = NULL;
+	this->bufferSize = 0;
+	setBufferSize(MQTT_MAX_PACKET_SIZE);
+	this->keepAlive = MQTT_KEEPALIVE;
+	this->socketTimeout = MQTT_SOCKET_TIMEOUT;
+	this->ackCallback = NULL;
+	this->inflightCount = 0;
 	setServer(domain,port);
 	setCallback(callback);
 	setClient(client);
 	setStream(stream);
 }
 
+PubSubClient::~PubSubClient()
+{
+	free(this->buffer);
+}
+
 bool PubSubClient::connect(const char *id)
 {
 	return connect(id,NULL,NULL,0,0,0,0,1);
@@ -173,6 +279,8 @@ bool PubSubClient::connect(const char *id, const char *user, const char *pass,
 		}
 		if (result == 1) {
 			nextMsgId = 1;
+			// A new session, PUBACKs of the previous one will not arrive anymore
+			inflightCount = 0;
 			// Leave room in the buffer for header and variable length field
 			uint16_t length = MQTT_MAX_HEADER_SIZE;
 			unsigned int j;
@@ -208,8 +316,8 @@ bool PubSubClient::connect(const char *id, const char *user, const char *pass,
 
 			buffer[length++] = v;
 
-			buffer[length++] = ((MQTT_KEEPALIVE) >> 8);
-			buffer[length++] = ((MQTT_KEEPALIVE) & 0xFF);
+			buffer[length++] = ((this->keepAlive) >> 8);
+			buffer[length++] = ((this->keepAlive) & 0xFF);
 
 			CHECK_STRING_LENGTH(length,id)
 			length = writeString(id,buffer,length);
@@ -235,7 +343,7 @@ bool PubSubClient::connect(const char *id, const char *user, const char *pass,
 
 			while (!_client->available()) {
 				unsigned long t = millis();
-				if (t-lastInActivity >= ((int32_t) MQTT_SOCKET_TIMEOUT*1000UL)) {
+				if (t-lastInActivity >= ((int32_t) this->socketTimeout*1000UL)) {
 					_state = MQTT_CONNECTION_TIMEOUT;
 					_client->stop();
 					return false;
@@ -270,7 +378,7 @@ bool PubSubClient::readByte(uint8_t * result)
 	while(!_client->available()) {
 		yield();
 		uint32_t currentMillis = millis();
-		if(currentMillis - previousMillis >= ((int32_t) MQTT_SOCKET_TIMEOUT * 1000)) {
+		if(currentMillis - previousMillis >= ((int32_t) this->socketTimeout * 1000)) {
 			return false;
 		}
 	}
@@ -344,13 +452,13 @@ uint16_t PubSubClient::readPacket(uint8_t* lengthLength)
 				this->stream->write(digit);
 			}
 		}
-		if (len < MQTT_MAX_PACKET_SIZE) {
+		if (len < this->bufferSize) {
 			buffer[len] = digit;
 		}
 		len++;
 	}
 
-	if (!this->stream && len > MQTT_MAX_PACKET_SIZE) {
+	if (!this->stream && len > this->bufferSize) {
 		len = 0; // This will cause the packet to be ignored.
 	}
 
@@ -361,7 +469,7 @@ bool PubSubClient::loop()
 {
 	if (connected()) {
 		unsigned long t = millis();
-		if ((t - lastInActivity > MQTT_KEEPALIVE*1000UL) || (t - lastOutActivity > MQTT_KEEPALIVE*1000UL)) {
+		if ((t - lastInActivity > this->keepAlive*1000UL) || (t - lastOutActivity > this->keepAlive*1000UL)) {
 			if (pingOutstanding) {
 				this->_state = MQTT_CONNECTION_TIMEOUT;
 				_client->stop();
@@ -407,6 +515,17 @@ bool PubSubClient::loop()
 							callback(topic,payload,len-llen-3-tl);
 						}
 					}
+				} else if (type == MQTTPUBACK) {
+					uint16_t msgId = (buffer[llen+1]<<8)+buffer[llen+2];
+					for (uint8_t i = 0; i < inflightCount; i++) {
+						if (inflightIds[i] == msgId) {
+							inflightIds[i] = inflightIds[--inflightCount];
+							if (ackCallback) {
+								ackCallback(msgId);
+							}
+							break;
+						}
+					}
 				} else if (type == MQTTPINGREQ) {
 					buffer[0] = MQTTPINGRESP;
 					buffer[1] = 0;
@@ -442,27 +561,77 @@ bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned i
 bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int plength,
                            bool retained)
 {
+	return publish(topic, payload, plength, retained, 0, NULL);
+}
+
+bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int plength,
+                           bool retained, uint8_t qos, uint16_t* packetId, bool dup)
+{
+	if (qos > 1) {
+		return false;
+	}
 	if (connected()) {
-		if (MQTT_MAX_PACKET_SIZE < MQTT_MAX_HEADER_SIZE + 2+strlen(topic) + plength) {
+		const size_t tlen = strlen(topic);
+		const size_t idlen = qos ? 2 : 0;
+		if (tlen > 0xFFFF || 2 + tlen + idlen + plength > MQTT_MAX_REMAINING_LENGTH) {
 			// Too long
 			return false;
 		}
-		// Leave room in the buffer for header and variable length field
-		uint16_t length = MQTT_MAX_HEADER_SIZE;
-		length = writeString(topic,buffer,length);
-		uint16_t i;
-		for (i=0; i<plength; i++) {
-			buffer[length++] = payload[i];
+		if (qos && inflightCount >= MQTT_MAX_INFLIGHT) {
+			// Window full, wait for PUBACKs
+			return false;
 		}
 		uint8_t header = MQTTPUBLISH;
 		if (retained) {
 			header |= 1;
 		}
-		return write(header,buffer,length-MQTT_MAX_HEADER_SIZE);
+		if (qos) {
+			header |= MQTTQOS1;
+			if (dup) {
+				header |= MQTTDUP;
+			}
+		}
+		// Fixed header and topic length go into a small scratch area, the topic and
+		// payload are handed to the client as they are
+		uint8_t head[MQTT_MAX_HEADER_SIZE + 2];
+		uint8_t hlen = buildHeader(header, head, 2 + tlen + idlen + plength);
+		head[MQTT_MAX_HEADER_SIZE] = (tlen >> 8);
+		head[MQTT_MAX_HEADER_SIZE + 1] = (tlen & 0xFF);
+		uint8_t id[2];
+		if (qos) {
+			nextMsgId++;
+			if (nextMsgId == 0) {
+				nextMsgId = 1;
+			}
+			id[0] = (nextMsgId >> 8);
+			id[1] = (nextMsgId & 0xFF);
+		}
+		const uint8_t* parts[4] = {
+			head + (MQTT_MAX_HEADER_SIZE - hlen),
+			(const uint8_t*)topic,
+			id,
+			payload
+		};
+		const size_t lengths[4] = { (size_t)(hlen + 2), tlen, idlen, plength };
+		if (!writeParts(parts, lengths, 4)) {
+			return false;
+		}
+		if (qos) {
+			inflightIds[inflightCount++] = nextMsgId;
+			if (packetId) {
+				*packetId = nextMsgId;
+			}
+		}
+		return true;
 	}
 	return false;
 }
 
+uint8_t PubSubClient::inflight()
+{
+	return inflightCount;
+}
+
 bool PubSubClient::publish_P(const char* topic, const char* payload, bool retained)
 {
 	return publish_P(topic, (const uint8_t*)payload, strlen(payload), retained);
@@ -597,6 +766,42 @@ bool PubSubClient::write(uint8_t header, uint8_t* buf, uint16_t length)
 #endif
 }
 
+bool PubSubClient::writeParts(const uint8_t* const* parts, const size_t* lengths, uint8_t count)
+{
+	size_t total = 0;
+	if (count > MQTT_MAX_WRITE_PARTS) {
+		return false;
+	}
+	for (uint8_t i = 0; i < count; i++) {
+		total += lengths[i];
+	}
+	size_t rc = 0;
+#if defined(__linux__)
+	struct iovec iov[MQTT_MAX_WRITE_PARTS];
+	for (uint8_t i = 0; i < count; i++) {
+		iov[i].iov_base = (void*)parts[i];
+		iov[i].iov_len = lengths[i];
+	}
+	rc = _client->writev(iov, count);
+#else
+	if (total <= this->bufferSize) {
+		// Small packets are assembled first, most network clients send one segment per write
+		size_t pos = 0;
+		for (uint8_t i = 0; i < count; i++) {
+			memcpy(buffer + pos, parts[i], lengths[i]);
+			pos += lengths[i];
+		}
+		rc = _client->write(buffer, total);
+	} else {
+		for (uint8_t i = 0; i < count; i++) {
+			rc += _client->write(parts[i], lengths[i]);
+		}
+	}
+#endif
+	lastOutActivity = millis();
+	return (rc == total);
+}
+
 bool PubSubClient::subscribe(const char* topic)
 {
 	return subscribe(topic, 0);
@@ -607,7 +812,7 @@ bool PubSubClient::subscribe(const char* topic, uint8_t qos)
 	if (qos > 1) {
 		return false;
 	}
-	if (MQTT_MAX_PACKET_SIZE < 9 + strlen(topic)) {
+	if (this->bufferSize < 9 + strlen(topic)) {
 		// Too long
 		return false;
 	}
@@ -629,7 +834,7 @@ bool PubSubClient::subscribe(const char* topic, uint8_t qos)
 
 bool PubSubClient::unsubscribe(const char* topic)
 {
-	if (MQTT_MAX_PACKET_SIZE < 9 + strlen(topic)) {
+	if (this->bufferSize < 9 + strlen(topic)) {
 		// Too long
 		return false;
 	}
@@ -647,6 +852,38 @@ bool PubSubClient::unsubscribe(const char* topic)
 	return false;
 }
 
+bool PubSubClient::setBufferSize(uint16_t size)
+{
+	if (size < MQTT_MIN_PACKET_SIZE) {
+		return false;
+	}
+	uint8_t* newBuffer = (uint8_t*)realloc(this->buffer, size);
+	if (newBuffer == NULL) {
+		// Keep the current buffer
+		return false;
+	}
+	this->buffer = newBuffer;
+	this->bufferSize = size;
+	return true;
+}
+
+uint16_t PubSubClient::getBufferSize()
+{
+	return this->bufferSize;
+}
+
+PubSubClient& PubSubClient::setKeepAlive(uint16_t keepAlive)
+{
+	this->keepAlive = keepAlive;
+	return *this;
+}
+
+PubSubClient& PubSubClient::setSocketTimeout(uint16_t timeout)
+{
+	this->socketTimeout = timeout;
+	return *this;
+}
+
 void PubSubClient::disconnect()
 {
 	buffer[0] = MQTTDISCONNECT;
@@ -718,6 +955,12 @@ PubSubClient& PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE)
 	return *this;
 }
 
+PubSubClient& PubSubClient::setAckCallback(MQTT_ACK_CALLBACK_SIGNATURE)
+{
+	this->ackCallback = ackCallback;
+	return *this;
+}
+
 PubSubClient& PubSubClient::setClient(Client& client)
 {
 	this->_client = &client;
@@ -21,17 +21,22 @@
 #define MQTT_VERSION MQTT_VERSION_3_1_1
 #endif
 
-// MQTT_MAX_PACKET_SIZE : Maximum packet size
+// MQTT_MAX_PACKET_SIZE : Initial packet buffer size, change at runtime with setBufferSize()
 #ifndef MQTT_MAX_PACKET_SIZE
 #define MQTT_MAX_PACKET_SIZE 128
 #endif
 
-// MQTT_KEEPALIVE : keepAlive interval in Seconds
+// MQTT_KEEPALIVE : keepAlive interval in Seconds, change at runtime with setKeepAlive()
 #ifndef MQTT_KEEPALIVE
 #define MQTT_KEEPALIVE 15
 #endif
 
-// MQTT_SOCKET_TIMEOUT: socket timeout interval in Seconds
+// MQTT_MAX_INFLIGHT : Maximum number of QoS1 publishes awaiting their PUBACK
+#ifndef MQTT_MAX_INFLIGHT
+#define MQTT_MAX_INFLIGHT 8
+#endif
+
+// MQTT_SOCKET_TIMEOUT: socket timeout interval in Seconds, change at runtime with setSocketTimeout()
 #ifndef MQTT_SOCKET_TIMEOUT
 #define MQTT_SOCKET_TIMEOUT 15
 #endif
@@ -72,35 +77,53 @@
 #define MQTTQOS0        (0 << 1)
 #define MQTTQOS1        (1 << 1)
 #define MQTTQOS2        (2 << 1)
+#define MQTTDUP         (1 << 3)
 
 // Maximum size of fixed header and variable length size header
 #define MQTT_MAX_HEADER_SIZE 5
+// Smallest packet buffer accepted by setBufferSize(), enough for the short control packets
+#define MQTT_MIN_PACKET_SIZE 16
+// Largest remaining length a published packet may have
+#define MQTT_MAX_REMAINING_LENGTH 0xFFFF
+// Most pieces a single packet is handed to the client in
+#define MQTT_MAX_WRITE_PARTS 4
 
 #if defined(ESP8266) || defined(ESP32)
 #include <functional>
 #define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+#define MQTT_ACK_CALLBACK_SIGNATURE std::function<void(uint16_t)> ackCallback
 #else
 #define MQTT_CALLBACK_SIGNATURE void (*callback)(char*, uint8_t*, unsigned int)
+#define MQTT_ACK_CALLBACK_SIGNATURE void (*ackCallback)(uint16_t)
 #endif
 
-#define CHECK_STRING_LENGTH(l,s) if (l+2+strlen(s) > MQTT_MAX_PACKET_SIZE) {_client->stop();return false;}
+#define CHECK_STRING_LENGTH(l,s) if (l+2+strlen(s) > this->bufferSize) {_client->stop();return false;}
 
 /** PubSubClient class */
 class PubSubClient : public Print
 {
 private:
 	Client* _client;
-	uint8_t buffer[MQTT_MAX_PACKET_SIZE];
+	uint8_t* buffer;
+	uint16_t bufferSize;
+	uint16_t keepAlive;
+	uint16_t socketTimeout;
 	uint16_t nextMsgId;
 	unsigned long lastOutActivity;
 	unsigned long lastInActivity;
 	bool pingOutstanding;
 	MQTT_CALLBACK_SIGNATURE;
+	MQTT_ACK_CALLBACK_SIGNATURE;
+	uint16_t inflightIds[MQTT_MAX_INFLIGHT];
+	uint8_t inflightCount;
 	uint16_t readPacket(uint8_t*);
 	bool readByte(uint8_t * result);
 	bool readByte(uint8_t * result, uint16_t * index);
 	bool write(uint8_t header, uint8_t* buf, uint16_t length);
 	uint16_t writeString(const char* string, uint8_t* buf, uint16_t pos);
+	// Hand a packet made of several pieces to the client without copying them together first
+	// where the client supports scatter writes
+	bool writeParts(const uint8_t* const* parts, const size_t* lengths, uint8_t count);
 	// Build up the header ready to send
 	// Returns the size of the header
 	// Note: the header is built at the end of the first MQTT_MAX_HEADER_SIZE bytes, so will start
@@ -129,13 +152,26 @@ public:
 	PubSubClient(const char*, uint16_t, MQTT_CALLBACK_SIGNATURE,Client& client); //!< PubSubClient
 	PubSubClient(const char*, uint16_t, MQTT_CALLBACK_SIGNATURE,Client& client,
 	             Stream&); //!< PubSubClient
+	~PubSubClient(); //!< ~PubSubClient
 
 	PubSubClient& setServer(IPAddress ip, uint16_t port); //!< setServer
 	PubSubClient& setServer(uint8_t * ip, uint16_t port); //!< setServer
 	PubSubClient& setServer(const char * domain, uint16_t port); //!< setServer
 	PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE); //!< setCallback
+	// Called with the packet id of a QoS1 publish once its PUBACK arrived
+	PubSubClient& setAckCallback(MQTT_ACK_CALLBACK_SIGNATURE); //!< setAckCallback
 	PubSubClient& setClient(Client& client); //!< setClient
 	PubSubClient& setStream(Stream& stream); //!< setStream
+	// Resize the packet buffer used for incoming packets and outgoing control packets.
+	// Publishes are streamed to the client and are not limited by it.
+	// Returns false if the buffer could not be resized, the current buffer is kept then
+	bool setBufferSize(uint16_t size); //!< setBufferSize
+	uint16_t getBufferSize(); //!< getBufferSize
+	// Keepalive sent to the broker with the next connect, a broker that stays silent for it is
+	// pinged and dropped if it stays silent for another one
+	PubSubClient& setKeepAlive(uint16_t keepAlive); //!< setKeepAlive
+	// Time to wait for the CONNACK and for the rest of an incoming packet
+	PubSubClient& setSocketTimeout(uint16_t timeout); //!< setSocketTimeout
 
 	bool connect(const char* id); //!< connect
 	bool connect(const char* id, const char* user, const char* pass); //!< connect
@@ -151,6 +187,13 @@ public:
 	bool publish(const char* topic, const uint8_t * payload, unsigned int plength); //!< publish
 	bool publish(const char* topic, const uint8_t * payload, unsigned int plength,
 	             bool retained); //!< publish
+	// Publish with QoS 0 or 1. For QoS1 the packet id is stored in packetId and the publish
+	// counts against MQTT_MAX_INFLIGHT until its PUBACK arrives, false is returned while
+	// the window is full. PUBACKs are processed by loop(). dup marks a QoS1 publish sent again.
+	bool publish(const char* topic, const uint8_t * payload, unsigned int plength,
+	             bool retained, uint8_t qos, uint16_t* packetId, bool dup = false); //!< publish
+	// Number of QoS1 publishes awaiting their PUBACK
+	uint8_t inflight(); //!< inflight
 	bool publish_P(const char* topic, const char* payload, bool retained); //!< publish
 	bool publish_P(const char* topic, const uint8_t * payload, unsigned int plength,
 	               bool retained); //!< publish
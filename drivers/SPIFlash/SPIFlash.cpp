@@ -246,6 +246,8 @@ void SPIFlash::writeByte(uint32_t addr, uint8_t byt)
 ///          use the block erase commands to first clear memory (write 0xFFs)
 /// This version handles both page alignment and data blocks larger than 256 bytes.
 /// See documentation of #MY_SPIFLASH_SST25TYPE define for more information
+/// Returns while the last page is still being programmed, the next command waits for it. Use
+/// busy() to wait explicitly.
 void SPIFlash::writeBytes(uint32_t addr, const void* buf, uint16_t len)
 {
 #ifdef MY_SPIFLASH_SST25TYPE
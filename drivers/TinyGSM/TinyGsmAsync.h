@@ -0,0 +1,294 @@
+/**
+ * file       TinyGsmAsync.h
+ * license    LGPL-3.0
+ *
+ * Non-blocking AT command engine: commands are queued with a callback and sent one after
+ * the other, poll() matches the responses line by line in short time slices.
+ */
+
+#ifndef TinyGsmAsync_h
+#define TinyGsmAsync_h
+
+#include <stdarg.h>
+#include "TinyGsmCommon.h"
+
+#if !defined(TINY_GSM_ASYNC_QUEUE_SIZE)
+#define TINY_GSM_ASYNC_QUEUE_SIZE 4
+#endif
+
+#if !defined(TINY_GSM_ASYNC_CMD_SIZE)
+#define TINY_GSM_ASYNC_CMD_SIZE 64
+#endif
+
+#if !defined(TINY_GSM_ASYNC_LINE_SIZE)
+#define TINY_GSM_ASYNC_LINE_SIZE 80
+#endif
+
+#if TINY_GSM_ASYNC_LINE_SIZE > 255
+#error TINY_GSM_ASYNC_LINE_SIZE must not exceed 255
+#endif
+
+static const char GSM_ASYNC_OK[] TINY_GSM_PROGMEM = "OK";
+static const char GSM_ASYNC_ERROR[] TINY_GSM_PROGMEM = "ERROR";
+static const char GSM_ASYNC_CME_ERROR[] TINY_GSM_PROGMEM = "+CME ERROR:";
+static const char GSM_ASYNC_CMS_ERROR[] TINY_GSM_PROGMEM = "+CMS ERROR:";
+
+// Results passed to the callback of a command
+#define TINY_GSM_ASYNC_TIMEOUT  ((uint8_t)0x00)	// no final response within the timeout
+#define TINY_GSM_ASYNC_OK       ((uint8_t)0x01)	// the expected final response
+#define TINY_GSM_ASYNC_ERROR    ((uint8_t)0xFE)	// ERROR, +CME ERROR or +CMS ERROR
+#define TINY_GSM_ASYNC_LINE     ((uint8_t)0xFF)	// an information line, the command goes on
+
+// Gets the responses of a command, line is the final or the information line
+typedef void (*TinyGsmAsyncCallback)(void *context, uint8_t result, const char *line);
+// Gets every information line first, returns true if it was an unsolicited result code
+typedef bool (*TinyGsmAsyncUrcHandler)(void *context, const char *line);
+
+class TinyGsmAsync
+{
+
+public:
+
+	explicit TinyGsmAsync(Stream& stream)
+		: stream(stream)
+	{
+		_urcHandler = NULL;
+		_urcContext = NULL;
+		clear();
+	}
+
+	void setUrcHandler(TinyGsmAsyncUrcHandler handler, void *context)
+	{
+		_urcHandler = handler;
+		_urcContext = context;
+	}
+
+	/*
+	 * Queue "AT<format>", the format string is in PROGMEM. The command is done on the
+	 * expected response (NULL for OK), an error or the timeout in ms.
+	 */
+	bool queue(TinyGsmAsyncCallback callback, void *context, uint32_t timeout,
+	           GsmConstStr response, const char *format, ...)
+	{
+		va_list args;
+		va_start(args, format);
+		Entry *entry = _add(callback, context, timeout, response, format, args);
+		va_end(args);
+		return entry != NULL;
+	}
+
+	/*
+	 * Same as queue() for commands answering with a "> " prompt, e.g. +CIPSEND, the data is
+	 * sent on the prompt. It is not copied and has to stay unchanged until the callback.
+	 */
+	bool queueData(TinyGsmAsyncCallback callback, void *context, uint32_t timeout,
+	               GsmConstStr response, const uint8_t *data, size_t len, const char *format, ...)
+	{
+		va_list args;
+		va_start(args, format);
+		Entry *entry = _add(callback, context, timeout, response, format, args);
+		va_end(args);
+		if (entry == NULL) {
+			return false;
+		}
+		entry->data = data;
+		entry->dataLen = len;
+		return true;
+	}
+
+	/*
+	 * Read and match what the modem sent, send the next command and check the timeout.
+	 * Returns after slice ms at the latest, or once there is nothing to read.
+	 */
+	void poll(uint8_t slice)
+	{
+		const uint32_t started = millis();
+		do {
+			if (_state == STATE_IDLE && _count > 0) {
+				_start();
+			}
+			if (_state != STATE_IDLE &&
+			        (uint32_t)(millis() - _started) >= _queue[_head].timeout) {
+				_lineLen = 0;
+				_line[0] = 0;
+				_finish(TINY_GSM_ASYNC_TIMEOUT);
+				continue;
+			}
+			if (stream.available() <= 0) {
+				return;
+			}
+			const int c = stream.read();
+			if (c > 0) {
+				_receive((char)c);
+			}
+		} while ((uint32_t)(millis() - started) < slice);
+	}
+
+	// Commands queued and not yet done, including the running one
+	uint8_t pending() const
+	{
+		return _count;
+	}
+
+	bool idle() const
+	{
+		return _count == 0;
+	}
+
+	// Forget all commands without calling back, e.g. after a reset of the modem
+	void clear()
+	{
+		_head = 0;
+		_count = 0;
+		_state = STATE_IDLE;
+		_lineLen = 0;
+		_line[0] = 0;
+		_overflow = false;
+	}
+
+public:
+	Stream&       stream;
+
+protected:
+
+	struct Entry {
+		char command[TINY_GSM_ASYNC_CMD_SIZE];
+		const uint8_t *data;
+		size_t dataLen;
+		GsmConstStr response;
+		TinyGsmAsyncCallback callback;
+		void *context;
+		uint32_t timeout;
+	};
+
+	enum State {
+		STATE_IDLE,	// nothing sent
+		STATE_PROMPT,	// waiting for "> "
+		STATE_FINAL	// waiting for the final response
+	};
+
+	Entry *_add(TinyGsmAsyncCallback callback, void *context, uint32_t timeout,
+	            GsmConstStr response, const char *format, va_list args)
+	{
+		if (_count == TINY_GSM_ASYNC_QUEUE_SIZE) {
+			return NULL;
+		}
+		Entry *entry = &_queue[(_head + _count) % TINY_GSM_ASYNC_QUEUE_SIZE];
+		const int len = vsnprintf_P(entry->command, sizeof(entry->command), format, args);
+		if (len < 0 || len >= (int)sizeof(entry->command)) {
+			DBG("### Command too long");
+			return NULL;
+		}
+		entry->data = NULL;
+		entry->dataLen = 0;
+		entry->response = response ? response : GFP(GSM_ASYNC_OK);
+		entry->callback = callback;
+		entry->context = context;
+		entry->timeout = timeout;
+		_count++;
+		return entry;
+	}
+
+	void _start()
+	{
+		const Entry &entry = _queue[_head];
+		stream.print("AT");
+		stream.print(entry.command);
+		stream.print("\r\n");
+		_state = entry.data ? STATE_PROMPT : STATE_FINAL;
+		_started = millis();
+	}
+
+	void _finish(uint8_t result)
+	{
+		// the entry is released first, the callback can queue the next command
+		const Entry &entry = _queue[_head];
+		const TinyGsmAsyncCallback callback = entry.callback;
+		void *context = entry.context;
+		_head = (_head + 1) % TINY_GSM_ASYNC_QUEUE_SIZE;
+		_count--;
+		_state = STATE_IDLE;
+		if (callback) {
+			callback(context, result, _line);
+		}
+	}
+
+	void _receive(char c)
+	{
+		if (c == '\r') {
+			return;
+		}
+		if (c == '\n') {
+			if (_lineLen > 0 && !_overflow) {
+				_line[_lineLen] = 0;
+				_dispatch();
+			}
+			_lineLen = 0;
+			_overflow = false;
+			return;
+		}
+		if (_lineLen == 0 && c == ' ') {
+			// leading blanks, e.g. after the prompt
+			return;
+		}
+		if (_state == STATE_PROMPT && _lineLen == 0 && c == '>') {
+			const Entry &entry = _queue[_head];
+			stream.write(entry.data, entry.dataLen);
+			_state = STATE_FINAL;
+			return;
+		}
+		if (_lineLen < TINY_GSM_ASYNC_LINE_SIZE - 1) {
+			_line[_lineLen++] = c;
+		} else if (!_overflow) {
+			_overflow = true;
+			DBG("### Line too long");
+		}
+	}
+
+	void _dispatch()
+	{
+		// unsolicited result codes first, they can arrive in the middle of a command
+		if (_urcHandler && _urcHandler(_urcContext, _line)) {
+			return;
+		}
+		if (_state != STATE_IDLE) {
+			if (_startsWith(_line, _queue[_head].response)) {
+				_finish(TINY_GSM_ASYNC_OK);
+				return;
+			}
+			if (_startsWith(_line, GFP(GSM_ASYNC_ERROR)) || _startsWith(_line, GFP(GSM_ASYNC_CME_ERROR)) ||
+			        _startsWith(_line, GFP(GSM_ASYNC_CMS_ERROR))) {
+				_finish(TINY_GSM_ASYNC_ERROR);
+				return;
+			}
+		}
+		if (_state != STATE_IDLE && _queue[_head].callback) {
+			_queue[_head].callback(_queue[_head].context, TINY_GSM_ASYNC_LINE, _line);
+		} else {
+			DBG("### Unhandled:", _line);
+		}
+	}
+
+	static bool _startsWith(const char *line, GsmConstStr prefix)
+	{
+#if defined(__AVR__)
+		const char *p = reinterpret_cast<const char *>(prefix);
+		return strncmp_P(line, p, strlen_P(p)) == 0;
+#else
+		return strncmp(line, prefix, strlen(prefix)) == 0;
+#endif
+	}
+
+	Entry         _queue[TINY_GSM_ASYNC_QUEUE_SIZE];
+	uint8_t       _head;
+	uint8_t       _count;
+	State         _state;
+	uint32_t      _started;
+	char          _line[TINY_GSM_ASYNC_LINE_SIZE];
+	uint8_t       _lineLen;
+	bool          _overflow;
+	TinyGsmAsyncUrcHandler _urcHandler;
+	void          *_urcContext;
+};
+
+#endif
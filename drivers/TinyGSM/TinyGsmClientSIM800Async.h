@@ -0,0 +1,645 @@
+/**
+ * file       TinyGsmClientSIM800Async.h
+ * license    LGPL-3.0
+ *
+ * Non-blocking variant of TinyGsmClientSIM800.h on top of TinyGsmAsync: the modem is brought
+ * up by a state machine and the sockets exchange their data in the background, loop() runs
+ * it in time slices. Works for the SIM800, SIM900, SIM808 and SIM868.
+ */
+
+#ifndef TinyGsmClientSIM800Async_h
+#define TinyGsmClientSIM800Async_h
+
+//#define TINY_GSM_DEBUG Serial
+
+#if !defined(TINY_GSM_RX_BUFFER)
+#define TINY_GSM_RX_BUFFER 64
+#endif
+
+#if !defined(TINY_GSM_TX_BUFFER)
+#define TINY_GSM_TX_BUFFER 128
+#endif
+
+// time slice of the client calls in ms
+#if !defined(TINY_GSM_ASYNC_SLICE)
+#define TINY_GSM_ASYNC_SLICE 1
+#endif
+
+// delay before the bring-up starts over after a failed step in ms
+#if !defined(TINY_GSM_ASYNC_RETRY)
+#define TINY_GSM_ASYNC_RETRY 5000ul
+#endif
+
+#define TINY_GSM_MUX_COUNT 5
+
+#include "TinyGsmAsync.h"
+
+// The data is read as hex, the largest chunk that fits a line
+#define TINY_GSM_ASYNC_READ_CHUNK ((TINY_GSM_ASYNC_LINE_SIZE - 1) / 2)
+
+static const char GSM_ASYNC_ANY[] TINY_GSM_PROGMEM = "";
+static const char GSM_ASYNC_SHUT_OK[] TINY_GSM_PROGMEM = "SHUT OK";
+static const char GSM_ASYNC_DATA_ACCEPT[] TINY_GSM_PROGMEM = "DATA ACCEPT:";
+
+class TinyGsmSim800Async
+{
+
+public:
+
+	class GsmClient : public Client
+	{
+		friend class TinyGsmSim800Async;
+		typedef TinyGsmFifo<uint8_t, TINY_GSM_RX_BUFFER> RxFifo;
+
+	public:
+		GsmClient() {}
+
+		GsmClient(TinyGsmSim800Async& modem, uint8_t mux = 1)
+		{
+			init(&modem, mux);
+		}
+
+		bool init(TinyGsmSim800Async* modem, uint8_t mux = 1)
+		{
+			this->at = modem;
+			this->mux = mux;
+			sock_state = SOCK_CLOSED;
+			sock_available = 0;
+			prev_check = 0;
+			got_data = false;
+			rx_pending = false;
+			rx_expect = 0;
+			tx_len = 0;
+			tx_sending = 0;
+
+			at->sockets[mux] = this;
+
+			return true;
+		}
+
+	public:
+		/*
+		 * Starts the connection and returns 0 while it is pending, 1 once it is up and
+		 * -1 if it failed. Keep calling it while connecting() is true.
+		 */
+		virtual int connect(const char *host, uint16_t port)
+		{
+			at->loop(TINY_GSM_ASYNC_SLICE);
+			switch (sock_state) {
+			case SOCK_CONNECTING:
+				return 0;
+			case SOCK_OPENED:
+				sock_state = SOCK_CONNECTED;
+				return 1;
+			case SOCK_FAILED:
+				sock_state = SOCK_CLOSED;
+				return -1;
+			case SOCK_CONNECTED:
+				stop();
+				break;
+			default:
+				break;
+			}
+			_clear();
+			if (!at->modemConnect(host, port, mux)) {
+				return -1;
+			}
+			sock_state = SOCK_CONNECTING;
+			connect_started = millis();
+			return 0;
+		}
+
+		virtual int connect(IPAddress ip, uint16_t port)
+		{
+			char host[16];
+			(void)snprintf_P(host, sizeof(host), PSTR("%u.%u.%u.%u"), ip[0], ip[1], ip[2], ip[3]);
+			return connect(host, port);
+		}
+
+		bool connecting()
+		{
+			return sock_state == SOCK_CONNECTING || sock_state == SOCK_OPENED;
+		}
+
+		virtual void stop()
+		{
+			if (sock_state != SOCK_CLOSED) {
+				// a full queue leaves it to the server or the next CIPSTART
+				(void)at->modemClose(mux);
+			}
+			sock_state = SOCK_CLOSED;
+			_clear();
+		}
+
+		// Takes what fits the transmit buffer, it is sent in the background
+		virtual size_t write(const uint8_t *buf, size_t size)
+		{
+			if (sock_state != SOCK_CONNECTED) {
+				return 0;
+			}
+			const size_t len = TinyGsmMin(size, (size_t)(TINY_GSM_TX_BUFFER - tx_len));
+			(void)memcpy(&tx[tx_len], buf, len);
+			tx_len += len;
+			at->loop(TINY_GSM_ASYNC_SLICE);
+			return len;
+		}
+
+		virtual size_t write(uint8_t c)
+		{
+			return write(&c, 1);
+		}
+
+		virtual int available()
+		{
+			at->loop(TINY_GSM_ASYNC_SLICE);
+			if (!rx.size() && sock_state == SOCK_CONNECTED) {
+				// Workaround: sometimes SIM800 forgets to notify about data arrival.
+				if (millis() - prev_check > 500) {
+					got_data = true;
+					prev_check = millis();
+				}
+			}
+			return rx.size();
+		}
+
+		virtual int read(uint8_t *buf, size_t size)
+		{
+			at->loop(TINY_GSM_ASYNC_SLICE);
+			return rx.get(buf, TinyGsmMin(size, rx.size()));
+		}
+
+		virtual int read()
+		{
+			uint8_t c;
+			if (read(&c, 1) == 1) {
+				return c;
+			}
+			return -1;
+		}
+
+		virtual int peek()
+		{
+			at->loop(TINY_GSM_ASYNC_SLICE);
+			uint8_t c;
+			if (rx.peek(&c)) {
+				return c;
+			}
+			return -1;
+		}
+
+		// Nothing to wait for, the data goes out from loop()
+		virtual void flush() {}
+
+		virtual uint8_t connected()
+		{
+			return sock_state == SOCK_CONNECTED || rx.size() > 0;
+		}
+		virtual operator bool()
+		{
+			return connected();
+		}
+
+	private:
+		enum SockState {
+			SOCK_CLOSED,
+			SOCK_CONNECTING,	// CIPSTART sent
+			SOCK_OPENED,		// CONNECT OK, connect() did not return 1 yet
+			SOCK_CONNECTED,
+			SOCK_FAILED		// connect() did not return -1 yet
+		};
+
+		void _clear()
+		{
+			rx.clear();
+			sock_available = 0;
+			got_data = false;
+			// late callbacks of the previous connection are ignored
+			rx_pending = false;
+			rx_expect = 0;
+			tx_len = 0;
+			tx_sending = 0;
+		}
+
+		TinyGsmSim800Async* at;
+		uint8_t       mux;
+		SockState     sock_state;
+		uint16_t      sock_available;
+		uint32_t      prev_check;
+		uint32_t      connect_started;
+		bool          got_data;
+		bool          rx_pending;	// CIPRXGET queued
+		uint8_t       rx_expect;	// bytes in the next hex line
+		RxFifo        rx;
+		uint8_t       tx[TINY_GSM_TX_BUFFER];
+		uint16_t      tx_len;
+		uint16_t      tx_sending;	// CIPSEND queued for the first tx_sending bytes
+	};
+
+public:
+
+	explicit TinyGsmSim800Async(Stream& stream)
+		: at(stream)
+	{
+		memset(sockets, 0, sizeof(sockets));
+		at.setUrcHandler(_onUrc, this);
+		_step = STEP_IDLE;
+		_wait = 0;
+		_waitStart = 0;
+		_ready = false;
+		_registered = false;
+		_looping = false;
+		_apn = NULL;
+		_user = NULL;
+		_pwd = NULL;
+		_pin = NULL;
+		_ip[0] = 0;
+	}
+
+	/*
+	 * Start the bring-up: restart, SIM unlock, network registration and GPRS. The strings
+	 * are not copied, user, pwd and pin can be NULL.
+	 */
+	void begin(const char* apn, const char* user = NULL, const char* pwd = NULL,
+	           const char* pin = NULL)
+	{
+		_apn = apn;
+		_user = user ? user : "";
+		_pwd = pwd ? pwd : "";
+		_pin = pin;
+		at.clear();
+		_ready = false;
+		_goto(STEP_RESET, 0);
+	}
+
+	// Run the modem for up to slice ms, never blocks on a response
+	void loop(uint8_t slice)
+	{
+		if (_looping) {
+			return;
+		}
+		_looping = true;
+		at.poll(slice);
+		_run();
+		_looping = false;
+	}
+
+	// GPRS is up and sockets can connect
+	bool isReady() const
+	{
+		return _ready;
+	}
+
+	const char *getLocalIP() const
+	{
+		return _ip;
+	}
+
+protected:
+
+	enum Step {
+		STEP_IDLE,	// begin() not called
+		STEP_RESET,	// full functionality and reboot
+		STEP_PROBE,	// until the modem answers AT
+		STEP_ECHO,
+		STEP_PIN,
+		STEP_REGISTER,	// until registered at home or roaming
+		STEP_SHUT,
+		STEP_ATTACH,
+		STEP_MUX,
+		STEP_QSEND,
+		STEP_RXGET,
+		STEP_APN,
+		STEP_BRINGUP,
+		STEP_IP,
+		STEP_DNS,
+		STEP_READY
+	};
+
+	bool modemConnect(const char* host, uint16_t port, uint8_t mux)
+	{
+		if (!_ready) {
+			return false;
+		}
+		// OK only acknowledges the command, the result is an URC
+		return at.queue(_onConnect, sockets[mux], 10000L, NULL, PSTR("+CIPSTART=%u,\"TCP\",\"%s\",%u"),
+		                mux, host, port);
+	}
+
+	bool modemClose(uint8_t mux)
+	{
+		if (!_ready) {
+			return false;
+		}
+		// answers "<mux>, CLOSE OK" instead of OK
+		return at.queue(NULL, NULL, 5000L, GFP(GSM_ASYNC_ANY), PSTR("+CIPCLOSE=%u,1"), mux);
+	}
+
+	void _run()
+	{
+		if (_step != STEP_READY) {
+			if (_step != STEP_IDLE && at.idle() && (uint32_t)(millis() - _waitStart) >= _wait) {
+				_issue();
+			}
+			return;
+		}
+		for (uint8_t mux = 0; mux < TINY_GSM_MUX_COUNT; mux++) {
+			GsmClient* sock = sockets[mux];
+			if (!sock) {
+				continue;
+			}
+			if (sock->sock_state == GsmClient::SOCK_CONNECTING &&
+			        millis() - sock->connect_started > 75000L) {
+				sock->sock_state = GsmClient::SOCK_FAILED;
+			}
+			if (sock->sock_state != GsmClient::SOCK_CONNECTED) {
+				continue;
+			}
+			if (!sock->tx_sending && sock->tx_len > 0 &&
+			        at.queueData(_onSend, sock, 10000L, GFP(GSM_ASYNC_DATA_ACCEPT), sock->tx, sock->tx_len,
+			                     PSTR("+CIPSEND=%u,%u"), mux, sock->tx_len)) {
+				sock->tx_sending = sock->tx_len;
+			}
+			const size_t space = TinyGsmMin((size_t)sock->rx.free(), (size_t)TINY_GSM_ASYNC_READ_CHUNK);
+			if (!sock->rx_pending && (sock->got_data || sock->sock_available > 0) && space > 0 &&
+			        at.queue(_onRead, sock, 5000L, NULL, PSTR("+CIPRXGET=3,%u,%u"), mux, (unsigned)space)) {
+				sock->got_data = false;
+				sock->rx_pending = true;
+			}
+		}
+	}
+
+	void _issue()
+	{
+		switch (_step) {
+		case STEP_RESET:
+			(void)at.queue(_onStep, this, 10000L, NULL, PSTR("+CFUN=1,1"));
+			break;
+		case STEP_PROBE:
+			(void)at.queue(_onStep, this, 200L, NULL, PSTR(""));
+			break;
+		case STEP_ECHO:
+			(void)at.queue(_onStep, this, 1000L, NULL, PSTR("E0"));
+			break;
+		case STEP_PIN:
+			(void)at.queue(_onStep, this, 5000L, NULL, PSTR("+CPIN=\"%s\""), _pin);
+			break;
+		case STEP_REGISTER:
+			_registered = false;
+			(void)at.queue(_onStep, this, 1000L, NULL, PSTR("+CREG?"));
+			break;
+		case STEP_SHUT:
+			(void)at.queue(_onStep, this, 65000L, GFP(GSM_ASYNC_SHUT_OK), PSTR("+CIPSHUT"));
+			break;
+		case STEP_ATTACH:
+			(void)at.queue(_onStep, this, 60000L, NULL, PSTR("+CGATT=1"));
+			break;
+		case STEP_MUX:
+			(void)at.queue(_onStep, this, 1000L, NULL, PSTR("+CIPMUX=1"));
+			break;
+		case STEP_QSEND:
+			// "quick send", DATA ACCEPT instead of waiting for SEND OK
+			(void)at.queue(_onStep, this, 1000L, NULL, PSTR("+CIPQSEND=1"));
+			break;
+		case STEP_RXGET:
+			// get data manually
+			(void)at.queue(_onStep, this, 1000L, NULL, PSTR("+CIPRXGET=1"));
+			break;
+		case STEP_APN:
+			(void)at.queue(_onStep, this, 60000L, NULL, PSTR("+CSTT=\"%s\",\"%s\",\"%s\""), _apn, _user,
+			                  _pwd);
+			break;
+		case STEP_BRINGUP:
+			(void)at.queue(_onStep, this, 60000L, NULL, PSTR("+CIICR"));
+			break;
+		case STEP_IP:
+			// the address is only assigned after the bring-up, E0 adds an OK
+			_ip[0] = 0;
+			(void)at.queue(_onStep, this, 10000L, NULL, PSTR("+CIFSR;E0"));
+			break;
+		case STEP_DNS:
+			(void)at.queue(_onStep, this, 1000L, NULL, PSTR("+CDNSCFG=\"8.8.8.8\",\"8.8.4.4\""));
+			break;
+		default:
+			break;
+		}
+	}
+
+	void _goto(Step step, uint32_t wait)
+	{
+		_step = step;
+		_wait = wait;
+		_waitStart = millis();
+	}
+
+	void _stepDone(uint8_t result)
+	{
+		const bool ok = result == TINY_GSM_ASYNC_OK;
+		switch (_step) {
+		case STEP_RESET:
+			// the answer is lost if the modem was not up yet
+			_goto(STEP_PROBE, 3000L);
+			break;
+		case STEP_PROBE:
+			if (ok) {
+				_goto(STEP_ECHO, 0);
+			} else {
+				_goto(STEP_PROBE, 100L);
+			}
+			break;
+		case STEP_ECHO:
+			_goto(ok ? (_pin ? STEP_PIN : STEP_REGISTER) : STEP_PROBE, 0);
+			break;
+		case STEP_PIN:
+			// fails if the SIM is unlocked already
+			_goto(STEP_REGISTER, 0);
+			break;
+		case STEP_REGISTER:
+			if (ok && _registered) {
+				_goto(STEP_SHUT, 0);
+			} else {
+				_goto(STEP_REGISTER, 250L);
+			}
+			break;
+		case STEP_DNS:
+			if (ok) {
+				DBG("### GPRS up:", _ip);
+				_step = STEP_READY;
+				_ready = true;
+			} else {
+				_fail();
+			}
+			break;
+		default:
+			if (ok) {
+				_goto((Step)(_step + 1), 0);
+			} else {
+				_fail();
+			}
+			break;
+		}
+	}
+
+	void _fail()
+	{
+		DBG("### Bring-up failed:", (int)_step);
+		_goto(STEP_REGISTER, TINY_GSM_ASYNC_RETRY);
+	}
+
+	void _lost()
+	{
+		DBG("### GPRS lost");
+		_ready = false;
+		for (uint8_t mux = 0; mux < TINY_GSM_MUX_COUNT; mux++) {
+			GsmClient* sock = sockets[mux];
+			if (sock && sock->sock_state != GsmClient::SOCK_CLOSED) {
+				sock->sock_state = sock->connecting() ? GsmClient::SOCK_FAILED : GsmClient::SOCK_CLOSED;
+			}
+		}
+		_goto(STEP_REGISTER, 0);
+	}
+
+	static void _onStep(void *context, uint8_t result, const char *line)
+	{
+		TinyGsmSim800Async *modem = static_cast<TinyGsmSim800Async *>(context);
+		if (result != TINY_GSM_ASYNC_LINE) {
+			modem->_stepDone(result);
+		} else if (modem->_step == STEP_REGISTER && !strncmp_P(line, PSTR("+CREG:"), 6)) {
+			// +CREG: <n>,<stat>, home (1) or roaming (5)
+			const char *stat = strchr(line, ',');
+			modem->_registered = stat && (stat[1] == '1' || stat[1] == '5');
+		} else if (modem->_step == STEP_IP && isdigit(line[0])) {
+			(void)strncpy(modem->_ip, line, sizeof(modem->_ip) - 1);
+			modem->_ip[sizeof(modem->_ip) - 1] = 0;
+		}
+	}
+
+	static void _onConnect(void *context, uint8_t result, const char *line)
+	{
+		(void)line;
+		GsmClient *sock = static_cast<GsmClient *>(context);
+		if (result != TINY_GSM_ASYNC_LINE && result != TINY_GSM_ASYNC_OK &&
+		        sock->sock_state == GsmClient::SOCK_CONNECTING) {
+			sock->sock_state = GsmClient::SOCK_FAILED;
+		}
+	}
+
+	static void _onSend(void *context, uint8_t result, const char *line)
+	{
+		(void)line;
+		GsmClient *sock = static_cast<GsmClient *>(context);
+		if (result == TINY_GSM_ASYNC_LINE || !sock->tx_sending) {
+			return;
+		}
+		if (result == TINY_GSM_ASYNC_OK) {
+			// written meanwhile goes to the front
+			sock->tx_len -= sock->tx_sending;
+			(void)memmove(sock->tx, &sock->tx[sock->tx_sending], sock->tx_len);
+			sock->tx_sending = 0;
+			return;
+		}
+		DBG("### Send failed:", sock->mux);
+		(void)sock->at->modemClose(sock->mux);
+		sock->sock_state = GsmClient::SOCK_CLOSED;
+		sock->tx_len = 0;
+		sock->tx_sending = 0;
+	}
+
+	static void _onRead(void *context, uint8_t result, const char *line)
+	{
+		GsmClient *sock = static_cast<GsmClient *>(context);
+		if (!sock->rx_pending) {
+			return;
+		}
+		if (result != TINY_GSM_ASYNC_LINE) {
+			if (result != TINY_GSM_ASYNC_OK) {
+				sock->sock_available = 0;
+			}
+			sock->rx_pending = false;
+			sock->rx_expect = 0;
+			return;
+		}
+		if (!strncmp_P(line, PSTR("+CIPRXGET: 3,"), 13)) {
+			// +CIPRXGET: 3,<mux>,<len>,<left>
+			const char *p = strchr(line + 13, ',');
+			if (p) {
+				sock->rx_expect = (uint8_t)atoi(p + 1);
+				p = strchr(p + 1, ',');
+				sock->sock_available = p ? (uint16_t)atoi(p + 1) : 0;
+			}
+			return;
+		}
+		for (; sock->rx_expect > 0 && isxdigit(line[0]) && isxdigit(line[1]); line += 2) {
+			(void)sock->rx.put((uint8_t)((_hexValue(line[0]) << 4) | _hexValue(line[1])));
+			sock->rx_expect--;
+		}
+		sock->rx_expect = 0;
+	}
+
+	static bool _onUrc(void *context, const char *line)
+	{
+		TinyGsmSim800Async *modem = static_cast<TinyGsmSim800Async *>(context);
+		if (!strncmp_P(line, PSTR("+CIPRXGET: 1,"), 13)) {
+			const int mux = atoi(line + 13);
+			if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && modem->sockets[mux]) {
+				modem->sockets[mux]->got_data = true;
+			}
+			return true;
+		}
+		if (!strncmp_P(line, PSTR("+PDP: DEACT"), 11)) {
+			modem->_lost();
+			return true;
+		}
+		// <mux>, CONNECT OK | CONNECT FAIL | ALREADY CONNECT | CLOSED
+		if (!isdigit(line[0]) || line[1] != ',' || line[2] != ' ') {
+			return false;
+		}
+		const int mux = line[0] - '0';
+		GsmClient *sock = mux < TINY_GSM_MUX_COUNT ? modem->sockets[mux] : NULL;
+		const char *event = line + 3;
+		if (!strcmp_P(event, PSTR("CONNECT OK")) || !strcmp_P(event, PSTR("ALREADY CONNECT"))) {
+			if (sock && sock->sock_state == GsmClient::SOCK_CONNECTING) {
+				sock->sock_state = GsmClient::SOCK_OPENED;
+			}
+			return true;
+		}
+		if (!strcmp_P(event, PSTR("CONNECT FAIL"))) {
+			if (sock && sock->sock_state == GsmClient::SOCK_CONNECTING) {
+				sock->sock_state = GsmClient::SOCK_FAILED;
+			}
+			return true;
+		}
+		if (!strcmp_P(event, PSTR("CLOSED"))) {
+			if (sock && sock->sock_state != GsmClient::SOCK_CLOSED) {
+				sock->sock_state = sock->connecting() ? GsmClient::SOCK_FAILED : GsmClient::SOCK_CLOSED;
+			}
+			DBG("### Closed: ", mux);
+			return true;
+		}
+		// CLOSE OK ends the CIPCLOSE
+		return false;
+	}
+
+	static uint8_t _hexValue(char c)
+	{
+		return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+	}
+
+public:
+	TinyGsmAsync  at;
+
+protected:
+	GsmClient*    sockets[TINY_GSM_MUX_COUNT];
+	Step          _step;
+	uint32_t      _wait;
+	uint32_t      _waitStart;
+	bool          _ready;
+	bool          _registered;
+	bool          _looping;
+	const char*   _apn;
+	const char*   _user;
+	const char*   _pwd;
+	const char*   _pin;
+	char          _ip[16];
+};
+
+#endif
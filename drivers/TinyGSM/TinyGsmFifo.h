@@ -105,6 +105,17 @@ public:
 		return true;
 	}
 
+	// like get(), but the element stays in the buffer
+	bool peek(T* p)
+	{
+		int r = _r;
+		if (r == _w) { // !readable()
+			return false;
+		}
+		*p = _b[r];
+		return true;
+	}
+
 	int get(T* p, int n, bool t = false)
 	{
 		int c = n;
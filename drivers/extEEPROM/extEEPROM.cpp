@@ -79,6 +79,7 @@ extEEPROM::extEEPROM(eeprom_size_t deviceCapacity, byte nDevice, unsigned int pa
 	_nDevice = nDevice;
 	_pageSize = pageSize;
 	_eepromAddr = eepromAddr;
+	_pendingCtrl = 0;
 	_totalCapacity = _nDevice * _dvcCapacity * 1024UL / 8;
 	_nAddrBytes = deviceCapacity > kbits_16 ? 2 :
 	              1;       //two address bytes needed for eeproms > 16kbits
@@ -130,6 +131,10 @@ byte extEEPROM::write(unsigned long addr, byte *values, unsigned int nBytes)
 	}
 
 	while (nBytes > 0) {
+		txStatus = waitReady();
+		if (txStatus != 0) {
+			return txStatus;
+		}
 		const uint16_t nPage = _pageSize - ( addr & (_pageSize - 1) );
 		//find min(nBytes, nPage, BUFFER_LENGTH) -- BUFFER_LENGTH is defined in the Wire library.
 		uint16_t nWrite = nBytes < nPage ? nBytes : nPage;
@@ -145,23 +150,8 @@ byte extEEPROM::write(unsigned long addr, byte *values, unsigned int nBytes)
 		if (txStatus != 0) {
 			return txStatus;
 		}
-
-		//wait up to 50ms for the write to complete
-		for (uint8_t i=100; i; --i) {
-			delayMicroseconds(500);                     //no point in waiting too fast
-			communication->beginTransmission(ctrlByte);
-			if (_nAddrBytes == 2) {
-				communication->write((byte)0);    //high addr byte
-			}
-			communication->write((byte)0);                              //low addr byte
-			txStatus = communication->endTransmission();
-			if (txStatus == 0) {
-				break;
-			}
-		}
-		if (txStatus != 0) {
-			return txStatus;
-		}
+		//the write cycle is awaited before the next access
+		_pendingCtrl = ctrlByte;
 
 		addr += nWrite;         //increment the EEPROM address
 		values += nWrite;       //increment the input data pointer
@@ -180,6 +170,11 @@ byte extEEPROM::read(unsigned long addr, byte *values, unsigned int nBytes)
 		return EEPROM_ADDR_ERR;             //yes, tell the caller
 	}
 
+	const byte txStatus = waitReady();
+	if (txStatus != 0) {
+		return txStatus;
+	}
+
 	while (nBytes > 0) {
 		const uint16_t nPage = _pageSize - ( addr & (_pageSize - 1) );
 		uint16_t nRead = nBytes < nPage ? nBytes : nPage;
@@ -255,3 +250,27 @@ unsigned long extEEPROM::length( void )
 {
 	return _totalCapacity * 8;
 }
+
+byte extEEPROM::waitReady(void)
+{
+	if (!_pendingCtrl) {
+		return 0;
+	}
+	//ACK polling: the device does not acknowledge while it writes, wait up to 50ms
+	byte txStatus;
+	const unsigned long started = micros();
+	do {
+		communication->beginTransmission(_pendingCtrl);
+		if (_nAddrBytes == 2) {
+			communication->write((byte)0);    //high addr byte
+		}
+		communication->write((byte)0);                              //low addr byte
+		txStatus = communication->endTransmission();
+		if (txStatus == 0) {
+			_pendingCtrl = 0;
+			break;
+		}
+		delayMicroseconds(50);
+	} while (micros() - started < 50000ul);
+	return txStatus;
+}
@@ -58,6 +58,10 @@
 /*
  * tekka 2018:
  * Re-implementing extEEPROM::update(unsigned long addr, byte value);
+ *
+ * 2019:
+ * The write cycle is awaited by ACK polling before the next access instead of
+ * after each write, the caller can go on meanwhile. 1MHz clock for Fm+ chips.
  */
 #ifndef extEEPROM_h
 #define extEEPROM_h
@@ -96,7 +100,8 @@ public:
 	*/
 	enum twiClockFreq_t {
 		twiClock100kHz = 100000,  //!< twiClock100kHz
-		twiClock400kHz = 400000   //!< twiClock400kHz
+		twiClock400kHz = 400000,  //!< twiClock400kHz
+		twiClock1000kHz = 1000000 //!< twiClock1000kHz, Fm+ EEPROMs only (e.g. 24FC256)
 	};
 	/**
 	* @brief Constructor
@@ -117,6 +122,7 @@ public:
 	byte update(unsigned long addr, byte *values, unsigned int nBytes);	//!< update()
 	byte update(unsigned long addr, byte value);	//!< update()
 	unsigned long length();	//!< length()
+	byte waitReady();	//!< wait for a pending write cycle, 0 when ready
 
 private:
 	uint8_t _eepromAddr;            //eeprom i2c address
@@ -126,6 +132,7 @@ private:
 	uint8_t _csShift;               //number of bits to shift address for chip select bits in control byte
 	uint16_t _nAddrBytes;           //number of address bytes (1 or 2)
 	unsigned long _totalCapacity;   //capacity of all EEPROM devices on the bus, in bytes
+	uint8_t _pendingCtrl;           //control byte of the device in a write cycle, 0 if none
 };
 
 #endif
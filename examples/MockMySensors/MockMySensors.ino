@@ -37,6 +37,9 @@
 
 #define MY_NODE_ID 254
 
+// Enable signing of the load generator traffic
+//#define MY_SIGNING_SIMPLE_PASSWD "MockMySensors"
+
 #include <MySensors.h>
 
 #define RADIO_ERROR_LED_PIN 4  // Error led pin
@@ -103,6 +106,16 @@
 //
 //#define ID_S_CUSTOM            99
 
+// Load generator mode for gateway soak tests: instead of the mock sensors above, emulate
+// MOCK_LOAD_NODES virtual nodes that send at a fixed rate and report throughput and losses
+//#define MOCK_LOAD_GENERATOR
+#define MOCK_LOAD_NODES           16     // number of virtual node ids
+#define MOCK_LOAD_FIRST_NODE_ID   100    // first virtual node id
+#define MOCK_LOAD_RATE            50     // messages per second, set it above the link capacity to saturate it
+#define MOCK_LOAD_BURST           1      // messages sent back to back per time slot
+#define MOCK_LOAD_MIX             { 40, 20, 20, 10, 10 } // weights: float, int, bool, string, custom
+#define MOCK_LOAD_REPORT_INTERVAL 10000  // milliseconds between reports
+
 
 
 // Global Vars
@@ -352,6 +365,17 @@ MyMessage msg_S_CUSTOM_5(ID_S_CUSTOM,V_VAR5);
 
 
 
+#ifdef MOCK_LOAD_GENERATOR
+static const uint8_t loadMix[5] = MOCK_LOAD_MIX;
+static uint32_t loadSent = 0;
+static uint32_t loadFailed = 0;
+static uint32_t loadSlot = 0;
+static uint32_t loadReportTime = 0;
+static uint32_t loadReportSent = 0;
+static uint8_t loadNode = 0;
+MyMessage msg_LOAD;
+#endif
+
 void setup()
 {
 	// Random SEED
@@ -580,10 +604,17 @@ void presentation()
 
 	Serial.println("________________");
 
+#ifdef MOCK_LOAD_GENERATOR
+	loadPresentation();
+#endif
 }
 
 void loop()
 {
+#ifdef MOCK_LOAD_GENERATOR
+	loadGenerator();
+	return;
+#endif
 	Serial.println("");
 	Serial.println("");
 	Serial.println("");
@@ -749,6 +780,105 @@ void receiveTime(uint32_t controllerTime)
 
 }
 
+#ifdef MOCK_LOAD_GENERATOR
+// Send msg_LOAD on behalf of a virtual node, i.e. as if it was forwarded by this node.
+// The node can only sign its own messages, so with signing all traffic uses the own node id.
+bool loadSend(const uint8_t node)
+{
+#if defined(MY_SIGNING_FEATURE)
+	(void)node;
+#else
+	msg_LOAD.sender = node;
+#endif
+	return _sendRoute(msg_LOAD);
+}
+
+void loadPresentation()
+{
+	Serial.println("Presenting virtual nodes");
+	for (uint8_t i = 0; i < MOCK_LOAD_NODES; i++) {
+		build(msg_LOAD, GATEWAY_ADDRESS, 1, C_PRESENTATION, S_CUSTOM).set("Load generator");
+		(void)loadSend(MOCK_LOAD_FIRST_NODE_ID + i);
+		wait(SHORT_WAIT);
+	}
+	loadReportTime = millis();
+}
+
+// Fill msg_LOAD with a payload type picked by the weights of MOCK_LOAD_MIX
+void loadPayload()
+{
+	uint16_t total = 0;
+	for (uint8_t i = 0; i < sizeof(loadMix); i++) {
+		total += loadMix[i];
+	}
+	int16_t pick = random(0, total);
+	uint8_t kind = 0;
+	while (kind < sizeof(loadMix) - 1 && (pick -= loadMix[kind]) >= 0) {
+		kind++;
+	}
+	msg_LOAD.clear();
+	build(msg_LOAD, GATEWAY_ADDRESS, 1, C_SET, V_TEMP);
+	switch (kind) {
+	case 0:
+		msg_LOAD.set(random(-200, 400) / 10.0f, 1);
+		break;
+	case 1:
+		msg_LOAD.setType(V_LEVEL).set((int16_t)random(-1000, 1000));
+		break;
+	case 2:
+		msg_LOAD.setType(V_STATUS).set((bool)random(0, 2));
+		break;
+	case 3:
+		msg_LOAD.setType(V_TEXT).set("MockMySensors load");
+		break;
+	default: {
+		uint8_t data[8];
+		for (uint8_t i = 0; i < sizeof(data); i++) {
+			data[i] = random(0, 256);
+		}
+		msg_LOAD.setType(V_CUSTOM).set(data, sizeof(data));
+	}
+	}
+}
+
+void loadGenerator()
+{
+	// send the bursts of all time slots due, loop() may be called less often than the rate
+	const uint32_t period = 1000000ul * MOCK_LOAD_BURST / MOCK_LOAD_RATE;
+	const uint32_t now = micros();
+	if ((int32_t)(now - loadSlot) > 1000000l) {
+		// more than a second behind, the rate cannot be reached: do not try to catch up
+		loadSlot = now;
+	}
+	while ((int32_t)(now - loadSlot) >= 0) {
+		for (uint8_t i = 0; i < MOCK_LOAD_BURST; i++) {
+			loadPayload();
+			if (!loadSend(MOCK_LOAD_FIRST_NODE_ID + loadNode)) {
+				loadFailed++;
+			}
+			loadSent++;
+			loadNode = (loadNode + 1) % MOCK_LOAD_NODES;
+		}
+		loadSlot += period;
+	}
+
+	const uint32_t elapsed = millis() - loadReportTime;
+	if (elapsed >= MOCK_LOAD_REPORT_INTERVAL) {
+		Serial.print("Load: sent=");
+		Serial.print(loadSent);
+		Serial.print(" failed=");
+		Serial.print(loadFailed);
+		Serial.print(" loss=");
+		Serial.print(loadSent ? 100.0f * loadFailed / loadSent : 0.0f, 2);
+		Serial.print("% rate=");
+		Serial.print(1000.0f * (loadSent - loadReportSent) / elapsed, 1);
+		Serial.println(" msg/s");
+		loadReportSent = loadSent;
+		loadReportTime += elapsed;
+	}
+}
+#endif
+
 //void door(){}
 
 #ifdef ID_S_DOOR
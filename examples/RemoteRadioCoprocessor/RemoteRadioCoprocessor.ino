@@ -0,0 +1,56 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ *******************************
+ *
+ * DESCRIPTION
+ *
+ * Radio coprocessor of a Linux gateway without SPI, e.g. a server or a VM. Attach it to
+ * a (USB) serial port of the host and build the gateway with
+ * ./configure --my-transport=remote --my-remote-serial-port=/dev/ttyACM0
+ *
+ * The gateway runs the transport, this sketch runs the radio: it sends the frames of the
+ * gateway with ACK and retries, and forwards the received frames in batches.
+ * Use the radio options of the network, e.g. the channel and the encryption.
+ *
+ */
+// load core modules only, the gateway runs the transport
+#define MY_CORE_ONLY
+
+// Enable and select radio type attached
+#define MY_RADIO_RF24
+//#define MY_RADIO_NRF5_ESB
+//#define MY_RADIO_RFM69
+//#define MY_RADIO_RFM95
+
+#define MY_RADIO_REMOTE_COPROCESSOR
+// Serial port and baud rate of the link to the gateway
+//#define MY_RADIO_REMOTE_SERIAL Serial
+//#define MY_RADIO_REMOTE_BAUD_RATE (115200ul)
+
+#include <MySensors.h>
+
+void setup()
+{
+	remoteRadioBegin();
+}
+
+void loop()
+{
+	remoteRadioProcess();
+}
@@ -0,0 +1,602 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// Microbenchmarks of the core hot paths, built with the configured flags by "make bench".
+//
+// Each benchmark runs until MYBENCH_MIN_TIME_MS (default 200) have passed and reports the time,
+// throughput and heap allocations per operation. Benchmarks with setup work per operation time
+// each operation on its own and report the latency percentiles as well. Set MYBENCH_FORMAT=json
+// for machine readable output and MYBENCH_FILTER=<text> to run only the benchmarks whose name
+// contains the text.
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+
+// core functions without the gateway and radio running
+#define MY_CORE_ONLY
+
+// the protocol functions are part of the gateway
+#if !defined(MY_GATEWAY_LINUX) && !defined(MY_GATEWAY_SERIAL)
+#define MY_GATEWAY_LINUX
+#endif
+
+// signing needs a sensor network, the simulated radio needs no hardware
+#if !defined(MY_RADIO_RF24) && !defined(MY_RADIO_RFM69) && !defined(MY_RADIO_RFM95) && \
+	!defined(MY_RS485) && !defined(MY_RADIO_SIMULATED)
+#define MY_RADIO_SIMULATED
+#endif
+#if !defined(MY_SIGNING_SOFT) && !defined(MY_SIGNING_SIMPLE_PASSWD)
+#define MY_SIGNING_SIMPLE_PASSWD "mybenchmark"
+#endif
+// signerVerifyMsg() only verifies when signatures are required
+#if !defined(MY_SIGNING_REQUEST_SIGNATURES)
+#define MY_SIGNING_REQUEST_SIGNATURES
+#endif
+
+#include <MySensors.h>
+#include "drivers/CircularBuffer/CircularBuffer.h"
+
+extern "C" {
+	void *__libc_malloc(size_t size);
+	void *__libc_calloc(size_t count, size_t size);
+	void *__libc_realloc(void *ptr, size_t size);
+}
+
+static volatile uint32_t _benchAllocs = 0;
+static volatile uint32_t _benchSink = 0;
+
+// count the heap allocations of the benchmarks, new and delete end up here as well
+extern "C" void *malloc(size_t size)
+{
+	_benchAllocs++;
+	return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+	_benchAllocs++;
+	return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+	_benchAllocs++;
+	return __libc_realloc(ptr, size);
+}
+
+typedef void (*benchFunction_t)(const uint32_t iterations);
+
+typedef struct {
+	const char *name;
+	benchFunction_t run;
+} bench_t;
+
+static uint64_t benchNanos(void)
+{
+	struct timespec now;
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+// latencies of the operations timed on their own, the most recent ones are kept
+#define BENCH_LATENCY_SAMPLES (65536u)
+static uint32_t _benchLatency[BENCH_LATENCY_SAMPLES];
+static uint32_t _benchLatencyCount = 0;
+static uint64_t _benchLatencyNanos = 0;
+
+static void benchLatency(const uint64_t start)
+{
+	const uint64_t nanos = benchNanos() - start;
+	_benchLatencyNanos += nanos;
+	_benchLatency[_benchLatencyCount++ % BENCH_LATENCY_SAMPLES] = (uint32_t)nanos;
+}
+
+static MyMessage _benchMsg;
+static char _benchLine[MY_GATEWAY_MAX_RECEIVE_LENGTH];
+static char _benchBuffer[MAX_PAYLOAD * 2 + 1];
+
+static const char _benchSerialLine[] = "12;6;1;0;0;36.5\n";
+
+static void benchSerial2MyMessage(const uint32_t iterations)
+{
+	for (uint32_t i = 0; i < iterations; i++) {
+		// parsed in place
+		(void)memcpy(_benchLine, _benchSerialLine, sizeof(_benchSerialLine));
+		_benchSink += protocolSerial2MyMessage(_benchMsg, _benchLine);
+	}
+}
+
+static void benchParseStream(const uint32_t iterations)
+{
+	// the characters as the gateways feed them, no line buffer
+	protocolParser_t parser;
+	protocolParserReset(parser);
+	for (uint32_t i = 0; i < iterations; i++) {
+		for (const char *c = _benchSerialLine; *c; c++) {
+			_benchSink += protocolParse(parser, _benchMsg, *c);
+		}
+	}
+}
+
+// the strtok_r/atoi parser protocolParse() replaced, kept as the reference
+static bool benchStrtokSerial2MyMessage(MyMessage &message, char *inputString)
+{
+	char *str, *p;
+	uint8_t index = 0;
+	uint8_t command = 0;
+	message.sender = GATEWAY_ADDRESS;
+	message.last = GATEWAY_ADDRESS;
+	mSetEcho(message, false);
+	for (str = strtok_r(inputString, ";", &p); str && index < 6; str = strtok_r(NULL, ";", &p)) {
+		switch (index) {
+		case 0:
+			message.destination = atoi(str);
+			break;
+		case 1:
+			message.sensor = atoi(str);
+			break;
+		case 2:
+			command = atoi(str);
+			mSetCommand(message, command);
+			break;
+		case 3:
+			mSetRequestEcho(message, atoi(str) ? 1 : 0);
+			break;
+		case 4:
+			message.type = atoi(str);
+			break;
+		case 5:
+			if (command == C_STREAM) {
+				uint8_t bvalue[MAX_PAYLOAD];
+				uint8_t blen = 0;
+				while (*str && blen < MAX_PAYLOAD) {
+					uint8_t val = convertH2I(*str++) << 4;
+					val += convertH2I(*str++);
+					bvalue[blen++] = val;
+				}
+				message.set(bvalue, blen);
+			} else {
+				const uint8_t lastCharacter = strlen(str) - 1;
+				if (str[lastCharacter] == '\r' || str[lastCharacter] == '\n') {
+					str[lastCharacter] = '\0';
+				}
+				message.set(str);
+			}
+			break;
+		}
+		index++;
+	}
+	return (index == 6);
+}
+
+static void benchSerial2MyMessageStrtok(const uint32_t iterations)
+{
+	for (uint32_t i = 0; i < iterations; i++) {
+		// strtok_r needs a writable copy
+		(void)memcpy(_benchLine, _benchSerialLine, sizeof(_benchSerialLine));
+		_benchSink += benchStrtokSerial2MyMessage(_benchMsg, _benchLine);
+	}
+}
+
+static void benchMyMessage2Serial(const uint32_t iterations)
+{
+	build(_benchMsg, 12, 6, C_SET, V_TEMP).set(36.5f, 1);
+	for (uint32_t i = 0; i < iterations; i++) {
+		size_t length;
+		_benchSink += protocolMyMessage2Serial(_benchMsg, length)[0] + length;
+	}
+}
+
+static void benchMQTT2MyMessage(const uint32_t iterations)
+{
+	static const char topic[] = MY_MQTT_SUBSCRIBE_TOPIC_PREFIX "/12/6/1/0/0";
+	uint8_t payload[] = "36.5";
+	for (uint32_t i = 0; i < iterations; i++) {
+		// the topic is split in place
+		(void)memcpy(_benchLine, topic, sizeof(topic));
+		_benchSink += protocolMQTT2MyMessage(_benchMsg, _benchLine, payload, sizeof(payload) - 1);
+	}
+}
+
+static void benchMyMessage2MQTT(const uint32_t iterations)
+{
+	build(_benchMsg, 12, 6, C_SET, V_TEMP).set(36.5f, 1);
+	for (uint32_t i = 0; i < iterations; i++) {
+		_benchSink += protocolMyMessage2MQTT(MY_MQTT_PUBLISH_TOPIC_PREFIX, _benchMsg)[0];
+	}
+}
+
+static void benchGetString(const uint32_t iterations)
+{
+	for (uint32_t i = 0; i < iterations; i++) {
+		_benchSink += _benchMsg.getString(_benchBuffer)[0];
+	}
+}
+
+static void benchGetStringString(const uint32_t iterations)
+{
+	_benchMsg.set("Hello sensor network");
+	benchGetString(iterations);
+}
+
+static void benchGetStringByte(const uint32_t iterations)
+{
+	_benchMsg.set((uint8_t)123);
+	benchGetString(iterations);
+}
+
+static void benchGetStringInt16(const uint32_t iterations)
+{
+	_benchMsg.set((int16_t)-12345);
+	benchGetString(iterations);
+}
+
+static void benchGetStringUInt16(const uint32_t iterations)
+{
+	_benchMsg.set((uint16_t)54321);
+	benchGetString(iterations);
+}
+
+static void benchGetStringLong32(const uint32_t iterations)
+{
+	_benchMsg.set((int32_t)-1234567890);
+	benchGetString(iterations);
+}
+
+static void benchGetStringULong32(const uint32_t iterations)
+{
+	_benchMsg.set((uint32_t)3456789012u);
+	benchGetString(iterations);
+}
+
+static void benchGetStringCustom(const uint32_t iterations)
+{
+	static const uint8_t data[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0x01, 0x23, 0x45, 0x67 };
+	_benchMsg.set(data, sizeof(data));
+	benchGetString(iterations);
+}
+
+static void benchGetStringFloat32(const uint32_t iterations)
+{
+	_benchMsg.set(-1234.5678f, 4);
+	benchGetString(iterations);
+}
+
+// the node signs for itself: the nonce handed out is used for signing and verification
+static MyMessage _benchNonce;
+
+static void benchSignerGetNonce(const uint32_t iterations)
+{
+	_benchNonce.sender = 12;
+	for (uint32_t i = 0; i < iterations; i++) {
+		_benchSink += signerBackendGetNonce(_benchNonce);
+	}
+}
+
+static void benchSignerSign(const uint32_t iterations)
+{
+	MyMessage message;
+	_benchNonce.sender = 12;
+	(void)signerBackendGetNonce(_benchNonce);
+	for (uint32_t i = 0; i < iterations; i++) {
+		build(message, 0, 6, C_SET, V_TEMP).set(36.5f, 1).sender = 12;
+		signerBackendPutNonce(_benchNonce);
+		_benchSink += signerBackendSignMsg(message);
+	}
+}
+
+static void benchSignerRoundTrip(const uint32_t iterations)
+{
+	MyMessage message;
+	_benchNonce.sender = 12;
+	for (uint32_t i = 0; i < iterations; i++) {
+		build(message, 0, 6, C_SET, V_TEMP).set(36.5f, 1).sender = 12;
+		(void)signerBackendGetNonce(_benchNonce);
+		signerBackendPutNonce(_benchNonce);
+		(void)signerBackendSignMsg(message);
+		if (!signerBackendVerifyMsg(message)) {
+			logError("Signature verification failed.\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+// The gateway hands out nonces to a batch of nodes, each node signs a message with its nonce and
+// the gateway verifies them. The sender ids cycle through 1..254, a batch fills the nonce table.
+#define BENCH_SIGNER_BATCH (MY_SIGNING_NONCE_TABLE_SIZE)
+static MyMessage _benchSigned[BENCH_SIGNER_BATCH];
+static uint8_t _benchSender = 0;
+
+static void benchSignerFail(const char *what)
+{
+	logError("%s failed for node %" PRIu8 ".\n", what, _benchSender);
+	exit(EXIT_FAILURE);
+}
+
+static void benchSignerNonces(MyMessage *nonces, const uint8_t count)
+{
+	for (uint8_t i = 0; i < count; i++) {
+		_benchSender = _benchSender % 254u + 1u;
+		nonces[i].sender = _benchSender;
+		if (!signerBackendGetNonce(nonces[i])) {
+			benchSignerFail("Nonce generation");
+		}
+	}
+}
+
+static void benchSignerSignSenders(const uint32_t iterations)
+{
+	MyMessage nonces[BENCH_SIGNER_BATCH];
+	for (uint32_t done = 0; done < iterations;) {
+		const uint8_t count = (uint8_t)std::min(iterations - done, (uint32_t)BENCH_SIGNER_BATCH);
+		benchSignerNonces(nonces, count);
+		for (uint8_t i = 0; i < count; i++) {
+			MyMessage &message = _benchSigned[i];
+			build(message, getNodeId(), 6, C_SET, V_TEMP).set(36.5f, 1).sender = nonces[i].sender;
+			const uint64_t start = benchNanos();
+			signerBackendPutNonce(nonces[i]);
+			const bool signedMsg = signerBackendSignMsg(message);
+			benchLatency(start);
+			if (!signedMsg) {
+				benchSignerFail("Signing");
+			}
+		}
+		// release the nonces of the batch
+		for (uint8_t i = 0; i < count; i++) {
+			(void)signerVerifyMsg(_benchSigned[i]);
+		}
+		done += count;
+	}
+}
+
+static void benchSignerVerifySenders(const uint32_t iterations)
+{
+	MyMessage nonces[BENCH_SIGNER_BATCH];
+	for (uint32_t done = 0; done < iterations;) {
+		const uint8_t count = (uint8_t)std::min(iterations - done, (uint32_t)BENCH_SIGNER_BATCH);
+		benchSignerNonces(nonces, count);
+		for (uint8_t i = 0; i < count; i++) {
+			MyMessage &message = _benchSigned[i];
+			build(message, getNodeId(), 6, C_SET, V_TEMP).set(36.5f, 1).sender = nonces[i].sender;
+			signerBackendPutNonce(nonces[i]);
+			if (!signerBackendSignMsg(message)) {
+				benchSignerFail("Signing");
+			}
+		}
+		for (uint8_t i = 0; i < count; i++) {
+			const uint64_t start = benchNanos();
+			const bool verified = signerVerifyMsg(_benchSigned[i]);
+			benchLatency(start);
+			if (!verified) {
+				_benchSender = _benchSigned[i].sender;
+				benchSignerFail("Verification");
+			}
+		}
+		done += count;
+	}
+}
+
+static uint8_t _benchData[1024];
+static uint8_t _benchHash[32];
+static const uint8_t _benchKey[32] = { 0x42 };
+
+static void benchSHA256Block(const uint32_t iterations)
+{
+	for (uint32_t i = 0; i < iterations; i++) {
+		SHA256(_benchHash, _benchData, 64);
+	}
+	_benchSink += _benchHash[0];
+}
+
+static void benchSHA256KB(const uint32_t iterations)
+{
+	for (uint32_t i = 0; i < iterations; i++) {
+		SHA256(_benchHash, _benchData, sizeof(_benchData));
+	}
+	_benchSink += _benchHash[0];
+}
+
+static void benchHMAC(const uint32_t iterations)
+{
+	for (uint32_t i = 0; i < iterations; i++) {
+		SHA256HMAC(_benchHash, _benchKey, sizeof(_benchKey), _benchData, 32);
+	}
+	_benchSink += _benchHash[0];
+}
+
+static void benchHMACWithKey(const uint32_t iterations)
+{
+	SHA256HMACSetKey(_benchKey, sizeof(_benchKey));
+	for (uint32_t i = 0; i < iterations; i++) {
+		SHA256HMACWithKey(_benchHash, _benchData, 32);
+	}
+	_benchSink += _benchHash[0];
+}
+
+static void benchAESCBC(const uint32_t iterations)
+{
+	AES128CBCInit(_benchKey);
+	for (uint32_t i = 0; i < iterations; i++) {
+		uint8_t iv[16] = { 0 };
+		AES128CBCEncrypt(iv, _benchData, 32);
+	}
+	_benchSink += _benchData[0];
+}
+
+static void benchAESCTR(const uint32_t iterations)
+{
+	static const uint8_t iv[16] = { 0 };
+	AES128CBCInit(_benchKey);
+	for (uint32_t i = 0; i < iterations; i++) {
+		AES128CTRCrypt(iv, _benchData, 25);
+	}
+	_benchSink += _benchData[0];
+}
+
+static void benchCircularBuffer(const uint32_t iterations)
+{
+	static MyMessage storage[8];
+	CircularBuffer<MyMessage> queue(storage, 8);
+	for (uint32_t i = 0; i < iterations; i++) {
+		MyMessage *front = queue.getFront();
+		front->sensor = (uint8_t)i;
+		(void)queue.pushFront(front);
+		_benchSink += queue.getBack()->sensor;
+		(void)queue.popBack();
+	}
+}
+
+// keep clear of the node and signing configuration
+#define BENCH_EEPROM_ADDRESS(i) (EEPROM_LOCAL_CONFIG_ADDRESS + (i) % 256u)
+
+static void benchEepromRead(const uint32_t iterations)
+{
+	for (uint32_t i = 0; i < iterations; i++) {
+		hwReadConfigBlock((void *)_benchHash, (void *)(uintptr_t)BENCH_EEPROM_ADDRESS(i),
+		                  sizeof(_benchHash));
+	}
+	_benchSink += _benchHash[0];
+}
+
+static void benchEepromWrite(const uint32_t iterations)
+{
+	for (uint32_t i = 0; i < iterations; i++) {
+		// a changed byte every time, unchanged writes are skipped
+		hwWriteConfig((int)BENCH_EEPROM_ADDRESS(i), (uint8_t)i);
+	}
+}
+
+static const bench_t _benches[] = {
+	{ "protocol_serial2mymessage", benchSerial2MyMessage },
+	{ "protocol_parse_stream", benchParseStream },
+	{ "protocol_serial2mymessage_strtok", benchSerial2MyMessageStrtok },
+	{ "protocol_mymessage2serial", benchMyMessage2Serial },
+	{ "protocol_mqtt2mymessage", benchMQTT2MyMessage },
+	{ "protocol_mymessage2mqtt", benchMyMessage2MQTT },
+	{ "message_getstring_string", benchGetStringString },
+	{ "message_getstring_byte", benchGetStringByte },
+	{ "message_getstring_int16", benchGetStringInt16 },
+	{ "message_getstring_uint16", benchGetStringUInt16 },
+	{ "message_getstring_long32", benchGetStringLong32 },
+	{ "message_getstring_ulong32", benchGetStringULong32 },
+	{ "message_getstring_custom", benchGetStringCustom },
+	{ "message_getstring_float32", benchGetStringFloat32 },
+	{ "signer_get_nonce", benchSignerGetNonce },
+	{ "signer_sign", benchSignerSign },
+	{ "signer_nonce_sign_verify", benchSignerRoundTrip },
+	{ "signer_sign_senders", benchSignerSignSenders },
+	{ "signer_verify_senders", benchSignerVerifySenders },
+	{ "crypto_sha256_64b", benchSHA256Block },
+	{ "crypto_sha256_1kb", benchSHA256KB },
+	{ "crypto_hmac_sha256_32b", benchHMAC },
+	{ "crypto_hmac_sha256_with_key_32b", benchHMACWithKey },
+	{ "crypto_aes128_cbc_32b", benchAESCBC },
+	{ "crypto_aes128_ctr_25b", benchAESCTR },
+	{ "circularbuffer_push_pop", benchCircularBuffer },
+	{ "eeprom_read_block_32b", benchEepromRead },
+	{ "eeprom_write_byte", benchEepromWrite }
+};
+
+// latency below which the given percentage of the recorded operations fall
+static uint32_t benchPercentile(const uint32_t count, const uint32_t percent)
+{
+	return _benchLatency[(uint64_t)(count - 1) * percent / 100u];
+}
+
+void setup()
+{
+	const char *format = getenv("MYBENCH_FORMAT");
+	const char *filter = getenv("MYBENCH_FILTER");
+	const char *minTime = getenv("MYBENCH_MIN_TIME_MS");
+	const bool json = format && !strcmp(format, "json");
+	const uint64_t minNanos = (minTime ? strtoul(minTime, NULL, 10) : 200u) * 1000000ull;
+
+	// signing requirements from the (blank) eeprom, nothing is whitelisted
+	signerInit();
+	if (json) {
+		printf("{\"version\":\"%s\",\"results\":[", MYSENSORS_LIBRARY_VERSION);
+	} else {
+		printf("%-34s %12s %12s %12s %12s %10s %10s %10s\n", "benchmark", "iterations", "ns/op",
+		       "ops/s", "allocs/op", "p50 ns", "p90 ns", "p99 ns");
+	}
+	bool first = true;
+	for (size_t b = 0; b < sizeof(_benches) / sizeof(_benches[0]); b++) {
+		const bench_t &bench = _benches[b];
+		if (filter && !strstr(bench.name, filter)) {
+			continue;
+		}
+		// double the iterations until the run takes long enough to be measured
+		uint32_t iterations = 1;
+		uint64_t elapsed;
+		uint32_t allocs;
+		for (;;) {
+			_benchLatencyCount = 0;
+			_benchLatencyNanos = 0;
+			const uint32_t allocsBefore = _benchAllocs;
+			const uint64_t start = benchNanos();
+			bench.run(iterations);
+			elapsed = benchNanos() - start;
+			allocs = _benchAllocs - allocsBefore;
+			if (elapsed >= minNanos || iterations >= 0x80000000u) {
+				break;
+			}
+			iterations *= 2;
+		}
+		// operations timed on their own leave their setup work out
+		const uint32_t samples = std::min(_benchLatencyCount, BENCH_LATENCY_SAMPLES);
+		const double nanosPerOp = (double)(samples ? _benchLatencyNanos : elapsed) / iterations;
+		const double opsPerSec = nanosPerOp > 0 ? 1e9 / nanosPerOp : 0;
+		const double allocsPerOp = (double)allocs / iterations;
+		uint32_t p50 = 0, p90 = 0, p99 = 0;
+		if (samples) {
+			std::sort(_benchLatency, _benchLatency + samples);
+			p50 = benchPercentile(samples, 50);
+			p90 = benchPercentile(samples, 90);
+			p99 = benchPercentile(samples, 99);
+		}
+		if (json) {
+			printf("%s{\"name\":\"%s\",\"iterations\":%" PRIu32
+			       ",\"ns_per_op\":%.2f,\"ops_per_sec\":%.0f,\"allocs_per_op\":%.3f",
+			       first ? "" : ",", bench.name, iterations, nanosPerOp, opsPerSec, allocsPerOp);
+			if (samples) {
+				printf(",\"p50_ns\":%" PRIu32 ",\"p90_ns\":%" PRIu32 ",\"p99_ns\":%" PRIu32, p50, p90, p99);
+			}
+			printf("}");
+		} else if (samples) {
+			printf("%-34s %12" PRIu32 " %12.2f %12.0f %12.3f %10" PRIu32 " %10" PRIu32 " %10" PRIu32 "\n",
+			       bench.name, iterations, nanosPerOp, opsPerSec, allocsPerOp, p50, p90, p99);
+		} else {
+			printf("%-34s %12" PRIu32 " %12.2f %12.0f %12.3f %10s %10s %10s\n", bench.name, iterations,
+			       nanosPerOp, opsPerSec, allocsPerOp, "-", "-", "-");
+		}
+		first = false;
+		fflush(stdout);
+	}
+	if (json) {
+		printf("]}\n");
+	}
+	exit(EXIT_SUCCESS);
+}
+
+void loop()
+{
+	// all benchmarks run in setup()
+}
@@ -0,0 +1,346 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// Benchmarks of the radio drivers on modelled radios, built by "make radiobench".
+//
+// The driver of the radio selected with MYRADIOBENCH_RF24, MYRADIOBENCH_RFM69 or MYRADIOBENCH_RFM95
+// runs against the register file of the radio in radiomodel/. The SPI bus, the GPIOs, the
+// interrupt and the clock are simulated, so the counts do not need the hardware and are the same
+// on every host. Each benchmark sends or receives MYRADIOBENCH_FRAMES (default 200) frames of 25
+// bytes and reports per frame the spidev ioctls, chip select frames, bytes on the bus, GPIO writes,
+// the time spent on the bus and the GPIOs, the simulated time, airtime and waits included, and the
+// host time of the driver code. The bus costs are set in ns with MYRADIOBENCH_SPI_OVERHEAD_NS
+// (per ioctl, default 10000), MYRADIOBENCH_GPIO_NS (per GPIO write, default 2000) and
+// MYRADIOBENCH_POLL_NS (per clock read, default 1000), rough figures of a Raspberry Pi class host.
+// MYBENCH_FORMAT=json and MYBENCH_FILTER=<text> work as for mybench.
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+// the driver only, the transport is run by the benchmarks
+#define MY_CORE_ONLY
+
+#if !defined(MY_GATEWAY_LINUX) && !defined(MY_GATEWAY_SERIAL)
+#define MY_GATEWAY_LINUX
+#endif
+
+// the radio of the configuration is replaced by the one of the benchmark, on the simulated bus
+#undef MY_RADIO_RF24
+#undef MY_RADIO_NRF24
+#undef MY_RADIO_RFM69
+#undef MY_RADIO_RFM95
+#undef MY_RADIO_SIMULATED
+#undef MY_RS485
+#undef MY_GATEWAY_SECONDARY_RFM95
+#undef LINUX_ARCH_RASPBERRYPI
+#undef LINUX_SPI_BCM
+#if !defined(LINUX_SPI_SPIDEV)
+#define LINUX_SPI_SPIDEV
+#endif
+
+#if defined(MYRADIOBENCH_RF24)
+#define MY_RADIO_RF24
+#define MYRADIOBENCH_NAME "rf24"
+#elif defined(MYRADIOBENCH_RFM69)
+#define MY_RADIO_RFM69
+#define MY_RFM69_NEW_DRIVER
+#undef MY_NODE_ID_16BIT
+#define MYRADIOBENCH_NAME "rfm69"
+#elif defined(MYRADIOBENCH_RFM95)
+#define MY_RADIO_RFM95
+#undef MY_NODE_ID_16BIT
+#define MYRADIOBENCH_NAME "rfm95"
+#else
+#error Select the radio with MYRADIOBENCH_RF24, MYRADIOBENCH_RFM69 or MYRADIOBENCH_RFM95
+#endif
+
+#include <MySensors.h>
+#include "radiomodel/NRF24Model.h"
+#include "radiomodel/SX1231Model.h"
+#include "radiomodel/SX1276Model.h"
+
+#define MYRADIOBENCH_PEER (1u)						// node at the other end
+#define MYRADIOBENCH_TURNAROUND_NS (1000000ull)		// the peer answers after 1 ms
+#define MYRADIOBENCH_TIMEOUT_MS (1000u)
+
+typedef void (*benchFunction_t)(const uint32_t frames);
+
+typedef struct {
+	const char *name;
+	benchFunction_t run;
+} bench_t;
+
+static uint8_t _benchPayload[25];
+static uint8_t _benchBuffer[MAX_MESSAGE_LENGTH];
+
+static void benchFail(const char *reason)
+{
+	fprintf(stderr, "myradiobench: %s\n", reason);
+	exit(EXIT_FAILURE);
+}
+
+#if defined(MYRADIOBENCH_RF24)
+static NRF24Model _model(MY_RF24_CE_PIN);
+
+// the peer is the radio, the ACK is sent by the hardware
+static void benchPeer(const uint8_t *data, const uint8_t len)
+{
+	(void)data;
+	(void)len;
+}
+
+static uint8_t benchFrame(uint8_t *frame, const nodeId_t to, const bool ack, uint8_t &pipe)
+{
+	(void)ack;
+	pipe = (to == BROADCAST_ADDRESS) ? RF24_BROADCAST_PIPE : 0;
+	(void)memcpy(frame, _benchPayload, sizeof(_benchPayload));
+	return sizeof(_benchPayload);
+}
+#elif defined(MYRADIOBENCH_RFM69)
+static SX1231Model _model;
+static rfm69_sequenceNumber_t _benchSequence = 0;
+
+// the peer acknowledges the frames that request it
+static void benchPeer(const uint8_t *data, const uint8_t len)
+{
+	rfm69_header_t header;
+	if (len < sizeof(header)) {
+		return;
+	}
+	(void)memcpy((void *)&header, data, sizeof(header));
+	if (header.recipient != MYRADIOBENCH_PEER || !RFM69_getACKRequested(header.controlFlags) ||
+	        RFM69_getACKReceived(header.controlFlags)) {
+		return;
+	}
+	rfm69_packet_t packet;
+	packet.header.packetLen = RFM69_HEADER_LEN - 1 + sizeof(rfm69_ack_t);
+	packet.header.recipient = header.sender;
+	packet.header.version = RFM69_PACKET_HEADER_VERSION;
+	packet.header.sender = MYRADIOBENCH_PEER;
+	packet.header.controlFlags = 0u;
+	RFM69_setACKReceived(packet.header.controlFlags, true);
+	RFM69_setACKRSSIReport(packet.header.controlFlags, true);
+	packet.header.sequenceNumber = ++_benchSequence;
+	packet.ACK.sequenceNumber = header.sequenceNumber;
+	packet.ACK.RSSI = _model.rssi;
+	const uint8_t frameLen = packet.header.packetLen + 1u;
+	(void)_model.deliver(packet.data, frameLen,
+	                     radioModelNow() + MYRADIOBENCH_TURNAROUND_NS + _model.airtime(frameLen));
+}
+
+static uint8_t benchFrame(uint8_t *frame, const nodeId_t to, const bool ack, uint8_t &pipe)
+{
+	rfm69_packet_t packet;
+	pipe = 0;
+	packet.header.packetLen = RFM69_HEADER_LEN - 1 + sizeof(_benchPayload);
+	packet.header.recipient = to;
+	packet.header.version = RFM69_PACKET_HEADER_VERSION;
+	packet.header.sender = MYRADIOBENCH_PEER;
+	packet.header.controlFlags = 0u;
+	RFM69_setACKRequested(packet.header.controlFlags, ack);
+	packet.header.sequenceNumber = ++_benchSequence;
+	(void)memcpy(packet.payload, _benchPayload, sizeof(_benchPayload));
+	(void)memcpy(frame, packet.data, packet.header.packetLen + 1u);
+	return packet.header.packetLen + 1u;
+}
+#elif defined(MYRADIOBENCH_RFM95)
+static SX1276Model _model;
+static rfm95_sequenceNumber_t _benchSequence = 0;
+
+// the peer acknowledges the frames that request it
+static void benchPeer(const uint8_t *data, const uint8_t len)
+{
+	rfm95_header_t header;
+	if (len < sizeof(header)) {
+		return;
+	}
+	(void)memcpy((void *)&header, data, sizeof(header));
+	if (header.recipient != MYRADIOBENCH_PEER || !RFM95_getACKRequested(header.controlFlags) ||
+	        RFM95_getACKReceived(header.controlFlags)) {
+		return;
+	}
+	rfm95_packet_t packet;
+	packet.header.version = RFM95_PACKET_HEADER_VERSION;
+	packet.header.recipient = header.sender;
+	packet.header.sender = MYRADIOBENCH_PEER;
+	packet.header.controlFlags = 0u;
+	RFM95_setACKReceived(packet.header.controlFlags, true);
+	RFM95_setACKRSSIReport(packet.header.controlFlags, true);
+	packet.header.sequenceNumber = ++_benchSequence;
+	packet.ACK.sequenceNumber = header.sequenceNumber;
+	packet.ACK.RSSI = _model.rssi;
+	packet.ACK.SNR = _model.snr;
+	(void)_model.deliver(packet.data, RFM95_ACK_FRAME_LEN,
+	                     radioModelNow() + MYRADIOBENCH_TURNAROUND_NS + _model.airtime(RFM95_ACK_FRAME_LEN));
+}
+
+static uint8_t benchFrame(uint8_t *frame, const nodeId_t to, const bool ack, uint8_t &pipe)
+{
+	rfm95_packet_t packet;
+	pipe = 0;
+	packet.header.version = RFM95_PACKET_HEADER_VERSION;
+	packet.header.recipient = to;
+	packet.header.sender = MYRADIOBENCH_PEER;
+	packet.header.controlFlags = 0u;
+	RFM95_setACKRequested(packet.header.controlFlags, ack);
+	packet.header.sequenceNumber = ++_benchSequence;
+	(void)memcpy(packet.payload, _benchPayload, sizeof(_benchPayload));
+	(void)memcpy(frame, packet.data, RFM95_HEADER_LEN + sizeof(_benchPayload));
+	return RFM95_HEADER_LEN + sizeof(_benchPayload);
+}
+#endif
+
+static void benchTxBroadcast(const uint32_t frames)
+{
+	for (uint32_t i = 0; i < frames; i++) {
+		if (!transportSend(BROADCAST_ADDRESS, _benchPayload, sizeof(_benchPayload), false)) {
+			benchFail("broadcast not sent");
+		}
+	}
+}
+
+static void benchTxAck(const uint32_t frames)
+{
+	for (uint32_t i = 0; i < frames; i++) {
+		if (!transportSend(MYRADIOBENCH_PEER, _benchPayload, sizeof(_benchPayload), false)) {
+			benchFail("frame not acknowledged");
+		}
+	}
+}
+
+static void benchReceive(const uint32_t frames, const nodeId_t to, const bool ack)
+{
+	for (uint32_t i = 0; i < frames; i++) {
+		uint8_t frame[RADIO_MODEL_MAX_FRAME];
+		uint8_t pipe;
+		const uint8_t len = benchFrame(frame, to, ack, pipe);
+		if (!_model.deliver(frame, len, radioModelNow() + _model.airtime(len), pipe)) {
+			benchFail("air queue full");
+		}
+		// polled like the transport does
+		const uint32_t enterMS = hwMillis();
+		while (!transportDataAvailable()) {
+			if (hwMillis() - enterMS > MYRADIOBENCH_TIMEOUT_MS) {
+				benchFail("frame not received");
+			}
+		}
+		if (transportReceive(_benchBuffer) != sizeof(_benchPayload)) {
+			benchFail("frame received with a wrong length");
+		}
+	}
+}
+
+static void benchRx(const uint32_t frames)
+{
+	benchReceive(frames, BROADCAST_ADDRESS, false);
+}
+
+static void benchRxAck(const uint32_t frames)
+{
+	// the RFM drivers send the ACK, the nRF24 does it in hardware
+	benchReceive(frames, GATEWAY_ADDRESS, true);
+}
+
+static const bench_t _benches[] = {
+	{ MYRADIOBENCH_NAME "_tx_broadcast", benchTxBroadcast },
+	{ MYRADIOBENCH_NAME "_tx_ack", benchTxAck },
+	{ MYRADIOBENCH_NAME "_rx", benchRx },
+	{ MYRADIOBENCH_NAME "_rx_ack", benchRxAck },
+};
+
+static uint32_t benchEnv(const char *name, const uint32_t value)
+{
+	const char *text = getenv(name);
+	return text ? (uint32_t)strtoul(text, NULL, 10) : value;
+}
+
+static uint64_t benchNanos(void)
+{
+	struct timespec now;
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+void setup()
+{
+	const char *format = getenv("MYBENCH_FORMAT");
+	const char *filter = getenv("MYBENCH_FILTER");
+	const bool json = format && !strcmp(format, "json");
+	const uint32_t frames = benchEnv("MYRADIOBENCH_FRAMES", 200u);
+
+	radioModelSetCosts(benchEnv("MYRADIOBENCH_SPI_OVERHEAD_NS", 10000u),
+	                   benchEnv("MYRADIOBENCH_GPIO_NS", 2000u), benchEnv("MYRADIOBENCH_POLL_NS", 1000u));
+	for (uint8_t i = 0; i < sizeof(_benchPayload); i++) {
+		_benchPayload[i] = i;
+	}
+	_model.onTransmit = benchPeer;
+	radioModelAttach(&_model);
+	if (!transportInit()) {
+		benchFail("radio initialization failed");
+	}
+	transportSetAddress(GATEWAY_ADDRESS);
+
+	if (json) {
+		printf("{\"version\":\"%s\",\"results\":[", MYSENSORS_LIBRARY_VERSION);
+	} else {
+		printf("%-34s %8s %8s %8s %8s %8s %10s %10s %10s\n", "benchmark", "frames", "ioctls/f",
+		       "cs/f", "bytes/f", "gpio/f", "bus_us/f", "sim_us/f", "host_ns/f");
+	}
+	bool first = true;
+	for (size_t b = 0; b < sizeof(_benches) / sizeof(_benches[0]); b++) {
+		const bench_t &bench = _benches[b];
+		if (!frames || (filter && !strstr(bench.name, filter))) {
+			continue;
+		}
+		const radioModelStats_t before = *radioModelStats();
+		const uint64_t simulatedStart = radioModelNow();
+		const uint64_t start = benchNanos();
+		bench.run(frames);
+		const double host = (double)(benchNanos() - start) / frames;
+		const double simulated = (double)(radioModelNow() - simulatedStart) / 1000.0 / frames;
+		const radioModelStats_t *after = radioModelStats();
+		const double submissions = (double)(after->submissions - before.submissions) / frames;
+		const double chipSelects = (double)(after->frames - before.frames) / frames;
+		const double bytes = (double)(after->bytes - before.bytes) / frames;
+		const double pinWrites = (double)(after->pinWrites - before.pinWrites) / frames;
+		const double bus = (double)(after->busNanos - before.busNanos) / 1000.0 / frames;
+		if (json) {
+			printf("%s{\"name\":\"%s\",\"frames\":%" PRIu32 ",\"ioctls_per_frame\":%.2f,"
+			       "\"cs_per_frame\":%.2f,\"bytes_per_frame\":%.2f,\"gpio_per_frame\":%.2f,"
+			       "\"bus_us_per_frame\":%.2f,\"sim_us_per_frame\":%.2f,\"host_ns_per_frame\":%.2f}",
+			       first ? "" : ",", bench.name, frames, submissions, chipSelects, bytes, pinWrites, bus,
+			       simulated, host);
+		} else {
+			printf("%-34s %8" PRIu32 " %8.2f %8.2f %8.2f %8.2f %10.2f %10.2f %10.2f\n", bench.name, frames,
+			       submissions, chipSelects, bytes, pinWrites, bus, simulated, host);
+		}
+		first = false;
+		fflush(stdout);
+	}
+	if (json) {
+		printf("]}\n");
+	}
+	exit(EXIT_SUCCESS);
+}
+
+void loop()
+{
+	// all benchmarks run in setup()
+}
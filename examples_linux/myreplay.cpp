@@ -0,0 +1,609 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// Replay of a radio capture of mysgw (pcap_file) into a gateway on the simulated radio, started
+// by "make replay".
+//
+// The frames the gateway received are sent again on the simulated radio, at the pace of the
+// capture times MYREPLAY_SPEED (default 1, 0 is as fast as possible), each one from the node
+// that sent it. The frames the gateway sends are compared with the ones it sent in the capture:
+// frames acknowledged in the capture are acknowledged again, the others are not, and the frames
+// missing or not captured are the divergence of the replay. With MYREPLAY_CONTROLLER=<host:port>
+// or <unix socket> the replay is the controller of the gateway as well: the commands behind the
+// frames the controller had the gateway send are written to it at their time, and the messages
+// forwarded for the replayed frames give the radio to controller latency. Encrypted frames are
+// replayed and compared but not timed, their messages can not be read here.
+//
+// MYREPLAY_FILE=<capture> selects the capture, MYREPLAY_SETTLE_MS (default 1000) is the time
+// frames sent late by the gateway are still collected, MYREPLAY_MAX_DIVERGENCE=<frames> makes the
+// replay fail beyond it. MYBENCH_FORMAT=json prints the report for machines, as mybench does.
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+#include <algorithm>
+#include <netdb.h>
+#include <sys/un.h>
+
+// the replay runs the simulated radio and the protocol functions, not the gateway
+#define MY_CORE_ONLY
+
+#if !defined(MY_GATEWAY_LINUX) && !defined(MY_GATEWAY_SERIAL)
+#define MY_GATEWAY_LINUX
+#endif
+
+#undef MY_RADIO_RF24
+#undef MY_RADIO_NRF24
+#undef MY_RADIO_RFM69
+#undef MY_RADIO_RFM95
+#undef MY_RS485
+#undef MY_GATEWAY_SECONDARY_RFM95
+#if !defined(MY_RADIO_SIMULATED)
+#define MY_RADIO_SIMULATED
+#endif
+
+#include <MySensors.h>
+
+#define MYREPLAY_LINE_TIMEOUT_US (1000000ull)	// forwarded messages not seen by then are not timed
+#define MYREPLAY_PENDING_LINES (256u)			// forwarded messages waited for at a time
+#define MYREPLAY_CONNECT_MS (5000u)				// the gateway may still be starting
+#define MYREPLAY_SHOWN (10u)					// diverging frames printed
+#define MYREPLAY_HISTOGRAM (21u)				// latency buckets of powers of 2 us, the last one open
+
+typedef struct {
+	uint64_t at;						// capture time in us, from the first frame
+	uint8_t direction;					// PCAP_CAPTURE_RX or PCAP_CAPTURE_TX
+	uint8_t flags;						// PCAP_CAPTURE_FLAG_xxx
+	uint8_t peer;						// TX: next recipient
+	uint8_t len;
+	bool matched;						// TX: sent by the gateway again
+	uint8_t data[MAX_MESSAGE_LENGTH];
+} replayFrame_t;
+
+typedef struct {
+	uint64_t injected;					// time the frame was sent
+	char line[MY_GATEWAY_MAX_SEND_LENGTH];
+} replayPendingLine_t;
+
+static std::vector<replayFrame_t> _replayFrames;
+static std::vector<uint32_t> _replayLatencies;
+static replayPendingLine_t _replayPending[MYREPLAY_PENDING_LINES];
+static uint16_t _replayPendingHead = 0;
+static uint16_t _replayPendingCount = 0;
+static int _replayController = -1;
+static char _replayLine[MY_GATEWAY_MAX_RECEIVE_LENGTH];
+static size_t _replayLineLength = 0;
+static uint16_t _replaySeq = 0;
+static bool _replayAcked = false;
+static uint32_t _replayGatewayStation = 0;
+static uint16_t _replayGatewaySeq = 0;
+static bool _replayGatewayAck = false;
+
+static struct {
+	uint32_t injected;
+	uint32_t acknowledged;
+	uint32_t lost;
+	uint32_t commands;
+	uint32_t sent;
+	uint32_t matched;
+	uint32_t unexpected;
+	uint32_t captured;
+	uint32_t forwarded;
+	uint32_t notForwarded;
+	uint32_t otherLines;
+} _replayStats;
+
+static void replayFail(const char *reason, const char *detail = "")
+{
+	fprintf(stderr, "myreplay: %s%s\n", reason, detail);
+	exit(EXIT_FAILURE);
+}
+
+static uint64_t replayMicros(void)
+{
+	struct timespec now;
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000ull + (uint64_t)now.tv_nsec / 1000u;
+}
+
+static uint32_t replayEnv(const char *name, const uint32_t value)
+{
+	const char *text = getenv(name);
+	return text ? (uint32_t)strtoul(text, NULL, 10) : value;
+}
+
+static void replayHex(FILE *stream, const uint8_t *data, const uint8_t len)
+{
+	for (uint8_t i = 0; i < len; i++) {
+		fprintf(stream, "%02X", data[i]);
+	}
+}
+
+// the frame as message, false if it is encrypted or not a message
+static bool replayMessage(MyMessage &msg, const uint8_t *data, const uint8_t len)
+{
+	msg.clear();
+	if (len < HEADER_SIZE || len > MAX_MESSAGE_LENGTH) {
+		return false;
+	}
+	(void)memcpy((void *)&msg, (const void *)data, len);
+	return mGetVersion(msg) == PROTOCOL_VERSION && HEADER_SIZE + mGetLength(msg) <= len;
+}
+
+// frames sent by the gateway for a controller command, the others are its own
+static bool replayFromController(const replayFrame_t &frame)
+{
+	MyMessage msg;
+	if (!replayMessage(msg, frame.data, frame.len) || msg.sender != GATEWAY_ADDRESS ||
+	        mGetEcho(msg)) {
+		return false;
+	}
+	if (mGetCommand(msg) != C_INTERNAL) {
+		return true;
+	}
+	switch (msg.type) {
+	case I_TIME:
+	case I_VERSION:
+	case I_ID_RESPONSE:
+	case I_INCLUSION_MODE:
+	case I_CONFIG:
+	case I_REBOOT:
+	case I_HEARTBEAT_REQUEST:
+	case I_PRESENTATION:
+	case I_DISCOVER_REQUEST:
+	case I_PING:
+	case I_DEBUG:
+	case I_SIGNAL_REPORT_REQUEST:
+	case I_STATS:
+	case I_PROFILING:
+	case I_ENERGY:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void replayLoad(const char *file)
+{
+	FILE *fp = fopen(file, "rb");
+	if (!fp) {
+		replayFail("unable to open ", file);
+	}
+	uint32_t header[6];
+	if (fread(header, sizeof(header), 1, fp) != 1 || header[0] != 0xa1b2c3d4 ||
+	        header[5] != PCAP_CAPTURE_LINKTYPE) {
+		replayFail("not a radio capture of mysgw: ", file);
+	}
+	uint64_t first = 0;
+	uint32_t record[4];
+	while (fread(record, sizeof(record), 1, fp) == 1) {
+		uint8_t buffer[sizeof(pcapCaptureHeader_t) + PCAP_CAPTURE_SNAPLEN];
+		const uint32_t length = record[2];
+		if (length > sizeof(buffer) || fread(buffer, length, 1, fp) != 1) {
+			replayFail("truncated capture: ", file);
+		}
+		pcapCaptureHeader_t capture;
+		if (length < sizeof(capture)) {
+			continue;
+		}
+		(void)memcpy((void *)&capture, (const void *)buffer, sizeof(capture));
+		const uint64_t at = (uint64_t)record[0] * 1000000ull + record[1];
+		if (_replayFrames.empty()) {
+			first = at;
+		}
+		replayFrame_t frame;
+		frame.at = at > first ? at - first : 0;
+		frame.direction = capture.direction;
+		frame.flags = capture.flags;
+		frame.peer = capture.peer;
+		frame.len = (uint8_t)min(length - (uint32_t)sizeof(capture), (uint32_t)MAX_MESSAGE_LENGTH);
+		frame.matched = false;
+		(void)memcpy((void *)frame.data, (const void *)&buffer[sizeof(capture)], frame.len);
+		_replayStats.captured += frame.direction == PCAP_CAPTURE_TX;
+		_replayFrames.push_back(frame);
+	}
+	fclose(fp);
+}
+
+static void replayConnect(const char *controller)
+{
+	const uint64_t until = replayMicros() + MYREPLAY_CONNECT_MS * 1000ull;
+	while (_replayController < 0 && replayMicros() < until) {
+		if (strchr(controller, '/')) {
+			struct sockaddr_un addr;
+			(void)memset((void *)&addr, 0, sizeof(addr));
+			addr.sun_family = AF_UNIX;
+			(void)strncpy(addr.sun_path, controller, sizeof(addr.sun_path) - 1);
+			_replayController = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+			if (_replayController >= 0 &&
+			        connect(_replayController, (const struct sockaddr *)&addr, sizeof(addr)) < 0) {
+				close(_replayController);
+				_replayController = -1;
+			}
+		} else {
+			char host[64];
+			const char *port = strrchr(controller, ':');
+			const size_t hostLength = port ? (size_t)(port - controller) : 0;
+			if (!port || hostLength >= sizeof(host)) {
+				replayFail("MYREPLAY_CONTROLLER is not <host:port> or a unix socket: ", controller);
+			}
+			(void)memcpy((void *)host, (const void *)controller, hostLength);
+			host[hostLength] = 0;
+			struct addrinfo hints;
+			struct addrinfo *result;
+			(void)memset((void *)&hints, 0, sizeof(hints));
+			hints.ai_family = AF_UNSPEC;
+			hints.ai_socktype = SOCK_STREAM;
+			if (getaddrinfo(host, port + 1, &hints, &result) != 0) {
+				replayFail("unknown controller host ", host);
+			}
+			_replayController = socket(result->ai_family, result->ai_socktype | SOCK_CLOEXEC,
+			                           result->ai_protocol);
+			if (_replayController >= 0 &&
+			        connect(_replayController, result->ai_addr, result->ai_addrlen) < 0) {
+				close(_replayController);
+				_replayController = -1;
+			}
+			freeaddrinfo(result);
+		}
+		if (_replayController < 0) {
+			usleep(100000);
+		}
+	}
+	if (_replayController < 0) {
+		replayFail("unable to connect to the gateway at ", controller);
+	}
+	(void)fcntl(_replayController, F_SETFL, fcntl(_replayController, F_GETFL) | O_NONBLOCK);
+}
+
+static void replayExpire(const uint64_t now)
+{
+	// taken slots are freed here as well, once they are the oldest
+	while (_replayPendingCount && (!_replayPending[_replayPendingHead].injected ||
+	                               now - _replayPending[_replayPendingHead].injected > MYREPLAY_LINE_TIMEOUT_US)) {
+		_replayStats.notForwarded += _replayPending[_replayPendingHead].injected != 0;
+		_replayPendingHead = (_replayPendingHead + 1) % MYREPLAY_PENDING_LINES;
+		_replayPendingCount--;
+	}
+}
+
+static void replayControllerLine(const char *line, const uint64_t now)
+{
+	for (uint16_t i = 0; i < _replayPendingCount; i++) {
+		replayPendingLine_t &pending = _replayPending[(_replayPendingHead + i) % MYREPLAY_PENDING_LINES];
+		if (pending.injected && !strcmp(pending.line, line)) {
+			_replayLatencies.push_back((uint32_t)(now - pending.injected));
+			_replayStats.forwarded++;
+			pending.injected = 0;
+			replayExpire(now);
+			return;
+		}
+	}
+	_replayStats.otherLines++;
+}
+
+static void replayReadController(void)
+{
+	char buffer[512];
+	ssize_t size = -1;
+	while (_replayController >= 0 && (size = recv(_replayController, buffer, sizeof(buffer), 0)) > 0) {
+		const uint64_t now = replayMicros();
+		for (ssize_t i = 0; i < size; i++) {
+			if (_replayLineLength < sizeof(_replayLine) - 1) {
+				_replayLine[_replayLineLength++] = buffer[i];
+			}
+			if (buffer[i] == '\n') {
+				_replayLine[_replayLineLength] = 0;
+				replayControllerLine(_replayLine, now);
+				_replayLineLength = 0;
+			}
+		}
+	}
+	if (size == 0) {
+		replayFail("the gateway closed the controller connection");
+	}
+}
+
+static void replaySendAck(const simulatedFrame_t &frame, const int16_t rssi)
+{
+	simulatedFrame_t ack;
+	ack.magic = SIMULATED_MAGIC;
+	ack.kind = SIMULATED_KIND_ACK;
+	ack.from = frame.to;
+	ack.to = frame.from;
+	ack.station = frame.station;
+	ack.seq = frame.seq;
+	ack.rssi = rssi;
+	ack.len = 0;
+	(void)sendto(_simSocket, &ack, SIMULATED_HEADER_SIZE, 0, (const struct sockaddr *)&_simGroup,
+	             sizeof(_simGroup));
+}
+
+static void replayShow(const char *what, const uint8_t peer, const uint8_t *data, const uint8_t len)
+{
+	fprintf(stderr, "myreplay: %s frame to %" PRIu8 ": ", what, peer);
+	replayHex(stderr, data, len);
+	fprintf(stderr, "\n");
+}
+
+// a frame sent by the gateway, acknowledged as in the capture
+static void replayGatewayFrame(const simulatedFrame_t &frame)
+{
+	const bool unicast = frame.to != BROADCAST_ADDRESS && !(frame.kind & SIMULATED_FLAG_NOACK);
+	if (frame.station == _replayGatewayStation && frame.seq == _replayGatewaySeq) {
+		// resent, the first one was not acknowledged
+		if (unicast && _replayGatewayAck) {
+			replaySendAck(frame, SIMULATED_RSSI);
+		}
+		return;
+	}
+	_replayGatewayStation = frame.station;
+	_replayGatewaySeq = frame.seq;
+	_replayStats.sent++;
+	const replayFrame_t *captured = NULL;
+	for (size_t i = 0; i < _replayFrames.size() && !captured; i++) {
+		replayFrame_t &candidate = _replayFrames[i];
+		if (candidate.direction == PCAP_CAPTURE_TX && !candidate.matched &&
+		        candidate.peer == (uint8_t)frame.to && candidate.len == frame.len &&
+		        !memcmp(candidate.data, frame.data, frame.len)) {
+			candidate.matched = true;
+			captured = &candidate;
+		}
+	}
+	if (captured) {
+		_replayStats.matched++;
+	} else if (_replayStats.unexpected++ < MYREPLAY_SHOWN) {
+		replayShow("unexpected", (uint8_t)frame.to, frame.data, frame.len);
+	}
+	// frames not in the capture reach a node that is there
+	_replayGatewayAck = captured ? (captured->flags & PCAP_CAPTURE_FLAG_ACK) : true;
+	if (unicast && _replayGatewayAck) {
+		replaySendAck(frame, SIMULATED_RSSI);
+	}
+}
+
+// read all pending datagrams and controller lines
+static void replayProcess(void)
+{
+	simulatedFrame_t frame;
+	ssize_t size;
+	while ((size = recv(_simSocket, &frame, sizeof(frame), 0)) >= (ssize_t)SIMULATED_HEADER_SIZE) {
+		if (frame.magic != SIMULATED_MAGIC) {
+			continue;
+		}
+		if ((frame.kind & ~SIMULATED_FLAG_NOACK) == SIMULATED_KIND_ACK) {
+			if (frame.station == _simStation && frame.seq == _replaySeq) {
+				_replayAcked = true;
+			}
+			continue;
+		}
+		if (frame.station == _simStation || frame.len > MAX_MESSAGE_LENGTH ||
+		        size < (ssize_t)(SIMULATED_HEADER_SIZE + frame.len)) {
+			continue;
+		}
+		replayGatewayFrame(frame);
+	}
+	replayReadController();
+	replayExpire(replayMicros());
+}
+
+// wait for the sockets until the time has come
+static void replayWait(const uint64_t until)
+{
+	for (;;) {
+		replayProcess();
+		const uint64_t now = replayMicros();
+		if (now >= until) {
+			return;
+		}
+		struct pollfd pfd[2] = { { _simSocket, POLLIN, 0 }, { _replayController, POLLIN, 0 } };
+		(void)poll(pfd, 2, (int)((until - now + 999u) / 1000u));
+	}
+}
+
+// send a received frame again, from the node that sent it and acknowledged like on air
+static void replayInject(const replayFrame_t &frame)
+{
+	MyMessage msg;
+	const bool readable = replayMessage(msg, frame.data, frame.len);
+	simulatedFrame_t sim;
+	sim.magic = SIMULATED_MAGIC;
+	sim.kind = SIMULATED_KIND_FRAME;
+	sim.from = readable ? msg.last : BROADCAST_ADDRESS;
+	sim.to = readable && msg.destination == BROADCAST_ADDRESS ? BROADCAST_ADDRESS : GATEWAY_ADDRESS;
+	sim.station = _simStation;
+	sim.seq = ++_replaySeq;
+	sim.rssi = INVALID_RSSI;
+	sim.len = frame.len;
+	(void)memcpy((void *)sim.data, (const void *)frame.data, frame.len);
+
+	if (readable && _replayController >= 0 && msg.destination == GATEWAY_ADDRESS) {
+		// the message the gateway forwards, if it does
+		if (_replayPendingCount == MYREPLAY_PENDING_LINES) {
+			_replayStats.notForwarded += _replayPending[_replayPendingHead].injected != 0;
+			_replayPendingHead = (_replayPendingHead + 1) % MYREPLAY_PENDING_LINES;
+			_replayPendingCount--;
+		}
+		replayPendingLine_t &pending = _replayPending[(_replayPendingHead + _replayPendingCount) %
+		                                             MYREPLAY_PENDING_LINES];
+		(void)strncpy(pending.line, protocolMyMessage2Serial(msg), sizeof(pending.line) - 1);
+		pending.line[sizeof(pending.line) - 1] = 0;
+		pending.injected = replayMicros();
+		_replayPendingCount++;
+	}
+
+	_replayStats.injected++;
+	const bool ack = sim.to != BROADCAST_ADDRESS;
+	_replayAcked = false;
+	for (uint8_t attempt = 0; attempt <= MY_RADIO_SIMULATED_RETRIES && !_replayAcked; attempt++) {
+		(void)sendto(_simSocket, &sim, SIMULATED_HEADER_SIZE + sim.len, 0,
+		             (const struct sockaddr *)&_simGroup, sizeof(_simGroup));
+		if (!ack) {
+			return;
+		}
+		const uint64_t until = replayMicros() + MY_RADIO_SIMULATED_ACK_TIMEOUT_MS * 1000u;
+		while (!_replayAcked && replayMicros() < until) {
+			struct pollfd pfd = { _simSocket, POLLIN, 0 };
+			(void)poll(&pfd, 1, MY_RADIO_SIMULATED_ACK_TIMEOUT_MS);
+			replayProcess();
+		}
+	}
+	if (_replayAcked) {
+		_replayStats.acknowledged++;
+	} else {
+		_replayStats.lost++;
+	}
+}
+
+// the command the controller sent for a frame of the gateway
+static void replayCommand(const replayFrame_t &frame)
+{
+	MyMessage msg;
+	(void)replayMessage(msg, frame.data, frame.len);
+	msg.sender = msg.destination;
+	mSetEcho(msg, mGetRequestEcho(msg));
+	size_t length;
+	const char *line = protocolMyMessage2Serial(msg, length);
+	if (send(_replayController, line, length, MSG_NOSIGNAL) != (ssize_t)length) {
+		replayFail("unable to write to the controller connection");
+	}
+	_replayStats.commands++;
+}
+
+static uint32_t replayPercentile(const uint8_t percent)
+{
+	if (_replayLatencies.empty()) {
+		return 0;
+	}
+	return _replayLatencies[(_replayLatencies.size() - 1) * percent / 100u];
+}
+
+static void replayReport(const bool json, const char *file, const uint32_t speed, const double seconds)
+{
+	uint32_t histogram[MYREPLAY_HISTOGRAM] = { 0 };
+	for (size_t i = 0; i < _replayLatencies.size(); i++) {
+		uint8_t bucket = 0;
+		while (bucket < MYREPLAY_HISTOGRAM - 1 && _replayLatencies[i] > (1u << bucket)) {
+			bucket++;
+		}
+		histogram[bucket]++;
+	}
+	const uint32_t missing = _replayStats.captured - _replayStats.matched;
+	if (json) {
+		printf("{\"version\":\"%s\",\"file\":\"%s\",\"speed\":%" PRIu32 ",\"seconds\":%.3f,"
+		       "\"injected\":%" PRIu32 ",\"acknowledged\":%" PRIu32 ",\"lost\":%" PRIu32 ","
+		       "\"injected_per_s\":%.1f,\"sent\":%" PRIu32 ",\"sent_per_s\":%.1f,\"captured\":%" PRIu32 ","
+		       "\"matched\":%" PRIu32 ",\"missing\":%" PRIu32 ",\"unexpected\":%" PRIu32 ","
+		       "\"commands\":%" PRIu32 ",\"forwarded\":%" PRIu32 ",\"not_forwarded\":%" PRIu32 ","
+		       "\"other_lines\":%" PRIu32 ",\"latency_us\":{\"p50\":%" PRIu32 ",\"p90\":%" PRIu32 ","
+		       "\"p99\":%" PRIu32 ",\"max\":%" PRIu32 ",\"histogram\":[",
+		       MYSENSORS_LIBRARY_VERSION, file, speed, seconds, _replayStats.injected,
+		       _replayStats.acknowledged, _replayStats.lost, _replayStats.injected / seconds,
+		       _replayStats.sent, _replayStats.sent / seconds, _replayStats.captured,
+		       _replayStats.matched, missing, _replayStats.unexpected, _replayStats.commands,
+		       _replayStats.forwarded, _replayStats.notForwarded, _replayStats.otherLines,
+		       replayPercentile(50), replayPercentile(90), replayPercentile(99), replayPercentile(100));
+		for (uint8_t i = 0; i < MYREPLAY_HISTOGRAM; i++) {
+			printf("%s%" PRIu32, i ? "," : "", histogram[i]);
+		}
+		printf("]}}\n");
+		return;
+	}
+	if (speed) {
+		printf("replay of %s at %" PRIu32 "x: %.3f s\n", file, speed, seconds);
+	} else {
+		printf("replay of %s as fast as possible: %.3f s\n", file, seconds);
+	}
+	printf("radio:      %" PRIu32 " frames injected (%.1f/s), %" PRIu32 " acknowledged, %" PRIu32
+	       " lost\n", _replayStats.injected, _replayStats.injected / seconds, _replayStats.acknowledged,
+	       _replayStats.lost);
+	printf("gateway:    %" PRIu32 " frames sent (%.1f/s), %" PRIu32 " of %" PRIu32
+	       " captured matched, %" PRIu32 " missing, %" PRIu32 " unexpected\n", _replayStats.sent,
+	       _replayStats.sent / seconds, _replayStats.matched, _replayStats.captured, missing,
+	       _replayStats.unexpected);
+	if (_replayController < 0) {
+		return;
+	}
+	printf("controller: %" PRIu32 " commands, %" PRIu32 " messages forwarded, %" PRIu32
+	       " not forwarded, %" PRIu32 " other\n", _replayStats.commands, _replayStats.forwarded,
+	       _replayStats.notForwarded, _replayStats.otherLines);
+	printf("latency:    p50 %" PRIu32 " us, p90 %" PRIu32 " us, p99 %" PRIu32 " us, max %" PRIu32
+	       " us\n", replayPercentile(50), replayPercentile(90), replayPercentile(99),
+	       replayPercentile(100));
+	for (uint8_t i = 0; i < MYREPLAY_HISTOGRAM; i++) {
+		if (histogram[i]) {
+			printf("  %s %8" PRIu32 " us %10" PRIu32 "\n", i < MYREPLAY_HISTOGRAM - 1 ? "<=" : "> ",
+			       i < MYREPLAY_HISTOGRAM - 1 ? (1u << i) : (1u << (i - 1)), histogram[i]);
+		}
+	}
+}
+
+void setup()
+{
+	const char *file = getenv("MYREPLAY_FILE");
+	const char *controller = getenv("MYREPLAY_CONTROLLER");
+	const char *format = getenv("MYBENCH_FORMAT");
+	const uint32_t speed = replayEnv("MYREPLAY_SPEED", 1u);
+	const uint32_t settle = replayEnv("MYREPLAY_SETTLE_MS", 1000u);
+	if (!file) {
+		replayFail("set MYREPLAY_FILE to the capture to replay");
+	}
+	replayLoad(file);
+	if (!transportInit()) {
+		replayFail("unable to join the simulated radio");
+	}
+	if (controller) {
+		replayConnect(controller);
+	}
+
+	const uint64_t start = replayMicros();
+	for (size_t i = 0; i < _replayFrames.size(); i++) {
+		const replayFrame_t &frame = _replayFrames[i];
+		replayWait(speed ? start + frame.at / speed : 0);
+		if (frame.direction == PCAP_CAPTURE_RX) {
+			replayInject(frame);
+		} else if (_replayController >= 0 && replayFromController(frame)) {
+			replayCommand(frame);
+		}
+	}
+	const double seconds = max((double)(replayMicros() - start) / 1e6, 1e-6);
+	replayWait(replayMicros() + settle * 1000ull);
+	// the remaining messages were not forwarded
+	replayExpire(UINT64_MAX);
+
+	uint32_t shown = 0;
+	for (size_t i = 0; i < _replayFrames.size() && shown < MYREPLAY_SHOWN; i++) {
+		const replayFrame_t &frame = _replayFrames[i];
+		if (frame.direction == PCAP_CAPTURE_TX && !frame.matched) {
+			replayShow("missing", frame.peer, frame.data, frame.len);
+			shown++;
+		}
+	}
+	std::sort(_replayLatencies.begin(), _replayLatencies.end());
+	replayReport(format && !strcmp(format, "json"), file, speed, seconds);
+	const char *maxDivergence = getenv("MYREPLAY_MAX_DIVERGENCE");
+	const uint32_t divergence = _replayStats.captured - _replayStats.matched + _replayStats.unexpected;
+	exit(maxDivergence && divergence > strtoul(maxDivergence, NULL, 10) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+void loop()
+{
+	// the replay runs in setup()
+}
@@ -0,0 +1,246 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "NRF24Model.h"
+#include <string.h>
+#include "GPIO.h"
+
+// registers and commands, see the nRF24L01+ product specification
+#define NRF24_CONFIG		(0x00)
+#define NRF24_EN_AA			(0x01)
+#define NRF24_SETUP_AW		(0x03)
+#define NRF24_SETUP_RETR	(0x04)
+#define NRF24_RF_SETUP		(0x06)
+#define NRF24_STATUS		(0x07)
+#define NRF24_OBSERVE_TX	(0x08)
+#define NRF24_RPD			(0x09)
+#define NRF24_RX_ADDR_P0	(0x0A)
+#define NRF24_RX_ADDR_P1	(0x0B)
+#define NRF24_TX_ADDR		(0x10)
+#define NRF24_FIFO_STATUS	(0x17)
+
+#define NRF24_R_REGISTER			(0x00)
+#define NRF24_W_REGISTER			(0x20)
+#define NRF24_R_RX_PL_WID			(0x60)
+#define NRF24_R_RX_PAYLOAD			(0x61)
+#define NRF24_W_TX_PAYLOAD			(0xA0)
+#define NRF24_W_TX_PAYLOAD_NO_ACK	(0xB0)
+#define NRF24_FLUSH_TX				(0xE1)
+#define NRF24_FLUSH_RX				(0xE2)
+
+#define NRF24_PRIM_RX	(0x01)
+#define NRF24_PWR_UP	(0x02)
+#define NRF24_CRCO		(0x04)
+#define NRF24_EN_CRC	(0x08)
+#define NRF24_RX_DR		(0x40)
+#define NRF24_TX_DS		(0x20)
+#define NRF24_MAX_RT	(0x10)
+#define NRF24_IRQS		(NRF24_RX_DR | NRF24_TX_DS | NRF24_MAX_RT)
+
+#define NRF24_SETTLING_NS (130000u)	// PLL settling before each TX and RX
+
+NRF24Model::NRF24Model(const uint8_t cePin) : ack(true), _cePin(cePin), _ce(false), _txCount(0),
+	_rxCount(0), _cmd(0), _index(0), _txBusy(false), _txAcked(false), _txEnd(0)
+{
+	// reset values
+	static const uint8_t regs[0x20] = {
+		0x08, 0x3F, 0x03, 0x03, 0x03, 0x02, 0x0E, 0x0E, 0x00, 0x00, 0x00, 0x00, 0xC3, 0xC4, 0xC5, 0xC6,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+	};
+	(void)memcpy(_regs, regs, sizeof(_regs));
+	(void)memset(_addr[0], 0xE7, sizeof(_addr[0]));
+	(void)memset(_addr[1], 0xC2, sizeof(_addr[1]));
+	(void)memset(_addr[2], 0xE7, sizeof(_addr[2]));
+	(void)memset(&_load, 0, sizeof(_load));
+}
+
+uint8_t NRF24Model::status()
+{
+	return (_regs[NRF24_STATUS] & NRF24_IRQS) | ((_rxCount ? _rx[0].pipe : 7u) << 1) |
+	       (_txCount == NRF24_MODEL_FIFO ? 1u : 0u);
+}
+
+uint8_t *NRF24Model::reg(const uint8_t address, uint8_t &width)
+{
+	if (address == NRF24_RX_ADDR_P0 || address == NRF24_RX_ADDR_P1 || address == NRF24_TX_ADDR) {
+		width = 5;
+		return _addr[address == NRF24_TX_ADDR ? 2 : address - NRF24_RX_ADDR_P0];
+	}
+	width = 1;
+	if (address == NRF24_STATUS) {
+		_regs[address] = status();
+	} else if (address == NRF24_FIFO_STATUS) {
+		_regs[address] = (!_rxCount ? 0x01 : 0) | (_rxCount == NRF24_MODEL_FIFO ? 0x02 : 0) |
+		                 (!_txCount ? 0x10 : 0) | (_txCount == NRF24_MODEL_FIFO ? 0x20 : 0);
+	}
+	return &_regs[address];
+}
+
+void NRF24Model::push(payload *fifo, uint8_t &count, const payload &frame)
+{
+	if (count < NRF24_MODEL_FIFO) {
+		fifo[count++] = frame;
+	}
+}
+
+void NRF24Model::pop(payload *fifo, uint8_t &count)
+{
+	if (count) {
+		(void)memmove(&fifo[0], &fifo[1], --count * sizeof(fifo[0]));
+	}
+}
+
+void NRF24Model::select()
+{
+	_index = 0;
+}
+
+uint8_t NRF24Model::transfer(const uint8_t mosi)
+{
+	if (!_index++) {
+		// the command byte, STATUS is shifted out
+		_cmd = mosi;
+		if (_cmd == NRF24_FLUSH_TX) {
+			_txCount = 0;
+		} else if (_cmd == NRF24_FLUSH_RX) {
+			_rxCount = 0;
+		} else if (_cmd == NRF24_W_TX_PAYLOAD || _cmd == NRF24_W_TX_PAYLOAD_NO_ACK) {
+			_load.len = 0;
+			_load.noAck = (_cmd == NRF24_W_TX_PAYLOAD_NO_ACK);
+		}
+		return status();
+	}
+	const uint8_t i = _index - 2;
+	uint8_t width;
+	if (_cmd < NRF24_W_REGISTER) {
+		const uint8_t *value = reg(_cmd & 0x1F, width);
+		return i < width ? value[i] : 0;
+	}
+	if (_cmd < NRF24_W_REGISTER + 0x20) {
+		const uint8_t address = _cmd & 0x1F;
+		if (address == NRF24_STATUS) {
+			// the IRQ flags are cleared by writing 1
+			_regs[NRF24_STATUS] &= ~(mosi & NRF24_IRQS);
+		} else if (address != NRF24_OBSERVE_TX && address != NRF24_RPD &&
+		           address != NRF24_FIFO_STATUS) {
+			uint8_t *value = reg(address, width);
+			if (i < width) {
+				value[i] = mosi;
+			}
+		}
+		return 0;
+	}
+	if (_cmd == NRF24_R_RX_PL_WID) {
+		return _rxCount ? _rx[0].len : 0;
+	}
+	if (_cmd == NRF24_R_RX_PAYLOAD) {
+		return _rxCount && i < _rx[0].len ? _rx[0].data[i] : 0;
+	}
+	if ((_cmd == NRF24_W_TX_PAYLOAD || _cmd == NRF24_W_TX_PAYLOAD_NO_ACK) &&
+	        i < NRF24_MODEL_MAX_PAYLOAD) {
+		_load.data[i] = mosi;
+		_load.len = i + 1;
+	}
+	// ACTIVATE, W_ACK_PAYLOAD and NOP
+	return 0;
+}
+
+void NRF24Model::deselect()
+{
+	if (_cmd == NRF24_R_RX_PAYLOAD && _index > 1) {
+		pop(_rx, _rxCount);
+	} else if ((_cmd == NRF24_W_TX_PAYLOAD || _cmd == NRF24_W_TX_PAYLOAD_NO_ACK) && _load.len) {
+		push(_tx, _txCount, _load);
+	}
+	_cmd = 0;
+}
+
+void NRF24Model::pinWrite(const uint8_t pin, const uint8_t value)
+{
+	if (pin == _cePin) {
+		_ce = (value != LOW);
+	}
+}
+
+uint8_t NRF24Model::irqLevel()
+{
+	// active low, CONFIG masks the flags with the same bits
+	return (_regs[NRF24_STATUS] & NRF24_IRQS & ~_regs[NRF24_CONFIG]) ? LOW : HIGH;
+}
+
+void NRF24Model::update(const uint64_t now)
+{
+	const uint8_t config = _regs[NRF24_CONFIG];
+	if (_txBusy && now >= _txEnd) {
+		_txBusy = false;
+		transmitted(_tx[0].data, _tx[0].len);
+		if (_txAcked) {
+			_regs[NRF24_STATUS] |= NRF24_TX_DS;
+			pop(_tx, _txCount);
+		} else {
+			// the payload stays in the FIFO, TX halts until MAX_RT is cleared
+			_regs[NRF24_STATUS] |= NRF24_MAX_RT;
+		}
+	}
+	if (!_txBusy && _ce && (config & NRF24_PWR_UP) && !(config & NRF24_PRIM_RX) && _txCount &&
+	        !(_regs[NRF24_STATUS] & NRF24_MAX_RT)) {
+		const uint64_t attempt = NRF24_SETTLING_NS + airtime(_tx[0].len);
+		const uint8_t retries = _regs[NRF24_SETUP_RETR] & 0x0F;
+		_txBusy = true;
+		_txAcked = true;
+		_txEnd = now + attempt;
+		_regs[NRF24_OBSERVE_TX] &= 0xF0;
+		if (!_tx[0].noAck && (_regs[NRF24_EN_AA] & 0x01)) {
+			if (ack) {
+				// RX turnaround and the ACK frame
+				_txEnd += NRF24_SETTLING_NS + airtime(0);
+			} else {
+				// every retransmit waits ARD for the ACK
+				const uint64_t delay = ((_regs[NRF24_SETUP_RETR] >> 4) + 1u) * 250000ull;
+				_txEnd += retries * (delay + attempt);
+				_txAcked = false;
+				_regs[NRF24_OBSERVE_TX] |= retries;
+			}
+		}
+	}
+	if (_ce && (config & NRF24_PWR_UP) && (config & NRF24_PRIM_RX)) {
+		uint8_t frame[RADIO_MODEL_MAX_FRAME];
+		payload rx;
+		while (_rxCount < NRF24_MODEL_FIFO && (rx.len = received(now, frame, &rx.pipe))) {
+			if (rx.len > NRF24_MODEL_MAX_PAYLOAD) {
+				rx.len = NRF24_MODEL_MAX_PAYLOAD;
+			}
+			rx.noAck = false;
+			(void)memcpy(rx.data, frame, rx.len);
+			push(_rx, _rxCount, rx);
+			_regs[NRF24_STATUS] |= NRF24_RX_DR;
+		}
+	}
+}
+
+uint64_t NRF24Model::airtime(const uint8_t len)
+{
+	const uint8_t config = _regs[NRF24_CONFIG];
+	const uint8_t rfSetup = _regs[NRF24_RF_SETUP];
+	const uint8_t crc = (config & NRF24_EN_CRC) ? ((config & NRF24_CRCO) ? 2u : 1u) : 0u;
+	// preamble, address, payload and CRC, 9 bits of packet control field
+	const uint32_t bits = 8u * (1u + (_regs[NRF24_SETUP_AW] & 0x03) + 2u + len + crc) + 9u;
+	const uint32_t bitNanos = (rfSetup & 0x20) ? 4000u : ((rfSetup & 0x08) ? 500u : 1000u);
+	return (uint64_t)bits * bitNanos;
+}
@@ -0,0 +1,79 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#ifndef NRF24Model_h
+#define NRF24Model_h
+
+#include "RadioModel.h"
+
+#define NRF24_MODEL_FIFO 3u				//!< Depth of the TX and RX FIFOs
+#define NRF24_MODEL_MAX_PAYLOAD 32u		//!< Longest payload
+
+/**
+ * @brief nRF24L01+ with dynamic payloads, auto ACK and auto retransmit.
+ *
+ * A frame sent with auto ACK is acknowledged if ack is set, otherwise it ends with MAX_RT after
+ * all retransmits. Frames on the air are the payloads, the pipe is taken from deliver().
+ */
+class NRF24Model : public RadioModel
+{
+public:
+	/**
+	 * @param cePin GPIO of CE.
+	 */
+	explicit NRF24Model(const uint8_t cePin);
+	void select();
+	uint8_t transfer(const uint8_t mosi);
+	void deselect();
+	void pinWrite(const uint8_t pin, const uint8_t value);
+	uint8_t irqLevel();
+	void update(const uint64_t now);
+	uint64_t airtime(const uint8_t len);
+
+	bool ack;	//!< The peer acknowledges frames sent with auto ACK
+
+private:
+	struct payload {
+		uint8_t pipe;
+		uint8_t len;
+		bool noAck;
+		uint8_t data[NRF24_MODEL_MAX_PAYLOAD];
+	};
+	uint8_t status();
+	uint8_t *reg(const uint8_t address, uint8_t &width);
+	void push(payload *fifo, uint8_t &count, const payload &frame);
+	void pop(payload *fifo, uint8_t &count);
+
+	uint8_t _cePin;
+	bool _ce;
+	uint8_t _regs[0x20];
+	uint8_t _addr[3][5];	// RX_ADDR_P0, RX_ADDR_P1 and TX_ADDR
+	payload _tx[NRF24_MODEL_FIFO];
+	uint8_t _txCount;
+	payload _rx[NRF24_MODEL_FIFO];
+	uint8_t _rxCount;
+	payload _load;			// payload written by the current command
+	uint8_t _cmd;
+	uint8_t _index;			// bytes of the current frame
+	bool _txBusy;
+	bool _txAcked;
+	uint64_t _txEnd;
+};
+
+#endif
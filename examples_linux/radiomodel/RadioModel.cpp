@@ -0,0 +1,429 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// The hardware access of the Linux drivers on a simulated bus: SPIDEVClass, GPIOClass, the
+// interrupts and the clock of compatibility.cpp are replaced by the versions below, the objects
+// of the real ones are not linked. Time only advances by the cost of the bus, the delays and
+// the clock reads, so the figures do not depend on the host.
+
+#include "RadioModel.h"
+#include <string.h>
+#include <stdlib.h>
+#include "SPIDEV.h"
+#include "GPIO.h"
+#include "interrupt.h"
+
+static RadioModel *_model = NULL;
+static radioModelStats_t _stats;
+static uint64_t _now = 0;
+static uint32_t _submissionNanos = 0;
+static uint32_t _pinNanos = 0;
+static uint32_t _pollNanos = 1000u;
+
+static void (*_isr)(void) = NULL;
+static uint8_t _isrMode = NONE;
+static uint8_t _irqLevel = LOW;
+static bool _irqPending = false;
+static bool _irqEnabled = true;
+
+RadioModel::RadioModel() : onTransmit(NULL), _airCount(0)
+{
+}
+
+bool RadioModel::deliver(const uint8_t *data, const uint8_t len, const uint64_t at,
+                         const uint8_t pipe)
+{
+	if (_airCount == RADIO_MODEL_AIR_QUEUE) {
+		return false;
+	}
+	airFrame &frame = _air[_airCount++];
+	frame.at = at;
+	frame.pipe = pipe;
+	frame.len = len;
+	(void)memcpy(frame.data, data, len);
+	return true;
+}
+
+uint8_t RadioModel::received(const uint64_t now, uint8_t *data, uint8_t *pipe)
+{
+	if (!_airCount || _air[0].at > now) {
+		return 0;
+	}
+	const uint8_t len = _air[0].len;
+	(void)memcpy(data, _air[0].data, len);
+	if (pipe) {
+		*pipe = _air[0].pipe;
+	}
+	(void)memmove(&_air[0], &_air[1], --_airCount * sizeof(_air[0]));
+	return len;
+}
+
+void RadioModel::transmitted(const uint8_t *data, const uint8_t len)
+{
+	if (onTransmit) {
+		onTransmit(data, len);
+	}
+}
+
+// latch the edges of the IRQ line, the level only changes on the bus and in updates
+static void _sampleIrq(void)
+{
+	const uint8_t level = _model->irqLevel();
+	if (level != _irqLevel) {
+		if (_isr && (_isrMode == CHANGE || (_isrMode == RISING && level == HIGH) ||
+		             (_isrMode == FALLING && level == LOW))) {
+			_irqPending = true;
+		}
+		_irqLevel = level;
+	}
+}
+
+static void _advance(const uint64_t nanos)
+{
+	_now += nanos;
+	if (_model) {
+		_model->update(_now);
+		_sampleIrq();
+	}
+}
+
+// the interrupt is taken where the driver waits, never in the middle of a transfer
+static void _interrupt(void)
+{
+	if (_irqPending && _irqEnabled) {
+		_irqPending = false;
+		_isr();
+	}
+}
+
+static void _wait(const uint64_t nanos)
+{
+	_advance(nanos);
+	_interrupt();
+}
+
+void radioModelAttach(RadioModel *model)
+{
+	_model = model;
+	_irqLevel = model->irqLevel();
+	_irqPending = false;
+	model->update(_now);
+}
+
+void radioModelSetCosts(const uint32_t submissionNanos, const uint32_t pinNanos,
+                        const uint32_t pollNanos)
+{
+	_submissionNanos = submissionNanos;
+	_pinNanos = pinNanos;
+	_pollNanos = pollNanos;
+}
+
+uint64_t radioModelNow(void)
+{
+	return _now;
+}
+
+const radioModelStats_t *radioModelStats(void)
+{
+	return &_stats;
+}
+
+// SPI
+
+SPIDEVClass SPIDEV = SPIDEVClass();
+
+uint32_t SPIDEVClass::speed = SPI_CLOCK_BASE;
+struct spi_ioc_transfer SPIDEVClass::queue[SPI_TRANSFER_QUEUE_SIZE];
+uint8_t SPIDEVClass::queued = 0;
+
+SPIDEVClass::SPIDEVClass()
+{
+}
+
+void SPIDEVClass::begin(int busNo)
+{
+	(void)busNo;
+}
+
+void SPIDEVClass::end()
+{
+}
+
+void SPIDEVClass::setBitOrder(uint8_t bit_order)
+{
+	(void)bit_order;
+}
+
+void SPIDEVClass::setDataMode(uint8_t data_mode)
+{
+	(void)data_mode;
+}
+
+void SPIDEVClass::setClockDivider(uint16_t divider)
+{
+	speed = SPI_CLOCK_BASE / (divider ? divider : 1u);
+}
+
+void SPIDEVClass::chipSelect(int csn_chip)
+{
+	(void)csn_chip;
+}
+
+static uint64_t _frame(const char *tbuf, char *rbuf, const uint32_t len)
+{
+	if (!_model) {
+		abort();
+	}
+	_model->select();
+	for (uint32_t i = 0; i < len; i++) {
+		// in place transfers read the byte before it is overwritten
+		const uint8_t miso = _model->transfer((uint8_t)tbuf[i]);
+		if (rbuf) {
+			rbuf[i] = (char)miso;
+		}
+	}
+	_model->deselect();
+	_sampleIrq();
+	_stats.frames++;
+	_stats.bytes += len;
+	return len;
+}
+
+static void _submitted(const uint64_t bytes, const uint32_t speed)
+{
+	const uint64_t nanos = _submissionNanos + bytes * 8u * 1000000000ull / speed;
+	_stats.submissions++;
+	_stats.busNanos += nanos;
+	_advance(nanos);
+}
+
+uint8_t SPIDEVClass::transfer(uint8_t data)
+{
+	char miso;
+	_submitted(_frame((const char *)&data, &miso, 1), speed);
+	return (uint8_t)miso;
+}
+
+void SPIDEVClass::transfernb(char* tbuf, char* rbuf, uint32_t len)
+{
+	_submitted(_frame(tbuf, rbuf, len), speed);
+}
+
+void SPIDEVClass::transfern(char* buf, uint32_t len)
+{
+	transfernb(buf, buf, len);
+}
+
+void SPIDEVClass::queueTransfer(char* tbuf, char* rbuf, uint32_t len)
+{
+	if (queued == SPI_TRANSFER_QUEUE_SIZE) {
+		submitTransfers();
+	}
+	queue[queued].tx_buf = (unsigned long)tbuf;
+	queue[queued].rx_buf = (unsigned long)rbuf;
+	queue[queued].len = len;
+	queued++;
+}
+
+void SPIDEVClass::submitTransfers()
+{
+	if (!queued) {
+		return;
+	}
+	uint64_t bytes = 0;
+	for (uint8_t i = 0; i < queued; i++) {
+		bytes += _frame((const char *)queue[i].tx_buf, (char *)queue[i].rx_buf, queue[i].len);
+	}
+	queued = 0;
+	_submitted(bytes, speed);
+}
+
+void SPIDEVClass::beginTransaction(SPISettings settings)
+{
+	speed = settings.clock;
+}
+
+void SPIDEVClass::endTransaction()
+{
+}
+
+void SPIDEVClass::usingInterrupt(uint8_t interruptNumber)
+{
+	(void)interruptNumber;
+}
+
+void SPIDEVClass::notUsingInterrupt(uint8_t interruptNumber)
+{
+	(void)interruptNumber;
+}
+
+// GPIO
+
+GPIOClass GPIO = GPIOClass();
+
+GPIOClass::GPIOClass() : lastPinNum(0), exportedPins(NULL), lineFds(NULL), numChips(0)
+{
+}
+
+GPIOClass::GPIOClass(const GPIOClass& other) : lastPinNum(other.lastPinNum), exportedPins(NULL),
+	lineFds(NULL), numChips(0)
+{
+}
+
+GPIOClass::~GPIOClass()
+{
+}
+
+void GPIOClass::pinMode(uint8_t pin, uint8_t mode)
+{
+	(void)pin;
+	(void)mode;
+}
+
+void GPIOClass::digitalWrite(uint8_t pin, uint8_t value)
+{
+	_stats.pinWrites++;
+	_stats.busNanos += _pinNanos;
+	if (_model) {
+		_model->pinWrite(pin, value);
+	}
+	_advance(_pinNanos);
+}
+
+uint8_t GPIOClass::digitalRead(uint8_t pin)
+{
+	(void)pin;
+	return _model ? _model->irqLevel() : LOW;
+}
+
+int GPIOClass::requestEvents(uint8_t pin, uint32_t eventFlags)
+{
+	(void)pin;
+	(void)eventFlags;
+	return -1;
+}
+
+void GPIOClass::releaseEvents(uint8_t pin)
+{
+	(void)pin;
+}
+
+uint8_t GPIOClass::digitalPinToInterrupt(uint8_t pin)
+{
+	return pin;
+}
+
+GPIOClass& GPIOClass::operator=(const GPIOClass& other)
+{
+	lastPinNum = other.lastPinNum;
+	return *this;
+}
+
+// interrupts, the radio has one IRQ line
+
+void attachInterrupt(uint8_t gpioPin, void (*func)(), uint8_t mode)
+{
+	(void)gpioPin;
+	_isr = func;
+	_isrMode = mode;
+	_irqPending = false;
+	if (_model) {
+		_irqLevel = _model->irqLevel();
+	}
+}
+
+void detachInterrupt(uint8_t gpioPin)
+{
+	(void)gpioPin;
+	_isr = NULL;
+	_irqPending = false;
+}
+
+uint64_t interruptTimestamp(uint8_t gpioPin)
+{
+	(void)gpioPin;
+	return _now / 1000u;
+}
+
+void interruptSetScheduling(int policy, int priority, int cpu)
+{
+	(void)policy;
+	(void)priority;
+	(void)cpu;
+}
+
+void interrupts()
+{
+	_irqEnabled = true;
+}
+
+void noInterrupts()
+{
+	_irqEnabled = false;
+}
+
+// clock, a busy wait advances by the cost of reading the clock
+
+void yield(void) {}
+
+unsigned long millis(void)
+{
+	_wait(_pollNanos);
+	return (unsigned long)(_now / 1000000u);
+}
+
+unsigned long micros()
+{
+	_wait(_pollNanos);
+	return (unsigned long)(_now / 1000u);
+}
+
+void _delay_milliseconds(unsigned int millis)
+{
+	_wait((uint64_t)millis * 1000000u);
+}
+
+void _delay_microseconds(unsigned int micro)
+{
+	_wait((uint64_t)micro * 1000u);
+}
+
+void randomSeed(unsigned long seed)
+{
+	if (seed != 0) {
+		srand(seed);
+	}
+}
+
+long randMax(long howbig)
+{
+	if (howbig == 0) {
+		return 0;
+	}
+	return rand() % howbig;
+}
+
+long randMinMax(long howsmall, long howbig)
+{
+	if (howsmall >= howbig) {
+		return howsmall;
+	}
+	long diff = howbig - howsmall;
+	return randMax(diff) + howsmall;
+}
@@ -0,0 +1,152 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#ifndef RadioModel_h
+#define RadioModel_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RADIO_MODEL_AIR_QUEUE 4u		//!< Frames on their way to the radio
+#define RADIO_MODEL_MAX_FRAME 255u	//!< Longest frame on the air
+
+/**
+ * @brief SPI and GPIO cost counted by the simulated bus.
+ */
+typedef struct {
+	uint32_t frames;		//!< chip select frames
+	uint32_t submissions;	//!< spidev ioctls, one carries up to SPI_TRANSFER_QUEUE_SIZE frames
+	uint32_t bytes;			//!< bytes clocked, in both directions at once
+	uint32_t pinWrites;		//!< GPIO writes
+	uint64_t busNanos;		//!< time spent on the bus and the GPIOs, the overheads included
+} radioModelStats_t;
+
+/**
+ * @brief Register file of a radio behind the simulated SPI bus and GPIOs.
+ *
+ * The bus calls select(), transfer() for every byte and deselect() for each chip select frame.
+ * update() is called whenever the simulated time advances, events that are due change the
+ * registers and the IRQ line there. Frames are exchanged with the air in the format of the FIFO
+ * of the radio: frames sent are passed to the onTransmit callback, frames to receive are queued
+ * with deliver().
+ */
+class RadioModel
+{
+public:
+	/**
+	 * @brief Called with every frame sent, from update().
+	 */
+	typedef void (*transmit_t)(const uint8_t *data, const uint8_t len);
+
+	RadioModel();
+	virtual ~RadioModel() {}
+	/**
+	 * @brief Chip select asserted, the next byte is a command or an address.
+	 */
+	virtual void select() = 0;
+	/**
+	 * @brief Exchange one byte.
+	 * @param mosi byte from the host.
+	 * @return byte to the host.
+	 */
+	virtual uint8_t transfer(const uint8_t mosi) = 0;
+	/**
+	 * @brief Chip select released.
+	 */
+	virtual void deselect() {}
+	/**
+	 * @brief A GPIO was written, e.g. CE of the nRF24.
+	 */
+	virtual void pinWrite(const uint8_t pin, const uint8_t value)
+	{
+		(void)pin;
+		(void)value;
+	}
+	/**
+	 * @brief Level of the IRQ line.
+	 */
+	virtual uint8_t irqLevel() = 0;
+	/**
+	 * @brief The simulated time advanced.
+	 * @param now simulated time in ns.
+	 */
+	virtual void update(const uint64_t now) = 0;
+	/**
+	 * @brief Time on air of a frame of len bytes with the current configuration, in ns.
+	 */
+	virtual uint64_t airtime(const uint8_t len) = 0;
+	/**
+	 * @brief Queue a frame to be received.
+	 *
+	 * The frame is received once the time has come and the radio listens. A radio that does not
+	 * listen when the frame arrives receives it as soon as it does, unlike real radios.
+	 * @param data frame in the format of the FIFO.
+	 * @param len length of data.
+	 * @param at simulated time of the end of the frame in ns.
+	 * @param pipe RX pipe, used by the nRF24 only.
+	 * @return false if the queue is full.
+	 */
+	bool deliver(const uint8_t *data, const uint8_t len, const uint64_t at, const uint8_t pipe = 0);
+
+	transmit_t onTransmit;	//!< Callback for the frames sent, NULL to drop them
+
+protected:
+	/**
+	 * @brief Take the next frame that arrived by now.
+	 * @return length, 0 if there is none.
+	 */
+	uint8_t received(const uint64_t now, uint8_t *data, uint8_t *pipe = NULL);
+	/**
+	 * @brief Pass a frame sent to the callback.
+	 */
+	void transmitted(const uint8_t *data, const uint8_t len);
+
+private:
+	struct airFrame {
+		uint64_t at;
+		uint8_t pipe;
+		uint8_t len;
+		uint8_t data[RADIO_MODEL_MAX_FRAME];
+	};
+	airFrame _air[RADIO_MODEL_AIR_QUEUE];
+	uint8_t _airCount;
+};
+
+/**
+ * @brief Put model behind the SPI bus, the GPIOs and the interrupt of the drivers.
+ */
+void radioModelAttach(RadioModel *model);
+/**
+ * @brief Set the cost of the simulated bus.
+ * @param submissionNanos overhead of a spidev ioctl.
+ * @param pinNanos cost of a GPIO write.
+ * @param pollNanos cost of a millis() or micros() call, busy waits advance by it.
+ */
+void radioModelSetCosts(const uint32_t submissionNanos, const uint32_t pinNanos,
+                        const uint32_t pollNanos);
+/**
+ * @brief Simulated time in ns.
+ */
+uint64_t radioModelNow(void);
+/**
+ * @brief SPI and GPIO cost so far.
+ */
+const radioModelStats_t *radioModelStats(void);
+
+#endif
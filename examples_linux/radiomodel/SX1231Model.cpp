@@ -0,0 +1,209 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "SX1231Model.h"
+#include <string.h>
+#include "GPIO.h"
+
+// registers, see the SX1231 datasheet
+#define SX1231_FIFO				(0x00)
+#define SX1231_OPMODE			(0x01)
+#define SX1231_BITRATEMSB		(0x03)
+#define SX1231_BITRATELSB		(0x04)
+#define SX1231_VERSION			(0x10)
+#define SX1231_RSSIVALUE		(0x24)
+#define SX1231_DIOMAPPING1		(0x25)
+#define SX1231_IRQFLAGS1		(0x27)
+#define SX1231_IRQFLAGS2		(0x28)
+#define SX1231_PREAMBLEMSB		(0x2C)
+#define SX1231_PREAMBLELSB		(0x2D)
+#define SX1231_SYNCCONFIG		(0x2E)
+#define SX1231_PACKETCONFIG1	(0x37)
+#define SX1231_FIFOTHRESH		(0x3C)
+#define SX1231_PACKETCONFIG2	(0x3D)
+
+#define SX1231_MODE_TX	(3u)
+#define SX1231_MODE_RX	(4u)
+
+SX1231Model::SX1231Model() : rssi(120u), _fifoCount(0), _address(0), _write(false),
+	_addressed(false), _packetSent(false), _payloadReady(false), _txBusy(false), _txEnd(0), _now(0)
+{
+	(void)memset(_regs, 0, sizeof(_regs));
+	_regs[SX1231_OPMODE] = 0x04;
+	_regs[SX1231_BITRATEMSB] = 0x1A;
+	_regs[SX1231_BITRATELSB] = 0x0B;
+	_regs[SX1231_VERSION] = 0x24;
+	_regs[SX1231_RSSIVALUE] = 0xFF;
+	_regs[SX1231_PREAMBLELSB] = 0x03;
+	_regs[SX1231_SYNCCONFIG] = 0x98;
+	_regs[SX1231_PACKETCONFIG1] = 0x10;
+	_regs[SX1231_FIFOTHRESH] = 0x8F;
+	_regs[SX1231_PACKETCONFIG2] = 0x02;
+}
+
+uint8_t SX1231Model::mode()
+{
+	return (_regs[SX1231_OPMODE] >> 2) & 0x07;
+}
+
+uint8_t SX1231Model::irqFlags2()
+{
+	return (_fifoCount == SX1231_MODEL_FIFO ? 0x80 : 0) | (_fifoCount ? 0x40 : 0) |
+	       (_fifoCount > (_regs[SX1231_FIFOTHRESH] & 0x7F) ? 0x20 : 0) | (_packetSent ? 0x08 : 0) |
+	       (_payloadReady ? 0x06 : 0);
+}
+
+void SX1231Model::clearFifo()
+{
+	_fifoCount = 0;
+	_payloadReady = false;
+}
+
+void SX1231Model::write(const uint8_t address, const uint8_t value)
+{
+	if (address == SX1231_FIFO) {
+		if (_fifoCount < SX1231_MODEL_FIFO) {
+			_fifo[_fifoCount++] = value;
+		}
+	} else if (address == SX1231_OPMODE) {
+		const uint8_t previous = mode();
+		// ListenAbort reads as 0
+		_regs[SX1231_OPMODE] = value & ~0x20;
+		if (mode() == previous) {
+			return;
+		}
+		if (previous == SX1231_MODE_TX) {
+			_packetSent = false;
+			_txBusy = false;
+		}
+		if (mode() == SX1231_MODE_TX && _fifoCount) {
+			_txBusy = true;
+			_txEnd = _now + airtime(_fifo[0] + 1u);
+		} else if (mode() == SX1231_MODE_RX) {
+			clearFifo();
+			_regs[SX1231_RSSIVALUE] = 0xFF;
+		}
+	} else if (address == SX1231_IRQFLAGS2) {
+		// writing FifoOverrun clears the FIFO
+		if (value & 0x10) {
+			clearFifo();
+		}
+	} else if (address == SX1231_PACKETCONFIG2) {
+		// RestartRx clears itself
+		_regs[address] = value & ~0x04;
+	} else if (address != SX1231_VERSION && address != SX1231_RSSIVALUE &&
+	           address != SX1231_IRQFLAGS1) {
+		_regs[address] = value;
+	}
+}
+
+uint8_t SX1231Model::read(const uint8_t address)
+{
+	if (address == SX1231_FIFO) {
+		if (!_fifoCount) {
+			return 0;
+		}
+		const uint8_t value = _fifo[0];
+		(void)memmove(&_fifo[0], &_fifo[1], --_fifoCount);
+		if (!_fifoCount) {
+			_payloadReady = false;
+		}
+		return value;
+	}
+	if (address == SX1231_IRQFLAGS1) {
+		// ModeReady, RxReady and TxReady
+		return 0x80 | (mode() == SX1231_MODE_RX ? 0x40 : 0) | (mode() == SX1231_MODE_TX ? 0x20 : 0);
+	}
+	if (address == SX1231_IRQFLAGS2) {
+		return irqFlags2();
+	}
+	return _regs[address];
+}
+
+void SX1231Model::select()
+{
+	_addressed = false;
+}
+
+uint8_t SX1231Model::transfer(const uint8_t mosi)
+{
+	if (!_addressed) {
+		_addressed = true;
+		_write = (mosi & 0x80);
+		_address = mosi & 0x7F;
+		return 0;
+	}
+	uint8_t miso = 0;
+	if (_write) {
+		write(_address, mosi);
+	} else {
+		miso = read(_address);
+	}
+	if (_address != SX1231_FIFO) {
+		_address = (_address + 1u) & 0x7F;
+	}
+	return miso;
+}
+
+uint8_t SX1231Model::irqLevel()
+{
+	// DIO0 is PacketSent in TX with mapping 00, PayloadReady in RX with mapping 01
+	const uint8_t mapping = _regs[SX1231_DIOMAPPING1] >> 6;
+	if (mode() == SX1231_MODE_TX) {
+		return mapping == 0 && _packetSent ? HIGH : LOW;
+	}
+	if (mode() == SX1231_MODE_RX) {
+		return mapping <= 1 && _payloadReady ? HIGH : LOW;
+	}
+	return LOW;
+}
+
+void SX1231Model::update(const uint64_t now)
+{
+	_now = now;
+	if (_txBusy && now >= _txEnd) {
+		_txBusy = false;
+		_packetSent = true;
+		const uint8_t len = _fifo[0] + 1u;
+		transmitted(_fifo, len < _fifoCount ? len : _fifoCount);
+		_fifoCount = 0;
+	}
+	if (mode() == SX1231_MODE_RX && !_payloadReady) {
+		uint8_t frame[RADIO_MODEL_MAX_FRAME];
+		const uint8_t len = received(now, frame);
+		if (len) {
+			_fifoCount = len < SX1231_MODEL_FIFO ? len : SX1231_MODEL_FIFO;
+			(void)memcpy(_fifo, frame, _fifoCount);
+			_payloadReady = true;
+			_regs[SX1231_RSSIVALUE] = rssi;
+		}
+	}
+}
+
+uint64_t SX1231Model::airtime(const uint8_t len)
+{
+	const uint8_t sync = _regs[SX1231_SYNCCONFIG];
+	const uint32_t bitrate = (uint32_t)_regs[SX1231_BITRATEMSB] << 8 | _regs[SX1231_BITRATELSB];
+	const uint32_t preamble = (uint32_t)_regs[SX1231_PREAMBLEMSB] << 8 | _regs[SX1231_PREAMBLELSB];
+	// preamble, sync word, the frame with its length byte and the CRC
+	const uint32_t bits = 8u * (preamble + ((sync & 0x80) ? ((sync >> 3) & 0x07) + 1u : 0u) + len +
+	                            ((_regs[SX1231_PACKETCONFIG1] & 0x10) ? 2u : 0u));
+	// the bit time is the bitrate register / 32MHz
+	return (uint64_t)bits * bitrate * 1000u / 32u;
+}
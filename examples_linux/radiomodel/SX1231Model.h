@@ -0,0 +1,65 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#ifndef SX1231Model_h
+#define SX1231Model_h
+
+#include "RadioModel.h"
+
+#define SX1231_MODEL_FIFO 66u	//!< FIFO size
+
+/**
+ * @brief SX1231 (RFM69) in packet mode with variable length frames.
+ *
+ * Modes are ready at once. A frame is received once the radio is in RX, the RSSI reads as a free
+ * channel otherwise. Frames on the air start with the length byte, as in the FIFO.
+ */
+class SX1231Model : public RadioModel
+{
+public:
+	SX1231Model();
+	void select();
+	uint8_t transfer(const uint8_t mosi);
+	uint8_t irqLevel();
+	void update(const uint64_t now);
+	uint64_t airtime(const uint8_t len);
+
+	uint8_t rssi;	//!< RSSI register value of the frames received, -rssi/2 dBm
+
+private:
+	uint8_t mode();
+	uint8_t irqFlags2();
+	void write(const uint8_t address, const uint8_t value);
+	uint8_t read(const uint8_t address);
+	void clearFifo();
+
+	uint8_t _regs[0x80];
+	uint8_t _fifo[SX1231_MODEL_FIFO];
+	uint8_t _fifoCount;
+	uint8_t _address;		// register of the current frame, the FIFO does not increment
+	bool _write;
+	bool _addressed;
+	bool _packetSent;
+	bool _payloadReady;
+	bool _txBusy;
+	uint64_t _txEnd;
+	uint64_t _now;
+};
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "SX1276Model.h"
+#include <string.h>
+#include "GPIO.h"
+
+// registers, see the SX1276 datasheet
+#define SX1276_FIFO				(0x00)
+#define SX1276_OPMODE			(0x01)
+#define SX1276_FIFOADDRPTR		(0x0D)
+#define SX1276_FIFOTXBASEADDR	(0x0E)
+#define SX1276_FIFORXBASEADDR	(0x0F)
+#define SX1276_FIFORXCURRENTADDR	(0x10)
+#define SX1276_IRQFLAGSMASK		(0x11)
+#define SX1276_IRQFLAGS			(0x12)
+#define SX1276_RXNBBYTES		(0x13)
+#define SX1276_PKTSNRVALUE		(0x19)
+#define SX1276_PKTRSSIVALUE		(0x1A)
+#define SX1276_MODEMCONFIG1		(0x1D)
+#define SX1276_MODEMCONFIG2		(0x1E)
+#define SX1276_PREAMBLEMSB		(0x20)
+#define SX1276_PREAMBLELSB		(0x21)
+#define SX1276_PAYLOADLENGTH	(0x22)
+#define SX1276_MODEMCONFIG3		(0x26)
+#define SX1276_DIOMAPPING1		(0x40)
+#define SX1276_VERSION			(0x42)
+
+#define SX1276_MODE_STDBY			(1u)
+#define SX1276_MODE_TX				(3u)
+#define SX1276_MODE_RXCONTINUOUS	(5u)
+#define SX1276_MODE_CAD				(7u)
+
+#define SX1276_RX_DONE		(0x40)
+#define SX1276_VALID_HEADER	(0x10)
+#define SX1276_TX_DONE		(0x08)
+#define SX1276_CAD_DONE		(0x04)
+
+SX1276Model::SX1276Model() : rssi(0x40u), snr(40), _address(0), _write(false), _addressed(false),
+	_busy(false), _end(0), _now(0)
+{
+	(void)memset(_regs, 0, sizeof(_regs));
+	(void)memset(_fifo, 0, sizeof(_fifo));
+	_regs[SX1276_OPMODE] = 0x09;
+	_regs[SX1276_FIFOTXBASEADDR] = 0x80;
+	_regs[SX1276_MODEMCONFIG1] = 0x72;
+	_regs[SX1276_MODEMCONFIG2] = 0x70;
+	_regs[SX1276_PREAMBLELSB] = 0x08;
+	_regs[SX1276_PAYLOADLENGTH] = 0x01;
+	_regs[0x23] = 0xFF;
+	_regs[SX1276_VERSION] = 0x12;
+}
+
+uint8_t SX1276Model::mode()
+{
+	return _regs[SX1276_OPMODE] & 0x07;
+}
+
+void SX1276Model::write(const uint8_t address, const uint8_t value)
+{
+	if (address == SX1276_FIFO) {
+		_fifo[_regs[SX1276_FIFOADDRPTR]++] = value;
+	} else if (address == SX1276_OPMODE) {
+		const uint8_t previous = mode();
+		_regs[SX1276_OPMODE] = value;
+		if (mode() == previous) {
+			return;
+		}
+		_busy = (mode() == SX1276_MODE_TX || mode() == SX1276_MODE_CAD);
+		if (mode() == SX1276_MODE_TX) {
+			_end = _now + airtime(_regs[SX1276_PAYLOADLENGTH]);
+		} else if (mode() == SX1276_MODE_CAD) {
+			// about two symbols
+			_end = _now + 2u * symbolNanos();
+		}
+	} else if (address == SX1276_IRQFLAGS) {
+		// cleared by writing 1
+		_regs[SX1276_IRQFLAGS] &= ~value;
+	} else if (address != SX1276_FIFORXCURRENTADDR && address != SX1276_RXNBBYTES &&
+	           address != SX1276_PKTSNRVALUE && address != SX1276_PKTRSSIVALUE &&
+	           address != SX1276_VERSION) {
+		_regs[address] = value;
+	}
+}
+
+uint8_t SX1276Model::read(const uint8_t address)
+{
+	if (address == SX1276_FIFO) {
+		return _fifo[_regs[SX1276_FIFOADDRPTR]++];
+	}
+	return _regs[address];
+}
+
+void SX1276Model::select()
+{
+	_addressed = false;
+}
+
+uint8_t SX1276Model::transfer(const uint8_t mosi)
+{
+	if (!_addressed) {
+		_addressed = true;
+		_write = (mosi & 0x80);
+		_address = mosi & 0x7F;
+		return 0;
+	}
+	uint8_t miso = 0;
+	if (_write) {
+		write(_address, mosi);
+	} else {
+		miso = read(_address);
+	}
+	if (_address != SX1276_FIFO) {
+		_address = (_address + 1u) & 0x7F;
+	}
+	return miso;
+}
+
+uint8_t SX1276Model::irqLevel()
+{
+	// DIO0 mapping 00 RxDone, 01 TxDone, 10 CadDone
+	static const uint8_t flags[4] = { SX1276_RX_DONE, SX1276_TX_DONE, SX1276_CAD_DONE, 0 };
+	const uint8_t flag = flags[_regs[SX1276_DIOMAPPING1] >> 6];
+	return (_regs[SX1276_IRQFLAGS] & ~_regs[SX1276_IRQFLAGSMASK] & flag) ? HIGH : LOW;
+}
+
+void SX1276Model::update(const uint64_t now)
+{
+	_now = now;
+	if (_busy && now >= _end) {
+		_busy = false;
+		if (mode() == SX1276_MODE_TX) {
+			const uint8_t base = _regs[SX1276_FIFOTXBASEADDR];
+			const uint8_t len = _regs[SX1276_PAYLOADLENGTH];
+			uint8_t frame[256];
+			for (uint16_t i = 0; i < len; i++) {
+				frame[i] = _fifo[(uint8_t)(base + i)];
+			}
+			transmitted(frame, len);
+			_regs[SX1276_IRQFLAGS] |= SX1276_TX_DONE;
+		} else {
+			// the channel is always free
+			_regs[SX1276_IRQFLAGS] |= SX1276_CAD_DONE;
+		}
+		_regs[SX1276_OPMODE] = (_regs[SX1276_OPMODE] & ~0x07) | SX1276_MODE_STDBY;
+	}
+	if (mode() == SX1276_MODE_RXCONTINUOUS && !(_regs[SX1276_IRQFLAGS] & SX1276_RX_DONE)) {
+		uint8_t frame[RADIO_MODEL_MAX_FRAME];
+		const uint8_t len = received(now, frame);
+		if (len) {
+			const uint8_t base = _regs[SX1276_FIFORXBASEADDR];
+			for (uint16_t i = 0; i < len; i++) {
+				_fifo[(uint8_t)(base + i)] = frame[i];
+			}
+			_regs[SX1276_FIFORXCURRENTADDR] = base;
+			_regs[SX1276_RXNBBYTES] = len;
+			_regs[SX1276_PKTSNRVALUE] = (uint8_t)snr;
+			_regs[SX1276_PKTRSSIVALUE] = rssi;
+			_regs[SX1276_IRQFLAGS] |= SX1276_RX_DONE | SX1276_VALID_HEADER;
+		}
+	}
+}
+
+uint64_t SX1276Model::symbolNanos()
+{
+	// bandwidth in 100Hz by register value
+	static const uint16_t bandwidth[16] = { 78u, 104u, 156u, 208u, 313u, 417u, 625u, 1250u, 2500u, 5000u,
+	                                        5000u, 5000u, 5000u, 5000u, 5000u, 5000u
+	                                      };
+	const uint8_t SF = _regs[SX1276_MODEMCONFIG2] >> 4;
+	return (1ull << SF) * 10000000u / bandwidth[_regs[SX1276_MODEMCONFIG1] >> 4];
+}
+
+uint64_t SX1276Model::airtime(const uint8_t len)
+{
+	const uint8_t config1 = _regs[SX1276_MODEMCONFIG1];
+	const uint8_t config2 = _regs[SX1276_MODEMCONFIG2];
+	const uint8_t SF = config2 >> 4;
+	const uint8_t CR = (config1 >> 1) & 0x07;
+	const uint8_t LDRO = (_regs[SX1276_MODEMCONFIG3] & 0x08) ? 2u : 0u;
+	const int16_t bits = 8 * len - 4 * SF + 28 + ((config2 & 0x04) ? 16 : 0) - ((config1 & 0x01) ? 20 : 0);
+	const uint8_t bitsPerSymbol = 4u * (SF - LDRO);
+	uint32_t symbols = 8u;
+	if (bits > 0) {
+		symbols += ((bits + bitsPerSymbol - 1) / bitsPerSymbol) * (CR + 4u);
+	}
+	// preamble + 4.25 symbols and payload
+	const uint32_t preamble = (uint32_t)_regs[SX1276_PREAMBLEMSB] << 8 | _regs[SX1276_PREAMBLELSB];
+	return (preamble * 4u + 17u + symbols * 4u) * symbolNanos() / 4u;
+}
@@ -0,0 +1,60 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#ifndef SX1276Model_h
+#define SX1276Model_h
+
+#include "RadioModel.h"
+
+/**
+ * @brief SX1276 (RFM95) in LoRa mode with explicit header.
+ *
+ * TX and CAD return to STDBY when done, CAD never detects activity. Frames are received in
+ * RXCONTINUOUS and placed at FifoRxBaseAddr.
+ */
+class SX1276Model : public RadioModel
+{
+public:
+	SX1276Model();
+	void select();
+	uint8_t transfer(const uint8_t mosi);
+	uint8_t irqLevel();
+	void update(const uint64_t now);
+	uint64_t airtime(const uint8_t len);
+
+	uint8_t rssi;	//!< PktRssiValue of the frames received
+	int8_t snr;		//!< PktSnrValue of the frames received
+
+private:
+	uint8_t mode();
+	uint64_t symbolNanos();
+	void write(const uint8_t address, const uint8_t value);
+	uint8_t read(const uint8_t address);
+
+	uint8_t _regs[0x80];
+	uint8_t _fifo[256];
+	uint8_t _address;
+	bool _write;
+	bool _addressed;
+	bool _busy;			// TX or CAD running
+	uint64_t _end;
+	uint64_t _now;
+};
+
+#endif
@@ -19,8 +19,15 @@
 
 #include "MyHwAVR.h"
 
+#if defined(MY_AVR_SLEEP_TIMER2)
+static void hwTimer2Init(void);
+#endif
+
 bool hwInit(void)
 {
+#if defined(MY_AVR_SLEEP_TIMER2)
+	hwTimer2Init();
+#endif
 #if !defined(MY_DISABLED_SERIAL)
 	MY_SERIALDEVICE.begin(MY_BAUD_RATE);
 #if defined(MY_GATEWAY_SERIAL)
@@ -79,7 +86,87 @@ ISR (WDT_vect)
 {
 }
 
-void hwPowerDown(const uint8_t wdto)
+void hwIdle(const uint32_t ms)
+{
+	(void)ms;
+	// timers, SPI, TWI, UART and external interrupts keep running
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	sleep_enable();
+	sleep_cpu();
+	sleep_disable();
+}
+
+#if defined(MY_WITH_LEDS_BLINKING_TIMER)
+static void (*_hwLedTimerUpdate)(void) = NULL;
+static uint16_t _hwLedTimerPeriod = 0;
+static uint16_t _hwLedTimerAt = 0;
+
+// Timer0 counts millis(), its compare B match comes once per overflow whatever OCR0B holds, so
+// analogWrite() on the OC0B pin does not change the rate
+ISR (TIMER0_COMPB_vect)
+{
+	const uint16_t now = (uint16_t)millis();
+	if ((uint16_t)(now - _hwLedTimerAt) >= _hwLedTimerPeriod) {
+		_hwLedTimerAt = now;
+		_hwLedTimerUpdate();
+	}
+}
+
+void hwLedTimerStart(void (*update)(void), const uint16_t periodMs)
+{
+	MY_CRITICAL_SECTION {
+		_hwLedTimerUpdate = update;
+		_hwLedTimerPeriod = periodMs;
+		_hwLedTimerAt = (uint16_t)millis();
+		TIFR0 = _BV(OCF0B);
+		TIMSK0 |= _BV(OCIE0B);
+	}
+}
+
+void hwLedTimerStop(void)
+{
+	MY_CRITICAL_SECTION {
+		TIMSK0 &= ~_BV(OCIE0B);
+	}
+}
+#endif
+
+#if defined(MY_PROFILING)
+static volatile uint16_t _hwCyclesOverflows = 0;
+
+ISR (TIMER1_OVF_vect)
+{
+	_hwCyclesOverflows++;
+}
+
+void hwCycleCounterInit(void)
+{
+	// normal mode, no prescaler
+	TCCR1A = 0;
+	TCCR1C = 0;
+	TCNT1 = 0;
+	TIFR1 = _BV(TOV1);
+	TIMSK1 = _BV(TOIE1);
+	TCCR1B = _BV(CS10);
+}
+
+uint32_t hwCycles(void)
+{
+	uint16_t overflows;
+	uint16_t count;
+	MY_CRITICAL_SECTION {
+		count = TCNT1;
+		overflows = _hwCyclesOverflows;
+		// account an overflow that happened since interrupts were disabled
+		if ((TIFR1 & _BV(TOV1)) && count < 0x8000u) {
+			overflows++;
+		}
+	}
+	return ((uint32_t)overflows << 16) | count;
+}
+#endif
+
+static void hwPowerSleep(const uint8_t wdto, const uint8_t mode)
 {
 	// Let serial prints finish (debug, log etc)
 #ifndef MY_DISABLED_SERIAL
@@ -98,7 +185,7 @@ void hwPowerDown(const uint8_t wdto)
 		// if sleeping forever, disable WDT
 		wdt_disable();
 	}
-	set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+	set_sleep_mode(mode);
 	cli();
 	sleep_enable();
 #if defined(__AVR_ATmega328P__)
@@ -120,8 +207,88 @@ void hwPowerDown(const uint8_t wdto)
 	sei();
 	// enable ADC
 	ADCSRA |= (1 << ADEN);
+#if defined(MY_AVR_CPU_VOLTAGE_ASYNC)
+	// Vref settles while the node works after the wake-up
+	hwCPUVoltageStart();
+#endif
+}
+
+void hwPowerDown(const uint8_t wdto)
+{
+	hwPowerSleep(wdto, SLEEP_MODE_PWR_DOWN);
+}
+
+#if defined(MY_AVR_SLEEP_TIMER2)
+// Timer2 runs from the 32.768kHz crystal. With the fine prescaler it counts 1024 ticks per
+// second, with the coarse one 32, so one coarse tick equals 32 fine ticks.
+#define TIMER2_PRESCALER_FINE		(_BV(CS21) | _BV(CS20))				// clk/32
+#define TIMER2_PRESCALER_COARSE		(_BV(CS22) | _BV(CS21) | _BV(CS20))	// clk/1024
+#define TIMER2_COARSE_SHIFT			(5u)
+
+// Timer2 compare match, only wakes the mcu from power-save
+ISR (TIMER2_COMPA_vect)
+{
+}
+
+static void hwTimer2Init(void)
+{
+	// Ref: ATMega328P datasheet, asynchronous operation of Timer/Counter2
+	TIMSK2 = 0;
+	ASSR = _BV(AS2);
+	TCCR2A = 0;
+	TCCR2B = TIMER2_PRESCALER_COARSE;
+	TCNT2 = 0;
+	while (ASSR & (_BV(TCN2UB) | _BV(TCR2AUB) | _BV(TCR2BUB))) {}
+	TIFR2 = _BV(OCF2B) | _BV(OCF2A) | _BV(TOV2);
+}
+
+static uint8_t hwTimer2Sleep(const uint8_t prescaler, const uint8_t ticks)
+{
+	TCCR2B = prescaler;
+	TCNT2 = 0;
+	OCR2A = ticks;
+	// the registers are updated in the crystal clock domain, the timer would not wake the mcu
+	// if it went to sleep before they are
+	while (ASSR & (_BV(TCN2UB) | _BV(OCR2AUB) | _BV(TCR2BUB))) {}
+	TIFR2 = _BV(OCF2A);
+	TIMSK2 = _BV(OCIE2A);
+	hwPowerSleep(WDTO_SLEEP_FOREVER, SLEEP_MODE_PWR_SAVE);
+	TIMSK2 = 0;
+	// TCNT2 reads a stale value right after the wake-up, a register write that passed the
+	// crystal clock domain assures a full crystal cycle passed
+	OCR2B = 0;
+	while (ASSR & _BV(OCR2BUB)) {}
+	const uint8_t elapsed = TCNT2;
+	if ((TIFR2 & _BV(OCF2A)) || elapsed > ticks) {
+		return ticks;
+	}
+	return elapsed;
 }
 
+uint32_t hwInternalSleep(uint32_t ms)
+{
+	// ms to 1/1024s ticks, rounded up to assure we sleep at least the requested amount of time
+	uint32_t ticks = ms + (ms / 125u) * 3u + ((ms % 125u) * 3u + 124u) / 125u;
+	if (ticks < ms) {
+		ticks = UINT32_MAX;
+	}
+	while (!interruptWakeUp() && ticks > 0u) {
+		if (ticks >= (1u << TIMER2_COARSE_SHIFT)) {
+			// whole coarse ticks first, a wake-up by interrupt discards the partial one
+			const uint32_t coarse = ticks >> TIMER2_COARSE_SHIFT;
+			const uint8_t chunk = coarse > UINT8_MAX ? UINT8_MAX : (uint8_t)coarse;
+			ticks -= (uint32_t)hwTimer2Sleep(TIMER2_PRESCALER_COARSE, chunk) << TIMER2_COARSE_SHIFT;
+		} else {
+			ticks -= hwTimer2Sleep(TIMER2_PRESCALER_FINE, (uint8_t)ticks);
+		}
+	}
+	if (interruptWakeUp()) {
+		// ticks back to ms
+		return (ticks / 128u) * 125u + ((ticks % 128u) * 125u) / 128u;
+	}
+	return 0ul;
+}
+#else
 uint32_t hwInternalSleep(uint32_t ms)
 {
 	// Sleeping with watchdog only supports multiples of 16ms.
@@ -144,6 +311,7 @@ uint32_t hwInternalSleep(uint32_t ms)
 	}
 	return 0ul;
 }
+#endif
 
 int8_t hwSleep(uint32_t ms)
 {
@@ -286,26 +454,67 @@ bool hwUniqueID(unique_id_t *uniqueID)
 #endif
 }
 
-uint16_t hwCPUVoltage(void)
-{
-	// Measure Vcc against 1.1V Vref
+// Measure Vcc against 1.1V Vref
 #if defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
-	ADMUX = (_BV(REFS0) | _BV(MUX4) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1));
+#define HW_CPU_VOLTAGE_ADMUX (_BV(REFS0) | _BV(MUX4) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1))
 #elif defined (__AVR_ATtiny24__) || defined(__AVR_ATtiny44__) || defined(__AVR_ATtiny84__)
-	ADMUX = (_BV(MUX5) | _BV(MUX0));
+#define HW_CPU_VOLTAGE_ADMUX (_BV(MUX5) | _BV(MUX0))
 #elif defined (__AVR_ATtiny25__) || defined(__AVR_ATtiny45__) || defined(__AVR_ATtiny85__)
-	ADMUX = (_BV(MUX3) | _BV(MUX2));
+#define HW_CPU_VOLTAGE_ADMUX (_BV(MUX3) | _BV(MUX2))
 #else
-	ADMUX = (_BV(REFS0) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1));
+#define HW_CPU_VOLTAGE_ADMUX (_BV(REFS0) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1))
 #endif
+#define HW_CPU_VOLTAGE_SETTLE_MS (70u)
+
+#if defined(MY_AVR_CPU_VOLTAGE_ASYNC)
+static uint32_t _hwCPUVoltageSettleStart = 0;
+
+// only wakes the mcu from ADC noise reduction mode
+EMPTY_INTERRUPT(ADC_vect);
+
+void hwCPUVoltageStart(void)
+{
+	ADMUX = HW_CPU_VOLTAGE_ADMUX;
+	_hwCPUVoltageSettleStart = hwMillis();
+}
+
+uint16_t hwCPUVoltage(void)
+{
+	if (ADMUX != HW_CPU_VOLTAGE_ADMUX) {
+		// analogRead() selected another input meanwhile
+		hwCPUVoltageStart();
+	}
+	// wait for what is left of the Vref settling
+	const uint32_t settling = hwMillis() - _hwCPUVoltageSettleStart;
+	if (settling < HW_CPU_VOLTAGE_SETTLE_MS) {
+		delay(HW_CPU_VOLTAGE_SETTLE_MS - settling);
+	}
+	// Do conversion in ADC noise reduction mode, it starts with the sleep
+	ADCSRA |= _BV(ADIE);
+	set_sleep_mode(SLEEP_MODE_ADC);
+	do {
+		// other interrupts, e.g. Timer0, wake the mcu before the conversion completes
+		sleep_enable();
+		sleep_cpu();
+		sleep_disable();
+	} while (bit_is_set(ADCSRA, ADSC));
+	ADCSRA &= ~_BV(ADIE);
+	// return Vcc in mV
+	return (1125300UL) / ADC;
+}
+#else
+uint16_t hwCPUVoltage(void)
+{
+	ADMUX = HW_CPU_VOLTAGE_ADMUX;
 	// Vref settle
-	delay(70);
+	delay(HW_CPU_VOLTAGE_SETTLE_MS);
 	// Do conversion
 	ADCSRA |= _BV(ADSC);
 	while (bit_is_set(ADCSRA,ADSC)) {};
 	// return Vcc in mV
 	return (1125300UL) / ADC;
 }
+#endif
 
 uint16_t hwCPUFrequency(void)
 {
@@ -42,6 +42,14 @@
 #include <Arduino.h>
 #endif
 
+// Interrupt driven hardware I2C
+#if defined(MY_AVR_TWI_MASTER)
+#if !defined(TWCR)
+#error MY_AVR_TWI_MASTER requires a TWI
+#endif
+#include "hal/architecture/AVR/drivers/DigitalIO/TwiMaster.h"
+#endif
+
 #define CRYPTO_LITTLE_ENDIAN
 
 #ifndef MY_SERIALDEVICE
@@ -71,6 +79,7 @@ bool hwInit(void);
 #define hwWatchdogReset() wdt_reset()
 #define hwReboot() wdt_enable(WDTO_15MS); while (1)
 #define hwMillis() millis()
+#define hwMicros() micros()
 #define hwReadConfig(__pos) eeprom_read_byte((const uint8_t *)__pos)
 #define hwWriteConfig(__pos, __val) eeprom_update_byte((uint8_t *)__pos, (uint8_t)__val)
 #define hwReadConfigBlock(__buf, __pos, __length) eeprom_read_block((void *)__buf, (const void *)__pos, (uint32_t)__length)
@@ -78,6 +87,28 @@ bool hwInit(void);
 
 inline void hwRandomNumberInit(void);
 uint32_t hwInternalSleep(uint32_t ms);
+#if defined(MY_AVR_SLEEP_TIMER2) && !defined(AS2)
+#error MY_AVR_SLEEP_TIMER2 requires a Timer2 with asynchronous operation
+#endif
+#if defined(MY_AVR_CPU_VOLTAGE_ASYNC)
+// select the 1.1V Vref for hwCPUVoltage(), which then only waits for the rest of the 70ms settling
+void hwCPUVoltageStart(void);
+#endif
+// idle sleep, Timer0 (hwMillis) wakes the CPU every 1024us
+void hwIdle(const uint32_t ms);
+#define MY_HW_HAS_IDLE
+#if defined(MY_WITH_LEDS_BLINKING_TIMER)
+// LED updates from the Timer0 (hwMillis) compare B interrupt
+void hwLedTimerStart(void (*update)(void), const uint16_t periodMs);
+void hwLedTimerStop(void);
+#define MY_HW_HAS_LED_TIMER
+#endif
+#if defined(MY_PROFILING)
+// Timer1 at F_CPU, extended to 32 bits by its overflow interrupt
+void hwCycleCounterInit(void);
+uint32_t hwCycles(void);
+#define MY_HW_HAS_CYCLE_COUNTER
+#endif
 
 #if defined(MY_SOFTSPI)
 SoftSPI<MY_SOFT_SPI_MISO_PIN, MY_SOFT_SPI_MOSI_PIN, MY_SOFT_SPI_SCK_PIN, 0> hwSPI; //!< hwSPI
@@ -0,0 +1,157 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+#if defined(__AVR__)
+#include <util/atomic.h>
+#include <util/twi.h>
+#include "TwiMaster.h"
+
+twiTransaction_t *volatile TwiMaster::_queue[TWI_MASTER_QUEUE_SIZE];
+volatile uint8_t TwiMaster::_head = 0;
+volatile uint8_t TwiMaster::_count = 0;
+uint8_t TwiMaster::_index = 0;
+
+// TWCR values
+#define TWI_CR_IDLE  (_BV(TWEN) | _BV(TWIE))
+#define TWI_CR_NEXT  (_BV(TWEN) | _BV(TWIE) | _BV(TWINT))
+
+void TwiMaster::begin(uint8_t speed, uint8_t pullups)
+{
+	if (pullups == I2C_INTERNAL_PULLUPS) {
+		digitalWrite(SDA, HIGH);
+		digitalWrite(SCL, HIGH);
+	} else {
+		digitalWrite(SDA, LOW);
+		digitalWrite(SCL, LOW);
+	}
+	// prescaler 1
+	TWSR = 0;
+	TWBR = ((F_CPU / (speed == I2C_400KHZ ? 400000UL : 100000UL)) - 16) / 2;
+	TWCR = TWI_CR_IDLE;
+}
+
+bool TwiMaster::queue(twiTransaction_t *transaction)
+{
+	bool queued = false;
+	transaction->status = TWI_STATUS_PENDING;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		if (_count < TWI_MASTER_QUEUE_SIZE) {
+			_queue[(_head + _count) % TWI_MASTER_QUEUE_SIZE] = transaction;
+			_count++;
+			queued = true;
+			if (_count == 1) {
+				_start();
+			}
+		}
+	}
+	return queued;
+}
+
+uint8_t TwiMaster::transfer(twiTransaction_t *transaction)
+{
+	while (!queue(transaction)) {
+		// wait for a free slot
+	}
+	while (transaction->status == TWI_STATUS_PENDING) {
+		// wait for completion
+	}
+	return transaction->status;
+}
+
+void TwiMaster::_start(void)
+{
+	_index = 0;
+	TWCR = TWI_CR_NEXT | _BV(TWSTA);
+}
+
+void TwiMaster::_finish(uint8_t status)
+{
+	twiTransaction_t *transaction = _queue[_head];
+	transaction->status = status;
+	if (transaction->callback) {
+		// may queue the next transaction, the slot is still counted so queue() does not start it
+		transaction->callback(transaction->context, status);
+	}
+	_head = (_head + 1) % TWI_MASTER_QUEUE_SIZE;
+	_count--;
+	if (_count) {
+		// stop followed by start
+		_index = 0;
+		TWCR = TWI_CR_NEXT | _BV(TWSTO) | _BV(TWSTA);
+	} else {
+		TWCR = TWI_CR_IDLE | _BV(TWINT) | _BV(TWSTO);
+	}
+}
+
+void TwiMaster::isr(void)
+{
+	twiTransaction_t *transaction = _queue[_head];
+	switch (TW_STATUS) {
+	case TW_START:
+	case TW_REP_START:
+		if (_index < transaction->txLength || !transaction->rxLength) {
+			TWDR = (transaction->address << 1) | I2C_WRITE;
+		} else {
+			_index = 0;
+			TWDR = (transaction->address << 1) | I2C_READ;
+		}
+		TWCR = TWI_CR_NEXT;
+		break;
+	case TW_MT_SLA_ACK:
+	case TW_MT_DATA_ACK:
+		if (_index < transaction->txLength) {
+			TWDR = transaction->txBuffer[_index++];
+			TWCR = TWI_CR_NEXT;
+		} else if (transaction->rxLength) {
+			// repeated start to read
+			TWCR = TWI_CR_NEXT | _BV(TWSTA);
+		} else {
+			_finish(TWI_STATUS_OK);
+		}
+		break;
+	case TW_MR_SLA_ACK:
+		TWCR = transaction->rxLength > 1 ? TWI_CR_NEXT | _BV(TWEA) : TWI_CR_NEXT;
+		break;
+	case TW_MR_DATA_ACK:
+		transaction->rxBuffer[_index++] = TWDR;
+		// NACK the last byte
+		TWCR = (_index < transaction->rxLength - 1) ? TWI_CR_NEXT | _BV(TWEA) : TWI_CR_NEXT;
+		break;
+	case TW_MR_DATA_NACK:
+		transaction->rxBuffer[_index++] = TWDR;
+		_finish(TWI_STATUS_OK);
+		break;
+	case TW_MT_SLA_NACK:
+	case TW_MR_SLA_NACK:
+		_finish(TWI_STATUS_ADDR_NACK);
+		break;
+	case TW_MT_DATA_NACK:
+		_finish(TWI_STATUS_DATA_NACK);
+		break;
+	default:
+		// arbitration lost, bus error
+		_finish(TWI_STATUS_BUS_ERROR);
+		break;
+	}
+}
+
+ISR(TWI_vect)
+{
+	TwiMaster::isr();
+}
+#endif  // __AVR__
@@ -0,0 +1,120 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+#ifndef TWI_MASTER_H
+#define TWI_MASTER_H
+/**
+ * @file
+ * @brief AVR interrupt driven hardware I2C master
+ *
+ * @defgroup twiMaster Hardware I2C
+ * @details  Transactions are queued and run by the TWI interrupt, the CPU is free meanwhile.
+ *           SoftI2cMaster remains for arbitrary pins. Cannot be combined with the Wire
+ *           library, both own the TWI interrupt.
+ * @{
+ */
+#if defined(__AVR__) || defined(DOXYGEN)  // AVR only
+#include <Arduino.h>
+#include "I2cConstants.h"
+
+/** Number of transactions that can be queued */
+#ifndef TWI_MASTER_QUEUE_SIZE
+#define TWI_MASTER_QUEUE_SIZE 4
+#endif
+
+/** Transaction queued or running */
+const uint8_t TWI_STATUS_PENDING = 0xFF;
+/** Transaction done */
+const uint8_t TWI_STATUS_OK = 0;
+/** Slave address NACKed, e.g. an EEPROM in its write cycle */
+const uint8_t TWI_STATUS_ADDR_NACK = 1;
+/** Data byte NACKed */
+const uint8_t TWI_STATUS_DATA_NACK = 2;
+/** Arbitration lost or bus error */
+const uint8_t TWI_STATUS_BUS_ERROR = 3;
+
+/**
+ * @brief Called from the TWI interrupt once a transaction is done.
+ * @param context Context of the transaction
+ * @param status TWI_STATUS_OK or the error
+ */
+typedef void (*twiCallback_t)(void *context, uint8_t status);
+
+/**
+ * @brief I2C transaction: write txLen bytes, then read rxLen bytes after a repeated start.
+ *
+ * Owned by the caller, it and its buffers must stay valid until status is no longer
+ * TWI_STATUS_PENDING.
+ */
+typedef struct {
+	uint8_t address;               //!< 7 bit slave address
+	const uint8_t *txBuffer;       //!< bytes to write, e.g. a register address
+	uint8_t txLength;              //!< number of bytes to write
+	uint8_t *rxBuffer;             //!< buffer for the bytes read
+	uint8_t rxLength;              //!< number of bytes to read
+	twiCallback_t callback;        //!< completion callback or NULL
+	void *context;                 //!< passed to the callback
+	volatile uint8_t status;       //!< TWI_STATUS_PENDING until done
+} twiTransaction_t;
+
+/**
+ * @class TwiMaster
+ * @brief AVR hardware I2C master with a transaction queue
+ */
+class TwiMaster
+{
+public:
+	/**
+	 * @brief Initialize the TWI
+	 * @param speed I2C_100KHZ or I2C_400KHZ
+	 * @param pullups I2C_INTERNAL_PULLUPS or I2C_NO_PULLUPS
+	 */
+	static void begin(uint8_t speed = I2C_400KHZ, uint8_t pullups = I2C_NO_PULLUPS);
+	/**
+	 * @brief Queue a transaction, it starts right away if the bus is idle.
+	 * @return false if the queue is full
+	 */
+	static bool queue(twiTransaction_t *transaction);
+	/**
+	 * @brief Queue a transaction and wait for it.
+	 * @return status of the transaction
+	 */
+	static uint8_t transfer(twiTransaction_t *transaction);
+	/**
+	 * @brief Nothing queued or running
+	 */
+	static bool idle(void)
+	{
+		return _count == 0;
+	}
+	/**
+	 * @brief Run the state machine, called by the TWI interrupt.
+	 */
+	static void isr(void);
+
+private:
+	static void _start(void);
+	static void _finish(uint8_t status);
+	static twiTransaction_t *volatile _queue[TWI_MASTER_QUEUE_SIZE];
+	static volatile uint8_t _head;
+	static volatile uint8_t _count;
+	static uint8_t _index;
+};
+#endif  // __AVR__
+#endif  // TWI_MASTER_H
+/** @} */
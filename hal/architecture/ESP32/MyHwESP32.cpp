@@ -35,6 +35,11 @@ bool hwInit(void)
 	return EEPROM.begin(MY_EEPROM_SIZE);
 }
 
+#if MY_ESP32_EEPROM_COMMIT_MS > 0
+static bool hwConfigDirty = false;
+static uint32_t hwConfigDirtySince;
+#endif
+
 void hwReadConfigBlock(void *buf, void *addr, size_t length)
 {
 	uint8_t *dst = static_cast<uint8_t *>(buf);
@@ -51,7 +56,15 @@ void hwWriteConfigBlock(void *buf, void *addr, size_t length)
 	while (length-- > 0) {
 		EEPROM.write(offs++, *src++);
 	}
+#if MY_ESP32_EEPROM_COMMIT_MS > 0
+	// commit later, see hwFlushConfigIfDue()
+	if (!hwConfigDirty) {
+		hwConfigDirty = true;
+		hwConfigDirtySince = hwMillis();
+	}
+#else
 	EEPROM.commit();
+#endif
 }
 
 uint8_t hwReadConfig(const int addr)
@@ -68,6 +81,25 @@ void hwWriteConfig(const int addr, uint8_t value)
 	}
 }
 
+void hwFlushConfig(void)
+{
+#if MY_ESP32_EEPROM_COMMIT_MS > 0
+	if (hwConfigDirty) {
+		hwConfigDirty = false;
+		EEPROM.commit();
+	}
+#endif
+}
+
+void hwFlushConfigIfDue(void)
+{
+#if MY_ESP32_EEPROM_COMMIT_MS > 0
+	if (hwConfigDirty && (hwMillis() - hwConfigDirtySince >= MY_ESP32_EEPROM_COMMIT_MS)) {
+		hwFlushConfig();
+	}
+#endif
+}
+
 bool hwUniqueID(unique_id_t *uniqueID)
 {
 	uint64_t val = ESP.getEfuseMac();
@@ -83,9 +115,11 @@ ssize_t hwGetentropy(void *__buffer, size_t __length)
 		__length = 256;
 	}
 	uint8_t *dst = (uint8_t *)__buffer;
-	// get random numbers
-	for (size_t i = 0; i < __length; i++) {
-		dst[i] = (uint8_t)esp_random();
+	// get random numbers, all four bytes of each word of the hardware RNG are used
+	for (size_t i = 0; i < __length; i += sizeof(uint32_t)) {
+		const uint32_t word = esp_random();
+		const size_t count = (__length - i < sizeof(uint32_t)) ? __length - i : sizeof(uint32_t);
+		(void)memcpy((void *)&dst[i], (const void *)&word, count);
 	}
 	return __length;
 }
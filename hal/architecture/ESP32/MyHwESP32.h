@@ -70,7 +70,7 @@
 #define hwDigitalRead(__pin) digitalRead(__pin)
 #define hwPinMode(__pin, __value) pinMode(__pin, __value)
 #define hwWatchdogReset()
-#define hwReboot() ESP.restart()
+#define hwReboot() hwFlushConfig(); ESP.restart()
 #define hwMillis() millis()
 #define hwMicros() micros()
 #define hwRandomNumberInit() randomSeed(esp_random())
@@ -81,8 +81,15 @@ void hwReadConfigBlock(void *buf, void *addr, size_t length);
 void hwWriteConfigBlock(void *buf, void *addr, size_t length);
 void hwWriteConfig(const int addr, uint8_t value);
 uint8_t hwReadConfig(const int addr);
+void hwFlushConfig(void);
+void hwFlushConfigIfDue(void);
+#define MY_HW_HAS_FLUSH_CONFIG
 ssize_t hwGetentropy(void *__buffer, size_t __length);
 #define MY_HW_HAS_GETENTROPY
+// CPU cycle counter register
+#define hwCycleCounterInit()
+#define hwCycles() ESP.getCycleCount()
+#define MY_HW_HAS_CYCLE_COUNTER
 
 // SOFTSPI
 #ifdef MY_SOFTSPI
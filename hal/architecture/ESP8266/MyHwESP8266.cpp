@@ -32,6 +32,11 @@ bool hwInit(void)
 	return true;
 }
 
+#if MY_ESP8266_EEPROM_COMMIT_MS > 0
+static bool hwConfigDirty = false;
+static uint32_t hwConfigDirtySince;
+#endif
+
 void hwReadConfigBlock(void *buf, void *addr, size_t length)
 {
 	uint8_t *dst = static_cast<uint8_t *>(buf);
@@ -48,8 +53,16 @@ void hwWriteConfigBlock(void *buf, void *addr, size_t length)
 	while (length-- > 0) {
 		EEPROM.write(pos++, *src++);
 	}
+#if MY_ESP8266_EEPROM_COMMIT_MS > 0
+	// commit later, see hwFlushConfigIfDue()
+	if (!hwConfigDirty) {
+		hwConfigDirty = true;
+		hwConfigDirtySince = hwMillis();
+	}
+#else
 	// see implementation, commit only executed if diff
 	EEPROM.commit();
+#endif
 }
 
 uint8_t hwReadConfig(const int addr)
@@ -64,6 +77,25 @@ void hwWriteConfig(const int addr, uint8_t value)
 	hwWriteConfigBlock(&value, reinterpret_cast<void *>(addr), 1);
 }
 
+void hwFlushConfig(void)
+{
+#if MY_ESP8266_EEPROM_COMMIT_MS > 0
+	if (hwConfigDirty) {
+		hwConfigDirty = false;
+		EEPROM.commit();
+	}
+#endif
+}
+
+void hwFlushConfigIfDue(void)
+{
+#if MY_ESP8266_EEPROM_COMMIT_MS > 0
+	if (hwConfigDirty && (hwMillis() - hwConfigDirtySince >= MY_ESP8266_EEPROM_COMMIT_MS)) {
+		hwFlushConfig();
+	}
+#endif
+}
+
 bool hwUniqueID(unique_id_t *uniqueID)
 {
 	// padding
@@ -45,8 +45,9 @@
 #define hwDigitalRead(__pin) digitalRead(__pin)
 #define hwPinMode(__pin, __value) pinMode(__pin, __value)
 #define hwWatchdogReset() wdt_reset()
-#define hwReboot() ESP.restart()
+#define hwReboot() hwFlushConfig(); ESP.restart()
 #define hwMillis() millis()
+#define hwMicros() micros()
 // The use of randomSeed switch to pseudo random number. Keep hwRandomNumberInit empty
 #define hwRandomNumberInit()
 #define hwGetSleepRemaining() (0ul)
@@ -56,8 +57,15 @@ void hwReadConfigBlock(void *buf, void *addr, size_t length);
 void hwWriteConfigBlock(void *buf, void *addr, size_t length);
 void hwWriteConfig(const int addr, uint8_t value);
 uint8_t hwReadConfig(const int addr);
+void hwFlushConfig(void);
+void hwFlushConfigIfDue(void);
+#define MY_HW_HAS_FLUSH_CONFIG
 ssize_t hwGetentropy(void *__buffer, size_t __length);
 //#define MY_HW_HAS_GETENTROPY
+// CPU cycle counter register
+#define hwCycleCounterInit()
+#define hwCycles() ESP.getCycleCount()
+#define MY_HW_HAS_CYCLE_COUNTER
 
 // SOFTSPI
 #ifdef MY_SOFTSPI
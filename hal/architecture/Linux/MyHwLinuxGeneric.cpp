@@ -20,7 +20,12 @@
 #include "MyHwLinuxGeneric.h"
 
 static SoftEeprom eeprom;
+#if !defined(SYS_getrandom)
 static FILE *randomFp = NULL;
+#endif
+// random data is read from the kernel in bulk, the unused part is at the end of the pool
+static uint8_t entropyPool[MY_LINUX_ENTROPY_POOL_SIZE];
+static size_t entropyPoolAvailable = 0;
 
 bool hwInit(void)
 {
@@ -34,13 +39,37 @@ bool hwInit(void)
 #endif
 #endif
 
-	if (eeprom.init(conf.eeprom_file, conf.eeprom_size) != 0) {
+	if (eeprom.init(conf.eeprom_file, conf.eeprom_size, MY_LINUX_EEPROM_FLUSH_MS) != 0) {
+		exit(1);
+	}
+
+	if (eventLoopInit() != 0) {
 		exit(1);
 	}
+	eventLoopSetTick(MY_LINUX_EVENT_LOOP_TICK_MS);
 
 	return true;
 }
 
+void hwWaitForEvents(const uint32_t timeoutMS)
+{
+	// commit collected eeprom writes, or wake up when they are due
+	const int eepromFlushDue = eeprom.flushIfDue();
+	if (eepromFlushDue >= 0) {
+		eventLoopWakeupIn(eepromFlushDue);
+	}
+	if (timeoutMS != UINT32_MAX) {
+		eventLoopWakeupIn(timeoutMS);
+	}
+	(void)eventLoopWait(-1);
+}
+
+void hwFlushConfig(void)
+{
+	// no waiting under load, commit the collected eeprom writes that are due
+	(void)eeprom.flushIfDue();
+}
+
 void hwReadConfigBlock(void *buf, void *addr, size_t length)
 {
 	eeprom.readBlock(buf, addr, length);
@@ -65,6 +94,7 @@ void hwRandomNumberInit(void)
 {
 	uint32_t seed=0;
 
+#if !defined(SYS_getrandom)
 	if (randomFp != NULL) {
 		fclose(randomFp);
 	}
@@ -72,14 +102,54 @@ void hwRandomNumberInit(void)
 		logError("Cannot open '/dev/urandom'.\n");
 		exit(2);
 	}
+#endif
 
 	while (hwGetentropy(&seed, sizeof(seed)) != sizeof(seed));
 	randomSeed(seed);
 }
 
+static bool hwEntropyPoolFill(void)
+{
+#if defined(SYS_getrandom)
+	const long result = syscall(SYS_getrandom, entropyPool, sizeof(entropyPool), 0);
+	if (result <= 0) {
+		return false;
+	}
+	const size_t length = (size_t)result;
+#else
+	if (randomFp == NULL) {
+		return false;
+	}
+	const size_t length = fread(entropyPool, 1, sizeof(entropyPool), randomFp);
+#endif
+	// keep the fresh data at the end of the pool
+	if (length < sizeof(entropyPool)) {
+		(void)memmove(&entropyPool[sizeof(entropyPool) - length], entropyPool, length);
+	}
+	entropyPoolAvailable = length;
+	return length > 0;
+}
+
 ssize_t hwGetentropy(void *__buffer, size_t __length)
 {
-	return(fread(__buffer, 1, __length, randomFp));
+	uint8_t *dest = (uint8_t *)__buffer;
+	size_t done = 0;
+	while (done < __length) {
+		if (entropyPoolAvailable == 0 && !hwEntropyPoolFill()) {
+			break;
+		}
+		size_t length = __length - done;
+		if (length > entropyPoolAvailable) {
+			length = entropyPoolAvailable;
+		}
+		uint8_t *src = &entropyPool[sizeof(entropyPool) - entropyPoolAvailable];
+		(void)memcpy(&dest[done], src, length);
+		// random data is only ever handed out once
+		(void)memset(src, 0, length);
+		entropyPoolAvailable -= length;
+		done += length;
+	}
+	return (ssize_t)done;
 }
 
 uint32_t hwMillis(void)
@@ -87,6 +157,11 @@ uint32_t hwMillis(void)
 	return millis();
 }
 
+uint32_t hwMicros(void)
+{
+	return micros();
+}
+
 bool hwUniqueID(unique_id_t *uniqueID)
 {
 	// not implemented yet
@@ -26,14 +26,21 @@
 #include "StdInOutStream.h"
 #include <SPI.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 #include "SoftEeprom.h"
 #include "log.h"
 #include "config.h"
+#include "eventloop.h"
+#include "pcapcapture.h"
 
 #define CRYPTO_LITTLE_ENDIAN
 
@@ -61,6 +68,8 @@ inline int hwDigitalRead(uint8_t);
 inline void hwPinMode(uint8_t, uint8_t);
 
 bool hwInit(void);
+void hwWaitForEvents(const uint32_t timeoutMS);
+void hwFlushConfig(void);
 inline void hwReadConfigBlock(void *buf, void *addr, size_t length);
 inline void hwWriteConfigBlock(void *buf, void *addr, size_t length);
 inline uint8_t hwReadConfig(const int addr);
@@ -69,6 +78,7 @@ inline void hwRandomNumberInit(void);
 ssize_t hwGetentropy(void *__buffer, size_t __length);
 #define MY_HW_HAS_GETENTROPY
 inline uint32_t hwMillis(void);
+inline uint32_t hwMicros(void);
 
 // SOFTSPI
 #ifdef MY_SOFTSPI
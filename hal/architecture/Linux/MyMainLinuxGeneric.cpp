@@ -29,8 +29,36 @@
 #include <getopt.h>
 #include "log.h"
 #include "config.h"
+#include "httpstats.h"
+#include "pcapcapture.h"
+#include "scheduling.h"
+#include "standby.h"
 #include "MySensorsCore.h"
 
+static void shutdown_gateway(int status)
+{
+#ifdef MY_RF24_IRQ_PIN
+	detachInterrupt(MY_RF24_IRQ_PIN);
+#endif
+
+#if defined(MY_GATEWAY_SERIAL)
+	MY_SERIALDEVICE.end();
+#endif
+
+#if defined(MY_GATEWAY_PRESENTATION_CACHE) && defined(MY_SENSOR_NETWORK)
+	gatewayTransportCacheSave();
+#endif
+#if defined(MY_GATEWAY_OUTBOX) && defined(MY_SENSOR_NETWORK)
+	gatewayTransportOutboxClose();
+#endif
+	httpStatsEnd();
+	pcapCaptureEnd();
+	standbyEnd();
+	logClose();
+
+	exit(status);
+}
+
 void handle_sigint(int sig)
 {
 	if (sig == SIGINT) {
@@ -41,17 +69,113 @@ void handle_sigint(int sig)
 		return;
 	}
 
-#ifdef MY_RF24_IRQ_PIN
-	detachInterrupt(MY_RF24_IRQ_PIN);
-#endif
+	shutdown_gateway(EXIT_SUCCESS);
+}
 
-#if defined(MY_GATEWAY_SERIAL)
-	MY_SERIALDEVICE.end();
+static volatile sig_atomic_t reload_pending = 0;
+
+void handle_sighup(int sig)
+{
+	(void)sig;
+	// applied by the main loop, which is woken up if it is waiting for events
+	reload_pending = 1;
+	eventLoopWakeup();
+}
+
+static void log_begin(void)
+{
+	logSetLevel(conf.verbose);
+
+	if (conf.log_file) {
+		if (logSetFile(conf.log_filepath) != 0) {
+			logError("Failed to open log file.\n");
+		}
+	}
+
+	if (conf.log_pipe) {
+		if (logSetPipe(conf.log_pipe_file) != 0) {
+			logError("Failed to open log pipe.\n");
+		}
+	}
+
+	if (conf.syslog) {
+		logSetSyslog(LOG_CONS, LOG_USER);
+	}
+}
+
+static bool config_changed(const char *previous, const char *current)
+{
+	if (previous == NULL || current == NULL) {
+		return previous != current;
+	}
+	return strcmp(previous, current) != 0;
+}
+
+static void reload_config(const char *config_file)
+{
+	struct config previous;
+
+	logNotice("Received SIGHUP, reloading %s\n", config_file);
+	if (config_reload(config_file, &previous) != 0) {
+		logError("Failed to reload the configuration, keeping the current settings.\n");
+		return;
+	}
+
+	logResetSinks();
+	log_begin();
+
+	if (conf.stats_port != previous.stats_port) {
+#if defined(MY_STATS_FEATURE)
+		httpStatsEnd();
+		if (conf.stats_port && httpStatsBegin(conf.stats_port, statsRender) != 0) {
+			logError("Failed to start the statistics server.\n");
+		}
+#else
+		logWarning("stats_port is ignored, the gateway was built without --my-stats.\n");
 #endif
+	}
 
-	logClose();
+	if (config_changed(previous.pcap_file, conf.pcap_file)) {
+		pcapCaptureEnd();
+		if (conf.pcap_file && pcapCaptureBegin(conf.pcap_file) != 0) {
+			logError("Failed to start the radio capture.\n");
+		}
+	}
 
-	exit(EXIT_SUCCESS);
+#if defined(MY_GATEWAY_FIRMWARE_SERVER) && defined(MY_SENSOR_NETWORK)
+	// mapped again, replaced images are picked up
+	gatewayTransportFirmwareOpen(conf.firmware_dir);
+#endif
+
+	// the radio, EEPROM and keys stay as they were initialized by _begin()
+	if (conf.log_async != previous.log_async ||
+	        conf.eeprom_size != previous.eeprom_size ||
+	        conf.rf24_channel != previous.rf24_channel ||
+	        conf.sim_port != previous.sim_port ||
+	        conf.sim_loss != previous.sim_loss ||
+	        conf.sim_latency_us != previous.sim_latency_us ||
+	        config_changed(previous.eeprom_file, conf.eeprom_file) ||
+	        config_changed(previous.soft_hmac_key, conf.soft_hmac_key) ||
+	        config_changed(previous.soft_serial_key, conf.soft_serial_key) ||
+	        config_changed(previous.aes_key, conf.aes_key) ||
+	        config_changed(previous.presentation_cache_file, conf.presentation_cache_file) ||
+	        config_changed(previous.outbox_file, conf.outbox_file) ||
+	        config_changed(previous.sim_group, conf.sim_group) ||
+	        config_changed(previous.sim_topology, conf.sim_topology) ||
+	        conf.irq_scheduler != previous.irq_scheduler ||
+	        conf.irq_priority != previous.irq_priority ||
+	        conf.irq_cpu != previous.irq_cpu ||
+	        conf.radio_scheduler != previous.radio_scheduler ||
+	        conf.radio_priority != previous.radio_priority ||
+	        conf.radio_cpu != previous.radio_cpu ||
+	        conf.lock_memory != previous.lock_memory ||
+	        conf.standby_port != previous.standby_port ||
+	        config_changed(previous.standby_peer, conf.standby_peer)) {
+		logWarning("Some changed settings only take effect after a restart.\n");
+	}
+
+	config_release(&previous);
+	logNotice("Configuration reloaded.\n");
 }
 
 static int daemonize(void)
@@ -111,7 +235,9 @@ void print_usage()
 	       "  --daemon                   Run as a daemon.\n" \
 	       "  --gen-soft-hmac-key        Generate and print a soft hmac key.\n" \
 	       "  --gen-soft-serial-key      Generate and print a soft serial key.\n" \
-	       "  --gen-aes-key              Generate and print an aes encryption key.\n");
+	       "  --gen-aes-key              Generate and print an aes encryption key.\n" \
+	       "\n" \
+	       "Send SIGHUP to reload the log, statistics, capture and firmware settings of the config file.\n");
 }
 
 void print_soft_sign_hmac_key(uint8_t *key_ptr = NULL)
@@ -354,6 +480,7 @@ int main(int argc, char *argv[])
 	signal(SIGINT, handle_sigint);
 	signal(SIGTERM, handle_sigint);
 	signal(SIGPIPE, handle_sigint);
+	signal(SIGHUP, handle_sighup);
 
 	hwRandomNumberInit();
 
@@ -423,22 +550,71 @@ int main(int argc, char *argv[])
 	}
 
 	logSetQuiet(quiet);
-	logSetLevel(conf.verbose);
+	log_begin();
 
-	if (conf.log_file) {
-		if (logSetFile(conf.log_filepath) != 0) {
-			logError("Failed to open log file.\n");
+	if (conf.log_async) {
+		if (logSetAsync() != 0) {
+			logError("Failed to start the log thread.\n");
 		}
 	}
 
-	if (conf.log_pipe) {
-		if (logSetPipe(conf.log_pipe_file) != 0) {
-			logError("Failed to open log pipe.\n");
+	if (conf.stats_port) {
+#if defined(MY_STATS_FEATURE)
+		if (httpStatsBegin(conf.stats_port, statsRender) != 0) {
+			logError("Failed to start the statistics server.\n");
 		}
+#else
+		logWarning("stats_port is ignored, the gateway was built without --my-stats.\n");
+#endif
 	}
 
-	if (conf.syslog) {
-		logSetSyslog(LOG_CONS, LOG_USER);
+	if (conf.pcap_file) {
+		if (pcapCaptureBegin(conf.pcap_file) != 0) {
+			logError("Failed to start the radio capture.\n");
+		}
+	}
+
+	if (conf.presentation_cache_file) {
+#if defined(MY_GATEWAY_PRESENTATION_CACHE) && defined(MY_SENSOR_NETWORK)
+		gatewayTransportCacheLoad(conf.presentation_cache_file);
+#else
+		logWarning("presentation_cache_file is ignored, the gateway was built without MY_GATEWAY_PRESENTATION_CACHE.\n");
+#endif
+	}
+
+	if (conf.outbox_file) {
+#if defined(MY_GATEWAY_OUTBOX) && defined(MY_SENSOR_NETWORK)
+		gatewayTransportOutboxOpen(conf.outbox_file);
+#else
+		logWarning("outbox_file is ignored, the gateway was built without MY_GATEWAY_OUTBOX.\n");
+#endif
+	}
+
+	if (conf.firmware_dir) {
+#if defined(MY_GATEWAY_FIRMWARE_SERVER) && defined(MY_SENSOR_NETWORK)
+		gatewayTransportFirmwareOpen(conf.firmware_dir);
+#else
+		logWarning("firmware_dir is ignored, the gateway was built without MY_GATEWAY_FIRMWARE_SERVER.\n");
+#endif
+	}
+
+	if (conf.lock_memory) {
+		(void)schedulingLockMemory();
+	}
+	// applied by the interrupt thread once it is started by the radio driver
+	interruptSetScheduling(conf.irq_scheduler, conf.irq_priority, conf.irq_cpu);
+
+	if (conf.standby_peer) {
+#if defined(MY_GATEWAY_STANDBY)
+		if (conf.standby_port) {
+			// the radio stays off until the active gateway is gone
+			gatewayTransportStandbyFollow(conf.standby_peer, conf.standby_port);
+		} else {
+			logWarning("standby_peer is ignored without standby_port.\n");
+		}
+#else
+		logWarning("standby_peer is ignored, the gateway was built without MY_GATEWAY_STANDBY.\n");
+#endif
 	}
 
 	logInfo("Starting gateway...\n");
@@ -446,6 +622,22 @@ int main(int argc, char *argv[])
 
 	_begin(); // Startup MySensors library
 
+#if defined(MY_GATEWAY_STANDBY)
+	if (conf.standby_peer && conf.standby_port) {
+		gatewayTransportStandbyTakeOver();
+	}
+	if (conf.standby_port && standbyServe(conf.standby_port, MY_GATEWAY_STANDBY_HEARTBEAT_MS) != 0) {
+		logError("Failed to start the standby server.\n");
+	} else if (conf.standby_peer && conf.standby_port &&
+	           standbyWatch(conf.standby_peer, conf.standby_port) != 0) {
+		logError("Failed to watch the standby peer.\n");
+	}
+#else
+	if (conf.standby_port) {
+		logWarning("standby_port is ignored, the gateway was built without MY_GATEWAY_STANDBY.\n");
+	}
+#endif
+
 	// EEPROM is initialized within _begin()
 	// any operation on it must be done hereafter
 
@@ -474,8 +666,10 @@ int main(int argc, char *argv[])
 	}
 #endif
 
-	if (config_file) {
-		free(config_file);
+	// set last, the threads started by _begin() would inherit it otherwise
+	if (conf.radio_scheduler != SCHED_OTHER || conf.radio_cpu >= 0) {
+		(void)schedulingApply(pthread_self(), conf.radio_scheduler, conf.radio_priority,
+		                      conf.radio_cpu);
 	}
 
 	for (;;) {
@@ -483,6 +677,16 @@ int main(int argc, char *argv[])
 		if (loop) {
 			loop(); // Call sketch loop
 		}
+		if (reload_pending) {
+			reload_pending = 0;
+			reload_config(config_file?config_file:MY_LINUX_CONFIG_FILE);
+		}
+#if defined(MY_GATEWAY_STANDBY)
+		if (standbyYield()) {
+			// restarted by the service manager, it follows the peer then
+			shutdown_gateway(EXIT_FAILURE);
+		}
+#endif
 	}
 	return 0;
 }
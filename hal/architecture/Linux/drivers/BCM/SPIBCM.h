@@ -28,6 +28,11 @@
 
 #define SPI_HAS_TRANSACTION
 
+#if defined(MY_SPI_DMA) && !defined(MY_SPI_DMA_MIN_LENGTH)
+// same default as in MyConfig.h, SPIBCM.cpp is built without it
+#define MY_SPI_DMA_MIN_LENGTH (8u)
+#endif
+
 #define SPI_CLOCK_BASE 256000000
 
 // SPI Clock divider
@@ -249,6 +254,11 @@ uint8_t SPIBCMClass::transfer(uint8_t data)
 
 void SPIBCMClass::transfernb(char* tbuf, char* rbuf, uint32_t len)
 {
+#if defined(MY_SPI_DMA)
+	if (len >= MY_SPI_DMA_MIN_LENGTH && bcm2835_spi_transfernb_dma(tbuf, rbuf, len)) {
+		return;
+	}
+#endif
 	bcm2835_spi_transfernb( tbuf, rbuf, len);
 }
 
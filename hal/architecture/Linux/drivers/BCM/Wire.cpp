@@ -40,6 +40,33 @@ uint8_t TwoWire::txBufferIndex = 0;
 uint8_t TwoWire::txBufferLength = 0;
 
 uint8_t TwoWire::transmitting = 0;
+uint8_t TwoWire::repeatedStart = 0;
+
+static uint8_t wireStatus(uint8_t reason)
+{
+	if (reason == BCM2835_I2C_REASON_OK) {
+		return 0;	// success
+	} else if (reason == BCM2835_I2C_REASON_ERROR_NACK) {
+		return 3;	// error: data send, nack received
+	}
+	return 4;	// other error
+}
+
+// with i2cMutex held
+static uint8_t wireTransfer(uint8_t address, const uint8_t *tx, uint32_t txLength, uint8_t *rx,
+                            uint32_t rxLength)
+{
+	bcm2835_i2c_setSlaveAddress(address);
+	if (!rxLength) {
+		return bcm2835_i2c_write(reinterpret_cast<const char *>(tx), txLength);
+	}
+	if (!txLength) {
+		return bcm2835_i2c_read(reinterpret_cast<char *>(rx), rxLength);
+	}
+	// one transaction, the read follows the write after a repeated start
+	return bcm2835_i2c_write_read_rs(reinterpret_cast<char *>(const_cast<uint8_t *>(tx)), txLength,
+	                                 reinterpret_cast<char *>(rx), rxLength);
+}
 
 void TwoWire::begin()
 {
@@ -89,24 +116,29 @@ void TwoWire::beginTransmission(int address)
 
 uint8_t TwoWire::endTransmission(void)
 {
+	return endTransmission(static_cast<uint8_t>(1));
+}
+
+uint8_t TwoWire::endTransmission(uint8_t sendStop)
+{
+	// indicate that we are done transmitting
+	transmitting = 0;
+	if (!sendStop) {
+		// requestFrom() sends the buffer and reads after a repeated start, the bus stays locked
+		repeatedStart = 1;
+		return 0;
+	}
+
 	// transmit buffer
-	bcm2835_i2c_setSlaveAddress(txAddress);
-	uint8_t ret = bcm2835_i2c_write(reinterpret_cast<const char *>(txBuffer), txBufferLength);
+	uint8_t ret = wireTransfer(txAddress, txBuffer, txBufferLength, NULL, 0);
 
 	// reset tx buffer iterator vars
 	txBufferIndex = 0;
 	txBufferLength = 0;
-	// indicate that we are done transmitting
-	transmitting = 0;
 
 	pthread_mutex_unlock(&i2cMutex);
 
-	if (ret == BCM2835_I2C_REASON_OK) {
-		return 0;	// success
-	} else if (ret == BCM2835_I2C_REASON_ERROR_NACK) {
-		return 3;	// error: data send, nack received
-	}
-	return 4;	// other error
+	return wireStatus(ret);
 }
 
 size_t TwoWire::requestFrom(uint8_t address, size_t quantity)
@@ -119,11 +151,24 @@ size_t TwoWire::requestFrom(uint8_t address, size_t quantity)
 	rxBufferIndex = 0;
 	rxBufferLength = 0;
 
-	bcm2835_i2c_setSlaveAddress(address);
-	uint8_t ret = bcm2835_i2c_read(reinterpret_cast<char *>(rxBuffer), quantity);
+	if (repeatedStart) {
+		// locked since beginTransmission()
+		repeatedStart = 0;
+		if (address != txAddress) {
+			(void)wireTransfer(txAddress, txBuffer, txBufferLength, NULL, 0);
+			txBufferLength = 0;
+		}
+	} else {
+		pthread_mutex_lock(&i2cMutex);
+		txBufferLength = 0;
+	}
+	uint8_t ret = wireTransfer(address, txBuffer, txBufferLength, rxBuffer, quantity);
 	if (ret == BCM2835_I2C_REASON_OK) {
 		rxBufferLength = quantity;
 	}
+	txBufferIndex = 0;
+	txBufferLength = 0;
+	pthread_mutex_unlock(&i2cMutex);
 
 	return rxBufferLength;
 }
@@ -138,6 +183,21 @@ uint8_t TwoWire::requestFrom(int address, int quantity)
 	return requestFrom(static_cast<uint8_t>(address), static_cast<size_t>(quantity));
 }
 
+uint8_t TwoWire::transfer(wireTransaction_t *transactions, uint8_t count)
+{
+	uint8_t failed = 0;
+	// the batch holds the bus, other threads cannot interleave
+	pthread_mutex_lock(&i2cMutex);
+	for (uint8_t i = 0; i < count; i++) {
+		wireTransaction_t &transaction = transactions[i];
+		transaction.status = wireStatus(wireTransfer(transaction.address, transaction.txBuffer,
+		                                transaction.txLength, transaction.rxBuffer, transaction.rxLength));
+		failed += (transaction.status != 0);
+	}
+	pthread_mutex_unlock(&i2cMutex);
+	return failed;
+}
+
 size_t TwoWire::write(uint8_t data)
 {
 	if (transmitting) {
@@ -32,6 +32,18 @@
 
 #define BUFFER_LENGTH 32
 
+/**
+ * @brief I2C transaction: write txLength bytes, then read rxLength bytes after a repeated start.
+ */
+typedef struct {
+	uint8_t address;			//!< 7 bit slave address
+	const uint8_t *txBuffer;	//!< bytes to write, e.g. a register address
+	uint8_t txLength;			//!< number of bytes to write
+	uint8_t *rxBuffer;			//!< buffer for the bytes read
+	uint8_t rxLength;			//!< number of bytes to read
+	uint8_t status;				//!< result as of endTransmission(), 0 on success
+} wireTransaction_t;
+
 class TwoWire : public Stream
 {
 
@@ -46,6 +58,7 @@ private:
 	static uint8_t txBufferLength;
 
 	static uint8_t transmitting;
+	static uint8_t repeatedStart;
 
 public:
 	void begin();
@@ -57,11 +70,14 @@ public:
 	void beginTransmission(uint8_t address);
 	void beginTransmission(int address);
 	uint8_t endTransmission(void);
+	uint8_t endTransmission(uint8_t sendStop);
 
 	size_t requestFrom(uint8_t address, size_t size);
 	uint8_t requestFrom(uint8_t address, uint8_t quantity);
 	uint8_t requestFrom(int address, int quantity);
 
+	uint8_t transfer(wireTransaction_t *transactions, uint8_t count);
+
 	size_t write(uint8_t data);
 	size_t write(const uint8_t *data, size_t quantity);
 	int available();
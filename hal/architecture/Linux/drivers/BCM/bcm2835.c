@@ -16,6 +16,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sched.h>
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
@@ -703,6 +705,218 @@ void bcm2835_spi_transfern(char* buf, uint32_t len)
 	bcm2835_spi_transfernb(buf, buf, len);
 }
 
+/* DMA control block as per section 4.2.1.1, 32 byte aligned */
+typedef struct {
+	uint32_t ti;
+	uint32_t source_ad;
+	uint32_t dest_ad;
+	uint32_t txfr_len;
+	uint32_t stride;
+	uint32_t nextconbk;
+	uint32_t reserved[2];
+} bcm2835_dma_cb_t;
+
+/* One page of VideoCore memory holds the TX and RX control blocks, then the TX and RX data */
+#define SPI_DMA_CB_OFFSET	0
+#define SPI_DMA_TX_OFFSET	64
+#define SPI_DMA_RX_OFFSET	(SPI_DMA_TX_OFFSET + BCM2835_SPI_DMA_MAX_LENGTH)
+#define SPI_DMA_MEM_SIZE	BCM2835_PAGE_SIZE
+/* A stuck transfer gives up DMA after this long */
+#define SPI_DMA_TIMEOUT_US	100000
+
+/* VideoCore mailbox property interface, see the firmware wiki of the raspberrypi project */
+#define MBOX_IOCTL_PROPERTY	_IOWR(100, 0, char *)
+#define MBOX_TAG_MEM_ALLOC	0x3000c
+#define MBOX_TAG_MEM_LOCK	0x3000d
+#define MBOX_TAG_MEM_UNLOCK	0x3000e
+#define MBOX_TAG_MEM_RELEASE	0x3000f
+#define MBOX_MEM_FLAG_DIRECT	0x04 /* 0xC0000000 alias, uncached */
+#define MBOX_MEM_FLAG_COHERENT	0x08 /* 0x40000000 alias, L2 coherent */
+#define MBOX_BUS_TO_PHYS(x)	((x) & ~0xC0000000)
+
+static void *mapmem(const char *msg, size_t size, int fd, off_t off);
+static void unmapmem(void **pmem, size_t size);
+
+/* 0 not set up yet, 1 ready, -1 not available and bcm2835_spi_transfernb() is used */
+static int spi_dma_state = 0;
+static int spi_dma_mbox = -1;
+static uint32_t spi_dma_handle = 0;
+static uint32_t spi_dma_bus = 0;
+static volatile uint8_t *spi_dma_mem = (uint8_t *)MAP_FAILED;
+
+static uint32_t mbox_property(uint32_t tag, uint32_t arg0, uint32_t arg1, uint32_t arg2,
+                              uint32_t nargs)
+{
+	uint32_t msg[9];
+	msg[0] = sizeof(msg);
+	msg[1] = 0; /* process request */
+	msg[2] = tag;
+	msg[3] = 3 * sizeof(uint32_t); /* value buffer size */
+	msg[4] = nargs * sizeof(uint32_t); /* request size */
+	msg[5] = arg0;
+	msg[6] = arg1;
+	msg[7] = arg2;
+	msg[8] = 0; /* end tag */
+	if (ioctl(spi_dma_mbox, MBOX_IOCTL_PROPERTY, msg) < 0 || msg[1] != 0x80000000) {
+		return 0;
+	}
+	return msg[5];
+}
+
+static volatile uint32_t *spi_dma_channel(uint8_t channel)
+{
+	return bcm2835_peripherals + (BCM2835_DMA_BASE + channel * 0x100)/4;
+}
+
+static void spi_dma_release(void)
+{
+	unmapmem((void**) &spi_dma_mem, SPI_DMA_MEM_SIZE);
+	if (spi_dma_handle) {
+		if (spi_dma_bus) {
+			(void)mbox_property(MBOX_TAG_MEM_UNLOCK, spi_dma_handle, 0, 0, 1);
+		}
+		(void)mbox_property(MBOX_TAG_MEM_RELEASE, spi_dma_handle, 0, 0, 1);
+	}
+	if (spi_dma_mbox >= 0) {
+		close(spi_dma_mbox);
+	}
+	spi_dma_mbox = -1;
+	spi_dma_handle = 0;
+	spi_dma_bus = 0;
+}
+
+static int spi_dma_begin(void)
+{
+	int memfd;
+	/* the ARM of the RPi 1 shares the L2 cache with the VideoCore, later ones do not */
+	const uint32_t flags = (uintptr_t)bcm2835_peripherals_base == BCM2835_PERI_BASE ?
+	                       MBOX_MEM_FLAG_DIRECT | MBOX_MEM_FLAG_COHERENT : MBOX_MEM_FLAG_DIRECT;
+
+	if (debug || bcm2835_spi0 == MAP_FAILED) {
+		return 0;
+	}
+	if ((spi_dma_mbox = open("/dev/vcio", 0)) < 0) {
+		logError("bcm2835_spi_transfernb_dma: Unable to open /dev/vcio: %s\n", strerror(errno));
+		return 0;
+	}
+	spi_dma_handle = mbox_property(MBOX_TAG_MEM_ALLOC, SPI_DMA_MEM_SIZE, SPI_DMA_MEM_SIZE, flags,
+	                               3);
+	if (spi_dma_handle) {
+		spi_dma_bus = mbox_property(MBOX_TAG_MEM_LOCK, spi_dma_handle, 0, 0, 1);
+	}
+	if (!spi_dma_bus) {
+		logError("bcm2835_spi_transfernb_dma: VideoCore memory allocation failed\n");
+		spi_dma_release();
+		return 0;
+	}
+	if ((memfd = open("/dev/mem", O_RDWR | O_SYNC)) < 0) {
+		logError("bcm2835_spi_transfernb_dma: Unable to open /dev/mem: %s\n", strerror(errno));
+		spi_dma_release();
+		return 0;
+	}
+	spi_dma_mem = (volatile uint8_t *)mapmem("dma", SPI_DMA_MEM_SIZE, memfd,
+	              MBOX_BUS_TO_PHYS(spi_dma_bus));
+	close(memfd);
+	if (spi_dma_mem == MAP_FAILED) {
+		spi_dma_release();
+		return 0;
+	}
+	bcm2835_peri_write(spi_dma_channel(BCM2835_SPI_DMA_TX_CHANNEL) + BCM2835_DMA_CS/4,
+	                   BCM2835_DMA_CS_RESET);
+	bcm2835_peri_write(spi_dma_channel(BCM2835_SPI_DMA_RX_CHANNEL) + BCM2835_DMA_CS/4,
+	                   BCM2835_DMA_CS_RESET);
+	return 1;
+}
+
+static void spi_dma_start(uint8_t channel, uint32_t cbOffset)
+{
+	volatile uint32_t* dma = spi_dma_channel(channel);
+	bcm2835_peri_write(dma + BCM2835_DMA_CS/4, BCM2835_DMA_CS_END | BCM2835_DMA_CS_INT);
+	bcm2835_peri_write(dma + BCM2835_DMA_DEBUG/4, BCM2835_DMA_DEBUG_CLEAR);
+	bcm2835_peri_write(dma + BCM2835_DMA_CONBLK_AD/4, spi_dma_bus + cbOffset);
+	bcm2835_peri_write(dma + BCM2835_DMA_CS/4, BCM2835_DMA_CS_WAIT_WRITES |
+	                   BCM2835_DMA_CS_PANIC_PRIORITY(8) | BCM2835_DMA_CS_PRIORITY(8) | BCM2835_DMA_CS_ACTIVE);
+}
+
+/* Writes (and reads) an number of bytes to SPI, moved by DMA as per section 10.6.3 */
+int bcm2835_spi_transfernb_dma(char* tbuf, char* rbuf, uint32_t len)
+{
+	volatile uint32_t* paddr = bcm2835_spi0 + BCM2835_SPI0_CS/4;
+	volatile uint32_t* rxcs = spi_dma_channel(BCM2835_SPI_DMA_RX_CHANNEL) + BCM2835_DMA_CS/4;
+	const uint32_t fifo = BCM2835_PERI_BUS_BASE + BCM2835_SPI0_BASE + BCM2835_SPI0_FIFO;
+	const uint32_t spiDma = BCM2835_SPI0_CS_TA | BCM2835_SPI0_CS_DMAEN | BCM2835_SPI0_CS_ADCS;
+	volatile bcm2835_dma_cb_t *cb;
+	uint64_t start;
+	uint32_t i;
+	int ok;
+
+	if (len == 0 || len > BCM2835_SPI_DMA_MAX_LENGTH) {
+		return 0;
+	}
+	if (spi_dma_state == 0) {
+		spi_dma_state = spi_dma_begin() ? 1 : -1;
+	}
+	if (spi_dma_state < 0) {
+		return 0;
+	}
+
+	/* The FIFO is accessed by 32 bit words in DMA mode, DLEN stops the SPI after len bytes */
+	cb = (volatile bcm2835_dma_cb_t *)(spi_dma_mem + SPI_DMA_CB_OFFSET);
+	cb[0].ti = BCM2835_DMA_TI_PERMAP(BCM2835_DMA_DREQ_SPI_TX) | BCM2835_DMA_TI_DEST_DREQ |
+	           BCM2835_DMA_TI_SRC_INC | BCM2835_DMA_TI_WAIT_RESP;
+	cb[0].source_ad = spi_dma_bus + SPI_DMA_TX_OFFSET;
+	cb[0].dest_ad = fifo;
+	cb[0].txfr_len = (len + 3) & ~3u;
+	cb[0].stride = 0;
+	cb[0].nextconbk = 0;
+	cb[1].ti = BCM2835_DMA_TI_PERMAP(BCM2835_DMA_DREQ_SPI_RX) | BCM2835_DMA_TI_SRC_DREQ |
+	           BCM2835_DMA_TI_DEST_INC | BCM2835_DMA_TI_WAIT_RESP;
+	cb[1].source_ad = fifo;
+	cb[1].dest_ad = spi_dma_bus + SPI_DMA_RX_OFFSET;
+	cb[1].txfr_len = (len + 3) & ~3u;
+	cb[1].stride = 0;
+	cb[1].nextconbk = 0;
+	/* Byte accesses, the uncached mapping does not allow unaligned ones */
+	for (i = 0; i < len; i++) {
+		spi_dma_mem[SPI_DMA_TX_OFFSET + i] = (uint8_t)tbuf[i];
+	}
+	__sync_synchronize();
+
+	bcm2835_peri_set_bits(paddr, BCM2835_SPI0_CS_CLEAR, BCM2835_SPI0_CS_CLEAR);
+	bcm2835_peri_write(bcm2835_spi0 + BCM2835_SPI0_DLEN/4, len);
+	bcm2835_peri_set_bits(paddr, spiDma, spiDma);
+	spi_dma_start(BCM2835_SPI_DMA_RX_CHANNEL, SPI_DMA_CB_OFFSET + sizeof(bcm2835_dma_cb_t));
+	spi_dma_start(BCM2835_SPI_DMA_TX_CHANNEL, SPI_DMA_CB_OFFSET);
+
+	/* The RX channel ends after the last byte came in, until then others may run */
+	start = bcm2835_st_read();
+	while (!(bcm2835_peri_read(rxcs) & (BCM2835_DMA_CS_END | BCM2835_DMA_CS_ERROR)) &&
+	        bcm2835_st_read() - start < SPI_DMA_TIMEOUT_US) {
+		sched_yield();
+	}
+	while (!(bcm2835_peri_read(paddr) & BCM2835_SPI0_CS_DONE) &&
+	        bcm2835_st_read() - start < SPI_DMA_TIMEOUT_US)
+		;
+	ok = (bcm2835_peri_read(rxcs) & (BCM2835_DMA_CS_END | BCM2835_DMA_CS_ERROR)) ==
+	     BCM2835_DMA_CS_END && (bcm2835_peri_read(paddr) & BCM2835_SPI0_CS_DONE);
+
+	bcm2835_peri_set_bits(paddr, BCM2835_SPI0_CS_CLEAR, spiDma | BCM2835_SPI0_CS_CLEAR);
+	if (!ok) {
+		logError("bcm2835_spi_transfernb_dma: transfer failed, using polled transfers\n");
+		bcm2835_peri_write(spi_dma_channel(BCM2835_SPI_DMA_TX_CHANNEL) + BCM2835_DMA_CS/4,
+		                   BCM2835_DMA_CS_RESET);
+		bcm2835_peri_write(rxcs, BCM2835_DMA_CS_RESET);
+		spi_dma_release();
+		spi_dma_state = -1;
+		return 0;
+	}
+	__sync_synchronize();
+	for (i = 0; i < len; i++) {
+		rbuf[i] = (char)spi_dma_mem[SPI_DMA_RX_OFFSET + i];
+	}
+	return 1;
+}
+
 void bcm2835_spi_chipSelect(uint8_t cs)
 {
 	volatile uint32_t* paddr = bcm2835_spi0 + BCM2835_SPI0_CS/4;
@@ -1386,6 +1600,8 @@ int bcm2835_close(void)
 		return 1;    /* Success */
 	}
 
+	spi_dma_release();
+	spi_dma_state = 0;
 	unmapmem((void**) &bcm2835_peripherals, bcm2835_peripherals_size);
 	bcm2835_peripherals = MAP_FAILED;
 	bcm2835_gpio = MAP_FAILED;
@@ -523,6 +523,11 @@
 #define BCM2835_GPIO_PWM                0x20C000
 /*! Base Address of the BSC1 registers */
 #define BCM2835_BSC1_BASE		0x804000
+/*! Base Address of the DMA controller, channel n is at BCM2835_DMA_BASE + n * 0x100 */
+#define BCM2835_DMA_BASE		0x007000
+
+/*! Peripherals block as seen by the DMA controller (bus address) */
+#define BCM2835_PERI_BUS_BASE           0x7E000000
 
 /*! Physical address and size of the peripherals block
   May be overridden on RPi2
@@ -817,6 +822,49 @@ typedef enum {
 #define BCM2835_SPI0_CS_CPHA                 0x00000004 /*!< Clock Phase */
 #define BCM2835_SPI0_CS_CS                   0x00000003 /*!< Chip Select */
 
+/* Defines for DMA
+   Offsets into one channel of the DMA controller in bytes per 4.2.1 DMA Controller Registers
+*/
+#define BCM2835_DMA_CS                       0x0000 /*!< DMA Channel Control and Status */
+#define BCM2835_DMA_CONBLK_AD                0x0004 /*!< DMA Channel Control Block Address */
+#define BCM2835_DMA_DEBUG                    0x0020 /*!< DMA Channel Debug */
+
+/* Register masks for DMA_CS */
+#define BCM2835_DMA_CS_RESET                 0x80000000 /*!< Channel Reset */
+#define BCM2835_DMA_CS_ABORT                 0x40000000 /*!< Abort current Control Block */
+#define BCM2835_DMA_CS_WAIT_WRITES           0x10000000 /*!< Wait for outstanding writes */
+#define BCM2835_DMA_CS_PANIC_PRIORITY(x)     (((x) & 0xF) << 20) /*!< AXI Panic Priority */
+#define BCM2835_DMA_CS_PRIORITY(x)           (((x) & 0xF) << 16) /*!< AXI Priority */
+#define BCM2835_DMA_CS_ERROR                 0x00000100 /*!< Channel has an error */
+#define BCM2835_DMA_CS_INT                   0x00000004 /*!< Interrupt status */
+#define BCM2835_DMA_CS_END                   0x00000002 /*!< Transfer complete */
+#define BCM2835_DMA_CS_ACTIVE                0x00000001 /*!< Activate the channel */
+
+/* Register masks for the TI word of a DMA control block */
+#define BCM2835_DMA_TI_PERMAP(x)             (((x) & 0x1F) << 16) /*!< Peripheral paced by DREQ */
+#define BCM2835_DMA_TI_SRC_DREQ              0x00000400 /*!< Source reads paced by DREQ */
+#define BCM2835_DMA_TI_SRC_INC               0x00000100 /*!< Source address increments */
+#define BCM2835_DMA_TI_DEST_DREQ             0x00000040 /*!< Destination writes paced by DREQ */
+#define BCM2835_DMA_TI_DEST_INC              0x00000010 /*!< Destination address increments */
+#define BCM2835_DMA_TI_WAIT_RESP             0x00000008 /*!< Wait for the write response */
+
+/* Register masks for DMA_DEBUG */
+#define BCM2835_DMA_DEBUG_CLEAR              0x00000007 /*!< Clear the read, FIFO and last errors */
+
+#define BCM2835_DMA_DREQ_SPI_TX              6 /*!< DREQ of the SPI0 TX FIFO */
+#define BCM2835_DMA_DREQ_SPI_RX              7 /*!< DREQ of the SPI0 RX FIFO */
+
+/*! DMA channel feeding the SPI0 TX FIFO, must be a free full or lite channel (0-14) */
+#ifndef BCM2835_SPI_DMA_TX_CHANNEL
+#define BCM2835_SPI_DMA_TX_CHANNEL           8
+#endif
+/*! DMA channel draining the SPI0 RX FIFO, must be a free full or lite channel (0-14) */
+#ifndef BCM2835_SPI_DMA_RX_CHANNEL
+#define BCM2835_SPI_DMA_RX_CHANNEL           9
+#endif
+/*! Longest transfer bcm2835_spi_transfernb_dma() moves, longer ones return 0 */
+#define BCM2835_SPI_DMA_MAX_LENGTH           2016
+
 /*! \brief bcm2835SPIBitOrder SPI Bit order
   Specifies the SPI data bit ordering for bcm2835_spi_setBitOrder()
 */
@@ -1472,6 +1520,20 @@ extern void bcm2835_spi_transfernb(char* tbuf, char* rbuf, uint32_t len);
 */
 extern void bcm2835_spi_transfern(char* buf, uint32_t len);
 
+/*! Transfers any number of bytes to and from the currently selected SPI slave like
+  bcm2835_spi_transfernb(), but the FIFOs are fed and drained by two DMA channels
+  (BCM2835_SPI_DMA_TX_CHANNEL and BCM2835_SPI_DMA_RX_CHANNEL) as per section 10.6.3 of the
+  BCM 2835 ARM Peripherals manual. The calling thread yields the CPU until the transfer is done.
+  The DMA memory is allocated from the VideoCore through /dev/vcio on the first call.
+  \param[in] tbuf Buffer of bytes to send.
+  \param[out] rbuf Received bytes will by put in this buffer
+  \param[in] len Number of bytes to send/receive, at most BCM2835_SPI_DMA_MAX_LENGTH
+  \return 1 if the transfer was done, 0 if nothing was transferred and
+  bcm2835_spi_transfernb() has to be used (DMA not available, or len too long)
+  \sa bcm2835_spi_transfernb()
+*/
+extern int bcm2835_spi_transfernb_dma(char* tbuf, char* rbuf, uint32_t len);
+
 /*! Transfers any number of bytes to the currently selected SPI slave.
   Asserts the currently selected CS pins (as previously set by bcm2835_spi_chipSelect)
   during the transfer.
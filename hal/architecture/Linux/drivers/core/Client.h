@@ -22,6 +22,7 @@
 #ifndef client_h
 #define client_h
 
+#include <sys/uio.h>
 #include "Stream.h"
 #include "IPAddress.h"
 
@@ -34,6 +35,14 @@ public:
 	virtual int connect(const char *host, uint16_t port) = 0;
 	virtual size_t write(uint8_t) = 0;
 	virtual size_t write(const uint8_t *buf, size_t size) = 0;
+	virtual size_t writev(const struct iovec *iov, int iovcnt)
+	{
+		size_t bytes = 0;
+		for (int i = 0; i < iovcnt; i++) {
+			bytes += write((const uint8_t *)iov[i].iov_base, iov[i].iov_len);
+		}
+		return bytes;
+	}
 	virtual int available() = 0;
 	virtual int read() = 0;
 	virtual int read(uint8_t *buf, size_t size) = 0;
@@ -28,16 +28,27 @@
 #include <arpa/inet.h>
 #include <cstring>
 #include <unistd.h>
-#include <sys/time.h>
+#include <time.h>
 #include <netinet/tcp.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include "log.h"
+#include "eventloop.h"
 
-EthernetClient::EthernetClient() : _sock(-1)
+static int64_t _now()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+EthernetClient::EthernetClient() : _sock(-1), _rxPos(0), _rxLen(0), _connecting(false)
 {
 }
 
-EthernetClient::EthernetClient(int sock) : _sock(sock)
+EthernetClient::EthernetClient(int sock) : _sock(sock), _rxPos(0), _rxLen(0), _connecting(false)
 {
 }
 
@@ -49,6 +60,10 @@ int EthernetClient::connect(const char* host, uint16_t port)
 	char port_str[6];
 	bool use_bind = (_srcip != 0);
 
+	if (_connecting) {
+		return connectResult();
+	}
+
 	close();
 
 	memset(&hints, 0, sizeof hints);
@@ -63,6 +78,7 @@ int EthernetClient::connect(const char* host, uint16_t port)
 	if (use_bind) {
 		if ((rv = getaddrinfo(_srcip.toString().c_str(), port_str, &hints, &localinfo)) != 0) {
 			logError("getaddrinfo: %s\n", gai_strerror(rv));
+			freeaddrinfo(servinfo);
 			return -1;
 		}
 	}
@@ -74,16 +90,23 @@ int EthernetClient::connect(const char* host, uint16_t port)
 			logError("socket: %s\n", strerror(errno));
 			continue;
 		}
+		fcntl(_sock, F_SETFL, O_NONBLOCK);
 
 		if (use_bind) {
 			if (::bind(_sock, localinfo->ai_addr, localinfo->ai_addrlen) == -1) {
 				close();
 				logError("bind: %s\n", strerror(errno));
-				return -1;
+				p = NULL;
+				break;
 			}
 		}
 
 		if (::connect(_sock, p->ai_addr, p->ai_addrlen) == -1) {
+			if (errno == EINPROGRESS) {
+				_connecting = true;
+				_connectStart = _now();
+				break;
+			}
 			close();
 			logError("connect: %s\n", strerror(errno));
 			continue;
@@ -92,20 +115,62 @@ int EthernetClient::connect(const char* host, uint16_t port)
 		break;
 	}
 
+	if (p != NULL) {
+		void *addr = &(((struct sockaddr_in*)p->ai_addr)->sin_addr);
+		inet_ntop(p->ai_family, addr, s, sizeof s);
+	}
+
+	freeaddrinfo(servinfo); // all done with this structure
+	if (use_bind) {
+		freeaddrinfo(localinfo); // all done with this structure
+	}
+
 	if (p == NULL) {
 		logError("failed to connect\n");
 		return -1;
 	}
 
-	void *addr = &(((struct sockaddr_in*)p->ai_addr)->sin_addr);
-	inet_ntop(p->ai_family, addr, s, sizeof s);
+	eventLoopAdd(_sock);
+	if (_connecting) {
+		logDebug("connecting to %s\n", s);
+		return connectResult();
+	}
 	logDebug("connected to %s\n", s);
 
-	freeaddrinfo(servinfo); // all done with this structure
-	if (use_bind) {
-		freeaddrinfo(localinfo); // all done with this structure
+	return 1;
+}
+
+bool EthernetClient::connecting()
+{
+	return _connecting;
+}
+
+int EthernetClient::connectResult()
+{
+	struct pollfd pfd;
+	int err = 0;
+	socklen_t len = sizeof(err);
+
+	pfd.fd = _sock;
+	pfd.events = POLLOUT;
+	pfd.revents = 0;
+	if (poll(&pfd, 1, 0) == 0) {
+		if (_now() - _connectStart < ETHERNETCLIENT_CONNECT_TIMEOUT_MS) {
+			return 0;
+		}
+		err = ETIMEDOUT;
+	} else if (getsockopt(_sock, SOL_SOCKET, SO_ERROR, &err, &len) == -1) {
+		err = errno;
 	}
 
+	_connecting = false;
+	if (err != 0) {
+		logError("connect: %s\n", strerror(err));
+		close();
+		return -1;
+	}
+	logDebug("connected\n");
+
 	return 1;
 }
 
@@ -141,6 +206,47 @@ size_t EthernetClient::write(const uint8_t *buf, size_t size)
 	return bytes;
 }
 
+size_t EthernetClient::writev(const struct iovec *iov, int iovcnt)
+{
+	struct iovec vec[ETHERNETCLIENT_MAX_IOV];
+	struct msghdr msg;
+	size_t bytes = 0;
+
+	if (_sock == -1) {
+		return 0;
+	}
+	if (iovcnt > ETHERNETCLIENT_MAX_IOV) {
+		return Client::writev(iov, iovcnt);
+	}
+
+	memcpy(vec, iov, iovcnt * sizeof(struct iovec));
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = vec;
+	msg.msg_iovlen = iovcnt;
+
+	while (msg.msg_iovlen > 0) {
+		ssize_t rc = sendmsg(_sock, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (rc == -1) {
+			logError("sendmsg: %s\n", strerror(errno));
+			close();
+			break;
+		}
+		bytes += rc;
+		// skip what has been sent, a partial send leaves the rest for the next round
+		while (msg.msg_iovlen > 0 && (size_t)rc >= msg.msg_iov->iov_len) {
+			rc -= msg.msg_iov->iov_len;
+			msg.msg_iov++;
+			msg.msg_iovlen--;
+		}
+		if (msg.msg_iovlen > 0) {
+			msg.msg_iov->iov_base = (uint8_t *)msg.msg_iov->iov_base + rc;
+			msg.msg_iov->iov_len -= rc;
+		}
+	}
+
+	return bytes;
+}
+
 size_t EthernetClient::write(const char *str)
 {
 	if (str == NULL) {
@@ -155,41 +261,64 @@ size_t EthernetClient::write(const char *buffer, size_t size)
 
 int EthernetClient::available()
 {
-	int count = 0;
-
-	if (_sock != -1) {
-		ioctl(_sock, SIOCINQ, &count);
+	if (_rxPos < _rxLen) {
+		return _rxLen - _rxPos;
 	}
 
-	return count;
+	return fill();
 }
 
 int EthernetClient::read()
 {
-	uint8_t b;
-	if ( recv(_sock, &b, 1, MSG_DONTWAIT) > 0 ) {
-		// recv worked
-		return b;
-	} else {
+	if (_rxPos >= _rxLen && fill() == 0) {
 		// No data available
 		return -1;
 	}
+
+	return _rxBuffer[_rxPos++];
 }
 
 int EthernetClient::read(uint8_t *buf, size_t bytes)
 {
-	return recv(_sock, buf, bytes, MSG_DONTWAIT);
+	size_t count = _rxLen - _rxPos;
+
+	if (count == 0) {
+		return recv(_sock, buf, bytes, MSG_DONTWAIT);
+	}
+
+	if (count > bytes) {
+		count = bytes;
+	}
+	memcpy(buf, _rxBuffer + _rxPos, count);
+	_rxPos += count;
+
+	return count;
 }
 
 int EthernetClient::peek()
 {
-	uint8_t b;
-
-	if (recv(_sock, &b, 1, MSG_PEEK | MSG_DONTWAIT) > 0) {
-		return b;
-	} else {
+	if (_rxPos >= _rxLen && fill() == 0) {
 		return -1;
 	}
+
+	return _rxBuffer[_rxPos];
+}
+
+int EthernetClient::fill()
+{
+	_rxPos = 0;
+	_rxLen = 0;
+
+	if (_sock == -1) {
+		return 0;
+	}
+
+	ssize_t rc = recv(_sock, _rxBuffer, sizeof(_rxBuffer), MSG_DONTWAIT);
+	if (rc > 0) {
+		_rxLen = rc;
+	}
+
+	return _rxLen;
 }
 
 void EthernetClient::flush()
@@ -213,26 +342,17 @@ void EthernetClient::stop()
 		return;
 	}
 
-	// attempt to close the connection gracefully (send a FIN to other side)
+	// attempt to close the connection gracefully (send a FIN to other side),
+	// the kernel completes the close in the background
 	shutdown(_sock, SHUT_RDWR);
 
-	timeval startTime, curTime;
-	gettimeofday(&startTime, NULL);
-
-	// wait up to a second for the connection to close
-	do {
-		uint8_t s = status();
-		if (s == ETHERNETCLIENT_W5100_CLOSED) {
-			break; // exit the loop
-		}
-		usleep(1000);
-		gettimeofday(&curTime, NULL);
-	} while (((curTime.tv_sec - startTime.tv_sec) * 1000000) + (curTime.tv_usec - startTime.tv_usec) <
-	         1000000);
-
 	// free up the socket descriptor
+	eventLoopRemove(_sock);
 	::close(_sock);
 	_sock = -1;
+	_rxPos = 0;
+	_rxLen = 0;
+	_connecting = false;
 }
 
 uint8_t EthernetClient::status()
@@ -271,20 +391,48 @@ uint8_t EthernetClient::status()
 		}
 	}
 
+	int domain = 0;
+	socklen_t domain_length = sizeof(domain);
+	if (getsockopt(_sock, SOL_SOCKET, SO_DOMAIN, &domain, &domain_length) == 0 && domain == AF_UNIX) {
+		// no TCP state, a local connection is open until the peer closed it
+		char c;
+		const ssize_t n = recv(_sock, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+		if (n > 0 || (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))) {
+			return ETHERNETCLIENT_W5100_ESTABLISHED;
+		}
+	}
+
 	return ETHERNETCLIENT_W5100_CLOSED;
 }
 
 uint8_t EthernetClient::connected()
 {
-	return status() == ETHERNETCLIENT_W5100_ESTABLISHED || available();
+	if (_rxPos < _rxLen) {
+		return 1;
+	}
+	if (status() == ETHERNETCLIENT_W5100_ESTABLISHED) {
+		return 1;
+	}
+
+	// Don't consume here: EthernetServer checks temporary copies sharing the same socket
+	int count = 0;
+	if (_sock != -1) {
+		ioctl(_sock, SIOCINQ, &count);
+	}
+
+	return count > 0;
 }
 
 void EthernetClient::close()
 {
 	if (_sock != -1) {
+		eventLoopRemove(_sock);
 		::close(_sock);
 		_sock = -1;
 	}
+	_rxPos = 0;
+	_rxLen = 0;
+	_connecting = false;
 }
 
 void EthernetClient::bind(IPAddress ip)
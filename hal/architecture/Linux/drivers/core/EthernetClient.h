@@ -22,9 +22,22 @@
 #ifndef EthernetClient_h
 #define EthernetClient_h
 
+#include <sys/time.h>
 #include "Client.h"
 #include "IPAddress.h"
 
+#ifndef ETHERNETCLIENT_CONNECT_TIMEOUT_MS
+#define ETHERNETCLIENT_CONNECT_TIMEOUT_MS 5000 //!< Time after which a pending connect is given up
+#endif
+
+#ifndef ETHERNETCLIENT_RX_BUFFER_SIZE
+#define ETHERNETCLIENT_RX_BUFFER_SIZE 256 //!< Size of the per-client receive buffer
+#endif
+
+#ifndef ETHERNETCLIENT_MAX_IOV
+#define ETHERNETCLIENT_MAX_IOV 8 //!< Most buffers writev() sends with a single sendmsg()
+#endif
+
 // State codes from W5100 library
 #define ETHERNETCLIENT_W5100_CLOSED 0x00
 #define ETHERNETCLIENT_W5100_LISTEN 0x14
@@ -57,9 +70,12 @@ public:
 	/**
 	 * @brief Initiate a connection with host:port.
 	 *
+	 * The connection is established without blocking. While it is pending, further calls only
+	 * check its progress, so callers simply retry until the result is no longer 0.
+	 *
 	 * @param host name to resolve or a stringified dotted IP address.
 	 * @param port to connect to.
-	 * @return 1 if SUCCESS or -1 if FAILURE.
+	 * @return 1 if SUCCESS, 0 if the connection is still pending or -1 if FAILURE.
 	 */
 	virtual int connect(const char *host, uint16_t port);
 	/**
@@ -67,9 +83,15 @@ public:
 	 *
 	 * @param ip to connect to.
 	 * @param port to connect to.
-	 * @return 1 if SUCCESS or -1 if FAILURE.
+	 * @return 1 if SUCCESS, 0 if the connection is still pending or -1 if FAILURE.
 	 */
 	virtual int connect(IPAddress ip, uint16_t port);
+	/**
+	 * @brief Whether a connection attempt started by connect() is still pending.
+	 *
+	 * @return @c true if connect() has to be called again to complete the connection.
+	 */
+	bool connecting();
 	/**
 	 * @brief Write a byte.
 	 *
@@ -85,6 +107,14 @@ public:
 	 * @return 0 if FAILURE or the number of bytes sent.
 	 */
 	virtual size_t write(const uint8_t *buf, size_t size);
+	/**
+	 * @brief Write several buffers with a single system call.
+	 *
+	 * @param iov Buffers to write, in order.
+	 * @param iovcnt Number of buffers.
+	 * @return 0 if FAILURE or the number of bytes sent.
+	 */
+	virtual size_t writev(const struct iovec *iov, int iovcnt);
 	/**
 	 * @brief Write a null-terminated string.
 	 *
@@ -103,6 +133,8 @@ public:
 	/**
 	 * @brief Returns the number of bytes available for reading.
 	 *
+	 * If the receive buffer is empty, it is refilled with a single non-blocking recv().
+	 *
 	 * @return number of bytes available.
 	 */
 	virtual int available();
@@ -206,6 +238,24 @@ public:
 private:
 	int _sock; //!< @brief Network socket file descriptor.
 	IPAddress _srcip; //!< @brief Local ip to bind to.
+	uint8_t _rxBuffer[ETHERNETCLIENT_RX_BUFFER_SIZE]; //!< @brief Receive buffer.
+	size_t _rxPos; //!< @brief Read position in the receive buffer.
+	size_t _rxLen; //!< @brief Number of valid bytes in the receive buffer.
+	bool _connecting; //!< @brief A non-blocking connect is in progress.
+	int64_t _connectStart; //!< @brief Time the pending connect was started, CLOCK_MONOTONIC in ms.
+
+	/**
+	 * @brief Refill the receive buffer with a single non-blocking recv().
+	 *
+	 * @return number of buffered bytes.
+	 */
+	int fill();
+	/**
+	 * @brief Check the progress of a pending non-blocking connect.
+	 *
+	 * @return 1 if connected, 0 if still pending or -1 if it failed or timed out.
+	 */
+	int connectResult();
 };
 
 #endif
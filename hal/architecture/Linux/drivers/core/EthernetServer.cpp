@@ -26,16 +26,31 @@
 #include <sys/socket.h>
 #include <netdb.h>
 #include <arpa/inet.h>
+#include <sys/un.h>
 #include <unistd.h>
 #include <errno.h>
+#include <time.h>
 #include <fcntl.h>
+#include <sys/epoll.h>
+#include <algorithm>
 #include "log.h"
+#include "eventloop.h"
 #include "EthernetClient.h"
 
+static int64_t _now()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
 EthernetServer::EthernetServer(uint16_t port, uint16_t max_clients) : port(port),
-	max_clients(max_clients), sockfd(-1)
+	max_clients(max_clients), sockfd(-1), unixfd(-1), epollfd(-1), txFlushDelay(0),
+	txFlushThreshold(0)
 {
 	clients.reserve(max_clients);
+	txBuffers.reserve(max_clients);
 }
 
 void EthernetServer::begin()
@@ -51,7 +66,16 @@ void EthernetServer::begin(IPAddress address)
 	char ipstr[INET_ADDRSTRLEN];
 	char portstr[6];
 
+	if (epollfd == -1) {
+		if ((epollfd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+			logError("epoll_create1: %s\n", strerror(errno));
+			return;
+		}
+		// readable for the event loop while any of our sockets has an event
+		eventLoopAdd(epollfd);
+	}
 	if (sockfd != -1) {
+		epoll_ctl(epollfd, EPOLL_CTL_DEL, sockfd, NULL);
 		close(sockfd);
 		sockfd = -1;
 	}
@@ -104,6 +128,13 @@ void EthernetServer::begin(IPAddress address)
 	freeaddrinfo(servinfo);
 
 	fcntl(sockfd, F_SETFL, O_NONBLOCK);
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = sockfd;
+	if (epoll_ctl(epollfd, EPOLL_CTL_ADD, sockfd, &ev) == -1) {
+		logError("epoll_ctl: %s\n", strerror(errno));
+	}
 
 	struct sockaddr_in *ipv4 = (struct sockaddr_in *)p->ai_addr;
 	void *addr = &(ipv4->sin_addr);
@@ -111,27 +142,57 @@ void EthernetServer::begin(IPAddress address)
 	logDebug("Listening for connections on %s:%s\n", ipstr, portstr);
 }
 
-bool EthernetServer::hasClient()
+void EthernetServer::beginUnix(const char *path)
 {
-	// Check if any client has disconnected
-	for (size_t i = 0; i < clients.size(); ++i) {
-		EthernetClient client(clients[i]);
-		if (!client.connected()) {
-			// Checks if this disconnected client is also on the new clients list
-			for (std::list<int>::iterator it = new_clients.begin(); it != new_clients.end(); ++it) {
-				if (*it == clients[i]) {
-					new_clients.erase(it);
-					break;
-				}
-			}
-			client.stop();
-			clients[i] = clients.back();
-			clients.pop_back();
-			logDebug("Ethernet client disconnected.\n");
+	struct sockaddr_un addr;
+
+	if (epollfd == -1) {
+		if ((epollfd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+			logError("epoll_create1: %s\n", strerror(errno));
+			return;
 		}
+		eventLoopAdd(epollfd);
+	}
+	if (unixfd != -1) {
+		epoll_ctl(epollfd, EPOLL_CTL_DEL, unixfd, NULL);
+		close(unixfd);
+		unixfd = -1;
+	}
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		logError("Unix socket path too long: %s\n", path);
+		return;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	if ((unixfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0)) == -1) {
+		logError("socket: %s\n", strerror(errno));
+		return;
+	}
+	// left behind by a previous run
+	unlink(path);
+	if (bind(unixfd, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+	        listen(unixfd, ETHERNETSERVER_BACKLOG) == -1) {
+		logError("bind to %s: %s\n", path, strerror(errno));
+		close(unixfd);
+		unixfd = -1;
+		return;
 	}
 
-	_accept();
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = unixfd;
+	if (epoll_ctl(epollfd, EPOLL_CTL_ADD, unixfd, &ev) == -1) {
+		logError("epoll_ctl: %s\n", strerror(errno));
+	}
+	logDebug("Listening for connections on %s\n", path);
+}
+
+bool EthernetServer::hasClient()
+{
+	_poll();
 
 	return !new_clients.empty();
 }
@@ -147,6 +208,91 @@ EthernetClient EthernetServer::available()
 	}
 }
 
+int EthernetServer::readableClient()
+{
+	if (readable_clients.empty()) {
+		_poll();
+		if (readable_clients.empty()) {
+			return -1;
+		}
+	}
+	int sock = readable_clients.front();
+	readable_clients.pop_front();
+	return sock;
+}
+
+void EthernetServer::setReadable(int sock)
+{
+	if (indexes.count(sock) &&
+	        std::find(readable_clients.begin(), readable_clients.end(), sock) == readable_clients.end()) {
+		readable_clients.push_back(sock);
+	}
+}
+
+int EthernetServer::closedClient()
+{
+	if (closed_clients.empty()) {
+		return -1;
+	}
+	int sock = closed_clients.front();
+	closed_clients.pop_front();
+	return sock;
+}
+
+void EthernetServer::_poll()
+{
+	struct epoll_event events[ETHERNETSERVER_MAX_EVENTS];
+
+	if (epollfd == -1) {
+		return;
+	}
+	int n = epoll_wait(epollfd, events, ETHERNETSERVER_MAX_EVENTS, 0);
+	if (n == -1) {
+		if (errno != EINTR) {
+			logError("epoll_wait: %s\n", strerror(errno));
+		}
+		return;
+	}
+	for (int i = 0; i < n; i++) {
+		const int sock = events[i].data.fd;
+		if (sock == sockfd || sock == unixfd) {
+			while (_accept(sock)) {
+				// take the whole backlog
+			}
+			continue;
+		}
+		if (events[i].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+			// input sent before the hangup is still delivered
+			char c;
+			if (recv(sock, &c, 1, MSG_PEEK | MSG_DONTWAIT) <= 0) {
+				_closed(sock);
+				continue;
+			}
+		}
+		setReadable(sock);
+	}
+}
+
+void EthernetServer::_closed(int sock)
+{
+	std::unordered_map<int, size_t>::iterator it = indexes.find(sock);
+	if (it == indexes.end()) {
+		return;
+	}
+	epoll_ctl(epollfd, EPOLL_CTL_DEL, sock, NULL);
+	_remove(it->second);
+	readable_clients.remove(sock);
+	logDebug("Ethernet client disconnected.\n");
+	std::list<int>::iterator pending = std::find(new_clients.begin(), new_clients.end(), sock);
+	if (pending != new_clients.end()) {
+		// nobody took it yet
+		new_clients.erase(pending);
+		close(sock);
+	} else {
+		closed_clients.push_back(sock);
+	}
+}
+
 size_t EthernetServer::write(uint8_t b)
 {
 	return write(&b, 1);
@@ -157,15 +303,45 @@ size_t EthernetServer::write(const uint8_t *buffer, size_t size)
 	size_t n = 0;
 
 	for (size_t i = 0; i < clients.size(); ++i) {
-		EthernetClient client(clients[i]);
-		if (client.status() == ETHERNETCLIENT_W5100_ESTABLISHED) {
-			n += client.write(buffer, size);
-		}
+		n += _queue(i, buffer, size);
 	}
 
 	return n;
 }
 
+size_t EthernetServer::write(int sock, const uint8_t *buffer, size_t size)
+{
+	std::unordered_map<int, size_t>::iterator it = indexes.find(sock);
+	if (it == indexes.end()) {
+		return 0;
+	}
+
+	return _queue(it->second, buffer, size);
+}
+
+size_t EthernetServer::_queue(size_t i, const uint8_t *buffer, size_t size)
+{
+	std::vector<uint8_t> &data = txBuffers[i].data;
+	if (data.size() + size > ETHERNETSERVER_TX_BUFFER_SIZE) {
+		_flush(i);
+		if (data.size() + size > ETHERNETSERVER_TX_BUFFER_SIZE) {
+			logDebug("Ethernet client tx buffer full, %zu bytes dropped.\n", size);
+			return 0;
+		}
+	}
+	const bool wasEmpty = data.empty();
+	data.insert(data.end(), buffer, buffer + size);
+	if (data.size() >= txFlushThreshold) {
+		_flush(i);
+	}
+	if (wasEmpty && !data.empty()) {
+		txBuffers[i].since = _now();
+		eventLoopWakeupIn(txFlushDelay);
+	}
+
+	return size;
+}
+
 size_t EthernetServer::write(const char *str)
 {
 	if (str == NULL) {
@@ -179,7 +355,79 @@ size_t EthernetServer::write(const char *buffer, size_t size)
 	return write((const uint8_t *)buffer, size);
 }
 
-void EthernetServer::_accept()
+void EthernetServer::setTxCoalescing(uint32_t flushDelayMs, size_t flushThreshold)
+{
+	txFlushDelay = flushDelayMs;
+	txFlushThreshold = flushThreshold;
+}
+
+void EthernetServer::flushIfDue()
+{
+	const int64_t now = _now();
+
+	for (size_t i = 0; i < clients.size(); ++i) {
+		txBuffer &tx = txBuffers[i];
+		if (tx.data.empty()) {
+			continue;
+		}
+		const int64_t age = now - tx.since;
+		if (age >= txFlushDelay) {
+			_flush(i);
+			if (!tx.data.empty()) {
+				// socket is full, retry on the next tick
+				tx.since = now;
+			}
+		} else {
+			eventLoopWakeupIn(txFlushDelay - age);
+		}
+	}
+}
+
+void EthernetServer::flush()
+{
+	for (size_t i = 0; i < clients.size(); ++i) {
+		_flush(i);
+	}
+}
+
+void EthernetServer::_flush(size_t i)
+{
+	std::vector<uint8_t> &data = txBuffers[i].data;
+	size_t sent = 0;
+
+	while (sent < data.size()) {
+		ssize_t rc = send(clients[i], &data[sent], data.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (rc == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				logError("send: %s\n", strerror(errno));
+				// the hangup event removes the client
+				shutdown(clients[i], SHUT_RDWR);
+				data.clear();
+				return;
+			}
+			break;
+		}
+		sent += rc;
+	}
+	data.erase(data.begin(), data.begin() + sent);
+}
+
+void EthernetServer::_remove(size_t i)
+{
+	indexes.erase(clients[i]);
+	clients[i] = clients.back();
+	clients.pop_back();
+	if (i < clients.size()) {
+		indexes[clients[i]] = i;
+	}
+	txBuffers[i] = txBuffers.back();
+	txBuffers.pop_back();
+}
+
+bool EthernetServer::_accept(int listenfd)
 {
 	int new_fd;
 	socklen_t sin_size;
@@ -187,25 +435,40 @@ void EthernetServer::_accept()
 	char ipstr[INET_ADDRSTRLEN];
 
 	sin_size = sizeof client_addr;
-	new_fd = accept(sockfd, (struct sockaddr *)&client_addr, &sin_size);
+	new_fd = accept(listenfd, (struct sockaddr *)&client_addr, &sin_size);
 	if (new_fd == -1) {
 		if (errno != EAGAIN && errno != EWOULDBLOCK) {
 			logError("accept: %s\n", strerror(errno));
 		}
-		return;
+		return false;
 	}
 
 	if (clients.size() == max_clients) {
-		// no free slots, search for a dead client
 		close(new_fd);
 		logDebug("Max number of ethernet clients reached.\n");
-		return;
+		return true;
 	}
 
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLRDHUP;
+	ev.data.fd = new_fd;
+	if (epoll_ctl(epollfd, EPOLL_CTL_ADD, new_fd, &ev) == -1) {
+		logError("epoll_ctl: %s\n", strerror(errno));
+		close(new_fd);
+		return true;
+	}
 	new_clients.push_back(new_fd);
+	indexes[new_fd] = clients.size();
 	clients.push_back(new_fd);
+	txBuffers.push_back(txBuffer());
 
+	if (client_addr.ss_family == AF_UNIX) {
+		logDebug("New local connection\n");
+		return true;
+	}
 	void *addr = &(((struct sockaddr_in*)&client_addr)->sin_addr);
 	inet_ntop(client_addr.ss_family, addr, ipstr, sizeof ipstr);
 	logDebug("New connection from %s\n", ipstr);
+	return true;
 }
@@ -24,6 +24,7 @@
 
 #include <list>
 #include <vector>
+#include <unordered_map>
 #include "Server.h"
 #include "IPAddress.h"
 
@@ -34,10 +35,22 @@
 #define ETHERNETSERVER_BACKLOG 10 //!< Maximum length to which the queue of pending connections may grow.
 #endif
 
+#ifndef ETHERNETSERVER_MAX_EVENTS
+#define ETHERNETSERVER_MAX_EVENTS 64 //!< Connection events taken from the kernel at once.
+#endif
+
+#ifndef ETHERNETSERVER_TX_BUFFER_SIZE
+#define ETHERNETSERVER_TX_BUFFER_SIZE 8192 //!< Maximum number of pending outbound bytes per client.
+#endif
+
 class EthernetClient;
 
 /**
  * @brief EthernetServer class
+ *
+ * The listening sockets and the client sockets are watched by an epoll instance of the server,
+ * which is itself watched by the event loop. Accepts, input and hangups are taken from it as
+ * events, idle clients cost nothing per loop iteration.
  */
 class EthernetServer : public Server
 {
@@ -61,9 +74,19 @@ public:
 	 * @param addr IP address to bind to.
 	 */
 	void begin(IPAddress addr);
+	/**
+	 * @brief Also listen for inbound connection requests on a Unix domain socket.
+	 *
+	 * Local clients are served like the network clients. A stale socket file at path is removed.
+	 *
+	 * @param path socket file.
+	 */
+	void beginUnix(const char *path);
 	/**
 	 * @brief Verifies if a new client has connected.
 	 *
+	 * Takes the pending connection events, see readableClient() and closedClient().
+	 *
 	 * @return @c true if a new client has connected, else @c false.
 	 */
 	bool hasClient();
@@ -73,6 +96,52 @@ public:
 	 * @return a EthernetClient object; if no new client has connected, this object will evaluate to false.
 	 */
 	EthernetClient available();
+	/**
+	 * @brief Get the next client with pending input.
+	 *
+	 * Events are level triggered, a client whose input was not read completely is reported again
+	 * by a later call. Input kept in the buffer of an EthernetClient is not seen by the kernel,
+	 * report such a client again with setReadable().
+	 *
+	 * @return socket of the client, see EthernetClient::getSocketNumber(), -1 if none.
+	 */
+	int readableClient();
+	/**
+	 * @brief Report a client again by readableClient(), after the clients already pending.
+	 *
+	 * @param sock Socket of the client.
+	 */
+	void setReadable(int sock);
+	/**
+	 * @brief Get the next client whose connection was closed by the peer or failed.
+	 *
+	 * The server no longer serves it, the owner closes it with EthernetClient::stop().
+	 * Connections returned by available() are reported once hasClient() took their event.
+	 *
+	 * @return socket of the client, -1 if none.
+	 */
+	int closedClient();
+	/**
+	 * @brief Configure the coalescing of outbound data.
+	 *
+	 * Data written to the clients is buffered per client and sent with a single send() once the
+	 * oldest pending byte is older than flushDelayMs, at the latest with the next flushIfDue() call
+	 * after that, or as soon as flushThreshold bytes are pending.
+	 *
+	 * @param flushDelayMs maximum time in ms outbound data is held back.
+	 * @param flushThreshold number of pending bytes that triggers an immediate flush.
+	 */
+	void setTxCoalescing(uint32_t flushDelayMs, size_t flushThreshold);
+	/**
+	 * @brief Send the pending outbound data of every client whose flush deadline expired.
+	 *
+	 * Meant to be called once per main loop iteration.
+	 */
+	void flushIfDue();
+	/**
+	 * @brief Send the pending outbound data of all clients now.
+	 */
+	void flush();
 	/**
 	 * @brief Write a byte to all clients.
 	 *
@@ -83,9 +152,11 @@ public:
 	/**
 	 * @brief Write at most 'size' bytes to all clients.
 	 *
+	 * The data is appended to the outbound buffer of each client, see setTxCoalescing().
+	 *
 	 * @param buffer to read from.
 	 * @param size of the buffer.
-	 * @return 0 if FAILURE else number of bytes sent.
+	 * @return 0 if FAILURE else number of bytes queued.
 	 */
 	virtual size_t write(const uint8_t *buffer, size_t size);
 	/**
@@ -103,19 +174,82 @@ public:
 	 * @return 0 if FAILURE else the number of characters sent.
 	 */
 	size_t write(const char *buffer, size_t size);
+	/**
+	 * @brief Write at most 'size' bytes to a single client.
+	 *
+	 * The data is appended to the outbound buffer of the client, see setTxCoalescing().
+	 *
+	 * @param sock Socket of the client, see EthernetClient::getSocketNumber().
+	 * @param buffer to read from.
+	 * @param size of the buffer.
+	 * @return 0 if FAILURE else number of bytes queued.
+	 */
+	size_t write(int sock, const uint8_t *buffer, size_t size);
 
 private:
 	uint16_t port; //!< @brief Port number for the network socket.
 	std::list<int> new_clients; //!< Socket list of new connected clients.
+	std::list<int> readable_clients; //!< @brief Socket list of clients with pending input.
+	std::list<int> closed_clients; //!< @brief Socket list of closed clients not yet stopped.
 	std::vector<int> clients; //!< @brief Socket list of connected clients.
+	std::unordered_map<int, size_t> indexes; //!< @brief Index in clients by socket.
+	/**
+	 * @brief Pending outbound data of a client.
+	 */
+	struct txBuffer {
+		std::vector<uint8_t> data; //!< @brief Bytes not yet accepted by the kernel.
+		int64_t since; //!< @brief Time in ms the oldest pending byte was queued.
+	};
+	std::vector<txBuffer> txBuffers; //!< @brief Outbound buffers, same order as clients.
 	uint16_t max_clients; //!< @brief The maximum number of allowed clients.
 	int sockfd; //!< @brief Network socket used to accept connections.
+	int unixfd; //!< @brief Unix domain socket used to accept local connections.
+	int epollfd; //!< @brief Epoll instance watching sockfd and the clients.
+	uint32_t txFlushDelay; //!< @brief Maximum time in ms outbound data is held back.
+	size_t txFlushThreshold; //!< @brief Pending bytes that trigger an immediate flush.
 
 	/**
-	 * @brief Accept new clients if the total of connected clients is below max_clients.
+	 * @brief Accept a new client if the total of connected clients is below max_clients.
+	 *
+	 * @param listenfd Listening socket with the pending connection.
+	 * @return @c false if no connection was pending.
+	 */
+	bool _accept(int listenfd);
+	/**
+	 * @brief Take the pending connection events without blocking.
+	 *
+	 */
+	void _poll();
+	/**
+	 * @brief Stop serving a client whose connection is closed.
+	 *
+	 * @param sock Socket of the client.
+	 */
+	void _closed(int sock);
+	/**
+	 * @brief Remove a client from the list of connected clients.
+	 *
+	 * @param i index of the client.
+	 */
+	void _remove(size_t i);
+	/**
+	 * @brief Send as much pending outbound data of a client as the socket accepts.
+	 *
+	 * Partially sent data stays buffered, on a fatal error the connection is shut down
+	 * and later removed by hasClient().
 	 *
+	 * @param i index of the client.
+	 */
+	void _flush(size_t i);
+	/**
+	 * @brief Append data to the outbound buffer of a client.
+	 *
+	 * @param i index of the client.
+	 * @param buffer to read from.
+	 * @param size of the buffer.
+	 * @return 0 if the buffer is full else size.
 	 */
-	void _accept();
+	size_t _queue(size_t i, const uint8_t *buffer, size_t size);
 };
 
 #endif
@@ -0,0 +1,266 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * Based on Arduino ethernet library, Copyright (c) 2010 Arduino LLC. All right reserved.
+ */
+
+#include "EthernetUDP.h"
+#include <cstdio>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <errno.h>
+#include "log.h"
+#include "eventloop.h"
+
+EthernetUDP::EthernetUDP() : sockfd(-1), hostPort(0), destinationLength(0), txCount(0),
+	rxCount(0), rxIndex(0), rxPos(0)
+{
+	memset(txLength, 0, sizeof(txLength));
+	memset(rxLength, 0, sizeof(rxLength));
+}
+
+uint8_t EthernetUDP::begin(uint16_t port)
+{
+	struct sockaddr_in addr;
+
+	stop();
+	if ((sockfd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1) {
+		logError("socket: %s\n", strerror(errno));
+		return 0;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if (bind(sockfd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+		logError("bind: %s\n", strerror(errno));
+		close(sockfd);
+		sockfd = -1;
+		return 0;
+	}
+	eventLoopAdd(sockfd);
+	logDebug("Listening for datagrams on port %u\n", port);
+	return 1;
+}
+
+void EthernetUDP::stop()
+{
+	if (sockfd != -1) {
+		eventLoopRemove(sockfd);
+		close(sockfd);
+		sockfd = -1;
+	}
+	txCount = 0;
+	txLength[0] = 0;
+	destinationLength = 0;
+	rxCount = 0;
+	rxIndex = 0;
+	rxPos = 0;
+}
+
+int EthernetUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+	return beginPacket(ip.toString().c_str(), port);
+}
+
+int EthernetUDP::beginPacket(const char *host, uint16_t port)
+{
+	if (host != this->host || port != hostPort || !destinationLength) {
+		struct addrinfo hints, *result;
+		char portstr[6];
+		int rv;
+
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_DGRAM;
+		sprintf(portstr, "%u", port);
+		destinationLength = 0;
+		if ((rv = getaddrinfo(host, portstr, &hints, &result)) != 0) {
+			logError("getaddrinfo: %s\n", gai_strerror(rv));
+			return 0;
+		}
+		memcpy(&destination, result->ai_addr, result->ai_addrlen);
+		destinationLength = result->ai_addrlen;
+		freeaddrinfo(result);
+		this->host = host;
+		hostPort = port;
+	}
+	if (txCount == ETHERNETUDP_BATCH) {
+		// make room for the new datagram
+		(void)sendQueued();
+	}
+	if (txCount < ETHERNETUDP_BATCH) {
+		txLength[txCount] = 0;
+	}
+	return 1;
+}
+
+size_t EthernetUDP::write(uint8_t b)
+{
+	return write(&b, 1);
+}
+
+size_t EthernetUDP::write(const uint8_t *buffer, size_t size)
+{
+	if (txCount == ETHERNETUDP_BATCH) {
+		return 0;
+	}
+	size_t &length = txLength[txCount];
+	if (size > ETHERNETUDP_PACKET_SIZE - length) {
+		size = ETHERNETUDP_PACKET_SIZE - length;
+	}
+	memcpy(&txData[txCount][length], buffer, size);
+	length += size;
+	return size;
+}
+
+int EthernetUDP::endPacket()
+{
+	if (!destinationLength || sockfd == -1 || txCount == ETHERNETUDP_BATCH) {
+		return 0;
+	}
+	memcpy(&txDestination[txCount], &destination, destinationLength);
+	txDestinationLength[txCount] = destinationLength;
+	if (++txCount == ETHERNETUDP_BATCH) {
+		(void)sendQueued();
+	} else if (txCount == 1) {
+		// sent by the next loop iteration
+		eventLoopWakeupIn(0);
+	}
+	if (txCount < ETHERNETUDP_BATCH) {
+		txLength[txCount] = 0;
+	}
+	return 1;
+}
+
+int EthernetUDP::sendQueued()
+{
+	struct mmsghdr msgs[ETHERNETUDP_BATCH];
+	struct iovec iov[ETHERNETUDP_BATCH];
+
+	if (!txCount || sockfd == -1) {
+		return 0;
+	}
+	memset(msgs, 0, sizeof(msgs));
+	for (uint8_t i = 0; i < txCount; i++) {
+		iov[i].iov_base = txData[i];
+		iov[i].iov_len = txLength[i];
+		msgs[i].msg_hdr.msg_name = &txDestination[i];
+		msgs[i].msg_hdr.msg_namelen = txDestinationLength[i];
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+	int sent = sendmmsg(sockfd, msgs, txCount, MSG_DONTWAIT);
+	if (sent == -1) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+			// retried by the next call
+			eventLoopWakeupIn(1);
+			return 0;
+		}
+		// the first datagram failed, e.g. no route, the others may still go out later
+		logError("sendmmsg: %s\n", strerror(errno));
+		sent = 1;
+	}
+	// keep the datagrams the kernel did not take, the started one moves along
+	const uint8_t left = txCount - sent;
+	const size_t started = txCount < ETHERNETUDP_BATCH ? txLength[txCount] : 0;
+	for (uint8_t i = 0; i < left; i++) {
+		memcpy(txData[i], txData[sent + i], txLength[sent + i]);
+		txLength[i] = txLength[sent + i];
+		txDestination[i] = txDestination[sent + i];
+		txDestinationLength[i] = txDestinationLength[sent + i];
+	}
+	if (started) {
+		memcpy(txData[left], txData[txCount], started);
+	}
+	txLength[left] = started;
+	txCount = left;
+	if (txCount) {
+		eventLoopWakeupIn(1);
+	}
+	return sent;
+}
+
+int EthernetUDP::parsePacket()
+{
+	if (rxIndex < rxCount) {
+		rxIndex++;
+	}
+	if (rxIndex >= rxCount && sockfd != -1) {
+		struct mmsghdr msgs[ETHERNETUDP_BATCH];
+		struct iovec iov[ETHERNETUDP_BATCH];
+
+		memset(msgs, 0, sizeof(msgs));
+		for (uint8_t i = 0; i < ETHERNETUDP_BATCH; i++) {
+			iov[i].iov_base = rxData[i];
+			iov[i].iov_len = ETHERNETUDP_PACKET_SIZE;
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+		const int n = recvmmsg(sockfd, msgs, ETHERNETUDP_BATCH, MSG_DONTWAIT, NULL);
+		if (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+			logError("recvmmsg: %s\n", strerror(errno));
+		}
+		rxCount = n > 0 ? (uint8_t)n : 0;
+		for (uint8_t i = 0; i < rxCount; i++) {
+			rxLength[i] = msgs[i].msg_len;
+		}
+		rxIndex = 0;
+	}
+	// empty datagrams carry nothing
+	while (rxIndex < rxCount && !rxLength[rxIndex]) {
+		rxIndex++;
+	}
+	rxPos = 0;
+	return rxIndex < rxCount ? (int)rxLength[rxIndex] : 0;
+}
+
+int EthernetUDP::available()
+{
+	return rxIndex < rxCount ? (int)(rxLength[rxIndex] - rxPos) : 0;
+}
+
+int EthernetUDP::read()
+{
+	return available() ? rxData[rxIndex][rxPos++] : -1;
+}
+
+int EthernetUDP::read(uint8_t *buffer, size_t size)
+{
+	const size_t left = (size_t)available();
+	if (size > left) {
+		size = left;
+	}
+	if (size) {
+		memcpy(buffer, &rxData[rxIndex][rxPos], size);
+		rxPos += size;
+	}
+	return (int)size;
+}
+
+int EthernetUDP::peek()
+{
+	return available() ? rxData[rxIndex][rxPos] : -1;
+}
+
+void EthernetUDP::flush()
+{
+	(void)sendQueued();
+}
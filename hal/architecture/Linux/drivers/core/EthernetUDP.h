@@ -0,0 +1,165 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * Based on Arduino ethernet library, Copyright (c) 2010 Arduino LLC. All right reserved.
+ */
+
+#ifndef EthernetUDP_h
+#define EthernetUDP_h
+
+#include <string>
+#include <sys/socket.h>
+#include "Stream.h"
+#include "IPAddress.h"
+
+#ifndef ETHERNETUDP_BATCH
+#define ETHERNETUDP_BATCH 16 //!< Datagrams taken from or handed to the kernel with one syscall.
+#endif
+
+#ifndef ETHERNETUDP_PACKET_SIZE
+#define ETHERNETUDP_PACKET_SIZE 1472 //!< Largest datagram sent or received, longer ones are cut.
+#endif
+
+/**
+ * @brief EthernetUDP class
+ *
+ * Datagrams are received in batches with recvmmsg(), parsePacket() hands them out one by one and
+ * only asks the kernel again once the batch is used up. Datagrams finished with endPacket() are
+ * queued and sent together with a single sendmmsg() by sendQueued(), or once the queue is full.
+ */
+class EthernetUDP : public Stream
+{
+
+public:
+	/**
+	 * @brief EthernetUDP constructor.
+	 */
+	EthernetUDP();
+	/**
+	 * @brief Open the socket on port, watched by the event loop of the calling thread.
+	 *
+	 * @param port local port, 0 for any.
+	 * @return 1 on success, 0 on error.
+	 */
+	uint8_t begin(uint16_t port);
+	/**
+	 * @brief Drop the queued datagrams and close the socket.
+	 */
+	void stop();
+	/**
+	 * @brief Start a datagram to ip:port.
+	 *
+	 * @param ip destination address.
+	 * @param port destination port.
+	 * @return 1 on success, 0 if the destination is invalid.
+	 */
+	int beginPacket(IPAddress ip, uint16_t port);
+	/**
+	 * @brief Start a datagram to host:port.
+	 *
+	 * The address of the last host is kept, it is only resolved again when the host changes.
+	 *
+	 * @param host destination name or address.
+	 * @param port destination port.
+	 * @return 1 on success, 0 if the host could not be resolved.
+	 */
+	int beginPacket(const char *host, uint16_t port);
+	/**
+	 * @brief Queue the datagram started with beginPacket().
+	 *
+	 * @return 1 if it was queued, 0 if the queue is full and the kernel takes nothing.
+	 */
+	int endPacket();
+	/**
+	 * @brief Send the queued datagrams with a single sendmmsg().
+	 *
+	 * Meant to be called once per main loop iteration. What the socket does not take stays
+	 * queued for the next call.
+	 *
+	 * @return number of datagrams sent.
+	 */
+	int sendQueued();
+	/**
+	 * @brief Append a byte to the started datagram.
+	 *
+	 * @param b byte to send.
+	 * @return 0 if the datagram is full else 1.
+	 */
+	virtual size_t write(uint8_t b);
+	/**
+	 * @brief Append data to the started datagram.
+	 *
+	 * @param buffer to read from.
+	 * @param size of the buffer.
+	 * @return number of bytes appended.
+	 */
+	virtual size_t write(const uint8_t *buffer, size_t size);
+	/**
+	 * @brief Move to the next received datagram.
+	 *
+	 * @return size of the datagram, 0 if none is pending.
+	 */
+	int parsePacket();
+	/**
+	 * @brief Number of bytes left in the current datagram.
+	 */
+	virtual int available();
+	/**
+	 * @brief Read a byte of the current datagram.
+	 *
+	 * @return the byte, -1 if none is left.
+	 */
+	virtual int read();
+	/**
+	 * @brief Read bytes of the current datagram.
+	 *
+	 * @param buffer to write to.
+	 * @param size of the buffer.
+	 * @return number of bytes read.
+	 */
+	int read(uint8_t *buffer, size_t size);
+	/**
+	 * @brief The next byte of the current datagram without taking it.
+	 *
+	 * @return the byte, -1 if none is left.
+	 */
+	virtual int peek();
+	/**
+	 * @brief Send the queued datagrams, see sendQueued().
+	 */
+	virtual void flush();
+
+private:
+	int sockfd; //!< @brief Datagram socket.
+	std::string host; //!< @brief Last resolved host of beginPacket().
+	uint16_t hostPort; //!< @brief Port of host.
+	struct sockaddr_storage destination; //!< @brief Destination of the started datagram.
+	socklen_t destinationLength; //!< @brief Length of destination, 0 if none.
+	uint8_t txData[ETHERNETUDP_BATCH][ETHERNETUDP_PACKET_SIZE]; //!< @brief Queued datagrams.
+	size_t txLength[ETHERNETUDP_BATCH]; //!< @brief Length of each queued datagram.
+	struct sockaddr_storage txDestination[ETHERNETUDP_BATCH]; //!< @brief Destination of each.
+	socklen_t txDestinationLength[ETHERNETUDP_BATCH]; //!< @brief Length of each destination.
+	uint8_t txCount; //!< @brief Queued datagrams, the started one is txData[txCount].
+	uint8_t rxData[ETHERNETUDP_BATCH][ETHERNETUDP_PACKET_SIZE]; //!< @brief Received datagrams.
+	size_t rxLength[ETHERNETUDP_BATCH]; //!< @brief Length of each received datagram.
+	uint8_t rxCount; //!< @brief Datagrams of the last batch.
+	uint8_t rxIndex; //!< @brief Current datagram, rxCount if none.
+	size_t rxPos; //!< @brief Read position in the current datagram.
+};
+
+#endif
@@ -17,32 +17,53 @@
  * version 2 as published by the Free Software Foundation.
  */
 
+
 #include "GPIO.h"
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ioctl.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <linux/gpio.h>
 #include "log.h"
 
+// exportedPins value of a pin held by requestEvents()
+#define GPIO_PIN_EVENTS 2
+
 // Declare a single default instance
 GPIOClass GPIO = GPIOClass();
 
-GPIOClass::GPIOClass()
+GPIOClass::GPIOClass() : lastPinNum(0), exportedPins(NULL), lineFds(NULL), numChips(0)
+{
+	// the pins are looked up on first use, hosts without GPIO run as long as no pin is used
+}
+
+void GPIOClass::begin()
 {
 	FILE *f;
 	DIR* dp;
 	char file[64];
 
+	if (exportedPins != NULL) {
+		return;
+	}
+
+	openChips();
+	if (numChips > 0) {
+		allocPins();
+		return;
+	}
+
 	dp = opendir("/sys/class/gpio");
 	if (dp == NULL) {
 		logError("Could not open /sys/class/gpio directory");
 		exit(1);
 	}
 
-	lastPinNum = 0;
-
 	while (true) {
 		dirent *de = readdir(dp);
 		if (de == NULL) {
@@ -76,20 +97,26 @@ GPIOClass::GPIOClass()
 	}
 	closedir(dp);
 
-	exportedPins = new uint8_t[lastPinNum + 1];
-
-	for (int i = 0; i < lastPinNum + 1; ++i) {
-		exportedPins[i] = 0;
-	}
+	allocPins();
 }
 
-GPIOClass::GPIOClass(const GPIOClass& other)
+GPIOClass::GPIOClass(const GPIOClass& other) : lastPinNum(0), exportedPins(NULL), lineFds(NULL),
+	numChips(0)
 {
+	if (other.exportedPins == NULL) {
+		return;
+	}
 	lastPinNum = other.lastPinNum;
+	numChips = other.numChips;
+	for (int i = 0; i < numChips; ++i) {
+		chips[i] = other.chips[i];
+		chips[i].fd = dup(other.chips[i].fd);
+	}
 
-	exportedPins = new uint8_t[lastPinNum + 1];
+	allocPins();
 	for (int i = 0; i < lastPinNum + 1; ++i) {
 		exportedPins[i] = other.exportedPins[i];
+		lineFds[i] = other.lineFds[i] == -1 ? -1 : dup(other.lineFds[i]);
 	}
 }
 
@@ -97,51 +124,41 @@ GPIOClass::~GPIOClass()
 {
 	FILE *f;
 
+	if (exportedPins == NULL) {
+		return;
+	}
 	for (int i = 0; i < lastPinNum + 1; ++i) {
-		if (exportedPins[i]) {
+		if (lineFds[i] != -1) {
+			close(lineFds[i]);
+		} else if (exportedPins[i]) {
 			f = fopen("/sys/class/gpio/unexport", "w");
 			fprintf(f, "%d\n", i);
 			fclose(f);
 		}
 	}
+	for (int i = 0; i < numChips; ++i) {
+		close(chips[i].fd);
+	}
 
 	delete [] exportedPins;
+	delete [] lineFds;
 }
 
 void GPIOClass::pinMode(uint8_t pin, uint8_t mode)
 {
-	FILE *f;
-
-	if (pin > lastPinNum) {
+	begin();
+	if (pin > lastPinNum || exportedPins[pin] == GPIO_PIN_EVENTS) {
+		// an interrupt pin stays an input
 		return;
 	}
 
-	f = fopen("/sys/class/gpio/export", "w");
-	fprintf(f, "%d\n", pin);
-	fclose(f);
-
-	int counter = 0;
-	char file[128];
-	sprintf(file, "/sys/class/gpio/gpio%d/direction", pin);
-
-	while ((f = fopen(file,"w")) == NULL) {
-		// Wait 10 seconds for the file to be accessible if not open on first attempt
-		sleep(1);
-		counter++;
-		if (counter > 10) {
-			logError("Could not open /sys/class/gpio/gpio%u/direction", pin);
-			exit(1);
-		}
-	}
-	if (mode == INPUT) {
-		fprintf(f, "in\n");
+	if (numChips > 0) {
+		requestLine(pin, mode);
 	} else {
-		fprintf(f, "out\n");
+		sysfsPinMode(pin, mode);
 	}
 
 	exportedPins[pin] = 1;
-
-	fclose(f);
 }
 
 void GPIOClass::digitalWrite(uint8_t pin, uint8_t value)
@@ -149,6 +166,7 @@ void GPIOClass::digitalWrite(uint8_t pin, uint8_t value)
 	FILE *f;
 	char file[128];
 
+	begin();
 	if (pin > lastPinNum) {
 		return;
 	}
@@ -156,6 +174,18 @@ void GPIOClass::digitalWrite(uint8_t pin, uint8_t value)
 		pinMode(pin, OUTPUT);
 	}
 
+#ifdef GPIOHANDLE_SET_LINE_VALUES_IOCTL
+	if (lineFds[pin] != -1) {
+		struct gpiohandle_data data;
+		memset(&data, 0, sizeof(data));
+		data.values[0] = value ? 1 : 0;
+		if (ioctl(lineFds[pin], GPIOHANDLE_SET_LINE_VALUES_IOCTL, &data) == -1) {
+			logError("digitalWrite: failed to set pin %u: %s\n", pin, strerror(errno));
+		}
+		return;
+	}
+#endif
+
 	sprintf(file, "/sys/class/gpio/gpio%d/value", pin);
 	f = fopen(file, "w");
 
@@ -173,6 +203,7 @@ uint8_t GPIOClass::digitalRead(uint8_t pin)
 	FILE *f;
 	char file[128];
 
+	begin();
 	if (pin > lastPinNum) {
 		return 0;
 	}
@@ -180,6 +211,18 @@ uint8_t GPIOClass::digitalRead(uint8_t pin)
 		pinMode(pin, INPUT);
 	}
 
+#ifdef GPIOHANDLE_GET_LINE_VALUES_IOCTL
+	if (lineFds[pin] != -1) {
+		struct gpiohandle_data data;
+		memset(&data, 0, sizeof(data));
+		if (ioctl(lineFds[pin], GPIOHANDLE_GET_LINE_VALUES_IOCTL, &data) == -1) {
+			logError("digitalRead: failed to read pin %u: %s\n", pin, strerror(errno));
+			return 0;
+		}
+		return data.values[0];
+	}
+#endif
+
 	sprintf(file, "/sys/class/gpio/gpio%d/value", pin);
 	f = fopen(file, "r");
 
@@ -200,12 +243,243 @@ uint8_t GPIOClass::digitalPinToInterrupt(uint8_t pin)
 GPIOClass& GPIOClass::operator=(const GPIOClass& other)
 {
 	if (this != &other) {
+		for (int i = 0; exportedPins != NULL && i < lastPinNum + 1; ++i) {
+			if (lineFds[i] != -1) {
+				close(lineFds[i]);
+			}
+		}
+		for (int i = 0; i < numChips; ++i) {
+			close(chips[i].fd);
+		}
+		delete [] exportedPins;
+		delete [] lineFds;
+		exportedPins = NULL;
+		lineFds = NULL;
+
 		lastPinNum = other.lastPinNum;
+		numChips = other.numChips;
+		if (other.exportedPins == NULL) {
+			return *this;
+		}
+		for (int i = 0; i < numChips; ++i) {
+			chips[i] = other.chips[i];
+			chips[i].fd = dup(other.chips[i].fd);
+		}
 
-		exportedPins = new uint8_t[lastPinNum + 1];
+		allocPins();
 		for (int i = 0; i < lastPinNum + 1; ++i) {
 			exportedPins[i] = other.exportedPins[i];
+			lineFds[i] = other.lineFds[i] == -1 ? -1 : dup(other.lineFds[i]);
 		}
 	}
 	return *this;
 }
+
+void GPIOClass::allocPins()
+{
+	exportedPins = new uint8_t[lastPinNum + 1];
+	lineFds = new int[lastPinNum + 1];
+
+	for (int i = 0; i < lastPinNum + 1; ++i) {
+		exportedPins[i] = 0;
+		lineFds[i] = -1;
+	}
+}
+
+void GPIOClass::openChips()
+{
+#ifdef GPIO_GET_LINEHANDLE_IOCTL
+	char file[64];
+
+	for (int i = 0; i < GPIO_MAX_CHIPS; ++i) {
+		struct gpiochip_info info;
+		gpioChip &chip = chips[numChips];
+
+		sprintf(file, "/dev/gpiochip%d", i);
+		chip.fd = open(file, O_RDWR | O_CLOEXEC);
+		if (chip.fd == -1) {
+			continue;
+		}
+		if (ioctl(chip.fd, GPIO_GET_CHIPINFO_IOCTL, &info) == -1) {
+			logError("Failed to get info of %s: %s\n", file, strerror(errno));
+			close(chip.fd);
+			continue;
+		}
+		chip.base = -1;
+		chip.lines = info.lines;
+		// info.label is at least as long as chip.label
+		(void)memcpy(chip.label, info.label, sizeof(chip.label) - 1);
+		chip.label[sizeof(chip.label) - 1] = '\0';
+		numChips++;
+	}
+
+	// the global pin numbers (chip base) are only known to sysfs
+	DIR *dp = opendir("/sys/class/gpio");
+	while (dp != NULL) {
+		dirent *de = readdir(dp);
+		if (de == NULL) {
+			closedir(dp);
+			break;
+		}
+		if (strncmp("gpiochip", de->d_name, 8) != 0) {
+			continue;
+		}
+
+		char label[32] = "";
+		int base = -1;
+		sprintf(file, "/sys/class/gpio/%.40s/label", de->d_name);
+		FILE *f = fopen(file, "r");
+		if (f != NULL) {
+			if (fscanf(f, "%31s", label) != 1) {
+				label[0] = '\0';
+			}
+			fclose(f);
+		}
+		sprintf(file, "/sys/class/gpio/%.40s/base", de->d_name);
+		f = fopen(file, "r");
+		if (f != NULL) {
+			if (fscanf(f, "%d", &base) != 1) {
+				base = -1;
+			}
+			fclose(f);
+		}
+		for (int i = 0; i < numChips; ++i) {
+			if (chips[i].base == -1 && strcmp(chips[i].label, label) == 0) {
+				chips[i].base = base;
+				break;
+			}
+		}
+	}
+
+	for (int i = 0; i < numChips; ++i) {
+		int max = (chips[i].base == -1 ? 0 : chips[i].base) + chips[i].lines - 1;
+		if (lastPinNum < max) {
+			lastPinNum = max;
+		}
+	}
+#endif
+}
+
+int GPIOClass::requestEvents(uint8_t pin, uint32_t eventFlags)
+{
+#ifdef GPIO_GET_LINEEVENT_IOCTL
+	begin();
+	if (numChips == 0 || pin > lastPinNum) {
+		return -1;
+	}
+
+	int offset;
+	gpioChip *chip = findChip(pin, &offset);
+
+	if (lineFds[pin] != -1) {
+		close(lineFds[pin]);
+		lineFds[pin] = -1;
+	}
+
+	struct gpioevent_request req;
+	memset(&req, 0, sizeof(req));
+	req.lineoffset = offset;
+	req.handleflags = GPIOHANDLE_REQUEST_INPUT;
+	req.eventflags = eventFlags;
+	strncpy(req.consumer_label, "mysensors", sizeof(req.consumer_label) - 1);
+	if (ioctl(chip->fd, GPIO_GET_LINEEVENT_IOCTL, &req) == -1) {
+		logError("Could not request events of GPIO %u (%s line %d): %s\n", pin, chip->label, offset,
+		         strerror(errno));
+		exit(1);
+	}
+	lineFds[pin] = req.fd;
+	exportedPins[pin] = GPIO_PIN_EVENTS;
+
+	return req.fd;
+#else
+	(void)pin;
+	(void)eventFlags;
+	return -1;
+#endif
+}
+
+void GPIOClass::releaseEvents(uint8_t pin)
+{
+	if (exportedPins == NULL || pin > lastPinNum || exportedPins[pin] != GPIO_PIN_EVENTS) {
+		return;
+	}
+	close(lineFds[pin]);
+	lineFds[pin] = -1;
+	exportedPins[pin] = 0;
+}
+
+GPIOClass::gpioChip *GPIOClass::findChip(uint8_t pin, int *offset)
+{
+	for (int i = 0; i < numChips; ++i) {
+		if (chips[i].base != -1 && pin >= chips[i].base && pin < chips[i].base + chips[i].lines) {
+			*offset = pin - chips[i].base;
+			return &chips[i];
+		}
+	}
+	if (pin < chips[0].lines) {
+		// e.g. sysfs disabled or chip bases above 255, use the line offset
+		*offset = pin;
+		return &chips[0];
+	}
+	logError("GPIO %u not found on any gpiochip\n", pin);
+	exit(1);
+}
+
+void GPIOClass::requestLine(uint8_t pin, uint8_t mode)
+{
+#ifdef GPIO_GET_LINEHANDLE_IOCTL
+	int offset;
+	gpioChip *chip = findChip(pin, &offset);
+
+	if (lineFds[pin] != -1) {
+		close(lineFds[pin]);
+		lineFds[pin] = -1;
+	}
+
+	struct gpiohandle_request req;
+	memset(&req, 0, sizeof(req));
+	req.lineoffsets[0] = offset;
+	req.lines = 1;
+	req.flags = mode == INPUT ? GPIOHANDLE_REQUEST_INPUT : GPIOHANDLE_REQUEST_OUTPUT;
+	strncpy(req.consumer_label, "mysensors", sizeof(req.consumer_label) - 1);
+	if (ioctl(chip->fd, GPIO_GET_LINEHANDLE_IOCTL, &req) == -1) {
+		logError("Could not request GPIO %u (%s line %d): %s\n", pin, chip->label, offset,
+		         strerror(errno));
+		exit(1);
+	}
+	lineFds[pin] = req.fd;
+#else
+	(void)pin;
+	(void)mode;
+#endif
+}
+
+void GPIOClass::sysfsPinMode(uint8_t pin, uint8_t mode)
+{
+	FILE *f;
+
+	f = fopen("/sys/class/gpio/export", "w");
+	fprintf(f, "%d\n", pin);
+	fclose(f);
+
+	int counter = 0;
+	char file[128];
+	sprintf(file, "/sys/class/gpio/gpio%d/direction", pin);
+
+	while ((f = fopen(file,"w")) == NULL) {
+		// Wait 10 seconds for the file to be accessible if not open on first attempt
+		sleep(1);
+		counter++;
+		if (counter > 10) {
+			logError("Could not open /sys/class/gpio/gpio%u/direction", pin);
+			exit(1);
+		}
+	}
+	if (mode == INPUT) {
+		fprintf(f, "in\n");
+	} else {
+		fprintf(f, "out\n");
+	}
+
+	fclose(f);
+}
@@ -28,8 +28,18 @@
 #define LOW 0
 #define HIGH 1
 
+#ifndef GPIO_MAX_CHIPS
+#define GPIO_MAX_CHIPS 8 //!< Maximum number of gpiochip character devices used
+#endif
+
 /**
  * @brief GPIO class
+ *
+ * Pins are driven through line handles of the /dev/gpiochipN character devices, which stay
+ * open after the first pinMode(), so digitalWrite() and digitalRead() cost a single ioctl.
+ * Pin numbers are the global sysfs GPIO numbers; pins outside the range of every chip map to the
+ * line offset on gpiochip0. If no character device is available, the sysfs interface is used.
+ * The chips are opened on the first use of a pin, not at startup.
  */
 class GPIOClass
 {
@@ -68,6 +78,22 @@ public:
 	 * @return HIGH or LOW.
 	 */
 	uint8_t digitalRead(uint8_t pin);
+	/**
+	 * @brief Request edge events for a pin from its gpiochip, replacing its line handle.
+	 *
+	 * The pin stays an input that can be read with digitalRead() until releaseEvents().
+	 *
+	 * @param pin The number of the pin.
+	 * @param eventFlags GPIOEVENT_REQUEST_RISING_EDGE and/or GPIOEVENT_REQUEST_FALLING_EDGE.
+	 * @return file descriptor delivering struct gpioevent_data, -1 if no gpiochip device is used.
+	 */
+	int requestEvents(uint8_t pin, uint32_t eventFlags);
+	/**
+	 * @brief Release the edge events of a pin requested with requestEvents().
+	 *
+	 * @param pin The number of the pin.
+	 */
+	void releaseEvents(uint8_t pin);
 	/**
 	 * @brief Arduino compatibility function, returns the same given pin.
 	 *
@@ -82,8 +108,56 @@ public:
 	GPIOClass& operator=(const GPIOClass& other);
 
 private:
+	/**
+	 * @brief A gpiochip character device.
+	 */
+	struct gpioChip {
+		int fd; //!< @brief Open chip device.
+		int base; //!< @brief Global number of the first line, -1 if unknown.
+		int lines; //!< @brief Number of lines of the chip.
+		char label[32]; //!< @brief Chip label, used to match the sysfs base.
+	};
+
 	int lastPinNum; //!< @brief Highest pin number supported.
-	uint8_t *exportedPins; //!< @brief Array with information of which pins were exported.
+	uint8_t *exportedPins; //!< @brief Array with information of which pins were exported, NULL before begin().
+	int *lineFds; //!< @brief Line handle of each pin, -1 if not requested.
+	gpioChip chips[GPIO_MAX_CHIPS]; //!< @brief Available gpiochip devices.
+	int numChips; //!< @brief Number of entries in chips, 0 selects the sysfs interface.
+
+	/**
+	 * @brief Find the chips and allocate the pin state unless done before, exits without GPIO.
+	 */
+	void begin();
+	/**
+	 * @brief Allocate the per pin state for pins 0..lastPinNum.
+	 */
+	void allocPins();
+	/**
+	 * @brief Open the gpiochip character devices.
+	 */
+	void openChips();
+	/**
+	 * @brief Find the gpiochip and line offset of a pin, exits if there is none.
+	 *
+	 * @param pin The number of the pin.
+	 * @param offset receives the line offset on the chip.
+	 * @return the chip of the pin.
+	 */
+	gpioChip *findChip(uint8_t pin, int *offset);
+	/**
+	 * @brief Request a line handle for a pin from its gpiochip.
+	 *
+	 * @param pin The number of the pin.
+	 * @param mode INPUT or OUTPUT.
+	 */
+	void requestLine(uint8_t pin, uint8_t mode);
+	/**
+	 * @brief Configure a pin through /sys/class/gpio.
+	 *
+	 * @param pin The number of the pin.
+	 * @param mode INPUT or OUTPUT.
+	 */
+	void sysfsPinMode(uint8_t pin, uint8_t mode);
 };
 
 extern GPIOClass GPIO;
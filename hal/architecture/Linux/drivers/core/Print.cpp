@@ -47,24 +47,17 @@ Print::printf(const char *format, ...)
 {
 	va_list arg;
 	va_start(arg, format);
-	char temp[64];
-	char* buffer = temp;
-	size_t len = vsnprintf(temp, sizeof(temp), format, arg);
+	char buffer[PRINT_PRINTF_BUFFER_SIZE];
+	int len = vsnprintf(buffer, sizeof(buffer), format, arg);
 	va_end(arg);
-	if (len > sizeof(temp) - 1) {
-		buffer = new char[len + 1];
-		if (!buffer) {
-			return 0;
-		}
-		va_start(arg, format);
-		vsnprintf(buffer, len + 1, format, arg);
-		va_end(arg);
+	if (len < 0) {
+		return 0;
 	}
-	len = write((const uint8_t*) buffer, len);
-	if (buffer != temp) {
-		delete[] buffer;
+	if ((size_t)len >= sizeof(buffer)) {
+		len = sizeof(buffer) - 1;
 	}
-	return len;
+	// one write for the whole line
+	return write((const uint8_t*) buffer, (size_t)len);
 }
 
 size_t Print::print(const std::string &s)
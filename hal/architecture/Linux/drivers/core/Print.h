@@ -27,6 +27,10 @@
 #include <string.h>
 
 #if !DOXYGEN
+#ifndef PRINT_PRINTF_BUFFER_SIZE
+#define PRINT_PRINTF_BUFFER_SIZE 256 // longer printf() output is truncated
+#endif
+
 #define DEC 10
 #define HEX 16
 #define OCT 8
@@ -41,6 +41,8 @@ uint8_t SPIDEVClass::mode = SPI_MODE0;
 uint32_t SPIDEVClass::speed = SPI_CLOCK_BASE;
 uint8_t SPIDEVClass::bit_order = MSBFIRST;
 struct spi_ioc_transfer SPIDEVClass::tr = {0,0,0,0,0,8,0,0,0,0};	// 8 bits_per_word, 0 cs_change
+struct spi_ioc_transfer SPIDEVClass::queue[SPI_TRANSFER_QUEUE_SIZE];
+uint8_t SPIDEVClass::queued = 0;
 
 SPIDEVClass::SPIDEVClass()
 {
@@ -210,6 +212,48 @@ void SPIDEVClass::transfern(char* buf, uint32_t len)
 	transfernb(buf, buf, len);
 }
 
+void SPIDEVClass::queueTransfer(char* tbuf, char* rbuf, uint32_t len)
+{
+	if (queued == SPI_TRANSFER_QUEUE_SIZE) {
+		submitTransfers();
+	}
+
+	// released by submitTransfers()
+	pthread_mutex_lock(&spiMutex);
+
+	queue[queued] = tr;
+	queue[queued].tx_buf = (unsigned long)tbuf;
+	queue[queued].rx_buf = (unsigned long)rbuf;
+	queue[queued].len = len;
+	queue[queued].speed_hz = speed;
+	// release chip select after this transfer, the last one releases it anyway
+	queue[queued].cs_change = 1;
+	queued++;
+}
+
+void SPIDEVClass::submitTransfers()
+{
+	int ret;
+
+	pthread_mutex_lock(&spiMutex);
+
+	if (queued > 0) {
+		queue[queued - 1].cs_change = 0;
+		ret = ioctl(fd, SPI_IOC_MESSAGE(queued), queue);
+		if (ret < 1) {
+			logError("Can't send spi message.\n");
+			abort();
+		}
+	}
+	// one lock per queued transfer
+	while (queued > 0) {
+		queued--;
+		pthread_mutex_unlock(&spiMutex);
+	}
+
+	pthread_mutex_unlock(&spiMutex);
+}
+
 void SPIDEVClass::beginTransaction(SPISettings settings)
 {
 	int ret;
@@ -27,6 +27,9 @@
 #include <linux/spi/spidev.h>
 
 #define SPI_HAS_TRANSACTION
+#define SPI_HAS_TRANSFER_QUEUE	//!< queueTransfer() and submitTransfers() are available
+
+#define SPI_TRANSFER_QUEUE_SIZE 4	//!< Max number of transfers submitted with one ioctl
 
 #define MSBFIRST 0
 #define LSBFIRST SPI_LSB_FIRST
@@ -172,6 +175,21 @@ public:
 	* @param len Length of the data
 	*/
 	static void transfern(char* buf, uint32_t len);
+	/**
+	* @brief Queue a transfer, to be submitted with the next ones by submitTransfers()
+	*
+	* Chip select is released between the queued transfers. The buffers have to stay valid until
+	* the transfers are submitted. A full queue is submitted before queuing the transfer.
+	*
+	* @param tbuf Transmit buffer
+	* @param rbuf Receive buffer, can be the transmit buffer
+	* @param len Length of the data
+	*/
+	static void queueTransfer(char* tbuf, char* rbuf, uint32_t len);
+	/**
+	* @brief Submit all queued transfers with a single SPI_IOC_MESSAGE ioctl
+	*/
+	static void submitTransfers();
 	/**
 	 * @brief Start SPI transaction.
 	 *
@@ -203,6 +221,8 @@ private:
 	static uint32_t speed; //!< @brief SPI speed.
 	static uint8_t bit_order; //!< @brief SPI bit order.
 	static struct spi_ioc_transfer tr; //!< @brief Auxiliar struct for data transfer.
+	static struct spi_ioc_transfer queue[SPI_TRANSFER_QUEUE_SIZE]; //!< @brief Queued transfers.
+	static uint8_t queued; //!< @brief Number of queued transfers.
 
 	static void init();
 };
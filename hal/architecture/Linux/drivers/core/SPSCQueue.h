@@ -0,0 +1,99 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#ifndef SPSCQueue_h
+#define SPSCQueue_h
+
+#include <stddef.h>
+#include <atomic>
+
+/**
+ * @brief Bounded lock-free single-producer/single-consumer ring buffer.
+ *
+ * push() must only be called from one thread and pop() from one other thread.
+ * One slot is kept free to tell a full queue from an empty one, so at most N-1 entries are stored.
+ * @tparam T entry type, copied in and out.
+ * @tparam N number of slots.
+ */
+template <class T, size_t N> class SPSCQueue
+{
+public:
+	SPSCQueue() : head(0), tail(0)
+	{
+	}
+
+	/**
+	 * @brief Append an entry, producer side.
+	 * @param item entry to copy into the queue.
+	 * @return false if the queue is full.
+	 */
+	bool push(const T &item)
+	{
+		const size_t h = head.load(std::memory_order_relaxed);
+		const size_t next = (h + 1) % N;
+		if (next == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		buffer[h] = item;
+		head.store(next, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Remove the oldest entry, consumer side.
+	 * @param item receives the entry.
+	 * @return false if the queue is empty.
+	 */
+	bool pop(T &item)
+	{
+		const size_t t = tail.load(std::memory_order_relaxed);
+		if (t == head.load(std::memory_order_acquire)) {
+			return false;
+		}
+		item = buffer[t];
+		tail.store((t + 1) % N, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Check for a free slot, producer side.
+	 * @return true if push() would fail.
+	 */
+	bool full() const
+	{
+		const size_t next = (head.load(std::memory_order_relaxed) + 1) % N;
+		return next == tail.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * @brief Check for pending entries, safe from both sides.
+	 * @return true if the queue is empty.
+	 */
+	bool empty() const
+	{
+		return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+	}
+
+private:
+	T buffer[N];
+	std::atomic<size_t> head;
+	std::atomic<size_t> tail;
+};
+
+#endif
@@ -28,12 +28,16 @@
 #include <grp.h>
 #include <errno.h>
 #include <sys/stat.h>
+#include <linux/serial.h>
 #include "log.h"
 #include "SerialPort.h"
+#include "eventloop.h"
 
 SerialPort::SerialPort(const char *port, bool isPty) : serialPort(std::string(port)), isPty(isPty)
 {
 	sd = -1;
+	rxPos = 0;
+	rxLen = 0;
 }
 
 void SerialPort::begin(int bauds)
@@ -175,6 +179,11 @@ bool SerialPort::open(int bauds)
 
 	usleep(10000);
 
+	// a PTY master reports HUP while no slave is open, rely on the loop tick instead
+	if (!isPty) {
+		eventLoopAdd(sd);
+	}
+
 	return true;
 }
 
@@ -213,29 +222,52 @@ bool SerialPort::setGroupPerm(const char *groupName)
 	return false;
 }
 
-int SerialPort::available()
+bool SerialPort::setRS485()
 {
-	int nbytes = 0;
+	struct serial_rs485 rs485;
 
-	if (ioctl(sd, FIONREAD, &nbytes) < 0) {
-		logError("Failed to get byte count on serial.\n");
-		exit(-1);
+	bzero(&rs485, sizeof(rs485));
+	// RTS high while sending, low right after the last stop bit
+	rs485.flags = SER_RS485_ENABLED | SER_RS485_RTS_ON_SEND;
+	if (ioctl(sd, TIOCSRS485, &rs485) < 0) {
+		logError("Couldn't set RS485 mode on %s: %s\n", serialPort.c_str(), strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+int SerialPort::available()
+{
+	if (rxPos < rxLen) {
+		return rxLen - rxPos;
 	}
-	return nbytes;
+
+	return fill();
 }
 
 int SerialPort::read()
 {
-	unsigned char c;
+	if (rxPos >= rxLen && fill() == 0) {
+		return -1;
+	}
 
-	int ret = ::read(sd, &c, 1);
-	if (ret < 0) {
+	return rxBuffer[rxPos++];
+}
+
+int SerialPort::fill()
+{
+	rxPos = 0;
+	rxLen = 0;
+
+	ssize_t ret = ::read(sd, rxBuffer, sizeof(rxBuffer));
+	if (ret > 0) {
+		rxLen = ret;
+	} else if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK && !(isPty && errno == EIO)) {
+		// A PTY master reports EIO while no slave is attached
 		logError("Serial - read failed: %s\n", strerror(errno));
-	} else if (ret == 1) {
-		return c;
 	}
 
-	return -1;
+	return rxLen;
 }
 
 size_t SerialPort::write(uint8_t b)
@@ -258,13 +290,11 @@ size_t SerialPort::write(const uint8_t *buffer, size_t size)
 
 int SerialPort::peek()
 {
-	FILE * f = fdopen(sd, "r+");
-	int c = getc(f);
-	if (c == EOF) {
+	if (rxPos >= rxLen && fill() == 0) {
 		return -1;
 	}
-	ungetc(c, f);
-	return c;
+
+	return rxBuffer[rxPos];
 }
 
 void SerialPort::flush()
@@ -277,7 +307,10 @@ void SerialPort::flush()
 
 void SerialPort::end()
 {
+	eventLoopRemove(sd);
 	close(sd);
+	rxPos = 0;
+	rxLen = 0;
 
 	if (isPty) {
 		unlink(serialPort.c_str());	// remove the symlink
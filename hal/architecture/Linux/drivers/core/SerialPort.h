@@ -24,6 +24,10 @@
 #include <stdbool.h>
 #include "Stream.h"
 
+#ifndef SERIALPORT_RX_BUFFER_SIZE
+#define SERIALPORT_RX_BUFFER_SIZE 256 //!< Size of the serial receive buffer
+#endif
+
 /**
  * SerialPort Class
  * Class that provides the functionality of arduino Serial library
@@ -35,6 +39,16 @@ private:
 	int sd; //!< @brief file descriptor number.
 	std::string serialPort;	//!< @brief tty name.
 	bool isPty; //!< @brief true if serial is pseudo terminal.
+	uint8_t rxBuffer[SERIALPORT_RX_BUFFER_SIZE]; //!< @brief Receive buffer.
+	size_t rxPos; //!< @brief Read position in the receive buffer.
+	size_t rxLen; //!< @brief Number of valid bytes in the receive buffer.
+
+	/**
+	* @brief Refill the receive buffer with a single non-blocking read().
+	*
+	* @return number of buffered bytes.
+	*/
+	int fill();
 
 public:
 	/**
@@ -63,10 +77,17 @@ public:
 	*/
 	bool setGroupPerm(const char *groupName);
 	/**
+	* @brief Switch the port to RS485 mode, the UART driver asserts RTS while sending.
+	*
+	* @return @c true if the driver supports RS485 mode, else @c false.
+	*/
+	bool setRS485();
+	/**
 	* @brief Get the number of bytes available.
 	*
 	* Get the numberof bytes (characters) available for reading from
-	* the serial port.
+	* the serial port. If the receive buffer is empty, it is refilled
+	* with a single non-blocking read().
 	*
 	* @return number of bytes avalable to read.
 	*/
@@ -0,0 +1,51 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "SlabPool.h"
+#include <stdio.h>
+#include <inttypes.h>
+
+// constant initialized, pools constructed in other units during static initialization find it ready
+static SlabPoolBase *pools[SLAB_POOL_MAX_POOLS];
+static size_t poolCount = 0;
+
+SlabPoolBase::SlabPoolBase(const char *name, size_t limit) : _name(name), _limit(limit), _used(0),
+	_peak(0), _failures(0)
+{
+	if (poolCount < SLAB_POOL_MAX_POOLS) {
+		pools[poolCount++] = this;
+	}
+}
+
+size_t slabPoolRender(char *buffer, size_t size)
+{
+	static const char *const types[4] = { "limit", "used", "peak", "failures_total" };
+	size_t length = 0;
+	for (uint8_t t = 0; t < 4 && length < size; t++) {
+		length += snprintf(&buffer[length], size - length, "# TYPE mysensors_pool_%s %s\n", types[t],
+		                   t == 3 ? "counter" : "gauge");
+		for (size_t i = 0; i < poolCount && length < size; i++) {
+			const SlabPoolBase &pool = *pools[i];
+			const uint64_t values[4] = { pool.limit(), pool.used(), pool.peak(), pool.failures() };
+			length += snprintf(&buffer[length], size - length, "mysensors_pool_%s{pool=\"%s\"} %" PRIu64 "\n",
+			                   types[t], pool.name(), values[t]);
+		}
+	}
+	return length < size ? length : size - 1;
+}
@@ -0,0 +1,194 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#ifndef SlabPool_h
+#define SlabPool_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#define SLAB_POOL_MAX_POOLS 8	//!< Pools listed by slabPoolRender(), more are not listed
+#define SLAB_POOL_NONE 0xFFFFu	//!< End of the free list
+
+/**
+ * @brief Occupancy of a pool, the part of SlabPool that does not depend on the block type.
+ *
+ * Each pool registers itself for slabPoolRender() when constructed, pools are meant to be static.
+ */
+class SlabPoolBase
+{
+public:
+	/**
+	 * @param name name of the pool in the statistics.
+	 * @param limit number of blocks that may be in use at the same time.
+	 */
+	SlabPoolBase(const char *name, size_t limit);
+
+	/**
+	 * @brief Name given to the constructor.
+	 */
+	const char *name() const
+	{
+		return _name;
+	}
+	/**
+	 * @brief Blocks in use.
+	 */
+	size_t used() const
+	{
+		return _used.load(std::memory_order_relaxed);
+	}
+	/**
+	 * @brief Most blocks in use at the same time.
+	 */
+	size_t peak() const
+	{
+		return _peak.load(std::memory_order_relaxed);
+	}
+	/**
+	 * @brief Allocations refused because the limit was reached.
+	 */
+	uint32_t failures() const
+	{
+		return _failures.load(std::memory_order_relaxed);
+	}
+	/**
+	 * @brief Limit given to the constructor, at most the number of blocks.
+	 */
+	size_t limit() const
+	{
+		return _limit;
+	}
+
+protected:
+	/**
+	 * @brief Count a block as used.
+	 * @return false if the limit is reached, counted as failure.
+	 */
+	bool reserve(void)
+	{
+		const size_t used = _used.fetch_add(1, std::memory_order_relaxed) + 1;
+		if (used > _limit) {
+			_used.fetch_sub(1, std::memory_order_relaxed);
+			_failures.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		size_t peak = _peak.load(std::memory_order_relaxed);
+		while (used > peak && !_peak.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+		}
+		return true;
+	}
+	/**
+	 * @brief Count a block as free again.
+	 */
+	void unreserve(void)
+	{
+		_used.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+private:
+	const char *_name;
+	const size_t _limit;
+	std::atomic<size_t> _used;
+	std::atomic<size_t> _peak;
+	std::atomic<uint32_t> _failures;
+};
+
+/**
+ * @brief Fixed-size block allocator with a lock-free free list.
+ *
+ * The blocks are part of the object, the pool never calls malloc and a released block is the
+ * next one handed out again. alloc() and release() may be called from any thread. The free list
+ * holds block indices, tagged with a counter against ABA.
+ * @tparam T block type, blocks are not constructed or destructed by alloc() and release().
+ * @tparam N number of blocks, 1..65535.
+ */
+template <class T, size_t N> class SlabPool : public SlabPoolBase
+{
+public:
+	/**
+	 * @param name name of the pool in the statistics.
+	 * @param limit number of blocks that may be in use at the same time, all by default.
+	 */
+	explicit SlabPool(const char *name, size_t limit = N) : SlabPoolBase(name, limit < N ? limit : N)
+	{
+		static_assert(N > 0 && N < SLAB_POOL_NONE, "SlabPool supports 1..65535 blocks");
+		for (size_t i = 0; i < N; i++) {
+			next[i].store(i + 1 < N ? (uint16_t)(i + 1) : (uint16_t)SLAB_POOL_NONE,
+			              std::memory_order_relaxed);
+		}
+		head.store(0, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Take a free block.
+	 * @return the block, NULL if the limit is reached.
+	 */
+	T *alloc(void)
+	{
+		if (!reserve()) {
+			return NULL;
+		}
+		// the limit is at most N, the free list is not empty once a block is reserved
+		uint32_t current = head.load(std::memory_order_acquire);
+		uint32_t index;
+		do {
+			index = current & SLAB_POOL_NONE;
+		} while (!head.compare_exchange_weak(current, _tagged(current,
+		                                     next[index].load(std::memory_order_relaxed)),
+		                                     std::memory_order_acquire, std::memory_order_acquire));
+		return &blocks[index];
+	}
+
+	/**
+	 * @brief Give a block back.
+	 * @param block block returned by alloc() of this pool.
+	 */
+	void release(T *block)
+	{
+		const uint32_t index = (uint32_t)(block - blocks);
+		uint32_t current = head.load(std::memory_order_relaxed);
+		do {
+			next[index].store((uint16_t)(current & SLAB_POOL_NONE), std::memory_order_relaxed);
+		} while (!head.compare_exchange_weak(current, _tagged(current, index),
+		                                     std::memory_order_release, std::memory_order_relaxed));
+		unreserve();
+	}
+
+private:
+	static uint32_t _tagged(const uint32_t current, const uint32_t index)
+	{
+		return ((current + 0x10000u) & 0xFFFF0000u) | index;
+	}
+
+	T blocks[N];
+	std::atomic<uint16_t> next[N];
+	std::atomic<uint32_t> head;	// first free block, the tag in the upper 16 bits
+};
+
+/**
+ * @brief Render the occupancy of all pools in Prometheus text exposition format.
+ * @param buffer output buffer.
+ * @param size size of the output buffer.
+ * @return length of the text, truncated to size - 1.
+ */
+size_t slabPoolRender(char *buffer, size_t size);
+
+#endif
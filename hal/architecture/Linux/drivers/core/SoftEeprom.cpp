@@ -17,20 +17,60 @@
  * version 2 as published by the Free Software Foundation.
  */
 
+
 #include <stdlib.h>
-#include <iostream>
-#include <fstream>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <string.h>
 #include <errno.h>
 #include "log.h"
 #include "SoftEeprom.h"
 
-SoftEeprom::SoftEeprom() : _length(0), _fileName(NULL), _values(NULL)
+#define SOFTEEPROM_JOURNAL_MAGIC 0x4D59534A // "MYSJ"
+
+// header of a journal record, followed by length bytes of data
+struct journalHeader {
+	uint32_t magic;
+	uint32_t offset;
+	uint32_t length;
+	uint32_t checksum;
+};
+
+static uint32_t _millis()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+// FNV-1a over the record position and data
+static uint32_t _checksum(uint32_t offset, uint32_t length, const uint8_t *data)
 {
+	uint32_t hash = 2166136261u;
+	const uint32_t fields[2] = {offset, length};
+	const uint8_t *p = (const uint8_t *)fields;
+
+	for (size_t i = 0; i < sizeof(fields); ++i) {
+		hash = (hash ^ p[i]) * 16777619u;
+	}
+	for (size_t i = 0; i < length; ++i) {
+		hash = (hash ^ data[i]) * 16777619u;
+	}
+	return hash;
 }
 
-SoftEeprom::SoftEeprom(const SoftEeprom& other)
+SoftEeprom::SoftEeprom() : _length(0), _fileName(NULL), _values(NULL), _fd(-1), _map(NULL),
+	_flushInterval(0), _dirtyStart(0), _dirtyEnd(0), _dirtySince(0)
+{
+}
+
+SoftEeprom::SoftEeprom(const SoftEeprom& other) : _fd(-1), _map(NULL), _flushInterval(0),
+	_dirtyStart(0), _dirtyEnd(0), _dirtySince(0)
 {
 	_fileName = strdup(other._fileName);
 
@@ -46,7 +86,7 @@ SoftEeprom::~SoftEeprom()
 	destroy();
 }
 
-int SoftEeprom::init(const char *fileName, size_t length)
+int SoftEeprom::init(const char *fileName, size_t length, uint32_t flushInterval)
 {
 	struct stat fileInfo;
 
@@ -60,35 +100,43 @@ int SoftEeprom::init(const char *fileName, size_t length)
 
 	_length = length;
 	_values = new uint8_t[_length];
+	_flushInterval = flushInterval;
 
 	if (stat(_fileName, &fileInfo) != 0) {
 		//File does not exist.  Create it.
 		logInfo("EEPROM file %s does not exist, creating new file.\n", _fileName);
-		std::ofstream myFile(_fileName, std::ios::out | std::ios::binary);
-		if (!myFile) {
+		_fd = open(_fileName, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+		if (_fd == -1) {
 			logError("Unable to create config file %s.\n", _fileName);
 			return -1;
 		}
 		// Fill the eeprom with 1s
-		for (size_t i = 0; i < _length; ++i) {
-			_values[i] = 0xFF;
+		memset(_values, 0xFF, _length);
+		if (pwrite(_fd, _values, _length, 0) != (ssize_t)_length) {
+			logError("Unable to create config file %s.\n", _fileName);
+			return -1;
 		}
-		myFile.write((const char*)_values, _length);
-		myFile.close();
 	} else if (fileInfo.st_size < 0 || (size_t)fileInfo.st_size != _length) {
 		logError("EEPROM file %s is not the correct size of %zu.  Please remove the file and a new one will be created.\n",
 		         _fileName, _length);
 		destroy();
 		return -1;
 	} else {
+		replayJournal();
 		//Read config into local memory.
-		std::ifstream myFile(_fileName, std::ios::in | std::ios::binary);
-		if (!myFile) {
+		if (openFile() != 0 || pread(_fd, _values, _length, 0) != (ssize_t)_length) {
 			logError("Unable to open EEPROM file %s for reading.\n", _fileName);
 			return -1;
 		}
-		myFile.read((char*)_values, _length);
-		myFile.close();
+	}
+
+	if (_flushInterval) {
+		_map = (uint8_t *)mmap(NULL, _length, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+		if (_map == MAP_FAILED) {
+			_map = NULL;
+			logError("Unable to map EEPROM file %s: %s\n", _fileName, strerror(errno));
+			return -1;
+		}
 	}
 
 	return 0;
@@ -96,11 +144,22 @@ int SoftEeprom::init(const char *fileName, size_t length)
 
 void SoftEeprom::destroy()
 {
+	flush();
+	if (_map) {
+		munmap(_map, _length);
+		_map = NULL;
+	}
+	if (_fd != -1) {
+		close(_fd);
+		_fd = -1;
+	}
 	if (_values) {
 		delete[] _values;
+		_values = NULL;
 	}
 	if (_fileName) {
 		free(_fileName);
+		_fileName = NULL;
 	}
 	_length = 0;
 }
@@ -135,14 +194,24 @@ void SoftEeprom::writeBlock(void* buf, void* addr, size_t length)
 
 		memcpy(_values+offs, buf, length);
 
-		std::ofstream myFile(_fileName, std::ios::out | std::ios::in | std::ios::binary);
-		if (!myFile) {
-			logError("Unable to write config to file %s.\n", _fileName);
+		if (_map) {
+			// collect the change, flush() commits it
+			if (_dirtyStart == _dirtyEnd) {
+				_dirtyStart = offs;
+				_dirtyEnd = offs + length;
+				_dirtySince = _millis();
+			} else {
+				_dirtyStart = offs < _dirtyStart ? offs : _dirtyStart;
+				_dirtyEnd = offs + length > _dirtyEnd ? offs + length : _dirtyEnd;
+			}
+			// a steady stream of writes is committed at least once per interval
+			(void)flushIfDue();
 			return;
 		}
-		myFile.seekp(offs);
-		myFile.write((const char*)buf, length);
-		myFile.close();
+
+		if (openFile() != 0 || pwrite(_fd, buf, length, offs) != (ssize_t)length) {
+			logError("Unable to write config to file %s.\n", _fileName);
+		}
 	}
 }
 
@@ -161,11 +230,135 @@ void SoftEeprom::writeByte(int addr, uint8_t value)
 	}
 }
 
+int SoftEeprom::flushIfDue()
+{
+	if (_dirtyStart == _dirtyEnd) {
+		return -1;
+	}
+
+	const uint32_t age = _millis() - _dirtySince;
+	if (age < _flushInterval) {
+		return _flushInterval - age;
+	}
+	flush();
+
+	return -1;
+}
+
+void SoftEeprom::flush()
+{
+	if (_dirtyStart == _dirtyEnd || !_map) {
+		return;
+	}
+
+	const uint32_t offset = _dirtyStart;
+	const uint32_t length = _dirtyEnd - _dirtyStart;
+	_dirtyStart = _dirtyEnd = 0;
+
+	// 1. write the new data to the journal, the eeprom file is untouched until it is complete
+	struct journalHeader header;
+	header.magic = SOFTEEPROM_JOURNAL_MAGIC;
+	header.offset = offset;
+	header.length = length;
+	header.checksum = _checksum(offset, length, _values + offset);
+
+	char *journal = journalName();
+	int jfd = journal == NULL ? -1 : open(journal, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (jfd == -1 || write(jfd, &header, sizeof(header)) != (ssize_t)sizeof(header) ||
+	        write(jfd, _values + offset, length) != (ssize_t)length || fdatasync(jfd) != 0) {
+		logError("Unable to write EEPROM journal %s: %s\n", journal == NULL ? _fileName : journal,
+		         strerror(errno));
+		if (jfd != -1) {
+			close(jfd);
+		}
+		// keep the eeprom file consistent, retry with the next flush
+		_dirtyStart = offset;
+		_dirtyEnd = offset + length;
+		_dirtySince = _millis();
+		free(journal);
+		return;
+	}
+
+	// 2. update the eeprom file
+	const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	const size_t syncStart = offset - offset % page;
+	memcpy(_map + offset, _values + offset, length);
+	if (msync(_map + syncStart, offset + length - syncStart, MS_SYNC) != 0) {
+		logError("Unable to write config to file %s: %s\n", _fileName, strerror(errno));
+	}
+
+	// 3. the journal is not needed anymore, replaying it again would be harmless
+	if (ftruncate(jfd, 0) != 0) {
+		logError("Unable to clear EEPROM journal %s: %s\n", journal, strerror(errno));
+	}
+	close(jfd);
+	free(journal);
+}
+
+int SoftEeprom::openFile()
+{
+	if (_fd == -1) {
+		_fd = open(_fileName, O_RDWR | O_CLOEXEC);
+		if (_fd == -1) {
+			logError("Unable to open EEPROM file %s: %s\n", _fileName, strerror(errno));
+			return -1;
+		}
+	}
+	return 0;
+}
+
+char *SoftEeprom::journalName()
+{
+	const size_t size = strlen(_fileName) + sizeof(".journal");
+	char *name = (char *)malloc(size);
+	if (name != NULL) {
+		snprintf(name, size, "%s.journal", _fileName);
+	}
+	return name;
+}
+
+void SoftEeprom::replayJournal()
+{
+	struct journalHeader header;
+	struct stat journalInfo;
+	char *journal = journalName();
+	bool keep = false;
+	int jfd;
+
+	if (journal == NULL || (jfd = open(journal, O_RDONLY | O_CLOEXEC)) == -1) {
+		free(journal);
+		return;
+	}
+
+	if (fstat(jfd, &journalInfo) == 0 && journalInfo.st_size > (off_t)sizeof(header) &&
+	        read(jfd, &header, sizeof(header)) == (ssize_t)sizeof(header) &&
+	        header.magic == SOFTEEPROM_JOURNAL_MAGIC &&
+	        (off_t)(sizeof(header) + header.length) == journalInfo.st_size &&
+	        header.offset + header.length <= _length) {
+		uint8_t *data = new uint8_t[header.length];
+		if (read(jfd, data, header.length) == (ssize_t)header.length &&
+		        _checksum(header.offset, header.length, data) == header.checksum) {
+			logInfo("Replaying EEPROM journal %s.\n", journal);
+			if (openFile() != 0 || pwrite(_fd, data, header.length, header.offset) != (ssize_t)header.length ||
+			        fdatasync(_fd) != 0) {
+				logError("Unable to write config to file %s.\n", _fileName);
+				// try again on the next start
+				keep = true;
+			}
+		}
+		delete[] data;
+	}
+	close(jfd);
+	if (!keep) {
+		unlink(journal);
+	}
+	free(journal);
+}
+
 SoftEeprom& SoftEeprom::operator=(const SoftEeprom& other)
 {
 	if (this != &other) {
-		delete[] _values;
-		free(_fileName);
+		destroy();
 
 		_fileName = strdup(other._fileName);
 
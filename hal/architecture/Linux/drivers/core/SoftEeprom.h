@@ -20,6 +20,11 @@
 /**
 * This a software emulation of EEPROM that uses a file for data storage.
 * A copy of the eeprom values are also held in memory for faster reading.
+*
+* Writes either go straight to the file, or, with a flush interval, are collected
+* into a dirty range that is periodically committed through a write-ahead journal
+* (<file>.journal) and the memory-mapped file, so a power loss never leaves a
+* partially written range behind.
 */
 
 #ifndef SoftEeprom_h
@@ -49,11 +54,15 @@ public:
 	/**
 	 * @brief Initializes the eeprom class.
 	 *
+	 * A journal left over from an interrupted flush is replayed first.
+	 *
 	 * @param fileName filepath where the data is saved.
 	 * @param length eeprom size in bytes.
+	 * @param flushInterval time in ms writes are collected before being committed,
+	 *                      0 writes every change to the file immediately.
 	 * @return 0 if SUCCESS or -1 if FAILURE.
 	 */
-	int init(const char *fileName, size_t length);
+	int init(const char *fileName, size_t length, uint32_t flushInterval = 0);
 	/**
 	 * @brief Clear all allocated memory variables.
 	 *
@@ -89,6 +98,16 @@ public:
 	 * @param value to write.
 	 */
 	void writeByte(int addr, uint8_t value);
+	/**
+	 * @brief Commit the pending writes if the flush interval expired.
+	 *
+	 * @return time in ms until the next commit is due, -1 if nothing is pending.
+	 */
+	int flushIfDue();
+	/**
+	 * @brief Commit the pending writes now.
+	 */
+	void flush();
 	/**
 	 * @brief Overloaded assign operator.
 	 *
@@ -99,6 +118,31 @@ private:
 	size_t _length; //!< @brief Eeprom max size.
 	char *_fileName; //!< @brief file where the eeprom values are stored.
 	uint8_t *_values; //!< @brief copy of the eeprom values held in memory for a faster reading.
+	int _fd; //!< @brief file descriptor of the eeprom file.
+	uint8_t *_map; //!< @brief eeprom file mapped into memory, only used with a flush interval.
+	uint32_t _flushInterval; //!< @brief time in ms writes are collected, 0 to write through.
+	size_t _dirtyStart; //!< @brief first modified byte not yet committed.
+	size_t _dirtyEnd; //!< @brief end of the modified range, equal to _dirtyStart if clean.
+	uint32_t _dirtySince; //!< @brief time in ms of the first uncommitted write.
+
+	/**
+	 * @brief Open the eeprom file for writing if not done yet.
+	 *
+	 * @return 0 if SUCCESS or -1 if FAILURE.
+	 */
+	int openFile();
+	/**
+	 * @brief Get the path of the journal file.
+	 *
+	 * @return newly allocated path, to be released with free().
+	 */
+	char *journalName();
+	/**
+	 * @brief Apply a complete journal to the eeprom file and remove it.
+	 *
+	 * An incomplete journal means the interrupted flush never touched the file, it is discarded.
+	 */
+	void replayJournal();
 };
 
 #endif
@@ -37,7 +37,12 @@ int StdInOutStream::read()
 
 size_t StdInOutStream::write(uint8_t b)
 {
-	return (size_t)::printf("%c", b);
+	return (putchar(b) == EOF) ? 0 : 1;
+}
+
+size_t StdInOutStream::write(const uint8_t *buffer, size_t size)
+{
+	return fwrite(buffer, 1, size, stdout);
 }
 
 int StdInOutStream::peek()
@@ -54,9 +54,17 @@ public:
 	 * @brief Writes a single byte to stdout.
 	 *
 	 * @param b byte to write.
-	 * @return -1 if error else, number of bytes written.
+	 * @return 0 if error else, number of bytes written.
 	 */
 	size_t write(uint8_t b);
+	/**
+	 * @brief Writes binary data to stdout.
+	 *
+	 * @param buffer to write.
+	 * @param size of the buffer.
+	 * @return number of bytes written.
+	 */
+	size_t write(const uint8_t *buffer, size_t size);
 	/**
 	 * @brief Not supported.
 	 *
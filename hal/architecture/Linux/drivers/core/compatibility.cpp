@@ -18,39 +18,58 @@
  */
 
 #include <time.h>
-#include <sys/time.h>
 #include <stdlib.h>
 #include "Arduino.h"
 
-// For millis()
-static unsigned long millis_at_start = 0;
+// millis() and micros() count from the first second they are read in. The monotonic clock does
+// not jump when NTP or the user sets the time, timeouts would expire early or never otherwise.
+
+// The coarse clock is read from the vDSO without touching the hardware counter, it is used for
+// millis() if it ticks at least every ms (kernels with HZ=1000)
+static clockid_t _millisClockSelect(void)
+{
+#if defined(CLOCK_MONOTONIC_COARSE)
+	struct timespec res;
+	if (clock_getres(CLOCK_MONOTONIC_COARSE, &res) == 0 && res.tv_sec == 0 &&
+	        res.tv_nsec <= 1000000) {
+		return CLOCK_MONOTONIC_COARSE;
+	}
+#endif
+	return CLOCK_MONOTONIC;
+}
+
+static time_t _clockStartSelect(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec;
+}
+
+static time_t _clockStart(void)
+{
+	static const time_t start = _clockStartSelect();
+	return start;
+}
 
 void yield(void) {}
 
 unsigned long millis(void)
 {
-	timeval curTime;
+	static const clockid_t clock = _millisClockSelect();
+	const time_t start = _clockStart();
+	struct timespec now;
 
-	if (millis_at_start == 0) {
-		gettimeofday(&curTime, NULL);
-		millis_at_start = curTime.tv_sec;
-	}
-
-	gettimeofday(&curTime, NULL);
-	return ((curTime.tv_sec - millis_at_start) * 1000) + (curTime.tv_usec / 1000);
+	clock_gettime(clock, &now);
+	return ((now.tv_sec - start) * 1000) + (now.tv_nsec / 1000000);
 }
 
 unsigned long micros()
 {
-	timeval curTime;
-
-	if (millis_at_start == 0) {
-		gettimeofday(&curTime, NULL);
-		millis_at_start = curTime.tv_sec;
-	}
+	const time_t start = _clockStart();
+	struct timespec now;
 
-	gettimeofday(&curTime, NULL);
-	return ((curTime.tv_sec - millis_at_start) * 1000000) + (curTime.tv_usec);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((now.tv_sec - start) * 1000000) + (now.tv_nsec / 1000);
 }
 
 void _delay_milliseconds(unsigned int millis)
@@ -19,17 +19,23 @@
  * Based on mosquitto project, Copyright (c) 2012 Roger Light <roger@atchoo.org>
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE	/* CPU_SETSIZE */
+#endif
 #include "config.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sched.h>
 #include "log.h"
 
 static int _config_create(const char *config_file);
 static int _config_parse_int(char *token, const char *name, int *value);
 static int _config_parse_string(char *token, const char *name, char **value);
+static int _config_parse_scheduler(char *token, const char *name, int *value);
+static int _config_check_scheduling(const char *name, int scheduler, int priority, int cpu);
 
 int config_parse(const char *config_file)
 {
@@ -53,11 +59,32 @@ int config_parse(const char *config_file)
 	conf.log_pipe = 0;
 	conf.log_pipe_file = NULL;
 	conf.syslog = 0;
+	conf.log_async = 0;
 	conf.eeprom_file = NULL;
 	conf.eeprom_size = 0;
 	conf.soft_hmac_key = NULL;
 	conf.soft_serial_key = NULL;
 	conf.aes_key = NULL;
+	conf.rf24_channel = -1;
+	conf.stats_port = 0;
+	conf.pcap_file = NULL;
+	conf.presentation_cache_file = NULL;
+	conf.outbox_file = NULL;
+	conf.firmware_dir = NULL;
+	conf.standby_peer = NULL;
+	conf.standby_port = 0;
+	conf.sim_group = NULL;
+	conf.sim_port = 0;
+	conf.sim_loss = 0;
+	conf.sim_latency_us = 0;
+	conf.sim_topology = NULL;
+	conf.irq_scheduler = SCHED_RR;
+	conf.irq_priority = 55;
+	conf.irq_cpu = -1;
+	conf.radio_scheduler = SCHED_OTHER;
+	conf.radio_priority = 0;
+	conf.radio_cpu = -1;
+	conf.lock_memory = 0;
 
 	while (fgets(buf, 1024, fptr)) {
 		if (buf[0] != '#' && buf[0] != 10 && buf[0] != 13) {
@@ -132,6 +159,17 @@ int config_parse(const char *config_file)
 						return -1;
 					}
 				}
+			} else if (!strncmp(buf, "log_async=", 10)) {
+				if (_config_parse_int(&(buf[10]), "log_async", &conf.log_async)) {
+					fclose(fptr);
+					return -1;
+				} else {
+					if (conf.log_async != 0 && conf.log_async != 1) {
+						logError("log_async must be 1 or 0 in configuration.\n");
+						fclose(fptr);
+						return -1;
+					}
+				}
 			} else if (!strncmp(buf, "eeprom_file=", 12)) {
 				if (_config_parse_string(&(buf[12]), "eeprom_file", &conf.eeprom_file)) {
 					fclose(fptr);
@@ -163,6 +201,149 @@ int config_parse(const char *config_file)
 					fclose(fptr);
 					return -1;
 				}
+			} else if (!strncmp(buf, "rf24_channel=", 13)) {
+				if (_config_parse_int(&(buf[13]), "rf24_channel", &conf.rf24_channel)) {
+					fclose(fptr);
+					return -1;
+				} else {
+					if (conf.rf24_channel < 0 || conf.rf24_channel > 125) {
+						logError("rf24_channel value must be between 0 and 125 in configuration.\n");
+						fclose(fptr);
+						return -1;
+					}
+				}
+			} else if (!strncmp(buf, "stats_port=", 11)) {
+				if (_config_parse_int(&(buf[11]), "stats_port", &conf.stats_port)) {
+					fclose(fptr);
+					return -1;
+				} else {
+					if (conf.stats_port < 0 || conf.stats_port > 65535) {
+						logError("stats_port value must be between 0 and 65535 in configuration.\n");
+						fclose(fptr);
+						return -1;
+					}
+				}
+			} else if (!strncmp(buf, "pcap_file=", 10)) {
+				if (_config_parse_string(&(buf[10]), "pcap_file", &conf.pcap_file)) {
+					fclose(fptr);
+					return -1;
+				}
+			} else if (!strncmp(buf, "presentation_cache_file=", 24)) {
+				if (_config_parse_string(&(buf[24]), "presentation_cache_file",
+				                         &conf.presentation_cache_file)) {
+					fclose(fptr);
+					return -1;
+				}
+			} else if (!strncmp(buf, "outbox_file=", 12)) {
+				if (_config_parse_string(&(buf[12]), "outbox_file", &conf.outbox_file)) {
+					fclose(fptr);
+					return -1;
+				}
+			} else if (!strncmp(buf, "firmware_dir=", 13)) {
+				if (_config_parse_string(&(buf[13]), "firmware_dir", &conf.firmware_dir)) {
+					fclose(fptr);
+					return -1;
+				}
+			} else if (!strncmp(buf, "standby_peer=", 13)) {
+				if (_config_parse_string(&(buf[13]), "standby_peer", &conf.standby_peer)) {
+					fclose(fptr);
+					return -1;
+				}
+			} else if (!strncmp(buf, "standby_port=", 13)) {
+				if (_config_parse_int(&(buf[13]), "standby_port", &conf.standby_port)) {
+					fclose(fptr);
+					return -1;
+				} else {
+					if (conf.standby_port < 0 || conf.standby_port > 65535) {
+						logError("standby_port value must be between 0 and 65535 in configuration.\n");
+						fclose(fptr);
+						return -1;
+					}
+				}
+			} else if (!strncmp(buf, "sim_group=", 10)) {
+				if (_config_parse_string(&(buf[10]), "sim_group", &conf.sim_group)) {
+					fclose(fptr);
+					return -1;
+				}
+			} else if (!strncmp(buf, "sim_port=", 9)) {
+				if (_config_parse_int(&(buf[9]), "sim_port", &conf.sim_port)) {
+					fclose(fptr);
+					return -1;
+				} else {
+					if (conf.sim_port < 0 || conf.sim_port > 65535) {
+						logError("sim_port value must be between 0 and 65535 in configuration.\n");
+						fclose(fptr);
+						return -1;
+					}
+				}
+			} else if (!strncmp(buf, "sim_loss=", 9)) {
+				if (_config_parse_int(&(buf[9]), "sim_loss", &conf.sim_loss)) {
+					fclose(fptr);
+					return -1;
+				} else {
+					if (conf.sim_loss < 0 || conf.sim_loss > 100) {
+						logError("sim_loss value must be between 0 and 100 in configuration.\n");
+						fclose(fptr);
+						return -1;
+					}
+				}
+			} else if (!strncmp(buf, "sim_latency_us=", 15)) {
+				if (_config_parse_int(&(buf[15]), "sim_latency_us", &conf.sim_latency_us)) {
+					fclose(fptr);
+					return -1;
+				} else {
+					if (conf.sim_latency_us < 0) {
+						logError("sim_latency_us value must be 0 or greater in configuration.\n");
+						fclose(fptr);
+						return -1;
+					}
+				}
+			} else if (!strncmp(buf, "sim_topology=", 13)) {
+				if (_config_parse_string(&(buf[13]), "sim_topology", &conf.sim_topology)) {
+					fclose(fptr);
+					return -1;
+				}
+			} else if (!strncmp(buf, "irq_scheduler=", 14)) {
+				if (_config_parse_scheduler(&(buf[14]), "irq_scheduler", &conf.irq_scheduler)) {
+					fclose(fptr);
+					return -1;
+				}
+			} else if (!strncmp(buf, "irq_priority=", 13)) {
+				if (_config_parse_int(&(buf[13]), "irq_priority", &conf.irq_priority)) {
+					fclose(fptr);
+					return -1;
+				}
+			} else if (!strncmp(buf, "irq_cpu=", 8)) {
+				if (_config_parse_int(&(buf[8]), "irq_cpu", &conf.irq_cpu)) {
+					fclose(fptr);
+					return -1;
+				}
+			} else if (!strncmp(buf, "radio_scheduler=", 16)) {
+				if (_config_parse_scheduler(&(buf[16]), "radio_scheduler", &conf.radio_scheduler)) {
+					fclose(fptr);
+					return -1;
+				}
+			} else if (!strncmp(buf, "radio_priority=", 15)) {
+				if (_config_parse_int(&(buf[15]), "radio_priority", &conf.radio_priority)) {
+					fclose(fptr);
+					return -1;
+				}
+			} else if (!strncmp(buf, "radio_cpu=", 10)) {
+				if (_config_parse_int(&(buf[10]), "radio_cpu", &conf.radio_cpu)) {
+					fclose(fptr);
+					return -1;
+				}
+			} else if (!strncmp(buf, "lock_memory=", 12)) {
+				if (_config_parse_int(&(buf[12]), "lock_memory", &conf.lock_memory)) {
+					fclose(fptr);
+					return -1;
+				} else {
+					if (conf.lock_memory != 0 && conf.lock_memory != 1) {
+						logError("lock_memory must be 1 or 0 in configuration.\n");
+						fclose(fptr);
+						return -1;
+					}
+				}
 			} else {
 				logWarning("Unknown config option \"%s\".\n", buf);
 			}
@@ -185,37 +366,88 @@ int config_parse(const char *config_file)
 		return -1;
 	}
 
+	if (_config_check_scheduling("irq", conf.irq_scheduler, conf.irq_priority, conf.irq_cpu) ||
+	        _config_check_scheduling("radio", conf.radio_scheduler, conf.radio_priority,
+	                                 conf.radio_cpu)) {
+		return -1;
+	}
+
 	return 0;
 }
 
-void config_cleanup(void)
+/*
+ * Parse config_file again, on success previous holds the settings that were
+ * replaced and must be freed with config_release(), on failure conf is unchanged.
+ */
+int config_reload(const char *config_file, struct config *previous)
 {
-	if (conf.log_filepath) {
-		free(conf.log_filepath);
+	*previous = conf;
+	memset(&conf, 0, sizeof(conf));
+	if (config_parse(config_file) != 0) {
+		config_release(&conf);
+		conf = *previous;
+		return -1;
+	}
+	return 0;
+}
+
+void config_release(struct config *config)
+{
+	if (config->log_filepath) {
+		free(config->log_filepath);
+	}
+	if (config->log_pipe_file) {
+		free(config->log_pipe_file);
+	}
+	if (config->eeprom_file) {
+		free(config->eeprom_file);
+	}
+	if (config->soft_hmac_key) {
+		free(config->soft_hmac_key);
+	}
+	if (config->soft_serial_key) {
+		free(config->soft_serial_key);
+	}
+	if (config->aes_key) {
+		free(config->aes_key);
+	}
+	if (config->pcap_file) {
+		free(config->pcap_file);
+	}
+	if (config->presentation_cache_file) {
+		free(config->presentation_cache_file);
 	}
-	if (conf.log_pipe_file) {
-		free(conf.log_pipe_file);
+	if (config->outbox_file) {
+		free(config->outbox_file);
 	}
-	if (conf.eeprom_file) {
-		free(conf.eeprom_file);
+	if (config->firmware_dir) {
+		free(config->firmware_dir);
 	}
-	if (conf.soft_hmac_key) {
-		free(conf.soft_hmac_key);
+	if (config->standby_peer) {
+		free(config->standby_peer);
 	}
-	if (conf.soft_serial_key) {
-		free(conf.soft_serial_key);
+	if (config->sim_group) {
+		free(config->sim_group);
 	}
-	if (conf.aes_key) {
-		free(conf.aes_key);
+	if (config->sim_topology) {
+		free(config->sim_topology);
 	}
 }
 
+void config_cleanup(void)
+{
+	config_release(&conf);
+}
+
 int _config_create(const char *config_file)
 {
 	FILE *myFile;
 	int ret;
 
-	const char default_conf[] = "# Logging\n" \
+	const char default_conf[] = "# The logging, statistics and capture settings are applied again\n" \
+	                            "# when mysgw receives SIGHUP, the others need a restart.\n" \
+	                            "\n" \
+	                            "# Logging\n" \
 	                            "# Verbosity: debug,info,notice,warn,err\n" \
 	                            "verbose=debug\n" \
 	                            "\n" \
@@ -235,6 +467,12 @@ int _config_create(const char *config_file)
 	                            "# Enable logging to syslog.\n" \
 	                            "syslog=0\n" \
 	                            "\n" \
+	                            "# Write log messages from a background thread.\n" \
+	                            "# Use this option to keep logging I/O out of the radio handling,\n" \
+	                            "# lines are dropped and counted instead of blocking if the thread\n" \
+	                            "# falls behind.\n" \
+	                            "log_async=0\n" \
+	                            "\n" \
 	                            "# EEPROM settings\n" \
 	                            "eeprom_file=/etc/mysensors.eeprom\n" \
 	                            "eeprom_size=1024\n" \
@@ -256,7 +494,101 @@ int _config_create(const char *config_file)
 	                            "#\n" \
 	                            "# To generate a AES key run mysgw with: --gen-aes-key\n" \
 	                            "# copy the new key in the line below and uncomment it.\n" \
-	                            "#aes_key=\n";
+	                            "#aes_key=\n" \
+	                            "\n" \
+	                            "# Radio settings\n" \
+	                            "# Note: The gateway must have been built with the RF24\n" \
+	                            "#       radio to use the option below.\n" \
+	                            "#\n" \
+	                            "# RF channel (0-125), overrides MY_RF24_CHANNEL. Gateways on\n" \
+	                            "# different channels each serve their own network, nodes\n" \
+	                            "# must be built with the channel of their gateway.\n" \
+	                            "#rf24_channel=76\n" \
+	                            "\n" \
+	                            "# Statistics\n" \
+	                            "# Note: The gateway must have been built with --my-stats\n" \
+	                            "#       to use the option below.\n" \
+	                            "#\n" \
+	                            "# Serve the transport and gateway counters in Prometheus text\n" \
+	                            "# format on http://<gateway>:<stats_port>/metrics, 0 disables it.\n" \
+	                            "#stats_port=9101\n" \
+	                            "\n" \
+	                            "# Radio capture\n" \
+	                            "# Write every frame sent or received by the radio to a pcap\n" \
+	                            "# file (link type USER0, 147) for offline analysis. Each frame\n" \
+	                            "# is preceded by an 8 byte header: version, direction (0 rx,\n" \
+	                            "# 1 tx), flags (1 acknowledged, 2 secondary radio), next\n" \
+	                            "# recipient, RSSI and SNR (int16 little endian).\n" \
+	                            "#pcap_file=/tmp/mysgw.pcap\n" \
+	                            "\n" \
+	                            "# Presentation cache\n" \
+	                            "# Note: The gateway must have been built with\n" \
+	                            "#       MY_GATEWAY_PRESENTATION_CACHE to use the option below.\n" \
+	                            "#\n" \
+	                            "# Keep the presentations and last values of the nodes across\n" \
+	                            "# restarts, they are sent to every controller that connects.\n" \
+	                            "#presentation_cache_file=/etc/mysensors.cache\n" \
+	                            "\n" \
+	                            "# Outbox\n" \
+	                            "# Note: The gateway must have been built with\n" \
+	                            "#       MY_GATEWAY_OUTBOX to use the option below.\n" \
+	                            "#\n" \
+	                            "# Keep the controller messages that could not be delivered to a\n" \
+	                            "# node yet, they are retried after a restart of the gateway.\n" \
+	                            "#outbox_file=/etc/mysensors.outbox\n" \
+	                            "\n" \
+	                            "# Firmware server\n" \
+	                            "# Note: The gateway must have been built with\n" \
+	                            "#       MY_GATEWAY_FIRMWARE_SERVER to use the option below.\n" \
+	                            "#\n" \
+	                            "# Answer the OTA requests of the nodes from the binary images\n" \
+	                            "# <type>-<version>.bin of this directory.\n" \
+	                            "#firmware_dir=/etc/mysensors/firmware\n" \
+	                            "\n" \
+	                            "# Hot-standby pair\n" \
+	                            "# Note: The gateway must have been built with\n" \
+	                            "#       MY_GATEWAY_STANDBY to use the options below.\n" \
+	                            "#\n" \
+	                            "# The active gateway replicates its routes, nonces and outbox\n" \
+	                            "# to a standby connecting to standby_port. With standby_peer\n" \
+	                            "# the gateway starts as the standby of that host and turns its\n" \
+	                            "# radio on when the heartbeat of the peer stops. If the peer\n" \
+	                            "# turns out to be active as well, e.g. after a network failure,\n" \
+	                            "# the gateway exits with a failure to restart as the standby.\n" \
+	                            "#standby_port=5004\n" \
+	                            "#standby_peer=192.168.1.10\n" \
+	                            "\n" \
+	                            "# Simulated radio\n" \
+	                            "# Note: The gateway must have been built with\n" \
+	                            "#       --my-transport=simulated to use the options below.\n" \
+	                            "#\n" \
+	                            "# Multicast group and port shared by all nodes of one network.\n" \
+	                            "#sim_group=239.255.77.77\n" \
+	                            "#sim_port=17777\n" \
+	                            "# Frames lost on air in percent, and time on air of a frame.\n" \
+	                            "#sim_loss=0\n" \
+	                            "#sim_latency_us=0\n" \
+	                            "# Links between the nodes, one per line: <a> <b> [loss] [rssi],\n" \
+	                            "# * matches any node. All nodes hear each other without it.\n" \
+	                            "#sim_topology=/etc/mysensors-topology.txt\n" \
+	                            "\n" \
+	                            "# Scheduling\n" \
+	                            "# Note: Realtime schedulers and lock_memory need root or\n" \
+	                            "#       CAP_SYS_NICE and CAP_IPC_LOCK.\n" \
+	                            "#\n" \
+	                            "# Scheduler (other, fifo, rr), realtime priority (1-99) and\n" \
+	                            "# CPU (-1 for any) of the thread serving the radio interrupt.\n" \
+	                            "#irq_scheduler=rr\n" \
+	                            "#irq_priority=55\n" \
+	                            "#irq_cpu=-1\n" \
+	                            "# The same for the main thread processing the radio messages.\n" \
+	                            "# Keep it below irq_priority, the other threads of the gateway\n" \
+	                            "# (controller, logging) keep the default scheduler.\n" \
+	                            "#radio_scheduler=other\n" \
+	                            "#radio_priority=0\n" \
+	                            "#radio_cpu=-1\n" \
+	                            "# Keep the gateway in RAM to avoid page fault latencies.\n" \
+	                            "#lock_memory=0\n";
 
 	myFile = fopen(config_file, "w");
 	if (!myFile) {
@@ -281,6 +613,36 @@ int _config_parse_int(char *token, const char *name, int *value)
 	return 0;
 }
 
+int _config_parse_scheduler(char *token, const char *name, int *value)
+{
+	if (!strcmp(token, "other")) {
+		*value = SCHED_OTHER;
+	} else if (!strcmp(token, "fifo")) {
+		*value = SCHED_FIFO;
+	} else if (!strcmp(token, "rr")) {
+		*value = SCHED_RR;
+	} else {
+		logError("Invalid value for %s in configuration, use other, fifo or rr.\n", name);
+		return 1;
+	}
+	return 0;
+}
+
+int _config_check_scheduling(const char *name, int scheduler, int priority, int cpu)
+{
+	if (scheduler != SCHED_OTHER && (priority < sched_get_priority_min(scheduler) ||
+	                                 priority > sched_get_priority_max(scheduler))) {
+		logError("%s_priority value must be between %d and %d in configuration.\n", name,
+		         sched_get_priority_min(scheduler), sched_get_priority_max(scheduler));
+		return 1;
+	}
+	if (cpu < -1 || cpu >= CPU_SETSIZE) {
+		logError("%s_cpu value must be -1 or a CPU number in configuration.\n", name);
+		return 1;
+	}
+	return 0;
+}
+
 int _config_parse_string(char *token, const char *name, char **value)
 {
 	if (token) {
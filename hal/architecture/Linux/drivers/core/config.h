@@ -31,14 +31,37 @@ struct config {
 	int log_pipe;
 	char *log_pipe_file;
 	int syslog;
+	int log_async;
 	char *eeprom_file;
 	int eeprom_size;
 	char *soft_hmac_key;
 	char *soft_serial_key;
 	char *aes_key;
+	int rf24_channel;
+	int stats_port;
+	char *pcap_file;
+	char *presentation_cache_file;
+	char *outbox_file;
+	char *firmware_dir;
+	char *standby_peer;
+	int standby_port;
+	char *sim_group;
+	int sim_port;
+	int sim_loss;
+	int sim_latency_us;
+	char *sim_topology;
+	int irq_scheduler;
+	int irq_priority;
+	int irq_cpu;
+	int radio_scheduler;
+	int radio_priority;
+	int radio_cpu;
+	int lock_memory;
 } conf;
 
 int config_parse(const char *config_file);
+int config_reload(const char *config_file, struct config *previous);
+void config_release(struct config *config);
 void config_cleanup(void);
 
 #ifdef __cplusplus
@@ -0,0 +1,236 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "eventloop.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include "log.h"
+
+#define EVENTLOOP_MAX_EVENTS 16
+#define EVENTLOOP_MAX_LOOPS 4
+
+struct eventLoop {
+	int epollFd;
+	int wakeupFd;
+	int tickFd;
+	int64_t deadline; // one-shot wakeup in CLOCK_MONOTONIC ms, -1 if none
+};
+
+static struct eventLoop loops[EVENTLOOP_MAX_LOOPS] = {
+	{-1, -1, -1, -1}, {-1, -1, -1, -1}, {-1, -1, -1, -1}, {-1, -1, -1, -1}
+};
+static pthread_mutex_t loopsMutex = PTHREAD_MUTEX_INITIALIZER;
+// each thread waits on its own loop
+static __thread struct eventLoop *current = NULL;
+
+static int _add(int epollFd, int fd)
+{
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = fd;
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == -1 && errno != EEXIST) {
+		logError("epoll_ctl: %s\n", strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+static int64_t _now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void _close(struct eventLoop *loop)
+{
+	if (loop->tickFd != -1) {
+		close(loop->tickFd);
+		loop->tickFd = -1;
+	}
+	if (loop->wakeupFd != -1) {
+		close(loop->wakeupFd);
+		loop->wakeupFd = -1;
+	}
+	if (loop->epollFd != -1) {
+		close(loop->epollFd);
+		loop->epollFd = -1;
+	}
+	loop->deadline = -1;
+}
+
+int eventLoopInit(void)
+{
+	struct eventLoop *loop = NULL;
+	int ret = 0;
+
+	if (current != NULL) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&loopsMutex);
+	for (int i = 0; i < EVENTLOOP_MAX_LOOPS; i++) {
+		if (loops[i].epollFd == -1) {
+			loop = &loops[i];
+			break;
+		}
+	}
+	if (loop == NULL) {
+		logError("Too many event loops.\n");
+		ret = -1;
+	} else if ((loop->wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+		logError("eventfd: %s\n", strerror(errno));
+		ret = -1;
+	} else if ((loop->tickFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) == -1) {
+		logError("timerfd_create: %s\n", strerror(errno));
+		ret = -1;
+	} else if ((loop->epollFd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+		logError("epoll_create1: %s\n", strerror(errno));
+		ret = -1;
+	} else if (_add(loop->epollFd, loop->wakeupFd) != 0 || _add(loop->epollFd, loop->tickFd) != 0) {
+		ret = -1;
+	}
+
+	if (ret == 0) {
+		current = loop;
+	} else if (loop != NULL) {
+		_close(loop);
+	}
+	pthread_mutex_unlock(&loopsMutex);
+
+	return ret;
+}
+
+void eventLoopAdd(int fd)
+{
+	if (fd < 0 || eventLoopInit() != 0) {
+		return;
+	}
+	(void)_add(current->epollFd, fd);
+}
+
+void eventLoopRemove(int fd)
+{
+	if (fd < 0 || current == NULL) {
+		return;
+	}
+	// fd may already be closed, the kernel then removed it for us
+	(void)epoll_ctl(current->epollFd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+void eventLoopSetTick(uint32_t ms)
+{
+	struct itimerspec its;
+
+	if (eventLoopInit() != 0) {
+		return;
+	}
+	memset(&its, 0, sizeof(its));
+	its.it_interval.tv_sec = ms / 1000;
+	its.it_interval.tv_nsec = (long)(ms % 1000) * 1000000;
+	its.it_value = its.it_interval;
+	if (timerfd_settime(current->tickFd, 0, &its, NULL) == -1) {
+		logError("timerfd_settime: %s\n", strerror(errno));
+	}
+}
+
+void eventLoopWakeup(void)
+{
+	const uint64_t one = 1;
+
+	// no lock, loops are only closed on shutdown
+	for (int i = 0; i < EVENTLOOP_MAX_LOOPS; i++) {
+		const int fd = loops[i].wakeupFd;
+		if (fd != -1) {
+			// counter saturation (EAGAIN) still leaves the fd readable
+			(void)!write(fd, &one, sizeof(one));
+		}
+	}
+}
+
+void eventLoopWakeupIn(uint32_t ms)
+{
+	if (eventLoopInit() != 0) {
+		return;
+	}
+	const int64_t deadline = _now() + ms;
+	if (current->deadline == -1 || deadline < current->deadline) {
+		current->deadline = deadline;
+	}
+}
+
+int eventLoopWait(int timeoutMs)
+{
+	struct epoll_event events[EVENTLOOP_MAX_EVENTS];
+	uint64_t count;
+
+	if (eventLoopInit() != 0) {
+		return -1;
+	}
+
+	if (current->deadline != -1) {
+		int64_t remaining = current->deadline - _now();
+		if (remaining < 0) {
+			remaining = 0;
+		}
+		if (timeoutMs < 0 || remaining < timeoutMs) {
+			timeoutMs = (int)remaining;
+		}
+		current->deadline = -1;
+	}
+
+	int n = epoll_wait(current->epollFd, events, EVENTLOOP_MAX_EVENTS, timeoutMs);
+	if (n == -1) {
+		if (errno != EINTR) {
+			logError("epoll_wait: %s\n", strerror(errno));
+			return -1;
+		}
+		return 0;
+	}
+
+	for (int i = 0; i < n; i++) {
+		const int fd = events[i].data.fd;
+		if (fd == current->wakeupFd || fd == current->tickFd) {
+			// consume the event, data on other fds is read by their owners
+			(void)!read(fd, &count, sizeof(count));
+		}
+	}
+
+	return n;
+}
+
+void eventLoopClose(void)
+{
+	if (current == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&loopsMutex);
+	_close(current);
+	current = NULL;
+	pthread_mutex_unlock(&loopsMutex);
+}
@@ -0,0 +1,78 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#ifndef eventloop_h
+#define eventloop_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create the event loop of the calling thread (epoll instance, wakeup eventfd and tick timerfd).
+ *
+ * Every thread has its own loop, fds added by a thread are only watched by that thread's loop.
+ * Called implicitly by the other functions, safe to call more than once.
+ * @return 0 on success, -1 on error.
+ */
+int eventLoopInit(void);
+/**
+ * @brief Watch a file descriptor for incoming data.
+ * @param fd file descriptor (socket, tty, ...).
+ */
+void eventLoopAdd(int fd);
+/**
+ * @brief Stop watching a file descriptor, must be called before closing it.
+ * @param fd file descriptor.
+ */
+void eventLoopRemove(int fd);
+/**
+ * @brief Set the interval of the periodic tick timer.
+ * @param ms tick interval in ms, 0 disables the tick.
+ */
+void eventLoopSetTick(uint32_t ms);
+/**
+ * @brief Wake up all blocked eventLoopWait() calls, can be called from any thread.
+ */
+void eventLoopWakeup(void);
+/**
+ * @brief Make the next eventLoopWait() of the calling thread return after at most ms milliseconds.
+ *
+ * The deadline is one-shot and cleared by eventLoopWait(), the earliest of several requests wins.
+ * @param ms maximum time in ms until the next eventLoopWait() returns.
+ */
+void eventLoopWakeupIn(uint32_t ms);
+/**
+ * @brief Block until a watched fd is readable, the tick timer expired or a wakeup was requested.
+ * @param timeoutMs maximum time to block in ms, -1 blocks until the next event.
+ * @return number of pending events, 0 on timeout, -1 on error.
+ */
+int eventLoopWait(int timeoutMs);
+/**
+ * @brief Close the event loop of the calling thread.
+ */
+void eventLoopClose(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
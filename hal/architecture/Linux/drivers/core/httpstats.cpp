@@ -0,0 +1,176 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "httpstats.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <pthread.h>
+#include "log.h"
+
+#define HTTPSTATS_BODY_SIZE 16384
+#define HTTPSTATS_REQUEST_SIZE 1024
+#define HTTPSTATS_TIMEOUT_MS 1000
+
+static int listenFd = -1;
+static int stopFd[2] = {-1, -1};
+static pthread_t thread;
+static bool running = false;
+static httpStatsRender_t renderCb = NULL;
+
+static void _send(int fd, const char *data, size_t length)
+{
+	while (length) {
+		const ssize_t n = send(fd, data, length, MSG_NOSIGNAL);
+		if (n <= 0) {
+			return;
+		}
+		data += n;
+		length -= n;
+	}
+}
+
+static void _serve(int fd)
+{
+	char request[HTTPSTATS_REQUEST_SIZE];
+	size_t length = 0;
+	struct pollfd pfd = {fd, POLLIN, 0};
+
+	// read the request head, the body of a GET is empty
+	while (length < sizeof(request) - 1 && poll(&pfd, 1, HTTPSTATS_TIMEOUT_MS) > 0) {
+		const ssize_t n = recv(fd, &request[length], sizeof(request) - 1 - length, 0);
+		if (n <= 0) {
+			return;
+		}
+		length += n;
+		request[length] = '\0';
+		if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) {
+			break;
+		}
+	}
+	request[length] = '\0';
+
+	char header[160];
+	if (strncmp(request, "GET / ", 6) && strncmp(request, "GET /metrics ", 13) &&
+	        strncmp(request, "GET /metrics?", 13)) {
+		const int n = snprintf(header, sizeof(header),
+		                       "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+		_send(fd, header, n);
+		return;
+	}
+	char body[HTTPSTATS_BODY_SIZE];
+	const size_t bodyLength = renderCb(body, sizeof(body));
+	const int n = snprintf(header, sizeof(header),
+	                       "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+	                       "Content-Length: %zu\r\nConnection: close\r\n\r\n", bodyLength);
+	_send(fd, header, n);
+	_send(fd, body, bodyLength);
+}
+
+static void *_run(void *)
+{
+	struct pollfd pfd[2] = {{listenFd, POLLIN, 0}, {stopFd[0], POLLIN, 0}};
+
+	for (;;) {
+		if (poll(pfd, 2, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			logError("httpstats poll: %s\n", strerror(errno));
+			break;
+		}
+		if (pfd[1].revents) {
+			break;
+		}
+		if (pfd[0].revents & POLLIN) {
+			const int fd = accept(listenFd, NULL, NULL);
+			if (fd >= 0) {
+				_serve(fd);
+				close(fd);
+			}
+		}
+	}
+	return NULL;
+}
+
+int httpStatsBegin(uint16_t port, httpStatsRender_t render)
+{
+	struct sockaddr_in addr;
+	int on = 1;
+
+	if (listenFd >= 0 || render == NULL) {
+		return -1;
+	}
+	listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (listenFd < 0) {
+		logError("httpstats socket: %s\n", strerror(errno));
+		return -1;
+	}
+	(void)setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listenFd, 4) < 0) {
+		logError("httpstats bind to port %u: %s\n", port, strerror(errno));
+		close(listenFd);
+		listenFd = -1;
+		return -1;
+	}
+	if (pipe(stopFd) < 0) {
+		close(listenFd);
+		listenFd = -1;
+		return -1;
+	}
+	renderCb = render;
+	if (pthread_create(&thread, NULL, _run, NULL) != 0) {
+		httpStatsEnd();
+		return -1;
+	}
+	running = true;
+	logInfo("Statistics served on port %u\n", port);
+	return 0;
+}
+
+void httpStatsEnd(void)
+{
+	if (listenFd < 0) {
+		return;
+	}
+	if (running) {
+		const char stop = 0;
+		if (write(stopFd[1], &stop, 1) == 1) {
+			pthread_join(thread, NULL);
+		}
+		running = false;
+	}
+	close(listenFd);
+	listenFd = -1;
+	for (uint8_t i = 0; i < 2; i++) {
+		if (stopFd[i] >= 0) {
+			close(stopFd[i]);
+			stopFd[i] = -1;
+		}
+	}
+	renderCb = NULL;
+}
@@ -0,0 +1,46 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#ifndef httpstats_h
+#define httpstats_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Renders the statistics text into buffer and returns its length.
+ */
+typedef size_t (*httpStatsRender_t)(char *buffer, const size_t size);
+
+/**
+ * @brief Serve the text of render on GET /metrics (and /) from a background thread.
+ *
+ * The text is rendered on the server thread for every request, render must only read
+ * values that are safe to read concurrently. The response uses the Prometheus text format.
+ * @param port TCP port to listen on.
+ * @param render callback rendering the response body.
+ * @return 0 on success, -1 on error.
+ */
+int httpStatsBegin(uint16_t port, httpStatsRender_t render);
+/**
+ * @brief Stop the server thread and close the listening socket.
+ */
+void httpStatsEnd(void);
+
+#endif
@@ -22,125 +22,125 @@
 #include "interrupt.h"
 #include <pthread.h>
 #include <stdlib.h>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
 #include <stdio.h>
 #include <unistd.h>
-#include <poll.h>
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
-#include <stropts.h>
 #include <errno.h>
 #include <sched.h>
+#include <time.h>
+#include <linux/gpio.h>
 #include "log.h"
+#include "eventloop.h"
+#include "GPIO.h"
+#include "scheduling.h"
 
-struct ThreadArgs {
+struct interruptLine {
 	void (*func)();
-	int gpioPin;
+	int fd;
+	bool sysfs; // fd is /sys/class/gpio/gpioX/value instead of a gpiochip line event
+	uint64_t timestamp;
 };
 
 volatile bool interruptsEnabled = true;
 static pthread_mutex_t intMutex = PTHREAD_MUTEX_INITIALIZER;
+// protects lines against attach/detach while the handler thread dispatches
+static pthread_mutex_t linesMutex = PTHREAD_MUTEX_INITIALIZER;
 
-static pthread_t *threadIds[64] = {NULL};
+static struct interruptLine lines[256];
+static bool linesInitialized = false;
+static int epollFd = -1;
+static pthread_t threadId;
 
-// sysFds:
-//	Map a file descriptor from the /sys/class/gpio/gpioX/value
-static int sysFds[64] = {
-	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-};
+// scheduling of the handler thread, realtime by default so edges are served under load
+static int schedPolicy = SCHED_RR;
+static int schedPriority = 55;
+static int schedCpu = -1;
 
-/*
- * Part of wiringPi: Simple way to get your program running at high priority
- * with realtime schedulling.
- */
-int piHiPri(const int pri)
+// Read the pending edge of a line, returns false if there was none
+static bool readEdge(struct interruptLine *line)
 {
-	struct sched_param sched ;
-
-	memset (&sched, 0, sizeof(sched)) ;
-
-	if (pri > sched_get_priority_max (SCHED_RR)) {
-		sched.sched_priority = sched_get_priority_max (SCHED_RR) ;
-	} else {
-		sched.sched_priority = pri ;
+	if (line->sysfs) {
+		char c;
+		// Do a dummy read to clear the interrupt
+		//	A one character read appars to be enough.
+		if (lseek(line->fd, 0, SEEK_SET) < 0 || read(line->fd, &c, 1) < 0) {
+			logError("Interrupt handler error: %s\n", strerror(errno));
+			return false;
+		}
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		line->timestamp = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+		return true;
 	}
 
-	return sched_setscheduler (0, SCHED_RR, &sched) ;
+	struct gpioevent_data event;
+	if (read(line->fd, &event, sizeof(event)) != sizeof(event)) {
+		if (errno != EAGAIN) {
+			logError("Interrupt handler error: %s\n", strerror(errno));
+		}
+		return false;
+	}
+	line->timestamp = event.timestamp;
+	return true;
 }
 
 void *interruptHandler(void *args)
 {
-	int fd;
-	struct pollfd polls;
-	char c;
-	struct ThreadArgs *arguments = (struct ThreadArgs *)args;
-	int gpioPin = arguments->gpioPin;
-	void (*func)() = arguments->func;
-	delete arguments;
+	struct epoll_event events[8];
 
-	(void)piHiPri(55);	// Only effective if we run as root
-
-	if ((fd = sysFds[gpioPin]) == -1) {
-		logError("Failed to attach interrupt for pin %d\n", gpioPin);
-		return NULL;
-	}
-
-	// Setup poll structure
-	polls.fd     = fd;
-	polls.events = POLLPRI | POLLERR;
+	(void)args;
+	pthread_mutex_lock(&linesMutex);
+	(void)schedulingApply(pthread_self(), schedPolicy, schedPriority, schedCpu);
+	pthread_mutex_unlock(&linesMutex);
 
 	while (1) {
 		// Wait for it ...
-		int ret = poll(&polls, 1, -1);
-		if (ret < 0) {
+		int n = epoll_wait(epollFd, events, 8, -1);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
 			logError("Error waiting for interrupt: %s\n", strerror(errno));
 			break;
 		}
-		// Do a dummy read to clear the interrupt
-		//	A one character read appars to be enough.
-		if (lseek (fd, 0, SEEK_SET) < 0) {
-			logError("Interrupt handler error: %s\n", strerror(errno));
-			break;
-		}
-		if (read (fd, &c, 1) < 0) {
-			logError("Interrupt handler error: %s\n", strerror(errno));
-			break;
-		}
-		// Call user function.
-		pthread_mutex_lock(&intMutex);
-		if (interruptsEnabled) {
-			pthread_mutex_unlock(&intMutex);
-			func();
-		} else {
-			pthread_mutex_unlock(&intMutex);
+		for (int i = 0; i < n; i++) {
+			const uint8_t gpioPin = events[i].data.u32;
+			void (*func)() = NULL;
+
+			pthread_mutex_lock(&linesMutex);
+			if (lines[gpioPin].fd != -1 && readEdge(&lines[gpioPin])) {
+				func = lines[gpioPin].func;
+			}
+			pthread_mutex_unlock(&linesMutex);
+
+			// Call user function.
+			pthread_mutex_lock(&intMutex);
+			if (func != NULL && interruptsEnabled) {
+				pthread_mutex_unlock(&intMutex);
+				func();
+				// let the main loop handle what the ISR queued
+				eventLoopWakeup();
+			} else {
+				pthread_mutex_unlock(&intMutex);
+			}
 		}
 	}
 
-	close(fd);
-
 	return NULL;
 }
 
-void attachInterrupt(uint8_t gpioPin, void (*func)(), uint8_t mode)
+// Export a pin through /sys/class/gpio, used without gpiochip devices
+static int sysfsAttach(uint8_t gpioPin, uint8_t mode)
 {
 	FILE *fd;
 	char fName[40];
 	char c;
-	int count, i;
-
-	if (threadIds[gpioPin] == NULL) {
-		threadIds[gpioPin] = new pthread_t;
-	} else {
-		// Cancel the existing thread for that pin
-		pthread_cancel(*threadIds[gpioPin]);
-		// Wait a bit
-		usleep(1000);
-	}
+	int count, i, valueFd;
 
 	// Export pin for interrupt
 	if ((fd = fopen("/sys/class/gpio/export", "w")) == NULL) {
@@ -179,55 +179,130 @@ void attachInterrupt(uint8_t gpioPin, void (*func)(), uint8_t mode)
 	case RISING:
 		fprintf(fd, "rising\n");
 		break;
-	case NONE:
-		fprintf(fd, "none\n");
+	}
+	fclose(fd);
+
+	snprintf(fName, sizeof(fName), "/sys/class/gpio/gpio%d/value", gpioPin);
+	if ((valueFd = open(fName, O_RDWR)) < 0) {
+		logError("Error reading pin %d: %s\n", gpioPin, strerror(errno));
+		exit(1);
+	}
+
+	// Clear any initial pending interrupt
+	ioctl(valueFd, FIONREAD, &count);
+	for (i = 0; i < count; ++i) {
+		if (read(valueFd, &c, 1) == -1) {
+			logError("attachInterrupt: failed to read pin status: %s\n", strerror(errno));
+		}
+	}
+
+	return valueFd;
+}
+
+void attachInterrupt(uint8_t gpioPin, void (*func)(), uint8_t mode)
+{
+	uint32_t eventFlags;
+
+	switch (mode) {
+	case CHANGE:
+		eventFlags = GPIOEVENT_REQUEST_BOTH_EDGES;
+		break;
+	case FALLING:
+		eventFlags = GPIOEVENT_REQUEST_FALLING_EDGE;
 		break;
+	case RISING:
+		eventFlags = GPIOEVENT_REQUEST_RISING_EDGE;
+		break;
+	case NONE:
+		detachInterrupt(gpioPin);
+		return;
 	default:
 		logError("attachInterrupt: Invalid mode\n");
-		fclose(fd);
 		return;
 	}
-	fclose(fd);
 
-	if (sysFds[gpioPin] == -1) {
-		snprintf(fName, sizeof(fName), "/sys/class/gpio/gpio%d/value", gpioPin);
-		if ((sysFds[gpioPin] = open(fName, O_RDWR)) < 0) {
-			logError("Error reading pin %d: %s\n", gpioPin, strerror(errno));
+	pthread_mutex_lock(&linesMutex);
+	if (!linesInitialized) {
+		for (int i = 0; i < 256; i++) {
+			lines[i].fd = -1;
+		}
+		linesInitialized = true;
+	}
+	if (epollFd == -1) {
+		// a single thread waits for the edges of all pins
+		if ((epollFd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+			logError("attachInterrupt: epoll_create1: %s\n", strerror(errno));
+			exit(1);
+		}
+		if (pthread_create(&threadId, NULL, interruptHandler, NULL) != 0) {
+			logError("attachInterrupt: Unable to create interrupt thread\n");
 			exit(1);
 		}
 	}
+	pthread_mutex_unlock(&linesMutex);
 
-	// Clear any initial pending interrupt
-	ioctl(sysFds[gpioPin], FIONREAD, &count);
-	for (i = 0; i < count; ++i) {
-		if (read(sysFds[gpioPin], &c, 1) == -1) {
-			logError("attachInterrupt: failed to read pin status: %s\n", strerror(errno));
-		}
+	detachInterrupt(gpioPin);
+
+	struct interruptLine line;
+	line.func = func;
+	line.timestamp = 0;
+	line.fd = GPIO.requestEvents(gpioPin, eventFlags);
+	line.sysfs = line.fd == -1;
+	if (line.sysfs) {
+		line.fd = sysfsAttach(gpioPin, mode);
+	} else {
+		fcntl(line.fd, F_SETFL, O_NONBLOCK);
 	}
 
-	struct ThreadArgs *threadArgs = new struct ThreadArgs;
-	threadArgs->func = func;
-	threadArgs->gpioPin = gpioPin;
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = line.sysfs ? (EPOLLPRI | EPOLLERR) : EPOLLIN;
+	ev.data.u32 = gpioPin;
 
-	// Create a thread passing the pin and function
-	pthread_create(threadIds[gpioPin], NULL, interruptHandler, (void *)threadArgs);
+	pthread_mutex_lock(&linesMutex);
+	lines[gpioPin] = line;
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, line.fd, &ev) == -1) {
+		logError("attachInterrupt: epoll_ctl: %s\n", strerror(errno));
+		exit(1);
+	}
+	pthread_mutex_unlock(&linesMutex);
+}
+
+void interruptSetScheduling(int policy, int priority, int cpu)
+{
+	pthread_mutex_lock(&linesMutex);
+	schedPolicy = policy;
+	schedPriority = priority;
+	schedCpu = cpu;
+	if (epollFd != -1) {
+		// the handler thread is already running
+		(void)schedulingApply(threadId, policy, priority, cpu);
+	}
+	pthread_mutex_unlock(&linesMutex);
 }
 
 void detachInterrupt(uint8_t gpioPin)
 {
-	// Cancel the thread
-	if (threadIds[gpioPin] != NULL) {
-		pthread_cancel(*threadIds[gpioPin]);
-		delete threadIds[gpioPin];
-		threadIds[gpioPin] = NULL;
+	pthread_mutex_lock(&linesMutex);
+	if (!linesInitialized || lines[gpioPin].fd == -1) {
+		pthread_mutex_unlock(&linesMutex);
+		return;
 	}
 
-	// Close filehandle
-	if (sysFds[gpioPin] != -1) {
-		close(sysFds[gpioPin]);
-		sysFds[gpioPin] = -1;
+	struct interruptLine line = lines[gpioPin];
+	lines[gpioPin].fd = -1;
+	lines[gpioPin].func = NULL;
+	(void)epoll_ctl(epollFd, EPOLL_CTL_DEL, line.fd, NULL);
+	pthread_mutex_unlock(&linesMutex);
+
+	if (!line.sysfs) {
+		GPIO.releaseEvents(gpioPin);
+		return;
 	}
 
+	// Close filehandle
+	close(line.fd);
+
 	FILE *fp = fopen("/sys/class/gpio/unexport", "w");
 	if (fp == NULL) {
 		logError("Unable to unexport pin %d for interrupt\n", gpioPin);
@@ -237,6 +312,15 @@ void detachInterrupt(uint8_t gpioPin)
 	fclose(fp);
 }
 
+uint64_t interruptTimestamp(uint8_t gpioPin)
+{
+	pthread_mutex_lock(&linesMutex);
+	const uint64_t timestamp = linesInitialized ? lines[gpioPin].timestamp : 0;
+	pthread_mutex_unlock(&linesMutex);
+
+	return timestamp;
+}
+
 void interrupts()
 {
 	pthread_mutex_lock(&intMutex);
@@ -35,6 +35,24 @@ extern "C" {
 
 void attachInterrupt(uint8_t gpioPin, void(*func)(), uint8_t mode);
 void detachInterrupt(uint8_t gpioPin);
+/**
+ * @brief Get the time of the last edge that triggered the interrupt of a pin.
+ *
+ * Edges of gpiochip line events carry the kernel timestamp taken in the GPIO irq handler,
+ * with the sysfs fallback the time the handler thread woke up.
+ * @param gpioPin The number of the pin.
+ * @return timestamp in ns (CLOCK_MONOTONIC, CLOCK_REALTIME on kernels before 5.7), 0 if none.
+ */
+uint64_t interruptTimestamp(uint8_t gpioPin);
+/**
+ * @brief Set the scheduling of the thread handling the interrupts.
+ *
+ * Applied when the thread is started by the first attachInterrupt(), or right away if it runs.
+ * @param policy SCHED_OTHER, SCHED_FIFO or SCHED_RR, SCHED_RR by default.
+ * @param priority realtime priority, 55 by default.
+ * @param cpu CPU to pin the thread to, -1 (default) to leave the affinity unchanged.
+ */
+void interruptSetScheduling(int policy, int priority, int cpu);
 void interrupts();
 void noInterrupts();
 
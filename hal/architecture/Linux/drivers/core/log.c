@@ -17,6 +17,9 @@
  * version 2 as published by the Free Software Foundation.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE	/* PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP */
+#endif
 #include "log.h"
 #include <stdio.h>
 #include <stdarg.h>
@@ -27,6 +30,8 @@
 #include <string.h>
 #include <time.h>
 #include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
 
 static const char *_log_level_colors[] = {
 	"\x1b[1;5;91m", "\x1b[1;91m", "\x1b[91m", "\x1b[31m", "\x1b[33m", "\x1b[34m", "\x1b[32m", "\x1b[36m"
@@ -44,6 +49,31 @@ static int _log_pipe_fd = -1;
 
 static FILE *_log_file_fp = NULL;
 
+/* held while a sink is written, so sinks can be swapped by logResetSinks() at runtime,
+ * recursive as the signal handlers log and close the sinks on the interrupted thread */
+static pthread_mutex_t _log_sink_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+/* Asynchronous mode: callers format into a ring of records, a writer thread does the I/O */
+#define LOG_ASYNC_RECORDS		1024	/* power of 2 */
+#define LOG_ASYNC_LINE_SIZE		256
+#define LOG_ASYNC_BATCH_SIZE	8192
+
+typedef struct {
+	uint32_t seq;	/* record index + 1 once written by a caller */
+	time_t time;
+	int level;
+	char line[LOG_ASYNC_LINE_SIZE];
+} log_record_t;
+
+static uint8_t _log_async = 0;
+static uint8_t _log_async_stop = 0;
+static log_record_t *_log_async_records = NULL;
+static uint32_t _log_async_head = 0;	/* next record to claim, shared by all callers */
+static uint32_t _log_async_tail = 0;	/* next record to write, writer thread only */
+static uint32_t _log_async_dropped = 0;
+static sem_t _log_async_sem;
+static pthread_t _log_async_thread;
+
 void logSetQuiet(uint8_t enable)
 {
 	_log_quiet = enable ? 1 : 0;
@@ -60,8 +90,10 @@ void logSetLevel(int level)
 
 void logSetSyslog(int options, int facility)
 {
+	pthread_mutex_lock(&_log_sink_mutex);
 	openlog(NULL, options, facility);
 	_log_syslog = 1;
+	pthread_mutex_unlock(&_log_sink_mutex);
 }
 
 int logSetPipe(char *pipe_file)
@@ -70,8 +102,11 @@ int logSetPipe(char *pipe_file)
 		return -1;
 	}
 
+	pthread_mutex_lock(&_log_sink_mutex);
+	free(_log_pipe_file);
 	_log_pipe_file = strdup(pipe_file);
 	if (_log_pipe_file == NULL) {
+		pthread_mutex_unlock(&_log_sink_mutex);
 		return -1;
 	}
 
@@ -79,6 +114,7 @@ int logSetPipe(char *pipe_file)
 	if (ret == 0) {
 		_log_pipe = 1;
 	}
+	pthread_mutex_unlock(&_log_sink_mutex);
 
 	return ret;
 }
@@ -89,16 +125,200 @@ int logSetFile(char *file)
 		return -1;
 	}
 
-	_log_file_fp = fopen(file, "a");
-	if (_log_file_fp == NULL) {
+	FILE *fp = fopen(file, "a");
+	if (fp == NULL) {
 		return errno;
 	}
 
+	pthread_mutex_lock(&_log_sink_mutex);
+	if (_log_file_fp != NULL) {
+		fclose(_log_file_fp);
+	}
+	_log_file_fp = fp;
+	pthread_mutex_unlock(&_log_sink_mutex);
+
 	return 0;
 }
 
-void logClose(void)
+static void _log_async_flush(char *batch, size_t *length)
+{
+	if (*length) {
+		(void)fwrite(batch, 1, *length, stderr);
+		*length = 0;
+	}
+}
+
+static void _log_async_output(const log_record_t *record, char *date, time_t *date_time,
+                              char *batch, size_t *batch_length)
 {
+	if (record->time != *date_time) {
+		/* the date string only changes once per second */
+		struct tm lt;
+		(void)localtime_r(&record->time, &lt);
+		date[strftime(date, 16, "%b %d %H:%M:%S", &lt)] = '\0';
+		*date_time = record->time;
+	}
+
+	if (_log_file_fp != NULL) {
+		fprintf(_log_file_fp, "%s %-5s %s", date, _log_level_names[record->level], record->line);
+	}
+
+	if (!_log_quiet) {
+		char prefix[48];
+#ifdef LOG_DISABLE_COLOR
+		const int prefix_length = snprintf(prefix, sizeof(prefix), "%s %-5s ", date,
+		                                   _log_level_names[record->level]);
+#else
+		const int prefix_length = snprintf(prefix, sizeof(prefix), "%s %s%-5s\x1b[0m ", date,
+		                                   _log_level_colors[record->level], _log_level_names[record->level]);
+#endif
+		const size_t line_length = strlen(record->line);
+		if (*batch_length + prefix_length + line_length > LOG_ASYNC_BATCH_SIZE) {
+			_log_async_flush(batch, batch_length);
+		}
+		memcpy(&batch[*batch_length], prefix, prefix_length);
+		memcpy(&batch[*batch_length + prefix_length], record->line, line_length);
+		*batch_length += prefix_length + line_length;
+	}
+
+	if (_log_syslog) {
+		syslog(record->level, "%s", record->line);
+	}
+
+	if (_log_pipe) {
+		if (_log_pipe_fd < 0) {
+			_log_pipe_fd = open(_log_pipe_file, O_WRONLY | O_NONBLOCK);
+		}
+		if (_log_pipe_fd > 0) {
+			if (write(_log_pipe_fd, record->line, strlen(record->line)) < 0) {
+				close(_log_pipe_fd);
+				_log_pipe_fd = -1;
+			}
+		}
+	}
+}
+
+static void *_log_async_writer(void *arg)
+{
+	(void)arg;
+	static char batch[LOG_ASYNC_BATCH_SIZE];
+	size_t batch_length = 0;
+	char date[16];
+	time_t date_time = (time_t)-1;
+	uint32_t reported = 0;
+
+	for (;;) {
+		while (sem_wait(&_log_async_sem) != 0 && errno == EINTR) {
+		}
+		pthread_mutex_lock(&_log_sink_mutex);
+		/* write everything that is ready in one go */
+		for (;;) {
+			log_record_t *record = &_log_async_records[_log_async_tail & (LOG_ASYNC_RECORDS - 1)];
+			if (__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) != _log_async_tail + 1) {
+				break;
+			}
+			_log_async_output(record, date, &date_time, batch, &batch_length);
+			/* hand the record back to the callers for the next round */
+			__atomic_store_n(&record->seq, _log_async_tail + LOG_ASYNC_RECORDS, __ATOMIC_RELEASE);
+			_log_async_tail++;
+		}
+		const uint32_t dropped = __atomic_load_n(&_log_async_dropped, __ATOMIC_RELAXED);
+		if (dropped != reported) {
+			log_record_t record;
+			record.time = time(NULL);
+			record.level = LOG_WARNING;
+			snprintf(record.line, sizeof(record.line), "Log buffer full, %u lines dropped in total\n",
+			         dropped);
+			_log_async_output(&record, date, &date_time, batch, &batch_length);
+			reported = dropped;
+		}
+		_log_async_flush(batch, &batch_length);
+		if (_log_file_fp != NULL) {
+			fflush(_log_file_fp);
+		}
+		pthread_mutex_unlock(&_log_sink_mutex);
+		if (__atomic_load_n(&_log_async_stop, __ATOMIC_ACQUIRE)) {
+			break;
+		}
+	}
+	return NULL;
+}
+
+static void _log_async_push(int level, const char *fmt, va_list args)
+{
+	uint32_t pos = __atomic_load_n(&_log_async_head, __ATOMIC_RELAXED);
+	log_record_t *record;
+	for (;;) {
+		record = &_log_async_records[pos & (LOG_ASYNC_RECORDS - 1)];
+		const int32_t diff = (int32_t)(__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) - pos);
+		if (diff == 0) {
+			/* record is free, claim it unless another caller was faster */
+			if (__atomic_compare_exchange_n(&_log_async_head, &pos, pos + 1, 1, __ATOMIC_RELAXED,
+			                                __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if (diff < 0) {
+			/* writer is behind, count the line instead of waiting */
+			__atomic_fetch_add(&_log_async_dropped, 1, __ATOMIC_RELAXED);
+			return;
+		} else {
+			pos = __atomic_load_n(&_log_async_head, __ATOMIC_RELAXED);
+		}
+	}
+	record->time = time(NULL);
+	record->level = level;
+	const int length = vsnprintf(record->line, sizeof(record->line), fmt, args);
+	if (length < 0) {
+		record->line[0] = '\0';
+	} else if (length >= (int)sizeof(record->line)) {
+		/* keep the line break of truncated lines */
+		record->line[sizeof(record->line) - 2] = '\n';
+	}
+	__atomic_store_n(&record->seq, pos + 1, __ATOMIC_RELEASE);
+	(void)sem_post(&_log_async_sem);
+}
+
+int logSetAsync(void)
+{
+	if (_log_async || _log_async_records != NULL) {
+		/* once stopped by logClose() the ring is not reused */
+		return _log_async ? 0 : -1;
+	}
+	_log_async_records = (log_record_t *)malloc(LOG_ASYNC_RECORDS * sizeof(log_record_t));
+	if (_log_async_records == NULL) {
+		return -1;
+	}
+	for (uint32_t i = 0; i < LOG_ASYNC_RECORDS; i++) {
+		_log_async_records[i].seq = i;
+	}
+	_log_async_head = 0;
+	_log_async_tail = 0;
+	_log_async_stop = 0;
+	if (sem_init(&_log_async_sem, 0, 0) != 0) {
+		free(_log_async_records);
+		_log_async_records = NULL;
+		return -1;
+	}
+	if (pthread_create(&_log_async_thread, NULL, _log_async_writer, NULL) != 0) {
+		sem_destroy(&_log_async_sem);
+		free(_log_async_records);
+		_log_async_records = NULL;
+		return -1;
+	}
+	_log_async = 1;
+	/* lines still in the ring are written on any exit() */
+	atexit(logClose);
+	return 0;
+}
+
+uint32_t logGetDropped(void)
+{
+	return __atomic_load_n(&_log_async_dropped, __ATOMIC_RELAXED);
+}
+
+void logResetSinks(void)
+{
+	pthread_mutex_lock(&_log_sink_mutex);
 	if (_log_syslog) {
 		closelog();
 		_log_syslog = 0;
@@ -107,6 +327,7 @@ void logClose(void)
 	if (_log_pipe) {
 		if (_log_pipe_fd > 0) {
 			close(_log_pipe_fd);
+			_log_pipe_fd = -1;
 		}
 		/* remove the FIFO */
 		unlink(_log_pipe_file);
@@ -121,6 +342,21 @@ void logClose(void)
 		fclose(_log_file_fp);
 		_log_file_fp = NULL;
 	}
+	pthread_mutex_unlock(&_log_sink_mutex);
+}
+
+void logClose(void)
+{
+	if (__atomic_load_n(&_log_async, __ATOMIC_RELAXED)) {
+		/* later lines are written directly, the writer drains the ring before it stops */
+		__atomic_store_n(&_log_async, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&_log_async_stop, 1, __ATOMIC_RELEASE);
+		(void)sem_post(&_log_async_sem);
+		pthread_join(_log_async_thread, NULL);
+		/* ring and semaphore are kept, other threads may still be about to push */
+	}
+
+	logResetSinks();
 }
 
 void vlog(int level, const char *fmt, va_list args)
@@ -129,6 +365,12 @@ void vlog(int level, const char *fmt, va_list args)
 		return;
 	}
 
+	if (__atomic_load_n(&_log_async, __ATOMIC_RELAXED)) {
+		_log_async_push(level, fmt, args);
+		return;
+	}
+
+	pthread_mutex_lock(&_log_sink_mutex);
 	if (!_log_quiet || _log_file_fp != NULL) {
 		/* Get current time */
 		time_t t = time(NULL);
@@ -171,6 +413,7 @@ void vlog(int level, const char *fmt, va_list args)
 		}
 
 	}
+	pthread_mutex_unlock(&_log_sink_mutex);
 }
 
 void
@@ -40,6 +40,9 @@ void logSetLevel(int level);
 void logSetSyslog(int options, int facility);
 int logSetPipe(char *pipe_file);
 int logSetFile(char *file);
+int logSetAsync(void);
+void logResetSinks(void);
+uint32_t logGetDropped(void);
 void logClose(void);
 
 void vlog(int level, const char *fmt, va_list args);
@@ -0,0 +1,187 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "pcapcapture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include "SPSCQueue.h"
+#include "log.h"
+
+#define PCAP_CAPTURE_RECORDS 1024
+
+typedef struct {
+	uint32_t sec;
+	uint32_t usec;
+	uint8_t length;
+	pcapCaptureHeader_t header;
+	uint8_t data[PCAP_CAPTURE_SNAPLEN];
+} pcapCaptureRecord_t;
+
+// pcap file header and record header, see https://wiki.wireshark.org/Development/LibpcapFileFormat
+typedef struct {
+	uint32_t magic;
+	uint16_t versionMajor;
+	uint16_t versionMinor;
+	int32_t thisZone;
+	uint32_t sigFigs;
+	uint32_t snapLen;
+	uint32_t linkType;
+} __attribute__((packed)) pcapFileHeader_t;
+
+typedef struct {
+	uint32_t sec;
+	uint32_t usec;
+	uint32_t inclLen;
+	uint32_t origLen;
+} __attribute__((packed)) pcapRecordHeader_t;
+
+static SPSCQueue<pcapCaptureRecord_t, PCAP_CAPTURE_RECORDS> queue;
+static FILE *fp = NULL;
+static pthread_t thread;
+static sem_t sem;
+static bool running = false;
+static bool stop = false;
+static uint32_t dropped = 0;
+
+static void _write(const pcapCaptureRecord_t &record)
+{
+	pcapRecordHeader_t header;
+	header.sec = record.sec;
+	header.usec = record.usec;
+	header.inclLen = sizeof(record.header) + record.length;
+	header.origLen = header.inclLen;
+	if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+	        fwrite(&record.header, header.inclLen, 1, fp) != 1) {
+		logError("pcap write: %s\n", strerror(errno));
+	}
+}
+
+static void *_run(void *)
+{
+	pcapCaptureRecord_t record;
+
+	for (;;) {
+		while (sem_wait(&sem) != 0 && errno == EINTR) {
+		}
+		// write everything that is ready in one go
+		while (queue.pop(record)) {
+			_write(record);
+		}
+		fflush(fp);
+		if (__atomic_load_n(&stop, __ATOMIC_ACQUIRE)) {
+			break;
+		}
+	}
+	return NULL;
+}
+
+int pcapCaptureBegin(const char *file)
+{
+	if (fp != NULL || file == NULL) {
+		return -1;
+	}
+	fp = fopen(file, "wb");
+	if (fp == NULL) {
+		logError("pcap open %s: %s\n", file, strerror(errno));
+		return -1;
+	}
+	const pcapFileHeader_t header = {
+		0xa1b2c3d4, 2, 4, 0, 0, sizeof(pcapCaptureHeader_t) + PCAP_CAPTURE_SNAPLEN, PCAP_CAPTURE_LINKTYPE
+	};
+	if (fwrite(&header, sizeof(header), 1, fp) != 1 || fflush(fp) != 0 || sem_init(&sem, 0, 0) != 0) {
+		logError("pcap write %s: %s\n", file, strerror(errno));
+		fclose(fp);
+		fp = NULL;
+		return -1;
+	}
+	stop = false;
+	if (pthread_create(&thread, NULL, _run, NULL) != 0) {
+		sem_destroy(&sem);
+		fclose(fp);
+		fp = NULL;
+		return -1;
+	}
+	__atomic_store_n(&running, true, __ATOMIC_RELEASE);
+	// frames still queued are written on any exit()
+	atexit(pcapCaptureEnd);
+	logInfo("Capturing radio frames to %s\n", file);
+	return 0;
+}
+
+bool pcapCaptureActive(void)
+{
+	return __atomic_load_n(&running, __ATOMIC_ACQUIRE);
+}
+
+void pcapCapture(uint8_t direction, uint8_t peer, uint8_t flags, int16_t RSSI, int16_t SNR,
+                 const void *data, uint8_t length)
+{
+	if (!pcapCaptureActive()) {
+		return;
+	}
+	if (queue.full()) {
+		__atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	pcapCaptureRecord_t record;
+	struct timespec now;
+	(void)clock_gettime(CLOCK_REALTIME, &now);
+	record.sec = (uint32_t)now.tv_sec;
+	record.usec = (uint32_t)(now.tv_nsec / 1000);
+	record.length = length < PCAP_CAPTURE_SNAPLEN ? length : PCAP_CAPTURE_SNAPLEN;
+	record.header.version = 1;
+	record.header.direction = direction;
+	record.header.flags = flags;
+	record.header.peer = peer;
+	record.header.RSSI = RSSI;
+	record.header.SNR = SNR;
+	memcpy(record.data, data, record.length);
+	(void)queue.push(record);
+	(void)sem_post(&sem);
+}
+
+uint32_t pcapCaptureGetDropped(void)
+{
+	return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
+
+void pcapCaptureEnd(void)
+{
+	if (!pcapCaptureActive()) {
+		return;
+	}
+	// later frames are ignored, the writer drains the queue before it stops
+	__atomic_store_n(&running, false, __ATOMIC_RELEASE);
+	__atomic_store_n(&stop, true, __ATOMIC_RELEASE);
+	(void)sem_post(&sem);
+	pthread_join(thread, NULL);
+	// the semaphore is kept, the radio thread may still be about to post
+	const uint32_t lost = pcapCaptureGetDropped();
+	if (lost) {
+		logWarning("pcap capture dropped %u frames\n", lost);
+	}
+	fclose(fp);
+	fp = NULL;
+}
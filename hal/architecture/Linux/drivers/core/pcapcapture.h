@@ -0,0 +1,86 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#ifndef pcapcapture_h
+#define pcapcapture_h
+
+#include <stdint.h>
+
+#define PCAP_CAPTURE_LINKTYPE 147	//!< LINKTYPE_USER0, reserved for private use
+#define PCAP_CAPTURE_SNAPLEN 64		//!< Largest radio frame captured, longer frames are truncated
+
+#define PCAP_CAPTURE_RX 0			//!< Frame received from the radio
+#define PCAP_CAPTURE_TX 1			//!< Frame sent to the radio
+
+#define PCAP_CAPTURE_FLAG_ACK 0x01	//!< TX: the radio reported the frame delivered
+#define PCAP_CAPTURE_FLAG_SECONDARY 0x02	//!< Frame of the secondary radio, see MY_GATEWAY_SECONDARY_RFM95
+
+/**
+ * @brief Pseudo header in front of every captured frame, little endian.
+ *
+ * The frame follows as it was on air, i.e. encrypted if the transport is encrypted.
+ */
+typedef struct {
+	uint8_t version;	//!< Pseudo header version, 1
+	uint8_t direction;	//!< PCAP_CAPTURE_RX or PCAP_CAPTURE_TX
+	uint8_t flags;		//!< PCAP_CAPTURE_FLAG_xxx
+	uint8_t peer;		//!< TX: next recipient, RX: 255 (not known to the radio layer)
+	int16_t RSSI;		//!< Signal of the frame, or of the ACK for sent frames
+	int16_t SNR;		//!< SNR, if the radio reports one
+} __attribute__((packed)) pcapCaptureHeader_t;
+
+/**
+ * @brief Open the capture file and start the writer thread.
+ *
+ * The file is written in the classic pcap format with link type PCAP_CAPTURE_LINKTYPE,
+ * an existing file is replaced.
+ * @param file path of the capture file.
+ * @return 0 on success, -1 on error.
+ */
+int pcapCaptureBegin(const char *file);
+/**
+ * @brief Check if frames are captured, to skip collecting them otherwise.
+ */
+bool pcapCaptureActive(void);
+/**
+ * @brief Queue a frame for the capture file.
+ *
+ * Must only be called from one thread, the one driving the radio. Frames are stamped here and
+ * written by the writer thread, they are dropped and counted if it falls behind.
+ * @param direction PCAP_CAPTURE_RX or PCAP_CAPTURE_TX.
+ * @param peer next recipient of sent frames.
+ * @param flags PCAP_CAPTURE_FLAG_xxx.
+ * @param RSSI signal of the frame.
+ * @param SNR SNR of the frame.
+ * @param data frame as on air.
+ * @param length length of the frame.
+ */
+void pcapCapture(uint8_t direction, uint8_t peer, uint8_t flags, int16_t RSSI, int16_t SNR,
+                 const void *data, uint8_t length);
+/**
+ * @brief Number of frames dropped because the writer thread fell behind.
+ */
+uint32_t pcapCaptureGetDropped(void);
+/**
+ * @brief Write the queued frames, stop the writer thread and close the file.
+ */
+void pcapCaptureEnd(void);
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "scheduling.h"
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include "log.h"
+
+int schedulingApply(pthread_t thread, int policy, int priority, int cpu)
+{
+	struct sched_param param;
+	int ret = 0;
+	int err;
+
+	memset(&param, 0, sizeof(param));
+	param.sched_priority = policy == SCHED_OTHER ? 0 : priority;
+	if ((err = pthread_setschedparam(thread, policy, &param)) != 0) {
+		logWarning("Failed to set the scheduler of a thread: %s\n", strerror(err));
+		ret = -1;
+	}
+
+	if (cpu >= 0) {
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(cpu, &cpus);
+		if ((err = pthread_setaffinity_np(thread, sizeof(cpus), &cpus)) != 0) {
+			logWarning("Failed to pin a thread to CPU %d: %s\n", cpu, strerror(err));
+			ret = -1;
+		}
+	}
+
+	return ret;
+}
+
+int schedulingLockMemory(void)
+{
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+		logWarning("Failed to lock the memory: %s\n", strerror(errno));
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,47 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#ifndef scheduling_h
+#define scheduling_h
+
+#include <pthread.h>
+#include <sched.h>
+
+/**
+ * @brief Set the scheduling policy, priority and CPU affinity of a thread.
+ *
+ * Realtime policies and priorities need root or CAP_SYS_NICE, failures are logged and the
+ * thread keeps running with its previous settings.
+ * @param thread thread to change.
+ * @param policy SCHED_OTHER, SCHED_FIFO or SCHED_RR.
+ * @param priority realtime priority, 0 for SCHED_OTHER.
+ * @param cpu CPU to pin the thread to, -1 to leave the affinity unchanged.
+ * @return 0 on success, -1 if a setting could not be applied.
+ */
+int schedulingApply(pthread_t thread, int policy, int priority, int cpu);
+/**
+ * @brief Lock the current and future memory of the process in RAM.
+ *
+ * Avoids page faults, e.g. of swapped out code, delaying the radio handling.
+ * @return 0 on success, -1 on error.
+ */
+int schedulingLockMemory(void);
+
+#endif
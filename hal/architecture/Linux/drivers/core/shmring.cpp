@@ -0,0 +1,281 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "shmring.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include "eventloop.h"
+#include "log.h"
+
+#define SHMRING_MAX_SLOTS (32768u)
+
+typedef struct {
+	uint32_t *head;
+	uint32_t *tail;
+	uint8_t *slots;
+} shmRing_t;
+
+static int listenFd = -1;
+static int peerFd = -1;
+static int memFd = -1;
+static int wakeFd[2] = {-1, -1};	// per ring, signalled by its producer
+static uint8_t *memory = NULL;
+static size_t memorySize = 0;
+static shmRing_t rings[2];
+static uint32_t ringSlots = 0;
+static uint32_t ringSlotSize = 0;
+static bool readArmed = false;		// the wakeup of the controller was reset since the last record
+static char socketPath[sizeof(((struct sockaddr_un *)NULL)->sun_path)];
+
+static void _detach(void)
+{
+	if (peerFd >= 0) {
+		eventLoopRemove(peerFd);
+		close(peerFd);
+		peerFd = -1;
+	}
+	if (wakeFd[SHMRING_FROM_CONTROLLER] >= 0) {
+		eventLoopRemove(wakeFd[SHMRING_FROM_CONTROLLER]);
+	}
+	for (uint8_t i = 0; i < 2; i++) {
+		if (wakeFd[i] >= 0) {
+			close(wakeFd[i]);
+			wakeFd[i] = -1;
+		}
+	}
+	if (memory) {
+		(void)munmap(memory, memorySize);
+		memory = NULL;
+	}
+	if (memFd >= 0) {
+		close(memFd);
+		memFd = -1;
+	}
+}
+
+static size_t _ringSize(void)
+{
+	return 2 * SHMRING_LINE_SIZE + (size_t)ringSlots * ringSlotSize;
+}
+
+// new rings for the controller connected on fd, handed over with the wakeup eventfds
+static bool _attach(int fd)
+{
+	// the header takes the first cache line
+	memorySize = SHMRING_LINE_SIZE + 2 * _ringSize();
+	memFd = memfd_create("mysensors-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (memFd < 0 || ftruncate(memFd, memorySize) < 0) {
+		logError("shared memory ring: %s\n", strerror(errno));
+		return false;
+	}
+	// the controller cannot shrink the memory under the gateway
+	(void)fcntl(memFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+	void *mapped = mmap(NULL, memorySize, PROT_READ | PROT_WRITE, MAP_SHARED, memFd, 0);
+	if (mapped == MAP_FAILED) {
+		logError("shared memory ring mmap: %s\n", strerror(errno));
+		return false;
+	}
+	memory = (uint8_t *)mapped;
+	shmRingHeader_t *header = (shmRingHeader_t *)memory;
+	header->magic = SHMRING_MAGIC;
+	header->version = SHMRING_VERSION;
+	header->slots = (uint16_t)ringSlots;
+	header->slotSize = ringSlotSize;
+	for (uint8_t i = 0; i < 2; i++) {
+		const uint32_t offset = (uint32_t)(SHMRING_LINE_SIZE + i * _ringSize());
+		header->ringOffset[i] = offset;
+		// the indexes start at 0, a new memfd reads as zeroes
+		rings[i].head = (uint32_t *)&memory[offset];
+		rings[i].tail = (uint32_t *)&memory[offset + SHMRING_LINE_SIZE];
+		rings[i].slots = &memory[offset + 2 * SHMRING_LINE_SIZE];
+		wakeFd[i] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		if (wakeFd[i] < 0) {
+			logError("shared memory ring eventfd: %s\n", strerror(errno));
+			return false;
+		}
+	}
+
+	const int fds[3] = {memFd, wakeFd[SHMRING_TO_CONTROLLER], wakeFd[SHMRING_FROM_CONTROLLER]};
+	char control[CMSG_SPACE(sizeof(fds))];
+	uint8_t version = SHMRING_VERSION;
+	struct iovec iov = {&version, sizeof(version)};
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	memset(control, 0, sizeof(control));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+	(void)memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+	if (sendmsg(fd, &msg, MSG_NOSIGNAL) != (ssize_t)sizeof(version)) {
+		logError("shared memory ring handover: %s\n", strerror(errno));
+		return false;
+	}
+	peerFd = fd;
+	readArmed = false;
+	eventLoopAdd(peerFd);
+	eventLoopAdd(wakeFd[SHMRING_FROM_CONTROLLER]);
+	return true;
+}
+
+int shmRingServe(const char *path, uint16_t slots, uint32_t slotSize)
+{
+	struct sockaddr_un addr;
+
+	if (listenFd >= 0 || !slotSize) {
+		return -1;
+	}
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		logError("shared memory ring socket path too long: %s\n", path);
+		return -1;
+	}
+	ringSlots = 2;
+	while (ringSlots < slots && ringSlots < SHMRING_MAX_SLOTS) {
+		ringSlots <<= 1;
+	}
+	ringSlotSize = slotSize;
+	listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (listenFd < 0) {
+		logError("shared memory ring socket: %s\n", strerror(errno));
+		return -1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	(void)strcpy(addr.sun_path, path);
+	// left behind by a previous run
+	(void)unlink(path);
+	if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listenFd, 2) < 0) {
+		logError("shared memory ring bind to %s: %s\n", path, strerror(errno));
+		close(listenFd);
+		listenFd = -1;
+		return -1;
+	}
+	(void)strcpy(socketPath, path);
+	eventLoopAdd(listenFd);
+	logInfo("Shared memory ring served on %s, %u slots of %u bytes\n", path,
+	        (unsigned int)ringSlots, (unsigned int)ringSlotSize);
+	return 0;
+}
+
+void shmRingEnd(void)
+{
+	if (listenFd < 0) {
+		return;
+	}
+	_detach();
+	eventLoopRemove(listenFd);
+	close(listenFd);
+	listenFd = -1;
+	(void)unlink(socketPath);
+}
+
+bool shmRingAccept(void)
+{
+	struct pollfd pfd[2] = {{listenFd, POLLIN, 0}, {peerFd, POLLIN, 0}};
+	bool attached = false;
+
+	if (listenFd < 0 || poll(pfd, 2, 0) <= 0) {
+		return false;
+	}
+	if (pfd[1].revents) {
+		// the controller sends nothing, readable means closed
+		char discard[64];
+		const ssize_t n = recv(peerFd, discard, sizeof(discard), MSG_DONTWAIT);
+		if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+			logNotice("Shared memory controller detached.\n");
+			_detach();
+		}
+	}
+	if (pfd[0].revents & POLLIN) {
+		int fd;
+		while ((fd = accept4(listenFd, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK)) >= 0) {
+			if (peerFd >= 0) {
+				logNotice("Shared memory controller replaced by a new connection.\n");
+				_detach();
+			}
+			if (_attach(fd)) {
+				logNotice("Shared memory controller attached.\n");
+				attached = true;
+			} else {
+				close(fd);
+				_detach();
+				attached = false;
+			}
+		}
+	}
+	return attached;
+}
+
+bool shmRingWrite(const void *data)
+{
+	if (!memory) {
+		return false;
+	}
+	shmRing_t &ring = rings[SHMRING_TO_CONTROLLER];
+	const uint32_t head = *ring.head;
+	if (head - __atomic_load_n(ring.tail, __ATOMIC_ACQUIRE) >= ringSlots) {
+		return false;
+	}
+	(void)memcpy(&ring.slots[(head & (ringSlots - 1)) * ringSlotSize], data, ringSlotSize);
+	__atomic_store_n(ring.head, head + 1, __ATOMIC_RELEASE);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(ring.tail, __ATOMIC_RELAXED) == head) {
+		// the controller took everything before, it may be waiting
+		const uint64_t one = 1;
+		(void)write(wakeFd[SHMRING_TO_CONTROLLER], &one, sizeof(one));
+	}
+	return true;
+}
+
+bool shmRingRead(void *data)
+{
+	if (!memory) {
+		return false;
+	}
+	shmRing_t &ring = rings[SHMRING_FROM_CONTROLLER];
+	const uint32_t tail = *ring.tail;
+	if (__atomic_load_n(ring.head, __ATOMIC_ACQUIRE) == tail) {
+		if (readArmed) {
+			// the controller signals the next record
+			return false;
+		}
+		uint64_t count;
+		(void)read(wakeFd[SHMRING_FROM_CONTROLLER], &count, sizeof(count));
+		readArmed = true;
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if (__atomic_load_n(ring.head, __ATOMIC_ACQUIRE) == tail) {
+			return false;
+		}
+	}
+	(void)memcpy(data, &ring.slots[(tail & (ringSlots - 1)) * ringSlotSize], ringSlotSize);
+	__atomic_store_n(ring.tail, tail + 1, __ATOMIC_RELEASE);
+	readArmed = false;
+	return true;
+}
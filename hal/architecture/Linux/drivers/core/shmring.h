@@ -0,0 +1,99 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#ifndef shmring_h
+#define shmring_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Shared-memory ring link to a controller running on the same host.
+ *
+ * A controller connects to the Unix domain socket passed to shmRingServe() and receives, in one
+ * message with SCM_RIGHTS, three file descriptors: the memfd holding the rings, the eventfd the
+ * gateway signals and the eventfd the controller signals. The connection is kept open for the
+ * session, closing it detaches the controller. Every session gets new rings.
+ *
+ * Layout of the memfd, all fields in host byte order:
+ * - shmRingHeader_t at offset 0,
+ * - ring SHMRING_TO_CONTROLLER and ring SHMRING_FROM_CONTROLLER at the offsets of the header.
+ *
+ * A ring is the head index (written by the producer only) and the tail index (written by the
+ * consumer only), each on its own cache line, followed by the slots. The indexes run freely and
+ * wrap at 2^32, the slot of an index is index % slots. A record is published by writing its slot
+ * and then storing head with release semantics, it is taken by reading the slot and then storing
+ * tail the same way. After publishing, the producer issues a full fence and signals the eventfd
+ * of its direction if tail had caught up with the previous head. The consumer that finds the
+ * ring empty reads the eventfd to reset it, issues a full fence and checks head once more before
+ * it waits.
+ */
+
+#define SHMRING_MAGIC (0x5253594Du)		//!< "MYSR"
+#define SHMRING_VERSION (1u)			//!< Layout version
+#define SHMRING_TO_CONTROLLER (0u)		//!< Ring written by the gateway
+#define SHMRING_FROM_CONTROLLER (1u)		//!< Ring written by the controller
+#define SHMRING_LINE_SIZE (64u)			//!< Distance of head and tail, one cache line
+
+/**
+ * @brief Header at the start of the shared memory.
+ */
+typedef struct {
+	uint32_t magic;		//!< SHMRING_MAGIC
+	uint16_t version;	//!< SHMRING_VERSION
+	uint16_t slots;		//!< Slots per ring, a power of two
+	uint32_t slotSize;	//!< Size of a slot in bytes
+	uint32_t ringOffset[2];	//!< Offset of each ring from the start of the memory
+} shmRingHeader_t;
+
+/**
+ * @brief Listen for a controller on a Unix domain socket.
+ *
+ * A stale socket file at path is removed. One controller is served at a time, a new connection
+ * replaces the previous one. The listening socket and the eventfd of the controller are watched
+ * by the event loop of the calling thread, the other functions are called from that thread.
+ * @param path socket file.
+ * @param slots records per ring, rounded up to a power of two.
+ * @param slotSize size of a record.
+ * @return 0 on success, -1 on error.
+ */
+int shmRingServe(const char *path, uint16_t slots, uint32_t slotSize);
+/**
+ * @brief Detach the controller, close the socket and remove the socket file.
+ */
+void shmRingEnd(void);
+/**
+ * @brief Take pending connections and hangups without blocking.
+ * @return true if a controller attached since the last call.
+ */
+bool shmRingAccept(void);
+/**
+ * @brief Publish a record to the controller.
+ * @param data slotSize bytes.
+ * @return false if no controller is attached or its ring is full.
+ */
+bool shmRingWrite(const void *data);
+/**
+ * @brief Take the next record of the controller.
+ * @param data receives slotSize bytes.
+ * @return false if there is none.
+ */
+bool shmRingRead(void *data);
+
+#endif
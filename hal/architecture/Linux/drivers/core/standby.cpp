@@ -0,0 +1,422 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "standby.h"
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "eventloop.h"
+#include "log.h"
+
+// a record is its type, its length (little endian) and the data
+#define STANDBY_HEADER_SIZE 3
+#define STANDBY_RETRY_MS 100
+// the age of the active gateway and if it watches its peer
+#define STANDBY_ACTIVE_SIZE 5
+#define STANDBY_WATCH_MS 1000
+
+static int listenFd = -1;
+static int peerFd = -1;
+static int stopFd[2] = {-1, -1};
+static pthread_t thread;
+static bool running = false;
+static bool syncPending = false;
+static uint32_t heartbeat = 0;
+static uint32_t activeSince = 0;
+static char *watchHost = NULL;
+static uint16_t watchPort = 0;
+static pthread_t watchThread;
+static bool watching = false;
+static volatile bool yieldPending = false;
+static pthread_mutex_t peerMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t _now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static void _noDelay(int fd)
+{
+	int on = 1;
+	(void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+// with peerMutex held
+static void _drop(const char *reason)
+{
+	logWarning("Standby gateway disconnected: %s\n", reason);
+	close(peerFd);
+	peerFd = -1;
+}
+
+// with peerMutex held
+static void _write(uint8_t type, const void *data, uint16_t length)
+{
+	if (peerFd < 0) {
+		return;
+	}
+	uint8_t header[STANDBY_HEADER_SIZE] = {type, (uint8_t)(length & 0xFF), (uint8_t)(length >> 8)};
+	struct iovec iov[2] = {{header, sizeof(header)}, {(void *)data, length}};
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 2;
+	// a partly written record would corrupt the stream, the standby resyncs instead
+	const ssize_t n = sendmsg(peerFd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+	if (n != (ssize_t)(sizeof(header) + length)) {
+		_drop(n < 0 ? strerror(errno) : "send buffer full");
+	}
+}
+
+static void *_run(void *)
+{
+	uint32_t sentAt = _now();
+
+	for (;;) {
+		struct pollfd pfd[3] = {{stopFd[0], POLLIN, 0}, {listenFd, POLLIN, 0}, {-1, POLLIN, 0}};
+		pthread_mutex_lock(&peerMutex);
+		pfd[2].fd = peerFd;
+		pthread_mutex_unlock(&peerMutex);
+		const uint32_t elapsed = _now() - sentAt;
+		const int timeout = elapsed >= heartbeat ? 0 : (int)(heartbeat - elapsed);
+		if (poll(pfd, 3, timeout) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			logError("standby poll: %s\n", strerror(errno));
+			break;
+		}
+		if (pfd[0].revents) {
+			break;
+		}
+		pthread_mutex_lock(&peerMutex);
+		if (pfd[2].revents && pfd[2].fd == peerFd) {
+			// the standby sends nothing, readable means closed
+			char discard[64];
+			if (recv(peerFd, discard, sizeof(discard), MSG_DONTWAIT) <= 0) {
+				_drop("connection closed");
+			}
+		}
+		if (pfd[1].revents & POLLIN) {
+			const int fd = accept4(listenFd, NULL, NULL, SOCK_CLOEXEC);
+			if (fd >= 0) {
+				if (peerFd >= 0) {
+					_drop("replaced by a new connection");
+				}
+				_noDelay(fd);
+				peerFd = fd;
+				syncPending = true;
+				// first, a watching peer that is active as well decides who yields
+				const uint32_t active = _now() - activeSince;
+				const uint8_t record[STANDBY_ACTIVE_SIZE] = {(uint8_t)(active & 0xFF), (uint8_t)(active >> 8),
+				                                             (uint8_t)(active >> 16), (uint8_t)(active >> 24), watching
+				                                            };
+				_write(STANDBY_ACTIVE, record, sizeof(record));
+				logNotice("Standby gateway connected.\n");
+				// the state is sent by the main loop
+				eventLoopWakeup();
+			}
+		}
+		if (_now() - sentAt >= heartbeat) {
+			_write(STANDBY_HEARTBEAT, NULL, 0);
+			sentAt = _now();
+		}
+		pthread_mutex_unlock(&peerMutex);
+	}
+	return NULL;
+}
+
+int standbyServe(uint16_t port, uint32_t heartbeatMs)
+{
+	struct sockaddr_in addr;
+	int on = 1;
+
+	if (listenFd >= 0) {
+		return -1;
+	}
+	listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (listenFd < 0) {
+		logError("standby socket: %s\n", strerror(errno));
+		return -1;
+	}
+	(void)setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listenFd, 2) < 0) {
+		logError("standby bind to port %u: %s\n", port, strerror(errno));
+		close(listenFd);
+		listenFd = -1;
+		return -1;
+	}
+	if (pipe(stopFd) < 0) {
+		close(listenFd);
+		listenFd = -1;
+		return -1;
+	}
+	heartbeat = heartbeatMs;
+	activeSince = _now();
+	if (pthread_create(&thread, NULL, _run, NULL) != 0) {
+		standbyEnd();
+		return -1;
+	}
+	running = true;
+	logInfo("Standby gateway served on port %u\n", port);
+	return 0;
+}
+
+void standbyEnd(void)
+{
+	if (listenFd < 0) {
+		return;
+	}
+	if (running) {
+		// the byte is never read, it stops both threads
+		const char stop = 0;
+		if (write(stopFd[1], &stop, 1) == 1) {
+			pthread_join(thread, NULL);
+			if (watching) {
+				pthread_join(watchThread, NULL);
+			}
+		}
+		running = false;
+	}
+	watching = false;
+	free(watchHost);
+	watchHost = NULL;
+	close(listenFd);
+	listenFd = -1;
+	pthread_mutex_lock(&peerMutex);
+	if (peerFd >= 0) {
+		close(peerFd);
+		peerFd = -1;
+	}
+	syncPending = false;
+	pthread_mutex_unlock(&peerMutex);
+	for (uint8_t i = 0; i < 2; i++) {
+		if (stopFd[i] >= 0) {
+			close(stopFd[i]);
+			stopFd[i] = -1;
+		}
+	}
+}
+
+bool standbySyncPending(void)
+{
+	pthread_mutex_lock(&peerMutex);
+	const bool pending = syncPending && peerFd >= 0;
+	syncPending = false;
+	pthread_mutex_unlock(&peerMutex);
+	return pending;
+}
+
+void standbySend(uint8_t type, const void *data, uint16_t length)
+{
+	pthread_mutex_lock(&peerMutex);
+	_write(type, data, length);
+	pthread_mutex_unlock(&peerMutex);
+}
+
+// non-blocking connect, an unreachable host must not hold the takeover
+static int _connect(const char *host, uint16_t port, int timeoutMs)
+{
+	struct addrinfo hints;
+	struct addrinfo *result;
+	char service[6];
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	(void)snprintf(service, sizeof(service), "%u", port);
+	if (getaddrinfo(host, service, &hints, &result) != 0) {
+		return -1;
+	}
+	int fd = socket(result->ai_family, result->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK,
+	                result->ai_protocol);
+	if (fd >= 0 && connect(fd, result->ai_addr, result->ai_addrlen) < 0) {
+		struct pollfd pfd = {fd, POLLOUT, 0};
+		int error = errno;
+		socklen_t length = sizeof(error);
+		if (error != EINPROGRESS || poll(&pfd, 1, timeoutMs) <= 0 ||
+		        getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+			close(fd);
+			fd = -1;
+		}
+	}
+	freeaddrinfo(result);
+	if (fd >= 0) {
+		_noDelay(fd);
+	}
+	return fd;
+}
+
+// read exactly length bytes from the non-blocking fd
+static bool _receive(int fd, uint8_t *data, size_t length, int timeoutMs)
+{
+	const uint32_t start = _now();
+	size_t received = 0;
+
+	while (received < length) {
+		const uint32_t elapsed = _now() - start;
+		struct pollfd pfd = {fd, POLLIN, 0};
+		if (elapsed >= (uint32_t)timeoutMs || poll(&pfd, 1, (int)(timeoutMs - elapsed)) <= 0) {
+			return false;
+		}
+		const ssize_t n = recv(fd, &data[received], length - received, 0);
+		if (n == 0 || (n < 0 && errno != EINTR && errno != EAGAIN)) {
+			return false;
+		}
+		if (n > 0) {
+			received += n;
+		}
+	}
+	return true;
+}
+
+static void *_watch(void *)
+{
+	for (;;) {
+		struct pollfd stop = {stopFd[0], POLLIN, 0};
+		const int stopped = poll(&stop, 1, STANDBY_WATCH_MS);
+		if (stopped > 0 || (stopped < 0 && errno != EINTR)) {
+			break;
+		}
+		const int fd = _connect(watchHost, watchPort, STANDBY_WATCH_MS);
+		if (fd < 0) {
+			continue;
+		}
+		uint8_t record[STANDBY_HEADER_SIZE + STANDBY_ACTIVE_SIZE];
+		const bool active = _receive(fd, record, sizeof(record), STANDBY_WATCH_MS) &&
+		                    record[0] == STANDBY_ACTIVE && record[1] == STANDBY_ACTIVE_SIZE && record[2] == 0;
+		close(fd);
+		if (!active) {
+			continue;
+		}
+		// the peer only serves once it is active, both use the radio address
+		const uint32_t peerActive = record[3] | (uint32_t)record[4] << 8 | (uint32_t)record[5] << 16 |
+		                            (uint32_t)record[6] << 24;
+		if (!record[7] || peerActive >= _now() - activeSince) {
+			logError("The peer %s:%u is active as well, yielding to it.\n", watchHost, watchPort);
+			yieldPending = true;
+			eventLoopWakeup();
+			break;
+		}
+		logWarning("The peer %s:%u is active as well, it yields.\n", watchHost, watchPort);
+	}
+	return NULL;
+}
+
+int standbyWatch(const char *host, uint16_t port)
+{
+	if (!running || watching) {
+		return -1;
+	}
+	watchHost = strdup(host);
+	watchPort = port;
+	if (watchHost == NULL) {
+		return -1;
+	}
+	pthread_mutex_lock(&peerMutex);
+	watching = pthread_create(&watchThread, NULL, _watch, NULL) == 0;
+	pthread_mutex_unlock(&peerMutex);
+	if (!watching) {
+		free(watchHost);
+		watchHost = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+bool standbyYield(void)
+{
+	return yieldPending;
+}
+
+void standbyFollow(const char *host, uint16_t port, uint32_t timeoutMs, standbyApply_t apply)
+{
+	static uint8_t buffer[STANDBY_HEADER_SIZE + 65535];
+	size_t length = 0;
+	int fd = -1;
+	uint32_t heardAt = _now();
+
+	logInfo("Following the active gateway %s:%u\n", host, port);
+	for (;;) {
+		const uint32_t silent = _now() - heardAt;
+		if (silent >= timeoutMs) {
+			break;
+		}
+		const int remaining = (int)(timeoutMs - silent);
+		if (fd < 0) {
+			fd = _connect(host, port, remaining);
+			if (fd < 0) {
+				(void)poll(NULL, 0, remaining < STANDBY_RETRY_MS ? remaining : STANDBY_RETRY_MS);
+				continue;
+			}
+			logNotice("Connected to the active gateway %s:%u\n", host, port);
+			length = 0;
+		}
+		struct pollfd pfd = {fd, POLLIN, 0};
+		if (poll(&pfd, 1, remaining) <= 0) {
+			continue;
+		}
+		const ssize_t n = recv(fd, &buffer[length], sizeof(buffer) - length, 0);
+		if (n <= 0) {
+			if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+				continue;
+			}
+			logWarning("Lost the active gateway %s:%u\n", host, port);
+			close(fd);
+			fd = -1;
+			continue;
+		}
+		heardAt = _now();
+		length += n;
+		size_t used = 0;
+		while (length - used >= STANDBY_HEADER_SIZE) {
+			const uint16_t dataLength = buffer[used + 1] | (uint16_t)buffer[used + 2] << 8;
+			if (length - used < STANDBY_HEADER_SIZE + (size_t)dataLength) {
+				break;
+			}
+			if (buffer[used] != STANDBY_HEARTBEAT && buffer[used] != STANDBY_ACTIVE) {
+				apply(buffer[used], &buffer[used + STANDBY_HEADER_SIZE], dataLength);
+			}
+			used += STANDBY_HEADER_SIZE + dataLength;
+		}
+		(void)memmove(buffer, &buffer[used], length - used);
+		length -= used;
+	}
+	if (fd >= 0) {
+		close(fd);
+	}
+	logNotice("No heartbeat of the active gateway for %u ms, taking over.\n", (unsigned int)timeoutMs);
+}
@@ -0,0 +1,95 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#ifndef standby_h
+#define standby_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Record type of the heartbeat, the other types are up to the user of the link.
+ */
+#define STANDBY_HEARTBEAT (0u)
+/**
+ * Record type sent first to every connection, how long the gateway has been active and if it
+ * watches its peer. Taken by the link as well.
+ */
+#define STANDBY_ACTIVE (0xFFu)
+
+/**
+ * @brief Called for every record received from the active gateway.
+ */
+typedef void (*standbyApply_t)(uint8_t type, const uint8_t *data, uint16_t length);
+
+/**
+ * @brief Accept a standby gateway on port and send it heartbeats from a background thread.
+ *
+ * One standby is served at a time, a new connection replaces the previous one.
+ * @param port TCP port to listen on.
+ * @param heartbeatMs interval of the heartbeats.
+ * @return 0 on success, -1 on error.
+ */
+int standbyServe(uint16_t port, uint32_t heartbeatMs);
+/**
+ * @brief Stop the server thread and close the sockets.
+ */
+void standbyEnd(void);
+/**
+ * @brief A standby connected since the last call and needs the complete state.
+ */
+bool standbySyncPending(void);
+/**
+ * @brief Send a record to the standby, can be called from any thread.
+ *
+ * Nothing is sent without a standby. The record is never queued, the standby is dropped if
+ * the socket buffer is full, it gets the complete state again when it reconnects.
+ * @param type record type, not STANDBY_HEARTBEAT.
+ * @param data record data.
+ * @param length length of data.
+ */
+void standbySend(uint8_t type, const void *data, uint16_t length);
+/**
+ * @brief Watch the former active gateway at host:port after taking over from it.
+ *
+ * A background thread connects to it every second. It only serves once it is active, so if it
+ * answers, both gateways use the radio address. This gateway then yields, unless the peer
+ * watches as well and became active later. Requires standbyServe().
+ * @param host former active gateway.
+ * @param port its standbyServe() port.
+ * @return 0 on success, -1 on error.
+ */
+int standbyWatch(const char *host, uint16_t port);
+/**
+ * @brief The watched peer is active as well and this gateway has to stop.
+ */
+bool standbyYield(void);
+/**
+ * @brief Follow the active gateway at host:port until its heartbeat stops.
+ *
+ * Blocks, connects to the active gateway and passes its records to apply. Returns once nothing
+ * was heard from it for timeoutMs, also if it could not be reached from the start.
+ * @param host active gateway.
+ * @param port its standbyServe() port.
+ * @param timeoutMs silence after which the active gateway is considered gone.
+ * @param apply callback for the records.
+ */
+void standbyFollow(const char *host, uint16_t port, uint32_t timeoutMs, standbyApply_t apply);
+
+#endif
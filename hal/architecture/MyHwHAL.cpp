@@ -55,17 +55,168 @@ void hwDebugPrint(const char *fmt, ...)
 #endif
 }
 
+#if defined(MY_DEBUG_TRACE)
+#define MY_DEBUG_TRACE_SYNC (0xFEu)	//!< Record start marker
+#define MY_DEBUG_TRACE_RECORD_SIZE (64u)	//!< Maximum record payload (id, timestamp, arguments)
+
+static uint8_t _hwDebugTraceBuffer[MY_DEBUG_TRACE_BUFFER_SIZE];
+static uint16_t _hwDebugTraceHead = 0;	// write position
+static uint16_t _hwDebugTraceTail = 0;	// read position
+static uint16_t _hwDebugTraceDropped = 0;	// records lost since the last drop record
+
+static uint16_t hwDebugTraceUsed(void)
+{
+	return (uint16_t)((_hwDebugTraceHead + MY_DEBUG_TRACE_BUFFER_SIZE - _hwDebugTraceTail) %
+	                  MY_DEBUG_TRACE_BUFFER_SIZE);
+}
+
+static bool hwDebugTracePut(const uint8_t *record, const uint8_t len)
+{
+	if (hwDebugTraceUsed() + len + 2u >= MY_DEBUG_TRACE_BUFFER_SIZE) {
+		return false;
+	}
+	_hwDebugTraceBuffer[_hwDebugTraceHead] = MY_DEBUG_TRACE_SYNC;
+	_hwDebugTraceHead = (_hwDebugTraceHead + 1) % MY_DEBUG_TRACE_BUFFER_SIZE;
+	_hwDebugTraceBuffer[_hwDebugTraceHead] = len;
+	_hwDebugTraceHead = (_hwDebugTraceHead + 1) % MY_DEBUG_TRACE_BUFFER_SIZE;
+	for (uint8_t i = 0; i < len; i++) {
+		_hwDebugTraceBuffer[_hwDebugTraceHead] = record[i];
+		_hwDebugTraceHead = (_hwDebugTraceHead + 1) % MY_DEBUG_TRACE_BUFFER_SIZE;
+	}
+	return true;
+}
+
+// all supported MCUs are little endian, values are stored in native byte order
+static bool hwDebugTraceAppend(uint8_t *record, uint8_t &len, const void *value,
+                               const uint8_t size)
+{
+	if (len + size > MY_DEBUG_TRACE_RECORD_SIZE) {
+		return false;
+	}
+	(void)memcpy(&record[len], value, size);
+	len += size;
+	return true;
+}
+
+// record layout: id (format string address), 16 bit timestamp, arguments; id 0 reports drops
+void hwDebugTrace(const char *fmt, ...)
+{
+	uint8_t record[MY_DEBUG_TRACE_RECORD_SIZE];
+	uint8_t len = 0;
+	const uint16_t now = (uint16_t)hwMillis();
+	if (_hwDebugTraceDropped) {
+		const char *none = NULL;
+		(void)hwDebugTraceAppend(record, len, &none, sizeof(none));
+		(void)hwDebugTraceAppend(record, len, &now, sizeof(now));
+		(void)hwDebugTraceAppend(record, len, &_hwDebugTraceDropped, sizeof(_hwDebugTraceDropped));
+		if (!hwDebugTracePut(record, len)) {
+			_hwDebugTraceDropped++;
+			return;
+		}
+		_hwDebugTraceDropped = 0;
+		len = 0;
+	}
+	(void)hwDebugTraceAppend(record, len, &fmt, sizeof(fmt));
+	(void)hwDebugTraceAppend(record, len, &now, sizeof(now));
+
+	va_list args;
+	va_start(args, fmt);
+	bool room = true;
+	char c;
+	while (room && (c = pgm_read_byte(fmt++)) != '\0') {
+		if (c != '%') {
+			continue;
+		}
+		uint8_t longs = 0;
+		bool sizeT = false;
+		// skip flags, width, precision and length modifiers
+		while ((c = pgm_read_byte(fmt++)) != '\0') {
+			if (c == 'l') {
+				longs++;
+			} else if (c == 'z') {
+				sizeT = true;
+			} else if (c == '*') {
+				const int width = va_arg(args, int);
+				room = room && hwDebugTraceAppend(record, len, &width, sizeof(width));
+			} else if (!((c >= '0' && c <= '9') || c == '-' || c == '+' || c == ' ' || c == '#' ||
+			             c == '.' || c == 'h')) {
+				break;
+			}
+		}
+		if (c == 'd' || c == 'i' || c == 'u' || c == 'x' || c == 'X' || c == 'o' || c == 'c') {
+			if (longs > 1) {
+				const long long value = va_arg(args, long long);
+				room = room && hwDebugTraceAppend(record, len, &value, sizeof(value));
+			} else if (longs) {
+				const long value = va_arg(args, long);
+				room = room && hwDebugTraceAppend(record, len, &value, sizeof(value));
+			} else if (sizeT) {
+				const size_t value = va_arg(args, size_t);
+				room = room && hwDebugTraceAppend(record, len, &value, sizeof(value));
+			} else {
+				const int value = va_arg(args, int);
+				room = room && hwDebugTraceAppend(record, len, &value, sizeof(value));
+			}
+		} else if (c == 's') {
+			// copy the string including its terminator, truncated to fit
+			const char *str = va_arg(args, const char *);
+			uint8_t chars = 0;
+			while (room && str != NULL && str[chars] != '\0' && chars < MY_DEBUG_TRACE_STRING_SIZE &&
+			        len + 1u < MY_DEBUG_TRACE_RECORD_SIZE) {
+				record[len++] = (uint8_t)str[chars++];
+			}
+			room = room && len < MY_DEBUG_TRACE_RECORD_SIZE;
+			if (room) {
+				record[len++] = '\0';
+			}
+		} else if (c == 'p') {
+			const void *value = va_arg(args, void *);
+			room = room && hwDebugTraceAppend(record, len, &value, sizeof(value));
+		} else if (c == 'e' || c == 'E' || c == 'f' || c == 'g' || c == 'G') {
+			const double value = va_arg(args, double);
+			room = room && hwDebugTraceAppend(record, len, &value, sizeof(value));
+		} else if (c != '%') {
+			// end of format or unknown conversion, the remaining arguments cannot be walked
+			break;
+		}
+	}
+	va_end(args);
+
+	if (!hwDebugTracePut(record, len)) {
+		_hwDebugTraceDropped++;
+	}
+	hwDebugTraceFlush(false);
+}
+
+void hwDebugTraceFlush(const bool all)
+{
+	while (_hwDebugTraceTail != _hwDebugTraceHead) {
+		// devices without a transmit buffer report no room, drain those once half full
+		if (!all && MY_DEBUGDEVICE.availableForWrite() <= 0 &&
+		        hwDebugTraceUsed() < MY_DEBUG_TRACE_BUFFER_SIZE / 2) {
+			return;
+		}
+		(void)MY_DEBUGDEVICE.write(_hwDebugTraceBuffer[_hwDebugTraceTail]);
+		_hwDebugTraceTail = (_hwDebugTraceTail + 1) % MY_DEBUG_TRACE_BUFFER_SIZE;
+	}
+	if (all) {
+		MY_DEBUGDEVICE.flush();
+	}
+}
+#endif
+
 #if defined(DEBUG_OUTPUT_ENABLED)
+#if defined(MY_SHARED_BUFFERS)
+static char (&hwDebugPrintStr)[65] = _coreSharedBuffers.debugHex;
+#else
 static char hwDebugPrintStr[65];
+#endif
+static_assert(sizeof(hwDebugPrintStr) >= 32 * 2 + 1, "hwDebugPrintStr holds 32 bytes in hex");
 static void hwDebugBuf2Str(const uint8_t *buf, size_t sz)
 {
 	if (sz > 32) {
 		sz = 32; //clamp to 32 bytes
 	}
-	for (uint8_t i = 0; i < sz; i++) {
-		hwDebugPrintStr[i * 2] = convertI2H(buf[i] >> 4);
-		hwDebugPrintStr[(i * 2) + 1] = convertI2H(buf[i]);
-	}
-	hwDebugPrintStr[sz * 2] = '\0';
+	convertBuf2Hex(hwDebugPrintStr, buf, sz);
 }
 #endif
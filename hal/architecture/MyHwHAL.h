@@ -44,6 +44,7 @@
 #define hwWatchdogReset() wdt_reset()
 #define hwReboot() wdt_enable(WDTO_15MS); while (1)
 #define hwMillis() millis()
+#define hwMicros() micros()
 
 #define hwDigitalWrite(__pin, __value)
 #define hwDigitalRead(__pin)
@@ -63,6 +64,38 @@ uint8_t hwReadConfig(const int addr);
  */
 //#define MY_HW_HAS_GETENTROPY
 
+/**
+ * @def MY_HW_HAS_FLUSH_CONFIG
+ * @brief Define this, if config writes can be deferred and hwFlushConfig is implemented
+ *
+ * void hwFlushConfig(void);		// commit pending config writes now
+ * void hwFlushConfigIfDue(void);	// commit pending config writes if their delay expired
+ *
+ * Both are empty macros otherwise.
+ */
+//#define MY_HW_HAS_FLUSH_CONFIG
+
+/**
+ * @def MY_HW_HAS_IDLE
+ * @brief Define this, if hwIdle is implemented
+ *
+ * void hwIdle(const uint32_t ms);	// sleep the CPU until the next interrupt, at most ms
+ *
+ * Timers, the radio IRQ and the serial port keep running. An empty macro otherwise.
+ */
+//#define MY_HW_HAS_IDLE
+
+/**
+ * @def MY_HW_HAS_LED_TIMER
+ * @brief Define this, if hwLedTimerStart is implemented
+ *
+ * void hwLedTimerStart(void (*update)(void), const uint16_t periodMs);	// call update from an interrupt every periodMs
+ * void hwLedTimerStop(void);
+ *
+ * The LEDs are updated from doYield() otherwise, see @ref MY_WITH_LEDS_BLINKING_TIMER.
+ */
+//#define MY_HW_HAS_LED_TIMER
+
 /// @brief unique ID
 typedef uint8_t unique_id_t[16];
 
@@ -133,6 +166,18 @@ uint16_t hwFreeMem(void);
  * @param fmt
  */
 void hwDebugPrint(const char *fmt, ...);
+#if defined(MY_DEBUG_TRACE)
+/**
+ * Debug trace, stores a binary record of the format string address and its arguments
+ * @param fmt
+ */
+void hwDebugTrace(const char *fmt, ...);
+/**
+ * Drain buffered trace records to MY_DEBUGDEVICE
+ * @param all true to block until all records are sent, false to write only what fits
+ */
+void hwDebugTraceFlush(const bool all);
+#endif
 /**
  * Convert buffer to hex string
  * @param buf
@@ -172,6 +217,10 @@ static void hwDebugBuf2Str(const uint8_t *buf, size_t sz) __attribute__((unused)
 #ifdef DOXYGEN
 #define MY_CRITICAL_SECTION
 #define MY_HW_HAS_GETENTROPY
+#define MY_HW_HAS_FLUSH_CONFIG
+#define MY_HW_HAS_IDLE
+#define MY_HW_HAS_CYCLE_COUNTER
+#define MY_HW_HAS_SPI_DMA
 #endif  /* DOXYGEN */
 
 #endif // #ifdef MyHw_h
@@ -128,6 +128,38 @@ bool hwInit(void)
 static nrf_ecb_t hwRngData;
 static int8_t hwRndDataReadPos = -1;
 
+#if defined(MY_HW_HAS_CYCLE_COUNTER)
+void hwCycleCounterInit(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+#endif
+
+#if defined(MY_HW_HAS_SPI_DMA)
+void hwSPITransferDMA(const uint8_t *txBuffer, uint8_t *rxBuffer, const uint8_t length)
+{
+	// SPIM0 shares the instance with the SPI0 of the core, swap them for the transfer.
+	// The pin, frequency and mode registers are at the same offsets and stay configured.
+	NRF_SPI0->ENABLE = (SPI_ENABLE_ENABLE_Disabled << SPI_ENABLE_ENABLE_Pos);
+	NRF_SPIM0->ENABLE = (SPIM_ENABLE_ENABLE_Enabled << SPIM_ENABLE_ENABLE_Pos);
+	NRF_SPIM0->ORC = 0xFF;
+	NRF_SPIM0->TXD.PTR = (uint32_t)txBuffer;
+	NRF_SPIM0->TXD.MAXCNT = txBuffer != NULL ? length : 0;
+	NRF_SPIM0->RXD.PTR = (uint32_t)rxBuffer;
+	NRF_SPIM0->RXD.MAXCNT = rxBuffer != NULL ? length : 0;
+	NRF_SPIM0->EVENTS_END = 0;
+	NRF_SPIM0->TASKS_START = 1;
+	while (!NRF_SPIM0->EVENTS_END) {
+		// EasyDMA moves the bytes back to back
+	}
+	NRF_SPIM0->EVENTS_END = 0;
+	NRF_SPIM0->ENABLE = (SPIM_ENABLE_ENABLE_Disabled << SPIM_ENABLE_ENABLE_Pos);
+	NRF_SPI0->ENABLE = (SPI_ENABLE_ENABLE_Enabled << SPI_ENABLE_ENABLE_Pos);
+}
+#endif
+
 void hwRandomNumberInit(void)
 {
 	// Start HWRNG
@@ -232,6 +264,52 @@ void hwReboot(void)
 static volatile bool nrf5_rtc_event_triggered;
 static volatile bool nrf5_pwr_hfclk;
 
+// Start the sleep RTC, its compare interrupt fires after ms
+static void hwSleepTimerStart(uint32_t ms)
+{
+	// Configure RTC
+#ifdef NRF51
+	MY_HW_RTC->POWER = 1;
+#endif
+	// Reset RTC
+	MY_HW_RTC->TASKS_CLEAR = 1;
+
+	// Calculate sleep time and prescaler
+	if (ms<512000) {
+		// prescaler 0, 30.517 μs resolution -> max 512 s sleep
+		MY_HW_RTC->PRESCALER =  0;
+		// Set compare register to 1/30.517 µs to guarantee event triggering
+		// A minimum of 2 ticks must be guaranteed
+		// (1000/32768)<<12 == 125
+		MY_HW_RTC->CC[0] = max(((ms << 12) / 125), 2);
+	} else {
+		// 8 Hz -> max 582.542 hours sleep.
+		MY_HW_RTC->PRESCALER = 4095;
+		// Set compare register to 1/125ms
+		// A minimum of 2 ticks must be guaranteed
+		MY_HW_RTC->CC[0] = max((ms / 125), 2);
+	}
+
+	MY_HW_RTC->INTENSET = RTC_INTENSET_COMPARE0_Msk;
+	MY_HW_RTC->EVTENSET = RTC_EVTENSET_COMPARE0_Msk;
+	MY_HW_RTC->EVENTS_COMPARE[0] = 0;
+	MY_HW_RTC->TASKS_START = 1;
+	NVIC_SetPriority(MY_HW_RTC_IRQN, 15);
+	NVIC_ClearPendingIRQ(MY_HW_RTC_IRQN);
+	NVIC_EnableIRQ(MY_HW_RTC_IRQN);
+}
+
+static void hwSleepTimerStop(void)
+{
+#ifdef NRF51
+	MY_HW_RTC->POWER = 0;
+#endif
+	MY_HW_RTC->INTENCLR = RTC_INTENSET_COMPARE0_Msk;
+	MY_HW_RTC->EVTENCLR = RTC_EVTENSET_COMPARE0_Msk;
+	MY_HW_RTC->TASKS_STOP = 1;
+	NVIC_DisableIRQ(MY_HW_RTC_IRQN);
+}
+
 void hwSleepPrepare(uint32_t ms)
 {
 	// Enable low power sleep mode
@@ -241,36 +319,7 @@ void hwSleepPrepare(uint32_t ms)
 	nrf5_rtc_event_triggered = false;
 
 	if (ms > 0) {
-		// Configure RTC
-#ifdef NRF51
-		MY_HW_RTC->POWER = 1;
-#endif
-		// Reset RTC
-		MY_HW_RTC->TASKS_CLEAR = 1;
-
-		// Calculate sleep time and prescaler
-		if (ms<512000) {
-			// prescaler 0, 30.517 μs resolution -> max 512 s sleep
-			MY_HW_RTC->PRESCALER =  0;
-			// Set compare register to 1/30.517 µs to guarantee event triggering
-			// A minimum of 2 ticks must be guaranteed
-			// (1000/32768)<<12 == 125
-			MY_HW_RTC->CC[0] = max(((ms << 12) / 125), 2);
-		} else {
-			// 8 Hz -> max 582.542 hours sleep.
-			MY_HW_RTC->PRESCALER = 4095;
-			// Set compare register to 1/125ms
-			// A minimum of 2 ticks must be guaranteed
-			MY_HW_RTC->CC[0] = max((ms / 125), 2);
-		}
-
-		MY_HW_RTC->INTENSET = RTC_INTENSET_COMPARE0_Msk;
-		MY_HW_RTC->EVTENSET = RTC_EVTENSET_COMPARE0_Msk;
-		MY_HW_RTC->EVENTS_COMPARE[0] = 0;
-		MY_HW_RTC->TASKS_START = 1;
-		NVIC_SetPriority(MY_HW_RTC_IRQN, 15);
-		NVIC_ClearPendingIRQ(MY_HW_RTC_IRQN);
-		NVIC_EnableIRQ(MY_HW_RTC_IRQN);
+		hwSleepTimerStart(ms);
 	} else {
 		NRF_RTC1->TASKS_STOP = 1;
 	}
@@ -307,13 +356,7 @@ void hwSleepEnd(uint32_t ms)
 
 	if (ms > 0) {
 		// Stop RTC
-#ifdef NRF51
-		MY_HW_RTC->POWER = 0;
-#endif
-		MY_HW_RTC->INTENCLR = RTC_INTENSET_COMPARE0_Msk;
-		MY_HW_RTC->EVTENCLR = RTC_EVTENSET_COMPARE0_Msk;
-		MY_HW_RTC->TASKS_STOP = 1;
-		NVIC_DisableIRQ(MY_HW_RTC_IRQN);
+		hwSleepTimerStop();
 	} else {
 		// Start Arduino RTC for millis()
 		NRF_RTC1->TASKS_START = 1;
@@ -333,6 +376,15 @@ inline void hwWaitForInterrupt(void)
 	__WFI();
 }
 
+void hwIdle(const uint32_t ms)
+{
+	// millis() does not interrupt regularly, the sleep RTC bounds the idle time
+	nrf5_rtc_event_triggered = false;
+	hwSleepTimerStart(ms);
+	hwWaitForInterrupt();
+	hwSleepTimerStop();
+}
+
 // Sleep in System ON mode
 inline void hwSleep(void)
 {
@@ -114,6 +114,7 @@
 #define hwDigitalRead(__pin) digitalRead(__pin)
 #define hwPinMode(__pin, __value) nrf5_pinMode(__pin, __value)
 #define hwMillis() millis()
+#define hwMicros() micros()
 // TODO: Can nrf5 determine time slept?
 #define hwGetSleepRemaining() (0ul)
 
@@ -127,12 +128,25 @@ uint8_t hwReadConfig(const int addr);
 void hwRandomNumberInit(void);
 ssize_t hwGetentropy(void *__buffer, size_t __length);
 #define MY_HW_HAS_GETENTROPY
+void hwIdle(const uint32_t ms);
+#define MY_HW_HAS_IDLE
+#if defined(DWT)
+// Cortex-M4 DWT cycle counter, not available on nRF51
+void hwCycleCounterInit(void);
+#define hwCycles() (DWT->CYCCNT)
+#define MY_HW_HAS_CYCLE_COUNTER
+#endif
 
 // SOFTSPI
 #ifdef MY_SOFTSPI
 #error Soft SPI is not available on this architecture!
 #endif
 #define hwSPI SPI //!< hwSPI
+#if defined(MY_SPI_DMA) && !defined(NRF51)
+// SPIM EasyDMA, not available on nRF51
+void hwSPITransferDMA(const uint8_t *txBuffer, uint8_t *rxBuffer, const uint8_t length);
+#define MY_HW_HAS_SPI_DMA
+#endif
 
 
 /**
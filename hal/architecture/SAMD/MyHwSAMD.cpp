@@ -135,6 +135,115 @@ bool hwUniqueID(unique_id_t *uniqueID)
 	return true;
 }
 
+#if defined(MY_HW_HAS_SPI_DMA)
+// DMAC channel 0 reads, channel 1 writes the SERCOM of hwSPI
+#define SAMD_SPI_DMA_RX_CHANNEL (0u)
+#define SAMD_SPI_DMA_TX_CHANNEL (1u)
+
+static DmacDescriptor hwSPIDMADescriptor[2] __attribute__((aligned(16)));
+static DmacDescriptor hwSPIDMAWriteback[2] __attribute__((aligned(16)));
+static Sercom *hwSPIDMASercom = NULL;
+static uint8_t hwSPIDMARxTrigger;
+static uint8_t hwSPIDMATxTrigger;
+
+static bool hwSPIDMAInit(void)
+{
+#define SAMD_SPI_DMA_SERCOM(n) \
+	if (&PERIPH_SPI == &sercom##n) { \
+		hwSPIDMASercom = SERCOM##n; \
+		hwSPIDMARxTrigger = SERCOM##n##_DMAC_ID_RX; \
+		hwSPIDMATxTrigger = SERCOM##n##_DMAC_ID_TX; \
+	}
+#if defined(SERCOM0)
+	SAMD_SPI_DMA_SERCOM(0)
+#endif
+#if defined(SERCOM1)
+	SAMD_SPI_DMA_SERCOM(1)
+#endif
+#if defined(SERCOM2)
+	SAMD_SPI_DMA_SERCOM(2)
+#endif
+#if defined(SERCOM3)
+	SAMD_SPI_DMA_SERCOM(3)
+#endif
+#if defined(SERCOM4)
+	SAMD_SPI_DMA_SERCOM(4)
+#endif
+#if defined(SERCOM5)
+	SAMD_SPI_DMA_SERCOM(5)
+#endif
+#undef SAMD_SPI_DMA_SERCOM
+	if (hwSPIDMASercom == NULL) {
+		return false;
+	}
+	PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+	PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+	DMAC->CTRL.reg &= ~DMAC_CTRL_DMAENABLE;
+	DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+	DMAC->BASEADDR.reg = (uint32_t)hwSPIDMADescriptor;
+	DMAC->WRBADDR.reg = (uint32_t)hwSPIDMAWriteback;
+	DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+	return true;
+}
+
+static void hwSPIDMAChannel(const uint8_t channel, const uint8_t trigger, volatile void *source,
+                            volatile void *destination, const uint16_t increment, const uint8_t length)
+{
+	DmacDescriptor *descriptor = &hwSPIDMADescriptor[channel];
+	descriptor->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE | increment;
+	descriptor->BTCNT.reg = length;
+	descriptor->SRCADDR.reg = (uint32_t)source;
+	descriptor->DSTADDR.reg = (uint32_t)destination;
+	descriptor->DESCADDR.reg = 0;
+	DMAC->CHID.reg = DMAC_CHID_ID(channel);
+	DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+	DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+	DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0) | DMAC_CHCTRLB_TRIGSRC(trigger) |
+	                    DMAC_CHCTRLB_TRIGACT_BEAT;
+	DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+	DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+}
+
+void hwSPITransferDMA(const uint8_t *txBuffer, uint8_t *rxBuffer, const uint8_t length)
+{
+	static uint8_t dummy;
+	if (hwSPIDMASercom == NULL && !hwSPIDMAInit()) {
+		// hwSPI is not on a SERCOM, fall back to the CPU
+		for (uint8_t i = 0; i < length; i++) {
+			const uint8_t data = hwSPI.transfer(txBuffer != NULL ? txBuffer[i] : 0xFF);
+			if (rxBuffer != NULL) {
+				rxBuffer[i] = data;
+			}
+		}
+		return;
+	}
+	volatile void *data = &hwSPIDMASercom->SPI.DATA.reg;
+	while (hwSPIDMASercom->SPI.INTFLAG.bit.RXC) {
+		// drop what the CPU left in the receiver
+		(void)hwSPIDMASercom->SPI.DATA.reg;
+	}
+	// an incrementing address is the end of the block, the dummy byte is not incremented
+	if (rxBuffer != NULL) {
+		hwSPIDMAChannel(SAMD_SPI_DMA_RX_CHANNEL, hwSPIDMARxTrigger, data, rxBuffer + length,
+		                DMAC_BTCTRL_DSTINC, length);
+	} else {
+		hwSPIDMAChannel(SAMD_SPI_DMA_RX_CHANNEL, hwSPIDMARxTrigger, data, &dummy, 0, length);
+	}
+	if (txBuffer != NULL) {
+		hwSPIDMAChannel(SAMD_SPI_DMA_TX_CHANNEL, hwSPIDMATxTrigger, (uint8_t *)txBuffer + length,
+		                data, DMAC_BTCTRL_SRCINC, length);
+	} else {
+		dummy = 0xFF;
+		hwSPIDMAChannel(SAMD_SPI_DMA_TX_CHANNEL, hwSPIDMATxTrigger, &dummy, data, 0, length);
+	}
+	// the receiver completes last
+	DMAC->CHID.reg = DMAC_CHID_ID(SAMD_SPI_DMA_RX_CHANNEL);
+	while (!(DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL)) {
+	}
+	DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+}
+#endif
+
 // Wait for synchronization of registers between the clock domains
 static __inline__ void syncADC() __attribute__((always_inline, unused));
 static void syncADC()
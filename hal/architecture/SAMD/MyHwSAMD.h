@@ -62,6 +62,7 @@ extEEPROM eep(MY_EXT_EEPROM_SIZE, 1, MY_EXT_EEPROM_PAGE_SIZE,
 #define hwDigitalRead(__pin) digitalRead(__pin)
 #define hwPinMode(__pin, __value) pinMode(__pin, __value)
 #define hwMillis() millis()
+#define hwMicros() micros()
 #define hwRandomNumberInit() randomSeed(analogRead(MY_SIGNING_SOFT_RANDOMSEED_PIN))
 #define hwGetSleepRemaining() (0ul)
 
@@ -72,12 +73,19 @@ void hwReadConfigBlock(void *buf, void *addr, size_t length);
 void hwWriteConfigBlock(void *buf, void *addr, size_t length);
 void hwWriteConfig(const int addr, uint8_t value);
 uint8_t hwReadConfig(const int addr);
+// SysTick interrupts every millisecond, the CPU sleeps at most that long
+#define hwIdle(__ms) __asm__ __volatile__("wfi")
+#define MY_HW_HAS_IDLE
 
 // SOFTSPI
 #ifdef MY_SOFTSPI
 #error Soft SPI is not available on this architecture!
 #endif
 #define hwSPI SPI //!< hwSPI
+#if defined(MY_SPI_DMA)
+void hwSPITransferDMA(const uint8_t *txBuffer, uint8_t *rxBuffer, const uint8_t length);
+#define MY_HW_HAS_SPI_DMA
+#endif
 
 
 /**
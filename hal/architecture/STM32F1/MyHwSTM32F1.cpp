@@ -50,6 +50,10 @@ bool hwInit(void)
 	while (!MY_SERIALDEVICE) {}
 #endif
 #endif
+#if defined(MY_STM32F1_NVRAM)
+	// NVRAM allocates its virtual page on first access
+	return true;
+#else
 	if (EEPROM.init() == EEPROM_OK) {
 		uint16 cnt;
 		EEPROM.count(&cnt);
@@ -60,8 +64,34 @@ bool hwInit(void)
 		return true;
 	}
 	return false;
+#endif
+}
+
+#if defined(MY_STM32F1_NVRAM)
+void hwReadConfigBlock(void *buf, void *addr, size_t length)
+{
+	uint8_t *dst = static_cast<uint8_t *>(buf);
+	const int offs = reinterpret_cast<int>(addr);
+	(void)NVRAM.read_block(dst, offs, length);
+}
+
+void hwWriteConfigBlock(void *buf, void *addr, size_t length)
+{
+	uint8_t *src = static_cast<uint8_t *>(buf);
+	const int offs = reinterpret_cast<int>(addr);
+	(void)NVRAM.write_block(src, offs, length);
+}
+
+uint8_t hwReadConfig(const int addr)
+{
+	return NVRAM.read(addr);
 }
 
+void hwWriteConfig(const int addr, uint8_t value)
+{
+	(void)NVRAM.write(addr, value);
+}
+#else
 void hwReadConfigBlock(void *buf, void *addr, size_t length)
 {
 	uint8_t *dst = static_cast<uint8_t *>(buf);
@@ -91,6 +121,7 @@ void hwWriteConfig(const int addr, uint8_t value)
 {
 	hwWriteConfigBlock(&value, reinterpret_cast<void *>(addr), 1);
 }
+#endif
 
 int8_t hwSleep(uint32_t ms)
 {
@@ -122,6 +153,26 @@ int8_t hwSleep(const uint8_t interrupt1, const uint8_t mode1, const uint8_t inte
 }
 
 
+void hwCycleCounterInit(void)
+{
+	// DEMCR.TRCENA, then DWT_CTRL.CYCCNTENA
+	*(volatile uint32_t *)0xE000EDFCu |= (1ul << 24);
+	*(volatile uint32_t *)0xE0001004u = 0;
+	*(volatile uint32_t *)0xE0001000u |= 1ul;
+}
+
+#if defined(MY_HW_HAS_SPI_DMA)
+void hwSPITransferDMA(const uint8_t *txBuffer, uint8_t *rxBuffer, const uint8_t length)
+{
+	// blocking, CS is held by the caller. The core sends 0xFF if there is nothing to transmit
+	if (rxBuffer == NULL) {
+		(void)hwSPI.dmaSend((void *)txBuffer, length);
+	} else {
+		(void)hwSPI.dmaTransfer((void *)txBuffer, rxBuffer, length);
+	}
+}
+#endif
+
 void hwRandomNumberInit(void)
 {
 	// use internal temperature sensor as noise source
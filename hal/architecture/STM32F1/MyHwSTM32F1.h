@@ -22,7 +22,16 @@
 
 #include <libmaple/iwdg.h>
 #include <itoa.h>
+#if defined(MY_STM32F1_NVRAM)
+// use the top 16k of the flash memory
+#ifndef NVM_VIRTUAL_PAGE_COUNT
+#define NVM_VIRTUAL_PAGE_COUNT 4
+#endif
+#include "drivers/NVM/NVRAM.cpp"
+#include "drivers/NVM/VirtualPage.cpp"
+#else
 #include <EEPROM.h>
+#endif
 #include <SPI.h>
 
 #ifdef __cplusplus
@@ -69,6 +78,7 @@
 #define hwWatchdogReset() iwdg_feed()
 #define hwReboot() nvic_sys_reset()
 #define hwMillis() millis()
+#define hwMicros() micros()
 #define hwGetSleepRemaining() (0ul)
 
 extern void serialEventRun(void) __attribute__((weak));
@@ -78,12 +88,23 @@ void hwReadConfigBlock(void *buf, void *addr, size_t length);
 void hwWriteConfigBlock(void *buf, void *addr, size_t length);
 void hwWriteConfig(const int addr, uint8_t value);
 uint8_t hwReadConfig(const int addr);
+// SysTick interrupts every millisecond, the CPU sleeps at most that long
+#define hwIdle(__ms) __asm__ __volatile__("wfi")
+#define MY_HW_HAS_IDLE
+// Cortex-M3 DWT cycle counter, libmaple has no CMSIS definitions for it
+void hwCycleCounterInit(void);
+#define hwCycles() (*(volatile uint32_t *)0xE0001004u)
+#define MY_HW_HAS_CYCLE_COUNTER
 
 // SOFTSPI
 #ifdef MY_SOFTSPI
 #error Soft SPI is not available on this architecture!
 #endif
 #define hwSPI SPI //!< hwSPI
+#if defined(MY_SPI_DMA)
+void hwSPITransferDMA(const uint8_t *txBuffer, uint8_t *rxBuffer, const uint8_t length);
+#define MY_HW_HAS_SPI_DMA
+#endif
 
 
 #ifndef DOXYGEN
@@ -0,0 +1,123 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * STM32F1 backend of the FlashClass used by drivers/NVM, based on the flash
+ * routines of the EEPROM emulation library of the STM32F1 core.
+ */
+#include "drivers/NVM/Flash.h"
+#include <flash_stm32.h>
+
+FlashClass Flash;
+
+// Start of the flash memory
+#define STM32F1_FLASH_BASE (0x08000000ul)
+// Flash size in kb, set by the factory
+#define STM32F1_FLASH_SIZE_KB (*(volatile uint16_t *)0x1FFFF7E0)
+
+uint32_t FlashClass::page_size() const
+{
+	return (uint32_t)1 << page_size_bits();
+}
+
+uint8_t FlashClass::page_size_bits() const
+{
+	// high density devices use 2k pages
+	return (STM32F1_FLASH_SIZE_KB > 128) ? 11 : 10;
+}
+
+uint32_t FlashClass::page_count() const
+{
+	return ((uint32_t)STM32F1_FLASH_SIZE_KB << 10) >> page_size_bits();
+}
+
+uint32_t FlashClass::specified_erase_cycles() const
+{
+	return FLASH_ERASE_CYCLES;
+}
+
+uint32_t *FlashClass::page_address(size_t page)
+{
+	return (uint32_t *)(STM32F1_FLASH_BASE + (page << page_size_bits()));
+}
+
+uint32_t *FlashClass::top_app_page_address()
+{
+	// Return flash end
+	return (uint32_t *)(STM32F1_FLASH_BASE + ((uint32_t)STM32F1_FLASH_SIZE_KB << 10));
+}
+
+void FlashClass::erase(uint32_t *address, size_t size)
+{
+	size_t end_address = (size_t)address + size;
+
+	// align address
+	address = (uint32_t *)((size_t)address & ~(size_t)(page_size() - 1));
+
+	// Wrong parameters?
+	if ((size_t)address >= end_address) {
+		return;
+	}
+
+	FLASH_Unlock();
+	// Erase page(s), FLASH_ErasePage() waits until the controller is ready
+	while ((size_t)address < end_address) {
+		(void)FLASH_ErasePage((uint32)address);
+		address = (uint32_t *)((size_t)address + page_size());
+	}
+	FLASH_Lock();
+}
+
+void FlashClass::erase_all()
+{
+	// There is no mass erase from code running in flash, erase page by page
+	erase(page_address(0), (size_t)page_count() << page_size_bits());
+}
+
+void FlashClass::write(uint32_t *address, uint32_t value)
+{
+	// Compare word
+	if (*address != value) {
+		write_block(address, &value, 1);
+	}
+}
+
+void FlashClass::write_block(uint32_t *dst_address, uint32_t *src_address,
+                             uint16_t word_count)
+{
+	FLASH_Unlock();
+	while (word_count > 0) {
+		// The controller programs half words, skip the unchanged ones
+		uint16_t *dst = (uint16_t *)dst_address;
+		const uint32_t value = *src_address;
+		if (dst[0] != (uint16_t)value) {
+			(void)FLASH_ProgramHalfWord((uint32)&dst[0], (uint16_t)value);
+		}
+		if (dst[1] != (uint16_t)(value >> 16)) {
+			(void)FLASH_ProgramHalfWord((uint32)&dst[1], (uint16_t)(value >> 16));
+		}
+		word_count--;
+		dst_address++;
+		src_address++;
+	}
+	FLASH_Lock();
+}
+
+void FlashClass::wait_for_ready()
+{
+	// FLASH_ErasePage() and FLASH_ProgramHalfWord() return when the operation finished
+}
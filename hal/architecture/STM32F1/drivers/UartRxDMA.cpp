@@ -0,0 +1,162 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "UartRxDMA.h"
+
+// Receivers of USART1..3 by DMA1 channel 5, 6 and 3
+static UartRxDMA *_uartRxDMA[3] = { NULL, NULL, NULL };
+
+static void _uartRxDMA1ISR(void)
+{
+	_uartRxDMA[0]->lap();
+}
+
+static void _uartRxDMA2ISR(void)
+{
+	_uartRxDMA[1]->lap();
+}
+
+static void _uartRxDMA3ISR(void)
+{
+	_uartRxDMA[2]->lap();
+}
+
+UartRxDMA::UartRxDMA(HardwareSerial &serial) : _serial(serial), _dev(NULL), _channel(DMA_CH5),
+	_laps(0), _consumed(0), _highWater(0), _overruns(0)
+{
+}
+
+bool UartRxDMA::begin(uint32_t baud)
+{
+	uint8_t index;
+	voidFuncPtr handler;
+	_serial.begin(baud);
+	_dev = _serial.c_dev();
+	if (_dev == USART1) {
+		index = 0;
+		_channel = DMA_CH5;
+		handler = _uartRxDMA1ISR;
+	} else if (_dev == USART2) {
+		index = 1;
+		_channel = DMA_CH6;
+		handler = _uartRxDMA2ISR;
+	} else if (_dev == USART3) {
+		index = 2;
+		_channel = DMA_CH3;
+		handler = _uartRxDMA3ISR;
+	} else {
+		return false;
+	}
+	_uartRxDMA[index] = this;
+	_laps = 0;
+	_consumed = 0;
+
+	dma_init(DMA1);
+	dma_disable(DMA1, _channel);
+	// the DMA reads the data register, the RX interrupt of the core must not compete
+	_dev->regs->CR1 &= ~USART_CR1_RXNEIE;
+	dma_setup_transfer(DMA1, _channel, &_dev->regs->DR, DMA_SIZE_8BITS, _buffer, DMA_SIZE_8BITS,
+	                   DMA_MINC_MODE | DMA_CIRC_MODE | DMA_TRNS_CMPLT);
+	dma_set_num_transfers(DMA1, _channel, MY_UART_DMA_RX_BUFFER_SIZE);
+	dma_set_priority(DMA1, _channel, DMA_PRIORITY_HIGH);
+	dma_attach_interrupt(DMA1, _channel, handler);
+	dma_enable(DMA1, _channel);
+	_dev->regs->CR3 |= USART_CR3_DMAR;
+	return true;
+}
+
+void UartRxDMA::end(void)
+{
+	if (_dev == NULL) {
+		return;
+	}
+	_dev->regs->CR3 &= ~USART_CR3_DMAR;
+	dma_disable(DMA1, _channel);
+	dma_detach_interrupt(DMA1, _channel);
+	_dev->regs->CR1 |= USART_CR1_RXNEIE;
+	_dev = NULL;
+}
+
+uint32_t UartRxDMA::_received(void)
+{
+	uint32_t laps;
+	uint16_t remaining;
+	do {
+		laps = _laps;
+		remaining = dma_channel_regs(DMA1, _channel)->CNDTR;
+	} while (laps != _laps);
+	uint32_t received = laps * MY_UART_DMA_RX_BUFFER_SIZE + (MY_UART_DMA_RX_BUFFER_SIZE - remaining);
+	if ((int32_t)(received - _consumed) < 0) {
+		// wrapped, but the interrupt did not count the lap yet
+		received += MY_UART_DMA_RX_BUFFER_SIZE;
+	}
+	return received;
+}
+
+int UartRxDMA::available(void)
+{
+	if (_dev == NULL) {
+		return 0;
+	}
+	const uint32_t received = _received();
+	uint32_t waiting = received - _consumed;
+	if (waiting > MY_UART_DMA_RX_BUFFER_SIZE) {
+		// the reader was lapped, what is left is a mix of two rounds
+		_overruns++;
+		_consumed = received;
+		waiting = 0;
+	}
+	if (waiting > _highWater) {
+		_highWater = (uint16_t)waiting;
+	}
+	return (int)waiting;
+}
+
+int UartRxDMA::read(void)
+{
+	if (available() == 0) {
+		return -1;
+	}
+	const uint8_t c = _buffer[_consumed % MY_UART_DMA_RX_BUFFER_SIZE];
+	_consumed++;
+	return c;
+}
+
+int UartRxDMA::peek(void)
+{
+	if (available() == 0) {
+		return -1;
+	}
+	return _buffer[_consumed % MY_UART_DMA_RX_BUFFER_SIZE];
+}
+
+void UartRxDMA::flush(void)
+{
+	_serial.flush();
+}
+
+size_t UartRxDMA::write(uint8_t c)
+{
+	return _serial.write(c);
+}
+
+size_t UartRxDMA::write(const uint8_t *buffer, size_t size)
+{
+	return _serial.write(buffer, size);
+}
@@ -0,0 +1,92 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * UART receiver for the STM32F1: the DMA writes every byte into a circular buffer, the CPU
+ * is not involved until the buffer is read. Transmission stays with the HardwareSerial.
+ */
+
+#ifndef UartRxDMA_h
+#define UartRxDMA_h
+
+#include <Arduino.h>
+#include <libmaple/dma.h>
+#include <libmaple/usart.h>
+
+/**
+ * @brief Stream on a HardwareSerial (Serial1..Serial3) receiving by DMA.
+ */
+class UartRxDMA : public Stream
+{
+public:
+	/**
+	 * @brief Constructor
+	 * @param serial USART to receive from, USART1..USART3
+	 */
+	explicit UartRxDMA(HardwareSerial &serial);
+	/**
+	 * @brief Start the serial port and the DMA channel of its receiver.
+	 * @param baud Baud rate
+	 * @return False if the USART has no DMA channel
+	 */
+	bool begin(uint32_t baud);
+	/**
+	 * @brief Stop the DMA, the serial port receives by interrupt again.
+	 */
+	void end(void);
+	virtual int available(void);
+	virtual int read(void);
+	virtual int peek(void);
+	virtual void flush(void);
+	virtual size_t write(uint8_t c);
+	virtual size_t write(const uint8_t *buffer, size_t size);
+	using Print::write;
+	/**
+	 * @brief Most bytes waiting in the buffer so far.
+	 */
+	uint16_t highWater(void) const
+	{
+		return _highWater;
+	}
+	/**
+	 * @brief Number of times the DMA lapped the reader, the buffer content was lost.
+	 */
+	uint32_t overruns(void) const
+	{
+		return _overruns;
+	}
+	/**
+	 * @brief Count a completed lap of the DMA, called from its interrupt.
+	 */
+	void lap(void)
+	{
+		_laps++;
+	}
+
+private:
+	uint32_t _received(void);
+	HardwareSerial &_serial;
+	usart_dev *_dev;
+	dma_channel _channel;
+	volatile uint32_t _laps;
+	uint32_t _consumed;
+	uint16_t _highWater;
+	uint32_t _overruns;
+	uint8_t _buffer[MY_UART_DMA_RX_BUFFER_SIZE];
+};
+
+#endif
@@ -160,6 +160,15 @@ ssize_t hwGetentropy(void *__buffer, const size_t __length)
 }
 #endif
 
+#if defined(MY_HW_HAS_CYCLE_COUNTER)
+void hwCycleCounterInit(void)
+{
+	ARM_DEMCR |= ARM_DEMCR_TRCENA;
+	ARM_DWT_CYCCNT = 0;
+	ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+}
+#endif
+
 void hwRandomNumberInit(void)
 {
 #if defined(MY_HW_HAS_GETENTROPY)
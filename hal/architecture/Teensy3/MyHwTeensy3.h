@@ -62,6 +62,7 @@
 #define hwDigitalRead(__pin) digitalReadFast(__pin)
 #define hwPinMode(__pin, __value) pinMode(__pin, __value)
 #define hwMillis() millis()
+#define hwMicros() micros()
 #define hwGetSleepRemaining() (0ul)
 
 void hwRandomNumberInit(void);
@@ -86,6 +87,16 @@ void hwReboot(void);
 #define MY_HW_HAS_GETENTROPY
 #endif
 
+// SysTick interrupts every millisecond, the CPU sleeps at most that long
+#define hwIdle(__ms) __asm__ __volatile__("wfi")
+#define MY_HW_HAS_IDLE
+#if defined(KINETISK)
+// Cortex-M4 DWT cycle counter, not available on the Cortex-M0+ Teensy LC
+void hwCycleCounterInit(void);
+#define hwCycles() (ARM_DWT_CYCCNT)
+#define MY_HW_HAS_CYCLE_COUNTER
+#endif
+
 #define MY_CRITICAL_SECTION ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 
 #endif
@@ -33,6 +33,18 @@ void SHA256HMAC(uint8_t *dest, const uint8_t *key, size_t keyLength, const uint8
 	hmac_sha256(dest, key, keyLength << 3, data, dataLength << 3);
 }
 
+hmac_sha256_ctx_t hmac_ctx;
+
+void SHA256HMACSetKey(const uint8_t *key, size_t keyLength)
+{
+	hmac_sha256_init(&hmac_ctx, key, keyLength << 3);
+}
+
+void SHA256HMACWithKey(uint8_t *dest, const uint8_t *data, size_t dataLength)
+{
+	hmac_sha256_mac(dest, &hmac_ctx, data, dataLength << 3);
+}
+
 
 // AES
 AES_ctx aes_ctx;
@@ -54,4 +66,10 @@ void AES128CBCDecrypt(uint8_t *iv, uint8_t *buffer, const size_t dataLength)
 	AES_CBC_decrypt_buffer(&aes_ctx, buffer, dataLength);
 }
 
+void AES128CTRCrypt(const uint8_t *iv, uint8_t *buffer, const size_t dataLength)
+{
+	AES_ctx_set_iv(&aes_ctx, iv);
+	AES_CTR_xcrypt_buffer(&aes_ctx, buffer, dataLength);
+}
+
 
@@ -22,6 +22,8 @@
 #define MyCryptoGeneric_h
 
 #include "hal/crypto/MyCryptoHAL.h"
+// CTR mode is used for transport encryption
+#define CTR 1
 #include "hal/crypto/AVR/drivers/AES/aes.cpp"
 #include "hal/crypto/AVR/drivers/SHA256/sha256.cpp"
 #include "hal/crypto/AVR/drivers/HMAC_SHA256/hmac_sha256.cpp"
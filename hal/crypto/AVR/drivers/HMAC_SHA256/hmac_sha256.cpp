@@ -23,10 +23,8 @@
 /*
 * all lengths in bits!
 */
-void hmac_sha256(void *dest, const void *key, uint16_t keylength_b, const void *msg,
-                 uint32_t msglength_b)
+void hmac_sha256_init(hmac_sha256_ctx_t *s, const void *key, uint16_t keylength_b)
 {
-	sha256_ctx_t s;
 	uint8_t buffer[HMAC_SHA256_BLOCK_BYTES];
 
 	(void)memset((void *)buffer, 0x00, HMAC_SHA256_BLOCK_BYTES);
@@ -41,21 +39,38 @@ void hmac_sha256(void *dest, const void *key, uint16_t keylength_b, const void *
 	for (uint8_t i = 0; i < SHA256_BLOCK_BYTES; ++i) {
 		buffer[i] ^= IPAD;
 	}
-	sha256_init(&s);
-	sha256_nextBlock(&s, buffer);
+	sha256_init(&s->a);
+	sha256_nextBlock(&s->a, buffer);
+	for (uint8_t i = 0; i < HMAC_SHA256_BLOCK_BYTES; ++i) {
+		buffer[i] ^= IPAD ^ OPAD;
+	}
+	sha256_init(&s->b);
+	sha256_nextBlock(&s->b, buffer);
+	(void)memset((void *)buffer, 0x00, HMAC_SHA256_BLOCK_BYTES);
+}
+
+void hmac_sha256_mac(void *dest, const hmac_sha256_ctx_t *s, const void *msg,
+                     uint32_t msglength_b)
+{
+	sha256_ctx_t a = s->a;
+
 	while (msglength_b >= HMAC_SHA256_BLOCK_BITS) {
-		sha256_nextBlock(&s, msg);
+		sha256_nextBlock(&a, msg);
 		msg = (uint8_t *)msg + HMAC_SHA256_BLOCK_BYTES;
 		msglength_b -= HMAC_SHA256_BLOCK_BITS;
 	}
-	sha256_lastBlock(&s, msg, msglength_b);
-	/* since buffer still contains key xor ipad we can do ... */
-	for (uint8_t i = 0; i < HMAC_SHA256_BLOCK_BYTES; ++i) {
-		buffer[i] ^= IPAD ^ OPAD;
-	}
-	sha256_ctx2hash((sha256_hash_t *)dest, &s); /* save inner hash temporary to dest */
-	sha256_init(&s);
-	sha256_nextBlock(&s, buffer);
-	sha256_lastBlock(&s, dest, SHA256_HASH_BITS);
-	sha256_ctx2hash((sha256_hash_t *)dest, &s);
+	sha256_lastBlock(&a, msg, msglength_b);
+	sha256_ctx2hash((sha256_hash_t *)dest, &a); /* save inner hash temporary to dest */
+	a = s->b;
+	sha256_lastBlock(&a, dest, SHA256_HASH_BITS);
+	sha256_ctx2hash((sha256_hash_t *)dest, &a);
+}
+
+void hmac_sha256(void *dest, const void *key, uint16_t keylength_b, const void *msg,
+                 uint32_t msglength_b)
+{
+	hmac_sha256_ctx_t s;
+
+	hmac_sha256_init(&s, key, keylength_b);
+	hmac_sha256_mac(dest, &s, msg, msglength_b);
 }
@@ -75,4 +75,24 @@ typedef struct {
 void hmac_sha256(void *dest, const void *key, uint16_t keylength_b, const void *msg,
                  uint32_t msglength_b);
 
+/**
+* @brief Hash the padded key blocks once for several SHA256 HMAC calculations
+*
+* @param s pointer to the context receiving the inner and outer hash state
+* @param key pointer to the key that's is needed for the HMAC calculation
+* @param keylength_b length of the key
+*/
+void hmac_sha256_init(hmac_sha256_ctx_t *s, const void *key, uint16_t keylength_b);
+
+/**
+* @brief SHA256 HMAC function using a context prepared by hmac_sha256_init()
+*
+* @param dest pointer to the location where the hash value is going to be written to
+* @param s pointer to the prepared context, left unchanged
+* @param msg pointer to the message that's going to be hashed
+* @param msglength_b length of the message
+*/
+void hmac_sha256_mac(void *dest, const hmac_sha256_ctx_t *s, const void *msg,
+                     uint32_t msglength_b);
+
 #endif
@@ -19,15 +19,19 @@
 
 #include "MyCryptoESP32.h"
 
-// ESP32 SHA256
+// The mbedtls build of the ESP32 core drives the SHA and AES accelerators, the peripherals are
+// locked per operation by mbedtls. The contexts below keep state between calls, they are guarded
+// by _cryptoMutex as both tasks of a dual core gateway may reach them.
+static pthread_mutex_t _cryptoMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// ESP32 SHA256, one shot on the stack without the heap allocated mbedtls_md context
 void SHA256(uint8_t *dest, const uint8_t *data, size_t dataLength)
 {
-	mbedtls_md_context_t ctx;
-	mbedtls_md_init(&ctx);
-	mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0);
-	mbedtls_md_starts(&ctx);
-	mbedtls_md_update(&ctx, (const unsigned char *)data, dataLength);
-	mbedtls_md_finish(&ctx, dest);
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+	(void)mbedtls_sha256((const unsigned char *)data, dataLength, dest, 0);
+#else
+	(void)mbedtls_sha256_ret((const unsigned char *)data, dataLength, dest, 0);
+#endif
 }
 
 
@@ -35,32 +39,76 @@ void SHA256(uint8_t *dest, const uint8_t *data, size_t dataLength)
 void SHA256HMAC(uint8_t *dest, const uint8_t *key, size_t keyLength, const uint8_t *data,
                 size_t dataLength)
 {
-	mbedtls_md_context_t ctx;
-	mbedtls_md_init(&ctx);
-	mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1);
-	mbedtls_md_starts(&ctx);
-	mbedtls_md_hmac_starts(&ctx, (const unsigned char *)key, keyLength);
-	mbedtls_md_hmac_update(&ctx, (const unsigned char *)data, dataLength);
-	mbedtls_md_hmac_finish(&ctx, dest);
+	(void)mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), (const unsigned char *)key,
+	                      keyLength, (const unsigned char *)data, dataLength, dest);
+}
+
+// ESP32 SHA256HMAC with cached key, reset restores the state after the inner key block
+static mbedtls_md_context_t hmac_ctx;
+static bool hmac_ctx_init = false;
+
+void SHA256HMACSetKey(const uint8_t *key, size_t keyLength)
+{
+	(void)pthread_mutex_lock(&_cryptoMutex);
+	if (hmac_ctx_init) {
+		mbedtls_md_free(&hmac_ctx);
+	}
+	mbedtls_md_init(&hmac_ctx);
+	mbedtls_md_setup(&hmac_ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1);
+	mbedtls_md_hmac_starts(&hmac_ctx, (const unsigned char *)key, keyLength);
+	hmac_ctx_init = true;
+	(void)pthread_mutex_unlock(&_cryptoMutex);
+}
+
+void SHA256HMACWithKey(uint8_t *dest, const uint8_t *data, size_t dataLength)
+{
+	(void)pthread_mutex_lock(&_cryptoMutex);
+	mbedtls_md_hmac_reset(&hmac_ctx);
+	mbedtls_md_hmac_update(&hmac_ctx, (const unsigned char *)data, dataLength);
+	mbedtls_md_hmac_finish(&hmac_ctx, dest);
+	(void)pthread_mutex_unlock(&_cryptoMutex);
 }
 
 // ESP32 AES128 CBC
 static mbedtls_aes_context aes_ctx;
+static bool aes_ctx_init = false;
 
 void AES128CBCInit(const uint8_t *key)
 {
+	(void)pthread_mutex_lock(&_cryptoMutex);
+	if (aes_ctx_init) {
+		mbedtls_aes_free(&aes_ctx);
+	}
 	mbedtls_aes_init(&aes_ctx);
 	(void)mbedtls_aes_setkey_enc(&aes_ctx, key, 128);
+	aes_ctx_init = true;
+	(void)pthread_mutex_unlock(&_cryptoMutex);
 }
 
 void AES128CBCEncrypt(uint8_t *iv, uint8_t *buffer, const size_t dataLength)
 {
+	(void)pthread_mutex_lock(&_cryptoMutex);
 	mbedtls_aes_crypt_cbc(&aes_ctx, MBEDTLS_AES_ENCRYPT, dataLength, iv, (const unsigned char *)buffer,
 	                      (unsigned char *)buffer);
+	(void)pthread_mutex_unlock(&_cryptoMutex);
 }
 
 void AES128CBCDecrypt(uint8_t *iv, uint8_t *buffer, const size_t dataLength)
 {
+	(void)pthread_mutex_lock(&_cryptoMutex);
 	mbedtls_aes_crypt_cbc(&aes_ctx, MBEDTLS_AES_DECRYPT, dataLength, iv, (const unsigned char *)buffer,
 	                      (unsigned char *)buffer);
+	(void)pthread_mutex_unlock(&_cryptoMutex);
+}
+
+void AES128CTRCrypt(const uint8_t *iv, uint8_t *buffer, const size_t dataLength)
+{
+	uint8_t counter[16];
+	uint8_t stream[16];
+	size_t offset = 0;
+	(void)memcpy((void *)counter, (const void *)iv, sizeof(counter));
+	(void)pthread_mutex_lock(&_cryptoMutex);
+	(void)mbedtls_aes_crypt_ctr(&aes_ctx, dataLength, &offset, counter, stream,
+	                            (const unsigned char *)buffer, (unsigned char *)buffer);
+	(void)pthread_mutex_unlock(&_cryptoMutex);
 }
@@ -21,7 +21,10 @@
 #define MyCryptoESP32_h
 
 #include "hal/crypto/MyCryptoHAL.h"
+#include <pthread.h>
+#include "mbedtls/version.h"
 #include "mbedtls/md.h"
+#include "mbedtls/sha256.h"
 #include "mbedtls/aes.h"
 
 #endif
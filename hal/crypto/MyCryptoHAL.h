@@ -20,6 +20,12 @@
 #ifndef MyCryptoHAL_h
 #define MyCryptoHAL_h
 
+#if defined(MY_SIGNING_PARALLEL_VERIFY)
+#define MY_CRYPTO_THREAD_LOCAL __thread	//!< Scratch state of the hash functions, one per verifying thread
+#else
+#define MY_CRYPTO_THREAD_LOCAL			//!< Scratch state of the hash functions
+#endif
+
 /**
 * @brief SHA256 calculation
 *
@@ -45,6 +51,28 @@ void SHA256(uint8_t *dest, const uint8_t *data, size_t dataLength);
 void SHA256HMAC(uint8_t *dest, const uint8_t *key, size_t keyLength, const uint8_t *data,
                 size_t dataLength);
 
+/**
+* @brief Precompute the SHA256 HMAC key
+*
+* The inner and outer padded key blocks are hashed once here, so @ref SHA256HMACWithKey()
+* saves two SHA256 block calculations compared to @ref SHA256HMAC().
+*
+* @param key Buffer with HMAC key.
+* @param keyLength Size of HMAC key.
+*/
+void SHA256HMACSetKey(const uint8_t *key, size_t keyLength);
+
+/**
+* @brief SHA256 HMAC calculation with the key set by @ref SHA256HMACSetKey()
+*
+* The returned hash size is always 32 bytes.
+*
+* @param dest Buffer to return 32-byte hash.
+* @param data Buffer with data to add.
+* @param dataLength Size of data buffer.
+*/
+void SHA256HMACWithKey(uint8_t *dest, const uint8_t *data, size_t dataLength);
+
 /**
 * @brief AES128CBCInit
 * @param key AES encryption key, 16 bytes
@@ -64,5 +92,15 @@ void AES128CBCEncrypt(uint8_t *iv, uint8_t *buffer, const size_t dataLength);
 * @param dataLength Buffer length
 */
 void AES128CBCDecrypt(uint8_t *iv, uint8_t *buffer, const size_t dataLength);
+/**
+* @brief AES128CTRCrypt
+*
+* Encrypts or decrypts in place, the buffer length does not have to be a multiple of the block
+* size. Uses the key set by @ref AES128CBCInit().
+* @param iv Initial counter block, 16 bytes, incremented as a big-endian number per block
+* @param buffer Buffer to encrypt or decrypt
+* @param dataLength Buffer length
+*/
+void AES128CTRCrypt(const uint8_t *iv, uint8_t *buffer, const size_t dataLength);
 
 #endif
@@ -0,0 +1,85 @@
+/*
+* The MySensors Arduino library handles the wireless radio link and protocol
+* between your home built sensors/actuators and HA controller of choice.
+* The sensors forms a self healing radio network with optional repeaters. Each
+* repeater and gateway builds a routing tables in EEPROM which keeps track of the
+* network topology allowing messages to be routed to nodes.
+*
+* Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+* Copyright (C) 2013-2019 Sensnology AB
+* Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+*
+* Documentation: http://www.mysensors.org
+* Support Forum: http://forum.mysensors.org
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* version 2 as published by the Free Software Foundation.
+*/
+
+#include "MyCryptoNRF5.h"
+#include "hal/crypto/generic/MyCryptoGeneric.cpp"
+
+// Key and data block for the ECB peripheral
+static nrf_ecb_t _aes_ecb;
+
+// Encrypt the cleartext block, the ECB unit is shared with the random number generator
+static void AES128ECBEncryptBlock(void)
+{
+	MY_CRITICAL_SECTION {
+		// Retry until no error
+		bool need_data = true;
+		while (need_data) {
+			// Stop if another task is running
+			NRF_ECB->TASKS_STOPECB = 1;
+			NRF_ECB->EVENTS_ERRORECB = 0;
+			NRF_ECB->EVENTS_ENDECB = 0;
+			uint32_t ptrbackup = NRF_ECB->ECBDATAPTR;
+			NRF_ECB->ECBDATAPTR = (uint32_t)&_aes_ecb;
+			NRF_ECB->TASKS_STARTECB = 1;
+			while (!NRF_ECB->EVENTS_ENDECB);
+			NRF_ECB->ECBDATAPTR = ptrbackup;
+			if (NRF_ECB->EVENTS_ERRORECB == 0) {
+				need_data = false;
+			}
+		}
+	}
+}
+
+void AES128CBCInit(const uint8_t *key)
+{
+	(void)memcpy((void *)_aes_ecb.key, (const void *)key, 16);
+	// The ECB peripheral can only encrypt, decryption keeps using the software implementation
+	_aes.set_key((byte *)key, 16);
+}
+
+void AES128CBCEncrypt(uint8_t *iv, uint8_t *buffer, const size_t dataLength)
+{
+	for (size_t pos = 0; pos + 16 <= dataLength; pos += 16) {
+		for (uint8_t i = 0; i < 16; i++) {
+			_aes_ecb.cleartext[i] = buffer[pos + i] ^ iv[i];
+		}
+		AES128ECBEncryptBlock();
+		(void)memcpy((void *)&buffer[pos], (const void *)_aes_ecb.ciphertext, 16);
+		(void)memcpy((void *)iv, (const void *)_aes_ecb.ciphertext, 16);
+	}
+	(void)memset((void *)_aes_ecb.cleartext, 0x00, 16);
+}
+
+void AES128CTRCrypt(const uint8_t *iv, uint8_t *buffer, const size_t dataLength)
+{
+	(void)memcpy((void *)_aes_ecb.cleartext, (const void *)iv, 16);
+	for (size_t pos = 0; pos < dataLength; pos += 16) {
+		AES128ECBEncryptBlock();
+		for (size_t i = 0; i < 16 && pos + i < dataLength; i++) {
+			buffer[pos + i] ^= _aes_ecb.ciphertext[i];
+		}
+		// big-endian increment
+		for (uint8_t i = 16; i > 0; i--) {
+			if (++_aes_ecb.cleartext[i - 1] != 0) {
+				break;
+			}
+		}
+	}
+	(void)memset((void *)_aes_ecb.ciphertext, 0x00, 16);
+}
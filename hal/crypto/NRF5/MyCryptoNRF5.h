@@ -0,0 +1,28 @@
+/*
+* The MySensors Arduino library handles the wireless radio link and protocol
+* between your home built sensors/actuators and HA controller of choice.
+* The sensors forms a self healing radio network with optional repeaters. Each
+* repeater and gateway builds a routing tables in EEPROM which keeps track of the
+* network topology allowing messages to be routed to nodes.
+*
+* Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+* Copyright (C) 2013-2019 Sensnology AB
+* Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+*
+* Documentation: http://www.mysensors.org
+* Support Forum: http://forum.mysensors.org
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* version 2 as published by the Free Software Foundation.
+*/
+
+#ifndef MyCryptoNRF5_h
+#define MyCryptoNRF5_h
+
+// AES encryption uses the ECB peripheral, SHA256 and AES decryption are done in software
+#define MY_CRYPTO_HW_AES	//!< AES128CBCInit(), AES128CBCEncrypt() and AES128CTRCrypt() are provided by the architecture
+
+#include "hal/crypto/generic/MyCryptoGeneric.h"
+
+#endif
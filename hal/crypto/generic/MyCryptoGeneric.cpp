@@ -27,19 +27,101 @@ void SHA256HMAC(uint8_t *dest, const uint8_t *key, size_t keyLength, const uint8
 	SHA256HMACResult(dest);
 }
 
+// Key midstates cached by SHA256HMACSetKey(), kept apart from SHA256HMAC() calls. Shared by all
+// threads, only set at init
+static _SHA256state_t _SHA256HMACcachedInner;
+static _SHA256state_t _SHA256HMACcachedOuter;
+
+void SHA256HMACSetKey(const uint8_t *key, size_t keyLength)
+{
+	SHA256HMACKey(key, keyLength);
+	_SHA256HMACcachedInner = SHA256HMACinnerState;
+	_SHA256HMACcachedOuter = SHA256HMACouterState;
+}
+
+void SHA256HMACWithKey(uint8_t *dest, const uint8_t *data, size_t dataLength)
+{
+	SHA256HMACinnerState = _SHA256HMACcachedInner;
+	SHA256HMACouterState = _SHA256HMACcachedOuter;
+	SHA256HMACStart();
+	SHA256HMACAdd(data, dataLength);
+	SHA256HMACResult(dest);
+}
+
 AES _aes;
 
+#if !defined(MY_CRYPTO_HW_AES)
 void AES128CBCInit(const uint8_t *key)
 {
 	_aes.set_key((byte *)key, 16);
+#if defined(MY_CRYPTO_CPU_EXTENSIONS)
+	if (cryptoCPUAES) {
+		cryptoCPUAES128SetKey(_aes.get_key_schedule());
+	}
+#endif
 }
 
 void AES128CBCEncrypt(uint8_t *iv, uint8_t *buffer, const size_t dataLength)
 {
+#if defined(MY_CRYPTO_CPU_EXTENSIONS)
+	if (cryptoCPUAES) {
+		for (size_t pos = 0; pos + 16 <= dataLength; pos += 16) {
+			for (uint8_t i = 0; i < 16; i++) {
+				iv[i] ^= buffer[pos + i];
+			}
+			cryptoCPUAES128Encrypt(iv, iv);
+			(void)memcpy((void *)&buffer[pos], (const void *)iv, 16);
+		}
+		return;
+	}
+#endif
 	_aes.cbc_encrypt((byte *)buffer, (byte *)buffer, dataLength / 16, iv);
 }
 
+void AES128CTRCrypt(const uint8_t *iv, uint8_t *buffer, const size_t dataLength)
+{
+	uint8_t counter[16];
+	uint8_t stream[16];
+	(void)memcpy((void *)counter, (const void *)iv, sizeof(counter));
+	for (size_t pos = 0; pos < dataLength; pos += 16) {
+#if defined(MY_CRYPTO_CPU_EXTENSIONS)
+		if (cryptoCPUAES) {
+			cryptoCPUAES128Encrypt(counter, stream);
+		} else {
+			(void)_aes.encrypt((byte *)counter, (byte *)stream);
+		}
+#else
+		(void)_aes.encrypt((byte *)counter, (byte *)stream);
+#endif
+		for (size_t i = 0; i < 16 && pos + i < dataLength; i++) {
+			buffer[pos + i] ^= stream[i];
+		}
+		// big-endian increment
+		for (uint8_t i = 16; i > 0; i--) {
+			if (++counter[i - 1] != 0) {
+				break;
+			}
+		}
+	}
+	(void)memset((void *)stream, 0x00, sizeof(stream));
+}
+#endif
+
 void AES128CBCDecrypt(uint8_t *iv, uint8_t *buffer, const size_t dataLength)
 {
+#if defined(MY_CRYPTO_CPU_EXTENSIONS)
+	if (cryptoCPUAES) {
+		uint8_t cipher[16];
+		for (size_t pos = 0; pos + 16 <= dataLength; pos += 16) {
+			(void)memcpy((void *)cipher, (const void *)&buffer[pos], 16);
+			cryptoCPUAES128Decrypt(cipher, &buffer[pos]);
+			for (uint8_t i = 0; i < 16; i++) {
+				buffer[pos + i] ^= iv[i];
+			}
+			(void)memcpy((void *)iv, (const void *)cipher, 16);
+		}
+		return;
+	}
+#endif
 	_aes.cbc_decrypt((byte *)buffer, (byte *)buffer, dataLength / 16, iv);
 }
@@ -22,6 +22,11 @@
 
 #include "hal/crypto/MyCryptoHAL.h"
 #include "hal/crypto/generic/drivers/AES/AES.cpp"
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__)) && \
+	!defined(MY_LINUX_DISABLE_CRYPTO_EXTENSIONS)
+#define MY_CRYPTO_CPU_EXTENSIONS	//!< SHA256 and AES128 use the crypto instructions of the CPU if present
+#include "hal/crypto/generic/MyCryptoGenericCPU.cpp"
+#endif
 #include "hal/crypto/generic/drivers/SHA256/sha256.cpp"
 #include "hal/crypto/generic/drivers/HMAC_SHA256/hmac_sha256.cpp"
 
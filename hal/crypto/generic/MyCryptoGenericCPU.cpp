@@ -0,0 +1,199 @@
+/*
+* The MySensors Arduino library handles the wireless radio link and protocol
+* between your home built sensors/actuators and HA controller of choice.
+* The sensors forms a self healing radio network with optional repeaters. Each
+* repeater and gateway builds a routing tables in EEPROM which keeps track of the
+* network topology allowing messages to be routed to nodes.
+*
+* Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+* Copyright (C) 2013-2019 Sensnology AB
+* Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+*
+* Documentation: http://www.mysensors.org
+* Support Forum: http://forum.mysensors.org
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* version 2 as published by the Free Software Foundation.
+*
+* SHA256 block and AES128 block functions using the crypto instructions of the CPU:
+* SHA-NI and AES-NI on x86_64, the ARMv8 crypto extensions on aarch64. The instructions are
+* enabled per function, so the binary still runs on CPUs without them. Availability is
+* detected once at startup, the software implementations are used otherwise.
+*/
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define CRYPTO_CPU_SHA256_TARGET __attribute__((target("sha,sse4.1")))
+#define CRYPTO_CPU_AES_TARGET __attribute__((target("aes,sse2")))
+#elif defined(__aarch64__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#include <arm_neon.h>
+#define CRYPTO_CPU_SHA256_TARGET __attribute__((target("+crypto")))
+#define CRYPTO_CPU_AES_TARGET __attribute__((target("+crypto")))
+#endif
+
+#define CRYPTO_CPU_AES128_ROUNDS (10u)
+
+static bool cryptoCPUSHA256 = false;
+static bool cryptoCPUAES = false;
+// round keys of the encryption and the equivalent inverse cipher
+static uint8_t cryptoCPUAESEncryptKeys[CRYPTO_CPU_AES128_ROUNDS + 1][16] __attribute__((aligned(16)));
+static uint8_t cryptoCPUAESDecryptKeys[CRYPTO_CPU_AES128_ROUNDS + 1][16] __attribute__((aligned(16)));
+
+extern const uint32_t SHA256K[];
+
+__attribute__((constructor)) static void cryptoCPUDetect(void)
+{
+#if defined(__x86_64__)
+	uint32_t eax, ebx, ecx, edx;
+	bool sse41 = false;
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+		sse41 = (ecx & bit_SSE4_1);
+		cryptoCPUAES = (ecx & bit_AES);
+	}
+	if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+		cryptoCPUSHA256 = sse41 && (ebx & bit_SHA);
+	}
+#elif defined(__aarch64__)
+	const unsigned long hwcap = getauxval(AT_HWCAP);
+	cryptoCPUSHA256 = (hwcap & HWCAP_SHA2);
+	cryptoCPUAES = (hwcap & HWCAP_AES);
+#endif
+}
+
+#if defined(__x86_64__)
+CRYPTO_CPU_SHA256_TARGET static void cryptoCPUSHA256Block(uint32_t *state, uint32_t *block)
+{
+	// the rounds work on ABEF and CDGH
+	__m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xB1);
+	__m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1B);
+	__m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+	const __m128i abef = state0;
+	const __m128i cdgh = state1;
+	// the block holds the message words in host order already
+	__m128i msg[4];
+	for (uint8_t i = 0; i < 4; i++) {
+		msg[i] = _mm_loadu_si128((const __m128i *)&block[i * 4]);
+	}
+	for (uint8_t i = 0; i < 16; i++) {
+		if (i >= 4) {
+			// W[t] from W[t-16], W[t-15], W[t-7] and W[t-2]
+			tmp = _mm_sha256msg1_epu32(msg[i & 3], msg[(i + 1) & 3]);
+			tmp = _mm_add_epi32(tmp, _mm_alignr_epi8(msg[(i + 3) & 3], msg[(i + 2) & 3], 4));
+			msg[i & 3] = _mm_sha256msg2_epu32(tmp, msg[(i + 3) & 3]);
+		}
+		tmp = _mm_add_epi32(msg[i & 3], _mm_loadu_si128((const __m128i *)&SHA256K[i * 4]));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, tmp);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(tmp, 0x0E));
+	}
+	state0 = _mm_add_epi32(state0, abef);
+	state1 = _mm_add_epi32(state1, cdgh);
+	// back to ABCD and EFGH
+	tmp = _mm_shuffle_epi32(state0, 0x1B);
+	state1 = _mm_shuffle_epi32(state1, 0xB1);
+	_mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(tmp, state1, 0xF0));
+	_mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+CRYPTO_CPU_AES_TARGET static void cryptoCPUAES128SetKey(const uint8_t *schedule)
+{
+	(void)memcpy((void *)cryptoCPUAESEncryptKeys, (const void *)schedule,
+	             sizeof(cryptoCPUAESEncryptKeys));
+	for (uint8_t i = 0; i <= CRYPTO_CPU_AES128_ROUNDS; i++) {
+		__m128i key = _mm_load_si128((const __m128i *)
+		                             cryptoCPUAESEncryptKeys[CRYPTO_CPU_AES128_ROUNDS - i]);
+		if (i > 0 && i < CRYPTO_CPU_AES128_ROUNDS) {
+			key = _mm_aesimc_si128(key);
+		}
+		_mm_store_si128((__m128i *)cryptoCPUAESDecryptKeys[i], key);
+	}
+}
+
+CRYPTO_CPU_AES_TARGET static void cryptoCPUAES128Encrypt(const uint8_t *in, uint8_t *out)
+{
+	__m128i data = _mm_xor_si128(_mm_loadu_si128((const __m128i *)in),
+	                             _mm_load_si128((const __m128i *)cryptoCPUAESEncryptKeys[0]));
+	for (uint8_t i = 1; i < CRYPTO_CPU_AES128_ROUNDS; i++) {
+		data = _mm_aesenc_si128(data, _mm_load_si128((const __m128i *)cryptoCPUAESEncryptKeys[i]));
+	}
+	data = _mm_aesenclast_si128(data, _mm_load_si128((const __m128i *)
+	                            cryptoCPUAESEncryptKeys[CRYPTO_CPU_AES128_ROUNDS]));
+	_mm_storeu_si128((__m128i *)out, data);
+}
+
+CRYPTO_CPU_AES_TARGET static void cryptoCPUAES128Decrypt(const uint8_t *in, uint8_t *out)
+{
+	__m128i data = _mm_xor_si128(_mm_loadu_si128((const __m128i *)in),
+	                             _mm_load_si128((const __m128i *)cryptoCPUAESDecryptKeys[0]));
+	for (uint8_t i = 1; i < CRYPTO_CPU_AES128_ROUNDS; i++) {
+		data = _mm_aesdec_si128(data, _mm_load_si128((const __m128i *)cryptoCPUAESDecryptKeys[i]));
+	}
+	data = _mm_aesdeclast_si128(data, _mm_load_si128((const __m128i *)
+	                            cryptoCPUAESDecryptKeys[CRYPTO_CPU_AES128_ROUNDS]));
+	_mm_storeu_si128((__m128i *)out, data);
+}
+
+#elif defined(__aarch64__)
+CRYPTO_CPU_SHA256_TARGET static void cryptoCPUSHA256Block(uint32_t *state, uint32_t *block)
+{
+	uint32x4_t state0 = vld1q_u32(&state[0]);
+	uint32x4_t state1 = vld1q_u32(&state[4]);
+	const uint32x4_t abcd = state0;
+	const uint32x4_t efgh = state1;
+	// the block holds the message words in host order already
+	uint32x4_t msg[4];
+	for (uint8_t i = 0; i < 4; i++) {
+		msg[i] = vld1q_u32(&block[i * 4]);
+	}
+	for (uint8_t i = 0; i < 16; i++) {
+		if (i >= 4) {
+			// W[t] from W[t-16], W[t-15], W[t-7] and W[t-2]
+			msg[i & 3] = vsha256su1q_u32(vsha256su0q_u32(msg[i & 3], msg[(i + 1) & 3]),
+			                             msg[(i + 2) & 3], msg[(i + 3) & 3]);
+		}
+		const uint32x4_t wk = vaddq_u32(msg[i & 3], vld1q_u32(&SHA256K[i * 4]));
+		const uint32x4_t tmp = state0;
+		state0 = vsha256hq_u32(state0, state1, wk);
+		state1 = vsha256h2q_u32(state1, tmp, wk);
+	}
+	vst1q_u32(&state[0], vaddq_u32(state0, abcd));
+	vst1q_u32(&state[4], vaddq_u32(state1, efgh));
+}
+
+CRYPTO_CPU_AES_TARGET static void cryptoCPUAES128SetKey(const uint8_t *schedule)
+{
+	(void)memcpy((void *)cryptoCPUAESEncryptKeys, (const void *)schedule,
+	             sizeof(cryptoCPUAESEncryptKeys));
+	for (uint8_t i = 0; i <= CRYPTO_CPU_AES128_ROUNDS; i++) {
+		uint8x16_t key = vld1q_u8(cryptoCPUAESEncryptKeys[CRYPTO_CPU_AES128_ROUNDS - i]);
+		if (i > 0 && i < CRYPTO_CPU_AES128_ROUNDS) {
+			key = vaesimcq_u8(key);
+		}
+		vst1q_u8(cryptoCPUAESDecryptKeys[i], key);
+	}
+}
+
+CRYPTO_CPU_AES_TARGET static void cryptoCPUAES128Encrypt(const uint8_t *in, uint8_t *out)
+{
+	uint8x16_t data = vld1q_u8(in);
+	for (uint8_t i = 0; i < CRYPTO_CPU_AES128_ROUNDS - 1; i++) {
+		data = vaesmcq_u8(vaeseq_u8(data, vld1q_u8(cryptoCPUAESEncryptKeys[i])));
+	}
+	data = vaeseq_u8(data, vld1q_u8(cryptoCPUAESEncryptKeys[CRYPTO_CPU_AES128_ROUNDS - 1]));
+	vst1q_u8(out, veorq_u8(data, vld1q_u8(cryptoCPUAESEncryptKeys[CRYPTO_CPU_AES128_ROUNDS])));
+}
+
+CRYPTO_CPU_AES_TARGET static void cryptoCPUAES128Decrypt(const uint8_t *in, uint8_t *out)
+{
+	uint8x16_t data = vld1q_u8(in);
+	for (uint8_t i = 0; i < CRYPTO_CPU_AES128_ROUNDS - 1; i++) {
+		data = vaesimcq_u8(vaesdq_u8(data, vld1q_u8(cryptoCPUAESDecryptKeys[i])));
+	}
+	data = vaesdq_u8(data, vld1q_u8(cryptoCPUAESDecryptKeys[CRYPTO_CPU_AES128_ROUNDS - 1]));
+	vst1q_u8(out, veorq_u8(data, vld1q_u8(cryptoCPUAESDecryptKeys[CRYPTO_CPU_AES128_ROUNDS])));
+}
+#endif
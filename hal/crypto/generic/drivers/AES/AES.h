@@ -69,6 +69,14 @@ public:
 	 */
 	void clean () ;  // delete key schedule after use
 
+	/** expanded key set by set_key(), (rounds + 1) round keys of N_BLOCK bytes.
+	 *  @return pointer to the key schedule.
+	 */
+	const byte *get_key_schedule () const
+	{
+		return key_sched;
+	}
+
 	/** copying and xoring utilities.
 	 *  @param *AESt byte pointer of the AEStination array.
 	 *  @param *src byte pointer of the source array.
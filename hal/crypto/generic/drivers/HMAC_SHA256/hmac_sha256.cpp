@@ -20,7 +20,10 @@
 
 #include "hmac_sha256.h"
 
-void SHA256HMACInit(const uint8_t *key, size_t keyLength)
+MY_CRYPTO_THREAD_LOCAL _SHA256state_t SHA256HMACinnerState;
+MY_CRYPTO_THREAD_LOCAL _SHA256state_t SHA256HMACouterState;
+
+void SHA256HMACKey(const uint8_t *key, size_t keyLength)
 {
 	(void)memset((void *)&SHA256keyBuffer, 0x00, BLOCK_LENGTH);
 	if (keyLength > BLOCK_LENGTH) {
@@ -32,11 +35,34 @@ void SHA256HMACInit(const uint8_t *key, size_t keyLength)
 		// Block length keys are used as is
 		(void)memcpy((void *)SHA256keyBuffer, (const void *)key, keyLength);
 	}
-	// Start inner hash
+	// The padded key fills exactly one block, keep the state after it for inner and outer hash
+	for (uint8_t i = 0; i < BLOCK_LENGTH; i++) {
+		SHA256keyBuffer[i] ^= HMAC_IPAD;
+	}
 	SHA256Init();
+	SHA256Add(SHA256keyBuffer, BLOCK_LENGTH);
+	SHA256HMACinnerState = SHA256state;
 	for (uint8_t i = 0; i < BLOCK_LENGTH; i++) {
-		SHA256Add(SHA256keyBuffer[i] ^ HMAC_IPAD);
+		SHA256keyBuffer[i] ^= HMAC_IPAD ^ HMAC_OPAD;
 	}
+	SHA256Init();
+	SHA256Add(SHA256keyBuffer, BLOCK_LENGTH);
+	SHA256HMACouterState = SHA256state;
+	(void)memset((void *)&SHA256keyBuffer, 0x00, BLOCK_LENGTH);
+}
+
+void SHA256HMACStart(void)
+{
+	// Start inner hash from the key set by SHA256HMACKey()
+	SHA256state = SHA256HMACinnerState;
+	SHA256byteCount = BLOCK_LENGTH;
+	SHA256bufferOffset = 0;
+}
+
+void SHA256HMACInit(const uint8_t *key, size_t keyLength)
+{
+	SHA256HMACKey(key, keyLength);
+	SHA256HMACStart();
 }
 
 void SHA256HMACAdd(const uint8_t data)
@@ -55,10 +81,9 @@ void SHA256HMACResult(uint8_t *dest)
 	// Complete inner hash
 	SHA256Result(innerHash);
 	// Calculate outer hash
-	SHA256Init();
-	for (uint8_t i = 0; i < BLOCK_LENGTH; i++) {
-		SHA256Add(SHA256keyBuffer[i] ^ HMAC_OPAD);
-	}
+	SHA256state = SHA256HMACouterState;
+	SHA256byteCount = BLOCK_LENGTH;
+	SHA256bufferOffset = 0;
 	SHA256Add(innerHash, HASH_LENGTH);
 	SHA256Result(dest);
-}
\ No newline at end of file
+}
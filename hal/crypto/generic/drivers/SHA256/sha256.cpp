@@ -42,11 +42,11 @@ const uint8_t SHA256InitState[] PROGMEM = {
 	0x19,0xcd,0xe0,0x5b  // H7
 };
 
-_SHA256buffer_t SHA256buffer;
-uint8_t SHA256bufferOffset;
-_SHA256state_t SHA256state;
-uint32_t SHA256byteCount;
-uint8_t SHA256keyBuffer[BLOCK_LENGTH];
+MY_CRYPTO_THREAD_LOCAL _SHA256buffer_t SHA256buffer;
+MY_CRYPTO_THREAD_LOCAL uint8_t SHA256bufferOffset;
+MY_CRYPTO_THREAD_LOCAL _SHA256state_t SHA256state;
+MY_CRYPTO_THREAD_LOCAL uint32_t SHA256byteCount;
+MY_CRYPTO_THREAD_LOCAL uint8_t SHA256keyBuffer[BLOCK_LENGTH];
 
 void SHA256Init(void)
 {
@@ -62,6 +62,12 @@ uint32_t SHA256ror32(const uint32_t number, const uint8_t bits)
 
 void SHA256hashBlock(void)
 {
+#if defined(MY_CRYPTO_CPU_EXTENSIONS)
+	if (cryptoCPUSHA256) {
+		cryptoCPUSHA256Block(SHA256state.w, SHA256buffer.w);
+		return;
+	}
+#endif
 	uint32_t a, b, c, d, e, f, g, h, t1, t2;
 
 	a = SHA256state.w[0];
@@ -127,8 +133,23 @@ void SHA256Add(const uint8_t data)
 
 void SHA256Add(const uint8_t *data, size_t dataLength)
 {
-	while (dataLength--) {
-		SHA256Add(*data++);
+	SHA256byteCount += dataLength;
+	while (dataLength) {
+		if (!(SHA256bufferOffset & 3) && dataLength >= 4) {
+			// whole big-endian words
+			SHA256buffer.w[SHA256bufferOffset >> 2] = ((uint32_t)data[0] << 24) |
+			        ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+			data += 4;
+			dataLength -= 4;
+			SHA256bufferOffset += 4;
+			if (SHA256bufferOffset == BLOCK_LENGTH) {
+				SHA256hashBlock();
+				SHA256bufferOffset = 0;
+			}
+		} else {
+			SHA256addUncounted(*data++);
+			dataLength--;
+		}
 	}
 }
 
@@ -26,6 +26,179 @@
 #define TRANSPORT_HAL_DEBUG(x,...)	//!< debug NULL
 #endif
 
+#if defined(__linux__)
+// frames as on air for the capture file of mysgw, see pcapcapture.h
+// the peer of the capture record is 8 bit, 16 bit node ids are complete in the frame itself
+#define TRANSPORT_HAL_CAPTURE(...) do { if (pcapCaptureActive()) { pcapCapture(__VA_ARGS__); } } while (0)	//!< capture
+#else
+#define TRANSPORT_HAL_CAPTURE(...)	//!< capture NULL
+#endif
+
+#if defined(TRANSPORT_HAL_RX_QUEUE) || defined(MY_GATEWAY_SECONDARY_RFM95)
+#include "drivers/CircularBuffer/CircularBuffer.h"
+
+typedef struct {
+	uint8_t len;						// Length of the data
+	int16_t RSSI;						// RSSI of the frame, read when it was taken from the radio
+	int16_t SNR;						// SNR of the frame
+#if defined(MY_STATS_LATENCY)
+	uint32_t stamp;						// Time the frame was taken from the radio
+#endif
+	uint8_t data[MAX_MESSAGE_LENGTH];	// The raw data
+} transportHALQueuedMessage_t;
+#endif
+
+#if defined(TRANSPORT_HAL_RX_QUEUE)
+static transportHALQueuedMessage_t _transportHALRxQueueStorage[MY_RX_MESSAGE_BUFFER_SIZE];
+static CircularBuffer<transportHALQueuedMessage_t> _transportHALRxQueue(_transportHALRxQueueStorage,
+        MY_RX_MESSAGE_BUFFER_SIZE);
+static transportHALRxQueueStats_t _transportHALRxQueueStats;
+// signal of the frame handed out last
+#if defined(TRANSPORT_HAL_RX_RSSI)
+static int16_t _transportHALRxRSSI = INVALID_RSSI;
+#endif
+#if defined(TRANSPORT_HAL_SNR)
+static int16_t _transportHALRxSNR = INVALID_SNR;
+#endif
+
+// The radio IRQ only flags a received frame, the frame is read from the radio on the next
+// poll. Polling on every HAL call, including the ones around sending, frees the radio
+// (and acknowledges the frame) while the previous one is still being processed.
+static void transportHALPoll(void)
+{
+	while (transportDataAvailable()) {
+		transportHALQueuedMessage_t *msg = _transportHALRxQueue.getFront();
+		if (msg == NULL) {
+			// leave the frame in the radio, the sender retries if it is not acknowledged
+			_transportHALRxQueueStats.overflows++;
+			STATS_INC(STATS_RX_OVERFLOWS);
+			TRANSPORT_HAL_DEBUG(PSTR("!THA:POL:QUEUE FULL\n"));
+			return;
+		}
+		msg->len = transportReceive((void *)msg->data);
+		msg->RSSI = transportGetReceivingRSSI();
+		msg->SNR = transportGetReceivingSNR();
+#if defined(MY_STATS_LATENCY)
+		msg->stamp = statsLatencyStamp();
+#endif
+		TRANSPORT_HAL_CAPTURE(PCAP_CAPTURE_RX, (uint8_t)BROADCAST_ADDRESS, 0, msg->RSSI, msg->SNR, msg->data,
+		                      msg->len);
+		(void)_transportHALRxQueue.pushFront(msg);
+		_transportHALRxQueueStats.queued++;
+		if (_transportHALRxQueue.available() > _transportHALRxQueueStats.highWater) {
+			_transportHALRxQueueStats.highWater = _transportHALRxQueue.available();
+		}
+	}
+}
+
+transportHALRxQueueStats_t transportHALGetRxQueueStats(void)
+{
+	return _transportHALRxQueueStats;
+}
+#endif
+
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+static transportHALQueuedMessage_t
+_transportHALSecondaryRxQueueStorage[MY_GATEWAY_SECONDARY_RX_QUEUE_SIZE];
+static CircularBuffer<transportHALQueuedMessage_t> _transportHALSecondaryRxQueue(
+    _transportHALSecondaryRxQueueStorage, MY_GATEWAY_SECONDARY_RX_QUEUE_SIZE);
+// one bit per node id: neighbour last heard on the secondary radio
+static uint8_t _transportHALSecondaryNodes[32];
+// radio of the frame handed out last and of the frame sent last, whose turn it is to hand out
+static bool _transportHALRxSecondary = false;
+static bool _transportHALTxSecondary = false;
+static bool _transportHALSecondaryTurn = false;
+static int16_t _transportHALSecondaryRxRSSI = INVALID_RSSI;
+static int16_t _transportHALSecondaryRxSNR = INVALID_SNR;
+
+static bool transportHALIsSecondaryNode(const uint8_t nodeId)
+{
+	return _transportHALSecondaryNodes[nodeId >> 3] & (1u << (nodeId & 7));
+}
+
+static void transportHALSetSecondaryNode(const uint8_t nodeId, const bool secondary)
+{
+	if (secondary) {
+		_transportHALSecondaryNodes[nodeId >> 3] |= (1u << (nodeId & 7));
+	} else {
+		_transportHALSecondaryNodes[nodeId >> 3] &= ~(1u << (nodeId & 7));
+	}
+}
+
+// Frames are taken from the secondary radio on every HAL call, like the RX queue above, so a
+// slow radio is not kept busy while frames of the other radio are processed.
+static void transportHALSecondaryPoll(void)
+{
+	while (transportSecondaryDataAvailable()) {
+		transportHALQueuedMessage_t *msg = _transportHALSecondaryRxQueue.getFront();
+		if (msg == NULL) {
+			STATS_INC(STATS_RX_OVERFLOWS);
+			TRANSPORT_HAL_DEBUG(PSTR("!THA:POL:SEC QUEUE FULL\n"));
+			return;
+		}
+		msg->len = transportSecondaryReceive((void *)msg->data);
+		msg->RSSI = transportSecondaryGetReceivingRSSI();
+		msg->SNR = transportSecondaryGetReceivingSNR();
+#if defined(MY_STATS_LATENCY)
+		msg->stamp = statsLatencyStamp();
+#endif
+		TRANSPORT_HAL_CAPTURE(PCAP_CAPTURE_RX, (uint8_t)BROADCAST_ADDRESS, PCAP_CAPTURE_FLAG_SECONDARY, msg->RSSI,
+		                      msg->SNR, msg->data, msg->len);
+		(void)_transportHALSecondaryRxQueue.pushFront(msg);
+	}
+}
+
+static uint8_t transportHALSecondaryReceive(uint8_t *rx_data)
+{
+	uint8_t payloadLength = 0;
+	transportHALQueuedMessage_t *msg = _transportHALSecondaryRxQueue.getBack();
+	if (msg != NULL) {
+		payloadLength = msg->len;
+		_transportHALSecondaryRxRSSI = msg->RSSI;
+		_transportHALSecondaryRxSNR = msg->SNR;
+		STATS_UPLINK_BEGIN(msg->stamp);
+		(void)memcpy((void *)rx_data, (void *)msg->data, payloadLength);
+		(void)_transportHALSecondaryRxQueue.popBack();
+	}
+	return payloadLength;
+}
+
+static bool transportHALSendOn(const bool secondary, const uint8_t nextRecipient,
+                               const uint8_t *data, const uint8_t len, const bool noACK)
+{
+	_transportHALTxSecondary = secondary;
+	bool result;
+	if (secondary) {
+		result = transportSecondarySend(nextRecipient, (const void *)data, len, noACK);
+		TRANSPORT_HAL_CAPTURE(PCAP_CAPTURE_TX, nextRecipient,
+		                      PCAP_CAPTURE_FLAG_SECONDARY | (result ? PCAP_CAPTURE_FLAG_ACK : 0),
+		                      transportSecondaryGetSendingRSSI(), transportSecondaryGetSendingSNR(), data, len);
+	} else {
+		result = transportSend(nextRecipient, (const void *)data, len, noACK);
+		TRANSPORT_HAL_CAPTURE(PCAP_CAPTURE_TX, nextRecipient, result ? PCAP_CAPTURE_FLAG_ACK : 0,
+		                      transportGetSendingRSSI(), transportGetSendingSNR(), data, len);
+	}
+	TRANSPORT_HAL_DEBUG(PSTR("THA:SND:RADIO=%" PRIu8 ",RES=%" PRIu8 "\n"), secondary, result);
+	return result;
+}
+#endif
+
+#if defined(MY_TRANSPORT_ENCRYPTION) && defined(MY_ENCRYPTION_CTR) && !defined(MY_RADIO_RFM69)
+#define TRANSPORT_HAL_ENCRYPTION_CTR			//!< Frames not exceeding MAX_MESSAGE_LENGTH are CTR encrypted
+#define TRANSPORT_HAL_CTR_NONCE_SIZE	(4u)	//!< Size of the clear text counter prepended to CTR frames
+
+// Counter of the last sent frame, seeded randomly so nodes sharing the key start apart
+static uint32_t _transportHALCTRNonce;
+
+// The counter block is the clear text nonce padded with zeros, the last byte counts the blocks
+static void transportHALCTRCrypt(const uint8_t *nonce, uint8_t *buffer, const uint8_t len)
+{
+	uint8_t IV[16] = { 0 };
+	(void)memcpy((void *)IV, (const void *)nonce, TRANSPORT_HAL_CTR_NONCE_SIZE);
+	AES128CTRCrypt(IV, buffer, len);
+}
+#endif
+
 bool transportHALInit(void)
 {
 	TRANSPORT_HAL_DEBUG(PSTR("THA:INIT\n"));
@@ -45,6 +218,9 @@ bool transportHALInit(void)
 #endif
 #endif
 	bool result = transportInit();
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+	result = transportSecondaryInit() && result;
+#endif
 
 #if defined(MY_TRANSPORT_ENCRYPTION)
 #if defined(MY_RADIO_RFM69)
@@ -52,6 +228,10 @@ bool transportHALInit(void)
 #else
 	//set up AES-key
 	AES128CBCInit(transportPSK);
+#if defined(TRANSPORT_HAL_ENCRYPTION_CTR)
+	hwRandomNumberInit();
+	_transportHALCTRNonce = ((uint32_t)random(0x10000) << 16) | (uint32_t)random(0x10000);
+#endif
 #endif
 	// Make sure it is purged from memory when set
 	(void)memset((void *)transportPSK, 0,
@@ -60,22 +240,39 @@ bool transportHALInit(void)
 	return result;
 }
 
-void transportHALSetAddress(const uint8_t address)
+void transportHALSetAddress(const nodeId_t address)
 {
-	TRANSPORT_HAL_DEBUG(PSTR("THA:SAD:ADDR=%" PRIu8 "\n"), address);
+	TRANSPORT_HAL_DEBUG(PSTR("THA:SAD:ADDR=%" PRIuNodeId "\n"), address);
 	transportSetAddress(address);
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+	transportSecondarySetAddress(address);
+#endif
 }
 
-uint8_t transportHALGetAddress(void)
+nodeId_t transportHALGetAddress(void)
 {
-	uint8_t result = transportGetAddress();
-	TRANSPORT_HAL_DEBUG(PSTR("THA:GAD:ADDR=%" PRIu8 "\n"), result);
+	nodeId_t result = transportGetAddress();
+	TRANSPORT_HAL_DEBUG(PSTR("THA:GAD:ADDR=%" PRIuNodeId "\n"), result);
 	return result;
 }
 
+static bool transportHALPrimaryDataAvailable(void)
+{
+#if defined(TRANSPORT_HAL_RX_QUEUE)
+	transportHALPoll();
+	return !_transportHALRxQueue.empty();
+#else
+	return transportDataAvailable();
+#endif
+}
+
 bool transportHALDataAvailable(void)
 {
-	bool result = transportDataAvailable();
+	bool result = transportHALPrimaryDataAvailable();
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+	transportHALSecondaryPoll();
+	result = result || !_transportHALSecondaryRxQueue.empty();
+#endif
 #if defined(MY_DEBUG_VERBOSE_TRANSPORT_HAL)
 	if (result) {
 		TRANSPORT_HAL_DEBUG(PSTR("THA:DATA:AVAIL\n"));
@@ -87,43 +284,116 @@ bool transportHALDataAvailable(void)
 bool transportHALSanityCheck(void)
 {
 	bool result = transportSanityCheck();
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+	result = transportSecondarySanityCheck() && result;
+#endif
 	TRANSPORT_HAL_DEBUG(PSTR("THA:SAN:RES=%" PRIu8 "\n"), result);
 	return result;
 }
 
+static uint8_t transportHALPrimaryReceive(uint8_t *rx_data)
+{
+#if defined(TRANSPORT_HAL_RX_QUEUE)
+	uint8_t payloadLength = 0;
+	transportHALQueuedMessage_t *msg = _transportHALRxQueue.getBack();
+	if (msg != NULL) {
+		payloadLength = msg->len;
+#if defined(TRANSPORT_HAL_RX_RSSI)
+		_transportHALRxRSSI = msg->RSSI;
+#endif
+#if defined(TRANSPORT_HAL_SNR)
+		_transportHALRxSNR = msg->SNR;
+#endif
+		STATS_UPLINK_BEGIN(msg->stamp);
+		(void)memcpy((void *)rx_data, (void *)msg->data, payloadLength);
+		(void)_transportHALRxQueue.popBack();
+	}
+#else
+	// drivers queueing frames in their IRQ handler move the start to the receive time
+	STATS_UPLINK_BEGIN(statsLatencyStamp());
+	uint8_t payloadLength = transportReceive((void *)rx_data);
+	TRANSPORT_HAL_CAPTURE(PCAP_CAPTURE_RX, (uint8_t)BROADCAST_ADDRESS, 0, transportGetReceivingRSSI(),
+	                      transportGetReceivingSNR(), rx_data, payloadLength);
+#endif
+	return payloadLength;
+}
+
 bool transportHALReceive(MyMessage *inMsg, uint8_t *msgLength)
 {
+	PROFILING_SCOPE(PROFILING_RADIO_RECEIVE);
 	// set pointer to first byte of data structure
-	uint8_t *rx_data = &inMsg->last;
-	uint8_t payloadLength = transportReceive((void *)rx_data);
+	uint8_t *rx_data = (uint8_t *)&inMsg->last;
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+	// the radios take turns while both have frames pending
+	transportHALSecondaryPoll();
+	_transportHALRxSecondary = !_transportHALSecondaryRxQueue.empty() &&
+	                           (_transportHALSecondaryTurn || !transportHALPrimaryDataAvailable());
+	_transportHALSecondaryTurn = !_transportHALRxSecondary;
+	uint8_t payloadLength = _transportHALRxSecondary ? transportHALSecondaryReceive(rx_data) :
+	                        transportHALPrimaryReceive(rx_data);
+#else
+	uint8_t payloadLength = transportHALPrimaryReceive(rx_data);
+#endif
 #if defined(MY_DEBUG_VERBOSE_TRANSPORT_HAL)
 	hwDebugBuf2Str((const uint8_t *)rx_data, payloadLength);
 	TRANSPORT_HAL_DEBUG(PSTR("THA:RCV:MSG=%s\n"), hwDebugPrintStr);
 #endif
 #if defined(MY_TRANSPORT_ENCRYPTION) && !defined(MY_RADIO_RFM69)
-	TRANSPORT_HAL_DEBUG(PSTR("THA:RCV:DECRYPT\n"));
-	// has to be adjusted, WIP!
-	uint8_t IV[16] = { 0 };
-	// decrypt data
-	AES128CBCDecrypt(IV, (uint8_t *)rx_data, payloadLength);
+#if defined(TRANSPORT_HAL_ENCRYPTION_CTR)
+	// only full size frames are CBC encrypted, see transportHALSend()
+	const bool blockEncrypted = (payloadLength == MAX_MESSAGE_LENGTH);
+#else
+	const bool blockEncrypted = true;
+#endif
+	if (blockEncrypted) {
+		TRANSPORT_HAL_DEBUG(PSTR("THA:RCV:DECRYPT\n"));
+		// has to be adjusted, WIP!
+		uint8_t IV[16] = { 0 };
+		// decrypt data
+		AES128CBCDecrypt(IV, (uint8_t *)rx_data, payloadLength);
+	} else {
+#if defined(TRANSPORT_HAL_ENCRYPTION_CTR)
+		if (payloadLength < TRANSPORT_HAL_CTR_NONCE_SIZE + HEADER_SIZE) {
+			setIndication(INDICATION_ERR_LENGTH);
+			TRANSPORT_HAL_DEBUG(PSTR("!THA:RCV:LEN=%" PRIu8 "\n"), payloadLength); // frame too short
+			return false;
+		}
+		TRANSPORT_HAL_DEBUG(PSTR("THA:RCV:DECRYPT CTR\n"));
+		// decrypt behind the nonce, then move the message to the start of the buffer
+		payloadLength -= TRANSPORT_HAL_CTR_NONCE_SIZE;
+		transportHALCTRCrypt(rx_data, rx_data + TRANSPORT_HAL_CTR_NONCE_SIZE, payloadLength);
+		(void)memmove((void *)rx_data, (const void *)(rx_data + TRANSPORT_HAL_CTR_NONCE_SIZE),
+		              payloadLength);
+#endif
+	}
 #if defined(MY_DEBUG_VERBOSE_TRANSPORT_HAL)
 	hwDebugBuf2Str((const uint8_t *)rx_data, payloadLength);
 	TRANSPORT_HAL_DEBUG(PSTR("THA:RCV:PLAIN=%s\n"), hwDebugPrintStr);
 #endif
 #endif
-	// Reject messages with incorrect protocol version
-	MyMessage tmp = *inMsg;
-	if (mGetVersion(tmp) != PROTOCOL_VERSION) {
+	// Reject messages with incorrect protocol version, the header is checked in place
+	const MyMessage &header = *inMsg;
+	if (mGetVersion(header) != PROTOCOL_VERSION) {
 		setIndication(INDICATION_ERR_VERSION);
-		TRANSPORT_HAL_DEBUG(PSTR("!THA:RCV:PVER,%" PRIu8 "!=%" PRIu8 "\n"), mGetVersion(tmp),
+		TRANSPORT_HAL_DEBUG(PSTR("!THA:RCV:PVER,%" PRIu8 "!=%" PRIu8 "\n"), mGetVersion(header),
 		                    PROTOCOL_VERSION);	// protocol version mismatch
 		return false;
 	}
-	*msgLength = min(mGetLength(tmp), (uint8_t)MAX_PAYLOAD);
-	const uint8_t expectedMessageLength = HEADER_SIZE + (mGetSigned(tmp) ? MAX_PAYLOAD : *msgLength);
+	*msgLength = min(mGetLength(header), (uint8_t)MAX_PAYLOAD);
+#if defined(MY_TRANSPORT_SEQUENCE)
+	uint8_t expectedMessageLength = HEADER_SIZE + *msgLength + (mGetSigned(
+	                                    header) ? signerGetSignatureLength(header) : 0);
+	// frames with room for it carry the sequence number of the sender behind the message
+	expectedMessageLength += expectedMessageLength < MAX_MESSAGE_LENGTH ? 1u : 0u;
+#else
+	const uint8_t expectedMessageLength = HEADER_SIZE + *msgLength + (mGetSigned(
+	        header) ? signerGetSignatureLength(header) : 0);
+#endif
 #if defined(MY_TRANSPORT_ENCRYPTION) && !defined(MY_RADIO_RFM69)
 	// payload length = a multiple of blocksize length for decrypted messages, i.e. cannot be used for payload length check
-	payloadLength = expectedMessageLength;
+	if (blockEncrypted) {
+		payloadLength = expectedMessageLength;
+	}
 #endif
 	// Reject payloads with incorrect length
 	if (payloadLength != expectedMessageLength) {
@@ -133,12 +403,17 @@ bool transportHALReceive(MyMessage *inMsg, uint8_t *msgLength)
 		return false;
 	}
 	TRANSPORT_HAL_DEBUG(PSTR("THA:RCV:MSG LEN=%" PRIu8 "\n"), payloadLength);
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+	// answers go out on the radio the neighbour was heard on
+	transportHALSetSecondaryNode(header.last, _transportHALRxSecondary);
+#endif
 	return true;
 }
 
-bool transportHALSend(const uint8_t nextRecipient, const MyMessage *outMsg, const uint8_t len,
+bool transportHALSend(const nodeId_t nextRecipient, const MyMessage *outMsg, const uint8_t len,
                       const bool noACK)
 {
+	PROFILING_SCOPE(PROFILING_RADIO_SEND);
 	if (outMsg == NULL) {
 
 		// nothing to send
@@ -150,30 +425,80 @@ bool transportHALSend(const uint8_t nextRecipient, const MyMessage *outMsg, cons
 #endif
 
 #if defined(MY_TRANSPORT_ENCRYPTION) && !defined(MY_RADIO_RFM69)
-	TRANSPORT_HAL_DEBUG(PSTR("THA:SND:ENCRYPT\n"));
-	uint8_t *tx_data[MAX_MESSAGE_LENGTH];
-	// copy input data because it is read-only
-	(void)memcpy((void *)tx_data, (void *)&outMsg->last, len);
-	// We us IV vector filled with zeros but randomize unused bytes in encryption block
-	uint8_t IV[16] = { 0 };
-	const uint8_t finalLength = len > 16 ? 32 : 16;
-	// fill block with random data
-	for (uint8_t i = len; i < finalLength; i++) {
-		*((uint8_t *)tx_data + i) = random(255);
+	uint8_t tx_data[MAX_MESSAGE_LENGTH];
+#if defined(TRANSPORT_HAL_ENCRYPTION_CTR)
+	// frames without room for the nonce are sent as full size CBC frames
+	const bool blockEncrypted = (len + TRANSPORT_HAL_CTR_NONCE_SIZE >= MAX_MESSAGE_LENGTH);
+#else
+	const bool blockEncrypted = true;
+#endif
+	uint8_t finalLength;
+	if (blockEncrypted) {
+		TRANSPORT_HAL_DEBUG(PSTR("THA:SND:ENCRYPT\n"));
+		// copy input data because it is read-only
+		(void)memcpy((void *)tx_data, (const void *)&outMsg->last, len);
+		// We us IV vector filled with zeros but randomize unused bytes in encryption block
+		uint8_t IV[16] = { 0 };
+#if defined(TRANSPORT_HAL_ENCRYPTION_CTR)
+		finalLength = MAX_MESSAGE_LENGTH;
+#else
+		finalLength = len > 16 ? 32 : 16;
+#endif
+		// fill block with random data
+		for (uint8_t i = len; i < finalLength; i++) {
+			tx_data[i] = random(255);
+		}
+		//encrypt data
+		AES128CBCEncrypt(IV, tx_data, finalLength);
+	} else {
+#if defined(TRANSPORT_HAL_ENCRYPTION_CTR)
+		TRANSPORT_HAL_DEBUG(PSTR("THA:SND:ENCRYPT CTR\n"));
+		// the nonce is sent in clear text, followed by the encrypted message
+		_transportHALCTRNonce++;
+		(void)memcpy((void *)tx_data, (const void *)&_transportHALCTRNonce, TRANSPORT_HAL_CTR_NONCE_SIZE);
+		(void)memcpy((void *)&tx_data[TRANSPORT_HAL_CTR_NONCE_SIZE], (const void *)&outMsg->last, len);
+		transportHALCTRCrypt(tx_data, &tx_data[TRANSPORT_HAL_CTR_NONCE_SIZE], len);
+		finalLength = len + TRANSPORT_HAL_CTR_NONCE_SIZE;
+#endif
 	}
-	//encrypt data
-	AES128CBCEncrypt(IV, (uint8_t *)tx_data, finalLength);
 #if defined(MY_DEBUG_VERBOSE_TRANSPORT_HAL)
 	hwDebugBuf2Str((const uint8_t *)tx_data, finalLength);
 	TRANSPORT_HAL_DEBUG(PSTR("THA:SND:CIP=%s\n"), hwDebugPrintStr);
 #endif
 
 #else
-	const uint8_t *tx_data = &outMsg->last;
+	const uint8_t *tx_data = (const uint8_t *)&outMsg->last;
 	const uint8_t finalLength = len;
 #endif
 
+#if defined(TRANSPORT_HAL_RX_QUEUE)
+	// frames received while waiting for the ACK are picked up right away
+	transportHALPoll();
+#endif
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+	bool result;
+	if (nextRecipient == BROADCAST_ADDRESS) {
+		result = transportHALSendOn(false, nextRecipient, tx_data, finalLength, noACK);
+		result = transportHALSendOn(true, nextRecipient, tx_data, finalLength, noACK) || result;
+	} else {
+		const bool secondary = transportHALIsSecondaryNode(nextRecipient);
+		result = transportHALSendOn(secondary, nextRecipient, tx_data, finalLength, noACK);
+		if (!result && !noACK) {
+			// not heard yet or moved, try the other radio
+			result = transportHALSendOn(!secondary, nextRecipient, tx_data, finalLength, noACK);
+			if (result) {
+				transportHALSetSecondaryNode(nextRecipient, !secondary);
+			}
+		}
+	}
+#else
 	bool result = transportSend(nextRecipient, (void *)tx_data, finalLength, noACK);
+	TRANSPORT_HAL_CAPTURE(PCAP_CAPTURE_TX, nextRecipient, result ? PCAP_CAPTURE_FLAG_ACK : 0,
+	                      transportGetSendingRSSI(), transportGetSendingSNR(), tx_data, finalLength);
+#endif
+#if defined(TRANSPORT_HAL_RX_QUEUE)
+	transportHALPoll();
+#endif
 	TRANSPORT_HAL_DEBUG(PSTR("THA:SND:MSG LEN=%" PRIu8 ",RES=%" PRIu8 "\n"), finalLength, result);
 	return result;
 }
@@ -181,46 +506,92 @@ bool transportHALSend(const uint8_t nextRecipient, const MyMessage *outMsg, cons
 void transportHALPowerDown(void)
 {
 	transportPowerDown();
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+	transportSecondaryPowerDown();
+#endif
 }
 
 void transportHALPowerUp(void)
 {
 	transportPowerUp();
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+	transportSecondaryPowerUp();
+#endif
 }
 
 void transportHALSleep(void)
 {
 	transportSleep();
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+	transportSecondarySleep();
+#endif
 }
 
 void transportHALStandBy(void)
 {
 	transportStandBy();
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+	transportSecondaryStandBy();
+#endif
 }
 
+#if defined(TRANSPORT_HAL_TX_RSSI)
 int16_t transportHALGetSendingRSSI(void)
 {
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+	if (_transportHALTxSecondary) {
+		return transportSecondaryGetSendingRSSI();
+	}
+#endif
 	int16_t result = transportGetSendingRSSI();
 	return result;
 }
+#endif
 
+#if defined(TRANSPORT_HAL_RX_RSSI)
 int16_t transportHALGetReceivingRSSI(void)
 {
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+	if (_transportHALRxSecondary) {
+		return _transportHALSecondaryRxRSSI;
+	}
+#endif
+#if defined(TRANSPORT_HAL_RX_QUEUE)
+	int16_t result = _transportHALRxRSSI;
+#else
 	int16_t result = transportGetReceivingRSSI();
+#endif
 	return result;
 }
+#endif
 
+#if defined(TRANSPORT_HAL_SNR)
 int16_t transportHALGetSendingSNR(void)
 {
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+	if (_transportHALTxSecondary) {
+		return transportSecondaryGetSendingSNR();
+	}
+#endif
 	int16_t result = transportGetSendingSNR();
 	return result;
 }
 
 int16_t transportHALGetReceivingSNR(void)
 {
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+	if (_transportHALRxSecondary) {
+		return _transportHALSecondaryRxSNR;
+	}
+#endif
+#if defined(TRANSPORT_HAL_RX_QUEUE)
+	int16_t result = _transportHALRxSNR;
+#else
 	int16_t result = transportGetReceivingSNR();
+#endif
 	return result;
 }
+#endif
 
 int16_t transportHALGetTxPowerPercent(void)
 {
@@ -239,3 +610,36 @@ int16_t transportHALGetTxPowerLevel(void)
 	int16_t result = transportGetTxPowerLevel();
 	return result;
 }
+
+uint32_t transportHALGetAirtime(void)
+{
+#if defined(MY_GATEWAY_SECONDARY_RFM95)
+	return transportGetAirtime() + transportSecondaryGetAirtime();
+#else
+	return transportGetAirtime();
+#endif
+}
+
+#if defined(TRANSPORT_HAL_ACK_PAYLOAD)
+bool transportHALSetAckPayload(const nodeId_t nextRecipient, const MyMessage *outMsg,
+                               const uint8_t len)
+{
+	if (outMsg == NULL) {
+		// nothing to send
+		return false;
+	}
+	return transportSetAckPayload(nextRecipient, (const void *)&outMsg->last, len);
+}
+
+bool transportHALWithdrawAckPayload(const nodeId_t nextRecipient)
+{
+	return transportWithdrawAckPayload(nextRecipient);
+}
+#endif
+
+#if defined(TRANSPORT_HAL_WAKE_UP_PREAMBLE)
+void transportHALSetWakeUpPreamble(const uint32_t cycleMS)
+{
+	transportSetWakeUpPreamble(cycleMS);
+}
+#endif
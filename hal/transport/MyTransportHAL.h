@@ -52,19 +52,37 @@
 #if defined(MY_RADIO_NRF5_ESB)
 #error Receive message buffering not supported for NRF5 radio! Please define MY_NRF5_RX_BUFFER_SIZE
 #endif
-#if defined(MY_RADIO_RFM69)
-#error Receive message buffering not supported for RFM69!
-#endif
-#if defined(MY_RADIO_RFM95)
-#error Receive message buffering not supported for RFM95!
-#endif
-#if defined(MY_RS485)
-#error Receive message buffering not supported for RS485!
+#if defined(MY_RADIO_RFM69) || defined(MY_RADIO_RFM95) || defined(MY_RS485)
+#define TRANSPORT_HAL_RX_QUEUE	//!< received frames are queued by the HAL, RF24 queues in its driver
 #endif
 #elif defined(MY_RX_MESSAGE_BUFFER_SIZE)
 #error Receive message buffering requires message buffering feature enabled!
 #endif
 
+#if (defined(MY_RADIO_NRF5_ESB) && defined(MY_NRF5_ESB_ACK_PAYLOAD)) || (defined(MY_RADIO_RF24) && defined(MY_RF24_ACK_PAYLOAD))
+#define TRANSPORT_HAL_ACK_PAYLOAD	//!< the radio can send a message in the ACK of a received frame
+#endif
+
+#if defined(MY_RADIO_RFM69) && defined(MY_RFM69_NEW_DRIVER)
+#define TRANSPORT_HAL_WAKE_UP_PREAMBLE	//!< the radio can send frames with a preamble spanning a listen cycle
+#if defined(MY_RFM69_ENABLE_LISTENMODE)
+#define TRANSPORT_HAL_LISTEN_INTERRUPT	(MY_RFM69_IRQ_NUM)	//!< the radio listens while the MCU sleeps and wakes it on this interrupt
+#define TRANSPORT_HAL_LISTEN_CYCLE_MS	(RFM69_LISTEN_CYCLE_MS)	//!< listen cycle of the radio
+#endif
+#endif
+
+// Signal reports of the radio. Without them the getters below are constants, the compiler drops
+// the RSSI and SNR handling of the transport.
+#if !defined(MY_RS485) && !(defined(MY_RADIO_RFM69) && !defined(MY_RFM69_NEW_DRIVER))
+#define TRANSPORT_HAL_TX_RSSI	//!< the radio reports the RSSI of sent frames, from the ACK
+#endif
+#if (!defined(MY_RADIO_RF24) && !defined(MY_RS485)) || defined(MY_GATEWAY_SECONDARY_RFM95)
+#define TRANSPORT_HAL_RX_RSSI	//!< the radio reports the RSSI of received frames
+#endif
+#if defined(MY_RADIO_RFM95) || defined(MY_RADIO_REMOTE) || defined(MY_GATEWAY_SECONDARY_RFM95)
+#define TRANSPORT_HAL_SNR		//!< the radio reports the SNR of sent and received frames
+#endif
+
 /**
 * @brief Signal report selector
 */
@@ -88,11 +106,11 @@ bool transportHALInit(void);
 /**
 * @brief Set node address
 */
-void transportHALSetAddress(const uint8_t address);
+void transportHALSetAddress(const nodeId_t address);
 /**
 * @brief Retrieve node address
 */
-uint8_t transportHALGetAddress(void);
+nodeId_t transportHALGetAddress(void);
 /**
 * @brief Send message
 * @param to recipient
@@ -101,7 +119,7 @@ uint8_t transportHALGetAddress(void);
 * @param noACK do not wait for ACK
 * @return true if message sent successfully
 */
-bool transportHALSend(const uint8_t nextRecipient, const MyMessage *outMsg, const uint8_t len,
+bool transportHALSend(const nodeId_t nextRecipient, const MyMessage *outMsg, const uint8_t len,
                       const bool noACK);
 /**
 * @brief Verify if RX FIFO has pending messages
@@ -120,6 +138,21 @@ bool transportHALSanityCheck(void);
 * @return True if valid message received
 */
 bool transportHALReceive(MyMessage *inMsg, uint8_t *msgLength);
+#if defined(TRANSPORT_HAL_RX_QUEUE)
+/**
+* @brief Receive queue statistics, see transportHALGetRxQueueStats()
+*/
+typedef struct {
+	uint32_t queued;		//!< Frames taken from the radio into the queue
+	uint32_t overflows;		//!< Times a frame had to be left in the radio because the queue was full
+	uint8_t highWater;		//!< Highest number of frames queued at once
+} transportHALRxQueueStats_t;
+/**
+* @brief Receive queue statistics
+* @return counters since startup
+*/
+transportHALRxQueueStats_t transportHALGetRxQueueStats(void);
+#endif
 /**
 * @brief Power down transport HW (if corresponding MY_XYZ_POWER_PIN defined)
 */
@@ -140,22 +173,50 @@ void transportHALStandBy(void);
 * @brief transportGetSendingRSSI
 * @return RSSI of outgoing message (via ACK packet)
 */
+#if defined(TRANSPORT_HAL_TX_RSSI)
 int16_t transportHALGetSendingRSSI(void);
+#else
+inline int16_t transportHALGetSendingRSSI(void)
+{
+	return INVALID_RSSI;
+}
+#endif
 /**
 * @brief transportGetReceivingRSSI
 * @return RSSI of incoming message
 */
+#if defined(TRANSPORT_HAL_RX_RSSI)
 int16_t transportHALGetReceivingRSSI(void);
+#else
+inline int16_t transportHALGetReceivingRSSI(void)
+{
+	return INVALID_RSSI;
+}
+#endif
 /**
 * @brief transportGetSendingSNR
 * @return SNR of outgoing message (via ACK packet)
 */
+#if defined(TRANSPORT_HAL_SNR)
 int16_t transportHALGetSendingSNR(void);
+#else
+inline int16_t transportHALGetSendingSNR(void)
+{
+	return INVALID_SNR;
+}
+#endif
 /**
 * @brief transportGetReceivingSNR
 * @return SNR of incoming message
 */
+#if defined(TRANSPORT_HAL_SNR)
 int16_t transportHALGetReceivingSNR(void);
+#else
+inline int16_t transportHALGetReceivingSNR(void)
+{
+	return INVALID_SNR;
+}
+#endif
 /**
 * @brief transportGetTxPowerPercent
 * @return TX power level in percent
@@ -172,5 +233,38 @@ bool transportHALSetTxPowerPercent(const uint8_t powerPercent);
 * @return TX power in dBm
 */
 int16_t transportHALGetTxPowerLevel(void);
+/**
+* @brief Time on air of all frames sent by the radio, computed by the driver from the frame
+* length and the modem settings, including retries and ACKs sent by the driver. With
+* @ref MY_GATEWAY_SECONDARY_RFM95 the time on air of both radios.
+* @return Time on air in us, wraps around
+*/
+uint32_t transportHALGetAirtime(void);
+#if defined(TRANSPORT_HAL_ACK_PAYLOAD)
+/**
+* @brief Send a message in the ACK of the next frame received from nextRecipient. Replaces a
+* payload still pending for nextRecipient. The payload is sent at most once, with no retries.
+* @param nextRecipient
+* @param outMsg
+* @param len Message length including the header
+* @return true if the payload is pending
+*/
+bool transportHALSetAckPayload(const nodeId_t nextRecipient, const MyMessage *outMsg,
+                               const uint8_t len);
+/**
+* @brief Drop the payload pending for nextRecipient
+* @param nextRecipient
+* @return true if it was still pending, false if there was none or it has been sent
+*/
+bool transportHALWithdrawAckPayload(const nodeId_t nextRecipient);
+#endif
+#if defined(TRANSPORT_HAL_WAKE_UP_PREAMBLE)
+/**
+* @brief Send the next frames with a preamble spanning a listen cycle, a receiver in listen
+* mode wakes on it
+* @param cycleMS Listen cycle of the receiver, 0 for the default preamble
+*/
+void transportHALSetWakeUpPreamble(const uint32_t cycleMS);
+#endif
 
 #endif // MyTransportHAL_h
@@ -22,10 +22,17 @@
 #include "hal/transport/NRF5_ESB/driver/Radio.h"
 #include "hal/transport/NRF5_ESB/driver/Radio_ESB.h"
 
-#include "drivers/CircularBuffer/CircularBuffer.h"
+#include "drivers/CircularBuffer/SPSCCircularBuffer.h"
 
 bool transportInit(void)
 {
+#if !defined(MY_GATEWAY_FEATURE) && defined(MY_NRF5_ESB_ATC_MODE)
+	// only enable ATC mode in nodes
+	NRF5_ESB_ATCmode(true, MY_NRF5_ESB_ATC_TARGET_RSSI);
+#else
+	// ATC mode function not used
+	(void)NRF5_ESB_ATCmode;
+#endif
 	return NRF5_ESB_initialize();
 }
 
@@ -45,6 +52,23 @@ bool transportSend(const uint8_t to, const void *data, const uint8_t len, const
 	return NRF5_ESB_sendMessage(to, data, len, noACK);
 }
 
+uint32_t transportGetAirtime(void)
+{
+	return NRF5_ESB_getAirtime();
+}
+
+#if defined(MY_NRF5_ESB_ACK_PAYLOAD)
+bool transportSetAckPayload(const uint8_t recipient, const void *data, const uint8_t len)
+{
+	return NRF5_ESB_setAckPayload(recipient, data, len);
+}
+
+bool transportWithdrawAckPayload(const uint8_t recipient)
+{
+	return NRF5_ESB_withdrawAckPayload(recipient);
+}
+#endif
+
 bool transportDataAvailable(void)
 {
 	return NRF5_ESB_isDataAvailable();
@@ -22,24 +22,54 @@
 #include "Radio.h"
 #include "Radio_ESB.h"
 #include "hal/architecture/NRF5/MyHwNRF5.h"
-#include "drivers/CircularBuffer/CircularBuffer.h"
+#include "drivers/CircularBuffer/SPSCCircularBuffer.h"
 #include <stdio.h>
 
 // internal functions
 static uint8_t reverse_byte(uint8_t address);
 inline void _stopTimer();
 inline void _stopACK();
+static NRF5_ESB_Packet *_allocRX();
+static void _releaseRX(NRF5_ESB_Packet *packet);
+static void _prepareACK(const uint8_t pid, const uint8_t last, const int8_t rssi,
+                        const bool newPacket);
 
 // RX Buffer
-static NRF5_ESB_Packet rx_circular_buffer_buffer[MY_NRF5_ESB_RX_BUFFER_SIZE];
-// Poiter to rx circular buffer
-static NRF5_ESB_Packet rx_buffer;
-// Circular buffer
-static CircularBuffer<NRF5_ESB_Packet>
-rx_circular_buffer(rx_circular_buffer_buffer, MY_NRF5_ESB_RX_BUFFER_SIZE);
+// EasyDMA receives straight into a pool of packet buffers. Filled buffers are handed from the
+// radio IRQ to the transport by pointer and come back the same way once read, a packet is
+// copied only once, by NRF5_ESB_readMessage().
+static NRF5_ESB_Packet rx_pool[NRF5_ESB_RX_POOL_SIZE];
+// Filled buffers, radio IRQ -> transport
+static SPSCCircularBuffer<NRF5_ESB_Packet *, SPSC_CIRCULAR_BUFFER_SIZE(NRF5_ESB_RX_POOL_SIZE)>
+rx_filled;
+// Free buffers, transport -> radio IRQ
+static SPSCCircularBuffer<NRF5_ESB_Packet *, SPSC_CIRCULAR_BUFFER_SIZE(NRF5_ESB_RX_POOL_SIZE)>
+rx_free;
+// Buffer for the next reception, written to PACKETPTR
+static NRF5_ESB_Packet *volatile rx_armed = NULL;
+// Buffer of the ongoing reception
+static NRF5_ESB_Packet *rx_current = NULL;
+// Buffer given back by the radio IRQ, which cannot push to rx_free
+static NRF5_ESB_Packet *rx_spare = NULL;
+// Receives while the pool is exhausted, the packet is dropped and not acknowledged
+static NRF5_ESB_Packet rx_drop;
 // Dedect duplicate packages for every pipe available
 static volatile uint32_t package_ids[8];
 
+// ACK packet, carries the RSSI of the received packet or a payload
+static NRF5_ESB_Packet ack_buffer;
+#if defined(MY_NRF5_ESB_ACK_PAYLOAD)
+// Payloads waiting for the next packet of a node
+static struct {
+	volatile bool pending;
+	uint8_t node;
+	uint8_t len;
+	uint8_t data[MAX_MESSAGE_LENGTH];
+} ack_payloads[MY_NRF5_ESB_ACK_PAYLOAD_SLOTS];
+// Node the payload in ack_buffer went to, repeated when the node retransmits
+static uint8_t ack_payload_node = BROADCAST_ADDRESS;
+#endif
+
 // TX Buffer
 static NRF5_ESB_Packet tx_buffer;
 // remaining TX retries
@@ -54,16 +84,31 @@ static volatile bool events_end_tx;
 static volatile int16_t rssi_rx;
 // Last RSSI sample by last package
 static volatile int16_t rssi_tx;
+// Time on air of transmitted frames in us
+static uint32_t airtime = 0;
 // Buffer node address
 static uint8_t node_address = 0;
 // TX power level
 static int8_t tx_power_level = (MY_NRF5_ESB_PA_LEVEL << RADIO_TXPOWER_TXPOWER_Pos);
+// ATC enabled
+static bool atc_enabled = false;
+// ATC target RSSI
+static int16_t atc_target_rssi = MY_NRF5_ESB_ATC_TARGET_RSSI;
 
 // Initialize radio unit
 static bool NRF5_ESB_initialize()
 {
 	NRF5_RADIO_DEBUG(PSTR("NRF5:INIT:ESB\n"));
 
+	// Fill the RX pool once, received packets are kept across power down
+	if (rx_armed == NULL) {
+		for (uint8_t i = 1; i < NRF5_ESB_RX_POOL_SIZE; i++) {
+			NRF5_ESB_Packet *packet = &rx_pool[i];
+			(void)rx_free.pushFront(&packet);
+		}
+		rx_armed = &rx_pool[0];
+	}
+
 #if defined(SOFTDEVICE_PRESENT)
 	// Disable the SoftDevice; requires NRF5 SDK available
 	sd_softdevice_disable();
@@ -288,6 +333,9 @@ static void NRF5_ESB_startListening()
 	// Enable RX when ready, Enable RX after disabling task
 	NRF_RADIO->SHORTS = NRF5_ESB_SHORTS_RX;
 
+	// Receive into the armed pool buffer
+	NRF_RADIO->PACKETPTR = (uint32_t)rx_armed;
+
 	// Switch to RX
 	if (NRF_RADIO->STATE == RADIO_STATE_STATE_Disabled) {
 		NRF_RADIO->TASKS_RXEN = 1;
@@ -298,17 +346,18 @@ static void NRF5_ESB_startListening()
 
 static bool NRF5_ESB_isDataAvailable()
 {
-	return rx_circular_buffer.available() > 0;
+	return rx_filled.available() > 0;
 }
 
 static uint8_t NRF5_ESB_readMessage(void *data)
 {
 	uint8_t ret = 0;
 
-	// get content from rx buffer
-	NRF5_ESB_Packet *buffer = rx_circular_buffer.getBack();
+	// get next filled buffer
+	NRF5_ESB_Packet **filled = rx_filled.getBack();
 	// Nothing to read?
-	if (buffer != NULL) {
+	if (filled != NULL) {
+		NRF5_ESB_Packet *buffer = *filled;
 		// copy content
 		memcpy(data, buffer->data, buffer->len);
 		ret = buffer->len;
@@ -321,13 +370,61 @@ static uint8_t NRF5_ESB_readMessage(void *data)
 		                 buffer->len, buffer->noack, buffer->pid, rssi_rx, buffer->rxmatch);
 #endif
 
-		// release buffer
-		rx_circular_buffer.popBack();
+		// release buffer, it goes back to the radio
+		(void)rx_filled.popBack();
+		(void)rx_free.pushFront(&buffer);
 	}
 
 	return ret;
 }
 
+#if defined(MY_NRF5_ESB_ACK_PAYLOAD)
+static bool NRF5_ESB_setAckPayload(const uint8_t recipient, const void *buf, uint8_t len)
+{
+	bool result = false;
+	if (len > MAX_MESSAGE_LENGTH) {
+		len = MAX_MESSAGE_LENGTH;
+	}
+	MY_CRITICAL_SECTION {
+		int8_t slot = -1;
+		for (uint8_t i = 0; i < MY_NRF5_ESB_ACK_PAYLOAD_SLOTS; i++) {
+			if (ack_payloads[i].pending && ack_payloads[i].node == recipient) {
+				// replace the payload of the node
+				slot = i;
+				break;
+			}
+			if (!ack_payloads[i].pending && slot < 0) {
+				slot = i;
+			}
+		}
+		if (slot >= 0) {
+			(void)memcpy(ack_payloads[slot].data, buf, len);
+			ack_payloads[slot].len = len;
+			ack_payloads[slot].node = recipient;
+			ack_payloads[slot].pending = true;
+			result = true;
+		}
+	}
+	NRF5_RADIO_DEBUG(PSTR("NRF5:APL:SET,TO=%" PRIu8 ",LEN=%" PRIu8 ",OK=%" PRIu8 "\n"), recipient, len,
+	                 result);
+	return result;
+}
+
+static bool NRF5_ESB_withdrawAckPayload(const uint8_t recipient)
+{
+	bool result = false;
+	MY_CRITICAL_SECTION {
+		for (uint8_t i = 0; i < MY_NRF5_ESB_ACK_PAYLOAD_SLOTS; i++) {
+			if (ack_payloads[i].pending && ack_payloads[i].node == recipient) {
+				ack_payloads[i].pending = false;
+				result = true;
+			}
+		}
+	}
+	return result;
+}
+#endif
+
 void NRF5_ESB_endtx();
 void NRF5_ESB_starttx()
 {
@@ -487,6 +584,15 @@ static bool NRF5_ESB_sendMessage(uint8_t recipient, const void *buf, uint8_t len
 	// Enable listening on Node and BC address
 	NRF_RADIO->RXADDRESSES = (1 << NRF5_ESB_NODE_ADDR) | (1 << NRF5_ESB_BC_ADDR);
 
+	// Account time on air of all transmissions: preamble, address, 9 bit length and S1, payload, CRC16
+	const uint32_t frames = max(1, tx_retries_start - tx_retries);
+	airtime += (frames * (8 * (1 + MY_NRF5_ESB_ADDR_WIDTH + len + 2) + 9) << NRF5_ESB_byte_time()) / 8;
+
+	// Adjust TX level on frames with ACK
+	if (atc_enabled && recipient != BROADCAST_ADDRESS && noACK == false) {
+		NRF5_ESB_executeATC(ack_received, rssi_tx);
+	}
+
 #ifdef MY_DEBUG_VERBOSE_NRF5_ESB
 	NRF5_RADIO_DEBUG(PSTR("NRF5:SND:END=%" PRIu8 ",ACK=%" PRIu8 ",RTRY=%" PRIi8 ",RSSI=%" PRIi16
 	                      ",WAKE=%" PRIu32 "\n"),
@@ -497,6 +603,11 @@ static bool NRF5_ESB_sendMessage(uint8_t recipient, const void *buf, uint8_t len
 	return ack_received;
 };
 
+static uint32_t NRF5_ESB_getAirtime()
+{
+	return airtime;
+}
+
 static int16_t NRF5_ESB_getSendingRSSI()
 {
 	return rssi_tx;
@@ -507,6 +618,51 @@ static int16_t NRF5_ESB_getReceivingRSSI()
 	return rssi_rx;
 }
 
+static void NRF5_ESB_ATCmode(const bool OnOff, const int16_t targetRSSI)
+{
+	atc_enabled = OnOff;
+	atc_target_rssi = targetRSSI;
+}
+
+static void NRF5_ESB_executeATC(const bool ACKreceived, const int16_t RSSI)
+{
+	int8_t level = (int8_t)NRF_RADIO->TXPOWER;
+	/* TX levels used: NRF5_PA_LOW..0dBm in steps of NRF5_ESB_ATC_STEP_DBM
+	 * and MY_NRF5_ESB_PA_LEVEL, valid on all nRF5 variants
+	 */
+	if (!ACKreceived || RSSI < atc_target_rssi - NRF5_ESB_ATC_TARGET_RANGE_DBM) {
+		// increase transmitter power, no ACK may be out of reach
+		if (level >= (int8_t)MY_NRF5_ESB_PA_LEVEL) {
+			return;
+		}
+		if (level < (int8_t)NRF5_PA_LOW) {
+			level = (int8_t)NRF5_PA_LOW;
+		} else if (level < 0) {
+			level += NRF5_ESB_ATC_STEP_DBM;
+		} else {
+			level = (int8_t)MY_NRF5_ESB_PA_LEVEL;
+		}
+		if (level > (int8_t)MY_NRF5_ESB_PA_LEVEL) {
+			level = (int8_t)MY_NRF5_ESB_PA_LEVEL;
+		}
+	} else if (RSSI > atc_target_rssi + NRF5_ESB_ATC_TARGET_RANGE_DBM) {
+		// decrease transmitter power
+		if (level <= (int8_t)NRF5_PA_LOW) {
+			return;
+		}
+		level = (level > 0) ? 0 : level - NRF5_ESB_ATC_STEP_DBM;
+		if (level < (int8_t)NRF5_PA_LOW) {
+			level = (int8_t)NRF5_PA_LOW;
+		}
+	} else {
+		// nothing to adjust
+		return;
+	}
+	NRF5_RADIO_DEBUG(PSTR("NRF5:ATC:ADJ TXL,cR=%" PRIi16 ",tR=%" PRIi16 ",TXL=%" PRIi8 "\n"),
+	                 RSSI, atc_target_rssi, level);
+	NRF_RADIO->TXPOWER = (uint8_t)level;
+}
+
 /*
  * Internal helper functions
  */
@@ -530,6 +686,66 @@ inline void _stopTimer()
 	NRF5_RADIO_TIMER->TASKS_SHUTDOWN = 1;
 }
 
+// Take a free buffer of the pool, called from the radio IRQ
+static NRF5_ESB_Packet *_allocRX()
+{
+	NRF5_ESB_Packet *packet = rx_spare;
+	if (packet != NULL) {
+		rx_spare = NULL;
+		return packet;
+	}
+	NRF5_ESB_Packet **next = rx_free.getBack();
+	if (next == NULL) {
+		// pool exhausted, the packet will be dropped
+		return &rx_drop;
+	}
+	packet = *next;
+	(void)rx_free.popBack();
+	return packet;
+}
+
+// Give back a buffer that was not handed to the transport, called from the radio IRQ
+static void _releaseRX(NRF5_ESB_Packet *packet)
+{
+	if (packet != NULL && packet != &rx_drop) {
+		// one allocation per received packet, so the spare is free
+		rx_spare = packet;
+	}
+}
+
+// Fill the ACK for a packet of node last, called from the radio IRQ before the ACK is sent
+static void _prepareACK(const uint8_t pid, const uint8_t last, const int8_t rssi,
+                        const bool newPacket)
+{
+	ack_buffer.pid = pid;
+#ifndef MY_NRF5_ESB_REVERSE_ACK_TX
+	ack_buffer.noack = 1;
+#else
+	ack_buffer.noack = 0;
+#endif
+#if defined(MY_NRF5_ESB_ACK_PAYLOAD)
+	if (!newPacket && last == ack_payload_node) {
+		// retransmitted packet, the payload in ack_buffer is sent again
+		return;
+	}
+	ack_payload_node = BROADCAST_ADDRESS;
+	for (uint8_t i = 0; i < MY_NRF5_ESB_ACK_PAYLOAD_SLOTS; i++) {
+		if (ack_payloads[i].pending && ack_payloads[i].node == last) {
+			(void)memcpy(ack_buffer.data, ack_payloads[i].data, ack_payloads[i].len);
+			ack_buffer.len = ack_payloads[i].len;
+			ack_payloads[i].pending = false;
+			ack_payload_node = last;
+			return;
+		}
+	}
+#else
+	(void)last;
+	(void)newPacket;
+#endif
+	ack_buffer.data[0] = rssi;
+	ack_buffer.len = 1;
+}
+
 inline void _stopACK()
 {
 	// Enable RX when ready, Enable RX after disabling task
@@ -571,13 +787,20 @@ extern "C" {
 
 			// In RX mode -> prepare ACK or RX
 			if (NRF_RADIO->STATE == RADIO_STATE_STATE_Rx) {
+				// A reception without END, e.g. cut off by a TX, gives its buffer back
+				_releaseRX(rx_current);
+				// The armed buffer was taken by the START of this packet, arm the next one
+				rx_current = rx_armed;
+				rx_armed = _allocRX();
 				// Send ACK only for node address, don't care about the ACK bit to handle bad nRF24 clones
 				if (NRF_RADIO->RXMATCH == NRF5_ESB_NODE_ADDR) {
-					// Send ACK after END, an empty packet is provided in READY event
+					// Send ACK after END, the ACK packet is filled in END event
 					NRF_RADIO->SHORTS = NRF5_ESB_SHORTS_RX_TX;
+					NRF_RADIO->PACKETPTR = (uint32_t)&ack_buffer;
 				} else {
-					// No ACK -> Start RX after END
+					// No ACK -> Start RX after END, which takes the next buffer right away
 					NRF_RADIO->SHORTS = NRF5_ESB_SHORTS_RX;
+					NRF_RADIO->PACKETPTR = (uint32_t)rx_armed;
 				}
 
 				// Handle incoming ACK packet
@@ -591,7 +814,13 @@ extern "C" {
 					NRF5_RADIO_TIMER->TASKS_CAPTURE[1] = 1;
 
 					// Set Timer compare register 0 to end of packet (len+CRC)
-					NRF5_RADIO_TIMER->CC[1] += ((rx_buffer.len + 3) << NRF5_ESB_byte_time());
+					NRF5_RADIO_TIMER->CC[1] += ((rx_current->len + 3) << NRF5_ESB_byte_time());
+#if defined(MY_NRF5_ESB_ACK_PAYLOAD)
+					// Don't retransmit while an ACK with payload is still received
+					if (NRF5_RADIO_TIMER->CC[3] < NRF5_RADIO_TIMER->CC[1] + NRF5_ESB_RAMP_UP_TIME) {
+						NRF5_RADIO_TIMER->CC[3] = NRF5_RADIO_TIMER->CC[1] + NRF5_ESB_RAMP_UP_TIME;
+					}
+#endif
 				}
 			} else {
 				// Current mode is TX:
@@ -610,11 +839,9 @@ extern "C" {
 #ifdef MY_DEBUG_VERBOSE_NRF5_ESB
 			intcntr_ready++;
 #endif
-			// Configure DMA target address
-			NRF_RADIO->PACKETPTR = (uint32_t)&rx_buffer;
-
-			/* Don't care about if next packet RX or ACK,
-			 * prepare current rx_buffer to send an ACK */
+			/* The START of this RX or TX has taken its buffer already,
+			 * the next START after TX is always a RX */
+			NRF_RADIO->PACKETPTR = (uint32_t)rx_armed;
 
 			// Set outgoing address to node address for ACK packages
 			NRF_RADIO->TXADDRESS = NRF5_ESB_NODE_ADDR;
@@ -636,44 +863,57 @@ extern "C" {
 			        (NRF_RADIO->STATE == RADIO_STATE_STATE_RxIdle) or
 			        (NRF_RADIO->STATE == RADIO_STATE_STATE_RxDisable) or
 			        (NRF_RADIO->STATE == RADIO_STATE_STATE_TxRu)) {
-				if (NRF_RADIO->CRCSTATUS) {
+				NRF5_ESB_Packet *packet = rx_current;
+				rx_current = NULL;
+				if (packet == NULL) {
+					// END without BCMATCH, nothing was received into the pool
+				} else if (NRF_RADIO->CRCSTATUS) {
 					// Ensure no ACK package is received
 					if (NRF_RADIO->RXMATCH != NRF5_ESB_TX_ADDR) {
 						// calculate a package id
-						uint32_t pkgid = rx_buffer.pid << 16 | NRF_RADIO->RXCRC;
+						uint32_t pkgid = packet->pid << 16 | NRF_RADIO->RXCRC;
+						// hop the packet comes from, first byte of the MySensors header
+						const uint8_t last = packet->data[0];
+						const int8_t rssi = NRF_RADIO->RSSISAMPLE;
 						if (pkgid != package_ids[NRF_RADIO->RXMATCH]) {
 							// correct package -> store id to dedect duplicates
 							package_ids[NRF_RADIO->RXMATCH] = pkgid;
-							rx_buffer.rssi = NRF_RADIO->RSSISAMPLE;
+							packet->rssi = rssi;
 #ifdef MY_DEBUG_VERBOSE_NRF5_ESB
 							// Store debug data
-							rx_buffer.rxmatch = NRF_RADIO->RXMATCH;
+							packet->rxmatch = NRF_RADIO->RXMATCH;
 #endif
-							// Push data to buffer
-							if (rx_circular_buffer.pushFront(&rx_buffer)) {
+							// Hand the buffer over, no copy
+							if (packet != &rx_drop && rx_filled.pushFront(&packet)) {
 								// Prepare ACK package
-								rx_buffer.data[0]=rx_buffer.rssi;
-								rx_buffer.len=1; // data[0] is set some lines before
-#ifndef MY_NRF5_ESB_REVERSE_ACK_TX
-								rx_buffer.noack = 1;
-#else
-								rx_buffer.noack = 0;
-#endif
+								_prepareACK(packet->pid, last, rssi, true);
 							} else {
 								// Buffer is full
+								_releaseRX(packet);
 								// Stop ACK
 								_stopACK();
 								// Increment pkgid allowing receive the package again
 								package_ids[NRF_RADIO->RXMATCH]++;
 							}
+						} else {
+							// Duplicate, the sender missed the ACK
+							_releaseRX(packet);
+							_prepareACK(packet->pid, last, rssi, false);
 						}
 					} else {
 						// ACK package received, ducplicates are accepted
 
 						// rssi value in ACK included?
-						if (rx_buffer.len == 1) {
-							rssi_tx = 0-rx_buffer.data[0];
+						if (packet->len == 1) {
+							rssi_tx = 0-packet->data[0];
+#if defined(MY_NRF5_ESB_ACK_PAYLOAD)
+						} else if (packet->len > 2 && packet->data[2] == node_address &&
+						           packet != &rx_drop && rx_filled.pushFront(&packet)) {
+							// ACK payload for this node, a message as received, no copy
+							packet = NULL;
+#endif
 						}
+						_releaseRX(packet);
 						// notify TX process
 						ack_received = true;
 						// End TX
@@ -681,6 +921,7 @@ extern "C" {
 					}
 				} else {
 					/** Invalid CRC -> Switch back to RX, Stop sending ACK */
+					_releaseRX(packet);
 					_stopACK();
 				}
 			} else {
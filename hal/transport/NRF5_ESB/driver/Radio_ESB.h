@@ -34,6 +34,12 @@
 #if MY_NRF5_ESB_RX_BUFFER_SIZE < (4)
 #error "MY_NRF5_ESB_RX_BUFFER_SIZE must be greater than 3."
 #endif
+#if MY_NRF5_ESB_RX_BUFFER_SIZE > (126)
+#error "MY_NRF5_ESB_RX_BUFFER_SIZE must not exceed 126."
+#endif
+
+// RX buffers: the queued ones, the one being received into and the one armed for the next packet
+#define NRF5_ESB_RX_POOL_SIZE (MY_NRF5_ESB_RX_BUFFER_SIZE + 2)
 
 /** Wait for start of an ACK packet in us
  * Calculation: ramp up time + packet header (57 Bit): round to 9 Byte
@@ -117,6 +123,12 @@
  */
 #define NRF5_ESB_RAMP_UP_TIME (140)
 
+// ATC target range +/- dBm, wider than the step between TX levels
+#define NRF5_ESB_ATC_TARGET_RANGE_DBM (5)
+
+// ATC step between TX levels below 0dBm
+#define NRF5_ESB_ATC_STEP_DBM (4)
+
 
 static bool NRF5_ESB_initialize();
 static void NRF5_ESB_powerDown();
@@ -133,10 +145,21 @@ static bool NRF5_ESB_isDataAvailable();
 static uint8_t NRF5_ESB_readMessage(void *data);
 
 static bool NRF5_ESB_sendMessage(uint8_t recipient, const void *buf, uint8_t len, const bool noACK);
+#if defined(MY_NRF5_ESB_ACK_PAYLOAD)
+// Send buf in the ACK of the next packet from recipient, replaces a pending payload for it
+static bool NRF5_ESB_setAckPayload(const uint8_t recipient, const void *buf, uint8_t len);
+// Drop the pending payload for recipient, false if there was none or it has been sent
+static bool NRF5_ESB_withdrawAckPayload(const uint8_t recipient);
+#endif
+// Time on air of all transmitted frames including retransmits in us, wraps around
+static uint32_t NRF5_ESB_getAirtime();
 
 static int16_t NRF5_ESB_getSendingRSSI();
 static int16_t NRF5_ESB_getReceivingRSSI();
 
+static void NRF5_ESB_ATCmode(const bool OnOff, const int16_t targetRSSI);
+static void NRF5_ESB_executeATC(const bool ACKreceived, const int16_t RSSI);
+
 // Calculate time to transmit an byte in us as bit shift -> 2^X
 static inline uint8_t NRF5_ESB_byte_time();
 
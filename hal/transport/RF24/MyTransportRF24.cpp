@@ -20,18 +20,19 @@
 #include "hal/transport/RF24/driver/RF24.h"
 
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
-#include "drivers/CircularBuffer/CircularBuffer.h"
+#include "drivers/CircularBuffer/SPSCCircularBuffer.h"
 
 typedef struct _transportQueuedMessage {
 	uint8_t m_len;                        // Length of the data
 	uint8_t m_data[MAX_MESSAGE_LENGTH];   // The raw data
+#if defined(MY_STATS_LATENCY)
+	uint32_t m_stamp;                     // Time of the IRQ
+#endif
 } transportQueuedMessage;
 
-/** Buffer to store queued messages in. */
-static transportQueuedMessage transportRxQueueStorage[MY_RX_MESSAGE_BUFFER_SIZE];
-/** Circular buffer, which uses the transportRxQueueStorage and administers stored messages. */
-static CircularBuffer<transportQueuedMessage> transportRxQueue(transportRxQueueStorage,
-        MY_RX_MESSAGE_BUFFER_SIZE);
+/** Circular buffer of queued messages, filled from the IRQ handler and drained by the transport. */
+static SPSCCircularBuffer<transportQueuedMessage, SPSC_CIRCULAR_BUFFER_SIZE(MY_RX_MESSAGE_BUFFER_SIZE)>
+transportRxQueue;
 
 static volatile uint8_t transportLostMessageCount = 0;
 
@@ -42,10 +43,17 @@ static void transportRxCallback(void)
 	if (!transportRxQueue.full()) {
 		transportQueuedMessage* msg = transportRxQueue.getFront();
 		msg->m_len = RF24_readMessage(msg->m_data);		// Read payload & clear RX_DR
-		(void)transportRxQueue.pushFront(msg);
+#if defined(MY_STATS_LATENCY)
+		msg->m_stamp = statsLatencyStamp();
+#endif
+		if (msg->m_len > 0) {
+			// nothing to queue for an invalid frame or an ACK payload for another node
+			(void)transportRxQueue.pushFront(msg);
+		}
 	} else {
 		// Queue is full. Discard message.
 		(void)RF24_readMessage(NULL);		// Read payload & clear RX_DR
+		STATS_INC(STATS_RX_OVERFLOWS);
 		// Keep track of messages lost. Max 255, prevent wrapping.
 		if (transportLostMessageCount < 255) {
 			++transportLostMessageCount;
@@ -58,28 +66,62 @@ bool transportInit(void)
 {
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
 	RF24_registerReceiveCallback( transportRxCallback );
+#endif
+#if !defined(MY_GATEWAY_FEATURE) && defined(MY_RF24_ATC_MODE)
+	// only enable ATC mode in nodes
+	RF24_ATCmode(true);
+#else
+	// ATC mode function not used
+	(void)RF24_ATCmode;
+#endif
+#if defined(__linux__)
+	if (conf.rf24_channel >= 0) {
+		// channel plan of this gateway from the config file
+		RF24_channel = static_cast<uint8_t>(conf.rf24_channel);
+	}
 #endif
 	return RF24_initialize();
 }
 
-void transportSetAddress(const uint8_t address)
+void transportSetAddress(const nodeId_t address)
 {
 	RF24_setNodeAddress(address);
 	RF24_startListening();
 }
 
-uint8_t transportGetAddress(void)
+nodeId_t transportGetAddress(void)
 {
 	return RF24_getNodeID();
 }
 
-bool transportSend(const uint8_t to, const void *data, const uint8_t len, const bool noACK)
+bool transportSend(const nodeId_t to, const void *data, const uint8_t len, const bool noACK)
 {
 	return RF24_sendMessage(to, data, len, noACK);
 }
 
+uint32_t transportGetAirtime(void)
+{
+	return RF24_getAirtime();
+}
+
+#if defined(MY_RF24_ACK_PAYLOAD)
+bool transportSetAckPayload(const nodeId_t recipient, const void *data, const uint8_t len)
+{
+	return RF24_setAckPayload(recipient, data, len);
+}
+
+bool transportWithdrawAckPayload(const nodeId_t recipient)
+{
+	return RF24_withdrawAckPayload(recipient);
+}
+#endif
+
 bool transportDataAvailable(void)
 {
+#if defined(MY_RF24_LINK_DATARATE) && (defined(MY_GATEWAY_FEATURE) || defined(MY_REPEATER_FEATURE))
+	// children may send at either data rate
+	RF24_hopDataRate();
+#endif
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
 	(void)RF24_isDataAvailable;				// Prevent 'defined but not used' warning
 	return !transportRxQueue.empty();
@@ -101,6 +143,7 @@ uint8_t transportReceive(void *data)
 	if (msg) {
 		len = msg->m_len;
 		(void)memcpy(data, msg->m_data, len);
+		STATS_UPLINK_BEGIN(msg->m_stamp);
 		(void)transportRxQueue.popBack();
 	}
 #else
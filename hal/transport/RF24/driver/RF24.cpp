@@ -30,10 +30,47 @@
 #endif
 
 LOCAL uint8_t RF24_BASE_ID[MY_RF24_ADDR_WIDTH] = { MY_RF24_BASE_RADIO_ID };
-LOCAL uint8_t RF24_NODE_ADDRESS = RF24_BROADCAST_ADDRESS;
+LOCAL nodeId_t RF24_NODE_ADDRESS = RF24_BROADCAST_ADDRESS;
+LOCAL uint8_t RF24_channel = MY_RF24_CHANNEL;
+LOCAL bool RF24_ATCenabled = false;
+LOCAL uint8_t RF24_ATCcleanFrames = 0;
+
+// registers are retained in power down, only the oscillator has to start up before CE goes high
+LOCAL uint32_t RF24_standByMicros = 0;
+LOCAL bool RF24_standByPending = false;
+// time on air of the transmitted frames in us
+LOCAL uint32_t RF24_airtime = 0;
 
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
 LOCAL RF24_receiveCallbackType RF24_receiveCallback = NULL;
+// STATUS with TX_DS or MAX_RT as caught by the IRQ handler, 0 while the transmission is ongoing
+LOCAL volatile uint8_t RF24_txStatus = 0;
+#endif
+
+#if defined(MY_RF24_ACK_PAYLOAD)
+// Payloads waiting for a node, loaded into the TX FIFO when a frame of the node is received
+LOCAL struct {
+	volatile bool pending;
+	nodeId_t node;
+	uint8_t len;
+	uint8_t data[32];
+} RF24_ackPayloads[MY_RF24_ACK_PAYLOAD_SLOTS];
+// Node whose payload is in the TX FIFO, it leaves with the ACK of the next frame on pipe 0
+LOCAL volatile nodeId_t RF24_ackPayloadLoaded = RF24_BROADCAST_ADDRESS;
+// RX FIFO was empty when the transmission started, a frame received with its ACK is read next
+LOCAL volatile bool RF24_ackPayloadRxEmpty = false;
+// the frame read next came with an ACK of the parent
+LOCAL volatile bool RF24_ackPayloadNext = false;
+#endif
+
+#if defined(MY_RF24_LINK_DATARATE)
+// data rate of the next transmission, and of listening
+LOCAL uint8_t RF24_txDataRate = MY_RF24_DATARATE;
+LOCAL uint8_t RF24_rxDataRate = MY_RF24_DATARATE;
+LOCAL uint32_t RF24_rxDataRateSince = 0;
+// one bit per node that did not take a frame at MY_RF24_LINK_DATARATE, by the low byte of 16 bit ids
+LOCAL uint8_t RF24_linkSlow[32];
+LOCAL uint8_t RF24_linkProbeCount = 0;
 #endif
 
 #if defined(__linux__)
@@ -53,6 +90,14 @@ LOCAL void RF24_csn(const bool level)
 
 LOCAL void RF24_ce(const bool level)
 {
+	if (level && RF24_standByPending) {
+		// wait for what is left of the power down to standby delay
+		const uint32_t elapsed = hwMicros() - RF24_standByMicros;
+		if (elapsed < RF24_STANDBY_DELAY_US) {
+			delayMicroseconds(RF24_STANDBY_DELAY_US - elapsed);
+		}
+		RF24_standByPending = false;
+	}
 	hwDigitalWrite(MY_RF24_CE_PIN, level);
 }
 
@@ -67,8 +112,10 @@ LOCAL uint8_t RF24_spiMultiByteTransfer(const uint8_t cmd, uint8_t *buf, uint8_t
 #endif
 
 	RF24_csn(LOW);
+#if MY_RF24_SPI_CSN_DELAY_US > 0 && !defined(__linux__)
 	// timing
-	delayMicroseconds(10);
+	delayMicroseconds(MY_RF24_SPI_CSN_DELAY_US);
+#endif
 #ifdef __linux__
 	uint8_t *prx = RF24_spi_rxbuff;
 	uint8_t *ptx = RF24_spi_txbuff;
@@ -98,6 +145,16 @@ LOCAL uint8_t RF24_spiMultiByteTransfer(const uint8_t cmd, uint8_t *buf, uint8_t
 	}
 #else
 	status = RF24_SPI.transfer(cmd);
+#if defined(MY_HW_HAS_SPI_DMA) && !defined(MY_SOFTSPI)
+	if (buf != NULL && len >= MY_SPI_DMA_MIN_LENGTH) {
+		// payload bytes back to back, CS stays low until the transfer is done
+		hwSPITransferDMA(readMode ? NULL : buf, readMode ? buf : NULL, len);
+		if (readMode) {
+			status = buf[len - 1];
+		}
+		len = 0;
+	}
+#endif
 	while ( len-- ) {
 		if (readMode) {
 			status = RF24_SPI.transfer(RF24_CMD_NOP);
@@ -114,8 +171,10 @@ LOCAL uint8_t RF24_spiMultiByteTransfer(const uint8_t cmd, uint8_t *buf, uint8_t
 #if !defined(MY_SOFTSPI) && defined(SPI_HAS_TRANSACTION)
 	RF24_SPI.endTransaction();
 #endif
+#if MY_RF24_SPI_CSN_DELAY_US > 0 && !defined(__linux__)
 	// timing
-	delayMicroseconds(10);
+	delayMicroseconds(MY_RF24_SPI_CSN_DELAY_US);
+#endif
 	return status;
 }
 
@@ -161,6 +220,7 @@ LOCAL uint8_t RF24_getFIFOStatus(void)
 
 LOCAL void RF24_setChannel(const uint8_t channel)
 {
+	RF24_channel = channel;
 	RF24_writeByteRegister(RF24_REG_RF_CH,channel);
 }
 
@@ -180,6 +240,28 @@ LOCAL void RF24_setRFSetup(const uint8_t RFsetup)
 	RF24_writeByteRegister(RF24_REG_RF_SETUP, RFsetup);
 }
 
+#if defined(MY_RF24_LINK_DATARATE)
+LOCAL void RF24_setDataRate(const uint8_t dataRate)
+{
+	const uint8_t registerContent = RF24_readByteRegister(RF24_REG_RF_SETUP);
+	RF24_writeByteRegister(RF24_REG_RF_SETUP,
+	                       (registerContent & ~RF24_DATARATE_MASK) | RF24_DATARATE_BITS(dataRate));
+}
+
+LOCAL void RF24_hopDataRate(void)
+{
+	if (hwMillis() - RF24_rxDataRateSince < MY_RF24_LINK_DATARATE_DWELL_MS || RF24_isDataAvailable()) {
+		return;
+	}
+	// a frame on air is lost, its sender retransmits it after the switch
+	RF24_ce(LOW);
+	RF24_rxDataRate = RF24_rxDataRate == MY_RF24_DATARATE ? MY_RF24_LINK_DATARATE : MY_RF24_DATARATE;
+	RF24_setDataRate(RF24_rxDataRate);
+	RF24_ce(HIGH);
+	RF24_rxDataRateSince = hwMillis();
+}
+#endif
+
 LOCAL void RF24_setFeature(const uint8_t feature)
 {
 	RF24_writeByteRegister(RF24_REG_FEATURE, feature);
@@ -226,6 +308,16 @@ LOCAL void RF24_setPipeLSB(const uint8_t pipe, const uint8_t LSB)
 	RF24_writeByteRegister(pipe, LSB);
 }
 
+LOCAL void RF24_setPipeNode(const uint8_t pipe, const nodeId_t node)
+{
+#if defined(MY_NODE_ID_16BIT)
+	// the higher address bytes keep the base radio id
+	RF24_writeMultiByteRegister(pipe, &node, sizeof(node));
+#else
+	RF24_setPipeLSB(pipe, node);
+#endif
+}
+
 LOCAL uint8_t RF24_getObserveTX(void)
 {
 	return RF24_readByteRegister(RF24_REG_OBSERVE_TX);
@@ -241,12 +333,12 @@ LOCAL void RF24_enableFeatures(void)
 	RF24_RAW_writeByteRegister(RF24_CMD_ACTIVATE, 0x73);
 }
 
-LOCAL void RF24_openWritingPipe(const uint8_t recipient)
+LOCAL void RF24_openWritingPipe(const nodeId_t recipient)
 {
-	RF24_DEBUG(PSTR("RF24:OWP:RCPT=%" PRIu8 "\n"), recipient); // open writing pipe
+	RF24_DEBUG(PSTR("RF24:OWP:RCPT=%" PRIuNodeId "\n"), recipient); // open writing pipe
 	// only write LSB of RX0 and TX pipe
-	RF24_setPipeLSB(RF24_REG_RX_ADDR_P0, recipient);
-	RF24_setPipeLSB(RF24_REG_TX_ADDR, recipient);
+	RF24_setPipeNode(RF24_REG_RX_ADDR_P0, recipient);
+	RF24_setPipeNode(RF24_REG_TX_ADDR, recipient);
 }
 
 LOCAL void RF24_startListening(void)
@@ -256,8 +348,13 @@ LOCAL void RF24_startListening(void)
 	RF24_setRFConfiguration(RF24_CONFIGURATION | _BV(RF24_PWR_UP) | _BV(RF24_PRIM_RX) );
 	// all RX pipe addresses must be unique, therefore skip if node ID is RF24_BROADCAST_ADDRESS
 	if(RF24_NODE_ADDRESS!= RF24_BROADCAST_ADDRESS) {
-		RF24_setPipeLSB(RF24_REG_RX_ADDR_P0, RF24_NODE_ADDRESS);
+		RF24_setPipeNode(RF24_REG_RX_ADDR_P0, RF24_NODE_ADDRESS);
+	}
+#if defined(MY_RF24_LINK_DATARATE)
+	if (RF24_txDataRate != RF24_rxDataRate) {
+		RF24_setDataRate(RF24_rxDataRate);
 	}
+#endif
 	// start listening
 	RF24_ce(HIGH);
 }
@@ -300,24 +397,104 @@ LOCAL void RF24_standBy(void)
 	RF24_ce(LOW);
 	RF24_setRFConfiguration(RF24_CONFIGURATION | _BV(RF24_PWR_UP));
 	// There must be a delay of up to 4.5ms after the nRF24L01+ leaves power down mode before the CE is set high.
-	delayMicroseconds(4500);
+	// SPI access is possible right away, RF24_ce() waits before CE goes high and the time spent until
+	// the first TX or RX is not lost.
+	RF24_standByMicros = hwMicros();
+	RF24_standByPending = true;
 }
 
 
-LOCAL bool RF24_sendMessage(const uint8_t recipient, const void *buf, const uint8_t len,
+LOCAL bool RF24_sendMessage(const nodeId_t recipient, const void *buf, const uint8_t len,
                             const bool noACK)
+{
+#if defined(MY_RF24_LINK_DATARATE)
+	if (recipient == RF24_BROADCAST_ADDRESS) {
+		// parents listen at either data rate
+		RF24_txDataRate = MY_RF24_DATARATE;
+		(void)RF24_sendFrame(recipient, buf, len, noACK);
+		RF24_txDataRate = MY_RF24_LINK_DATARATE;
+		return RF24_sendFrame(recipient, buf, len, noACK);
+	}
+	const uint8_t mask = _BV(recipient & 7);
+	uint8_t &slow = RF24_linkSlow[(uint8_t)recipient >> 3];
+	// without ACK there is no telling whether the faster link works
+	if (!noACK && (!(slow & mask) || !(++RF24_linkProbeCount % MY_RF24_LINK_DATARATE_PROBE))) {
+		RF24_txDataRate = MY_RF24_LINK_DATARATE;
+		if (RF24_sendFrame(recipient, buf, len, noACK)) {
+			slow &= ~mask;
+			return true;
+		}
+		RF24_DEBUG(PSTR("!RF24:TXM:LINK SLOW,TO=%" PRIuNodeId "\n"), recipient); // fall back to MY_RF24_DATARATE
+		slow |= mask;
+	}
+	RF24_txDataRate = MY_RF24_DATARATE;
+#endif
+	return RF24_sendFrame(recipient, buf, len, noACK);
+}
+
+LOCAL bool RF24_sendFrame(const nodeId_t recipient, const void *buf, const uint8_t len,
+                          const bool noACK)
 {
 	uint8_t RF24_status;
 	RF24_stopListening();
+#if defined(MY_RF24_LINK_DATARATE)
+	RF24_setDataRate(RF24_txDataRate);
+	const uint32_t bitTime = RF24_DATARATE_BIT_TIME_NS(RF24_txDataRate);
+	// ATC adjusts the PA level for MY_RF24_DATARATE
+	const bool ATC = RF24_ATCenabled && RF24_txDataRate == MY_RF24_DATARATE;
+#else
+	const uint32_t bitTime = RF24_BIT_TIME_NS;
+	const bool ATC = RF24_ATCenabled;
+#endif
 	RF24_openWritingPipe( recipient );
-	RF24_DEBUG(PSTR("RF24:TXM:TO=%" PRIu8 ",LEN=%" PRIu8 "\n"),recipient,len); // send message
-	// flush TX FIFO
-	RF24_flushTX();
+	RF24_DEBUG(PSTR("RF24:TXM:TO=%" PRIuNodeId ",LEN=%" PRIu8 "\n"),recipient,len); // send message
 	// this command is affected in clones (e.g. Si24R1):  flipped NoACK bit when using W_TX_PAYLOAD_NO_ACK / W_TX_PAYLOAD
 	// AutoACK is disabled on the broadcasting pipe - NO_ACK prevents resending
-	RF24_spiMultiByteTransfer((recipient == RF24_BROADCAST_ADDRESS ||
-	                           noACK) ? RF24_CMD_WRITE_TX_PAYLOAD_NO_ACK :
-	                          RF24_CMD_WRITE_TX_PAYLOAD, (uint8_t *)buf, len, false );
+	const uint8_t cmd = (recipient == RF24_BROADCAST_ADDRESS ||
+	                     noACK) ? RF24_CMD_WRITE_TX_PAYLOAD_NO_ACK : RF24_CMD_WRITE_TX_PAYLOAD;
+#if defined(MY_RF24_ACK_PAYLOAD)
+	// the flush below drops a loaded payload, it stays pending and is loaded again with the next
+	// frame of its node
+	RF24_ackPayloadLoaded = RF24_BROADCAST_ADDRESS;
+	RF24_ackPayloadRxEmpty = !RF24_isDataAvailable();
+	// TX_DS of a payload sent with an ACK in RX mode must not end the wait for this frame
+	RF24_setStatus(_BV(RF24_TX_DS));
+#endif
+#if defined(SPI_HAS_TRANSFER_QUEUE)
+	// flush TX FIFO and write payload with one submission
+	RF24_DEBUG(PSTR("RF24:FTX\n"));
+	uint8_t flushTX = RF24_CMD_FLUSH_TX;
+	RF24_spi_txbuff[0] = cmd;
+	(void)memcpy((void *)&RF24_spi_txbuff[1], buf, len);
+	RF24_SPI.beginTransaction(SPISettings(MY_RF24_SPI_SPEED, RF24_SPI_DATA_ORDER,
+	                                      RF24_SPI_DATA_MODE));
+	RF24_SPI.queueTransfer((char *)&flushTX, (char *)&flushTX, sizeof(flushTX));
+	RF24_SPI.queueTransfer((char *)RF24_spi_txbuff, (char *)RF24_spi_rxbuff, len + 1);
+	RF24_SPI.submitTransfers();
+	RF24_SPI.endTransaction();
+#else
+	// flush TX FIFO
+	RF24_flushTX();
+	RF24_spiMultiByteTransfer(cmd, (uint8_t *)buf, len, false );
+#endif
+#if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
+	RF24_txStatus = 0;
+	// go, TX starts after ~10us, CE high also enables PA+LNA on supported HW
+	RF24_ce(HIGH);
+	// TX_DS and MAX_RT raise the IRQ, wait for the handler instead of polling STATUS via SPI
+	const uint32_t enter = hwMillis();
+	while (!RF24_txStatus && hwMillis() - enter < RF24_TX_TIMEOUT_MS) {
+#if defined(__linux__)
+		// leave the CPU to the IRQ thread during auto retransmits
+		delayMicroseconds(100);
+#endif
+	}
+	RF24_status = RF24_txStatus;
+	if (!RF24_status) {
+		// IRQ missed or HW issue
+		RF24_status = RF24_getStatus();
+	}
+#else
 	// go, TX starts after ~10us, CE high also enables PA+LNA on supported HW
 	RF24_ce(HIGH);
 	// timeout counter to detect HW issues
@@ -326,9 +503,19 @@ LOCAL bool RF24_sendMessage(const uint8_t recipient, const void *buf, const uint
 		RF24_status = RF24_getStatus();
 	} while  (!(RF24_status & ( _BV(RF24_MAX_RT) | _BV(RF24_TX_DS) )) && timeout--);
 	// timeout value after successful TX on 16Mhz AVR ~ 65500, i.e. msg is transmitted after ~36 loop cycles
+#if defined(MY_RF24_ACK_PAYLOAD)
+	RF24_ackPayloadNext = RF24_ackPayloadRxEmpty && (RF24_status & _BV(RF24_RX_DR));
+#endif
+#endif
 	RF24_ce(LOW);
 	// reset interrupts
 	RF24_setStatus(_BV(RF24_TX_DS) | _BV(RF24_MAX_RT) );
+	// auto retransmits of the frame, ARC_CNT is reset by the next payload
+	const uint8_t frames = 1u + (cmd == RF24_CMD_WRITE_TX_PAYLOAD ? (RF24_getObserveTX() & 0xF) : 0u);
+	RF24_airtime += (uint32_t)frames * RF24_FRAME_BITS(len) * bitTime / 1000u;
+	if (ATC && cmd == RF24_CMD_WRITE_TX_PAYLOAD) {
+		RF24_executeATC(RF24_status & _BV(RF24_TX_DS));
+	}
 	// Max retries exceeded
 	if(RF24_status & _BV(RF24_MAX_RT)) {
 		// flush packet
@@ -340,6 +527,11 @@ LOCAL bool RF24_sendMessage(const uint8_t recipient, const void *buf, const uint
 	return (RF24_status & _BV(RF24_TX_DS) || noACK);
 }
 
+LOCAL uint32_t RF24_getAirtime(void)
+{
+	return RF24_airtime;
+}
+
 LOCAL uint8_t RF24_getDynamicPayloadSize(void)
 {
 	uint8_t result = RF24_spiMultiByteTransfer(RF24_CMD_READ_RX_PL_WID, NULL, 1, true);
@@ -358,17 +550,135 @@ LOCAL bool RF24_isDataAvailable(void)
 }
 
 
+#if defined(MY_RF24_ACK_PAYLOAD)
+LOCAL bool RF24_setAckPayload(const nodeId_t recipient, const void *buf, uint8_t len)
+{
+	bool result = false;
+	if (len > 32) {
+		len = 32;
+	}
+	MY_CRITICAL_SECTION {
+		int8_t slot = -1;
+		for (uint8_t i = 0; i < MY_RF24_ACK_PAYLOAD_SLOTS; i++) {
+			if (RF24_ackPayloads[i].pending && RF24_ackPayloads[i].node == recipient) {
+				// replace the payload of the node
+				slot = i;
+				break;
+			}
+			if (!RF24_ackPayloads[i].pending && slot < 0) {
+				slot = i;
+			}
+		}
+		if (slot >= 0) {
+			if (RF24_ackPayloadLoaded == recipient) {
+				// the old payload must not leave anymore, the new one is loaded with the next frame
+				RF24_flushTX();
+				RF24_ackPayloadLoaded = RF24_BROADCAST_ADDRESS;
+			}
+			(void)memcpy(RF24_ackPayloads[slot].data, buf, len);
+			RF24_ackPayloads[slot].len = len;
+			RF24_ackPayloads[slot].node = recipient;
+			RF24_ackPayloads[slot].pending = true;
+			result = true;
+		}
+	}
+	RF24_DEBUG(PSTR("RF24:APL:SET,TO=%" PRIuNodeId ",LEN=%" PRIu8 ",OK=%" PRIu8 "\n"), recipient, len,
+	           result);
+	return result;
+}
+
+LOCAL bool RF24_withdrawAckPayload(const nodeId_t recipient)
+{
+	bool result = false;
+	MY_CRITICAL_SECTION {
+		for (uint8_t i = 0; i < MY_RF24_ACK_PAYLOAD_SLOTS; i++) {
+			if (RF24_ackPayloads[i].pending && RF24_ackPayloads[i].node == recipient) {
+				RF24_ackPayloads[i].pending = false;
+				result = true;
+			}
+		}
+		if (result && RF24_ackPayloadLoaded == recipient) {
+			// if it left already, the frame it went with is still unread: counted as not sent
+			RF24_flushTX();
+			RF24_ackPayloadLoaded = RF24_BROADCAST_ADDRESS;
+		}
+	}
+	return result;
+}
+
+LOCAL void RF24_ackPayloadReceived(const nodeId_t last)
+{
+	const nodeId_t loaded = RF24_ackPayloadLoaded;
+	if (loaded != RF24_BROADCAST_ADDRESS) {
+		// FIFO state after the frame of last was read
+		const uint8_t fifo = RF24_getFIFOStatus();
+		if (!(fifo & _BV(RF24_TX_EMPTY)) || !(fifo & _BV(RF24_RX_EMPTY))) {
+			// not sent yet, or more frames came in and the one it left with is not known
+			return;
+		}
+		RF24_ackPayloadLoaded = RF24_BROADCAST_ADDRESS;
+		for (uint8_t i = 0; i < MY_RF24_ACK_PAYLOAD_SLOTS; i++) {
+			if (RF24_ackPayloads[i].pending && RF24_ackPayloads[i].node == loaded) {
+				// taken by another node that transmitted first: load it again for the next frame of the node
+				RF24_ackPayloads[i].pending = (last != loaded);
+			}
+		}
+		RF24_DEBUG(PSTR("RF24:APL:SENT,TO=%" PRIuNodeId ",OK=%" PRIu8 "\n"), last, last == loaded);
+	}
+	for (uint8_t i = 0; i < MY_RF24_ACK_PAYLOAD_SLOTS; i++) {
+		if (RF24_ackPayloads[i].pending && RF24_ackPayloads[i].node == last) {
+			// the node is awake, its next frame takes the payload
+			RF24_spiMultiByteTransfer(RF24_CMD_WRITE_ACK_PAYLOAD, RF24_ackPayloads[i].data,
+			                          RF24_ackPayloads[i].len, false);
+			RF24_ackPayloadLoaded = last;
+			return;
+		}
+	}
+}
+#endif
+
 LOCAL uint8_t RF24_readMessage(void *buf)
 {
 	const uint8_t len = RF24_getDynamicPayloadSize();
 	RF24_DEBUG(PSTR("RF24:RXM:LEN=%" PRIu8 "\n"), len);	// read message
+#if defined(SPI_HAS_TRANSFER_QUEUE)
+	// read payload and clear RX interrupt with one submission
+	uint8_t clearRX[2] = { RF24_CMD_WRITE_REGISTER | RF24_REG_STATUS, _BV(RF24_RX_DR) };
+	RF24_spi_txbuff[0] = RF24_CMD_READ_RX_PAYLOAD;
+	(void)memset((void *)&RF24_spi_txbuff[1], RF24_CMD_NOP, len);
+	RF24_SPI.beginTransaction(SPISettings(MY_RF24_SPI_SPEED, RF24_SPI_DATA_ORDER,
+	                                      RF24_SPI_DATA_MODE));
+	RF24_SPI.queueTransfer((char *)RF24_spi_txbuff, (char *)RF24_spi_rxbuff, len + 1);
+	RF24_SPI.queueTransfer((char *)clearRX, (char *)clearRX, sizeof(clearRX));
+	RF24_SPI.submitTransfers();
+	(void)memcpy(buf, (const void *)&RF24_spi_rxbuff[1], len);
+	RF24_SPI.endTransaction();
+#else
 	RF24_spiMultiByteTransfer(RF24_CMD_READ_RX_PAYLOAD,(uint8_t *)buf,len,true);
 	// clear RX interrupt
 	RF24_setStatus(_BV(RF24_RX_DR));
+#endif
+#if defined(MY_RF24_ACK_PAYLOAD)
+	// header: last, sender, destination
+	nodeId_t header[3];
+	if (buf != NULL) {
+		(void)memcpy((void *)header, buf, min((size_t)len, sizeof(header)));
+	}
+	if (RF24_ackPayloadNext) {
+		RF24_ackPayloadNext = false;
+		if (buf != NULL && len >= sizeof(header) && header[2] != RF24_NODE_ADDRESS) {
+			// loaded by the parent for a node that did not transmit in time
+			RF24_DEBUG(PSTR("!RF24:RXM:APL,TO=%" PRIuNodeId "\n"), header[2]);
+			return 0;
+		}
+	} else if (buf != NULL && len >= sizeof(header[0])) {
+		RF24_ackPayloadReceived(header[0]);
+	}
+#endif
 	return len;
 }
 
-LOCAL void RF24_setNodeAddress(const uint8_t address)
+LOCAL void RF24_setNodeAddress(const nodeId_t address)
 {
 	if(address!= RF24_BROADCAST_ADDRESS) {
 		RF24_NODE_ADDRESS = address;
@@ -379,7 +689,7 @@ LOCAL void RF24_setNodeAddress(const uint8_t address)
 	}
 }
 
-LOCAL uint8_t RF24_getNodeID(void)
+LOCAL nodeId_t RF24_getNodeID(void)
 {
 	return RF24_NODE_ADDRESS;
 }
@@ -387,8 +697,15 @@ LOCAL uint8_t RF24_getNodeID(void)
 LOCAL bool RF24_sanityCheck(void)
 {
 	// detect HW defect, configuration errors or interrupted SPI line, CE disconnect cannot be detected
-	return (RF24_readByteRegister(RF24_REG_RF_SETUP) == RF24_RF_SETUP) && (RF24_readByteRegister(
-	            RF24_REG_RF_CH) == MY_RF24_CHANNEL);
+	// PA level excluded, changed by ATC and RF24_setTxPowerLevel()
+#if defined(MY_RF24_LINK_DATARATE)
+	// data rate excluded, changed per transmission and by the listening schedule
+	const uint8_t mask = 0xF9 & ~RF24_DATARATE_MASK;
+#else
+	const uint8_t mask = 0xF9;
+#endif
+	return ((RF24_readByteRegister(RF24_REG_RF_SETUP) & mask) == (RF24_RF_SETUP & mask)) &&
+	       (RF24_readByteRegister(RF24_REG_RF_CH) == RF24_channel);
 }
 LOCAL int16_t RF24_getTxPowerLevel(void)
 {
@@ -424,6 +741,36 @@ LOCAL int16_t RF24_getSendingRSSI(void)
 	return static_cast<int16_t>(-29 - (8 * (RF24_getObserveTX() & 0xF)));
 }
 
+LOCAL void RF24_ATCmode(const bool OnOff)
+{
+	RF24_ATCenabled = OnOff;
+	RF24_ATCcleanFrames = 0;
+}
+
+LOCAL void RF24_executeATC(const bool ACKreceived)
+{
+	// no RSSI available, use retransmits of the last frame, no ACK counts as max retransmits
+	const uint8_t ARC = ACKreceived ? (RF24_getObserveTX() & 0xF) : RF24_SET_ARC;
+	bool increase = false;
+	if (ARC >= RF24_ATC_ARC_INCREASE) {
+		increase = true;
+	} else if (ARC || ++RF24_ATCcleanFrames < RF24_ATC_CLEAN_FRAMES) {
+		// nothing to adjust
+		if (ARC) {
+			RF24_ATCcleanFrames = 0;
+		}
+		return;
+	}
+	RF24_ATCcleanFrames = 0;
+	const uint8_t powerLevel = (RF24_readByteRegister(RF24_REG_RF_SETUP) >> 1) & 3;
+	if (increase ? (powerLevel >= MY_RF24_PA_LEVEL) : (powerLevel == RF24_MIN_POWER_LEVEL)) {
+		// limit reached
+		return;
+	}
+	RF24_DEBUG(PSTR("RF24:ATC:ADJ TXL,ARC=%" PRIu8 ",TXL=%" PRIu8 "\n"), ARC, powerLevel);
+	(void)RF24_setTxPowerLevel(increase ? powerLevel + 1 : powerLevel - 1);
+}
+
 LOCAL void RF24_enableConstantCarrierWave(void)
 {
 	RF24_standBy();
@@ -447,6 +794,18 @@ LOCAL bool RF24_getReceivedPowerDetector(void)
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
 LOCAL void RF24_irqHandler(void)
 {
+	// Completion of a transmission started by RF24_sendMessage()
+	const uint8_t status = RF24_getStatus();
+	const bool txCompleted = (status & (_BV(RF24_TX_DS) | _BV(RF24_MAX_RT))) != 0;
+	if (txCompleted) {
+		RF24_setStatus(status & (_BV(RF24_TX_DS) | _BV(RF24_MAX_RT)));
+		RF24_txStatus = status;
+#if defined(MY_RF24_ACK_PAYLOAD)
+		// in PRX mode TX_DS is an ACK payload sent, RF24_ackPayloadReceived() keeps track of it
+		RF24_ackPayloadNext = RF24_ackPayloadRxEmpty && (status & _BV(RF24_RX_DR)) &&
+		                      !(RF24_readByteRegister(RF24_REG_NRF_CONFIG) & _BV(RF24_PRIM_RX));
+#endif
+	}
 	if (RF24_receiveCallback) {
 #if defined(MY_GATEWAY_SERIAL) && !defined(__linux__)
 		// Will stay for a while (several 100us) in this interrupt handler. Any interrupts from serial
@@ -468,7 +827,7 @@ LOCAL void RF24_irqHandler(void)
 			do {
 				RF24_receiveCallback();		// Must call RF24_readMessage(), which will clear RX_DR IRQ !
 			} while (RF24_isDataAvailable());
-		} else {
+		} else if (!txCompleted) {
 			// Occasionally interrupt is triggered but no data is available - clear RX interrupt only
 			RF24_setStatus(_BV(RF24_RX_DR));
 			logNotice("RF24: Recovered from a bad interrupt trigger.\n");
@@ -535,7 +894,7 @@ LOCAL bool RF24_initialize(void)
 	// auto retransmit delay 1500us, auto retransmit count 15
 	RF24_setRetries(RF24_SET_ARD, RF24_SET_ARC);
 	// set channel
-	RF24_setChannel(MY_RF24_CHANNEL);
+	RF24_setChannel(RF24_channel);
 	// set data rate and pa level
 	RF24_setRFSetup(RF24_RF_SETUP);
 	// enable ACK payload and dynamic payload
@@ -552,7 +911,8 @@ LOCAL bool RF24_initialize(void)
 	// enable dynamic payloads on used pipes
 	RF24_setDynamicPayload(_BV(RF24_DPL_P0 + RF24_BROADCAST_PIPE) | _BV(RF24_DPL_P0));
 	// listen to broadcast pipe
-	RF24_BASE_ID[0] = RF24_BROADCAST_ADDRESS;
+	const nodeId_t broadcast = RF24_BROADCAST_ADDRESS;
+	(void)memcpy((void *)RF24_BASE_ID, (const void *)&broadcast, sizeof(broadcast));
 	RF24_setPipeAddress(RF24_REG_RX_ADDR_P0 + RF24_BROADCAST_PIPE, (uint8_t *)&RF24_BASE_ID,
 	                    RF24_BROADCAST_PIPE > 1 ? 1 : MY_RF24_ADDR_WIDTH);
 	// pipe 0, set full address, later only LSB is updated
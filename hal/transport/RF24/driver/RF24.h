@@ -53,6 +53,7 @@
 * |!| RF24 | GDP  | PYL INV              | Invalid payload size
 * | | RF24 | RXM  | LEN=%%d              | Read message, length=(LEN)
 * | | RF24 | STX  | LEVEL=%%d            | Set TX level, level=(LEVEL)
+* | | RF24 | ATC  | ADJ TXL,ARC=%%d,TXL=%%d | Adjust TX level, retransmits of last frame (ARC), previous TX level (TXL)
 *
 */
 
@@ -93,7 +94,14 @@
 #define RF24_SPI_DATA_ORDER				MSBFIRST	//!< RF24_SPI_DATA_ORDER
 #define RF24_SPI_DATA_MODE				SPI_MODE0	//!< RF24_SPI_DATA_MODE
 
+#if defined(MY_NODE_ID_16BIT)
+#define RF24_BROADCAST_ADDRESS	(0xFFFFu)	//!< RF24_BROADCAST_ADDRESS
+#if MY_RF24_ADDR_WIDTH < 3
+#error MY_NODE_ID_16BIT takes two address bytes, MY_RF24_ADDR_WIDTH must be at least 3
+#endif
+#else
 #define RF24_BROADCAST_ADDRESS	(255u)	//!< RF24_BROADCAST_ADDRESS
+#endif
 
 // verify RF24 IRQ defs
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
@@ -119,16 +127,31 @@
 
 
 // RF24 settings
-#if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
-#define RF24_CONFIGURATION (uint8_t) ((RF24_CRC_16 << 2) | (1 << RF24_MASK_TX_DS) | (1 << RF24_MASK_MAX_RT))		//!< MY_RF24_CONFIGURATION
-#else
+// TX_DS and MAX_RT are not masked, with MY_RX_MESSAGE_BUFFER_FEATURE they signal the end of a transmission on the IRQ pin
 #define RF24_CONFIGURATION (uint8_t) (RF24_CRC_16 << 2)		//!< RF24_CONFIGURATION
-#endif
+#if defined(MY_RF24_ACK_PAYLOAD)
+#define RF24_FEATURE (uint8_t)( _BV(RF24_EN_DPL) | _BV(RF24_EN_ACK_PAY))	//!<  RF24_FEATURE
+#else
 #define RF24_FEATURE (uint8_t)( _BV(RF24_EN_DPL))	//!<  RF24_FEATURE
+#endif
 #define RF24_RF_SETUP (uint8_t)(( ((MY_RF24_DATARATE & 0b10 ) << 4) | ((MY_RF24_DATARATE & 0b01 ) << 3) | (MY_RF24_PA_LEVEL << 1) ) + 1) 		//!< RF24_RF_SETUP, +1 for Si24R1 and LNA
+#define RF24_DATARATE_MASK (uint8_t)(_BV(RF24_RF_DR_LOW) | _BV(RF24_RF_DR_HIGH))	//!< Data rate bits of RF_SETUP
+#define RF24_DATARATE_BITS(rate) (uint8_t)((((rate) & 0b10) << 4) | (((rate) & 0b01) << 3))	//!< RF_SETUP bits of a data rate
 
 // powerup delay
 #define RF24_POWERUP_DELAY_MS	(100u)		//!< Power up delay, allow VCC to settle, transport to become fully operational
+#define RF24_STANDBY_DELAY_US	(4500u)		//!< Delay after leaving power down mode before CE may go high (Tpd2stby)
+// TX timeout, 15 retransmits at 250kbps take ~40ms
+#define RF24_TX_TIMEOUT_MS		(100u)		//!< Time to wait for TX_DS or MAX_RT on the IRQ pin, detects HW issues
+
+// time on air: preamble, address, 9 bit packet control field, payload and CRC16
+#define RF24_DATARATE_BIT_TIME_NS(rate)	((rate) == RF24_250KBPS ? 4000u : ((rate) == RF24_2MBPS ? 500u : 1000u))	//!< Time on air of one bit at a data rate
+#define RF24_BIT_TIME_NS		RF24_DATARATE_BIT_TIME_NS(MY_RF24_DATARATE)	//!< Time on air of one bit
+#define RF24_FRAME_BITS(len)	(8u * (1u + MY_RF24_ADDR_WIDTH + (len) + 2u) + 9u)	//!< Bits of a frame with len bytes payload
+
+// ATC
+#define RF24_ATC_ARC_INCREASE	(2u)		//!< ATC: increase TX level if a frame needed at least this many retransmits
+#define RF24_ATC_CLEAN_FRAMES	(8u)		//!< ATC: decrease TX level after this many consecutive frames without retransmit
 
 // pipes
 #define RF24_BROADCAST_PIPE		(1u)		//!< RF24_BROADCAST_PIPE
@@ -202,7 +225,7 @@ LOCAL uint8_t RF24_getFIFOStatus(void);
 * @brief RF24_openWritingPipe
 * @param recipient
 */
-LOCAL void RF24_openWritingPipe(const uint8_t recipient);
+LOCAL void RF24_openWritingPipe(const nodeId_t recipient);
 /**
 * @brief RF24_startListening
 */
@@ -235,9 +258,26 @@ LOCAL void RF24_powerUp(void);
 * @param noACK set True if no ACK is required
 * @return
 */
-LOCAL bool RF24_sendMessage(const uint8_t recipient, const void *buf, const uint8_t len,
+LOCAL bool RF24_sendMessage(const nodeId_t recipient, const void *buf, const uint8_t len,
                             const bool noACK = false);
 /**
+* @brief Transmit one frame, at RF24_txDataRate with MY_RF24_LINK_DATARATE
+* @param recipient
+* @param buf
+* @param len
+* @param noACK set True if no ACK is required
+* @return
+*/
+LOCAL bool RF24_sendFrame(const nodeId_t recipient, const void *buf, const uint8_t len,
+                          const bool noACK);
+/**
+* @brief Get the time on air of all transmitted frames, including auto retransmits
+*
+* ACKs sent by the radio on its own for received frames are not included.
+* @return Time on air in us, wraps around
+*/
+LOCAL uint32_t RF24_getAirtime(void);
+/**
 * @brief RF24_getDynamicPayloadSize
 * @return
 */
@@ -256,12 +296,12 @@ LOCAL uint8_t RF24_readMessage(void *buf);
 * @brief RF24_setNodeAddress
 * @param address
 */
-LOCAL void RF24_setNodeAddress(const uint8_t address);
+LOCAL void RF24_setNodeAddress(const nodeId_t address);
 /**
 * @brief RF24_getNodeID
 * @return
 */
-LOCAL uint8_t RF24_getNodeID(void);
+LOCAL nodeId_t RF24_getNodeID(void);
 /**
 * @brief RF24_sanityCheck
 * @return
@@ -337,6 +377,13 @@ LOCAL void RF24_setPipeAddress(const uint8_t pipe, uint8_t *address, const uint8
 */
 LOCAL void RF24_setPipeLSB(const uint8_t pipe, const uint8_t LSB);
 /**
+* @brief Set the node id part of a pipe address, the lowest byte or with MY_NODE_ID_16BIT the two
+* lowest bytes
+* @param pipe
+* @param node
+*/
+LOCAL void RF24_setPipeNode(const uint8_t pipe, const nodeId_t node);
+/**
 * @brief RF24_getObserveTX
 * @return
 */
@@ -372,6 +419,16 @@ LOCAL bool RF24_setTxPowerPercent(const uint8_t newPowerPercent);
 */
 LOCAL int16_t RF24_getSendingRSSI(void);
 /**
+* @brief RF24_ATCmode
+* @param OnOff True to enable ATC, the TX level is then adjusted between RF24_PA_MIN and MY_RF24_PA_LEVEL
+*/
+LOCAL void RF24_ATCmode(const bool OnOff);
+/**
+* @brief RF24_executeATC, uses the retransmit count (ARC) as link quality
+* @param ACKreceived True if the last frame was acknowledged
+*/
+LOCAL void RF24_executeATC(const bool ACKreceived);
+/**
 * @brief Generate a constant carrier wave at active channel & transmit power (for testing only).
 */
 LOCAL void RF24_enableConstantCarrierWave(void) __attribute__((unused));
@@ -385,6 +442,43 @@ LOCAL void RF24_disableConstantCarrierWave(void) __attribute__((unused));
 */
 LOCAL bool RF24_getReceivedPowerDetector(void) __attribute__((unused));
 
+#if defined(MY_RF24_ACK_PAYLOAD)
+/**
+* @brief Send a payload in the ACK of the next frame of a node, replaces one still pending.
+* The payload is loaded once a frame of the node was received and leaves with the ACK of the
+* following frame on pipe 0. If another node transmits first, the payload is loaded again.
+* @param recipient
+* @param buf
+* @param len
+* @return true if the payload is pending
+*/
+LOCAL bool RF24_setAckPayload(const nodeId_t recipient, const void *buf, uint8_t len);
+/**
+* @brief Drop the payload pending for a node
+* @param recipient
+* @return true if it was still pending, false if there was none or it has been sent
+*/
+LOCAL bool RF24_withdrawAckPayload(const nodeId_t recipient);
+/**
+* @brief Keep track of the ACK payloads, called for each frame read
+* @param last Node the frame came from
+*/
+LOCAL void RF24_ackPayloadReceived(const nodeId_t last);
+#endif
+
+#if defined(MY_RF24_LINK_DATARATE)
+/**
+* @brief Set the data rate, PA level and other bits of RF_SETUP are kept
+* @param dataRate RF24_250KBPS, RF24_1MBPS or RF24_2MBPS
+*/
+LOCAL void RF24_setDataRate(const uint8_t dataRate);
+/**
+* @brief Switch the listening data rate once MY_RF24_LINK_DATARATE_DWELL_MS passed, call while
+* listening. Parents listen at both data rates in turn.
+*/
+LOCAL void RF24_hopDataRate(void) __attribute__((unused));
+#endif
+
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
 /**
 * @brief Callback type
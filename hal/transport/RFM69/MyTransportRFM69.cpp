@@ -66,6 +66,11 @@ bool transportSend(const uint8_t to, const void *data, uint8_t len, const bool n
 	return RFM69_sendWithRetry(to, data, len);
 }
 
+uint32_t transportGetAirtime(void)
+{
+	return RFM69_getAirtime();
+}
+
 bool transportDataAvailable(void)
 {
 	RFM69_handler();
@@ -89,7 +94,13 @@ void transportEncrypt(const char *key)
 
 void transportSleep(void)
 {
+#if defined(MY_RFM69_ENABLE_LISTENMODE)
+	// keep receiving, a frame wakes the MCU
+	(void)RFM69_listen();
+#else
+	(void)RFM69_listen;
 	(void)RFM69_sleep();
+#endif
 }
 
 void transportStandBy(void)
@@ -97,6 +108,11 @@ void transportStandBy(void)
 	(void)RFM69_standBy();
 }
 
+void transportSetWakeUpPreamble(const uint32_t cycleMS)
+{
+	RFM69_setWakeUpPreamble(cycleMS);
+}
+
 void transportPowerDown(void)
 {
 	(void)RFM69_powerDown();
@@ -215,6 +231,12 @@ bool transportSend(const uint8_t to, const void *data, const uint8_t len, const
 	return _radio.sendWithRetry(to, data, len);
 }
 
+uint32_t transportGetAirtime(void)
+{
+	// not accounted by the old driver
+	return 0;
+}
+
 bool transportDataAvailable(void)
 {
 	return _radio.receiveDone();
@@ -112,6 +112,16 @@ LOCAL uint8_t RFM69_spiMultiByteTransfer(const uint8_t cmd, uint8_t *buf, uint8_
 	}
 #else
 	status = RFM69_SPI.transfer(cmd);
+#if defined(MY_HW_HAS_SPI_DMA) && !defined(MY_SOFTSPI)
+	if (buf != NULL && len >= MY_SPI_DMA_MIN_LENGTH) {
+		// payload bytes back to back, CS stays low until the transfer is done
+		hwSPITransferDMA(aReadMode ? NULL : buf, aReadMode ? buf : NULL, len);
+		if (aReadMode) {
+			status = buf[len - 1];
+		}
+		len = 0;
+	}
+#endif
 	while (len--) {
 		if (aReadMode) {
 			status = RFM69_SPI.transfer((uint8_t)RFM69_NOP);
@@ -205,6 +215,7 @@ LOCAL bool RFM69_initialise(const uint32_t frequencyHz)
 	RFM69.radioMode = RFM69_RADIO_MODE_SLEEP;
 	RFM69.ATCenabled = false;
 	RFM69.ATCtargetRSSI = RFM69_RSSItoInternal(MY_RFM69_ATC_TARGET_RSSI_DBM);
+	RFM69.preambleLength = RFM69_PREAMBLESIZE_LSB_VALUE;
 
 	// SPI init
 #if !defined(__linux__)
@@ -278,8 +289,8 @@ LOCAL void RFM69_interruptHandling(void)
 			             RFM69.currentPacket.header.packetLen - 1);
 
 			if (RFM69.currentPacket.header.version >= RFM69_MIN_PACKET_HEADER_VERSION) {
-				RFM69.currentPacket.payloadLen = min(RFM69.currentPacket.header.packetLen - (RFM69_HEADER_LEN - 1),
-				                                     RFM69_MAX_PACKET_LEN);
+				RFM69.currentPacket.payloadLen = min((uint8_t)(RFM69.currentPacket.header.packetLen - (RFM69_HEADER_LEN - 1)),
+				                                     (uint8_t)RFM69_MAX_PACKET_LEN);
 				RFM69.ackReceived = RFM69_getACKReceived(RFM69.currentPacket.header.controlFlags);
 				RFM69.dataReceived = !RFM69.ackReceived;
 			}
@@ -297,12 +308,18 @@ LOCAL void RFM69_interruptHandling(void)
 					headerRead = true;
 					if (RFM69.currentPacket.header.version >= RFM69_MIN_PACKET_HEADER_VERSION) {
 						// read payload
-						readingLength = min(RFM69.currentPacket.header.packetLen - (RFM69_HEADER_LEN - 1),
-						                    RFM69_MAX_PACKET_LEN);
+						readingLength = min((uint8_t)(RFM69.currentPacket.header.packetLen - (RFM69_HEADER_LEN - 1)),
+						                    (uint8_t)RFM69_MAX_PACKET_LEN);
 						// save payload length
 						RFM69.currentPacket.payloadLen = readingLength;
 						RFM69.ackReceived = RFM69_getACKReceived(RFM69.currentPacket.header.controlFlags);
 						RFM69.dataReceived = !RFM69.ackReceived;
+#if defined(MY_HW_HAS_SPI_DMA) && !defined(MY_SOFTSPI)
+						if (readingLength >= MY_SPI_DMA_MIN_LENGTH) {
+							hwSPITransferDMA(NULL, current, readingLength);
+							readingLength = 0;
+						}
+#endif
 					}
 				}
 			}
@@ -399,16 +416,34 @@ LOCAL bool RFM69_sendFrame(rfm69_packet_t *packet, const bool increaseSequenceCo
 	// write packet
 	const uint8_t finalLen = packet->payloadLen + RFM69_HEADER_LEN; // including length byte
 	(void)RFM69_burstWriteReg(RFM69_REG_FIFO, packet->data, finalLen);
+	const uint32_t timeOnAirUS = RFM69_getTimeOnAir(finalLen);
+	RFM69.airtime += timeOnAirUS;
 
 	// send message
 	(void)RFM69_setRadioMode(RFM69_RADIO_MODE_TX); // irq upon txsent
 	const uint32_t txStartMS = hwMillis();
-	while (!RFM69_irq && (hwMillis() - txStartMS < MY_RFM69_TX_TIMEOUT_MS)) {
+	// a wake-up preamble extends the frame
+	const uint32_t txTimeoutMS = MY_RFM69_TX_TIMEOUT_MS + timeOnAirUS / 1000u;
+	while (!RFM69_irq && (hwMillis() - txStartMS < txTimeoutMS)) {
 		doYield();
 	};
 	return RFM69_irq;
 }
 
+LOCAL uint32_t RFM69_getTimeOnAir(const uint8_t len)
+{
+	const uint8_t rfm69_modem_config[] = { MY_RFM69_MODEM_CONFIGURATION };
+	// bit time in us is the bitrate register / 32MHz, the frame adds preamble, sync word and CRC
+	const uint16_t bitrate = (uint16_t)(rfm69_modem_config[1] << 8) | rfm69_modem_config[2];
+	const uint32_t bits = 8u * (RFM69.preambleLength + 2u + len + 2u);
+	return bits * bitrate / 32u;
+}
+
+LOCAL uint32_t RFM69_getAirtime(void)
+{
+	return RFM69.airtime;
+}
+
 LOCAL bool RFM69_send(const uint8_t recipient, uint8_t *data, const uint8_t len,
                       const rfm69_controlFlags_t flags, const bool increaseSequenceCounter)
 {
@@ -428,9 +463,10 @@ LOCAL bool RFM69_send(const uint8_t recipient, uint8_t *data, const uint8_t len,
 LOCAL void RFM69_setFrequency(const uint32_t frequencyHz)
 {
 	const uint32_t freqHz = (uint32_t)(frequencyHz / RFM69_FSTEP);
-	RFM69_writeReg(RFM69_REG_FRFMSB, (uint8_t)((freqHz >> 16) & 0xFF));
-	RFM69_writeReg(RFM69_REG_FRFMID, (uint8_t)((freqHz >> 8) & 0xFF));
-	RFM69_writeReg(RFM69_REG_FRFLSB, (uint8_t)(freqHz & 0xFF));
+	const uint8_t freqRegs[] = { (uint8_t)((freqHz >> 16) & 0xFF), (uint8_t)((freqHz >> 8) & 0xFF),
+	                             (uint8_t)(freqHz & 0xFF)
+	                           };
+	(void)RFM69_burstWriteReg(RFM69_REG_FRFMSB, freqRegs, sizeof(freqRegs));
 }
 
 LOCAL void RFM69_setHighPowerRegs(const bool onOff)
@@ -499,6 +535,14 @@ LOCAL bool RFM69_setRadioMode(const rfm69_radio_mode_t newRadioMode)
 
 	uint8_t regMode;
 
+	if (RFM69.radioMode == RFM69_RADIO_MODE_LISTEN) {
+		// ListenOn is cleared together with ListenAbort, then the new mode is set
+		RFM69_writeReg(RFM69_REG_OPMODE,
+		               RFM69_OPMODE_SEQUENCER_ON | RFM69_OPMODE_LISTEN_OFF | RFM69_OPMODE_LISTENABORT |
+		               RFM69_OPMODE_STANDBY);
+		RFM69_writeReg(RFM69_REG_RXTIMEOUT2, RFM69_RXTIMEOUT2_RSSITHRESH_VALUE);
+	}
+
 	if (newRadioMode == RFM69_RADIO_MODE_STDBY) {
 		regMode = RFM69_OPMODE_SEQUENCER_ON | RFM69_OPMODE_LISTEN_OFF | RFM69_OPMODE_STANDBY;
 	} else if (newRadioMode == RFM69_RADIO_MODE_SLEEP) {
@@ -516,6 +560,12 @@ LOCAL bool RFM69_setRadioMode(const rfm69_radio_mode_t newRadioMode)
 		regMode = RFM69_OPMODE_SEQUENCER_ON | RFM69_OPMODE_LISTEN_OFF | RFM69_OPMODE_TRANSMITTER;
 		RFM69_writeReg(RFM69_REG_DIOMAPPING1, RFM69_DIOMAPPING1_DIO0_00); // Interrupt on PacketSent, DIO0
 		RFM69_setHighPowerRegs(RFM69.powerLevel >= (rfm69_powerlevel_t)RFM69_HIGH_POWER_DBM);
+	} else if (newRadioMode == RFM69_RADIO_MODE_LISTEN) {
+		RFM69.dataReceived = false;
+		RFM69.ackReceived = false;
+		regMode = RFM69_OPMODE_SEQUENCER_ON | RFM69_OPMODE_LISTEN_ON | RFM69_OPMODE_STANDBY;
+		RFM69_writeReg(RFM69_REG_DIOMAPPING1, RFM69_DIOMAPPING1_DIO0_01); // Interrupt on PayloadReady, DIO0
+		RFM69_setHighPowerRegs(false);
 	} else if (newRadioMode == RFM69_RADIO_MODE_SYNTH) {
 		regMode = RFM69_OPMODE_SEQUENCER_ON | RFM69_OPMODE_LISTEN_OFF | RFM69_OPMODE_SYNTHESIZER;
 	} else {
@@ -561,7 +611,80 @@ LOCAL bool RFM69_sleep(void)
 LOCAL bool RFM69_standBy(void)
 {
 	RFM69_DEBUG(PSTR("RFM69:RSB\n"));	// put radio to standby
-	return RFM69_setRadioMode(RFM69_RADIO_MODE_STDBY);
+	const bool listening = (RFM69.radioMode == RFM69_RADIO_MODE_LISTEN);
+	const bool result = RFM69_setRadioMode(RFM69_RADIO_MODE_STDBY);
+	if (listening) {
+		// the MCU slept with its own ISR on the radio IRQ
+		attachInterrupt(MY_RFM69_IRQ_NUM, RFM69_interruptHandler, RISING);
+		RFM69_irq = false;
+		if (RFM69_readReg(RFM69_REG_IRQFLAGS2) & RFM69_IRQFLAGS2_PAYLOADREADY) {
+			RFM69_DEBUG(PSTR("RFM69:RLM:PAYLOAD READY\n"));
+			// read the frame as if received in RX
+			RFM69.radioMode = RFM69_RADIO_MODE_RX;
+			RFM69_interruptHandling();
+		}
+	}
+	return result;
+}
+
+LOCAL uint8_t RFM69_listenCoefficient(const uint32_t durationUS, uint8_t &resolution)
+{
+	const uint32_t stepUS[] = { 64ul, 4100ul, 262000ul };
+	resolution = 1u;
+	while (resolution < 3u && durationUS > 255ul * stepUS[resolution - 1u]) {
+		resolution++;
+	}
+	const uint32_t coefficient = durationUS / stepUS[resolution - 1u];
+	if (coefficient > 255u) {
+		return 255u;
+	}
+	return coefficient ? (uint8_t)coefficient : 1u;
+}
+
+LOCAL bool RFM69_listen(void)
+{
+	const uint8_t rfm69_modem_config[] = { MY_RFM69_MODEM_CONFIGURATION };
+	const uint16_t bitrate = (uint16_t)(rfm69_modem_config[1] << 8) | rfm69_modem_config[2];
+	uint8_t idleResolution;
+	uint8_t rxResolution;
+	const uint8_t idleCoefficient = RFM69_listenCoefficient(MY_RFM69_DEFAULT_LISTEN_IDLE_US,
+	                                idleResolution);
+	const uint8_t rxCoefficient = RFM69_listenCoefficient(MY_RFM69_DEFAULT_LISTEN_RX_US,
+	                              rxResolution);
+	// once the RSSI triggered, RX lasts for the rest of a wake-up preamble and the longest frame,
+	// in units of 16 bit times, i.e. bitrate / 2 us
+	uint32_t timeout = (RFM69_LISTEN_CYCLE_MS * 1000ul * 2u + bitrate - 1u) / bitrate +
+	                   (2u + RFM69_MAX_PACKET_LEN + 2u) / 2u + 1u;
+	if (timeout > 255u) {
+		RFM69_DEBUG(PSTR("!RFM69:RLM:TO\n"));
+		timeout = 255u;
+	}
+	RFM69_DEBUG(PSTR("RFM69:RLM:IDLE=%" PRIu8 ",RX=%" PRIu8 ",TO=%" PRIu32 "\n"), idleCoefficient,
+	            rxCoefficient, timeout);
+	(void)RFM69_setRadioMode(RFM69_RADIO_MODE_STDBY);
+	// RSSI criteria, a frame or the timeout resumes the idle phase
+	RFM69_writeReg(RFM69_REG_LISTEN1, (uint8_t)(idleResolution << 6) | (uint8_t)(rxResolution << 4) |
+	               RFM69_LISTEN1_CRITERIA_RSSI | RFM69_LISTEN1_END_10);
+	RFM69_writeReg(RFM69_REG_LISTEN2, idleCoefficient);
+	RFM69_writeReg(RFM69_REG_LISTEN3, rxCoefficient);
+	RFM69_writeReg(RFM69_REG_RXTIMEOUT2, (uint8_t)timeout);
+	RFM69_clearFIFO();
+	return RFM69_setRadioMode(RFM69_RADIO_MODE_LISTEN);
+}
+
+LOCAL void RFM69_setWakeUpPreamble(const uint32_t cycleMS)
+{
+	const uint8_t rfm69_modem_config[] = { MY_RFM69_MODEM_CONFIGURATION };
+	const uint16_t bitrate = (uint16_t)(rfm69_modem_config[1] << 8) | rfm69_modem_config[2];
+	// a preamble byte takes bitrate / 4 us
+	uint32_t length = RFM69_PREAMBLESIZE_LSB_VALUE + cycleMS * 1000ul * 4u / bitrate;
+	if (length > 0xFFFFul) {
+		length = 0xFFFFul;
+	}
+	RFM69.preambleLength = (uint16_t)length;
+	RFM69_DEBUG(PSTR("RFM69:WUP:PRE=%" PRIu16 "\n"), RFM69.preambleLength);
+	RFM69_writeReg(RFM69_REG_PREAMBLEMSB, (uint8_t)(length >> 8));
+	RFM69_writeReg(RFM69_REG_PREAMBLELSB, (uint8_t)length);
 }
 
 
@@ -701,16 +824,18 @@ LOCAL uint8_t RFM69_getTxPowerPercent(void)
 
 LOCAL bool RFM69_sanityCheck(void)
 {
-	bool result = true; // default
-	result &= RFM69_readReg(RFM69_REG_RSSITHRESH) == RFM69_RSSITHRESH_VALUE;
-	result &= RFM69_readReg(RFM69_REG_SYNCVALUE1) == RFM69_SYNCVALUE1;
-	result &= RFM69_readReg(RFM69_REG_SYNCVALUE2) == MY_RFM69_NETWORKID;
-	return result;
+	// RSSI threshold to sync word in one burst
+	uint8_t regs[RFM69_REG_SYNCVALUE2 - RFM69_REG_RSSITHRESH + 1];
+	(void)RFM69_burstReadReg(RFM69_REG_RSSITHRESH, regs, sizeof(regs));
+	return regs[0] == RFM69_RSSITHRESH_VALUE &&
+	       regs[RFM69_REG_SYNCVALUE1 - RFM69_REG_RSSITHRESH] == RFM69_SYNCVALUE1 &&
+	       regs[RFM69_REG_SYNCVALUE2 - RFM69_REG_RSSITHRESH] == MY_RFM69_NETWORKID;
 }
 
 LOCAL void RFM69_setConfiguration(void)
 {
 	const uint8_t rfm69_modem_config[] = { MY_RFM69_MODEM_CONFIGURATION };
+	// ascending, registers in a row are written in one burst (address auto-increment)
 	const uint8_t CONFIG[][2] = {
 		{ RFM69_REG_OPMODE, RFM69_OPMODE_SEQUENCER_ON | RFM69_OPMODE_LISTEN_OFF | RFM69_OPMODE_STANDBY },
 		{ RFM69_REG_DATAMODUL, rfm69_modem_config[0] },
@@ -725,6 +850,8 @@ LOCAL void RFM69_setConfiguration(void)
 		{ RFM69_REG_DIOMAPPING2, RFM69_DIOMAPPING2_CLKOUT_OFF },
 		{ RFM69_REG_IRQFLAGS2, RFM69_IRQFLAGS2_FIFOOVERRUN },		// clear FIFO and flags
 		{ RFM69_REG_RSSITHRESH, RFM69_RSSITHRESH_VALUE },
+		{ RFM69_REG_RXTIMEOUT1, RFM69_RXTIMEOUT1_RXSTART_VALUE },
+		{ RFM69_REG_RXTIMEOUT2, RFM69_RXTIMEOUT2_RSSITHRESH_VALUE },
 		{ RFM69_REG_PREAMBLEMSB, RFM69_PREAMBLESIZE_MSB_VALUE },
 		{ RFM69_REG_PREAMBLELSB, RFM69_PREAMBLESIZE_LSB_VALUE },
 		{ RFM69_REG_SYNCCONFIG, RFM69_SYNC_ON | RFM69_SYNC_FIFOFILL_AUTO | RFM69_SYNC_SIZE_2 | RFM69_SYNC_TOL_0 },
@@ -734,13 +861,21 @@ LOCAL void RFM69_setConfiguration(void)
 		{ RFM69_REG_PAYLOADLENGTH, RFM69_MAX_PACKET_LEN }, // in variable length mode: the max frame size, not used in TX
 		{ RFM69_REG_NODEADRS, RFM69_BROADCAST_ADDRESS },	// init
 		{ RFM69_REG_BROADCASTADRS, RFM69_BROADCAST_ADDRESS },
+		{ RFM69_REG_AUTOMODES, RFM69_AUTOMODES_ENTER_OFF | RFM69_AUTOMODES_EXIT_OFF | RFM69_AUTOMODES_INTERMEDIATE_SLEEP },
 		{ RFM69_REG_FIFOTHRESH, RFM69_FIFOTHRESH_TXSTART_FIFOTHRESH | (RFM69_HEADER_LEN - 1) },	// start transmitting when rfm69 header loaded, fifo level irq when header bytes received (irq asserted when n bytes exceeded)
 		{ RFM69_REG_PACKETCONFIG2, RFM69_PACKET2_RXRESTARTDELAY_2BITS | RFM69_PACKET2_AUTORXRESTART_OFF | RFM69_PACKET2_AES_OFF },
 		{ RFM69_REG_TESTDAGC, RFM69_DAGC_IMPROVED_LOWBETA0 }, // continuous DAGC mode, use 0x30 if afc offset == 0
 		{ 255, 0}
 	};
-	for (uint8_t i = 0; CONFIG[i][0] != 255; i++) {
-		RFM69_writeReg(CONFIG[i][0], CONFIG[i][1]);
+	uint8_t i = 0;
+	while (CONFIG[i][0] != 255) {
+		uint8_t values[sizeof(CONFIG) / sizeof(CONFIG[0])];
+		uint8_t len = 0;
+		const uint8_t reg = CONFIG[i][0];
+		do {
+			values[len++] = CONFIG[i++][1];
+		} while (CONFIG[i][0] == reg + len);
+		(void)RFM69_burstWriteReg(reg, values, len);
 	}
 }
 
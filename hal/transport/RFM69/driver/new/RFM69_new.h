@@ -59,6 +59,10 @@
 * | | RFM69 | SPP  | PCT=%%d,TX LEVEL=%%d                 | Set TX level, input TX percent (PCT)
 * | | RFM69 | RSL  |                                      | Radio in sleep mode
 * | | RFM69 | RSB  |                                      | Radio in standby mode
+* | | RFM69 | RLM  | IDLE=%%d,RX=%%d,TO=%%d               | Radio in listen mode, idle (IDLE) and RX (RX) coefficients, RX timeout (TO)
+* |!| RFM69 | RLM  | TO                                   | Listen cycle too long for the RX timeout, long preambles are missed
+* | | RFM69 | RLM  | PAYLOAD READY                        | Listen mode left with a received frame
+* | | RFM69 | WUP  | PRE=%%d                              | Preamble length (PRE) in bytes, spanning the listen cycle of receivers
 * | | RFM69 | PWD  |                                      | Power down radio
 * | | RFM69 | PWU  |                                      | Power up radio
 *
@@ -155,6 +159,8 @@
 #if !defined(MY_RFM69_CSMA_TIMEOUT_MS)
 #define MY_RFM69_CSMA_TIMEOUT_MS            (500ul)		//!< CSMA timeout
 #endif
+// listen mode
+#define RFM69_LISTEN_CYCLE_MS            ((MY_RFM69_DEFAULT_LISTEN_IDLE_US + MY_RFM69_DEFAULT_LISTEN_RX_US + 999ul) / 1000ul)	//!< Listen cycle, rounded up
 // powerup delay
 #define RFM69_POWERUP_DELAY_MS           (100ul)		//!< Power up delay, allow VCC to settle, transport to become fully operational
 
@@ -321,6 +327,8 @@ typedef struct {
 	rfm69_sequenceNumber_t txSequenceNumber;   //!< RFM69_txSequenceNumber
 	rfm69_powerlevel_t powerLevel;             //!< TX power level dBm
 	uint8_t ATCtargetRSSI;                     //!< ATC: target RSSI
+	uint32_t airtime;                          //!< Time on air of the transmitted frames in us, wraps around
+	uint16_t preambleLength;                   //!< Preamble length of the transmitted frames in bytes
 	// 8 bit
 	rfm69_radio_mode_t radioMode : 3;          //!< current transceiver state
 	bool dataReceived : 1;                     //!< data received
@@ -393,6 +401,19 @@ LOCAL uint8_t RFM69_receive(uint8_t *buf, const uint8_t maxBufSize);
 */
 LOCAL bool RFM69_sendFrame(rfm69_packet_t *packet, const bool increaseSequenceCounter = true);
 
+/**
+* @brief Time on air of a frame with the modem configuration
+* @param len Length of the frame including the length byte and header
+* @return Time on air in us
+*/
+LOCAL uint32_t RFM69_getTimeOnAir(const uint8_t len);
+
+/**
+* @brief Get the time on air of all transmitted frames, including retries and ACKs
+* @return Time on air in us, wraps around
+*/
+LOCAL uint32_t RFM69_getAirtime(void);
+
 /**
 * @brief RFM69_send
 * @param recipient
@@ -442,6 +463,29 @@ LOCAL bool RFM69_sleep(void);
 */
 LOCAL bool RFM69_standBy(void);
 
+/**
+* @brief Sets the radio to listen mode, it receives for @ref MY_RFM69_DEFAULT_LISTEN_RX_US every
+* @ref MY_RFM69_DEFAULT_LISTEN_IDLE_US and raises the IRQ on a received frame. Leave it with
+* RFM69_standBy(), which picks up the frame.
+* @return true if listen mode was entered
+*/
+LOCAL bool RFM69_listen(void);
+
+/**
+* @brief Convert a listen mode duration to a coefficient and resolution
+* @param durationUS Duration in us
+* @param resolution Resolution, 1..3 for 64us, 4.1ms and 262ms
+* @return coefficient, the duration is rounded down
+*/
+LOCAL uint8_t RFM69_listenCoefficient(const uint32_t durationUS, uint8_t &resolution);
+
+/**
+* @brief Set the preamble of the next frames to span a listen cycle, a receiver in listen mode
+* detects it in its next RX window and stays in RX for the frame.
+* @param cycleMS Listen cycle of the receiver, 0 for the default preamble
+*/
+LOCAL void RFM69_setWakeUpPreamble(const uint32_t cycleMS);
+
 /**
 * @brief Power down radio (HW)
 */
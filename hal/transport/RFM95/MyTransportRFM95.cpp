@@ -51,6 +51,11 @@ bool transportSend(const uint8_t to, const void *data, const uint8_t len, const
 	return RFM95_sendWithRetry(to, data, len);
 }
 
+uint32_t transportGetAirtime(void)
+{
+	return RFM95_getAirtime();
+}
+
 bool transportDataAvailable(void)
 {
 	RFM95_handler();
@@ -0,0 +1,107 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// RFM95 as secondary radio of the GW, see MY_GATEWAY_SECONDARY_RFM95
+
+#include "hal/transport/RFM95/driver/RFM95.h"
+
+bool transportSecondaryInit(void)
+{
+	const bool result = RFM95_initialise(MY_RFM95_FREQUENCY);
+#if defined(MY_RFM95_TCXO)
+	RFM95_enableTCXO();
+#endif
+	return result;
+}
+
+void transportSecondarySetAddress(const uint8_t address)
+{
+	RFM95_setAddress(address);
+}
+
+bool transportSecondarySend(const uint8_t to, const void *data, const uint8_t len,
+                            const bool noACK)
+{
+	if (noACK) {
+		(void)RFM95_sendWithRetry(to, data, len, 0, 0);
+		return true;
+	}
+	return RFM95_sendWithRetry(to, data, len);
+}
+
+uint32_t transportSecondaryGetAirtime(void)
+{
+	return RFM95_getAirtime();
+}
+
+bool transportSecondaryDataAvailable(void)
+{
+	RFM95_handler();
+	return RFM95_available();
+}
+
+bool transportSecondarySanityCheck(void)
+{
+	return RFM95_sanityCheck();
+}
+
+uint8_t transportSecondaryReceive(void *data)
+{
+	return RFM95_receive((uint8_t *)data, MAX_MESSAGE_LENGTH);
+}
+
+void transportSecondarySleep(void)
+{
+	(void)RFM95_sleep();
+}
+
+void transportSecondaryStandBy(void)
+{
+	(void)RFM95_standBy();
+}
+
+void transportSecondaryPowerDown(void)
+{
+	RFM95_powerDown();
+}
+
+void transportSecondaryPowerUp(void)
+{
+	RFM95_powerUp();
+}
+
+int16_t transportSecondaryGetSendingRSSI(void)
+{
+	return RFM95_getSendingRSSI();
+}
+
+int16_t transportSecondaryGetReceivingRSSI(void)
+{
+	return RFM95_getReceivingRSSI();
+}
+
+int16_t transportSecondaryGetSendingSNR(void)
+{
+	return RFM95_getSendingSNR();
+}
+
+int16_t transportSecondaryGetReceivingSNR(void)
+{
+	return RFM95_getReceivingSNR();
+}
@@ -93,6 +93,16 @@ LOCAL uint8_t RFM95_spiMultiByteTransfer(const uint8_t cmd, uint8_t *buf, uint8_
 	}
 #else
 	status = RFM95_SPI.transfer(cmd);
+#if defined(MY_HW_HAS_SPI_DMA) && !defined(MY_SOFTSPI)
+	if (buf != NULL && len >= MY_SPI_DMA_MIN_LENGTH) {
+		// payload bytes back to back, CS stays low until the transfer is done
+		hwSPITransferDMA(aReadMode ? NULL : buf, aReadMode ? buf : NULL, len);
+		if (aReadMode) {
+			status = buf[len - 1];
+		}
+		len = 0;
+	}
+#endif
 	while (len--) {
 		if (aReadMode) {
 			status = RFM95_SPI.transfer((uint8_t)RFM95_NOP);
@@ -209,14 +219,17 @@ LOCAL bool RFM95_initialise(const uint32_t frequencyHz)
 #endif
 
 	// Set up FIFO, 256 bytes: LoRa max message 64 bytes, set half RX half TX (default)
-	(void)RFM95_writeReg(RFM95_REG_0F_FIFO_RX_BASE_ADDR, RFM95_RX_FIFO_ADDR);
-	(void)RFM95_writeReg(RFM95_REG_0E_FIFO_TX_BASE_ADDR, RFM95_TX_FIFO_ADDR);
-	(void)RFM95_writeReg(RFM95_REG_23_MAX_PAYLOAD_LENGTH, RFM95_MAX_PACKET_LEN);
+	const uint8_t fifoBaseRegs[] = { RFM95_TX_FIFO_ADDR, RFM95_RX_FIFO_ADDR };
+	(void)RFM95_burstWriteReg(RFM95_REG_0E_FIFO_TX_BASE_ADDR, fifoBaseRegs, sizeof(fifoBaseRegs));
 
 	(void)RFM95_setRadioMode(RFM95_RADIO_MODE_STDBY);
 	const rfm95_modemConfig_t configuration = { MY_RFM95_MODEM_CONFIGRUATION };
 	RFM95_setModemRegisters(&configuration);
-	RFM95_setPreambleLength(RFM95_PREAMBLE_LENGTH);
+	// preamble, payload length (set per frame) and max payload length in one burst
+	const uint8_t packetRegs[] = { (uint8_t)((RFM95_PREAMBLE_LENGTH >> 8) & 0xff),
+	                               (uint8_t)(RFM95_PREAMBLE_LENGTH & 0xff), RFM95_MAX_PACKET_LEN, RFM95_MAX_PACKET_LEN
+	                             };
+	(void)RFM95_burstWriteReg(RFM95_REG_20_PREAMBLE_MSB, packetRegs, sizeof(packetRegs));
 	RFM95_setFrequency(frequencyHz);
 	(void)RFM95_setTxPowerLevel(MY_RFM95_TX_POWER_DBM);
 
@@ -242,21 +255,44 @@ LOCAL void RFM95_interruptHandler(void)
 // RxDone, TxDone, CADDone is mapped to DI0
 LOCAL void RFM95_interruptHandling(void)
 {
-	// read interrupt register
-	const uint8_t irqFlags = RFM95_readReg(RFM95_REG_12_IRQ_FLAGS);
+	// read interrupt register, together with the RX FIFO address and the number of bytes received
+	uint8_t rxRegs[4];
+	(void)RFM95_burstReadReg(RFM95_REG_10_FIFO_RX_CURRENT_ADDR, rxRegs, sizeof(rxRegs));
+	const uint8_t irqFlags = rxRegs[RFM95_REG_12_IRQ_FLAGS - RFM95_REG_10_FIFO_RX_CURRENT_ADDR];
 	if (RFM95.radioMode == RFM95_RADIO_MODE_RX && (irqFlags & RFM95_RX_DONE)) {
 		// RXSingle mode: Radio goes automatically to STDBY after packet received
 		(void)RFM95_setRadioMode(RFM95_RADIO_MODE_STDBY);
 		// Check CRC flag
 		if (!(irqFlags & RFM95_PAYLOAD_CRC_ERROR)) {
-			const uint8_t bufLen = min(RFM95_readReg(RFM95_REG_13_RX_NB_BYTES), (uint8_t)RFM95_MAX_PACKET_LEN);
+			const uint8_t bufLen = min(rxRegs[RFM95_REG_13_RX_NB_BYTES - RFM95_REG_10_FIFO_RX_CURRENT_ADDR],
+			                           (uint8_t)RFM95_MAX_PACKET_LEN);
 			if (bufLen >= RFM95_HEADER_LEN) {
+				// SNR and RSSI of latest packet received
+				uint8_t signalRegs[2];
+#if defined(SPI_HAS_TRANSFER_QUEUE)
+				// set the fifo read ptr, read packet and signal with one submission
+				uint8_t fifoAddr[2] = { RFM95_REG_0D_FIFO_ADDR_PTR | RFM95_WRITE_REGISTER, rxRegs[0] };
+				uint8_t signal[3] = { RFM95_REG_19_PKT_SNR_VALUE & RFM95_READ_REGISTER, RFM95_NOP, RFM95_NOP };
+				RFM95_spi_txbuff[0] = RFM95_REG_00_FIFO & RFM95_READ_REGISTER;
+				(void)memset((void *)&RFM95_spi_txbuff[1], RFM95_NOP, bufLen);
+				RFM95_SPI.beginTransaction(SPISettings(MY_RFM95_SPI_SPEED, RFM95_SPI_DATA_ORDER,
+				                                       RFM95_SPI_DATA_MODE));
+				RFM95_SPI.queueTransfer((char *)fifoAddr, (char *)fifoAddr, sizeof(fifoAddr));
+				RFM95_SPI.queueTransfer((char *)RFM95_spi_txbuff, (char *)RFM95_spi_rxbuff, bufLen + 1);
+				RFM95_SPI.queueTransfer((char *)signal, (char *)signal, sizeof(signal));
+				RFM95_SPI.submitTransfers();
+				(void)memcpy((void *)RFM95.currentPacket.data, (const void *)&RFM95_spi_rxbuff[1], bufLen);
+				RFM95_SPI.endTransaction();
+				signalRegs[0] = signal[1];
+				signalRegs[1] = signal[2];
+#else
 				// Reset the fifo read ptr to the beginning of the packet
-				(void)RFM95_writeReg(RFM95_REG_0D_FIFO_ADDR_PTR, RFM95_readReg(RFM95_REG_10_FIFO_RX_CURRENT_ADDR));
+				(void)RFM95_writeReg(RFM95_REG_0D_FIFO_ADDR_PTR, rxRegs[0]);
 				(void)RFM95_burstReadReg(RFM95_REG_00_FIFO, RFM95.currentPacket.data, bufLen);
-				RFM95.currentPacket.RSSI = static_cast<rfm95_RSSI_t>(RFM95_readReg(
-				                               RFM95_REG_1A_PKT_RSSI_VALUE)); // RSSI of latest packet received
-				RFM95.currentPacket.SNR = static_cast<rfm95_SNR_t>(RFM95_readReg(RFM95_REG_19_PKT_SNR_VALUE));
+				(void)RFM95_burstReadReg(RFM95_REG_19_PKT_SNR_VALUE, signalRegs, sizeof(signalRegs));
+#endif
+				RFM95.currentPacket.SNR = static_cast<rfm95_SNR_t>(signalRegs[0]);
+				RFM95.currentPacket.RSSI = static_cast<rfm95_RSSI_t>(signalRegs[1]);
 				RFM95.currentPacket.payloadLen = bufLen - RFM95_HEADER_LEN;
 				if ((RFM95.currentPacket.header.version >= RFM95_MIN_PACKET_HEADER_VERSION) &&
 				        (RFM95_PROMISCUOUS || RFM95.currentPacket.header.recipient == RFM95.address ||
@@ -331,23 +367,68 @@ LOCAL uint8_t RFM95_receive(uint8_t *buf, const uint8_t maxBufSize)
 
 LOCAL bool RFM95_sendFrame(rfm95_packet_t *packet, const bool increaseSequenceCounter)
 {
-	// Check channel activity
-	if (!RFM95_waitCAD()) {
-		return false;
+	// Listen before talk, back off while there is channel activity
+	for (uint8_t attempt = 0; !RFM95_waitCAD(); attempt++) {
+		RFM95.stats.channelBusy++;
+		if (attempt >= RFM95_CAD_RETRIES) {
+			RFM95.stats.channelFailed++;
+			RFM95_DEBUG(PSTR("!RFM95:CAD:FAIL\n"));
+			return false;
+		}
+		const uint32_t backoffMS = RFM95_backoff(attempt);
+		(void)backoffMS;
+		RFM95_DEBUG(PSTR("!RFM95:CAD:BUSY,BO=%" PRIu32 "\n"), backoffMS);
 	}
+	RFM95.stats.txFrames++;
 	// radio is in STDBY
 	if (increaseSequenceCounter) {
 		// increase sequence counter, overflow is ok
 		RFM95.txSequenceNumber++;
 	}
 	packet->header.sequenceNumber = RFM95.txSequenceNumber;
+	const uint8_t finalLen = packet->payloadLen + RFM95_HEADER_LEN;
+#if defined(MY_RFM95_IMPLICIT_ACK)
+	// the recipient waits for the ACK and knows its length
+	const bool implicitHeader = RFM95_getACKReceived(packet->header.controlFlags);
+	if (implicitHeader) {
+		RFM95_setImplicitHeader(finalLen);
+	}
+#else
+	const bool implicitHeader = false;
+#endif
+#if defined(MY_RFM95_SHORT_PREAMBLE_LENGTH)
+	// receivers listen for the full preamble, they detect a shorter one as well
+	const uint8_t recipient = packet->header.recipient;
+	const uint16_t preambleLength = bitRead(RFM95.shortPreamble[recipient >> 3],
+	                                        recipient & 7) ? MY_RFM95_SHORT_PREAMBLE_LENGTH : RFM95_PREAMBLE_LENGTH;
+	if (preambleLength != RFM95_PREAMBLE_LENGTH) {
+		RFM95_setPreambleLength(preambleLength);
+	}
+#else
+	const uint16_t preambleLength = RFM95_PREAMBLE_LENGTH;
+#endif
+	RFM95.stats.airtime += RFM95_getTimeOnAir(finalLen, preambleLength, implicitHeader);
+#if defined(SPI_HAS_TRANSFER_QUEUE)
+	// position, write packet and length with one submission
+	uint8_t fifoAddr[2] = { RFM95_REG_0D_FIFO_ADDR_PTR | RFM95_WRITE_REGISTER, RFM95_TX_FIFO_ADDR };
+	uint8_t payloadLength[2] = { RFM95_REG_22_PAYLOAD_LENGTH | RFM95_WRITE_REGISTER, finalLen };
+	RFM95_spi_txbuff[0] = RFM95_REG_00_FIFO | RFM95_WRITE_REGISTER;
+	(void)memcpy((void *)&RFM95_spi_txbuff[1], (const void *)packet->data, finalLen);
+	RFM95_SPI.beginTransaction(SPISettings(MY_RFM95_SPI_SPEED, RFM95_SPI_DATA_ORDER,
+	                                       RFM95_SPI_DATA_MODE));
+	RFM95_SPI.queueTransfer((char *)fifoAddr, (char *)fifoAddr, sizeof(fifoAddr));
+	RFM95_SPI.queueTransfer((char *)RFM95_spi_txbuff, (char *)RFM95_spi_rxbuff, finalLen + 1);
+	RFM95_SPI.queueTransfer((char *)payloadLength, (char *)payloadLength, sizeof(payloadLength));
+	RFM95_SPI.submitTransfers();
+	RFM95_SPI.endTransaction();
+#else
 	// Position at the beginning of the TX FIFO
 	(void)RFM95_writeReg(RFM95_REG_0D_FIFO_ADDR_PTR, RFM95_TX_FIFO_ADDR);
 	// write packet
-	const uint8_t finalLen = packet->payloadLen + RFM95_HEADER_LEN;
 	(void)RFM95_burstWriteReg(RFM95_REG_00_FIFO, packet->data, finalLen);
 	// total payload length
 	(void)RFM95_writeReg(RFM95_REG_22_PAYLOAD_LENGTH, finalLen);
+#endif
 	// send message, if sent, irq fires and radio returns to standby
 	(void)RFM95_setRadioMode(RFM95_RADIO_MODE_TX);
 	// wait until IRQ fires or timeout
@@ -356,6 +437,13 @@ LOCAL bool RFM95_sendFrame(rfm95_packet_t *packet, const bool increaseSequenceCo
 	while (!RFM95_irq && (hwMillis() - startTX_MS < MY_RFM95_TX_TIMEOUT_MS) ) {
 		doYield();
 	}
+	// back to the settings for listening, the radio is in STDBY after TX
+	if (implicitHeader) {
+		RFM95_setImplicitHeader(0);
+	}
+	if (preambleLength != RFM95_PREAMBLE_LENGTH) {
+		RFM95_setPreambleLength(RFM95_PREAMBLE_LENGTH);
+	}
 	return RFM95_irq;
 }
 
@@ -375,9 +463,10 @@ LOCAL bool RFM95_send(const uint8_t recipient, uint8_t *data, const uint8_t len,
 LOCAL void RFM95_setFrequency(const uint32_t frequencyHz)
 {
 	const uint32_t freqReg = (uint32_t)(frequencyHz / RFM95_FSTEP);
-	(void)RFM95_writeReg(RFM95_REG_06_FRF_MSB, (uint8_t)((freqReg >> 16) & 0xff));
-	(void)RFM95_writeReg(RFM95_REG_07_FRF_MID, (uint8_t)((freqReg >> 8) & 0xff));
-	(void)RFM95_writeReg(RFM95_REG_08_FRF_LSB, (uint8_t)(freqReg & 0xff));
+	const uint8_t freqRegs[] = { (uint8_t)((freqReg >> 16) & 0xff), (uint8_t)((freqReg >> 8) & 0xff),
+	                             (uint8_t)(freqReg & 0xff)
+	                           };
+	(void)RFM95_burstWriteReg(RFM95_REG_06_FRF_MSB, freqRegs, sizeof(freqRegs));
 }
 
 LOCAL bool RFM95_setTxPowerLevel(rfm95_powerLevel_t newPowerLevel)
@@ -417,15 +506,55 @@ LOCAL void RFM95_enableTCXO(void)
 // Sets registers from a canned modem configuration structure
 LOCAL void RFM95_setModemRegisters(const rfm95_modemConfig_t *config)
 {
-	(void)RFM95_writeReg(RFM95_REG_1D_MODEM_CONFIG1, config->reg_1d);
-	(void)RFM95_writeReg(RFM95_REG_1E_MODEM_CONFIG2, config->reg_1e);
+	const uint8_t modemRegs[] = { config->reg_1d, config->reg_1e };
+	(void)RFM95_burstWriteReg(RFM95_REG_1D_MODEM_CONFIG1, modemRegs, sizeof(modemRegs));
 	(void)RFM95_writeReg(RFM95_REG_26_MODEM_CONFIG3, config->reg_26);
 }
 
 LOCAL void RFM95_setPreambleLength(const uint16_t preambleLength)
 {
-	(void)RFM95_writeReg(RFM95_REG_20_PREAMBLE_MSB, (uint8_t)((preambleLength >> 8) & 0xff));
-	(void)RFM95_writeReg(RFM95_REG_21_PREAMBLE_LSB, (uint8_t)(preambleLength & 0xff));
+	const uint8_t preambleRegs[] = { (uint8_t)((preambleLength >> 8) & 0xff),
+	                                 (uint8_t)(preambleLength & 0xff)
+	                               };
+	(void)RFM95_burstWriteReg(RFM95_REG_20_PREAMBLE_MSB, preambleRegs, sizeof(preambleRegs));
+}
+
+LOCAL void RFM95_setImplicitHeader(const uint8_t len)
+{
+	// the modem configuration is changed in STDBY
+	const bool listening = (RFM95.radioMode == RFM95_RADIO_MODE_RX);
+	if (listening) {
+		(void)RFM95_setRadioMode(RFM95_RADIO_MODE_STDBY);
+	}
+	const rfm95_modemConfig_t config = { MY_RFM95_MODEM_CONFIGRUATION };
+	if (len) {
+		(void)RFM95_writeReg(RFM95_REG_1D_MODEM_CONFIG1, config.reg_1d | RFM95_IMPLICIT_HEADER_MODE_ON);
+		(void)RFM95_writeReg(RFM95_REG_22_PAYLOAD_LENGTH, len);
+	} else {
+		(void)RFM95_writeReg(RFM95_REG_1D_MODEM_CONFIG1, config.reg_1d);
+	}
+	if (listening) {
+		(void)RFM95_setRadioMode(RFM95_RADIO_MODE_RX);
+	}
+}
+
+LOCAL void RFM95_updateLinkPreamble(const uint8_t node, const rfm95_SNR_t SNR)
+{
+#if defined(MY_RFM95_SHORT_PREAMBLE_LENGTH)
+	// demodulation limit: -7.5dB at SF7, 2.5dB lower per SF step
+	const rfm95_modemConfig_t config = { MY_RFM95_MODEM_CONFIGRUATION };
+	const int16_t limitSNR = -5 - (5 * ((config.reg_1e >> 4) - 6)) / 2;
+	const bool isShort = RFM95_internalToSNR(SNR) >= limitSNR + MY_RFM95_SHORT_PREAMBLE_MARGIN_DB;
+	if (node != RFM95_BROADCAST_ADDRESS &&
+	        isShort != bitRead(RFM95.shortPreamble[node >> 3], node & 7)) {
+		bitWrite(RFM95.shortPreamble[node >> 3], node & 7, isShort);
+		RFM95_DEBUG(PSTR("RFM95:LNK:TO=%" PRIu8 ",PRE=%" PRIu16 "\n"), node,
+		            isShort ? MY_RFM95_SHORT_PREAMBLE_LENGTH : RFM95_PREAMBLE_LENGTH);
+	}
+#else
+	(void)node;
+	(void)SNR;
+#endif
 }
 
 LOCAL void RFM95_setAddress(const uint8_t addr)
@@ -514,6 +643,8 @@ LOCAL void RFM95_sendACK(const uint8_t recipient, const rfm95_sequenceNumber_t s
 	rfm95_controlFlags_t flags = 0u;
 	RFM95_setACKReceived(flags, true);
 	RFM95_setACKRSSIReport(flags, true);
+	// the SNR of the frame tells how well the link carries a short preamble
+	RFM95_updateLinkPreamble(recipient, SNR);
 	(void)RFM95_send(recipient, (uint8_t *)&ACK, sizeof(rfm95_ack_t), flags);
 }
 
@@ -551,6 +682,15 @@ LOCAL bool RFM95_sendWithRetry(const uint8_t recipient, const void *buffer,
 		if (!RFM95_send(recipient, (uint8_t *)buffer, bufferSize, flags, !retry)) {
 			return false;
 		}
+		if (retry) {
+			RFM95.stats.txRetries++;
+		}
+#if defined(MY_RFM95_IMPLICIT_ACK)
+		if (recipient != RFM95_BROADCAST_ADDRESS) {
+			// the ACK is the only frame expected
+			RFM95_setImplicitHeader(RFM95_ACK_FRAME_LEN);
+		}
+#endif
 		(void)RFM95_setRadioMode(RFM95_RADIO_MODE_RX);
 		if (recipient == RFM95_BROADCAST_ADDRESS) {
 			return true;
@@ -563,7 +703,7 @@ LOCAL bool RFM95_sendWithRetry(const uint8_t recipient, const void *buffer,
 				const rfm95_sequenceNumber_t ACKsequenceNumber = RFM95.currentPacket.ACK.sequenceNumber;
 				const rfm95_controlFlags_t flag = RFM95.currentPacket.header.controlFlags;
 				const rfm95_RSSI_t RSSI = RFM95.currentPacket.ACK.RSSI;
-				//const rfm95_SNR_t SNR = RFM95.currentPacket.ACK.SNR;
+				const rfm95_SNR_t SNR = RFM95.currentPacket.ACK.SNR;
 				RFM95.ackReceived = false;
 				// packet read, back to RX
 				RFM95_setRadioMode(RFM95_RADIO_MODE_RX);
@@ -577,18 +717,37 @@ LOCAL bool RFM95_sendWithRetry(const uint8_t recipient, const void *buffer,
 					if (RFM95.ATCenabled && RFM95_getACKRSSIReport(flag)) {
 						(void)RFM95_executeATC(RSSI, RFM95.ATCtargetRSSI);
 					}
+					if (RFM95_getACKRSSIReport(flag)) {
+						RFM95_updateLinkPreamble(recipient, SNR);
+					}
+#if defined(MY_RFM95_IMPLICIT_ACK)
+					RFM95_setImplicitHeader(0);
+#endif
 					return true;
 				} // seq check
 			}
 			doYield();
 		}
-		RFM95_DEBUG(PSTR("!RFM95:SWR:NACK\n"));
-		const uint32_t enterCSMAMS = hwMillis();
-		const uint16_t randDelayCSMA = enterMS % 100;
-		while (hwMillis() - enterCSMAMS < randDelayCSMA) {
-			doYield();
+#if defined(MY_RFM95_IMPLICIT_ACK)
+		if (recipient != RFM95_BROADCAST_ADDRESS) {
+			RFM95_setImplicitHeader(0);
+		}
+#endif
+		// no ACK, retry with the full preamble
+		RFM95_updateLinkPreamble(recipient, INT8_MIN);
+		if (retry < retries) {
+			// spread the retries of nodes that collided
+			const uint32_t backoffMS = RFM95_backoff(retry);
+			(void)backoffMS;
+			RFM95_DEBUG(PSTR("!RFM95:SWR:NACK,BO=%" PRIu32 "\n"), backoffMS);
+		} else {
+			RFM95_DEBUG(PSTR("!RFM95:SWR:NACK\n"));
 		}
 	}
+	if (retryWaitTime) {
+		// not a fire and forget frame
+		RFM95.stats.txFailed++;
+	}
 	if (RFM95.ATCenabled) {
 		// No ACK received, maybe out of reach: increase power level
 		(void)RFM95_setTxPowerLevel(RFM95.powerLevel + 1);
@@ -610,6 +769,51 @@ LOCAL bool RFM95_waitCAD(void)
 	return !RFM95.channelActive;
 }
 
+LOCAL uint32_t RFM95_backoff(const uint8_t attempt)
+{
+	uint32_t window = RFM95_BACKOFF_MS;
+	for (uint8_t i = 0; i < attempt && window < RFM95_BACKOFF_MAX_MS; i++) {
+		window <<= 1;
+	}
+	if (window > RFM95_BACKOFF_MAX_MS) {
+		window = RFM95_BACKOFF_MAX_MS;
+	}
+	// random() may be unseeded, the clock differs between nodes that collided
+	const uint32_t backoffMS = ((uint32_t)random(window) + hwMicros()) % window;
+	const uint32_t enterMS = hwMillis();
+	while (hwMillis() - enterMS < backoffMS) {
+		RFM95_handler();
+		doYield();
+	}
+	return backoffMS;
+}
+
+LOCAL uint32_t RFM95_getTimeOnAir(const uint8_t len, const uint16_t preambleLength,
+                                  const bool implicitHeader)
+{
+	// bandwidth in 100Hz by register value
+	static const uint16_t bandwidth[] = { 78u, 104u, 156u, 208u, 313u, 417u, 625u, 1250u, 2500u, 5000u };
+	const rfm95_modemConfig_t config = { MY_RFM95_MODEM_CONFIGRUATION };
+	const uint8_t SF = config.reg_1e >> 4;
+	const uint8_t CR = (config.reg_1d >> 1) & 0x07u;
+	const uint8_t LDRO = (config.reg_26 & RFM95_LOW_DATA_RATE_OPTIMIZE) ? 2u : 0u;
+	const int16_t bits = 8 * len - 4 * SF + 28 + ((config.reg_1e & RFM95_RX_PAYLOAD_CRC_ON) ? 16 : 0) -
+	                     ((implicitHeader || (config.reg_1d & RFM95_IMPLICIT_HEADER_MODE_ON)) ? 20 : 0);
+	const uint8_t bitsPerSymbol = 4u * (SF - LDRO);
+	uint16_t symbols = 8u;
+	if (bits > 0) {
+		symbols += ((bits + bitsPerSymbol - 1) / bitsPerSymbol) * (CR + 4u);
+	}
+	// preamble + 4.25 symbols and payload, in quarter symbols of 2^SF / BW
+	const uint32_t quarterSymbols = preambleLength * 4u + 17u + symbols * 4u;
+	return (uint32_t)(((uint64_t)quarterSymbols << SF) * 10000u / (4u * bandwidth[config.reg_1d >> 4]));
+}
+
+LOCAL uint32_t RFM95_getAirtime(void)
+{
+	return RFM95.stats.airtime;
+}
+
 LOCAL void RFM95_ATCmode(const bool OnOff, const int16_t targetRSSI)
 {
 	RFM95.ATCenabled = OnOff;
@@ -618,11 +822,10 @@ LOCAL void RFM95_ATCmode(const bool OnOff, const int16_t targetRSSI)
 
 LOCAL bool RFM95_sanityCheck(void)
 {
-	bool result = true;
-	result &= RFM95_readReg(RFM95_REG_0F_FIFO_RX_BASE_ADDR) == RFM95_RX_FIFO_ADDR;
-	result &= RFM95_readReg(RFM95_REG_0E_FIFO_TX_BASE_ADDR) == RFM95_TX_FIFO_ADDR;
-	result &= RFM95_readReg(RFM95_REG_23_MAX_PAYLOAD_LENGTH) == RFM95_MAX_PACKET_LEN;
-	return result;
+	uint8_t fifoBaseRegs[2];
+	(void)RFM95_burstReadReg(RFM95_REG_0E_FIFO_TX_BASE_ADDR, fifoBaseRegs, sizeof(fifoBaseRegs));
+	return fifoBaseRegs[0] == RFM95_TX_FIFO_ADDR && fifoBaseRegs[1] == RFM95_RX_FIFO_ADDR &&
+	       RFM95_readReg(RFM95_REG_23_MAX_PAYLOAD_LENGTH) == RFM95_MAX_PACKET_LEN;
 }
 
 
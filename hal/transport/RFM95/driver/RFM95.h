@@ -52,7 +52,10 @@
 * | | RFM95 | ATC  | ADJ TXL,cR=%%d,tR=%%d..%%d,TXL=%%d     | Adjust TX level, current RSSI (cR), target RSSI range (tR), TX level (TXL)
 * | | RFM95 | SWR  | SEND,TO=%%d,RETRY=%%d                  | Send message to (TO), NACK retry counter (RETRY)
 * | | RFM95 | SWR  | ACK FROM=%%d,SEQ=%%d,RSSI=%%d,SNR=%%d  | ACK received from node (FROM), seq ID (SEQ), (RSSI), (SNR)
-* |!| RFM95 | SWR  | NACK                                   | No ACK received
+* |!| RFM95 | SWR  | NACK,BO=%%d                            | No ACK received, back off (BO) ms before the retry
+* | | RFM95 | LNK  | TO=%%d,PRE=%%d                         | Frames to node (TO) are sent with a preamble of (PRE) symbols
+* |!| RFM95 | CAD  | BUSY,BO=%%d                            | Channel activity detected, back off (BO) ms before the next CAD
+* |!| RFM95 | CAD  | FAIL                                   | Channel still busy after RFM95_CAD_RETRIES, frame not sent
 * | | RFM95 | SPP  | PCT=%%d,TX LEVEL=%%d                   | Set TX level percent (PCT), TX level (LEVEL)
 * | | RFM95 | PWD  |                                        | Power down radio
 * | | RFM95 | PWU  |                                        | Power up radio
@@ -130,6 +133,19 @@
 #define RFM95_RETRY_TIMEOUT_MS			(500ul)			//!< Timeout for ACK, adjustments needed if modem configuration changed (air time different)
 #endif
 
+#if !defined(RFM95_CAD_RETRIES)
+#define RFM95_CAD_RETRIES				(5u)			//!< Channel activity detections before a frame is given up
+#endif
+
+#if !defined(RFM95_BACKOFF_MS)
+// random backoff window for the first retry, doubled for each further one, ~2x air-time of BW125/SF128
+#define RFM95_BACKOFF_MS				(100ul)			//!< Initial backoff window after a busy channel or a missing ACK
+#endif
+
+#if !defined(RFM95_BACKOFF_MAX_MS)
+#define RFM95_BACKOFF_MAX_MS			(3200ul)		//!< Max backoff window
+#endif
+
 #if !defined(MY_RFM95_TX_TIMEOUT_MS)
 #define MY_RFM95_TX_TIMEOUT_MS                 (5*1000ul)		//!< TX timeout
 #endif
@@ -147,6 +163,9 @@
 #define RFM95_TX_FIFO_ADDR                     (0x80u)			//!< TX FIFO addr pointer
 #define RFM95_MAX_PACKET_LEN                   (0x40u)			//!< This is the maximum number of bytes that can be carried by the LORA
 #define RFM95_PREAMBLE_LENGTH                  (8u)					//!< Preamble length, default=8
+#if defined(MY_RFM95_SHORT_PREAMBLE_LENGTH) && (MY_RFM95_SHORT_PREAMBLE_LENGTH < 6 || MY_RFM95_SHORT_PREAMBLE_LENGTH >= RFM95_PREAMBLE_LENGTH)
+#error MY_RFM95_SHORT_PREAMBLE_LENGTH must be at least 6 and shorter than RFM95_PREAMBLE_LENGTH
+#endif
 #define RFM95_CAD_TIMEOUT_MS                   (2*1000ul)		//!< channel activity detection timeout
 #define RFM95_POWERUP_DELAY_MS                 (100u)				//!< Power up delay, allow VCC to settle, transport to become fully operational
 
@@ -243,6 +262,7 @@ typedef struct {
 
 #define RFM95_HEADER_LEN sizeof(rfm95_header_t)		//!< Size header inside LoRa payload
 #define RFM95_MAX_PAYLOAD_LEN (RFM95_MAX_PACKET_LEN - RFM95_HEADER_LEN)	//!< Max payload length
+#define RFM95_ACK_FRAME_LEN (RFM95_HEADER_LEN + sizeof(rfm95_ack_t))	//!< Length of an ACK frame
 
 /**
 * @brief LoRa packet structure
@@ -264,6 +284,18 @@ typedef struct {
 } __attribute__((packed)) rfm95_packet_t;
 
 
+/**
+* @brief RFM95 channel access statistics
+*/
+typedef struct {
+	uint16_t txFrames;                        //!< Frames transmitted, including retries and ACKs
+	uint16_t txRetries;                       //!< Frames retransmitted after a missing ACK
+	uint16_t txFailed;                        //!< Messages not acknowledged after all retries
+	uint16_t channelBusy;                     //!< Channel activity detections that delayed a frame
+	uint16_t channelFailed;                   //!< Frames dropped because the channel stayed busy
+	uint32_t airtime;                         //!< Time on air of the transmitted frames in us, wraps around
+} rfm95_stats_t;
+
 /**
 * @brief RFM95 internal variables
 */
@@ -273,6 +305,10 @@ typedef struct {
 	rfm95_sequenceNumber_t txSequenceNumber;  //!< RFM95_txSequenceNumber
 	rfm95_powerLevel_t powerLevel;            //!< TX power level dBm
 	rfm95_RSSI_t ATCtargetRSSI;               //!< ATC: target RSSI
+	rfm95_stats_t stats;                      //!< Channel access statistics
+#if defined(MY_RFM95_SHORT_PREAMBLE_LENGTH)
+	uint8_t shortPreamble[32];                //!< One bit per node reached with a short preamble
+#endif
 	// 8 bit
 	rfm95_radioMode_t radioMode : 3;          //!< current transceiver state
 	bool channelActive : 1;                   //!< RFM95_cad
@@ -299,7 +335,7 @@ LOCAL void RFM95_setAddress(const uint8_t addr);
 * @brief Get driver/node address
 * @return Node address
 */
-LOCAL uint8_t RFM95_getAddress(void);
+LOCAL uint8_t RFM95_getAddress(void) __attribute__((unused));
 /**
 * @brief Sets all the registers required to configure the data modem in the RF95/96/97/98, including the
 * bandwidth, spreading factor etc.
@@ -358,7 +394,7 @@ LOCAL bool RFM95_setTxPowerLevel(rfm95_powerLevel_t newPowerLevel);
 * @param newPowerPercent Transmitter power level in percent
 * @return True power level adjusted
 */
-LOCAL bool RFM95_setTxPowerPercent(const uint8_t newPowerPercent);
+LOCAL bool RFM95_setTxPowerPercent(const uint8_t newPowerPercent) __attribute__((unused));
 
 /**
 * @brief Enable TCXO mode
@@ -414,6 +450,39 @@ LOCAL bool RFM95_sendWithRetry(const uint8_t recipient, const void *buffer,
 * @return True if no channel activity detected, False if timeout occured
 */
 LOCAL bool RFM95_waitCAD(void);
+/**
+* @brief Wait a random time of up to RFM95_BACKOFF_MS * 2^attempt, capped to RFM95_BACKOFF_MAX_MS
+*
+* Incoming frames are handled while waiting.
+* @param attempt Number of the failed attempt, starting at 0
+* @return The time waited in ms
+*/
+LOCAL uint32_t RFM95_backoff(const uint8_t attempt);
+/**
+* @brief Time on air of a frame with the modem configuration, see SX1276 datasheet 4.1.1.7
+* @param len Length of the frame including the header
+* @param preambleLength Preamble length in symbols
+* @param implicitHeader True if the frame is sent without LoRa header
+* @return Time on air in us
+*/
+LOCAL uint32_t RFM95_getTimeOnAir(const uint8_t len,
+                                  const uint16_t preambleLength = RFM95_PREAMBLE_LENGTH, const bool implicitHeader = false);
+/**
+* @brief Switch between explicit and implicit LoRa header, in STDBY or RX
+* @param len Length of the frames without header, 0 for the explicit header
+*/
+LOCAL void RFM95_setImplicitHeader(const uint8_t len) __attribute__((unused));
+/**
+* @brief Use the short preamble for a node if the SNR of its link leaves enough margin
+* @param node
+* @param SNR Internal SNR of a frame of the link
+*/
+LOCAL void RFM95_updateLinkPreamble(const uint8_t node, const rfm95_SNR_t SNR) __attribute__((unused));
+/**
+* @brief Get the time on air of all transmitted frames, including retries and ACKs
+* @return Time on air in us, wraps around
+*/
+LOCAL uint32_t RFM95_getAirtime(void);
 
 /**
 * @brief RFM95_setRadioMode
@@ -459,12 +528,12 @@ LOCAL int16_t RFM95_getSendingSNR(void);
 * @brief Get transmitter power level
 * @return Transmitter power level in percents
 */
-LOCAL uint8_t RFM95_getTxPowerPercent(void);
+LOCAL uint8_t RFM95_getTxPowerPercent(void) __attribute__((unused));
 /**
 * @brief Get transmitter power level
 * @return Transmitter power level in dBm
 */
-LOCAL uint8_t RFM95_getTxPowerLevel(void);
+LOCAL uint8_t RFM95_getTxPowerLevel(void) __attribute__((unused));
 /**
 * @brief RFM_executeATC
 * @param currentRSSI
@@ -477,7 +546,8 @@ LOCAL bool RFM95_executeATC(const rfm95_RSSI_t currentRSSI, const rfm95_RSSI_t t
 * @param targetRSSI Target RSSI for transmitter (default -60)
 * @param OnOff True to enable ATC
 */
-LOCAL void RFM95_ATCmode(const bool OnOff, const int16_t targetRSSI = RFM95_TARGET_RSSI);
+LOCAL void RFM95_ATCmode(const bool OnOff,
+                         const int16_t targetRSSI = RFM95_TARGET_RSSI) __attribute__((unused));
 /**
 * @brief RFM95_sanityCheck
 * @return True if sanity check passed
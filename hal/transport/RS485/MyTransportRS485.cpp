@@ -67,9 +67,43 @@
 
 // We only use SYS_PACK in this application
 #define	ICSC_SYS_PACK	0x58
+// Slot beacon of the GW, see MY_RS485_TDMA
+#define	RS485_SYS_SYNC	0x59
+
+#if defined(MY_RS485_CRC16)
+// CRC-16/MODBUS, sent LSB first
+typedef uint16_t rs485Checksum_t;
+#define RS485_CHECKSUM_INIT	(0xFFFFu)
+#define RS485_CHECKSUM_SIZE	(2u)
+#else
+// 8 bit sum
+typedef unsigned char rs485Checksum_t;
+#define RS485_CHECKSUM_INIT	(0u)
+#define RS485_CHECKSUM_SIZE	(1u)
+#endif
+
+// Frame of len data bytes: SOH, header (4 bytes and STX), data, ETX, checksum and EOT
+#define RS485_FRAME_SIZE(__len)	(MY_RS485_SOH_COUNT + 6u + (__len) + RS485_CHECKSUM_SIZE + 1u)
+// Time on the bus in us, 10 bits per byte
+#define RS485_BYTES_US(__bytes)	((uint32_t)(__bytes) * 10000000ul / MY_RS485_BAUD_RATE)
+
+#if defined(MY_RS485_TDMA)
+// The beacon starts the cycle, slot 0 of the GW follows, then the slots of the nodes
+#define RS485_BEACON_US	RS485_BYTES_US(RS485_FRAME_SIZE(0))
+#define RS485_SLOT_US	(RS485_BYTES_US(RS485_FRAME_SIZE(MY_RS485_MAX_MESSAGE_LENGTH)) + MY_RS485_TDMA_GUARD_US)
+#define RS485_CYCLE_US	(RS485_BEACON_US + (uint32_t)MY_RS485_TDMA_SLOTS * RS485_SLOT_US)
+// start of the cycle, the GW sends the next beacon one cycle later
+uint32_t _serialSyncUS;
+bool _serialSynced;
+#endif
 
-// Receiving header information
-char _header[6];
+// Receiving header information, ring of the last bytes received
+#define RS485_HEADER_SIZE	(6u)
+#define RS485_HEADER_RING	(8u)
+char _header[RS485_HEADER_RING];
+unsigned char _headerPos;
+// Byte x of the header window
+#define RS485_HEADER(x) _header[(unsigned char)(_headerPos - RS485_HEADER_SIZE + (x)) & (RS485_HEADER_RING - 1)]
 
 // Reception state machine control and storage variables
 unsigned char _recPhase;
@@ -78,8 +112,9 @@ unsigned char _recCommand;
 unsigned char _recLen;
 unsigned char _recStation;
 unsigned char _recSender;
-unsigned char _recCS;
-unsigned char _recCalcCS;
+bool _recStore;
+rs485Checksum_t _recCS;
+rs485Checksum_t _recCalcCS;
 
 
 #if defined(__linux__)
@@ -95,6 +130,8 @@ char _data[MY_RS485_MAX_MESSAGE_LENGTH];
 uint8_t _packet_len;
 unsigned char _packet_from;
 bool _packet_received;
+// time the bus was driven by this node in us, 10 bits per byte
+uint32_t _serialAirtime = 0;
 
 // Packet wrapping characters, defined in standard ASCII table
 #define SOH 1
@@ -103,6 +140,15 @@ bool _packet_received;
 #define EOT 4
 
 
+// Add one byte to the frame checksum
+rs485Checksum_t _serialChecksum(rs485Checksum_t cs, const unsigned char inch)
+{
+#if defined(MY_RS485_CRC16)
+	return crc16Update(cs, inch);
+#else
+	return cs + inch;
+#endif
+}
 
 //Reset the state machine and release the data pointer
 void _serialReset()
@@ -112,7 +158,7 @@ void _serialReset()
 	_recLen = 0;
 	_recCommand = 0;
 	_recCS = 0;
-	_recCalcCS = 0;
+	_recCalcCS = RS485_CHECKSUM_INIT;
 }
 
 // This is the main reception state machine.  Progress through the states
@@ -124,7 +170,6 @@ void _serialReset()
 // function.
 bool _serialProcess()
 {
-	unsigned char i;
 	if (!_dev.available()) {
 		return false;
 	}
@@ -136,24 +181,26 @@ bool _serialProcess()
 		switch(_recPhase) {
 
 		// Case 0 looks for the header.  Bytes arrive in the serial interface and get
-		// shifted through a header buffer.  When the start and end characters in
-		// the buffer match the SOH/STX pair, and the destination station ID matches
-		// our ID, save the header information and progress to the next state.
+		// stored in a ring holding the last header sized window.  When the start and
+		// end characters in the window match the SOH/STX pair, and the destination
+		// station ID matches our ID, save the header information and progress to the
+		// next state.
 		case 0:
-			memcpy(&_header[0],&_header[1],5);
-			_header[5] = inch;
-			if ((_header[0] == SOH) && (_header[5] == STX) && (_header[1] != _header[2])) {
-				_recCalcCS = 0;
-				_recStation = _header[1];
-				_recSender = _header[2];
-				_recCommand = _header[3];
-				_recLen = _header[4];
-
-				for (i=1; i<=4; i++) {
-					_recCalcCS += _header[i];
+			_header[_headerPos++ & (RS485_HEADER_RING - 1)] = inch;
+			if ((inch == STX) && (RS485_HEADER(0) == SOH) && (RS485_HEADER(1) != RS485_HEADER(2))) {
+				_recCalcCS = RS485_CHECKSUM_INIT;
+				_recStation = RS485_HEADER(1);
+				_recSender = RS485_HEADER(2);
+				_recCommand = RS485_HEADER(3);
+				_recLen = RS485_HEADER(4);
+
+				for (unsigned char i = 1; i <= 4; i++) {
+					_recCalcCS = _serialChecksum(_recCalcCS, RS485_HEADER(i));
 				}
 				_recPhase = 1;
 				_recPos = 0;
+				// a received frame not yet read must not be overwritten
+				_recStore = !_packet_received;
 
 				//Avoid _data[] overflow
 				if (_recLen >= MY_RS485_MAX_MESSAGE_LENGTH) {
@@ -181,8 +228,11 @@ bool _serialProcess()
 		// Case 1 receives the data portion of the packet.  Read in "_recLen" number
 		// of bytes and store them in the _data array.
 		case 1:
-			_data[_recPos++] = inch;
-			_recCalcCS += inch;
+			if (_recStore) {
+				_data[_recPos] = inch;
+			}
+			_recPos++;
+			_recCalcCS = _serialChecksum(_recCalcCS, inch);
 			if (_recPos == _recLen) {
 				_recPhase = 2;
 			}
@@ -194,36 +244,46 @@ bool _serialProcess()
 			// Packet properly terminated?
 			if (inch == ETX) {
 				_recPhase = 3;
+				_recPos = 0;
 			} else {
 				_serialReset();
 			}
 			break;
 
 		// Next comes the checksum.  We have already calculated it from the incoming
-		// data, so just store the incoming checksum byte for later.
+		// data, so just store the incoming checksum byte(s) for later.
 		case 3:
-			_recCS = inch;
-			_recPhase = 4;
+			_recCS |= (rs485Checksum_t)((rs485Checksum_t)(unsigned char)inch << (8 * _recPos));
+			if (++_recPos == RS485_CHECKSUM_SIZE) {
+				_recPhase = 4;
+			}
 			break;
 
 		// The final state - check the last character is EOT and that the checksum matches.
 		// If that test passes, then look for a valid command callback to execute.
 		// Execute it if found.
 		case 4:
-			if (inch == EOT) {
-				if (_recCS == _recCalcCS) {
-					// First, check for system level commands.  It is possible
-					// to register your own callback as well for system level
-					// commands which will be called after the system default
-					// hook.
-
-					switch (_recCommand) {
-					case ICSC_SYS_PACK:
+			if (inch == EOT && _recCS == _recCalcCS) {
+				// First, check for system level commands.  It is possible
+				// to register your own callback as well for system level
+				// commands which will be called after the system default
+				// hook.
+
+				switch (_recCommand) {
+				case ICSC_SYS_PACK:
+					if (_recStore) {
 						_packet_from = _recSender;
 						_packet_len = _recLen;
 						_packet_received = true;
-						break;
 					}
+					break;
+#if defined(MY_RS485_TDMA) && !defined(MY_GATEWAY_FEATURE)
+				case RS485_SYS_SYNC:
+					// the beacon just ended
+					_serialSyncUS = hwMicros() - RS485_BEACON_US;
+					_serialSynced = true;
+					break;
+#endif
 				}
 			}
 			//Clear the data
@@ -236,32 +296,15 @@ bool _serialProcess()
 	return true;
 }
 
-bool transportSend(const uint8_t to, const void* data, const uint8_t len, const bool noACK)
+// Write a frame to the bus, the caller has arbitrated the bus
+static void _serialWriteFrame(const uint8_t to, const uint8_t command, const uint8_t *datap,
+                              const uint8_t len)
 {
-	(void)noACK;	// not implemented
-	const char *datap = static_cast<char const *>(data);
 	unsigned char i;
-	unsigned char cs = 0;
-
-	// This is how many times to try and transmit before failing.
-	unsigned char timeout = 10;
-
-	// Let's start out by looking for a collision.  If there has been anything seen in
-	// the last millisecond, then wait for a random time and check again.
-
-	while (_serialProcess()) {
-		unsigned char del;
-		del = rand() % 20;
-		for (i = 0; i < del; i++) {
-			delay(1);
-			_serialProcess();
-		}
-		timeout--;
-		if (timeout == 0) {
-			// Failed to transmit!!!
-			return false;
-		}
-	}
+	rs485Checksum_t cs = RS485_CHECKSUM_INIT;
+	// SOH, header (4 bytes and STX), data, ETX, checksum and EOT, written with one call
+	uint8_t frame[RS485_FRAME_SIZE(MY_RS485_MAX_MESSAGE_LENGTH)];
+	uint8_t pos = 0;
 
 #if defined(MY_RS485_DE_PIN)
 	hwDigitalWrite(MY_RS485_DE_PIN, HIGH);
@@ -270,24 +313,28 @@ bool transportSend(const uint8_t to, const void* data, const uint8_t len, const
 
 	// Start of header by writing multiple SOH
 	for(byte w=0; w<MY_RS485_SOH_COUNT; w++) {
-		_dev.write(SOH);
+		frame[pos++] = SOH;
 	}
-	_dev.write(to);  // Destination address
-	cs += to;
-	_dev.write(_nodeId); // Source address
-	cs += _nodeId;
-	_dev.write(ICSC_SYS_PACK);  // Command code
-	cs += ICSC_SYS_PACK;
-	_dev.write(len);      // Length of text
-	cs += len;
-	_dev.write(STX);      // Start of text
+	frame[pos++] = to;  // Destination address
+	cs = _serialChecksum(cs, to);
+	frame[pos++] = _nodeId; // Source address
+	cs = _serialChecksum(cs, _nodeId);
+	frame[pos++] = command;  // Command code
+	cs = _serialChecksum(cs, command);
+	frame[pos++] = len;      // Length of text
+	cs = _serialChecksum(cs, len);
+	frame[pos++] = STX;      // Start of text
 	for(i=0; i<len; i++) {
-		_dev.write(datap[i]);      // Text bytes
-		cs += datap[i];
+		frame[pos++] = datap[i];      // Text bytes
+		cs = _serialChecksum(cs, datap[i]);
+	}
+	frame[pos++] = ETX;      // End of text
+	for (i = 0; i < RS485_CHECKSUM_SIZE; i++) {
+		frame[pos++] = (uint8_t)(cs >> (8 * i));
 	}
-	_dev.write(ETX);      // End of text
-	_dev.write(cs);
-	_dev.write(EOT);
+	frame[pos++] = EOT;
+	_dev.write(frame, pos);
+	_serialAirtime += RS485_BYTES_US(pos);
 
 #if defined(MY_RS485_DE_PIN)
 #ifdef __PIC32MX__
@@ -312,19 +359,120 @@ bool transportSend(const uint8_t to, const void* data, const uint8_t len, const
 #endif
 	hwDigitalWrite(MY_RS485_DE_PIN, LOW);
 #endif
+}
+
+#if defined(MY_RS485_TDMA)
+#if defined(MY_GATEWAY_FEATURE)
+// Send the beacon once the cycle is over, it starts the next one
+static void _serialBeacon(void)
+{
+	if (hwMicros() - _serialSyncUS >= RS485_CYCLE_US) {
+		_serialSyncUS = hwMicros();
+		_serialWriteFrame(BROADCAST_ADDRESS, RS485_SYS_SYNC, NULL, 0);
+	}
+}
+#endif
+
+// Wait until a frame of frameSize bytes fits into the slot of this node, frames received
+// meanwhile are processed. False if no beacon of the GW was seen for two cycles.
+static bool _serialSlotWait(const uint8_t frameSize)
+{
+#if defined(MY_GATEWAY_FEATURE)
+	const uint8_t slot = 0;
+#else
+	const uint8_t slot = 1 + (uint8_t)(_nodeId - 1) % (MY_RS485_TDMA_SLOTS - 1);
+#endif
+	const uint32_t slotStart = RS485_BEACON_US + (uint32_t)slot * RS485_SLOT_US;
+	const uint32_t slotEnd = slotStart + RS485_SLOT_US - MY_RS485_TDMA_GUARD_US - RS485_BYTES_US(
+	                             frameSize);
+	while (true) {
+		(void)_serialProcess();
+#if defined(MY_GATEWAY_FEATURE)
+		_serialBeacon();
+#endif
+		const uint32_t elapsed = hwMicros() - _serialSyncUS;
+		if (!_serialSynced || elapsed >= 2 * RS485_CYCLE_US) {
+			_serialSynced = false;
+			return false;
+		}
+		// a single missed beacon is bridged
+		const uint32_t cycleTime = elapsed % RS485_CYCLE_US;
+		if (cycleTime >= slotStart && cycleTime <= slotEnd) {
+			return true;
+		}
+		doYield();
+	}
+}
+#endif
+
+bool transportSend(const uint8_t to, const void* data, const uint8_t len, const bool noACK)
+{
+	(void)noACK;	// not implemented
+	const uint8_t *datap = static_cast<uint8_t const *>(data);
+	unsigned char i;
+
+	if (len >= MY_RS485_MAX_MESSAGE_LENGTH) {
+		// would be rejected by the receivers
+		return false;
+	}
+
+#if defined(MY_RS485_TDMA)
+	if (_serialSlotWait(RS485_FRAME_SIZE(len))) {
+		_serialWriteFrame(to, ICSC_SYS_PACK, datap, len);
+		return true;
+	}
+	// no beacon of the GW, fall back to carrier sense
+#endif
+
+	// This is how many times to try and transmit before failing.
+	unsigned char timeout = 10;
+
+	// Let's start out by looking for a collision.  If there has been anything seen in
+	// the last millisecond, then wait for a random time and check again.
+
+	while (_serialProcess()) {
+		unsigned char del;
+		del = rand() % 20;
+		for (i = 0; i < del; i++) {
+			delay(1);
+			_serialProcess();
+		}
+		timeout--;
+		if (timeout == 0) {
+			// Failed to transmit!!!
+			return false;
+		}
+	}
+
+	_serialWriteFrame(to, ICSC_SYS_PACK, datap, len);
 	return true;
 }
 
+uint32_t transportGetAirtime(void)
+{
+	return _serialAirtime;
+}
+
 
 
 bool transportInit(void)
 {
 	// Reset the state machine
 	_dev.begin(MY_RS485_BAUD_RATE);
+#if defined(MY_RS485_KERNEL_DE)
+	if (!_dev.setRS485()) {
+		return false;
+	}
+#endif
 	_serialReset();
 #if defined(MY_RS485_DE_PIN)
 	hwPinMode(MY_RS485_DE_PIN, OUTPUT);
 	hwDigitalWrite(MY_RS485_DE_PIN, LOW);
+#endif
+#if defined(MY_RS485_TDMA) && defined(MY_GATEWAY_FEATURE)
+	// the GW is the time master, the first beacon is due right away
+	_serialSyncUS = hwMicros() - RS485_CYCLE_US;
+	_serialSynced = true;
 #endif
 	return true;
 }
@@ -343,6 +491,9 @@ uint8_t transportGetAddress(void)
 bool transportDataAvailable(void)
 {
 	_serialProcess();
+#if defined(MY_RS485_TDMA) && defined(MY_GATEWAY_FEATURE)
+	_serialBeacon();
+#endif
 	return _packet_received;
 }
 
@@ -0,0 +1,159 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// Coprocessor side of MY_RADIO_REMOTE: the radio driver of this node serves the requests of the
+// host, see RemoteRadio.h. The transport layer is not used, the host runs it.
+
+#if defined(__linux__)
+#include "SerialPort.h"
+static SerialPort _remoteRadioPort = SerialPort(MY_RADIO_REMOTE_SERIAL);
+#define REMOTE_RADIO_SERIAL _remoteRadioPort
+#else
+#define REMOTE_RADIO_SERIAL MY_RADIO_REMOTE_SERIAL
+#endif
+
+typedef struct {
+	uint32_t stamp;						// hwMicros() when the frame was taken from the radio
+	int16_t rssi;
+	int16_t snr;
+	uint8_t len;
+	uint8_t data[MAX_MESSAGE_LENGTH];
+} remoteRadioQueued_t;
+
+static remoteRadioParser_t _remoteRadioParser;
+static remoteRadioQueued_t _remoteRadioRxQueue[MY_RADIO_REMOTE_RX_BATCH];
+static uint8_t _remoteRadioRxCount = 0;
+// a batch fills at most one frame of the link
+static uint8_t _remoteRadioPayload[REMOTE_RADIO_MAX_PAYLOAD];
+
+static void _remoteRadioStatus(const bool result)
+{
+	uint8_t payload[5];
+	payload[0] = result;
+	remoteRadioPut16(&payload[1], (uint16_t)transportGetTxPowerPercent());
+	remoteRadioPut16(&payload[3], (uint16_t)transportGetTxPowerLevel());
+	remoteRadioWrite(REMOTE_RADIO_SERIAL, REMOTE_RADIO_STATUS, payload, sizeof(payload));
+}
+
+static void _remoteRadioSend(const uint8_t *payload, const uint8_t length)
+{
+	if (length < 4u) {
+		return;
+	}
+	// the driver waits for the ACK and retries
+	const bool result = transportSend((nodeId_t)remoteRadioGet16(&payload[1]), &payload[4],
+	                                  min((uint8_t)(length - 4u), (uint8_t)MAX_MESSAGE_LENGTH), payload[3]);
+	uint8_t sent[10];
+	sent[0] = payload[0];
+	sent[1] = result;
+	remoteRadioPut16(&sent[2], (uint16_t)transportGetSendingRSSI());
+	remoteRadioPut16(&sent[4], (uint16_t)transportGetSendingSNR());
+	remoteRadioPut32(&sent[6], transportGetAirtime());
+	remoteRadioWrite(REMOTE_RADIO_SERIAL, REMOTE_RADIO_SENT, sent, sizeof(sent));
+}
+
+static void _remoteRadioRequest(const uint8_t type, const uint8_t *payload, const uint8_t length)
+{
+	switch (type) {
+	case REMOTE_RADIO_INIT:
+		_remoteRadioRxCount = 0;
+		_remoteRadioStatus(transportInit());
+		break;
+	case REMOTE_RADIO_ADDRESS:
+		if (length >= 2u) {
+			transportSetAddress((nodeId_t)remoteRadioGet16(payload));
+		}
+		break;
+	case REMOTE_RADIO_SEND:
+		_remoteRadioSend(payload, length);
+		break;
+	case REMOTE_RADIO_POWER:
+		if (length >= 1u) {
+			if (payload[0] == REMOTE_RADIO_POWER_DOWN) {
+				transportPowerDown();
+			} else if (payload[0] == REMOTE_RADIO_POWER_UP) {
+				transportPowerUp();
+			} else if (payload[0] == REMOTE_RADIO_POWER_SLEEP) {
+				transportSleep();
+			} else {
+				transportStandBy();
+			}
+		}
+		break;
+	case REMOTE_RADIO_TX_POWER:
+		_remoteRadioStatus(length >= 1u && transportSetTxPowerPercent(payload[0]));
+		break;
+	case REMOTE_RADIO_CHECK:
+		_remoteRadioStatus(transportSanityCheck());
+		break;
+	default:
+		break;
+	}
+}
+
+// write the queued frames in one RX message
+static void _remoteRadioFlush(void)
+{
+	remoteRadioPut32(_remoteRadioPayload, hwMicros());
+	uint8_t length = REMOTE_RADIO_RX_HEADER;
+	for (uint8_t i = 0; i < _remoteRadioRxCount; i++) {
+		const remoteRadioQueued_t *msg = &_remoteRadioRxQueue[i];
+		uint8_t *frame = &_remoteRadioPayload[length];
+		remoteRadioPut32(frame, msg->stamp);
+		remoteRadioPut16(&frame[4], (uint16_t)msg->rssi);
+		remoteRadioPut16(&frame[6], (uint16_t)msg->snr);
+		frame[8] = msg->len;
+		(void)memcpy((void *)&frame[REMOTE_RADIO_RX_FRAME], (const void *)msg->data, msg->len);
+		length += REMOTE_RADIO_RX_FRAME + msg->len;
+	}
+	remoteRadioWrite(REMOTE_RADIO_SERIAL, REMOTE_RADIO_RX, _remoteRadioPayload, length);
+	_remoteRadioRxCount = 0;
+}
+
+void remoteRadioBegin(void)
+{
+	REMOTE_RADIO_SERIAL.begin(MY_RADIO_REMOTE_BAUD_RATE);
+	_remoteRadioParser.phase = 0;
+}
+
+void remoteRadioProcess(void)
+{
+	// the frames of the radio first, their time stamp is taken here
+	while (transportDataAvailable()) {
+		if (_remoteRadioRxCount == MY_RADIO_REMOTE_RX_BATCH) {
+			// the serial write blocks while the host is behind, the radio buffers meanwhile
+			_remoteRadioFlush();
+		}
+		remoteRadioQueued_t *msg = &_remoteRadioRxQueue[_remoteRadioRxCount];
+		msg->len = transportReceive(msg->data);
+		msg->stamp = hwMicros();
+		msg->rssi = transportGetReceivingRSSI();
+		msg->snr = transportGetReceivingSNR();
+		if (msg->len) {
+			_remoteRadioRxCount++;
+		}
+	}
+	if (_remoteRadioRxCount) {
+		_remoteRadioFlush();
+	}
+	while (remoteRadioParse(_remoteRadioParser, REMOTE_RADIO_SERIAL)) {
+		_remoteRadioRequest(_remoteRadioParser.type, _remoteRadioParser.payload,
+		                    _remoteRadioParser.length - 1u);
+	}
+}
@@ -0,0 +1,298 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// Radio of a coprocessor attached to a serial port, see RemoteRadio.h for the link. The
+// coprocessor sends with ACK and retries on its own, the host waits for the result of one frame
+// at a time. Received frames arrive in batches and are queued here with the time they were
+// received.
+
+#include "SerialPort.h"
+
+#define REMOTE_RADIO_POLL_US	(50u)	//!< sleep while waiting for the coprocessor
+
+typedef struct {
+	uint32_t stamp;						// hwMicros() of the host when the frame was received
+	int16_t rssi;
+	int16_t snr;
+	uint8_t len;
+	uint8_t data[MAX_MESSAGE_LENGTH];
+} remoteQueued_t;
+
+static SerialPort _remoteSerial = SerialPort(MY_RADIO_REMOTE_SERIAL);
+static remoteRadioParser_t _remoteParser;
+static bool _remoteOpen = false;
+static nodeId_t _remoteAddress = AUTO;
+static uint8_t _remoteSeq = 0;
+static uint32_t _remoteAirtime = 0;
+static int16_t _remoteSendingRSSI = INVALID_RSSI;
+static int16_t _remoteSendingSNR = INVALID_SNR;
+static int16_t _remoteReceivingRSSI = INVALID_RSSI;
+static int16_t _remoteReceivingSNR = INVALID_SNR;
+static int16_t _remoteTxPowerPercent = INVALID_PERCENT;
+static int16_t _remoteTxPowerLevel = INVALID_LEVEL;
+
+static remoteQueued_t _remoteRxQueue[MY_RADIO_REMOTE_RX_QUEUE_SIZE];
+static uint8_t _remoteRxHead = 0;
+static uint8_t _remoteRxCount = 0;
+
+// queue the frames of an RX message
+static void _remoteReceived(const uint8_t *payload, const uint8_t length)
+{
+	if (length < REMOTE_RADIO_RX_HEADER) {
+		return;
+	}
+	// the age of a frame on the coprocessor moves the reception to the time base of the host
+	const uint32_t now = hwMicros();
+	const uint32_t remoteNow = remoteRadioGet32(payload);
+	uint8_t position = REMOTE_RADIO_RX_HEADER;
+	while (position + REMOTE_RADIO_RX_FRAME <= length) {
+		const uint8_t *frame = &payload[position];
+		const uint8_t len = frame[8];
+		if (len > MAX_MESSAGE_LENGTH || position + REMOTE_RADIO_RX_FRAME + len > length) {
+			break;
+		}
+		position += REMOTE_RADIO_RX_FRAME + len;
+		if (_remoteRxCount == MY_RADIO_REMOTE_RX_QUEUE_SIZE) {
+			STATS_INC(STATS_RX_OVERFLOWS);
+			continue;
+		}
+		remoteQueued_t *msg = &_remoteRxQueue[(_remoteRxHead + _remoteRxCount) %
+		                                      MY_RADIO_REMOTE_RX_QUEUE_SIZE];
+		msg->stamp = now - (remoteNow - remoteRadioGet32(frame));
+		msg->rssi = (int16_t)remoteRadioGet16(&frame[4]);
+		msg->snr = (int16_t)remoteRadioGet16(&frame[6]);
+		msg->len = len;
+		(void)memcpy((void *)msg->data, (const void *)&frame[REMOTE_RADIO_RX_FRAME], len);
+		_remoteRxCount++;
+	}
+}
+
+// read the pending frames of the coprocessor, true if one of type expected arrived
+static bool _remoteProcess(const uint8_t expected)
+{
+	while (remoteRadioParse(_remoteParser, _remoteSerial)) {
+		const uint8_t length = _remoteParser.length - 1u;
+		if (_remoteParser.type == REMOTE_RADIO_RX) {
+			_remoteReceived(_remoteParser.payload, length);
+		} else if (_remoteParser.type == expected) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// nothing is written before the port was opened
+static bool _remoteWrite(const uint8_t type, const uint8_t *payload, const uint8_t length)
+{
+	if (_remoteOpen) {
+		remoteRadioWrite(_remoteSerial, type, payload, length);
+	}
+	return _remoteOpen;
+}
+
+// send a request and wait for its answer in _remoteParser.payload
+static bool _remoteRequest(const uint8_t type, const uint8_t *payload, const uint8_t length,
+                           const uint8_t answer, const uint32_t timeoutMS)
+{
+	if (!_remoteWrite(type, payload, length)) {
+		return false;
+	}
+	const uint32_t started = hwMillis();
+	while (!_remoteProcess(answer)) {
+		if (hwMillis() - started >= timeoutMS) {
+			return false;
+		}
+		usleep(REMOTE_RADIO_POLL_US);
+	}
+	return true;
+}
+
+static bool _remoteStatus(const uint8_t type, const uint8_t *payload, const uint8_t length,
+                          const uint32_t timeoutMS)
+{
+	if (!_remoteRequest(type, payload, length, REMOTE_RADIO_STATUS, timeoutMS) ||
+	        _remoteParser.length - 1u < 5u) {
+		return false;
+	}
+	_remoteTxPowerPercent = (int16_t)remoteRadioGet16(&_remoteParser.payload[1]);
+	_remoteTxPowerLevel = (int16_t)remoteRadioGet16(&_remoteParser.payload[3]);
+	return _remoteParser.payload[0];
+}
+
+bool transportInit(void)
+{
+	if (!_remoteOpen) {
+		_remoteOpen = _remoteSerial.open(MY_RADIO_REMOTE_BAUD_RATE);
+	}
+	if (!_remoteOpen) {
+		return false;
+	}
+	// opening the port may reset the coprocessor, it answers once it is running
+	const uint32_t started = hwMillis();
+	while (hwMillis() - started < MY_RADIO_REMOTE_INIT_TIMEOUT_MS) {
+		if (_remoteStatus(REMOTE_RADIO_INIT, NULL, 0, MY_RADIO_REMOTE_TIMEOUT_MS)) {
+			return true;
+		}
+	}
+	logError("Remote radio on %s not responding.\n", MY_RADIO_REMOTE_SERIAL);
+	return false;
+}
+
+void transportSetAddress(const nodeId_t address)
+{
+	uint8_t payload[2];
+	remoteRadioPut16(payload, address);
+	(void)_remoteWrite(REMOTE_RADIO_ADDRESS, payload, sizeof(payload));
+	_remoteAddress = address;
+}
+
+nodeId_t transportGetAddress(void)
+{
+	return _remoteAddress;
+}
+
+bool transportSend(const nodeId_t to, const void *data, const uint8_t len, const bool noACK)
+{
+	uint8_t payload[4 + MAX_MESSAGE_LENGTH];
+	const uint8_t length = min(len, (uint8_t)MAX_MESSAGE_LENGTH);
+	payload[0] = ++_remoteSeq;
+	remoteRadioPut16(&payload[1], to);
+	payload[3] = noACK;
+	(void)memcpy((void *)&payload[4], data, length);
+	bool result = false;
+	// an answer to an earlier frame that timed out is skipped
+	const uint32_t started = hwMillis();
+	uint32_t elapsed = 0;
+	if (!_remoteWrite(REMOTE_RADIO_SEND, payload, 4u + length)) {
+		return false;
+	}
+	while (elapsed < MY_RADIO_REMOTE_TIMEOUT_MS) {
+		if (_remoteProcess(REMOTE_RADIO_SENT) && _remoteParser.length - 1u >= 10u &&
+		        _remoteParser.payload[0] == _remoteSeq) {
+			result = _remoteParser.payload[1];
+			_remoteSendingRSSI = result ? (int16_t)remoteRadioGet16(&_remoteParser.payload[2]) : INVALID_RSSI;
+			_remoteSendingSNR = result ? (int16_t)remoteRadioGet16(&_remoteParser.payload[4]) : INVALID_SNR;
+			_remoteAirtime = remoteRadioGet32(&_remoteParser.payload[6]);
+			break;
+		}
+		usleep(REMOTE_RADIO_POLL_US);
+		elapsed = hwMillis() - started;
+	}
+	if (elapsed >= MY_RADIO_REMOTE_TIMEOUT_MS) {
+		logWarning("Remote radio: no answer to frame %u.\n", _remoteSeq);
+	}
+	if (_remoteRxCount) {
+		// frames received while waiting are no longer signalled by the port
+		eventLoopWakeup();
+	}
+	return result;
+}
+
+uint32_t transportGetAirtime(void)
+{
+	return _remoteAirtime;
+}
+
+bool transportDataAvailable(void)
+{
+	if (_remoteOpen) {
+		(void)_remoteProcess(0);
+	}
+	return _remoteRxCount > 0;
+}
+
+bool transportSanityCheck(void)
+{
+	return _remoteStatus(REMOTE_RADIO_CHECK, NULL, 0, MY_RADIO_REMOTE_TIMEOUT_MS);
+}
+
+uint8_t transportReceive(void *data)
+{
+	if (!_remoteRxCount) {
+		return 0;
+	}
+	const remoteQueued_t *msg = &_remoteRxQueue[_remoteRxHead];
+	(void)memcpy(data, (const void *)msg->data, msg->len);
+	_remoteReceivingRSSI = msg->rssi;
+	_remoteReceivingSNR = msg->snr;
+	STATS_UPLINK_BEGIN(msg->stamp ? msg->stamp : 1u);
+	_remoteRxHead = (_remoteRxHead + 1) % MY_RADIO_REMOTE_RX_QUEUE_SIZE;
+	_remoteRxCount--;
+	return msg->len;
+}
+
+static void _remotePower(const uint8_t mode)
+{
+	(void)_remoteWrite(REMOTE_RADIO_POWER, &mode, 1u);
+}
+
+void transportPowerDown(void)
+{
+	_remotePower(REMOTE_RADIO_POWER_DOWN);
+}
+
+void transportPowerUp(void)
+{
+	_remotePower(REMOTE_RADIO_POWER_UP);
+}
+
+void transportSleep(void)
+{
+	_remotePower(REMOTE_RADIO_POWER_SLEEP);
+}
+
+void transportStandBy(void)
+{
+	_remotePower(REMOTE_RADIO_POWER_STANDBY);
+}
+
+int16_t transportGetSendingRSSI(void)
+{
+	return _remoteSendingRSSI;
+}
+
+int16_t transportGetReceivingRSSI(void)
+{
+	return _remoteReceivingRSSI;
+}
+
+int16_t transportGetSendingSNR(void)
+{
+	return _remoteSendingSNR;
+}
+
+int16_t transportGetReceivingSNR(void)
+{
+	return _remoteReceivingSNR;
+}
+
+int16_t transportGetTxPowerPercent(void)
+{
+	return _remoteTxPowerPercent;
+}
+
+int16_t transportGetTxPowerLevel(void)
+{
+	return _remoteTxPowerLevel;
+}
+
+bool transportSetTxPowerPercent(const uint8_t powerPercent)
+{
+	return _remoteStatus(REMOTE_RADIO_TX_POWER, &powerPercent, 1u, MY_RADIO_REMOTE_TIMEOUT_MS);
+}
@@ -0,0 +1,109 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "RemoteRadio.h"
+
+// frames are written in one piece
+static uint8_t _remoteRadioFrame[REMOTE_RADIO_MAX_PAYLOAD + REMOTE_RADIO_OVERHEAD];
+
+bool remoteRadioParse(remoteRadioParser_t &parser, Stream &stream)
+{
+	while (stream.available()) {
+		const uint8_t inByte = (uint8_t)stream.read();
+		switch (parser.phase) {
+		case 0:
+			if (inByte == REMOTE_RADIO_SYNC) {
+				parser.phase = 1;
+			}
+			break;
+		case 1:
+			if (inByte == 0 || inByte > REMOTE_RADIO_MAX_PAYLOAD + 1u) {
+				// not a frame, a sync byte may follow
+				parser.phase = inByte == REMOTE_RADIO_SYNC ? 1 : 0;
+				break;
+			}
+			parser.length = inByte;
+			parser.position = 0;
+			parser.crc = crc16Update(0xFFFF, inByte);
+			parser.phase = 2;
+			break;
+		case 2:
+			if (parser.position == 0) {
+				parser.type = inByte;
+			} else {
+				parser.payload[parser.position - 1] = inByte;
+			}
+			parser.crc = crc16Update(parser.crc, inByte);
+			if (++parser.position == parser.length) {
+				parser.phase = 3;
+			}
+			break;
+		case 3:
+			parser.received = (uint16_t)inByte << 8;
+			parser.phase = 4;
+			break;
+		default:
+			parser.received |= inByte;
+			parser.phase = 0;
+			if (parser.received == parser.crc) {
+				return true;
+			}
+			break;
+		}
+	}
+	return false;
+}
+
+void remoteRadioWrite(Stream &stream, const uint8_t type, const uint8_t *payload,
+                      const uint8_t length)
+{
+	_remoteRadioFrame[0] = REMOTE_RADIO_SYNC;
+	_remoteRadioFrame[1] = length + 1u;
+	_remoteRadioFrame[2] = type;
+	(void)memcpy((void *)&_remoteRadioFrame[3], (const void *)payload, length);
+	uint16_t crc = 0xFFFF;
+	for (uint8_t i = 1; i < length + 3u; i++) {
+		crc = crc16Update(crc, _remoteRadioFrame[i]);
+	}
+	_remoteRadioFrame[length + 3u] = crc >> 8;
+	_remoteRadioFrame[length + 4u] = crc & 0xFF;
+	(void)stream.write(_remoteRadioFrame, length + REMOTE_RADIO_OVERHEAD);
+}
+
+void remoteRadioPut16(uint8_t *buffer, const uint16_t value)
+{
+	buffer[0] = value & 0xFF;
+	buffer[1] = value >> 8;
+}
+
+void remoteRadioPut32(uint8_t *buffer, const uint32_t value)
+{
+	remoteRadioPut16(buffer, value & 0xFFFF);
+	remoteRadioPut16(&buffer[2], value >> 16);
+}
+
+uint16_t remoteRadioGet16(const uint8_t *buffer)
+{
+	return buffer[0] | (uint16_t)buffer[1] << 8;
+}
+
+uint32_t remoteRadioGet32(const uint8_t *buffer)
+{
+	return remoteRadioGet16(buffer) | (uint32_t)remoteRadioGet16(&buffer[2]) << 16;
+}
@@ -0,0 +1,131 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+ * @file RemoteRadio.h
+ *
+ * @brief Serial link between a Linux gateway and a radio coprocessor, see @ref MY_RADIO_REMOTE
+ *
+ * Frame: REMOTE_RADIO_SYNC, length, type, payload (length - 1 bytes), CRC-16 MSB first.
+ * The CRC (crc16Update(), start 0xFFFF) covers length, type and payload. Multi-byte fields
+ * are little endian.
+ *
+ * | Type                  | Direction | Payload
+ * |-----------------------|-----------|----------------------------------------------------------
+ * | REMOTE_RADIO_INIT     | host->MCU | -
+ * | REMOTE_RADIO_ADDRESS  | host->MCU | address (2)
+ * | REMOTE_RADIO_SEND     | host->MCU | sequence (1), destination (2), no ACK (1), frame
+ * | REMOTE_RADIO_POWER    | host->MCU | REMOTE_RADIO_POWER_xxx (1)
+ * | REMOTE_RADIO_TX_POWER | host->MCU | percent (1)
+ * | REMOTE_RADIO_CHECK    | host->MCU | -
+ * | REMOTE_RADIO_STATUS   | MCU->host | result (1), TX power percent (2), TX power level (2)
+ * | REMOTE_RADIO_SENT     | MCU->host | sequence (1), result (1), RSSI (2), SNR (2), time on air (4)
+ * | REMOTE_RADIO_RX       | MCU->host | now (4), frames: received (4), RSSI (2), SNR (2), length (1), frame
+ *
+ * INIT, TX_POWER and CHECK are answered by STATUS, SEND by SENT once the radio has the ACK or
+ * gave up retrying. The host has one request outstanding at a time. The coprocessor batches the
+ * received frames in RX messages, with its hwMicros() when they were received and when the RX
+ * message was written. It blocks on a full serial port, the radio buffers meanwhile.
+ */
+
+#ifndef RemoteRadio_h
+#define RemoteRadio_h
+
+#define REMOTE_RADIO_SYNC			(0xA5u)	//!< First byte of a frame
+#define REMOTE_RADIO_OVERHEAD		(5u)	//!< Sync, length, type and CRC bytes around the payload
+#define REMOTE_RADIO_MAX_PAYLOAD	(250u)	//!< Largest payload
+
+#define REMOTE_RADIO_INIT			(0x01u)	//!< Initialize the radio
+#define REMOTE_RADIO_ADDRESS		(0x02u)	//!< Set the address of the radio
+#define REMOTE_RADIO_SEND			(0x03u)	//!< Send a frame
+#define REMOTE_RADIO_POWER			(0x04u)	//!< Change the power state
+#define REMOTE_RADIO_TX_POWER		(0x05u)	//!< Set the TX power
+#define REMOTE_RADIO_CHECK			(0x06u)	//!< Sanity check of the radio
+#define REMOTE_RADIO_STATUS			(0x81u)	//!< Result of INIT, TX_POWER and CHECK
+#define REMOTE_RADIO_SENT			(0x82u)	//!< Result of SEND
+#define REMOTE_RADIO_RX				(0x83u)	//!< Received frames
+
+#define REMOTE_RADIO_POWER_DOWN		(0u)	//!< transportPowerDown()
+#define REMOTE_RADIO_POWER_UP		(1u)	//!< transportPowerUp()
+#define REMOTE_RADIO_POWER_SLEEP	(2u)	//!< transportSleep()
+#define REMOTE_RADIO_POWER_STANDBY	(3u)	//!< transportStandBy()
+
+#define REMOTE_RADIO_RX_HEADER		(4u)	//!< now of an RX message
+#define REMOTE_RADIO_RX_FRAME		(9u)	//!< received, RSSI, SNR and length of a frame in an RX message
+
+/**
+ * @brief Frame being received
+ */
+typedef struct {
+	uint8_t phase;		//!< 0 waiting for sync, 1 length, 2 type and payload, 3 and 4 CRC
+	uint8_t length;		//!< length field
+	uint8_t position;	//!< bytes of type and payload received
+	uint16_t crc;		//!< CRC so far
+	uint16_t received;	//!< CRC received
+	uint8_t type;		//!< type of the frame
+	uint8_t payload[REMOTE_RADIO_MAX_PAYLOAD];	//!< payload of the frame
+} remoteRadioParser_t;
+
+/**
+ * @brief Read the available bytes until a frame is complete
+ * @param parser state, the frame is in type and payload if true is returned
+ * @param stream serial port
+ * @return true if a frame with a valid CRC was received, parser.length - 1 bytes of payload
+ */
+bool remoteRadioParse(remoteRadioParser_t &parser, Stream &stream);
+
+/**
+ * @brief Write a frame
+ * @param stream serial port
+ * @param type frame type
+ * @param payload payload
+ * @param length payload length, at most REMOTE_RADIO_MAX_PAYLOAD
+ */
+void remoteRadioWrite(Stream &stream, const uint8_t type, const uint8_t *payload,
+                      const uint8_t length);
+
+/**
+ * @brief Store a 16 bit value little endian
+ */
+void remoteRadioPut16(uint8_t *buffer, const uint16_t value);
+/**
+ * @brief Store a 32 bit value little endian
+ */
+void remoteRadioPut32(uint8_t *buffer, const uint32_t value);
+/**
+ * @brief Read a 16 bit value stored little endian
+ */
+uint16_t remoteRadioGet16(const uint8_t *buffer);
+/**
+ * @brief Read a 32 bit value stored little endian
+ */
+uint32_t remoteRadioGet32(const uint8_t *buffer);
+
+#if defined(MY_RADIO_REMOTE_COPROCESSOR) || defined(DOXYGEN)
+/**
+ * @brief Open the serial port of the coprocessor, call in setup()
+ */
+void remoteRadioBegin(void);
+/**
+ * @brief Forward the received frames to the host and serve its requests, call in loop()
+ */
+void remoteRadioProcess(void);
+#endif
+
+#endif
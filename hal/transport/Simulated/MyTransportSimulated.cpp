@@ -0,0 +1,423 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// Virtual radio for Linux hosts. Every node process joins the same UDP multicast group on the
+// loopback interface, so each frame reaches all of them and is filtered like on air: by the
+// destination address, the links of the topology and the loss rate. Unicast frames are
+// acknowledged by the receiver and resent by the sender, like the RF24 auto-ACK.
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#define SIMULATED_MAGIC			(0x5Au)	//!< first byte of every datagram
+#define SIMULATED_KIND_FRAME	(0u)	//!< frame sent by transportSend()
+#define SIMULATED_KIND_ACK		(1u)	//!< receiver acknowledges a frame
+#define SIMULATED_FLAG_NOACK	(0x80u)	//!< frame must not be acknowledged
+#define SIMULATED_NO_LINK		(0xFFu)	//!< loss of a link missing in the topology
+#define SIMULATED_RSSI			(-50)	//!< RSSI of links without a configured RSSI
+#define SIMULATED_DUPLICATES	(8u)	//!< resent frames recognized per receiver
+
+typedef struct {
+	uint8_t magic;						// SIMULATED_MAGIC
+	uint8_t kind;						// SIMULATED_KIND_*, SIMULATED_FLAG_NOACK
+	nodeId_t from;						// transport address of the sender
+	nodeId_t to;						// destination address, BROADCAST_ADDRESS for all
+	uint32_t station;					// process of the sender (ACK: of the acknowledged frame)
+	uint16_t seq;						// frame number of the station
+	int16_t rssi;						// ACK: RSSI the frame was received with
+	uint8_t len;						// length of data
+	uint8_t data[MAX_MESSAGE_LENGTH];	// frame
+} __attribute__((packed)) simulatedFrame_t;
+
+#define SIMULATED_HEADER_SIZE	(offsetof(simulatedFrame_t, data))	//!< datagram without data
+
+typedef struct {
+	uint8_t loss;						// loss in percent, SIMULATED_NO_LINK if out of range
+	int8_t rssi;						// RSSI of frames received over the link
+} simulatedLink_t;
+
+typedef struct {
+	uint8_t len;
+	int16_t rssi;
+	uint8_t data[MAX_MESSAGE_LENGTH];
+} simulatedQueued_t;
+
+typedef struct {
+	uint32_t station;
+	uint16_t seq;
+} simulatedSeen_t;
+
+static int _simSocket = -1;
+static struct sockaddr_in _simGroup;
+static nodeId_t _simAddress = AUTO;
+static uint32_t _simStation = 0;
+static uint16_t _simSeq = 0;
+static bool _simAcked = false;
+static unsigned int _simRandom = 0;
+static uint8_t _simLoss = 0;
+static uint32_t _simLatencyUs = 0;
+static uint32_t _simAirtime = 0;	// sim_latency_us per transmitted frame
+static simulatedLink_t *_simLinks = NULL;	// [from][to], NULL is a full mesh
+static int16_t _simSendingRSSI = INVALID_RSSI;
+static int16_t _simReceivingRSSI = INVALID_RSSI;
+
+static simulatedQueued_t _simRxQueue[MY_RADIO_SIMULATED_RX_QUEUE_SIZE];
+static uint8_t _simRxHead = 0;
+static uint8_t _simRxCount = 0;
+static simulatedSeen_t _simSeen[SIMULATED_DUPLICATES];
+static uint8_t _simSeenNext = 0;
+
+static simulatedLink_t _simLink(const nodeId_t from, const nodeId_t to)
+{
+	// the topology covers ids up to 255, links of higher 16 bit ids are those of the full mesh
+	if (_simLinks && (uint16_t)(from | to) < 256u) {
+		return _simLinks[from * 256u + to];
+	}
+	simulatedLink_t link;
+	link.loss = _simLoss;
+	link.rssi = SIMULATED_RSSI;
+	return link;
+}
+
+// Topology file: one link per line "<a> <b> [loss %] [rssi]", both directions, * for any address
+static bool _simLoadTopology(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	if (!file) {
+		logError("Unable to open sim_topology file %s.\n", path);
+		return false;
+	}
+	_simLinks = (simulatedLink_t *)malloc(256u * 256u * sizeof(simulatedLink_t));
+	if (!_simLinks) {
+		fclose(file);
+		return false;
+	}
+	for (uint32_t i = 0; i < 256u * 256u; i++) {
+		_simLinks[i].loss = SIMULATED_NO_LINK;
+		_simLinks[i].rssi = SIMULATED_RSSI;
+	}
+	char line[128];
+	uint16_t number = 0;
+	while (fgets(line, sizeof(line), file)) {
+		number++;
+		char a[8], b[8];
+		int loss = _simLoss, rssi = SIMULATED_RSSI;
+		const int fields = sscanf(line, " %7s %7s %d %d", a, b, &loss, &rssi);
+		if (fields <= 0 || a[0] == '#') {
+			continue;
+		}
+		if (fields < 2 || loss < 0 || loss > 100 || rssi < -128 || rssi > 0) {
+			logError("Invalid link in sim_topology line %u.\n", number);
+			fclose(file);
+			return false;
+		}
+		const bool anyA = !strcmp(a, "*");
+		const bool anyB = !strcmp(b, "*");
+		const int nodeA = atoi(a);
+		const int nodeB = atoi(b);
+		for (int x = 0; x < 256; x++) {
+			for (int y = 0; y < 256; y++) {
+				if ((anyA || x == nodeA) && (anyB || y == nodeB)) {
+					_simLinks[x * 256u + y].loss = (uint8_t)loss;
+					_simLinks[x * 256u + y].rssi = (int8_t)rssi;
+					_simLinks[y * 256u + x].loss = (uint8_t)loss;
+					_simLinks[y * 256u + x].rssi = (int8_t)rssi;
+				}
+			}
+		}
+	}
+	fclose(file);
+	return true;
+}
+
+static bool _simIsDuplicate(const uint32_t station, const uint16_t seq)
+{
+	for (uint8_t i = 0; i < SIMULATED_DUPLICATES; i++) {
+		if (_simSeen[i].station == station && _simSeen[i].seq == seq) {
+			return true;
+		}
+	}
+	_simSeen[_simSeenNext].station = station;
+	_simSeen[_simSeenNext].seq = seq;
+	_simSeenNext = (_simSeenNext + 1) % SIMULATED_DUPLICATES;
+	return false;
+}
+
+static void _simSendAck(const simulatedFrame_t &frame, const int16_t rssi)
+{
+	simulatedFrame_t ack;
+	ack.magic = SIMULATED_MAGIC;
+	ack.kind = SIMULATED_KIND_ACK;
+	ack.from = _simAddress;
+	ack.to = frame.from;
+	ack.station = frame.station;
+	ack.seq = frame.seq;
+	ack.rssi = rssi;
+	ack.len = 0;
+	(void)sendto(_simSocket, &ack, SIMULATED_HEADER_SIZE, 0, (const struct sockaddr *)&_simGroup,
+	             sizeof(_simGroup));
+}
+
+// read all pending datagrams: queue the frames this node hears, note the ACK of the pending frame
+static void _simProcess(void)
+{
+	simulatedFrame_t frame;
+	ssize_t size;
+	while ((size = recv(_simSocket, &frame, sizeof(frame), 0)) >= (ssize_t)SIMULATED_HEADER_SIZE) {
+		if (frame.magic != SIMULATED_MAGIC) {
+			continue;
+		}
+		if ((frame.kind & ~SIMULATED_FLAG_NOACK) == SIMULATED_KIND_ACK) {
+			if (frame.station == _simStation && frame.seq == _simSeq) {
+				_simAcked = true;
+				_simSendingRSSI = frame.rssi;
+			}
+			continue;
+		}
+		if (frame.station == _simStation || (frame.to != _simAddress && frame.to != BROADCAST_ADDRESS) ||
+		        frame.len > MAX_MESSAGE_LENGTH || size < (ssize_t)(SIMULATED_HEADER_SIZE + frame.len)) {
+			continue;
+		}
+		const simulatedLink_t link = _simLink(frame.from, _simAddress);
+		if (link.loss == SIMULATED_NO_LINK || (link.loss && (uint8_t)(rand_r(&_simRandom) % 100u) < link.loss)) {
+			// out of range or lost on air
+			continue;
+		}
+		const bool ack = frame.to != BROADCAST_ADDRESS && !(frame.kind & SIMULATED_FLAG_NOACK);
+		if (ack && _simIsDuplicate(frame.station, frame.seq)) {
+			// our ACK got lost, the sender retries
+			_simSendAck(frame, link.rssi);
+			continue;
+		}
+		if (_simRxCount == MY_RADIO_SIMULATED_RX_QUEUE_SIZE) {
+			// like a full radio FIFO: not acknowledged
+			STATS_INC(STATS_RX_OVERFLOWS);
+			continue;
+		}
+		simulatedQueued_t *msg = &_simRxQueue[(_simRxHead + _simRxCount) % MY_RADIO_SIMULATED_RX_QUEUE_SIZE];
+		msg->len = frame.len;
+		msg->rssi = link.rssi;
+		(void)memcpy((void *)msg->data, (const void *)frame.data, frame.len);
+		_simRxCount++;
+		if (ack) {
+			_simSendAck(frame, link.rssi);
+		}
+	}
+}
+
+bool transportInit(void)
+{
+	const char *group = conf.sim_group ? conf.sim_group : MY_RADIO_SIMULATED_GROUP;
+	(void)memset((void *)&_simGroup, 0, sizeof(_simGroup));
+	_simGroup.sin_family = AF_INET;
+	_simGroup.sin_port = htons(conf.sim_port ? conf.sim_port : MY_RADIO_SIMULATED_PORT);
+	if (!inet_aton(group, &_simGroup.sin_addr)) {
+		logError("Invalid sim_group address %s.\n", group);
+		return false;
+	}
+	_simLoss = (uint8_t)conf.sim_loss;
+	_simLatencyUs = (uint32_t)conf.sim_latency_us;
+	if (conf.sim_topology && !_simLoadTopology(conf.sim_topology)) {
+		return false;
+	}
+	_simStation = (uint32_t)getpid();
+	_simRandom = (unsigned int)_simStation;
+
+	_simSocket = socket(AF_INET, SOCK_DGRAM, 0);
+	if (_simSocket < 0) {
+		logError("Simulated radio: socket failed: %s\n", strerror(errno));
+		return false;
+	}
+	const int on = 1;
+	const unsigned char loop = 1;
+	struct ip_mreq membership;
+	membership.imr_multiaddr = _simGroup.sin_addr;
+	membership.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+	struct sockaddr_in local;
+	(void)memset((void *)&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_port = _simGroup.sin_port;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	// all processes of one host share the group port
+	if (setsockopt(_simSocket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0 ||
+	        bind(_simSocket, (const struct sockaddr *)&local, sizeof(local)) < 0 ||
+	        setsockopt(_simSocket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0 ||
+	        setsockopt(_simSocket, IPPROTO_IP, IP_MULTICAST_IF, &membership.imr_interface,
+	                   sizeof(membership.imr_interface)) < 0 ||
+	        setsockopt(_simSocket, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) < 0) {
+		logError("Simulated radio: joining %s failed: %s\n", group, strerror(errno));
+		close(_simSocket);
+		_simSocket = -1;
+		return false;
+	}
+	(void)fcntl(_simSocket, F_SETFL, fcntl(_simSocket, F_GETFL) | O_NONBLOCK);
+	eventLoopAdd(_simSocket);
+	return true;
+}
+
+void transportSetAddress(const nodeId_t address)
+{
+	_simAddress = address;
+}
+
+nodeId_t transportGetAddress(void)
+{
+	return _simAddress;
+}
+
+bool transportSend(const nodeId_t to, const void *data, const uint8_t len, const bool noACK)
+{
+	simulatedFrame_t frame;
+	frame.magic = SIMULATED_MAGIC;
+	frame.kind = SIMULATED_KIND_FRAME | (noACK ? SIMULATED_FLAG_NOACK : 0);
+	frame.from = _simAddress;
+	frame.to = to;
+	frame.station = _simStation;
+	frame.seq = ++_simSeq;
+	frame.rssi = INVALID_RSSI;
+	frame.len = min(len, (uint8_t)MAX_MESSAGE_LENGTH);
+	(void)memcpy((void *)frame.data, data, frame.len);
+
+	if (_simLatencyUs) {
+		// time on air, the sender is blocked like by a real radio
+		usleep(_simLatencyUs);
+	}
+	const bool ack = to != BROADCAST_ADDRESS && !noACK;
+	bool result = !ack;
+	_simAcked = false;
+	for (uint8_t attempt = 0; attempt <= MY_RADIO_SIMULATED_RETRIES && !_simAcked; attempt++) {
+		(void)sendto(_simSocket, &frame, SIMULATED_HEADER_SIZE + frame.len, 0,
+		             (const struct sockaddr *)&_simGroup, sizeof(_simGroup));
+		_simAirtime += _simLatencyUs;
+		if (!ack) {
+			break;
+		}
+		const uint32_t started = hwMillis();
+		uint32_t elapsed = 0;
+		while (!_simAcked && elapsed < MY_RADIO_SIMULATED_ACK_TIMEOUT_MS) {
+			struct pollfd pfd = { _simSocket, POLLIN, 0 };
+			(void)poll(&pfd, 1, (int)(MY_RADIO_SIMULATED_ACK_TIMEOUT_MS - elapsed));
+			_simProcess();
+			elapsed = hwMillis() - started;
+		}
+		result = _simAcked;
+	}
+	if (!result) {
+		_simSendingRSSI = INVALID_RSSI;
+	}
+	if (_simRxCount) {
+		// frames received while waiting for the ACK are no longer signalled by the socket
+		eventLoopWakeup();
+	}
+	return result;
+}
+
+uint32_t transportGetAirtime(void)
+{
+	return _simAirtime;
+}
+
+bool transportDataAvailable(void)
+{
+	_simProcess();
+	return _simRxCount > 0;
+}
+
+bool transportSanityCheck(void)
+{
+	return _simSocket >= 0;
+}
+
+uint8_t transportReceive(void *data)
+{
+	if (!_simRxCount) {
+		return 0;
+	}
+	const simulatedQueued_t *msg = &_simRxQueue[_simRxHead];
+	(void)memcpy(data, (const void *)msg->data, msg->len);
+	_simReceivingRSSI = msg->rssi;
+	_simRxHead = (_simRxHead + 1) % MY_RADIO_SIMULATED_RX_QUEUE_SIZE;
+	_simRxCount--;
+	return msg->len;
+}
+
+void transportPowerDown(void)
+{
+	// nothing to power down
+}
+
+void transportPowerUp(void)
+{
+	// nothing to power up
+}
+
+void transportSleep(void)
+{
+	// frames keep arriving in the socket
+}
+
+void transportStandBy(void)
+{
+	// always listening
+}
+
+int16_t transportGetSendingRSSI(void)
+{
+	return _simSendingRSSI;
+}
+
+int16_t transportGetReceivingRSSI(void)
+{
+	return _simReceivingRSSI;
+}
+
+int16_t transportGetSendingSNR(void)
+{
+	// not simulated
+	return INVALID_SNR;
+}
+
+int16_t transportGetReceivingSNR(void)
+{
+	// not simulated
+	return INVALID_SNR;
+}
+
+int16_t transportGetTxPowerPercent(void)
+{
+	// not simulated
+	return static_cast<int16_t>(100);
+}
+
+int16_t transportGetTxPowerLevel(void)
+{
+	// not simulated
+	return static_cast<int16_t>(100);
+}
+
+bool transportSetTxPowerPercent(const uint8_t powerPercent)
+{
+	// not simulated
+	(void)powerPercent;
+	return false;
+}
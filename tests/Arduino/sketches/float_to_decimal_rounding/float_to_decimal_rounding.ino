@@ -0,0 +1,62 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ *******************************
+ */
+#define MY_RADIO_RF24
+#define MY_GATEWAY_SERIAL
+
+#include <MySensors.h>
+
+static bool checkF2D(const float value, const uint8_t decimals, const char *expected)
+{
+	char buffer[MY_GATEWAY_MAX_SEND_LENGTH];
+	(void)convertF2D(buffer, value, decimals);
+	if (strcmp(buffer, expected)) {
+		Serial.print(F("F2D:FAIL "));
+		Serial.print(expected);
+		Serial.print(' ');
+		Serial.println(buffer);
+		return false;
+	}
+	return true;
+}
+
+void setup()
+{
+	bool passed = true;
+	// exact ties round to even
+	passed &= checkF2D(0.125f, 2, "0.12");
+	passed &= checkF2D(0.375f, 2, "0.38");
+	passed &= checkF2D(-0.125f, 2, "-0.12");
+	passed &= checkF2D(2.5f, 0, " 2");
+	passed &= checkF2D(3.5f, 0, " 4");
+	// no ties, the floats are 1.00499999... and 0.99500000...
+	passed &= checkF2D(1.005f, 2, "1.00");
+	passed &= checkF2D(0.995f, 2, "1.00");
+	passed &= checkF2D(99.995f, 2, "100.00");
+	passed &= checkF2D(123.456f, 3, "123.456");
+	passed &= checkF2D(0.1f, 8, "0.10000000");
+	passed &= checkF2D(1e-10f, 8, "0.00000000");
+	passed &= checkF2D(4294967.0f, 2, "4294967.00");
+	Serial.println(passed ? F("F2D:PASS") : F("F2D:FAIL"));
+}
+
+void loop()
+{
+}
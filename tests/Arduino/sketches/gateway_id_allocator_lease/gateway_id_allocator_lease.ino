@@ -0,0 +1,69 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ *******************************
+ */
+#define MY_DEBUG
+#define MY_RADIO_RF24
+#define MY_GATEWAY_SERIAL
+#define MY_GATEWAY_ID_ALLOCATOR
+
+#include <MySensors.h>
+
+extern MyMessage _msgTmp;
+
+// an I_ID_REQUEST of a node without ID, received directly
+static nodeId_t requestNodeId(const uint8_t token)
+{
+	MyMessage request;
+	build(request, GATEWAY_ADDRESS, token, C_INTERNAL, I_ID_REQUEST).set("");
+	request.sender = AUTO;
+	request.last = AUTO;
+	if (!transportAllocateNodeId(request)) {
+		return AUTO;
+	}
+	// the I_ID_RESPONSE sent to the node
+#if defined(MY_NODE_ID_16BIT)
+	return (nodeId_t)_msgTmp.getUInt();
+#else
+	return (nodeId_t)_msgTmp.getByte();
+#endif
+}
+
+void setup()
+{
+	const nodeId_t leased = requestNodeId(42);
+	// the response got lost, the node asks again with the same token
+	const nodeId_t repeated = requestNodeId(42);
+	const nodeId_t other = requestNodeId(43);
+	// the node sent with its ID, the lease ends
+	transportConfirmNodeId(leased);
+	const nodeId_t next = requestNodeId(42);
+	const bool passed = leased != AUTO && repeated == leased && other != AUTO && other != leased &&
+	                    next != AUTO && next != leased && next != other;
+	Serial.println(passed ? F("IDA:LEASE:PASS") : F("IDA:LEASE:FAIL"));
+	// release the IDs of the test
+	transportSetRoute(leased, BROADCAST_ADDRESS);
+	transportSetRoute(other, BROADCAST_ADDRESS);
+	transportSetRoute(next, BROADCAST_ADDRESS);
+	transportSaveRoutingTable();
+}
+
+void loop()
+{
+}
@@ -0,0 +1,65 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2019 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ *******************************
+ */
+#define MY_DEBUG
+#define MY_DEBUG_VERBOSE_SIGNING
+#define MY_RADIO_RF24
+#define MY_GATEWAY_SERIAL
+#define MY_TRANSPORT_TX_QUEUE_FEATURE
+#define MY_SIGNING_SOFT
+#define MY_SIGNING_REQUEST_SIGNATURES
+#ifndef MY_SIGNING_SOFT_RANDOMSEED_PIN
+#define MY_SIGNING_SOFT_RANDOMSEED_PIN 7
+#endif
+
+#include <MySensors.h>
+
+// signing a queued message waits for the nonce in _process(), which runs the queue again
+#define QUEUED_NODE_ID 1
+#define QUEUED_MESSAGES 3
+
+static uint8_t completed[QUEUED_MESSAGES];
+
+void queuedSent(const MyMessage &message, const bool success)
+{
+	if (message.sensor < QUEUED_MESSAGES) {
+		completed[message.sensor]++;
+	}
+	(void)success;
+}
+
+void setup()
+{
+	transportRegisterTxCallback(queuedSent);
+}
+
+void loop()
+{
+	MyMessage msg;
+	for (uint8_t i = 0; i < QUEUED_MESSAGES; i++) {
+		// each message is completed once, before the next burst
+		if (completed[i] > 1) {
+			Serial.println(F("TXQ:DUP"));
+		}
+		completed[i] = 0;
+		(void)transportQueueRoute(build(msg, QUEUED_NODE_ID, i, C_SET, V_STATUS).set(i));
+	}
+	wait(10000);
+}